@@ -1,28 +1,24 @@
-function onPlayerCommand(playerid, command)
+function onWhisperCommand(playerid, args, text)
 {
-	local cmd = split(command, " ");
-
-	if(cmd[0] == "/w" || cmd[0] == "/whisper")
+	if(args.len() < 2)
 	{
-		if(cmd.len() < 3)
-		{
-			sendPlayerMessage(playerid, "Syntax: (/w)hisper [playerid] [text]");
-			return 1;
-		}
+		sendPlayerMessage(playerid, "Syntax: (/w)hisper [playerid] [text]");
+		return;
+	}
 
-		if(!isPlayerConnected(cmd[1].tointeger()))
-		{
-			sendPlayerMessage(playerid, "Player " + cmd[1].tointeger() + " is not connected");
-			return 1;
-		}
+	local targetid = args[0].tointeger();
 
-		local text = command.slice(cmd[0].len() + cmd[1].len() + 2);
-		sendPlayerMessage(cmd[1].tointeger(), "Whisper from " + getPlayerName(playerid) + " [" + playerid + "]: " + text);
-		sendPlayerMessage(playerid, "Whisper sent to " + getPlayerName(cmd[1].tointeger()) + " [" + cmd[1].tointeger() + "]: " + text);
-		log("[Whisper] " + getPlayerName(cmd[1].tointeger()) + " to " + getPlayerName(cmd[1].tointeger()) + ": " + text);			callEvent("playerWhisper", 1, playerid, cmd[1].tointeger(), text);
-		return 1;
+	if(!isPlayerConnected(targetid))
+	{
+		sendPlayerMessage(playerid, "Player " + targetid + " is not connected");
+		return;
 	}
 
-	return 1;
+	local message = text.slice(args[0].len() + 1);
+	sendPlayerMessage(targetid, "Whisper from " + getPlayerName(playerid) + " [" + playerid + "]: " + message);
+	sendPlayerMessage(playerid, "Whisper sent to " + getPlayerName(targetid) + " [" + targetid + "]: " + message);
+	log("[Whisper] " + getPlayerName(playerid) + " to " + getPlayerName(targetid) + ": " + message);
+	callEvent("playerWhisper", 1, playerid, targetid, message);
 }
-addEvent("playerCommand", onPlayerCommand);
\ No newline at end of file
+addCommandHandler("w", onWhisperCommand);
+addCommandHandler("whisper", onWhisperCommand);
\ No newline at end of file
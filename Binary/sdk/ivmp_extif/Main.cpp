@@ -68,4 +68,18 @@ EXPORT void ScriptUnload(HSQUIRRELVM pVM)
 EXPORT void Pulse()
 {
 	
-}
\ No newline at end of file
+}
+
+/*
+	Optional, return the time in ms between two calls of Pulse (and PulseAsync),
+	Pulse is called every server pulse if this isn't exported.
+
+	EXPORT unsigned int GetPulseInterval()
+
+	Optional, called on a worker thread with a copy of all players and vehicles
+	taken when it was started, it is not called again until it returned.
+	CPU-intensive code belongs here but it must not call any IVMP functions.
+
+	EXPORT void PulseAsync(const ModulePlayerData * pPlayers, unsigned int uiPlayerCount,
+		const ModuleVehicleData * pVehicles, unsigned int uiVehicleCount)
+*/
\ No newline at end of file
@@ -66,6 +66,7 @@ struct NewInterfaceContainer_t
 	ICAreaModuleNatives* g_pAreaNatives;
 	ICHashModuleNatives* g_pHashNatives;
 	ICWorldModuleNatives* g_pWorldNatives;
+	ICBulkModuleNatives* g_pBulkNatives; // NULL on servers older than MODULE_API_VERSION 2
 };
 
 extern InterfaceContainer_t InterfaceContainer;
@@ -186,6 +187,10 @@ namespace IVMP
 	{
 		return NewInterfaceContainer.g_pWorldNatives;
 	}
+	inline ICBulkModuleNatives * Bulk()
+	{
+		return NewInterfaceContainer.g_pBulkNatives;
+	}
 	namespace Events
 	{
 		inline CEventsInterface * Manager()
@@ -14,6 +14,7 @@
 #include "CVehicleManager.h"
 #include "CNetworkManager.h"
 #include <CLogfile.h>
+#include <SharedUtility.h>
 
 extern CModelManager * g_pModelManager;
 extern CVehicleManager * g_pVehicleManager;
@@ -28,6 +29,7 @@ CActorManager::CActorManager()
 		m_bActive[x] = false;
 		m_Actors[x].bRender = false;
 		m_Actors[x].bFailedEnterVehicle = false;
+		m_Actors[x].bPath = false;
 	}
 }
 
@@ -42,6 +44,9 @@ CActorManager::~CActorManager()
 
 void CActorManager::Create(EntityId actorId, int iModelId, CVector3 vecPosition, float fHeading, String strName, bool bTogglename, unsigned int iColor, bool bFrozen, bool bHelmet, bool bBlip)
 {
+	if(actorId >= MAX_ACTORS)
+		return;
+
 	if(m_bActive[actorId])
 		Delete(actorId);
 
@@ -138,13 +143,19 @@ bool CActorManager::Delete(EntityId actorId)
 
 	m_bActive[actorId] = false;
 	m_Actors[actorId].bRender = false;
+	m_Actors[actorId].bPath = false;
+	m_Actors[actorId].path.Clear();
 	return true;
 }
 
 void CActorManager::SetPosition(EntityId actorId, CVector3 vecPosition)
 {
 	if(m_bActive[actorId])
+	{
+		// The server stops the path of an actor it sets the position of
+		StopPath(actorId);
 		Scripting::SetCharCoordinates(m_Actors[actorId].uiActorIndex, vecPosition.fX, vecPosition.fY, vecPosition.fZ);
+	}
 }
 
 void CActorManager::SetHeading(EntityId actorId, float fHeading)
@@ -363,6 +374,88 @@ void CActorManager::DriveToPoint(EntityId actorId, EntityId vehicleId, CVector3
 			m_Actors[actorId].bRender = false;
 	}
 }
+void CActorManager::SetPath(EntityId actorId, const CMoveTimeline& path)
+{
+	if(!DoesExist(actorId))
+		return;
+
+	if(path.IsEmpty())
+	{
+		StopPath(actorId);
+		return;
+	}
+
+	// Actors are frozen where they spawned until they walk
+	m_Actors[actorId].path = path;
+	m_Actors[actorId].bPath = true;
+	m_Actors[actorId].ulLastPathTaskTime = 0;
+	Scripting::FreezeCharPosition(m_Actors[actorId].uiActorIndex, false);
+}
+
+void CActorManager::StopPath(EntityId actorId)
+{
+	if(!DoesExist(actorId) || !m_Actors[actorId].bPath)
+		return;
+
+	m_Actors[actorId].bPath = false;
+	m_Actors[actorId].path.Clear();
+	Scripting::ClearCharTasks(m_Actors[actorId].uiActorIndex);
+	Scripting::FreezeCharPosition(m_Actors[actorId].uiActorIndex, true);
+}
+
+void CActorManager::CorrectPath(EntityId actorId, unsigned int uiElapsed)
+{
+	if(DoesExist(actorId) && m_Actors[actorId].bPath)
+		m_Actors[actorId].path.SetStartTime(SharedUtility::GetTime() - uiElapsed);
+}
+
+void CActorManager::ProcessPath(EntityId actorId, unsigned long ulTime)
+{
+	_Actor * pActor = &m_Actors[actorId];
+	CVector3 vecTarget, vecAhead, vecRotation;
+
+	if(!pActor->path.Evaluate(ulTime, vecTarget, vecRotation))
+		return;
+
+	CVector3 vecPosition;
+	Scripting::GetCharCoordinates(pActor->uiActorIndex, &vecPosition.fX, &vecPosition.fY, &vecPosition.fZ);
+
+	// Once the path is over the actor stays where it ends, like it does on the server
+	if(pActor->path.IsFinished(ulTime))
+	{
+		pActor->bPath = false;
+		pActor->path.Clear();
+		Scripting::ClearCharTasks(pActor->uiActorIndex);
+		Scripting::SetCharCoordinates(pActor->uiActorIndex, vecTarget.fX, vecTarget.fY, vecTarget.fZ);
+		Scripting::FreezeCharPosition(pActor->uiActorIndex, true);
+		return;
+	}
+
+	// Actors that fell behind (or weren't streamed in by the game) are put where they should be
+	if((vecTarget - vecPosition).Length() > ACTOR_PATH_WARP_DISTANCE)
+	{
+		Scripting::SetCharCoordinates(pActor->uiActorIndex, vecTarget.fX, vecTarget.fY, vecTarget.fZ);
+		pActor->ulLastPathTaskTime = 0;
+	}
+
+	if((ulTime - pActor->ulLastPathTaskTime) < ACTOR_PATH_TASK_INTERVAL)
+		return;
+
+	pActor->ulLastPathTaskTime = ulTime;
+
+	// Walk, run or sprint towards where the path is a bit later
+	pActor->path.Evaluate((ulTime + ACTOR_PATH_LOOK_AHEAD), vecAhead, vecRotation);
+	float fSpeed = ((vecAhead - vecTarget).Length() / (ACTOR_PATH_LOOK_AHEAD / 1000.0f));
+	unsigned int uiMoveState = 2;
+
+	if(fSpeed > 5.0f)
+		uiMoveState = 4;
+	else if(fSpeed > 2.5f)
+		uiMoveState = 3;
+
+	Scripting::TaskGoStraightToCoord(pActor->uiActorIndex, vecAhead.fX, vecAhead.fY, vecAhead.fZ, uiMoveState, 45000);
+}
+
 CBitStream		bsSend;
 float			fHeading;
 unsigned int	uiVehicleHandle;
@@ -405,6 +498,15 @@ void CActorManager::Process()
 	if(CGame::IsMenuActive())
 		bMenuFocused = true;
 
+	// Walk the actors along the paths the server moves them on
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	for(EntityId i = 0; i < MAX_ACTORS; i++)
+	{
+		if(m_bActive[i] && m_Actors[i].bPath)
+			ProcessPath(i, ulTime);
+	}
+
 	for(EntityId i = 0; i < MAX_ACTORS; i++)
 	{
 		if(m_bActive[i] && m_Actors[i].bRender)
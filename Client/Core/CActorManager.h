@@ -12,6 +12,16 @@
 
 #include "Scripting.h"
 #include "CPlayerManager.h"
+#include <Game/CMoveTimeline.h>
+
+// Actors further than this from where their path has them are put there
+#define ACTOR_PATH_WARP_DISTANCE 5.0f
+
+// Time in ms ahead on the path an actor walks towards
+#define ACTOR_PATH_LOOK_AHEAD 1000
+
+// Interval in ms at which an actor gets a new walk task on its path
+#define ACTOR_PATH_TASK_INTERVAL 500
 
  struct _Actor
  {
@@ -32,6 +42,9 @@
 	bool			bFailedEnterVehicle;
 	CVector3		vecDriveFinalPos;
 	CVector3		vecDrivePos;
+	bool			bPath;
+	CMoveTimeline	path;
+	unsigned long	ulLastPathTaskTime;
  };
 
 class CActorManager
@@ -40,6 +53,8 @@ private:
 	bool m_bActive[MAX_ACTORS];
 	_Actor m_Actors[MAX_ACTORS];
 
+	void			ProcessPath(EntityId actorId, unsigned long ulTime);
+
 public:
 	CActorManager();
 	~CActorManager();
@@ -69,6 +84,13 @@ public:
 	float			GetArmour(EntityId actorId);
 	void			DriveToPoint(EntityId actorId, EntityId vehicleId, CVector3 vecPos, CVector3 vecRot, CVector3 vecFinalPos, bool bDrive);
 	EntityId		GetVehicleId(EntityId actorId) { return m_Actors[actorId].vehicleId; }
-	bool			DoesExist(EntityId actorId) { return m_bActive[actorId]; };
+	bool			DoesExist(EntityId actorId) { return (actorId < MAX_ACTORS && m_bActive[actorId]); };
+
+	// The actor walks along the path the server moves it on, an empty path stops it
+	void			SetPath(EntityId actorId, const CMoveTimeline& path);
+	void			StopPath(EntityId actorId);
+
+	// Puts the path of the actor at the time the server has it at
+	void			CorrectPath(EntityId actorId, unsigned int uiElapsed);
 	void			Process();
 };
@@ -13,6 +13,7 @@
 #include "CChatWindow.h"
 #include "CModelmanager.h"
 #include "CVehicleManager.h"
+#include <SharedUtility.h>
 
 extern CVehicleManager * g_pVehicleManager;
 
@@ -37,35 +38,77 @@ void CBlipManager::Create(EntityId blipId, int iSprite, CVector3 vecPosition)
 	if(m_bActive[blipId])
 		Delete(blipId);
 
-	// Add the blip to the game
-	Scripting::AddBlipForCoord(vecPosition.fX, vecPosition.fY, vecPosition.fZ, &m_Blips[blipId].uiBlipIndex);
-
 	// Ensure we have a valid sprite id
 	if(iSprite < 0 || iSprite > 94)
 		iSprite = 3;
 
-	// Set the blip sprite
-	Scripting::ChangeBlipSprite(m_Blips[blipId].uiBlipIndex, (Scripting::eBlipSprite)iSprite);
+	m_Blips[blipId].uiBlipIndex = 0;
+	m_Blips[blipId].iSprite = iSprite;
+	m_Blips[blipId].vecPosition = vecPosition;
+	m_Blips[blipId].uiColor = 0xFFFFFFFF;
+	m_Blips[blipId].fSize = 1.0f;
+	m_Blips[blipId].bShortRange = false;
+	m_Blips[blipId].bRouteBlip = false;
+	m_Blips[blipId].bShow = true;
+	m_Blips[blipId].strName.Clear();
+	m_Blips[blipId].bFlash = false;
+	m_Blips[blipId].iFlashType = 0;
+	m_Blips[blipId].bCreated = false;
+	m_Blips[blipId].attachedVehicle = INVALID_ENTITY_ID;
+	m_bActive[blipId] = true;
 
-	// Set the blip color
-	SetColor(blipId, 0xFFFFFFFF);
+	// The game blip is created later in Process so joining a server with
+	// lots of blips doesn't stall a frame, until then the setters only
+	// store the blip state
+	m_createQueue.push_back(blipId);
+}
 
-	// Set the blip size
-	SetSize(blipId, 1.0f);
+void CBlipManager::CreateGameBlip(EntityId blipId)
+{
+	_Blip * pBlip = &m_Blips[blipId];
 
-	// Set short-range
-	ToggleShortRange(blipId, false);
+	// Add the blip to the game (to the vehicle if it was attached to one before it was created)
+	if(pBlip->attachedVehicle != INVALID_ENTITY_ID && g_pVehicleManager->Exists(pBlip->attachedVehicle))
+		Scripting::AddBlipForCar(g_pVehicleManager->Get(pBlip->attachedVehicle)->GetScriptingHandle(), &pBlip->uiBlipIndex);
+	else
+		Scripting::AddBlipForCoord(pBlip->vecPosition.fX, pBlip->vecPosition.fY, pBlip->vecPosition.fZ, &pBlip->uiBlipIndex);
 
-	// Set route
-	ToggleRouteBlip(blipId, false);
+	pBlip->bCreated = true;
 
-	// Set name
-	SetName(blipId, "");
+	// Set the blip sprite
+	Scripting::ChangeBlipSprite(pBlip->uiBlipIndex, (Scripting::eBlipSprite)pBlip->iSprite);
+
+	// Apply the blip state
+	SetColor(blipId, pBlip->uiColor);
+	SetSize(blipId, pBlip->fSize);
+	ToggleShortRange(blipId, pBlip->bShortRange);
+	ToggleRouteBlip(blipId, pBlip->bRouteBlip);
+	SetName(blipId, pBlip->strName);
+	Show(blipId, pBlip->bShow);
+
+	if(pBlip->bFlash)
+		Flash(blipId, true, pBlip->iFlashType);
+}
 
-	m_Blips[blipId].iSprite = iSprite;
-	m_Blips[blipId].vecPosition = vecPosition;
-	m_Blips[blipId].attachedVehicle = INVALID_ENTITY_ID;
-	m_bActive[blipId] = true;
+void CBlipManager::Process()
+{
+	// Create the game blips of the new blips within the frame budget
+	unsigned long ulStartTime = SharedUtility::GetTime();
+
+	while(!m_createQueue.empty())
+	{
+		EntityId blipId = m_createQueue.front();
+		m_createQueue.pop_front();
+
+		// Was the blip deleted (or created) since it was queued?
+		if(!m_bActive[blipId] || m_Blips[blipId].bCreated)
+			continue;
+
+		CreateGameBlip(blipId);
+
+		if((SharedUtility::GetTime() - ulStartTime) >= BLIP_CREATION_BUDGET)
+			break;
+	}
 }
 
 bool CBlipManager::Delete(EntityId blipId)
@@ -78,21 +121,42 @@ bool CBlipManager::Delete(EntityId blipId)
 	}
 
 	// Remove the blip from the game
-	Scripting::RemoveBlip(m_Blips[blipId].uiBlipIndex);
+	if(m_Blips[blipId].bCreated)
+		Scripting::RemoveBlip(m_Blips[blipId].uiBlipIndex);
 
+	m_Blips[blipId].bCreated = false;
 	m_bActive[blipId] = false;
 	return true;
 }
 
+void CBlipManager::SetPosition(EntityId blipId, CVector3 vecPosition)
+{
+	if(m_bActive[blipId])
+	{
+		m_Blips[blipId].vecPosition = vecPosition;
+
+		// Blips attached to a vehicle follow the vehicle
+		if(!m_Blips[blipId].bCreated || m_Blips[blipId].attachedVehicle != INVALID_ENTITY_ID)
+			return;
+
+		// Coord blips can't be moved so the game blip is created again with the same state
+		Scripting::RemoveBlip(m_Blips[blipId].uiBlipIndex);
+		CreateGameBlip(blipId);
+	}
+}
+
 void CBlipManager::SetColor(EntityId blipId, unsigned int uiColor)
 {
 	if(m_bActive[blipId])
 	{
-		// Change the blip color
-		Scripting::ChangeBlipColour(m_Blips[blipId].uiBlipIndex, uiColor);
+		if(m_Blips[blipId].bCreated)
+		{
+			// Change the blip color
+			Scripting::ChangeBlipColour(m_Blips[blipId].uiBlipIndex, uiColor);
 
-		// Set the blip alpha
-		Scripting::ChangeBlipAlpha(m_Blips[blipId].uiBlipIndex, uiColor & 0xFF);
+			// Set the blip alpha
+			Scripting::ChangeBlipAlpha(m_Blips[blipId].uiBlipIndex, uiColor & 0xFF);
+		}
 
 		m_Blips[blipId].uiColor = uiColor;
 	}
@@ -102,7 +166,9 @@ void CBlipManager::SetSize(EntityId blipId, float fSize)
 {
 	if(m_bActive[blipId])
 	{
-		Scripting::ChangeBlipScale(m_Blips[blipId].uiBlipIndex, fSize);
+		if(m_Blips[blipId].bCreated)
+			Scripting::ChangeBlipScale(m_Blips[blipId].uiBlipIndex, fSize);
+
 		m_Blips[blipId].fSize = fSize;
 	}
 }
@@ -111,6 +177,12 @@ void CBlipManager::Flash(EntityId blipId, bool bFlash, int iFlashType)
 {
 	if(m_bActive[blipId])
 	{
+		m_Blips[blipId].bFlash = bFlash;
+		m_Blips[blipId].iFlashType = iFlashType;
+
+		if(!m_Blips[blipId].bCreated)
+			return;
+
 		bool bBlipFlash[2];
 
 		if(!bFlash)
@@ -140,7 +212,9 @@ void CBlipManager::ToggleShortRange(EntityId blipId, bool bToggle)
 {
 	if(m_bActive[blipId])
 	{
-		Scripting::SetBlipAsShortRange(m_Blips[blipId].uiBlipIndex, bToggle);
+		if(m_Blips[blipId].bCreated)
+			Scripting::SetBlipAsShortRange(m_Blips[blipId].uiBlipIndex, bToggle);
+
 		m_Blips[blipId].bShortRange = bToggle;
 	}
 }
@@ -149,6 +223,11 @@ void CBlipManager::ToggleRouteBlip(EntityId blipId, bool bToggle)
 {
 	if(m_bActive[blipId])
 	{
+		m_Blips[blipId].bRouteBlip = bToggle;
+
+		if(!m_Blips[blipId].bCreated)
+			return;
+
 		DWORD dwFunction = (CGame::GetBase()+0x810DC0);
 		unsigned int uiIndex = m_Blips[blipId].uiBlipIndex;	
 		int iToggle = (int)bToggle;
@@ -161,7 +240,6 @@ void CBlipManager::ToggleRouteBlip(EntityId blipId, bool bToggle)
 			call dwFunction
 			add esp, 0Ch
 		}
-		m_Blips[blipId].bRouteBlip = bToggle;
 
 		//Scripting::SetRoute(m_Blips[blipId].uiBlipIndex, bToggle);
 		//m_Blips[blipId].bRouteBlip = bToggle;
@@ -174,7 +252,12 @@ void CBlipManager::ToggleRouteBlip(EntityId blipId, bool bToggle)
 void CBlipManager::SetName(EntityId blipId, String strName)
 {
 	if(m_bActive[blipId])
-		Scripting::ChangeBlipNameFromAscii(m_Blips[blipId].uiBlipIndex, strName.Get());
+	{
+		if(m_Blips[blipId].bCreated)
+			Scripting::ChangeBlipNameFromAscii(m_Blips[blipId].uiBlipIndex, strName.Get());
+
+		m_Blips[blipId].strName = strName;
+	}
 }
 
 void CBlipManager::AttachToVehicle(EntityId blipId, EntityId vehicleId) 
@@ -183,6 +266,13 @@ void CBlipManager::AttachToVehicle(EntityId blipId, EntityId vehicleId)
 	{
 		if(g_pVehicleManager->Exists(vehicleId)) 
 		{
+			// Is the game blip not created yet? (it is created for the vehicle then)
+			if(!m_Blips[blipId].bCreated)
+			{
+				m_Blips[blipId].attachedVehicle = vehicleId;
+				return;
+			}
+
 			CNetworkVehicle * pVehicle = g_pVehicleManager->Get(vehicleId);
 			
 			//Remove the position blip
@@ -215,6 +305,11 @@ void CBlipManager::Show(EntityId blipId, bool bShow)
 {
 	if(m_bActive[blipId])
 	{
+		m_Blips[blipId].bShow = bShow;
+
+		if(!m_Blips[blipId].bCreated)
+			return;
+
 		if(bShow)
 			Scripting::ChangeBlipDisplay(m_Blips[blipId].uiBlipIndex,Scripting::BLIP_MODE_SHOW);
 		else if(!bShow)
@@ -11,8 +11,12 @@
 
 #pragma once
 
+#include <list>
 #include "Scripting.h"
 
+// Time in ms that can be spent each frame on creating the game blips of new blips (at least one is created)
+#define BLIP_CREATION_BUDGET 2
+
 struct _Blip
 {
 	unsigned int	uiBlipIndex;
@@ -23,6 +27,10 @@ struct _Blip
 	bool			bShortRange;
 	bool			bRouteBlip;
 	bool			bShow;
+	String			strName;
+	bool			bFlash;
+	int				iFlashType;
+	bool			bCreated; // The game blip exists
 
 	EntityId		attachedVehicle;
 };
@@ -32,6 +40,9 @@ class CBlipManager
 private:
 	bool m_bActive[MAX_BLIPS];
 	_Blip m_Blips[MAX_BLIPS];
+	std::list<EntityId> m_createQueue; // Blips the game blip is created for over the next frames
+
+	void CreateGameBlip(EntityId blipId);
 
 public:
 	CBlipManager();
@@ -39,6 +50,7 @@ public:
 
 	void Create(EntityId blipId, int iSprite, CVector3 vecPosition);
 	bool Delete(EntityId blipId);
+	void SetPosition(EntityId blipId, CVector3 vecPosition);
 	void SetColor(EntityId blipId, unsigned int uiColor);
 	void SetSize(EntityId blipId, float fSize);
 	void Flash(EntityId blipId, bool bFlash, int iFlashType);
@@ -48,4 +60,5 @@ public:
 	void AttachToVehicle(EntityId blipId, EntityId vehicleId);
 	bool DoesExist(EntityId blipId) { return m_bActive[blipId]; };
 	void Show(EntityId blipId, bool bShow);
+	void Process();
 };
@@ -146,6 +146,11 @@ void CCamera::SetLookAt(const CVector3& vecLookAt)
 	Scripting::PointCamAtCoord(CGame::GetPools()->GetCamPool()->HandleOf(m_pScriptCam->GetCam()), vecLookAt.fX, vecLookAt.fY, vecLookAt.fZ);
 }
 
+void CCamera::GetForward(CVector3& vecForward)
+{
+	vecForward = GetGameCam()->GetCam()->m_data1.m_matMatrix.vecForward;
+}
+
 void CCamera::GetLookAt(CVector3& vecLookAt)
 {
 	// TODO: try to get coords from vec
@@ -33,5 +33,6 @@ public:
 	void     GetPosition(CVector3& vecPosition);
 	void     SetLookAt(const CVector3& vecLookAt);
 	void     GetLookAt(CVector3& vecLookAt);
+	void     GetForward(CVector3& vecForward);
 	void	 Attach(unsigned int uiHandle, bool bVehicleOrPlayer);
 };
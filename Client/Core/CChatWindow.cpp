@@ -23,7 +23,9 @@ extern CPlayerManager * g_pPlayerManager;
 
 CChatWindow::CChatWindow()
 	: m_bEnabled(true),
-	m_iCurrentPage(1)
+	m_iCurrentPage(1),
+	m_pGeometryBuffer(NULL),
+	m_bLayoutChanged(true)
 {
 	memset(&m_chatMessages, 0, sizeof(m_chatMessages));
 	InitFontAndBackground();
@@ -31,7 +33,53 @@ CChatWindow::CChatWindow()
 
 CChatWindow::~CChatWindow()
 {
+	if(m_pGeometryBuffer)
+		g_pGUI->GetRenderer()->destroyGeometryBuffer(*m_pGeometryBuffer);
+}
+
+void CChatWindow::BuildGeometry()
+{
+	// Create the geometry buffer if needed
+	if(!m_pGeometryBuffer)
+		m_pGeometryBuffer = &g_pGUI->GetRenderer()->createGeometryBuffer();
+
+	m_pGeometryBuffer->reset();
+	m_pGeometryBuffer->setClippingRegion(CEGUI::Rect(CEGUI::Vector2(0, 0), g_pGUI->GetRenderer()->getDisplaySize()));
+	CGUITextLayout nameLayout;
+	CGUITextLayout messageLayout;
+	int iCurrentMessage = (m_iCurrentPage * MAX_DISPLAYED_MESSAGES) - 1;
+	float fY = 30;
+
+	for(int x = 0; x < MAX_DISPLAYED_MESSAGES; x++)
+	{
+		CHAT_MESSAGE * pMessage = &m_chatMessages[iCurrentMessage - x];
+		float fX = 25.0f;
+
+		// Add the name
+		if(pMessage->fNameExtent)
+		{
+			nameLayout.Set(pMessage->szName, m_pFont, pMessage->bAllowFormatting);
+
+			// Add a name shadow
+			nameLayout.Draw(m_pGeometryBuffer, CEGUI::Vector2(fX + 1, fY + 1), MESSAGE_BACKGROUND_COLOR, false);
+
+			// Add the name
+			nameLayout.Draw(m_pGeometryBuffer, CEGUI::Vector2(fX, fY), pMessage->nameColor);
+			fX += pMessage->fNameExtent;
+		}
+
+		messageLayout.Set(pMessage->szMessage, m_pFont, pMessage->bAllowFormatting);
+
+		// Add a text shadow
+		messageLayout.Draw(m_pGeometryBuffer, CEGUI::Vector2(fX + 1, fY + 1), MESSAGE_BACKGROUND_COLOR, false);
 
+		// Add the text
+		messageLayout.Draw(m_pGeometryBuffer, CEGUI::Vector2(fX, fY), pMessage->messageColor);
+
+		fY += 20;
+	}
+
+	m_bLayoutChanged = false;
 }
 
 void CChatWindow::Draw()
@@ -45,37 +93,13 @@ void CChatWindow::Draw()
 		// Do we have a valid font?
 		if(m_pFont)
 		{
-			int iCurrentMessage = (m_iCurrentPage * MAX_DISPLAYED_MESSAGES) - 1;
-			float fY = 30;
+			// Only lay out the displayed messages again if they changed
+			if(m_bLayoutChanged || !m_pGeometryBuffer)
+				BuildGeometry();
 
-			for(int x = 0; x < MAX_DISPLAYED_MESSAGES; x++)
-			{
-				// Draw the text
-				if(m_chatMessages[iCurrentMessage - x].fNameExtent)
-				{
-					// Draw a name shadow
-					g_pGUI->DrawText(m_chatMessages[iCurrentMessage - x].szName, CEGUI::Vector2(26.0f, fY + 1), MESSAGE_BACKGROUND_COLOR, m_pFont, m_chatMessages[iCurrentMessage - x].bAllowFormatting, false);
-
-					// Draw the name
-					g_pGUI->DrawText(m_chatMessages[iCurrentMessage - x].szName, CEGUI::Vector2(25.0f, fY), m_chatMessages[iCurrentMessage - x].nameColor, m_pFont, m_chatMessages[iCurrentMessage - x].bAllowFormatting);
-
-					// Draw a text shadow
-					g_pGUI->DrawText(m_chatMessages[iCurrentMessage - x].szMessage, CEGUI::Vector2(26.0f + m_chatMessages[iCurrentMessage - x].fNameExtent, fY + 1), MESSAGE_BACKGROUND_COLOR, m_pFont, m_chatMessages[iCurrentMessage - x].bAllowFormatting);
-
-					// Draw the text
-					g_pGUI->DrawText(m_chatMessages[iCurrentMessage - x].szMessage, CEGUI::Vector2(25.0f + m_chatMessages[iCurrentMessage - x].fNameExtent, fY), m_chatMessages[iCurrentMessage - x].messageColor, m_pFont, m_chatMessages[iCurrentMessage - x].bAllowFormatting);
-				}
-				else
-				{
-					// Draw a shadow
-					g_pGUI->DrawText(m_chatMessages[iCurrentMessage - x].szMessage, CEGUI::Vector2(26.0f, fY + 1), MESSAGE_BACKGROUND_COLOR, m_pFont, m_chatMessages[iCurrentMessage - x].bAllowFormatting, false);
-
-					// Draw the text
-					g_pGUI->DrawText(m_chatMessages[iCurrentMessage - x].szMessage, CEGUI::Vector2(25.0f, fY), m_chatMessages[iCurrentMessage - x].messageColor, m_pFont, m_chatMessages[iCurrentMessage - x].bAllowFormatting);
-				}
-
-				fY += 20;
-			}
+			// Draw the text over the background
+			g_pGraphics->Flush();
+			m_pGeometryBuffer->draw();
 		}
 	}
 }
@@ -148,6 +172,7 @@ void CChatWindow::AddChatMessage(EntityId playerId, const char * szMessage)
 
 	m_chatMessages[0].fNameExtent = fTextExtent;
 	m_iMessageAmount++;
+	m_bLayoutChanged = true;
 
 	//Write messages to log
 	CLogFile::Open("Chatlog.log",true);
@@ -172,6 +197,7 @@ void CChatWindow::AddInfoMessage(const char * szFormat, ...)
 	m_chatMessages[0].fNameExtent = 0;
 	m_chatMessages[0].bAllowFormatting = true;
 	m_iMessageAmount++;
+	m_bLayoutChanged = true;
 
 	// Write info to log
 	CLogFile::Open("Chatlog.log",true);
@@ -197,6 +223,7 @@ void CChatWindow::AddInfoDebugMessage(const char * szFormat, ...)
 	m_chatMessages[0].fNameExtent = 0;
 	m_chatMessages[0].bAllowFormatting = true;
 	m_iMessageAmount++;
+	m_bLayoutChanged = true;
 
 	// Write info to log
 	CLogFile::Open("Chatlog.log",true);
@@ -221,6 +248,7 @@ void CChatWindow::AddMessage(DWORD dwColor, bool bAllowFormatting, const char *
 	m_chatMessages[0].fNameExtent = 0;
 	m_chatMessages[0].bAllowFormatting = bAllowFormatting;
 	m_iMessageAmount++;
+	m_bLayoutChanged = true;
 }
 
 void CChatWindow::PageUp()
@@ -228,14 +256,20 @@ void CChatWindow::PageUp()
 	if(m_iCurrentPage < MAX_PAGES)
 	{
 		if(m_iMessageAmount > (MAX_DISPLAYED_MESSAGES * m_iCurrentPage))
+		{
 			m_iCurrentPage++;
+			m_bLayoutChanged = true;
+		}
 	}
 }
 
 void CChatWindow::PageDown()
 {
 	if(m_iCurrentPage > 1)
+	{
 		m_iCurrentPage--;
+		m_bLayoutChanged = true;
+	}
 }
 
 void CChatWindow::InitFontAndBackground()
@@ -247,6 +281,8 @@ void CChatWindow::InitFontAndBackground()
 	if(!m_pFont)
 		g_pGUI->ShowMessageBox("Invalid chat font.\nPlease set a valid font in the Chat tab of the Settings menu.", "Warning");
 
+	m_bLayoutChanged = true;
+
 	// Set our background colors
 	m_ulBackgroundColor = D3DCOLOR_ARGB(CVAR_GET_INTEGER("chatbga"), 
 										CVAR_GET_INTEGER("chatbgr"), 
@@ -43,8 +43,11 @@ private:
 	int           m_iMessageAmount;
 	unsigned long m_ulBackgroundColor;
 	CEGUI::Font * m_pFont;
+	CEGUI::GeometryBuffer * m_pGeometryBuffer; // The text of the displayed messages
+	bool          m_bLayoutChanged;            // The geometry buffer must be rebuilt
 
 	void MoveUp();
+	void BuildGeometry();
 
 public:
 	CChatWindow();
@@ -84,6 +84,7 @@ void CCheckpoint::SetPosition(const CVector3& vecPosition)
 		m_pCheckpoint->SetPosition(vecPosition);
 
 	m_vecPosition = vecPosition;
+	OnStreamPositionChanged();
 }
 
 void CCheckpoint::GetPosition(CVector3& vecPosition)
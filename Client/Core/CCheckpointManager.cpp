@@ -19,9 +19,9 @@ extern CStreamer       * g_pStreamer;
 
 void CCheckpointManager::Pulse()
 {
-	std::list<CStreamableEntity *> * streamedCheckpoints = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_CHECKPOINT);
+	std::vector<CStreamableEntity *> * streamedCheckpoints = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_CHECKPOINT);
 
-	for(std::list<CStreamableEntity *>::iterator iter = streamedCheckpoints->begin(); iter != streamedCheckpoints->end(); ++iter)
+	for(std::vector<CStreamableEntity *>::iterator iter = streamedCheckpoints->begin(); iter != streamedCheckpoints->end(); ++iter)
 	{
 		CCheckpoint * pCheckpoint = reinterpret_cast<CCheckpoint *>(*iter);
 
@@ -16,6 +16,7 @@
 
 extern CChatWindow     * g_pChatWindow;
 extern String            g_strNick;
+extern String            g_strTransferToken;
 extern CNetworkManager * g_pNetworkManager;
 extern CMainMenu	   * g_pMainMenu;
 
@@ -36,7 +37,21 @@ void CClientPacketHandler::ConnectionSucceeded(CBitStream * pBitStream, CPlayerS
 	CBitStream  bsSend;
 	bsSend.Write(NETWORK_VERSION);
 	bsSend.Write(g_strNick);
-	bsSend.WriteBit(!CGameFileChecker::CheckFiles());
+
+	// A transfer skips the game file check, the server takes its result from the token
+	bool bTransfer = !g_strTransferToken.IsEmpty();
+	bsSend.WriteBit(bTransfer ? false : !CGameFileChecker::CheckFiles());
+	bsSend.WriteBit(bTransfer);
+
+	if(bTransfer)
+	{
+		bsSend.Write(g_strTransferToken);
+		g_strTransferToken.Clear();
+	}
+
+	// Only relay nodes identify themselves as relays
+	bsSend.WriteBit(false);
+
 	g_pNetworkManager->RPC(RPC_PlayerConnect, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
 }
 
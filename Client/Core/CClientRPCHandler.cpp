@@ -36,11 +36,16 @@
 #include "CIVWeather.h"
 #include "CCamera.h"
 #include "CFireManager.h"
+#include "CEntityDataStore.h"
 #include "CGame.h"
 #include "CStreamer.h"
+#include <Network/CSyncSerializer.h>
 
 extern String                 g_strNick;
 extern String                 g_strHost;
+extern unsigned short         g_usPort;
+extern String                 g_strPassword;
+extern String                 g_strTransferToken;
 extern CLocalPlayer         * g_pLocalPlayer;
 extern CNetworkManager      * g_pNetworkManager;
 extern CChatWindow          * g_pChatWindow;
@@ -64,6 +69,36 @@ extern CNameTags            * g_pNameTags;
 extern CCamera              * g_pCamera;
 extern CFireManager		    * g_pFireManager;
 extern CStreamer			* g_pStreamer;
+extern CEntityDataStore     * g_pEntityDataStore;
+
+// Local time the sync entry of the snapshot being read is from (0 if the sync isn't from a snapshot)
+static unsigned long g_ulSnapshotEntryTime = 0;
+
+// Difference between the local time and the server time of the snapshot that arrived the fastest
+static long g_lServerTimeOffset = 0;
+static bool g_bHasServerTimeOffset = false;
+static unsigned long g_ulLastServerTimeOffsetDecay = 0;
+
+// Time in ms after which the server time offset is allowed to grow by a ms (follows clock drift and route changes)
+#define SERVER_TIME_OFFSET_DECAY 1000
+
+static unsigned long GetSyncTime()
+{
+	if(g_ulSnapshotEntryTime != 0)
+		return g_ulSnapshotEntryTime;
+
+	return SharedUtility::GetTime();
+}
+
+bool CClientRPCHandler::GetServerTime(unsigned int& uiServerTime)
+{
+	if(!g_bHasServerTimeOffset)
+		return false;
+
+	// The remote players are interpolated behind the time their sync arrived at
+	uiServerTime = (unsigned int)((SharedUtility::GetTime() - INTERPOLATION_DELAY) - g_lServerTimeOffset);
+	return true;
+}
 
 
 bool m_bControlsDisabled = false;
@@ -76,10 +111,10 @@ void CClientRPCHandler::JoinedGame(CBitStream * pBitStream, CPlayerSocket * pSen
 
 	EntityId playerId;
 	String sHostName, sHttpServer;
-	bool bPayAndSpray, bAutoAim, bGUINametags, bHeadMovement;
+	bool bPayAndSpray, bAutoAim, bGUINametags, bHeadMovement, bHashedFiles;
 	unsigned short usHttpPort;
-	unsigned char ucWeather, ucTrafficLightState, ucHour, ucMinute;
-	unsigned int uiColor, uiMaxPlayers, uiMinuteDuration, uiTrafficLightTimePassed, uiGreenDuration, uiYellowDuration, uiRedDuration;
+	unsigned char ucWeather, ucTrafficLightState;
+	unsigned int uiColor, uiMaxPlayers, uiTrafficLightTimePassed, uiGreenDuration, uiYellowDuration, uiRedDuration;
 
 	pBitStream->Read(playerId);
 	pBitStream->Read(sHostName);
@@ -89,17 +124,13 @@ void CClientRPCHandler::JoinedGame(CBitStream * pBitStream, CPlayerSocket * pSen
 
 	pBitStream->Read(sHttpServer);
 	pBitStream->Read(usHttpPort);
+	pBitStream->Read(bHashedFiles);
 	pBitStream->Read(ucWeather);
 	pBitStream->Read(bGUINametags);
 	pBitStream->Read(bHeadMovement);
 	pBitStream->Read(uiMaxPlayers);
 
-	pBitStream->Read(ucHour);
-	pBitStream->Read(ucMinute);
-	if(pBitStream->ReadBit())
-		pBitStream->Read(uiMinuteDuration);
-	else
-		uiMinuteDuration = CTime::DEFAULT_MINUTE_DURATION;
+	g_pTime->Read(pBitStream);
 
 	g_pTrafficLights->Reset();
 	pBitStream->Read(ucTrafficLightState);
@@ -130,7 +161,7 @@ void CClientRPCHandler::JoinedGame(CBitStream * pBitStream, CPlayerSocket * pSen
 	g_pTrafficLights->SetState((CTrafficLights::eTrafficLightState)ucTrafficLightState);
 	g_pTrafficLights->SetTimeThisCycle(uiTrafficLightTimePassed);
 
-	g_pFileTransfer->SetServerInformation(sHttpServer.IsEmpty() ? g_strHost : sHttpServer, usHttpPort);
+	g_pFileTransfer->SetServerInformation(sHttpServer.IsEmpty() ? g_strHost : sHttpServer, usHttpPort, bHashedFiles);
 
 	CGame::SetNameTags(bGUINametags);
 	CGame::SetHeadMovement(bHeadMovement);
@@ -139,11 +170,10 @@ void CClientRPCHandler::JoinedGame(CBitStream * pBitStream, CPlayerSocket * pSen
 	g_pPlayerManager->SetLocalPlayer(playerId, g_pLocalPlayer);
 	g_pLocalPlayer->SetName(g_strNick);
 	g_pLocalPlayer->SetColor(uiColor);
+	g_pLocalPlayer->SetSyncInterval(TICK_RATE);
 	Scripting::SetNoResprays(!bPayAndSpray);
 	Scripting::DisablePlayerLockon(0, !bAutoAim);
 	CGame::GetWeather()->SetWeather((eWeather)(ucWeather - 1));
-	g_pTime->SetMinuteDuration(uiMinuteDuration);
-	g_pTime->SetTime(ucHour, ucMinute);
 	g_pNetworkManager->SetJoinedServer(true);
 
 	// Set the disconnect button visible
@@ -198,180 +228,180 @@ void CClientRPCHandler::NewVehicle(CBitStream * pBitStream, CPlayerSocket * pSen
 		return;
 
 	// Read the vehicle id
+	// (vehicles are packed when streamed on join, so loop until we run out of them)
 	EntityId vehicleId;
-	pBitStream->ReadCompressed(vehicleId);
-
-	// Read the model id
-	int iModelId;
-	pBitStream->Read(iModelId);
-
-	// Read the vehicle health
-	unsigned int uiHealth;
-	pBitStream->Read(uiHealth);
-
-	// Read the petroltank health
-	float fPetrolTank;
-	pBitStream->Read(fPetrolTank);
 
-	// Read the position
-	CVector3 vecPosition;
-	pBitStream->Read(vecPosition);
+	while(pBitStream->ReadCompressed(vehicleId))
+	{
+		// Read the model id
+		int iModelId;
+		pBitStream->Read(iModelId);
 
-	// Read the rotation (if we have it)
-	CVector3 vecRotation;
-	if(pBitStream->ReadBit())
-		pBitStream->Read(vecRotation);
+		// Read the vehicle health
+		unsigned int uiHealth;
+		pBitStream->Read(uiHealth);
 
-	// Read the turn speed vector (if we have it)
-	CVector3 vecTurnSpeed;
-	if(pBitStream->ReadBit())
-		pBitStream->Read(vecTurnSpeed);
+		// Read the petroltank health
+		float fPetrolTank;
+		pBitStream->Read(fPetrolTank);
 
-	// Read the move speed vector (if we have it)
-	CVector3 vecMoveSpeed;
-	if(pBitStream->ReadBit())
-		pBitStream->Read(vecMoveSpeed);
+		// Read the position
+		CVector3 vecPosition;
+		pBitStream->Read(vecPosition);
 
-	// Read the colors
-	BYTE byteColors[4];
-	pBitStream->Read((char *)byteColors, sizeof(byteColors));
+		// Read the rotation (if we have it)
+		CVector3 vecRotation;
+		if(pBitStream->ReadBit())
+			pBitStream->Read(vecRotation);
 
-	// Read the dirt level
-	float fDirtLevel;
-	pBitStream->Read(fDirtLevel);
+		// Read the turn speed vector (if we have it)
+		CVector3 vecTurnSpeed;
+		if(pBitStream->ReadBit())
+			pBitStream->Read(vecTurnSpeed);
 
-	// Read the indicator states
-	bool bIndicatorStateFrontLeft  = pBitStream->ReadBit();
-	bool bIndicatorStateFrontRight = pBitStream->ReadBit();
-	bool bIndicatorStateBackLeft   = pBitStream->ReadBit();
-	bool bIndicatorStateBackRight  = pBitStream->ReadBit();
-
-	// Read the components
-	bool bComponents[9] = {0};
-	for(int i = 0; i < 9; ++ i)
-		bComponents[i] = pBitStream->ReadBit();
-
-	// Read the horn duration
-	int iHornDuration;
-	pBitStream->Read(iHornDuration);
+		// Read the move speed vector (if we have it)
+		CVector3 vecMoveSpeed;
+		if(pBitStream->ReadBit())
+			pBitStream->Read(vecMoveSpeed);
+
+		// Read the colors
+		BYTE byteColors[4];
+		pBitStream->Read((char *)byteColors, sizeof(byteColors));
+
+		// Read the dirt level
+		float fDirtLevel;
+		pBitStream->Read(fDirtLevel);
+
+		// Read the indicator states
+		bool bIndicatorStateFrontLeft  = pBitStream->ReadBit();
+		bool bIndicatorStateFrontRight = pBitStream->ReadBit();
+		bool bIndicatorStateBackLeft   = pBitStream->ReadBit();
+		bool bIndicatorStateBackRight  = pBitStream->ReadBit();
+
+		// Read the components
+		bool bComponents[9] = {0};
+		for(int i = 0; i < 9; ++ i)
+			bComponents[i] = pBitStream->ReadBit();
+
+		// Read the horn duration
+		int iHornDuration;
+		pBitStream->Read(iHornDuration);
 	
-	// Read the siren state flag
-	bool bSirenState = pBitStream->ReadBit();
+		// Read the siren state flag
+		bool bSirenState = pBitStream->ReadBit();
 
-	// Read the lock state
-	int iLocked;
-	pBitStream->Read(iLocked);
+		// Read the lock state
+		int iLocked;
+		pBitStream->Read(iLocked);
 
-	// Convert int to dword
-	DWORD dwLockState = static_cast<DWORD>(iLocked);
+		// Convert int to dword
+		DWORD dwLockState = static_cast<DWORD>(iLocked);
 
-	// Read the engine state
-	bool bEngineStatus = pBitStream->ReadBit();
+		// Read the engine state
+		bool bEngineStatus = pBitStream->ReadBit();
 
-	// Read if our lights are on
-	bool bLights = pBitStream->ReadBit();
+		// Read if our lights are on
+		bool bLights = pBitStream->ReadBit();
 
-	// Read the door angles
-	float fDoor[6];
-	for(int i = 0; i <= 5; i++)
-		pBitStream->Read(fDoor[i]);
+		// Read the door angles
+		float fDoor[6];
+		for(int i = 0; i <= 5; i++)
+			pBitStream->Read(fDoor[i]);
 
-	// Read the window states
-	bool bWindow[4];
-	for(int i = 0; i <= 3; i++)
-		pBitStream->Read(bWindow[i]);
+		// Read the damage
+		VehicleDamageSyncData damage;
+		CSyncSerializer::Deserialize(pBitStream, damage);
 	
-	// Read if taxilight is turned on
-	bool bTaxiLight;
-	pBitStream->Read(bTaxiLight);
+		// Read if taxilight is turned on
+		bool bTaxiLight;
+		pBitStream->Read(bTaxiLight);
 
-	// Read if gps state is turned on
-	bool bGPS;
-	pBitStream->Read(bGPS);
+		// Read if gps state is turned on
+		bool bGPS;
+		pBitStream->Read(bGPS);
 
-	// Read the variation
-	unsigned char ucVariation = 0;
-	if(pBitStream->ReadBit())
-		pBitStream->Read(ucVariation);
+		// Read the variation
+		unsigned char ucVariation = 0;
+		if(pBitStream->ReadBit())
+			pBitStream->Read(ucVariation);
 
-	// Create the new vehicle
-	CNetworkVehicle * pVehicle = new CNetworkVehicle(g_pModelManager->VehicleIdToModelHash(iModelId), iModelId);
+		// Create the new vehicle
+		CNetworkVehicle * pVehicle = new CNetworkVehicle(g_pModelManager->VehicleIdToModelHash(iModelId), iModelId);
 	
-	// Set the vehicle spawn position
-	pVehicle->SetSpawnPosition(vecPosition);
+		// Set the vehicle spawn position
+		pVehicle->SetSpawnPosition(vecPosition);
 
-	// Set the vehicle spawn rotation
-	pVehicle->SetSpawnRotation(vecRotation);
+		// Set the vehicle spawn rotation
+		pVehicle->SetSpawnRotation(vecRotation);
 
-	// Add the vehicle to the vehicle manager
-	g_pVehicleManager->Add(vehicleId, pVehicle);
+		// Add the vehicle to the vehicle manager
+		g_pVehicleManager->Add(vehicleId, pVehicle);
 
-	// Set the vehicle id
-	pVehicle->SetVehicleId(vehicleId);
+		// Set the vehicle id
+		pVehicle->SetVehicleId(vehicleId);
 
-	// Set the vehicle position
-	pVehicle->SetPosition(vecPosition);
+		// Set the vehicle position
+		pVehicle->SetPosition(vecPosition);
 
-	// Set the vehicle rotation
-	pVehicle->SetRotation(vecRotation);
+		// Set the vehicle rotation
+		pVehicle->SetRotation(vecRotation);
 
-	// Set the vehicle colors
-	pVehicle->SetColors(byteColors[0], byteColors[1], byteColors[2], byteColors[3]);
+		// Set the vehicle colors
+		pVehicle->SetColors(byteColors[0], byteColors[1], byteColors[2], byteColors[3]);
 
-	// Set the vehicle health
-	pVehicle->SetHealth(uiHealth);
+		// Set the vehicle health
+		pVehicle->SetHealth(uiHealth);
 
-	// Set the vehicle turn speed vector
-	pVehicle->SetTurnSpeed(vecTurnSpeed);
+		// Set the vehicle turn speed vector
+		pVehicle->SetTurnSpeed(vecTurnSpeed);
 
-	// Set the vehicle move speed vector
-	pVehicle->SetMoveSpeed(vecMoveSpeed);
+		// Set the vehicle move speed vector
+		pVehicle->SetMoveSpeed(vecMoveSpeed);
 
-	// Set the vehicle dirt level
-	pVehicle->SetDirtLevel(fDirtLevel);
+		// Set the vehicle dirt level
+		pVehicle->SetDirtLevel(fDirtLevel);
 
-	// Set the vehicle indicators
-	pVehicle->SetIndicatorState(bIndicatorStateFrontLeft, bIndicatorStateFrontRight, bIndicatorStateBackLeft, bIndicatorStateBackRight);
+		// Set the vehicle indicators
+		pVehicle->SetIndicatorState(bIndicatorStateFrontLeft, bIndicatorStateFrontRight, bIndicatorStateBackLeft, bIndicatorStateBackRight);
 
-	// Set the components
-	for(unsigned char i = 0; i < 9; ++ i)
-		pVehicle->SetComponentState(i, bComponents[i]);
+		// Set the components
+		for(unsigned char i = 0; i < 9; ++ i)
+			pVehicle->SetComponentState(i, bComponents[i]);
 
-	// Sound horn if needed
-	pVehicle->SoundHorn(iHornDuration);
+		// Sound horn if needed
+		pVehicle->SoundHorn(iHornDuration);
 
-	// Set the locked state
-	pVehicle->SetDoorLockState(dwLockState);
+		// Set the locked state
+		pVehicle->SetDoorLockState(dwLockState);
 
-	// Set the vehicle siren state
-	pVehicle->SetSirenState(bSirenState);
+		// Set the vehicle siren state
+		pVehicle->SetSirenState(bSirenState);
 
-	// Set the variation
-	pVehicle->SetVariation(ucVariation);
+		// Set the variation
+		pVehicle->SetVariation(ucVariation);
 
-	// Set the engine status
-	pVehicle->SetEngineState(bEngineStatus);
+		// Set the engine status
+		pVehicle->SetEngineState(bEngineStatus);
 	
-	// Set the lights
-	pVehicle->SetLightsState(bLights);
+		// Set the lights
+		pVehicle->SetLightsState(bLights);
 
-	// Set the taxilights
-	pVehicle->SetTaxiLightsState(bTaxiLight);
+		// Set the taxilights
+		pVehicle->SetTaxiLightsState(bTaxiLight);
 
-	// Set the petrol tank health
-	pVehicle->SetPetrolTankHealth(fPetrolTank);
+		// Set the petrol tank health
+		pVehicle->SetPetrolTankHealth(fPetrolTank);
 
-	// Set the door angle
-	for(int i = 0; i <= 5; i++)
-		pVehicle->SetCarDoorAngle(i,false,fDoor[i]);
+		// Set the door angle
+		for(int i = 0; i <= 5; i++)
+			pVehicle->SetCarDoorAngle(i,false,fDoor[i]);
 
-	// Set the window states(broken etc)
-	for(int i = 0; i <= 3; i++)
-		pVehicle->SetWindowState(i,bWindow[i]);
+		// Set the damage (it is applied once the vehicle streams in)
+		pVehicle->SetDamage(damage);
 
-	// Flag the vehicle as can be streamed in
-	pVehicle->SetCanBeStreamedIn(true);
-	
+		// Flag the vehicle as can be streamed in
+		pVehicle->SetCanBeStreamedIn(true);
+	}
 }
 
 void CClientRPCHandler::DeleteVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -433,39 +463,38 @@ void CClientRPCHandler::NewObject(CBitStream * pBitStream, CPlayerSocket * pSend
 		// Read the attached rot
 		pBitStream->Read(vecAttachRotation);
 
-		// Create the object
+		// Read the attached bone (objects are packed so this must always be read)
+		unsigned int uiBone = 0;
+
+		if(pBitStream->ReadBit())
+			pBitStream->Read(uiBone);
+
+		// Read the movement timeline
+		CMoveTimeline timeline;
+		bool bMoving = pBitStream->ReadBit();
+
+		if(bMoving && !timeline.Deserialize(pBitStream, SharedUtility::GetTime()))
+			break;
+
+		// Create the object (the game object is created by the streamer)
 		CObject * pObject = new CObject(dwModelHash, vecPos, vecRot);
 
 		// Add the object to the object manager
 		g_pObjectManager->Add(objectId, pObject);
 
-		// Flag the object as can be streamed in
-		pObject->SetCanBeStreamedIn(true);
-
-		// If object is attached
+		// Set the attachment (it is applied once the object is streamed in)
 		if(bAttached)
+			pObject->SetAttachment(bVehicleAttached, uiVehiclePlayerId, vecAttachPosition, vecAttachRotation, uiBone);
+
+		// Continue the movement from where it is now
+		if(bMoving)
 		{
-			if(bVehicleAttached)
-			{
-				if(g_pVehicleManager->Exists(uiVehiclePlayerId))
-				{
-					CNetworkVehicle * pVehicle = g_pVehicleManager->Get(uiVehiclePlayerId);
+			pObject->SetMoveTimeline(timeline);
+			pObject->ProcessMovement(SharedUtility::GetTime());
+		}
 
-					if(pVehicle)
-						Scripting::AttachObjectToCar(pObject->GetHandle(),pVehicle->GetScriptingHandle(),0,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ);
-				}
-			}
-			else if(!bVehicleAttached)
-			{
-				if(g_pPlayerManager->DoesExist(uiVehiclePlayerId))
-				{
-					CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(uiVehiclePlayerId);
-					
-					if(pPlayer)
-						Scripting::AttachObjectToPed(pObject->GetHandle(),pPlayer->GetScriptingHandle(),(Scripting::ePedBone)0,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ,0);
-				}
-			}
-		}	
+		// Flag the object as can be streamed in
+		pObject->SetCanBeStreamedIn(true);
 	}
 }
 
@@ -480,7 +509,7 @@ void CClientRPCHandler::DetachObject(CBitStream * pBitStream, CPlayerSocket * pS
 	{
 		CObject * pObject = g_pObjectManager->Get(objectId);
 		if(pObject)
-			Scripting::DetachObject(g_pObjectManager->Get(objectId)->GetHandle(), true);
+			pObject->Detach();
 	}
 }
 void CClientRPCHandler::AttachObject(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -522,34 +551,9 @@ void CClientRPCHandler::AttachObject(CBitStream * pBitStream, CPlayerSocket * pS
 			if(pBitStream->ReadBit())
 				pBitStream->Read(iBone);
 
-			// If object is attached
+			// If object is attached (it is applied once the object is streamed in)
 			if(bAttached)
-			{
-				if(bVehicleAttached)
-				{
-					if(g_pVehicleManager->Exists(uiVehiclePlayerId))
-					{
-						CNetworkVehicle * pVehicle = g_pVehicleManager->Get(uiVehiclePlayerId);
-
-						if(pVehicle)
-							Scripting::AttachObjectToCar(pObject->GetHandle(),pVehicle->GetScriptingHandle(),0,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ);
-					}
-				}
-				else if(!bVehicleAttached)
-				{
-					if(g_pPlayerManager->DoesExist(uiVehiclePlayerId))
-					{
-						CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(uiVehiclePlayerId);
-					
-						if(pPlayer) {
-							if(iBone != -1)
-								Scripting::AttachObjectToPed(pObject->GetHandle(),pPlayer->GetScriptingHandle(),(Scripting::ePedBone)iBone,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ,0);
-							else
-								Scripting::AttachObjectToPed(pObject->GetHandle(),pPlayer->GetScriptingHandle(),(Scripting::ePedBone)0,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ,0);
-						}
-					}
-				}
-			}
+				pObject->SetAttachment(bVehicleAttached, uiVehiclePlayerId, vecAttachPosition, vecAttachRotation, ((iBone != -1) ? iBone : 0));
 		}	
 	}
 }
@@ -727,7 +731,17 @@ void CClientRPCHandler::NewActor(CBitStream * pBitStream, CPlayerSocket * pSende
 		pBitStream->Read(vehicleId);
 		pBitStream->Read(iSeat);
 
+		// Read the path (actors are packed so this must always be read)
+		CMoveTimeline path;
+		bool bPath = pBitStream->ReadBit();
+
+		if(bPath && !path.Deserialize(pBitStream, SharedUtility::GetTime()))
+			break;
+
 		g_pActorManager->Create(actorId, iModelId, vecPosition, fHeading, name, togglename, color, frozen, helmet, bBlip);
+
+		if(bPath)
+			g_pActorManager->SetPath(actorId, path);
 		//g_pActorManager->DriveToPoint(actorId, vehicleId, vecDrivePosition, vecDriveRotation, vecDriveFinalPosition, bDriveStop);
 	}
 }
@@ -1073,6 +1087,15 @@ void CClientRPCHandler::Chat(CBitStream * pBitStream, CPlayerSocket * pSenderSoc
 		g_pChatWindow->AddChatMessage(playerId, sChat);
 }
 
+// Returns the state the head and aim of the player are read with, the local player has none
+static CSyncLookState * GetLookState(CNetworkPlayer * pPlayer)
+{
+	if(!pPlayer || pPlayer->IsLocalPlayer())
+		return NULL;
+
+	return reinterpret_cast<CRemotePlayer *>(pPlayer)->GetLookState();
+}
+
 void CClientRPCHandler::OnFootSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
@@ -1088,14 +1111,23 @@ void CClientRPCHandler::OnFootSync(CBitStream * pBitStream, CPlayerSocket * pSen
 	pBitStream->ReadCompressed(usPing);
 	pBitStream->ReadCompressed(m_bHelmet);
 
-	pBitStream->Read((char *)&syncPacket, sizeof(OnFootSyncData));
+	// Get the player first so we can resolve their interned anim names
+	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+	CSyncAnimState * pAnimState = NULL;
 
-	bool bHasAimSyncData = pBitStream->ReadBit();
+	if(pPlayer && !pPlayer->IsLocalPlayer())
+		pAnimState = reinterpret_cast<CRemotePlayer *>(pPlayer)->GetAnimState();
 
-	if(bHasAimSyncData)
-		pBitStream->Read((char *)&aimSyncPacket, sizeof(AimSyncData));
+	if(!CSyncSerializer::Deserialize(pBitStream, syncPacket, pAnimState))
+		return;
+
+	bool bHasAimSyncData;
+	bool bHasHead;
+	CVector3 vecHead;
+
+	if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncPacket, GetLookState(pPlayer)))
+		return;
 
-	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 	if(pPlayer && pPlayer->IsSpawned())
 	{
 		if(!pPlayer->IsLocalPlayer()) {
@@ -1111,7 +1143,11 @@ void CClientRPCHandler::OnFootSync(CBitStream * pBitStream, CPlayerSocket * pSen
 				if(bHasAimSyncData)
 					pRemotePlayer->SetAimSyncData(&aimSyncPacket);
 
-				pRemotePlayer->StoreOnFootSync(&syncPacket);
+				// Turn their head to where they look
+				if(bHasHead)
+					Scripting::TaskLookAtCoord(pRemotePlayer->GetScriptingHandle(), vecHead.fX, vecHead.fY, vecHead.fZ, TICK_RATE, 0);
+
+				pRemotePlayer->StoreOnFootSync(&syncPacket, GetSyncTime());
 			}
 		}
 		else { if(g_pLocalPlayer->GetPlayerId() == pPlayer->GetPlayerId()) { g_pLocalPlayer->SetPing(usPing); } }
@@ -1134,15 +1170,48 @@ void CClientRPCHandler::InVehicleSync(CBitStream * pBitStream, CPlayerSocket * p
 	pBitStream->ReadCompressed(vehicleId);
 	pBitStream->ReadCompressed(usPing);
 	pBitStream->ReadCompressed(m_bHelmet);
-	pBitStream->Read((char *)&syncPacket, sizeof(InVehicleSyncData));
 
-	bool bHasAimSyncData = pBitStream->ReadBit();
+	unsigned char ucSequence;
+	unsigned char ucBaselineSequence = 0;
+	pBitStream->Read(ucSequence);
+	bool bHasBaseline = pBitStream->ReadBit();
 
-	if(bHasAimSyncData)
-		pBitStream->Read((char *)&aimSyncPacket, sizeof(AimSyncData));
+	if(bHasBaseline)
+		pBitStream->Read(ucBaselineSequence);
 
+	// Get the player first so we can resolve the delta baseline
 	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
-	if(pPlayer && pPlayer->IsSpawned())
+
+	if(!pPlayer || pPlayer->IsLocalPlayer())
+		return;
+
+	CSyncSnapshotHistory * pSnapshots = reinterpret_cast<CRemotePlayer *>(pPlayer)->GetInVehicleSnapshots();
+	const InVehicleSyncData * pBaseline = NULL;
+
+	if(bHasBaseline)
+	{
+		pBaseline = pSnapshots->Get(ucBaselineSequence);
+
+		// We can't rebuild the snapshot without its baseline
+		if(!pBaseline)
+			return;
+	}
+
+	if(!CSyncSerializer::DeserializeDelta(pBitStream, syncPacket, pBaseline))
+		return;
+
+	// Store the rebuilt snapshot and acknowledge it so it can be used as a baseline
+	pSnapshots->Store(ucSequence, syncPacket);
+	reinterpret_cast<CRemotePlayer *>(pPlayer)->SetInVehicleAck(ucSequence);
+
+	bool bHasAimSyncData;
+	bool bHasHead;
+	CVector3 vecHead;
+
+	if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncPacket, GetLookState(pPlayer)))
+		return;
+
+	if(pPlayer->IsSpawned())
 	{
 		pPlayer->SetPing(usPing);
 		if(!pPlayer->IsLocalPlayer()) {
@@ -1158,7 +1227,11 @@ void CClientRPCHandler::InVehicleSync(CBitStream * pBitStream, CPlayerSocket * p
 				if(bHasAimSyncData)
 					pRemotePlayer->SetAimSyncData(&aimSyncPacket);
 
-				pRemotePlayer->StoreInVehicleSync(vehicleId, &syncPacket);
+				// Turn their head to where they look
+				if(bHasHead)
+					Scripting::TaskLookAtCoord(pRemotePlayer->GetScriptingHandle(), vecHead.fX, vecHead.fY, vecHead.fZ, TICK_RATE, 0);
+
+				pRemotePlayer->StoreInVehicleSync(vehicleId, &syncPacket, GetSyncTime());
 			}
 		}
 	}
@@ -1180,13 +1253,16 @@ void CClientRPCHandler::PassengerSync(CBitStream * pBitStream, CPlayerSocket * p
 	pBitStream->ReadCompressed(vehicleId);
 	pBitStream->ReadCompressed(usPing);
 	pBitStream->ReadCompressed(m_bHelmet);
-	pBitStream->Read((char *)&syncPacket, sizeof(PassengerSyncData));
-	bool bHasAimSyncData = pBitStream->ReadBit();
+	if(!CSyncSerializer::Deserialize(pBitStream, syncPacket))
+		return;
+	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+	bool bHasAimSyncData;
+	bool bHasHead;
+	CVector3 vecHead;
 
-	if(bHasAimSyncData)
-		pBitStream->Read((char *)&aimSyncPacket, sizeof(AimSyncData));
+	if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncPacket, GetLookState(pPlayer)))
+		return;
 
-	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 	if(pPlayer && pPlayer->IsSpawned())
 	{
 		
@@ -1204,6 +1280,10 @@ void CClientRPCHandler::PassengerSync(CBitStream * pBitStream, CPlayerSocket * p
 				if(bHasAimSyncData)
 					pRemotePlayer->SetAimSyncData(&aimSyncPacket);
 
+				// Turn their head to where they look
+				if(bHasHead)
+					Scripting::TaskLookAtCoord(pRemotePlayer->GetScriptingHandle(), vecHead.fX, vecHead.fY, vecHead.fZ, TICK_RATE, 0);
+
 				pRemotePlayer->StorePassengerSync(vehicleId, &syncPacket);
 			}
 		}
@@ -1221,13 +1301,16 @@ void CClientRPCHandler::SmallSync(CBitStream * pBitStream, CPlayerSocket * pSend
 	SmallSyncData syncPacket;
 	AimSyncData aimSyncPacket;
 	pBitStream->ReadCompressed(playerId);
-	pBitStream->Read((char *)&syncPacket, sizeof(SmallSyncData));
-	bool bHasAimSyncData = pBitStream->ReadBit();
+	if(!CSyncSerializer::Deserialize(pBitStream, syncPacket))
+		return;
+	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+	bool bHasAimSyncData;
+	bool bHasHead;
+	CVector3 vecHead;
 
-	if(bHasAimSyncData)
-		pBitStream->Read((char *)&aimSyncPacket, sizeof(AimSyncData));
+	if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncPacket, GetLookState(pPlayer)))
+		return;
 
-	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 	if(pPlayer && pPlayer->IsSpawned())
 	{
 		// Todo: Local player stuff...
@@ -1239,24 +1322,253 @@ void CClientRPCHandler::SmallSync(CBitStream * pBitStream, CPlayerSocket * pSend
 				if(bHasAimSyncData)
 					pRemotePlayer->SetAimSyncData(&aimSyncPacket);
 
+				// Turn their head to where they look
+				if(bHasHead)
+					Scripting::TaskLookAtCoord(pRemotePlayer->GetScriptingHandle(), vecHead.fX, vecHead.fY, vecHead.fZ, TICK_RATE, 0);
+
 				pRemotePlayer->StoreSmallSync(&syncPacket);
 			}
 		}
 	}
 }
 
+void CClientRPCHandler::InputAction(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId playerId;
+	unsigned char ucInputActions;
+
+	if(!pBitStream->ReadCompressed(playerId) || !pBitStream->Read(ucInputActions))
+		return;
+
+	CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer || pPlayer->IsLocalPlayer() || !pPlayer->IsSpawned())
+		return;
+
+	// Only the action keys change, the rest of the control state comes with the next sync
+	CControlState controlState;
+	pPlayer->GetControlState(&controlState);
+
+	if(controlState.GetInputActions() == ucInputActions)
+		return;
+
+	controlState.SetInputActions(ucInputActions);
+	pPlayer->SetControlState(&controlState);
+}
+
+void CClientRPCHandler::SyncSnapshot(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	unsigned char ucCount;
+	unsigned int uiServerTime;
+
+	if(!pBitStream->Read(ucCount) || !pBitStream->Read(uiServerTime))
+		return;
+
+	// Keep the smallest offset between our time and the server time, it is the one
+	// of the snapshot with the least delay so the jitter is taken out of the others
+	unsigned long ulTime = SharedUtility::GetTime();
+	long lServerTimeOffset = (long)(ulTime - uiServerTime);
+
+	if(!g_bHasServerTimeOffset || lServerTimeOffset < g_lServerTimeOffset)
+	{
+		g_lServerTimeOffset = lServerTimeOffset;
+		g_bHasServerTimeOffset = true;
+		g_ulLastServerTimeOffsetDecay = ulTime;
+	}
+	else if((ulTime - g_ulLastServerTimeOffsetDecay) >= SERVER_TIME_OFFSET_DECAY)
+	{
+		g_lServerTimeOffset++;
+		g_ulLastServerTimeOffsetDecay = ulTime;
+	}
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		RPCIdentifier rpcId;
+		unsigned int uiSize;
+		unsigned short usAge;
+
+		if(!pBitStream->Read(rpcId) || !pBitStream->ReadCompressed(uiSize) || !pBitStream->ReadCompressed(usAge))
+			break;
+
+		// Entries are byte aligned so we can read them in place
+		pBitStream->AlignReadToByteBoundary();
+
+		if(BYTES_TO_BITS(uiSize) > pBitStream->GetNumberOfUnreadBits())
+			break;
+
+		CBitStream bitStream((pBitStream->GetData() + (pBitStream->GetReadOffset() >> 3)), uiSize, false);
+		pBitStream->IgnoreBytes(uiSize);
+
+		// The time the server received the sync at on our time line (0 is used for no time)
+		g_ulSnapshotEntryTime = (unsigned long)((uiServerTime - usAge) + g_lServerTimeOffset);
+
+		if(g_ulSnapshotEntryTime == 0)
+			g_ulSnapshotEntryTime = 1;
+
+		switch(rpcId)
+		{
+		case RPC_OnFootSync:
+			OnFootSync(&bitStream, pSenderSocket);
+			break;
+		case RPC_InVehicleSync:
+			InVehicleSync(&bitStream, pSenderSocket);
+			break;
+		case RPC_PassengerSync:
+			PassengerSync(&bitStream, pSenderSocket);
+			break;
+		case RPC_SmallSync:
+			SmallSync(&bitStream, pSenderSocket);
+			break;
+		}
+	}
+
+	g_ulSnapshotEntryTime = 0;
+}
+
+void CClientRPCHandler::CommandBatch(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	unsigned char ucCount;
+
+	if(!pBitStream->Read(ucCount))
+		return;
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		RPCIdentifier rpcId;
+		unsigned int uiSize;
+
+		if(!pBitStream->Read(rpcId) || !pBitStream->ReadCompressed(uiSize))
+			return;
+
+		// Entries are byte aligned so we can read them in place
+		pBitStream->AlignReadToByteBoundary();
+
+		if(BYTES_TO_BITS(uiSize) > pBitStream->GetNumberOfUnreadBits())
+			return;
+
+		CBitStream bitStream((pBitStream->GetData() + (pBitStream->GetReadOffset() >> 3)), uiSize, false);
+		pBitStream->IgnoreBytes(uiSize);
+
+		// Call the function of the command as if it was sent on its own
+		RPCFunction * pFunction = g_pNetworkManager->GetRPCHandler()->GetFunctionFromIdentifier(rpcId);
+
+		if(pFunction && rpcId != RPC_CommandBatch)
+			pFunction->rpcFunction(&bitStream, pSenderSocket);
+	}
+}
+
+void CClientRPCHandler::SyncRate(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	unsigned short usSyncInterval;
+
+	if(!pBitStream->ReadCompressed(usSyncInterval) || usSyncInterval == 0)
+		return;
+
+	g_pLocalPlayer->SetSyncInterval(usSyncInterval);
+}
+
 void CClientRPCHandler::EmptyVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
-//	// Ensure we have a valid bit stream
-//	if(!pBitStream)
-//		return;
-//
-//	EMPTYVEHICLESYNCPACKET syncPacket;
-//	pBitStream->Read((PCHAR)&syncPacket, sizeof(EMPTYVEHICLESYNCPACKET));
-//	CNetworkVehicle * pVehicle = g_pVehicleManager->Get(syncPacket.vehicleId);
-//
-//	if(pVehicle)
-//		pVehicle->StoreEmptySync(&syncPacket);
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	unsigned char ucCount;
+
+	if(!pBitStream->Read(ucCount))
+		return;
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		EMPTYVEHICLESYNCPACKET syncPacket;
+
+		if(!pBitStream->Read((PCHAR)&syncPacket, sizeof(EMPTYVEHICLESYNCPACKET)))
+			return;
+
+		CNetworkVehicle * pVehicle = g_pVehicleManager->Get(syncPacket.vehicleId);
+
+		// We might have become the sync owner since it was sent
+		if(pVehicle && pVehicle->IsStreamedIn() && !pVehicle->IsSyncOwner())
+			pVehicle->ApplyEmptySync(&syncPacket);
+	}
+}
+
+void CClientRPCHandler::VehicleSyncOwner(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId vehicleId;
+
+	if(!pBitStream->ReadCompressed(vehicleId))
+		return;
+
+	bool bSyncOwner = pBitStream->ReadBit();
+	CNetworkVehicle * pVehicle = g_pVehicleManager->Get(vehicleId);
+
+	if(pVehicle)
+		pVehicle->SetSyncOwner(bSyncOwner);
+}
+
+void CClientRPCHandler::VehicleDamageSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId vehicleId;
+	VehicleDamageSyncData damage;
+
+	if(!pBitStream->ReadCompressed(vehicleId) || !CSyncSerializer::Deserialize(pBitStream, damage))
+		return;
+
+	CNetworkVehicle * pVehicle = g_pVehicleManager->Get(vehicleId);
+
+	if(pVehicle)
+		pVehicle->SetDamage(damage);
+}
+
+void ResetGame();
+
+void CClientRPCHandler::PlayerTransfer(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	String strHost;
+	unsigned short usPort;
+	String strPassword;
+	String strToken;
+
+	if(!pBitStream->Read(strHost) || !pBitStream->Read(usPort) || !pBitStream->Read(strPassword) || !pBitStream->Read(strToken))
+		return;
+
+	g_pChatWindow->AddInfoMessage("Transferring to %s:%d...", strHost.Get(), usPort);
+
+	// The game is reset on the next frame and connects to the new server with the token
+	g_strHost = strHost;
+	g_usPort = usPort;
+	g_strPassword = strPassword;
+	g_strTransferToken = strToken;
+	ResetGame();
 }
 
 void CClientRPCHandler::Message(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -1295,6 +1607,12 @@ void CClientRPCHandler::ConnectionRefused(CBitStream * pBitStream, CPlayerSocket
 		strReason = "Your name is already in use.";
  	else if(iReason == REFUSE_REASON_ABORTED_BY_SCRIPT)
 		strReason = "Connection aborted by script!";
+ 	else if(iReason == REFUSE_REASON_BANNED)
+		strReason = "You are banned from this server.";
+	else if(iReason == REFUSE_REASON_TRANSFER_INVALID)
+		strReason = "The transfer to this server failed.";
+	else if(iReason == REFUSE_REASON_RELAY_UNAVAILABLE)
+		strReason = "The relay can't take any more spectators.";
  
  	// Disconnect from the server & show the message
  	g_pNetworkManager->Disconnect();
@@ -1384,8 +1702,12 @@ void CClientRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 		{
 			CLogFile::Printf("VehicleEntry(%d, %d, %d)", playerId, vehicleId, byteSeatId);
 
-			// Enter the vehicle
-			pPlayer->EnterVehicle(pVehicle, byteSeatId);
+			// We started our entry when we requested it, this only confirms it
+			if(!pPlayer->IsLocalPlayer())
+			{
+				// Enter the vehicle
+				pPlayer->EnterVehicle(pVehicle, byteSeatId);
+			}
 		}
 		// Is it an entry cancellation?
 		if(byteEnterExitVehicleType == VEHICLE_ENTRY_CANCELLED)
@@ -1410,24 +1732,6 @@ void CClientRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 	}
 }
 
-void CClientRPCHandler::HeadMovement(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
-{
-	// Ensure we have a valid bit stream
-	if(!pBitStream)
-		return;
-
-	EntityId playerId;
-	CVector3 vecAim;
-
-	pBitStream->ReadCompressed(playerId);
-	pBitStream->Read(vecAim.fX);
-	pBitStream->Read(vecAim.fY);
-	pBitStream->Read(vecAim.fZ);
-
-	if(g_pPlayerManager->DoesExist(playerId) && g_pPlayerManager->GetAt(playerId)->IsSpawned())
-		Scripting::TaskLookAtCoord(g_pPlayerManager->GetAt(playerId)->GetScriptingHandle(), vecAim.fX, vecAim.fY, vecAim.fZ, TICK_RATE, 0);
-}
-
 void CClientRPCHandler::NameChange(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
@@ -1463,19 +1767,60 @@ void CClientRPCHandler::NewFile(CBitStream * pBitStream, CPlayerSocket * pSender
 		return;
 
 	// Read the file type
+	// (files are packed when streamed on join, so loop until we run out of them)
 	bool bIsScript;
-	pBitStream->Read(bIsScript);
 
-	// Read the file name
-	String strFileName;
-	pBitStream->Read(strFileName);
+	while(pBitStream->Read(bIsScript))
+	{
+		// Read the file name
+		String strFileName;
+		pBitStream->Read(strFileName);
+
+		// Read the file checksum
+		CFileChecksum fileChecksum;
+		pBitStream->Read((char *)&fileChecksum, sizeof(CFileChecksum));
+
+		// Read the file size
+		unsigned int uiSize = 0;
+		pBitStream->Read(uiSize);
+
+		// Read if the file is in the file pack
+		bool bInPack = false;
+		pBitStream->Read(bInPack);
 
-	// Read the file checksum
+		// Read if the script is only loaded once another script requires it
+		bool bLazy = false;
+		pBitStream->Read(bLazy);
+
+		// Add the file to the file transfer
+		g_pFileTransfer->AddFile(strFileName, fileChecksum, uiSize, !bIsScript, bInPack, bLazy);
+	}
+}
+
+void CClientRPCHandler::NewFilePack(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	// Read the file pack checksum
 	CFileChecksum fileChecksum;
 	pBitStream->Read((char *)&fileChecksum, sizeof(CFileChecksum));
 
-	// Add the file to the file transfer
-	g_pFileTransfer->AddFile(strFileName, fileChecksum, !bIsScript);
+	// Read the file pack size
+	unsigned int uiSize = 0;
+	pBitStream->Read(uiSize);
+
+	g_pFileTransfer->SetFilePack(fileChecksum, uiSize);
+}
+
+void CClientRPCHandler::EntityData(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	g_pEntityDataStore->Process(pBitStream);
 }
 
 void CClientRPCHandler::DeleteFile(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -1529,17 +1874,8 @@ void CClientRPCHandler::ScriptingSetPlayerTime(CBitStream * pBitStream, CPlayerS
 	if(!pBitStream)
 		return;
 
-	unsigned char ucHour;
-	unsigned char ucMinute;
-	unsigned int uiMinuteDuration;
-	pBitStream->Read(ucHour);
-	pBitStream->Read(ucMinute);
-
-	g_pTime->SetTime(ucHour, ucMinute);
-	if(pBitStream->Read(uiMinuteDuration))
-		g_pTime->SetMinuteDuration(uiMinuteDuration);
-	else
-		g_pTime->SetMinuteDuration(CTime::DEFAULT_MINUTE_DURATION);
+	// The clock runs from here on without the server sending it again
+	g_pTime->Read(pBitStream);
 }
 
 void CClientRPCHandler::ScriptingSetPlayerWeather(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -1991,6 +2327,25 @@ void CClientRPCHandler::ScriptingDisplayText(CBitStream * pBitStream, CPlayerSoc
 	dwTextStartTick = SharedUtility::GetTime();
 }
 
+void CClientRPCHandler::JoinProgress(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	unsigned char ucProgress;
+
+	if(!pBitStream->Read(ucProgress))
+		return;
+
+	// Show the progress of the world state download
+	fTextPos[0] = 0.42f;
+	fTextPos[1] = 0.9f;
+	strTextText.Format("Loading world (%d%%)", ucProgress);
+	iTextTime = ((ucProgress < 100) ? 2000 : 1000);
+	dwTextStartTick = SharedUtility::GetTime();
+}
+
 void CClientRPCHandler::ScriptingDisplayInfoText(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
@@ -2203,6 +2558,74 @@ void CClientRPCHandler::ScriptingActorWalkToCoordinates(CBitStream * pBitStream,
 	}
 }
 
+void CClientRPCHandler::ScriptingSetActorPath(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId actorId;
+	CMoveTimeline path;
+
+	if(!pBitStream->Read(actorId) || !path.Deserialize(pBitStream, SharedUtility::GetTime()))
+		return;
+
+	g_pActorManager->SetPath(actorId, path);
+}
+
+void CClientRPCHandler::ActorPathCorrection(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	// The time the server is at on the paths of the actors we have
+	EntityId actorId;
+	unsigned int uiElapsed;
+
+	while(pBitStream->Read(actorId) && pBitStream->ReadCompressed(uiElapsed))
+		g_pActorManager->CorrectPath(actorId, uiElapsed);
+}
+
+void CClientRPCHandler::ScriptingSetBlipPosition(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	// Read the blip id
+	EntityId blipId;
+
+	if(!pBitStream->ReadCompressed(blipId) || blipId >= MAX_BLIPS)
+		return;
+
+	// Read the position
+	CVector3 vecPosition;
+
+	if(!pBitStream->Read(vecPosition))
+		return;
+
+	// Set the blip position
+	g_pBlipManager->SetPosition(blipId, vecPosition);
+}
+
+void CClientRPCHandler::AttachedBlipPositions(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	// The positions of the blips attached to players that moved, rounded to a metre
+	EntityId blipId;
+	short sX, sY, sZ;
+
+	while(pBitStream->ReadCompressed(blipId) && pBitStream->Read(sX) && pBitStream->Read(sY) && pBitStream->Read(sZ))
+	{
+		if(blipId < MAX_BLIPS)
+			g_pBlipManager->SetPosition(blipId, CVector3((float)sX, (float)sY, (float)sZ));
+	}
+}
+
 void CClientRPCHandler::ScriptingSetBlipColor(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
@@ -2336,6 +2759,65 @@ void CClientRPCHandler::ScriptingShowCheckpointForPlayer(CBitStream * pBitStream
 	}
 }
 
+void CClientRPCHandler::UpdateCheckpoint(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId checkpointId;
+	unsigned char ucFields;
+
+	if(!pBitStream->ReadCompressed(checkpointId) || !pBitStream->Read(ucFields))
+		return;
+
+	CCheckpoint * pCheckpoint = g_pCheckpointManager->Get(checkpointId);
+
+	if(!pCheckpoint)
+		return;
+
+	// Only the fields that changed are sent
+	if(ucFields & CHECKPOINT_FIELD_TYPE)
+	{
+		WORD wType;
+
+		if(!pBitStream->Read(wType))
+			return;
+
+		pCheckpoint->SetType((eCheckpointType)wType);
+	}
+
+	if(ucFields & CHECKPOINT_FIELD_POSITION)
+	{
+		CVector3 vecPosition;
+
+		if(!pBitStream->Read(vecPosition))
+			return;
+
+		pCheckpoint->SetPosition(vecPosition);
+	}
+
+	if(ucFields & CHECKPOINT_FIELD_TARGET_POSITION)
+	{
+		CVector3 vecTargetPosition;
+
+		if(!pBitStream->Read(vecTargetPosition))
+			return;
+
+		pCheckpoint->SetTargetPosition(vecTargetPosition);
+	}
+
+	if(ucFields & CHECKPOINT_FIELD_RADIUS)
+	{
+		float fRadius;
+
+		if(!pBitStream->Read(fRadius))
+			return;
+
+		pCheckpoint->SetRadius(fRadius);
+	}
+}
+
 void CClientRPCHandler::ScriptingHideCheckpointForPlayer(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
@@ -2418,19 +2900,22 @@ void CClientRPCHandler::ScriptingEventCall(CBitStream * pBitStream, CPlayerSocke
 	if(!pBitStream)
 		return;
 
-	CSquirrelArguments* pArgs = new CSquirrelArguments(pBitStream);
-	CSquirrelArgument* pEventName = pArgs->size() > 0 ? pArgs->front() : 0;
+	EventId eventId = g_pNetworkManager->GetEventNames()->ReadEvent(0, pBitStream);
 
-	if(pEventName && pEventName->GetType() == OT_STRING)
-	{
-		const char* szEventName = pEventName->data.str->C_String();
-		pArgs->pop_front();
+	if(eventId == INVALID_EVENT_ID)
+		return;
 
-		g_pEvents->Call(szEventName, pArgs);
-	}
+	CSquirrelArguments arguments(pBitStream);
+	g_pEvents->Call(eventId, &arguments);
+}
+
+void CClientRPCHandler::ScriptingEventName(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
 
-	delete pEventName;
-	delete pArgs;
+	g_pNetworkManager->GetEventNames()->ReadDefinition(0, pBitStream);
 }
 
 void CClientRPCHandler::ScriptingSetPlayerColor(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -2551,10 +3036,12 @@ void CClientRPCHandler::ScriptingSetTrafficLightState(CBitStream * pBitStream, C
 		return;
 
 	unsigned char ucState;
+	unsigned int uiTimeThisCycle;
 	CTrafficLights::eTrafficLightState eState;
 
-	// read the state
+	// read the state and how far into its cycle it is
 	pBitStream->Read(ucState);
+	pBitStream->Read(uiTimeThisCycle);
 	eState = (CTrafficLights::eTrafficLightState)ucState;
 
 	if(eState != CTrafficLights::TRAFFIC_LIGHT_STATE_DISABLED_DISABLED)
@@ -2592,6 +3079,7 @@ void CClientRPCHandler::ScriptingSetTrafficLightState(CBitStream * pBitStream, C
 		}
 	}
 	g_pTrafficLights->SetState(eState);
+	g_pTrafficLights->SetTimeThisCycle(uiTimeThisCycle);
 }
 
 void CClientRPCHandler::ScriptingSetVehicleComponents(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -2653,7 +3141,8 @@ void CClientRPCHandler::ScriptingSetObjectPosition(CBitStream * pBitStream, CPla
 		CVector3 vecPosition;
 		pBitStream->Read(vecPosition);
 
-		// Set the position
+		// Set the position (this stops the object if it was moving)
+		pObject->StopMoving();
 		pObject->SetPosition(vecPosition);
 	}
 }
@@ -2675,7 +3164,8 @@ void CClientRPCHandler::ScriptingSetObjectRotation(CBitStream * pBitStream, CPla
 		CVector3 vecRotation;
 		pBitStream->Read(vecRotation);
 
-		// Set the rotation
+		// Set the rotation (this stops the object if it was moving)
+		pObject->StopMoving();
 		pObject->SetRotation(vecRotation);
 	}
 }
@@ -3442,7 +3932,14 @@ void CClientRPCHandler::ResetVehicleEnterExit(CBitStream * pBitStream, CPlayerSo
 	EntityId playerId;
 	pBitStream->Read(playerId);
 
+	EntityId vehicleId = INVALID_ENTITY_ID;
+	pBitStream->Read(vehicleId);
+
 	if(playerId == g_pLocalPlayer->GetPlayerId()) {
+		// Roll back our entry, if it already completed get out of the vehicle again
+		if(g_pLocalPlayer->IsInVehicle() && g_pLocalPlayer->GetVehicle()->GetVehicleId() == vehicleId)
+			g_pLocalPlayer->RemoveFromVehicle();
+
 		g_pLocalPlayer->ResetVehicleEnterExit();
 	}
 }
@@ -3484,77 +3981,38 @@ void CClientRPCHandler::ScriptingFixVehicle(CBitStream * pBitStream, CPlayerSock
 	pBitStream->Read(vehicleId);
 
 	if(g_pVehicleManager->Exists(vehicleId))
-		Scripting::FixCar(g_pVehicleManager->Get(vehicleId)->GetScriptingHandle());
+	{
+		CNetworkVehicle * pVehicle = g_pVehicleManager->Get(vehicleId);
+		Scripting::FixCar(pVehicle->GetScriptingHandle());
+
+		// Forget the damage so it isn't applied again when it streams in
+		VehicleDamageSyncData damage;
+		memset(&damage, 0, sizeof(VehicleDamageSyncData));
+		pVehicle->SetDamage(damage);
+	}
 }
 
 
 void CClientRPCHandler::ScriptingMoveObject(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
+	// Ensure we have a valid bit stream
 	if(!pBitStream)
 		return;
 
 	EntityId objectId;
-	pBitStream->ReadCompressed(objectId);
+	CMoveTimeline timeline;
 
-	CVector3 vecMoveTarget;
-	pBitStream->Read(vecMoveTarget);
-
-	float fMoveSpeed;
-	pBitStream->Read(fMoveSpeed);
-
-	CVector3 vecMoveRot;
-	vecMoveRot = CVector3();
-
-	if(pBitStream->ReadBit())
-		pBitStream->Read(vecMoveRot);
-
-	CObject *pObject = g_pObjectManager->Get(objectId);
-	if(pObject) {
-		pObject->SetMoveTarget(vecMoveTarget);
-
-		CVector3 vecStart;
-		pObject->GetPosition(vecStart);
-		pObject->SetStartPosition(vecStart);
-
-		pObject->SetMoveSpeed(fMoveSpeed);
-		pObject->SetIsMoving(true);
-
-
-		if(vecMoveRot.Length() != 0) {
-			pObject->SetMoveTargetRot(vecMoveRot);
-
-			CVector3 vecStartRot;
-			pObject->GetRotation(vecStartRot);
-			pObject->SetStartRotation(vecStartRot);
-
-			pObject->SetIsRotating(true);
-		}
-	}
-}
-
-void CClientRPCHandler::ScriptingRotateObject(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
-{
-	if(!pBitStream)
+	if(!pBitStream->ReadCompressed(objectId) || !timeline.Deserialize(pBitStream, SharedUtility::GetTime()))
 		return;
 
-	EntityId objectId;
-	pBitStream->ReadCompressed(objectId);
-
-	CVector3 vecMoveRot;
-	pBitStream->Read(vecMoveRot);
+	CObject * pObject = g_pObjectManager->Get(objectId);
 
-	float fMoveSpeed;
-	pBitStream->Read(fMoveSpeed);
-
-	CObject *pObject = g_pObjectManager->Get(objectId);
-	if(pObject) {
-		pObject->SetMoveTargetRot(vecMoveRot);
-
-		CVector3 vecStartRot;
-		pObject->GetRotation(vecStartRot);
-		pObject->SetStartRotation(vecStartRot);
+	if(pObject)
+	{
+		pObject->SetMoveTimeline(timeline);
 
-		pObject->SetIsRotating(true);
+		// Place the object right away so a timeline that is already over still applies
+		pObject->ProcessMovement(SharedUtility::GetTime());
 	}
 }
 
@@ -3616,14 +4074,23 @@ void CClientRPCHandler::Register()
 	AddFunction(RPC_InVehicleSync, InVehicleSync);
 	AddFunction(RPC_PassengerSync, PassengerSync);
 	AddFunction(RPC_SmallSync, SmallSync);
+	AddFunction(RPC_InputAction, InputAction);
+	AddFunction(RPC_SyncSnapshot, SyncSnapshot);
+	AddFunction(RPC_CommandBatch, CommandBatch);
+	AddFunction(RPC_SyncRate, SyncRate);
+	AddFunction(RPC_JoinProgress, JoinProgress);
 	AddFunction(RPC_EmptyVehicleSync, EmptyVehicleSync);
+	AddFunction(RPC_VehicleSyncOwner, VehicleSyncOwner);
+	AddFunction(RPC_VehicleDamageSync, VehicleDamageSync);
+	AddFunction(RPC_PlayerTransfer, PlayerTransfer);
 	AddFunction(RPC_Message, Message);
 	AddFunction(RPC_ConnectionRefused, ConnectionRefused);
 	AddFunction(RPC_VehicleEnterExit, VehicleEnterExit);
-	AddFunction(RPC_HeadMovement, HeadMovement);
 	AddFunction(RPC_NameChange, NameChange);
 	AddFunction(RPC_NewFile, NewFile);
 	AddFunction(RPC_DeleteFile, DeleteFile);
+	AddFunction(RPC_NewFilePack, NewFilePack);
+	AddFunction(RPC_EntityData, EntityData);
 	AddFunction(RPC_NewPickup, NewPickup);
 	AddFunction(RPC_DeletePickup, DeletePickup);
 
@@ -3677,6 +4144,8 @@ void CClientRPCHandler::Register()
 	AddFunction(RPC_ScriptingSetActorCoordinates, ScriptingSetActorCoordinates);
 	AddFunction(RPC_ScriptingSetActorHeading, ScriptingSetActorHeading);
 	AddFunction(RPC_ScriptingActorWalkToCoordinates, ScriptingActorWalkToCoordinates);
+	AddFunction(RPC_ScriptingSetActorPath, ScriptingSetActorPath);
+	AddFunction(RPC_ActorPathCorrection, ActorPathCorrection);
 	AddFunction(RPC_ScriptingSetActorName, ScriptingSetActorName);
 	AddFunction(RPC_ScriptingToggleActorNametag, ScriptingToggleActorNametag);
 	AddFunction(RPC_ScriptingToggleActorBlip, ScriptingToggleActorBlip);
@@ -3685,6 +4154,8 @@ void CClientRPCHandler::Register()
 	AddFunction(RPC_ScriptingToggleActorHelmet, ScriptingToggleActorHelmet);
 	AddFunction(RPC_ScriptingWarpActorIntoVehicle, ScriptingWarpActorIntoVehicle);
 	AddFunction(RPC_ScriptingRemoveActorFromVehicle, ScriptingRemoveActorFromVehicle);
+	AddFunction(RPC_ScriptingSetBlipPosition, ScriptingSetBlipPosition);
+	AddFunction(RPC_AttachedBlipPositions, AttachedBlipPositions);
 	AddFunction(RPC_ScriptingSetBlipColor, ScriptingSetBlipColor);
 	AddFunction(RPC_ScriptingSetBlipSize, ScriptingSetBlipSize);
 	AddFunction(RPC_ScriptingToggleBlipShortRange, ScriptingToggleBlipShortRange);
@@ -3693,11 +4164,13 @@ void CClientRPCHandler::Register()
 	AddFunction(RPC_ScriptingSetBlipIcon, ScriptingSetBlipIcon);
 	AddFunction(RPC_ScriptingShowCheckpointForPlayer, ScriptingShowCheckpointForPlayer);
 	AddFunction(RPC_ScriptingHideCheckpointForPlayer, ScriptingHideCheckpointForPlayer);
+	AddFunction(RPC_UpdateCheckpoint, UpdateCheckpoint);
 	AddFunction(RPC_ScriptingToggleHUD, ScriptingToggleHUD);
 	AddFunction(RPC_ScriptingToggleRadar, ScriptingToggleRadar);
 	AddFunction(RPC_ScriptingToggleNames, ScriptingToggleNames);
 	AddFunction(RPC_ScriptingToggleAreaNames, ScriptingToggleAreaNames);
 	AddFunction(RPC_ScriptingEventCall, ScriptingEventCall);
+	AddFunction(RPC_ScriptingEventName, ScriptingEventName);
 	AddFunction(RPC_ScriptingSetPlayerColor, ScriptingSetPlayerColor);
 	AddFunction(RPC_ScriptingSetVehicleLocked, ScriptingSetVehicleLocked);
 	AddFunction(RPC_ScriptingSetPlayerClothes, ScriptingSetPlayerClothes);
@@ -3757,7 +4230,6 @@ void CClientRPCHandler::Register()
 	AddFunction(RPC_ScriptingAttachObject, AttachObject);
 	AddFunction(RPC_ScriptingDetachObject, DetachObject);
 	AddFunction(RPC_ScriptingMoveObject, ScriptingMoveObject);
-	AddFunction(RPC_ScriptingRotateObject, ScriptingRotateObject);
 	AddFunction(RPC_ScriptingSetObjectDimension, ScriptingSetObjectDimension);
 }
 
@@ -3784,14 +4256,23 @@ void CClientRPCHandler::Unregister()
 	RemoveFunction(RPC_InVehicleSync);
 	RemoveFunction(RPC_PassengerSync);
 	RemoveFunction(RPC_SmallSync);
+	RemoveFunction(RPC_InputAction);
+	RemoveFunction(RPC_SyncSnapshot);
+	RemoveFunction(RPC_CommandBatch);
+	RemoveFunction(RPC_SyncRate);
+	RemoveFunction(RPC_JoinProgress);
 	RemoveFunction(RPC_EmptyVehicleSync);
+	RemoveFunction(RPC_VehicleSyncOwner);
+	RemoveFunction(RPC_VehicleDamageSync);
+	RemoveFunction(RPC_PlayerTransfer);
 	RemoveFunction(RPC_Message);
 	RemoveFunction(RPC_ConnectionRefused);
 	RemoveFunction(RPC_VehicleEnterExit);
-	RemoveFunction(RPC_HeadMovement);
 	RemoveFunction(RPC_NameChange);
 	RemoveFunction(RPC_NewFile);
 	RemoveFunction(RPC_DeleteFile);
+	RemoveFunction(RPC_NewFilePack);
+	RemoveFunction(RPC_EntityData);
 	RemoveFunction(RPC_DeletePickup);
 	RemoveFunction(RPC_NewPickup);
 
@@ -3845,6 +4326,8 @@ void CClientRPCHandler::Unregister()
 	RemoveFunction(RPC_ScriptingSetActorCoordinates);
 	RemoveFunction(RPC_ScriptingSetActorHeading);
 	RemoveFunction(RPC_ScriptingActorWalkToCoordinates);
+	RemoveFunction(RPC_ScriptingSetActorPath);
+	RemoveFunction(RPC_ActorPathCorrection);
 	RemoveFunction(RPC_ScriptingSetActorName);
 	RemoveFunction(RPC_ScriptingToggleActorNametag);
 	RemoveFunction(RPC_ScriptingToggleActorBlip);
@@ -3853,6 +4336,8 @@ void CClientRPCHandler::Unregister()
 	RemoveFunction(RPC_ScriptingToggleActorFrozen);
 	RemoveFunction(RPC_ScriptingWarpActorIntoVehicle);
 	RemoveFunction(RPC_ScriptingRemoveActorFromVehicle);
+	RemoveFunction(RPC_ScriptingSetBlipPosition);
+	RemoveFunction(RPC_AttachedBlipPositions);
 	RemoveFunction(RPC_ScriptingSetBlipColor);
 	RemoveFunction(RPC_ScriptingSetBlipSize);
 	RemoveFunction(RPC_ScriptingToggleBlipShortRange);
@@ -3861,11 +4346,13 @@ void CClientRPCHandler::Unregister()
 	RemoveFunction(RPC_ScriptingSetBlipIcon);
 	RemoveFunction(RPC_ScriptingShowCheckpointForPlayer);
 	RemoveFunction(RPC_ScriptingHideCheckpointForPlayer);
+	RemoveFunction(RPC_UpdateCheckpoint);
 	RemoveFunction(RPC_ScriptingToggleHUD);
 	RemoveFunction(RPC_ScriptingToggleRadar);
 	RemoveFunction(RPC_ScriptingToggleNames);
 	RemoveFunction(RPC_ScriptingToggleAreaNames);
 	RemoveFunction(RPC_ScriptingEventCall);
+	RemoveFunction(RPC_ScriptingEventName);
 	RemoveFunction(RPC_ScriptingSetPlayerColor);
 	RemoveFunction(RPC_ScriptingSetVehicleLocked);
 	RemoveFunction(RPC_ScriptingSetPlayerClothes);
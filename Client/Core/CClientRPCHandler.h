@@ -42,13 +42,22 @@ private:
 	static void InVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void PassengerSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void SmallSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void InputAction(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void SyncSnapshot(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void CommandBatch(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void SyncRate(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void JoinProgress(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void EmptyVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void VehicleSyncOwner(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void VehicleDamageSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void PlayerTransfer(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void Message(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ConnectionRefused(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
-	static void HeadMovement(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void NameChange(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void NewFile(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void NewFilePack(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void EntityData(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void DeleteFile(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void NewPickup(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void DeletePickup(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
@@ -104,6 +113,8 @@ private:
 	static void ScriptingSetActorCoordinates(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetActorHeading(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingActorWalkToCoordinates(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void ScriptingSetActorPath(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void ActorPathCorrection(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetActorName(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleActorNametag(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleActorBlip(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
@@ -112,6 +123,8 @@ private:
 	static void ScriptingToggleActorHelmet(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingWarpActorIntoVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingRemoveActorFromVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void ScriptingSetBlipPosition(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void AttachedBlipPositions(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetBlipColor(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetBlipSize(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleBlipShortRange(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
@@ -120,11 +133,13 @@ private:
 	static void ScriptingSetBlipIcon(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingShowCheckpointForPlayer(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingHideCheckpointForPlayer(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void UpdateCheckpoint(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleHUD(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleRadar(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleNames(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingToggleAreaNames(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingEventCall(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void ScriptingEventName(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetPlayerColor(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetVehicleLocked(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetPlayerClothes(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
@@ -183,11 +198,14 @@ private:
 	static void ScriptingTogglePlayerLabelForPlayer(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingFixVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void	ScriptingMoveObject(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
-	static void	ScriptingRotateObject(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetObjectDimension(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void ScriptingSetCheckpointDimension(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 
 public:
+	// Gets the server time of what the remote players are shown at now, returns
+	// false until the first snapshot gave us the offset to the server time
+	static bool GetServerTime(unsigned int& uiServerTime);
+
 	void        Register();
 	void        Unregister();
 };
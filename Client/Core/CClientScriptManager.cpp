@@ -12,6 +12,8 @@
 #include "Natives.h"
 #include <CLogFile.h>
 #include "Scripting/CScriptTimerManager.h"
+#include "Scripting/CScriptBytecodeCache.h"
+#include "Scripting/CScriptProfiler.h"
 
 extern CScriptingManager * g_pScriptingManager;
 extern CScriptTimerManager * g_pScriptTimerManager;
@@ -100,6 +102,7 @@ _MEMBER_FUNCTION(GUIWebView, getLoadInfo, 0, NULL)
 _MEMBER_FUNCTION(GUIWebView, clickElement, 1, "s")
 _MEMBER_FUNCTION(GUIWebView, setSize, 2, "ii")
 _MEMBER_FUNCTION(GUIWebView, registerJavaScriptMethod, 1, "s")
+_MEMBER_FUNCTION(GUIWebView, setMaxRefreshRate, 1, "i")
 _MEMBER_FUNCTION(GUIWebView, draw, 4, "iiii")
 _END_CLASS_BASE(GUIWebView, GUIElement)
 */
@@ -120,13 +123,49 @@ _MEMBER_FUNCTION(Audio, clearPosition, 0, NULL)
 _MEMBER_FUNCTION(Audio, usePositionSystem, 1, "b")
 _END_CLASS(Audio)
 
+// DisplayElement
+_BEGIN_CLASS(DisplayElement)
+_MEMBER_FUNCTION(DisplayElement, setPosition, 2, "ff")
+_MEMBER_FUNCTION(DisplayElement, getPosition, 0, NULL)
+_MEMBER_FUNCTION(DisplayElement, setSize, 2, "ff")
+_MEMBER_FUNCTION(DisplayElement, getSize, 0, NULL)
+_MEMBER_FUNCTION(DisplayElement, setColor, 1, "i")
+_MEMBER_FUNCTION(DisplayElement, setVisible, 1, "b")
+_MEMBER_FUNCTION(DisplayElement, isVisible, 0, NULL)
+_MEMBER_FUNCTION(DisplayElement, destroy, 0, NULL)
+_END_CLASS(DisplayElement)
+
+// DisplayText
+_BEGIN_CLASS(DisplayText)
+_MEMBER_FUNCTION(DisplayText, constructor, 3, "ffs")
+_MEMBER_FUNCTION(DisplayText, setText, 1, "s")
+_MEMBER_FUNCTION(DisplayText, setFont, 1, "x")
+_MEMBER_FUNCTION(DisplayText, getTextExtent, 0, NULL)
+_END_CLASS_BASE(DisplayText, DisplayElement)
+
+// DisplayRect
+_BEGIN_CLASS(DisplayRect)
+_MEMBER_FUNCTION(DisplayRect, constructor, 5, "ffffi")
+_END_CLASS_BASE(DisplayRect, DisplayElement)
+
+// DisplayImage
+_BEGIN_CLASS(DisplayImage)
+_MEMBER_FUNCTION(DisplayImage, constructor, 3, "ffs")
+_END_CLASS_BASE(DisplayImage, DisplayElement)
+
 
 CClientScriptManager::CClientScriptManager()
 {
 	m_pScripting = new CScriptingManager();
 	g_pScriptingManager = m_pScripting;
 	m_pGUIManager = new CClientScriptGUIManager();
+	m_pDisplayList = new CDisplayList();
 	g_pScriptTimerManager = new CScriptTimerManager();
+	g_pScriptProfiler = new CScriptProfiler();
+
+	// Cache compiled client scripts so scripts that haven't changed since the
+	// last join don't have to be compiled again
+	CScriptBytecodeCache::SetDirectory(SharedUtility::GetAbsolutePath("clientfiles/cache"));
 
 	// Register the client natives
 	RegisterClientNatives(m_pScripting);
@@ -146,11 +185,18 @@ CClientScriptManager::CClientScriptManager()
 	// Register the vehicle natives
 	CVehicleNatives::Register(m_pScripting);
 
+	// Register the entity data natives
+	CEntityDataNatives::Register(m_pScripting);
+
 	// Register the area natives
 	CAreaNatives::Register(m_pScripting);
 
 	// Register the hash natives
 	CHashNatives::Register(m_pScripting);
+	CSerializationNatives::Register(m_pScripting);
+
+	// Register the shared data natives
+	CSharedDataNatives::Register(m_pScripting);
 
 	// Register the script natives
 	RegisterScriptNatives(m_pScripting);
@@ -161,6 +207,9 @@ CClientScriptManager::CClientScriptManager()
 	// Register the timer natives
 	RegisterTimerNatives(m_pScripting);
 
+	// Register the coroutine natives
+	CCoroutineNatives::Register(m_pScripting);
+
 	// Register the default constants
 	m_pScripting->RegisterDefaultConstants();
 
@@ -177,6 +226,12 @@ CClientScriptManager::CClientScriptManager()
 	m_pScripting->RegisterClass(&_CLASS_DECL(GUIProgressBar));
 	m_pScripting->RegisterClass(&_CLASS_DECL(Audio));
 
+	// Display list
+	m_pScripting->RegisterClass(&_CLASS_DECL(DisplayElement));
+	m_pScripting->RegisterClass(&_CLASS_DECL(DisplayText));
+	m_pScripting->RegisterClass(&_CLASS_DECL(DisplayRect));
+	m_pScripting->RegisterClass(&_CLASS_DECL(DisplayImage));
+
 	#ifdef IVMP_WEBKIT
 		//m_pScripting->RegisterClass(&_CLASS_DECL(GUIWebView));
 	#endif
@@ -185,8 +240,13 @@ CClientScriptManager::CClientScriptManager()
 CClientScriptManager::~CClientScriptManager()
 {
 	SAFE_DELETE(g_pScriptTimerManager);
+	SAFE_DELETE(g_pScriptProfiler);
 	SAFE_DELETE(m_pGUIManager);
 	SAFE_DELETE(m_pScripting);
+	g_pScriptingManager = NULL;
+
+	// After the scripts, their elements are deleted when the vms close
+	SAFE_DELETE(m_pDisplayList);
 
 	for(std::list<ClientScript *>::iterator iter = m_clientScripts.begin(); iter != m_clientScripts.end(); iter++)
 		SAFE_DELETE (*iter);
@@ -194,11 +254,12 @@ CClientScriptManager::~CClientScriptManager()
 	m_clientScripts.clear();
 }
 
-void CClientScriptManager::AddScript(String strName, String strPath)
+void CClientScriptManager::AddScript(String strName, String strPath, bool bLazy)
 {
 	ClientScript * pClientScript = new ClientScript();
 	pClientScript->strName = strName;
 	pClientScript->strPath = strPath;
+	pClientScript->bLazy = bLazy;
 	m_clientScripts.push_back(pClientScript);
 	CLogFile::Printf("ClientScript %s added.", strName.Get());
 }
@@ -237,6 +298,17 @@ void CClientScriptManager::Load(String strName)
 	}
 }
 
+bool CClientScriptManager::Require(String strName)
+{
+	if(!Exists(strName))
+		return false;
+
+	if(!m_pScripting->Get(strName))
+		Load(strName);
+
+	return (m_pScripting->Get(strName) != NULL);
+}
+
 void CClientScriptManager::Unload(String strName)
 {
 	if(!Exists(strName))
@@ -273,7 +345,10 @@ void CClientScriptManager::LoadAll()
 	for(std::list<ClientScript *>::iterator iter = m_clientScripts.begin(); iter != m_clientScripts.end(); iter++)
 	{
 		ClientScript * pClientScript = (*iter);
-		Load(pClientScript->strName);
+
+		// Lazy scripts are loaded once another script requires them
+		if(!pClientScript->bLazy)
+			Load(pClientScript->strName);
 	}
 }
 
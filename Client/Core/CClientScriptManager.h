@@ -12,11 +12,13 @@
 #include <list>
 #include "..\Shared\Scripting\CScriptingManager.h"
 #include "CClientScriptGUIManager.h"
+#include "CDisplayList.h"
 
 struct ClientScript
 {
 	String strName;
 	String strPath;
+	bool   bLazy; // Only loaded once another script requires it
 };
 
 class CClientScriptManager
@@ -25,6 +27,7 @@ private:
 	std::list<ClientScript *> m_clientScripts;
 	CScriptingManager       * m_pScripting;
 	CClientScriptGUIManager * m_pGUIManager;
+	CDisplayList            * m_pDisplayList;
 
 public:
 	CClientScriptManager();
@@ -32,9 +35,13 @@ public:
 
 	CScriptingManager       * GetScriptingManager() { return m_pScripting; }
 	CClientScriptGUIManager * GetGUIManager() { return m_pGUIManager; }
-	void                      AddScript(String strName, String strPath);
+	CDisplayList            * GetDisplayList() { return m_pDisplayList; }
+	void                      AddScript(String strName, String strPath, bool bLazy = false);
 	void                      RemoveScript(String strName);
 	void                      Load(String strName);
+
+	// Loads the script if it isn't loaded yet, returns true if it is loaded
+	bool                      Require(String strName);
 	void                      Unload(String strName);
 	bool                      Exists(String strName);
 	void                      LoadAll();
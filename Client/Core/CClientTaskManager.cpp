@@ -16,11 +16,7 @@ CClientTaskManager::CClientTaskManager()
 
 CClientTaskManager::~CClientTaskManager()
 {
-	for(std::list<ClientTaskPair *>::iterator iter = m_taskList.begin(); iter != m_taskList.end(); iter++)
-	{
-		// Delete the client task pair
-		delete (*iter);
-	}
+
 }
 
 bool CClientTaskManager::AddTask(CIVTask * pClientTask)
@@ -29,19 +25,17 @@ bool CClientTaskManager::AddTask(CIVTask * pClientTask)
 	if(!pClientTask)
 		return false;
 
-	// Create the client task pair
-	ClientTaskPair * pClientTaskPair = new ClientTaskPair;
+	IVTask * pGameTask = pClientTask->GetTask();
 
-	// Do we have an invalid task pair?
-	if(!pClientTaskPair)
-		return false;
+	// Does another client task already have this game task?
+	std::unordered_map<IVTask *, CIVTask *>::iterator iter = m_clientTasks.find(pGameTask);
 
-	// Set the client task pair pointers
-	pClientTaskPair->pGameTask = pClientTask->GetTask();
-	pClientTaskPair->pClientTask = pClientTask;
+	if(iter != m_clientTasks.end() && (*iter).second != pClientTask)
+		m_gameTasks.erase((*iter).second);
 
-	// Add the client task pair to the client task pair list
-	m_taskList.push_back(pClientTaskPair);
+	// Add the task to both maps
+	m_clientTasks[pGameTask] = pClientTask;
+	m_gameTasks[pClientTask] = pGameTask;
 	return true;
 }
 
@@ -49,24 +43,22 @@ bool CClientTaskManager::RemoveTask(CIVTask * pClientTask)
 {
 	// Do we have an invalid client task pointer?
 	if(!pClientTask)
-		return NULL;
+		return false;
 
-	for(std::list<ClientTaskPair *>::iterator iter = m_taskList.begin(); iter != m_taskList.end(); iter++)
-	{
-		// Is this the client task pair we are looking for?
-		if((*iter)->pClientTask == pClientTask)
-		{
-			// Delete the client task pair
-			delete (*iter);
-
-			// Remove it from the list
-			m_taskList.remove(*iter);
-			return true;
-		}
-	}
+	std::unordered_map<CIVTask *, IVTask *>::iterator iter = m_gameTasks.find(pClientTask);
 
 	// Client task not in task list
-	return false;
+	if(iter == m_gameTasks.end())
+		return false;
+
+	// Remove it from both maps
+	std::unordered_map<IVTask *, CIVTask *>::iterator clientIter = m_clientTasks.find((*iter).second);
+
+	if(clientIter != m_clientTasks.end() && (*clientIter).second == pClientTask)
+		m_clientTasks.erase(clientIter);
+
+	m_gameTasks.erase(iter);
+	return true;
 }
 
 IVTask * CClientTaskManager::GetGameTaskFromClientTask(CIVTask * pClientTask)
@@ -75,12 +67,10 @@ IVTask * CClientTaskManager::GetGameTaskFromClientTask(CIVTask * pClientTask)
 	if(!pClientTask)
 		return NULL;
 
-	for(std::list<ClientTaskPair *>::iterator iter = m_taskList.begin(); iter != m_taskList.end(); iter++)
-	{
-		// Is this the client task pair we are looking for?
-		if((*iter)->pClientTask == pClientTask)
-			return (*iter)->pGameTask;
-	}
+	std::unordered_map<CIVTask *, IVTask *>::iterator iter = m_gameTasks.find(pClientTask);
+
+	if(iter != m_gameTasks.end())
+		return (*iter).second;
 
 	// No game task found
 	return NULL;
@@ -92,12 +82,10 @@ CIVTask * CClientTaskManager::GetClientTaskFromGameTask(IVTask * pGameTask, bool
 	if(!pGameTask)
 		return NULL;
 
-	for(std::list<ClientTaskPair *>::iterator iter = m_taskList.begin(); iter != m_taskList.end(); iter++)
-	{
-		// Is this the client task pair we are looking for?
-		if((*iter)->pGameTask == pGameTask)
-			return (*iter)->pClientTask;
-	}
+	std::unordered_map<IVTask *, CIVTask *>::iterator iter = m_clientTasks.find(pGameTask);
+
+	if(iter != m_clientTasks.end())
+		return (*iter).second;
 
 	// Create the client task if requested
 	if(bCreateIfNotExist)
@@ -10,18 +10,14 @@
 #pragma once
 
 #include "CIVTask.h"
-#include <list>
-
-struct ClientTaskPair
-{
-	IVTask * pGameTask;
-	CIVTask * pClientTask;
-};
+#include <unordered_map>
 
 class CClientTaskManager
 {
 private:
-	std::list<ClientTaskPair *> m_taskList;
+	// The tasks are looked up both ways from the game hooks, so each way has its own map
+	std::unordered_map<IVTask *, CIVTask *> m_clientTasks;
+	std::unordered_map<CIVTask *, IVTask *> m_gameTasks;
 
 public:
 	CClientTaskManager();
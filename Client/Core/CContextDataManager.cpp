@@ -9,7 +9,12 @@
 
 #include "CContextDataManager.h"
 
-std::list<CContextData *> CContextDataManager::m_contextDataList;
+std::list<CContextData *>                            CContextDataManager::m_contextDataList;
+CContextData                                       * CContextDataManager::m_pPlayerNumberContextData[CONTEXT_DATA_PLAYER_NUMBERS];
+std::unordered_map<CIVPlayerInfo *, CContextData *> CContextDataManager::m_playerInfoContextData;
+std::unordered_map<IVPlayerInfo *, CContextData *>  CContextDataManager::m_gamePlayerInfoContextData;
+std::unordered_map<CIVPlayerPed *, CContextData *>  CContextDataManager::m_playerPedContextData;
+std::unordered_map<IVPlayerPed *, CContextData *>   CContextDataManager::m_gamePlayerPedContextData;
 
 CContextDataManager::CContextDataManager()
 {
@@ -24,28 +29,79 @@ CContextDataManager::~CContextDataManager()
 		// Delete this context info
 		delete *iter;
 	}
+
+	m_contextDataList.clear();
+	memset(m_pPlayerNumberContextData, 0, sizeof(m_pPlayerNumberContextData));
+	m_playerInfoContextData.clear();
+	m_gamePlayerInfoContextData.clear();
+	m_playerPedContextData.clear();
+	m_gamePlayerPedContextData.clear();
+}
+
+void CContextData::SetPlayerPed(CIVPlayerPed * pPlayerPed)
+{
+	// Find the context data by the new ped from now on
+	CContextDataManager::RemovePlayerPed(this);
+	m_pPlayerPed = pPlayerPed;
+	CContextDataManager::AddPlayerPed(this);
+}
+
+void CContextDataManager::AddPlayerPed(CContextData * pContextInfo)
+{
+	CIVPlayerPed * pPlayerPed = pContextInfo->GetPlayerPed();
+
+	if(!pPlayerPed)
+		return;
+
+	m_playerPedContextData[pPlayerPed] = pContextInfo;
+	pContextInfo->m_pGamePlayerPed = pPlayerPed->GetPlayerPed();
+
+	if(pContextInfo->m_pGamePlayerPed)
+		m_gamePlayerPedContextData[pContextInfo->m_pGamePlayerPed] = pContextInfo;
+}
+
+void CContextDataManager::RemovePlayerPed(CContextData * pContextInfo)
+{
+	if(pContextInfo->GetPlayerPed())
+		m_playerPedContextData.erase(pContextInfo->GetPlayerPed());
+
+	// The game ped could have been reused for another context info meanwhile
+	std::unordered_map<IVPlayerPed *, CContextData *>::iterator iter = m_gamePlayerPedContextData.find(pContextInfo->m_pGamePlayerPed);
+
+	if(iter != m_gamePlayerPedContextData.end() && iter->second == pContextInfo)
+		m_gamePlayerPedContextData.erase(iter);
+
+	pContextInfo->m_pGamePlayerPed = NULL;
 }
 
 CContextData * CContextDataManager::CreateContextData(CIVPlayerInfo * pPlayerInfo)
 {
 	CContextData * pContextInfo = new CContextData(pPlayerInfo);
 	m_contextDataList.push_back(pContextInfo);
+	m_pPlayerNumberContextData[pPlayerInfo->GetPlayerNumber()] = pContextInfo;
+	m_playerInfoContextData[pPlayerInfo] = pContextInfo;
+	m_gamePlayerInfoContextData[pPlayerInfo->GetPlayerInfo()] = pContextInfo;
 	return pContextInfo;
 }
 
 void CContextDataManager::DestroyContextData(CContextData * pContextInfo)
 {
-	// Loop through the context info list
-	for(std::list<CContextData *>::iterator iter = m_contextDataList.begin(); iter != m_contextDataList.end(); iter++)
-	{
-		// Is this the context info we are looking for?
-		if(*iter == pContextInfo)
-		{
-			// Remove it from the context info list
-			m_contextDataList.remove(pContextInfo);
-			break;
-		}
-	}
+	// Remove the context info from the lookups
+	CIVPlayerInfo * pPlayerInfo = pContextInfo->GetPlayerInfo();
+
+	if(m_pPlayerNumberContextData[pPlayerInfo->GetPlayerNumber()] == pContextInfo)
+		m_pPlayerNumberContextData[pPlayerInfo->GetPlayerNumber()] = NULL;
+
+	m_playerInfoContextData.erase(pPlayerInfo);
+	std::unordered_map<IVPlayerInfo *, CContextData *>::iterator iter = m_gamePlayerInfoContextData.find(pPlayerInfo->GetPlayerInfo());
+
+	if(iter != m_gamePlayerInfoContextData.end() && iter->second == pContextInfo)
+		m_gamePlayerInfoContextData.erase(iter);
+
+	RemovePlayerPed(pContextInfo);
+
+	// Remove it from the context info list
+	m_contextDataList.remove(pContextInfo);
 
 	// Delete the context info
 	delete pContextInfo;
@@ -53,80 +109,29 @@ void CContextDataManager::DestroyContextData(CContextData * pContextInfo)
 
 CContextData * CContextDataManager::GetContextData(BYTE bytePlayerNumber)
 {
-	// Loop through the context info list
-	for(std::list<CContextData *>::iterator iter = m_contextDataList.begin(); iter != m_contextDataList.end(); iter++)
-	{
-		// Get the context info pointer
-		CContextData * pContextInfo = *iter;
-
-		// Is this the context info we are looking for?
-		if(pContextInfo->GetPlayerInfo()->GetPlayerNumber() == bytePlayerNumber)
-			return pContextInfo;
-	}
-
-	return NULL;
+	return m_pPlayerNumberContextData[bytePlayerNumber];
 }
 
 CContextData * CContextDataManager::GetContextData(CIVPlayerInfo * pPlayerInfo)
 {
-	// Loop through the context info list
-	for(std::list<CContextData *>::iterator iter = m_contextDataList.begin(); iter != m_contextDataList.end(); iter++)
-	{
-		// Get the context info pointer
-		CContextData * pContextInfo = *iter;
-
-		// Is this the context info we are looking for?
-		if(pContextInfo->GetPlayerInfo() == pPlayerInfo)
-			return pContextInfo;
-	}
-
-	return NULL;
+	std::unordered_map<CIVPlayerInfo *, CContextData *>::iterator iter = m_playerInfoContextData.find(pPlayerInfo);
+	return (iter != m_playerInfoContextData.end()) ? iter->second : NULL;
 }
 
 CContextData * CContextDataManager::GetContextData(IVPlayerInfo * pPlayerInfo)
 {
-	// Loop through the context info list
-	for(std::list<CContextData *>::iterator iter = m_contextDataList.begin(); iter != m_contextDataList.end(); iter++)
-	{
-		// Get the context info pointer
-		CContextData * pContextInfo = *iter;
-
-		// Is this the context info we are looking for?
-		if(pContextInfo->GetPlayerInfo()->GetPlayerInfo() == pPlayerInfo)
-			return pContextInfo;
-	}
-
-	return NULL;
+	std::unordered_map<IVPlayerInfo *, CContextData *>::iterator iter = m_gamePlayerInfoContextData.find(pPlayerInfo);
+	return (iter != m_gamePlayerInfoContextData.end()) ? iter->second : NULL;
 }
 
 CContextData * CContextDataManager::GetContextData(CIVPlayerPed * pPlayerPed)
 {
-	// Loop through the context info list
-	for(std::list<CContextData *>::iterator iter = m_contextDataList.begin(); iter != m_contextDataList.end(); iter++)
-	{
-		// Get the context info pointer
-		CContextData * pContextInfo = *iter;
-
-		// Is this the context info we are looking for?
-		if(pContextInfo->GetPlayerPed() == pPlayerPed)
-			return pContextInfo;
-	}
-
-	return NULL;
+	std::unordered_map<CIVPlayerPed *, CContextData *>::iterator iter = m_playerPedContextData.find(pPlayerPed);
+	return (iter != m_playerPedContextData.end()) ? iter->second : NULL;
 }
 
 CContextData * CContextDataManager::GetContextData(IVPlayerPed * pPlayerPed)
 {
-	// Loop through the context info list
-	for(std::list<CContextData *>::iterator iter = m_contextDataList.begin(); iter != m_contextDataList.end(); iter++)
-	{
-		// Get the context info pointer
-		CContextData * pContextInfo = *iter;
-
-		// Is this the context info we are looking for?
-		if(pContextInfo->GetPlayerPed()->GetPlayerPed() == pPlayerPed)
-			return pContextInfo;
-	}
-
-	return NULL;
+	std::unordered_map<IVPlayerPed *, CContextData *>::iterator iter = m_gamePlayerPedContextData.find(pPlayerPed);
+	return (iter != m_gamePlayerPedContextData.end()) ? iter->second : NULL;
 }
@@ -14,12 +14,19 @@
 #include "CIVPad.h"
 #include <Math/CMath.h>
 #include <list>
+#include <unordered_map>
+
+// Player numbers are bytes so every player number gets a slot
+#define CONTEXT_DATA_PLAYER_NUMBERS 256
 
 class CContextData
 {
+	friend class CContextDataManager;
+
 private:
 	CIVPlayerInfo * m_pPlayerInfo;
 	CIVPlayerPed  * m_pPlayerPed;
+	IVPlayerPed   * m_pGamePlayerPed; // The game ped the context data is found by (the ped changes with the model)
 	CIVPad        * m_pPad;
 	CVector3        m_vecWeaponAimTarget;
 	CVector3        m_vecWeaponShotSource;
@@ -30,6 +37,7 @@ public:
 	{
 		m_pPlayerInfo = NULL;
 		m_pPlayerPed = NULL;
+		m_pGamePlayerPed = NULL;
 		m_pPad = new CIVPad();
 	}
 
@@ -37,6 +45,7 @@ public:
 	{
 		m_pPlayerInfo = NULL;
 		m_pPlayerPed = NULL;
+		m_pGamePlayerPed = NULL;
 		m_pPad = new CIVPad();
 		m_pPlayerInfo = pPlayerInfo;
 	}
@@ -46,9 +55,8 @@ public:
 		delete m_pPad;
 	}
 
-	void            SetPlayerInfo(CIVPlayerInfo * pPlayerInfo) { m_pPlayerInfo = pPlayerInfo; }
 	CIVPlayerInfo * GetPlayerInfo() { return m_pPlayerInfo; }
-	void            SetPlayerPed(CIVPlayerPed * pPlayerPed) { m_pPlayerPed = pPlayerPed; }
+	void            SetPlayerPed(CIVPlayerPed * pPlayerPed);
 	CIVPlayerPed  * GetPlayerPed() { return m_pPlayerPed; }
 	CIVPad        * GetPad() { return m_pPad; }
 	void            SetWeaponAimTarget(const CVector3& vecWeaponAimTarget) { m_vecWeaponAimTarget = vecWeaponAimTarget; }
@@ -59,10 +67,22 @@ public:
 	void            GetWeaponShotTarget(CVector3& vecWeaponShotTarget) { vecWeaponShotTarget = m_vecWeaponShotTarget; }
 };
 
+// Finds the context data of a player, the lookups run from the pad and sync
+// hooks for every ped each frame so they don't depend on the amount of players
 class CContextDataManager
 {
+	friend class CContextData;
+
 private:
-	static std::list<CContextData *> m_contextDataList;
+	static std::list<CContextData *>                              m_contextDataList;
+	static CContextData                                         * m_pPlayerNumberContextData[CONTEXT_DATA_PLAYER_NUMBERS];
+	static std::unordered_map<CIVPlayerInfo *, CContextData *>   m_playerInfoContextData;
+	static std::unordered_map<IVPlayerInfo *, CContextData *>    m_gamePlayerInfoContextData;
+	static std::unordered_map<CIVPlayerPed *, CContextData *>    m_playerPedContextData;
+	static std::unordered_map<IVPlayerPed *, CContextData *>     m_gamePlayerPedContextData;
+
+	static void           AddPlayerPed(CContextData * pContextInfo);
+	static void           RemovePlayerPed(CContextData * pContextInfo);
 
 public:
 	CContextDataManager();
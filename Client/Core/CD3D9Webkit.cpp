@@ -176,6 +176,15 @@ bool OnCharKey(const CEGUI::EventArgs &eventArgs)
 
 bool CD3D9WebkitNotification::ViewUpdate(EA::WebKit::ViewUpdateInfo& info)
 {
+	// The changed region is only set once the view finished drawing
+	if(info.mDrawEvent == EA::WebKit::ViewUpdateInfo::kViewDrawEnd)
+	{
+		CD3D9WebView * pView = (CD3D9WebView*)info.mpView->GetUserData();
+
+		if(pView)
+			pView->AddDirtyRect(info.mX, info.mY, info.mW, info.mH);
+	}
+
 	return true;
 }
 bool CD3D9WebkitNotification::LoadUpdate(EA::WebKit::LoadInfo& info)
@@ -263,6 +272,9 @@ CD3D9WebView::CD3D9WebView(int width, int height, EA::WebKit::View * view)
 	view->SetUserData(this);
 
 	texturenum = 0;
+	dirty = false;
+	maxRefreshRate = 0;
+	lastUpdateTime = 0;
 
 	name = g_pGUI->GetUniqueName();
 
@@ -299,6 +311,10 @@ void CD3D9WebView::RecreateTexture()
 	CEGUI::ImagesetManager::getSingleton().get(String("%s_%d", name.Get(), texturenum).Get()).defineImage("full_image", CEGUI::Rect(0, 0, (float)width, (float)height), CEGUI::Point(0, 0));
 	image->setProperty("Image", String("set:%s image:full_image", String("%s_%d", name.Get(), texturenum).Get()).Get());
 	CEGUI::ImagesetManager::getSingleton().destroy(String("%s_%d", name.Get(), texturenum - 1).Get());
+
+	// The new texture is empty
+	dirty = false;
+	AddDirtyRect(0, 0, width, height);
 }
 void CD3D9WebView::SetSize(int width, int height)
 {
@@ -314,15 +330,56 @@ void CD3D9WebView::SetPosition(CEGUI::UVector2 & vec)
 }
 void CD3D9WebView::SetData(void * buffer)
 {
+	if(!dirty)
+		return;
+
+	// Only lock the changed region so only it is copied and uploaded by the managed texture
 	D3DLOCKED_RECT lockedRect;
-	texture->LockRect(0, &lockedRect, NULL, 0);
-	unsigned int * buf = (unsigned int*)buffer;
-	unsigned int * destBuffer = (unsigned int*)lockedRect.pBits;
-	memcpy(lockedRect.pBits, buffer, width*height*4);
+
+	if(FAILED(texture->LockRect(0, &lockedRect, &dirtyRect, 0)))
+		return;
+
+	unsigned int rowSize = ((dirtyRect.right - dirtyRect.left) * 4);
+	unsigned char * srcBuffer = ((unsigned char*)buffer + ((dirtyRect.top * width + dirtyRect.left) * 4));
+	unsigned char * destBuffer = (unsigned char*)lockedRect.pBits;
+
+	for(int y = dirtyRect.top; y < dirtyRect.bottom; y++)
+	{
+		memcpy(destBuffer, srcBuffer, rowSize);
+		srcBuffer += (width * 4);
+		destBuffer += lockedRect.Pitch;
+	}
+
 	texture->UnlockRect(0);
+	dirty = false;
+	lastUpdateTime = GetTickCount();
 	
 	image->invalidate();
 }
+void CD3D9WebView::AddDirtyRect(int x, int y, int w, int h)
+{
+	// Clip the region to the surface
+	RECT rect = { max(x, 0), max(y, 0), min((x + w), width), min((y + h), height) };
+
+	if(rect.left >= rect.right || rect.top >= rect.bottom)
+		return;
+
+	if(!dirty)
+	{
+		dirtyRect = rect;
+		dirty = true;
+	}
+	else
+		UnionRect(&dirtyRect, &dirtyRect, &rect);
+}
+bool CD3D9WebView::IsUpdateDue()
+{
+	if(!dirty)
+		return false;
+
+	// Static views are never updated, changing ones at most maxRefreshRate times per second
+	return (maxRefreshRate == 0 || (GetTickCount() - lastUpdateTime) >= (1000 / maxRefreshRate));
+}
 void CD3D9WebView::Draw(int x, int y, int w, int h)
 {
 	RECT rect = {0, 0, w, h};
@@ -405,20 +462,27 @@ CD3D9WebKit::~CD3D9WebKit()
 }
 void CD3D9WebKit::RenderAll(bool bSetData, bool bTick)
 {
-	for(std::list<CD3D9WebView*>::iterator it = views.begin(); it != views.end(); it++)
+	// All views are ticked at the same time
+	bool bTickViews = false;
+	if(bTick && ((GetTickCount() - tickCount) > 75))
 	{
-		bool b = false;
-		if(bTick && ((GetTickCount() - tickCount) > 75))
+		tickCount = GetTickCount();
+		bTickViews = true;
+		if(keyEventsQueue.size() != 0)
 		{
-			tickCount = GetTickCount();
-			if(keyEventsQueue.size() != 0)
-			{
-				keyEventsQueue.front().view->OnKeyboardEvent(keyEventsQueue.front().e);
-				keyEventsQueue.pop();
-			}
-			b = (*it)->GetView()->Tick();
+			keyEventsQueue.front().view->OnKeyboardEvent(keyEventsQueue.front().e);
+			keyEventsQueue.pop();
 		}
-		if(bSetData && b)
+	}
+
+	for(std::list<CD3D9WebView*>::iterator it = views.begin(); it != views.end(); it++)
+	{
+		// Ticking the view draws it and reports the changed regions with ViewUpdate
+		if(bTickViews)
+			(*it)->GetView()->Tick();
+
+		// Only views that changed are updated
+		if(bSetData && (*it)->IsUpdateDue())
 		{
 			(*it)->SetData((*it)->GetView()->GetSurface()->GetData());
 		}
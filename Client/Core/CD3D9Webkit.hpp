@@ -43,6 +43,9 @@ public:
 	void SetSize(int width, int height);
 	void SetPosition(CEGUI::UVector2 & vec);
 	void SetData(void * buffer);
+	void AddDirtyRect(int x, int y, int w, int h);
+	bool IsUpdateDue();
+	void SetMaxRefreshRate(unsigned int rate) { maxRefreshRate = rate; }
 	void Draw(int x, int y, int width, int height);
 	EA::WebKit::View * GetView();
 	IDirect3DTexture9 * GetTexture();
@@ -62,6 +65,14 @@ private:
 	CEGUI::UVector2 pos;
 
 	int texturenum;
+
+	// Region of the surface that changed since the last texture update
+	RECT dirtyRect;
+	bool dirty;
+
+	// Updates per second the texture is updated at most with, 0 for no limit
+	unsigned int maxRefreshRate;
+	unsigned long lastUpdateTime;
 };
 
 
@@ -7,15 +7,28 @@
 //
 //==============================================================================
 
+#include <algorithm>
 #include "CDebugView.h"
 #include "CChatWindow.h"
 #include "CGUI.h"
 #include "CLocalPlayer.h"
+#include "CGraphics.h"
+#include "CFrameProfiler.h"
+#include "CStreamer.h"
+#include "CModelManager.h"
 
 #define DEBUG_TEXT_TOP (40.0f + (MAX_DISPLAYED_MESSAGES * 20))
 
-extern CGUI         * g_pGUI;
-extern CLocalPlayer * g_pLocalPlayer;
+// Height of the frame time graph and the frame time (in microseconds) at its top
+#define FRAME_GRAPH_HEIGHT 60.0f
+#define FRAME_GRAPH_MAX_TIME 50000
+
+extern CGUI           * g_pGUI;
+extern CGraphics      * g_pGraphics;
+extern CLocalPlayer   * g_pLocalPlayer;
+extern CFrameProfiler * g_pFrameProfiler;
+extern CStreamer      * g_pStreamer;
+extern CModelManager  * g_pModelManager;
 
 CDebugView::CDebugView()
 	: m_fDebugTextTop(0)
@@ -166,6 +179,35 @@ void CDebugView::DumpPlayer(CNetworkPlayer * pPlayer)
 	DumpTasks(pPedTaskManager, 2);
 }
 
+void CDebugView::DumpStreamer()
+{
+	if(!g_pStreamer)
+		return;
+
+	DrawText("Streamer Debug: ");
+	DrawText("");
+
+	const char * szTypeNames[] = { "Vehicles", "Pickups", "Objects", "Checkpoints", "Players" };
+
+	for(int i = 0; i < STREAM_ENTITY_MAX; i++)
+	{
+		eStreamEntityType eType = (eStreamEntityType)i;
+		String strText("%s (StreamedIn/StreamedInLimit): %d/%d", szTypeNames[i], g_pStreamer->GetStreamedInEntityCountOfType(eType), g_pStreamer->GetStreamedInLimitOfType(eType));
+		unsigned int uiUsed;
+		unsigned int uiSize;
+
+		if(g_pStreamer->GetPoolUsage(eType, &uiUsed, &uiSize))
+			strText.AppendF(" Pool (Used/Size): %d/%d", uiUsed, uiSize);
+
+		DrawText(strText);
+	}
+
+	if(g_pModelManager)
+		DrawText(String("Unused Models (Loaded/Budget): %d/%d", g_pModelManager->GetUnusedModelCount(), g_pModelManager->GetModelBudget()));
+
+	DrawText("");
+}
+
 void CDebugView::Draw()
 {
 	if(g_pGUI)
@@ -174,5 +216,64 @@ void CDebugView::Draw()
 
 		// TODO: Different modes (all network players, all network vehicles, network info, e.t.c.)
 		DumpPlayer(g_pLocalPlayer);
+		DumpStreamer();
+	}
+}
+
+void CDebugView::DrawFrameProfile()
+{
+	if(!g_pGUI || !g_pGraphics || !g_pFrameProfiler)
+		return;
+
+	m_fDebugTextTop = DEBUG_TEXT_TOP;
+	unsigned int uiSampleCount = g_pFrameProfiler->GetSampleCount();
+
+	// Draw the graph background and a line at 60 and 30 fps
+	g_pGraphics->DrawRect(26.0f, m_fDebugTextTop, (float)FRAME_PROFILER_HISTORY, FRAME_GRAPH_HEIGHT, D3DCOLOR_ARGB(120, 0, 0, 0));
+	g_pGraphics->DrawRect(26.0f, (m_fDebugTextTop + FRAME_GRAPH_HEIGHT - (FRAME_GRAPH_HEIGHT * 16667 / FRAME_GRAPH_MAX_TIME)), (float)FRAME_PROFILER_HISTORY, 1.0f, D3DCOLOR_ARGB(120, 255, 255, 255));
+	g_pGraphics->DrawRect(26.0f, (m_fDebugTextTop + FRAME_GRAPH_HEIGHT - (FRAME_GRAPH_HEIGHT * 33333 / FRAME_GRAPH_MAX_TIME)), (float)FRAME_PROFILER_HISTORY, 1.0f, D3DCOLOR_ARGB(120, 255, 255, 255));
+
+	// Draw a bar for each frame, the newest on the right
+	unsigned long long ullCpuTime[FRAME_PROFILER_STAGE_MAX];
+	unsigned long long ullGpuTime[FRAME_PROFILER_STAGE_MAX];
+	unsigned long long ullFrameTime = 0;
+	memset(ullCpuTime, 0, sizeof(ullCpuTime));
+	memset(ullGpuTime, 0, sizeof(ullGpuTime));
+
+	for(unsigned int i = 0; i < uiSampleCount; i++)
+	{
+		FrameProfilerSample * pSample = g_pFrameProfiler->GetSample(i);
+		unsigned long long ullBarTime = (std::min)(pSample->ullFrameTime, (unsigned long long)FRAME_GRAPH_MAX_TIME);
+		float fBarHeight = (FRAME_GRAPH_HEIGHT * ullBarTime / FRAME_GRAPH_MAX_TIME);
+		DWORD dwColor = D3DCOLOR_ARGB(200, 0, 200, 0);
+
+		if(pSample->ullFrameTime > 33333)
+			dwColor = D3DCOLOR_ARGB(200, 220, 0, 0);
+		else if(pSample->ullFrameTime > 16667)
+			dwColor = D3DCOLOR_ARGB(200, 220, 220, 0);
+
+		g_pGraphics->DrawRect((26.0f + FRAME_PROFILER_HISTORY - uiSampleCount + i), (m_fDebugTextTop + FRAME_GRAPH_HEIGHT - fBarHeight), 1.0f, fBarHeight, dwColor);
+		ullFrameTime += pSample->ullFrameTime;
+
+		for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+		{
+			ullCpuTime[iStage] += pSample->ullCpuTime[iStage];
+			ullGpuTime[iStage] += pSample->ullGpuTime[iStage];
+		}
+	}
+
+	m_fDebugTextTop += (FRAME_GRAPH_HEIGHT + 4.0f);
+
+	if(uiSampleCount == 0)
+		return;
+
+	// Draw the averages of the shown frames
+	DrawText(String("Frame: %.2f ms (p99: %.2f ms, max: %.2f ms)", ((float)ullFrameTime / uiSampleCount / 1000.0f), 
+		((float)g_pFrameProfiler->GetFrameTimePercentile(99) / 1000.0f), ((float)g_pFrameProfiler->GetFrameTimePercentile(100) / 1000.0f)));
+
+	for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+	{
+		DrawText(String("%s: %.2f ms cpu, %.2f ms gpu", CFrameProfiler::GetStageName((eFrameProfilerStage)iStage), 
+			((float)ullCpuTime[iStage] / uiSampleCount / 1000.0f), ((float)ullGpuTime[iStage] / uiSampleCount / 1000.0f)));
 	}
 }
@@ -29,9 +29,15 @@ private:
 	// Dump player
 	void DumpPlayer(CNetworkPlayer * pPlayer);
 
+	// Dump the streaming limits and the game pools they come from
+	void DumpStreamer();
+
 public:
 	CDebugView();
 	~CDebugView();
 
 	void Draw();
+
+	// Draw the frame time graph and the stage times of the frame profiler
+	void DrawFrameProfile();
 };
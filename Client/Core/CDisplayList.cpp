@@ -0,0 +1,140 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CDisplayList.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CDisplayList.h"
+#include "CGraphics.h"
+#include <CSettings.h>
+#include <Common.h>
+
+extern CGUI * g_pGUI;
+extern CGraphics * g_pGraphics;
+
+CDisplayList::CDisplayList()
+{
+
+}
+
+CDisplayList::~CDisplayList()
+{
+	DeleteAll();
+}
+
+DisplayElement * CDisplayList::Create(eDisplayElementType type)
+{
+	DisplayElement * pElement = new DisplayElement;
+	pElement->type = type;
+	pElement->vecPosition = CEGUI::Vector2(0.0f, 0.0f);
+	pElement->size = CEGUI::Size(0.0f, 0.0f);
+	pElement->ulColor = 0xFFFFFFFF;
+	pElement->bVisible = true;
+	pElement->pFont = NULL;
+	pElement->pImage = NULL;
+	m_elements.push_back(pElement);
+	return pElement;
+}
+
+void CDisplayList::Delete(DisplayElement * pElement)
+{
+	if(!pElement)
+		return;
+
+	m_elements.remove(pElement);
+	delete pElement;
+}
+
+void CDisplayList::DeleteAll()
+{
+	for(std::list<DisplayElement *>::iterator iter = m_elements.begin(); iter != m_elements.end(); iter++)
+		delete (*iter);
+
+	m_elements.clear();
+}
+
+void CDisplayList::SetText(DisplayElement * pElement, const String& strText)
+{
+	pElement->strText = strText;
+
+	// Texts without a font use the chat font like CGUI::DrawText does
+	CEGUI::Font * pFont = pElement->pFont;
+
+	if(!pFont && g_pGUI)
+		pFont = g_pGUI->GetFont(CVAR_GET_STRING("chatfont").Get());
+
+	// This does nothing if the text and font didn't change
+	if(pFont)
+		pElement->textLayout.Set(strText, pFont);
+}
+
+void CDisplayList::SetFont(DisplayElement * pElement, CEGUI::Font * pFont)
+{
+	pElement->pFont = pFont;
+	SetText(pElement, pElement->strText);
+}
+
+bool CDisplayList::SetImage(DisplayElement * pElement, const String& strFile)
+{
+	if(!g_pGUI)
+		return false;
+
+	try
+	{
+		// Small images share the textures of the image atlas so they go in the same batch
+		String strImage = g_pGUI->GetImageAtlas()->Load(g_pGUI->GetUniqueName(), strFile, "resources");
+		pElement->pImage = CEGUI::PropertyHelper::stringToImage(strImage.C_String());
+	}
+	catch(CEGUI::Exception e)
+	{
+		return false;
+	}
+
+	if(!pElement->pImage)
+		return false;
+
+	// Images without a size are drawn at the size of the file
+	if(pElement->size.d_width <= 0.0f || pElement->size.d_height <= 0.0f)
+		pElement->size = pElement->pImage->getSize();
+
+	return true;
+}
+
+void CDisplayList::Render()
+{
+	if(m_elements.empty() || !g_pGUI || !g_pGraphics)
+		return;
+
+	// The rects are flushed before the batch is drawn so they are under it
+	for(std::list<DisplayElement *>::iterator iter = m_elements.begin(); iter != m_elements.end(); iter++)
+	{
+		DisplayElement * pElement = (*iter);
+
+		if(pElement->bVisible && pElement->type == DISPLAY_ELEMENT_RECT)
+			g_pGraphics->DrawRect(pElement->vecPosition.d_x, pElement->vecPosition.d_y, pElement->size.d_width, pElement->size.d_height, pElement->ulColor);
+	}
+
+	// The images and texts are drawn with a single draw call (per texture)
+	g_pGUI->BeginTextBatch();
+
+	for(std::list<DisplayElement *>::iterator iter = m_elements.begin(); iter != m_elements.end(); iter++)
+	{
+		DisplayElement * pElement = (*iter);
+
+		if(!pElement->bVisible)
+			continue;
+
+		if(pElement->type == DISPLAY_ELEMENT_IMAGE && pElement->pImage)
+		{
+			CEGUI::Rect rect(pElement->vecPosition.d_x, pElement->vecPosition.d_y, (pElement->vecPosition.d_x + pElement->size.d_width), (pElement->vecPosition.d_y + pElement->size.d_height));
+			g_pGUI->AddImageToBatch(pElement->pImage, rect, CEGUI::colour(pElement->ulColor));
+		}
+		else if(pElement->type == DISPLAY_ELEMENT_TEXT && !pElement->textLayout.IsEmpty())
+			g_pGUI->AddTextToBatch(&pElement->textLayout, pElement->vecPosition, CEGUI::colour(pElement->ulColor));
+	}
+
+	g_pGUI->DrawTextBatch();
+}
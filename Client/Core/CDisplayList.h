@@ -0,0 +1,59 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CDisplayList.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include "CGUI.h"
+#include <CString.h>
+
+enum eDisplayElementType
+{
+	DISPLAY_ELEMENT_TEXT,
+	DISPLAY_ELEMENT_RECT,
+	DISPLAY_ELEMENT_IMAGE
+};
+
+struct DisplayElement
+{
+	eDisplayElementType  type;
+	CEGUI::Vector2       vecPosition;
+	CEGUI::Size          size;        // Of rects and images
+	unsigned long        ulColor;     // ARGB
+	bool                 bVisible;
+	CGUITextLayout       textLayout;  // Of texts, only laid out again when the text or font changes
+	String               strText;
+	CEGUI::Font        * pFont;
+	const CEGUI::Image * pImage;
+};
+
+// Elements scripts create once and change when they need to, they are all drawn
+// in a single pass after the frameRender event so a static HUD costs the scripts
+// nothing each frame. Rects are drawn under the images and texts.
+class CDisplayList
+{
+private:
+	std::list<DisplayElement *> m_elements;
+
+public:
+	CDisplayList();
+	~CDisplayList();
+
+	DisplayElement * Create(eDisplayElementType type);
+	void             Delete(DisplayElement * pElement);
+	void             DeleteAll();
+
+	void             SetText(DisplayElement * pElement, const String& strText);
+	void             SetFont(DisplayElement * pElement, CEGUI::Font * pFont);
+
+	// Loads the image into the image atlas, returns false if it can't be loaded
+	bool             SetImage(DisplayElement * pElement, const String& strFile);
+
+	void             Render();
+};
@@ -0,0 +1,89 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityDataStore.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CEntityDataStore.h"
+
+void CEntityDataStore::Set(eEntityDataType type, EntityId entityId, String strKey, const CSquirrelArgument& value)
+{
+	CSquirrelArgument& data = m_data[type][entityId][strKey];
+	data.reset();
+	data.set(value);
+}
+
+CSquirrelArgument * CEntityDataStore::Get(eEntityDataType type, EntityId entityId, String strKey)
+{
+	std::map<EntityId, EntityDataStoreMap>::iterator iter = m_data[type].find(entityId);
+
+	if(iter == m_data[type].end())
+		return NULL;
+
+	EntityDataStoreMap::iterator keyIter = (*iter).second.find(strKey);
+
+	if(keyIter == (*iter).second.end())
+		return NULL;
+
+	return &(*keyIter).second;
+}
+
+void CEntityDataStore::Remove(eEntityDataType type, EntityId entityId, String strKey)
+{
+	std::map<EntityId, EntityDataStoreMap>::iterator iter = m_data[type].find(entityId);
+
+	if(iter == m_data[type].end())
+		return;
+
+	(*iter).second.erase(strKey);
+
+	if((*iter).second.empty())
+		m_data[type].erase(iter);
+}
+
+void CEntityDataStore::Clear(eEntityDataType type, EntityId entityId)
+{
+	m_data[type].erase(entityId);
+}
+
+void CEntityDataStore::Process(CBitStream * pBitStream)
+{
+	unsigned char ucOperation;
+
+	// Every operation starts on a byte boundary
+	while(pBitStream->Read(ucOperation))
+	{
+		unsigned char ucType;
+		EntityId entityId;
+
+		if(!pBitStream->Read(ucType) || !pBitStream->ReadCompressed(entityId) || ucType >= ENTITY_DATA_TYPE_MAX)
+			return;
+
+		eEntityDataType type = (eEntityDataType)ucType;
+
+		if(ucOperation == ENTITY_DATA_OPERATION_CLEAR)
+			Clear(type, entityId);
+		else
+		{
+			String strKey;
+
+			if(!pBitStream->Read(strKey))
+				return;
+
+			if(ucOperation == ENTITY_DATA_OPERATION_SET)
+			{
+				CSquirrelArgument value(pBitStream);
+				Set(type, entityId, strKey, value);
+			}
+			else if(ucOperation == ENTITY_DATA_OPERATION_REMOVE)
+				Remove(type, entityId, strKey);
+			else
+				return;
+		}
+
+		pBitStream->AlignReadToByteBoundary();
+	}
+}
@@ -0,0 +1,37 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityDataStore.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <CString.h>
+#include <Common.h>
+#include <Network/CBitStream.h>
+#include <Network/EntityData.h>
+#include <Scripting/CSquirrelArguments.h>
+
+typedef std::map<String, CSquirrelArgument> EntityDataStoreMap;
+
+// The entity data the server replicated to us, kept up to date by the
+// operations of RPC_EntityData
+class CEntityDataStore
+{
+private:
+	std::map<EntityId, EntityDataStoreMap> m_data[ENTITY_DATA_TYPE_MAX];
+
+public:
+	void                Set(eEntityDataType type, EntityId entityId, String strKey, const CSquirrelArgument& value);
+	// Returns NULL if the entity has no data with the key
+	CSquirrelArgument * Get(eEntityDataType type, EntityId entityId, String strKey);
+	void                Remove(eEntityDataType type, EntityId entityId, String strKey);
+	void                Clear(eEntityDataType type, EntityId entityId);
+
+	// Applies the operations of an RPC_EntityData message
+	void                Process(CBitStream * pBitStream);
+};
@@ -10,6 +10,7 @@
 
 #include "CFileTransfer.h"
 #include <stdio.h>
+#include <algorithm>
 #include "SharedUtility.h"
 #include "CClientScriptManager.h"
 #include "CChatWindow.h"
@@ -27,100 +28,309 @@ extern CLocalPlayer			* g_pLocalPlayer;
 
 #define TRANSFERBOX_WIDTH       350
 #define TRANSFERBOX_HEIGHT      58
+#define PROGRESSBAR_HEIGHT      20
 
 CFileTransfer::CFileTransfer()
-	: m_bDownloadingFile(false),
-	m_pDownloadFile(NULL),
-	m_fDownloadFile(NULL),
+	: m_usPort(0),
+	m_bHashedFiles(false),
+	m_checksumCache(SharedUtility::GetAbsolutePath("clientfiles/%s", CHECKSUM_CACHE_FILE)),
+	m_bHasFilePack(false),
+	m_bFilePackQueued(false),
+	m_uiActiveDownloads(0),
+	m_uiTotalBytes(0),
+	m_uiDownloadedBytes(0),
+	m_pFileText(NULL),
 	m_pFileImage(NULL),
-	m_pFileText(NULL)
+	m_pProgressBar(NULL)
 {
-	// Set the http client receive handler
-	m_httpClient.SetReceiveHandle(ReceiveHandler, this);
+	for(int i = 0; i < FILE_TRANSFER_MAX_DOWNLOADS; i++)
+	{
+		FileDownload * pDownload = &m_downloads[i];
+		pDownload->pFileTransfer = this;
+		pDownload->pServerFile = NULL;
+		pDownload->fFile = NULL;
+		pDownload->uiBytesReceived = 0;
+		pDownload->bResumed = false;
+		pDownload->bCheckedStatus = false;
+
+		// Set the http client receive handler, the server sends client files compressed if it can
+		pDownload->httpClient.SetReceiveHandle(ReceiveHandler, pDownload);
+		pDownload->httpClient.SetAcceptCompression(true);
+	}
 }
 
 bool CFileTransfer::ReceiveHandler(const char * szData, unsigned int uiDataSize, void * pUserData)
 {
-	// Get the CFileTransfer pointer
-	CFileTransfer * pFileTransfer = (CFileTransfer *)pUserData;
+	// Get the download pointer
+	FileDownload * pDownload = (FileDownload *)pUserData;
+
+	// Did the server send the whole file instead of the rest of the partial file?
+	if(!pDownload->bCheckedStatus)
+	{
+		pDownload->bCheckedStatus = true;
+
+		if(pDownload->bResumed && pDownload->httpClient.GetStatusCode() != 206)
+		{
+			if(pDownload->fFile)
+				pDownload->fFile = freopen(pDownload->strPartPath.Get(), "wb", pDownload->fFile);
+
+			pDownload->uiBytesReceived = 0;
+			pDownload->bResumed = false;
+		}
+	}
 
 	// Write the data to the download file
-	if(pFileTransfer->m_fDownloadFile)
-		fwrite(szData, 1, uiDataSize, pFileTransfer->m_fDownloadFile);
+	if(pDownload->fFile)
+		fwrite(szData, 1, uiDataSize, pDownload->fFile);
+
+	pDownload->uiBytesReceived += uiDataSize;
 
 	// Discard the data
 	return false;
 }
 
-bool CFileTransfer::StartDownload(String strName, String strType)
+String CFileTransfer::GetFilePath(String strName, String strType)
 {
-	if(m_pFileImage)
-		m_pFileImage->setVisible(true);
+	// The file pack is in the client files folder itself
+	if(strType == "pack")
+		return SharedUtility::GetAbsolutePath("clientfiles/%s", strName.Get());
+
+	return SharedUtility::GetAbsolutePath("clientfiles/%s/%s", ((strType == "resource") ? "resources" : "clientscripts"), strName.Get());
+}
+
+void CFileTransfer::CreateFolder(String strType)
+{
+	// Create the client files folder if needed
+	String strClientFilesFolder(SharedUtility::GetAbsolutePath("clientfiles"));
+
+	if(!SharedUtility::Exists(strClientFilesFolder.Get()))
+		SharedUtility::CreateDirectory(strClientFilesFolder.Get());
 
+	if(strType == "pack")
+		return;
+
+	// Create the destination type folder if needed
+	String strDestinationFolder("%s/%s", strClientFilesFolder.Get(), ((strType == "resource") ? "resources" : "clientscripts"));
+
+	if(!SharedUtility::Exists(strDestinationFolder.Get()))
+		SharedUtility::CreateDirectory(strDestinationFolder.Get());
+}
+
+bool CFileTransfer::StartDownload(FileDownload * pDownload, ServerFile * pServerFile, bool bResume)
+{
 	// Ensure we have a server address set
-	if(m_httpClient.GetHost().IsNotEmpty())
+	if(m_strHost.IsEmpty())
+		return false;
+
+	// Get the uri of the file (the file pack is in the root of the web server)
+	String strUri;
+
+	if(m_bHashedFiles && pServerFile->strType != "pack")
+		strUri.Format("%s/%s", HASHED_FILES_URI, pServerFile->fileChecksum.GetHashedName(pServerFile->uiSize, pServerFile->strName).Get());
+	else if(pServerFile->strType == "resource")
+		strUri.Format("/resources/%s", pServerFile->strName.Get());
+	else if(pServerFile->strType == "script")
+		strUri.Format("/clientscripts/%s", pServerFile->strName.Get());
+	else
+		strUri.Format("/%s", pServerFile->strName.Get());
+
+	// Create the destination folder if needed
+	CreateFolder(pServerFile->strType);
+
+	// Is there a partial file from an earlier download we can resume?
+	pDownload->strPartPath.Format("%s%s", GetFilePath(pServerFile->strName, pServerFile->strType).Get(), FILE_TRANSFER_PART_EXTENSION);
+	unsigned int uiRangeStart = 0;
+
+	if(bResume)
+	{
+		pDownload->fFile = fopen(pDownload->strPartPath.Get(), "ab");
+
+		if(pDownload->fFile)
+		{
+			fseek(pDownload->fFile, 0, SEEK_END);
+			uiRangeStart = (unsigned int)ftell(pDownload->fFile);
+
+			// Only resume if the partial file is smaller than the server file (its size is 0 if the server didn't send it)
+			if(uiRangeStart >= pServerFile->uiSize)
+			{
+				uiRangeStart = 0;
+				pDownload->fFile = freopen(pDownload->strPartPath.Get(), "wb", pDownload->fFile);
+			}
+		}
+	}
+	else
+		pDownload->fFile = fopen(pDownload->strPartPath.Get(), "wb");
+
+	// Did the destination file not open sucessfully?
+	if(!pDownload->fFile)
+		return false;
+
+	// Send the request
+	pDownload->httpClient.SetHost(m_strHost);
+	pDownload->httpClient.SetPort(m_usPort);
+
+	if(!pDownload->httpClient.Get(strUri, uiRangeStart))
 	{
-		// Get the folder name
-		String strFolderName;
+		fclose(pDownload->fFile);
+		pDownload->fFile = NULL;
+		return false;
+	}
 
-		if(strType == "resource")
-			strFolderName = "resources";
-		else if(strType == "script")
-			strFolderName = "clientscripts";
+	pDownload->pServerFile = pServerFile;
+	pDownload->uiBytesReceived = uiRangeStart;
+	pDownload->bResumed = (uiRangeStart > 0);
+	pDownload->bCheckedStatus = false;
+	m_uiActiveDownloads++;
+	SetProgressVisible(true);
+	return true;
+}
+
+bool CFileTransfer::FinishDownload(FileDownload * pDownload)
+{
+	ServerFile * pServerFile = pDownload->pServerFile;
 
-		// Create the client files folder string
-		String strClientFilesFolder(SharedUtility::GetAbsolutePath("clientfiles"));
+	// Close the file
+	if(pDownload->fFile)
+		fclose(pDownload->fFile);
 
-		// Create the client files folder if needed
-		if(!SharedUtility::Exists(strClientFilesFolder.Get()))
-			SharedUtility::CreateDirectory(strClientFilesFolder.Get());
+	pDownload->fFile = NULL;
+
+	// Has the http client not successfully downloaded the file (the partial file is resumed with the next download)?
+	if(!pDownload->httpClient.GotData())
+	{
+		Fail(String("Failed to download %s %s (%s)", pServerFile->strType.Get(), pServerFile->strName.Get(), pDownload->httpClient.GetLastErrorString().Get()), true);
+		return false;
+	}
 
-		// Create the destination type folder string
-		String strDestinationFolder("%s/%s", strClientFilesFolder.Get(), strFolderName.Get());
+	// Replace the file with the downloaded file
+	String strFilePath(GetFilePath(pServerFile->strName, pServerFile->strType));
+	remove(strFilePath.Get());
+	rename(pDownload->strPartPath.Get(), strFilePath.Get());
 
-		// Create the destination type folder if needed
-		if(!SharedUtility::Exists(strDestinationFolder.Get()))
-			SharedUtility::CreateDirectory(strDestinationFolder.Get());
+	// Create a checksum of the file, the downloaded file can have the
+	// same size and modification time as the file it replaced
+	CFileChecksum fileChecksum;
+	m_checksumCache.Remove(strFilePath);
+	m_checksumCache.GetChecksum(strFilePath, fileChecksum);
 
-		// Create the destination file string
-		String strDestinationFile("%s/%s", strDestinationFolder.Get(), strName.Get());
+	// Do the checksums not match?
+	if(fileChecksum != pServerFile->fileChecksum)
+	{
+		// The partial file could have been from another version of the file, download the whole file again
+		if(pDownload->bResumed)
+		{
+			pDownload->httpClient.Reset();
+			pDownload->pServerFile = NULL;
+			m_uiActiveDownloads--;
 
-		// Open the destination file
-		m_fDownloadFile = fopen(strDestinationFile.Get(), "wb");
+			if(StartDownload(pDownload, pServerFile, false))
+				return true;
 
-		// Did the destination file not open sucessfully?
-		if(!m_fDownloadFile)
+			Fail(String("Failed to start download of %s %s", pServerFile->strType.Get(), pServerFile->strName.Get()), false);
+			SAFE_DELETE(pServerFile);
 			return false;
+		}
+
+		Fail(String("Failed to download %s %s (Checksum mismatch)", pServerFile->strType.Get(), pServerFile->strName.Get()), true);
+		return false;
+	}
 
-		// Create the post path string
-		String strPostPath("/%s/%s", strFolderName.Get(), strName.Get());
+	// Free the download for the next file
+	m_uiDownloadedBytes += pServerFile->uiSize;
+	pDownload->httpClient.Reset();
+	pDownload->pServerFile = NULL;
+	m_uiActiveDownloads--;
+	OnFileReady(pServerFile->strName, pServerFile->strType, strFilePath, pServerFile->bLazy);
+	SAFE_DELETE(pServerFile);
+	return true;
+}
+
+void CFileTransfer::OnFileReady(String strName, String strType, String strFilePath, bool bLazy)
+{
+	// Is the file the file pack?
+	if(strType == "pack")
+	{
+		m_bFilePackQueued = false;
+		ExtractPackFiles();
+		return;
+	}
 
-		// Show message stuff
-		String strText;
-		strText.AppendF("%s",strName.Get());
+	// Is the file a script?
+	if(strType == "script")
+	{
+		// Add the script to the client script manager
+		g_pClientScriptManager->AddScript(strName, strFilePath, bLazy);
 
-		// Set stuff & check if we have our gui stuff
-		if(m_pFileImage && m_pFileText)
+		// Check if we had already our first spawn (lazy scripts are loaded once another script requires them)
+		if(!bLazy && g_pLocalPlayer->GetFirstSpawn())
 		{
-			// Set the filename
-			m_pFileText->setText(strText.Get());
+			g_pClientScriptManager->Load(strName);
 
-			// Set the image and text visible
-			m_pFileText->setVisible(true);
+			// If we're spawned and had our spawn, hide the download image stuff because we're already connected and the files we're refreshed serverside
+			if(g_pLocalPlayer->IsSpawned() && m_pFileImage)
+				SetDownloadImageVisible(false);
 		}
+	}
+}
+
+void CFileTransfer::Fail(String strMessage, bool bDisconnect)
+{
+	// Show Message
+	g_pMainMenu->ShowMessageBox(strMessage.Get(),"Download failed",true,false, false);
+
+	// Hide message stuff
+	SetProgressVisible(false);
+
+	if(m_pFileImage)
+		m_pFileImage->setVisible(false);
+
+	// Reset all transfers
+	Reset();
+
+	// Disconnect from the server
+	if(bDisconnect)
+		g_pNetworkManager->Disconnect();
+}
+
+void CFileTransfer::UpdateProgress()
+{
+	// The bytes received by the downloads in progress count as well
+	unsigned int uiDownloadedBytes = m_uiDownloadedBytes;
 
-		// Send the request
-		m_httpClient.Get(strPostPath);
-		return true;
+	for(int i = 0; i < FILE_TRANSFER_MAX_DOWNLOADS; i++)
+	{
+		if(m_downloads[i].pServerFile)
+			uiDownloadedBytes += (std::min)(m_downloads[i].uiBytesReceived, m_downloads[i].pServerFile->uiSize);
 	}
 
-	return false;
+	if(m_pFileText)
+		m_pFileText->setText(String("Downloading %d file(s) (%d of %d KB)", GetTransferListSize(), (uiDownloadedBytes / 1024), (m_uiTotalBytes / 1024)).Get());
+
+	if(m_pProgressBar)
+	{
+		float fProgress = ((m_uiTotalBytes > 0) ? ((float)uiDownloadedBytes / m_uiTotalBytes) : 0.0f);
+		m_pProgressBar->setProperty("CurrentProgress", String("%f", fProgress).Get());
+	}
+}
+
+void CFileTransfer::SetProgressVisible(bool bVisible)
+{
+	if(m_pFileImage && bVisible)
+		m_pFileImage->setVisible(true);
+
+	if(m_pFileText)
+		m_pFileText->setVisible(bVisible);
+
+	if(m_pProgressBar)
+		m_pProgressBar->setVisible(bVisible);
 }
 
-void CFileTransfer::SetServerInformation(String strAddress, unsigned short usPort)
+void CFileTransfer::SetServerInformation(String strAddress, unsigned short usPort, bool bHashedFiles)
 {
-	m_httpClient.SetHost(strAddress);
-	m_httpClient.SetPort(usPort);
+	m_strHost = strAddress;
+	m_usPort = usPort;
+	m_bHashedFiles = bHashedFiles;
+
 
 	float fWidth = (float)g_pGUI->GetDisplayWidth();
 	float fHeight = (float)g_pGUI->GetDisplayHeight();
@@ -168,236 +378,256 @@ void CFileTransfer::SetServerInformation(String strAddress, unsigned short usPor
 		m_pFileText->setFont(g_pGUI->GetFont("tahoma",28U));
 		m_pFileText->setVisible(false);
 	}
+	if(!m_pProgressBar)
+	{
+		m_pProgressBar = g_pGUI->CreateGUIProgressBar(g_pGUI->GetDefaultWindow());
+		m_pProgressBar->setSize(CEGUI::UVector2(CEGUI::UDim(0, TRANSFERBOX_WIDTH), CEGUI::UDim(0, PROGRESSBAR_HEIGHT)));
+		m_pProgressBar->setPosition(CEGUI::UVector2(CEGUI::UDim(0, fWidth/(float)2.75),  CEGUI::UDim(0, fHeight/2-(fHeight/4)+TRANSFERBOX_HEIGHT)));
+		m_pProgressBar->setVisible(false);
+	}
 }
 
-void CFileTransfer::AddFile(String strFileName, CFileChecksum fileChecksum, bool bIsResource)
+void CFileTransfer::QueueFile(ServerFile * pServerFile)
 {
-	// Get the folder name
-	String strFolderName;
+	m_uiTotalBytes += pServerFile->uiSize;
 
-	if(bIsResource)
-		strFolderName = "resources";
-	else
-		strFolderName = "clientscripts";
+	// Keep the largest files first so the small ones fill the connections once they are done
+	std::list<ServerFile *>::iterator iter = m_fileList.begin();
+
+	while(iter != m_fileList.end() && (*iter)->uiSize >= pServerFile->uiSize)
+		iter++;
+
+	m_fileList.insert(iter, pServerFile);
+}
+
+void CFileTransfer::QueueFilePack()
+{
+	if(m_bFilePackQueued)
+		return;
+
+	ServerFile * pServerFile = new ServerFile();
+	*pServerFile = m_filePackFile;
+	QueueFile(pServerFile);
+	m_bFilePackQueued = true;
+}
+
+bool CFileTransfer::ExtractPackFile(ServerFile * pServerFile)
+{
+	// Is the file in the file pack as the server has it?
+	FilePackEntry * pEntry = m_filePack.Find(pServerFile->strName, (pServerFile->strType == "script"));
+
+	if(!pEntry || pEntry->fileChecksum != pServerFile->fileChecksum)
+		return false;
+
+	CreateFolder(pServerFile->strType);
+	String strFilePath(GetFilePath(pServerFile->strName, pServerFile->strType));
+
+	if(!m_filePack.Extract(pEntry, strFilePath))
+		return false;
+
+	// Create a checksum of the file (the extracted file can have the same size and
+	// modification time as the file it replaced)
+	CFileChecksum fileChecksum;
+	m_checksumCache.Remove(strFilePath);
+	m_checksumCache.GetChecksum(strFilePath, fileChecksum);
+
+	if(fileChecksum != pServerFile->fileChecksum)
+		return false;
+
+	OnFileReady(pServerFile->strName, pServerFile->strType, strFilePath, pServerFile->bLazy);
+	return true;
+}
+
+void CFileTransfer::ExtractPackFiles()
+{
+	m_filePack.Open(GetFilePath(m_filePackFile.strName, m_filePackFile.strType));
+
+	// Files we can't extract are downloaded on their own
+	for(std::list<ServerFile *>::iterator iter = m_packFileList.begin(); iter != m_packFileList.end(); iter++)
+	{
+		if(ExtractPackFile(*iter))
+			SAFE_DELETE(*iter);
+		else
+			QueueFile(*iter);
+	}
+
+	m_packFileList.clear();
+}
+
+void CFileTransfer::SetFilePack(CFileChecksum fileChecksum, unsigned int uiSize)
+{
+	m_filePackFile.strName = FILE_PACK_FILE;
+	m_filePackFile.fileChecksum = fileChecksum;
+	m_filePackFile.uiSize = uiSize;
+	m_filePackFile.strType = "pack";
+	m_filePackFile.bLazy = false;
+	m_bHasFilePack = true;
+	m_filePack.Close();
+
+	// Is the file pack from the last connect up to date (it is only downloaded when a file in it is needed)?
+	String strFilePath(GetFilePath(m_filePackFile.strName, m_filePackFile.strType));
+	CFileChecksum currentFileChecksum;
+
+	if(SharedUtility::Exists(strFilePath) && m_checksumCache.GetChecksum(strFilePath, currentFileChecksum) && currentFileChecksum == fileChecksum)
+		m_filePack.Open(strFilePath);
+}
+
+void CFileTransfer::AddFile(String strFileName, CFileChecksum fileChecksum, unsigned int uiSize, bool bIsResource, bool bInPack, bool bLazy)
+{
+	String strType(bIsResource ? "resource" : "script");
 
 	// Create the file path string
-	String strFilePath(SharedUtility::GetAbsolutePath("clientfiles/%s/%s", strFolderName.Get(), strFileName.Get()));
+	String strFilePath(GetFilePath(strFileName, strType));
 
 	// Does the file exist?
 	if(SharedUtility::Exists(strFilePath))
 	{
-		// Create a file checksum of the file
+		// Get the file checksum of the file
 		CFileChecksum currentFileChecksum;
-		currentFileChecksum.Calculate(strFilePath);
+		m_checksumCache.GetChecksum(strFilePath, currentFileChecksum);
 
 		// Does the file checksum match the server file checksum (We don't need to download the file)?
 		if(currentFileChecksum == fileChecksum)
 		{
-			// Is the downloaded file a script?
-			if(!bIsResource)
-			{
-				// Add the script to the client script manager
-				g_pClientScriptManager->AddScript(strFileName, strFilePath);
+			OnFileReady(strFileName, strType, strFilePath, bLazy);
+			return;
+		}
+	}
 
-				// Check if we had already our first spawn
-				if(g_pLocalPlayer->GetFirstSpawn())
-					g_pClientScriptManager->Load(strFileName);
-			}
+	// Is the file already waiting for a download (the server sends a file again when it is restarted)?
+	for(std::list<ServerFile *>::iterator iter = m_fileList.begin(); iter != m_fileList.end(); iter++)
+	{
+		if((*iter)->strName == strFileName && (*iter)->strType == strType)
+		{
+			m_uiTotalBytes -= (*iter)->uiSize;
+			SAFE_DELETE(*iter);
+			m_fileList.erase(iter);
+			break;
+		}
+	}
 
-			return;
+	for(std::list<ServerFile *>::iterator iter = m_packFileList.begin(); iter != m_packFileList.end(); iter++)
+	{
+		if((*iter)->strName == strFileName && (*iter)->strType == strType)
+		{
+			SAFE_DELETE(*iter);
+			m_packFileList.erase(iter);
+			break;
 		}
 	}
 
 	ServerFile * pServerFile = new  ServerFile();
 	pServerFile->strName = strFileName;
 	memcpy(&pServerFile->fileChecksum, &fileChecksum, sizeof(CFileChecksum));
-	pServerFile->strType = (bIsResource ? "resource" : "script");
-	m_fileList.push_back(pServerFile);
-}
+	pServerFile->uiSize = uiSize;
+	pServerFile->strType = strType;
+	pServerFile->bLazy = bLazy;
 
-void CFileTransfer::Process()
-{	
-	// Are we not downloading a file?
-	if(!m_bDownloadingFile)
+	// Can we get the file from the file pack?
+	if(bInPack && m_bHasFilePack)
 	{
-		// Do we have no files to download?
-		if(m_fileList.empty())
-			return;
-
-		// Loop through all server files
-		for(std::list<ServerFile *>::iterator iter = m_fileList.begin(); iter != m_fileList.end(); iter++)
+		// Extract the file if we have the file pack already
+		if(m_filePack.IsOpen())
 		{
-			// Get the server file pointer
-			ServerFile * pServerFile = (*iter);
-
-			// Get the folder name
-			String strFolderName;
-
-			if(pServerFile->strType == "resource")
-				strFolderName = "resources";
-			else if(pServerFile->strType == "script")
-				strFolderName = "clientscripts";
-
-			// Create the file path string
-			String strFilePath(SharedUtility::GetAbsolutePath("clientfiles/%s/%s", strFolderName.Get(), pServerFile->strName.Get()));
-
-			// Generate a checksum of the file we have
-			CFileChecksum fileChecksum;
-			fileChecksum.Calculate(strFilePath.Get());
-
-			// Does the checksum differ from the server file checksum?
-			if((!SharedUtility::Exists(strFilePath)) || (fileChecksum != pServerFile->fileChecksum))
+			if(ExtractPackFile(pServerFile))
 			{
-				// Start the download of the new file
-				if(StartDownload(pServerFile->strName, pServerFile->strType))
-				{
-					// Flag ourselves as downloading
-					m_bDownloadingFile = true;
-
-					// Set the download file
-					m_pDownloadFile = pServerFile;
-				}
-				else
-				{
-					// Reset all transfers
-					Reset();
-
-					// Show Message
-					String strMessage; 
-					strMessage.AppendF("Failed to start download of %s %s", pServerFile->strType.Get(), pServerFile->strName.Get());
-					g_pMainMenu->ShowMessageBox(strMessage.Get(),"Download failed",true,false, false);
-				}
+				SAFE_DELETE(pServerFile);
+				return;
 			}
 		}
+		else
+		{
+			// Wait for the file pack instead of downloading the file on its own
+			m_packFileList.push_back(pServerFile);
+			QueueFilePack();
+			return;
+		}
 	}
-	else
+
+	QueueFile(pServerFile);
+}
+
+void CFileTransfer::Process()
+{
+	// Do we have no files to download?
+	if(GetTransferListSize() == 0)
+	{
+		// Keep the checksums of the files for the next connect
+		m_checksumCache.Save();
+		return;
+	}
+
+	// Process the downloads in progress
+	for(int i = 0; i < FILE_TRANSFER_MAX_DOWNLOADS; i++)
 	{
+		FileDownload * pDownload = &m_downloads[i];
+
+		if(!pDownload->pServerFile)
+			continue;
+
 		// Is the http client busy?
-		if(m_httpClient.IsBusy())
+		if(pDownload->httpClient.IsBusy())
 		{
 			// Process the http client
-			m_httpClient.Process();
+			pDownload->httpClient.Process();
+
+			if(pDownload->httpClient.IsBusy())
+				continue;
 		}
-		else
+
+		// Did the download fail (all transfers are reset then)?
+		if(!FinishDownload(pDownload))
+			return;
+	}
+
+	// Start the next downloads on the free connections
+	for(int i = 0; i < FILE_TRANSFER_MAX_DOWNLOADS && !m_fileList.empty(); i++)
+	{
+		FileDownload * pDownload = &m_downloads[i];
+
+		if(pDownload->pServerFile)
+			continue;
+
+		ServerFile * pServerFile = m_fileList.front();
+		m_fileList.pop_front();
+
+		if(!StartDownload(pDownload, pServerFile, true))
 		{
-			// Has the http client successfully downloaded the file?
-			if(m_httpClient.GotData())
-			{
-				// Close the file
-				if(m_fDownloadFile)
-					fclose(m_fDownloadFile);
-				m_fDownloadFile = NULL;
-
-				// Get the folder name
-				String strFolderName;
-
-				if(m_pDownloadFile->strType == "resource")
-					strFolderName = "resources";
-				else if(m_pDownloadFile->strType == "script")
-					strFolderName = "clientscripts";
-
-				// Create the file path string
-				String strFilePath(SharedUtility::GetAbsolutePath("clientfiles/%s/%s", strFolderName.Get(), m_pDownloadFile->strName.Get()));
-
-				// Create a checksum of the file
-				CFileChecksum fileChecksum;
-				fileChecksum.Calculate(strFilePath);
-
-				// Do the checksums match?
-				if(fileChecksum == m_pDownloadFile->fileChecksum)
-				{
-					// Is the downloaded file a script?
-					if(m_pDownloadFile->strType == "script")
-					{
-						// Add the script to the client script manager
-						g_pClientScriptManager->AddScript(m_pDownloadFile->strName, strFilePath);
-
-						// Check if we had already our first spawn
-						if(g_pLocalPlayer->GetFirstSpawn())
-							g_pClientScriptManager->Load(m_pDownloadFile->strName);
-
-						// If we're spawned and had our spawn, hide the download image stuff because we're already connected and the files we're refreshed serverside
-						if(g_pLocalPlayer->GetFirstSpawn() && g_pLocalPlayer->IsSpawned())
-							SetDownloadImageVisible(false);
-					}
-
-					// Remove the download file from the file list
-					m_fileList.remove(m_pDownloadFile);
-
-					// Delete the download file
-					SAFE_DELETE(m_pDownloadFile);
-
-					// Flag ourselves as no longer downloading
-					m_bDownloadingFile = false;
-
-					// Reset out http client
-					m_httpClient.Reset();
-
-					// Hide message & image
-					m_pFileText->setVisible(false);
-					
-				}
-				else
-				{
-					// Show Message
-					String strMessage; 
-					strMessage.AppendF("Failed to download %s %s (Checksum mismatch)", m_pDownloadFile->strType.Get(), m_pDownloadFile->strName.Get());
-					g_pMainMenu->ShowMessageBox(strMessage.Get(),"Download failed",true,false, false);
-
-					// Hide message stuff
-					String strText = "";
-					// Set stuff & check if we have our gui stuff
-					if(m_pFileImage && m_pFileText)
-					{
-						// Set the filename
-						m_pFileText->setText(strText.Get());
-
-						// Set the image and text visible
-						m_pFileText->setVisible(false);
-						m_pFileImage->setVisible(false);
-					}
-
-					// Reset all transfers
-					Reset();
-
-					// Disconnect from the server
-					g_pNetworkManager->Disconnect();
-				}
-			}
-			else
-			{
-				// Show Message
-				String strMessage; 
-				strMessage.AppendF("Failed to download %s %s (%s)", m_pDownloadFile->strType.Get(), m_pDownloadFile->strName.Get(), m_httpClient.GetLastErrorString().Get());
-				g_pMainMenu->ShowMessageBox(strMessage.Get(),"Download failed",true,false, false);
-
-				// Hide message stuff
-				String strText = "";
-				// Set stuff & check if we have our gui stuff
-				if(m_pFileImage && m_pFileText)
-				{
-					// Set the filename
-					m_pFileText->setText(strText.Get());
-
-					// Set the image and text visible
-					m_pFileText->setVisible(false);
-					m_pFileImage->setVisible(false);
-				}
-
-				// Reset all transfers
-				Reset();
-
-				// Disconnect from the server
-				g_pNetworkManager->Disconnect();
-			}
+			String strMessage("Failed to start download of %s %s", pServerFile->strType.Get(), pServerFile->strName.Get());
+			SAFE_DELETE(pServerFile);
+			Fail(strMessage, false);
+			return;
 		}
 	}
+
+	// Are all files downloaded?
+	if(GetTransferListSize() == 0)
+	{
+		m_uiTotalBytes = 0;
+		m_uiDownloadedBytes = 0;
+		SetProgressVisible(false);
+		return;
+	}
+
+	UpdateProgress();
 }
 
 void CFileTransfer::Reset()
 {
-	// Reset the HTTP client
-	m_httpClient.Reset();
+	// Reset the downloads
+	for(int i = 0; i < FILE_TRANSFER_MAX_DOWNLOADS; i++)
+	{
+		FileDownload * pDownload = &m_downloads[i];
+		pDownload->httpClient.Reset();
+
+		if(pDownload->fFile)
+			fclose(pDownload->fFile);
+
+		pDownload->fFile = NULL;
+		SAFE_DELETE(pDownload->pServerFile);
+	}
+
+	m_uiActiveDownloads = 0;
 
 	// Clear the file transfer list
 	for(std::list<ServerFile *>::iterator iter = m_fileList.begin(); iter != m_fileList.end(); iter++)
@@ -405,12 +635,14 @@ void CFileTransfer::Reset()
 
 	m_fileList.clear();
 
-	// Reset download vars
-	m_bDownloadingFile = false;
-	m_pDownloadFile = NULL;
-
-	if(m_fDownloadFile)
-		fclose(m_fDownloadFile);
+	// Clear the files waiting for the file pack
+	for(std::list<ServerFile *>::iterator iter = m_packFileList.begin(); iter != m_packFileList.end(); iter++)
+		SAFE_DELETE(*iter);
 
-	m_fDownloadFile = NULL;
+	m_packFileList.clear();
+	m_filePack.Close();
+	m_bHasFilePack = false;
+	m_bFilePackQueued = false;
+	m_uiTotalBytes = 0;
+	m_uiDownloadedBytes = 0;
 }
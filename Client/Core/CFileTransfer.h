@@ -12,37 +12,87 @@
 
 #include <list>
 #include <CFileChecksum.h>
+#include <CChecksumCache.h>
+#include <CFilePack.h>
 #include <Network/CHttpClient.h>
 #include "CGUI.h"
 
+// Maximum amount of files downloaded at the same time
+#define FILE_TRANSFER_MAX_DOWNLOADS 4
+
 struct ServerFile
 {
 	String        strName;
 	CFileChecksum fileChecksum;
-	String        strType;
+	unsigned int  uiSize;
+	String        strType; // "resource", "script" or "pack" (the file pack)
+	bool          bLazy; // The script is only loaded once another script requires it
+};
+
+class CFileTransfer;
+
+// Extension of the files that are being downloaded, a partial file is resumed with the next download
+#define FILE_TRANSFER_PART_EXTENSION ".part"
+
+// A download in progress, each download has its own connection
+struct FileDownload
+{
+	CFileTransfer * pFileTransfer;
+	CHttpClient     httpClient;
+	ServerFile    * pServerFile;
+	String          strPartPath;
+	FILE          * fFile;
+	unsigned int    uiBytesReceived;
+	bool            bResumed;      // Only the rest of the partial file is downloaded
+	bool            bCheckedStatus;
 };
 
 class CFileTransfer
 {
 private:
-	CHttpClient             m_httpClient;
-	std::list<ServerFile *> m_fileList;
-	bool                    m_bDownloadingFile;
-	ServerFile            * m_pDownloadFile;
-	FILE                  * m_fDownloadFile;
+	String                  m_strHost;
+	unsigned short          m_usPort;
+	bool                    m_bHashedFiles; // The files are downloaded by their content and not by their name
+	CChecksumCache          m_checksumCache;
+	std::list<ServerFile *> m_fileList; // Files waiting for a download, the largest first
+	ServerFile              m_filePackFile; // The file pack of the server
+	bool                    m_bHasFilePack;
+	bool                    m_bFilePackQueued; // The file pack waits for its download or is downloading
+	CFilePack               m_filePack; // Open once the file pack is downloaded
+	std::list<ServerFile *> m_packFileList; // Files waiting for the file pack download
+	FileDownload            m_downloads[FILE_TRANSFER_MAX_DOWNLOADS];
+	unsigned int            m_uiActiveDownloads;
+	unsigned int            m_uiTotalBytes;
+	unsigned int            m_uiDownloadedBytes; // Of the finished downloads
 	CGUIStaticText		  * m_pFileText;
 	CGUIStaticImage		  * m_pFileImage;
+	CGUIProgressBar       * m_pProgressBar;
 
 private:
 	static bool  ReceiveHandler(const char * szData, unsigned int uiDataSize, void * pUserData);
-	bool         StartDownload(String strName, String strType);
+	static String GetFilePath(String strName, String strType);
+	static void  CreateFolder(String strType);
+	void         QueueFile(ServerFile * pServerFile);
+	void         QueueFilePack();
+	bool         ExtractPackFile(ServerFile * pServerFile);
+	void         ExtractPackFiles();
+	bool         StartDownload(FileDownload * pDownload, ServerFile * pServerFile, bool bResume);
+	bool         FinishDownload(FileDownload * pDownload);
+	void         OnFileReady(String strName, String strType, String strFilePath, bool bLazy);
+	void         Fail(String strMessage, bool bDisconnect);
+	void         UpdateProgress();
+	void         SetProgressVisible(bool bVisible);
 
 public:
 	CFileTransfer();
 
-	unsigned int GetTransferListSize() { return m_fileList.size(); }
-	void         SetServerInformation(String strAddress, unsigned short usPort);
-	void         AddFile(String strFileName, CFileChecksum fileChecksum, bool bIsResource);
+	// Amount of files that are still waiting for a download or are downloading
+	unsigned int GetTransferListSize() { return (m_fileList.size() + m_packFileList.size() + m_uiActiveDownloads); }
+	void         SetServerInformation(String strAddress, unsigned short usPort, bool bHashedFiles);
+
+	// The files the server says are in the file pack are extracted from it instead of downloaded on their own
+	void         SetFilePack(CFileChecksum fileChecksum, unsigned int uiSize);
+	void         AddFile(String strFileName, CFileChecksum fileChecksum, unsigned int uiSize, bool bIsResource, bool bInPack, bool bLazy);
 	void         Process();
 	void		 SetDownloadImageVisible(bool bVisible) { m_pFileImage->setVisible(bVisible); }
 	void         Reset();
@@ -0,0 +1,365 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFrameProfiler.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "CFrameProfiler.h"
+#include <SharedUtility.h>
+#include <CLogFile.h>
+#include <CTraceRecorder.h>
+
+extern CFrameProfiler * g_pFrameProfiler;
+
+// Only these stages draw anything, the others don't use the gpu
+static const bool g_bStageUsesGpu[FRAME_PROFILER_STAGE_MAX] = { true, true, true, true, true, true, false, false };
+
+CFrameProfiler::CFrameProfiler(IDirect3DDevice9 * pDevice)
+	: m_pDevice(pDevice),
+	m_bEnabled(false),
+	m_bQueriesCreated(false),
+	m_uiCurrentSample(0),
+	m_uiSampleCount(0),
+	m_ullFrameStartTime(0),
+	m_uiCurrentQueries(0),
+	m_ullTraceFrameStartTime(0)
+{
+	memset(m_ullTraceStageStartTime, 0, sizeof(m_ullTraceStageStartTime));
+	memset(m_samples, 0, sizeof(m_samples));
+	memset(m_ullStageStartTime, 0, sizeof(m_ullStageStartTime));
+	memset(m_bGpuTiming, 0, sizeof(m_bGpuTiming));
+	memset(m_queries, 0, sizeof(m_queries));
+}
+
+CFrameProfiler::~CFrameProfiler()
+{
+	DestroyQueries();
+}
+
+const char * CFrameProfiler::GetStageName(eFrameProfilerStage stage)
+{
+	switch(stage)
+	{
+	case FRAME_PROFILER_GUI:                return "GUI";
+	case FRAME_PROFILER_WEBKIT:             return "WebKit";
+	case FRAME_PROFILER_CHAT:               return "Chat";
+	case FRAME_PROFILER_NAMETAGS:           return "NameTags";
+	case FRAME_PROFILER_FRAME_RENDER_EVENT: return "frameRender";
+	case FRAME_PROFILER_DISPLAY_LIST:       return "DisplayList";
+	case FRAME_PROFILER_NETWORK:            return "Network";
+	case FRAME_PROFILER_STREAMER:           return "Streamer";
+	}
+
+	return "Unknown";
+}
+
+void CFrameProfiler::CreateQueries()
+{
+	if(m_bQueriesCreated)
+		return;
+
+	// Are timestamp queries supported?
+	if(FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMP, NULL)) || FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMPDISJOINT, NULL)) ||
+		FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMPFREQ, NULL)))
+	{
+		CLogFile::Printf("Timestamp queries are not supported, the frame profiler only records cpu times");
+		return;
+	}
+
+	m_bQueriesCreated = true;
+
+	for(unsigned int i = 0; i < FRAME_PROFILER_QUERY_FRAMES; i++)
+	{
+		FrameProfilerQueries * pQueries = &m_queries[i];
+		memset(pQueries, 0, sizeof(FrameProfilerQueries));
+
+		if(FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMPDISJOINT, &pQueries->pDisjoint)) ||
+			FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMPFREQ, &pQueries->pFrequency)))
+		{
+			DestroyQueries();
+			return;
+		}
+
+		for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+		{
+			if(!g_bStageUsesGpu[iStage])
+				continue;
+
+			if(FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMP, &pQueries->pBegin[iStage])) ||
+				FAILED(m_pDevice->CreateQuery(D3DQUERYTYPE_TIMESTAMP, &pQueries->pEnd[iStage])))
+			{
+				DestroyQueries();
+				return;
+			}
+		}
+	}
+}
+
+void CFrameProfiler::DestroyQueries()
+{
+	for(unsigned int i = 0; i < FRAME_PROFILER_QUERY_FRAMES; i++)
+	{
+		FrameProfilerQueries * pQueries = &m_queries[i];
+
+		if(pQueries->pDisjoint)
+			pQueries->pDisjoint->Release();
+
+		if(pQueries->pFrequency)
+			pQueries->pFrequency->Release();
+
+		for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+		{
+			if(pQueries->pBegin[iStage])
+				pQueries->pBegin[iStage]->Release();
+
+			if(pQueries->pEnd[iStage])
+				pQueries->pEnd[iStage]->Release();
+		}
+
+		memset(pQueries, 0, sizeof(FrameProfilerQueries));
+	}
+
+	memset(m_bGpuTiming, 0, sizeof(m_bGpuTiming));
+	m_bQueriesCreated = false;
+}
+
+void CFrameProfiler::ReadQueries(FrameProfilerQueries * pQueries)
+{
+	if(!pQueries->bPending)
+		return;
+
+	pQueries->bPending = false;
+
+	// The results are dropped if they aren't ready yet, we never wait for the gpu
+	BOOL bDisjoint = TRUE;
+	UINT64 ullFrequency = 0;
+
+	if(pQueries->pDisjoint->GetData(&bDisjoint, sizeof(BOOL), 0) != S_OK || bDisjoint)
+		return;
+
+	if(pQueries->pFrequency->GetData(&ullFrequency, sizeof(UINT64), 0) != S_OK || ullFrequency == 0)
+		return;
+
+	FrameProfilerSample * pSample = &m_samples[pQueries->uiSample];
+
+	for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+	{
+		if(!pQueries->bIssued[iStage])
+			continue;
+
+		UINT64 ullBegin = 0;
+		UINT64 ullEnd = 0;
+
+		if(pQueries->pBegin[iStage]->GetData(&ullBegin, sizeof(UINT64), 0) == S_OK &&
+			pQueries->pEnd[iStage]->GetData(&ullEnd, sizeof(UINT64), 0) == S_OK && ullEnd > ullBegin)
+			pSample->ullGpuTime[iStage] = (((ullEnd - ullBegin) * 1000000) / ullFrequency);
+	}
+}
+
+void CFrameProfiler::BeginFrameQueries()
+{
+	if(!m_bQueriesCreated)
+		return;
+
+	FrameProfilerQueries * pQueries = &m_queries[m_uiCurrentQueries];
+
+	// Get the results of the frame that used these queries before
+	ReadQueries(pQueries);
+	memset(pQueries->bIssued, 0, sizeof(pQueries->bIssued));
+	memset(m_bGpuTiming, 0, sizeof(m_bGpuTiming));
+	pQueries->pDisjoint->Issue(D3DISSUE_BEGIN);
+	pQueries->pFrequency->Issue(D3DISSUE_END);
+}
+
+void CFrameProfiler::StartFrame()
+{
+	m_ullFrameStartTime = SharedUtility::GetMicroseconds();
+	memset(&m_samples[m_uiCurrentSample], 0, sizeof(FrameProfilerSample));
+	BeginFrameQueries();
+}
+
+void CFrameProfiler::SetEnabled(bool bEnabled)
+{
+	if(bEnabled == m_bEnabled)
+		return;
+
+	m_bEnabled = bEnabled;
+
+	if(m_bEnabled)
+	{
+		m_uiCurrentSample = 0;
+		m_uiSampleCount = 0;
+		CreateQueries();
+		StartFrame();
+	}
+	else
+		DestroyQueries();
+}
+
+void CFrameProfiler::OnLostDevice()
+{
+	// The queries have to be released before the device is reset
+	DestroyQueries();
+}
+
+void CFrameProfiler::OnResetDevice()
+{
+	if(m_bEnabled)
+	{
+		CreateQueries();
+		BeginFrameQueries();
+	}
+}
+
+void CFrameProfiler::BeginStage(eFrameProfilerStage stage)
+{
+	// The stages are traced while the profiler is disabled too
+	m_ullTraceStageStartTime[stage] = (CTraceRecorder::IsEnabled() ? SharedUtility::GetMicroseconds() : 0);
+
+	if(!m_bEnabled)
+		return;
+
+	m_ullStageStartTime[stage] = SharedUtility::GetMicroseconds();
+
+	// Only the first time the stage runs in a frame is timed on the gpu
+	if(m_bQueriesCreated && g_bStageUsesGpu[stage] && !m_queries[m_uiCurrentQueries].bIssued[stage] && !m_bGpuTiming[stage])
+	{
+		m_queries[m_uiCurrentQueries].pBegin[stage]->Issue(D3DISSUE_END);
+		m_bGpuTiming[stage] = true;
+	}
+}
+
+void CFrameProfiler::EndStage(eFrameProfilerStage stage)
+{
+	if(m_ullTraceStageStartTime[stage] != 0)
+	{
+		CTraceRecorder::Record(TRACE_CATEGORY_STAGE, GetStageName(stage), -1, m_ullTraceStageStartTime[stage], SharedUtility::GetMicroseconds());
+		m_ullTraceStageStartTime[stage] = 0;
+	}
+
+	if(!m_bEnabled)
+		return;
+
+	m_samples[m_uiCurrentSample].ullCpuTime[stage] += (SharedUtility::GetMicroseconds() - m_ullStageStartTime[stage]);
+
+	if(m_bQueriesCreated && m_bGpuTiming[stage])
+	{
+		m_queries[m_uiCurrentQueries].pEnd[stage]->Issue(D3DISSUE_END);
+		m_queries[m_uiCurrentQueries].bIssued[stage] = true;
+		m_bGpuTiming[stage] = false;
+	}
+}
+
+void CFrameProfiler::EndFrame()
+{
+	// A traced frame goes from the end of the last frame to the end of this one
+	if(CTraceRecorder::IsEnabled())
+	{
+		unsigned long long ullTime = SharedUtility::GetMicroseconds();
+
+		if(m_ullTraceFrameStartTime != 0)
+			CTraceRecorder::Record(TRACE_CATEGORY_FRAME, "frame", -1, m_ullTraceFrameStartTime, ullTime);
+
+		m_ullTraceFrameStartTime = ullTime;
+	}
+	else
+		m_ullTraceFrameStartTime = 0;
+
+	if(!m_bEnabled)
+		return;
+
+	m_samples[m_uiCurrentSample].ullFrameTime = (SharedUtility::GetMicroseconds() - m_ullFrameStartTime);
+
+	if(m_bQueriesCreated)
+	{
+		FrameProfilerQueries * pQueries = &m_queries[m_uiCurrentQueries];
+		pQueries->pDisjoint->Issue(D3DISSUE_END);
+		pQueries->uiSample = m_uiCurrentSample;
+		pQueries->bPending = true;
+		m_uiCurrentQueries = ((m_uiCurrentQueries + 1) % FRAME_PROFILER_QUERY_FRAMES);
+	}
+
+	m_uiCurrentSample = ((m_uiCurrentSample + 1) % FRAME_PROFILER_HISTORY);
+
+	if(m_uiSampleCount < (FRAME_PROFILER_HISTORY - 1))
+		m_uiSampleCount++;
+
+	StartFrame();
+}
+
+FrameProfilerSample * CFrameProfiler::GetSample(unsigned int uiIndex)
+{
+	if(uiIndex >= m_uiSampleCount)
+		return NULL;
+
+	return &m_samples[(m_uiCurrentSample + FRAME_PROFILER_HISTORY - m_uiSampleCount + uiIndex) % FRAME_PROFILER_HISTORY];
+}
+
+unsigned long long CFrameProfiler::GetFrameTimePercentile(unsigned int uiPercent)
+{
+	if(m_uiSampleCount == 0)
+		return 0;
+
+	std::vector<unsigned long long> frameTimes;
+	frameTimes.reserve(m_uiSampleCount);
+
+	for(unsigned int i = 0; i < m_uiSampleCount; i++)
+		frameTimes.push_back(GetSample(i)->ullFrameTime);
+
+	std::sort(frameTimes.begin(), frameTimes.end());
+	return frameTimes[((m_uiSampleCount - 1) * uiPercent) / 100];
+}
+
+bool CFrameProfiler::Dump(String strPath)
+{
+	FILE * pFile = fopen(strPath.Get(), "w");
+
+	if(!pFile)
+		return false;
+
+	// Summary
+	fprintf(pFile, "Frames: %d\n", m_uiSampleCount);
+	fprintf(pFile, "Frame time (us): p50 %llu p99 %llu max %llu\n\n", GetFrameTimePercentile(50), GetFrameTimePercentile(99), GetFrameTimePercentile(100));
+
+	// One line per frame with the frame time and the cpu and gpu time of each stage in microseconds
+	fprintf(pFile, "frame time");
+
+	for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+		fprintf(pFile, ",%s cpu,%s gpu", GetStageName((eFrameProfilerStage)iStage), GetStageName((eFrameProfilerStage)iStage));
+
+	fprintf(pFile, "\n");
+
+	for(unsigned int i = 0; i < m_uiSampleCount; i++)
+	{
+		FrameProfilerSample * pSample = GetSample(i);
+		fprintf(pFile, "%llu", pSample->ullFrameTime);
+
+		for(int iStage = 0; iStage < FRAME_PROFILER_STAGE_MAX; iStage++)
+			fprintf(pFile, ",%llu,%llu", pSample->ullCpuTime[iStage], pSample->ullGpuTime[iStage]);
+
+		fprintf(pFile, "\n");
+	}
+
+	fclose(pFile);
+	return true;
+}
+
+CFrameProfilerScope::CFrameProfilerScope(eFrameProfilerStage stage)
+	: m_stage(stage)
+{
+	if(g_pFrameProfiler)
+		g_pFrameProfiler->BeginStage(m_stage);
+}
+
+CFrameProfilerScope::~CFrameProfilerScope()
+{
+	if(g_pFrameProfiler)
+		g_pFrameProfiler->EndStage(m_stage);
+}
@@ -0,0 +1,111 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFrameProfiler.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <d3d9.h>
+#include <CString.h>
+
+// Amount of frames kept for the graph, the percentiles and the dump
+#define FRAME_PROFILER_HISTORY 240
+
+// Amount of frames the gpu timestamps are read back later (so we never wait for the gpu)
+#define FRAME_PROFILER_QUERY_FRAMES 4
+
+// Stages of a frame the profiler times
+enum eFrameProfilerStage
+{
+	FRAME_PROFILER_GUI,
+	FRAME_PROFILER_WEBKIT,
+	FRAME_PROFILER_CHAT,
+	FRAME_PROFILER_NAMETAGS,
+	FRAME_PROFILER_FRAME_RENDER_EVENT,
+	FRAME_PROFILER_DISPLAY_LIST,
+	FRAME_PROFILER_NETWORK,
+	FRAME_PROFILER_STREAMER,
+	FRAME_PROFILER_STAGE_MAX
+};
+
+// Times (in microseconds) of a single frame, the gpu time is 0 if it isn't known (yet)
+struct FrameProfilerSample
+{
+	unsigned long long ullFrameTime;
+	unsigned long long ullCpuTime[FRAME_PROFILER_STAGE_MAX];
+	unsigned long long ullGpuTime[FRAME_PROFILER_STAGE_MAX];
+};
+
+// Gpu timestamps of the stages of a frame
+struct FrameProfilerQueries
+{
+	IDirect3DQuery9 * pDisjoint;
+	IDirect3DQuery9 * pFrequency;
+	IDirect3DQuery9 * pBegin[FRAME_PROFILER_STAGE_MAX];
+	IDirect3DQuery9 * pEnd[FRAME_PROFILER_STAGE_MAX];
+	bool              bIssued[FRAME_PROFILER_STAGE_MAX];
+	unsigned int      uiSample; // Index of the sample the results belong to
+	bool              bPending;
+};
+
+// Records the cpu and gpu time of the stages of each frame while it is enabled
+class CFrameProfiler
+{
+private:
+	IDirect3DDevice9   * m_pDevice;
+	bool                 m_bEnabled;
+	bool                 m_bQueriesCreated;
+	FrameProfilerSample  m_samples[FRAME_PROFILER_HISTORY];
+	unsigned int         m_uiCurrentSample;
+	unsigned int         m_uiSampleCount; // Amount of finished samples
+	unsigned long long   m_ullFrameStartTime;
+	unsigned long long   m_ullStageStartTime[FRAME_PROFILER_STAGE_MAX];
+	bool                 m_bGpuTiming[FRAME_PROFILER_STAGE_MAX]; // The begin timestamp of the stage was issued
+	FrameProfilerQueries m_queries[FRAME_PROFILER_QUERY_FRAMES];
+	unsigned int         m_uiCurrentQueries;
+	unsigned long long   m_ullTraceFrameStartTime;
+	unsigned long long   m_ullTraceStageStartTime[FRAME_PROFILER_STAGE_MAX]; // 0 if the stage isn't traced
+
+	void         CreateQueries();
+	void         DestroyQueries();
+	void         ReadQueries(FrameProfilerQueries * pQueries);
+	void         BeginFrameQueries();
+	void         StartFrame();
+
+public:
+	CFrameProfiler(IDirect3DDevice9 * pDevice);
+	~CFrameProfiler();
+
+	static const char * GetStageName(eFrameProfilerStage stage);
+	bool         IsEnabled() { return m_bEnabled; }
+	void         SetEnabled(bool bEnabled);
+	void         OnLostDevice();
+	void         OnResetDevice();
+	void         BeginStage(eFrameProfilerStage stage);
+	void         EndStage(eFrameProfilerStage stage);
+	void         EndFrame();
+
+	// Finished samples from the oldest (0) to the newest
+	unsigned int GetSampleCount() { return m_uiSampleCount; }
+	FrameProfilerSample * GetSample(unsigned int uiIndex);
+
+	// Frame time (in microseconds) that uiPercent percent of the frames are faster than
+	unsigned long long GetFrameTimePercentile(unsigned int uiPercent);
+	bool         Dump(String strPath);
+};
+
+// Times the stage from the construction to the destruction of the scope while the profiler
+// or the trace recorder is enabled
+class CFrameProfilerScope
+{
+private:
+	eFrameProfilerStage m_stage;
+
+public:
+	CFrameProfilerScope(eFrameProfilerStage stage);
+	~CFrameProfilerScope();
+};
@@ -16,6 +16,7 @@
 #include "CSettings.h"
 
 extern CChatWindow * g_pChatWindow;
+extern CGraphics * g_pGraphics;
 
 // TODO: Make CGUI message box members
 bool m_bMessageBoxHideCursor = false;
@@ -29,6 +30,7 @@ CGUI::CGUI(IDirect3DDevice9 * pD3DDevice)
 	m_pCursor(NULL),
 	m_pWindowManager(NULL),
 	m_pDefaultWindow(NULL),
+	m_pImageAtlas(NULL),
 	m_pInput(NULL),
 	m_pInputMouse(NULL),
 	m_bInitialized(false),
@@ -69,6 +71,9 @@ CGUI::~CGUI()
 	// Destroy the GUI fonts
 	CEGUI::FontManager::getSingleton().destroyAll();
 
+	// Destroy the image atlas (its imagesets are destroyed with the GUI system)
+	SAFE_DELETE(m_pImageAtlas);
+
 	// Destroy the default GUI window
 	m_pWindowManager->destroyWindow(m_pDefaultWindow);
 
@@ -176,6 +181,31 @@ bool CGUI::Initialize()
 		m_pTextDrawingGeometryBuffer = &m_pRenderer->createGeometryBuffer();
 		m_pTextDrawingGeometryBuffer->setClippingRegion(CEGUI::Rect(CEGUI::Vector2(0, 0), m_pRenderer->getDisplaySize()));
 
+		// Create the image atlas
+		m_pImageAtlas = new CGUIImageAtlas(m_pRenderer);
+
+		// Get the code points to rasterise when a font is created (e.g. "0x20-0x24F,0x400-0x4FF")
+		String strGlyphRanges = CVAR_GET_STRING("fontglyphranges");
+		const char * szRange = strGlyphRanges.Get();
+
+		while(*szRange)
+		{
+			char * szEnd;
+			unsigned int uiStart = strtoul(szRange, &szEnd, 0);
+			unsigned int uiEnd = uiStart;
+
+			if(szEnd == szRange)
+				break;
+
+			if(*szEnd == '-')
+				uiEnd = strtoul((szEnd + 1), &szEnd, 0);
+
+			if(uiEnd >= uiStart)
+				m_glyphRanges.push_back(std::pair<unsigned int, unsigned int>(uiStart, uiEnd));
+
+			szRange = ((*szEnd == ',') ? (szEnd + 1) : szEnd);
+		}
+
 		// Set the default GUI font
 		m_pSystem->setDefaultFont(GetFont(CVAR_GET_STRING("chatfont").Get()));
 
@@ -247,7 +277,7 @@ void CGUI::Render()
 	// Make sure we are initialized
 	if(m_bInitialized)
 	{
-		// Render our GUI
+		// Render our GUI, the renderer sets up its own states inside the overlay pass
 		if(m_pSystem)
 			m_pSystem->renderGUI();
 
@@ -359,107 +389,13 @@ void CGUI::DrawText(String sText, CEGUI::Vector2 vecPosition, CEGUI::ColourRect
 		// Do we have a valid font?
 		if(pTextFont)
 		{
-			// Reset the text geometry buffer
-			m_pTextDrawingGeometryBuffer->reset();
-
-			const float fBaseY = (vecPosition.d_y + pTextFont->getBaseline(fYScale));
-			CEGUI::Vector2 vecGlyphPos(vecPosition);
-			float fOtherY = 0;
-			CEGUI::ColourRect rColourRect = rColorRect;
-
-			// Temporary strings for unicode conversion
-			unsigned char ucAnsi = 0;
-			WCHAR wcUnicode = 0;
-
-			// Loop through all characters
-			unsigned int uiTextLength = sText.GetLength();
-
-			for(unsigned int c = 0; c < uiTextLength; c++)
-			{
-				// Set the current character in our ANSI string
-				ucAnsi = sText[c];
-
-				// Convert the current character to unicode
-				SharedUtility::AnsiToUnicode((const char *)&ucAnsi, 1, &wcUnicode, 1);
-
-				// Check for font formatting
-				if(bProcessFormatting)
-				{
-					// Check for newline constant
-					if(sText[c] == '\n')
-					{
-						vecGlyphPos.d_x = vecPosition.d_x;
-						fOtherY += pTextFont->getFontHeight();
-						continue;
-					}
-
-					// Check for color formatting
-					else if(uiTextLength >= 10 && (sText[c] == '[' && sText[c + 9] == ']'))
-					{
-						bool bValid = true;
-						CEGUI::String sColour;
-
-						// Loop through all color chars
-						for(size_t i = 0; i < 8; i++)
-						{
-							unsigned char cChar = sText[(c + i) + 1];
-
-							// Make sure its 0-99, A-F or a-f
-							if((cChar < '0' || cChar > '9') && (cChar < 'A' || cChar > 'F') && 
-								(cChar < 'a' || cChar > 'f'))
-							{
-								// char is invalid
-								bValid = false;
-								break;
-							}
-
-							// Add the char to the color string
-							sColour += cChar;
-						}
-
-						// Set the color if its valid
-						if(bValid)
-						{
-							// Is color formatting allowed?
-							if(bAllowColorFormatting)
-							{
-								// Set the color
-								rColourRect.setColours((CEGUI::colour(strtoul(sColour.c_str(), NULL, 16)) >> 8) | 0xFF000000);
-							}
-
-							// Increment the current char by 9
-							c += 9;
-							continue;
-						}
-					}
-				}
-
-				// Attempt to get the glyph data
-				const CEGUI::FontGlyph * glyph = pTextFont->getGlyphData((unsigned long)wcUnicode);
-
-				// Do we have valid glyph data?
-				if(glyph)
-				{
-					// Get the glyph image
-					const CEGUI::Image * const img = glyph->getImage();
+			// Lay out the text, this is skipped if the same text is drawn again
+			m_textLayout.Set(sText, pTextFont, bProcessFormatting, fSpaceExtra, fXScale, fYScale);
 
-					// Calculate the glyph y position
-					vecGlyphPos.d_y = (fBaseY - (img->getOffsetY() - img->getOffsetY() * fYScale) + fOtherY);
-
-					// Draw the glyph
-					img->draw(*m_pTextDrawingGeometryBuffer, vecGlyphPos, glyph->getSize(fXScale, fYScale), rClipRect, rColourRect);
-
-					// Increment the x position
-					vecGlyphPos.d_x += glyph->getAdvance(fXScale);
-
-					// Apply extra spacing to space chars
-					if(sText[c] == ' ')
-						vecGlyphPos.d_x += fSpaceExtra;
-				}
-			}
-
-			// Draw the text geometry buffer
-			m_pTextDrawingGeometryBuffer->draw();
+			// Draw the text
+			BeginTextBatch();
+			m_textLayout.Draw(m_pTextDrawingGeometryBuffer, vecPosition, rColorRect, bAllowColorFormatting, rClipRect);
+			DrawTextBatch();
 		}
 	}
 }
@@ -469,6 +405,36 @@ void CGUI::DrawText(String sText, CEGUI::Vector2 vecPosition, CEGUI::ColourRect
 	DrawText(sText, vecPosition, rColorRect, GetFont(strFontName), bProcessFormatting, bAllowColorFormatting, rClipRect, fSpaceExtra, fXScale, fYScale);
 }
 
+void CGUI::BeginTextBatch()
+{
+	if(m_bInitialized)
+		m_pTextDrawingGeometryBuffer->reset();
+}
+
+void CGUI::AddTextToBatch(CGUITextLayout * pTextLayout, CEGUI::Vector2 vecPosition, CEGUI::ColourRect rColorRect, bool bAllowColorFormatting, CEGUI::Rect * rClipRect)
+{
+	if(m_bInitialized)
+		pTextLayout->Draw(m_pTextDrawingGeometryBuffer, vecPosition, rColorRect, bAllowColorFormatting, rClipRect);
+}
+
+void CGUI::AddImageToBatch(const CEGUI::Image * pImage, const CEGUI::Rect& rect, CEGUI::ColourRect rColorRect, CEGUI::Rect * rClipRect)
+{
+	if(m_bInitialized)
+		pImage->draw(*m_pTextDrawingGeometryBuffer, rect, rClipRect, rColorRect);
+}
+
+void CGUI::DrawTextBatch()
+{
+	if(m_bInitialized)
+	{
+		// Draw the text over the primitives drawn before it
+		if(g_pGraphics)
+			g_pGraphics->Flush();
+
+		m_pTextDrawingGeometryBuffer->draw();
+	}
+}
+
 bool CGUI::OnMessageBoxClick(const CEGUI::EventArgs &eventArgs)
 {
 	// Get the window
@@ -1253,17 +1219,44 @@ CEGUI::Font * CGUI::GetFont(String strFont, unsigned int uiSize, bool bScaled)
 		// Get the font name
 		String strName("%s.ttf", strFont.ToLower().Get());
 
+		CEGUI::Font * pFont = NULL;
+
 		// Attempt to create the front from the fonts directory
 		try {
-			return &CEGUI::FontManager::getSingleton().createFreeTypeFont(strInternalFont.Get(), (float)uiSize, true, strName.Get(), "", bScaled);
+			pFont = &CEGUI::FontManager::getSingleton().createFreeTypeFont(strInternalFont.Get(), (float)uiSize, true, strName.Get(), "", bScaled);
 		} catch(CEGUI::Exception e) {}
 
 		// Attempt to create the font from the client resource directory
-		try {
-			return &CEGUI::FontManager::getSingleton().createFreeTypeFont(strInternalFont.C_String(), (float)uiSize, true, strName.Get(), "resources", bScaled);
-		} catch(CEGUI::Exception e) {}
+		if(!pFont)
+		{
+			try {
+				pFont = &CEGUI::FontManager::getSingleton().createFreeTypeFont(strInternalFont.C_String(), (float)uiSize, true, strName.Get(), "resources", bScaled);
+			} catch(CEGUI::Exception e) {}
+		}
+
+		if(pFont)
+		{
+			PreloadGlyphs(pFont);
+			return pFont;
+		}
 	}
 
 	// Font does not exist and font creation failed
 	return NULL;
 }
+
+void CGUI::PreloadGlyphs(CEGUI::Font * pFont)
+{
+	// Rasterise the glyphs now instead of the first time a frame draws them, the
+	// font rasterises whole pages of 256 code points so one per page is enough
+	for(std::vector<std::pair<unsigned int, unsigned int> >::iterator iter = m_glyphRanges.begin(); iter != m_glyphRanges.end(); ++iter)
+	{
+		for(unsigned int uiCodepoint = (*iter).first; uiCodepoint <= (*iter).second; uiCodepoint = ((uiCodepoint | 0xFF) + 1))
+		{
+			pFont->getGlyphData(uiCodepoint);
+
+			if((uiCodepoint | 0xFF) == 0xFFFFFFFF)
+				break;
+		}
+	}
+}
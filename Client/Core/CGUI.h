@@ -18,6 +18,8 @@
 #include <CEGUI.h>
 #include <RendererModules/Direct3D9/CEGUIDirect3D9Renderer.h>
 #include "CDirectInput8Proxy.h"
+#include "CGUITextLayout.h"
+#include "CGUIImageAtlas.h"
 #include <CString.h>
 
 //#define STYLE_SCHEME "VanillaSkin.scheme"
@@ -104,6 +106,9 @@ private:
 	CEGUI::DefaultWindow     * m_pDefaultWindow;
 	CEGUI::FontManager       * m_pFontManager;
 	CEGUI::GeometryBuffer    * m_pTextDrawingGeometryBuffer;
+	CGUITextLayout             m_textLayout; // Of the last text drawn with DrawText
+	CGUIImageAtlas           * m_pImageAtlas;
+	std::vector<std::pair<unsigned int, unsigned int> > m_glyphRanges; // Code points rasterised when a font is created
 
 	struct
 	{
@@ -128,6 +133,8 @@ private:
 	POINT                      m_clickPosition;
 	unsigned int               m_uiCurrentKyeFag;
 
+	void                       PreloadGlyphs(CEGUI::Font * pFont);
+
 public:
 	CGUI(IDirect3DDevice9 * pD3DDevice);
 	~CGUI();
@@ -141,6 +148,12 @@ public:
 	void                       DrawText(String sText, CEGUI::Vector2 vecPosition, CEGUI::ColourRect rColorRect = CEGUI::colour(0xFFFFFFFF), CEGUI::Font * pFont = NULL, bool bProcessFormatting = true, bool bAllowColorFormatting = true, CEGUI::Rect * rClipRect = NULL, float fSpaceExtra = 0.0f, float fXScale = 1.0f, float fYScale = 1.0f);
 	void                       DrawText(String sText, CEGUI::Vector2 vecPosition, CEGUI::ColourRect rColorRect, String sFontName, bool bProcessFormatting = true, bool bAllowColorFormatting = true, CEGUI::Rect * rClipRect = NULL, float fSpaceExtra = 0.0f, float fXScale = 1.0f, float fYScale = 1.0f);
 
+	// Draws many laid out texts (and images) with a single draw call
+	void                       BeginTextBatch();
+	void                       AddTextToBatch(CGUITextLayout * pTextLayout, CEGUI::Vector2 vecPosition, CEGUI::ColourRect rColorRect = CEGUI::colour(0xFFFFFFFF), bool bAllowColorFormatting = true, CEGUI::Rect * rClipRect = NULL);
+	void                       AddImageToBatch(const CEGUI::Image * pImage, const CEGUI::Rect& rect, CEGUI::ColourRect rColorRect = CEGUI::colour(0xFFFFFFFF), CEGUI::Rect * rClipRect = NULL);
+	void                       DrawTextBatch();
+
 	// Message box
 	bool                       OnMessageBoxClick(const CEGUI::EventArgs& eventArgs);
 	void                       ShowMessageBox(const CEGUI::String &sText, const CEGUI::String &sTitle = "", eGUIMessageBoxType style = GUI_MESSAGEBOXTYPE_OK, GUIMessageBoxHandler_t pfnHandler = NULL);
@@ -196,6 +209,7 @@ public:
 	CEGUI::WindowManager     * GetWindowManager() { return m_pWindowManager; }
 	CEGUI::DefaultWindow     * GetDefaultWindow() { return m_pDefaultWindow; }
 	CEGUI::Font              * GetFont(String strFont, unsigned int uiSize = 8, bool bScaled = false);
+	CGUIImageAtlas           * GetImageAtlas() { return m_pImageAtlas; }
 };
 
 class CGUIElement
@@ -0,0 +1,169 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CGUIImageAtlas.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <windows.h>
+#include "CGUIImageAtlas.h"
+
+// Texture the image codec decodes an image into, it only keeps the pixels
+class CGUIDecodedImage : public CEGUI::Texture
+{
+private:
+	CEGUI::Size                m_size;
+	CEGUI::Vector2             m_texelScaling;
+
+public:
+	std::vector<unsigned long> m_pixels; // D3DCOLOR rows
+
+	CGUIDecodedImage() : m_size(0, 0), m_texelScaling(0, 0) { }
+
+	const CEGUI::Size& getSize() const { return m_size; }
+	const CEGUI::Size& getOriginalDataSize() const { return m_size; }
+	const CEGUI::Vector2& getTexelScaling() const { return m_texelScaling; }
+	void loadFromFile(const CEGUI::String& filename, const CEGUI::String& resourceGroup) { }
+	void saveToMemory(void* buffer) { }
+
+	void loadFromMemory(const void* buffer, const CEGUI::Size& buffer_size, PixelFormat pixel_format)
+	{
+		m_size = buffer_size;
+		unsigned int uiWidth = (unsigned int)buffer_size.d_width;
+		unsigned int uiHeight = (unsigned int)buffer_size.d_height;
+		m_pixels.resize(uiWidth * uiHeight);
+		const unsigned char * pSource = static_cast<const unsigned char *>(buffer);
+		unsigned int uiBytesPerPixel = ((pixel_format == PF_RGBA) ? 4 : 3);
+
+		// Convert it the same way the renderer does
+		for(unsigned int i = 0; i < (uiWidth * uiHeight); i++)
+		{
+			const unsigned char * pPixel = &pSource[i * uiBytesPerPixel];
+			unsigned char ucAlpha = ((pixel_format == PF_RGBA) ? pPixel[3] : 0xFF);
+			m_pixels[i] = D3DCOLOR_ARGB(ucAlpha, pPixel[0], pPixel[1], pPixel[2]);
+		}
+	}
+};
+
+CGUIImageAtlas::CGUIImageAtlas(CEGUI::Direct3D9Renderer * pRenderer)
+	: m_pRenderer(pRenderer)
+{
+
+}
+
+CGUIImageAtlas::~CGUIImageAtlas()
+{
+	// The imagesets own the atlas textures and are destroyed with the gui system
+}
+
+GUIAtlasPage * CGUIImageAtlas::AddPage()
+{
+	GUIAtlasPage page;
+	page.pTexture = static_cast<CEGUI::Direct3D9Texture *>(&m_pRenderer->createTexture(CEGUI::Size(GUI_ATLAS_SIZE, GUI_ATLAS_SIZE)));
+	page.uiShelfX = 0;
+	page.uiShelfY = 0;
+	page.uiShelfHeight = 0;
+
+	// Start with a transparent texture
+	D3DLOCKED_RECT lockedRect;
+
+	if(SUCCEEDED(page.pTexture->getDirect3D9Texture()->LockRect(0, &lockedRect, NULL, 0)))
+	{
+		for(unsigned int y = 0; y < GUI_ATLAS_SIZE; y++)
+			memset(((unsigned char *)lockedRect.pBits + (y * lockedRect.Pitch)), 0, (GUI_ATLAS_SIZE * sizeof(unsigned long)));
+
+		page.pTexture->getDirect3D9Texture()->UnlockRect(0);
+	}
+
+	String strName("atlas%d", m_pages.size());
+	page.pImageset = &CEGUI::ImagesetManager::getSingleton().create(strName.Get(), *page.pTexture);
+	m_pages.push_back(page);
+	return &m_pages.back();
+}
+
+bool CGUIImageAtlas::Allocate(GUIAtlasPage * pPage, unsigned int uiWidth, unsigned int uiHeight, unsigned int& uiX, unsigned int& uiY)
+{
+	uiWidth += GUI_ATLAS_PADDING;
+	uiHeight += GUI_ATLAS_PADDING;
+
+	// Does it not fit on the current shelf? Start a new one below it
+	if((pPage->uiShelfX + uiWidth) > GUI_ATLAS_SIZE)
+	{
+		pPage->uiShelfY += pPage->uiShelfHeight;
+		pPage->uiShelfX = 0;
+		pPage->uiShelfHeight = 0;
+	}
+
+	if((pPage->uiShelfY + uiHeight) > GUI_ATLAS_SIZE)
+		return false;
+
+	uiX = pPage->uiShelfX;
+	uiY = pPage->uiShelfY;
+	pPage->uiShelfX += uiWidth;
+
+	if(uiHeight > pPage->uiShelfHeight)
+		pPage->uiShelfHeight = uiHeight;
+
+	return true;
+}
+
+String CGUIImageAtlas::Load(const String& strName, const String& strFile, const String& strResourceGroup)
+{
+	CEGUI::System * pSystem = CEGUI::System::getSingletonPtr();
+
+	// Decode the image
+	CGUIDecodedImage image;
+	CEGUI::RawDataContainer data;
+	bool bDecoded = false;
+
+	try
+	{
+		pSystem->getResourceProvider()->loadRawDataContainer(strFile.Get(), data, strResourceGroup.Get());
+		bDecoded = (pSystem->getImageCodec().load(data, &image) != NULL);
+		pSystem->getResourceProvider()->unloadRawDataContainer(data);
+	}
+	catch(CEGUI::Exception e) {}
+
+	unsigned int uiWidth = (unsigned int)image.getSize().d_width;
+	unsigned int uiHeight = (unsigned int)image.getSize().d_height;
+	GUIAtlasPage * pPage = NULL;
+	unsigned int uiX, uiY;
+
+	if(bDecoded && uiWidth > 0 && uiHeight > 0 && uiWidth <= GUI_ATLAS_MAX_IMAGE_SIZE && uiHeight <= GUI_ATLAS_MAX_IMAGE_SIZE)
+	{
+		// Use the last page, it is the only one with free shelves
+		if(!m_pages.empty() && Allocate(&m_pages.back(), uiWidth, uiHeight, uiX, uiY))
+			pPage = &m_pages.back();
+		else
+		{
+			pPage = AddPage();
+
+			if(!Allocate(pPage, uiWidth, uiHeight, uiX, uiY))
+				pPage = NULL;
+		}
+	}
+
+	// Is it too big for an atlas (or couldn't it be decoded)? (this throws if it can't be loaded)
+	if(!pPage)
+	{
+		CEGUI::ImagesetManager::getSingleton().createFromImageFile(strName.Get(), strFile.Get(), strResourceGroup.Get());
+		return String("set:%s image:full_image", strName.Get());
+	}
+
+	// Copy the image into the atlas
+	RECT rect = { uiX, uiY, (uiX + uiWidth), (uiY + uiHeight) };
+	D3DLOCKED_RECT lockedRect;
+
+	if(SUCCEEDED(pPage->pTexture->getDirect3D9Texture()->LockRect(0, &lockedRect, &rect, 0)))
+	{
+		for(unsigned int y = 0; y < uiHeight; y++)
+			memcpy(((unsigned char *)lockedRect.pBits + (y * lockedRect.Pitch)), &image.m_pixels[y * uiWidth], (uiWidth * sizeof(unsigned long)));
+
+		pPage->pTexture->getDirect3D9Texture()->UnlockRect(0);
+	}
+
+	pPage->pImageset->defineImage(strName.Get(), CEGUI::Rect((float)uiX, (float)uiY, (float)(uiX + uiWidth), (float)(uiY + uiHeight)), CEGUI::Point(0, 0));
+	return String("set:%s image:%s", pPage->pImageset->getName().c_str(), strName.Get());
+}
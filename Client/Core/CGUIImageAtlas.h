@@ -0,0 +1,53 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CGUIImageAtlas.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include <CEGUI.h>
+#include <RendererModules/Direct3D9/CEGUIDirect3D9Renderer.h>
+#include <RendererModules/Direct3D9/CEGUIDirect3D9Texture.h>
+#include <CString.h>
+
+// Size of an atlas texture, bigger images get a texture of their own
+#define GUI_ATLAS_SIZE 1024
+#define GUI_ATLAS_MAX_IMAGE_SIZE 256
+
+// Empty pixels around each image so filtering doesn't bleed its neighbours in
+#define GUI_ATLAS_PADDING 1
+
+// A single atlas texture, the images are put on shelves from the top down
+struct GUIAtlasPage
+{
+	CEGUI::Imageset         * pImageset;
+	CEGUI::Direct3D9Texture * pTexture;
+	unsigned int              uiShelfX; // Where the next image on the shelf goes
+	unsigned int              uiShelfY;
+	unsigned int              uiShelfHeight;
+};
+
+// Loads small images into shared textures so the windows showing them don't need
+// a texture (and a separate batch) each
+class CGUIImageAtlas
+{
+private:
+	CEGUI::Direct3D9Renderer * m_pRenderer;
+	std::vector<GUIAtlasPage>  m_pages;
+
+	bool Allocate(GUIAtlasPage * pPage, unsigned int uiWidth, unsigned int uiHeight, unsigned int& uiX, unsigned int& uiY);
+	GUIAtlasPage * AddPage();
+
+public:
+	CGUIImageAtlas(CEGUI::Direct3D9Renderer * pRenderer);
+	~CGUIImageAtlas();
+
+	// Loads the image file and returns the Image property value of it, images that don't
+	// fit an atlas get an imageset of their own. Throws like createFromImageFile.
+	String Load(const String& strName, const String& strFile, const String& strResourceGroup);
+};
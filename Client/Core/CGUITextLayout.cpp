@@ -0,0 +1,166 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CGUITextLayout.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <windows.h>
+#include "CGUITextLayout.h"
+#include <SharedUtility.h>
+
+CGUITextLayout::CGUITextLayout()
+{
+	m_pFont = NULL;
+	m_bProcessFormatting = false;
+	m_fSpaceExtra = 0.0f;
+	m_fXScale = 1.0f;
+	m_fYScale = 1.0f;
+	m_fExtent = 0.0f;
+}
+
+void CGUITextLayout::Reset()
+{
+	m_pFont = NULL;
+	m_strText.Clear();
+	m_glyphs.clear();
+	m_fExtent = 0.0f;
+}
+
+bool CGUITextLayout::Set(const String& strText, CEGUI::Font * pFont, bool bProcessFormatting, float fSpaceExtra, float fXScale, float fYScale)
+{
+	// Is it laid out like this already?
+	if(pFont == m_pFont && bProcessFormatting == m_bProcessFormatting && fSpaceExtra == m_fSpaceExtra &&
+		fXScale == m_fXScale && fYScale == m_fYScale && strText == m_strText)
+		return false;
+
+	m_pFont = pFont;
+	m_strText = strText;
+	m_bProcessFormatting = bProcessFormatting;
+	m_fSpaceExtra = fSpaceExtra;
+	m_fXScale = fXScale;
+	m_fYScale = fYScale;
+	m_glyphs.clear();
+	m_fExtent = 0.0f;
+
+	if(!pFont)
+		return true;
+
+	const float fBaseY = pFont->getBaseline(fYScale);
+	CEGUI::Vector2 vecGlyphPos(0.0f, 0.0f);
+	float fOtherY = 0;
+	bool bHasColor = false;
+	CEGUI::colour color;
+
+	// Temporary strings for unicode conversion
+	unsigned char ucAnsi = 0;
+	WCHAR wcUnicode = 0;
+
+	// Loop through all characters
+	unsigned int uiTextLength = strText.GetLength();
+
+	for(unsigned int c = 0; c < uiTextLength; c++)
+	{
+		// Set the current character in our ANSI string
+		ucAnsi = strText[c];
+
+		// Convert the current character to unicode
+		SharedUtility::AnsiToUnicode((const char *)&ucAnsi, 1, &wcUnicode, 1);
+
+		// Check for font formatting
+		if(bProcessFormatting)
+		{
+			// Check for newline constant
+			if(strText[c] == '\n')
+			{
+				vecGlyphPos.d_x = 0.0f;
+				fOtherY += pFont->getFontHeight();
+				continue;
+			}
+
+			// Check for color formatting
+			else if((c + 9) < uiTextLength && (strText[c] == '[' && strText[c + 9] == ']'))
+			{
+				bool bValid = true;
+				CEGUI::String sColour;
+
+				// Loop through all color chars
+				for(size_t i = 0; i < 8; i++)
+				{
+					unsigned char cChar = strText[(c + i) + 1];
+
+					// Make sure its 0-99, A-F or a-f
+					if((cChar < '0' || cChar > '9') && (cChar < 'A' || cChar > 'F') &&
+						(cChar < 'a' || cChar > 'f'))
+					{
+						// char is invalid
+						bValid = false;
+						break;
+					}
+
+					// Add the char to the color string
+					sColour += cChar;
+				}
+
+				// Set the color if its valid
+				if(bValid)
+				{
+					bHasColor = true;
+					color = ((CEGUI::colour(strtoul(sColour.c_str(), NULL, 16)) >> 8) | 0xFF000000);
+
+					// Increment the current char by 9
+					c += 9;
+					continue;
+				}
+			}
+		}
+
+		// Attempt to get the glyph data
+		const CEGUI::FontGlyph * glyph = pFont->getGlyphData((unsigned long)wcUnicode);
+
+		// Do we have valid glyph data?
+		if(glyph)
+		{
+			// Get the glyph image
+			const CEGUI::Image * const img = glyph->getImage();
+
+			// Calculate the glyph y position
+			vecGlyphPos.d_y = (fBaseY - (img->getOffsetY() - img->getOffsetY() * fYScale) + fOtherY);
+
+			GUITextGlyph textGlyph;
+			textGlyph.pImage = img;
+			textGlyph.vecOffset = vecGlyphPos;
+			textGlyph.size = glyph->getSize(fXScale, fYScale);
+			textGlyph.bHasColor = bHasColor;
+			textGlyph.color = color;
+			m_glyphs.push_back(textGlyph);
+
+			// Increment the x position
+			vecGlyphPos.d_x += glyph->getAdvance(fXScale);
+
+			// Apply extra spacing to space chars
+			if(strText[c] == ' ')
+				vecGlyphPos.d_x += fSpaceExtra;
+
+			if(vecGlyphPos.d_x > m_fExtent)
+				m_fExtent = vecGlyphPos.d_x;
+		}
+	}
+
+	return true;
+}
+
+void CGUITextLayout::Draw(CEGUI::GeometryBuffer * pBuffer, const CEGUI::Vector2& vecPosition, const CEGUI::ColourRect& rColorRect, bool bAllowColorFormatting, const CEGUI::Rect * rClipRect)
+{
+	for(std::vector<GUITextGlyph>::iterator iter = m_glyphs.begin(); iter != m_glyphs.end(); iter++)
+	{
+		CEGUI::Vector2 vecGlyphPos((vecPosition.d_x + iter->vecOffset.d_x), (vecPosition.d_y + iter->vecOffset.d_y));
+
+		if(bAllowColorFormatting && iter->bHasColor)
+			iter->pImage->draw(*pBuffer, vecGlyphPos, iter->size, rClipRect, CEGUI::ColourRect(iter->color));
+		else
+			iter->pImage->draw(*pBuffer, vecGlyphPos, iter->size, rClipRect, rColorRect);
+	}
+}
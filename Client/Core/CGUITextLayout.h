@@ -0,0 +1,51 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CGUITextLayout.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include <CEGUI.h>
+#include <CString.h>
+
+struct GUITextGlyph
+{
+	const CEGUI::Image * pImage;
+	CEGUI::Vector2       vecOffset; // From the position the text is drawn at
+	CEGUI::Size          size;
+	bool                 bHasColor; // Colored by a color code
+	CEGUI::colour        color;
+};
+
+// The glyphs of a text laid out once (with the color codes parsed) so it can
+// be drawn again and again without looking up every character
+class CGUITextLayout
+{
+private:
+	CEGUI::Font             * m_pFont;
+	String                    m_strText;
+	bool                      m_bProcessFormatting;
+	float                     m_fSpaceExtra;
+	float                     m_fXScale;
+	float                     m_fYScale;
+	std::vector<GUITextGlyph> m_glyphs;
+	float                     m_fExtent;
+
+public:
+	CGUITextLayout();
+
+	// Lays out the text, returns false if it is already laid out like this
+	bool          Set(const String& strText, CEGUI::Font * pFont, bool bProcessFormatting = true, float fSpaceExtra = 0.0f, float fXScale = 1.0f, float fYScale = 1.0f);
+	void          Reset();
+	bool          IsEmpty() { return m_glyphs.empty(); }
+	CEGUI::Font * GetFont() { return m_pFont; }
+	float         GetExtent() { return m_fExtent; }
+
+	// Adds the glyphs to the geometry buffer, the color codes are only used if bAllowColorFormatting is set
+	void          Draw(CEGUI::GeometryBuffer * pBuffer, const CEGUI::Vector2& vecPosition, const CEGUI::ColourRect& rColorRect, bool bAllowColorFormatting = true, const CEGUI::Rect * rClipRect = NULL);
+};
@@ -35,6 +35,7 @@
 #include "CMainMenu.h"
 #include "AnimGroups.h"
 #include "CCrashFixes.h"
+#include "CGameFileChecker.h"
 
 // Enable on of them if we wanna/don't want trains
 #ifdef IVMP_TRAINS
@@ -167,6 +168,9 @@ void CGame::Initialize()
 	assert(sizeof(IVWeaponInfo) == 0x110);
 	assert(sizeof(CSimpleCollection<void>) == 0x8);
 
+	// Check the game files while the game loads, the result is needed once we connect
+	CGameFileChecker::StartCheck();
+
 	// Get the process base address
 	m_uiBaseAddress = (unsigned int)GetModuleHandle(NULL);
 
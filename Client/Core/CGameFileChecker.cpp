@@ -9,8 +9,10 @@
 //==============================================================================
 
 #include "CGameFileChecker.h"
-#include <CFileChecksum.h>
+#include <algorithm>
+#include <CChecksumCache.h>
 #include <CLogFile.h>
+#include <Threading/CJobSystem.h>
 
 struct GameFile
 {
@@ -23,21 +25,106 @@ struct GameFile
 	{ 0x6DA6A192, "common\\data\\gta.dat" }
 };
 
-bool CGameFileChecker::CheckFiles()
+// The files whose checksums weren't in the cache
+struct GameFileJob
+{
+	String             strFilePath;
+	ChecksumCacheEntry entry;
+	bool               bCalculated;
+};
+
+CThread CGameFileChecker::m_checkThread;
+bool    CGameFileChecker::m_bCheckStarted = false;
+bool    CGameFileChecker::m_bFilesValid = false;
+
+static void CalculateGameFileChecksums(unsigned int uiBegin, unsigned int uiEnd, void * pUserData)
+{
+	GameFileJob * pJobs = (GameFileJob *)pUserData;
+
+	for(unsigned int i = uiBegin; i < uiEnd; i++)
+		pJobs[i].bCalculated = pJobs[i].entry.fileChecksum.Calculate(pJobs[i].strFilePath);
+}
+
+bool CGameFileChecker::Check()
 {
-	CFileChecksum fileChecksum;
+	CChecksumCache checksumCache(SharedUtility::GetAbsolutePath("clientfiles/%s", GAME_FILE_CACHE_FILE));
+	CFileChecksum fileChecksums[ARRAY_LENGTH(gameFiles)];
+	GameFileJob jobs[ARRAY_LENGTH(gameFiles)];
+	int iFileJobs[ARRAY_LENGTH(gameFiles)];
+	unsigned int uiJobs = 0;
 
+	// Only the files that changed since they were last checked are read again
 	for(int i = 0; i < ARRAY_LENGTH(gameFiles); i++)
 	{
+		iFileJobs[i] = -1;
+		String strFilePath("%s%s", SharedUtility::GetExePath(), gameFiles[i].strFileName.Get());
+		ChecksumCacheEntry entry;
+
 		// No need to check if the files exist as they should all be default game files
-		fileChecksum.Calculate(String("%s%s", SharedUtility::GetExePath(), gameFiles[i].strFileName.Get()));
+		if(!CChecksumCache::GetFileInfo(strFilePath, entry))
+			continue;
+
+		if(checksumCache.GetCachedChecksum(strFilePath, entry, fileChecksums[i]))
+			continue;
+
+		jobs[uiJobs].strFilePath = strFilePath;
+		jobs[uiJobs].entry = entry;
+		jobs[uiJobs].bCalculated = false;
+		iFileJobs[i] = uiJobs++;
+	}
+
+	if(uiJobs > 0)
+	{
+		// One thread per file, the calling thread is one of them
+		unsigned int uiThreads = std::min(uiJobs, CJobSystem::GetProcessorCount());
+		CJobSystem jobSystem((int)uiThreads - 1);
+		jobSystem.ParallelFor(0, uiJobs, 1, CalculateGameFileChecksums, jobs);
+
+		for(int i = 0; i < ARRAY_LENGTH(gameFiles); i++)
+		{
+			if(iFileJobs[i] == -1 || !jobs[iFileJobs[i]].bCalculated)
+				continue;
+
+			fileChecksums[i] = jobs[iFileJobs[i]].entry.fileChecksum;
+			checksumCache.SetChecksum(jobs[iFileJobs[i]].strFilePath, jobs[iFileJobs[i]].entry);
+		}
+	}
 
-		if(fileChecksum.GetChecksum() != gameFiles[i].uiChecksum)
+	for(int i = 0; i < ARRAY_LENGTH(gameFiles); i++)
+	{
+		if(fileChecksums[i].GetChecksum() != gameFiles[i].uiChecksum)
 		{
-			CLogFile::Printf("Checksum for file %s failed (Expected 0x%x, Got 0x%x).", gameFiles[i].strFileName.Get(), fileChecksum.GetChecksum(), gameFiles[i].uiChecksum);
+			CLogFile::Printf("Checksum for file %s failed (Expected 0x%x, Got 0x%x).", gameFiles[i].strFileName.Get(), gameFiles[i].uiChecksum, fileChecksums[i].GetChecksum());
 			return false;
 		}
 	}
 
 	return true;
 }
+
+void CGameFileChecker::CheckThread(CThread * pCreator)
+{
+	m_bFilesValid = Check();
+}
+
+void CGameFileChecker::StartCheck()
+{
+	if(m_bCheckStarted)
+		return;
+
+	m_bCheckStarted = true;
+	m_checkThread.Start(CheckThread);
+}
+
+bool CGameFileChecker::CheckFiles()
+{
+	if(m_bCheckStarted)
+	{
+		// Wait for the check that runs while the game loads
+		m_checkThread.Stop();
+		m_bCheckStarted = false;
+		return m_bFilesValid;
+	}
+
+	return Check();
+}
@@ -9,8 +9,26 @@
 
 #pragma once
 
+#include <Threading/CThread.h>
+
+// Name of the checksum cache file of the game files
+#define GAME_FILE_CACHE_FILE "gamechecksums.dat"
+
 class CGameFileChecker
 {
+private:
+	static CThread m_checkThread;
+	static bool    m_bCheckStarted;
+	static bool    m_bFilesValid;
+
+	static bool    Check();
+	static void    CheckThread(CThread * pCreator);
+
 public:
-	static bool CheckFiles();
+	// Starts checking the files on another thread so it runs while the game loads
+	static void    StartCheck();
+
+	// Returns true if the files are unmodified, waits for the check StartCheck
+	// started if there is one and checks the files again otherwise
+	static bool    CheckFiles();
 };
@@ -16,97 +16,257 @@
 #include <CSettings.h>
 
 extern CGUI * g_pGUI;
-const unsigned char g_szPixel [] = { 0x42, 0x4D, 0x3A, 0, 0, 0, 0, 0, 0, 0, 0x36, 0, 0, 0, 0x28, 0, 0,
-                                    0, 0x1, 0, 0, 0, 0x1, 0, 0, 0, 0x1, 0, 0x18, 0, 0, 0, 0, 0,
-                                    0x4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-                                    0, 0, 0, 0xFF, 0xFF, 0xFF, 0 };
 
-struct D3DVERTEX
+#define D3DFVF_GRAPHICS (D3DFVF_XYZRHW | D3DFVF_DIFFUSE)
+
+CGraphics::CGraphics(IDirect3DDevice9 * pDevice)
 {
-	float fX;
-	float fY;
-	float fZ;
-	float fRHW;
-	DWORD dwColor;
+	m_pDevice = pDevice;
+	m_pOverlayStateBlock = NULL;
+	m_pBatchStateBlock = NULL;
+	m_pVertexBuffer = NULL;
+	m_vertices.reserve(GRAPHICS_BATCH_MAX_VERTICES);
+	OnResetDevice();
+}
+
+CGraphics::~CGraphics()
+{
+	OnLostDevice();
+}
 
-	D3DVERTEX()
+void CGraphics::OnLostDevice()
+{
+	// Drop anything that was not drawn yet
+	m_vertices.clear();
+	m_runs.clear();
+
+	// If we have state blocks release them
+	if(m_pOverlayStateBlock)
 	{
-		fX = 0.0f;
-		fY = 0.0f;
-		fZ = 0.0f;
-		fRHW = 1.0f;
-		dwColor = 0;
+		m_pOverlayStateBlock->Release();
+		m_pOverlayStateBlock = NULL;
 	}
 
-	D3DVERTEX(float _fX, float _fY, float _fZ, float _fRHW, DWORD _dwColor)
+	if(m_pBatchStateBlock)
 	{
-		fX = _fX;
-		fY = _fY;
-		fZ = _fZ;
-		fRHW = _fRHW;
-		dwColor = _dwColor;
+		m_pBatchStateBlock->Release();
+		m_pBatchStateBlock = NULL;
 	}
-};
 
-CGraphics::CGraphics(IDirect3DDevice9 * pDevice)
+	// If we have a vertex buffer release it
+	if(m_pVertexBuffer)
+	{
+		m_pVertexBuffer->Release();
+		m_pVertexBuffer = NULL;
+	}
+}
+
+void CGraphics::OnResetDevice()
 {
-	m_pDevice = pDevice;
-	m_pStateBlock = NULL;
+	// If we don't have state blocks create them
+	if(!m_pOverlayStateBlock)
+		m_pOverlayStateBlock = CreateOverlayStateBlock();
 
-	// Create Sprite..
-	D3DXCreateSprite( m_pDevice, &m_pSprite );
+	if(!m_pBatchStateBlock)
+		m_pBatchStateBlock = CreateBatchStateBlock();
 
-	// Create Texture stuff
-	D3DXCreateTextureFromFileInMemory( pDevice,  g_szPixel, sizeof( g_szPixel ), &m_pPixelTexture );
+	// If we don't have a vertex buffer create one
+	if(!m_pVertexBuffer)
+	{
+		if(FAILED(m_pDevice->CreateVertexBuffer((GRAPHICS_BATCH_MAX_VERTICES * sizeof(D3DVERTEX)), (D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY), 
+			D3DFVF_GRAPHICS, D3DPOOL_DEFAULT, &m_pVertexBuffer, NULL)))
+			m_pVertexBuffer = NULL;
+	}
+}
 
-	OnResetDevice();
+// A recorded state block only holds the states that were set while recording
+// it, capturing it later saves just their current values. The recorded values
+// don't matter as it is always captured before it is applied and the device
+// state isn't changed while recording.
+IDirect3DStateBlock9 * CGraphics::CreateOverlayStateBlock()
+{
+	if(FAILED(m_pDevice->BeginStateBlock()))
+		return NULL;
+
+	// The states of the batch and of the gui renderer (see Direct3D9Renderer::beginRendering
+	// and Direct3D9GeometryBuffer::draw), the gui render targets restore the render target themselves
+	D3DMATRIX matIdentity = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	D3DVIEWPORT9 viewport = { 0, 0, 1, 1, 0.0f, 1.0f };
+	RECT rScissor = { 0, 0, 1, 1 };
+	m_pDevice->SetTexture(0, NULL);
+	m_pDevice->SetPixelShader(NULL);
+	m_pDevice->SetVertexShader(NULL);
+	m_pDevice->SetFVF(D3DFVF_GRAPHICS);
+	m_pDevice->SetStreamSource(0, NULL, 0, 0);
+	m_pDevice->SetTransform(D3DTS_WORLD, &matIdentity);
+	m_pDevice->SetTransform(D3DTS_VIEW, &matIdentity);
+	m_pDevice->SetTransform(D3DTS_PROJECTION, &matIdentity);
+	m_pDevice->SetViewport(&viewport);
+	m_pDevice->SetScissorRect(&rScissor);
+	m_pDevice->SetRenderState(D3DRS_ZENABLE, D3DZB_FALSE);
+	m_pDevice->SetRenderState(D3DRS_ZWRITEENABLE, FALSE);
+	m_pDevice->SetRenderState(D3DRS_LIGHTING, FALSE);
+	m_pDevice->SetRenderState(D3DRS_FOGENABLE, FALSE);
+	m_pDevice->SetRenderState(D3DRS_ALPHATESTENABLE, FALSE);
+	m_pDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+	m_pDevice->SetRenderState(D3DRS_FILLMODE, D3DFILL_SOLID);
+	m_pDevice->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+	m_pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+	m_pDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+	m_pDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+	m_pDevice->SetSamplerState(0, D3DSAMP_ADDRESSU, D3DTADDRESS_CLAMP);
+	m_pDevice->SetSamplerState(0, D3DSAMP_ADDRESSV, D3DTADDRESS_CLAMP);
+	m_pDevice->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_LINEAR);
+	m_pDevice->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_SELECTARG1);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_DIFFUSE);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLORARG2, D3DTA_DIFFUSE);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_DIFFUSE);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAARG2, D3DTA_DIFFUSE);
+	m_pDevice->SetTextureStageState(1, D3DTSS_COLOROP, D3DTOP_DISABLE);
+
+	IDirect3DStateBlock9 * pStateBlock = NULL;
+
+	if(FAILED(m_pDevice->EndStateBlock(&pStateBlock)))
+		return NULL;
+
+	return pStateBlock;
 }
 
-CGraphics::~CGraphics()
+IDirect3DStateBlock9 * CGraphics::CreateBatchStateBlock()
 {
+	if(FAILED(m_pDevice->BeginStateBlock()))
+		return NULL;
 
+	// Has to match the states Flush sets
+	m_pDevice->SetTexture(0, NULL);
+	m_pDevice->SetPixelShader(NULL);
+	m_pDevice->SetVertexShader(NULL);
+	m_pDevice->SetFVF(D3DFVF_GRAPHICS);
+	m_pDevice->SetStreamSource(0, NULL, 0, 0);
+	m_pDevice->SetRenderState(D3DRS_ZENABLE, D3DZB_FALSE);
+	m_pDevice->SetRenderState(D3DRS_LIGHTING, FALSE);
+	m_pDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+	m_pDevice->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+	m_pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+	m_pDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+	m_pDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_SELECTARG1);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_DIFFUSE);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_DIFFUSE);
+
+	IDirect3DStateBlock9 * pStateBlock = NULL;
+
+	if(FAILED(m_pDevice->EndStateBlock(&pStateBlock)))
+		return NULL;
+
+	return pStateBlock;
 }
 
-void CGraphics::OnLostDevice()
+void CGraphics::Begin()
 {
-	// If we have a state block release it
-	if(m_pStateBlock)
-	{
-		m_pStateBlock->Release();
-		m_pStateBlock = NULL;
-	}
+	// Save the states the overlay changes
+	if(m_pOverlayStateBlock)
+		m_pOverlayStateBlock->Capture();
 }
 
-void CGraphics::OnResetDevice()
+void CGraphics::End()
 {
-	// If we don't have a state block create one
-	if(!m_pStateBlock)
-		m_pDevice->CreateStateBlock(D3DSBT_ALL, &m_pStateBlock);
+	// Draw what is left of the batch and give the game its states back
+	Flush();
+
+	if(m_pOverlayStateBlock)
+		m_pOverlayStateBlock->Apply();
 }
 
-void CGraphics::Begin()
+void CGraphics::AddVertices(D3DPRIMITIVETYPE primitiveType, const D3DVERTEX * pVertices, unsigned int uiVertexCount, unsigned int uiPrimitiveCount)
 {
-	// If we have a state block capture the current device state
-	if(m_pStateBlock)
-		m_pStateBlock->Capture();
+	// Flush the batch if it is full
+	if((m_vertices.size() + uiVertexCount) > GRAPHICS_BATCH_MAX_VERTICES)
+		Flush();
+
+	// Can we continue the last run?
+	if(!m_runs.empty() && m_runs.back().primitiveType == primitiveType)
+		m_runs.back().uiPrimitiveCount += uiPrimitiveCount;
+	else
+	{
+		GraphicsBatchRun run;
+		run.primitiveType = primitiveType;
+		run.uiStartVertex = m_vertices.size();
+		run.uiPrimitiveCount = uiPrimitiveCount;
+		m_runs.push_back(run);
+	}
+
+	m_vertices.insert(m_vertices.end(), pVertices, (pVertices + uiVertexCount));
 }
 
-void CGraphics::End()
+void CGraphics::Flush()
 {
-	// If we have a state block apply the captured device state
-	if(m_pStateBlock)
-		m_pStateBlock->Apply();
+	// Is there anything to draw?
+	if(m_vertices.empty())
+		return;
+
+	// Copy the vertices to the vertex buffer
+	bool bUseVertexBuffer = false;
+
+	if(m_pVertexBuffer)
+	{
+		void * pData = NULL;
+
+		if(SUCCEEDED(m_pVertexBuffer->Lock(0, (m_vertices.size() * sizeof(D3DVERTEX)), &pData, D3DLOCK_DISCARD)))
+		{
+			memcpy(pData, &m_vertices[0], (m_vertices.size() * sizeof(D3DVERTEX)));
+			m_pVertexBuffer->Unlock();
+			bUseVertexBuffer = true;
+		}
+	}
+
+	// Set the state once for all primitives, the states it changes are given
+	// back afterwards for the gui text that is drawn over them
+	if(m_pBatchStateBlock)
+		m_pBatchStateBlock->Capture();
+
+	m_pDevice->SetTexture(0, NULL);
+	m_pDevice->SetPixelShader(NULL);
+	m_pDevice->SetVertexShader(NULL);
+	m_pDevice->SetFVF(D3DFVF_GRAPHICS);
+	m_pDevice->SetRenderState(D3DRS_ZENABLE, D3DZB_FALSE);
+	m_pDevice->SetRenderState(D3DRS_LIGHTING, FALSE);
+	m_pDevice->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+	m_pDevice->SetRenderState(D3DRS_SCISSORTESTENABLE, FALSE);
+	m_pDevice->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
+	m_pDevice->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_SRCALPHA);
+	m_pDevice->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLOROP, D3DTOP_SELECTARG1);
+	m_pDevice->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_DIFFUSE);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAOP, D3DTOP_SELECTARG1);
+	m_pDevice->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_DIFFUSE);
+
+	if(bUseVertexBuffer)
+		m_pDevice->SetStreamSource(0, m_pVertexBuffer, 0, sizeof(D3DVERTEX));
+
+	// Draw each run of primitives
+	for(std::vector<GraphicsBatchRun>::iterator iter = m_runs.begin(); iter != m_runs.end(); iter++)
+	{
+		if(bUseVertexBuffer)
+			m_pDevice->DrawPrimitive(iter->primitiveType, iter->uiStartVertex, iter->uiPrimitiveCount);
+		else
+			m_pDevice->DrawPrimitiveUP(iter->primitiveType, iter->uiPrimitiveCount, &m_vertices[iter->uiStartVertex], sizeof(D3DVERTEX));
+	}
+
+	if(m_pBatchStateBlock)
+		m_pBatchStateBlock->Apply();
+
+	m_vertices.clear();
+	m_runs.clear();
 }
 
 void CGraphics::DrawPixel(float fX, float fY, unsigned long ulColor)
 {
 	D3DVERTEX vertex(fX, fY, 0.0f, 1.0f, ulColor);
-
-	Begin();
-	m_pDevice->SetTexture(0, NULL);
-	m_pDevice->SetFVF(D3DFVF_XYZRHW | D3DFVF_DIFFUSE);
-	m_pDevice->DrawPrimitiveUP(D3DPT_POINTLIST, 1, &vertex, sizeof(D3DVERTEX));
-	End();
+	AddVertices(D3DPT_POINTLIST, &vertex, 1, 1);
 }
 
 void CGraphics::DrawLine(float fStartX, float fStartY, float fEndX, float fEndY, unsigned long ulColor)
@@ -114,76 +274,30 @@ void CGraphics::DrawLine(float fStartX, float fStartY, float fEndX, float fEndY,
 	D3DVERTEX vertex[2];
 	vertex[0] = D3DVERTEX(fStartX, fStartY, 0.0f, 1.0f, ulColor);
 	vertex[1] = D3DVERTEX(fEndX, fEndY, 0.0f, 1.0f, ulColor);
-
-	Begin();
-	m_pDevice->SetTexture(0, NULL);
-	m_pDevice->SetFVF(D3DFVF_XYZRHW | D3DFVF_DIFFUSE);
-	m_pDevice->DrawPrimitiveUP(D3DPT_LINELIST, 1, &vertex[0], sizeof(D3DVERTEX));
-	End();
+	AddVertices(D3DPT_LINELIST, &vertex[0], 2, 1);
 }
 
 void CGraphics::DrawBox_2(float fLeft, float fTop, float fWidth, float fHeight, DWORD dwColorBox)
 {
-	m_pSprite->Begin( D3DXSPRITE_ALPHABLEND | D3DXSPRITE_SORT_TEXTURE );
-
-	// Generate the matrix
-	D3DXMATRIX matrix;
-	D3DXMatrixTransformation2D( &matrix, NULL, 0.0f, &D3DXVECTOR2( fWidth, fHeight ), NULL, 0.0f, &D3DXVECTOR2( fLeft, fTop ) );
-
-	// Set the sprite transform
-	m_pSprite->SetTransform( &matrix );
-
-	// Draw the box
-	m_pSprite->Draw( m_pPixelTexture, NULL, NULL, NULL, dwColorBox );
-
-	// End the sprite
-	m_pSprite->End( );
+	DrawRect(fLeft, fTop, fWidth, fHeight, dwColorBox);
 }
 
 void CGraphics::DrawRect(float fX, float fY, float fWidth, float fHeight, unsigned long ulColor)
 {
-	// From Irrlicht
-	D3DVERTEX vertex[4];
+	// Two triangles so all rects can be drawn as a single triangle list
+	D3DVERTEX vertex[6];
 	vertex[0] = D3DVERTEX(fX, fY, 0.0f, 1.0f, ulColor);
 	vertex[1] = D3DVERTEX((fX + fWidth), fY, 0.0f, 1.0f, ulColor);
 	vertex[2] = D3DVERTEX((fX + fWidth), (fY + fHeight), 0.0f, 1.0f, ulColor);
-	vertex[3] = D3DVERTEX(fX, (fY + fHeight), 0.0f, 1.0f, ulColor);
-	short indices[6] = {0,1,2,0,2,3};
-
-	Begin();
-	m_pDevice->SetTexture(0, NULL);
-	m_pDevice->SetFVF(D3DFVF_XYZRHW | D3DFVF_DIFFUSE);
-	m_pDevice->DrawIndexedPrimitiveUP(D3DPT_TRIANGLELIST, 0, 4, 2, &indices[0], D3DFMT_INDEX16, &vertex[0], sizeof(D3DVERTEX));
-	//m_pDevice->Release();
-	End();
+	vertex[3] = vertex[0];
+	vertex[4] = vertex[2];
+	vertex[5] = D3DVERTEX(fX, (fY + fHeight), 0.0f, 1.0f, ulColor);
+	AddVertices(D3DPT_TRIANGLELIST, &vertex[0], 6, 2);
 }
 
 void CGraphics::DrawBox( float fLeft, float fTop, float fWidth, float fHeight, DWORD dwColour )
 {
-	GenerateTextures( &m_pTexture, dwColour );
-
-	CVertexList qV[4];
-
-	qV[0].dwColor = qV[1].dwColor = qV[2].dwColor = qV[3].dwColor = dwColour;
-	qV[0].z = qV[1].z = qV[2].z = qV[3].z = 0.0f;
-	qV[0].rhw = qV[1].rhw = qV[2].rhw = qV[3].rhw = 0.0f;
-
-	qV[0].x = fLeft;
-	qV[0].y = (fTop + fHeight);
-	qV[1].x = fLeft;
-	qV[1].y = fTop;
-	qV[2].x = (fLeft + fWidth);
-	qV[2].y = (fTop + fHeight);
-	qV[3].x = (fLeft + fWidth);
-	qV[3].y = fTop;
-
-	const DWORD D3DFVF_TL = D3DFVF_XYZRHW | D3DFVF_DIFFUSE | D3DFVF_TEX1;
-	m_pDevice->SetRenderState( D3DRS_ALPHABLENDENABLE, true );
-	m_pDevice->SetRenderState( D3DRS_DESTBLEND, D3DBLEND_INVSRCALPHA );
-	m_pDevice->SetFVF( D3DFVF_TL );
-	m_pDevice->SetTexture( 0, m_pTexture );
-	m_pDevice->DrawPrimitiveUP( D3DPT_TRIANGLESTRIP, 2, qV, sizeof( CVertexList ) );
-	m_pDevice->Release();
+	DrawRect(fLeft, fTop, fWidth, fHeight, dwColour);
 }
 
 float CGraphics::GetFontHeight( float fScale )
@@ -202,28 +316,6 @@ float CGraphics::GetFontHeight( float fScale )
 	return 0.0f;
 }
 
-void CGraphics::GenerateTextures( IDirect3DTexture9 ** pTexture, DWORD dwColour )
-{
-	// Create the texture
-	m_pDevice->CreateTexture( 8, 8, 1, 0, D3DFMT_A4R4G4B4, D3DPOOL_MANAGED, pTexture, NULL );
-
-	// Generate the colour
-	WORD colour16 = ( (WORD)((dwColour >> 28) & 0xF) << 12) |
-		(WORD)(((dwColour >> 20) & 0xF) << 8) |
-		(WORD)(((dwColour >> 12) & 0xF) << 4) |
-        (WORD)(((dwColour >> 4) & 0xF) << 0);
-
-	D3DLOCKED_RECT lockedRect;
-	(*pTexture)->LockRect( 0, &lockedRect, 0, 0 );
-
-	WORD *pDst16 = (WORD*)lockedRect.pBits;
-	for(int xy=0; xy < 8*8; xy++)
-	*pDst16++ = colour16;
-	(*pTexture)->UnlockRect(0);
-
-	m_pDevice->Release();
-}
-
 void CGraphics::GetScreenPositionFromWorldPosition(CVector3 vecWorld, CVector3 * vecScreen)
 {
 	// Get the game matrix
@@ -12,22 +12,59 @@
 #include <d3dx9.h>
 #include <Math\CVector3.h>
 
-class CVertexList
+#include <vector>
+
+// Maximum amount of vertices drawn with a single draw call, the batch is flushed once it is full
+#define GRAPHICS_BATCH_MAX_VERTICES 4096
+
+struct D3DVERTEX
 {
-public:
-    FLOAT x, y, z, rhw;
-    DWORD dwColor;
+	float fX;
+	float fY;
+	float fZ;
+	float fRHW;
+	DWORD dwColor;
+
+	D3DVERTEX()
+	{
+		fX = 0.0f;
+		fY = 0.0f;
+		fZ = 0.0f;
+		fRHW = 1.0f;
+		dwColor = 0;
+	}
+
+	D3DVERTEX(float _fX, float _fY, float _fZ, float _fRHW, DWORD _dwColor)
+	{
+		fX = _fX;
+		fY = _fY;
+		fZ = _fZ;
+		fRHW = _fRHW;
+		dwColor = _dwColor;
+	}
+};
+
+// A run of primitives of the same type in the batch
+struct GraphicsBatchRun
+{
+	D3DPRIMITIVETYPE primitiveType;
+	unsigned int     uiStartVertex;
+	unsigned int     uiPrimitiveCount;
 };
 
 class CGraphics 
 {
 private:
 	IDirect3DDevice9     * m_pDevice;
-	IDirect3DStateBlock9 * m_pStateBlock;
-	LPD3DXSPRITE		   m_pSprite;
-	IDirect3DTexture9				* m_pPixelTexture;
-	IDirect3DTexture9	 * m_pTexture;
-	void				   GenerateTextures( IDirect3DTexture9 ** pTexture, DWORD dwColour );
+	IDirect3DStateBlock9 * m_pOverlayStateBlock; // The states everything drawn over the frame changes
+	IDirect3DStateBlock9 * m_pBatchStateBlock;   // The states a flush of the batch changes
+	IDirect3DVertexBuffer9 * m_pVertexBuffer;
+	std::vector<D3DVERTEX> m_vertices; // Of the primitives drawn since the last flush
+	std::vector<GraphicsBatchRun> m_runs;
+
+	IDirect3DStateBlock9 * CreateOverlayStateBlock();
+	IDirect3DStateBlock9 * CreateBatchStateBlock();
+	void	AddVertices(D3DPRIMITIVETYPE primitiveType, const D3DVERTEX * pVertices, unsigned int uiVertexCount, unsigned int uiPrimitiveCount);
 
 public:
 	CGraphics(IDirect3DDevice9 * pDevice);
@@ -35,8 +72,16 @@ public:
 
 	void	OnLostDevice();
 	void	OnResetDevice();
+
+	// Everything drawn over the frame (the gui, chat, name tags, debug view and
+	// scripts) is drawn between these once per frame, only the states the overlay
+	// changes are saved and given back to the game afterwards
 	void	Begin();
 	void	End();
+
+	// The primitives are only drawn once the batch is flushed, this must be done
+	// before anything else is drawn over them and at the end of the frame
+	void	Flush();
 	void	DrawPixel(float fX, float fY, unsigned long ulColor);
 	void	DrawLine(float fStartX, float fStartY, float fEndX, float fEndY, unsigned long ulColor);
 	void	DrawBox_2(float fLeft, float fTop, float fWidth, float fHeight, DWORD dwColorBox);
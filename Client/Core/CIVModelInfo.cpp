@@ -12,8 +12,11 @@
 
 #include "CIVModelInfo.h"
 #include "CGame.h"
+#include "CModelManager.h"
 #include <CLogFile.h>
 
+extern CModelManager * g_pModelManager;
+
 CIVModelInfo::CIVModelInfo()
 	: m_iModelIndex(-1),
 	m_dwReferenceCount(0)
@@ -164,6 +167,10 @@ void CIVModelInfo::AddReference(bool bWaitForLoad)
 	{
 		CLogFile::Printf("Loading model %d", m_iModelIndex);
 
+		// The model isn't unused anymore
+		if(g_pModelManager)
+			g_pModelManager->OnModelUsed(m_iModelIndex);
+
 		// Load the model
 		Load(bWaitForLoad);
 	}
@@ -191,10 +198,16 @@ void CIVModelInfo::RemoveReference()
 		// Is this the last reference?
 		if(m_dwReferenceCount == 0)
 		{
-			CLogFile::Printf("Unlading model %d", m_iModelIndex);
-
-			// Unload the model
-			Unload();
+			// Let the model manager unload the model once it needs the memory
+			if(g_pModelManager)
+				g_pModelManager->OnModelUnused(m_iModelIndex);
+			else
+			{
+				CLogFile::Printf("Unlading model %d", m_iModelIndex);
+
+				// Unload the model
+				Unload();
+			}
 		}
 	}
 	else
@@ -214,7 +214,7 @@ void CInputWindow::ProcessInput()
 					// Send the command to the server
 					CBitStream bsSend;
 					bsSend.Write(String(m_szInput));
-					g_pNetworkManager->RPC(RPC_Command, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE);
+					g_pNetworkManager->RPC(RPC_Command, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_CHAT);
 				}
 			}
 		}
@@ -227,7 +227,7 @@ void CInputWindow::ProcessInput()
 			{
 				CBitStream bsSend;
 				bsSend.Write(String(m_szInput));
-				g_pNetworkManager->RPC(RPC_Chat, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE);
+				g_pNetworkManager->RPC(RPC_Chat, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_CHAT);
 			}
 		}
 
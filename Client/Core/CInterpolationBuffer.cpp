@@ -0,0 +1,121 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CInterpolationBuffer.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CInterpolationBuffer.h"
+#include <Math/CMath.h>
+
+// Returns the time from ulStart to ulEnd in ms (negative if ulEnd is before ulStart)
+inline long GetTimeDifference(unsigned long ulStart, unsigned long ulEnd)
+{
+	return (long)(ulEnd - ulStart);
+}
+
+CInterpolationBuffer::CInterpolationBuffer()
+{
+	m_uiCount = 0;
+}
+
+void CInterpolationBuffer::Add(unsigned long ulTime, const CVector3& vecPosition)
+{
+	// Drop the old snapshots after a long gap, there is nothing to interpolate between
+	if(m_uiCount > 0 && GetTimeDifference(m_snapshots[m_uiCount - 1].ulTime, ulTime) > INTERPOLATION_MAX_GAP)
+		m_uiCount = 0;
+
+	// Find the place of the snapshot, usually it is the newest one
+	unsigned int uiIndex = m_uiCount;
+
+	while(uiIndex > 0 && GetTimeDifference(ulTime, m_snapshots[uiIndex - 1].ulTime) > 0)
+		uiIndex--;
+
+	// A snapshot of the same time replaces the one we have
+	if(uiIndex > 0 && m_snapshots[uiIndex - 1].ulTime == ulTime)
+	{
+		m_snapshots[uiIndex - 1].vecPosition = vecPosition;
+		return;
+	}
+
+	// Is the buffer full? Make space by dropping the oldest snapshot
+	if(m_uiCount == INTERPOLATION_BUFFER_SIZE)
+	{
+		// Older than everything we have?
+		if(uiIndex == 0)
+			return;
+
+		for(unsigned int i = 1; i < m_uiCount; i++)
+			m_snapshots[i - 1] = m_snapshots[i];
+
+		m_uiCount--;
+		uiIndex--;
+	}
+
+	for(unsigned int i = m_uiCount; i > uiIndex; i--)
+		m_snapshots[i] = m_snapshots[i - 1];
+
+	m_snapshots[uiIndex].ulTime = ulTime;
+	m_snapshots[uiIndex].vecPosition = vecPosition;
+	m_uiCount++;
+}
+
+bool CInterpolationBuffer::GetPosition(unsigned long ulTime, CVector3& vecPosition)
+{
+	if(m_uiCount == 0)
+		return false;
+
+	// Before the oldest snapshot?
+	if(GetTimeDifference(m_snapshots[0].ulTime, ulTime) <= 0)
+	{
+		vecPosition = m_snapshots[0].vecPosition;
+		return true;
+	}
+
+	// Find the first snapshot after the time
+	unsigned int uiIndex = 1;
+
+	while(uiIndex < m_uiCount && GetTimeDifference(m_snapshots[uiIndex].ulTime, ulTime) > 0)
+		uiIndex++;
+
+	if(uiIndex < m_uiCount)
+	{
+		InterpolationSnapshot * pFrom = &m_snapshots[uiIndex - 1];
+		InterpolationSnapshot * pTo = &m_snapshots[uiIndex];
+		float fAlpha = ((float)GetTimeDifference(pFrom->ulTime, ulTime) / (float)GetTimeDifference(pFrom->ulTime, pTo->ulTime));
+		vecPosition = Math::Lerp(pFrom->vecPosition, fAlpha, pTo->vecPosition);
+
+		// The snapshots before the one we interpolate from aren't needed again
+		if(uiIndex > 1)
+		{
+			unsigned int uiDropped = (uiIndex - 1);
+
+			for(unsigned int i = uiDropped; i < m_uiCount; i++)
+				m_snapshots[i - uiDropped] = m_snapshots[i];
+
+			m_uiCount -= uiDropped;
+		}
+
+		return true;
+	}
+
+	// After the newest snapshot, carry on along the last movement for a while
+	InterpolationSnapshot * pNewest = &m_snapshots[m_uiCount - 1];
+	vecPosition = pNewest->vecPosition;
+
+	if(m_uiCount >= 2)
+	{
+		InterpolationSnapshot * pPrevious = &m_snapshots[m_uiCount - 2];
+		long lExtrapolation = GetTimeDifference(pNewest->ulTime, ulTime);
+
+		if(lExtrapolation > INTERPOLATION_MAX_EXTRAPOLATION)
+			lExtrapolation = INTERPOLATION_MAX_EXTRAPOLATION;
+
+		float fAlpha = ((float)lExtrapolation / (float)GetTimeDifference(pPrevious->ulTime, pNewest->ulTime));
+		vecPosition = (pNewest->vecPosition + ((pNewest->vecPosition - pPrevious->vecPosition) * fAlpha));
+	}
+
+	return true;
+}
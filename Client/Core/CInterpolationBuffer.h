@@ -0,0 +1,51 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CInterpolationBuffer.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <Math/CVector3.h>
+
+// Amount of snapshots buffered for each remote entity
+#define INTERPOLATION_BUFFER_SIZE 8
+
+// Time in ms the remote entities are shown behind the time of their snapshots
+#define INTERPOLATION_DELAY 100
+
+// Time in ms a position is extrapolated for at most when no newer snapshot arrived
+#define INTERPOLATION_MAX_EXTRAPOLATION 250
+
+// Time in ms between two snapshots after which the older ones are dropped
+#define INTERPOLATION_MAX_GAP 1000
+
+struct InterpolationSnapshot
+{
+	unsigned long ulTime;
+	CVector3      vecPosition;
+};
+
+// Jitter buffer of the synced positions of a remote entity, the position is
+// interpolated between the two snapshots around the time it is shown at
+class CInterpolationBuffer
+{
+private:
+	InterpolationSnapshot m_snapshots[INTERPOLATION_BUFFER_SIZE]; // Sorted by time, the oldest first
+	unsigned int          m_uiCount;
+
+public:
+	CInterpolationBuffer();
+
+	void                  Reset() { m_uiCount = 0; }
+	bool                  IsEmpty() { return (m_uiCount == 0); }
+
+	// Snapshots that arrive out of order are sorted in, ones older than the buffer are dropped
+	void                  Add(unsigned long ulTime, const CVector3& vecPosition);
+
+	// Returns false if there are no snapshots
+	bool                  GetPosition(unsigned long ulTime, CVector3& vecPosition);
+};
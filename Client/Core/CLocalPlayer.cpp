@@ -26,6 +26,8 @@
 #include "CClientScriptManager.h"
 #include "CFireManager.h"
 #include "CFileTransfer.h"
+#include "CClientRPCHandler.h"
+#include <Network/CSyncSerializer.h>
 
 extern CNetworkManager		* g_pNetworkManager;
 extern CPlayerManager		* g_pPlayerManager;
@@ -85,13 +87,22 @@ CLocalPlayer::CLocalPlayer() : CNetworkPlayer(true),
 	m_bToggleControl(true),
 	m_fSpawnAngle(0),
 	m_ulLastPureSyncTime(0),
+	m_usSyncInterval(TICK_RATE),
 	m_uiLastInterior(0),
 	m_bDisableVehicleInfo(false),
-	m_bFirstSpawn(false)
+	m_bFirstSpawn(false),
+	m_lastSyncVehicleId(INVALID_ENTITY_ID),
+	m_lastPassengerSyncVehicleId(INVALID_ENTITY_ID),
+	m_ulLastPassengerSyncTime(0),
+	m_ulLastAimSyncTime(0),
+	m_uiLastShotWeapon(0),
+	m_uiLastShotAmmo(0),
+	m_ucLastInputActions(0)
 {
 	//m_bAnimating = false;
 	
 	memset(&m_lastControlStateSent, 0, sizeof(CControlState));
+	CDeadReckoning::Reset(&m_vehicleSyncState);
 	this->SetCanBeStreamedIn(false);
 	Scripting::SetCharWillFlyThroughWindscreen(GetScriptingHandle(), false);
 	// Patch to override spawn position and let the game call HandleSpawn
@@ -196,6 +207,101 @@ void CLocalPlayer::DoDeathCheck()
 	}
 }
 
+void CLocalPlayer::DoShotCheck()
+{
+	unsigned int uiWeapon = GetCurrentWeapon();
+	unsigned int uiAmmo = GetAmmo(uiWeapon);
+	bool bShot = (uiWeapon == m_uiLastShotWeapon && uiAmmo < m_uiLastShotAmmo);
+	m_uiLastShotWeapon = uiWeapon;
+	m_uiLastShotAmmo = uiAmmo;
+
+	// A shot used up ammo while the fire key was down
+	CControlState controlState;
+	GetControlState(&controlState);
+
+	if(!bShot || !(controlState.IsFiring() || controlState.IsDoingDriveBy()))
+		return;
+
+	AimSyncData aimSyncData;
+	GetAimSyncData(&aimSyncData);
+
+	// The hit player is the one closest to where the shot ended up
+	EntityId hitPlayerId = INVALID_ENTITY_ID;
+	float fHitDistance = SHOT_HIT_RADIUS;
+
+	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	{
+		if(!g_pPlayerManager->DoesExist(i))
+			continue;
+
+		CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(i);
+
+		if(!pPlayer || pPlayer->IsLocalPlayer() || !pPlayer->IsSpawned() || !pPlayer->IsStreamedIn())
+			continue;
+
+		CVector3 vecPosition;
+		pPlayer->GetPosition(vecPosition);
+		float fDistance = (aimSyncData.vecShotTarget - vecPosition).Length();
+
+		if(fDistance <= fHitDistance)
+		{
+			hitPlayerId = i;
+			fHitDistance = fDistance;
+		}
+	}
+
+	// The server checks the hit against where the players were when we saw them
+	unsigned int uiServerTime;
+
+	if(!CClientRPCHandler::GetServerTime(uiServerTime))
+		uiServerTime = 0;
+
+	CBitStream bsSend;
+	bsSend.Write(uiServerTime);
+	bsSend.WriteCompressed(uiWeapon);
+	bsSend.WritePosition(aimSyncData.vecShotSource);
+	bsSend.WritePosition(aimSyncData.vecShotTarget);
+	bsSend.WriteCompressed(hitPlayerId);
+	g_pNetworkManager->RPC(RPC_PlayerShot, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
+}
+
+void CLocalPlayer::DoInputActionCheck()
+{
+	CControlState controlState;
+	GetControlState(&controlState);
+	unsigned char ucInputActions = controlState.GetInputActions();
+
+	if(ucInputActions == m_ucLastInputActions)
+		return;
+
+	m_ucLastInputActions = ucInputActions;
+
+	// Send the changed actions at once on their own channel, the next sync
+	// carries them as well in case this one is lost
+	CBitStream bsSend;
+	bsSend.Write(ucInputActions);
+	g_pNetworkManager->RPC(RPC_InputAction, &bsSend, PRIORITY_HIGH, RELIABILITY_UNRELIABLE_SEQUENCED, PACKET_CHANNEL_INPUT);
+}
+
+bool CLocalPlayer::IsAimSyncNeeded(const CControlState& controlState)
+{
+	// Every sync while firing, the shots themselves are sent on their own
+	if(controlState.IsFiring())
+		return true;
+
+	if(!controlState.IsAiming())
+		return false;
+
+	// Just aiming only needs the aim now and then
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastAimSyncTime) < AIM_SYNC_INTERVAL)
+		return false;
+
+	m_ulLastAimSyncTime = ulTime;
+	return true;
+}
+
 void CLocalPlayer::Pulse()
 {
 	CNetworkPlayer::Pulse();
@@ -210,6 +316,12 @@ void CLocalPlayer::Pulse()
 			// Are we not dead?
 			if(!m_bIsDead)
 			{
+				// Send the shots we fired
+				DoShotCheck();
+
+				// Send the actions that were pressed or released
+				DoInputActionCheck();
+
 				// Is a pure sync needed and are we not getting in/out of a vehicle?
 				if(IsPureSyncNeeded() && !HasVehicleEnterExit())
 				{
@@ -310,8 +422,9 @@ void CLocalPlayer::SendOnFootSync()
 	syncPacket.uHealthArmour = ((GetHealth() << 16) | GetArmour());
 
 	// Set default animation stuff
-	/*syncPacket.bAnim = false;
+	syncPacket.bAnim = false;
 
+	/*
 	// Check for anims
 	// TODO Fix animation system
 	if(m_bAnimating)
@@ -334,43 +447,27 @@ void CLocalPlayer::SendOnFootSync()
 	syncPacket.uWeaponInfo = ((uiCurrentWeapon << 20) | GetAmmo(uiCurrentWeapon));
 
 	// Write the on foot sync data to the bit stream
-	bsSend.Write((char *)&syncPacket, sizeof(OnFootSyncData));
+	CSyncSerializer::Serialize(&bsSend, syncPacket, &m_animState);
+
+	// Get our head direction if head movement is enabled
+	CVector3 vecHead;
+	bool bHasHead = (CGame::GetHeadMovement() && IsSpawned());
+
+	if(bHasHead)
+		g_pCamera->GetLookAt(vecHead);
 
 	// Check if they are aiming or firing
 	// NOTE: Do i need to sync aim for combat too?
-	if(syncPacket.controlState.IsAiming() || syncPacket.controlState.IsFiring())
-	{
-		// Write a 1 bit to say we have aim sync
-		bsSend.Write1();
+	AimSyncData aimSyncPacket;
+	bool bHasAim = IsAimSyncNeeded(syncPacket.controlState);
 
-		// Get their aim sync data
-		AimSyncData aimSyncPacket;
+	if(bHasAim)
 		GetAimSyncData(&aimSyncPacket);
 
-		// Write the aim sync data to the bit stream
-		bsSend.Write((char *)&aimSyncPacket, sizeof(AimSyncData));
-	}
-	else
-	{
-		// Write a 0 bit to say we don't have aim sync
-		bsSend.Write0();
-	}
+	// Write the head and aim fields that changed
+	CSyncSerializer::SerializeLook(&bsSend, (bHasHead ? &vecHead : NULL), (bHasAim ? &aimSyncPacket : NULL), &m_lookState);
 
 	g_pNetworkManager->RPC(RPC_OnFootSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
-
-	// Send our latest head movement if it's enabled
-	if(CGame::GetHeadMovement() && IsSpawned()) 
-	{
-		CBitStream bsHead;
-		CVector3 vecLookAt; 
-
-		g_pCamera->GetLookAt(vecLookAt);
-		bsHead.Write(vecLookAt.fX);
-		bsHead.Write(vecLookAt.fY);
-		bsHead.Write(vecLookAt.fZ);
-
-		g_pNetworkManager->RPC(RPC_HeadMovement, &bsHead, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
-	}
 }
 
 void CLocalPlayer::SendInVehicleSync()
@@ -381,6 +478,7 @@ void CLocalPlayer::SendInVehicleSync()
 	{
 		CBitStream bsSend;
 		InVehicleSyncData syncPacket;
+		memset(&syncPacket, 0, sizeof(InVehicleSyncData));
 
 		// Write the vehicle id
 		bsSend.WriteCompressed(pVehicle->GetVehicleId());
@@ -422,17 +520,7 @@ void CLocalPlayer::SendInVehicleSync()
 		// Get their lights
 		syncPacket.bLights = pVehicle->GetLightsState();
 
-		// Get vehicle deformation
-		//CVector3 vecPos;
-		//pVehicle->GetDeformation(vecPos);
-
-		// Get the door stuff
-		syncPacket.fDoor[0] = pVehicle->GetCarDoorAngle(0);
-		syncPacket.fDoor[1] = pVehicle->GetCarDoorAngle(1);
-		syncPacket.fDoor[2] = pVehicle->GetCarDoorAngle(2);
-		syncPacket.fDoor[3] = pVehicle->GetCarDoorAngle(3);
-		syncPacket.fDoor[4] = pVehicle->GetCarDoorAngle(4);
-		syncPacket.fDoor[5] = pVehicle->GetCarDoorAngle(5);
+		// The doors, windows, tyres and deformation are sent by the vehicles damage sync
 
 		// Get their health and armour
 		syncPacket.uPlayerHealthArmour = ((GetHealth() << 16) | GetArmour());
@@ -443,55 +531,39 @@ void CLocalPlayer::SendInVehicleSync()
 
 		// Get their vehicles engine status (untested)
 		syncPacket.bEngineStatus = pVehicle->GetEngineState();
-		
-		// Set default window and typres values & check them
-		for(int i = 0; i <= 5; i++)
-		{
-			if(i < 4)
-			{
-				syncPacket.bWindow[i] = false;
-				syncPacket.bTyre[i] = false;
-			}
-			else if(i > 3)
-				syncPacket.bTyre[i] = false;
-		}
 
-		
-		for(int i = 0; i <= 3; i++)
-		{
-			if(!Scripting::IsVehWindowIntact(pVehicle->GetScriptingHandle(),(Scripting::eVehicleWindow)i))
-				syncPacket.bWindow[i] = true;
-		}
+		// Skip the sync while the others can extrapolate our movement well enough and nothing else changed
+		unsigned long ulTime = SharedUtility::GetTime();
+		bool bSyncNeeded = true;
 
-		for(int i = 0; i <= 5; i++)
+		if(pVehicle->GetVehicleId() == m_lastSyncVehicleId && !syncPacket.controlState.IsDoingDriveBy() &&
+			syncPacket.controlState == m_lastInVehicleSync.controlState &&
+			!(CSyncSerializer::GetChangedFields(syncPacket, m_lastInVehicleSync) & ~INVEHICLE_SYNC_MOVEMENT))
 		{
-			if(Scripting::IsCarTyreBurst(pVehicle->GetScriptingHandle(),(Scripting::eVehicleTyre)i))
-				syncPacket.bTyre[i] = true;
+			bSyncNeeded = CDeadReckoning::IsUpdateNeeded(&m_vehicleSyncState, ulTime, syncPacket.vecPos, syncPacket.vecRotation);
 		}
 
-		// Write the in vehicle sync data to the bit stream
-		bsSend.Write((char *)&syncPacket, sizeof(InVehicleSyncData));
-
-		// Check if they are doing a drive by
-		if(syncPacket.controlState.IsDoingDriveBy())
+		if(bSyncNeeded)
 		{
-			// Write a 1 bit to say we have aim sync
-			bsSend.Write1();
+			m_lastSyncVehicleId = pVehicle->GetVehicleId();
+			memcpy(&m_lastInVehicleSync, &syncPacket, sizeof(InVehicleSyncData));
+			CDeadReckoning::SetState(&m_vehicleSyncState, ulTime, syncPacket.vecPos, syncPacket.vecRotation, syncPacket.vecMoveSpeed, syncPacket.vecTurnSpeed);
+
+			// Write the in vehicle sync data to the bit stream
+			CSyncSerializer::Serialize(&bsSend, syncPacket);
 
-			// Get their aim sync data
+			// Check if they are doing a drive by
 			AimSyncData aimSyncPacket;
-			GetAimSyncData(&aimSyncPacket);
+			bool bHasAim = syncPacket.controlState.IsDoingDriveBy();
 
-			// Write the aim sync data to the bit stream
-			bsSend.Write((char *)&aimSyncPacket, sizeof(AimSyncData));
-		}
-		else
-		{
-			// Write a 0 bit to say we don't have aim sync
-			bsSend.Write0();
-		}
+			if(bHasAim)
+				GetAimSyncData(&aimSyncPacket);
 
-		g_pNetworkManager->RPC(RPC_InVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
+			// Write the aim fields that changed
+			CSyncSerializer::SerializeLook(&bsSend, NULL, (bHasAim ? &aimSyncPacket : NULL), &m_lookState);
+
+			g_pNetworkManager->RPC(RPC_InVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
+		}
 
 		// Check if our car is dead(exploded or in water)
 		if(Scripting::IsCarDead(pVehicle->GetScriptingHandle()) || (Scripting::IsCarInWater(pVehicle->GetScriptingHandle()) && syncPacket.vecPos.fZ < -1.0f))
@@ -519,9 +591,6 @@ void CLocalPlayer::SendPassengerSync()
 		// Get our control state
 		GetControlState(&syncPacket.controlState);
 
-		// Update the last sent control state
-		memcpy(&m_lastControlStateSent, &syncPacket.controlState, sizeof(CControlState));
-
 		// Get their seat id
 		syncPacket.byteSeatId = GetVehicleSeatId();
 
@@ -532,30 +601,42 @@ void CLocalPlayer::SendPassengerSync()
 		unsigned int uCurrentWeapon = GetCurrentWeapon();
 		syncPacket.uPlayerWeaponInfo = ((uCurrentWeapon << 20) | GetAmmo(uCurrentWeapon));
 
+		// Our position comes from the vehicle so only send when something changed
+		// or we do a drive by, and now and then so the others know we're still there
+		unsigned long ulTime = SharedUtility::GetTime();
+
+		if(pVehicle->GetVehicleId() == m_lastPassengerSyncVehicleId && !syncPacket.controlState.IsDoingDriveBy() &&
+			syncPacket.controlState == m_lastPassengerSync.controlState &&
+			syncPacket.byteSeatId == m_lastPassengerSync.byteSeatId &&
+			syncPacket.uPlayerHealthArmour == m_lastPassengerSync.uPlayerHealthArmour &&
+			syncPacket.uPlayerWeaponInfo == m_lastPassengerSync.uPlayerWeaponInfo &&
+			(ulTime - m_ulLastPassengerSyncTime) < PASSENGER_SYNC_HEARTBEAT)
+		{
+			return;
+		}
+
+		m_lastPassengerSyncVehicleId = pVehicle->GetVehicleId();
+		memcpy(&m_lastPassengerSync, &syncPacket, sizeof(PassengerSyncData));
+		m_ulLastPassengerSyncTime = ulTime;
+
+		// Update the last sent control state
+		memcpy(&m_lastControlStateSent, &syncPacket.controlState, sizeof(CControlState));
+
 		// Write the passenger sync data to the bit stream
-		bsSend.Write((char *)&syncPacket, sizeof(PassengerSyncData));
+		CSyncSerializer::Serialize(&bsSend, syncPacket);
 
 		// Check if they are doing a drive by
 		// NOTE: I think certain vehicles (e.g. helicoptors) allow 3rd person
 		// shooting from them which involves the on foot aim/fire keys so add
 		// them to this check if needed
-		if(syncPacket.controlState.IsDoingDriveBy())
-		{
-			// Write a 1 bit to say we have aim sync
-			bsSend.Write1();
+		AimSyncData aimSyncPacket;
+		bool bHasAim = syncPacket.controlState.IsDoingDriveBy();
 
-			// Get their aim sync data
-			AimSyncData aimSyncPacket;
+		if(bHasAim)
 			GetAimSyncData(&aimSyncPacket);
 
-			// Write the aim sync data to the bit stream
-			bsSend.Write((char *)&aimSyncPacket, sizeof(AimSyncData));
-		}
-		else
-		{
-			// Write a 0 bit to say we don't have aim sync
-			bsSend.Write0();
-		}
+		// Write the aim fields that changed
+		CSyncSerializer::SerializeLook(&bsSend, NULL, (bHasAim ? &aimSyncPacket : NULL), &m_lookState);
 
 		g_pNetworkManager->RPC(RPC_PassengerSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
 	}
@@ -580,26 +661,17 @@ void CLocalPlayer::SendSmallSync()
 	syncPacket.uWeaponInfo = ((uCurrentWeapon << 20) | GetAmmo(uCurrentWeapon));
 
 	// Write the small key sync data to the bit stream
-	bsSend.Write((char *)&syncPacket, sizeof(SmallSyncData));
+	CSyncSerializer::Serialize(&bsSend, syncPacket);
 
 	// Check if they are aiming or firing
-	if(syncPacket.controlState.IsAiming() || syncPacket.controlState.IsFiring())
-	{
-		// Write a 1 bit to say we have aim sync
-		bsSend.Write1();
+	AimSyncData aimSyncPacket;
+	bool bHasAim = IsAimSyncNeeded(syncPacket.controlState);
 
-		// Get their aim sync data
-		AimSyncData aimSyncPacket;
+	if(bHasAim)
 		GetAimSyncData(&aimSyncPacket);
 
-		// Write the aim sync data to the bit stream
-		bsSend.Write((char *)&aimSyncPacket, sizeof(AimSyncData));
-	}
-	else
-	{
-		// Write a 0 bit to say we don't have aim sync
-		bsSend.Write0();
-	}
+	// Write the aim fields that changed
+	CSyncSerializer::SerializeLook(&bsSend, NULL, (bHasAim ? &aimSyncPacket : NULL), &m_lookState);
 
 	g_pNetworkManager->RPC(RPC_SmallSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
 }
@@ -609,8 +681,8 @@ bool CLocalPlayer::IsPureSyncNeeded()
 	// Get the current time
 	unsigned long ulCurrentTime = SharedUtility::GetTime();
 
-	// Has it been TICK_RATE or more ms since our last pure sync?
-	if(ulCurrentTime >= (m_ulLastPureSyncTime + TICK_RATE))
+	// Has it been our sync interval (set by the server, TICK_RATE by default) or more ms since our last pure sync?
+	if(ulCurrentTime >= (m_ulLastPureSyncTime + m_usSyncInterval))
 	{
 		// Update the last pure sync time
 		m_ulLastPureSyncTime = ulCurrentTime;
@@ -666,42 +738,54 @@ void CLocalPlayer::SetAnimation(const char * strGroup, const char * strAnim)
 // TODO: or just sync nearest vehicle?
 void CLocalPlayer::SendEmptyVehicleSync()
 {
-	EMPTYVEHICLESYNCPACKET syncPacket;
-	CBitStream bsSend;
-	int uiOccupants = 0;
+	if(!IsSpawned() || !g_pVehicleManager || !g_pNetworkManager->IsConnected())
+		return;
+
+	// Only the vehicles the server made us the sync owner of are synced, those we
+	// own are close to us so they are streamed in
+	EMPTYVEHICLESYNCPACKET syncPackets[EMPTY_VEHICLE_SYNC_BATCH_SIZE];
+	unsigned char ucCount = 0;
+	std::vector<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
 
-	if(IsSpawned() && g_pVehicleManager && g_pNetworkManager->IsConnected())
+	for(std::vector<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
 	{
-		for(EntityId iD = 0; iD < g_pVehicleManager->GetCount(); iD++)
+		CNetworkVehicle * pVehicle = reinterpret_cast<CNetworkVehicle *>(*iter);
+
+		if(pVehicle->IsAsleep() || !pVehicle->IsSyncOwner() || !pVehicle->IsSpawned() || pVehicle->GetDriver())
+			continue;
+
+		bool bOccupied = false;
+
+		for(BYTE i = 0; i < pVehicle->GetMaxPassengers(); i++)
 		{
-			if(g_pVehicleManager->Exists(iD))
+			// Does this passenger seat contain a passenger?
+			if(pVehicle->GetPassenger(i))
 			{
-				if(g_pVehicleManager->Get(iD)->IsSpawned() && g_pVehicleManager->Get(iD)->IsStreamedIn())
-				{
-					// Reset stuff
-					uiOccupants = 0;
-					bsSend.Reset();
-
-					for(BYTE i = 0; i < g_pVehicleManager->Get(iD)->GetMaxPassengers(); i++)
-					{
-						// Does this passenger seat contain a passenger?
-						if(g_pVehicleManager->Get(iD)->GetPassenger(i))
-						{
-							uiOccupants = 1;
-							break;
-						}
-					}
-					if(uiOccupants == 0)
-					{
-						if(g_pVehicleManager->Get(iD)->StoreEmptySync(&syncPacket)) {
-			
-							bsSend.Write((char *)&syncPacket,sizeof(EMPTYVEHICLESYNCPACKET));
-							g_pNetworkManager->RPC(RPC_EmptyVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
-						}
-					}
-				}
+				bOccupied = true;
+				break;
 			}
 		}
+
+		// Only moving vehicles (or ones whose state changed) are synced
+		if(bOccupied || !pVehicle->StoreEmptySync(&syncPackets[ucCount]))
+			continue;
+
+		if(++ucCount == EMPTY_VEHICLE_SYNC_BATCH_SIZE)
+		{
+			SendEmptyVehicleSyncBatch(syncPackets, ucCount);
+			ucCount = 0;
+		}
 	}
+
+	if(ucCount > 0)
+		SendEmptyVehicleSyncBatch(syncPackets, ucCount);
+}
+
+void CLocalPlayer::SendEmptyVehicleSyncBatch(EMPTYVEHICLESYNCPACKET * pSyncPackets, unsigned char ucCount)
+{
+	CBitStream bsSend;
+	bsSend.Write(ucCount);
+	bsSend.Write((char *)pSyncPackets, (ucCount * sizeof(EMPTYVEHICLESYNCPACKET)));
+	g_pNetworkManager->RPC(RPC_EmptyVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
 }
 			
\ No newline at end of file
@@ -14,6 +14,14 @@
 #include <winsock2.h>
 #include <windows.h>
 #include "CNetworkPlayer.h"
+#include <Network/CSyncSerializer.h>
+#include <Game/CDeadReckoning.h>
+
+// Time in ms between the aim sync of a player that aims without firing
+#define AIM_SYNC_INTERVAL 100
+
+// Time in ms between the passenger syncs of a passenger whose state doesn't change
+#define PASSENGER_SYNC_HEARTBEAT 1000
 
 class CLocalPlayer : public CNetworkPlayer
 {
@@ -23,12 +31,25 @@ private:
 	float				m_fSpawnAngle;
 	bool				m_bToggleControl;
 	unsigned long		m_ulLastPureSyncTime;
+	unsigned short		m_usSyncInterval;
 	unsigned int		m_uiLastInterior;
 	bool				m_bDisableVehicleInfo;
 	CControlState		m_lastControlStateSent;
 	bool				m_bFirstSpawn;
 	unsigned short		m_uiPing;
 	OnFootSyncData		m_oldOnFootSync;
+	EntityId			m_lastSyncVehicleId;
+	InVehicleSyncData	m_lastInVehicleSync;
+	DeadReckoningState	m_vehicleSyncState; // What the others extrapolate from our last in vehicle sync
+	EntityId			m_lastPassengerSyncVehicleId;
+	PassengerSyncData	m_lastPassengerSync;
+	unsigned long		m_ulLastPassengerSyncTime;
+	CSyncAnimState		m_animState;
+	CSyncLookState		m_lookState;
+	unsigned long		m_ulLastAimSyncTime;
+	unsigned int		m_uiLastShotWeapon;
+	unsigned int		m_uiLastShotAmmo;
+	unsigned char		m_ucLastInputActions;
 	/*bool			    m_bAnimating;
 	char*				m_strAnimGroup;
 	char*				m_strAnimSpec;*/
@@ -40,6 +61,9 @@ public:
 	void           Respawn();
 	void           HandleSpawn();
 	void           DoDeathCheck();
+	void           DoShotCheck();
+	void           DoInputActionCheck();
+	bool           IsAimSyncNeeded(const CControlState& controlState);
 	void           Pulse();
 	void           SetSpawnLocation(CVector3 vecPosition, float fHeading);
 	void           SetPlayerControlAdvanced(bool bControl, bool bCamera);
@@ -48,6 +72,8 @@ public:
 	void           SendPassengerSync();
 	void           SendSmallSync();
 	bool           IsPureSyncNeeded();
+	void           SetSyncInterval(unsigned short usSyncInterval) { m_usSyncInterval = usSyncInterval; }
+	unsigned short GetSyncInterval() { return m_usSyncInterval; }
 	bool           IsSmallSyncNeeded();
 	unsigned short GetPing();
 	void           GetSpawnPosition(CVector3 * vecPosition) { memcpy(vecPosition, &m_vecSpawnPosition, sizeof(CVector3)); }
@@ -57,6 +83,7 @@ public:
 	bool		   GetVehicleInfos() { return m_bDisableVehicleInfo; }
 	void		   SetVehicleInfos(bool bInfo) { m_bDisableVehicleInfo = bInfo; }
 	void		   SendEmptyVehicleSync();
+	void		   SendEmptyVehicleSyncBatch(EMPTYVEHICLESYNCPACKET * pSyncPackets, unsigned char ucCount);
 	bool		   GetFirstSpawn() { return m_bFirstSpawn; }
 	void		   SetPing(unsigned short uiPing) { m_uiPing = uiPing; }
 	/*void		   SetAnimation(const char * strGroup, const char * strAnim);*/
@@ -18,6 +18,7 @@
 #include <CLogFile.h>
 #include "CCredits.h"
 #include <map>
+#include <set>
 #include "CGame.h"
 //#include "CD3D9Webkit.hpp"
 
@@ -30,12 +31,12 @@ extern unsigned short    g_usPort;
 extern String            g_strHost;
 extern String            g_strNick;
 extern String            g_strPassword;
+extern String            g_strTransferToken;
 extern CCredits        * g_pCredits;
 extern bool				 g_bGameLoaded;
 //extern CD3D9WebKit     * g_pWebkit;
 
 CMainMenu                         * CMainMenu::m_pSingleton = NULL;
-std::map<String, unsigned long>     serverPingStartMap;
 extern std::vector<CEGUI::Window *> g_pGUIElements;
 
 void ResetGame();
@@ -213,6 +214,9 @@ void CMainMenu::OnConnect(String strHost, unsigned short usPort, String strPassw
 	// Set the password
 	g_strPassword = strPassword;
 
+	// A server picked from the menu is no transfer
+	g_strTransferToken.Clear();
+
 	// Ensure they have changed from the default name and we are not ignoring default name
 	if(CVAR_GET_STRING("nick") == "player" && !bIgnoreDefaultName)
 	{
@@ -269,7 +273,21 @@ bool CMainMenu::OnServerBrowserWindowRowClick(const CEGUI::EventArgs &eventArgs)
 	return true;
 }
 
-void CMainMenu::ServerQueryHandler(String strHost, unsigned short usPort, String strQuery, CBitStream * pReply)
+// Returns the server browser row of the server, -1 if there is none
+static int GetServerBrowserRow(CEGUI::MultiColumnList * pMultiColumnList, String strHostAndPort)
+{
+	for(unsigned int i = 0; i < pMultiColumnList->getRowCount(); i++)
+	{
+		CEGUI::ListboxItem * pHost = pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(i, 1));
+
+		if(pHost && !strHostAndPort.Compare(pHost->getText().c_str()))
+			return (int)i;
+	}
+
+	return -1;
+}
+
+void CMainMenu::ServerQueryHandler(String strHost, unsigned short usPort, String strQuery, CBitStream * pReply, unsigned long ulPing)
 {
 	// Read the query type
 	char cQueryType;
@@ -279,37 +297,22 @@ void CMainMenu::ServerQueryHandler(String strHost, unsigned short usPort, String
 
 	// Get the server host and port
 	String strHostAndPort("%s:%d", strHost.Get(), usPort);
+	CEGUI::MultiColumnList * pMultiColumnList = (CEGUI::MultiColumnList *)CMainMenu::GetSingleton()->m_serverBrowser.pServerMultiColumnList;
+	char szTempBuf[64];
 
 	if(cQueryType == 'p') // Ping
 	{
-		// Get the start time from the ping map
-		unsigned long ulStartTime = serverPingStartMap[strHostAndPort];
+		// Set the server ping in the multi column list
+		int iRowIndex = GetServerBrowserRow(pMultiColumnList, strHostAndPort);
 
-		// Do we have a valid start time?
-		if(ulStartTime > 0)
+		if(iRowIndex != -1)
 		{
-			// Calculate the round trip time
-			unsigned long ulPing = (SharedUtility::GetTime() - ulStartTime);
-
-			// Set the server ping in the multi column list
-			CEGUI::MultiColumnList * pMultiColumnList = (CEGUI::MultiColumnList *)CMainMenu::GetSingleton()->m_serverBrowser.pServerMultiColumnList;
+			CEGUI::ListboxItem * pPing = pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(iRowIndex, 4));
 
-			for(unsigned int i = 0; i < pMultiColumnList->getRowCount(); i++)
+			if(pPing)
 			{
-				CEGUI::ListboxItem * pHost = pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(i, 1));
-
-				if(!strHostAndPort.Compare(pHost->getText().c_str()))
-				{
-					CEGUI::ListboxItem * pPing = pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(i, 4));
-
-					if(pPing)
-					{
-						char szTempBuf[64];
-						pPing->setText(itoa(ulPing, szTempBuf, 10));
-						pMultiColumnList->invalidate();
-						break;
-					}
-				}
+				pPing->setText(itoa(ulPing, szTempBuf, 10));
+				pMultiColumnList->invalidate();
 			}
 		}
 	}
@@ -342,28 +345,37 @@ void CMainMenu::ServerQueryHandler(String strHost, unsigned short usPort, String
 		if(!pReply->Read(bPassworded))
 			return;
 
-		// Add the server to the multi column list
-		CEGUI::MultiColumnList * pMultiColumnList = (CEGUI::MultiColumnList *)CMainMenu::GetSingleton()->m_serverBrowser.pServerMultiColumnList;
-		unsigned int iRowIndex = pMultiColumnList->addRow();
-		pMultiColumnList->setItem(new ServerBrowserListItem(strHostName.Get()), 0, iRowIndex);
-		pMultiColumnList->setItem(new ServerBrowserListItem(strHostAndPort.Get()), 1, iRowIndex);
-		char szTempBuf[64];
-		pMultiColumnList->setItem(new ServerBrowserListItem("-1"), 2, iRowIndex);
-		pMultiColumnList->setItem(new ServerBrowserListItem(itoa(iMaxPlayers, szTempBuf, 10)), 3, iRowIndex);
-		pMultiColumnList->setItem(new ServerBrowserListItem("-1"), 4, iRowIndex);
-		pMultiColumnList->setItem(new ServerBrowserListItem(bPassworded ? "Yes" : "No"), 5, iRowIndex);
-		pMultiColumnList->invalidate();
+		// Add the server to the multi column list (or update it if it's in there already), the
+		// round trip of the info query is used as the ping so no extra ping query is needed
+		int iRowIndex = GetServerBrowserRow(pMultiColumnList, strHostAndPort);
 
-		// Save the current time to the ping map
-		serverPingStartMap[strHostAndPort] = SharedUtility::GetTime();
+		if(iRowIndex == -1)
+		{
+			iRowIndex = (int)pMultiColumnList->addRow();
+			pMultiColumnList->setItem(new ServerBrowserListItem(strHostName.Get()), 0, iRowIndex);
+			pMultiColumnList->setItem(new ServerBrowserListItem(strHostAndPort.Get()), 1, iRowIndex);
+			pMultiColumnList->setItem(new ServerBrowserListItem(itoa(iPlayerCount, szTempBuf, 10)), 2, iRowIndex);
+			pMultiColumnList->setItem(new ServerBrowserListItem(itoa(iMaxPlayers, szTempBuf, 10)), 3, iRowIndex);
+			pMultiColumnList->setItem(new ServerBrowserListItem(itoa(ulPing, szTempBuf, 10)), 4, iRowIndex);
+			pMultiColumnList->setItem(new ServerBrowserListItem(bPassworded ? "Yes" : "No"), 5, iRowIndex);
+		}
+		else
+		{
+			pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(iRowIndex, 0))->setText(strHostName.Get());
+			pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(iRowIndex, 2))->setText(itoa(iPlayerCount, szTempBuf, 10));
+			pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(iRowIndex, 3))->setText(itoa(iMaxPlayers, szTempBuf, 10));
+			pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(iRowIndex, 4))->setText(itoa(ulPing, szTempBuf, 10));
+			pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(iRowIndex, 5))->setText(bPassworded ? "Yes" : "No");
+		}
 
-		// Send a ping query to the server
-		CMainMenu::GetSingleton()->m_pServerQuery->Query(strHost, usPort, "p");
+		pMultiColumnList->invalidate();
 	}
 }
 
 void CMainMenu::MasterListQueryHandler(std::vector<String> serverVector)
 {
+	std::set<String> serverSet;
+
 	// Loop through all servers
 	for(std::vector<String>::iterator iter = serverVector.begin(); iter != serverVector.end(); iter++)
 	{
@@ -379,21 +391,30 @@ void CMainMenu::MasterListQueryHandler(std::vector<String> serverVector)
 		if(strIp.IsEmpty() || strPort.IsEmpty())
 			continue;
 
-		// Query the server
+		// Query the server (the queries are sent paced out and the servers are added as they reply)
 		CMainMenu::GetSingleton()->m_pServerQuery->Query(strIp, strPort.ToInteger(), "i");
+		serverSet.insert(String("%s:%d", strIp.Get(), strPort.ToInteger()));
+	}
+
+	// Remove the servers that are no longer in the list
+	CEGUI::MultiColumnList * pMultiColumnList = (CEGUI::MultiColumnList *)CMainMenu::GetSingleton()->m_serverBrowser.pServerMultiColumnList;
+
+	for(int i = ((int)pMultiColumnList->getRowCount() - 1); i >= 0; i--)
+	{
+		CEGUI::ListboxItem * pHost = pMultiColumnList->getItemAtGridReference(CEGUI::MCLGridRef(i, 1));
+
+		if(!pHost || serverSet.find(pHost->getText().c_str()) == serverSet.end())
+			pMultiColumnList->removeRow(i);
 	}
 }
 
 void CMainMenu::OnMasterListQuery(int iType)
 {
-	// Reset the server browser list
-	CEGUI::MultiColumnList * pMultiColumnList = (CEGUI::MultiColumnList *)m_serverBrowser.pServerMultiColumnList;
-	pMultiColumnList->resetList();
-
 	// Reset the master list query
 	m_pMasterListQuery->Reset();
 
-	// Reset the server query
+	// Reset the server query, the server browser list is kept and
+	// updated in place as the new list and the replies come in
 	m_pServerQuery->Reset();
 
 	// Query the master list
@@ -643,6 +664,9 @@ CMainMenu::CMainMenu()
 	// Set the master list query handler
 	m_pMasterListQuery->SetMasterListQueryHandler(MasterListQueryHandler);
 
+	// Set the master list cache path
+	m_pMasterListQuery->SetCachePath(SharedUtility::GetAbsolutePath(MASTERLIST_CACHE_FILE));
+
 	// Create the server query instance
 	m_pServerQuery = new CServerQuery();
 
@@ -1079,6 +1103,10 @@ CMainMenu::CMainMenu()
 	m_pSettingsWindowSaveButton->subscribeEvent(CEGUI::PushButton::EventClicked, CEGUI::Event::Subscriber(&CMainMenu::OnSettingsWindowSaveButtonClick, this));
 
 	OnResetDevice();
+
+	// Show the servers of the last refresh right away and query them again
+	m_pServerQuery->LoadCache(SharedUtility::GetAbsolutePath(SERVER_QUERY_CACHE_FILE));
+	m_pMasterListQuery->LoadCache();
 }
 
 CMainMenu::~CMainMenu()
@@ -1099,6 +1127,9 @@ CMainMenu::~CMainMenu()
 	if(m_pBackground)
 		g_pGUI->RemoveGUIWindow(m_pBackground);
 
+	// Save the server query replies for the next start
+	m_pServerQuery->SaveCache(SharedUtility::GetAbsolutePath(SERVER_QUERY_CACHE_FILE));
+
 	// Delete the server query instance
 	SAFE_DELETE(m_pServerQuery);
 
@@ -13,6 +13,10 @@
 #include "CMasterListQuery.h"
 #include "CServerQuery.h"
 
+// Files the server browser is cached in between starts
+#define MASTERLIST_CACHE_FILE "masterlist.cache"
+#define SERVER_QUERY_CACHE_FILE "serverquery.cache"
+
 // Custom ListboxTextItem class to automatically set the selection brush image on creation
 class ServerBrowserListItem : public CEGUI::ListboxTextItem
 {
@@ -134,7 +138,7 @@ private:
 	// Server browser window events
 	bool             OnServerBrowserWindowCloseClick(const CEGUI::EventArgs &eventArgs);
 	bool             OnServerBrowserWindowRowClick(const CEGUI::EventArgs &eventArgs);
-	static void      ServerQueryHandler(String strHost, unsigned short usPort, String strQuery, CBitStream * pReply);
+	static void      ServerQueryHandler(String strHost, unsigned short usPort, String strQuery, CBitStream * pReply, unsigned long ulPing);
 	static void      MasterListQueryHandler(std::vector<String> serverVector);
 	void             OnMasterListQuery(int iType);
 	bool             OnServerBrowserWindowRefreshButtonClick(const CEGUI::EventArgs &eventArgs);
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "CMasterListQuery.h"
+#include <stdio.h>
 #include <CLogFile.h>
 
 CMasterListQuery::CMasterListQuery(String strHost, String strVersion)
@@ -19,6 +20,7 @@ CMasterListQuery::CMasterListQuery(String strHost, String strVersion)
 	m_pHttpClient->SetHost(strHost);
 	m_strVersion = strVersion;
 	m_pfnMasterListQueryHandler = NULL;
+	m_iType = 0;
 }
 
 CMasterListQuery::~CMasterListQuery()
@@ -40,6 +42,8 @@ bool CMasterListQuery::Query(int iType)
 	else if(iType == 2)
 		strPostPath += "&category=featured";
 
+	m_iType = iType;
+
 	if(!m_pHttpClient->Get(strPostPath))
 	{
 		CLogFile::Print("FAILED TO CONTACT MASTERLIST");
@@ -49,6 +53,60 @@ bool CMasterListQuery::Query(int iType)
 		return true;
 }
 
+void CMasterListQuery::ParseServers(String * strData)
+{
+	size_t sCurrent = 0;
+	size_t sPosition = 0;
+	std::vector<String> serverVector;
+
+	while((sPosition = strData->Find('\n', sCurrent)) != String::nPos)
+	{
+		// Get the server
+		String strAddress = strData->SubStr(sCurrent, (sPosition - sCurrent));
+
+		// Add the server to the server vector
+		serverVector.push_back(strAddress);
+
+		// Set the current position
+		sCurrent = (sPosition + 1);
+	}
+
+	// Call the master list query callback (if we have one)
+	if(m_pfnMasterListQueryHandler)
+		m_pfnMasterListQueryHandler(serverVector);
+}
+
+bool CMasterListQuery::LoadCache()
+{
+	if(m_strCachePath.IsEmpty())
+		return false;
+
+	FILE * pFile = fopen(m_strCachePath, "rb");
+
+	if(!pFile)
+		return false;
+
+	// Read the cached list
+	String strData;
+	char szBuffer[1024];
+	size_t sRead;
+
+	while((sRead = fread(szBuffer, 1, sizeof(szBuffer), pFile)) > 0)
+	{
+		String strPart;
+		strPart.Set(szBuffer, sRead);
+		strData += strPart;
+	}
+
+	fclose(pFile);
+
+	if(strData.IsEmpty())
+		return false;
+
+	ParseServers(&strData);
+	return true;
+}
+
 void CMasterListQuery::Process()
 {
 	// Is the http client busy?
@@ -67,27 +125,25 @@ void CMasterListQuery::Process()
 			if(strData->IsEmpty())
 				return;
 
-			// Process received servers
-			size_t sCurrent = 0;
-			size_t sPosition = 0;
-			std::vector<String> serverVector;
-
-			while((sPosition = strData->Find('\n', sCurrent)) != String::nPos)
+			// Write the full list to the cache
+			if(m_iType == 0 && m_strCachePath.IsNotEmpty())
 			{
-				// Get the server
-				String strAddress = strData->SubStr(sCurrent, (sPosition - sCurrent));
-
-				// Add the server to the server vector
-				serverVector.push_back(strAddress);
+				FILE * pFile = fopen(m_strCachePath, "wb");
 
-				// Set the current position
-				sCurrent = (sPosition + 1);
-				CLogFile::Printf("%s",strAddress.C_String());
+				if(pFile)
+				{
+					fwrite(strData->Get(), 1, strData->GetLength(), pFile);
+					fclose(pFile);
+				}
 			}
 
-			// Call the master list query callback (if we have one)
-			if(m_pfnMasterListQueryHandler)
-				m_pfnMasterListQueryHandler(serverVector);
+			// Process received servers
+			ParseServers(strData);
+		}
+		else if(!m_pHttpClient->IsBusy())
+		{
+			// The request failed after it was started (host not found, connect failed or timed out)
+			CLogFile::Printf("FAILED TO CONTACT MASTERLIST (%s)", m_pHttpClient->GetLastErrorString().Get());
 		}
 	}
 }
@@ -21,6 +21,10 @@ private:
 	CHttpClient            * m_pHttpClient;
 	String                   m_strVersion;
 	MasterListQueryHandler_t m_pfnMasterListQueryHandler;
+	int                      m_iType;
+	String                   m_strCachePath;
+
+	void          ParseServers(String * strData);
 
 public:
 	CMasterListQuery(String strHost, String strVersion);
@@ -31,4 +35,8 @@ public:
 	bool          Query(int iType);
 	void          Process();
 	void          SetMasterListQueryHandler(MasterListQueryHandler_t pfnMasterListQueryHandler) { m_pfnMasterListQueryHandler = pfnMasterListQueryHandler; }
+
+	// The last full master list is written to the cache, loading it passes the cached list to the handler
+	void          SetCachePath(String strCachePath) { m_strCachePath = strCachePath; }
+	bool          LoadCache();
 };
@@ -10,12 +10,54 @@
 
 #pragma once
 
+#include <map>
+#include <list>
 #include "Scripting.h"
 
+// Time in ms after which a model counts as ready even if it didn't load (it is then loaded when it's used)
+#define MODEL_REQUEST_TIMEOUT 5000
+
+// Maximum amount of models that are unloaded in one frame
+#define MODEL_UNLOAD_PER_FRAME 2
+
+// Time in ms a model has to be unused before it can be unloaded
+#define MODEL_UNUSED_MIN_TIME 1000
+
 class CModelManager
 {
+private:
+	std::map<int, unsigned long> m_modelRequests; // Index of the requested models and the time they were requested at
+	std::list<int>               m_unusedModels;  // Index of the loaded models no entity uses, the least recently used first
+	std::map<int, unsigned long> m_unusedTimes;   // Index of the unused models and the time they became unused at
+	unsigned int                 m_uiModelBudget; // Amount of unused models that are kept loaded
+
+	void UnloadModel(int iModelIndex);
+
 public:
+	CModelManager();
+	~CModelManager();
+
 	// TODO: Merge player and vehicle model ids
 	DWORD VehicleIdToModelHash(int iModelId);
 	int ModelHashToVehicleId(DWORD dwModelHash);
+
+	// Requests the model from the game streaming without waiting for it to load
+	void RequestModel(int iModelIndex);
+
+	// Returns true if the model can be used without waiting for it to load, requests it if not
+	bool IsModelReady(int iModelIndex);
+
+	// Called by the model info once the last reference to a model is removed, the
+	// model stays loaded until the budget needs the memory again
+	void OnModelUnused(int iModelIndex);
+
+	// Called by the model info once a model gets its first reference
+	void OnModelUsed(int iModelIndex);
+
+	unsigned int GetUnusedModelCount() { return m_unusedModels.size(); }
+	unsigned int GetModelBudget() { return m_uiModelBudget; }
+
+	// Forgets the requests of the models that are loaded and unloads the least
+	// recently used models that are over the budget
+	void Process();
 };
@@ -35,6 +35,11 @@ CNameTags::CNameTags()
 
 	// Get the name tag font
 	m_pFont = g_pGUI->GetFont("tahoma-bold", 10);
+
+	// Every name tag is updated the first time it is drawn
+	m_uiFrame = NAMETAG_LOD_FRAMES;
+	memset(m_playerStates, 0, sizeof(m_playerStates));
+	memset(m_actorStates, 0, sizeof(m_actorStates));
 }
 
 CNameTags::~CNameTags()
@@ -42,6 +47,101 @@ CNameTags::~CNameTags()
 
 }
 
+bool CNameTags::IsVisible(const CVector3& vecWorldPosition, const CVector3& vecLocalPlayerPosition, float fMaxDistance, float& fDistance)
+{
+	// Is it not within our view range?
+	fDistance = (vecLocalPlayerPosition - vecWorldPosition).Length();
+
+	if(fDistance > fMaxDistance)
+		return false;
+
+	// Is it behind the camera or too far to the side to be on screen?
+	CVector3 vecDirection = (vecWorldPosition - vecCamPosition);
+	float fCamDistance = vecDirection.Length();
+
+	if(fCamDistance > 0.0f)
+	{
+		float fDot = ((vecDirection.fX * vecCamForward.fX) + (vecDirection.fY * vecCamForward.fY) + (vecDirection.fZ * vecCamForward.fZ));
+
+		if(fDot < (fCamDistance * NAMETAG_MIN_VIEW_COS))
+			return false;
+	}
+
+	// Check the cam position with the world position(fix desync)
+	if(((vecLookAt - vecWorldPosition).Length() * 1.35) < fDistance)
+		return false;
+
+	return true;
+}
+
+bool CNameTags::IsDue(NameTagState * pState, float fDistance)
+{
+	// Only the close name tags are updated every frame
+	if(fDistance <= NAMETAG_LOD_DISTANCE)
+		return true;
+
+	return ((m_uiFrame - pState->uiLastUpdateFrame) >= NAMETAG_LOD_FRAMES);
+}
+
+void CNameTags::UpdateState(NameTagState * pState, DWORD dwColor, float fHealth, float fArmour)
+{
+	pState->uiLastUpdateFrame = m_uiFrame;
+	pState->dwColor = dwColor;
+	pState->bArmour = (fArmour > 2.0f);
+
+	// Get the ped health (Subtract 100 as IV health is health + 100)
+	float m_fHealth = ( h_b_w * ((fHealth - 100.0f) / 100) );
+	float m_fArmour = ( h_b_w * (fArmour / 100) );
+	pState->fHealthWidth = Math::Clamp< float >( 0, (b_i_p + m_fHealth), 100 );
+	pState->fArmourWidth = Math::Clamp< float >( 0, (b_i_p + m_fArmour), 100 );
+}
+
+void CNameTags::AddVisibleTag(CGUITextLayout * pTextLayout, NameTagState * pState, const CVector3& vecWorldPosition, float fDistance, float fTextFactor)
+{
+	VisibleNameTag tag;
+	tag.pTextLayout = pTextLayout;
+	tag.pState = pState;
+
+	// Convert the position to a screen position
+	CGame::GetScreenPositionFromWorldPosition(vecWorldPosition, tag.vecScreenPosition);
+
+	// set the position to the newest
+	tag.fTextOffset = (fDistance * fTextFactor); // must be added, otherwise wrong pos
+	tag.fBoxOffset = (fDistance * 0.15f);
+	m_visibleTags.push_back(tag);
+}
+
+void CNameTags::DrawBoxes(const VisibleNameTag& tag)
+{
+	float fX = tag.vecScreenPosition.X;
+	float fY = (tag.vecScreenPosition.Y + tag.fBoxOffset);
+	float fHealthY = nt_a;
+
+	if(tag.pState->bArmour)
+	{
+		// Background
+		g_pGraphics->DrawBox_2( (fX - (b_w / 2)), (fY + nt_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
+
+		// Armour background
+		g_pGraphics->DrawBox_2( (fX - ((b_w / 2) - b_i_p)), (fY + (nt_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 180, 180, 180) );
+
+		// Armour
+		g_pGraphics->DrawBox_2( (fX - ((b_w / 2) - b_i_p)), (fY + (nt_a + b_i_p)), tag.pState->fArmourWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(225, 225, 225, 225) );
+
+		// The health goes below the armour
+		fHealthY = nt_a_a;
+	}
+
+	// Background
+	g_pGraphics->DrawBox_2( (fX - (b_w / 2)), (fY + fHealthY), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
+
+	// Health background
+	g_pGraphics->DrawBox_2( (fX - ((b_w / 2) - b_i_p)), (fY + (fHealthY + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 110, 0, 0) );
+
+	// Health
+	g_pGraphics->DrawBox_2( (fX - ((b_w / 2) - b_i_p)), (fY + (fHealthY + b_i_p)), tag.pState->fHealthWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 255, 0, 0) );
+}
+
 void CNameTags::Draw()
 {
 	// Are we not enabled?
@@ -52,307 +152,94 @@ void CNameTags::Draw()
 	if(!g_pGraphics || !g_pGraphics->GetDevice())
 		return;
 
-	if(g_pPlayerManager && g_pCamera && g_pLocalPlayer && g_pLocalPlayer->IsSpawned() && g_pGame->GetNameTags())
+	if(!g_pPlayerManager || !g_pActorManager || !g_pCamera || !g_pLocalPlayer || !g_pLocalPlayer->IsSpawned() || !g_pGame->GetNameTags())
+		return;
+
+	m_uiFrame++;
+
+	// Get the local player position
+	CVector3 vecLocalPlayerPosition;
+	g_pLocalPlayer->GetPosition(vecLocalPlayerPosition);
+
+	// Get the lookat data from camera
+	CIVCam * pGameCam = g_pCamera->GetGameCam();
+	pGameCam->GetPosition(vecCamPosition);
+	vecCamForward = pGameCam->GetCam()->m_data1.m_matMatrix.vecForward;
+	vecLookAt.fX = vecCamPosition.fX + vecCamForward.fX;
+	vecLookAt.fY = vecCamPosition.fY + vecCamForward.fY;
+	vecLookAt.fZ = vecCamPosition.fZ + vecCamForward.fZ;
+
+	// Cull the name tags first so only the visible ones are projected to the screen and drawn
+	m_visibleTags.clear();
+	CVector3 vecWorldPosition;
+	float fDistance;
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t x = 0; x < players.size(); x++)
 	{
-		// Get the local player position
-		CVector3 vecLocalPlayerPosition;
-		g_pLocalPlayer->GetPosition(vecLocalPlayerPosition);
-			
-		// Get the lookat data from camera
-		CIVCam * pGameCam = g_pCamera->GetGameCam();
-		pGameCam->GetPosition(vecCamPosition);
-		vecCamForward = pGameCam->GetCam()->m_data1.m_matMatrix.vecForward;
-		vecLookAt.fX = vecCamPosition.fX + vecCamForward.fX;
-		vecLookAt.fY = vecCamPosition.fY + vecCamForward.fY;
-		vecLookAt.fZ = vecCamPosition.fZ + vecCamForward.fZ;
-
-		CVector3 vecWorldPosition;
-		Vector2 vecScreenPosition;
-			
-		// First render gui stuff(nametags), than boxes
-		for(EntityId i = 0; i < MAX_PLAYERS; i++)
-		{
-				// Is the current player active?
-				if(g_pPlayerManager->DoesExist(i) && g_pLocalPlayer->GetPlayerId() != i)
-				{
-					CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(i);
-
-					// Get the player position + add z coord
-					pPlayer->GetPosition(vecWorldPosition);
-					vecWorldPosition.fZ += 1.15f;
-					
-					// Convert the position to a screen position
-					CGame::GetScreenPositionFromWorldPosition(vecWorldPosition, vecScreenPosition);
-
-					// Is this player not within our view range?
-					if((vecLocalPlayerPosition - vecWorldPosition).Length() > 60.0f)
-						continue;
-
-					//if(g_pGraphics)
-					//{
-					//	CVector3 vecScreen;
-					//	g_pGraphics->GetScreenPositionFromWorldPosition(vecWorldPosition, &vecScreen);
-					//	
-					//	if( vecScreen.fZ < 0 )
-					//		return;
-					//}
-					//else
-					//	return;
-
-					// Check the cam position with the world position(fix desync)
-					if(((vecLookAt - vecWorldPosition).Length() * 1.35) < ((vecLocalPlayerPosition - vecWorldPosition).Length()))
-						continue;
-					
-					// set the position to the newest
-					vecScreenPosition.Y += ( (vecLocalPlayerPosition - vecWorldPosition).Length() * 0.25f); // must be added, otherwise wrong pos
-
-					// set the name
-					String strNameTag("(%d) %s",i, pPlayer->GetName().Get());
-
-					// Get the name tag color
-					DWORD dwColor = ((pPlayer->GetColor() >> 8) | 0xFF000000);
-
-					// Draw the name tag
-					g_pGUI->DrawText(strNameTag, CEGUI::Vector2((vecScreenPosition.X - (b_w / 2)), vecScreenPosition.Y), CEGUI::colour(dwColor), m_pFont, false);
-
-				}
-			}
-		
-		// Loop through all active actors
-		for(EntityId i = 0; i < MAX_ACTORS; i++)
-		{
-			// Is the current actor active?
-			if(g_pActorManager->DoesExist(i)/* && g_pActorManager->IsNameTagEnabled(i)*/)
-			{
-				// Get the player position + add z coord
-				vecWorldPosition = g_pActorManager->GetPosition(i);
-				vecWorldPosition.fZ += 1.0f;
-					
-				// Convert the position to a screen position
-				CGame::GetScreenPositionFromWorldPosition(vecWorldPosition, vecScreenPosition);
-
-				// Is this player not within our view range?
-				if((vecLocalPlayerPosition - vecWorldPosition).Length() > 30.0f)
-					continue;
-
-				//if(g_pGraphics)
-				//{
-				//	CVector3 vecScreen;
-				//	g_pGraphics->GetScreenPositionFromWorldPosition(vecWorldPosition, &vecScreen);
-
-				//	if( vecScreen.fZ < 0 )
-				//		return;
-				//}
-				//else
-				//	return;
-
-				// Check the cam position with the world position(fix desync)
-				if(((vecLookAt - vecWorldPosition).Length() * 1.35) < ((vecLocalPlayerPosition - vecWorldPosition).Length()))
-					continue;
-
-				// set the position to the newest
-				vecScreenPosition.Y += ( (vecLocalPlayerPosition - vecWorldPosition).Length() * 0.15f); // must be added, otherwise wrong pos
-
-				// set the name
-				String strNameTag("%s", g_pActorManager->GetName(i).Get());
-
-				// Get the name tag color
-				unsigned int dwColor = ((g_pActorManager->GetNametagColor(i) >> 8) | 0xFF000000);
-
-				// Draw the name tag
-				g_pGUI->DrawText(strNameTag, CEGUI::Vector2((vecScreenPosition.X - (b_w / 2)), vecScreenPosition.Y), CEGUI::colour(dwColor), m_pFont, false);
-
-			}
-		}
-		// Now render the boxes
+		EntityId i = players[x];
+
+		// Is the current player the local player?
+		if(g_pLocalPlayer->GetPlayerId() == i)
+			continue;
+
+		CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(i);
+
+		// Get the player position + add z coord
+		pPlayer->GetPosition(vecWorldPosition);
+		vecWorldPosition.fZ += 1.15f;
 
-		// Loop through all active actors
-		for(EntityId i = 0; i < MAX_PLAYERS; i++)
+		if(!IsVisible(vecWorldPosition, vecLocalPlayerPosition, NAMETAG_PLAYER_DISTANCE, fDistance))
+			continue;
+
+		if(IsDue(&m_playerStates[i], fDistance))
 		{
-			// Is the current actor active?
-			if(g_pPlayerManager->DoesExist(i) && g_pLocalPlayer->GetPlayerId() != i)
-			{
-				CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(i);
-
-				// Get the player position + add z coord
-				pPlayer->GetPosition(vecWorldPosition);
-				vecWorldPosition.fZ += 1.15f;
-					
-				// Convert the position to a screen position
-				CGame::GetScreenPositionFromWorldPosition(vecWorldPosition, vecScreenPosition);
-
-				// Is this player not within our view range?
-				if((vecLocalPlayerPosition - vecWorldPosition).Length() > 60.0f)
-					continue;
-
-			    //if(g_pGraphics)
-				//{
-				//	CVector3 vecScreen;
-				//	g_pGraphics->GetScreenPositionFromWorldPosition(vecWorldPosition, &vecScreen);
-				//		
-				//	if( vecScreen.fZ < 0 )
-				//		return;
-				//}
-				//else
-				//	return;
-
-				// Check the cam position with the world position(fix desync)
-				if(((vecLookAt - vecWorldPosition).Length() * 1.35) < ((vecLocalPlayerPosition - vecWorldPosition).Length()))
-					continue;
-
-				// Get the ped health (Subtract 100 as IV health is health + 100)
-				float m_fHealth = ( h_b_w * ((float)(pPlayer->GetHealth() - 100.0f) / 100) );
-				float m_fArmour = ( h_b_w * ((float)(pPlayer->GetArmour()) / 100) );
-				float fHealthWidth = Math::Clamp< float >( 0, (b_i_p + m_fHealth), 100 );
-				float fArmourWidth = Math::Clamp< float >( 0, (b_i_p + m_fArmour), 100 );
-
-				// Check health and armour(otherwise if < 0 -> crash)
-				if(m_fHealth < 0)
-					m_fHealth = 0.0f;
-
-				if(m_fArmour < 0)
-					m_fArmour = 0.0f;
-
-				// set the position to the newest
-				vecScreenPosition.Y += ( (vecLocalPlayerPosition - vecWorldPosition).Length() * 0.15f); // must be added, otherwise wrong pos
-
-				// Draw boxes
-				if(pPlayer->GetArmour() > 2.0)
-				{
-					// Background
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - (b_w / 2)), (vecScreenPosition.Y + nt_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
-
-					// Armour background
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 180, 180, 180) );
-
-					// Armour
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), fArmourWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(225, 225, 225, 225) );
-
-					// Background
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - (b_w / 2)), (vecScreenPosition.Y + nt_a_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
-
-					// Health background
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 110, 0, 0) );
-
-					// Health
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a_a + b_i_p)), fHealthWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 255, 0, 0) );
-				}
-				else
-				{
-					// Background
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - (b_w / 2)), (vecScreenPosition.Y + nt_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
-
-					// Health background
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 110, 0, 0) );
-
-					// Health
-					g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), fHealthWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 255, 0, 0) );
-					
-				}
-			}
+			// set the name
+			m_playerTextLayouts[i].Set(String("(%d) %s", i, pPlayer->GetName().Get()), m_pFont, false);
+			UpdateState(&m_playerStates[i], ((pPlayer->GetColor() >> 8) | 0xFF000000), (float)pPlayer->GetHealth(), (float)pPlayer->GetArmour());
 		}
+
+		AddVisibleTag(&m_playerTextLayouts[i], &m_playerStates[i], vecWorldPosition, fDistance, 0.25f);
 	}
-	if(g_pActorManager)
+
+	for(EntityId i = 0; i < MAX_ACTORS; i++)
 	{
-		if(g_pGame->GetNameTags())
+		// Is the current actor active?
+		if(!g_pActorManager->DoesExist(i)/* || !g_pActorManager->IsNameTagEnabled(i)*/)
+			continue;
+
+		// Get the actor position + add z coord
+		vecWorldPosition = g_pActorManager->GetPosition(i);
+		vecWorldPosition.fZ += 1.0f;
+
+		if(!IsVisible(vecWorldPosition, vecLocalPlayerPosition, NAMETAG_ACTOR_DISTANCE, fDistance))
+			continue;
+
+		if(IsDue(&m_actorStates[i], fDistance))
 		{
-			// Get the local player position
-			CVector3 vecLocalPlayerPosition;
-			g_pLocalPlayer->GetPosition(vecLocalPlayerPosition);
-			
-			// Get the lookat data from camera
-			CIVCam * pGameCam = g_pCamera->GetGameCam();
-			pGameCam->GetPosition(vecCamPosition);
-			vecCamForward = pGameCam->GetCam()->m_data1.m_matMatrix.vecForward;
-			vecLookAt.fX = vecCamPosition.fX + vecCamForward.fX;
-			vecLookAt.fY = vecCamPosition.fY + vecCamForward.fY;
-			vecLookAt.fZ = vecCamPosition.fZ + vecCamForward.fZ;
-
-			CVector3 vecWorldPosition;
-			Vector2 vecScreenPosition;
-
-			// Loop through all active actors
-			for(EntityId i = 0; i < MAX_ACTORS; i++)
-			{
-				// Is the current actor active?
-				if(g_pActorManager->DoesExist(i)/* && g_pActorManager->IsNameTagEnabled(i)*/)
-				{
-					// Get the player position + add z coord
-					vecWorldPosition = g_pActorManager->GetPosition(i);
-					vecWorldPosition.fZ += 1.0f;
-					
-					// Convert the position to a screen position
-					CGame::GetScreenPositionFromWorldPosition(vecWorldPosition, vecScreenPosition);
-
-					// Is this player not within our view range?
-					if((vecLocalPlayerPosition - vecWorldPosition).Length() > 30.0f)
-						continue;
-
-					//if(g_pGraphics)
-					//{
-					//	CVector3 vecScreen;
-					//	g_pGraphics->GetScreenPositionFromWorldPosition(vecWorldPosition, &vecScreen);
-					//	
-					//	if( vecScreen.fZ < 0 )
-					//		return;
-					//}
-					//else
-					//	return;
-
-					// Check the cam position with the world position(fix desync)
-					if(((vecLookAt - vecWorldPosition).Length() * 1.35) < ((vecLocalPlayerPosition - vecWorldPosition).Length()))
-						continue;
-
-					// Get the ped health (Subtract 100 as IV health is health + 100)
-					float m_fHealth = ( h_b_w * ((float)(g_pActorManager->GetHealth(i) - 100.0f) / 100) );
-					float m_fArmour = ( h_b_w * ((float)g_pActorManager->GetArmour(i) / 100) );
-					float fHealthWidth = Math::Clamp< float >( 0, (b_i_p + m_fHealth), 100 );
-					float fArmourWidth = Math::Clamp< float >( 0, (b_i_p + m_fArmour), 100 );
-
-					// Check health and armour(otherwise if < 0 -> crash)
-					if(m_fHealth < 0)
-						m_fHealth = 0.0f;
-
-					if(m_fArmour < 0)
-						m_fArmour = 0.0f;
-
-					// set the position to the newest
-					vecScreenPosition.Y += ( (vecLocalPlayerPosition - vecWorldPosition).Length() * 0.15f); // must be added, otherwise wrong pos
-
-					if(g_pActorManager->GetArmour(i) > 2.0)
-					{
-						// Background
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - (b_w / 2)), (vecScreenPosition.Y + nt_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
-
-						// Armour background
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 180, 180, 180) );
-
-						// Armour
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), fArmourWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(225, 225, 225, 225) );
-
-						// Background
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - (b_w / 2)), (vecScreenPosition.Y + nt_a_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
-
-						// Health background
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 110, 0, 0) );
-
-						// Health
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a_a + b_i_p)), fHealthWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 255, 0, 0) );
-					}
-					else
-					{
-						// Background
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - (b_w / 2)), (vecScreenPosition.Y + nt_a), b_w, b_h, D3DCOLOR_ARGB(120, 0, 0, 0) );
-
-						// Health background
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), (b_w - (b_i_p * 2)), (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 110, 0, 0) );
-
-						// Health
-						g_pGraphics->DrawBox_2( (vecScreenPosition.X - ((b_w / 2) - b_i_p)), (vecScreenPosition.Y + (nt_a + b_i_p)), fHealthWidth, (b_h - (b_i_p * 2)), D3DCOLOR_ARGB(180, 255, 0, 0) );
-					
-					}
-				}
-			}
+			// set the name
+			m_actorTextLayouts[i].Set(g_pActorManager->GetName(i), m_pFont, false);
+			UpdateState(&m_actorStates[i], ((g_pActorManager->GetNametagColor(i) >> 8) | 0xFF000000), g_pActorManager->GetHealth(i), g_pActorManager->GetArmour(i));
 		}
+
+		AddVisibleTag(&m_actorTextLayouts[i], &m_actorStates[i], vecWorldPosition, fDistance, 0.15f);
 	}
+
+	if(m_visibleTags.empty())
+		return;
+
+	// First render gui stuff(nametags), than boxes
+	g_pGUI->BeginTextBatch();
+
+	for(std::vector<VisibleNameTag>::iterator iter = m_visibleTags.begin(); iter != m_visibleTags.end(); ++iter)
+	{
+		CEGUI::Vector2 vecTextPosition(((*iter).vecScreenPosition.X - (b_w / 2)), ((*iter).vecScreenPosition.Y + (*iter).fTextOffset));
+		g_pGUI->AddTextToBatch((*iter).pTextLayout, vecTextPosition, CEGUI::colour((*iter).pState->dwColor), false);
+	}
+
+	g_pGUI->DrawTextBatch();
+
+	// Now render the boxes
+	for(size_t i = 0; i < m_visibleTags.size(); i++)
+		DrawBoxes(m_visibleTags[i]);
 }
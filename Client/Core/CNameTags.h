@@ -10,7 +10,40 @@
 #pragma once
 
 #include "CGUI.h"
+#include <vector>
 #include <Math\CVector3.h>
+#include <Common.h>
+
+// Distance up to which the name tags of players and actors are drawn
+#define NAMETAG_PLAYER_DISTANCE 60.0f
+#define NAMETAG_ACTOR_DISTANCE 30.0f
+
+// Name tags further away than this only update their text and health bars every few frames
+#define NAMETAG_LOD_DISTANCE 25.0f
+#define NAMETAG_LOD_FRAMES 4
+
+// Cosine of the angle from the camera direction beyond which a name tag is off screen
+#define NAMETAG_MIN_VIEW_COS 0.5f
+
+// What a name tag shows, only updated when it is due
+struct NameTagState
+{
+	unsigned int uiLastUpdateFrame;
+	DWORD        dwColor;
+	bool         bArmour;
+	float        fHealthWidth;
+	float        fArmourWidth;
+};
+
+// A name tag that passed the culling in this frame
+struct VisibleNameTag
+{
+	CGUITextLayout * pTextLayout;
+	NameTagState   * pState;
+	Vector2          vecScreenPosition;
+	float            fTextOffset; // Of the text from the screen position
+	float            fBoxOffset;  // Of the health bars from the screen position
+};
 
 class CNameTags
 {
@@ -20,6 +53,20 @@ private:
 	CVector3	  vecCamPosition;
 	CVector3	  vecCamForward;
 	CVector3	  vecLookAt;
+	unsigned int  m_uiFrame;
+	// Only laid out again when the name changes
+	CGUITextLayout m_playerTextLayouts[MAX_PLAYERS];
+	CGUITextLayout m_actorTextLayouts[MAX_ACTORS];
+	NameTagState   m_playerStates[MAX_PLAYERS];
+	NameTagState   m_actorStates[MAX_ACTORS];
+	std::vector<VisibleNameTag> m_visibleTags; // Kept around and reused for every frame
+
+	// Returns false if the position is too far away or outside of the camera view
+	bool IsVisible(const CVector3& vecWorldPosition, const CVector3& vecLocalPlayerPosition, float fMaxDistance, float& fDistance);
+	bool IsDue(NameTagState * pState, float fDistance);
+	void UpdateState(NameTagState * pState, DWORD dwColor, float fHealth, float fArmour);
+	void AddVisibleTag(CGUITextLayout * pTextLayout, NameTagState * pState, const CVector3& vecWorldPosition, float fDistance, float fTextFactor);
+	void DrawBoxes(const VisibleNameTag& tag);
 
 public:
 	CNameTags();
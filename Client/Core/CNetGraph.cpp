@@ -0,0 +1,84 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CNetGraph.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "CNetGraph.h"
+#include <SharedUtility.h>
+
+// Sorts the rpcs by their bytes per second, the most first
+struct NetGraphRow
+{
+	RPCIdentifier rpcId;
+	unsigned int  uiBytesIn;
+	unsigned int  uiBytesOut;
+
+	bool operator < (const NetGraphRow& row) const { return ((uiBytesIn + uiBytesOut) > (row.uiBytesIn + row.uiBytesOut)); }
+};
+
+CNetGraph::CNetGraph()
+{
+	memset(m_uiBytesIn, 0, sizeof(m_uiBytesIn));
+	memset(m_uiBytesOut, 0, sizeof(m_uiBytesOut));
+	memset(m_uiLastBytesIn, 0, sizeof(m_uiLastBytesIn));
+	memset(m_uiLastBytesOut, 0, sizeof(m_uiLastBytesOut));
+	m_ulSecondStartTime = SharedUtility::GetTime();
+}
+
+void CNetGraph::Update()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulSecondStartTime) < 1000)
+		return;
+
+	// A second without any rpcs shows as nothing
+	bool bMissedSecond = ((ulTime - m_ulSecondStartTime) >= 2000);
+
+	for(int i = 0; i < NET_GRAPH_MAX_RPCS; i++)
+	{
+		m_uiLastBytesIn[i] = (bMissedSecond ? 0 : m_uiBytesIn[i]);
+		m_uiLastBytesOut[i] = (bMissedSecond ? 0 : m_uiBytesOut[i]);
+	}
+
+	memset(m_uiBytesIn, 0, sizeof(m_uiBytesIn));
+	memset(m_uiBytesOut, 0, sizeof(m_uiBytesOut));
+	m_ulSecondStartTime = ulTime;
+}
+
+String CNetGraph::GetText()
+{
+	Update();
+	std::vector<NetGraphRow> rows;
+	unsigned int uiTotalIn = 0;
+	unsigned int uiTotalOut = 0;
+
+	for(int i = 0; i < NET_GRAPH_MAX_RPCS; i++)
+	{
+		if(m_uiLastBytesIn[i] == 0 && m_uiLastBytesOut[i] == 0)
+			continue;
+
+		NetGraphRow row;
+		row.rpcId = (RPCIdentifier)i;
+		row.uiBytesIn = m_uiLastBytesIn[i];
+		row.uiBytesOut = m_uiLastBytesOut[i];
+		rows.push_back(row);
+		uiTotalIn += row.uiBytesIn;
+		uiTotalOut += row.uiBytesOut;
+	}
+
+	std::sort(rows.begin(), rows.end());
+	String strText("RPC bytes per second (In/Out): %d/%d\n", uiTotalIn, uiTotalOut);
+
+	for(unsigned int i = 0; i < rows.size() && i < NET_GRAPH_MAX_ROWS; i++)
+		strText.AppendF("  RPC %d: %d/%d\n", rows[i].rpcId, rows[i].uiBytesIn, rows[i].uiBytesOut);
+
+	return strText;
+}
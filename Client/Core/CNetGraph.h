@@ -0,0 +1,40 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CNetGraph.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <CString.h>
+#include <Network/RPCIdentifiers.h>
+
+// Amount of rpc ids the graph counts
+#define NET_GRAPH_MAX_RPCS 256
+
+// Amount of rpcs listed in the overlay, the ones with the most bytes per second
+#define NET_GRAPH_MAX_ROWS 12
+
+// Counts the bytes each rpc sends and receives and shows them per second in
+// the network statistics overlay (F4)
+class CNetGraph
+{
+private:
+	unsigned int  m_uiBytesIn[NET_GRAPH_MAX_RPCS];  // Of the current second
+	unsigned int  m_uiBytesOut[NET_GRAPH_MAX_RPCS];
+	unsigned int  m_uiLastBytesIn[NET_GRAPH_MAX_RPCS]; // Of the last full second
+	unsigned int  m_uiLastBytesOut[NET_GRAPH_MAX_RPCS];
+	unsigned long m_ulSecondStartTime;
+
+	void          Update();
+
+public:
+	CNetGraph();
+
+	void          OnRPCReceived(RPCIdentifier rpcId, unsigned int uiBytes) { Update(); m_uiBytesIn[rpcId] += uiBytes; }
+	void          OnRPCSent(RPCIdentifier rpcId, unsigned int uiBytes) { Update(); m_uiBytesOut[rpcId] += uiBytes; }
+	String        GetText();
+};
@@ -18,11 +18,16 @@
 #include "CCheckpointManager.h"
 #include "CLocalPlayer.h"
 #include "CStreamer.h"
+#include "CModelManager.h"
 #include "Scripting/CScriptTimerManager.h"
+#include "Scripting/CScriptingManager.h"
 #include <Network/CNetworkModule.h>
+#include <Network/PacketIdentifiers.h>
 #include "CFileTransfer.h"
 #include "CAudio.h"
 #include "CActorManager.h"
+#include "CFrameProfiler.h"
+#include <CSettings.h>
 
 extern String g_strNick;
 extern CLocalPlayer * g_pLocalPlayer;
@@ -34,7 +39,9 @@ extern CBlipManager * g_pBlipManager;
 extern CActorManager * g_pActorManager;
 extern CCheckpointManager * g_pCheckpointManager;
 extern CStreamer * g_pStreamer;
+extern CModelManager * g_pModelManager;
 extern CScriptTimerManager * g_pScriptTimerManager;
+extern CScriptingManager * g_pScriptingManager;
 extern CNetworkManager * g_pNetworkManager;
 extern CFileTransfer * g_pFileTransfer;
 extern CActorManager * g_pActorManager;
@@ -62,6 +69,11 @@ CNetworkManager::CNetworkManager()
 	// Set the net client packet handler function
 	m_pNetClient->SetPacketHandler(PacketHandler);
 
+	// Receive on the network thread and spread the handling of large bursts
+	// of packets (e.g. joining a full server) across frames
+	m_pNetClient->SetNetworkThreadEnabled(CVAR_GET_BOOL("networkthread"));
+	m_pNetClient->SetProcessTimeLimit(CVAR_GET_INTEGER("networkprocesstime"));
+
 	g_pChatWindow->AddInfoMessage(VERSION_IDENTIFIER_2 " Initialized");
 }
 
@@ -113,6 +125,11 @@ void CNetworkManager::PacketHandler(CPacket * pPacket)
 	CNetworkManager * pNetworkManager = g_pNetworkManager;
 	if(!g_pNetworkManager)
 		return;
+
+	// Count the rpc (the rpc id is the first byte, the packet id isn't part of the data)
+	if(pPacket->packetId == PACKET_RPC && pPacket->uiLength >= 1)
+		pNetworkManager->m_netGraph.OnRPCReceived(pPacket->ucData[0], (pPacket->uiLength + 1));
+
 	// Pass it to the packet handler, if that doesn't handle it, pass it to the rpc handler
 	if(!pNetworkManager->m_pClientPacketHandler->HandlePacket(pPacket) && !pNetworkManager->m_pClientRPCHandler->HandlePacket(pPacket))
 		CLogFile::PrintDebugf("Warning: Unhandled packet (Id: %d)\n", pPacket->packetId);
@@ -148,9 +165,20 @@ void CNetworkManager::Process()
 	// Are we connected to a server?
 	if(m_pNetClient->IsConnected())
 	{
+		// If our model manager exists, process it
+		if(g_pModelManager)
+			g_pModelManager->Process();
+
 		// If our streamer exists, process it
 		if(g_pStreamer)
+		{
+			CFrameProfilerScope profilerScope(FRAME_PROFILER_STREAMER);
 			g_pStreamer->Pulse();
+		}
+
+		// Resume the script coroutines whose wait is over
+		if(g_pScriptingManager)
+			g_pScriptingManager->ProcessCoroutines();
 
 		// Is our script timer manager exists, process it
 		if(g_pScriptTimerManager)
@@ -170,6 +198,11 @@ void CNetworkManager::Process()
 
 		if(g_pObjectManager)
 			g_pObjectManager->Process();
+
+		// If our blip manager exists process it
+		if(g_pBlipManager)
+			g_pBlipManager->Process();
+
 		// Process the audio manager
 		CAudioManager::Process();
 
@@ -183,6 +216,9 @@ void CNetworkManager::Connect()
 	// Are we not already connected?
 	if(!IsConnected())
 	{
+		// The event name ids are per connection
+		m_eventNames.Reset();
+
 		// Start the net client connection process
 		eConnectionAttemptResult connectionAttemptResult = m_pNetClient->Connect();
 
@@ -238,5 +274,21 @@ void CNetworkManager::Disconnect()
 
 void CNetworkManager::RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel)
 {
+	m_netGraph.OnRPCSent(rpcId, (2 + (pBitStream ? pBitStream->GetNumberOfBytesUsed() : 0)));
 	m_pNetClient->RPC(rpcId, pBitStream, priority, reliability, cOrderingChannel);
 }
+
+void CNetworkManager::EventRPC(const String& strName, CSquirrelArguments * pArguments)
+{
+	// The server is the only peer of the client
+	EventNameId nameId = m_eventNames.GetId(strName);
+	CBitStream bsDefinition;
+
+	if(m_eventNames.WriteDefinition(0, nameId, &bsDefinition))
+		RPC(RPC_ScriptingEventName, &bsDefinition, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_SCRIPT);
+
+	CBitStream bsSend;
+	m_eventNames.WriteEvent(nameId, strName, &bsSend);
+	pArguments->serialize(&bsSend);
+	RPC(RPC_ScriptingEventCall, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_SCRIPT);
+}
@@ -13,6 +13,8 @@
 #include <Network/CNetClientInterface.h>
 #include "CClientPacketHandler.h"
 #include "CClientRPCHandler.h"
+#include <Network/CEventNameTable.h>
+#include "CNetGraph.h"
 
 enum eNetState
 {
@@ -29,6 +31,8 @@ private:
 	CNetClientInterface  * m_pNetClient;
 	CClientPacketHandler * m_pClientPacketHandler;
 	CClientRPCHandler    * m_pClientRPCHandler;
+	CEventNameTable        m_eventNames;
+	CNetGraph              m_netGraph;
 	String                 m_sHostName;
 	bool                   m_bJoinedServer;
 	bool                   m_bJoinedGame;
@@ -39,6 +43,8 @@ public:
 	~CNetworkManager();
 
 	CNetClientInterface * GetNetClient() { return m_pNetClient; }
+	CClientRPCHandler   * GetRPCHandler() { return m_pClientRPCHandler; }
+	CNetGraph           * GetNetGraph() { return &m_netGraph; }
 	String                GetHostName() { return m_sHostName; };
 	void                  SetHostName(String sHostName) { m_sHostName = sHostName; };
 	void				  SetMaxPlayers(int iPlayers) { m_iMaxPlayers = iPlayers; };
@@ -52,4 +58,8 @@ public:
 	bool                  IsConnected();
 	void                  Disconnect();
 	void                  RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+
+	// Sends a script event to the server, the definition of its name is sent first if the server doesn't have it yet
+	void                  EventRPC(const String& strName, CSquirrelArguments * pArguments);
+	CEventNameTable     * GetEventNames() { return &m_eventNames; }
 };
@@ -22,6 +22,7 @@
 #include "CCamera.h"
 #include "CModelManager.h"
 #include "CChatWindow.h"
+#include <Scripting/CScriptingManager.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CVehicleManager * g_pVehicleManager;
@@ -32,6 +33,7 @@ extern CStreamer       * g_pStreamer;
 extern CModelManager   * g_pModelManager;
 extern bool              m_bControlsDisabled;
 extern CChatWindow     * g_pChatWindow;
+extern CScriptingManager * g_pScriptingManager;
 
 #define THIS_CHECK if(!this) { CLogFile::Printf("this error"); return; }
 #define THIS_CHECK_R(x) if(!this) { CLogFile::Printf("this error"); return x; }
@@ -103,6 +105,10 @@ CNetworkPlayer::CNetworkPlayer(bool bIsLocalPlayer)
 
 CNetworkPlayer::~CNetworkPlayer()
 {
+	// The scripts keep the name under the address of the player
+	if(g_pScriptingManager)
+		g_pScriptingManager->InvalidateCachedString(this);
+
 	// Destroy ourselves
 	OnDelete();
 	Destroy();
@@ -116,9 +122,30 @@ bool CNetworkPlayer::Create()
 	if(IsSpawned() || IsLocalPlayer())
 		return false;
 
-	// Find a free player number
+	// Use a hidden ped of our model if the pool has one
+	PooledPlayerPed pooledPed;
+
+	if(g_pPlayerManager && g_pPlayerManager->GetPedPool()->Take(m_pModelInfo->GetIndex(), pooledPed))
+	{
+		// The ped keeps its model info reference
+		m_byteGamePlayerNumber = pooledPed.bytePlayerNumber;
+		m_pPlayerInfo = pooledPed.pPlayerInfo;
+		m_pContextData = pooledPed.pContextData;
+		m_pPlayerPed = pooledPed.pPlayerPed;
+		g_pPlayerManager->SetGamePed(m_playerId, NULL, m_pPlayerPed->GetPed());
+
+		// Add to world
+		m_pPlayerPed->AddToWorld();
+		OnCreate();
+		return true;
+	}
+
+	// Find a free player number, the hidden peds give theirs up if there is none
 	m_byteGamePlayerNumber = (BYTE)CGame::GetPools()->FindFreePlayerInfoIndex();
 
+	while(m_byteGamePlayerNumber == INVALID_PLAYER_PED && g_pPlayerManager && g_pPlayerManager->GetPedPool()->DestroyOldest())
+		m_byteGamePlayerNumber = (BYTE)CGame::GetPools()->FindFreePlayerInfoIndex();
+
 	// Invalid player number?
 	if(m_byteGamePlayerNumber == INVALID_PLAYER_PED)
 		return false;
@@ -210,6 +237,7 @@ bool CNetworkPlayer::Create()
 
 	// Create player ped instance
 	m_pPlayerPed = new CIVPlayerPed(pPlayerPed);
+	g_pPlayerManager->SetGamePed(m_playerId, NULL, m_pPlayerPed->GetPed());
 
 	// Set the context data player ped pointer
 	m_pContextData->SetPlayerPed(m_pPlayerPed);
@@ -217,10 +245,6 @@ bool CNetworkPlayer::Create()
 	// Add to world
 	m_pPlayerPed->AddToWorld();
 
-	// Delete player helemt
-	m_bHelmet = false;
-	SetHelmet(m_bHelmet);
-
 	// End new creation code
 #if 0
 	// Save local player id
@@ -272,6 +296,16 @@ bool CNetworkPlayer::Create()
 	CGame::GetPools()->SetPlayerInfoAtIndex(m_byteGamePlayerNumber, m_pPlayerInfo->GetPlayerInfo());
 #endif
 
+	OnCreate();
+	return true;
+}
+
+void CNetworkPlayer::OnCreate()
+{
+	// Delete player helemt
+	m_bHelmet = false;
+	SetHelmet(m_bHelmet);
+
 	// Flag as spawned
 	m_bSpawned = true;
 
@@ -288,7 +322,6 @@ bool CNetworkPlayer::Create()
 	ResetInterpolation();
 	this->m_bIsStreamedIn = true;
 	//CLogFile::Printf("Done: PlayerNumber: %d, ScriptingHandle: %d", m_byteGamePlayerNumber, GetScriptingHandle());
-	return true;
 }
 
 void CNetworkPlayer::Init()
@@ -301,76 +334,35 @@ void CNetworkPlayer::Init()
 void CNetworkPlayer::Destroy()
 {
 	THIS_CHECK
-	// Are we not the local player?
-	if(!IsLocalPlayer())
+	// Are we a spawned remote player?
+	if(!IsLocalPlayer() && IsSpawned())
 	{
-		// Are we spawned?
-		if(IsSpawned())
-		{
-			// Remove from world
-			/*CGame::RemoveEntityFromWorld(m_pPlayerPed->GetEntity());
-
-			// Call destructor
-			DWORD dwFunc = m_pPlayerPed->GetEntity()->m_VFTable->ScalarDeletingDestructor;
-			IVPed * pPlayerPed = m_pPlayerPed->GetPed();
-			_asm
-			{
-				push 1
-				mov ecx, pPlayerPed
-				call dwFunc
-			}
-
-			// Remove our model info reference
-			m_pModelInfo->RemoveReference();
-
-			// Delete our player ped instance
-			SAFE_DELETE(m_pPlayerPed);
-
-			// Delete our player info instance
-			SAFE_DELETE(m_pPlayerInfo);
-
-			// Do we have a valid player number?
-			if(m_byteGamePlayerNumber != INVALID_PLAYER_PED)
-			{
-				// Reset game player info pointer
-				CGame::GetPools()->SetPlayerInfoAtIndex((unsigned int)m_byteGamePlayerNumber, NULL);
-
-				// Invalidate the player number
-				m_byteGamePlayerNumber = INVALID_PLAYER_PED;
-			}*/
-			// Get the player ped pointer
-			IVPlayerPed * pPlayerPed = m_pPlayerPed->GetPlayerPed();
-
-			IVPedIntelligence * pPedIntelligence = pPlayerPed->m_pPedIntelligence;
-	#define FUNC_ShutdownPedIntelligence 0x9C4DF0
-			DWORD dwFunc = (CGame::GetBase() + FUNC_ShutdownPedIntelligence);
-			_asm
-			{
-				push 0
-				mov ecx, pPedIntelligence
-				call dwFunc
-			}
+		// The player manager doesn't index our ped anymore
+		if(g_pPlayerManager)
+			g_pPlayerManager->SetGamePed(m_playerId, m_pPlayerPed->GetPed(), NULL);
 
-			*(DWORD *)(pPlayerPed + 0x260) &= 0xFFFFFFFE;
+		PooledPlayerPed pooledPed;
+		pooledPed.bytePlayerNumber = (BYTE)m_byteGamePlayerNumber;
+		pooledPed.pPlayerInfo = m_pPlayerInfo;
+		pooledPed.pContextData = m_pContextData;
+		pooledPed.pPlayerPed = m_pPlayerPed;
+		pooledPed.pModelInfo = m_pModelInfo;
 
-			// Remove the player ped from the world
+		// Hide the ped for the next spawn with our model instead of deleting it
+		if(!g_pPlayerManager || !g_pPlayerManager->GetPedPool()->Add(pooledPed))
+		{
 			m_pPlayerPed->RemoveFromWorld();
-
-			// Delete the player ped
-			// We use the CPed destructor and not the CPlayerPed destructor because the CPlayerPed destructor
-			// messes with our player info (which we handle manually)
-			//dwFunc = m_pPlayerPed->GetPlayerPed()->m_VFTable->ScalarDeletingDestructor;
-	#define FUNC_CPed__ScalarDeletingDestructor 0x8ACAC0
-			dwFunc = (CGame::GetBase() + FUNC_CPed__ScalarDeletingDestructor);
-			_asm
-			{
-				push 1
-				mov ecx, pPlayerPed
-				call dwFunc
-			}
-			// Remove our model info reference
-			m_pModelInfo->RemoveReference();
+			CPlayerPedPool::Destroy(pooledPed);
 		}
+
+		m_pPlayerPed = NULL;
+		m_pPlayerInfo = NULL;
+		m_pContextData = NULL;
+		m_byteGamePlayerNumber = INVALID_PLAYER_PED;
+
+		// Flag ourselves as despawned
+		m_bSpawned = false;
+		return;
 	}
 
 	// Do we have a context data instance
@@ -382,6 +374,11 @@ void CNetworkPlayer::Destroy()
 		// Set the context data pointer to NULL
 		m_pContextData = NULL;
 	}
+
+	// Is the player manager still indexing our ped?
+	if(m_pPlayerPed && g_pPlayerManager)
+		g_pPlayerManager->SetGamePed(m_playerId, m_pPlayerPed->GetPed(), NULL);
+
 	// Delete the player ped instance
 	SAFE_DELETE(m_pPlayerPed);
 
@@ -576,9 +573,9 @@ bool CNetworkPlayer::GetKillInfo(EntityId * playerId, EntityId * vehicleId, Enti
 		if(*playerId == INVALID_ENTITY_ID && *vehicleId == INVALID_ENTITY_ID)
 		{
 			// Loop through all streamed in vehicles
-			std::list<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
+			std::vector<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
 
-			for(std::list<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
+			for(std::vector<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
 			{
 				CNetworkVehicle * pVehicle = reinterpret_cast<CNetworkVehicle *>(*iter);
 
@@ -760,8 +757,15 @@ void CNetworkPlayer::SetModel(DWORD dwModelHash)
 			unsigned int uiAmmoInClip = GetAmmoInClip(uiCurrWeap);
 			for(unsigned int ui = 1; ui < 12; ++ui)
 				GetWeaponInSlot(ui, uiWeap[ui], uiAmmo[ui], uiUnknown[ui]);
+			IVPed * pOldPed = m_pPlayerPed->GetPed();
 			Scripting::ChangePlayerModel(m_byteGamePlayerNumber, (Scripting::eModel)dwModelHash);
 			m_pPlayerPed->SetPed(m_pPlayerInfo->GetPlayerPed());
+			g_pPlayerManager->SetGamePed(m_playerId, pOldPed, m_pPlayerPed->GetPed());
+
+			// The context data is found by the new ped
+			if(m_pContextData)
+				m_pContextData->SetPlayerPed(m_pPlayerPed);
+
 			SetHealth(uiHealth);
 			SetArmour(uiArmour);
 			SetCurrentHeading(fHeading);
@@ -1517,6 +1521,14 @@ unsigned int CNetworkPlayer::GetInterior()
 void CNetworkPlayer::UpdateTargetPosition()
 {
 	THIS_CHECK
+	// Do we have buffered snapshots? Show the position of a moment ago between them
+	CVector3 vecSnapshotPosition;
+	if(m_interpolationBuffer.GetPosition((SharedUtility::GetTime() - INTERPOLATION_DELAY), vecSnapshotPosition))
+	{
+		SetPosition(vecSnapshotPosition, false);
+		return;
+	}
+
 	if(HasTargetPosition())
 	{
 		unsigned long ulCurrentTime = SharedUtility::GetTime();
@@ -1596,10 +1608,18 @@ void CNetworkPlayer::SetTargetPosition(const CVector3 &vecPosition, unsigned lon
 	}
 }
 
+void CNetworkPlayer::AddTargetSnapshot(unsigned long ulTime, const CVector3& vecPosition)
+{
+	THIS_CHECK
+	if(IsSpawned())
+		m_interpolationBuffer.Add(ulTime, vecPosition);
+}
+
 void CNetworkPlayer::RemoveTargetPosition()
 {
 	THIS_CHECK
 	m_interp.pos.ulFinishTime = 0;
+	m_interpolationBuffer.Reset();
 }
 
 void CNetworkPlayer::ResetInterpolation()
@@ -1765,6 +1785,9 @@ void CNetworkPlayer::SetName(String strName)
 	THIS_CHECK
 	m_strName = strName;
 
+	if(g_pScriptingManager)
+		g_pScriptingManager->InvalidateCachedString(this);
+
 	if(!CGame::GetNameTags())
 	{
 		Scripting::RemoveFakeNetworkNameFromPed(GetScriptingHandle());
@@ -1925,9 +1948,9 @@ bool CNetworkPlayer::GetClosestVehicle(bool bPassenger, CNetworkVehicle ** pVehi
 		GetPosition(vecPlayerPos);
 
 		// Loop through all streamed in vehicles
-		std::list<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
+		std::vector<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
 
-		for(std::list<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
+		for(std::vector<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
 		{
 			CNetworkVehicle * pTestVehicle = reinterpret_cast<CNetworkVehicle *>(*iter);
 
@@ -2333,7 +2356,8 @@ void CNetworkPlayer::CheckVehicleEntryExitKey()
 							// Is this a network vehicle?
 							if(pVehicle->IsNetworkVehicle())
 							{
-								// Request the vehicle entry
+								// Request the vehicle entry, the server only replies to roll it back
+								// or to confirm it so we don't have to wait for it
 								CBitStream bsSend;
 								bsSend.WriteCompressed(GetPlayerId());
 								bsSend.Write((BYTE)VEHICLE_ENTRY_REQUEST);
@@ -2342,11 +2366,9 @@ void CNetworkPlayer::CheckVehicleEntryExitKey()
 								g_pNetworkManager->RPC(RPC_VehicleEnterExit, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE);
 								m_vehicleEnterExit.bRequesting = true;
 							}
-							else
-							{
-								// Enter the vehicle
-								EnterVehicle(pVehicle, byteSeatId);
-							}
+
+							// Enter the vehicle
+							EnterVehicle(pVehicle, byteSeatId);
 						}
 					}
 				}
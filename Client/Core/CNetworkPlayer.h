@@ -11,6 +11,7 @@
 
 #include "Scripting.h"
 #include "CStreamer.h"
+#include "CInterpolationBuffer.h"
 #include "CIVPlayerPed.h"
 #include "CIVPlayerInfo.h"
 #include "CContextDataManager.h"
@@ -50,6 +51,7 @@ private:
 			unsigned long ulFinishTime;
 		} pos;
 	}                 m_interp;
+	CInterpolationBuffer m_interpolationBuffer;
 	unsigned char     m_ucClothes[11];
 	bool              m_bUseCustomClothesOnSpawn;
 	CControlState     m_previousControlState;
@@ -81,6 +83,9 @@ private:
 	unsigned int	  m_uiHealth;
 	CVector3		  m_vecPos;
 
+	// Sets up a new or pooled ped once Create has it
+	void              OnCreate();
+
 public:
 	CNetworkPlayer(bool bIsLocalPlayer = false);
 	~CNetworkPlayer();
@@ -210,6 +215,7 @@ public:
 	void                     ResetInterpolation();
 
 	void                     SetTargetPosition(const CVector3& vecPosition, unsigned long ulDelay);
+	void                     AddTargetSnapshot(unsigned long ulTime, const CVector3& vecPosition);
 
 	void                     RemoveTargetPosition();
 
@@ -17,11 +17,14 @@
 #include <SharedUtility.h>
 #include "CPools.h"
 #include "CNetworkManager.h"
+#include "CVehicleManager.h"
 
 extern CPlayerManager * g_pPlayerManager;
 extern CModelManager * g_pModelManager;
 extern CLocalPlayer * g_pLocalPlayer;
 extern CNetworkManager * g_pNetworkManager;
+extern CStreamer * g_pStreamer;
+extern CVehicleManager * g_pVehicleManager;
 
 #define THIS_CHECK if(!this) { CLogFile::Printf("this error"); return; }
 #define THIS_CHECK_R(x) if(!this) { CLogFile::Printf("this error"); return x; }
@@ -47,7 +50,14 @@ CNetworkVehicle::CNetworkVehicle(DWORD dwModelHash, int iModelId)
 	m_bActorVehicle(false),
 	m_bFirstStreamIn(false),
 	m_bActive(false),
-	m_iVehicleType(-1)
+	m_iVehicleType(-1),
+	m_bSyncOwner(false),
+	m_bEmptySyncMoving(false),
+	m_ulLastEmptySyncTime(0),
+	m_bAsleep(false),
+	m_ulIdleTime(0),
+	m_uiSleepHealth(0),
+	m_ulLastDamageSyncTime(0)
 {
 
 	for(int i = 0; i < 8; i++)
@@ -58,6 +68,7 @@ CNetworkVehicle::CNetworkVehicle(DWORD dwModelHash, int iModelId)
 	memset(&m_vecRotation, 0, sizeof(CVector3));
 	memset(&m_vecMoveSpeed, 0, sizeof(CVector3));
 	memset(&m_vecTurnSpeed, 0, sizeof(CVector3));
+	CDeadReckoning::Reset(&m_deadReckoning);
 	memset(m_byteColors, 0, sizeof(m_byteColors));
 	
 	memset(m_bIndicatorState, 0, sizeof(m_bIndicatorState));
@@ -74,6 +85,8 @@ CNetworkVehicle::CNetworkVehicle(DWORD dwModelHash, int iModelId)
 	
 	for(int i = 0; i < 4; i++)
 		m_bWindow[i] = false;
+
+	memset(&m_damage, 0, sizeof(VehicleDamageSyncData));
 }
 CNetworkVehicle::~CNetworkVehicle()
 {
@@ -156,6 +169,8 @@ CNetworkPlayer * CNetworkVehicle::GetPassenger(BYTE bytePassengerId)
 void CNetworkVehicle::SetOccupant(BYTE byteSeatId, CNetworkPlayer * pOccupant)
 {
 	THIS_CHECK
+	WakeUp();
+
 	if(byteSeatId == 0)
 		SetDriver(pOccupant);
 	else
@@ -177,58 +192,72 @@ bool CNetworkVehicle::Create(bool bStreamIn)
 	// Are we not already created?
 	if(!IsSpawned())
 	{
-		// Add our model info reference
-		m_pModelInfo->AddReference(true);
-
 		// Get our model index
 		int iModelIndex = m_pModelInfo->GetIndex();
+		IVVehicle * pVehicle = NULL;
 
-		//CLogFile::Printf("pModelInfo + 0x70 = %d", *(DWORD *)(m_pModelInfo->GetModelInfo() + 0x70));
-		//memset((void *)(CGame::GetBase() + 0x841808), 0x90, 5);
-		//memset((void *)(CGame::GetBase() + 0x8419B8), 0x90, 5);
+		// Reactivate a vehicle of our model that was streamed out recently, it keeps its model info reference
+		CIVVehicle * pCachedVehicle = ((bStreamIn && g_pVehicleManager) ? g_pVehicleManager->GetVehicleCache()->Take(iModelIndex) : NULL);
 
-		// Create the vehicle
-		DWORD dwFunc = (CGame::GetBase() + 0x8415D0);
-		CVector3 * pVecPosition = &m_vecPosition;
-		IVVehicle * pVehicle = NULL;
-		_asm
+		if(pCachedVehicle)
 		{
-			push 1
-			push 1
-			push pVecPosition
-			push iModelIndex
-			call dwFunc
-			add esp, 10h
-			mov pVehicle, eax
+			m_pVehicle = pCachedVehicle;
+			m_pVehicle->AddToWorld();
+			pVehicle = m_pVehicle->GetVehicle();
 		}
+		else
+		{
+			// Add our model info reference
+			m_pModelInfo->AddReference(true);
 
-		// Invalid vehicle?
-		if(!pVehicle)
-			return false;
+			//CLogFile::Printf("pModelInfo + 0x70 = %d", *(DWORD *)(m_pModelInfo->GetModelInfo() + 0x70));
+			//memset((void *)(CGame::GetBase() + 0x841808), 0x90, 5);
+			//memset((void *)(CGame::GetBase() + 0x8419B8), 0x90, 5);
 
-		dwFunc = (CGame::GetBase() + 0xC6CFC0);
-		_asm
-		{
-			push pVehicle
-			call dwFunc
-			add esp, 4
-		}
+			// Create the vehicle
+			DWORD dwFunc = (CGame::GetBase() + 0x8415D0);
+			CVector3 * pVecPosition = &m_vecPosition;
+			_asm
+			{
+				push 1
+				push 1
+				push pVecPosition
+				push iModelIndex
+				call dwFunc
+				add esp, 10h
+				mov pVehicle, eax
+			}
 
-		dwFunc = (CGame::GetBase() + 0xB77BB0);
-		_asm
-		{
-			push 0
-			push pVehicle
-			call dwFunc
-			add esp, 8
-		}
+			// Invalid vehicle?
+			if(!pVehicle)
+				return false;
 
-		// Create the vehicle instance
-		m_pVehicle = new CIVVehicle(pVehicle);
+			dwFunc = (CGame::GetBase() + 0xC6CFC0);
+			_asm
+			{
+				push pVehicle
+				call dwFunc
+				add esp, 4
+			}
 
-		// Invalid vehicle instance?
-		if(!m_pVehicle)
-			return false;
+			dwFunc = (CGame::GetBase() + 0xB77BB0);
+			_asm
+			{
+				push 0
+				push pVehicle
+				call dwFunc
+				add esp, 8
+			}
+
+			// Create the vehicle instance
+			m_pVehicle = new CIVVehicle(pVehicle);
+
+			// Invalid vehicle instance?
+			if(!m_pVehicle)
+				return false;
+		}
+
+		g_pStreamer->SetGameVehicle(pVehicle, this);
 		
 		if(bStreamIn) {
 			// Set initial colors
@@ -323,7 +352,7 @@ bool CNetworkVehicle::Create(bool bStreamIn)
 	return false;
 }
 
-void CNetworkVehicle::Destroy()
+void CNetworkVehicle::Destroy(bool bCache)
 {
 	THIS_CHECK
 	// Are we spawned?
@@ -340,39 +369,16 @@ void CNetworkVehicle::Destroy()
 				m_pPassengers[i]->InternalRemoveFromVehicle();
 		}
 
-		// Get the vehicle pointer
-		IVVehicle * pVehicle = m_pVehicle->GetVehicle();
+		// Remove the vehicle from the streamer index
+		if(g_pStreamer)
+			g_pStreamer->SetGameVehicle(m_pVehicle->GetVehicle(), NULL);
 
-		*(BYTE *)(pVehicle + 0xF6D) |= 8;
+		// Keep the vehicle hidden for a later stream in of our model or delete it,
+		// either way it keeps or removes our model info reference
+		if(!bCache || !g_pVehicleManager || !g_pVehicleManager->GetVehicleCache()->Add(m_pVehicle, m_pModelInfo))
+			CVehicleCache::Destroy(m_pVehicle, m_pModelInfo, true);
 
-		// Remove the vehicle from the world
-		m_pVehicle->RemoveFromWorld();
-
-		// Remove references?
-		DWORD dwFunc = (CGame::GetBase() + 0x819190);
-		_asm
-		{
-			push pVehicle
-			call dwFunc
-			add esp, 4
-		}
-
-		*(BYTE *)(pVehicle + 0xF6B) &= 0xDF;
-
-		// Delete the vehicle
-		dwFunc = pVehicle->m_VFTable->ScalarDeletingDestructor;
-		_asm
-		{
-			push 1
-			mov ecx, pVehicle
-			call dwFunc
-		}
-
-		// Remove our model info reference
-		m_pModelInfo->RemoveReference();
-
-		// Delete the vehicle instance
-		SAFE_DELETE(m_pVehicle);
+		m_pVehicle = NULL;
 
 		m_bActive = false;
 	}
@@ -435,6 +441,9 @@ void CNetworkVehicle::StreamIn()
 		// Restore gps state
 		SetVehicleGPSState(m_bGpsState);
 
+		// Restore the damage
+		ApplyDamage();
+
 		// Sound horn if needed
 		if(m_ulHornDurationEnd > SharedUtility::GetTime())
 			SoundHorn((m_ulHornDurationEnd - SharedUtility::GetTime()));
@@ -530,8 +539,8 @@ void CNetworkVehicle::StreamOut()
 	// Save the petrol tank health
 	m_fPetrolTankHealth = GetPetrolTankHealth();
 
-	// Destroy the vehicle
-	Destroy();
+	// Destroy the vehicle, its game vehicle is kept for a while
+	Destroy(true);
 }
 
 bool CNetworkVehicle::IsMoving()
@@ -546,6 +555,19 @@ bool CNetworkVehicle::IsMoving()
 	return false;
 }
 
+void CNetworkVehicle::PrefetchModel()
+{
+	THIS_CHECK
+	if(m_pModelInfo)
+		g_pModelManager->RequestModel(m_pModelInfo->GetIndex());
+}
+
+bool CNetworkVehicle::IsModelLoaded()
+{
+	THIS_CHECK_R(true)
+	return (!m_pModelInfo || g_pModelManager->IsModelReady(m_pModelInfo->GetIndex()));
+}
+
 void CNetworkVehicle::StopMoving()
 {
 	THIS_CHECK
@@ -650,6 +672,8 @@ void CNetworkVehicle::GetColors(BYTE &byteColor1, BYTE &byteColor2, BYTE &byteCo
 void CNetworkVehicle::SetPosition(const CVector3& vecPosition, bool bDontCancelTasks, bool bResetInterpolation)
 {
 	THIS_CHECK
+	WakeUp();
+
 	if(IsSpawned())
 	{
 		if(!bDontCancelTasks)
@@ -686,6 +710,8 @@ void CNetworkVehicle::GetPosition(CVector3& vecPosition)
 void CNetworkVehicle::SetRotation(const CVector3& vecRotation, bool bResetInterpolation)
 {
 	THIS_CHECK
+	WakeUp();
+
 	if(IsSpawned())
 	{
 		// Remove the vehicle from the world
@@ -745,6 +771,8 @@ void CNetworkVehicle::GetRotation(CVector3& vecRotation)
 void CNetworkVehicle::SetHealth(unsigned int uiHealth)
 {
 	THIS_CHECK
+	WakeUp();
+
 	// Are we spawned?
 	if(IsSpawned())
 		m_pVehicle->SetEngineHealth((float)uiHealth);
@@ -809,6 +837,8 @@ void CNetworkVehicle::GetQuaternion(float * quat)
 void CNetworkVehicle::SetMoveSpeed(const CVector3& vecMoveSpeed)
 {
 	THIS_CHECK
+	WakeUp();
+
 	// Are we spawned?
 	if(IsSpawned())
 		m_pVehicle->SetMoveSpeed(vecMoveSpeed);
@@ -829,6 +859,8 @@ void CNetworkVehicle::GetMoveSpeed(CVector3& vecMoveSpeed)
 void CNetworkVehicle::SetTurnSpeed(const CVector3& vecTurnSpeed)
 {
 	THIS_CHECK
+	WakeUp();
+
 	// Are we spawned?
 	if(IsSpawned())
 		m_pVehicle->SetTurnSpeed(vecTurnSpeed);
@@ -892,7 +924,10 @@ bool CNetworkVehicle::StoreEmptySync(EMPTYVEHICLESYNCPACKET * emptyVehicleSync)
 	THIS_CHECK_R(false)
 	if(IsSpawned() && IsStreamedIn())
 	{
-		if(m_oldEmptySyncData.bEngineStatus == GetEngineState()) 
+		// Standing vehicles are synced once more after they stopped so the others get where they stopped
+		bool bMoving = IsMoving();
+
+		if(!bMoving && !m_bEmptySyncMoving && m_oldEmptySyncData.bEngineStatus == GetEngineState())
 			//if(m_oldEmptySyncData.bLights == GetLightsState())
 				//if(m_oldEmptySyncData.bSirenState == GetSirenState())
 					//if(m_oldEmptySyncData.bTaxiLights == GetTaxiLightsState())
@@ -901,9 +936,11 @@ bool CNetworkVehicle::StoreEmptySync(EMPTYVEHICLESYNCPACKET * emptyVehicleSync)
 								if(m_oldEmptySyncData.uiHealth == GetHealth())
 									return false;
 
+		m_bEmptySyncMoving = bMoving;
+		memset(emptyVehicleSync, 0, sizeof(EMPTYVEHICLESYNCPACKET));
 		emptyVehicleSync->vehicleId = GetVehicleId();
-		/*GetPosition(emptyVehicleSync->vecPosition);
-		GetRotation(emptyVehicleSync->vecRotation);*/
+		GetPosition(emptyVehicleSync->vecPosition);
+		GetRotation(emptyVehicleSync->vecRotation);
 		emptyVehicleSync->uiHealth = GetHealth();
 		emptyVehicleSync->fPetrolHealth = GetPetrolTankHealth();
 		emptyVehicleSync->bLights = GetLightsState();
@@ -911,8 +948,8 @@ bool CNetworkVehicle::StoreEmptySync(EMPTYVEHICLESYNCPACKET * emptyVehicleSync)
 		emptyVehicleSync->bSirenState = GetSirenState();
 		emptyVehicleSync->bEngineStatus = GetEngineState();
 		emptyVehicleSync->fDirtLevel = GetDirtLevel();
-		/*GetTurnSpeed(emptyVehicleSync->vecTurnSpeed);
-		GetMoveSpeed(emptyVehicleSync->vecMoveSpeed);*/
+		GetTurnSpeed(emptyVehicleSync->vecTurnSpeed);
+		GetMoveSpeed(emptyVehicleSync->vecMoveSpeed);
 
 		CVector3 vecPos; GetPosition(vecPos);
 		if((int)GetHealth() < 0 || (float)GetPetrolTankHealth() < 0.0f || vecPos.fZ < -1.0f)
@@ -925,20 +962,32 @@ bool CNetworkVehicle::StoreEmptySync(EMPTYVEHICLESYNCPACKET * emptyVehicleSync)
 			}
 		}
 
-		/*for(int i = 0; i <= 3; i++)
-			emptyVehicleSync->bWindow[i] = GetWindowState(i);
-
-		for(int i = 0; i <= 5; i++)
-			emptyVehicleSync->bTyre[i] = 0;*/
-	
-		for(int i = 0; i <= 5; i++)
-			emptyVehicleSync->fDoor[i] = GetCarDoorAngle(i);
 		m_oldEmptySyncData = *emptyVehicleSync;
 		return true;
 	}
 	return false;
 }
 
+void CNetworkVehicle::ApplyEmptySync(const EMPTYVEHICLESYNCPACKET * emptyVehicleSync)
+{
+	THIS_CHECK
+	if(!IsSpawned() || GetDriver())
+		return;
+
+	// Move it to where the sync owner has it, it is interpolated like a vehicle with a driver
+	SetTargetPosition(emptyVehicleSync->vecPosition, TICK_RATE);
+	SetTargetRotation(emptyVehicleSync->vecRotation, TICK_RATE);
+	SetTurnSpeed(emptyVehicleSync->vecTurnSpeed);
+	SetMoveSpeed(emptyVehicleSync->vecMoveSpeed);
+	m_ulLastEmptySyncTime = SharedUtility::GetTime();
+}
+
+bool CNetworkVehicle::HasEmptySync()
+{
+	THIS_CHECK_R(false)
+	return (m_ulLastEmptySyncTime != 0 && (SharedUtility::GetTime() - m_ulLastEmptySyncTime) < EMPTY_VEHICLE_SYNC_TIMEOUT);
+}
+
 BYTE CNetworkVehicle::GetMaxPassengers()
 {
 	THIS_CHECK_R(0)
@@ -1029,12 +1078,60 @@ DWORD CNetworkVehicle::GetDoorLockState()
 void CNetworkVehicle::Pulse()
 {
 	THIS_CHECK
+	// Asleep vehicles only check if something (e.g. a collision or a shot) moved or damaged them
+	if(m_bAsleep)
+	{
+		if(!HasEmptySync() && !IsMoving() && GetHealth() == m_uiSleepHealth)
+			return;
+
+		WakeUp();
+	}
+
 	Interpolate();
+	UpdateDamageSync();
+	UpdateSleep();
+}
+
+void CNetworkVehicle::UpdateSleep()
+{
+	THIS_CHECK
+	if(!IsSpawned() || IsOccupied() || HasEmptySync() || IsMoving())
+	{
+		m_ulIdleTime = 0;
+		return;
+	}
+
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if(m_ulIdleTime == 0)
+		m_ulIdleTime = ulTime;
+	else if((ulTime - m_ulIdleTime) >= VEHICLE_SLEEP_TIME)
+	{
+		m_bAsleep = true;
+		m_uiSleepHealth = GetHealth();
+	}
 }
 
 void CNetworkVehicle::UpdateTargetPosition()
 {
 	THIS_CHECK
+	// Do we have buffered snapshots? Show the position of a moment ago between them,
+	// after the newest one carry on along its movement
+	unsigned long ulSnapshotTime = (SharedUtility::GetTime() - INTERPOLATION_DELAY);
+	CVector3 vecSnapshotPosition;
+	CVector3 vecSnapshotRotation;
+	if((long)(ulSnapshotTime - m_deadReckoning.ulTime) > 0 && CDeadReckoning::Extrapolate(&m_deadReckoning, ulSnapshotTime, vecSnapshotPosition, vecSnapshotRotation))
+	{
+		SetPosition(vecSnapshotPosition, true, false);
+		return;
+	}
+
+	if(m_interpolationBuffer.GetPosition(ulSnapshotTime, vecSnapshotPosition))
+	{
+		SetPosition(vecSnapshotPosition, true, false);
+		return;
+	}
+
 	// Do we have a target position?
 	if(HasTargetPosition())
 	{
@@ -1121,8 +1218,8 @@ void CNetworkVehicle::UpdateTargetRotation()
 void CNetworkVehicle::Interpolate()
 {
 	THIS_CHECK
-	// Do we have a driver?
-	if(GetDriver())
+	// Do we have a driver or does the sync owner move us?
+	if(GetDriver() || HasEmptySync())
 	{
 		// Update our target position
 		UpdateTargetPosition();
@@ -1131,7 +1228,7 @@ void CNetworkVehicle::Interpolate()
 		UpdateTargetRotation();
 
 		// Update our interior
-		UpdateInterior(true);
+		UpdateInterior(GetDriver() != NULL);
 	}
 	else
 	{
@@ -1221,10 +1318,25 @@ void CNetworkVehicle::SetTargetRotation(const CVector3& vecRotation, unsigned lo
 	m_vecRotation = vecRotation;
 }
 
+void CNetworkVehicle::AddTargetSnapshot(unsigned long ulTime, const CVector3& vecPosition, const CVector3& vecRotation, const CVector3& vecMoveSpeed, const CVector3& vecTurnSpeed)
+{
+	THIS_CHECK
+	if(IsSpawned())
+	{
+		m_interpolationBuffer.Add(ulTime, vecPosition);
+
+		// The driver only syncs once our extrapolation of the newest snapshot is too far off
+		if(m_deadReckoning.ulTime == 0 || (long)(ulTime - m_deadReckoning.ulTime) > 0)
+			CDeadReckoning::SetState(&m_deadReckoning, ulTime, vecPosition, vecRotation, vecMoveSpeed, vecTurnSpeed);
+	}
+}
+
 void CNetworkVehicle::RemoveTargetPosition()
 {
 	THIS_CHECK
 	m_interp.pos.ulFinishTime = 0;
+	m_interpolationBuffer.Reset();
+	CDeadReckoning::Reset(&m_deadReckoning);
 }
 
 void CNetworkVehicle::RemoveTargetRotation()
@@ -1558,14 +1670,150 @@ bool CNetworkVehicle::GetEngineState()
 CVector3 CNetworkVehicle::GetDeformation(CVector3 vecPosition)
 {
 	THIS_CHECK_R(CVector3(0.0f, 0.0f, 0.0f));
-	// Are we spawned?
+	CVector3 vecDeformation;
+
+	// Are we spawned? (the position is an offset from the vehicle)
 	if(IsSpawned())
+		Scripting::GetCarDeformationAtPos(GetScriptingHandle(), vecPosition.fX, vecPosition.fY, vecPosition.fZ, &vecDeformation);
+
+	return vecDeformation;
+}
+
+void CNetworkVehicle::GetDamagePoints(CVector3 * pvecPoints)
+{
+	THIS_CHECK
+	// The points are on the middle of the sides of the model
+	CVector3 vecMin;
+	CVector3 vecMax;
+	Scripting::GetModelDimensions((Scripting::eModel)m_pModelInfo->GetHash(), &vecMin, &vecMax);
+	pvecPoints[0] = CVector3(0.0f, vecMax.fY, 0.0f);
+	pvecPoints[1] = CVector3(0.0f, vecMin.fY, 0.0f);
+	pvecPoints[2] = CVector3(vecMin.fX, 0.0f, 0.0f);
+	pvecPoints[3] = CVector3(vecMax.fX, 0.0f, 0.0f);
+	pvecPoints[4] = CVector3(0.0f, 0.0f, vecMax.fZ);
+}
+
+void CNetworkVehicle::GetDamage(VehicleDamageSyncData& damage)
+{
+	THIS_CHECK
+	memset(&damage, 0, sizeof(VehicleDamageSyncData));
+
+	if(!IsSpawned())
+		return;
+
+	unsigned int uiHandle = GetScriptingHandle();
+
+	for(int i = 0; i < 4; i++)
+	{
+		if(!Scripting::IsVehWindowIntact(uiHandle, (Scripting::eVehicleWindow)i))
+			damage.ucWindows |= (1 << i);
+	}
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(Scripting::IsCarTyreBurst(uiHandle, (Scripting::eVehicleTyre)i))
+			damage.ucTyres |= (1 << i);
+
+		if(Scripting::IsCarDoorDamaged(uiHandle, (Scripting::eVehicleDoor)i))
+			damage.ucDamagedDoors |= (1 << i);
+
+		float fRatio = 0.0f;
+		Scripting::GetDoorAngleRatio(uiHandle, (Scripting::eVehicleDoor)i, &fRatio);
+		damage.ucDoors[i] = (unsigned char)((Math::Clamp(0.0f, fRatio, 1.0f) * 255.0f) + 0.5f);
+	}
+
+	CVector3 vecPoints[VEHICLE_DAMAGE_POINTS];
+	GetDamagePoints(vecPoints);
+
+	for(int i = 0; i < VEHICLE_DAMAGE_POINTS; i++)
+	{
+		CVector3 vecDeformation = GetDeformation(vecPoints[i]);
+		float fAxes[3] = { vecDeformation.fX, vecDeformation.fY, vecDeformation.fZ };
+
+		for(int j = 0; j < 3; j++)
+		{
+			float fSteps = Math::Clamp(-127.0f, (fAxes[j] / VEHICLE_DAMAGE_DEFORMATION_STEP), 127.0f);
+			damage.cDeformation[i][j] = (signed char)((fSteps < 0.0f) ? (fSteps - 0.5f) : (fSteps + 0.5f));
+		}
+	}
+}
+
+void CNetworkVehicle::SetDamage(const VehicleDamageSyncData& damage)
+{
+	THIS_CHECK
+	memcpy(&m_damage, &damage, sizeof(VehicleDamageSyncData));
+	ApplyDamage();
+}
+
+void CNetworkVehicle::ApplyDamage()
+{
+	THIS_CHECK
+	// Are we spawned?
+	if(!IsSpawned())
+		return;
+
+	// The game has no native to deform a vehicle, only the windows, tyres and doors are applied
+	unsigned int uiHandle = GetScriptingHandle();
+
+	for(int i = 0; i < 4; i++)
 	{
-		Scripting::GetCarDeformationAtPos(GetScriptingHandle(),m_vecPosition.fX, m_vecPosition.fY, m_vecPosition.fZ, &vecPosition);
-		//m_pVehicle->GetDeformation(vecPosition);
-		CLogFile::Printf("DEFORMATION(%f, %f, %f)",vecPosition.fX,vecPosition.fY,vecPosition.fZ);
+		if((m_damage.ucWindows & (1 << i)) && Scripting::IsVehWindowIntact(uiHandle, (Scripting::eVehicleWindow)i))
+		{
+			Scripting::SmashCarWindow(uiHandle, (Scripting::eVehicleWindow)i);
+			m_bWindow[i] = true;
+		}
 	}
-	return CVector3(0.0f, 0.0f, 0.0f);
+
+	for(int i = 0; i < 6; i++)
+	{
+		bool bBurst = ((m_damage.ucTyres & (1 << i)) != 0);
+
+		if(bBurst != Scripting::IsCarTyreBurst(uiHandle, (Scripting::eVehicleTyre)i))
+		{
+			if(bBurst)
+				Scripting::BurstCarTyre(uiHandle, (Scripting::eVehicleTyre)i);
+			else
+				Scripting::FixCarTyre(uiHandle, (Scripting::eVehicleTyre)i);
+		}
+
+		if((m_damage.ucDamagedDoors & (1 << i)) && !Scripting::IsCarDoorDamaged(uiHandle, (Scripting::eVehicleDoor)i))
+			Scripting::BreakCarDoor(uiHandle, (Scripting::eVehicleDoor)i, false);
+
+		// Only move the doors that are noticeably elsewhere
+		float fRatio = 0.0f;
+		Scripting::GetDoorAngleRatio(uiHandle, (Scripting::eVehicleDoor)i, &fRatio);
+		float fTargetRatio = (m_damage.ucDoors[i] / 255.0f);
+
+		if(fabs(fRatio - fTargetRatio) > VEHICLE_DAMAGE_DOOR_TOLERANCE)
+			Scripting::ControlCarDoor(uiHandle, (Scripting::eVehicleDoor)i, 0, fTargetRatio);
+	}
+}
+
+void CNetworkVehicle::UpdateDamageSync()
+{
+	THIS_CHECK
+	// Only the player that syncs the vehicle sends its damage
+	if(!IsSpawned() || (m_pDriver != g_pLocalPlayer && (!m_bSyncOwner || IsOccupied())))
+		return;
+
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastDamageSyncTime) < VEHICLE_DAMAGE_SYNC_INTERVAL)
+		return;
+
+	m_ulLastDamageSyncTime = ulTime;
+	VehicleDamageSyncData damage;
+	GetDamage(damage);
+
+	// Only send it when it changed, it is sent reliably
+	if(!memcmp(&damage, &m_damage, sizeof(VehicleDamageSyncData)))
+		return;
+
+	memcpy(&m_damage, &damage, sizeof(VehicleDamageSyncData));
+	CBitStream bsSend;
+	bsSend.WriteCompressed(m_vehicleId);
+	CSyncSerializer::Serialize(&bsSend, m_damage);
+	g_pNetworkManager->RPC(RPC_VehicleDamageSync, &bsSend, PRIORITY_MEDIUM, RELIABILITY_RELIABLE_ORDERED);
 }
 
 void CNetworkVehicle::SetVehicleGPSState(bool bState)
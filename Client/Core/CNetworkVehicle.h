@@ -11,6 +11,20 @@
 
 #include "CLocalPlayer.h"
 #include "CStreamer.h"
+#include "CInterpolationBuffer.h"
+#include <Game/CDeadReckoning.h>
+
+// Time in ms after the last empty sync of the sync owner after which we stop interpolating
+#define EMPTY_VEHICLE_SYNC_TIMEOUT 1000
+
+// Time in ms an empty vehicle has to stand still before it falls asleep
+#define VEHICLE_SLEEP_TIME 3000
+
+// Interval in ms at which the player that syncs a vehicle checks if its damage changed
+#define VEHICLE_DAMAGE_SYNC_INTERVAL 500
+
+// Difference in the open ratio of a door after which the synced ratio is applied
+#define VEHICLE_DAMAGE_DOOR_TOLERANCE 0.02f
 
 class CNetworkVehicle : public CStreamableEntity
 {
@@ -48,6 +62,8 @@ private:
 			unsigned long ulFinishTime;
 		} rot;
 	}                m_interp;
+	CInterpolationBuffer m_interpolationBuffer;
+	DeadReckoningState   m_deadReckoning; // Of the newest snapshot, it is extrapolated after it
 	bool             m_bSirenState;
 	bool             m_bIndicatorState[4];
 	int				 m_iComponents[9];
@@ -69,9 +85,23 @@ private:
 	unsigned int	 m_uiInterior;
 	int				 m_iVehicleType;
 	EMPTYVEHICLESYNCPACKET	m_oldEmptySyncData;
+	bool			 m_bSyncOwner;          // We sync the vehicle while nobody is in it
+	bool			 m_bEmptySyncMoving;    // It was moving at our last empty sync
+	unsigned long	 m_ulLastEmptySyncTime; // Of the last empty sync the sync owner sent us
+	bool			 m_bAsleep;             // Not interpolated or synced until something moves it
+	unsigned long	 m_ulIdleTime;          // Since when it is empty and stands still (0 if it isn't)
+	unsigned int	 m_uiSleepHealth;       // Health it fell asleep with, a change wakes it up
+	VehicleDamageSyncData m_damage;         // Last damage we sent or got from the server
+	unsigned long	 m_ulLastDamageSyncTime;
 
 	bool             Create(bool bStreamIn = false);
-	void             Destroy();
+	void             UpdateSleep();
+	void             UpdateDamageSync();
+	void             ApplyDamage();
+	// Gets the offsets of the VEHICLE_DAMAGE_POINTS deformation is sampled at
+	void             GetDamagePoints(CVector3 * pvecPoints);
+	// Keeps the game vehicle in the vehicle cache if bCache is set
+	void             Destroy(bool bCache = false);
 
 public:
 	CNetworkVehicle(DWORD dwModelHash, int iModelId);
@@ -105,6 +135,8 @@ public:
 
 	void             StreamIn();
 	void             StreamOut();
+	void             PrefetchModel();
+	bool             IsModelLoaded();
 	void             GetStreamPosition(CVector3& vecPosition) { GetPosition(vecPosition); }
 
 	void             AddToWorld();
@@ -147,7 +179,16 @@ public:
 	void             SetDirtLevel(float fDirtLevel);
 	float            GetDirtLevel();
 
+	// Returns false if the vehicle doesn't need an empty sync (standing still and nothing changed)
 	bool             StoreEmptySync(EMPTYVEHICLESYNCPACKET * emptyVehicleSync);
+	void             ApplyEmptySync(const EMPTYVEHICLESYNCPACKET * emptyVehicleSync);
+	bool             HasEmptySync();
+	void             SetSyncOwner(bool bSyncOwner) { m_bSyncOwner = bSyncOwner; m_bEmptySyncMoving = true; }
+	bool             IsSyncOwner() { return m_bSyncOwner; }
+
+	// Asleep vehicles are skipped by the per frame processing and the empty vehicle sync
+	bool             IsAsleep() { return m_bAsleep; }
+	void             WakeUp() { m_bAsleep = false; m_ulIdleTime = 0; }
 	
 	void             SetDoorLockState(DWORD dwDoorLockState);
 	DWORD            GetDoorLockState();
@@ -164,6 +205,7 @@ public:
 	void             UpdateTargetRotation();
 	
 	void             SetTargetPosition(const CVector3& vecPosition, unsigned long ulDelay);
+	void             AddTargetSnapshot(unsigned long ulTime, const CVector3& vecPosition, const CVector3& vecRotation, const CVector3& vecMoveSpeed, const CVector3& vecTurnSpeed);
 	void             SetTargetRotation(const CVector3& vecRotation, unsigned long ulDelay);
 	void             RemoveTargetPosition();
 	void             RemoveTargetRotation();
@@ -205,6 +247,9 @@ public:
 
 	void			 SetDeformation(CVector3 vecPos, CVector3 vecDeformation);
 	CVector3		 GetDeformation(CVector3 vecPos);
+	// Gets the damage from the game quantized like the damage sync
+	void			 GetDamage(VehicleDamageSyncData& damage);
+	void			 SetDamage(const VehicleDamageSyncData& damage);
 
 	void			 SetDamageable(bool bToggle);
 
@@ -10,8 +10,15 @@
 
 #include "CObject.h"
 #include "CLocalPlayer.h"
+#include "CGame.h"
+#include "CModelManager.h"
+#include "CVehicleManager.h"
+#include "CPlayerManager.h"
 
 extern CLocalPlayer * g_pLocalPlayer;
+extern CModelManager * g_pModelManager;
+extern CVehicleManager * g_pVehicleManager;
+extern CPlayerManager * g_pPlayerManager;
 
 CObject::CObject(DWORD dwModelHash, CVector3 vecPosition, CVector3 vecRotation)
 	: CStreamableEntity(STREAM_ENTITY_OBJECT, 400.0f),
@@ -19,8 +26,11 @@ CObject::CObject(DWORD dwModelHash, CVector3 vecPosition, CVector3 vecRotation)
 	m_dwModelHash(dwModelHash),
 	m_vecPosition(vecPosition),
 	m_vecRotation(vecRotation),
-	m_bIsMoving(false),
-	m_bIsRotating(false)
+	bAttached(false),
+	bVehicleAttached(false),
+	uiVehiclePlayerId(INVALID_ENTITY_ID),
+	uiAttachBone(0),
+	m_bIsMoving(false)
 {
 }
 
@@ -35,6 +45,12 @@ bool CObject::Create()
 	// Are we not already created?
 	if(!IsSpawned())
 	{
+		// Keep the model loaded while the object exists
+		CIVModelInfo * pModelInfo = CGame::GetModelInfo(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+
+		if(pModelInfo)
+			pModelInfo->AddReference(false);
+
 		Scripting::CreateObjectNoOffset((Scripting::eModel)m_dwModelHash, m_vecPosition.fX, m_vecPosition.fY, m_vecPosition.fZ, &m_uiObjectHandle, true);
 		Scripting::FreezeObjectPosition(m_uiObjectHandle, true);
 		Scripting::AddObjectToInteriorRoomByKey(m_uiObjectHandle, (Scripting::eInteriorRoomKey)g_pLocalPlayer->GetInterior());
@@ -51,6 +67,11 @@ void CObject::Destroy()
 	{
 		Scripting::DeleteObject(&m_uiObjectHandle);
 		m_uiObjectHandle = 0;
+
+		CIVModelInfo * pModelInfo = CGame::GetModelInfo(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+
+		if(pModelInfo)
+			pModelInfo->RemoveReference();
 	}
 }
 
@@ -64,6 +85,7 @@ void CObject::SetPosition(const CVector3& vecPosition)
 	}
 
 	m_vecPosition = vecPosition;
+	OnStreamPositionChanged();
 }
 
 void CObject::GetPosition(CVector3& vecPosition)
@@ -85,12 +107,79 @@ void CObject::GetRotation(CVector3& vecRotation)
 	vecRotation = m_vecRotation;
 }
 
+void CObject::ProcessMovement(unsigned long ulTime)
+{
+	if(!m_bIsMoving)
+		return;
+
+	CVector3 vecPosition;
+	CVector3 vecRotation;
+
+	if(m_moveTimeline.Evaluate(ulTime, vecPosition, vecRotation))
+	{
+		SetPosition(vecPosition);
+		SetRotation(vecRotation);
+	}
+
+	if(m_moveTimeline.IsFinished(ulTime))
+		m_bIsMoving = false;
+}
+
+void CObject::SetAttachment(bool bToVehicle, unsigned int uiToVehiclePlayerId, const CVector3& vecPosition, const CVector3& vecRotation, unsigned int uiBone)
+{
+	bAttached = true;
+	bVehicleAttached = bToVehicle;
+	uiVehiclePlayerId = uiToVehiclePlayerId;
+	vecAttachPosition = vecPosition;
+	vecAttachRotation = vecRotation;
+	uiAttachBone = uiBone;
+	ApplyAttachment();
+}
+
+void CObject::Detach()
+{
+	bAttached = false;
+
+	// Are we spawned?
+	if(IsSpawned())
+		Scripting::DetachObject(m_uiObjectHandle, true);
+}
+
+void CObject::ApplyAttachment()
+{
+	// Are we not spawned or not attached?
+	if(!IsSpawned() || !bAttached)
+		return;
+
+	if(bVehicleAttached)
+	{
+		if(g_pVehicleManager->Exists(uiVehiclePlayerId))
+		{
+			CNetworkVehicle * pVehicle = g_pVehicleManager->Get(uiVehiclePlayerId);
+
+			if(pVehicle)
+				Scripting::AttachObjectToCar(m_uiObjectHandle,pVehicle->GetScriptingHandle(),0,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ);
+		}
+	}
+	else
+	{
+		if(g_pPlayerManager->DoesExist(uiVehiclePlayerId))
+		{
+			CNetworkPlayer * pPlayer = g_pPlayerManager->GetAt(uiVehiclePlayerId);
+
+			if(pPlayer)
+				Scripting::AttachObjectToPed(m_uiObjectHandle,pPlayer->GetScriptingHandle(),(Scripting::ePedBone)uiAttachBone,vecAttachPosition.fX,vecAttachPosition.fY,vecAttachPosition.fZ,vecAttachRotation.fX,vecAttachRotation.fY,vecAttachRotation.fZ,0);
+		}
+	}
+}
+
 void CObject::StreamIn()
 {
 	if(Create())
 	{
 		SetPosition(m_vecPosition);
 		SetRotation(m_vecRotation);
+		ApplyAttachment();
 	}
 }
 
@@ -99,6 +188,16 @@ void CObject::StreamOut()
 	Destroy();
 }
 
+void CObject::PrefetchModel()
+{
+	g_pModelManager->RequestModel(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+}
+
+bool CObject::IsModelLoaded()
+{
+	return g_pModelManager->IsModelReady(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+}
+
 void CObject::UpdateInterior(unsigned int uiInterior)
 {
 	Scripting::AddObjectToInteriorRoomByKey(m_uiObjectHandle, (Scripting::eInteriorRoomKey)uiInterior);
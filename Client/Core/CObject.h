@@ -11,6 +11,7 @@
 #pragma once
 
 #include "CStreamer.h"
+#include <Game/CMoveTimeline.h>
 
 class CObject : public CStreamableEntity
 {
@@ -24,13 +25,9 @@ private:
 	unsigned int	uiVehiclePlayerId;
 	CVector3		vecAttachPosition;
 	CVector3		vecAttachRotation;
+	unsigned int	uiAttachBone;
 	bool			m_bIsMoving;
-	bool			m_bIsRotating;
-	float			m_fMoveSpeed;
-	CVector3		m_vecMoveTarget;
-	CVector3		m_vecMoveStart;
-	CVector3		m_vecMoveTargetRot;
-	CVector3		m_vecMoveStartRot;
+	CMoveTimeline	m_moveTimeline;
 
 public:
 	CObject(DWORD dwModelHash, CVector3 vecPosition, CVector3 vecRotation);
@@ -45,27 +42,22 @@ public:
 	void GetRotation(CVector3& vecRotation);
 	unsigned int GetHandle() { return m_uiObjectHandle; }
 
-	bool		IsMoving() { return m_bIsMoving; }
-	void		SetIsMoving(bool bMoving) { m_bIsMoving = bMoving; }
-	CVector3	GetMoveTarget() { return m_vecMoveTarget; }
-	void		SetMoveTarget(const CVector3 &vec) { m_vecMoveTarget = vec; }
-	CVector3	GetStartPosititon() { return m_vecMoveStart; }
-	void		SetStartPosition(const CVector3 &vec) { m_vecMoveStart = vec; }
-
-	bool		IsRotating() { return m_bIsMoving; }
-	void		SetIsRotating(bool bRotating) { m_bIsRotating = bRotating; }
-	CVector3	GetMoveTargetRot() { return m_vecMoveTargetRot; }
-	void		SetMoveTargetRot(const CVector3 &vecRot) { m_vecMoveTargetRot = vecRot; }
-	CVector3	GetStartRotation() { return m_vecMoveStartRot; }
-	void		SetStartRotation(const CVector3 &vec) { m_vecMoveStartRot = vec; }
+	// The attachment is kept while the object is streamed out and applied when it is streamed in
+	void		SetAttachment(bool bToVehicle, unsigned int uiToVehiclePlayerId, const CVector3& vecPosition, const CVector3& vecRotation, unsigned int uiBone);
+	void		Detach();
+	void		ApplyAttachment();
 
-	float		GetMoveSpeed() { return m_fMoveSpeed; }
-	void		SetMoveSpeed(float fSpeed) { m_fMoveSpeed = fSpeed; }
-	void		MoveObject(const CVector3& vecTarget, const CVector3& vecRot, float fSpeed);
+	// The object moves along the timeline the server sent until its end
+	bool		IsMoving() { return m_bIsMoving; }
+	void		SetMoveTimeline(const CMoveTimeline& timeline) { m_moveTimeline = timeline; m_bIsMoving = true; }
+	void		StopMoving() { m_bIsMoving = false; }
+	void		ProcessMovement(unsigned long ulTime);
 
 	// Streaming
 	void GetStreamPosition(CVector3& vecPosition) { GetPosition(vecPosition); }
 	void UpdateInterior(unsigned int uiInterior);
 	void StreamIn();
 	void StreamOut();
+	void PrefetchModel();
+	bool IsModelLoaded();
 };
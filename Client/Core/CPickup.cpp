@@ -9,8 +9,11 @@
 
 #include "CPickup.h"
 #include "CLocalPlayer.h"
+#include "CGame.h"
+#include "CModelManager.h"
 
 extern CLocalPlayer * g_pLocalPlayer;
+extern CModelManager * g_pModelManager;
 extern CStreamer * g_pStreamer;
 
 CPickup::CPickup(DWORD dwModelHash, unsigned char ucType, unsigned int uiValue, CVector3 vecPosition, CVector3 vecRotation)
@@ -36,6 +39,12 @@ bool CPickup::Create()
 	// Are we not already created?
 	if(!IsSpawned())
 	{
+		// Keep the model loaded while the pickup exists
+		CIVModelInfo * pModelInfo = CGame::GetModelInfo(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+
+		if(pModelInfo)
+			pModelInfo->AddReference(false);
+
 		// Create the pickup
 		Scripting::CreatePickupRotate((Scripting::eModel)m_dwModelHash, (Scripting::ePickupType)m_ucType, m_uiValue, m_vecPosition.fX, m_vecPosition.fY, m_vecPosition.fZ, m_vecRotation.fX,  m_vecRotation.fY, m_vecRotation.fZ, &m_uiPickupHandle);
 		Scripting::AddPickupToInteriorRoomByKey(m_uiPickupHandle, (Scripting::eInteriorRoomKey)g_pLocalPlayer->GetInterior());
@@ -52,12 +61,18 @@ void CPickup::Destroy()
 	{
 		Scripting::RemovePickup(m_uiPickupHandle);
 		m_uiPickupHandle = 0;
+
+		CIVModelInfo * pModelInfo = CGame::GetModelInfo(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+
+		if(pModelInfo)
+			pModelInfo->RemoveReference();
 	}
 }
 
 void CPickup::SetPosition(const CVector3& vecPosition)
 {
 	m_vecPosition = vecPosition;
+	OnStreamPositionChanged();
 
 	// Are we streamed in?
 	if(IsStreamedIn())
@@ -125,3 +140,13 @@ void CPickup::StreamOut()
 {
 	Destroy();
 }
+
+void CPickup::PrefetchModel()
+{
+	g_pModelManager->RequestModel(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+}
+
+bool CPickup::IsModelLoaded()
+{
+	return g_pModelManager->IsModelReady(CGame::GetStreaming()->GetModelIndexFromHash(m_dwModelHash));
+}
@@ -40,4 +40,6 @@ public:
 	void         UpdateInterior(unsigned int uiInterior);
 	void         StreamIn();
 	void         StreamOut();
+	void         PrefetchModel();
+	bool         IsModelLoaded();
 };
@@ -14,10 +14,14 @@
 #include <CLogFile.h>
 #include "Scripting/CScriptingManager.h"
 #include "CEvents.h"
+#include "CNetworkManager.h"
+#include <SharedUtility.h>
+#include <algorithm>
 
 extern CChatWindow * g_pChatWindow;
 extern CScriptingManager * g_pScriptingManager;
 extern CEvents * g_pEvents;
+extern CNetworkManager * g_pNetworkManager;
 
 DWORD dwPlayerModelHashes[] = 
 {
@@ -219,6 +223,8 @@ CPlayerManager::CPlayerManager()
 		m_bCreated[x] = false;
 		m_pPlayers[x] = NULL;
 	}
+
+	m_ulLastSyncAckTime = 0;
 }
 
 CPlayerManager::~CPlayerManager()
@@ -243,7 +249,7 @@ void CPlayerManager::Add(EntityId playerId, String sPlayerName)
 
 	m_pPlayers[playerId]->SetPlayerId(playerId);
 	m_pPlayers[playerId]->SetName(sPlayerName);
-	m_bActive[playerId] = true;
+	SetActive(playerId, true);
 
 	if(g_pEvents)
 	{
@@ -267,7 +273,7 @@ bool CPlayerManager::Remove(EntityId playerId)
 		return false;
 	}
 
-	m_bActive[playerId] = false;
+	SetActive(playerId, false);
 
 	// Now the player won't be synced anymore, now we can delete him
 	// --
@@ -279,6 +285,9 @@ bool CPlayerManager::Remove(EntityId playerId)
 	m_pPlayers[playerId]->Destroy();
 	m_bCreated[playerId] = false;
 
+	// The player object is reused so forget its sync baselines
+	reinterpret_cast<CRemotePlayer *>(m_pPlayers[playerId])->ResetSyncState();
+
 	// Enable that if we have to destroy stuff  in cremoteplayer
 	/*CNetworkPlayer * pPlayer = GetAt(playerId);
 	if(pPlayer && !pPlayer->IsLocalPlayer())
@@ -337,6 +346,47 @@ void CPlayerManager::Pulse()
 				m_pPlayers[x]->Teleport(CVector3(0.0f, 0.0f, -20.0f));
 		}
 	}
+
+	// Is it time to acknowledge the in vehicle sync we received?
+	unsigned long ulTime = SharedUtility::GetFrameTime();
+
+	if((ulTime - m_ulLastSyncAckTime) >= SYNC_ACK_INTERVAL)
+	{
+		SendSyncAcks();
+		m_ulLastSyncAckTime = ulTime;
+	}
+}
+
+void CPlayerManager::SendSyncAcks()
+{
+	EntityId playerIds[MAX_PLAYERS];
+	unsigned char ucSequences[MAX_PLAYERS];
+	unsigned char ucCount = 0;
+
+	for(size_t i = 0; i < m_activePlayers.size(); i++)
+	{
+		EntityId x = m_activePlayers[i];
+
+		if(!m_pPlayers[x]->IsLocalPlayer() && reinterpret_cast<CRemotePlayer *>(m_pPlayers[x])->GetInVehicleAck(ucSequences[ucCount]))
+		{
+			playerIds[ucCount] = x;
+			ucCount++;
+		}
+	}
+
+	if(ucCount == 0)
+		return;
+
+	CBitStream bsSend;
+	bsSend.WriteCompressed(ucCount);
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		bsSend.WriteCompressed(playerIds[i]);
+		bsSend.Write(ucSequences[i]);
+	}
+
+	g_pNetworkManager->RPC(RPC_InVehicleSyncAck, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
 }
 
 CNetworkPlayer * CPlayerManager::GetAt(EntityId playerId)
@@ -349,16 +399,51 @@ CNetworkPlayer * CPlayerManager::GetAt(EntityId playerId)
 
 CNetworkPlayer * CPlayerManager::GetFrom(IVPed * pIVPed)
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	std::unordered_map<IVPed *, EntityId>::iterator iter = m_gamePeds.find(pIVPed);
+
+	if(iter == m_gamePeds.end())
+		return NULL;
+
+	// The game can reuse the memory of a ped, so make sure the player still has it
+	EntityId playerId = (*iter).second;
+
+	if(!DoesExist(playerId) || !m_bCreated[playerId])
+		return NULL;
+
+	CIVPlayerPed * pPlayerPed = m_pPlayers[playerId]->GetGamePlayerPed();
+
+	if(!pPlayerPed || pPlayerPed->GetPed() != pIVPed)
+		return NULL;
+
+	return m_pPlayers[playerId];
+}
+
+void CPlayerManager::SetGamePed(EntityId playerId, IVPed * pOldPed, IVPed * pNewPed)
+{
+	if(pOldPed)
 	{
-		if(m_bActive[i])
-		{
-			if(m_bCreated[i] && m_pPlayers[i]->GetGamePlayerPed()->GetPed() == pIVPed)
-				return m_pPlayers[i];
-		}
+		std::unordered_map<IVPed *, EntityId>::iterator iter = m_gamePeds.find(pOldPed);
+
+		if(iter != m_gamePeds.end() && (*iter).second == playerId)
+			m_gamePeds.erase(iter);
 	}
 
-	return NULL;
+	if(pNewPed && playerId != INVALID_ENTITY_ID)
+		m_gamePeds[pNewPed] = playerId;
+}
+
+void CPlayerManager::SetActive(EntityId playerId, bool bActive)
+{
+	if(m_bActive[playerId] == bActive)
+		return;
+
+	m_bActive[playerId] = bActive;
+	std::vector<EntityId>::iterator iter = std::lower_bound(m_activePlayers.begin(), m_activePlayers.end(), playerId);
+
+	if(bActive)
+		m_activePlayers.insert(iter, playerId);
+	else
+		m_activePlayers.erase(iter);
 }
 
 bool CPlayerManager::DoesExist(EntityId playerId)
@@ -371,19 +456,23 @@ bool CPlayerManager::DoesExist(EntityId playerId)
 
 void CPlayerManager::SetLocalPlayer(EntityId playerId, CNetworkPlayer * pPlayer)
 {
-	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	for(size_t i = 0; i < m_activePlayers.size(); i++)
 	{
-		if(m_bActive[x] && m_pPlayers[x]->IsLocalPlayer())
+		if(m_pPlayers[m_activePlayers[i]]->IsLocalPlayer())
 		{
-			m_bActive[x] = false;
+			SetActive(m_activePlayers[i], false);
 			break;
 		}
 	}
 
-	m_bActive[playerId] = true;
+	SetActive(playerId, true);
 	m_bCreated[playerId] = true;
 	m_pPlayers[playerId] = pPlayer;
 	g_pLocalPlayer->SetPlayerId(playerId);
+
+	// The local player ped was created before the player had an id
+	if(pPlayer->GetGamePlayerPed())
+		SetGamePed(playerId, NULL, pPlayer->GetGamePlayerPed()->GetPed());
 }
 
 
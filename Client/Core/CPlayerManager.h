@@ -13,6 +13,9 @@
 #include "CNetworkPlayer.h"
 #include "CLocalPlayer.h"
 #include "CIVPed.h"
+#include "CPlayerPedPool.h"
+#include <unordered_map>
+#include <vector>
 
 extern CLocalPlayer * g_pLocalPlayer;
 
@@ -25,6 +28,19 @@ private:
 	bool             m_bActive[MAX_PLAYERS];
 	bool             m_bCreated[MAX_PLAYERS];
 	CNetworkPlayer * m_pPlayers[MAX_PLAYERS];
+	unsigned long    m_ulLastSyncAckTime;
+
+	// Ids of the existing players (including the local player) in ascending order
+	std::vector<EntityId> m_activePlayers;
+
+	// The players by their game ped so the game hooks can find them without a scan
+	std::unordered_map<IVPed *, EntityId> m_gamePeds;
+
+	// The peds of the remote players that were destroyed, deleted after the players
+	CPlayerPedPool   m_pedPool;
+
+	void             SendSyncAcks();
+	void             SetActive(EntityId playerId, bool bActive);
 
 public:
 	CPlayerManager();
@@ -36,10 +52,15 @@ public:
 	void             Pulse();
 	void             SetLocalPlayer(EntityId playerId, CNetworkPlayer * pPlayer);
 
+	// Called by the players when their game ped is created, replaced or destroyed
+	void             SetGamePed(EntityId playerId, IVPed * pOldPed, IVPed * pNewPed);
+
 	bool             DoesExist(EntityId playerId);
 	bool			 IsActive(EntityId playerId) { return m_bActive[playerId]; }
 	static bool		 IsPlayerLimitReached ( void );
 
 	CNetworkPlayer * GetAt(EntityId playerId);
 	CNetworkPlayer * GetFrom(IVPed * pIVPed);
+	const std::vector<EntityId>& GetActivePlayers() { return m_activePlayers; }
+	CPlayerPedPool * GetPedPool() { return &m_pedPool; }
 };
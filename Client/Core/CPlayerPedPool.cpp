@@ -0,0 +1,123 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPlayerPedPool.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CPlayerPedPool.h"
+#include "CGame.h"
+#include "CPools.h"
+#include "Scripting.h"
+
+CPlayerPedPool::CPlayerPedPool()
+{
+
+}
+
+CPlayerPedPool::~CPlayerPedPool()
+{
+	DestroyAll();
+}
+
+bool CPlayerPedPool::Add(const PooledPlayerPed& ped)
+{
+	if(m_peds.size() >= PLAYER_PED_POOL_MAX)
+		return false;
+
+	int iModelIndex = ped.pModelInfo->GetIndex();
+	unsigned int uiModelPeds = 0;
+
+	for(std::list<PooledPlayerPed>::iterator iter = m_peds.begin(); iter != m_peds.end(); iter++)
+	{
+		if((*iter).pModelInfo->GetIndex() == iModelIndex)
+			uiModelPeds++;
+	}
+
+	if(uiModelPeds >= PLAYER_PED_POOL_MAX_PER_MODEL)
+		return false;
+
+	// Reset what the last player left on the ped before it leaves the world
+	Scripting::ClearCharTasksImmediately(CGame::GetPools()->GetPedPool()->HandleOf(ped.pPlayerPed->GetPed()));
+	ped.pPlayerPed->GetPedWeapons()->RemoveAllWeapons();
+	ped.pPlayerPed->RemoveFromWorld();
+	m_peds.push_back(ped);
+	return true;
+}
+
+bool CPlayerPedPool::Take(int iModelIndex, PooledPlayerPed& ped)
+{
+	for(std::list<PooledPlayerPed>::iterator iter = m_peds.begin(); iter != m_peds.end(); iter++)
+	{
+		if((*iter).pModelInfo->GetIndex() == iModelIndex)
+		{
+			ped = *iter;
+			m_peds.erase(iter);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CPlayerPedPool::DestroyOldest()
+{
+	if(m_peds.empty())
+		return false;
+
+	Destroy(m_peds.front());
+	m_peds.pop_front();
+	return true;
+}
+
+void CPlayerPedPool::DestroyAll()
+{
+	while(DestroyOldest());
+}
+
+void CPlayerPedPool::Destroy(const PooledPlayerPed& ped)
+{
+	// Get the player ped pointer
+	IVPlayerPed * pPlayerPed = ped.pPlayerPed->GetPlayerPed();
+
+	IVPedIntelligence * pPedIntelligence = pPlayerPed->m_pPedIntelligence;
+#define FUNC_ShutdownPedIntelligence 0x9C4DF0
+	DWORD dwFunc = (CGame::GetBase() + FUNC_ShutdownPedIntelligence);
+	_asm
+	{
+		push 0
+		mov ecx, pPedIntelligence
+		call dwFunc
+	}
+
+	*(DWORD *)(pPlayerPed + 0x260) &= 0xFFFFFFFE;
+
+	// Delete the player ped
+	// We use the CPed destructor and not the CPlayerPed destructor because the CPlayerPed destructor
+	// messes with our player info (which we handle manually)
+#define FUNC_CPed__ScalarDeletingDestructor 0x8ACAC0
+	dwFunc = (CGame::GetBase() + FUNC_CPed__ScalarDeletingDestructor);
+	_asm
+	{
+		push 1
+		mov ecx, pPlayerPed
+		call dwFunc
+	}
+
+	// Remove the model info reference of the ped
+	ped.pModelInfo->RemoveReference();
+
+	// Delete the context data instance
+	if(ped.pContextData)
+		CContextDataManager::DestroyContextData(ped.pContextData);
+
+	// Delete the player ped and player info instances
+	delete ped.pPlayerPed;
+	delete ped.pPlayerInfo;
+
+	// Reset game player info pointer
+	if(ped.bytePlayerNumber != INVALID_PLAYER_PED)
+		CGame::GetPools()->SetPlayerInfoAtIndex((unsigned int)ped.bytePlayerNumber, NULL);
+}
@@ -0,0 +1,59 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPlayerPedPool.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include "CIVPlayerPed.h"
+#include "CIVPlayerInfo.h"
+#include "CIVModelInfo.h"
+#include "CContextDataManager.h"
+
+// Maximum amount of hidden peds in the pool and of them with the same model
+#define PLAYER_PED_POOL_MAX 8
+#define PLAYER_PED_POOL_MAX_PER_MODEL 2
+
+// A game player ped with its player info that no player uses
+struct PooledPlayerPed
+{
+	BYTE            bytePlayerNumber;
+	CIVPlayerInfo * pPlayerInfo;
+	CContextData  * pContextData;
+	CIVPlayerPed  * pPlayerPed;
+	CIVModelInfo  * pModelInfo; // Keeps the reference of the ped to it
+};
+
+// Keeps the peds of remote players that were destroyed (died, streamed out or
+// left) hidden outside of the world, so spawning a player with the same model
+// again doesn't have to construct a ped and find a player number. The hidden
+// peds give their player numbers up if a new ped needs one.
+class CPlayerPedPool
+{
+private:
+	std::list<PooledPlayerPed> m_peds; // The oldest first
+
+public:
+	CPlayerPedPool();
+	~CPlayerPedPool();
+
+	// Hides the ped, returns false if the pool is full and the ped must be destroyed
+	bool        Add(const PooledPlayerPed& ped);
+
+	// Gets a hidden ped of the model, it is still outside of the world
+	bool        Take(int iModelIndex, PooledPlayerPed& ped);
+
+	// Destroys the oldest hidden ped so its player number is free, returns false
+	// if there is none
+	bool        DestroyOldest();
+	void        DestroyAll();
+
+	// Deletes the ped, its player info and its context data. The ped must not be
+	// in the world.
+	static void Destroy(const PooledPlayerPed& ped);
+};
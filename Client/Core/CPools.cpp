@@ -13,6 +13,7 @@
 CPools::CPools()
 	: m_pPedPool(NULL),
 	m_pVehiclePool(NULL),
+	m_pObjectPool(NULL),
 	m_pTaskPool(NULL),
 	m_pCamPool(NULL)
 {
@@ -29,6 +30,7 @@ CPools::~CPools()
 	// Delete game pools
 	SAFE_DELETE(m_pCamPool);
 	SAFE_DELETE(m_pTaskPool);
+	SAFE_DELETE(m_pObjectPool);
 	SAFE_DELETE(m_pVehiclePool);
 	SAFE_DELETE(m_pPedPool);
 }
@@ -38,6 +40,7 @@ void CPools::Initialize()
 	// Initialize game pools
 	m_pPedPool = new CIVPool<IVPed>(*(IVPool **)COffsets::VAR_PedPool);
 	m_pVehiclePool = new CIVPool<IVVehicle>(*(IVPool **)COffsets::VAR_VehiclePool);
+	m_pObjectPool = new CIVPool<IVEntity>(*(IVPool **)COffsets::VAR_ObjectPool);
 	m_pTaskPool = new CIVPool<IVTask>(*(IVPool **)COffsets::VAR_TaskPool);
 	m_pCamPool = new CIVPool<IVCam>(*(IVPool **)COffsets::VAR_CamPool);
 	//m_pTrainPool = new CIVPool<IVTrain>(*(IVPool **)COffsets::VAR_TrainPool);
@@ -37,7 +37,7 @@ private:
 	CIVPool<IVPed>     * m_pPedPool;
 	CIVPool<IVVehicle> * m_pVehiclePool; // Size: 140
 	//#define VAR_BuildingPool_7 0x168FED0
-	//#define VAR_ObjectPool_7 0x1350CE0
+	CIVPool<IVEntity>  * m_pObjectPool; // Size: 1300
 	CIVPool<IVTask>    * m_pTaskPool; // Size: 1200
 	//#define VAR_EventPool_7 0x152F4B4 // Size: 300
 	CIVPool<IVCam>     * m_pCamPool;
@@ -58,6 +58,7 @@ public:
 	CIVPool<IVVehicle> * GetVehiclePool() { return m_pVehiclePool; }
 	CIVPool<IVTask>    * GetTaskPool() { return m_pTaskPool; }
 	CIVPool<IVCam>     * GetCamPool() { return m_pCamPool; }
+	CIVPool<IVEntity>  * GetObjectPool() { return m_pObjectPool; }
 
 	// Player Infos (An array not a pool)
 	IVPlayerInfo       * GetPlayerInfoFromIndex(unsigned int uiIndex);
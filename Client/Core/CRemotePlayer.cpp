@@ -28,7 +28,9 @@ CRemotePlayer::CRemotePlayer()
 	m_vehicleId(INVALID_ENTITY_ID),
 	m_stateType(STATE_TYPE_DISCONNECT),
 	m_bPassenger(false),
-	m_pLastSyncData(NULL)
+	m_pLastSyncData(NULL),
+	m_bInVehicleAckPending(false),
+	m_ucInVehicleAckSequence(0)
 {
 }
 
@@ -96,7 +98,7 @@ void CRemotePlayer::Init()
 	}
 }
 
-void CRemotePlayer::StoreOnFootSync(OnFootSyncData * syncPacket)
+void CRemotePlayer::StoreOnFootSync(OnFootSyncData * syncPacket, unsigned long ulSyncTime)
 {
 	// Check if the player isn't avaiable(disconnect etc)
 	if(!g_pPlayerManager->IsActive(GetPlayerId()))
@@ -115,8 +117,8 @@ void CRemotePlayer::StoreOnFootSync(OnFootSyncData * syncPacket)
 	else
 		return;*/
 
-	// Set our position
-	SetTargetPosition(syncPacket->vecPos, TICK_RATE*2);
+	// Buffer our position, it is interpolated between the buffered positions
+	AddTargetSnapshot(ulSyncTime, syncPacket->vecPos);
 
 	// Set our heading
 	SetCurrentSyncHeading(syncPacket->fHeading);
@@ -176,7 +178,7 @@ void CRemotePlayer::StoreOnFootSync(OnFootSyncData * syncPacket)
 	m_stateType = STATE_TYPE_ONFOOT;
 }
 
-void CRemotePlayer::StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * syncPacket)
+void CRemotePlayer::StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * syncPacket, unsigned long ulSyncTime)
 {
 	// Check if the player isn't avaiable(disconnect etc)
 	if(!g_pPlayerManager->IsActive(GetPlayerId()))
@@ -211,8 +213,8 @@ void CRemotePlayer::StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * s
 		// Set their control state
 		SetControlState(&syncPacket->controlState);
 
-		// Set their vehicles target position
-		pVehicle->SetTargetPosition(syncPacket->vecPos, TICK_RATE/**2*/);
+		// Buffer their vehicles position, it is interpolated between the buffered positions
+		pVehicle->AddTargetSnapshot(ulSyncTime, syncPacket->vecPos, syncPacket->vecRotation, syncPacket->vecMoveSpeed, syncPacket->vecTurnSpeed);
 
 		// Set their vehicles target rotation
 		pVehicle->SetTargetRotation(syncPacket->vecRotation, TICK_RATE/**2*/);
@@ -234,13 +236,6 @@ void CRemotePlayer::StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * s
 		pVehicle->SetHealth(syncPacket->uiHealth);
 		pVehicle->SetPetrolTankHealth(syncPacket->fPetrolHealth);
 
-		// Set their door states
-		for(int i = 0; i <= 5; i++)
-		{
-			if(pVehicle->GetCarDoorAngle(i) != syncPacket->fDoor[i])
-				pVehicle->SetCarDoorAngle(i,false,syncPacket->fDoor[i]);
-		}
-
 		// Check if color set is needed
 		BYTE byteColors[4];
 		pVehicle->GetColors(byteColors[0],byteColors[1],byteColors[2],byteColors[3]);
@@ -259,17 +254,6 @@ void CRemotePlayer::StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * s
 		// Set their vehicles siren state
 		if(pVehicle->GetSirenState() != syncPacket->bSirenState)
 			pVehicle->SetSirenState(syncPacket->bSirenState);
-		
-		// Set their windows
-		for(int i = 0; i <= 3; i++)
-			pVehicle->SetWindowState(i, syncPacket->bWindow[i]);
-
-		// Set their typres
-		for(int i = 0; i <= 5; i++)
-		{
-			if(syncPacket->bTyre[i])
-				Scripting::BurstCarTyre(pVehicle->GetScriptingHandle(),(Scripting::eVehicleTyre)i);
-		}
 
 		// Set their vehicles dirt level
 		if(pVehicle->GetDirtLevel() != syncPacket->fDirtLevel)
@@ -420,3 +404,21 @@ void CRemotePlayer::SetColor(unsigned int uiColor)
 		Scripting::ChangeBlipColour(GetBlip(), uiColor);
 
 }
+
+bool CRemotePlayer::GetInVehicleAck(unsigned char &ucSequence)
+{
+	if(!m_bInVehicleAckPending)
+		return false;
+
+	ucSequence = m_ucInVehicleAckSequence;
+	m_bInVehicleAckPending = false;
+	return true;
+}
+
+void CRemotePlayer::ResetSyncState()
+{
+	m_animState.Reset();
+	m_lookState.Reset();
+	m_inVehicleSnapshots.Reset();
+	m_bInVehicleAckPending = false;
+}
@@ -11,6 +11,7 @@
 
 #include "CNetworkPlayer.h"
 #include "Scripting.h"
+#include <Network/CSyncSerializer.h>
 
 class CRemotePlayer : public CNetworkPlayer
 {
@@ -25,6 +26,11 @@ private:
 	String				m_strAnimGroup;
 	String				m_strAnimSpec;
 	OnFootSyncData	   *m_pLastSyncData;
+	CSyncAnimState		m_animState;
+	CSyncLookState		m_lookState;
+	CSyncSnapshotHistory m_inVehicleSnapshots;
+	bool				m_bInVehicleAckPending;
+	unsigned char		m_ucInVehicleAckSequence;
 
 public:
 	CRemotePlayer();
@@ -35,8 +41,14 @@ public:
 	void         Kill();
 	void         Init();
 
-	void         StoreOnFootSync(OnFootSyncData * syncPacket);
-	void         StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * syncPacket);
+	CSyncAnimState * GetAnimState() { return &m_animState; }
+	CSyncLookState * GetLookState() { return &m_lookState; }
+	CSyncSnapshotHistory * GetInVehicleSnapshots() { return &m_inVehicleSnapshots; }
+	void         SetInVehicleAck(unsigned char ucSequence) { m_ucInVehicleAckSequence = ucSequence; m_bInVehicleAckPending = true; }
+	bool         GetInVehicleAck(unsigned char &ucSequence);
+	void         ResetSyncState();
+	void         StoreOnFootSync(OnFootSyncData * syncPacket, unsigned long ulSyncTime);
+	void         StoreInVehicleSync(EntityId vehicleId, InVehicleSyncData * syncPacket, unsigned long ulSyncTime);
 	void         StorePassengerSync(EntityId vehicleId, PassengerSyncData * syncPacket);
 	void         StoreSmallSync(SmallSyncData * syncPacket);
 
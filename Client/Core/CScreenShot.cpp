@@ -8,33 +8,47 @@
 //==============================================================================
 // Parts taken from code found on the Irrlicht forums
 
+#include <stdio.h>
+#include <setjmp.h>
 #include "CScreenShot.h"
 #include "../../Vendor/lpng142/png.h"
+extern "C"
+{
+#include "../../Vendor/jpeg-6b/jpeglib.h"
+}
 #include "DXSDK/Include/d3d9.h"
 #include "SharedUtility.h"
-#include "CGame.h"
-#include "CGUI.h"
-
-#define SCREEN_SHOT_FORMAT D3DFMT_A8R8G8B8
-#define SCREEN_SHOT_FORMAT_BYTES_PER_PIXEL (32 / 8)
-
-unsigned long           CScreenShot::m_ulLastScreenShotTime = 0;
-CThread                 CScreenShot::m_writeThread;
-unsigned char         * CScreenShot::m_ucData = NULL;
-unsigned int            CScreenShot::m_uiScreenWidth = 0;
-unsigned int            CScreenShot::m_uiScreenHeight = 0;
-CMutex                  CScreenShot::m_threadDataMutex;
-CScreenShot::ThreadData CScreenShot::m_threadData;
+#include "CSettings.h"
+
+unsigned long               CScreenShot::m_ulLastScreenShotTime = 0;
+unsigned int                CScreenShot::m_uiRequestedCaptures = 0;
+CScreenShot::Capture        CScreenShot::m_captures[SCREEN_SHOT_BUFFERS];
+unsigned int                CScreenShot::m_uiCurrentCapture = 0;
+unsigned int                CScreenShot::m_uiCaptureWidth = 0;
+unsigned int                CScreenShot::m_uiCaptureHeight = 0;
+D3DFORMAT                   CScreenShot::m_captureFormat = D3DFMT_UNKNOWN;
+CThread                     CScreenShot::m_writeThread;
+CMutex                      CScreenShot::m_queueMutex;
+std::list<CScreenShot::Image>  CScreenShot::m_writeQueue;
+std::list<CScreenShot::Result> CScreenShot::m_results;
+bool                        CScreenShot::m_bWriting = false;
+String                      CScreenShot::m_strError;
 
 extern IDirect3DDevice9 * g_pDevice;
-extern CGUI             * g_pGUI;
 
-CScreenShot::CScreenShot()
+// libjpeg calls exit on errors by default, jump back to the write instead
+struct ScreenShotJpegError
+{
+	jpeg_error_mgr pub;
+	jmp_buf        jmpBuffer;
+};
+
+static void JpegErrorExit(j_common_ptr cinfo)
 {
-	Reset();
+	longjmp(((ScreenShotJpegError *)cinfo->err)->jmpBuffer, 1);
 }
 
-String CScreenShot::GetScreenShotPath()
+String CScreenShot::GetScreenShotPath(const char * szExtension)
 {
 	// Get the screen shot directory
 	String strPath(SharedUtility::GetAbsolutePath("screenshots"));
@@ -43,381 +57,441 @@ String CScreenShot::GetScreenShotPath()
 	if(!SharedUtility::Exists(strPath))
 		SharedUtility::CreateDirectory(strPath);
 
-	// Append the screen shot name to the path
+	// Append the screen shot name to the path (with the milliseconds as more than one can be taken per second)
 	SYSTEMTIME systemTime;
 	GetLocalTime(&systemTime);
-	strPath.AppendF("/ivmp-%04d.%02d.%02d-%02d.%02d.%02d.png", systemTime.wYear, systemTime.wMonth, systemTime.wDay, systemTime.wHour, systemTime.wMinute, systemTime.wSecond);
+	strPath.AppendF("/ivmp-%04d.%02d.%02d-%02d.%02d.%02d.%03d.%s", systemTime.wYear, systemTime.wMonth, systemTime.wDay, systemTime.wHour, systemTime.wMinute, systemTime.wSecond, systemTime.wMilliseconds, szExtension);
 	return strPath;
 }
 
-void CScreenShot::WriteImageToFile(CThread * pThread)
+bool CScreenShot::CreateSurfaces(const D3DSURFACE_DESC& desc)
 {
-	// Lock the thread data mutex now
-	m_threadDataMutex.Lock();
-	m_threadData.bWriting = true;
+	// Do we already have surfaces for this back buffer?
+	if(m_captures[0].pRenderTarget && desc.Width == m_uiCaptureWidth && desc.Height == m_uiCaptureHeight && desc.Format == m_captureFormat)
+		return true;
 
-	// Get the screen shot path
-	String strPath = GetScreenShotPath();
+	ReleaseSurfaces();
 
-	// Open the screen shot file
-	FILE * fScreenshot = fopen(strPath, "wb");
+	for(unsigned int i = 0; i < SCREEN_SHOT_BUFFERS; i++)
+	{
+		Capture * pCapture = &m_captures[i];
+
+		if(FAILED(g_pDevice->CreateRenderTarget(desc.Width, desc.Height, desc.Format, D3DMULTISAMPLE_NONE, 0, FALSE, &pCapture->pRenderTarget, NULL)) ||
+			FAILED(g_pDevice->CreateOffscreenPlainSurface(desc.Width, desc.Height, desc.Format, D3DPOOL_SYSTEMMEM, &pCapture->pSystemSurface, NULL)) ||
+			FAILED(g_pDevice->CreateQuery(D3DQUERYTYPE_EVENT, &pCapture->pQuery)))
+		{
+			ReleaseSurfaces();
+			return false;
+		}
+	}
 
-	// Ensure the screen shot file is open
-	if(!fScreenshot)
+	m_uiCaptureWidth = desc.Width;
+	m_uiCaptureHeight = desc.Height;
+	m_captureFormat = desc.Format;
+	return true;
+}
+
+void CScreenShot::ReleaseSurfaces()
+{
+	for(unsigned int i = 0; i < SCREEN_SHOT_BUFFERS; i++)
 	{
-		// Delete the image data
-		delete [] m_ucData;
+		Capture * pCapture = &m_captures[i];
+
+		// Was the capture not read back yet?
+		if(pCapture->bPending)
+			AddResult(false, "Device lost");
+
+		if(pCapture->pRenderTarget)
+			pCapture->pRenderTarget->Release();
 
-		// Flag the write as not succeeded
-		m_threadData.bSucceeded = false;
-		m_threadData.strError = "Failed to open screen shot file";
+		if(pCapture->pSystemSurface)
+			pCapture->pSystemSurface->Release();
 
-		// Unlock the thread data mutex
-		m_threadDataMutex.Unlock();
-		return;
+		if(pCapture->pQuery)
+			pCapture->pQuery->Release();
+
+		memset(pCapture, 0, sizeof(Capture));
 	}
 
-	// Allocate the png write struct
-	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, /*(png_error_ptr)png_cpexcept_error*/NULL, NULL);
+	m_uiCurrentCapture = 0;
+	m_uiCaptureWidth = 0;
+	m_uiCaptureHeight = 0;
+	m_captureFormat = D3DFMT_UNKNOWN;
+}
 
-	// Ensure the png write struct was allocated
-	if(!png_ptr)
+bool CScreenShot::StartCapture()
+{
+	// Are all copies still being filled in? (try again next frame)
+	Capture * pCapture = &m_captures[m_uiCurrentCapture];
+
+	if(pCapture->bPending)
+		return false;
+
+	// Get the back buffer
+	IDirect3DSurface9 * pBackBuffer = NULL;
+
+	if(FAILED(g_pDevice->GetBackBuffer(0, 0, D3DBACKBUFFER_TYPE_MONO, &pBackBuffer)))
 	{
-		// Delete the image data
-		delete [] m_ucData;
+		AddResult(false, "Failed to get back buffer");
+		return true;
+	}
 
-		// Close the screen shot file
-		fclose(fScreenshot);
+	D3DSURFACE_DESC desc;
+	pBackBuffer->GetDesc(&desc);
 
-		// Flag the write as not succeeded
-		m_threadData.bSucceeded = false;
-		m_threadData.strError = "Failed to allocate memory";
+	// Ensure it's a format we can write
+	if(desc.Format != D3DFMT_X8R8G8B8 && desc.Format != D3DFMT_A8R8G8B8)
+	{
+		pBackBuffer->Release();
+		AddResult(false, "Unsupported back buffer format");
+		return true;
+	}
 
-		// Unlock the thread data mutex
-		m_threadDataMutex.Unlock();
-		return;
+	// Create the surfaces to copy the back buffer into (if needed)
+	if(!CreateSurfaces(desc))
+	{
+		pBackBuffer->Release();
+		AddResult(false, "Failed to create surface");
+		return true;
 	}
 
-	// Allocate the png info struct
-	png_infop info_ptr = png_create_info_struct(png_ptr);
+	// Copy the back buffer on the gpu and mark when it's done
+	pCapture = &m_captures[m_uiCurrentCapture];
+	HRESULT hr = g_pDevice->StretchRect(pBackBuffer, NULL, pCapture->pRenderTarget, NULL, D3DTEXF_NONE);
+	pBackBuffer->Release();
 
-	// Ensure the png info struct was allocated
-	if(!info_ptr)
+	if(FAILED(hr))
 	{
-		// Destroy the png write struct
-		png_destroy_write_struct(&png_ptr, NULL);
+		AddResult(false, "Failed to copy back buffer");
+		return true;
+	}
 
-		// Delete the image data
-		delete [] m_ucData;
+	pCapture->pQuery->Issue(D3DISSUE_END);
+	pCapture->bPending = true;
+	m_uiCurrentCapture = ((m_uiCurrentCapture + 1) % SCREEN_SHOT_BUFFERS);
+	return true;
+}
 
-		// Close the screen shot file
-		fclose(fScreenshot);
+bool CScreenShot::ReadCapture(Capture * pCapture)
+{
+	// Is the gpu not done with the copy yet? (never wait for it)
+	if(pCapture->pQuery->GetData(NULL, 0, 0) == S_FALSE)
+		return false;
 
-		// Flag the write as not succeeded
-		m_threadData.bSucceeded = false;
-		m_threadData.strError = "Failed to allocate memory";
+	pCapture->bPending = false;
 
-		// Unlock the thread data mutex
-		m_threadDataMutex.Unlock();
-		return;
+	// Read the copy back, the gpu is done with it so this doesn't stall
+	if(FAILED(g_pDevice->GetRenderTargetData(pCapture->pRenderTarget, pCapture->pSystemSurface)))
+	{
+		AddResult(false, "Failed to read back buffer");
+		return true;
 	}
 
-	// Set the png file pointer
-	png_init_io(png_ptr, fScreenshot);
+	// Lock the surface
+	D3DLOCKED_RECT lockedRect;
 
-	// Set the png write struct info
-	png_set_IHDR(png_ptr, info_ptr, m_uiScreenWidth, m_uiScreenHeight, 8, 
-		PNG_COLOR_TYPE_RGB_ALPHA, PNG_INTERLACE_NONE, 
-		PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	if(FAILED(pCapture->pSystemSurface->LockRect(&lockedRect, NULL, D3DLOCK_READONLY)))
+	{
+		AddResult(false, "Failed to lock surface");
+		return true;
+	}
 
-	// Get the line width
-	unsigned int uiLineWidth = (m_uiScreenWidth * SCREEN_SHOT_FORMAT_BYTES_PER_PIXEL);
+	// Allocate the image data
+	Image image;
+	image.uiWidth = m_uiCaptureWidth;
+	image.uiHeight = m_uiCaptureHeight;
+	image.ucData = new unsigned char[image.uiWidth * image.uiHeight * 4];
+	image.format = ((CVAR_GET_STRING("screenshotformat") == "jpg") ? SCREEN_SHOT_FORMAT_JPEG : SCREEN_SHOT_FORMAT_PNG);
+	image.iQuality = CVAR_GET_INTEGER("screenshotquality");
 
-	// Allocate the temporary image data
-	unsigned char * tmpImage = new unsigned char[m_uiScreenHeight * uiLineWidth];
+	// Sort the image data (d3d pads the image, so we need to copy the correct number of bytes)
+	unsigned int * dP = (unsigned int *)image.ucData;
+	unsigned char * sP = (unsigned char *)lockedRect.pBits;
 
-	// Ensure the temporary image data was allocated
-	if(!tmpImage)
+	// The alpha of X8R8G8B8 isn't defined so set each pixel alpha value to 255
+	if(m_captureFormat == D3DFMT_X8R8G8B8)
 	{
-		// Destroy the png write and info struct
-		png_destroy_write_struct(&png_ptr, &info_ptr);
+		for(unsigned int y = 0; y < image.uiHeight; y++)
+		{
+			for(unsigned int x = 0; x < image.uiWidth; x++)
+			{
+				*dP = *((unsigned int *)sP) | 0xFF000000;
+				dP++;
+				sP += 4;
+			}
 
-		// Delete the image data
-		delete [] m_ucData;
+			sP += lockedRect.Pitch - (4 * image.uiWidth);
+		}
+	}
+	else
+	{
+		for(unsigned int y = 0; y < image.uiHeight; y++)
+		{
+			memcpy(dP, sP, image.uiWidth * 4);
 
-		// Close the screen shot file
-		fclose(fScreenshot);
+			sP += lockedRect.Pitch;
+			dP += image.uiWidth;
+		}
+	}
 
-		// Flag the write as not succeeded
-		m_threadData.bSucceeded = false;
-		m_threadData.strError = "Failed to allocate memory";
+	// Unlock the surface
+	pCapture->pSystemSurface->UnlockRect();
 
-		// Unlock the thread data mutex
-		m_threadDataMutex.Unlock();
-		return;
-	}
+	// Queue the image for the write thread and start it if it isn't writing already
+	m_queueMutex.Lock();
+	m_writeQueue.push_back(image);
+	bool bStartThread = !m_bWriting;
+	m_bWriting = true;
+	m_queueMutex.Unlock();
 
-	// Copy the image data into the temporary image data
-	memcpy(tmpImage, m_ucData, (m_uiScreenHeight * uiLineWidth));
+	if(bStartThread)
+		m_writeThread.Start(WriteImagesToFile);
 
-	// Allocate the row pointers array
-	unsigned char ** ucRowPointers = new png_bytep[m_uiScreenHeight];
+	return true;
+}
 
-	// Ensure the row pointers array was allocated
-	if(!ucRowPointers)
-	{
-		// Delete the temporary image data
-		delete [] tmpImage;
+void CScreenShot::AddResult(bool bSucceeded, String strResult)
+{
+	Result result;
+	result.bSucceeded = bSucceeded;
+	result.strResult = strResult;
 
-		// Destroy the png write and info struct
-		png_destroy_write_struct(&png_ptr, &info_ptr);
+	m_queueMutex.Lock();
+	m_results.push_back(result);
+	m_queueMutex.Unlock();
+}
 
-		// Delete the image data
-		delete [] m_ucData;
+bool CScreenShot::WritePng(FILE * pFile, const Image& image, String& strError)
+{
+	// Allocate the png write struct
+	png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
 
-		// Close the screen shot file
-		fclose(fScreenshot);
+	// Ensure the png write struct was allocated
+	if(!png_ptr)
+	{
+		strError = "Failed to allocate memory";
+		return false;
+	}
 
-		// Flag the write as not succeeded
-		m_threadData.bSucceeded = false;
-		m_threadData.strError = "Failed to allocate memory";
+	// Allocate the png info struct
+	png_infop info_ptr = png_create_info_struct(png_ptr);
 
-		// Unlock the thread data mutex
-		m_threadDataMutex.Unlock();
-		return;
+	// Ensure the png info struct was allocated
+	if(!info_ptr)
+	{
+		png_destroy_write_struct(&png_ptr, NULL);
+		strError = "Failed to allocate memory";
+		return false;
 	}
 
-	// Fill row pointers array
-	for(unsigned int i = 0; i < m_uiScreenHeight; ++i)
-		ucRowPointers[i] = (tmpImage + (uiLineWidth * i));
+	// Set the png file pointer
+	png_init_io(png_ptr, pFile);
+
+	// Use the fastest compression, the default takes several times longer for a slightly smaller file
+	png_set_compression_level(png_ptr, Z_BEST_SPEED);
+	png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, PNG_FILTER_SUB);
+
+	// Set the png write struct info (without the alpha, it's always 255)
+	png_set_IHDR(png_ptr, info_ptr, image.uiWidth, image.uiHeight, 8,
+		PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+		PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+	// Allocate and fill the row pointers array
+	unsigned int uiLineWidth = (image.uiWidth * 4);
+	unsigned char ** ucRowPointers = new png_bytep[image.uiHeight];
+
+	for(unsigned int i = 0; i < image.uiHeight; ++i)
+		ucRowPointers[i] = (image.ucData + (uiLineWidth * i));
 
 	// Set the png rows
 	png_set_rows(png_ptr, info_ptr, ucRowPointers);
 
 	// Write the png
-	png_write_png(png_ptr, info_ptr, PNG_TRANSFORM_BGR, NULL);
+	png_write_png(png_ptr, info_ptr, (PNG_TRANSFORM_BGR | PNG_TRANSFORM_STRIP_FILLER_AFTER), NULL);
 
 	// Delete the row pointers array
 	delete [] ucRowPointers;
 
-	// Delete the temporary image data
-	delete [] tmpImage;
-
 	// Destroy the png write and info struct
 	png_destroy_write_struct(&png_ptr, &info_ptr);
-
-	// Delete the image data
-	delete [] m_ucData;
-
-	// Close the screen shot file
-	fclose(fScreenshot);
-
-	// Flag the write as succeeded
-	m_threadData.bSucceeded = true;
-	m_threadData.strWriteName = strPath;
-
-	// Unlock the thread data mutex
-	m_threadDataMutex.Unlock();
-	/*return true;*/
+	return true;
 }
 
-bool CScreenShot::Take()
+bool CScreenShot::WriteJpeg(FILE * pFile, const Image& image, String& strError)
 {
-	// Ensure we are not already taking a screen shot
-	if(m_writeThread.IsRunning())
-	{
-		// Flag the write as not succeeded
-		m_threadData.strError = "Screen shot already being taken";
-		return false;
-	}
+	jpeg_compress_struct cinfo;
+	ScreenShotJpegError jerr;
+	unsigned char * ucRow = new unsigned char[image.uiWidth * 3];
 
-	// Only allow one screen shot per second to avoid abuse
-	if((SharedUtility::GetTime() - m_ulLastScreenShotTime) < 1000)
+	// Set up the error handler
+	cinfo.err = jpeg_std_error(&jerr.pub);
+	jerr.pub.error_exit = JpegErrorExit;
+
+	if(setjmp(jerr.jmpBuffer))
 	{
-		// Flag the write as not succeeded
-		m_threadData.strError = "You must wait 1 second between screen shots";
+		jpeg_destroy_compress(&cinfo);
+		delete [] ucRow;
+		strError = "Failed to write jpeg";
 		return false;
 	}
 
-	// Get the screen display mode
-	D3DDISPLAYMODE displayMode;
-	g_pDevice->GetDisplayMode(0, &displayMode);
+	jpeg_create_compress(&cinfo);
+	jpeg_stdio_dest(&cinfo, pFile);
+	cinfo.image_width = image.uiWidth;
+	cinfo.image_height = image.uiHeight;
+	cinfo.input_components = 3;
+	cinfo.in_color_space = JCS_RGB;
+	jpeg_set_defaults(&cinfo);
+	jpeg_set_quality(&cinfo, image.iQuality, TRUE);
+	jpeg_start_compress(&cinfo, TRUE);
+
+	while(cinfo.next_scanline < cinfo.image_height)
+	{
+		// Convert the row from BGRA to RGB
+		unsigned char * sP = (image.ucData + (cinfo.next_scanline * image.uiWidth * 4));
+		unsigned char * dP = ucRow;
 
-	// Create the image surface to store the front buffer image
-	IDirect3DSurface9 * pSurface;
+		for(unsigned int x = 0; x < image.uiWidth; x++)
+		{
+			dP[0] = sP[2];
+			dP[1] = sP[1];
+			dP[2] = sP[0];
+			dP += 3;
+			sP += 4;
+		}
 
-	if(FAILED(g_pDevice->CreateOffscreenPlainSurface(displayMode.Width, displayMode.Height, SCREEN_SHOT_FORMAT, D3DPOOL_SCRATCH, &pSurface, NULL)))
-	{
-		// Flag the write as not succeeded
-		m_threadData.strError = "Failed to create surface";
-		return false;
+		JSAMPROW row = ucRow;
+		jpeg_write_scanlines(&cinfo, &row, 1);
 	}
 
-	// Read the front buffer into the image surface
-	if(FAILED(g_pDevice->GetFrontBufferData(0, pSurface)))
+	jpeg_finish_compress(&cinfo);
+	jpeg_destroy_compress(&cinfo);
+	delete [] ucRow;
+	return true;
+}
+
+void CScreenShot::WriteImagesToFile(CThread * pThread)
+{
+	while(true)
 	{
-		// Release the surface
-		pSurface->Release();
+		// Get the next image to write (or exit if there is none)
+		m_queueMutex.Lock();
 
-		// Flag the write as not succeeded
-		m_threadData.strError = "Failed to get front buffer";
-		return false;
-	}
+		if(m_writeQueue.empty())
+		{
+			m_bWriting = false;
+			m_queueMutex.Unlock();
+			return;
+		}
 
-	// Get the screen width and height
-	unsigned int uiScreenWidth = g_pGUI->GetDisplayWidth();
-	unsigned int uiScreenHeight = g_pGUI->GetDisplayHeight();
+		Image image = m_writeQueue.front();
+		m_writeQueue.pop_front();
+		m_queueMutex.Unlock();
 
-	// Create the client rect
-	RECT clientRect;
-	{
-		POINT clientPoint;
-		clientPoint.x = 0;
-		clientPoint.y = 0;
-		ClientToScreen(CGame::GetHWnd(), &clientPoint);
-		clientRect.left   = clientPoint.x;
-		clientRect.top	  = clientPoint.y;
-		clientRect.right  = (clientRect.left + uiScreenWidth);
-		clientRect.bottom = (clientRect.top  + uiScreenHeight);
-	}
+		// Get the screen shot path
+		String strPath = GetScreenShotPath((image.format == SCREEN_SHOT_FORMAT_JPEG) ? "jpg" : "png");
 
-	// Lock the surface
-	D3DLOCKED_RECT lockedRect;
+		// Open the screen shot file
+		FILE * fScreenshot = fopen(strPath, "wb");
 
-	if(FAILED(pSurface->LockRect(&lockedRect, &clientRect, D3DLOCK_READONLY)))
-	{
-		// Release the surface
-		pSurface->Release();
+		// Ensure the screen shot file is open
+		if(!fScreenshot)
+		{
+			delete [] image.ucData;
+			AddResult(false, "Failed to open screen shot file");
+			continue;
+		}
 
-		// Flag the write as not succeeded
-		m_threadData.strError = "Failed to lock surface";
-		return false;
-	}
+		// Write the image
+		String strError;
+		bool bSucceeded;
 
-	// Get the line width
-	unsigned int uiLineWidth = (uiScreenWidth * SCREEN_SHOT_FORMAT_BYTES_PER_PIXEL);
+		if(image.format == SCREEN_SHOT_FORMAT_JPEG)
+			bSucceeded = WriteJpeg(fScreenshot, image, strError);
+		else
+			bSucceeded = WritePng(fScreenshot, image, strError);
 
-	// Allocate the image data
-	unsigned char * ucData =  new unsigned char[uiScreenHeight * uiLineWidth];
+		// Close the screen shot file
+		fclose(fScreenshot);
 
-	// Ensure the image data was allocated
-	if(!ucData)
-	{
-		// Unlock the surface
-		pSurface->UnlockRect();
+		// Delete the image data
+		delete [] image.ucData;
 
-		// Release the surface
-		pSurface->Release();
+		AddResult(bSucceeded, (bSucceeded ? strPath : strError));
+	}
+}
 
-		// Flag the write as not succeeded
-		m_threadData.strError = "Failed to allocate memory";
+bool CScreenShot::Take()
+{
+	// Only allow a screen shot every SCREEN_SHOT_INTERVAL ms to avoid abuse
+	if((SharedUtility::GetTime() - m_ulLastScreenShotTime) < SCREEN_SHOT_INTERVAL)
+	{
+		m_strError = "You must wait between screen shots";
 		return false;
 	}
 
-	// Sort the image data (d3d pads the image, so we need to copy the correct number of bytes)
-	unsigned int * dP = (unsigned int *)ucData;
-	unsigned char * sP = (unsigned char *)lockedRect.pBits;
+	// Ensure there aren't too many screen shots waiting already
+	unsigned int uiWaiting = m_uiRequestedCaptures;
 
-	// If the display mode format doesn't promise anything about the Alpha value
-	// and it appears that it's not presenting 255, then we should manually
-	// set each pixel alpha value to 255
-	if((displayMode.Format == D3DFMT_X8R8G8B8) && (0xFF000000 != (*dP & 0xFF000000)))
-	{
-		for(unsigned int y = 0; y < uiScreenHeight; y++)
-		{
-			for(unsigned int x = 0; x < uiScreenWidth; x++)
-			{
-				*dP = *((unsigned int *)sP) | 0xFF000000;
-				dP++;
-				sP += 4;
-			}
-
-			sP += lockedRect.Pitch - (4 * uiScreenWidth);
-		}
-	}
-	else
+	for(unsigned int i = 0; i < SCREEN_SHOT_BUFFERS; i++)
 	{
-		for(unsigned int y = 0; y < uiScreenHeight; y++)
-		{
-			memcpy(dP, sP, uiScreenWidth * 4);
-
-			sP += lockedRect.Pitch;
-			dP += uiScreenWidth;
-		}
+		if(m_captures[i].bPending)
+			uiWaiting++;
 	}
 
-	// Unlock the surface
-	pSurface->UnlockRect();
+	m_queueMutex.Lock();
+	uiWaiting += m_writeQueue.size();
+	m_queueMutex.Unlock();
 
-	// Release the surface
-	pSurface->Release();
+	if(uiWaiting >= SCREEN_SHOT_MAX_QUEUED)
+	{
+		m_strError = "Too many screen shots are being taken";
+		return false;
+	}
 
-	// Write the image to a file
-	m_ucData = ucData;
-	m_uiScreenWidth = uiScreenWidth;
-	m_uiScreenHeight = uiScreenHeight;
-	m_writeThread.Start(WriteImageToFile);
+	// The back buffer is captured at the end of the next frame
+	m_uiRequestedCaptures++;
 
 	// Set the last screen shot time
 	m_ulLastScreenShotTime = SharedUtility::GetTime();
 	return true;
 }
 
-bool CScreenShot::IsDone()
+void CScreenShot::Process()
 {
-	// Lock the thread data mutex
-	m_threadDataMutex.Lock();
-	bool bWriting = m_threadData.bWriting;
-
-	// Unlock the thread data mutex
-	m_threadDataMutex.Unlock();
-
-	return (bWriting && !m_writeThread.IsRunning());
-}
-
-bool CScreenShot::HasSucceeded()
-{
-	// Lock the thread data mutex
-	m_threadDataMutex.Lock();
-	bool bSucceeded = m_threadData.bSucceeded;
-
-	// Unlock the thread data mutex
-	m_threadDataMutex.Unlock();
-	return bSucceeded;
-}
+	// Read back the copies the gpu is done with (the oldest first)
+	for(unsigned int i = 0; i < SCREEN_SHOT_BUFFERS; i++)
+	{
+		Capture * pCapture = &m_captures[(m_uiCurrentCapture + i) % SCREEN_SHOT_BUFFERS];
 
-String CScreenShot::GetWriteName()
-{
-	// Lock the thread data mutex
-	m_threadDataMutex.Lock();
-	String strWriteName = m_threadData.strWriteName;
+		if(pCapture->bPending && !ReadCapture(pCapture))
+			break;
+	}
 
-	// Unlock the thread data mutex
-	m_threadDataMutex.Unlock();
-	return strWriteName;
+	// Capture one requested screen shot per frame
+	if(m_uiRequestedCaptures > 0 && StartCapture())
+		m_uiRequestedCaptures--;
 }
 
-String CScreenShot::GetError()
+void CScreenShot::OnLostDevice()
 {
-	// Lock the thread data mutex
-	m_threadDataMutex.Lock();
-	String strError = m_threadData.strError;
-
-	// Unlock the thread data mutex
-	m_threadDataMutex.Unlock();
-	return strError;
+	// The render targets and queries have to be released before the device is reset
+	ReleaseSurfaces();
 }
 
-void CScreenShot::Reset()
+bool CScreenShot::GetResult(bool& bSucceeded, String& strResult)
 {
-	// Lock the thread data mutex
-	m_threadDataMutex.Lock();
+	m_queueMutex.Lock();
 
-	// Reset the thread data
-	m_threadData.bWriting = false;
-	m_threadData.bSucceeded = false;
-	m_threadData.strError = "";
+	if(m_results.empty())
+	{
+		m_queueMutex.Unlock();
+		return false;
+	}
 
-	// Unlock the thread data mutex
-	m_threadDataMutex.Unlock();
+	bSucceeded = m_results.front().bSucceeded;
+	strResult = m_results.front().strResult;
+	m_results.pop_front();
+	m_queueMutex.Unlock();
+	return true;
 }
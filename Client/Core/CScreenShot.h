@@ -9,40 +9,90 @@
 
 #pragma once
 
+#include <list>
+#include <d3d9.h>
 #include <CString.h>
 #include <Threading/CMutex.h>
 #include <Threading/CThread.h>
 
+// Amount of back buffer copies the gpu can fill in at once
+#define SCREEN_SHOT_BUFFERS 2
+
+// Amount of screen shots that can be waiting to be captured or written at once
+#define SCREEN_SHOT_MAX_QUEUED 8
+
+// Time in ms between two screen shots
+#define SCREEN_SHOT_INTERVAL 250
+
+enum eScreenShotFormat
+{
+	SCREEN_SHOT_FORMAT_PNG,
+	SCREEN_SHOT_FORMAT_JPEG
+};
+
 class CScreenShot
 {
 public:
-	struct ThreadData
+	// A captured image waiting to be written by the write thread
+	struct Image
+	{
+		unsigned char   * ucData; // 32 bit BGRA
+		unsigned int      uiWidth;
+		unsigned int      uiHeight;
+		eScreenShotFormat format;
+		int               iQuality; // Only used for jpeg
+	};
+
+	struct Result
 	{
-		bool   bWriting;
 		bool   bSucceeded;
-		String strWriteName;
-		String strError;
+		String strResult; // The write name if it succeeded, the error if not
+	};
+
+	// A copy of the back buffer, it is read back once the gpu is done with
+	// the copy so the render thread never waits for the gpu
+	struct Capture
+	{
+		IDirect3DSurface9 * pRenderTarget;
+		IDirect3DSurface9 * pSystemSurface;
+		IDirect3DQuery9   * pQuery;
+		bool                bPending;
 	};
 
 private:
-	static unsigned long   m_ulLastScreenShotTime;
-	static CThread         m_writeThread;
-	static unsigned char * m_ucData;
-	static unsigned int    m_uiScreenWidth;
-	static unsigned int    m_uiScreenHeight;
-	static CMutex          m_threadDataMutex;
-	static ThreadData      m_threadData;
+	static unsigned long      m_ulLastScreenShotTime;
+	static unsigned int       m_uiRequestedCaptures;
+	static Capture            m_captures[SCREEN_SHOT_BUFFERS];
+	static unsigned int       m_uiCurrentCapture;
+	static unsigned int       m_uiCaptureWidth;
+	static unsigned int       m_uiCaptureHeight;
+	static D3DFORMAT          m_captureFormat;
+	static CThread            m_writeThread;
+	static CMutex             m_queueMutex; // Mutex for the write queue, the results and m_bWriting
+	static std::list<Image>   m_writeQueue;
+	static std::list<Result>  m_results;
+	static bool               m_bWriting;
+	static String             m_strError;
 
-	static String GetScreenShotPath();
-	static void   WriteImageToFile(CThread * pThread);
+	static String GetScreenShotPath(const char * szExtension);
+	static bool   CreateSurfaces(const D3DSURFACE_DESC& desc);
+	static void   ReleaseSurfaces();
+	static bool   StartCapture();
+	static bool   ReadCapture(Capture * pCapture);
+	static void   AddResult(bool bSucceeded, String strResult);
+	static bool   WritePng(FILE * pFile, const Image& image, String& strError);
+	static bool   WriteJpeg(FILE * pFile, const Image& image, String& strError);
+	static void   WriteImagesToFile(CThread * pThread);
 
 public:
-	CScreenShot();
-
+	// Queues a capture of the next frame, returns false (see GetError) if it can't be taken
 	static bool   Take();
-	static bool   IsDone();
-	static bool   HasSucceeded();
-	static String GetWriteName();
-	static String GetError();
-	static void   Reset();
+	static String GetError() { return m_strError; }
+
+	// Must be called at the end of each frame on the render thread
+	static void   Process();
+	static void   OnLostDevice();
+
+	// Gets the result of the next finished screen shot, returns false if there is none
+	static bool   GetResult(bool& bSucceeded, String& strResult);
 };
@@ -10,8 +10,13 @@
 #include "CServerQuery.h"
 #include <winsock2.h>
 #include <winsock.h>
+#include <stdio.h>
 #include <SharedUtility.h>
 
+// Identifier and version of the cache file
+#define SERVER_QUERY_CACHE_IDENTIFIER "IVSQ"
+#define SERVER_QUERY_CACHE_VERSION 1
+
 CServerQuery::CServerQuery()
 {
 	// If windows startup winsock
@@ -26,6 +31,14 @@ CServerQuery::CServerQuery()
 	// Set the socket to non blocking
 	u_long sockopt = 1;
 	ioctlsocket(m_iSocket, FIONBIO, &sockopt);
+
+	// Raise the receive buffer so a burst of replies isn't dropped
+	int iReceiveBufferSize = (256 * 1024);
+	setsockopt(m_iSocket, SOL_SOCKET, SO_RCVBUF, (char *)&iReceiveBufferSize, sizeof(int));
+
+	m_fSendAllowance = SERVER_QUERY_SEND_BURST;
+	m_ulLastProcessTime = SharedUtility::GetTime();
+	m_pfnServerQueryHandler = NULL;
 }
 
 CServerQuery::~CServerQuery()
@@ -49,28 +62,26 @@ CServerQuery::~CServerQuery()
 #endif
 }
 
-ServerQueryItem * CServerQuery::GetServerQuery(String strHost, unsigned short usPort)
+String CServerQuery::GetKey(String strHost, unsigned short usPort, String strQuery)
 {
-	for(std::list<ServerQueryItem *>::iterator iter = m_serverQueryList.begin(); iter != m_serverQueryList.end(); iter++)
-	{
-		ServerQueryItem * pServerQuery = *iter;
-
-		if(pServerQuery->strHost == strHost && pServerQuery->usPort == usPort)
-			return pServerQuery;
-	}
-
-	return NULL;
+	// The replies start with the query type so more than one query can wait for a server
+	return String("%s:%d:%s", strHost.Get(), usPort, strQuery.Get());
 }
 
 void CServerQuery::Reset()
 {
-	for(std::list<ServerQueryItem *>::iterator iter = m_serverQueryList.begin(); iter != m_serverQueryList.end(); iter++)
+	for(std::list<ServerQueryItem *>::iterator iter = m_sendQueue.begin(); iter != m_sendQueue.end(); iter++)
 		delete *iter;
 
-	m_serverQueryList.clear();
+	m_sendQueue.clear();
+
+	for(std::map<String, ServerQueryItem *>::iterator iter = m_serverQueries.begin(); iter != m_serverQueries.end(); iter++)
+		delete iter->second;
+
+	m_serverQueries.clear();
 }
 
-bool CServerQuery::Query(String strHost, unsigned short usPort, String strQuery)
+bool CServerQuery::SendQuery(ServerQueryItem * pServerQuery)
 {
 	// Create the query bit stream
 	CBitStream bitStream;
@@ -79,57 +90,61 @@ bool CServerQuery::Query(String strHost, unsigned short usPort, String strQuery)
 	bitStream.Write("IVMP", 4);
 
 	// Write the query
-	bitStream.Write(strQuery.Get(), strQuery.GetLength());
+	bitStream.Write(pServerQuery->strQuery.Get(), pServerQuery->strQuery.GetLength());
+
+	// Write the challenge token if the server asked for one
+	if(pServerQuery->bHasToken)
+		bitStream.Write(pServerQuery->uiToken);
 
 	// Prepare the query address
 	sockaddr_in addr;
 	memset(&addr, 0, sizeof(sockaddr_in));
 	addr.sin_family = AF_INET;
-	addr.sin_port = htons(usPort + QUERY_PORT_OFFSET);
-	addr.sin_addr.s_addr = inet_addr(strHost.Get());
+	addr.sin_port = htons(pServerQuery->usPort + QUERY_PORT_OFFSET);
+	addr.sin_addr.s_addr = inet_addr(pServerQuery->strHost.Get());
 
 	// Send the query
-	if(sendto(m_iSocket, (char *)bitStream.GetData(), bitStream.GetNumberOfBytesUsed(), 0, (sockaddr *)&addr, sizeof(sockaddr_in)) == bitStream.GetNumberOfBytesUsed())
-	{
-		// Create the server query
-		ServerQueryItem * pServerQuery = new ServerQueryItem;
-
-		// Ensure the server query created successfully
-		if(!pServerQuery)
-			return false;
+	pServerQuery->ulTime = SharedUtility::GetTime();
+	return (sendto(m_iSocket, (char *)bitStream.GetData(), bitStream.GetNumberOfBytesUsed(), 0, (sockaddr *)&addr, sizeof(sockaddr_in)) == bitStream.GetNumberOfBytesUsed());
+}
 
-		// Set the server query information
-		pServerQuery->strHost = strHost;
-		pServerQuery->usPort = usPort;
-		pServerQuery->strQuery = strQuery;
-		pServerQuery->ulTime = SharedUtility::GetTime();
+bool CServerQuery::Query(String strHost, unsigned short usPort, String strQuery)
+{
+	// Is this query already waiting?
+	String strKey = GetKey(strHost, usPort, strQuery);
 
-		// Add the server query to the server query list
-		m_serverQueryList.push_back(pServerQuery);
+	if(m_serverQueries.find(strKey) != m_serverQueries.end())
 		return true;
+
+	for(std::list<ServerQueryItem *>::iterator iter = m_sendQueue.begin(); iter != m_sendQueue.end(); iter++)
+	{
+		if((*iter)->strHost == strHost && (*iter)->usPort == usPort && (*iter)->strQuery == strQuery)
+			return true;
 	}
 
-	// Query not sent
-	return false;
+	// Create the server query
+	ServerQueryItem * pServerQuery = new ServerQueryItem;
+
+	// Ensure the server query created successfully
+	if(!pServerQuery)
+		return false;
+
+	// Set the server query information
+	pServerQuery->strHost = strHost;
+	pServerQuery->usPort = usPort;
+	pServerQuery->strQuery = strQuery;
+	pServerQuery->ulTime = 0;
+	pServerQuery->uiRetries = 0;
+	pServerQuery->bHasToken = false;
+	pServerQuery->uiToken = 0;
+
+	// Add the server query to the send queue
+	m_sendQueue.push_back(pServerQuery);
+	return true;
 }
 
 void CServerQuery::Process()
 {
-	// Remove any stale queries
-	for(std::list<ServerQueryItem *>::iterator iter = m_serverQueryList.begin(); iter != m_serverQueryList.end(); )
-	{
-		ServerQueryItem * pServerQuery = *iter;
-
-		if((SharedUtility::GetTime() - pServerQuery->ulTime) > 10000) // 10 seconds
-		{
-			// Remove the query
-			delete pServerQuery;
-			iter = m_serverQueryList.erase(iter);
-		}
-		else
-			iter++;
-	}
-
 	char szBuffer[1024];
 	sockaddr_in addr;
 	memset(&addr, 0, sizeof(sockaddr_in));
@@ -140,46 +155,213 @@ void CServerQuery::Process()
 
 	while((iBytesRead = recvfrom(m_iSocket, szBuffer, sizeof(szBuffer), 0, (sockaddr *)&addr, &iFromLen)) != -1)
 	{
+		// Ensure the first 4 bytes are 'IVMP' and we have the query type
+		if(iBytesRead < 5 || szBuffer[0] != 'I' || szBuffer[1] != 'V' || szBuffer[2] != 'M' || szBuffer[3] != 'P')
+			continue;
+
+		// Did the server send a challenge token instead of the reply?
+		bool bChallenge = (szBuffer[4] == 'c');
+
+		if(bChallenge && iBytesRead < 6)
+			continue;
+
 		// Convert the ip address to a string
 		char szIpAddress[64];
 		SharedUtility::inet_ntop(addr.sin_family, &addr.sin_addr, szIpAddress, sizeof(szIpAddress));
 
 		// Get the port
-		unsigned short usPort = ntohs(addr.sin_port);
+		unsigned short usPort = (ntohs(addr.sin_port) - QUERY_PORT_OFFSET);
 
 		// Get the server query item
-		ServerQueryItem * pServerQuery = GetServerQuery(szIpAddress, (usPort - QUERY_PORT_OFFSET));
+		char szQueryType[2] = { szBuffer[bChallenge ? 5 : 4], '\0' };
+		String strKey = GetKey(szIpAddress, usPort, szQueryType);
+		std::map<String, ServerQueryItem *>::iterator serverQuery = m_serverQueries.find(strKey);
 
 		// Invalid server query item?
-		if(!pServerQuery)
+		if(serverQuery == m_serverQueries.end())
 			continue;
 
-		// Create a bit stream from the data
-		CBitStream bitStream((unsigned char *)szBuffer, iBytesRead, true);
+		ServerQueryItem * pServerQuery = serverQuery->second;
 
-		// Read the first 4 bytes
-		char szIdentifier[4];
+		// Create a bit stream from the data (without the identifier)
+		CBitStream bitStream((unsigned char *)(szBuffer + 4), (iBytesRead - 4), false);
 
-		if(!bitStream.Read(szIdentifier, sizeof(szIdentifier)))
-			continue;
+		if(bChallenge)
+		{
+			char cChallenge;
+			char cQueryType;
+			unsigned int uiToken;
+
+			// Send the query again with the token, the server replies to that one
+			if(bitStream.Read(cChallenge) && bitStream.Read(cQueryType) && bitStream.Read(uiToken))
+			{
+				pServerQuery->bHasToken = true;
+				pServerQuery->uiToken = uiToken;
+				SendQuery(pServerQuery);
+			}
 
-		// Ensure the first 4 bytes are 'IVMP'
-		if(szIdentifier[0] != 'I' || szIdentifier[1] != 'V' || szIdentifier[2] != 'M' || szIdentifier[3] != 'P')
 			continue;
+		}
+
+		// Cache the reply
+		unsigned long ulPing = (SharedUtility::GetTime() - pServerQuery->ulTime);
+		ServerQueryCacheItem& cacheItem = m_cache[strKey];
+		cacheItem.strHost = pServerQuery->strHost;
+		cacheItem.usPort = pServerQuery->usPort;
+		cacheItem.strQuery = pServerQuery->strQuery;
+		cacheItem.ulPing = ulPing;
+		cacheItem.reply.assign((unsigned char *)(szBuffer + 4), (unsigned char *)(szBuffer + iBytesRead));
+
+		// Remove the server query (before the callback as it can queue new queries)
+		m_serverQueries.erase(serverQuery);
 
 		// Call the server query callback (if we have one)
 		if(m_pfnServerQueryHandler)
-			m_pfnServerQueryHandler(pServerQuery->strHost, pServerQuery->usPort, pServerQuery->strQuery, &bitStream);
-		
-		// Remove the server query
+			m_pfnServerQueryHandler(pServerQuery->strHost, pServerQuery->usPort, pServerQuery->strQuery, &bitStream, ulPing);
+
 		delete pServerQuery;
-		for(std::list<ServerQueryItem *>::iterator iter = m_serverQueryList.begin(); iter != m_serverQueryList.end(); iter++)
+	}
+
+	// Get the amount of queries we can send now
+	unsigned long ulTime = SharedUtility::GetTime();
+	m_fSendAllowance += (((ulTime - m_ulLastProcessTime) * SERVER_QUERY_SEND_RATE) / 1000.0f);
+
+	if(m_fSendAllowance > SERVER_QUERY_SEND_BURST)
+		m_fSendAllowance = SERVER_QUERY_SEND_BURST;
+
+	m_ulLastProcessTime = ulTime;
+
+	// Send the timed out queries again or give up on them
+	for(std::map<String, ServerQueryItem *>::iterator iter = m_serverQueries.begin(); iter != m_serverQueries.end(); )
+	{
+		ServerQueryItem * pServerQuery = iter->second;
+
+		if((ulTime - pServerQuery->ulTime) > SERVER_QUERY_TIMEOUT)
 		{
-			if(*iter == pServerQuery)
+			if(pServerQuery->uiRetries >= SERVER_QUERY_RETRIES)
+			{
+				// Remove the query
+				delete pServerQuery;
+				m_serverQueries.erase(iter++);
+				continue;
+			}
+
+			if(m_fSendAllowance >= 1.0f)
 			{
-				m_serverQueryList.erase(iter);
-				break;
+				pServerQuery->uiRetries++;
+				SendQuery(pServerQuery);
+				m_fSendAllowance -= 1.0f;
 			}
 		}
+
+		iter++;
+	}
+
+	// Send the queued queries
+	while(!m_sendQueue.empty() && m_fSendAllowance >= 1.0f)
+	{
+		ServerQueryItem * pServerQuery = m_sendQueue.front();
+		m_sendQueue.pop_front();
+		m_fSendAllowance -= 1.0f;
+
+		if(SendQuery(pServerQuery))
+			m_serverQueries[GetKey(pServerQuery->strHost, pServerQuery->usPort, pServerQuery->strQuery)] = pServerQuery;
+		else
+			delete pServerQuery;
+	}
+}
+
+bool CServerQuery::LoadCache(String strPath)
+{
+	FILE * pFile = fopen(strPath, "rb");
+
+	if(!pFile)
+		return false;
+
+	// Ensure the cache is of this version
+	char szIdentifier[4];
+	unsigned int uiVersion = 0;
+
+	if(fread(szIdentifier, 1, sizeof(szIdentifier), pFile) != sizeof(szIdentifier) || memcmp(szIdentifier, SERVER_QUERY_CACHE_IDENTIFIER, sizeof(szIdentifier)) ||
+		fread(&uiVersion, sizeof(unsigned int), 1, pFile) != 1 || uiVersion != SERVER_QUERY_CACHE_VERSION)
+	{
+		fclose(pFile);
+		return false;
+	}
+
+	// Read the cached replies
+	unsigned char ucHostLength;
+	char szHost[256];
+	unsigned short usPort;
+	unsigned char ucQueryLength;
+	char szQuery[256];
+	unsigned long ulPing;
+	unsigned short usReplyLength;
+
+	while(fread(&ucHostLength, 1, 1, pFile) == 1)
+	{
+		ServerQueryCacheItem cacheItem;
+
+		if(fread(szHost, 1, ucHostLength, pFile) != ucHostLength || fread(&usPort, sizeof(unsigned short), 1, pFile) != 1 ||
+			fread(&ucQueryLength, 1, 1, pFile) != 1 || fread(szQuery, 1, ucQueryLength, pFile) != ucQueryLength ||
+			fread(&ulPing, sizeof(unsigned long), 1, pFile) != 1 || fread(&usReplyLength, sizeof(unsigned short), 1, pFile) != 1 || usReplyLength == 0)
+			break;
+
+		cacheItem.reply.resize(usReplyLength);
+
+		if(fread(&cacheItem.reply[0], 1, usReplyLength, pFile) != usReplyLength)
+			break;
+
+		cacheItem.strHost.Set(szHost, ucHostLength);
+		cacheItem.usPort = usPort;
+		cacheItem.strQuery.Set(szQuery, ucQueryLength);
+		cacheItem.ulPing = ulPing;
+		m_cache[GetKey(cacheItem.strHost, cacheItem.usPort, cacheItem.strQuery)] = cacheItem;
+	}
+
+	fclose(pFile);
+
+	// Pass the cached replies to the server query callback (if we have one)
+	if(m_pfnServerQueryHandler)
+	{
+		for(std::map<String, ServerQueryCacheItem>::iterator iter = m_cache.begin(); iter != m_cache.end(); iter++)
+		{
+			ServerQueryCacheItem * pCacheItem = &iter->second;
+			CBitStream bitStream(&pCacheItem->reply[0], pCacheItem->reply.size(), false);
+			m_pfnServerQueryHandler(pCacheItem->strHost, pCacheItem->usPort, pCacheItem->strQuery, &bitStream, pCacheItem->ulPing);
+		}
 	}
+
+	return true;
+}
+
+bool CServerQuery::SaveCache(String strPath)
+{
+	FILE * pFile = fopen(strPath, "wb");
+
+	if(!pFile)
+		return false;
+
+	unsigned int uiVersion = SERVER_QUERY_CACHE_VERSION;
+	fwrite(SERVER_QUERY_CACHE_IDENTIFIER, 1, 4, pFile);
+	fwrite(&uiVersion, sizeof(unsigned int), 1, pFile);
+
+	for(std::map<String, ServerQueryCacheItem>::iterator iter = m_cache.begin(); iter != m_cache.end(); iter++)
+	{
+		ServerQueryCacheItem * pCacheItem = &iter->second;
+		unsigned char ucHostLength = (unsigned char)pCacheItem->strHost.GetLength();
+		unsigned char ucQueryLength = (unsigned char)pCacheItem->strQuery.GetLength();
+		unsigned short usReplyLength = (unsigned short)pCacheItem->reply.size();
+		fwrite(&ucHostLength, 1, 1, pFile);
+		fwrite(pCacheItem->strHost.Get(), 1, ucHostLength, pFile);
+		fwrite(&pCacheItem->usPort, sizeof(unsigned short), 1, pFile);
+		fwrite(&ucQueryLength, 1, 1, pFile);
+		fwrite(pCacheItem->strQuery.Get(), 1, ucQueryLength, pFile);
+		fwrite(&pCacheItem->ulPing, sizeof(unsigned long), 1, pFile);
+		fwrite(&usReplyLength, sizeof(unsigned short), 1, pFile);
+		fwrite(&pCacheItem->reply[0], 1, usReplyLength, pFile);
+	}
+
+	fclose(pFile);
+	return true;
 }
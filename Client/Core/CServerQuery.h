@@ -11,33 +11,71 @@
 
 #include <CString.h>
 #include <list>
+#include <map>
+#include <vector>
 #include <Network/CBitStream.h>
 
+// Time in ms a query waits for its reply before it is sent again
+#define SERVER_QUERY_TIMEOUT 1000
+
+// Amount of times a query is sent again before it is given up
+#define SERVER_QUERY_RETRIES 2
+
+// Amount of queries sent per second at most (so the replies don't overflow the receive buffer)
+#define SERVER_QUERY_SEND_RATE 250
+
+// Amount of queries that can be sent at once after a pause
+#define SERVER_QUERY_SEND_BURST 25
+
 struct ServerQueryItem
 {
 	String         strHost;
 	unsigned short usPort;
 	String         strQuery;
-	unsigned long  ulTime;
+	unsigned long  ulTime; // Time the query was last sent
+	unsigned int   uiRetries;
+	bool           bHasToken;
+	unsigned int   uiToken; // Challenge token the server asked us to send
 };
 
-typedef void (* ServerQueryHandler_t)(String strHost, unsigned short usPort, String strQuery, CBitStream * pReply);
+// The last reply of a server to a query
+struct ServerQueryCacheItem
+{
+	String                     strHost;
+	unsigned short             usPort;
+	String                     strQuery;
+	unsigned long              ulPing;
+	std::vector<unsigned char> reply;
+};
+
+typedef void (* ServerQueryHandler_t)(String strHost, unsigned short usPort, String strQuery, CBitStream * pReply, unsigned long ulPing);
 
 class CServerQuery
 {
 private:
-	int                          m_iSocket;
-	std::list<ServerQueryItem *> m_serverQueryList;
-	ServerQueryHandler_t         m_pfnServerQueryHandler;
+	int                                         m_iSocket;
+	std::list<ServerQueryItem *>                m_sendQueue; // Queries waiting to be sent
+	std::map<String, ServerQueryItem *>         m_serverQueries; // Sent queries waiting for their reply
+	std::map<String, ServerQueryCacheItem>      m_cache;
+	float                                       m_fSendAllowance; // Amount of queries that can be sent now
+	unsigned long                               m_ulLastProcessTime;
+	ServerQueryHandler_t                        m_pfnServerQueryHandler;
 
-	ServerQueryItem * GetServerQuery(String strHost, unsigned short usPort);
+	static String     GetKey(String strHost, unsigned short usPort, String strQuery);
+	bool              SendQuery(ServerQueryItem * pServerQuery);
 
 public:
 	CServerQuery();
 	~CServerQuery();
 
 	void              Reset();
+
+	// Queues the query, the queries are sent paced out by Process
 	bool              Query(String strHost, unsigned short usPort, String strQuery);
 	void              Process();
 	void              SetServerQueryHandler(ServerQueryHandler_t pfnServerQueryHandler) { m_pfnServerQueryHandler = pfnServerQueryHandler; }
+
+	// The cache holds the last reply of each server, loading it passes all cached replies to the handler
+	bool              LoadCache(String strPath);
+	bool              SaveCache(String strPath);
 };
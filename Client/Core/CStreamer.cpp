@@ -8,14 +8,19 @@
 //
 //==============================================================================
 
+#include <algorithm>
 #include "CStreamer.h"
 #include "CLocalPlayer.h"
 #include "CPlayerManager.h"
 #include "CVehicleManager.h"
+#include "CCamera.h"
+#include "CGame.h"
+#include "CPools.h"
 #include <SharedUtility.h>
 
 extern CLocalPlayer * g_pLocalPlayer;
 extern CStreamer    * g_pStreamer;
+extern CCamera      * g_pCamera;
 
 #define IS_VEHICLE(entity) ((entity)->GetType() == STREAM_ENTITY_VEHICLE)
 #define IS_PLAYER(entity) ((entity)->GetType() == STREAM_ENTITY_PLAYER)
@@ -25,11 +30,16 @@ CStreamableEntity::CStreamableEntity(eStreamEntityType eType, float fDistance)
 	m_fStreamingDistance(fDistance),
 	m_bIsStreamedIn(false),
 	m_pDimensionId(0), /* INVALID_DIMENSION_ID = always streamed in */
-	m_bCanBeStreamedIn(false)
+	m_bCanBeStreamedIn(false),
+	m_streamerList(STREAMER_LIST_NONE),
+	m_uiGridCell(0),
+	m_uiPulseId(0),
+	m_uiStreamedIndex(STREAMER_INVALID_INDEX),
+	m_bStreamInQueued(false)
 {
 
 	// add it to the streamer
-	g_pStreamer->push_back(this);
+	g_pStreamer->Add(this);
 }
 
 CStreamableEntity::~CStreamableEntity()
@@ -100,6 +110,13 @@ void CStreamableEntity::OnDelete()
 	g_pStreamer->remove(this);
 }
 
+void CStreamableEntity::OnStreamPositionChanged()
+{
+	// Move it to the grid cell of its new position
+	if(m_streamerList == STREAMER_LIST_GRID)
+		g_pStreamer->UpdateGridCell(this);
+}
+
 // --
 
 CStreamer::CStreamer()
@@ -110,6 +127,8 @@ CStreamer::CStreamer()
 	m_uiStreamingLimits[STREAM_ENTITY_OBJECT] = 512; // no more than object pool size
 	m_uiStreamingLimits[STREAM_ENTITY_CHECKPOINT] = 64; // no more than INTERNAL_CHECKPOINT_LIMIT
 	m_uiStreamingLimits[STREAM_ENTITY_PLAYER] = 32;
+	memcpy(m_uiMaxStreamingLimits, m_uiStreamingLimits, sizeof(m_uiStreamingLimits));
+	m_uiPulseId = 0;
 
 	// Reset the streamer
 	Reset();
@@ -130,109 +149,462 @@ void CStreamer::Reset()
 			CLogFile::Printf("CStreamer::Reset with %d objects of type %d", m_streamedElements[i].size(), i);
 
 			// Loop through all entities
-			for(std::list<CStreamableEntity*>::iterator iter = m_streamedElements[i].begin(); iter != m_streamedElements[i].end(); ++ iter)
+			for(std::vector<CStreamableEntity*>::iterator iter = m_streamedElements[i].begin(); iter != m_streamedElements[i].end(); ++ iter)
 			{
 				// Stream it out
 				(*iter)->StreamOutInternal();
+				(*iter)->m_uiStreamedIndex = STREAMER_INVALID_INDEX;
 			}
 
 			// Clear the list of entities specific to that type
 			m_streamedElements[i].clear();
 		}
+
+		for(std::vector<CStreamableEntity*>::iterator iter = m_streamInQueue[i].begin(); iter != m_streamInQueue[i].end(); ++ iter)
+			(*iter)->m_bStreamInQueued = false;
+
+		m_streamInQueue[i].clear();
 	}
 
+	// The entities that are still alive aren't in any list after this
+	for(iterator iter = begin(); iter != end(); ++ iter)
+		(*iter)->m_streamerList = STREAMER_LIST_NONE;
+
+	m_pendingEntities.clear();
+	m_dynamicEntities.clear();
+	m_grid.clear();
+	m_fMaxGridDistance = 0.0f;
+
 	// Clear the list of all entities
 	clear();
 }
 
-inline bool SortStreamableEntites(CStreamableEntity * pEntity, CStreamableEntity * pOther)
+unsigned int CStreamer::GetGridCell(const CVector3& vecPosition)
+{
+	// The cell coordinates are packed in 16 bits each
+	int iX = Math::Clamp(-32768, (int)floor(vecPosition.fX / STREAMER_GRID_CELL_SIZE), 32767);
+	int iY = Math::Clamp(-32768, (int)floor(vecPosition.fY / STREAMER_GRID_CELL_SIZE), 32767);
+	return ((unsigned int)(iX + 32768) << 16) | (unsigned int)(iY + 32768);
+}
+
+void CStreamer::Add(CStreamableEntity * pEntity)
+{
+	push_back(pEntity);
+
+	// The position can't be read from the constructor so the entity is placed with the next pulse
+	pEntity->m_streamerIter = m_pendingEntities.insert(m_pendingEntities.end(), pEntity);
+	pEntity->m_streamerList = STREAMER_LIST_PENDING;
+}
+
+void CStreamer::Place(CStreamableEntity * pEntity)
 {
-	// Get the local player position
-	CVector3 vecPlayerPos;
-	g_pLocalPlayer->GetPosition(vecPlayerPos);
+	float fDistance = pEntity->GetStreamingDistance();
+
+	// Players and vehicles move on their own, only entities that are moved by us go in the grid
+	if(IS_VEHICLE(pEntity) || IS_PLAYER(pEntity) || fDistance == -1 || fDistance > STREAMER_GRID_MAX_DISTANCE)
+	{
+		pEntity->m_streamerIter = m_dynamicEntities.insert(m_dynamicEntities.end(), pEntity);
+		pEntity->m_streamerList = STREAMER_LIST_DYNAMIC;
+		return;
+	}
+
+	CVector3 vecPos;
+	pEntity->GetStreamPosition(vecPos);
+	pEntity->m_uiGridCell = GetGridCell(vecPos);
+	std::list<CStreamableEntity *> * pCell = &m_grid[pEntity->m_uiGridCell];
+	pEntity->m_streamerIter = pCell->insert(pCell->end(), pEntity);
+	pEntity->m_streamerList = STREAMER_LIST_GRID;
+
+	if(fDistance > m_fMaxGridDistance)
+		m_fMaxGridDistance = fDistance;
+}
 
-	// Get the first entities position
+void CStreamer::UpdateGridCell(CStreamableEntity * pEntity)
+{
 	CVector3 vecPos;
 	pEntity->GetStreamPosition(vecPos);
+	unsigned int uiGridCell = GetGridCell(vecPos);
+
+	if(uiGridCell == pEntity->m_uiGridCell)
+		return;
 
-	// Get the second entities position
-	CVector3 vecPosOther;
-	pOther->GetStreamPosition(vecPosOther);
+	// Move the list node over so the iterator stays valid
+	std::map<unsigned int, std::list<CStreamableEntity *> >::iterator oldCell = m_grid.find(pEntity->m_uiGridCell);
+	std::list<CStreamableEntity *> * pCell = &m_grid[uiGridCell];
+	pCell->splice(pCell->end(), oldCell->second, pEntity->m_streamerIter);
+	pEntity->m_uiGridCell = uiGridCell;
 
-	// Compare the positions against the local player position
-	return (Math::GetDistanceBetweenPoints3D(vecPlayerPos.fX, vecPlayerPos.fY, vecPlayerPos.fZ, vecPos.fX, vecPos.fY, vecPos.fZ) < Math::GetDistanceBetweenPoints3D(vecPlayerPos.fX, vecPlayerPos.fY, vecPlayerPos.fZ, vecPosOther.fX, vecPosOther.fY, vecPosOther.fZ));
+	if(oldCell->second.empty())
+		m_grid.erase(oldCell);
+}
+
+void CStreamer::Unlink(CStreamableEntity * pEntity)
+{
+	switch(pEntity->m_streamerList)
+	{
+	case STREAMER_LIST_PENDING:
+		m_pendingEntities.erase(pEntity->m_streamerIter);
+		break;
+	case STREAMER_LIST_DYNAMIC:
+		m_dynamicEntities.erase(pEntity->m_streamerIter);
+		break;
+	case STREAMER_LIST_GRID:
+		{
+			std::map<unsigned int, std::list<CStreamableEntity *> >::iterator cell = m_grid.find(pEntity->m_uiGridCell);
+			cell->second.erase(pEntity->m_streamerIter);
+
+			if(cell->second.empty())
+				m_grid.erase(cell);
+		}
+		break;
+	default:
+		break;
+	}
+
+	pEntity->m_streamerList = STREAMER_LIST_NONE;
+}
+
+void CStreamer::AddStreamed(CStreamableEntity * pEntity)
+{
+	std::vector<CStreamableEntity *> * pStreamed = &m_streamedElements[pEntity->GetType()];
+	pEntity->m_uiStreamedIndex = pStreamed->size();
+	pStreamed->push_back(pEntity);
+}
+
+void CStreamer::RemoveStreamed(CStreamableEntity * pEntity)
+{
+	if(pEntity->m_uiStreamedIndex == STREAMER_INVALID_INDEX)
+		return;
+
+	// Move the last entity into its place
+	std::vector<CStreamableEntity *> * pStreamed = &m_streamedElements[pEntity->GetType()];
+	CStreamableEntity * pLast = pStreamed->back();
+	(*pStreamed)[pEntity->m_uiStreamedIndex] = pLast;
+	pLast->m_uiStreamedIndex = pEntity->m_uiStreamedIndex;
+	pStreamed->pop_back();
+	pEntity->m_uiStreamedIndex = STREAMER_INVALID_INDEX;
+}
+
+// A streamed in or new entity with its squared distance to the local player
+typedef std::pair<float, CStreamableEntity *> StreamCandidate;
+
+inline bool SortStreamCandidates(const StreamCandidate& candidate, const StreamCandidate& other)
+{
+	return (candidate.first < other.first);
+}
+
+void CStreamer::StreamInClosest(int iType, const CVector3& vecPlayerPos, std::vector<CStreamableEntity *>& newEntities)
+{
+	// alone reaching this isn't good - we should stream more entities than GTA can handle so we need to pick the closest ones
+	std::vector<StreamCandidate> candidates;
+	candidates.reserve(m_streamedElements[iType].size() + m_streamInQueue[iType].size() + newEntities.size());
+	CVector3 vecPos;
+
+	// Gather the positions first so the distances are worked out in one batch
+	m_candidatePositions.Clear();
+
+	for(std::vector<CStreamableEntity *>::iterator iter = m_streamedElements[iType].begin(); iter != m_streamedElements[iType].end(); ++ iter)
+	{
+		(*iter)->GetStreamPosition(vecPos);
+		m_candidatePositions.Add(vecPos);
+		candidates.push_back(StreamCandidate(0.0f, *iter));
+	}
+
+	for(std::vector<CStreamableEntity *>::iterator iter = m_streamInQueue[iType].begin(); iter != m_streamInQueue[iType].end(); ++ iter)
+	{
+		(*iter)->GetStreamPosition(vecPos);
+		m_candidatePositions.Add(vecPos);
+		candidates.push_back(StreamCandidate(0.0f, *iter));
+	}
+
+	for(std::vector<CStreamableEntity *>::iterator iter = newEntities.begin(); iter != newEntities.end(); ++ iter)
+	{
+		(*iter)->GetStreamPosition(vecPos);
+		m_candidatePositions.Add(vecPos);
+		candidates.push_back(StreamCandidate(0.0f, *iter));
+	}
+
+	if(!candidates.empty())
+	{
+		m_candidateDistances.resize(candidates.size());
+		m_candidatePositions.GetDistancesSquared(vecPlayerPos, &m_candidateDistances[0]);
+
+		for(size_t i = 0; i < candidates.size(); i++)
+			candidates[i].first = m_candidateDistances[i];
+	}
+
+	// Move the closest entities to the front and sort only those, so the closest are streamed in first
+	std::vector<StreamCandidate>::iterator limit = (candidates.begin() + m_uiStreamingLimits[iType]);
+	std::nth_element(candidates.begin(), limit, candidates.end(), SortStreamCandidates);
+	std::sort(candidates.begin(), limit, SortStreamCandidates);
+
+	// Stream out the entities that are too far away first so there is space for the new ones
+	for(std::vector<StreamCandidate>::iterator iter = limit; iter != candidates.end(); ++ iter)
+	{
+		// streamed in? (if not, it's new or queued and we don't need to stream it out either)
+		if(iter->second->IsStreamedIn())
+		{
+			RemoveStreamed(iter->second);
+			iter->second->StreamOutInternal();
+		}
+		else
+			iter->second->m_bStreamInQueued = false;
+	}
+
+	// queue all remaining entities that aren't streamed in yet
+	for(std::vector<CStreamableEntity *>::iterator iter = m_streamInQueue[iType].begin(); iter != m_streamInQueue[iType].end(); ++ iter)
+		(*iter)->m_bStreamInQueued = false;
+
+	m_streamInQueue[iType].clear();
+
+	for(std::vector<StreamCandidate>::iterator iter = candidates.begin(); iter != limit; ++ iter)
+	{
+		if(!iter->second->IsStreamedIn())
+			QueueStreamIn(iter->second);
+	}
+}
+
+void CStreamer::QueueStreamIn(CStreamableEntity * pEntity)
+{
+	// Start loading the model now so it is ready once the entity is created
+	pEntity->PrefetchModel();
+	pEntity->m_bStreamInQueued = true;
+	m_streamInQueue[pEntity->GetType()].push_back(pEntity);
+}
+
+void CStreamer::DequeueStreamIn(CStreamableEntity * pEntity)
+{
+	if(!pEntity->m_bStreamInQueued)
+		return;
+
+	std::vector<CStreamableEntity *> * pQueue = &m_streamInQueue[pEntity->GetType()];
+	pQueue->erase(std::find(pQueue->begin(), pQueue->end(), pEntity));
+	pEntity->m_bStreamInQueued = false;
+}
+
+void CStreamer::ProcessStreamInQueue()
+{
+	// Spread the stream ins over several frames so a lot of new entities don't stall a single frame
+	unsigned long ulStartTime = SharedUtility::GetTime();
+	bool bStreamedIn = false;
+
+	for(int i = 0; i < STREAM_ENTITY_MAX; ++i)
+	{
+		std::vector<CStreamableEntity *> * pQueue = &m_streamInQueue[i];
+		size_t sProcessed = 0;
+		size_t sWaiting = 0;
+
+		while(sProcessed < pQueue->size())
+		{
+			// Stream in at least one entity each frame
+			if(bStreamedIn && (SharedUtility::GetTime() - ulStartTime) >= STREAMER_STREAM_IN_BUDGET)
+				break;
+
+			CStreamableEntity * pEntity = (*pQueue)[sProcessed++];
+
+			// Keep the entity queued until the game streaming loaded its model
+			if(!pEntity->IsModelLoaded())
+			{
+				(*pQueue)[sWaiting++] = pEntity;
+				continue;
+			}
+
+			pEntity->m_bStreamInQueued = false;
+
+			// Stream the entity in
+			pEntity->StreamInInternal();
+
+			// add it to our list of streamed in entities
+			AddStreamed(pEntity);
+			bStreamedIn = true;
+		}
+
+		pQueue->erase((pQueue->begin() + sWaiting), (pQueue->begin() + sProcessed));
+	}
+}
+
+void CStreamer::GetPredictedPosition(const CVector3& vecPlayerPos, CVector3& vecPredictedPos)
+{
+	// Look ahead along the move speed of the local player (or the vehicle it is in)
+	CVector3 vecMoveSpeed;
+
+	if(g_pLocalPlayer->IsInVehicle())
+		g_pLocalPlayer->GetVehicle()->GetMoveSpeed(vecMoveSpeed);
+	else
+		g_pLocalPlayer->GetMoveSpeed(vecMoveSpeed);
+
+	vecPredictedPos = (vecPlayerPos + (vecMoveSpeed * STREAMER_LOOKAHEAD_TIME));
+
+	// and the direction the camera looks at
+	if(g_pCamera)
+	{
+		CVector3 vecForward;
+		g_pCamera->GetForward(vecForward);
+		vecPredictedPos = (vecPredictedPos + (vecForward * STREAMER_CAMERA_LOOKAHEAD));
+	}
+}
+
+void CStreamer::AddCandidate(CStreamableEntity * pEntity, std::vector<CStreamableEntity *>& candidates)
+{
+	// Only check each entity once per pulse
+	if(pEntity->m_uiPulseId == m_uiPulseId)
+		return;
+
+	pEntity->m_uiPulseId = m_uiPulseId;
+	candidates.push_back(pEntity);
+}
+
+void CStreamer::Evaluate(CStreamableEntity * pEntity, const CVector3& vecPlayerPos, const CVector3& vecPredictedPos, std::vector<CStreamableEntity *> * newEntities)
+{
+	// Can this entity be streamed in?
+	if(pEntity->CanBeStreamedIn())
+	{
+		bool bInRange = true;
+		bool bInPredictedRange = true;
+		float fStreamingDistance = pEntity->GetStreamingDistance();
+		if(fStreamingDistance != -1) {
+			// check distance
+			CVector3 vecPos;
+			pEntity->GetStreamPosition(vecPos);
+			float fStreamingDistanceSquared = (fStreamingDistance * fStreamingDistance);
+
+			// Streamed in entities stay until they are further out than that
+			float fRangeDistance = (pEntity->IsStreamedIn() ? (fStreamingDistance + STREAMER_HYSTERESIS_DISTANCE) : fStreamingDistance);
+			bInRange = ((vecPlayerPos - vecPos).LengthSquared() <= (fRangeDistance * fRangeDistance));
+			bInPredictedRange = ((vecPredictedPos - vecPos).LengthSquared() <= fStreamingDistanceSquared);
+		}
+
+		bool bInDimension = (m_dimensionId == INVALID_DIMENSION_ID || pEntity->GetDimension() == INVALID_DIMENSION_ID || (m_dimensionId == pEntity->GetDimension()));
+
+		if(!bInRange || !bInDimension)
+		{
+			// no longer wanted before it could be streamed in?
+			DequeueStreamIn(pEntity);
+
+			// will it be in range soon? load its model ahead of time
+			if(bInPredictedRange && bInDimension && !pEntity->IsStreamedIn())
+				pEntity->PrefetchModel();
+
+			// out of range or in another dimension, but streamed in?
+			if(pEntity->IsStreamedIn())
+			{
+				// remove it from the list of streamed in elements
+				RemoveStreamed(pEntity);
+
+				// stream it out
+				pEntity->StreamOutInternal();
+			}
+		}
+		else
+		{
+			// in range and in same/all dimension, but not streamed in or queued?
+			if(!pEntity->IsStreamedIn() && !pEntity->m_bStreamInQueued)
+			{
+				// flag it for being streamed in (important to have gta's hardcoded limits enforced)
+				newEntities[pEntity->GetType()].push_back(pEntity);
+			}
+		}
+	}
+	else
+	{
+		DequeueStreamIn(pEntity);
+
+		if(pEntity->IsStreamedIn())
+		{
+			CLogFile::Printf("Streamout of 0x%x due to not being allowed to be streamed in.", pEntity);
+
+			// remove it from the list of streamed in elements
+			RemoveStreamed(pEntity);
+
+			// stream it out
+			pEntity->StreamOutInternal();
+		}
+	}
 }
 
 // TODO: Notify server of stream in/out
 void CStreamer::Pulse()
 {
-	unsigned long ulTime = SharedUtility::GetTime();
+	unsigned long ulTime = SharedUtility::GetFrameTime();
 
 	if((ulTime - m_ulLastStreamTime) > STREAMING_TICK)
 	{
 		m_ulLastStreamTime = ulTime;
 
-		std::list<CStreamableEntity *> newEntities[STREAM_ENTITY_MAX];
+		std::vector<CStreamableEntity *> newEntities[STREAM_ENTITY_MAX];
 
 		CVector3 vecPlayerPos;
 		g_pLocalPlayer->GetPosition(vecPlayerPos);
+		CVector3 vecPredictedPos;
+		GetPredictedPosition(vecPlayerPos, vecPredictedPos);
+		m_uiPulseId++;
+
+		// Give our entities what the game doesn't use of its pools
+		UpdateStreamingLimits();
 
-		// Loop through all streamable elements
-		for(iterator iter = begin(); iter != end(); ++ iter)
+		// Place the entities created since the last pulse
+		while(!m_pendingEntities.empty())
+		{
+			CStreamableEntity * pEntity = m_pendingEntities.front();
+			m_pendingEntities.pop_front();
+			Place(pEntity);
+		}
+
+		// Only the moving entities, the streamed in entities and the grid cells
+		// around the local player are checked instead of every entity
+		std::vector<CStreamableEntity *> candidates;
+
+		for(iterator iter = m_dynamicEntities.begin(); iter != m_dynamicEntities.end(); ++ iter)
+			AddCandidate(*iter, candidates);
+
+		for(int i = 0; i < STREAM_ENTITY_MAX; ++i)
 		{
-			// Can this entity be streamed in?
-			if((*iter)->CanBeStreamedIn())
+			for(std::vector<CStreamableEntity *>::iterator iter = m_streamedElements[i].begin(); iter != m_streamedElements[i].end(); ++ iter)
 			{
+				// Streamed in entities can be moved by the game
+				if((*iter)->m_streamerList == STREAMER_LIST_GRID)
+					UpdateGridCell(*iter);
 
-				bool bInRange = true;
-				float fDistance = -1;
-				if((*iter)->GetStreamingDistance() != -1) {
-					// check distance
-					CVector3 vecPos;
-					(*iter)->GetStreamPosition(vecPos);
-					float fDistance = (vecPlayerPos - vecPos).Length();
-					bInRange = (fDistance <= (*iter)->GetStreamingDistance());
-				}
-	
-				if(!bInRange || (m_dimensionId != INVALID_DIMENSION_ID && (*iter)->GetDimension() != INVALID_DIMENSION_ID && (m_dimensionId != (*iter)->GetDimension())))
-				{
-					// out of range or in another dimension, but streamed in?
-					if((*iter)->IsStreamedIn())
-					{
-						//CLogFile::Printf("Streamout with Distance %f and Dimension %d/%d", fDistance, m_dimensionId, (*iter)->GetDimension());
-						
-						// remove it from the list of streamed in elements
-						m_streamedElements[(*iter)->GetType()].remove(*iter);
-
-						// stream it out
-						(*iter)->StreamOutInternal();
-					}
-				}
-				else if(bInRange && (m_dimensionId == INVALID_DIMENSION_ID || (*iter)->GetDimension() == INVALID_DIMENSION_ID || (m_dimensionId == (*iter)->GetDimension())))
-				{
-					// in range and in same/all dimension, but not streamed in?
-					if(!(*iter)->IsStreamedIn())
-					{
-						// flag it for being streamed in (important to have gta's hardcoded limits enforced)
-						newEntities[(*iter)->GetType()].push_back(*iter);
-					}
-				}
+				AddCandidate(*iter, candidates);
 			}
-			else
+
+			for(std::vector<CStreamableEntity *>::iterator iter = m_streamInQueue[i].begin(); iter != m_streamInQueue[i].end(); ++ iter)
+				AddCandidate(*iter, candidates);
+		}
+
+		if(!m_grid.empty())
+		{
+			// Check the cells around the local player and its predicted position
+			unsigned int uiPlayerCell = GetGridCell(vecPlayerPos);
+			unsigned int uiPredictedCell = GetGridCell(vecPredictedPos);
+			int iPlayerX = ((int)(uiPlayerCell >> 16) - 32768);
+			int iPlayerY = ((int)(uiPlayerCell & 0xFFFF) - 32768);
+			int iPredictedX = ((int)(uiPredictedCell >> 16) - 32768);
+			int iPredictedY = ((int)(uiPredictedCell & 0xFFFF) - 32768);
+			int iRange = (int)ceil(m_fMaxGridDistance / STREAMER_GRID_CELL_SIZE);
+			int iMinX = Math::Clamp(-32768, (((iPlayerX < iPredictedX) ? iPlayerX : iPredictedX) - iRange), 32767);
+			int iMaxX = Math::Clamp(-32768, (((iPlayerX > iPredictedX) ? iPlayerX : iPredictedX) + iRange), 32767);
+			int iMinY = Math::Clamp(-32768, (((iPlayerY < iPredictedY) ? iPlayerY : iPredictedY) - iRange), 32767);
+			int iMaxY = Math::Clamp(-32768, (((iPlayerY > iPredictedY) ? iPlayerY : iPredictedY) + iRange), 32767);
+
+			for(int iX = iMinX; iX <= iMaxX; iX++)
 			{
-				if((*iter)->IsStreamedIn())
+				for(int iY = iMinY; iY <= iMaxY; iY++)
 				{
-					CLogFile::Printf("Streamout of 0x%x due to not being allowed to be streamed in.", (*iter));
+					std::map<unsigned int, std::list<CStreamableEntity *> >::iterator cell = m_grid.find(((unsigned int)(iX + 32768) << 16) | (unsigned int)(iY + 32768));
 
-					// remove it from the list of streamed in elements
-					m_streamedElements[(*iter)->GetType()].remove(*iter);
+					if(cell == m_grid.end())
+						continue;
 
-					// stream it out
-					(*iter)->StreamOutInternal();
+					for(iterator iter = cell->second.begin(); iter != cell->second.end(); ++ iter)
+						AddCandidate(*iter, candidates);
 				}
 			}
 		}
 
+		for(std::vector<CStreamableEntity *>::iterator iter = candidates.begin(); iter != candidates.end(); ++ iter)
+			Evaluate(*iter, vecPlayerPos, vecPredictedPos, newEntities);
+
 		// Add all new entites
 		for(int i = 0; i < STREAM_ENTITY_MAX; ++i)
 		{
@@ -240,63 +612,24 @@ void CStreamer::Pulse()
 			if(newEntities[i].size() > 0)
 			{
 				// we have enough space within the GTA engine
-				if((m_streamedElements[i].size() + newEntities[i].size()) <= m_uiStreamingLimits[i])
+				if((m_streamedElements[i].size() + m_streamInQueue[i].size() + newEntities[i].size()) <= m_uiStreamingLimits[i])
 				{
-					for(std::list<CStreamableEntity*>::iterator iter = newEntities[i].begin(); iter != newEntities[i].end(); ++ iter)
-					{
-						// Stream the entity in
-						(*iter)->StreamInInternal();
-
-						// add it to our list of streamed in entities
-						m_streamedElements[i].push_back(*iter);
-					}
+					// queue the entities, they are streamed in over the next frames
+					for(std::vector<CStreamableEntity*>::iterator iter = newEntities[i].begin(); iter != newEntities[i].end(); ++ iter)
+						QueueStreamIn(*iter);
 				}
 				else
 				{
-					// alone reaching this isn't good - we should stream more entities than GTA can handle so we need to pick the closest ones
-
-					// add our own entites, but do not stream them in
-					for(std::list<CStreamableEntity*>::iterator iter = newEntities[i].begin(); iter != newEntities[i].end(); ++ iter)
-					{
-						m_streamedElements[i].push_back(*iter);
-					}
-
-					// sort the list by distance
-					m_streamedElements[i].sort(SortStreamableEntites);
-
-					// remove the entities that are too far away
-					while(m_streamedElements[i].size() > m_uiStreamingLimits[i])
-					{
-						// get the farest away entity
-						CStreamableEntity* pEntity = m_streamedElements[i].back();
-
-						// streamed in? (if not, it's new and we don't need to stream it out either)
-						if(pEntity->IsStreamedIn())
-						{
-							// stream it out
-							pEntity->StreamOutInternal();
-						}
-
-						// remove it from the streamed in entities
-						m_streamedElements[i].pop_back();
-					}
-
-					// make sure all remaining entities are streamed in
-					for(std::list<CStreamableEntity*>::iterator iter = m_streamedElements[i].begin(); iter != m_streamedElements[i].end(); ++iter)
-					{
-						// not streamed in?
-						if(!(*iter)->IsStreamedIn())
-						{
-							// stream it in
-							(*iter)->StreamInInternal();
-						}
-					}
+					StreamInClosest(i, vecPlayerPos, newEntities[i]);
 				}
 			}
 		}
 
 		//CLogFile::Printf("CStreamer::Pulse (total = %d, time = %dms, veh = %d, pick = %d, obj = %d)", size(), SharedUtility::GetTime() - ulTime, m_streamedElements[STREAM_ENTITY_VEHICLE].size(), m_streamedElements[STREAM_ENTITY_PICKUP].size(), m_streamedElements[STREAM_ENTITY_OBJECT].size());
 	}
+
+	// Stream in the queued entities within the frame budget
+	ProcessStreamInQueue();
 }
 
 void CStreamer::UpdateInterior(unsigned int uiInterior)
@@ -305,7 +638,7 @@ void CStreamer::UpdateInterior(unsigned int uiInterior)
 	for(int i = 0; i < STREAM_ENTITY_MAX; ++ i)
 	{
 		// look through all spawned entites of that type
-		for(std::list<CStreamableEntity*>::iterator iter = m_streamedElements[i].begin(); iter != m_streamedElements[i].end(); ++ iter)
+		for(std::vector<CStreamableEntity*>::iterator iter = m_streamedElements[i].begin(); iter != m_streamedElements[i].end(); ++ iter)
 		{
 			// Update the interior
 			(*iter)->UpdateInterior(uiInterior);
@@ -315,34 +648,38 @@ void CStreamer::UpdateInterior(unsigned int uiInterior)
 
 void CStreamer::ForceStreamIn(CStreamableEntity * pEntity)
 {
+	// don't wait for the queue
+	DequeueStreamIn(pEntity);
+
+	// already in the list of streamed entities?
+	if(pEntity->m_uiStreamedIndex != STREAMER_INVALID_INDEX)
+		return;
+
 	// not enough space to stream it in?
 	if(m_streamedElements[pEntity->GetType()].size() > m_uiStreamingLimits[pEntity->GetType()])
 	{
 		// Get the last entity
 		CStreamableEntity* pOtherEntity = m_streamedElements[pEntity->GetType()].back();
 
-		// Check if it is streamed in
-		if(pOtherEntity->IsStreamedIn())
-		{
-			// Stream it out
-			pOtherEntity->StreamOutInternal();
-		}
-
 		// remove it from the list so we'll have space
-		m_streamedElements[pEntity->GetType()].pop_back();
+		RemoveStreamed(pOtherEntity);
+
+		// Stream it out
+		pOtherEntity->StreamOutInternal();
 	}
 
 	// stream the entity in
 	pEntity->StreamInInternal();
 
 	// add it to the list of streamed entities
-	m_streamedElements[pEntity->GetType()].push_back(pEntity);
+	AddStreamed(pEntity);
 }
 
 void CStreamer::ForceStreamOut(CStreamableEntity * pEntity)
 {
 	// Remove it from the streamed in elements
-	m_streamedElements[pEntity->GetType()].remove(pEntity);
+	RemoveStreamed(pEntity);
+	DequeueStreamIn(pEntity);
 
 	// stream the entity out
 	pEntity->StreamOutInternal();
@@ -353,11 +690,14 @@ void CStreamer::remove(CStreamableEntity* pEntity)
 	// force it to be streamed out
 	ForceStreamOut(pEntity);
 
+	// remove it from the list or grid cell it is in
+	Unlink(pEntity);
+
 	// remove it from the global list
 	std::list<CStreamableEntity*>::remove(pEntity);
 }
 
-std::list<CStreamableEntity *> * CStreamer::GetStreamedInEntitiesOfType(eStreamEntityType eType)
+std::vector<CStreamableEntity *> * CStreamer::GetStreamedInEntitiesOfType(eStreamEntityType eType)
 {
 	return &m_streamedElements[eType];
 }
@@ -367,6 +707,60 @@ unsigned int CStreamer::GetStreamedInEntityCountOfType(eStreamEntityType eType)
 	return m_streamedElements[eType].size();
 }
 
+bool CStreamer::GetPoolUsage(eStreamEntityType eType, unsigned int * puiUsed, unsigned int * puiSize)
+{
+	CPools * pPools = CGame::GetPools();
+
+	if(!pPools)
+		return false;
+
+	switch(eType)
+	{
+	case STREAM_ENTITY_VEHICLE:
+		*puiUsed = pPools->GetVehiclePool()->GetUsed();
+		*puiSize = pPools->GetVehiclePool()->GetCount();
+		break;
+	case STREAM_ENTITY_OBJECT:
+		*puiUsed = pPools->GetObjectPool()->GetUsed();
+		*puiSize = pPools->GetObjectPool()->GetCount();
+		break;
+	case STREAM_ENTITY_PLAYER:
+		*puiUsed = pPools->GetPedPool()->GetUsed();
+		*puiSize = pPools->GetPedPool()->GetCount();
+		break;
+	default:
+		return false;
+	}
+
+	return (*puiSize > 0);
+}
+
+void CStreamer::UpdateStreamingLimits()
+{
+	for(int i = 0; i < STREAM_ENTITY_MAX; ++i)
+	{
+		unsigned int uiUsed;
+		unsigned int uiSize;
+
+		if(!GetPoolUsage((eStreamEntityType)i, &uiUsed, &uiSize))
+			continue;
+
+		unsigned int uiReserve = STREAMER_OBJECT_POOL_RESERVE;
+
+		if(i == STREAM_ENTITY_VEHICLE)
+			uiReserve = STREAMER_VEHICLE_POOL_RESERVE;
+		else if(i == STREAM_ENTITY_PLAYER)
+			uiReserve = STREAMER_PED_POOL_RESERVE;
+
+		// What the game uses of the pool besides our streamed in entities stays
+		// with it, our entities can have the rest without the reserve
+		unsigned int uiStreamed = m_streamedElements[i].size();
+		unsigned int uiGameUsed = ((uiUsed > uiStreamed) ? (uiUsed - uiStreamed) : 0);
+		unsigned int uiLimit = (((uiGameUsed + uiReserve) < uiSize) ? (uiSize - uiGameUsed - uiReserve) : 0);
+		m_uiStreamingLimits[i] = ((uiLimit < m_uiMaxStreamingLimits[i]) ? uiLimit : m_uiMaxStreamingLimits[i]);
+	}
+}
+
 unsigned int CStreamer::GetStreamedInLimitOfType(eStreamEntityType eType)
 {
 	return m_uiStreamingLimits[eType];
@@ -394,20 +788,25 @@ unsigned int CStreamer::GetStreamedInLimitOfType(eStreamEntityType eType)
 
 CNetworkVehicle * CStreamer::GetVehicleFromGameVehicle(IVVehicle * pGameVehicle)
 {
-	// Get the streamed in vehicles list
-	std::list <CStreamableEntity *> * m_streamedVehicles = &m_streamedElements[STREAM_ENTITY_VEHICLE];
+	std::unordered_map<IVVehicle *, CNetworkVehicle *>::iterator iter = m_gameVehicles.find(pGameVehicle);
 
-	// Loop through the streamed in vehicles list
-	for(std::list<CStreamableEntity *>::iterator iter = m_streamedVehicles->begin(); iter != m_streamedVehicles->end(); iter++)
-	{
-		// Get the vehicle pointer
-		CNetworkVehicle * pTestVehicle = reinterpret_cast<CNetworkVehicle *>(*iter);
+	// No vehicle found
+	if(iter == m_gameVehicles.end())
+		return NULL;
 
-		// Is this the vehicle we are looking for?
-		if(pTestVehicle->GetGameVehicle()->GetVehicle() == pGameVehicle)
-			return pTestVehicle;
-	}
+	// Does the vehicle still have this game vehicle?
+	CIVVehicle * pVehicle = (*iter).second->GetGameVehicle();
 
-	// No vehicle found
-	return NULL;
+	if(!pVehicle || pVehicle->GetVehicle() != pGameVehicle)
+		return NULL;
+
+	return (*iter).second;
+}
+
+void CStreamer::SetGameVehicle(IVVehicle * pGameVehicle, CNetworkVehicle * pVehicle)
+{
+	if(pVehicle)
+		m_gameVehicles[pGameVehicle] = pVehicle;
+	else
+		m_gameVehicles.erase(pGameVehicle);
 }
\ No newline at end of file
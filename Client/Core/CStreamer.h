@@ -13,6 +13,10 @@
 #include <winsock2.h>
 #include <windows.h>
 #include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <Math/CPositionBatch.h>
 #include "CIVVehicle.h"
 
 //#define NEW_STREAMER
@@ -23,8 +27,36 @@ typedef unsigned char DimensionId;
 // Define used for invalid dimension ids
 #define INVALID_DIMENSION_ID 0xFF
 
-// TODO: Adjust?
-#define STREAMING_TICK 1000
+// Time in ms between two streamer pulses
+#define STREAMING_TICK 250
+
+// Size of a streamer grid cell, entities that don't move are sorted into the cells by their position
+#define STREAMER_GRID_CELL_SIZE 200.0f
+
+// Time in seconds the streamer looks ahead along the move speed of the local player
+#define STREAMER_LOOKAHEAD_TIME 2.0f
+
+// Distance the streamer looks ahead along the camera direction
+#define STREAMER_CAMERA_LOOKAHEAD 50.0f
+
+// Time in ms that can be spent each frame on streaming in entities (at least one is streamed in)
+#define STREAMER_STREAM_IN_BUDGET 4
+
+// Index of an entity that isn't in the list of streamed in entities
+#define STREAMER_INVALID_INDEX 0xFFFFFFFF
+
+// Distance a streamed in entity can move beyond its streaming distance before it is
+// streamed out, so entities at the edge don't stream in and out all the time
+#define STREAMER_HYSTERESIS_DISTANCE 25.0f
+
+// Game pool slots the streaming limits leave free for what the game creates itself
+// (ambient population, script entities, hidden peds and vehicles of the caches)
+#define STREAMER_VEHICLE_POOL_RESERVE 16
+#define STREAMER_PED_POOL_RESERVE 8
+#define STREAMER_OBJECT_POOL_RESERVE 100
+
+// Entities with a larger streaming distance are checked every pulse instead of being put in the grid
+#define STREAMER_GRID_MAX_DISTANCE 2000.0f
 
 enum eStreamEntityType
 {
@@ -38,6 +70,15 @@ enum eStreamEntityType
 
 class CStreamer;
 
+// The streamer list an entity is in
+enum eStreamerList
+{
+	STREAMER_LIST_NONE,
+	STREAMER_LIST_PENDING, // Created since the last pulse
+	STREAMER_LIST_DYNAMIC, // Checked every pulse
+	STREAMER_LIST_GRID,
+};
+
 class CStreamableEntity
 {
 	friend class CStreamer;
@@ -50,6 +91,12 @@ private:
 	DimensionId       m_pDimensionId;
 	bool              m_bCanBeStreamedIn;
 	unsigned short    m_usStreamReferences, m_usStreamReferencesScript;
+	eStreamerList     m_streamerList;
+	std::list<CStreamableEntity *>::iterator m_streamerIter;
+	unsigned int      m_uiGridCell;
+	unsigned int      m_uiPulseId; // Last pulse the entity was checked in
+	unsigned int      m_uiStreamedIndex; // Index in the list of streamed in entities of its type
+	bool              m_bStreamInQueued;
 
 	void              StreamInInternal();
 	void              StreamOutInternal();
@@ -73,8 +120,17 @@ public:
 	virtual void      StreamIn() { };
 	virtual void      StreamOut() { };
 
+	// Requests the model of the entity without waiting for it to load
+	virtual void      PrefetchModel() { };
+
+	// Returns true if the entity can be streamed in without waiting for its model to load
+	virtual bool      IsModelLoaded() { return true; };
+
 protected:
 	void              OnDelete();
+
+	// Must be called when the stream position of the entity is changed
+	void              OnStreamPositionChanged();
 };
 
 class CNetworkVehicle;
@@ -85,9 +141,34 @@ class CStreamer : public std::list<CStreamableEntity*>
 private:
 	unsigned long						m_ulLastStreamTime;
 	DimensionId							m_dimensionId;
-	std::list<CStreamableEntity *>		m_streamedElements[STREAM_ENTITY_MAX];
-	std::list<CStreamableEntity *>		m_newlyStreamedElements[STREAM_ENTITY_MAX];
-	unsigned int						m_uiStreamingLimits[STREAM_ENTITY_MAX]; // max number of each entity type the game can handle	
+	std::vector<CStreamableEntity *>	m_streamedElements[STREAM_ENTITY_MAX];
+	std::vector<CStreamableEntity *>	m_streamInQueue[STREAM_ENTITY_MAX]; // Entities that are streamed in over the next frames, the closest first
+	unsigned int						m_uiStreamingLimits[STREAM_ENTITY_MAX]; // max number of each entity type the game can handle right now
+	unsigned int						m_uiMaxStreamingLimits[STREAM_ENTITY_MAX]; // the most the limits can be raised to
+	unsigned int						m_uiPulseId;
+	std::list<CStreamableEntity *>		m_pendingEntities;
+	std::list<CStreamableEntity *>		m_dynamicEntities;
+	std::map<unsigned int, std::list<CStreamableEntity *> > m_grid;
+	float								m_fMaxGridDistance; // Largest streaming distance of the entities in the grid
+	CPositionBatch						m_candidatePositions; // Kept around for StreamInClosest
+	std::vector<float>					m_candidateDistances;
+	std::unordered_map<IVVehicle *, CNetworkVehicle *> m_gameVehicles; // The vehicles by their game vehicle
+
+	static unsigned int					GetGridCell(const CVector3& vecPosition);
+	void								Add(CStreamableEntity * pEntity);
+	void								Place(CStreamableEntity * pEntity);
+	void								UpdateGridCell(CStreamableEntity * pEntity);
+	void								Unlink(CStreamableEntity * pEntity);
+	void								AddCandidate(CStreamableEntity * pEntity, std::vector<CStreamableEntity *>& candidates);
+	void								Evaluate(CStreamableEntity * pEntity, const CVector3& vecPlayerPos, const CVector3& vecPredictedPos, std::vector<CStreamableEntity *> * newEntities);
+	void								GetPredictedPosition(const CVector3& vecPlayerPos, CVector3& vecPredictedPos);
+	void								QueueStreamIn(CStreamableEntity * pEntity);
+	void								DequeueStreamIn(CStreamableEntity * pEntity);
+	void								ProcessStreamInQueue();
+	void								AddStreamed(CStreamableEntity * pEntity);
+	void								RemoveStreamed(CStreamableEntity * pEntity);
+	void								StreamInClosest(int iType, const CVector3& vecPlayerPos, std::vector<CStreamableEntity *>& newEntities);
+	void								UpdateStreamingLimits();
 
 public:
 	CStreamer();
@@ -98,9 +179,14 @@ public:
 	void                             ForceStreamIn(CStreamableEntity * pEntity);
 	void                             ForceStreamOut(CStreamableEntity * pEntity);
 	void                             remove(CStreamableEntity* pEntity);
-	std::list<CStreamableEntity *> * GetStreamedInEntitiesOfType(eStreamEntityType eType);
+	std::vector<CStreamableEntity *> * GetStreamedInEntitiesOfType(eStreamEntityType eType);
 	unsigned int                     GetStreamedInEntityCountOfType(eStreamEntityType eType);
 	unsigned int                     GetStreamedInLimitOfType(eStreamEntityType eType);
+
+	// Gets the live occupancy of the game pool the entities of the type are created
+	// in, returns false if they have none
+	bool                             GetPoolUsage(eStreamEntityType eType, unsigned int * puiUsed, unsigned int * puiSize);
 	//CNetworkPlayer                 * GetPlayerFromGamePlayerPed(IVPlayerPed * pGamePlayerPed);
 	CNetworkVehicle					*GetVehicleFromGameVehicle(IVVehicle * pGameVehicle);
+	void                             SetGameVehicle(IVVehicle * pGameVehicle, CNetworkVehicle * pVehicle); // NULL when the game vehicle is destroyed
 };
\ No newline at end of file
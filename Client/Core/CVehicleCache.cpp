@@ -0,0 +1,126 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CVehicleCache.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CVehicleCache.h"
+#include "CGame.h"
+#include <SharedUtility.h>
+
+CVehicleCache::CVehicleCache()
+{
+
+}
+
+CVehicleCache::~CVehicleCache()
+{
+	DestroyAll();
+}
+
+bool CVehicleCache::Add(CIVVehicle * pVehicle, CIVModelInfo * pModelInfo)
+{
+	if(m_vehicles.size() >= VEHICLE_CACHE_MAX)
+		return false;
+
+	int iModelIndex = pModelInfo->GetIndex();
+	unsigned int uiModelVehicles = 0;
+
+	for(std::list<CachedVehicle>::iterator iter = m_vehicles.begin(); iter != m_vehicles.end(); iter++)
+	{
+		if((*iter).pModelInfo->GetIndex() == iModelIndex)
+			uiModelVehicles++;
+	}
+
+	if(uiModelVehicles >= VEHICLE_CACHE_MAX_PER_MODEL)
+		return false;
+
+	// Stop the vehicle before it leaves the world, the rest is restored on stream in
+	pVehicle->SetMoveSpeed(CVector3());
+	pVehicle->SetTurnSpeed(CVector3());
+	pVehicle->RemoveFromWorld();
+
+	CachedVehicle vehicle;
+	vehicle.pVehicle = pVehicle;
+	vehicle.pModelInfo = pModelInfo;
+	vehicle.ulTime = SharedUtility::GetTime();
+	m_vehicles.push_back(vehicle);
+	return true;
+}
+
+CIVVehicle * CVehicleCache::Take(int iModelIndex)
+{
+	// The most recent first, it is the most likely to still have its model loaded
+	for(std::list<CachedVehicle>::reverse_iterator iter = m_vehicles.rbegin(); iter != m_vehicles.rend(); iter++)
+	{
+		if((*iter).pModelInfo->GetIndex() == iModelIndex)
+		{
+			CIVVehicle * pVehicle = (*iter).pVehicle;
+			m_vehicles.erase(--(iter.base()));
+			return pVehicle;
+		}
+	}
+
+	return NULL;
+}
+
+void CVehicleCache::Pulse()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	while(!m_vehicles.empty() && (ulTime - m_vehicles.front().ulTime) >= VEHICLE_CACHE_TIME)
+	{
+		Destroy(m_vehicles.front().pVehicle, m_vehicles.front().pModelInfo, false);
+		m_vehicles.pop_front();
+	}
+}
+
+void CVehicleCache::DestroyAll()
+{
+	while(!m_vehicles.empty())
+	{
+		Destroy(m_vehicles.front().pVehicle, m_vehicles.front().pModelInfo, false);
+		m_vehicles.pop_front();
+	}
+}
+
+void CVehicleCache::Destroy(CIVVehicle * pVehicle, CIVModelInfo * pModelInfo, bool bInWorld)
+{
+	// Get the vehicle pointer
+	IVVehicle * pGameVehicle = pVehicle->GetVehicle();
+
+	*(BYTE *)(pGameVehicle + 0xF6D) |= 8;
+
+	// Remove the vehicle from the world
+	if(bInWorld)
+		pVehicle->RemoveFromWorld();
+
+	// Remove references?
+	DWORD dwFunc = (CGame::GetBase() + 0x819190);
+	_asm
+	{
+		push pGameVehicle
+		call dwFunc
+		add esp, 4
+	}
+
+	*(BYTE *)(pGameVehicle + 0xF6B) &= 0xDF;
+
+	// Delete the vehicle
+	dwFunc = pGameVehicle->m_VFTable->ScalarDeletingDestructor;
+	_asm
+	{
+		push 1
+		mov ecx, pGameVehicle
+		call dwFunc
+	}
+
+	// Remove the model info reference of the vehicle
+	pModelInfo->RemoveReference();
+
+	// Delete the vehicle instance
+	delete pVehicle;
+}
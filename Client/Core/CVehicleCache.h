@@ -0,0 +1,55 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CVehicleCache.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include "CIVVehicle.h"
+#include "CIVModelInfo.h"
+
+// Maximum amount of hidden vehicles in the cache and of them with the same model
+#define VEHICLE_CACHE_MAX 8
+#define VEHICLE_CACHE_MAX_PER_MODEL 2
+
+// Time in ms a streamed out vehicle is kept before it is destroyed
+#define VEHICLE_CACHE_TIME 30000
+
+// A game vehicle that was streamed out and is kept outside of the world
+struct CachedVehicle
+{
+	CIVVehicle   * pVehicle;
+	CIVModelInfo * pModelInfo; // Keeps the reference of the vehicle to it
+	unsigned long  ulTime;     // When the vehicle was streamed out
+};
+
+// Keeps the game vehicles that were streamed out for a while, so a vehicle with
+// the same model that is streamed in (like one that went back over the streaming
+// distance) can be reactivated instead of constructing a new one
+class CVehicleCache
+{
+private:
+	std::list<CachedVehicle> m_vehicles; // The oldest first
+
+public:
+	CVehicleCache();
+	~CVehicleCache();
+
+	// Hides the vehicle, returns false if the cache is full and the vehicle must be destroyed
+	bool         Add(CIVVehicle * pVehicle, CIVModelInfo * pModelInfo);
+
+	// Gets a hidden vehicle of the model or NULL, it is still outside of the world
+	CIVVehicle * Take(int iModelIndex);
+
+	// Destroys the vehicles that were kept for longer than VEHICLE_CACHE_TIME
+	void         Pulse();
+	void         DestroyAll();
+
+	// Deletes the game vehicle and its instance and removes its model info reference
+	static void  Destroy(CIVVehicle * pVehicle, CIVModelInfo * pModelInfo, bool bInWorld);
+};
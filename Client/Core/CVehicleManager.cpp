@@ -17,11 +17,24 @@ extern CLocalPlayer * g_pLocalPlayer;
 extern CNetworkManager * g_pNetworkManager;
 extern CStreamer * g_pStreamer;
 
+CVehicleManager::~CVehicleManager()
+{
+	// The vehicles can give their game vehicles to the cache when they are
+	// deleted, so they are deleted before it
+	for(EntityId i = 0; i < MAX_VEHICLES; i++)
+		Delete(i);
+
+	m_vehicleCache.DestroyAll();
+}
+
 void CVehicleManager::Pulse()
 {
-	std::list<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
+	// Destroy the game vehicles that were streamed out a while ago
+	m_vehicleCache.Pulse();
+
+	std::vector<CStreamableEntity *> * streamedVehicles = g_pStreamer->GetStreamedInEntitiesOfType(STREAM_ENTITY_VEHICLE);
 
-	for(std::list<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
+	for(std::vector<CStreamableEntity *>::iterator iter = streamedVehicles->begin(); iter != streamedVehicles->end(); ++iter)
 	{
 		CNetworkVehicle * pVehicle = reinterpret_cast<CNetworkVehicle *>(*iter);
 
@@ -14,9 +14,16 @@
 #include "CNetworkVehicle.h"
 #include "CLocalPlayer.h"
 #include "CNetworkEntityManager.h"
+#include "CVehicleCache.h"
 
 class CVehicleManager : public CNetworkEntityManager<CNetworkVehicle, MAX_VEHICLES>
 {
+private:
+	CVehicleCache     m_vehicleCache;
+
 public:
+	~CVehicleManager();
+
 	void              Pulse();
+	CVehicleCache   * GetVehicleCache() { return &m_vehicleCache; }
 };
@@ -15,6 +15,9 @@
 #include "CModelManager.h"
 #include "SharedUtility.h"
 #include "CFPSCounter.h"
+#include "CFrameProfiler.h"
+#include <CTraceRecorder.h>
+#include "Scripting/CScriptProfiler.h"
 //#include "CD3D9Webkit.hpp"
 
 extern CInputWindow * g_pInputWindow;
@@ -25,6 +28,7 @@ extern CPlayerManager * g_pPlayerManager;
 extern CVehicleManager * g_pVehicleManager;
 extern CModelManager * g_pModelManager;
 extern CFPSCounter * g_pFPSCounter;
+extern CFrameProfiler * g_pFrameProfiler;
 //extern CD3D9WebKit * g_pWebkit;
 
 void QuitCommand(char * szParams)
@@ -58,6 +62,126 @@ void GetFPS(char * szParams)
 	g_pChatWindow->AddInfoMessage("Your current [FFFFFFAA]FPS: [F60000FF]%d",g_pFPSCounter->Get());
 }
 
+void ScriptProfileCommand(char * szParams)
+{
+	if(!g_pScriptProfiler)
+	{
+		g_pChatWindow->AddInfoMessage("No client scripts are loaded.");
+		return;
+	}
+
+	String strAction(szParams ? szParams : "");
+
+	if(strAction == "start")
+	{
+		g_pScriptProfiler->Start();
+		g_pChatWindow->AddInfoMessage("Script profiler started.");
+	}
+	else if(strAction == "stop")
+	{
+		g_pScriptProfiler->Stop();
+		g_pChatWindow->AddInfoMessage("Script profiler stopped.");
+	}
+	else if(strAction == "reset")
+	{
+		g_pScriptProfiler->Reset();
+		g_pChatWindow->AddInfoMessage("Script profiler reset.");
+	}
+	else
+	{
+		// Print the profile to the log and write the stacks for flame graph tools
+		g_pScriptProfiler->Print();
+
+		if(g_pScriptProfiler->Dump(SharedUtility::GetAbsolutePath("scriptprofile.txt")))
+			g_pChatWindow->AddInfoMessage("Script profile written to the log and 'scriptprofile.txt'.");
+		else
+			g_pChatWindow->AddInfoMessage("Failed to open 'scriptprofile.txt'.");
+	}
+}
+
+void FrameProfileCommand(char * szParams)
+{
+	if(!g_pFrameProfiler)
+		return;
+
+	String strAction(szParams ? szParams : "");
+
+	if(strAction == "dump")
+	{
+		// Write the recorded frames so they can be attached to stutter reports
+		if(g_pFrameProfiler->Dump(SharedUtility::GetAbsolutePath("frameprofile.txt")))
+			g_pChatWindow->AddInfoMessage("Frame profile written to 'frameprofile.txt'.");
+		else
+			g_pChatWindow->AddInfoMessage("Failed to open 'frameprofile.txt'.");
+	}
+	else
+	{
+		g_pFrameProfiler->SetEnabled(!g_pFrameProfiler->IsEnabled());
+		g_pChatWindow->AddInfoMessage("Frame profiler %s.", g_pFrameProfiler->IsEnabled() ? "enabled" : "disabled");
+	}
+}
+
+// trace [start|stop|dump]
+void TraceCommand(char * szParams)
+{
+	String strAction(szParams ? szParams : "");
+
+	if(strAction == "start")
+	{
+		CTraceRecorder::SetEnabled(false);
+		CTraceRecorder::Reset();
+		CTraceRecorder::SetEnabled(true);
+		g_pChatWindow->AddInfoMessage("Trace recorder started.");
+	}
+	else if(strAction == "stop")
+	{
+		CTraceRecorder::SetEnabled(false);
+		g_pChatWindow->AddInfoMessage("Trace recorder stopped with %d event(s).", CTraceRecorder::GetEventCount());
+	}
+	else if(strAction == "dump")
+	{
+		bool bEnabled = CTraceRecorder::IsEnabled();
+		CTraceRecorder::SetEnabled(false);
+
+		// Open it in chrome://tracing or ui.perfetto.dev
+		if(CTraceRecorder::Dump(SharedUtility::GetAbsolutePath("trace.json")))
+			g_pChatWindow->AddInfoMessage("Trace written to 'trace.json'.");
+		else
+			g_pChatWindow->AddInfoMessage("Failed to open 'trace.json'.");
+
+		CTraceRecorder::SetEnabled(bEnabled);
+	}
+	else
+		g_pChatWindow->AddInfoMessage("Usage: /trace [start|stop|dump]");
+}
+
+// netsim [off|<latency> [jitter] [loss] [reorder] [duplicate] [bandwidth]]
+// Simulates bad network conditions on what we send, without parameters the stats are shown
+void NetSimulatorCommand(char * szParams)
+{
+	CNetClientInterface * pNetClient = g_pNetworkManager->GetNetClient();
+	String strParams(szParams ? szParams : "");
+	NetSimulatorSettings settings;
+
+	if(strParams == "off")
+	{
+		pNetClient->SetNetSimulator(settings);
+		g_pChatWindow->AddInfoMessage("Network simulator disabled.");
+	}
+	else if(strParams.IsNotEmpty())
+	{
+		sscanf(szParams, "%u %u %f %f %f %u", &settings.uiLatency, &settings.uiJitter, &settings.fLoss, &settings.fReorder, &settings.fDuplicate, &settings.uiBandwidth);
+		pNetClient->SetNetSimulator(settings);
+		g_pChatWindow->AddInfoMessage("Network simulator set (Latency: %ums, Jitter: %ums, Loss: %.1f%%, Reorder: %.1f%%, Duplicate: %.1f%%, Bandwidth: %u bytes/s).", settings.uiLatency, settings.uiJitter, settings.fLoss, settings.fReorder, settings.fDuplicate, settings.uiBandwidth);
+	}
+	else
+	{
+		NetSimulatorStats stats;
+		pNetClient->GetNetSimulatorStats(&stats);
+		g_pChatWindow->AddInfoMessage("Network simulator: %lu datagrams (%lu bytes), %lu lost, %lu overflowed, %lu reordered, %lu duplicated, %u queued.", stats.ulDatagrams, stats.ulBytes, stats.ulLost, stats.ulOverflowed, stats.ulReordered, stats.ulDuplicated, stats.uiQueued);
+	}
+}
+
 void SavePosCommand(char * szParams)
 {
 	FILE * file = fopen(SharedUtility::GetAbsolutePath("SavedData.txt"), "a");
@@ -275,6 +399,10 @@ void RegisterCommands()
 	g_pInputWindow->RegisterCommand("ping", GetPing);
 	g_pInputWindow->RegisterCommand("fps", GetFPS);
 	g_pInputWindow->RegisterCommand("dvi", DisableVehicleInfos);
+	g_pInputWindow->RegisterCommand("scriptprofile", ScriptProfileCommand);
+	g_pInputWindow->RegisterCommand("frameprofile", FrameProfileCommand);
+	g_pInputWindow->RegisterCommand("trace", TraceCommand);
+	g_pInputWindow->RegisterCommand("netsim", NetSimulatorCommand);
 	#ifdef DEBUG_COMMANDS_ENABLED
 	g_pInputWindow->RegisterCommand("ap", AddPlayerCommand);
 	g_pInputWindow->RegisterCommand("dp", DeletePlayerCommand);
@@ -260,10 +260,7 @@ LRESULT APIENTRY WndProc_Hook(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam
 			if(CScreenShot::Take())
 				g_pChatWindow->AddInfoMessage("Screen shot captured.");
 			else
-			{
 				g_pChatWindow->AddInfoMessage("Screen shot capture failed (%s).", CScreenShot::GetError().Get());
-				CScreenShot::Reset();
-			}
 		}
 
 		/*if(uMsg == WM_KEYUP && wParam == VK_F4)
@@ -15,92 +15,103 @@
 #include "CContextDataManager.h"
 #include "CPools.h"
 #include <CLogFile.h>
+#include <stddef.h>
 
 IVPed      * g_pPed = NULL;
 IVVehicle  * g_pKeySyncIVVehicle = NULL;
 unsigned int g_uiLocalPlayerIndex = 0;
 IVPad        g_localPad;
 bool         g_bInLocalContext = true;
+IVPed      * g_pContextPed = NULL; // The remote ped whose pad is in the game pad
+
+// The parts of a pad the input processing reads. The key configs in between are
+// only used when the pad is updated from the devices and make up most of the pad,
+// so they aren't copied.
+#define PAD_INPUT_OFFSET offsetof(IVPad, m_padData)
+#define PAD_INPUT_SIZE (offsetof(IVPad, m_textPadConfig) - PAD_INPUT_OFFSET)
+#define PAD_TIME_OFFSET offsetof(IVPad, IVPad_pad3)
+#define PAD_TIME_SIZE (sizeof(IVPad) - PAD_TIME_OFFSET)
+
+void CopyPadInput(IVPad * pTo, IVPad * pFrom)
+{
+	memcpy(((BYTE *)pTo + PAD_INPUT_OFFSET), ((BYTE *)pFrom + PAD_INPUT_OFFSET), PAD_INPUT_SIZE);
+	memcpy(((BYTE *)pTo + PAD_TIME_OFFSET), ((BYTE *)pFrom + PAD_TIME_OFFSET), PAD_TIME_SIZE);
+}
 
 void ContextSwitch(IVPed * pPed, bool bPost)
 {
 	// Do we have a valid ped pointer?
-	if(pPed)
+	if(!pPed)
+		return;
+
+	// Get the game pad
+	CIVPad * pPad = CGame::GetPad();
+
+	if(bPost)
 	{
-		// Get the remote players context data
-		CContextData * pContextData = CContextDataManager::GetContextData((IVPlayerPed *)pPed);
+		// Did we not switch to this ped?
+		if(g_bInLocalContext || pPed != g_pContextPed)
+			return;
+
+		// Restore the local players pad
+		CopyPadInput(pPad->GetPad(), &g_localPad);
 
-		// Do we have a valid context data?
-		if(pContextData)
+		// Restore the local players index
+		CGame::GetPools()->SetLocalPlayerIndex(g_uiLocalPlayerIndex);
+
+		// Flag ourselves as back in local context
+		g_pContextPed = NULL;
+		g_bInLocalContext = true;
+		return;
+	}
+
+	// Get the remote players context data
+	CContextData * pContextData = CContextDataManager::GetContextData((IVPlayerPed *)pPed);
+
+	// Do we have a valid context data and is this not the local player?
+	if(!pContextData || pContextData->GetPlayerInfo()->GetPlayerNumber() == 0)
+		return;
+
+	if(!g_bInLocalContext)
+	{
+		CLogFile::Printf("Not switching due to not being in local context!");
+		return;
+	}
+
+	// Store the local players index
+	g_uiLocalPlayerIndex = CGame::GetPools()->GetLocalPlayerIndex();
+
+	// Store the local players pad
+	CopyPadInput(&g_localPad, pPad->GetPad());
+
+	// Swap the local player index with the remote players index
+	CGame::GetPools()->SetLocalPlayerIndex(pContextData->GetPlayerInfo()->GetPlayerNumber());
+
+	// Set the history values
+	IVPad * pRemotePad = pContextData->GetPad()->GetPad();
+
+	for(int i = 0; i < INPUT_COUNT; i++)
+	{
+		IVPadData * pPadData = &pRemotePad->m_padData[i];
+
+		if(pPadData->m_pHistory)
 		{
-			// Is this not the local player?
-			if(pContextData->GetPlayerInfo()->GetPlayerNumber() != 0)
-			{
-				if(!bPost && !g_bInLocalContext)
-				{
-					CLogFile::Printf("Not switching due to not being in local context!");
-					return;
-				}
-
-				if(bPost && g_bInLocalContext)
-				{
-					CLogFile::Printf("Not switching due to being in local context!");
-					return;
-				}
-
-				// Get the game pad
-				CIVPad * pPad = CGame::GetPad();
-
-				if(!bPost)
-				{
-					// Store the local players index
-					g_uiLocalPlayerIndex = CGame::GetPools()->GetLocalPlayerIndex();
-
-					// Store the local players pad
-					memcpy(&g_localPad, pPad->GetPad(), sizeof(IVPad));
-
-					// Swap the local player index with the remote players index
-					CGame::GetPools()->SetLocalPlayerIndex(pContextData->GetPlayerInfo()->GetPlayerNumber());
-
-					// Set the history values
-					for(int i = 0; i < INPUT_COUNT; i++)
-					{
-						IVPadData * pPadData = &pContextData->GetPad()->GetPad()->m_padData[i];
-
-						if(pPadData->m_pHistory)
-						{
-							pPadData->m_byteHistoryIndex++;
-
-							if(pPadData->m_byteHistoryIndex >= MAX_HISTORY_ITEMS)
-								pPadData->m_byteHistoryIndex = 0;
-
-							pPadData->m_pHistory->m_historyItems[pPadData->m_byteHistoryIndex].m_byteValue = pPadData->m_byteLastValue;
-							pPadData->m_pHistory->m_historyItems[pPadData->m_byteHistoryIndex].m_dwLastUpdateTime = CGame::GetTime();
-						}
-					}
-
-					// Swap the local players pad with the remote players pad
-					memcpy(pPad->GetPad(), pContextData->GetPad()->GetPad(), sizeof(IVPad));
-
-					// Flag ourselves as no longer in local context
-					g_bInLocalContext = false;
-				}
-				else
-				{
-					// Restore the local players pad
-					memcpy(pPad->GetPad(), &g_localPad, sizeof(IVPad));
-
-					// Restore the local players index
-					CGame::GetPools()->SetLocalPlayerIndex(g_uiLocalPlayerIndex);
-
-					// Flag ourselves as back in local context
-					g_bInLocalContext = true;
-				}
-			}
+			pPadData->m_byteHistoryIndex++;
+
+			if(pPadData->m_byteHistoryIndex >= MAX_HISTORY_ITEMS)
+				pPadData->m_byteHistoryIndex = 0;
+
+			pPadData->m_pHistory->m_historyItems[pPadData->m_byteHistoryIndex].m_byteValue = pPadData->m_byteLastValue;
+			pPadData->m_pHistory->m_historyItems[pPadData->m_byteHistoryIndex].m_dwLastUpdateTime = CGame::GetTime();
 		}
-		//else
-			//CLogFile::Printf("ContextSwitch Warning: Invalid Player Ped");
 	}
+
+	// Swap the local players pad with the remote players pad
+	CopyPadInput(pPad->GetPad(), pRemotePad);
+
+	// Flag ourselves as no longer in local context
+	g_pContextPed = pPed;
+	g_bInLocalContext = false;
 }
 
 void _declspec(naked) CPlayerPed__ProcessInput_Hook()
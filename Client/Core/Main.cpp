@@ -38,6 +38,7 @@
 #include "CClientScriptManager.h"
 #include "CMainMenu.h"
 #include "CFPSCounter.h"
+#include "CFrameProfiler.h"
 #include "CDebugView.h"
 #include "SharedUtility.h"
 #include "CFileTransfer.h"
@@ -57,6 +58,7 @@
 #include "CScreenShot.h"
 #include "CAudio.h"
 #include "CFireManager.h"
+#include "CEntityDataStore.h"
 #include <Threading/CThread.h>
 #include <Threading/CMutex.h>
 
@@ -84,6 +86,7 @@ CScriptingManager    * g_pScriptingManager = NULL;
 CClientScriptManager * g_pClientScriptManager = NULL;
 CMainMenu            * g_pMainMenu = NULL;
 CFPSCounter          * g_pFPSCounter = NULL;
+CFrameProfiler       * g_pFrameProfiler = NULL;
 CDebugView			 * g_pDebugView = NULL;
 CGUIStaticText       * g_pVersionIdentifier = NULL;
 CFileTransfer        * g_pFileTransfer = NULL;
@@ -95,6 +98,7 @@ CCredits             * g_pCredits = NULL;
 CNameTags            * g_pNameTags = NULL;
 CClientTaskManager   * g_pClientTaskManager = NULL;
 CFireManager		 * g_pFireManager = NULL;
+CEntityDataStore     * g_pEntityDataStore = NULL;
 
 #ifdef IVMP_WEBKIT
 	//CD3D9WebKit * g_pWebkit;
@@ -108,6 +112,7 @@ unsigned short g_usPort;
 String         g_strHost;
 String         g_strNick;
 String         g_strPassword;
+String         g_strTransferToken; // Sent to the server we were transferred to
 bool		   g_bLoadingScreenloaded = false;
 int			   g_iCameraState = 1;
 int			   g_iCameraTime = 0;
@@ -256,8 +261,10 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 			// Install the Cursor hook
 #ifdef IVMP_DEBUG
 			CCursorHook::Install();
-			g_pDebugView = new CDebugView();
 #endif
+			// Initialize the debug viewer
+			g_pDebugView = new CDebugView();
+
 			// Initialize the client script manager
 			g_pClientScriptManager = new CClientScriptManager();
 
@@ -296,6 +303,9 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 			// Delete our checkpoint manager
 			SAFE_DELETE(g_pCheckpointManager);
 
+			// Delete our entity data store
+			SAFE_DELETE(g_pEntityDataStore);
+
 			// Delete our object manager
 			SAFE_DELETE(g_pObjectManager);
 
@@ -329,10 +339,12 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 			// Delete our fps counter
 			SAFE_DELETE(g_pFPSCounter);
 
-#ifdef IVMP_DEBUG
 			// Delete out debug viewer
 			SAFE_DELETE(g_pDebugView);
-#endif
+
+			// Delete our frame profiler
+			SAFE_DELETE(g_pFrameProfiler);
+
 			// Delete our credits
 			SAFE_DELETE(g_pCredits);
 
@@ -396,6 +408,10 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 // Direct3DDevice9::EndScene
 void Direct3DRender()
 {
+	// Everything below draws over the frame in a single overlay pass
+	if(g_pGraphics)
+		g_pGraphics->Begin();
+
 	// Check for pause menu
 	if(g_pNetworkManager)
 	{
@@ -452,13 +468,17 @@ void Direct3DRender()
 
 	// If our GUI class exists render it
 	if(g_pGUI)
+	{
+		CFrameProfilerScope profilerScope(FRAME_PROFILER_GUI);
 		g_pGUI->Render();
+	}
 
 	// If our WebKit class exists render it
 	/*	
 	#ifdef IVMP_WEBKIT
 		if(g_pWebkit)
 		{
+			CFrameProfilerScope profilerScope(FRAME_PROFILER_WEBKIT);
 			g_pWebkit->RenderAll();
 		}
 	#endif
@@ -469,7 +489,10 @@ void Direct3DRender()
 
 	// if our chat exist draw it
 	if(g_pChatWindow && !CGame::IsMenuActive())
+	{
+		CFrameProfilerScope profilerScope(FRAME_PROFILER_CHAT);
 		g_pChatWindow->Draw();
+	}
 
 	// If our fps class exists update it
 	if(g_pFPSCounter)
@@ -481,17 +504,28 @@ void Direct3DRender()
 
 	// If our scripting manager exists, call the frame event
 	if(g_pEvents && !g_pMainMenu->IsVisible())
-		g_pEvents->Call("frameRender");
+	{
+		CFrameProfilerScope profilerScope(FRAME_PROFILER_FRAME_RENDER_EVENT);
+		g_pEvents->Call(EVENT_FRAME_RENDER);
+	}
 
-	// Check if our screen shot write failed
-	if(CScreenShot::IsDone())
+	// Draw the display elements of the scripts over what the frame event drew
+	if(g_pClientScriptManager && g_pClientScriptManager->GetDisplayList() && !g_pMainMenu->IsVisible())
 	{
-		if(CScreenShot::HasSucceeded())
-			g_pChatWindow->AddInfoMessage("Screen shot written (%s).", CScreenShot::GetWriteName().Get());
-		else
-			g_pChatWindow->AddInfoMessage("Screen shot write failed (%s).", CScreenShot::GetError().Get());
+		CFrameProfilerScope profilerScope(FRAME_PROFILER_DISPLAY_LIST);
+		g_pClientScriptManager->GetDisplayList()->Render();
+	}
+
+	// Check if our screen shot writes finished
+	bool bScreenShotSucceeded;
+	String strScreenShotResult;
 
-		CScreenShot::Reset();
+	while(CScreenShot::GetResult(bScreenShotSucceeded, strScreenShotResult))
+	{
+		if(bScreenShotSucceeded)
+			g_pChatWindow->AddInfoMessage("Screen shot written (%s).", strScreenShotResult.Get());
+		else
+			g_pChatWindow->AddInfoMessage("Screen shot write failed (%s).", strScreenShotResult.Get());
 	}
 	
 	// Moving Camera for main menu, problem: g_pCamera->SetLookAt() cause an crash at change
@@ -568,6 +602,9 @@ void Direct3DRender()
 			// Create the statistics string
 			String strStats(szNetworkStats);
 
+			// Append the bytes per second of the rpcs that send the most
+			strStats += g_pNetworkManager->GetNetGraph()->GetText();
+
 			// Append loaded and unloaded model counts to the stats
 			// jenksta: too performance heavy to be done every frame
 			//strStats.AppendF("Models (Loaded/Unload): %d/%d\n", CGame::GetLoadedModelCount(), CGame::GetUnloadedModelCount());
@@ -675,8 +712,29 @@ void Direct3DRender()
 			}
 		}
 		if(g_pNameTags)
+		{
+			CFrameProfilerScope profilerScope(FRAME_PROFILER_NAMETAGS);
 			g_pNameTags->Draw();
+		}
 	}
+
+	// If our frame profiler is enabled draw its overlay
+	if(g_pFrameProfiler && g_pFrameProfiler->IsEnabled() && g_pDebugView)
+		g_pDebugView->DrawFrameProfile();
+
+	// Draw the primitives of this frame and give the game its states back
+	if(g_pGraphics)
+		g_pGraphics->End();
+
+	// Capture the requested screen shots now that the frame is complete
+	CScreenShot::Process();
+
+	// Save the settings that were changed a while ago
+	CSettings::Process();
+
+	// If our frame profiler exists finish the frame
+	if(g_pFrameProfiler)
+		g_pFrameProfiler->EndFrame();
 }
 
 // Direct3DDevice9::Reset
@@ -689,6 +747,13 @@ void Direct3DInvalidate()
 	// If our graphics instance exists inform it of the device loss
 	if(g_pGraphics)
 		g_pGraphics->OnLostDevice();
+
+	// If our frame profiler instance exists inform it of the device loss
+	if(g_pFrameProfiler)
+		g_pFrameProfiler->OnLostDevice();
+
+	// Inform the screen shot capture of the device loss
+	CScreenShot::OnLostDevice();
 }
 
 // Direct3DDevice9::Reset
@@ -746,6 +811,12 @@ void Direct3DReset()
 	else
 		g_pGraphics->OnResetDevice();
 
+	// If our frame profiler does not exist create it
+	if(!g_pFrameProfiler && g_pDevice)
+		g_pFrameProfiler = new CFrameProfiler(g_pDevice);
+	else
+		g_pFrameProfiler->OnResetDevice();
+
 	// If our main menu class does not exist create it
 	if(!g_pMainMenu)
 		g_pMainMenu = new CMainMenu();
@@ -800,6 +871,9 @@ CRemotePlayer * pClonePlayer = NULL;
 
 void GameScriptProcess()
 {
+	// Read the clock once for everything processed this frame
+	SharedUtility::UpdateFrameTime();
+
 	// Do we need to reset the game?
 	if(g_bResetGame)
 	{
@@ -812,7 +886,10 @@ void GameScriptProcess()
 
 	// If our network manager exists process it
 	if(g_pNetworkManager)
+	{
+		CFrameProfilerScope profilerScope(FRAME_PROFILER_NETWORK);
 		g_pNetworkManager->Process();
+	}
 
 	// HACKY!
 	// TEMP! TODO: Anywhere in GTA there's a function which checks if the engine is turned on or off...
@@ -900,6 +977,10 @@ void InternalResetGame(bool bAutoConnect)
 	g_pFireManager = new CFireManager();
 	CLogFile::Printf("Created fire manager instance");
 
+	SAFE_DELETE(g_pEntityDataStore);
+	g_pEntityDataStore = new CEntityDataStore();
+	CLogFile::Printf("Created entity data store instance");
+
 	// Set all vehicles to destroyable
 	if(g_pVehicleManager)
 	{
@@ -29,4 +29,10 @@
 #include "Natives/AudioNatives.h"
 
 // GUI functions
-#include "Natives/GUINatives.h"
\ No newline at end of file
+#include "Natives/GUINatives.h"
+
+// Display list functions
+#include "Natives/DisplayNatives.h"
+
+// Entity data functions
+#include "Natives/EntityDataNatives.h"
\ No newline at end of file
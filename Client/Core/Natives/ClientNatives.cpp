@@ -24,6 +24,7 @@
 #include "../CFPSCounter.h"
 #include "../CIVWeather.h"
 #include "../CActorManager.h"
+#include "../CClientScriptManager.h"
 
 extern CNetworkManager * g_pNetworkManager;
 extern CChatWindow * g_pChatWindow;
@@ -34,6 +35,7 @@ extern CModelManager * g_pModelManager;
 extern CLocalPlayer * g_pLocalPlayer;
 extern CFPSCounter * g_pFPSCounter;
 extern CActorManager * g_pActorManager;
+extern CClientScriptManager * g_pClientScriptManager;
 
 // Client functions
 
@@ -231,16 +233,21 @@ int sq_guiDrawRectangle(SQVM * pVM)
 
 int sq_triggerServerEvent(SQVM * pVM)
 {
+	CHECK_PARAMS_MIN("triggerServerEvent", 1);
+	CHECK_TYPE("triggerServerEvent", 1, 2, OT_STRING);
+
+	const char * szEventName;
+	sq_getstring(pVM, 2, &szEventName);
 	CSquirrelArguments arguments;
-	for(int i = 2; i <= sq_gettop( pVM ); ++ i )
+
+	for(int i = 3; i <= sq_gettop( pVM ); ++ i )
 	{
 		if(!arguments.pushFromStack(pVM, i))
 			return 1;
 	}
 
-	CBitStream bsSend;
-	arguments.serialize(&bsSend);
-	g_pNetworkManager->RPC(RPC_ScriptingEventCall, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_SCRIPT);
+	g_pNetworkManager->EventRPC(szEventName, &arguments);
+	sq_pushbool(pVM, true);
 	return 1;
 }
 
@@ -250,6 +257,7 @@ void RegisterScriptNatives(CScriptingManager * pScriptingManager)
 {
 	pScriptingManager->RegisterFunction("getClientScripts", sq_getScripts, 0, NULL);
 	pScriptingManager->RegisterFunction("getScriptName", sq_getScriptName, 0, NULL);
+	pScriptingManager->RegisterFunction("requireClientScript", sq_requireClientScript, 1, "s");
 }
 
 // getClientScripts()
@@ -272,6 +280,15 @@ int sq_getScriptName(SQVM * pVM)
 	return 1;
 }
 
+// requireClientScript(name)
+int sq_requireClientScript(SQVM * pVM)
+{
+	const char * szName;
+	sq_getstring(pVM, 2, &szName);
+	sq_pushbool(pVM, g_pClientScriptManager->Require(szName));
+	return 1;
+}
+
 // getWeather()
 int sq_getWeather(SQVM * pVM)
 {
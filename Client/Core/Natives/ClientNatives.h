@@ -30,6 +30,7 @@ SQUIRREL_FUNCTION(triggerServerEvent);
 SQUIRREL_FUNCTION(guiIsCursorVisible);
 SQUIRREL_FUNCTION(getScripts);
 SQUIRREL_FUNCTION(getScriptName);
+SQUIRREL_FUNCTION(requireClientScript);
 SQUIRREL_FUNCTION(getWeather);
 SQUIRREL_FUNCTION(setWeather);
 SQUIRREL_FUNCTION(getGameScrollBarText);
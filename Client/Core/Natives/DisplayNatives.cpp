@@ -0,0 +1,319 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: DisplayNatives.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "DisplayNatives.h"
+#include <Scripting/CScriptingManager.h>
+#include "../CClientScriptManager.h"
+#include "../CDisplayList.h"
+#include <CLogFile.h>
+
+extern CClientScriptManager * g_pClientScriptManager;
+
+// Scripts use 0xRRGGBBAA colors like guiDrawRectangle does, they are kept as ARGB
+static unsigned long GetDisplayColor(SQVM * pVM, SQInteger iIndex)
+{
+	SQInteger iColor;
+	sq_getinteger(pVM, iIndex, &iColor);
+	unsigned long ulColor = (unsigned long)iColor;
+	return ((ulColor >> 8) | ((ulColor & 0xFF) << 24));
+}
+
+// The elements go away with the instances of them, so a script that unloads takes
+// its elements with it
+_MEMBER_FUNCTION_RELEASE_HOOK(DisplayElement)
+{
+	if(g_pClientScriptManager && g_pClientScriptManager->GetDisplayList())
+		g_pClientScriptManager->GetDisplayList()->Delete((DisplayElement *)pInst);
+
+	return 1;
+}
+
+static bool SetDisplayElementInstance(SQVM * pVM, DisplayElement * pElement)
+{
+	if(SQ_FAILED(sq_setinstance(pVM, pElement)))
+	{
+		g_pClientScriptManager->GetDisplayList()->Delete(pElement);
+		return false;
+	}
+
+	_SET_RELEASE_HOOK(DisplayElement);
+	return true;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, setPosition)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	float fX, fY;
+	sq_getfloat(pVM, 2, &fX);
+	sq_getfloat(pVM, 3, &fY);
+	pElement->vecPosition = CEGUI::Vector2(fX, fY);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, getPosition)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_newarray(pVM, 0);
+	sq_pushfloat(pVM, pElement->vecPosition.d_x);
+	sq_arrayappend(pVM, -2);
+	sq_pushfloat(pVM, pElement->vecPosition.d_y);
+	sq_arrayappend(pVM, -2);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, setSize)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	// Texts are as big as their text
+	if(!pElement || pElement->type == DISPLAY_ELEMENT_TEXT)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	float fWidth, fHeight;
+	sq_getfloat(pVM, 2, &fWidth);
+	sq_getfloat(pVM, 3, &fHeight);
+	pElement->size = CEGUI::Size(fWidth, fHeight);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, getSize)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_newarray(pVM, 0);
+	sq_pushfloat(pVM, pElement->size.d_width);
+	sq_arrayappend(pVM, -2);
+	sq_pushfloat(pVM, pElement->size.d_height);
+	sq_arrayappend(pVM, -2);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, setColor)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pElement->ulColor = GetDisplayColor(pVM, 2);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, setVisible)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQBool bVisible;
+	sq_getbool(pVM, 2, &bVisible);
+	pElement->bVisible = (bVisible != 0);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, isVisible)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, pElement->bVisible);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayElement, destroy)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// The instance no longer has an element so the release hook doesn't delete it again
+	g_pClientScriptManager->GetDisplayList()->Delete(pElement);
+	sq_setinstance(pVM, (DisplayElement *)NULL);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// DisplayText(x, y, text)
+_MEMBER_FUNCTION_IMPL(DisplayText, constructor)
+{
+	float fX, fY;
+	const char * szText;
+	sq_getfloat(pVM, 2, &fX);
+	sq_getfloat(pVM, 3, &fY);
+	sq_getstring(pVM, 4, &szText);
+
+	CDisplayList * pDisplayList = g_pClientScriptManager->GetDisplayList();
+	DisplayElement * pElement = pDisplayList->Create(DISPLAY_ELEMENT_TEXT);
+	pElement->vecPosition = CEGUI::Vector2(fX, fY);
+
+	String strText;
+	strText.Set(szText);
+	pDisplayList->SetText(pElement, strText);
+
+	if(!SetDisplayElementInstance(pVM, pElement))
+	{
+		CLogFile::Printf("Can't create DisplayText.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayText, setText)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * szText;
+	sq_getstring(pVM, 2, &szText);
+
+	String strText;
+	strText.Set(szText);
+	g_pClientScriptManager->GetDisplayList()->SetText(pElement, strText);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayText, setFont)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+	CEGUI::Font * pFont = sq_getinstance<CEGUI::Font *>(pVM, 2);
+
+	if(!pElement || !pFont)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	g_pClientScriptManager->GetDisplayList()->SetFont(pElement, pFont);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(DisplayText, getTextExtent)
+{
+	DisplayElement * pElement = sq_getinstance<DisplayElement *>(pVM);
+
+	if(!pElement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushfloat(pVM, pElement->textLayout.GetExtent());
+	return 1;
+}
+
+// DisplayRect(x, y, width, height, color)
+_MEMBER_FUNCTION_IMPL(DisplayRect, constructor)
+{
+	float fX, fY, fWidth, fHeight;
+	sq_getfloat(pVM, 2, &fX);
+	sq_getfloat(pVM, 3, &fY);
+	sq_getfloat(pVM, 4, &fWidth);
+	sq_getfloat(pVM, 5, &fHeight);
+
+	DisplayElement * pElement = g_pClientScriptManager->GetDisplayList()->Create(DISPLAY_ELEMENT_RECT);
+	pElement->vecPosition = CEGUI::Vector2(fX, fY);
+	pElement->size = CEGUI::Size(fWidth, fHeight);
+	pElement->ulColor = GetDisplayColor(pVM, 6);
+
+	if(!SetDisplayElementInstance(pVM, pElement))
+	{
+		CLogFile::Printf("Can't create DisplayRect.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// DisplayImage(x, y, file), the image is drawn at the size of the file until it is set
+_MEMBER_FUNCTION_IMPL(DisplayImage, constructor)
+{
+	float fX, fY;
+	const char * szFile;
+	sq_getfloat(pVM, 2, &fX);
+	sq_getfloat(pVM, 3, &fY);
+	sq_getstring(pVM, 4, &szFile);
+
+	CDisplayList * pDisplayList = g_pClientScriptManager->GetDisplayList();
+	DisplayElement * pElement = pDisplayList->Create(DISPLAY_ELEMENT_IMAGE);
+	pElement->vecPosition = CEGUI::Vector2(fX, fY);
+
+	if(!pDisplayList->SetImage(pElement, szFile))
+	{
+		CLogFile::Printf("Can't load DisplayImage %s.", szFile);
+		pDisplayList->Delete(pElement);
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	if(!SetDisplayElementInstance(pVM, pElement))
+	{
+		CLogFile::Printf("Can't create DisplayImage.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, true);
+	return 1;
+}
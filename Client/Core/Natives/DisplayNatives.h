@@ -0,0 +1,35 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: DisplayNatives.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+// DisplayElement
+_MEMBER_FUNCTION_RELEASE_HOOK(DisplayElement);
+_MEMBER_FUNCTION_IMPL(DisplayElement, setPosition);
+_MEMBER_FUNCTION_IMPL(DisplayElement, getPosition);
+_MEMBER_FUNCTION_IMPL(DisplayElement, setSize);
+_MEMBER_FUNCTION_IMPL(DisplayElement, getSize);
+_MEMBER_FUNCTION_IMPL(DisplayElement, setColor);
+_MEMBER_FUNCTION_IMPL(DisplayElement, setVisible);
+_MEMBER_FUNCTION_IMPL(DisplayElement, isVisible);
+_MEMBER_FUNCTION_IMPL(DisplayElement, destroy);
+
+// DisplayText
+_MEMBER_FUNCTION_IMPL(DisplayText, constructor);
+_MEMBER_FUNCTION_IMPL(DisplayText, setText);
+_MEMBER_FUNCTION_IMPL(DisplayText, setFont);
+_MEMBER_FUNCTION_IMPL(DisplayText, getTextExtent);
+
+// DisplayRect
+_MEMBER_FUNCTION_IMPL(DisplayRect, constructor);
+
+// DisplayImage
+_MEMBER_FUNCTION_IMPL(DisplayImage, constructor);
@@ -0,0 +1,64 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: EntityDataNatives.cpp
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "Squirrel/sqstate.h"
+#include "Squirrel/sqvm.h"
+#include "Squirrel/sqstring.h"
+#include "../CEntityDataStore.h"
+
+extern CEntityDataStore * g_pEntityDataStore;
+
+// Entity data functions
+
+void CEntityDataNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("getPlayerData", GetPlayerData, 2, "is");
+	pScriptingManager->RegisterFunction("getVehicleData", GetVehicleData, 2, "is");
+	pScriptingManager->RegisterFunction("getObjectData", GetObjectData, 2, "is");
+}
+
+// Pushes the data the server sent us for the entity or null if it sent none with the key
+SQInteger CEntityDataNatives::Get(SQVM * pVM, eEntityDataType type)
+{
+	EntityId entityId;
+	const char * szKey;
+	sq_getentity(pVM, -2, &entityId);
+	sq_getstring(pVM, -1, &szKey);
+
+	CSquirrelArgument * pValue = g_pEntityDataStore->Get(type, entityId, szKey);
+
+	if(!pValue)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	pValue->push(pVM);
+	return 1;
+}
+
+// getPlayerData(playerid, key)
+SQInteger CEntityDataNatives::GetPlayerData(SQVM * pVM)
+{
+	return Get(pVM, ENTITY_DATA_PLAYER);
+}
+
+// getVehicleData(vehicleid, key)
+SQInteger CEntityDataNatives::GetVehicleData(SQVM * pVM)
+{
+	return Get(pVM, ENTITY_DATA_VEHICLE);
+}
+
+// getObjectData(objectid, key)
+SQInteger CEntityDataNatives::GetObjectData(SQVM * pVM)
+{
+	return Get(pVM, ENTITY_DATA_OBJECT);
+}
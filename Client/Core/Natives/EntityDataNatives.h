@@ -0,0 +1,25 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: EntityDataNatives.h
+// Project: Client.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+#include <Network/EntityData.h>
+
+class CEntityDataNatives
+{
+private:
+	static SQInteger Get(SQVM * pVM, eEntityDataType type);
+	static SQInteger GetPlayerData(SQVM * pVM);
+	static SQInteger GetVehicleData(SQVM * pVM);
+	static SQInteger GetObjectData(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
@@ -890,12 +890,13 @@ _MEMBER_FUNCTION_IMPL(GUIImage, constructor)
 	try
 	{
 
-		CEGUI::ImagesetManager::getSingleton().createFromImageFile(szName.C_String(), filename, "resources");
+		// Small images share the textures of the image atlas
+		String strImage = g_pGUI->GetImageAtlas()->Load(szName, filename, "resources");
 		CGUIStaticImage * pImage = g_pGUI->CreateGUIStaticImage(CEGUI::String(szName.C_String()));
 		
 		pImage->setProperty("FrameEnabled", "false");
 		pImage->setProperty("BackgroundEnabled", "false");
-		pImage->setProperty("Image", String("set:%s image:full_image", szName.C_String()).C_String());
+		pImage->setProperty("Image", strImage.C_String());
 
 		if(!pImage || SQ_FAILED(sq_setinstance(pVM, pImage)))
 		{
@@ -1177,6 +1178,24 @@ _MEMBER_FUNCTION_IMPL(GUIWebView, registerJavaScriptMethod)
 	return 1;
 }
 
+_MEMBER_FUNCTION_IMPL(GUIWebView, setMaxRefreshRate)
+{
+ 	CEGUI::Window * pWindow = sq_getinstance<CEGUI::Window *>(pVM);
+	SQInteger rate;
+	sq_getinteger(pVM, -1, &rate);
+
+	CD3D9WebView * pView = g_pWebkit->GetView(pWindow);
+	if(pView && rate >= 0)
+	{
+		pView->SetMaxRefreshRate((unsigned int)rate);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
 _MEMBER_FUNCTION_IMPL(GUIWebView, draw)
 {
  	CEGUI::Window * pWindow = sq_getinstance<CEGUI::Window *>(pVM);
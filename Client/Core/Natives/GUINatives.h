@@ -73,4 +73,5 @@ _MEMBER_FUNCTION_IMPL(GUIWebView, getLoadInfo);
 _MEMBER_FUNCTION_IMPL(GUIWebView, clickElement);
 _MEMBER_FUNCTION_IMPL(GUIWebView, setSize);
 _MEMBER_FUNCTION_IMPL(GUIWebView, registerJavaScriptMethod);
+_MEMBER_FUNCTION_IMPL(GUIWebView, setMaxRefreshRate);
 _MEMBER_FUNCTION_IMPL(GUIWebView, draw);
\ No newline at end of file
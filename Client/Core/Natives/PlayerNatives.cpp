@@ -29,6 +29,7 @@ extern CNetworkManager * g_pNetworkManager;
 extern CChatWindow     * g_pChatWindow;
 extern CLocalPlayer    * g_pLocalPlayer;
 extern CGUI            * g_pGUI;
+extern CScriptingManager * g_pScriptingManager;
 
 // Player functions
 
@@ -98,7 +99,10 @@ SQInteger CPlayerNatives::GetName(SQVM * pVM)
 
 	if(pPlayer)
 	{
-		sq_pushstring(pVM, pPlayer->GetName(), -1);
+		// The name is kept by the script until it changes
+		if(!g_pScriptingManager->PushCachedString(pVM, pPlayer))
+			g_pScriptingManager->PushCachedString(pVM, pPlayer, pPlayer->GetName());
+
 		return 1;
 	}
 
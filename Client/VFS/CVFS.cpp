@@ -19,15 +19,20 @@
 #endif
 #include <fcntl.h>
 #include <stdio.h>
-#include "Rijndael.h"
+#ifndef LINUX
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "CVFSCipher.h"
 #include <stdlib.h>
 
 
 #include <time.h>
 
-CRijndael encAES;
-
-unsigned char g_buf[513];
+CVFSCipher encAES;
 
 extern "C"
 {
@@ -38,11 +43,19 @@ extern "C"
 #define VFS_INTERNAL
 #include "CVFS.h"
 
-int disk = 0;
+unsigned char g_buf[FAT_SECTOR_SIZE];
+
+int disk = -1;
 
 #define AES_ENCRYPTION
 #define VFS_VERSION 0x01
 
+// Amount of decrypted sectors kept in the sector cache (must be a power of 2)
+#define VFS_SECTOR_CACHE_SIZE 1024
+
+// Amount of sectors read and decrypted in advance once the reads are sequential
+#define VFS_READ_AHEAD_SECTORS 32
+
 struct vfs_header
 {
 	unsigned char version;
@@ -50,33 +63,188 @@ struct vfs_header
 	unsigned char encryption;
 };
 
+// A decrypted sector, the cache is direct mapped so each sector can only be in one slot
+struct vfs_cached_sector
+{
+	unsigned long sector;
+	bool valid;
+	unsigned char data[FAT_SECTOR_SIZE];
+};
+
+vfs_cached_sector g_sectorCache[VFS_SECTOR_CACHE_SIZE];
+unsigned long g_ulLastReadSector = 0xFFFFFFFF;
+
+// The disk image is mapped into memory so reads are a copy from the page cache instead of a seek and read
+unsigned char * g_pMappedDisk = NULL;
+unsigned long g_ulMappedSize = 0;
+#ifndef LINUX
+HANDLE g_hDiskMapping = NULL;
+#endif
+
+void media_clear_cache()
+{
+	for(int i = 0; i < VFS_SECTOR_CACHE_SIZE; i++)
+		g_sectorCache[i].valid = false;
+
+	g_ulLastReadSector = 0xFFFFFFFF;
+}
+
+void media_map()
+{
+#ifndef LINUX
+	LARGE_INTEGER size;
+	HANDLE hDisk = (HANDLE)_get_osfhandle(disk);
+
+	if(hDisk == INVALID_HANDLE_VALUE || !GetFileSizeEx(hDisk, &size) || size.HighPart != 0 || size.LowPart == 0)
+		return;
+
+	g_hDiskMapping = CreateFileMapping(hDisk, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if(!g_hDiskMapping)
+		return;
+
+	g_pMappedDisk = (unsigned char *)MapViewOfFile(g_hDiskMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if(!g_pMappedDisk)
+	{
+		CloseHandle(g_hDiskMapping);
+		g_hDiskMapping = NULL;
+		return;
+	}
+
+	g_ulMappedSize = size.LowPart;
+#else
+	struct stat st;
+
+	if(fstat(disk, &st) != 0 || st.st_size == 0)
+		return;
+
+	void * pMapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, disk, 0);
+
+	if(pMapping == MAP_FAILED)
+		return;
+
+	g_pMappedDisk = (unsigned char *)pMapping;
+	g_ulMappedSize = (unsigned long)st.st_size;
+#endif
+}
+
+void media_shutdown()
+{
+	if(g_pMappedDisk)
+	{
+#ifndef LINUX
+		UnmapViewOfFile(g_pMappedDisk);
+		CloseHandle(g_hDiskMapping);
+		g_hDiskMapping = NULL;
+#else
+		munmap(g_pMappedDisk, g_ulMappedSize);
+#endif
+		g_pMappedDisk = NULL;
+		g_ulMappedSize = 0;
+	}
+
+	if(disk != -1)
+	{
+		close(disk);
+		disk = -1;
+	}
+
+	media_clear_cache();
+}
+
 int media_init(const char * szDisk)
 {
+	media_shutdown();
 #ifndef LINUX
 	disk = open(szDisk, O_RDWR | O_BINARY);
 #else
 	disk = open(szDisk, O_RDWR);
 #endif
+
+	if(disk != -1)
+		media_map();
+
 	return 1;
 }
 
+// Reads the encrypted sectors, returns the amount of sectors read
+unsigned long media_read_raw(unsigned long sector, unsigned long count, unsigned char *buffer)
+{
+	unsigned long offset = (sector*FAT_SECTOR_SIZE)+sizeof(vfs_header);
+
+	if(g_pMappedDisk && (offset + FAT_SECTOR_SIZE) <= g_ulMappedSize)
+	{
+		unsigned long available = (g_ulMappedSize - offset) / FAT_SECTOR_SIZE;
+
+		if(count > available)
+			count = available;
+
+		memcpy(buffer, g_pMappedDisk + offset, count*FAT_SECTOR_SIZE);
+		return count;
+	}
+
+	// Sectors written after the disk was mapped are not in the mapping
+	if (lseek(disk, offset, SEEK_SET) == -1L)
+	{
+		printf("Read seek fail\n");
+		return 0;
+	}
+
+	int bytes = read(disk, buffer, count*FAT_SECTOR_SIZE);
+
+	if(bytes <= 0)
+		return 0;
+
+	return (bytes / FAT_SECTOR_SIZE);
+}
+
+vfs_cached_sector * media_cache_sector(unsigned long sector, const unsigned char *buffer)
+{
+	vfs_cached_sector * pCached = &g_sectorCache[sector & (VFS_SECTOR_CACHE_SIZE - 1)];
+	pCached->sector = sector;
+	pCached->valid = true;
+	memcpy(pCached->data, buffer, FAT_SECTOR_SIZE);
+	return pCached;
+}
+
 int media_read(unsigned long sector, unsigned char *buffer)
 {
-    if (lseek(disk, (sector*FAT_SECTOR_SIZE)+sizeof(vfs_header), SEEK_SET) == -1L)
-    {
-       printf("Read seek fail\n");
-       return -1; 
-    }
-	
-	read(disk, buffer, FAT_SECTOR_SIZE);
+	vfs_cached_sector * pCached = &g_sectorCache[sector & (VFS_SECTOR_CACHE_SIZE - 1)];
+	bool sequential = (sector == (g_ulLastReadSector + 1));
+	g_ulLastReadSector = sector;
+
+	if(pCached->valid && pCached->sector == sector)
+	{
+		memcpy(buffer, pCached->data, FAT_SECTOR_SIZE);
+		return 1;
+	}
+
+	// Sequential reads (file data) read and decrypt the next sectors at once so
+	// the following reads come from the cache
+	static unsigned char readBuffer[VFS_READ_AHEAD_SECTORS*FAT_SECTOR_SIZE];
+	unsigned long count = media_read_raw(sector, sequential ? VFS_READ_AHEAD_SECTORS : 1, readBuffer);
+
+	if(count == 0)
+		return -1;
+
 #ifdef XOR_ENCRYPTION
-	for(int i = 0; i < FAT_SECTOR_SIZE; i++)
-		buffer[i] ^= xorkey_512[i];
-#else if AES_ENCRYPTION
-	encAES.ResetChain();
-	encAES.Decrypt((char*)buffer, (char*)g_buf, FAT_SECTOR_SIZE);
-	memcpy(buffer, g_buf, FAT_SECTOR_SIZE);
+	for(unsigned long i = 0; i < count*FAT_SECTOR_SIZE; i++)
+		readBuffer[i] ^= xorkey_512[i % FAT_SECTOR_SIZE];
+#elif defined(AES_ENCRYPTION)
+	encAES.Decrypt(readBuffer, readBuffer, count*FAT_SECTOR_SIZE);
 #endif
+
+	for(unsigned long i = 0; i < count; i++)
+	{
+		// Sectors that are cached already are the same as on the disk
+		vfs_cached_sector * pReadAhead = &g_sectorCache[(sector + i) & (VFS_SECTOR_CACHE_SIZE - 1)];
+
+		if(i == 0 || !pReadAhead->valid || pReadAhead->sector != (sector + i))
+			media_cache_sector(sector + i, readBuffer + i*FAT_SECTOR_SIZE);
+	}
+
+	memcpy(buffer, readBuffer, FAT_SECTOR_SIZE);
 	return 1;
 }
 
@@ -88,23 +256,15 @@ int media_write(unsigned long sector, unsigned char *buffer)
        return -1; 
     }
 
+	// Encrypt into our own buffer so the callers buffer stays decrypted
 #ifdef XOR_ENCRYPTION
 	for(int i = 0; i < FAT_SECTOR_SIZE; i++)
-		buffer[i] ^= xorkey_512[i];
-#else if AES_ENCRYPTION
-	encAES.ResetChain();
-	encAES.Encrypt((char*)buffer, (char*)g_buf, FAT_SECTOR_SIZE);
-	memcpy(buffer, g_buf, FAT_SECTOR_SIZE);
-#endif
-	write(disk, buffer, FAT_SECTOR_SIZE);
-#ifdef XOR_ENCRYPTION
-	for(int i = 0; i < FAT_SECTOR_SIZE; i++)
-		buffer[i] ^= xorkey_512[i];
-#else if AES_ENCRYPTION
-	encAES.ResetChain();
-	encAES.Decrypt((char*)buffer, (char*)g_buf, FAT_SECTOR_SIZE);
-	memcpy(buffer, g_buf, FAT_SECTOR_SIZE);
+		g_buf[i] = buffer[i] ^ xorkey_512[i];
+#elif defined(AES_ENCRYPTION)
+	encAES.Encrypt(buffer, g_buf, FAT_SECTOR_SIZE);
 #endif
+	write(disk, g_buf, FAT_SECTOR_SIZE);
+	media_cache_sector(sector, buffer);
 	return 1;
 }
 
@@ -175,7 +335,7 @@ void CVFS::SetKey(char * szKey)
 		key[16] = 0;
 	}
 
-	encAES.MakeKey(key, CRijndael::sm_chain0, 16, 16);
+	encAES.SetKey(key);
 }
 
 void CVFS::ConnectDisk(const char * szFileName)
@@ -195,7 +355,8 @@ void CVFS::ConnectDisk(const char * szFileName)
 void CVFS::DisconnectDisk()
 {
 	fl_shutdown();
-	close(disk);
+	media_shutdown();
+	m_bConnected = false;
 }
 
 void CVFS::CreateDisk(const char *szFileName, int mbSize)
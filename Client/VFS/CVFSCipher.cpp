@@ -0,0 +1,174 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CVFSCipher.cpp
+// Project: Client.VFS
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//============================================================================== 
+
+#include <string.h>
+#include "CVFSCipher.h"
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AES_NI_FUNCTION
+#else
+#include <cpuid.h>
+#define AES_NI_FUNCTION __attribute__((target("sse2,aes")))
+#endif
+
+CVFSCipher::CVFSCipher()
+{
+	m_bHardware = false;
+	memset(m_ucEncryptKeys, 0, sizeof(m_ucEncryptKeys));
+	memset(m_ucDecryptKeys, 0, sizeof(m_ucDecryptKeys));
+}
+
+bool CVFSCipher::IsHardwareSupported()
+{
+	// The aes instructions are reported in bit 25 of ecx of cpuid function 1
+#ifdef _MSC_VER
+	int iInfo[4];
+	__cpuid(iInfo, 0);
+
+	if(iInfo[0] < 1)
+		return false;
+
+	__cpuid(iInfo, 1);
+	return ((iInfo[2] & (1 << 25)) != 0);
+#else
+	unsigned int uiEax, uiEbx, uiEcx, uiEdx;
+
+	if(!__get_cpuid(1, &uiEax, &uiEbx, &uiEcx, &uiEdx))
+		return false;
+
+	return ((uiEcx & (1 << 25)) != 0);
+#endif
+}
+
+// Rcon must be a constant for aeskeygenassist so each round is expanded by a macro
+#define AES_EXPAND_KEY(key, rcon) AesExpandKey(key, _mm_aeskeygenassist_si128(key, rcon))
+
+AES_NI_FUNCTION static __m128i AesExpandKey(__m128i key, __m128i keygened)
+{
+	keygened = _mm_shuffle_epi32(keygened, _MM_SHUFFLE(3, 3, 3, 3));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, keygened);
+}
+
+AES_NI_FUNCTION void CVFSCipher::MakeHardwareKeys(const char * szKey)
+{
+	__m128i keys[VFS_CIPHER_ROUND_KEYS];
+	keys[0] = _mm_loadu_si128((const __m128i *)szKey);
+	keys[1] = AES_EXPAND_KEY(keys[0], 0x01);
+	keys[2] = AES_EXPAND_KEY(keys[1], 0x02);
+	keys[3] = AES_EXPAND_KEY(keys[2], 0x04);
+	keys[4] = AES_EXPAND_KEY(keys[3], 0x08);
+	keys[5] = AES_EXPAND_KEY(keys[4], 0x10);
+	keys[6] = AES_EXPAND_KEY(keys[5], 0x20);
+	keys[7] = AES_EXPAND_KEY(keys[6], 0x40);
+	keys[8] = AES_EXPAND_KEY(keys[7], 0x80);
+	keys[9] = AES_EXPAND_KEY(keys[8], 0x1B);
+	keys[10] = AES_EXPAND_KEY(keys[9], 0x36);
+
+	// The decryption uses the encryption keys in the reverse order with inverse mix columns applied
+	for(int i = 0; i < VFS_CIPHER_ROUND_KEYS; i++)
+	{
+		_mm_storeu_si128((__m128i *)m_ucEncryptKeys[i], keys[i]);
+
+		__m128i decryptKey = keys[VFS_CIPHER_ROUND_KEYS - 1 - i];
+
+		if(i != 0 && i != (VFS_CIPHER_ROUND_KEYS - 1))
+			decryptKey = _mm_aesimc_si128(decryptKey);
+
+		_mm_storeu_si128((__m128i *)m_ucDecryptKeys[i], decryptKey);
+	}
+}
+
+AES_NI_FUNCTION void CVFSCipher::HardwareEncrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize)
+{
+	__m128i keys[VFS_CIPHER_ROUND_KEYS];
+
+	for(int i = 0; i < VFS_CIPHER_ROUND_KEYS; i++)
+		keys[i] = _mm_loadu_si128((const __m128i *)m_ucEncryptKeys[i]);
+
+	for(unsigned int uiOffset = 0; uiOffset < uiSize; uiOffset += 16)
+	{
+		__m128i block = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ucIn + uiOffset)), keys[0]);
+
+		for(int i = 1; i < (VFS_CIPHER_ROUND_KEYS - 1); i++)
+			block = _mm_aesenc_si128(block, keys[i]);
+
+		_mm_storeu_si128((__m128i *)(ucOut + uiOffset), _mm_aesenclast_si128(block, keys[VFS_CIPHER_ROUND_KEYS - 1]));
+	}
+}
+
+AES_NI_FUNCTION void CVFSCipher::HardwareDecrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize)
+{
+	__m128i keys[VFS_CIPHER_ROUND_KEYS];
+
+	for(int i = 0; i < VFS_CIPHER_ROUND_KEYS; i++)
+		keys[i] = _mm_loadu_si128((const __m128i *)m_ucDecryptKeys[i]);
+
+	unsigned int uiOffset = 0;
+
+	// Ecb blocks don't depend on each other so four are decrypted at once to keep the aes unit busy
+	for(; (uiOffset + 64) <= uiSize; uiOffset += 64)
+	{
+		__m128i block0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ucIn + uiOffset)), keys[0]);
+		__m128i block1 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ucIn + uiOffset + 16)), keys[0]);
+		__m128i block2 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ucIn + uiOffset + 32)), keys[0]);
+		__m128i block3 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ucIn + uiOffset + 48)), keys[0]);
+
+		for(int i = 1; i < (VFS_CIPHER_ROUND_KEYS - 1); i++)
+		{
+			block0 = _mm_aesdec_si128(block0, keys[i]);
+			block1 = _mm_aesdec_si128(block1, keys[i]);
+			block2 = _mm_aesdec_si128(block2, keys[i]);
+			block3 = _mm_aesdec_si128(block3, keys[i]);
+		}
+
+		_mm_storeu_si128((__m128i *)(ucOut + uiOffset), _mm_aesdeclast_si128(block0, keys[VFS_CIPHER_ROUND_KEYS - 1]));
+		_mm_storeu_si128((__m128i *)(ucOut + uiOffset + 16), _mm_aesdeclast_si128(block1, keys[VFS_CIPHER_ROUND_KEYS - 1]));
+		_mm_storeu_si128((__m128i *)(ucOut + uiOffset + 32), _mm_aesdeclast_si128(block2, keys[VFS_CIPHER_ROUND_KEYS - 1]));
+		_mm_storeu_si128((__m128i *)(ucOut + uiOffset + 48), _mm_aesdeclast_si128(block3, keys[VFS_CIPHER_ROUND_KEYS - 1]));
+	}
+
+	for(; uiOffset < uiSize; uiOffset += 16)
+	{
+		__m128i block = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(ucIn + uiOffset)), keys[0]);
+
+		for(int i = 1; i < (VFS_CIPHER_ROUND_KEYS - 1); i++)
+			block = _mm_aesdec_si128(block, keys[i]);
+
+		_mm_storeu_si128((__m128i *)(ucOut + uiOffset), _mm_aesdeclast_si128(block, keys[VFS_CIPHER_ROUND_KEYS - 1]));
+	}
+}
+
+void CVFSCipher::SetKey(const char * szKey)
+{
+	m_rijndael.MakeKey(szKey, CRijndael::sm_chain0, 16, 16);
+	m_bHardware = IsHardwareSupported();
+
+	if(m_bHardware)
+		MakeHardwareKeys(szKey);
+}
+
+void CVFSCipher::Encrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize)
+{
+	if(m_bHardware)
+		HardwareEncrypt(ucIn, ucOut, uiSize);
+	else
+		m_rijndael.Encrypt((const char *)ucIn, (char *)ucOut, uiSize);
+}
+
+void CVFSCipher::Decrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize)
+{
+	if(m_bHardware)
+		HardwareDecrypt(ucIn, ucOut, uiSize);
+	else
+		m_rijndael.Decrypt((const char *)ucIn, (char *)ucOut, uiSize);
+}
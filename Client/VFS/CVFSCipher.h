@@ -0,0 +1,42 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CVFSCipher.h
+// Project: Client.VFS
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//============================================================================== 
+
+#pragma once
+
+#include "Rijndael.h"
+
+// Amount of round keys of a 128 bit aes key
+#define VFS_CIPHER_ROUND_KEYS 11
+
+// Encrypts and decrypts the disk sectors (aes 128 in ecb mode), uses the aes
+// instructions of the cpu if it has them and the software aes if not
+class CVFSCipher
+{
+private:
+	CRijndael     m_rijndael;
+	bool          m_bHardware;
+	unsigned char m_ucEncryptKeys[VFS_CIPHER_ROUND_KEYS][16];
+	unsigned char m_ucDecryptKeys[VFS_CIPHER_ROUND_KEYS][16];
+
+	static bool   IsHardwareSupported();
+	void          MakeHardwareKeys(const char * szKey);
+	void          HardwareEncrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize);
+	void          HardwareDecrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize);
+
+public:
+	CVFSCipher();
+
+	// The key must be 16 characters long
+	void          SetKey(const char * szKey);
+	bool          IsHardware() { return m_bHardware; }
+
+	// The size must be a multiple of 16
+	void          Encrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize);
+	void          Decrypt(const unsigned char * ucIn, unsigned char * ucOut, unsigned int uiSize);
+};
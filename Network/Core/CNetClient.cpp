@@ -20,8 +20,9 @@ CNetClient::CNetClient()
 	// Reset the server address
 	m_serverAddress = RakNet::UNASSIGNED_SYSTEM_ADDRESS;
 
-	// Reset the connected flag
+	// Reset the connected flags
 	m_bConnected = false;
+	m_bNetworkConnected = false;
 
 	// Reset the port
 	m_usPort = 0xFFFF;
@@ -31,24 +32,109 @@ CNetClient::CNetClient()
 
 	// Create the server socket
 	m_serverSocket = CPlayerSocket();
+
+	// Reset the process time limit
+	m_uiProcessTimeLimit = 0;
+
+	// Reset the network thread
+	m_bNetworkThreadEnabled = false;
+	m_bNetworkThreadRunning = false;
+	m_bNetworkThreadActive = false;
 }
 
 CNetClient::~CNetClient()
 {
+	StopNetworkThread();
+	ClearQueues();
 	SAFE_DELETE(m_pRakPeer);
 }
 
+RAK_THREAD_DECLARATION(CNetClient::NetworkThread)
+{
+	CNetClient * pNetClient = (CNetClient *)arguments;
+	pNetClient->m_bNetworkThreadActive = true;
+
+	while(pNetClient->m_bNetworkThreadRunning)
+	{
+		// Return the packets the packet handler is done with to the pool
+		CPacket * pPacket = NULL;
+
+		while(pPacket = pNetClient->m_freeQueue.Pop())
+			pNetClient->m_packetPool.Free(pPacket);
+
+		// Move all received packets to the receive queue
+		while(pNetClient->m_bNetworkThreadRunning && (pPacket = pNetClient->Receive()))
+		{
+			// Wait for the packet handler if the receive queue is full
+			while(!pNetClient->m_receiveQueue.Push(pPacket))
+				RakSleep(1);
+		}
+
+		RakSleep(1);
+	}
+
+	pNetClient->m_bNetworkThreadActive = false;
+	return 0;
+}
+
+void CNetClient::StartNetworkThread()
+{
+	if(!m_bNetworkThreadEnabled || m_bNetworkThreadRunning)
+		return;
+
+	m_bNetworkThreadRunning = true;
+
+	if(RakNet::RakThread::Create(NetworkThread, this) != 0)
+		m_bNetworkThreadRunning = false;
+}
+
+void CNetClient::StopNetworkThread()
+{
+	if(!m_bNetworkThreadRunning)
+		return;
+
+	// Tell the network thread to stop and wait for it to exit
+	m_bNetworkThreadRunning = false;
+
+	while(m_bNetworkThreadActive)
+		RakSleep(1);
+}
+
+void CNetClient::ClearQueues()
+{
+	// Drop all packets the packet handler never got (the network thread must be stopped)
+	CPacket * pPacket = NULL;
+
+	while(pPacket = m_receiveQueue.Pop())
+	{
+		m_pRakPeer->DeallocatePacket((RakNet::Packet *)pPacket->pInternalPacket);
+		m_packetPool.Free(pPacket);
+	}
+
+	while(pPacket = m_freeQueue.Pop())
+		m_packetPool.Free(pPacket);
+}
+
 bool CNetClient::Startup()
 {
 	// TODO: Return the real result instead of a boolean
-	return (m_pRakPeer->Startup(1, &RakNet::SocketDescriptor(), 1, THREAD_PRIORITY_NORMAL) == RakNet::RAKNET_STARTED);
+	RakNet::SocketDescriptor socketDescriptor;
+	bool bStarted = (m_pRakPeer->Startup(1, &socketDescriptor, 1, THREAD_PRIORITY_NORMAL) == RakNet::RAKNET_STARTED);
+
+	// Start the network thread if enabled
+	if(bStarted)
+		StartNetworkThread();
+
+	return bStarted;
 }
 
 void CNetClient::Shutdown(int iBlockDuration)
 {
-	if(IsConnected())
+	if(m_bConnected || m_bNetworkConnected)
 		Disconnect();
 
+	StopNetworkThread();
+	ClearQueues();
 	m_pRakPeer->Shutdown(iBlockDuration);
 }
 
@@ -65,9 +151,14 @@ eConnectionAttemptResult CNetClient::Connect()
 
 void CNetClient::Disconnect()
 {
-	if(IsConnected())
+	if(m_bConnected || m_bNetworkConnected)
 	{
+		// Stop the network thread while the RakNet peer restarts, packets
+		// of the old connection that were not handled yet are dropped
+		StopNetworkThread();
+		ClearQueues();
 		m_bConnected = false;
+		m_bNetworkConnected = false;
 		m_pRakPeer->CloseConnection(m_serverAddress, true);
 		Shutdown(500);
 		Startup();
@@ -76,23 +167,37 @@ void CNetClient::Disconnect()
 	}
 }
 
+void CNetClient::HandlePacket(CPacket * pPacket)
+{
+	// Are we connected now?
+	if(pPacket->packetId == PACKET_CONNECTION_SUCCEEDED)
+		m_bConnected = true;
+
+	// Do we have a packet handler?
+	if(m_pfnPacketHandler)
+	{
+		// Pass it to the packet handler
+		m_pfnPacketHandler(pPacket);
+	}
+
+	// Deallocate the packet memory used
+	DeallocatePacket(pPacket);
+}
+
 void CNetClient::Process()
 {
 	CPacket * pPacket = NULL;
+	unsigned long ulStartTime = SharedUtility::GetTime();
 
-	// Loop until we have processed all packets in the packet queue (if any)
-	while(pPacket = Receive())
+	// Loop until we have processed all packets in the receive queue (or the
+	// RakNet packet queue without the network thread) or we are out of time,
+	// the packets left are handled in the next process
+	while(pPacket = (m_bNetworkThreadRunning ? m_receiveQueue.Pop() : Receive()))
 	{
-		// Do we have a packet handler?
-		if(m_pfnPacketHandler)
-		{
-			// Pass it to the packet handler
-			m_pfnPacketHandler(pPacket);
-		}
-		if(!pPacket)
-			return;
-		// Deallocate the packet memory used
-		DeallocatePacket(pPacket);
+		HandlePacket(pPacket);
+
+		if(m_uiProcessTimeLimit > 0 && (SharedUtility::GetTime() - ulStartTime) >= m_uiProcessTimeLimit)
+			break;
 	}
 }
 
@@ -109,7 +214,7 @@ const char * CNetClient::GetPassword()
 
 unsigned int CNetClient::Send(CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel)
 {
-	if(IsConnected() && pBitStream)
+	if(m_bNetworkConnected && pBitStream)
 		return m_pRakPeer->Send((char *)pBitStream->GetData(), pBitStream->GetNumberOfBytesUsed(), (PacketPriority)priority, (PacketReliability)reliability, cOrderingChannel, m_serverAddress, false);
 
 	return 0;
@@ -117,7 +222,7 @@ unsigned int CNetClient::Send(CBitStream * pBitStream, ePacketPriority priority,
 
 unsigned int CNetClient::RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel)
 {
-	if(IsConnected())
+	if(m_bNetworkConnected)
 	{
 		CBitStream bitStream;
 		bitStream.Write((PacketId)PACKET_RPC);
@@ -164,7 +269,7 @@ PacketId CNetClient::ProcessPacket(RakNet::SystemAddress systemAddress, PacketId
 	EntityId playerId = (EntityId)systemAddress.systemIndex;
 
 	// Are we not fully connected yet?
-	if(!m_bConnected)
+	if(!m_bNetworkConnected)
 	{
 		// Is this not a pre-connect packet?
 		switch(packetId)
@@ -214,17 +319,20 @@ PacketId CNetClient::ProcessPacket(RakNet::SystemAddress systemAddress, PacketId
 			// Write the network module version
 			bitStreamSend.Write((BYTE)NETWORK_MODULE_VERSION);
 
-			// Send the packet
-			m_bConnected = true;
-			Send(&bitStreamSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, false);
-			m_bConnected = false;
+			// Send back the cookie of the server
+			unsigned int uiCookie = 0;
+			bitStream.Read(uiCookie);
+			bitStreamSend.Write(uiCookie);
+
+			// Send the packet (directly as we are not connected yet)
+			m_pRakPeer->Send((char *)bitStreamSend.GetData(), bitStreamSend.GetNumberOfBytesUsed(), (PacketPriority)PRIORITY_HIGH, (PacketReliability)RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_DEFAULT, m_serverAddress, false);
 			return INVALID_PACKET_ID;
 		}
 		break;
 	case (ID_USER_PACKET_ENUM + 1): // Connection accepted
 		{
-			// Set our connected state
-			m_bConnected = true;
+			// Set our connected state (the packet handler is told when it gets the packet)
+			m_bNetworkConnected = true;
 
 			// Construct the bit stream
 			CBitStream bitStream;
@@ -290,39 +398,45 @@ CPacket * CNetClient::Receive()
 		// Process the packet and get the packet id
 		PacketId packetId = ProcessPacket(pRakPacket->systemAddress, pRakPacket->data[0], ucData, uiLength);
 
-		// Is this a valid packet?
-		if(packetId != INVALID_PACKET_ID)
+		// Hand compressed rpcs to the packet handler like any other rpc
+		if(packetId == PACKET_RPC_COMPRESSED)
+		{
+			RakNet::Packet * pDecompressedPacket = Decompress(pRakPacket);
+			m_pRakPeer->DeallocatePacket(pRakPacket);
+
+			if(!pDecompressedPacket)
+				return NULL;
+
+			pRakPacket = pDecompressedPacket;
+			ucData = (pRakPacket->data + sizeof(PacketId));
+			uiLength = (pRakPacket->length - sizeof(PacketId));
+			packetId = PACKET_RPC;
+		}
+
+		// Is this not a valid packet?
+		if(packetId == INVALID_PACKET_ID)
 		{
-			// Create the new packet
-			pPacket = new CPacket();
-
-			// Set the packet id
-			pPacket->packetId = packetId;
-
-			// Set the packet player socket
-			pPacket->pPlayerSocket = &m_serverSocket;
-
-			// Set the packet length
-			pPacket->uiLength = uiLength;
-
-			// Do we have any packet data?
-			if(uiLength > 0)
-			{
-				// Allocate and set the packet data
-				pPacket->ucData = (unsigned char *)malloc(uiLength);
-
-				// Copy the packet data
-				memcpy(pPacket->ucData, ucData, uiLength);
-			}
-			else
-			{
-				// Reset the packet data pointer
-				pPacket->ucData = NULL;
-			}
+			// Free the RakNet packet
+			m_pRakPeer->DeallocatePacket(pRakPacket);
+			return NULL;
 		}
 
-		// Free the RakNet packet
-		m_pRakPeer->DeallocatePacket(pRakPacket);
+		// Get a packet from the pool
+		pPacket = m_packetPool.Allocate();
+
+		// Set the packet id
+		pPacket->packetId = packetId;
+
+		// Set the packet player socket
+		pPacket->pPlayerSocket = &m_serverSocket;
+
+		// Set the packet length
+		pPacket->uiLength = uiLength;
+
+		// Point the packet data at the RakNet packet data, the RakNet packet
+		// is kept until the packet is deallocated
+		pPacket->ucData = ((uiLength > 0) ? ucData : NULL);
+		pPacket->pInternalPacket = pRakPacket;
 		return pPacket;
 	}
 
@@ -330,17 +444,52 @@ CPacket * CNetClient::Receive()
 	return NULL;
 }
 
+RakNet::Packet * CNetClient::Decompress(RakNet::Packet * pRakPacket)
+{
+	unsigned int uiHeaderSize = (sizeof(PacketId) + sizeof(unsigned int));
+
+	if(pRakPacket->length <= uiHeaderSize)
+		return NULL;
+
+	unsigned int uiLength = 0;
+	memcpy(&uiLength, (pRakPacket->data + sizeof(PacketId)), sizeof(unsigned int));
+
+	// Never trust the size the packet claims too much
+	if(uiLength < sizeof(RPCIdentifier) || uiLength > NET_MAX_DECOMPRESSED_SIZE)
+		return NULL;
+
+	// The decompressed packet is freed by RakNet like the one it was received in
+	RakNet::Packet * pDecompressedPacket = m_pRakPeer->AllocatePacket(sizeof(PacketId) + uiLength);
+	pDecompressedPacket->data[0] = (PacketId)PACKET_RPC;
+	pDecompressedPacket->systemAddress = pRakPacket->systemAddress;
+	pDecompressedPacket->guid = pRakPacket->guid;
+	uLongf ulLength = uiLength;
+
+	if(uncompress((pDecompressedPacket->data + sizeof(PacketId)), &ulLength, (pRakPacket->data + uiHeaderSize), (pRakPacket->length - uiHeaderSize)) != Z_OK || ulLength != uiLength)
+	{
+		m_pRakPeer->DeallocatePacket(pDecompressedPacket);
+		return NULL;
+	}
+
+	return pDecompressedPacket;
+}
+
 void CNetClient::DeallocatePacket(CPacket * pPacket)
 {
-	// Check if we have a disconnection packet
-	if(pPacket->packetId == PACKET_CONNECTION_REJECTED || pPacket->packetId == PACKET_DISCONNECTED || pPacket->packetId == PACKET_LOST_CONNECTION)
-		Disconnect();
+	// Check if we have a disconnection packet (before the network thread can reuse the packet)
+	PacketId packetId = pPacket->packetId;
 
-	// Free the packet data
-	SAFE_FREE(pPacket->ucData);
+	// Free the RakNet packet (before a disconnect restarts the RakNet peer)
+	m_pRakPeer->DeallocatePacket((RakNet::Packet *)pPacket->pInternalPacket);
 
-	// Delete the packet
-	SAFE_DELETE(pPacket);
+	// Return the packet to the pool (through the network thread if it owns the pool)
+	if(!m_bNetworkThreadRunning)
+		m_packetPool.Free(pPacket);
+	else if(!m_freeQueue.Push(pPacket))
+		delete pPacket;
+
+	if(packetId == PACKET_CONNECTION_REJECTED || packetId == PACKET_DISCONNECTED || packetId == PACKET_LOST_CONNECTION)
+		Disconnect();
 }
 
 CNetStats * CNetClient::GetNetStats()
@@ -11,21 +11,39 @@
 
 #include <StdInc.h>
 
+// Size a compressed rpc can be decompressed to at most, bigger ones are dropped
+#define NET_MAX_DECOMPRESSED_SIZE 16777216
+
 class CNetClient : CRakNetInterface, public CNetClientInterface
 {
 private:
 	RakNet::RakPeerInterface * m_pRakPeer;
 	RakNet::SystemAddress      m_serverAddress;
-	bool                       m_bConnected;
+	bool                       m_bConnected; // The packet handler got the connection succeeded packet
+	volatile bool              m_bNetworkConnected; // The handshake is done
 	String                     m_strHost;
 	unsigned short             m_usPort;
 	String                     m_strPassword;
 	PacketHandler_t            m_pfnPacketHandler;
 	CPlayerSocket              m_serverSocket;
+	CPacketPool                m_packetPool;
+	unsigned int               m_uiProcessTimeLimit;
+	bool                       m_bNetworkThreadEnabled;
+	volatile bool              m_bNetworkThreadRunning;
+	volatile bool              m_bNetworkThreadActive;
+	CPacketQueue               m_receiveQueue;
+	CPacketQueue               m_freeQueue;
+	CNetSimulator              m_netSimulator;
 
 	PacketId                 ProcessPacket(RakNet::SystemAddress systemAddress, PacketId packetId, unsigned char * ucData, int iLength);
 	CPacket *                Receive();
+	RakNet::Packet *         Decompress(RakNet::Packet * pRakPacket);
 	void                     DeallocatePacket(CPacket * pPacket);
+	void                     HandlePacket(CPacket * pPacket);
+	void                     StartNetworkThread();
+	void                     StopNetworkThread();
+	void                     ClearQueues();
+	static RAK_THREAD_DECLARATION(NetworkThread);
 
 public:
 	CNetClient();
@@ -51,4 +69,8 @@ public:
 	CNetStats              * GetNetStats();
 	int                      GetLastPing();
 	int                      GetAveragePing();
+	void                     SetNetworkThreadEnabled(bool bEnabled) { m_bNetworkThreadEnabled = bEnabled; }
+	void                     SetProcessTimeLimit(unsigned int uiMilliseconds) { m_uiProcessTimeLimit = uiMilliseconds; }
+	void                     SetNetSimulator(const NetSimulatorSettings& settings) { m_netSimulator.SetSettings(settings); }
+	void                     GetNetSimulatorStats(NetSimulatorStats * pStats) { m_netSimulator.GetStats(pStats); }
 };
@@ -19,11 +19,131 @@ CNetServer::CNetServer()
 
 	// Reset the packet handler
 	m_pfnPacketHandler = NULL;
+
+	// Reset the connection filter
+	m_pfnConnectionFilter = NULL;
+
+	// Reset the player socket arrays
+	m_pPlayerSockets = NULL;
+	m_pNetworkSockets = NULL;
+	m_pNetworkSocketsQueued = NULL;
+	m_pHandshakePending = NULL;
+	m_uiMaxPlayerSockets = 0;
+
+	// Reset the handshake limits
+	m_ulLastConnectionRatePrune = 0;
+	m_uiHandshakeBudget = NET_HANDSHAKE_BUDGET;
+	m_ulHandshakeBudgetTime = 0;
+	m_uiCookieSecret = (unsigned int)RakNet::RakPeerInterface::Get64BitUniqueRandomNumber();
+
+	// Don't compress rpcs until told to
+	m_uiCompressionThreshold = 0;
+
+	// Reset the network thread
+	m_bNetworkThreadEnabled = false;
+	m_bNetworkThreadRunning = false;
+	m_bNetworkThreadActive = false;
+	m_receiveEvent.InitEvent();
 }
 
 CNetServer::~CNetServer()
 {
+	StopNetworkThread();
 	SAFE_DELETE(m_pRakPeer);
+	DeletePlayerSockets();
+	m_receiveEvent.CloseEvent();
+}
+
+void CNetServer::DeletePlayerSockets()
+{
+	if(!m_pPlayerSockets)
+		return;
+
+	// Delete all packets the packet handler never got
+	CPacket * pPacket = NULL;
+
+	while(pPacket = m_receiveQueue.Pop())
+	{
+		// Disconnected sockets are no longer in the network socket array
+		if(pPacket->packetId == PACKET_DISCONNECTED || pPacket->packetId == PACKET_LOST_CONNECTION)
+		{
+			if(pPacket->pPlayerSocket && m_pPlayerSockets[pPacket->pPlayerSocket->playerId] != pPacket->pPlayerSocket)
+				delete pPacket->pPlayerSocket;
+		}
+
+		delete pPacket;
+	}
+
+	while(pPacket = m_freeQueue.Pop())
+		delete pPacket;
+
+	// Delete all remaining player sockets
+	for(unsigned int i = 0; i < m_uiMaxPlayerSockets; i++)
+	{
+		if(m_pNetworkSockets[i] != m_pPlayerSockets[i])
+			SAFE_DELETE(m_pNetworkSockets[i]);
+
+		SAFE_DELETE(m_pPlayerSockets[i]);
+	}
+
+	// Delete the player socket arrays
+	SAFE_DELETE_ARRAY(m_pPlayerSockets);
+	SAFE_DELETE_ARRAY(m_pNetworkSockets);
+	SAFE_DELETE_ARRAY(m_pNetworkSocketsQueued);
+	SAFE_DELETE_ARRAY(m_pHandshakePending);
+	m_pendingHandshakes.clear();
+	m_uiMaxPlayerSockets = 0;
+}
+
+RAK_THREAD_DECLARATION(CNetServer::NetworkThread)
+{
+	CNetServer * pNetServer = (CNetServer *)arguments;
+	pNetServer->m_bNetworkThreadActive = true;
+
+	while(pNetServer->m_bNetworkThreadRunning)
+	{
+		// Return the packets the packet handler is done with to the pool
+		CPacket * pPacket = NULL;
+
+		while(pPacket = pNetServer->m_freeQueue.Pop())
+			pNetServer->m_packetPool.Free(pPacket);
+
+		// Accept the handshakes the budget allows
+		pNetServer->ProcessPendingHandshakes();
+
+		// Move all received packets to the receive queue
+		bool bReceived = false;
+
+		while(pNetServer->m_bNetworkThreadRunning && (pPacket = pNetServer->Receive()))
+		{
+			// Wait for the packet handler if the receive queue is full
+			while(!pNetServer->m_receiveQueue.Push(pPacket))
+				RakSleep(1);
+
+			bReceived = true;
+		}
+
+		// Wake up the packet handler if it is waiting for packets
+		if(bReceived)
+			pNetServer->m_receiveEvent.SetEvent();
+
+		RakSleep(1);
+	}
+
+	pNetServer->m_bNetworkThreadActive = false;
+	return 0;
+}
+
+void CNetServer::StopNetworkThread()
+{
+	if(!m_bNetworkThreadRunning)
+		return;
+
+	// Tell the network thread to stop and wait for it to exit
+	m_bNetworkThreadRunning = false;
+
+	while(m_bNetworkThreadActive)
+		RakSleep(1);
 }
 
 bool CNetServer::Startup(unsigned short usPort, int iMaxPlayers, String strHostAddress)
@@ -33,34 +153,105 @@ bool CNetServer::Startup(unsigned short usPort, int iMaxPlayers, String strHostA
 	bool bStarted = (m_pRakPeer->Startup(iMaxPlayers, &socketDescriptor, 1, THREAD_PRIORITY_NORMAL) == RakNet::RAKNET_STARTED);
 
 	if(bStarted)
+	{
 		m_pRakPeer->SetMaximumIncomingConnections(iMaxPlayers);
 
+		// Create the player socket arrays, they are indexed by the RakNet system index
+		// which is always less than the maximum amount of connections
+		StopNetworkThread();
+		DeletePlayerSockets();
+		m_uiMaxPlayerSockets = (unsigned int)iMaxPlayers;
+		m_pPlayerSockets = new CPlayerSocket *[m_uiMaxPlayerSockets];
+		memset(m_pPlayerSockets, 0, (sizeof(CPlayerSocket *) * m_uiMaxPlayerSockets));
+		m_pNetworkSockets = new CPlayerSocket *[m_uiMaxPlayerSockets];
+		memset(m_pNetworkSockets, 0, (sizeof(CPlayerSocket *) * m_uiMaxPlayerSockets));
+		m_pNetworkSocketsQueued = new bool[m_uiMaxPlayerSockets];
+		memset(m_pNetworkSocketsQueued, 0, (sizeof(bool) * m_uiMaxPlayerSockets));
+		m_pHandshakePending = new bool[m_uiMaxPlayerSockets];
+		memset(m_pHandshakePending, 0, (sizeof(bool) * m_uiMaxPlayerSockets));
+
+		// Start the network thread if enabled
+		if(m_bNetworkThreadEnabled)
+		{
+			m_bNetworkThreadRunning = true;
+
+			if(RakNet::RakThread::Create(NetworkThread, this) != 0)
+				m_bNetworkThreadRunning = false;
+		}
+	}
+
 	return bStarted;
 }
 
 void CNetServer::Shutdown(int iBlockDuration)
 {
+	StopNetworkThread();
 	m_pRakPeer->Shutdown(iBlockDuration);
 }
 
+void CNetServer::HandlePacket(CPacket * pPacket)
+{
+	// Is this the first packet of a new player socket?
+	CPlayerSocket * pPlayerSocket = pPacket->pPlayerSocket;
+
+	if(pPlayerSocket && pPlayerSocket->playerId < m_uiMaxPlayerSockets && m_pPlayerSockets[pPlayerSocket->playerId] != pPlayerSocket)
+	{
+		// Delete any stale player socket for this player id, all packets
+		// with it have already been handled
+		SAFE_DELETE(m_pPlayerSockets[pPlayerSocket->playerId]);
+
+		// Add the player socket to the player socket array
+		m_pPlayerSockets[pPlayerSocket->playerId] = pPlayerSocket;
+	}
+
+	// Do we have a packet handler?
+	if(m_pfnPacketHandler)
+	{
+		// Pass it to the packet handler
+		m_pfnPacketHandler(pPacket);
+	}
+
+	// Deallocate the packet memory used
+	DeallocatePacket(pPacket);
+}
+
 void CNetServer::Process()
 {
 	CPacket * pPacket = NULL;
 
+	// Is the network thread receiving for us?
+	if(m_bNetworkThreadRunning)
+	{
+		// Loop until we have processed all packets in the receive queue (if any)
+		while(pPacket = m_receiveQueue.Pop())
+			HandlePacket(pPacket);
+
+		return;
+	}
+
+	// Accept the handshakes the budget allows
+	ProcessPendingHandshakes();
+
 	// Loop until we have processed all packets in the packet queue (if any)
 	while(pPacket = Receive())
+		HandlePacket(pPacket);
+}
+
+bool CNetServer::WaitForPackets(unsigned int uiTimeOutMilliseconds)
+{
+	// Without the network thread nothing tells us about new packets so just wait
+	if(!m_bNetworkThreadRunning)
 	{
-		// Do we have a packet handler?
-		if(m_pfnPacketHandler)
-		{
-			// Pass it to the packet handler
-			m_pfnPacketHandler(pPacket);
-		}
-		if(!this || !pPacket)
-			return;
-		// Deallocate the packet memory used
-		DeallocatePacket(pPacket);
+		RakSleep(uiTimeOutMilliseconds);
+		return false;
 	}
+
+	// Do we already have packets waiting?
+	if(!m_receiveQueue.IsEmpty())
+		return true;
+
+	m_receiveEvent.WaitOnEvent((int)uiTimeOutMilliseconds);
+	return !m_receiveQueue.IsEmpty();
 }
 
 void CNetServer::SetPassword(String strPassword)
@@ -83,17 +274,103 @@ unsigned int CNetServer::Send(CBitStream * pBitStream, ePacketPriority priority,
 		(playerId == INVALID_ENTITY_ID) ? RakNet::UNASSIGNED_SYSTEM_ADDRESS : m_pRakPeer->GetSystemAddressFromIndex(playerId), bBroadcast);
 }
 
+bool CNetServer::SendCompressed(const unsigned char * pData, unsigned int uiLength, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel, const RakNet::SystemAddress& systemAddress, bool bBroadcast, unsigned int * puiResult)
+{
+	// Only reliable rpcs are big enough to be worth it and a lost unreliable one
+	// would have been sent for nothing
+	if(m_uiCompressionThreshold == 0 || uiLength < m_uiCompressionThreshold || 
+		(reliability != RELIABILITY_RELIABLE && reliability != RELIABILITY_RELIABLE_ORDERED && reliability != RELIABILITY_RELIABLE_SEQUENCED))
+		return false;
+
+	// The packet id is replaced, the rpc identifier is compressed with the data
+	const unsigned char * pSource = (pData + sizeof(PacketId));
+	uLong ulSourceLength = (uiLength - sizeof(PacketId));
+	unsigned int uiHeaderSize = (sizeof(PacketId) + sizeof(unsigned int));
+	uLongf ulCompressedLength = compressBound(ulSourceLength);
+	std::vector<unsigned char> compressed(uiHeaderSize + ulCompressedLength);
+
+	if(compress2(&compressed[uiHeaderSize], &ulCompressedLength, pSource, ulSourceLength, NET_COMPRESSION_LEVEL) != Z_OK)
+		return false;
+
+	// Send it the normal way if it didn't get smaller
+	if((uiHeaderSize + ulCompressedLength) >= uiLength)
+		return false;
+
+	compressed[0] = (PacketId)PACKET_RPC_COMPRESSED;
+	unsigned int uiSourceLength = (unsigned int)ulSourceLength;
+	memcpy(&compressed[sizeof(PacketId)], &uiSourceLength, sizeof(unsigned int));
+	*puiResult = m_pRakPeer->Send((char *)&compressed[0], (uiHeaderSize + ulCompressedLength), (PacketPriority)priority, (PacketReliability)reliability, cOrderingChannel, systemAddress, bBroadcast);
+	return true;
+}
+
 unsigned int CNetServer::RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel)
 {
 	CBitStream bitStream;
+	bitStream.Reserve(RPC_HEADER_SIZE + (pBitStream ? pBitStream->GetNumberOfBytesUsed() : 0));
 	bitStream.Write((PacketId)PACKET_RPC);
 	bitStream.Write(rpcId);
 
 	if(pBitStream)
 		bitStream.Write((char *)pBitStream->GetData(), pBitStream->GetNumberOfBytesUsed());
 
+	RakNet::SystemAddress systemAddress = ((playerId == INVALID_ENTITY_ID) ? RakNet::UNASSIGNED_SYSTEM_ADDRESS : m_pRakPeer->GetSystemAddressFromIndex(playerId));
+	unsigned int uiResult = 0;
+
+	if(SendCompressed(bitStream.GetData(), bitStream.GetNumberOfBytesUsed(), priority, reliability, cOrderingChannel, systemAddress, bBroadcast, &uiResult))
+		return uiResult;
+
 	return m_pRakPeer->Send((char *)bitStream.GetData(), bitStream.GetNumberOfBytesUsed(), (PacketPriority)priority, (PacketReliability)reliability, cOrderingChannel, 
-		(playerId == INVALID_ENTITY_ID) ? RakNet::UNASSIGNED_SYSTEM_ADDRESS : m_pRakPeer->GetSystemAddressFromIndex(playerId), bBroadcast);
+		systemAddress, bBroadcast);
+}
+
+unsigned int CNetServer::RPCReserved(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel)
+{
+	// Ensure the header space was reserved
+	if(!pBitStream || pBitStream->GetNumberOfBytesUsed() < RPC_HEADER_SIZE)
+		return 0;
+
+	// Fill in the header in place so the payload is passed to RakNet without another copy
+	unsigned char * pData = pBitStream->GetData();
+	pData[0] = (PacketId)PACKET_RPC;
+	pData[sizeof(PacketId)] = rpcId;
+
+	RakNet::SystemAddress systemAddress = ((playerId == INVALID_ENTITY_ID) ? RakNet::UNASSIGNED_SYSTEM_ADDRESS : m_pRakPeer->GetSystemAddressFromIndex(playerId));
+	unsigned int uiResult = 0;
+
+	if(SendCompressed(pData, pBitStream->GetNumberOfBytesUsed(), priority, reliability, cOrderingChannel, systemAddress, bBroadcast, &uiResult))
+		return uiResult;
+
+	return m_pRakPeer->Send((char *)pData, pBitStream->GetNumberOfBytesUsed(), (PacketPriority)priority, (PacketReliability)reliability, cOrderingChannel, 
+		systemAddress, bBroadcast);
+}
+
+unsigned int CNetServer::RPCReservedBatch(RPCIdentifier rpcId, CBitStream ** ppBitStreams, const EntityId * pPlayerIds, unsigned int uiCount, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel)
+{
+	// Each bit stream goes to its own player, the headers are filled in the same way as RPCReserved
+	unsigned int uiSent = 0;
+
+	for(unsigned int i = 0; i < uiCount; i++)
+	{
+		CBitStream * pBitStream = ppBitStreams[i];
+
+		if(!pBitStream || pBitStream->GetNumberOfBytesUsed() < RPC_HEADER_SIZE || pPlayerIds[i] == INVALID_ENTITY_ID)
+			continue;
+
+		unsigned char * pData = pBitStream->GetData();
+		pData[0] = (PacketId)PACKET_RPC;
+		pData[sizeof(PacketId)] = rpcId;
+
+		RakNet::SystemAddress systemAddress = m_pRakPeer->GetSystemAddressFromIndex(pPlayerIds[i]);
+		unsigned int uiResult = 0;
+
+		if(!SendCompressed(pData, pBitStream->GetNumberOfBytesUsed(), priority, reliability, cOrderingChannel, systemAddress, false, &uiResult))
+			uiResult = m_pRakPeer->Send((char *)pData, pBitStream->GetNumberOfBytesUsed(), (PacketPriority)priority, (PacketReliability)reliability, cOrderingChannel, systemAddress, false);
+
+		if(uiResult != 0)
+			uiSent++;
+	}
+
+	return uiSent;
 }
 
 void CNetServer::RejectKick(EntityId playerId)
@@ -111,18 +388,153 @@ void CNetServer::RejectKick(EntityId playerId)
 	KickPlayer(playerId, false);
 }
 
+bool CNetServer::CheckConnectionRate(unsigned long ulBinaryAddress)
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	// Forget the addresses that can connect at their full burst again
+	if((ulTime - m_ulLastConnectionRatePrune) >= (NET_CONNECTION_INTERVAL * NET_CONNECTION_BURST))
+	{
+		std::map<unsigned long, NetConnectionRate>::iterator iter = m_connectionRates.begin();
+
+		while(iter != m_connectionRates.end())
+		{
+			if((ulTime - iter->second.ulTime) >= (NET_CONNECTION_INTERVAL * iter->second.uiConnections))
+				m_connectionRates.erase(iter++);
+			else
+				++iter;
+		}
+
+		m_ulLastConnectionRatePrune = ulTime;
+	}
+
+	std::map<unsigned long, NetConnectionRate>::iterator iter = m_connectionRates.find(ulBinaryAddress);
+
+	if(iter == m_connectionRates.end())
+	{
+		NetConnectionRate connectionRate;
+		connectionRate.uiConnections = 1;
+		connectionRate.ulTime = ulTime;
+		m_connectionRates[ulBinaryAddress] = connectionRate;
+		return true;
+	}
+
+	// Give back a connection for every interval that passed
+	NetConnectionRate& connectionRate = iter->second;
+	unsigned long ulIntervals = ((ulTime - connectionRate.ulTime) / NET_CONNECTION_INTERVAL);
+
+	if(ulIntervals >= connectionRate.uiConnections)
+	{
+		connectionRate.uiConnections = 0;
+		connectionRate.ulTime = ulTime;
+	}
+	else if(ulIntervals > 0)
+	{
+		connectionRate.uiConnections -= ulIntervals;
+		connectionRate.ulTime += (ulIntervals * NET_CONNECTION_INTERVAL);
+	}
+
+	if(connectionRate.uiConnections >= NET_CONNECTION_BURST)
+		return false;
+
+	connectionRate.uiConnections++;
+	return true;
+}
+
+unsigned int CNetServer::GetCookie(const RakNet::SystemAddress& systemAddress, unsigned long ulInterval)
+{
+	// The cookie proves the client got our reply at its address without us keeping
+	// anything for it, so a player socket is only made once the client sends it back
+	unsigned int uiHash = (m_uiCookieSecret ^ 2166136261U);
+	unsigned int uiValues[3] = { (unsigned int)systemAddress.address.addr4.sin_addr.s_addr, (unsigned int)systemAddress.address.addr4.sin_port, (unsigned int)ulInterval };
+
+	for(int i = 0; i < 3; i++)
+	{
+		uiHash ^= uiValues[i];
+		uiHash *= 16777619U;
+		uiHash ^= (uiHash >> 15);
+	}
+
+	return uiHash;
+}
+
+void CNetServer::AcceptHandshake(EntityId playerId, const RakNet::SystemAddress& systemAddress)
+{
+	// Delete any stale player socket for this player id the packet handler
+	// never got (if it did it deletes it once it gets the new one)
+	if(!m_pNetworkSocketsQueued[playerId])
+		SAFE_DELETE(m_pNetworkSockets[playerId]);
+
+	// Construct the new player socket
+	CPlayerSocket * pPlayerSocket = new CPlayerSocket;
+
+	// Set the player socket id
+	pPlayerSocket->playerId = playerId;
+
+	// Set the player socket binary address
+	pPlayerSocket->ulBinaryAddress = systemAddress.address.addr4.sin_addr.s_addr;
+
+	// Set the player socket port
+	pPlayerSocket->usPort = ntohs(systemAddress.address.addr4.sin_port);
+
+	// Add the player socket to the network socket array
+	m_pNetworkSockets[playerId] = pPlayerSocket;
+	m_pNetworkSocketsQueued[playerId] = false;
+
+	// Construct the bit stream
+	CBitStream bitStream;
+
+	// Write the packet id
+	bitStream.Write((PacketId)(ID_USER_PACKET_ENUM + 1));
+
+	// Send the packet
+	Send(&bitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+void CNetServer::ProcessPendingHandshakes()
+{
+	if(m_pendingHandshakes.empty())
+		return;
+
+	// Refill the budget every interval
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulHandshakeBudgetTime) >= NET_HANDSHAKE_INTERVAL)
+	{
+		m_uiHandshakeBudget = NET_HANDSHAKE_BUDGET;
+		m_ulHandshakeBudgetTime = ulTime;
+	}
+
+	while(m_uiHandshakeBudget > 0 && !m_pendingHandshakes.empty())
+	{
+		NetPendingHandshake pendingHandshake = m_pendingHandshakes.front();
+		m_pendingHandshakes.pop_front();
+
+		// Skip the handshakes of connections that are gone
+		if(!m_pHandshakePending[pendingHandshake.playerId] || m_pRakPeer->GetSystemAddressFromIndex(pendingHandshake.playerId) != pendingHandshake.systemAddress)
+			continue;
+
+		m_pHandshakePending[pendingHandshake.playerId] = false;
+		AcceptHandshake(pendingHandshake.playerId, pendingHandshake.systemAddress);
+		m_uiHandshakeBudget--;
+	}
+}
+
 PacketId CNetServer::ProcessPacket(RakNet::SystemAddress systemAddress, PacketId packetId, unsigned char * ucData, int iLength)
 {
 	// Get the player id
 	EntityId playerId = (EntityId)systemAddress.systemIndex;
 
 	// Is the player not fully connected yet?
-	if(!IsPlayerConnected(playerId))
+	if(playerId >= m_uiMaxPlayerSockets || !m_pNetworkSockets[playerId])
 	{
 		// Is this a disconnection or connection lost packet?
 		if(packetId == ID_DISCONNECTION_NOTIFICATION || packetId == ID_CONNECTION_LOST)
 		{
-			// Ignore it
+			// Drop its handshake if it is waiting and ignore it
+			if(playerId < m_uiMaxPlayerSockets)
+				m_pHandshakePending[playerId] = false;
+
 			return INVALID_PACKET_ID;
 		}
 
@@ -139,12 +551,31 @@ PacketId CNetServer::ProcessPacket(RakNet::SystemAddress systemAddress, PacketId
 	{
 	case ID_NEW_INCOMING_CONNECTION: // Request initial data
 		{
+			// Is the connection filtered out?
+			if(m_pfnConnectionFilter && !m_pfnConnectionFilter(systemAddress.address.addr4.sin_addr.s_addr))
+			{
+				// Reject the players connection
+				RejectKick(playerId);
+				return INVALID_PACKET_ID;
+			}
+
+			// Is the address connecting too often?
+			if(!CheckConnectionRate(systemAddress.address.addr4.sin_addr.s_addr))
+			{
+				// Reject the players connection
+				RejectKick(playerId);
+				return INVALID_PACKET_ID;
+			}
+
 			// Construct the bit stream
 			CBitStream bitStream;
 
 			// Write the packet id
 			bitStream.Write((PacketId)ID_USER_PACKET_ENUM);
 
+			// Write the cookie the client has to send back
+			bitStream.Write(GetCookie(systemAddress, (SharedUtility::GetTime() / NET_COOKIE_INTERVAL)));
+
 			// Send the packet
 			Send(&bitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 			return INVALID_PACKET_ID;
@@ -173,29 +604,43 @@ PacketId CNetServer::ProcessPacket(RakNet::SystemAddress systemAddress, PacketId
 				return INVALID_PACKET_ID;
 			}
 
-			// Construct the new player socket
-			CPlayerSocket * pPlayerSocket = new CPlayerSocket;
+			// Verify the cookie (it can be from the interval before)
+			unsigned int uiCookie;
+			unsigned long ulInterval = (SharedUtility::GetTime() / NET_COOKIE_INTERVAL);
 
-			// Set the player socket id
-			pPlayerSocket->playerId = playerId;
-
-			// Set the player socket binary address
-			pPlayerSocket->ulBinaryAddress = systemAddress.address.addr4.sin_addr.s_addr;
-
-			// Set the player socket port
-			pPlayerSocket->usPort = ntohs(systemAddress.address.addr4.sin_port);
+			if(!bitStream.Read(uiCookie) || (uiCookie != GetCookie(systemAddress, ulInterval) && uiCookie != GetCookie(systemAddress, (ulInterval - 1))))
+			{
+				// Reject the players connection
+				RejectKick(playerId);
+				return INVALID_PACKET_ID;
+			}
 
-			// Add the player socket to the player socket list
-			m_playerSocketList.push_back(pPlayerSocket);
+			// Is the player id out of the player socket array bounds?
+			if(playerId >= m_uiMaxPlayerSockets)
+			{
+				// Reject the players connection
+				RejectKick(playerId);
+				return INVALID_PACKET_ID;
+			}
 
-			// Reset the bit stream for reuse
-			bitStream.Reset();
+			// Is its handshake already waiting?
+			if(m_pHandshakePending[playerId])
+				return INVALID_PACKET_ID;
 
-			// Write the packet id
-			bitStream.Write((PacketId)(ID_USER_PACKET_ENUM + 1));
+			// Is the pending handshake queue full?
+			if(m_pendingHandshakes.size() >= NET_MAX_PENDING_HANDSHAKES)
+			{
+				// Reject the players connection
+				RejectKick(playerId);
+				return INVALID_PACKET_ID;
+			}
 
-			// Send the packet
-			Send(&bitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			// Queue the handshake, the player socket is made once it is accepted
+			NetPendingHandshake pendingHandshake;
+			pendingHandshake.playerId = playerId;
+			pendingHandshake.systemAddress = systemAddress;
+			m_pendingHandshakes.push_back(pendingHandshake);
+			m_pHandshakePending[playerId] = true;
 			return INVALID_PACKET_ID;
 		}
 		break;
@@ -237,39 +682,41 @@ CPacket * CNetServer::Receive()
 		// Process the packet and get the packet id
 		PacketId packetId = ProcessPacket(pRakPacket->systemAddress, pRakPacket->data[0], ucData, uiLength);
 
-		// Is this a valid packet?
-		if(packetId != INVALID_PACKET_ID)
+		// Is this not a valid packet?
+		if(packetId == INVALID_PACKET_ID)
 		{
-			// Create the new packet
-			pPacket = new CPacket;
-
-			// Set the packet player socket
-			pPacket->pPlayerSocket = GetPlayerSocket((EntityId)pRakPacket->systemAddress.systemIndex);
+			// Delete the RakNet packet
+			m_pRakPeer->DeallocatePacket(pRakPacket);
+			return NULL;
+		}
 
-			// Set the packet id
-			pPacket->packetId = packetId;
+		// Get a packet from the pool
+		pPacket = m_packetPool.Allocate();
 
-			// Set the packet length
-			pPacket->uiLength = uiLength;
+		// Set the packet player socket
+		EntityId playerId = (EntityId)pRakPacket->systemAddress.systemIndex;
+		pPacket->pPlayerSocket = NULL;
 
-			// Do we have any packet data?
-			if(uiLength > 0)
-			{
-				// Allocate and set the packet data
-				pPacket->ucData = (unsigned char *)malloc(uiLength);
+		if(playerId < m_uiMaxPlayerSockets)
+		{
+			pPacket->pPlayerSocket = m_pNetworkSockets[playerId];
+			m_pNetworkSocketsQueued[playerId] = true;
 
-				// Copy the packet data
-				memcpy(pPacket->ucData, ucData, uiLength);
-			}
-			else
-			{
-				// Reset the packet data pointer
-				pPacket->ucData = NULL;
-			}
+			// Disconnected player sockets are deleted once the packet handler is done with them
+			if(packetId == PACKET_DISCONNECTED || packetId == PACKET_LOST_CONNECTION)
+				m_pNetworkSockets[playerId] = NULL;
 		}
 
-		// Delete the RakNet packet
-		m_pRakPeer->DeallocatePacket(pRakPacket);
+		// Set the packet id
+		pPacket->packetId = packetId;
+
+		// Set the packet length
+		pPacket->uiLength = uiLength;
+
+		// Point the packet data at the RakNet packet data, the RakNet packet
+		// is kept until the packet is deallocated
+		pPacket->ucData = ((uiLength > 0) ? ucData : NULL);
+		pPacket->pInternalPacket = pRakPacket;
 		return pPacket;
 	}
 
@@ -279,26 +726,31 @@ CPacket * CNetServer::Receive()
 
 void CNetServer::DeallocatePacket(CPacket * pPacket)
 {
-	if(!this)
-		return;
 	// Check if we have a disconnection packet
 	if(pPacket->packetId == PACKET_DISCONNECTED || pPacket->packetId == PACKET_LOST_CONNECTION)
 	{
 		// Get the player socket
 		CPlayerSocket * pPlayerSocket = pPacket->pPlayerSocket;
 
-		// Delete the player socket
-		SAFE_DELETE(pPlayerSocket);
+		if(pPlayerSocket)
+		{
+			// Remove the player socket from the player socket array
+			if(pPlayerSocket->playerId < m_uiMaxPlayerSockets && m_pPlayerSockets[pPlayerSocket->playerId] == pPlayerSocket)
+				m_pPlayerSockets[pPlayerSocket->playerId] = NULL;
 
-		// Remove the player socket from the player socket list
-		m_playerSocketList.remove(pPlayerSocket);
+			// Delete the player socket
+			SAFE_DELETE(pPlayerSocket);
+		}
 	}
 
-	// Free the packet data
-	SAFE_FREE(pPacket->ucData);
+	// Delete the RakNet packet
+	m_pRakPeer->DeallocatePacket((RakNet::Packet *)pPacket->pInternalPacket);
 
-	// Delete the packet
-	SAFE_DELETE(pPacket);
+	// Return the packet to the pool (through the network thread if it owns the pool)
+	if(!m_bNetworkThreadRunning)
+		m_packetPool.Free(pPacket);
+	else if(!m_freeQueue.Push(pPacket))
+		delete pPacket;
 }
 
 const char * CNetServer::GetPlayerIp(EntityId playerId)
@@ -323,19 +775,11 @@ void CNetServer::KickPlayer(EntityId playerId, bool bSendDisconnectionNotificati
 
 CPlayerSocket * CNetServer::GetPlayerSocket(EntityId playerId)
 {
-	// Loop through the player socket list
-	for(std::list<CPlayerSocket *>::iterator iter = m_playerSocketList.begin(); iter != m_playerSocketList.end(); iter++)
-	{
-		// Is this the player socket we are looking for?
-		if((*iter)->playerId == playerId)
-		{
-			// Return the player socket
-			return (*iter);
-			break;
-		}
-	}
+	// Is the player id out of the player socket array bounds?
+	if(playerId >= m_uiMaxPlayerSockets)
+		return NULL;
 
-	return NULL;
+	return m_pPlayerSockets[playerId];
 }
 
 bool CNetServer::IsPlayerConnected(EntityId playerId)
@@ -362,3 +806,27 @@ int CNetServer::GetPlayerAveragePing(EntityId playerId)
 {
 	return m_pRakPeer->GetAveragePing(m_pRakPeer->GetSystemAddressFromIndex(playerId));
 }
+
+CNetStats * CNetServer::GetPlayerNetStats(EntityId playerId)
+{
+	RakNet::RakNetStatistics * pRakStats = m_pRakPeer->GetStatistics(m_pRakPeer->GetSystemAddressFromIndex(playerId));
+
+	if(!pRakStats)
+		return NULL;
+
+	static CNetStats netStats;
+	memcpy(netStats.ulValueOverLastSecond, pRakStats->valueOverLastSecond, (sizeof(NetStat_t) * NET_STAT_METRICS_COUNT));
+	memcpy(netStats.ulRunningTotal, pRakStats->runningTotal, (sizeof(NetStat_t) * NET_STAT_METRICS_COUNT));
+	netStats.ulConnectionStartTime = pRakStats->connectionStartTime;
+	netStats.bIsLimitedByCongestionControl = pRakStats->isLimitedByCongestionControl;
+	netStats.ulBPSLimitByCongestionControl = pRakStats->BPSLimitByCongestionControl;
+	netStats.bIsLimitedByOutgoingBandwidthLimit = pRakStats->isLimitedByOutgoingBandwidthLimit;
+	netStats.ulBPSLimitByOutgoingBandwidthLimit = pRakStats->BPSLimitByOutgoingBandwidthLimit;
+	memcpy(netStats.uiMessageInSendBuffer, pRakStats->messageInSendBuffer, (sizeof(unsigned int) * PRIORITY_COUNT));
+	memcpy(netStats.dBytesInSendBuffer, pRakStats->bytesInSendBuffer, (sizeof(double) * PRIORITY_COUNT));
+	netStats.uiMessagesInResendBuffer = pRakStats->messagesInResendBuffer;
+	netStats.ulBytesInResendBuffer = pRakStats->bytesInResendBuffer;
+	netStats.fPacketlossLastSecond = pRakStats->packetlossLastSecond;
+	netStats.fPacketlossTotal = pRakStats->packetlossTotal;
+	return &netStats;
+}
@@ -10,7 +10,38 @@
 #pragma once
 
 #include <StdInc.h>
-#include <list>
+#include <map>
+#include <deque>
+
+// Amount of connections an address can make at once, after that it gets another
+// one every NET_CONNECTION_INTERVAL ms
+#define NET_CONNECTION_BURST 3
+#define NET_CONNECTION_INTERVAL 2000
+
+// Amount of handshakes that can wait to be accepted, the connections after that are rejected
+#define NET_MAX_PENDING_HANDSHAKES 64
+
+// Amount of handshakes accepted every NET_HANDSHAKE_INTERVAL ms
+#define NET_HANDSHAKE_BUDGET 8
+#define NET_HANDSHAKE_INTERVAL 100
+
+// Time in ms a handshake cookie is valid for (the cookies of the interval before are accepted too)
+#define NET_COOKIE_INTERVAL 10000
+
+// Level rpcs are compressed with, join bursts are sent right away so speed matters most
+#define NET_COMPRESSION_LEVEL 1
+
+struct NetConnectionRate
+{
+	unsigned int  uiConnections;
+	unsigned long ulTime; // Time the last connection was given back
+};
+
+struct NetPendingHandshake
+{
+	EntityId              playerId;
+	RakNet::SystemAddress systemAddress;
+};
 
 class CNetServer : CRakNetInterface, public CNetServerInterface
 {
@@ -18,12 +49,43 @@ private:
 	RakNet::RakPeerInterface * m_pRakPeer;
 	String                     m_strPassword;
 	PacketHandler_t            m_pfnPacketHandler;
-	std::list<CPlayerSocket *> m_playerSocketList;
+	ConnectionFilter_t         m_pfnConnectionFilter;
+	CPlayerSocket           ** m_pPlayerSockets;     // Player sockets as seen by the packet handler
+	CPlayerSocket           ** m_pNetworkSockets;    // Player sockets as seen by Receive (the network thread if enabled)
+	bool                     * m_pNetworkSocketsQueued;
+	bool                     * m_pHandshakePending;
+	unsigned int               m_uiMaxPlayerSockets;
+	CPacketPool                m_packetPool;
+	bool                       m_bNetworkThreadEnabled;
+	volatile bool              m_bNetworkThreadRunning;
+	volatile bool              m_bNetworkThreadActive;
+	CPacketQueue               m_receiveQueue;
+	CPacketQueue               m_freeQueue;
+	RakNet::SignaledEvent      m_receiveEvent;
+
+	// Only used by Receive (the network thread if enabled)
+	std::map<unsigned long, NetConnectionRate> m_connectionRates;
+	unsigned long              m_ulLastConnectionRatePrune;
+	std::deque<NetPendingHandshake> m_pendingHandshakes;
+	unsigned int               m_uiHandshakeBudget;
+	unsigned long              m_ulHandshakeBudgetTime;
+	unsigned int               m_uiCookieSecret;
+	unsigned int               m_uiCompressionThreshold;
+	CNetSimulator              m_netSimulator;
 
 	PacketId        ProcessPacket(RakNet::SystemAddress systemAddress, PacketId packetId, unsigned char * ucData, int iLength);
 	CPacket *       Receive();
+	void            HandlePacket(CPacket * pPacket);
 	void            DeallocatePacket(CPacket * pPacket);
 	void            RejectKick(EntityId playerId);
+	bool            CheckConnectionRate(unsigned long ulBinaryAddress);
+	unsigned int    GetCookie(const RakNet::SystemAddress& systemAddress, unsigned long ulInterval);
+	void            AcceptHandshake(EntityId playerId, const RakNet::SystemAddress& systemAddress);
+	void            ProcessPendingHandshakes();
+	void            DeletePlayerSockets();
+	void            StopNetworkThread();
+	bool            SendCompressed(const unsigned char * pData, unsigned int uiLength, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel, const RakNet::SystemAddress& systemAddress, bool bBroadcast, unsigned int * puiResult);
+	static RAK_THREAD_DECLARATION(NetworkThread);
 
 public:
 	CNetServer();
@@ -32,14 +94,20 @@ public:
 	bool            Startup(unsigned short usPort, int iMaxPlayers, String strHostAddress = "");
 	void            Shutdown(int iBlockDuration);
 	void            Process();
+	void            SetNetworkThreadEnabled(bool bEnabled) { m_bNetworkThreadEnabled = bEnabled; }
+	bool            WaitForPackets(unsigned int uiTimeOutMilliseconds);
 	void            SetPassword(String strPassword);
 	const char    * GetPassword();
+	void            SetCompressionThreshold(unsigned int uiBytes) { m_uiCompressionThreshold = uiBytes; }
 	unsigned int    Send(CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
 	unsigned int    RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+	unsigned int    RPCReserved(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+	unsigned int    RPCReservedBatch(RPCIdentifier rpcId, CBitStream ** ppBitStreams, const EntityId * pPlayerIds, unsigned int uiCount, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
 	const char    * GetPlayerIp(EntityId playerId);
 	unsigned short  GetPlayerPort(EntityId playerId);
 	void            SetPacketHandler(PacketHandler_t pfnPacketHandler) { m_pfnPacketHandler = pfnPacketHandler; }
 	PacketHandler_t GetPacketHandler() { return m_pfnPacketHandler; }
+	void            SetConnectionFilter(ConnectionFilter_t pfnConnectionFilter) { m_pfnConnectionFilter = pfnConnectionFilter; }
 	const char    * GetPlayerSerial(EntityId playerId);
 	void            KickPlayer(EntityId playerId, bool bSendDisconnectionNotification = true, ePacketPriority disconnectionPacketPriority = PRIORITY_LOW);
 	CPlayerSocket * GetPlayerSocket(EntityId playerId);
@@ -48,4 +116,7 @@ public:
 	void            UnbanIp(String strIpAddress);
 	int             GetPlayerLastPing(EntityId playerId);
 	int             GetPlayerAveragePing(EntityId playerId);
+	CNetStats     * GetPlayerNetStats(EntityId playerId);
+	void            SetNetSimulator(const NetSimulatorSettings& settings) { m_netSimulator.SetSettings(settings); }
+	void            GetNetSimulatorStats(NetSimulatorStats * pStats) { m_netSimulator.GetStats(pStats); }
 };
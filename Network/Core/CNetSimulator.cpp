@@ -0,0 +1,207 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CNetSimulator.cpp
+// Project: Network.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <StdInc.h>
+
+CNetSimulator::CNetSimulator()
+{
+	m_bActive = false;
+	m_lastSendTime = 0;
+	m_linkFreeTime = 0;
+	m_bThreadRunning = false;
+	m_bThreadActive = false;
+}
+
+CNetSimulator::~CNetSimulator()
+{
+	SetSettings(NetSimulatorSettings());
+}
+
+void CNetSimulator::SetSettings(const NetSimulatorSettings& settings)
+{
+	bool bActive = settings.IsActive();
+
+	m_mutex.Lock();
+	m_settings = settings;
+	bool bWasActive = m_bActive;
+	m_bActive = bActive;
+	m_mutex.Unlock();
+
+	if(bActive && !bWasActive)
+	{
+		// Start the thread that sends the datagrams once they are due
+		if(!m_bThreadRunning)
+		{
+			m_bThreadRunning = true;
+
+			if(RakNet::RakThread::Create(SimulatorThread, this) != 0)
+			{
+				m_bThreadRunning = false;
+				m_mutex.Lock();
+				m_bActive = false;
+				m_mutex.Unlock();
+				return;
+			}
+		}
+
+		RakNet::SocketLayer::SetSocketLayerOverride(this);
+	}
+	else if(!bActive && bWasActive)
+	{
+		// Sends that already got the override send directly now, the datagrams
+		// still waiting are sent right away
+		if(RakNet::SocketLayer::GetSocketLayerOverride() == this)
+			RakNet::SocketLayer::SetSocketLayerOverride(NULL);
+
+		StopThread();
+		SendQueued(true);
+	}
+}
+
+void CNetSimulator::GetStats(NetSimulatorStats * pStats)
+{
+	m_mutex.Lock();
+	*pStats = m_stats;
+	pStats->uiQueued = (unsigned int)m_queue.size();
+	m_mutex.Unlock();
+}
+
+void CNetSimulator::Enqueue(RakNet::TimeUS sendTime, SOCKET s, const char * szData, int iLength, const RakNet::SystemAddress& systemAddress)
+{
+	NetSimulatorDatagram datagram;
+	datagram.s = s;
+	datagram.systemAddress = systemAddress;
+	datagram.pData = new char[iLength];
+	memcpy(datagram.pData, szData, iLength);
+	datagram.iLength = iLength;
+	m_queue.insert(std::pair<RakNet::TimeUS, NetSimulatorDatagram>(sendTime, datagram));
+}
+
+int CNetSimulator::RakNetSendTo(SOCKET s, const char * data, int length, const RakNet::SystemAddress &systemAddress)
+{
+	m_mutex.Lock();
+
+	if(!m_bActive)
+	{
+		m_mutex.Unlock();
+		return RakNet::SocketLayer::SendTo_PC(s, data, length, systemAddress, __FILE__, __LINE__);
+	}
+
+	m_stats.ulDatagrams++;
+	m_stats.ulBytes += length;
+
+	if(m_settings.fLoss > 0.0f && (frandomMT() * 100.0f) < m_settings.fLoss)
+	{
+		m_stats.ulLost++;
+		m_mutex.Unlock();
+		return length;
+	}
+
+	RakNet::TimeUS time = RakNet::GetTimeUS();
+	RakNet::TimeUS sendTime = time;
+
+	// The datagram leaves once the link is done with the ones before it
+	if(m_settings.uiBandwidth > 0)
+	{
+		RakNet::TimeUS linkTime = ((m_linkFreeTime > time) ? m_linkFreeTime : time);
+
+		if((linkTime - time) > ((RakNet::TimeUS)NET_SIMULATOR_MAX_BUFFER_TIME * 1000))
+		{
+			m_stats.ulOverflowed++;
+			m_mutex.Unlock();
+			return length;
+		}
+
+		m_linkFreeTime = (linkTime + (((RakNet::TimeUS)length * 1000000) / m_settings.uiBandwidth));
+		sendTime = m_linkFreeTime;
+	}
+
+	sendTime += ((RakNet::TimeUS)m_settings.uiLatency * 1000);
+
+	if(m_settings.uiJitter > 0)
+		sendTime += (RakNet::TimeUS)(frandomMT() * m_settings.uiJitter * 1000.0f);
+
+	if(m_settings.fReorder > 0.0f && (frandomMT() * 100.0f) < m_settings.fReorder)
+	{
+		// Held back without holding back the datagrams after it
+		m_stats.ulReordered++;
+		sendTime += ((RakNet::TimeUS)NET_SIMULATOR_REORDER_DELAY * 1000);
+	}
+	else
+	{
+		// Jitter alone doesn't reorder
+		if(sendTime < m_lastSendTime)
+			sendTime = m_lastSendTime;
+
+		m_lastSendTime = sendTime;
+	}
+
+	Enqueue(sendTime, s, data, length, systemAddress);
+
+	if(m_settings.fDuplicate > 0.0f && (frandomMT() * 100.0f) < m_settings.fDuplicate)
+	{
+		m_stats.ulDuplicated++;
+		Enqueue((sendTime + (RakNet::TimeUS)(frandomMT() * (m_settings.uiJitter + 1) * 1000.0f)), s, data, length, systemAddress);
+	}
+
+	m_mutex.Unlock();
+	return length;
+}
+
+void CNetSimulator::SendQueued(bool bAll)
+{
+	RakNet::TimeUS time = RakNet::GetTimeUS();
+
+	while(true)
+	{
+		// Send outside of the lock so RakNet is never kept waiting on the socket
+		m_mutex.Lock();
+		std::multimap<RakNet::TimeUS, NetSimulatorDatagram>::iterator iter = m_queue.begin();
+
+		if(iter == m_queue.end() || (!bAll && (*iter).first > time))
+		{
+			m_mutex.Unlock();
+			break;
+		}
+
+		NetSimulatorDatagram datagram = (*iter).second;
+		m_queue.erase(iter);
+		m_mutex.Unlock();
+
+		RakNet::SocketLayer::SendTo_PC(datagram.s, datagram.pData, datagram.iLength, datagram.systemAddress, __FILE__, __LINE__);
+		delete [] datagram.pData;
+	}
+}
+
+void CNetSimulator::StopThread()
+{
+	if(!m_bThreadRunning)
+		return;
+
+	// Tell the simulator thread to stop and wait for it to exit
+	m_bThreadRunning = false;
+
+	while(m_bThreadActive)
+		RakSleep(1);
+}
+
+RAK_THREAD_DECLARATION(CNetSimulator::SimulatorThread)
+{
+	CNetSimulator * pSimulator = (CNetSimulator *)arguments;
+	pSimulator->m_bThreadActive = true;
+
+	while(pSimulator->m_bThreadRunning)
+	{
+		pSimulator->SendQueued(false);
+		RakSleep(1);
+	}
+
+	pSimulator->m_bThreadActive = false;
+	return 0;
+}
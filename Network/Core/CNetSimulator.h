@@ -0,0 +1,58 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CNetSimulator.h
+// Project: Network.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+
+// Time in ms of data the bandwidth limited link buffers, datagrams after that are dropped
+#define NET_SIMULATOR_MAX_BUFFER_TIME 1000
+
+// Time in ms a reordered datagram is held back after its normal delay
+#define NET_SIMULATOR_REORDER_DELAY 20
+
+struct NetSimulatorDatagram
+{
+	SOCKET                s;
+	RakNet::SystemAddress systemAddress;
+	char                * pData;
+	int                   iLength;
+};
+
+// Sits between RakNet and its sockets and applies the simulated conditions to every
+// datagram sent, so the reliability layer sees the loss and delay like on a real link.
+// RakNet only has one socket layer override, so one simulator is installed at a time.
+class CNetSimulator : public RakNet::SocketLayerOverride
+{
+private:
+	RakNet::SimpleMutex                                  m_mutex; // Mutex for the members up to m_linkFreeTime
+	bool                                                 m_bActive;
+	NetSimulatorSettings                                 m_settings;
+	NetSimulatorStats                                    m_stats;
+	std::multimap<RakNet::TimeUS, NetSimulatorDatagram>  m_queue; // By the time they are sent
+	RakNet::TimeUS                                       m_lastSendTime; // Of the last datagram that keeps its order
+	RakNet::TimeUS                                       m_linkFreeTime; // When the link is done with the datagrams before
+	volatile bool                                        m_bThreadRunning;
+	volatile bool                                        m_bThreadActive;
+
+	void       Enqueue(RakNet::TimeUS sendTime, SOCKET s, const char * szData, int iLength, const RakNet::SystemAddress& systemAddress);
+	void       SendQueued(bool bAll);
+	void       StopThread();
+	static RAK_THREAD_DECLARATION(SimulatorThread);
+
+public:
+	CNetSimulator();
+	~CNetSimulator();
+
+	void       SetSettings(const NetSimulatorSettings& settings);
+	void       GetStats(NetSimulatorStats * pStats);
+
+	int        RakNetSendTo(SOCKET s, const char * data, int length, const RakNet::SystemAddress &systemAddress);
+	int        RakNetRecvFrom(const SOCKET sIn, RakNet::RakPeer * rakPeerIn, char dataOut[MAXIMUM_MTU_SIZE], RakNet::SystemAddress * senderOut, bool calledFromMainThread) { return 0; }
+};
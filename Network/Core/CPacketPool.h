@@ -0,0 +1,41 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPacketPool.h
+// Project: Network.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+
+// Free list of packets so receiving doesn't need a heap allocation per packet
+class CPacketPool
+{
+private:
+	std::vector<CPacket *> m_freePackets;
+
+public:
+	~CPacketPool()
+	{
+		for(std::vector<CPacket *>::iterator iter = m_freePackets.begin(); iter != m_freePackets.end(); iter++)
+			delete (*iter);
+	}
+
+	CPacket * Allocate()
+	{
+		if(m_freePackets.empty())
+			return new CPacket;
+
+		CPacket * pPacket = m_freePackets.back();
+		m_freePackets.pop_back();
+		return pPacket;
+	}
+
+	void Free(CPacket * pPacket)
+	{
+		m_freePackets.push_back(pPacket);
+	}
+};
@@ -0,0 +1,76 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPacketQueue.h
+// Project: Network.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+// Amount of packets that can be queued between the network thread and the
+// game thread (must be a power of 2)
+#define PACKET_QUEUE_SIZE 8192
+
+#ifdef WIN32
+#define PACKET_QUEUE_BARRIER() MemoryBarrier()
+#else
+#define PACKET_QUEUE_BARRIER() __sync_synchronize()
+#endif
+
+// Lock free queue of packets with exactly one thread pushing and one thread
+// popping, the read and write positions are only ever written by one side
+class CPacketQueue
+{
+private:
+	CPacket               * m_pPackets[PACKET_QUEUE_SIZE];
+	volatile unsigned int   m_uiReadPosition;
+	volatile unsigned int   m_uiWritePosition;
+
+public:
+	CPacketQueue()
+	{
+		m_uiReadPosition = 0;
+		m_uiWritePosition = 0;
+	}
+
+	bool Push(CPacket * pPacket)
+	{
+		unsigned int uiWritePosition = m_uiWritePosition;
+
+		// Is the queue full?
+		if((uiWritePosition - m_uiReadPosition) >= PACKET_QUEUE_SIZE)
+			return false;
+
+		m_pPackets[uiWritePosition & (PACKET_QUEUE_SIZE - 1)] = pPacket;
+
+		// Make sure the packet is visible before the new write position is
+		PACKET_QUEUE_BARRIER();
+		m_uiWritePosition = (uiWritePosition + 1);
+		return true;
+	}
+
+	bool IsEmpty()
+	{
+		return (m_uiReadPosition == m_uiWritePosition);
+	}
+
+	CPacket * Pop()
+	{
+		unsigned int uiReadPosition = m_uiReadPosition;
+
+		// Is the queue empty?
+		if(uiReadPosition == m_uiWritePosition)
+			return NULL;
+
+		// Make sure we read the packet after we have seen the write position
+		PACKET_QUEUE_BARRIER();
+		CPacket * pPacket = m_pPackets[uiReadPosition & (PACKET_QUEUE_SIZE - 1)];
+
+		// Make sure the packet is read before the slot can be reused
+		PACKET_QUEUE_BARRIER();
+		m_uiReadPosition = (uiReadPosition + 1);
+		return pPacket;
+	}
+};
@@ -8,6 +8,82 @@
 //==============================================================================
 
 #include <StdInc.h>
+#include <malloc.h>
+#include <CMemoryTracker.h>
+#include "RakNet/RakMemoryOverride.h"
+
+// RakNet allocates its buffers through these, the sizes are taken from the
+// heap so memory that was allocated before the hooks were set can be freed
+#ifdef _LINUX
+#define GetAllocationSize(pMemory) malloc_usable_size(pMemory)
+#else
+#define GetAllocationSize(pMemory) _msize(pMemory)
+#endif
+
+static void * CountedMalloc(size_t sSize)
+{
+	void * pMemory = malloc(sSize);
+
+	if(pMemory)
+		CMemoryTracker::Allocated(MEMORY_TAG_NETWORK, GetAllocationSize(pMemory));
+
+	return pMemory;
+}
+
+static void * CountedRealloc(void * pMemory, size_t sSize)
+{
+	size_t sOldSize = (pMemory ? GetAllocationSize(pMemory) : 0);
+	void * pNewMemory = realloc(pMemory, sSize);
+
+	// A failed realloc keeps the old memory, realloc to 0 frees it
+	if(pNewMemory)
+	{
+		CMemoryTracker::Freed(MEMORY_TAG_NETWORK, sOldSize);
+		CMemoryTracker::Allocated(MEMORY_TAG_NETWORK, GetAllocationSize(pNewMemory));
+	}
+	else if(sSize == 0)
+		CMemoryTracker::Freed(MEMORY_TAG_NETWORK, sOldSize);
+
+	return pNewMemory;
+}
+
+static void CountedFree(void * pMemory)
+{
+	if(!pMemory)
+		return;
+
+	CMemoryTracker::Freed(MEMORY_TAG_NETWORK, GetAllocationSize(pMemory));
+	free(pMemory);
+}
+
+static void * CountedMalloc_Ex(size_t sSize, const char *, unsigned int)
+{
+	return CountedMalloc(sSize);
+}
+
+static void * CountedRealloc_Ex(void * pMemory, size_t sSize, const char *, unsigned int)
+{
+	return CountedRealloc(pMemory, sSize);
+}
+
+static void CountedFree_Ex(void * pMemory, const char *, unsigned int)
+{
+	CountedFree(pMemory);
+}
+
+// Sets the hooks when the module is loaded
+static struct MemoryHooks
+{
+	MemoryHooks()
+	{
+		SetMalloc(CountedMalloc);
+		SetRealloc(CountedRealloc);
+		SetFree(CountedFree);
+		SetMalloc_Ex(CountedMalloc_Ex);
+		SetRealloc_Ex(CountedRealloc_Ex);
+		SetFree_Ex(CountedFree_Ex);
+	}
+} g_memoryHooks;
 
 EXPORT bool VerifyVersion(unsigned char ucVersion)
 {
@@ -39,6 +115,11 @@ EXPORT void DestroyNetClientInterface(CNetClientInterface * pNetClient)
 	delete pNetClient;
 }
 
+EXPORT MemoryCounter * GetMemoryCounter()
+{
+	return CMemoryTracker::GetCounter(MEMORY_TAG_NETWORK);
+}
+
 #ifndef _LINUX
 BOOL WINAPI DllMain(HMODULE hModule, DWORD dwReason, void *)
 {
@@ -12,6 +12,16 @@
 #include "RakNet/RakPeer.h"
 #include "RakNet/BitStream.h"
 #include "RakNet/MessageIdentifiers.h"
+#include "RakNet/RakThread.h"
+#include "RakNet/RakSleep.h"
+#include "RakNet/SignaledEvent.h"
+#include "RakNet/SocketLayer.h"
+#include "RakNet/SimpleMutex.h"
+#include "RakNet/GetTime.h"
+#include "RakNet/Rand.h"
+
+// zlib
+#include <zlib-1.2.5/zlib.h>
 
 // Shared
 #include <Common.h>
@@ -26,10 +36,14 @@
 #include <PacketChannels.h>
 #include <RPCIdentifiers.h>
 #include <CNetStats.h>
+#include <NetSimulator.h>
 #include <CNetServerInterface.h>
 #include <CNetClientInterface.h>
 
 // Project
 #include "CRakNetInterface.h"
+#include "CPacketPool.h"
+#include "CPacketQueue.h"
+#include "CNetSimulator.h"
 #include "CNetServer.h"
 #include "CNetClient.h"
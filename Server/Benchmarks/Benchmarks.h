@@ -0,0 +1,25 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: Benchmarks.h
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "CBenchmarkRunner.h"
+
+void RegisterBitStreamBenchmarks(CBenchmarkRunner * pRunner);
+void RegisterStringBenchmarks(CBenchmarkRunner * pRunner);
+void RegisterSyncBenchmarks(CBenchmarkRunner * pRunner);
+
+// The scripting benchmarks need a script VM, they are only registered if it loads
+bool RegisterScriptingBenchmarks(CBenchmarkRunner * pRunner);
+void ShutdownScriptingBenchmarks();
+
+// The workloads run a small gamemode with the natives of the server, they are
+// only registered if it loads
+bool RegisterWorkloadBenchmarks(CBenchmarkRunner * pRunner);
+void ShutdownWorkloadBenchmarks();
@@ -0,0 +1,139 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: BitStreamBenchmarks.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "Benchmarks.h"
+#include <Common.h>
+#include <Network/CBitStream.h>
+
+// A stream with the values the write benchmarks write (the read benchmarks read it)
+static void WriteValues(CBitStream * pBitStream, unsigned int i)
+{
+	pBitStream->Write((int)i);
+	pBitStream->Write((unsigned short)i);
+	pBitStream->Write((float)i * 0.5f);
+	pBitStream->Write(CVector3(1.0f, 2.0f, (float)i));
+	pBitStream->WriteBit((i & 1) != 0);
+	pBitStream->Write((unsigned char)i);
+}
+
+static void WriteCompressedValues(CBitStream * pBitStream, unsigned int i)
+{
+	// Entity ids and pings are small so they compress well, like most rpc fields
+	pBitStream->WriteCompressed((EntityId)(i % MAX_PLAYERS));
+	pBitStream->WriteCompressed((unsigned short)(i % 200));
+	pBitStream->WriteCompressed((i & 1) != 0);
+	pBitStream->WriteCompressed((int)i);
+	pBitStream->WriteCompressed((float)i * 0.5f);
+}
+
+static void BitStreamWrite(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetWritePointer();
+		WriteValues(&bitStream, i);
+	}
+
+	g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+}
+
+static void BitStreamRead(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	WriteValues(&bitStream, 12345);
+	int iValue;
+	unsigned short usValue;
+	float fValue;
+	CVector3 vecValue;
+	unsigned char ucValue;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetReadPointer();
+		bitStream.Read(iValue);
+		bitStream.Read(usValue);
+		bitStream.Read(fValue);
+		bitStream.Read(vecValue);
+		bool bValue = bitStream.ReadBit();
+		bitStream.Read(ucValue);
+		g_uiBenchmarkSink += (iValue + usValue + ucValue + (bValue ? 1 : 0));
+	}
+}
+
+static void BitStreamWriteCompressed(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetWritePointer();
+		WriteCompressedValues(&bitStream, i);
+	}
+
+	g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+}
+
+static void BitStreamReadCompressed(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	WriteCompressedValues(&bitStream, 12345);
+	EntityId entityId;
+	unsigned short usValue;
+	bool bValue;
+	int iValue;
+	float fValue;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetReadPointer();
+		bitStream.ReadCompressed(entityId);
+		bitStream.ReadCompressed(usValue);
+		bitStream.ReadCompressed(bValue);
+		bitStream.ReadCompressed(iValue);
+		bitStream.ReadCompressed(fValue);
+		g_uiBenchmarkSink += (entityId + usValue + iValue + (bValue ? 1 : 0));
+	}
+}
+
+static void BitStreamWriteString(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	String strMessage("This is a chat message of an average length");
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetWritePointer();
+		bitStream.Write(strMessage);
+	}
+
+	g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+}
+
+static void BitStreamConstruct(unsigned int uiIterations)
+{
+	// Every rpc handler and sender creates a stream of its own
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		CBitStream bitStream;
+		bitStream.WriteCompressed((EntityId)i);
+		g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+	}
+}
+
+void RegisterBitStreamBenchmarks(CBenchmarkRunner * pRunner)
+{
+	pRunner->Add("bitstream.write", BitStreamWrite);
+	pRunner->Add("bitstream.read", BitStreamRead);
+	pRunner->Add("bitstream.write_compressed", BitStreamWriteCompressed);
+	pRunner->Add("bitstream.read_compressed", BitStreamReadCompressed);
+	pRunner->Add("bitstream.write_string", BitStreamWriteString);
+	pRunner->Add("bitstream.construct", BitStreamConstruct);
+}
@@ -0,0 +1,128 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBenchmarkRunner.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <string.h>
+#include "CBenchmarkRunner.h"
+#include <algorithm>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+volatile unsigned int g_uiBenchmarkSink = 0;
+
+CBenchmarkRunner::CBenchmarkRunner(unsigned int uiMinTime, unsigned int uiRepetitions)
+{
+	m_uiMinTime = std::max(uiMinTime, (unsigned int)1);
+	m_uiRepetitions = std::max(uiRepetitions, (unsigned int)1);
+}
+
+void CBenchmarkRunner::Add(String strName, BenchmarkFunction_t pfnFunction)
+{
+	Benchmark benchmark;
+	benchmark.strName = strName;
+	benchmark.pfnFunction = pfnFunction;
+	m_benchmarks.push_back(benchmark);
+}
+
+unsigned long long CBenchmarkRunner::Time(BenchmarkFunction_t pfnFunction, unsigned int uiIterations)
+{
+	unsigned long long ullStartTime = SharedUtility::GetMicroseconds();
+	pfnFunction(uiIterations);
+	return (SharedUtility::GetMicroseconds() - ullStartTime);
+}
+
+void CBenchmarkRunner::Run(const Benchmark& benchmark, BenchmarkResult * pResult)
+{
+	unsigned long long ullMinTime = ((unsigned long long)m_uiMinTime * 1000);
+	unsigned int uiIterations = 1;
+
+	// Grow the iterations until a run takes the minimum time, this also
+	// warms up the caches and allocations of the benchmarked code
+	while(uiIterations < BENCHMARK_MAX_ITERATIONS)
+	{
+		unsigned long long ullTime = Time(benchmark.pfnFunction, uiIterations);
+
+		if(ullTime >= ullMinTime)
+			break;
+
+		// Aim a bit over the minimum time but grow at most 10 times per step
+		unsigned long long ullIterations = (ullTime > 0 ? ((ullMinTime * uiIterations * 6) / (ullTime * 5)) : ((unsigned long long)uiIterations * 10));
+		ullIterations = std::max(ullIterations, (unsigned long long)uiIterations * 2);
+		ullIterations = std::min(ullIterations, (unsigned long long)uiIterations * 10);
+		uiIterations = (unsigned int)std::min(ullIterations, (unsigned long long)BENCHMARK_MAX_ITERATIONS);
+	}
+
+	std::vector<double> nsPerOp;
+
+	for(unsigned int i = 0; i < m_uiRepetitions; i++)
+		nsPerOp.push_back(((double)Time(benchmark.pfnFunction, uiIterations) * 1000.0) / uiIterations);
+
+	std::sort(nsPerOp.begin(), nsPerOp.end());
+	pResult->strName = benchmark.strName;
+	pResult->uiIterations = uiIterations;
+	pResult->uiRepetitions = m_uiRepetitions;
+	pResult->dNsPerOp = nsPerOp[nsPerOp.size() / 2];
+	pResult->dMinNsPerOp = nsPerOp.front();
+	pResult->dMaxNsPerOp = nsPerOp.back();
+}
+
+void CBenchmarkRunner::Run(String strFilter, std::vector<BenchmarkResult> * pResults)
+{
+	for(std::vector<Benchmark>::iterator iter = m_benchmarks.begin(); iter != m_benchmarks.end(); ++ iter)
+	{
+		if(strFilter.IsNotEmpty() && !strstr((*iter).strName.Get(), strFilter.Get()))
+			continue;
+
+		BenchmarkResult result;
+		Run(*iter, &result);
+		pResults->push_back(result);
+		CLogFile::Printf("%-36s %12.1f ns/op (min %.1f, max %.1f, %d iterations)", result.strName.Get(), result.dNsPerOp, result.dMinNsPerOp, result.dMaxNsPerOp, result.uiIterations);
+	}
+}
+
+bool CBenchmarkRunner::WriteJSON(String strPath, const std::vector<BenchmarkResult>& results)
+{
+	FILE * pFile = fopen(strPath.Get(), "w");
+
+	if(!pFile)
+		return false;
+
+	// The names are plain ascii identifiers so they don't need escaping
+	fprintf(pFile, "{\n  \"benchmarks\": [\n");
+
+	for(unsigned int i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		fprintf(pFile, "    {\"name\": \"%s\", \"iterations\": %d, \"repetitions\": %d, \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"max_ns_per_op\": %.3f, \"ops_per_sec\": %.0f}%s\n",
+			result.strName.Get(), result.uiIterations, result.uiRepetitions, result.dNsPerOp, result.dMinNsPerOp, result.dMaxNsPerOp,
+			(result.dNsPerOp > 0.0 ? (1000000000.0 / result.dNsPerOp) : 0.0), ((i + 1) < results.size() ? "," : ""));
+	}
+
+	fprintf(pFile, "  ]\n}\n");
+	fclose(pFile);
+	return true;
+}
+
+bool CBenchmarkRunner::WriteCSV(String strPath, const std::vector<BenchmarkResult>& results)
+{
+	FILE * pFile = fopen(strPath.Get(), "w");
+
+	if(!pFile)
+		return false;
+
+	fprintf(pFile, "name,iterations,repetitions,ns_per_op,min_ns_per_op,max_ns_per_op,ops_per_sec\n");
+
+	for(std::vector<BenchmarkResult>::const_iterator iter = results.begin(); iter != results.end(); ++ iter)
+	{
+		fprintf(pFile, "%s,%d,%d,%.3f,%.3f,%.3f,%.0f\n", (*iter).strName.Get(), (*iter).uiIterations, (*iter).uiRepetitions, (*iter).dNsPerOp,
+			(*iter).dMinNsPerOp, (*iter).dMaxNsPerOp, ((*iter).dNsPerOp > 0.0 ? (1000000000.0 / (*iter).dNsPerOp) : 0.0));
+	}
+
+	fclose(pFile);
+	return true;
+}
@@ -0,0 +1,61 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBenchmarkRunner.h
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <CString.h>
+
+// Maximum amount of iterations a single benchmark run is allowed to grow to
+#define BENCHMARK_MAX_ITERATIONS 100000000
+
+// Runs uiIterations iterations of the benchmarked code
+typedef void (* BenchmarkFunction_t)(unsigned int uiIterations);
+
+// Benchmarks write their results here so the compiler can't optimize them away
+extern volatile unsigned int g_uiBenchmarkSink;
+
+struct Benchmark
+{
+	String              strName;
+	BenchmarkFunction_t pfnFunction;
+};
+
+struct BenchmarkResult
+{
+	String       strName;
+	unsigned int uiIterations;  // Iterations of each repetition
+	unsigned int uiRepetitions;
+	double       dNsPerOp;      // Median of all repetitions
+	double       dMinNsPerOp;
+	double       dMaxNsPerOp;
+};
+
+class CBenchmarkRunner
+{
+private:
+	std::vector<Benchmark> m_benchmarks;
+	unsigned int           m_uiMinTime;     // Minimum time in ms of a single repetition
+	unsigned int           m_uiRepetitions;
+
+	unsigned long long     Time(BenchmarkFunction_t pfnFunction, unsigned int uiIterations);
+	void                   Run(const Benchmark& benchmark, BenchmarkResult * pResult);
+
+public:
+	CBenchmarkRunner(unsigned int uiMinTime, unsigned int uiRepetitions);
+
+	void                   Add(String strName, BenchmarkFunction_t pfnFunction);
+
+	// Runs every benchmark whose name contains strFilter (all of them if it is empty)
+	void                   Run(String strFilter, std::vector<BenchmarkResult> * pResults);
+
+	static bool            WriteJSON(String strPath, const std::vector<BenchmarkResult>& results);
+	static bool            WriteCSV(String strPath, const std::vector<BenchmarkResult>& results);
+};
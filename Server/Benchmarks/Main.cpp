@@ -0,0 +1,111 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: Main.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Benchmarks.h"
+#include <Common.h>
+#include <CEvents.h>
+#include <CLogFile.h>
+
+CScriptingManager * g_pScriptingManager = NULL;
+CEvents * g_pEvents = NULL;
+
+void PrintUsage()
+{
+	CLogFile::Print("Usage: ivmp-bench [options]");
+	CLogFile::Print("  -filter <text>         Only run the benchmarks whose name contains the text");
+	CLogFile::Print("  -mintime <ms>          Minimum time of a single repetition (default 100)");
+	CLogFile::Print("  -repetitions <count>   Repetitions of each benchmark, the median is reported (default 5)");
+	CLogFile::Print("  -output <file>         File the results are written to (default ivmp-bench.json)");
+	CLogFile::Print("  -format <json|csv>     Format of the results file (default json)");
+}
+
+int main(int argc, char ** argv)
+{
+	String strFilter;
+	unsigned int uiMinTime = 100;
+	unsigned int uiRepetitions = 5;
+	String strOutput = "ivmp-bench.json";
+	String strFormat = "json";
+
+	// Parse the command line
+	for(int i = 1; i < argc; i++)
+	{
+		String strOption = argv[i];
+
+		if(strOption == "-help" || strOption == "-h" || (i + 1) >= argc)
+		{
+			PrintUsage();
+			return 0;
+		}
+
+		String strValue = argv[++i];
+
+		if(strOption == "-filter")
+			strFilter = strValue;
+		else if(strOption == "-mintime")
+			uiMinTime = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-repetitions")
+			uiRepetitions = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-output")
+			strOutput = strValue;
+		else if(strOption == "-format")
+			strFormat = strValue.ToLower();
+		else
+		{
+			CLogFile::Printf("Unknown option %s.", strOption.Get());
+			PrintUsage();
+			return 0;
+		}
+	}
+
+	if(strFormat != "json" && strFormat != "csv")
+	{
+		CLogFile::Printf("Unknown format %s.", strFormat.Get());
+		return 1;
+	}
+
+	g_pScriptingManager = new CScriptingManager();
+	g_pEvents = new CEvents();
+	CBenchmarkRunner runner(uiMinTime, uiRepetitions);
+	RegisterBitStreamBenchmarks(&runner);
+	RegisterStringBenchmarks(&runner);
+	RegisterSyncBenchmarks(&runner);
+
+	if(!RegisterScriptingBenchmarks(&runner))
+		CLogFile::Print("Failed to load the benchmark script, skipping the event benchmarks.");
+
+	if(!RegisterWorkloadBenchmarks(&runner))
+		CLogFile::Print("Failed to load the workload script, skipping the workload benchmarks.");
+
+	std::vector<BenchmarkResult> results;
+	runner.Run(strFilter, &results);
+	ShutdownWorkloadBenchmarks();
+	ShutdownScriptingBenchmarks();
+	SAFE_DELETE(g_pEvents);
+	SAFE_DELETE(g_pScriptingManager);
+
+	if(results.empty())
+	{
+		CLogFile::Print("No benchmarks matched the filter.");
+		return 1;
+	}
+
+	bool bWritten = (strFormat == "csv" ? CBenchmarkRunner::WriteCSV(strOutput, results) : CBenchmarkRunner::WriteJSON(strOutput, results));
+
+	if(!bWritten)
+	{
+		CLogFile::Printf("Failed to write the results to %s.", strOutput.Get());
+		return 1;
+	}
+
+	CLogFile::Printf("Wrote %d result(s) to %s.", results.size(), strOutput.Get());
+	return 0;
+}
@@ -0,0 +1,235 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ScriptingBenchmarks.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include "Benchmarks.h"
+#include <Common.h>
+#include <CEvents.h>
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+
+// File the benchmark script is written to while it is loaded
+#define BENCHMARK_SCRIPT_FILE "ivmp-bench.nut"
+
+extern CScriptingManager * g_pScriptingManager;
+extern CEvents * g_pEvents;
+
+// Event without any handler, calls to it only check if anyone listens
+#define BENCHMARK_UNHANDLED_EVENT "benchmarkUnhandled"
+
+// Event with the script handler, called by name
+#define BENCHMARK_SCRIPT_EVENT "benchmarkScript"
+
+// Event with the native handler, called by name
+#define BENCHMARK_NATIVE_EVENT "benchmarkNative"
+
+static const char * g_szBenchmarkScript =
+	"function onBenchmarkEvent(playerId)\n"
+	"{\n"
+	"	return 1;\n"
+	"}\n";
+
+// Handler that doesn't call into a script so the dispatch itself is measured
+class CBenchmarkEventHandler : public CEventHandler
+{
+public:
+	bool equals(const CEventHandler* other) const
+	{
+		return (other == this);
+	}
+
+	void Call(CSquirrelArguments* pArguments, CSquirrelArgument* pReturn)
+	{
+		g_uiBenchmarkSink += pArguments->size();
+	}
+};
+
+static CSquirrel * g_pBenchmarkScript = NULL;
+static CBenchmarkEventHandler * g_pBenchmarkEventHandler = NULL;
+
+static void ArgumentsPushPop(unsigned int uiIterations)
+{
+	CSquirrelArguments arguments;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		// The arguments of a typical event: player, a few values and a string
+		arguments.push((int)i);
+		arguments.push(1.5f);
+		arguments.push(true);
+		arguments.push("This is a chat message");
+
+		while(!arguments.empty())
+		{
+			g_uiBenchmarkSink += arguments.back()->GetType();
+			arguments.pop_back();
+		}
+	}
+}
+
+static void ArgumentsPushPopFront(unsigned int uiIterations)
+{
+	CSquirrelArguments arguments;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		arguments.push((int)i);
+		arguments.push(1.5f);
+		arguments.push(true);
+		arguments.push("This is a chat message");
+
+		// Natives read their arguments in order
+		while(!arguments.empty())
+			g_uiBenchmarkSink += arguments.pop().GetType();
+	}
+}
+
+static void ArgumentsSpill(unsigned int uiIterations)
+{
+	// More arguments than fit inline
+	CSquirrelArguments arguments;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		for(int j = 0; j < (SQUIRREL_ARGUMENTS_INLINE_SIZE * 2); j++)
+			arguments.push(j);
+
+		g_uiBenchmarkSink += arguments.size();
+		arguments.reset();
+	}
+}
+
+static void ArgumentsSerialize(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	CSquirrelArguments arguments;
+	arguments.push(1);
+	arguments.push(1.5f);
+	arguments.push(true);
+	arguments.push("This is a chat message");
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.Reset();
+		arguments.serialize(&bitStream);
+		CSquirrelArguments received(&bitStream);
+		g_uiBenchmarkSink += received.size();
+	}
+}
+
+static void EventsCallUnhandled(unsigned int uiIterations)
+{
+	CSquirrelArguments arguments;
+	arguments.push(1);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+		g_uiBenchmarkSink += g_pEvents->Call(BENCHMARK_UNHANDLED_EVENT, &arguments).GetInteger();
+}
+
+static void EventsCallUnhandledId(unsigned int uiIterations)
+{
+	// What a sync packet costs when no script listens to its event
+	CSquirrelArguments arguments;
+	arguments.push(1);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+		g_uiBenchmarkSink += g_pEvents->Call(EVENT_PLAYER_SMALL_SYNC_RECEIVED, &arguments).GetInteger();
+}
+
+static void EventsCallNative(unsigned int uiIterations)
+{
+	CSquirrelArguments arguments;
+	arguments.push(1);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+		g_uiBenchmarkSink += g_pEvents->Call(BENCHMARK_NATIVE_EVENT, &arguments).GetInteger();
+}
+
+static void EventsCallScript(unsigned int uiIterations)
+{
+	CSquirrelArguments arguments;
+	arguments.push(1);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+		g_uiBenchmarkSink += g_pEvents->Call(BENCHMARK_SCRIPT_EVENT, &arguments).GetInteger();
+}
+
+static void EventsCallScriptId(unsigned int uiIterations)
+{
+	// The way the OnFootSync rpc handler calls its event
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		CSquirrelArguments arguments;
+		arguments.push((int)i);
+		g_uiBenchmarkSink += g_pEvents->Call(EVENT_PLAYER_ONFOOT_SYNC_RECEIVED, &arguments).GetInteger();
+	}
+}
+
+bool RegisterScriptingBenchmarks(CBenchmarkRunner * pRunner)
+{
+	// Arguments don't need a script
+	pRunner->Add("squirrel_arguments.push_pop", ArgumentsPushPop);
+	pRunner->Add("squirrel_arguments.push_pop_front", ArgumentsPushPopFront);
+	pRunner->Add("squirrel_arguments.spill", ArgumentsSpill);
+	pRunner->Add("squirrel_arguments.serialize", ArgumentsSerialize);
+
+	FILE * pFile = fopen(BENCHMARK_SCRIPT_FILE, "w");
+
+	if(!pFile)
+		return false;
+
+	fputs(g_szBenchmarkScript, pFile);
+	fclose(pFile);
+	g_pBenchmarkScript = g_pScriptingManager->Load("benchmark", BENCHMARK_SCRIPT_FILE);
+	remove(BENCHMARK_SCRIPT_FILE);
+
+	if(!g_pBenchmarkScript)
+		return false;
+
+	// Get the handler function from the root table
+	SQVM * pVM = g_pBenchmarkScript->GetVM();
+	sq_pushroottable(pVM);
+	sq_pushstring(pVM, "onBenchmarkEvent", -1);
+
+	if(SQ_FAILED(sq_get(pVM, -2)))
+	{
+		sq_pop(pVM, 1);
+		return false;
+	}
+
+	SQObjectPtr pFunction = stack_get(pVM, -1);
+	sq_pop(pVM, 2);
+
+	// Add the handlers the same way addEvent does
+	g_pEvents->Add(BENCHMARK_SCRIPT_EVENT, new CSquirrelEventHandler(pVM, pFunction));
+	g_pEvents->Add(EVENT_PLAYER_ONFOOT_SYNC_RECEIVED, new CSquirrelEventHandler(pVM, pFunction));
+	g_pBenchmarkEventHandler = new CBenchmarkEventHandler();
+	g_pEvents->Add(BENCHMARK_NATIVE_EVENT, g_pBenchmarkEventHandler);
+	pRunner->Add("events.call_unhandled", EventsCallUnhandled);
+	pRunner->Add("events.call_unhandled_id", EventsCallUnhandledId);
+	pRunner->Add("events.call_native", EventsCallNative);
+	pRunner->Add("events.call_script", EventsCallScript);
+	pRunner->Add("events.call_script_id", EventsCallScriptId);
+	return true;
+}
+
+void ShutdownScriptingBenchmarks()
+{
+	if(g_pBenchmarkScript)
+	{
+		g_pScriptingManager->Unload("benchmark");
+		g_pBenchmarkScript = NULL;
+	}
+
+	if(g_pBenchmarkEventHandler)
+	{
+		g_pEvents->Remove(BENCHMARK_NATIVE_EVENT, g_pBenchmarkEventHandler);
+		SAFE_DELETE(g_pBenchmarkEventHandler);
+	}
+}
@@ -0,0 +1,85 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: StringBenchmarks.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "Benchmarks.h"
+
+static void StringFormat(unsigned int uiIterations)
+{
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		String strMessage("Player %s (%d) is at %f, %f, %f", "Player", i, 1.0f, 2.0f, 3.0f);
+		g_uiBenchmarkSink += strMessage.GetLength();
+	}
+}
+
+static void StringFormatInto(unsigned int uiIterations)
+{
+	String strMessage;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		strMessage.Format("Player %s (%d) is at %f, %f, %f", "Player", i, 1.0f, 2.0f, 3.0f);
+		g_uiBenchmarkSink += strMessage.GetLength();
+	}
+}
+
+static void StringAppend(unsigned int uiIterations)
+{
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		String strMessage("Player");
+		strMessage += ": ";
+		strMessage += "This is a chat message";
+		strMessage += (unsigned char)'!';
+		g_uiBenchmarkSink += strMessage.GetLength();
+	}
+}
+
+static void StringConcat(unsigned int uiIterations)
+{
+	String strName("Player");
+	String strText("This is a chat message");
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		String strMessage = (strName + ": " + strText);
+		g_uiBenchmarkSink += strMessage.GetLength();
+	}
+}
+
+static void StringCopy(unsigned int uiIterations)
+{
+	// Strings are passed by value almost everywhere
+	String strName("playerOnFootSyncReceived");
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		String strCopy = strName;
+		g_uiBenchmarkSink += strCopy.GetLength();
+	}
+}
+
+static void StringCompare(unsigned int uiIterations)
+{
+	String strName("playerOnFootSyncReceived");
+	String strOther("playerOnFootSyncReceives");
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+		g_uiBenchmarkSink += (strName < strOther ? 1 : 0);
+}
+
+void RegisterStringBenchmarks(CBenchmarkRunner * pRunner)
+{
+	pRunner->Add("string.format", StringFormat);
+	pRunner->Add("string.format_into", StringFormatInto);
+	pRunner->Add("string.append", StringAppend);
+	pRunner->Add("string.concat", StringConcat);
+	pRunner->Add("string.copy", StringCopy);
+	pRunner->Add("string.compare", StringCompare);
+}
@@ -0,0 +1,183 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SyncBenchmarks.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <string.h>
+#include "Benchmarks.h"
+#include <Network/CSyncSerializer.h>
+
+static void GetOnFootSync(OnFootSyncData * pSyncPacket, unsigned int i)
+{
+	memset(pSyncPacket, 0, sizeof(OnFootSyncData));
+	pSyncPacket->controlState = CControlState();
+	pSyncPacket->vecPos = CVector3(-341.36f + (i % 100), 1144.80f, 14.79f);
+	pSyncPacket->fHeading = 1.5f;
+	pSyncPacket->vecMoveSpeed = CVector3(0.5f, 0.25f, 0.0f);
+	pSyncPacket->uHealthArmour = ((200 << 16) | 50);
+	pSyncPacket->uWeaponInfo = ((7 << 20) | 120);
+}
+
+static void GetAimSync(AimSyncData * pAimSyncData)
+{
+	pAimSyncData->vecAimTarget = CVector3(10.0f, 20.0f, 30.0f);
+	pAimSyncData->vecShotSource = CVector3(11.0f, 21.0f, 31.0f);
+	pAimSyncData->vecShotTarget = CVector3(12.0f, 22.0f, 32.0f);
+	pAimSyncData->vecLookAt = CVector3(13.0f, 23.0f, 33.0f);
+}
+
+static void GetInVehicleSync(InVehicleSyncData * pSyncPacket, unsigned int i)
+{
+	memset(pSyncPacket, 0, sizeof(InVehicleSyncData));
+	pSyncPacket->controlState = CControlState();
+	pSyncPacket->vecPos = CVector3(-341.36f + (i % 100), 1144.80f, 14.79f);
+	pSyncPacket->vecRotation = CVector3(0.0f, 0.0f, 90.0f);
+	pSyncPacket->uiHealth = 1000;
+	pSyncPacket->vecMoveSpeed = CVector3(10.0f, 0.0f, 0.0f);
+	pSyncPacket->bEngineStatus = true;
+	pSyncPacket->fPetrolHealth = 1000.0f;
+	pSyncPacket->fQuaternion[2] = 0.7071f;
+	pSyncPacket->fQuaternion[3] = 0.7071f;
+	pSyncPacket->uPlayerHealthArmour = (200 << 16);
+}
+
+static void OnFootSerialize(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	OnFootSyncData syncPacket;
+	GetOnFootSync(&syncPacket, 0);
+	CSyncAnimState animState;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetWritePointer();
+		CSyncSerializer::Serialize(&bitStream, syncPacket, &animState);
+	}
+
+	g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+}
+
+static void OnFootDeserialize(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	OnFootSyncData syncPacket;
+	GetOnFootSync(&syncPacket, 0);
+	CSyncAnimState animState;
+	CSyncSerializer::Serialize(&bitStream, syncPacket, &animState);
+	CSyncAnimState incomingAnimState;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetReadPointer();
+		CSyncSerializer::Deserialize(&bitStream, syncPacket, &incomingAnimState);
+		g_uiBenchmarkSink += syncPacket.uHealthArmour;
+	}
+}
+
+// The serialization the server does for every on foot sync packet: the
+// OnFootSync rpc handler reads the packet and CPlayer::StoreOnFootSync writes
+// the sync relayed to the other players (without the interest grid and send)
+static void StoreOnFootSync(unsigned int uiIterations)
+{
+	CBitStream bsReceived;
+	OnFootSyncData syncPacket;
+	AimSyncData aimSyncData;
+	GetOnFootSync(&syncPacket, 0);
+	GetAimSync(&aimSyncData);
+	CSyncAnimState clientAnimState;
+	CSyncSerializer::Serialize(&bsReceived, syncPacket, &clientAnimState);
+	CVector3 vecHead(14.0f, 24.0f, 34.0f);
+	CSyncSerializer::SerializeLook(&bsReceived, &vecHead, &aimSyncData, NULL);
+	CSyncAnimState incomingAnimState;
+	CSyncAnimState outgoingAnimState;
+	CSyncLookState incomingLookState;
+	CSyncLookState outgoingLookState;
+	EntityId playerId = 1;
+	unsigned short usPing = 50;
+	bool bHelmet = false;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bsReceived.ResetReadPointer();
+
+		if(!CSyncSerializer::Deserialize(&bsReceived, syncPacket, &incomingAnimState))
+			return;
+
+		bool bHasAimSyncData;
+		bool bHasHead;
+
+		if(!CSyncSerializer::DeserializeLook(&bsReceived, bHasHead, vecHead, bHasAimSyncData, aimSyncData, &incomingLookState))
+			return;
+
+		CBitStream bsSend;
+		bsSend.WriteCompressed(playerId);
+		bsSend.WriteCompressed(usPing);
+		bsSend.WriteCompressed(bHelmet);
+		CSyncSerializer::Serialize(&bsSend, syncPacket, &outgoingAnimState);
+
+		CSyncSerializer::SerializeLook(&bsSend, (bHasHead ? &vecHead : NULL), (bHasAimSyncData ? &aimSyncData : NULL), &outgoingLookState);
+
+		g_uiBenchmarkSink += bsSend.GetNumberOfBitsUsed();
+	}
+}
+
+static void InVehicleSerialize(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	InVehicleSyncData syncPacket;
+	GetInVehicleSync(&syncPacket, 0);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetWritePointer();
+		CSyncSerializer::Serialize(&bitStream, syncPacket);
+	}
+
+	g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+}
+
+static void InVehicleDeserialize(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	InVehicleSyncData syncPacket;
+	GetInVehicleSync(&syncPacket, 0);
+	CSyncSerializer::Serialize(&bitStream, syncPacket);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetReadPointer();
+		CSyncSerializer::Deserialize(&bitStream, syncPacket);
+		g_uiBenchmarkSink += syncPacket.uiHealth;
+	}
+}
+
+static void InVehicleSerializeDelta(unsigned int uiIterations)
+{
+	CBitStream bitStream;
+	InVehicleSyncData baseline;
+	InVehicleSyncData syncPacket;
+	GetInVehicleSync(&baseline, 0);
+	GetInVehicleSync(&syncPacket, 1);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		bitStream.ResetWritePointer();
+		CSyncSerializer::SerializeDelta(&bitStream, syncPacket, &baseline);
+	}
+
+	g_uiBenchmarkSink += bitStream.GetNumberOfBitsUsed();
+}
+
+void RegisterSyncBenchmarks(CBenchmarkRunner * pRunner)
+{
+	pRunner->Add("sync.onfoot_serialize", OnFootSerialize);
+	pRunner->Add("sync.onfoot_deserialize", OnFootDeserialize);
+	pRunner->Add("sync.store_onfoot", StoreOnFootSync);
+	pRunner->Add("sync.invehicle_serialize", InVehicleSerialize);
+	pRunner->Add("sync.invehicle_deserialize", InVehicleDeserialize);
+	pRunner->Add("sync.invehicle_serialize_delta", InVehicleSerializeDelta);
+}
@@ -0,0 +1,531 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: WorkloadBenchmarks.cpp
+// Project: Server.Benchmarks
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include "Benchmarks.h"
+#include <Common.h>
+#include <CEvents.h>
+#include <SharedUtility.h>
+#include <Scripting/CScriptTimerManager.h>
+#include <Scripting/Natives/Natives.h>
+#include <Scripting/Natives/AreaNatives.h>
+#include <Scripting/Natives/EventNatives.h>
+#include <Scripting/Natives/SQLiteNatives.h>
+#include <Scripting/Natives/TimerNatives.h>
+#include <Network/CNetServerInterface.h>
+#include <Network/CEventNameTable.h>
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+
+// File the workload script is written to while it is loaded
+#define WORKLOAD_SCRIPT_FILE "ivmp-bench-workload.nut"
+
+// Database of the sqlite workloads, in the files directory like the ones of scripts
+#define WORKLOAD_DATABASE_FILE "ivmp-bench.db"
+
+// Players the gamemode and triggerClientEvent workloads act on
+#define WORKLOAD_PLAYERS 32
+
+// Timers the repeating timer workload keeps running
+#define WORKLOAD_REPEATING_TIMERS 1000
+
+// Timers started and fired by each iteration of the timer storm
+#define WORKLOAD_TIMER_STORM_SIZE 256
+
+extern CScriptingManager * g_pScriptingManager;
+extern CScriptTimerManager * g_pScriptTimerManager;
+extern CEvents * g_pEvents;
+
+// A small gamemode, the natives it uses are the ones of the server except for
+// triggerClientEvent which is replaced below
+static const char * g_szWorkloadScript =
+	"players <- {};\n"
+	"timers <- [];\n"
+	"database <- null;\n"
+	"insertStatement <- null;\n"
+	"selectStatement <- null;\n"
+	"\n"
+	"function addHandlers(eventName, count)\n"
+	"{\n"
+	"	// Every closure is a handler of its own\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"	{\n"
+	"		local index = i;\n"
+	"		addEvent(eventName, function(playerId, text, value)\n"
+	"		{\n"
+	"			return (playerId + index);\n"
+	"		});\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"function onTimer(playerId)\n"
+	"{\n"
+	"	if(playerId in players)\n"
+	"		players[playerId].ticks++;\n"
+	"}\n"
+	"\n"
+	"function startRepeatingTimers(count)\n"
+	"{\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"		timers.push(timer(onTimer, (1 + (i % 16)), -1, (i % 32)));\n"
+	"}\n"
+	"\n"
+	"function startTimerStorm(count)\n"
+	"{\n"
+	"	// The timers are dead once they fired, only the instances are left\n"
+	"	timers.clear();\n"
+	"\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"		timers.push(timer(onTimer, 0, 1, (i % 32)));\n"
+	"}\n"
+	"\n"
+	"function addPlayers(count)\n"
+	"{\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"	{\n"
+	"		players[i] <- {\n"
+	"			name = \"Player\" + i,\n"
+	"			team = (i % 4),\n"
+	"			score = 0,\n"
+	"			kills = 0,\n"
+	"			deaths = 0,\n"
+	"			ticks = 0,\n"
+	"			position = [(i * 10.0), (i * 5.0), 20.0],\n"
+	"			inventory = {}\n"
+	"		};\n"
+	"	}\n"
+	"}\n"
+	"\n"
+	"function gamemodeTick()\n"
+	"{\n"
+	"	local teamScores = [0, 0, 0, 0];\n"
+	"	local leaderboard = [];\n"
+	"\n"
+	"	foreach(playerId, player in players)\n"
+	"	{\n"
+	"		player.position[0] += 0.5;\n"
+	"		player.position[1] -= 0.25;\n"
+	"\n"
+	"		// Everyone close to the spawn scores a kill\n"
+	"		if(getDistanceBetweenPoints3D(player.position[0], player.position[1], player.position[2], 0.0, 0.0, 20.0) < 200.0)\n"
+	"			player.kills++;\n"
+	"\n"
+	"		player.score = ((player.kills * 10) - (player.deaths * 5));\n"
+	"		player.inventory[\"item\" + (player.kills % 8)] <- player.kills;\n"
+	"		teamScores[player.team] += player.score;\n"
+	"		leaderboard.push(player);\n"
+	"	}\n"
+	"\n"
+	"	leaderboard.sort(function(a, b)\n"
+	"	{\n"
+	"		return (b.score <=> a.score);\n"
+	"	});\n"
+	"\n"
+	"	return (leaderboard[0].score + teamScores[0]);\n"
+	"}\n"
+	"\n"
+	"function triggerEvents(count)\n"
+	"{\n"
+	"	local sent = 0;\n"
+	"\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"	{\n"
+	"		if(triggerClientEvent((i % 32), \"onClientScoreUpdate\", i, 1.5, true, \"This is a chat message\"))\n"
+	"			sent++;\n"
+	"	}\n"
+	"\n"
+	"	return sent;\n"
+	"}\n"
+	"\n"
+	"function openDatabase(fileName)\n"
+	"{\n"
+	"	database = db(fileName);\n"
+	"\n"
+	"	// Only the queries are measured, not the disk\n"
+	"	database.query(\"PRAGMA synchronous = OFF\");\n"
+	"	database.query(\"PRAGMA journal_mode = MEMORY\");\n"
+	"\n"
+	"	if(!database.query(\"CREATE TABLE IF NOT EXISTS accounts (id INTEGER PRIMARY KEY, name TEXT, score INTEGER, position REAL)\"))\n"
+	"		return false;\n"
+	"\n"
+	"	database.query(\"DELETE FROM accounts\");\n"
+	"	insertStatement = database.prepare(\"INSERT OR REPLACE INTO accounts (id, name, score, position) VALUES (?, ?, ?, ?)\");\n"
+	"	selectStatement = database.prepare(\"SELECT name, score, position FROM accounts WHERE id = ?\");\n"
+	"	return (insertStatement != false && selectStatement != false);\n"
+	"}\n"
+	"\n"
+	"function closeDatabase()\n"
+	"{\n"
+	"	if(insertStatement)\n"
+	"		insertStatement.close();\n"
+	"\n"
+	"	if(selectStatement)\n"
+	"		selectStatement.close();\n"
+	"\n"
+	"	if(database)\n"
+	"		database.close();\n"
+	"\n"
+	"	insertStatement = null;\n"
+	"	selectStatement = null;\n"
+	"	database = null;\n"
+	"}\n"
+	"\n"
+	"function writeAccounts(count)\n"
+	"{\n"
+	"	database.query(\"BEGIN\");\n"
+	"\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"		database.query(\"INSERT OR REPLACE INTO accounts (id, name, score, position) VALUES (?, ?, ?, ?)\", (i % 1024), \"Player\" + i, i, 1.5);\n"
+	"\n"
+	"	database.query(\"COMMIT\");\n"
+	"	return count;\n"
+	"}\n"
+	"\n"
+	"function writeAccountsPrepared(count)\n"
+	"{\n"
+	"	database.query(\"BEGIN\");\n"
+	"\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"	{\n"
+	"		insertStatement.bind(1, (i % 1024));\n"
+	"		insertStatement.bind(2, \"Player\" + i);\n"
+	"		insertStatement.bind(3, i);\n"
+	"		insertStatement.bind(4, 1.5);\n"
+	"		insertStatement.step();\n"
+	"		insertStatement.reset();\n"
+	"	}\n"
+	"\n"
+	"	database.query(\"COMMIT\");\n"
+	"	return count;\n"
+	"}\n"
+	"\n"
+	"function readAccounts(count)\n"
+	"{\n"
+	"	local score = 0;\n"
+	"\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"	{\n"
+	"		local rows = database.query(\"SELECT name, score, position FROM accounts WHERE id = ?\", (i % 1024));\n"
+	"\n"
+	"		// The rows are keyed by their number, starting at 1\n"
+	"		if(rows && (1 in rows))\n"
+	"			score += rows[1].score;\n"
+	"	}\n"
+	"\n"
+	"	return score;\n"
+	"}\n"
+	"\n"
+	"function readAccountsPrepared(count)\n"
+	"{\n"
+	"	local score = 0;\n"
+	"\n"
+	"	for(local i = 0; i < count; i++)\n"
+	"	{\n"
+	"		selectStatement.bind(1, (i % 1024));\n"
+	"\n"
+	"		if(selectStatement.step())\n"
+	"			score += selectStatement.column(1);\n"
+	"\n"
+	"		selectStatement.reset();\n"
+	"	}\n"
+	"\n"
+	"	return score;\n"
+	"}\n";
+
+// Events with that many script handlers
+static const int g_iEventHandlerCounts[] = { 1, 16, 64 };
+
+static CSquirrel * g_pWorkloadScript = NULL;
+static CScriptTimerManager * g_pWorkloadTimerManager = NULL;
+static CEventNameTable * g_pWorkloadEventNames = NULL;
+static bool g_bWorkloadDatabaseOpen = false;
+static bool g_bRepeatingTimersStarted = false;
+
+// Frame time of the last simulated tick of the timer workloads
+static unsigned long long g_ullWorkloadFrameTime = 0;
+
+// triggerClientEvent(playerid, eventname, ...)
+// Writes the rpc the way CNetworkManager::EventRPC does for a single player
+// but drops it instead of sending it
+static SQUIRREL_FUNCTION(triggerClientEvent)
+{
+	CHECK_PARAMS_MIN("triggerClientEvent", 2);
+	CHECK_TYPE("triggerClientEvent", 1, 2, OT_INTEGER);
+	CHECK_TYPE("triggerClientEvent", 2, 3, OT_STRING);
+
+	SQInteger playerId;
+	sq_getinteger(pVM, 2, &playerId);
+
+	if(playerId < 0 || playerId >= WORKLOAD_PLAYERS)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * szEventName;
+	sq_getstring(pVM, 3, &szEventName);
+	CSquirrelArguments arguments(pVM, 4);
+	String strEventName(szEventName);
+	EventNameId nameId = g_pWorkloadEventNames->GetId(strEventName);
+	CBitStream bsDefinition;
+
+	if(g_pWorkloadEventNames->WriteDefinition((EntityId)playerId, nameId, &bsDefinition))
+		g_uiBenchmarkSink += bsDefinition.GetNumberOfBytesUsed();
+
+	CBitStream bsSend;
+	bsSend.PadWithZeroToByteLength(RPC_HEADER_SIZE);
+	g_pWorkloadEventNames->WriteEvent(nameId, strEventName, &bsSend);
+	arguments.serialize(&bsSend);
+	g_uiBenchmarkSink += bsSend.GetNumberOfBytesUsed();
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+static bool GetWorkloadFunction(const char * szName, SQObjectPtr * pFunction)
+{
+	SQVM * pVM = g_pWorkloadScript->GetVM();
+	sq_pushroottable(pVM);
+	sq_pushstring(pVM, szName, -1);
+
+	if(SQ_FAILED(sq_get(pVM, -2)))
+	{
+		sq_pop(pVM, 1);
+		return false;
+	}
+
+	*pFunction = stack_get(pVM, -1);
+	sq_pop(pVM, 2);
+	return true;
+}
+
+static CSquirrelArgument CallWorkloadFunction(const char * szName, CSquirrelArguments * pArguments = NULL)
+{
+	CSquirrelArgument returnValue;
+	SQObjectPtr pFunction;
+
+	if(GetWorkloadFunction(szName, &pFunction))
+		g_pWorkloadScript->Call(pFunction, pArguments, &returnValue);
+
+	return returnValue;
+}
+
+// Calls a function of the workload script with a single integer argument
+static CSquirrelArgument CallWorkloadFunction(const char * szName, int iArgument)
+{
+	CSquirrelArguments arguments;
+	arguments.push(iArgument);
+	return CallWorkloadFunction(szName, &arguments);
+}
+
+static void CallEvent(const char * szName, unsigned int uiIterations)
+{
+	// The arguments of a typical event: player, a string and a value
+	CSquirrelArguments arguments;
+	arguments.push(1);
+	arguments.push("This is a chat message");
+	arguments.push(1.5f);
+	EventId eventId = g_pEvents->FindEventId(szName);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+		g_uiBenchmarkSink += g_pEvents->Call(eventId, &arguments).GetInteger();
+}
+
+static void EventsOneHandler(unsigned int uiIterations)
+{
+	CallEvent("workloadEvent1", uiIterations);
+}
+
+static void EventsManyHandlers(unsigned int uiIterations)
+{
+	CallEvent("workloadEvent16", uiIterations);
+}
+
+static void EventsLotsOfHandlers(unsigned int uiIterations)
+{
+	CallEvent("workloadEvent64", uiIterations);
+}
+
+// Runs the timer manager for a tick, the frame time is moved on by a ms
+// instead of waiting for the clock
+static void PulseTimers()
+{
+	g_ullWorkloadFrameTime += 1000;
+	SharedUtility::SetFrameMicroseconds(g_ullWorkloadFrameTime);
+	g_pScriptTimerManager->Pulse();
+}
+
+static void TimersRepeating(unsigned int uiIterations)
+{
+	// The timers are only started once this runs so they don't run during the storm
+	if(!g_bRepeatingTimersStarted)
+	{
+		CallWorkloadFunction("startRepeatingTimers", WORKLOAD_REPEATING_TIMERS);
+		g_bRepeatingTimersStarted = true;
+	}
+
+	// Each iteration is a tick of the server with the timers running
+	for(unsigned int i = 0; i < uiIterations; i++)
+		PulseTimers();
+
+	g_uiBenchmarkSink += g_pScriptTimerManager->GetCount();
+}
+
+static void TimersStorm(unsigned int uiIterations)
+{
+	// Each iteration starts a burst of timers and runs them on the next tick
+	SQObjectPtr pFunction;
+
+	if(!GetWorkloadFunction("startTimerStorm", &pFunction))
+		return;
+
+	CSquirrelArguments arguments;
+	arguments.push(WORKLOAD_TIMER_STORM_SIZE);
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		g_pWorkloadScript->Call(pFunction, &arguments);
+		PulseTimers();
+	}
+
+	g_uiBenchmarkSink += g_pScriptTimerManager->GetCount();
+}
+
+static void GamemodeTick(unsigned int uiIterations)
+{
+	SQObjectPtr pFunction;
+
+	if(!GetWorkloadFunction("gamemodeTick", &pFunction))
+		return;
+
+	for(unsigned int i = 0; i < uiIterations; i++)
+	{
+		CSquirrelArgument returnValue;
+		g_pWorkloadScript->Call(pFunction, NULL, &returnValue);
+		g_uiBenchmarkSink += returnValue.GetInteger();
+	}
+}
+
+// The script loops itself so every iteration is a single call of the natives
+static void TriggerClientEvent(unsigned int uiIterations)
+{
+	g_uiBenchmarkSink += CallWorkloadFunction("triggerEvents", (int)uiIterations).GetInteger();
+}
+
+static void SQLiteWrite(unsigned int uiIterations)
+{
+	g_uiBenchmarkSink += CallWorkloadFunction("writeAccounts", (int)uiIterations).GetInteger();
+}
+
+static void SQLiteWritePrepared(unsigned int uiIterations)
+{
+	g_uiBenchmarkSink += CallWorkloadFunction("writeAccountsPrepared", (int)uiIterations).GetInteger();
+}
+
+static void SQLiteRead(unsigned int uiIterations)
+{
+	g_uiBenchmarkSink += CallWorkloadFunction("readAccounts", (int)uiIterations).GetInteger();
+}
+
+static void SQLiteReadPrepared(unsigned int uiIterations)
+{
+	g_uiBenchmarkSink += CallWorkloadFunction("readAccountsPrepared", (int)uiIterations).GetInteger();
+}
+
+bool RegisterWorkloadBenchmarks(CBenchmarkRunner * pRunner)
+{
+	// The natives of the server the workloads use
+	CAreaNatives::Register(g_pScriptingManager);
+	CEventNatives::Register(g_pScriptingManager);
+	RegisterSQLiteNatives(g_pScriptingManager);
+	RegisterTimerNatives(g_pScriptingManager);
+	g_pScriptingManager->RegisterFunction("triggerClientEvent", sq_triggerClientEvent, -1, NULL);
+
+	// The timers are run on a simulated clock which starts now
+	g_ullWorkloadFrameTime = SharedUtility::GetMicroseconds();
+	SharedUtility::SetFrameMicroseconds(g_ullWorkloadFrameTime);
+	g_pWorkloadTimerManager = new CScriptTimerManager();
+	g_pScriptTimerManager = g_pWorkloadTimerManager;
+	g_pWorkloadEventNames = new CEventNameTable();
+
+	FILE * pFile = fopen(WORKLOAD_SCRIPT_FILE, "w");
+
+	if(!pFile)
+		return false;
+
+	fputs(g_szWorkloadScript, pFile);
+	fclose(pFile);
+	g_pWorkloadScript = g_pScriptingManager->Load("workload", WORKLOAD_SCRIPT_FILE);
+	remove(WORKLOAD_SCRIPT_FILE);
+
+	if(!g_pWorkloadScript)
+		return false;
+
+	SQObjectPtr pFunction;
+
+	if(!GetWorkloadFunction("addHandlers", &pFunction))
+		return false;
+
+	for(unsigned int i = 0; i < (sizeof(g_iEventHandlerCounts) / sizeof(g_iEventHandlerCounts[0])); i++)
+	{
+		CSquirrelArguments arguments;
+		arguments.push(String("workloadEvent%d", g_iEventHandlerCounts[i]));
+		arguments.push(g_iEventHandlerCounts[i]);
+		g_pWorkloadScript->Call(pFunction, &arguments);
+	}
+
+	CallWorkloadFunction("addPlayers", WORKLOAD_PLAYERS);
+	pRunner->Add("workload.events_1_handler", EventsOneHandler);
+	pRunner->Add("workload.events_16_handlers", EventsManyHandlers);
+	pRunner->Add("workload.events_64_handlers", EventsLotsOfHandlers);
+	pRunner->Add("workload.timers_storm", TimersStorm);
+	pRunner->Add("workload.gamemode_tick", GamemodeTick);
+	pRunner->Add("workload.timers_repeating", TimersRepeating);
+	pRunner->Add("workload.trigger_client_event", TriggerClientEvent);
+
+	// The database goes to the files directory of the scripts
+	CSquirrelArguments databaseArguments;
+	databaseArguments.push(WORKLOAD_DATABASE_FILE);
+	g_bWorkloadDatabaseOpen = CallWorkloadFunction("openDatabase", &databaseArguments).GetBool();
+
+	if(g_bWorkloadDatabaseOpen)
+	{
+		// The writes run first so the reads find the rows
+		pRunner->Add("workload.sqlite_write", SQLiteWrite);
+		pRunner->Add("workload.sqlite_write_prepared", SQLiteWritePrepared);
+		pRunner->Add("workload.sqlite_read", SQLiteRead);
+		pRunner->Add("workload.sqlite_read_prepared", SQLiteReadPrepared);
+	}
+	else
+		CLogFile::Print("Failed to open the workload database, skipping the sqlite benchmarks.");
+
+	return true;
+}
+
+void ShutdownWorkloadBenchmarks()
+{
+	if(g_pWorkloadScript)
+	{
+		if(g_bWorkloadDatabaseOpen)
+		{
+			CallWorkloadFunction("closeDatabase");
+			remove(SharedUtility::GetAbsolutePath("files/%s", WORKLOAD_DATABASE_FILE).Get());
+			g_bWorkloadDatabaseOpen = false;
+		}
+
+		// Unloading it takes its timers and event handlers away as well
+		g_pScriptingManager->Unload("workload");
+		g_pWorkloadScript = NULL;
+	}
+
+	g_pScriptTimerManager = NULL;
+	SAFE_DELETE(g_pWorkloadTimerManager);
+	g_bRepeatingTimersStarted = false;
+	SAFE_DELETE(g_pWorkloadEventNames);
+	SharedUtility::UpdateFrameTime();
+}
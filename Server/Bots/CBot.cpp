@@ -0,0 +1,241 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBot.cpp
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <math.h>
+#include "CBot.h"
+#include "CBotManager.h"
+#include <Network/CNetworkModule.h>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+extern CBotManager * g_pBotManager;
+
+// Drivers move this many times faster than the walking speed
+#define BOT_DRIVING_SPEED_FACTOR 4.0f
+
+// Distance at which a waypoint counts as reached
+#define BOT_WAYPOINT_DISTANCE 1.0f
+
+CBot::CBot(unsigned int uiIndex, String strName, bool bDriver, unsigned int uiWaypoint, CVector3 vecPosition)
+{
+	m_uiIndex = uiIndex;
+	m_strName = strName;
+	m_pNetClient = NULL;
+	m_state = BOT_STATE_IDLE;
+	m_playerId = INVALID_ENTITY_ID;
+	m_bDriver = bDriver;
+	m_vehicleId = INVALID_ENTITY_ID;
+	m_fHeading = 0.0f;
+	m_ulConnectTime = 0;
+	m_ulJoinTime = 0;
+	m_ulLastSyncTime = 0;
+	m_ulNextChatTime = 0;
+	m_uiChatMessages = 0;
+	m_ulRpcsSent = 0;
+	m_ulRpcsReceived = 0;
+	m_uiWaypoint = uiWaypoint;
+	m_vecPosition = vecPosition;
+}
+
+CBot::~CBot()
+{
+	Disconnect();
+}
+
+bool CBot::Connect()
+{
+	const BotSettings * pSettings = g_pBotManager->GetSettings();
+	m_pNetClient = CNetworkModule::GetNetClientInterface();
+
+	if(!m_pNetClient || !m_pNetClient->Startup())
+	{
+		OnFailed("failed to start up the net client");
+		return false;
+	}
+
+	m_pNetClient->SetPacketHandler(CBotManager::PacketHandler);
+	m_pNetClient->SetHost(pSettings->strHost);
+	m_pNetClient->SetPort(pSettings->usPort);
+	m_pNetClient->SetPassword(pSettings->strPassword);
+
+	if(m_pNetClient->Connect() != CONNECTION_ATTEMPT_STARTED)
+	{
+		OnFailed("failed to start the connection attempt");
+		return false;
+	}
+
+	m_state = BOT_STATE_CONNECTING;
+	m_ulConnectTime = SharedUtility::GetTime();
+	return true;
+}
+
+void CBot::Disconnect()
+{
+	if(!m_pNetClient)
+		return;
+
+	m_pNetClient->Shutdown(100);
+	CNetworkModule::DestroyNetClientInterface(m_pNetClient);
+	m_pNetClient = NULL;
+}
+
+void CBot::RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability)
+{
+	m_pNetClient->RPC(rpcId, pBitStream, priority, reliability);
+	m_ulRpcsSent++;
+}
+
+void CBot::OnConnected()
+{
+	// Send the same connect rpc as the client
+	CBitStream bsSend;
+	bsSend.Write(NETWORK_VERSION);
+	bsSend.Write(m_strName);
+	bsSend.WriteBit(false);
+	bsSend.WriteBit(false); // No transfer
+	bsSend.WriteBit(false); // Not a relay
+	RPC(RPC_PlayerConnect, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
+	m_state = BOT_STATE_JOINING;
+}
+
+void CBot::OnJoined(EntityId playerId)
+{
+	m_playerId = playerId;
+	m_ulJoinTime = (SharedUtility::GetTime() - m_ulConnectTime);
+
+	// Spawn with the default skin
+	CBitStream bsSend;
+	bsSend.Write(0);
+	RPC(RPC_PlayerSpawn, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
+	m_state = BOT_STATE_SPAWNED;
+
+	// Spread the chat messages of the bots over the chat interval
+	unsigned int uiChatInterval = g_pBotManager->GetSettings()->uiChatInterval;
+	m_ulLastSyncTime = SharedUtility::GetTime();
+	m_ulNextChatTime = (m_ulLastSyncTime + (uiChatInterval > 0 ? (rand() % uiChatInterval) : 0));
+}
+
+void CBot::OnFailed(const char * szReason)
+{
+	// Only the first reason is interesting (a refused connection is also disconnected)
+	if(m_state == BOT_STATE_FAILED)
+		return;
+
+	CLogFile::Printf("Bot %s failed: %s.", m_strName.Get(), szReason);
+	m_state = BOT_STATE_FAILED;
+}
+
+void CBot::Move(unsigned long ulTime)
+{
+	const BotSettings * pSettings = g_pBotManager->GetSettings();
+	const CVector3& vecWaypoint = pSettings->path[m_uiWaypoint];
+	float fSpeed = (m_vehicleId != INVALID_ENTITY_ID ? (pSettings->fSpeed * BOT_DRIVING_SPEED_FACTOR) : pSettings->fSpeed);
+	float fDistance = (fSpeed * ((ulTime - m_ulLastSyncTime) / 1000.0f));
+
+	// Walk (or drive) towards the next waypoint
+	CVector3 vecDirection = (vecWaypoint - m_vecPosition);
+	vecDirection.fZ = 0.0f;
+	float fLength = vecDirection.Length();
+
+	if(fLength <= BOT_WAYPOINT_DISTANCE || fLength <= fDistance)
+	{
+		m_vecPosition.fX = vecWaypoint.fX;
+		m_vecPosition.fY = vecWaypoint.fY;
+		m_uiWaypoint = ((m_uiWaypoint + 1) % pSettings->path.size());
+		return;
+	}
+
+	vecDirection /= fLength;
+	m_vecPosition = (m_vecPosition + (vecDirection * fDistance));
+	m_vecPosition.fZ = vecWaypoint.fZ;
+	m_vecMoveSpeed = (vecDirection * (fSpeed / 50.0f));
+	m_fHeading = (float)atan2(-vecDirection.fX, vecDirection.fY);
+}
+
+void CBot::SendOnFootSync()
+{
+	CBitStream bsSend;
+	OnFootSyncData syncPacket;
+	memset(&syncPacket, 0, sizeof(syncPacket));
+	syncPacket.controlState = CControlState();
+	syncPacket.vecPos = m_vecPosition;
+	syncPacket.fHeading = m_fHeading;
+	syncPacket.vecMoveSpeed = m_vecMoveSpeed;
+	syncPacket.uHealthArmour = (200 << 16);
+	CSyncSerializer::Serialize(&bsSend, syncPacket, &m_animState);
+
+	// Bots never look around or aim
+	CSyncSerializer::SerializeLook(&bsSend, NULL, NULL, NULL);
+	RPC(RPC_OnFootSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
+}
+
+void CBot::SendInVehicleSync()
+{
+	CBitStream bsSend;
+	bsSend.WriteCompressed(m_vehicleId);
+	InVehicleSyncData syncPacket;
+	memset(&syncPacket, 0, sizeof(syncPacket));
+	syncPacket.controlState = CControlState();
+	syncPacket.vecPos = m_vecPosition;
+	syncPacket.vecRotation.fZ = (m_fHeading * (180.0f / 3.14159265f));
+	syncPacket.uiHealth = 1000;
+	syncPacket.vecMoveSpeed = m_vecMoveSpeed;
+	syncPacket.bEngineStatus = true;
+	syncPacket.fPetrolHealth = 1000.0f;
+	syncPacket.fQuaternion[2] = (float)sin(m_fHeading / 2.0f);
+	syncPacket.fQuaternion[3] = (float)cos(m_fHeading / 2.0f);
+	syncPacket.uPlayerHealthArmour = (200 << 16);
+	CSyncSerializer::Serialize(&bsSend, syncPacket);
+
+	// Bots never do drive bys
+	CSyncSerializer::SerializeLook(&bsSend, NULL, NULL, NULL);
+	RPC(RPC_InVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
+}
+
+void CBot::SendChat()
+{
+	CBitStream bsSend;
+	bsSend.Write(String("Message %d from %s", ++m_uiChatMessages, m_strName.Get()));
+	RPC(RPC_Chat, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE);
+}
+
+void CBot::Process(unsigned long ulTime)
+{
+	if(!m_pNetClient)
+		return;
+
+	// Handle the packets the server sent us
+	m_pNetClient->Process();
+
+	if(m_state != BOT_STATE_SPAWNED)
+		return;
+
+	const BotSettings * pSettings = g_pBotManager->GetSettings();
+
+	if((ulTime - m_ulLastSyncTime) >= pSettings->uiSyncInterval)
+	{
+		// Drivers take a vehicle once the server told us about any
+		if(m_bDriver && m_vehicleId == INVALID_ENTITY_ID)
+			m_vehicleId = g_pBotManager->GetVehicle(m_uiIndex);
+
+		Move(ulTime);
+		m_ulLastSyncTime = ulTime;
+
+		if(m_vehicleId != INVALID_ENTITY_ID)
+			SendInVehicleSync();
+		else
+			SendOnFootSync();
+	}
+
+	if(pSettings->uiChatInterval > 0 && ulTime >= m_ulNextChatTime)
+	{
+		SendChat();
+		m_ulNextChatTime = (ulTime + pSettings->uiChatInterval);
+	}
+}
@@ -0,0 +1,84 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBot.h
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <Common.h>
+#include <Network/CNetClientInterface.h>
+#include <Network/CSyncSerializer.h>
+
+enum eBotState
+{
+	// Not connected yet
+	BOT_STATE_IDLE,
+
+	// Waiting for the server to accept the connection
+	BOT_STATE_CONNECTING,
+
+	// Waiting for the joined game rpc
+	BOT_STATE_JOINING,
+
+	// Spawned and sending sync
+	BOT_STATE_SPAWNED,
+
+	// Refused, disconnected or lost the connection
+	BOT_STATE_FAILED
+};
+
+// A simulated client that joins the server, spawns and sends on foot (or in
+// vehicle) sync along the path and chat messages
+class CBot
+{
+private:
+	unsigned int          m_uiIndex;
+	String                m_strName;
+	CNetClientInterface * m_pNetClient;
+	eBotState             m_state;
+	EntityId              m_playerId;
+	bool                  m_bDriver;
+	EntityId              m_vehicleId;
+	CSyncAnimState        m_animState;
+	CVector3              m_vecPosition;
+	CVector3              m_vecMoveSpeed;
+	float                 m_fHeading;
+	unsigned int          m_uiWaypoint;
+	unsigned long         m_ulConnectTime;
+	unsigned long         m_ulJoinTime;
+	unsigned long         m_ulLastSyncTime;
+	unsigned long         m_ulNextChatTime;
+	unsigned int          m_uiChatMessages;
+	unsigned long         m_ulRpcsSent;
+	unsigned long         m_ulRpcsReceived;
+
+	void                  Move(unsigned long ulTime);
+	void                  SendOnFootSync();
+	void                  SendInVehicleSync();
+	void                  SendChat();
+	void                  RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability);
+
+public:
+	CBot(unsigned int uiIndex, String strName, bool bDriver, unsigned int uiWaypoint, CVector3 vecPosition);
+	~CBot();
+
+	eBotState             GetState() { return m_state; }
+	String                GetName() { return m_strName; }
+	EntityId              GetPlayerId() { return m_playerId; }
+	CNetClientInterface * GetNetClient() { return m_pNetClient; }
+	unsigned long         GetJoinTime() { return m_ulJoinTime; }
+	unsigned long         GetRpcsSent() { return m_ulRpcsSent; }
+	unsigned long         GetRpcsReceived() { return m_ulRpcsReceived; }
+	void                  OnRpcReceived() { m_ulRpcsReceived++; }
+	bool                  Connect();
+	void                  Disconnect();
+	void                  OnConnected();
+	void                  OnJoined(EntityId playerId);
+	void                  OnFailed(const char * szReason);
+	void                  Process(unsigned long ulTime);
+};
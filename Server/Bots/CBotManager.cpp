@@ -0,0 +1,234 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBotManager.cpp
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <algorithm>
+#include "CBotManager.h"
+#include <Network/PacketIdentifiers.h>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+CBotManager * g_pBotManager = NULL;
+
+CBotManager::CBotManager(const BotSettings& settings)
+{
+	m_settings = settings;
+	m_pProcessingBot = NULL;
+
+	// Create the packet handler instance
+	m_pPacketHandler = new CBotPacketHandler();
+	m_pPacketHandler->Register();
+
+	// Create the rpc handler instance
+	m_pRPCHandler = new CBotRPCHandler();
+	m_pRPCHandler->Register();
+
+	// Create the bots, the drivers are spread over all bots
+	for(unsigned int i = 0; i < m_settings.uiBots; i++)
+	{
+		bool bDriver = (((i * m_settings.uiDrivers) % 100) + m_settings.uiDrivers >= 100);
+
+		// Spread the bots over the path and a small grid around it so they
+		// don't all stand on top of each other
+		unsigned int uiWaypoint = (i % m_settings.path.size());
+		CVector3 vecPosition = m_settings.path[uiWaypoint];
+		vecPosition.fX += (float)(i % 10);
+		vecPosition.fY += (float)((i / 10) % 10);
+		m_bots.push_back(new CBot(i, String("%s%d", m_settings.strName.Get(), i), bDriver, uiWaypoint, vecPosition));
+	}
+
+	m_ulStartTime = SharedUtility::GetTime();
+	m_ulLastJoinTime = 0;
+	m_ulLastReportTime = m_ulStartTime;
+	m_ulLastRpcsSent = 0;
+	m_ulLastRpcsReceived = 0;
+	m_pReportFile = NULL;
+
+	if(m_settings.strReportFile.IsNotEmpty())
+	{
+		m_pReportFile = fopen(m_settings.strReportFile.Get(), "w");
+
+		if(m_pReportFile)
+			fprintf(m_pReportFile, "time,bots,connecting,joining,spawned,failed,ping_avg,ping_max,packetloss,bytes_sent,bytes_received,rpcs_sent,rpcs_received,join_time_avg\n");
+		else
+			CLogFile::Printf("Failed to open %s for the reports.", m_settings.strReportFile.Get());
+	}
+}
+
+CBotManager::~CBotManager()
+{
+	// Print the final report before the bots go
+	Report(SharedUtility::GetTime());
+
+	for(std::vector<CBot *>::iterator iter = m_bots.begin(); iter != m_bots.end(); iter++)
+		delete *iter;
+
+	m_pRPCHandler->Unregister();
+	SAFE_DELETE(m_pRPCHandler);
+	m_pPacketHandler->Unregister();
+	SAFE_DELETE(m_pPacketHandler);
+
+	if(m_pReportFile)
+		fclose(m_pReportFile);
+}
+
+void CBotManager::PacketHandler(CPacket * pPacket)
+{
+	// Packets are only handled from CBot::Process so they belong to the bot
+	// that is being processed
+	CBot * pBot = g_pBotManager->m_pProcessingBot;
+
+	if(!pBot)
+		return;
+
+	if(pPacket->packetId == PACKET_RPC)
+		pBot->OnRpcReceived();
+
+	// Pass it to the packet handler, if that doesn't handle it, pass it to the rpc handler
+	if(!g_pBotManager->m_pPacketHandler->HandlePacket(pPacket))
+		g_pBotManager->m_pRPCHandler->HandlePacket(pPacket);
+}
+
+void CBotManager::AddVehicle(EntityId vehicleId)
+{
+	if(std::find(m_vehicles.begin(), m_vehicles.end(), vehicleId) == m_vehicles.end())
+		m_vehicles.push_back(vehicleId);
+}
+
+void CBotManager::RemoveVehicle(EntityId vehicleId)
+{
+	std::vector<EntityId>::iterator iter = std::find(m_vehicles.begin(), m_vehicles.end(), vehicleId);
+
+	if(iter != m_vehicles.end())
+		m_vehicles.erase(iter);
+}
+
+EntityId CBotManager::GetVehicle(unsigned int uiIndex)
+{
+	if(m_vehicles.empty())
+		return INVALID_ENTITY_ID;
+
+	return m_vehicles[uiIndex % m_vehicles.size()];
+}
+
+bool CBotManager::IsFinished()
+{
+	return (m_settings.uiDuration > 0 && (SharedUtility::GetTime() - m_ulStartTime) >= (m_settings.uiDuration * 1000));
+}
+
+void CBotManager::Report(unsigned long ulTime)
+{
+	unsigned int uiStates[BOT_STATE_FAILED + 1] = { 0 };
+	unsigned int uiPings = 0;
+	unsigned long ulTotalPing = 0;
+	int iMaxPing = 0;
+	float fTotalPacketloss = 0.0f;
+	NetStat_t ulBytesSent = 0;
+	NetStat_t ulBytesReceived = 0;
+	unsigned long ulRpcsSent = 0;
+	unsigned long ulRpcsReceived = 0;
+	unsigned int uiJoined = 0;
+	unsigned long ulTotalJoinTime = 0;
+
+	for(std::vector<CBot *>::iterator iter = m_bots.begin(); iter != m_bots.end(); iter++)
+	{
+		CBot * pBot = *iter;
+		uiStates[pBot->GetState()]++;
+		ulRpcsSent += pBot->GetRpcsSent();
+		ulRpcsReceived += pBot->GetRpcsReceived();
+
+		if(pBot->GetState() != BOT_STATE_SPAWNED)
+			continue;
+
+		uiJoined++;
+		ulTotalJoinTime += pBot->GetJoinTime();
+
+		// The net stats are only valid while connected
+		CNetClientInterface * pNetClient = pBot->GetNetClient();
+
+		if(!pNetClient || !pNetClient->IsConnected())
+			continue;
+
+		int iPing = pNetClient->GetAveragePing();
+
+		if(iPing >= 0)
+		{
+			ulTotalPing += iPing;
+			iMaxPing = std::max(iMaxPing, iPing);
+			uiPings++;
+		}
+
+		CNetStats * pNetStats = pNetClient->GetNetStats();
+		fTotalPacketloss += pNetStats->fPacketlossLastSecond;
+		ulBytesSent += pNetStats->ulValueOverLastSecond[ACTUAL_BYTES_SENT];
+		ulBytesReceived += pNetStats->ulValueOverLastSecond[ACTUAL_BYTES_RECEIVED];
+	}
+
+	// Rpc rates are over the time since the last report
+	float fSeconds = ((ulTime - m_ulLastReportTime) / 1000.0f);
+
+	if(fSeconds <= 0.0f)
+		fSeconds = 1.0f;
+
+	float fRpcsSent = ((ulRpcsSent - m_ulLastRpcsSent) / fSeconds);
+	float fRpcsReceived = ((ulRpcsReceived - m_ulLastRpcsReceived) / fSeconds);
+	unsigned long ulAveragePing = (uiPings > 0 ? (ulTotalPing / uiPings) : 0);
+	float fPacketloss = (uiPings > 0 ? ((fTotalPacketloss / uiPings) * 100.0f) : 0.0f);
+	unsigned long ulAverageJoinTime = (uiJoined > 0 ? (ulTotalJoinTime / uiJoined) : 0);
+	unsigned long ulRunTime = ((ulTime - m_ulStartTime) / 1000);
+	m_ulLastReportTime = ulTime;
+	m_ulLastRpcsSent = ulRpcsSent;
+	m_ulLastRpcsReceived = ulRpcsReceived;
+
+	CLogFile::Printf("[%lus] %d bot(s): %d connecting, %d joining, %d spawned, %d failed | ping %lu ms avg, %d ms max | packetloss %.2f%% | %.1f KB/s sent, %.1f KB/s received | %.0f rpc/s sent, %.0f rpc/s received | join %lu ms avg",
+		ulRunTime, m_bots.size(), uiStates[BOT_STATE_CONNECTING], uiStates[BOT_STATE_JOINING], uiStates[BOT_STATE_SPAWNED], uiStates[BOT_STATE_FAILED],
+		ulAveragePing, iMaxPing, fPacketloss, (ulBytesSent / 1024.0f), (ulBytesReceived / 1024.0f), fRpcsSent, fRpcsReceived, ulAverageJoinTime);
+
+	if(m_pReportFile)
+	{
+		fprintf(m_pReportFile, "%lu,%d,%d,%d,%d,%d,%lu,%d,%.4f,%llu,%llu,%.1f,%.1f,%lu\n", ulRunTime, (int)m_bots.size(), uiStates[BOT_STATE_CONNECTING],
+			uiStates[BOT_STATE_JOINING], uiStates[BOT_STATE_SPAWNED], uiStates[BOT_STATE_FAILED], ulAveragePing, iMaxPing, fPacketloss,
+			(unsigned long long)ulBytesSent, (unsigned long long)ulBytesReceived, fRpcsSent, fRpcsReceived, ulAverageJoinTime);
+		fflush(m_pReportFile);
+	}
+}
+
+void CBotManager::Process()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	// Connect the next bot, one per join interval so the server isn't hit by
+	// all of them at once
+	if((ulTime - m_ulLastJoinTime) >= m_settings.uiJoinInterval)
+	{
+		for(std::vector<CBot *>::iterator iter = m_bots.begin(); iter != m_bots.end(); iter++)
+		{
+			if((*iter)->GetState() == BOT_STATE_IDLE)
+			{
+				(*iter)->Connect();
+				m_ulLastJoinTime = ulTime;
+				break;
+			}
+		}
+	}
+
+	for(std::vector<CBot *>::iterator iter = m_bots.begin(); iter != m_bots.end(); iter++)
+	{
+		m_pProcessingBot = *iter;
+		m_pProcessingBot->Process(ulTime);
+
+		// Failed bots stay failed, their connection isn't needed anymore
+		if(m_pProcessingBot->GetState() == BOT_STATE_FAILED)
+			m_pProcessingBot->Disconnect();
+	}
+
+	m_pProcessingBot = NULL;
+
+	if(m_settings.uiReportInterval > 0 && (ulTime - m_ulLastReportTime) >= m_settings.uiReportInterval)
+		Report(ulTime);
+}
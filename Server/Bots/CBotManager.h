@@ -0,0 +1,70 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBotManager.h
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include "CBot.h"
+#include "CBotPacketHandler.h"
+#include "CBotRPCHandler.h"
+
+// Settings of a bot run, all times are in ms
+struct BotSettings
+{
+	String                strHost;
+	unsigned short        usPort;
+	String                strPassword;
+	String                strName;
+	unsigned int          uiBots;
+	unsigned int          uiJoinInterval;
+	unsigned int          uiSyncInterval;
+	unsigned int          uiChatInterval;   // 0 disables chat
+	unsigned int          uiDrivers;        // Percentage of the bots that drive (when there are vehicles)
+	float                 fSpeed;           // Walking speed in units per second
+	unsigned int          uiReportInterval;
+	String                strReportFile;    // Csv file the reports are also written to (if any)
+	unsigned int          uiDuration;       // 0 runs until stopped
+	std::vector<CVector3> path;             // Waypoints the bots walk along (in a loop)
+};
+
+class CBotManager
+{
+private:
+	BotSettings           m_settings;
+	std::vector<CBot *>   m_bots;
+	CBot *                m_pProcessingBot;
+	CBotPacketHandler *   m_pPacketHandler;
+	CBotRPCHandler *      m_pRPCHandler;
+	std::vector<EntityId> m_vehicles;
+	unsigned long         m_ulStartTime;
+	unsigned long         m_ulLastJoinTime;
+	unsigned long         m_ulLastReportTime;
+	unsigned long         m_ulLastRpcsSent;
+	unsigned long         m_ulLastRpcsReceived;
+	FILE *                m_pReportFile;
+
+	void                  Report(unsigned long ulTime);
+
+public:
+	CBotManager(const BotSettings& settings);
+	~CBotManager();
+
+	static void           PacketHandler(CPacket * pPacket);
+
+	const BotSettings *   GetSettings() { return &m_settings; }
+	CBot *                GetProcessingBot() { return m_pProcessingBot; }
+	void                  AddVehicle(EntityId vehicleId);
+	void                  RemoveVehicle(EntityId vehicleId);
+	EntityId              GetVehicle(unsigned int uiIndex);
+	bool                  IsFinished();
+	void                  Process();
+};
+
+extern CBotManager * g_pBotManager;
@@ -0,0 +1,85 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBotPacketHandler.cpp
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CBotPacketHandler.h"
+#include "CBotManager.h"
+#include <Network/PacketIdentifiers.h>
+
+extern CBotManager * g_pBotManager;
+
+void CBotPacketHandler::ConnectionRejected(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("connection rejected");
+}
+
+void CBotPacketHandler::ConnectionSucceeded(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnConnected();
+}
+
+void CBotPacketHandler::ConnectionFailed(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("connection timed out");
+}
+
+void CBotPacketHandler::AlreadyConnected(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("already connected");
+}
+
+void CBotPacketHandler::ServerFull(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("server full");
+}
+
+void CBotPacketHandler::Disconnected(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("disconnected");
+}
+
+void CBotPacketHandler::LostConnection(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("lost connection");
+}
+
+void CBotPacketHandler::Banned(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("banned");
+}
+
+void CBotPacketHandler::PasswordInvalid(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	g_pBotManager->GetProcessingBot()->OnFailed("invalid password");
+}
+
+void CBotPacketHandler::Register()
+{
+	AddFunction(PACKET_CONNECTION_REJECTED, ConnectionRejected);
+	AddFunction(PACKET_CONNECTION_SUCCEEDED, ConnectionSucceeded);
+	AddFunction(PACKET_CONNECTION_FAILED, ConnectionFailed);
+	AddFunction(PACKET_ALREADY_CONNECTED, AlreadyConnected);
+	AddFunction(PACKET_SERVER_FULL, ServerFull);
+	AddFunction(PACKET_DISCONNECTED, Disconnected);
+	AddFunction(PACKET_LOST_CONNECTION, LostConnection);
+	AddFunction(PACKET_BANNED, Banned);
+	AddFunction(PACKET_PASSWORD_INVALID, PasswordInvalid);
+}
+
+void CBotPacketHandler::Unregister()
+{
+	RemoveFunction(PACKET_CONNECTION_REJECTED);
+	RemoveFunction(PACKET_CONNECTION_SUCCEEDED);
+	RemoveFunction(PACKET_CONNECTION_FAILED);
+	RemoveFunction(PACKET_ALREADY_CONNECTED);
+	RemoveFunction(PACKET_SERVER_FULL);
+	RemoveFunction(PACKET_DISCONNECTED);
+	RemoveFunction(PACKET_LOST_CONNECTION);
+	RemoveFunction(PACKET_BANNED);
+	RemoveFunction(PACKET_PASSWORD_INVALID);
+}
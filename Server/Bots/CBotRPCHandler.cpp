@@ -0,0 +1,85 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBotRPCHandler.cpp
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CBotRPCHandler.h"
+#include "CBotManager.h"
+
+extern CBotManager * g_pBotManager;
+
+void CBotRPCHandler::JoinedGame(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	// The rest of the rpc is the server and world state which bots don't need
+	EntityId playerId;
+
+	if(!pBitStream->Read(playerId))
+		return;
+
+	g_pBotManager->GetProcessingBot()->OnJoined(playerId);
+}
+
+void CBotRPCHandler::ConnectionRefused(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	int iReason = -1;
+	pBitStream->Read(iReason);
+	g_pBotManager->GetProcessingBot()->OnFailed(String("connection refused (reason %d)", iReason).Get());
+}
+
+void CBotRPCHandler::NewVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	// Vehicles are packed when streamed on join but all bots get the same
+	// vehicles so the first one of each rpc is enough
+	EntityId vehicleId;
+
+	if(!pBitStream->ReadCompressed(vehicleId))
+		return;
+
+	g_pBotManager->AddVehicle(vehicleId);
+}
+
+void CBotRPCHandler::DeleteVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId vehicleId;
+
+	if(!pBitStream->ReadCompressed(vehicleId))
+		return;
+
+	g_pBotManager->RemoveVehicle(vehicleId);
+}
+
+void CBotRPCHandler::Register()
+{
+	AddFunction(RPC_JoinedGame, JoinedGame);
+	AddFunction(RPC_ConnectionRefused, ConnectionRefused);
+	AddFunction(RPC_NewVehicle, NewVehicle);
+	AddFunction(RPC_DeleteVehicle, DeleteVehicle);
+}
+
+void CBotRPCHandler::Unregister()
+{
+	RemoveFunction(RPC_JoinedGame);
+	RemoveFunction(RPC_ConnectionRefused);
+	RemoveFunction(RPC_NewVehicle);
+	RemoveFunction(RPC_DeleteVehicle);
+}
@@ -0,0 +1,25 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBotRPCHandler.h
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <Network/CRPCHandler.h>
+
+class CBotRPCHandler : public CRPCHandler
+{
+private:
+	static void JoinedGame(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void ConnectionRefused(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void NewVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void DeleteVehicle(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+
+public:
+	void        Register();
+	void        Unregister();
+};
@@ -0,0 +1,189 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: Main.cpp
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <algorithm>
+#include "Main.h"
+#include "CBotManager.h"
+#include <Network/CNetworkModule.h>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+// Time in ms the main loop sleeps between two bot manager updates
+#define BOT_PROCESS_INTERVAL 5
+
+extern CBotManager * g_pBotManager;
+
+bool g_bRunning = true;
+
+void SignalHandler(int iSignal)
+{
+	g_bRunning = false;
+}
+
+void PrintUsage()
+{
+	CLogFile::Print("Usage: ivmp-bots [options]");
+	CLogFile::Print("  -host <address>        Server address (default 127.0.0.1)");
+	CLogFile::Print("  -port <port>           Server port (default 9999)");
+	CLogFile::Print("  -password <password>   Server password");
+	CLogFile::Print("  -bots <count>          Amount of bots (default 10)");
+	CLogFile::Print("  -name <prefix>         Name prefix of the bots (default Bot)");
+	CLogFile::Print("  -joininterval <ms>     Time between two bots connecting (default 100)");
+	CLogFile::Print("  -syncinterval <ms>     Time between two sync packets of a bot (default 100)");
+	CLogFile::Print("  -chatinterval <ms>     Time between two chat messages of a bot, 0 disables chat (default 30000)");
+	CLogFile::Print("  -drivers <percent>     Bots that drive the vehicles of the server (default 25)");
+	CLogFile::Print("  -speed <units>         Walking speed in units per second (default 5)");
+	CLogFile::Print("  -path <file>           File with a waypoint (x y z) per line the bots walk along");
+	CLogFile::Print("  -report <ms>           Time between two reports (default 5000)");
+	CLogFile::Print("  -csv <file>            File the reports are also written to as csv");
+	CLogFile::Print("  -duration <seconds>    Time after which the bots stop, 0 runs until stopped (default 0)");
+}
+
+bool LoadPath(String strPath, std::vector<CVector3> * pPath)
+{
+	FILE * pFile = fopen(strPath.Get(), "r");
+
+	if(!pFile)
+		return false;
+
+	char szLine[256];
+
+	while(fgets(szLine, sizeof(szLine), pFile))
+	{
+		CVector3 vecWaypoint;
+
+		if(sscanf(szLine, "%f %f %f", &vecWaypoint.fX, &vecWaypoint.fY, &vecWaypoint.fZ) == 3)
+			pPath->push_back(vecWaypoint);
+	}
+
+	fclose(pFile);
+	return !pPath->empty();
+}
+
+int main(int argc, char ** argv)
+{
+	// Open the log file
+	CLogFile::Open("ivmp-bots.log", true);
+
+	BotSettings settings;
+	settings.strHost = "127.0.0.1";
+	settings.usPort = 9999;
+	settings.strName = "Bot";
+	settings.uiBots = 10;
+	settings.uiJoinInterval = 100;
+	settings.uiSyncInterval = 100;
+	settings.uiChatInterval = 30000;
+	settings.uiDrivers = 25;
+	settings.fSpeed = 5.0f;
+	settings.uiReportInterval = 5000;
+	settings.uiDuration = 0;
+	String strPath;
+
+	// Parse the command line
+	for(int i = 1; i < argc; i++)
+	{
+		String strOption = argv[i];
+
+		if(strOption == "-help" || strOption == "-h" || (i + 1) >= argc)
+		{
+			PrintUsage();
+			return 0;
+		}
+
+		String strValue = argv[++i];
+
+		if(strOption == "-host")
+			settings.strHost = strValue;
+		else if(strOption == "-port")
+			settings.usPort = (unsigned short)strValue.ToInteger();
+		else if(strOption == "-password")
+			settings.strPassword = strValue;
+		else if(strOption == "-bots")
+			settings.uiBots = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-name")
+			settings.strName = strValue;
+		else if(strOption == "-joininterval")
+			settings.uiJoinInterval = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-syncinterval")
+			settings.uiSyncInterval = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-chatinterval")
+			settings.uiChatInterval = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-drivers")
+			settings.uiDrivers = std::min((unsigned int)strValue.ToInteger(), (unsigned int)100);
+		else if(strOption == "-speed")
+			settings.fSpeed = strValue.ToFloat();
+		else if(strOption == "-path")
+			strPath = strValue;
+		else if(strOption == "-report")
+			settings.uiReportInterval = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-csv")
+			settings.strReportFile = strValue;
+		else if(strOption == "-duration")
+			settings.uiDuration = (unsigned int)strValue.ToInteger();
+		else
+		{
+			CLogFile::Printf("Unknown option %s.", strOption.Get());
+			PrintUsage();
+			return 0;
+		}
+	}
+
+	// The names have to fit in the name limit of the server
+	if(String("%s%d", settings.strName.Get(), settings.uiBots).GetLength() > MAX_NAME_LENGTH)
+	{
+		CLogFile::Printf("The bot names can be at most %d characters long.", MAX_NAME_LENGTH);
+		return 1;
+	}
+
+	if(strPath.IsNotEmpty())
+	{
+		if(!LoadPath(strPath, &settings.path))
+		{
+			CLogFile::Printf("Failed to load the path from %s.", strPath.Get());
+			return 1;
+		}
+	}
+	else
+	{
+		// Walk in a square around the default spawn
+		settings.path.push_back(CVector3(-341.36f, 1144.80f, 14.79f));
+		settings.path.push_back(CVector3(-291.36f, 1144.80f, 14.79f));
+		settings.path.push_back(CVector3(-291.36f, 1194.80f, 14.79f));
+		settings.path.push_back(CVector3(-341.36f, 1194.80f, 14.79f));
+	}
+
+	// Load the network module
+	if(!CNetworkModule::Init())
+	{
+		CLogFile::Print("Failed to load the network module.");
+		return 1;
+	}
+
+	srand((unsigned int)time(NULL));
+	signal(SIGINT, SignalHandler);
+	signal(SIGTERM, SignalHandler);
+	CLogFile::Printf("Starting %d bot(s) against %s:%d.", settings.uiBots, settings.strHost.Get(), settings.usPort);
+	g_pBotManager = new CBotManager(settings);
+
+	while(g_bRunning && !g_pBotManager->IsFinished())
+	{
+		g_pBotManager->Process();
+		Sleep(BOT_PROCESS_INTERVAL);
+	}
+
+	CLogFile::Print("Stopping the bots.");
+	SAFE_DELETE(g_pBotManager);
+	CNetworkModule::Shutdown();
+	CLogFile::Close();
+	return 0;
+}
@@ -0,0 +1,17 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: Main.h
+// Project: Server.Bots
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#ifndef WIN32
+#include <string.h>
+#include <unistd.h>
+
+#define Sleep(ms) usleep((ms) * 1000)
+#endif
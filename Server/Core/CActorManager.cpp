@@ -14,87 +14,77 @@
 #include "CModuleManager.h"
 #include "CVehicle.h"
 #include "CVehicleManager.h"
+#include "CPlayerManager.h"
+#include "CEntityStreamer.h"
+#include <math.h>
+#include <SharedUtility.h>
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CEvents * g_pEvents;
 extern CModuleManager * g_pModuleManager;
 extern CVehicleManager * g_pVehicleManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CEntityStreamer * g_pEntityStreamer;
 
 CActorManager::CActorManager()
+	: m_ulLastCorrectionTime(0)
 {
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CActorManager));
+
 	for(EntityId x = 0; x < MAX_ACTORS; x++)
-	{
-		m_bActive[x] = false;
 		m_Actors[x].bDrivingAutomatic = false;
-	}
 }
 
 CActorManager::~CActorManager()
 {
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CActorManager));
+
 	for(EntityId x = 0; x < MAX_ACTORS; x++)
-	{
-		if(m_bActive[x])
+		if(m_ids.IsUsed(x))
 			Delete(x);
-
-		m_bActive[x] = false;
-	}
 }
 
 EntityId CActorManager::Create(int iModelId, CVector3 vecPosition, float fHeading)
 {
-	for(EntityId x = 0; x < MAX_ACTORS; x++)
+	EntityId x = m_ids.Allocate();
+
+	if(x == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
+
+	m_Actors[x].strName = "Actor";
+	m_Actors[x].bTogglename = false;
+	m_Actors[x].iColor = 0xFFFFFFAA;
+	m_Actors[x].bFrozen = false;
+	m_Actors[x].bHelmet = false;
+	m_Actors[x].bBlip = true;
+	m_Actors[x].bDrivingAutomatic = false;
+	m_Actors[x].vecDrivePos = CVector3();
+	m_Actors[x].vecDriveFinalPos = CVector3();
+	m_Actors[x].vehicleId = -1;
+	m_Actors[x].iSeat = -1;
+	m_Actors[x].iModelId = iModelId;
+	memcpy(&m_Actors[x].vecPosition, &vecPosition, sizeof(CVector3));
+	m_Actors[x].fHeading = fHeading;
+
+	// If the server streams actors the players get it when they come in range
+	if(!g_pEntityStreamer->IsEnabled())
 	{
-		if(!m_bActive[x])
-		{
-			m_Actors[x].strName = "Actor";
-			m_Actors[x].bTogglename = false;
-			m_Actors[x].iColor = 0xFFFFFFAA;
-			m_Actors[x].bFrozen = false;
-			m_Actors[x].bHelmet = false;
-			m_Actors[x].bBlip = true;
-			m_Actors[x].bDrivingAutomatic = false;
-			m_Actors[x].vecDrivePos = CVector3();
-			m_Actors[x].vecDriveFinalPos = CVector3();
-			m_Actors[x].vehicleId = -1;
-			m_Actors[x].iSeat = -1;
-
-			CBitStream bsSend;
-			bsSend.Write(x);
-			bsSend.Write(iModelId);
-			bsSend.Write(vecPosition);
-			bsSend.Write(fHeading);
-			bsSend.Write(m_Actors[x].strName);
-			bsSend.Write(m_Actors[x].bTogglename);
-			bsSend.Write(m_Actors[x].iColor);
-			bsSend.Write(m_Actors[x].bFrozen);
-			bsSend.Write(m_Actors[x].bHelmet);
-			bsSend.Write(m_Actors[x].bBlip);
-			bsSend.Write(m_Actors[x].bDrivingAutomatic);
-			bsSend.Write(m_Actors[x].vecDrivePos);
-			bsSend.Write(m_Actors[x].vecDriveRot);
-			bsSend.Write(m_Actors[x].vecDriveFinalPos);
-			bsSend.Write(m_Actors[x].vehicleId);
-			bsSend.Write(m_Actors[x].iSeat);
-
-			g_pNetworkManager->RPC(RPC_NewActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-			m_Actors[x].iModelId = iModelId;
-			memcpy(&m_Actors[x].vecPosition, &vecPosition, sizeof(CVector3));
-			m_Actors[x].fHeading = fHeading;
-			m_bActive[x] = true;
-			CSquirrelArguments pArguments;
-			pArguments.push(x);
-			g_pEvents->Call("actorCreate", &pArguments);
-
-			return x;
-		}
+		CBitStream bsSend;
+		SerializeSpawn(x, &bsSend);
+		g_pNetworkManager->RPC(RPC_NewActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 	}
 
-	return INVALID_ENTITY_ID;
+	CSquirrelArguments pArguments;
+	pArguments.push(x);
+	g_pEvents->Call("actorCreate", &pArguments);
+
+	return x;
 }
 
 void CActorManager::Delete(EntityId actorId)
 {
-	if(!m_bActive[actorId])
+	if(!m_ids.IsUsed(actorId))
 		return;
 
 	CSquirrelArguments pArguments;
@@ -104,17 +94,25 @@ void CActorManager::Delete(EntityId actorId)
 	//TODO remove the player
 	//if(m_Actors[actorId].bDrivingAutomatic)
 		
+	if(g_pEntityStreamer->IsEnabled())
+		g_pEntityStreamer->RemoveEntity(ENTITY_STREAMER_ACTOR, actorId);
+	else
+	{
+		CBitStream bsSend;
+		bsSend.Write(actorId);
+		g_pNetworkManager->RPC(RPC_DeleteActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	}
 
-	CBitStream bsSend;
-	bsSend.Write(actorId);
-	g_pNetworkManager->RPC(RPC_DeleteActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-	m_bActive[actorId] = false;
+	m_paths.erase(actorId);
+	m_ids.Free(actorId);
 }
 
 void CActorManager::SetPosition(EntityId actorId, CVector3 vecPosition)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
+		// The clients stop the path when they get the position
+		m_paths.erase(actorId);
 		memcpy(&m_Actors[actorId].vecPosition, &vecPosition, sizeof(CVector3));
 		CBitStream bsSend;
 		bsSend.Write(actorId);
@@ -125,7 +123,7 @@ void CActorManager::SetPosition(EntityId actorId, CVector3 vecPosition)
 
 void CActorManager::SetColor(EntityId actorId, unsigned int iColor)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
 		m_Actors[actorId].iColor = iColor;
 		CBitStream bsSend;
@@ -137,7 +135,7 @@ void CActorManager::SetColor(EntityId actorId, unsigned int iColor)
 
 CVector3 CActorManager::GetPosition(EntityId actorId)
 {	
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 		return m_Actors[actorId].vecPosition;
 
 	return CVector3(0.0f, 0.0f, 0.0f);
@@ -145,7 +143,7 @@ CVector3 CActorManager::GetPosition(EntityId actorId)
 
 void CActorManager::SetHeading(EntityId actorId, float fHeading)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
 		m_Actors[actorId].fHeading = fHeading;
 		CBitStream bsSend;
@@ -157,7 +155,7 @@ void CActorManager::SetHeading(EntityId actorId, float fHeading)
 
 void CActorManager::SetActorName(EntityId actorId, String strName)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
 		//Check if we have an valid Name
 		if(strName.GetLength() > 2)
@@ -175,62 +173,130 @@ void CActorManager::SetActorName(EntityId actorId, String strName)
 
 String CActorManager::GetActorName(EntityId actorId)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 		return m_Actors[actorId].strName;
 	
 	return false;
 }
 
-void CActorManager::HandleClientJoin(EntityId playerId)
+void CActorManager::SerializeSpawn(EntityId actorId, CBitStream * pBitStream)
 {
-	if(GetActorCount() > 0)
+	pBitStream->Write(actorId);
+	pBitStream->Write(m_Actors[actorId].iModelId);
+	pBitStream->Write(m_Actors[actorId].vecPosition);
+	pBitStream->Write(m_Actors[actorId].fHeading);
+	pBitStream->Write(m_Actors[actorId].strName);
+	pBitStream->Write(m_Actors[actorId].bTogglename);
+	pBitStream->Write(m_Actors[actorId].iColor);
+	pBitStream->Write(m_Actors[actorId].bFrozen);
+	pBitStream->Write(m_Actors[actorId].bHelmet);
+	pBitStream->Write(m_Actors[actorId].bBlip);
+	pBitStream->Write(m_Actors[actorId].bDrivingAutomatic);
+	pBitStream->Write(m_Actors[actorId].vecDrivePos);
+	pBitStream->Write(m_Actors[actorId].vecDriveRot);
+	pBitStream->Write(m_Actors[actorId].vecDriveFinalPos);
+	pBitStream->Write(m_Actors[actorId].vehicleId);
+	pBitStream->Write(m_Actors[actorId].iSeat);
+
+	// Players the actor spawns for later start in the middle of the path
+	std::map<EntityId, CMoveTimeline>::iterator iter = m_paths.find(actorId);
+
+	if(iter == m_paths.end())
+		pBitStream->Write0();
+	else
 	{
-		CBitStream bsSend;
+		pBitStream->Write1();
+		(*iter).second.Serialize(pBitStream, SharedUtility::GetTime());
+	}
+}
+
+void CActorManager::SendDriveToCoordinates(EntityId actorId, EntityId playerId)
+{
+	if(!m_Actors[actorId].bDrivingAutomatic)
+		return;
+
+	CBitStream bsSend;
+	bsSend.Write(actorId);
+	bsSend.Write(m_Actors[actorId].vecDriveFinalPos);
+	g_pNetworkManager->RPC(RPC_ScriptingActorDriveToCoords, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+bool CActorManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
+{
+	// Pack as many actors as fit in a single message
+	CBitStream bsSend;
+	EntityId x = pCursor->entityId;
 
-		for(EntityId x = 0; x < MAX_ACTORS; x++)
+	for(; x < MAX_ACTORS && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; x++)
+	{
+		if(m_ids.IsUsed(x))
 		{
-			if(m_bActive[x])
-			{
-				bsSend.Write(x);
-				bsSend.Write(m_Actors[x].iModelId);
-				bsSend.Write(m_Actors[x].vecPosition);
-				bsSend.Write(m_Actors[x].fHeading);
-				bsSend.Write(m_Actors[x].strName);
-				bsSend.Write(m_Actors[x].bTogglename);
-				bsSend.Write(m_Actors[x].iColor);
-				bsSend.Write(m_Actors[x].bFrozen);
-				bsSend.Write(m_Actors[x].bHelmet);
-				bsSend.Write(m_Actors[x].bBlip);
-				bsSend.Write(m_Actors[x].bDrivingAutomatic);
-				bsSend.Write(m_Actors[x].vecDrivePos);
-				bsSend.Write(m_Actors[x].vecDriveRot);
-				bsSend.Write(m_Actors[x].vecDriveFinalPos);
-				bsSend.Write(m_Actors[x].vehicleId);
-				bsSend.Write(m_Actors[x].iSeat);
-			}
+			SerializeSpawn(x, &bsSend);
+			pCursor->uiEntities++;
 		}
+	}
+
+	if(pCursor->uiEntities > 0)
+	{
 		g_pNetworkManager->RPC(RPC_NewActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 
-		for(EntityId x = 0; x < MAX_ACTORS; x++)
+		for(EntityId y = pCursor->entityId; y < x; y++)
 		{
-			if(m_bActive[x] && m_Actors[x].bDrivingAutomatic)
-			{
-				bsSend.Reset();
+			if(m_ids.IsUsed(y))
+				SendDriveToCoordinates(y, playerId);
+		}
+	}
 
-				bsSend.Write(x);
-				bsSend.Write(m_Actors[x].vecDriveFinalPos);
-				g_pNetworkManager->RPC(RPC_ScriptingActorDriveToCoords, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-			}
+	pCursor->uiBytes = bsSend.GetNumberOfBytesUsed();
+	pCursor->entityId = x;
+	return (x >= MAX_ACTORS);
+}
+
+void CActorManager::SpawnForPlayer(EntityId playerId, const std::list<EntityId>& actorList)
+{
+	// Pack the actors into as few messages as possible
+	CBitStream bsSend;
+	std::list<EntityId>::const_iterator iter = actorList.begin();
+
+	while(iter != actorList.end())
+	{
+		bsSend.Reset();
+
+		for(; iter != actorList.end() && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; iter++)
+		{
+			if(DoesExist(*iter))
+				SerializeSpawn(*iter, &bsSend);
 		}
+
+		if(bsSend.GetNumberOfBytesUsed() > 0)
+			g_pNetworkManager->RPC(RPC_NewActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+	}
+
+	for(iter = actorList.begin(); iter != actorList.end(); iter++)
+	{
+		if(DoesExist(*iter))
+			SendDriveToCoordinates(*iter, playerId);
 	}
 }
 
+void CActorManager::DeleteForPlayer(EntityId actorId, EntityId playerId)
+{
+	CBitStream bsSend;
+	bsSend.Write(actorId);
+	g_pNetworkManager->RPC(RPC_DeleteActor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+bool CActorManager::IsSpawnedForPlayer(EntityId actorId, EntityId playerId)
+{
+	return (!g_pEntityStreamer->IsEnabled() || g_pEntityStreamer->IsStreamedIn(playerId, ENTITY_STREAMER_ACTOR, actorId));
+}
+
 bool CActorManager::DoesExist(EntityId actorId)
 {
 	if(actorId < 0 || actorId >= MAX_ACTORS)
 		return false;
 
-	return m_bActive[actorId];
+	return m_ids.IsUsed(actorId);
 }
 
 bool CActorManager::ToggleNametag(EntityId actorId, bool bShow)
@@ -278,7 +344,7 @@ bool CActorManager::ToggleHelmet(EntityId actorId, bool bHelmet)
 
 void CActorManager::WarpIntoVehicle(EntityId actorId, EntityId vehicleId, int iSeatid)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
 		// Check if we have a valid vehicle
 		if(!g_pVehicleManager->DoesExist(vehicleId))
@@ -302,7 +368,7 @@ void CActorManager::WarpIntoVehicle(EntityId actorId, EntityId vehicleId, int iS
 
 void CActorManager::RemoveFromVehicle(EntityId actorId)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
 		//Check if he is in a car
 		if(m_Actors[actorId].bStateincar)
@@ -329,7 +395,7 @@ bool CActorManager::DriveToCoordinates(EntityId actorId, CVector3 vecDriveTo, CV
 
 bool CActorManager::UpdateDrivePos(EntityId actorId, CVector3 vecDrivePos,CVector3 vecDriveRot, bool bStop)
 {
-	if(m_bActive[actorId])
+	if(m_ids.IsUsed(actorId))
 	{
 		if(!bStop)
 		{
@@ -364,9 +430,132 @@ EntityId CActorManager::GetActorCount()
 
 	for(EntityId x = 0; x < MAX_ACTORS; x++)
 	{
-		if(m_bActive[x])
+		if(m_ids.IsUsed(x))
 			actorCount++;
 	}
 
 	return actorCount;
+}
+
+void CActorManager::SendPath(EntityId actorId, const CMoveTimeline& path)
+{
+	CBitStream bsSend;
+	bsSend.Write(actorId);
+	path.Serialize(&bsSend, SharedUtility::GetTime());
+
+	if(!g_pEntityStreamer->IsEnabled())
+	{
+		g_pNetworkManager->RPC(RPC_ScriptingSetActorPath, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		return;
+	}
+
+	// Only the players that have the actor get its path, the rest get it when it spawns for them
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(IsSpawnedForPlayer(actorId, players[i]))
+			g_pNetworkManager->RPC(RPC_ScriptingSetActorPath, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, players[i], false);
+	}
+}
+
+bool CActorManager::SetPath(EntityId actorId, const CMoveTimeline& path)
+{
+	if(!DoesExist(actorId) || path.IsEmpty())
+		return false;
+
+	CMoveTimeline& actorPath = m_paths[actorId];
+	actorPath = path;
+	actorPath.SetStartTime(SharedUtility::GetTime());
+	SendPath(actorId, actorPath);
+	return true;
+}
+
+bool CActorManager::StopPath(EntityId actorId)
+{
+	std::map<EntityId, CMoveTimeline>::iterator iter = m_paths.find(actorId);
+
+	if(iter == m_paths.end())
+		return false;
+
+	// The clients stop the path when they get the position it stopped at
+	m_paths.erase(iter);
+	SetPosition(actorId, m_Actors[actorId].vecPosition);
+	return true;
+}
+
+bool CActorManager::HasPath(EntityId actorId)
+{
+	return (m_paths.find(actorId) != m_paths.end());
+}
+
+void CActorManager::SendPathCorrections()
+{
+	// The clients evaluate the paths on their own clock, this keeps them at
+	// the time the server is at
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+	unsigned long ulTime = SharedUtility::GetTime();
+	CBitStream bsSend;
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		bsSend.Reset();
+
+		for(std::map<EntityId, CMoveTimeline>::iterator iter = m_paths.begin(); iter != m_paths.end(); ++iter)
+		{
+			if(!IsSpawnedForPlayer((*iter).first, players[i]))
+				continue;
+
+			bsSend.Write((*iter).first);
+			bsSend.WriteCompressed((unsigned int)(ulTime - (*iter).second.GetStartTime()));
+		}
+
+		if(bsSend.GetNumberOfBytesUsed() > 0)
+			g_pNetworkManager->RPC(RPC_ActorPathCorrection, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, players[i], false);
+	}
+}
+
+void CActorManager::Process()
+{
+	if(m_paths.empty())
+		return;
+
+	unsigned long ulTime = SharedUtility::GetTime();
+	std::map<EntityId, CMoveTimeline>::iterator iter = m_paths.begin();
+
+	while(iter != m_paths.end())
+	{
+		EntityId actorId = (*iter).first;
+		CVector3 vecPosition, vecAhead;
+		CVector3 vecRotation;
+		(*iter).second.Evaluate(ulTime, vecPosition, vecRotation);
+		(*iter).second.Evaluate((ulTime + ACTOR_PATH_HEADING_TIME), vecAhead, vecRotation);
+
+		// Actors face the way they move and keep their heading once they stop
+		CVector3 vecMove = (vecAhead - vecPosition);
+
+		if((vecMove.fX * vecMove.fX + vecMove.fY * vecMove.fY) > 0.0001f)
+			m_Actors[actorId].fHeading = (float)(atan2(-vecMove.fX, vecMove.fY) * 180.0f / PI);
+
+		m_Actors[actorId].vecPosition = vecPosition;
+
+		if((*iter).second.IsFinished(ulTime))
+		{
+			// The clients finish the path on their own
+			m_paths.erase(iter++);
+
+			CSquirrelArguments pArguments;
+			pArguments.push(actorId);
+			g_pEvents->Call("actorPathFinished", &pArguments);
+			continue;
+		}
+
+		++iter;
+	}
+
+	if((ulTime - m_ulLastCorrectionTime) >= ACTOR_PATH_CORRECTION_INTERVAL)
+	{
+		m_ulLastCorrectionTime = ulTime;
+		SendPathCorrections();
+	}
 }
\ No newline at end of file
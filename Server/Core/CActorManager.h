@@ -12,6 +12,17 @@
 
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
+#include "CJoinStreamer.h"
+#include "CEntityIdAllocator.h"
+#include <map>
+#include <list>
+#include <Game/CMoveTimeline.h>
+
+// Interval in ms at which the players get the time of the paths of the actors they have
+#define ACTOR_PATH_CORRECTION_INTERVAL 1000
+
+// Time in ms ahead on the path that the heading of an actor is taken from
+#define ACTOR_PATH_HEADING_TIME 100
 
 struct _Actor
 {
@@ -37,9 +48,20 @@ struct _Actor
 class CActorManager : public CActorManagerInterface
 {
 private:
-	bool m_bActive[MAX_ACTORS];
+	CEntityIdAllocator<MAX_ACTORS> m_ids;
 	_Actor m_Actors[MAX_ACTORS];
 
+	// The server moves these actors along their paths and the clients evaluate the
+	// same paths, so no client has to control them
+	std::map<EntityId, CMoveTimeline> m_paths;
+	unsigned long m_ulLastCorrectionTime;
+
+	void		SerializeSpawn(EntityId actorId, CBitStream * pBitStream);
+	void		SendDriveToCoordinates(EntityId actorId, EntityId playerId);
+	bool		IsSpawnedForPlayer(EntityId actorId, EntityId playerId);
+	void		SendPath(EntityId actorId, const CMoveTimeline& path);
+	void		SendPathCorrections();
+
 public:
 	CActorManager();
 	~CActorManager();
@@ -51,7 +73,9 @@ public:
 	void		SetHeading(EntityId actorId, float fHeading);
 	float		GetHeading(EntityId actorId) { return m_Actors[actorId].fHeading; }
 	int			GetModel(EntityId actorId) { return m_Actors[actorId].iModelId; }
-	void		HandleClientJoin(EntityId playerId);
+	bool		HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
+	void		SpawnForPlayer(EntityId playerId, const std::list<EntityId>& actorList);
+	void		DeleteForPlayer(EntityId actorId, EntityId playerId);
 	void		SetActorName(EntityId actorId, String strName);
 	String		GetActorName(EntityId actorId);
 	void		SetColor(EntityId actorId, unsigned int iColor);
@@ -67,4 +91,13 @@ public:
 	bool		UpdateDrivePos(EntityId actorId, CVector3 vecDrivePos, CVector3 vecDriveRot, bool bStopDriving);
 	EntityId	GetVehicle(EntityId actorId) { return m_Actors[actorId].vehicleId; }
 	EntityId	GetActorCount();
+
+	// The keyframe rotations of a path are ignored, actors face the way they walk.
+	// Setting the position of an actor stops its path.
+	bool		SetPath(EntityId actorId, const CMoveTimeline& path);
+	bool		StopPath(EntityId actorId);
+	bool		HasPath(EntityId actorId);
+
+	// Moves the actors along their paths and sends the corrections
+	void		Process();
 };
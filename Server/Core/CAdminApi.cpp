@@ -0,0 +1,243 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CAdminApi.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CAdminApi.h"
+#include <mongoose/mongoose.h>
+#include <CSettings.h>
+#include <CLogFile.h>
+#include <SharedUtility.h>
+#include "CPlayerManager.h"
+#include "CBanManager.h"
+#include "CTickScheduler.h"
+#include "Scripting/CScriptingManager.h"
+
+extern CPlayerManager * g_pPlayerManager;
+extern CBanManager * g_pBanManager;
+extern CTickScheduler * g_pTickScheduler;
+extern CScriptingManager * g_pScriptingManager;
+extern unsigned long g_ulStartTick;
+void SendConsoleInput(String strInput);
+
+// The log output of the console input that is run for an admin request
+static String * g_pConsoleOutput = NULL;
+
+CAdminApi::CAdminApi()
+{
+	// The token is copied once so the webserver threads never read the settings
+	m_strToken = CVAR_GET_STRING("admintoken");
+}
+
+bool CAdminApi::IsAuthorized(const char * szAuthorization)
+{
+	if(!IsEnabled() || !szAuthorization || strncmp(szAuthorization, "Bearer ", 7))
+		return false;
+
+	// Compare all characters so the time doesn't tell how much of the token was right
+	const char * szToken = (szAuthorization + 7);
+	size_t sLength = strlen(szToken);
+	unsigned char ucDifference = (unsigned char)(sLength != m_strToken.GetLength());
+
+	for(size_t i = 0; i < m_strToken.GetLength(); i++)
+		ucDifference |= (unsigned char)(m_strToken[i] ^ ((i < sLength) ? szToken[i] : 0));
+
+	return (ucDifference == 0);
+}
+
+void CAdminApi::LogCallback(const char * szBuffer)
+{
+	if(g_pConsoleOutput)
+		g_pConsoleOutput->AppendF("%s\n", szBuffer);
+}
+
+String CAdminApi::EscapeJSON(const String& strString)
+{
+	String strEscaped;
+
+	for(size_t i = 0; i < strString.GetLength(); i++)
+	{
+		unsigned char ucChar = strString[i];
+
+		if(ucChar == '"' || ucChar == '\\')
+			strEscaped.AppendF("\\%c", ucChar);
+		else if(ucChar == '\n')
+			strEscaped.Append("\\n");
+		else if(ucChar < 0x20)
+			strEscaped.AppendF("\\u%04x", ucChar);
+		else
+			strEscaped += ucChar;
+	}
+
+	return strEscaped;
+}
+
+String CAdminApi::GetParameter(const String& strName, const String& strQuery, const String& strBody)
+{
+	// Parameters come from the query or a form encoded body
+	char szValue[ADMIN_API_MAX_PARAMETER_LENGTH];
+
+	if(mg_get_var(strQuery.Get(), strQuery.GetLength(), strName.Get(), szValue, sizeof(szValue)) >= 0 ||
+		mg_get_var(strBody.Get(), strBody.GetLength(), strName.Get(), szValue, sizeof(szValue)) >= 0)
+		return szValue;
+
+	return "";
+}
+
+String CAdminApi::GetStats()
+{
+	const TickSchedulerStats * pStats = g_pTickScheduler->GetStats();
+	return String("{\"hostname\": \"%s\", \"players\": %d, \"maxplayers\": %d, \"scripts\": %d, \"uptime\": %lu, \"tickrate\": %d, \"ticks\": %lu, \"overruns\": %lu, \"skippedticks\": %lu}",
+		EscapeJSON(CVAR_GET_STRING("hostname")).Get(), g_pPlayerManager->GetPlayerCount(), CVAR_GET_INTEGER("maxplayers"), (int)g_pScriptingManager->GetScriptList()->size(),
+		((SharedUtility::GetTime() - g_ulStartTick) / 1000), pStats->uiTickRate, pStats->ulTicks, pStats->ulOverruns, pStats->ulSkippedTicks);
+}
+
+String CAdminApi::GetPlayers()
+{
+	String strJSON("[");
+	bool bFirst = true;
+
+	for(EntityId i = 0; i < g_pPlayerManager->GetMaxPlayers(); i++)
+	{
+		CPlayer * pPlayer = g_pPlayerManager->GetAt(i);
+
+		if(!pPlayer)
+			continue;
+
+		strJSON.AppendF("%s{\"id\": %d, \"name\": \"%s\", \"ip\": \"%s\", \"serial\": \"%s\", \"ping\": %d, \"relay\": %s}", (bFirst ? "" : ", "), i,
+			EscapeJSON(pPlayer->GetName()).Get(), pPlayer->GetIp().Get(), EscapeJSON(pPlayer->GetSerial()).Get(), pPlayer->GetPing(), (pPlayer->IsRelay() ? "true" : "false"));
+		bFirst = false;
+	}
+
+	strJSON.Append("]");
+	return strJSON;
+}
+
+String CAdminApi::GetConfig()
+{
+	String strJSON("{");
+	std::map<String, SettingsValue *> * pValues = CSettings::GetValues();
+
+	for(std::map<String, SettingsValue *>::iterator iter = pValues->begin(); iter != pValues->end(); iter++)
+	{
+		strJSON.AppendF("%s\"%s\": ", ((iter == pValues->begin()) ? "" : ", "), EscapeJSON(iter->first).Get());
+
+		// Don't hand out the secrets of the server
+		if(iter->first.Find("password") != String::nPos || iter->first.Find("secret") != String::nPos || iter->first.Find("token") != String::nPos)
+			strJSON.Append("null");
+		else if(iter->second->IsString())
+			strJSON.AppendF("\"%s\"", EscapeJSON(iter->second->strValue).Get());
+		else if(iter->second->IsList())
+		{
+			strJSON.Append("[");
+
+			for(std::list<String>::iterator listIter = iter->second->listValue.begin(); listIter != iter->second->listValue.end(); listIter++)
+				strJSON.AppendF("%s\"%s\"", ((listIter == iter->second->listValue.begin()) ? "" : ", "), EscapeJSON(*listIter).Get());
+
+			strJSON.Append("]");
+		}
+		else
+			strJSON.Append(CVAR_GET_EX(iter->first));
+	}
+
+	strJSON.Append("}");
+	return strJSON;
+}
+
+String CAdminApi::RunConsoleInput(const String& strInput)
+{
+	// Collect what the command prints
+	String strOutput;
+	bool bUseCallback = CLogFile::GetUseCallback();
+	LogFileCallback_t pfnCallback = CLogFile::GetCallback();
+	g_pConsoleOutput = &strOutput;
+	CLogFile::SetCallback(LogCallback);
+	CLogFile::SetUseCallback(true);
+	SendConsoleInput(strInput);
+	CLogFile::SetUseCallback(bUseCallback);
+	CLogFile::SetCallback(pfnCallback);
+	g_pConsoleOutput = NULL;
+	return String("{\"output\": \"%s\"}", EscapeJSON(strOutput).Get());
+}
+
+int CAdminApi::Handle(const String& strUri, const String& strMethod, const String& strQuery, const String& strBody, String& strJSON)
+{
+	String strAction = strUri.SubStr(sizeof(ADMIN_API_URI) - 1);
+	bool bPost = (strMethod == "POST");
+
+	if(strAction == "stats")
+	{
+		strJSON = GetStats();
+		return 200;
+	}
+
+	if(strAction == "players")
+	{
+		strJSON = GetPlayers();
+		return 200;
+	}
+
+	if(strAction == "config" && !bPost)
+	{
+		strJSON = GetConfig();
+		return 200;
+	}
+
+	// Everything else changes the server
+	if(!bPost)
+	{
+		strJSON = "{\"error\": \"unknown action or not a POST\"}";
+		return 404;
+	}
+
+	bool bDone = false;
+
+	if(strAction == "kick" || strAction == "ban")
+	{
+		CPlayer * pPlayer = g_pPlayerManager->GetAt((EntityId)GetParameter("playerid", strQuery, strBody).ToInteger());
+		String strSeconds = GetParameter("seconds", strQuery, strBody);
+		String strTarget = GetParameter("target", strQuery, strBody);
+
+		if(strAction == "ban" && strTarget.IsNotEmpty())
+			bDone = g_pBanManager->Add(strTarget, (unsigned int)strSeconds.ToInteger());
+		else if(pPlayer && strAction == "ban")
+		{
+			pPlayer->Ban((unsigned int)strSeconds.ToInteger());
+			bDone = true;
+		}
+		else if(pPlayer)
+		{
+			pPlayer->Kick(GetParameter("notify", strQuery, strBody) != "0");
+			bDone = true;
+		}
+	}
+	else if(strAction == "unban")
+		bDone = g_pBanManager->Remove(GetParameter("target", strQuery, strBody));
+	else if(strAction == "config")
+	{
+		String strName = GetParameter("name", strQuery, strBody);
+		bDone = (strName != "admintoken" && CVAR_SET_EX(strName, GetParameter("value", strQuery, strBody)));
+	}
+	else if(strAction == "reloadscript")
+	{
+		strJSON = RunConsoleInput(String("reloadscript %s", GetParameter("name", strQuery, strBody).Get()));
+		return 200;
+	}
+	else if(strAction == "command")
+	{
+		strJSON = RunConsoleInput(GetParameter("input", strQuery, strBody));
+		return 200;
+	}
+	else
+	{
+		strJSON = "{\"error\": \"unknown action\"}";
+		return 404;
+	}
+
+	strJSON.Format("{\"ok\": %s}", (bDone ? "true" : "false"));
+	return (bDone ? 200 : 400);
+}
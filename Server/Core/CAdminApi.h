@@ -0,0 +1,50 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CAdminApi.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <CString.h>
+#include <string.h>
+
+// Uri of the webserver the admin api is served at
+#define ADMIN_API_URI "/admin/"
+
+// Maximum size in bytes of a parameter of an admin api request
+#define ADMIN_API_MAX_PARAMETER_LENGTH 1024
+
+// Lets tools control the server over http with json replies instead of the
+// console. Requests need the admintoken as a bearer token, the webserver
+// checks it on its own threads and queues the requests that pass for the
+// main thread which handles them in the tick.
+class CAdminApi
+{
+private:
+	String        m_strToken;
+
+	static void   LogCallback(const char * szBuffer);
+	static String EscapeJSON(const String& strString);
+	static String GetParameter(const String& strName, const String& strQuery, const String& strBody);
+	static String GetStats();
+	static String GetPlayers();
+	static String GetConfig();
+	static String RunConsoleInput(const String& strInput);
+
+public:
+	CAdminApi();
+
+	bool          IsEnabled() { return m_strToken.IsNotEmpty(); }
+	static bool   IsAdminUri(const char * szUri) { return !strncmp(szUri, ADMIN_API_URI, (sizeof(ADMIN_API_URI) - 1)); }
+
+	// Can be called from any thread, the value of the Authorization header
+	bool          IsAuthorized(const char * szAuthorization);
+
+	// Called from the main thread, returns the http status code of the reply
+	int           Handle(const String& strUri, const String& strMethod, const String& strQuery, const String& strBody, String& strJSON);
+};
@@ -0,0 +1,432 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBanManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#ifdef _LINUX
+#include <arpa/inet.h>
+#else
+#include <winsock2.h>
+#endif
+
+#include "CBanManager.h"
+#include <SharedUtility.h>
+#include <CLogFile.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctime>
+
+extern CJobSystem * g_pJobSystem;
+
+// The ban list file has a line for each ban that was added ("target:start:seconds",
+// the format the bans have always been written in) and a line for each ban that
+// was removed ("-target"), the lines of later bans replace the earlier ones
+
+CBanManager::CBanManager(String strFileName)
+{
+	m_strFileName = strFileName;
+	m_uiNextId = 1;
+	memset(m_uiPrefixBans, 0, sizeof(m_uiPrefixBans));
+	m_ulLastExpiryTime = 0;
+	m_uiDeadLines = 0;
+	m_bCompact = false;
+	m_bWriteCompact = false;
+	m_bWriteSucceeded = false;
+	m_bWriting = false;
+}
+
+CBanManager::~CBanManager()
+{
+	if(m_bWriting)
+	{
+		g_pJobSystem->Wait(&m_writeCounter);
+		OnWritten();
+	}
+
+	// Write what is left now as there is no next tick
+	if(QueueWrite())
+	{
+		Write();
+		OnWritten();
+	}
+}
+
+bool CBanManager::ParseTarget(String strTarget, BanEntry& ban)
+{
+	if(strTarget.IsEmpty() || strpbrk(strTarget.Get(), ":\r\n"))
+		return false;
+
+	unsigned int uiParts[4];
+	unsigned int uiPrefix = 32;
+	char cEnd;
+	int iRead = sscanf(strTarget.Get(), "%u.%u.%u.%u%c", &uiParts[0], &uiParts[1], &uiParts[2], &uiParts[3], &cEnd);
+
+	if(iRead < 4)
+	{
+		// Anything that isn't an address is a serial
+		ban.bSerial = true;
+		ban.ulAddress = 0;
+		ban.ucPrefix = 0;
+		ban.strSerial = strTarget;
+		return true;
+	}
+
+	if(iRead == 5 && (cEnd != '/' || sscanf(strTarget.Get(), "%*u.%*u.%*u.%*u/%u%c", &uiPrefix, &cEnd) != 1))
+		return false;
+
+	if(uiParts[0] > 255 || uiParts[1] > 255 || uiParts[2] > 255 || uiParts[3] > 255 || uiPrefix > 32)
+		return false;
+
+	ban.bSerial = false;
+	ban.ucPrefix = (unsigned char)uiPrefix;
+	ban.ulAddress = (((uiParts[0] << 24) | (uiParts[1] << 16) | (uiParts[2] << 8) | uiParts[3]) & GetMask(ban.ucPrefix));
+	return true;
+}
+
+String CBanManager::GetTarget(const BanEntry& ban)
+{
+	if(ban.bSerial)
+		return ban.strSerial;
+
+	String strTarget("%lu.%lu.%lu.%lu", ((ban.ulAddress >> 24) & 0xFF), ((ban.ulAddress >> 16) & 0xFF), ((ban.ulAddress >> 8) & 0xFF), (ban.ulAddress & 0xFF));
+
+	if(ban.ucPrefix != 32)
+		strTarget.AppendF("/%d", ban.ucPrefix);
+
+	return strTarget;
+}
+
+unsigned int CBanManager::Find(const BanEntry& ban)
+{
+	if(ban.bSerial)
+		return m_serials.Find(ban.strSerial);
+
+	return m_addresses.Find(GetAddressKey(ban.ulAddress, ban.ucPrefix));
+}
+
+bool CBanManager::IsExpired(const BanEntry& ban, unsigned int uiTime)
+{
+	return (ban.uiSeconds != 0 && (ban.uiStart + ban.uiSeconds) <= uiTime);
+}
+
+void CBanManager::Insert(const BanEntry& ban)
+{
+	// The lock must be held for writing
+	if(ban.bSerial)
+		m_serials.Set(ban.strSerial, ban.uiId);
+	else
+	{
+		m_addresses.Set(GetAddressKey(ban.ulAddress, ban.ucPrefix), ban.uiId);
+		m_uiPrefixBans[ban.ucPrefix]++;
+	}
+
+	m_bans[ban.uiId] = ban;
+
+	if(ban.uiSeconds != 0)
+		m_expiries.push(BanExpiry((ban.uiStart + ban.uiSeconds), ban.uiId));
+}
+
+bool CBanManager::Erase(unsigned int uiBanId)
+{
+	// The lock must be held for writing
+	std::map<unsigned int, BanEntry>::iterator iter = m_bans.find(uiBanId);
+
+	if(iter == m_bans.end())
+		return false;
+
+	if(iter->second.bSerial)
+		m_serials.Remove(iter->second.strSerial);
+	else
+	{
+		m_addresses.Remove(GetAddressKey(iter->second.ulAddress, iter->second.ucPrefix));
+		m_uiPrefixBans[iter->second.ucPrefix]--;
+	}
+
+	// Its expiry is skipped once it is at the top of the heap
+	m_bans.erase(iter);
+	m_uiDeadLines++;
+	return true;
+}
+
+bool CBanManager::Load()
+{
+	FILE * pFile = fopen(m_strFileName.Get(), "r");
+
+	if(!pFile)
+		return false;
+
+	unsigned int uiTime = (unsigned int)time(NULL);
+	char szLine[256];
+	m_lock.LockWrite();
+
+	while(fgets(szLine, sizeof(szLine), pFile))
+	{
+		// Strip the line break
+		szLine[strcspn(szLine, "\r\n")] = '\0';
+
+		if(szLine[0] == '\0')
+			continue;
+
+		BanEntry ban;
+
+		if(szLine[0] == '-')
+		{
+			// The removal line is dead as well as the ban it removes
+			if(ParseTarget(szLine + 1, ban))
+				Erase(Find(ban));
+
+			m_uiDeadLines++;
+			continue;
+		}
+
+		char * szStart = strchr(szLine, ':');
+		char * szSeconds = (szStart ? strchr(szStart + 1, ':') : NULL);
+
+		if(!szSeconds)
+		{
+			m_uiDeadLines++;
+			continue;
+		}
+
+		*szStart = '\0';
+
+		if(!ParseTarget(szLine, ban))
+		{
+			m_uiDeadLines++;
+			continue;
+		}
+
+		ban.uiStart = (unsigned int)strtoul(szStart + 1, NULL, 10);
+		ban.uiSeconds = (unsigned int)strtoul(szSeconds + 1, NULL, 10);
+
+		if(IsExpired(ban, uiTime))
+		{
+			m_uiDeadLines++;
+			continue;
+		}
+
+		Erase(Find(ban));
+		ban.uiId = m_uiNextId++;
+		Insert(ban);
+	}
+
+	m_lock.UnlockWrite();
+	fclose(pFile);
+	CLogFile::Printf("Loaded %d bans from %s", m_bans.size(), m_strFileName.Get());
+	return true;
+}
+
+bool CBanManager::Add(String strTarget, unsigned int uiSeconds)
+{
+	BanEntry ban;
+
+	if(!ParseTarget(strTarget, ban))
+		return false;
+
+	ban.uiStart = (unsigned int)time(NULL);
+	ban.uiSeconds = uiSeconds;
+	m_lock.LockWrite();
+	Erase(Find(ban));
+	ban.uiId = m_uiNextId++;
+	Insert(ban);
+	m_lock.UnlockWrite();
+
+	m_strPendingLines.AppendF("%s:%u:%u\n", GetTarget(ban).Get(), ban.uiStart, ban.uiSeconds);
+	return true;
+}
+
+bool CBanManager::Remove(String strTarget)
+{
+	BanEntry ban;
+
+	if(!ParseTarget(strTarget, ban))
+		return false;
+
+	m_lock.LockWrite();
+	bool bRemoved = Erase(Find(ban));
+	m_lock.UnlockWrite();
+
+	if(!bRemoved)
+		return false;
+
+	m_strPendingLines.AppendF("-%s\n", GetTarget(ban).Get());
+	m_uiDeadLines++;
+	return true;
+}
+
+bool CBanManager::IsBanned(String strTarget)
+{
+	BanEntry ban;
+
+	if(!ParseTarget(strTarget, ban))
+		return false;
+
+	if(ban.bSerial)
+		return IsSerialBanned(ban.strSerial);
+
+	// A single address is banned if any range it is in is, a range only by a ban for exactly it
+	if(ban.ucPrefix == 32)
+		return IsAddressBanned(htonl(ban.ulAddress));
+
+	unsigned int uiTime = (unsigned int)time(NULL);
+	m_lock.LockRead();
+	std::map<unsigned int, BanEntry>::iterator iter = m_bans.find(Find(ban));
+	bool bBanned = (iter != m_bans.end() && !IsExpired(iter->second, uiTime));
+	m_lock.UnlockRead();
+	return bBanned;
+}
+
+bool CBanManager::IsAddressBanned(unsigned long ulBinaryAddress)
+{
+	unsigned long ulAddress = ntohl(ulBinaryAddress);
+	unsigned int uiTime = (unsigned int)time(NULL);
+	bool bBanned = false;
+	m_lock.LockRead();
+
+	// Only the prefix lengths that have bans are looked up
+	for(int i = 32; i >= 0 && !bBanned; i--)
+	{
+		if(m_uiPrefixBans[i] == 0)
+			continue;
+
+		unsigned int uiBanId = m_addresses.Find(GetAddressKey((ulAddress & GetMask((unsigned char)i)), (unsigned char)i));
+
+		if(uiBanId != 0)
+		{
+			// It can have expired without Process having removed it yet
+			std::map<unsigned int, BanEntry>::iterator iter = m_bans.find(uiBanId);
+			bBanned = (iter != m_bans.end() && !IsExpired(iter->second, uiTime));
+		}
+	}
+
+	m_lock.UnlockRead();
+	return bBanned;
+}
+
+bool CBanManager::IsSerialBanned(String strSerial)
+{
+	unsigned int uiTime = (unsigned int)time(NULL);
+	m_lock.LockRead();
+	std::map<unsigned int, BanEntry>::iterator iter = m_bans.find(m_serials.Find(strSerial));
+	bool bBanned = (iter != m_bans.end() && !IsExpired(iter->second, uiTime));
+	m_lock.UnlockRead();
+	return bBanned;
+}
+
+bool CBanManager::QueueWrite()
+{
+	if(m_bWriting)
+		return false;
+
+	// Rewrite the file once most of its lines are dead
+	if(m_bCompact || (m_uiDeadLines >= BAN_LIST_COMPACT_LINES && m_uiDeadLines > m_bans.size()))
+	{
+		m_strWriteLines.Clear();
+
+		for(std::map<unsigned int, BanEntry>::iterator iter = m_bans.begin(); iter != m_bans.end(); ++iter)
+			m_strWriteLines.AppendF("%s:%u:%u\n", GetTarget(iter->second).Get(), iter->second.uiStart, iter->second.uiSeconds);
+
+		// The pending lines are part of the new file
+		m_strPendingLines.Clear();
+		m_uiDeadLines = 0;
+		m_bCompact = false;
+		m_bWriteCompact = true;
+		return true;
+	}
+
+	if(m_strPendingLines.IsEmpty())
+		return false;
+
+	m_strWriteLines = m_strPendingLines;
+	m_strPendingLines.Clear();
+	m_bWriteCompact = false;
+	return true;
+}
+
+void CBanManager::WriteJob(void * pUserData)
+{
+	((CBanManager *)pUserData)->Write();
+}
+
+void CBanManager::Write()
+{
+	// Write a compacted file next to the old one and move it over it once it is complete
+	String strWritePath = m_strFileName;
+
+	if(m_bWriteCompact)
+		strWritePath.Append(".tmp");
+
+	FILE * pFile = fopen(strWritePath.Get(), (m_bWriteCompact ? "w" : "a"));
+	m_bWriteSucceeded = false;
+
+	if(!pFile)
+		return;
+
+	m_bWriteSucceeded = (fwrite(m_strWriteLines.Get(), 1, m_strWriteLines.GetLength(), pFile) == m_strWriteLines.GetLength());
+	m_bWriteSucceeded = (fclose(pFile) == 0 && m_bWriteSucceeded);
+
+	if(m_bWriteCompact && m_bWriteSucceeded)
+	{
+		remove(m_strFileName.Get());
+		m_bWriteSucceeded = (rename(strWritePath.Get(), m_strFileName.Get()) == 0);
+	}
+}
+
+void CBanManager::OnWritten()
+{
+	m_bWriting = false;
+
+	if(m_bWriteSucceeded)
+		return;
+
+	CLogFile::Printf("Failed to write the ban list file %s", m_strFileName.Get());
+
+	// A compaction is tried again as a whole, appended lines are put back in front of the pending ones
+	if(m_bWriteCompact)
+		m_bCompact = true;
+	else
+	{
+		m_strWriteLines.Append(m_strPendingLines);
+		m_strPendingLines = m_strWriteLines;
+	}
+}
+
+void CBanManager::Process()
+{
+	if(m_bWriting && m_writeCounter.IsDone())
+		OnWritten();
+
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastExpiryTime) < BAN_EXPIRY_INTERVAL)
+		return;
+
+	m_ulLastExpiryTime = ulTime;
+
+	// Remove the bans that expired (the heap entries of the bans that were removed or replaced are skipped)
+	unsigned int uiTime = (unsigned int)time(NULL);
+
+	if(!m_expiries.empty() && m_expiries.top().first <= uiTime)
+	{
+		m_lock.LockWrite();
+
+		while(!m_expiries.empty() && m_expiries.top().first <= uiTime)
+		{
+			Erase(m_expiries.top().second);
+			m_expiries.pop();
+		}
+
+		m_lock.UnlockWrite();
+	}
+
+	// Write the lines added since the last write
+	if(QueueWrite())
+	{
+		m_bWriting = true;
+		g_pJobSystem->Add(WriteJob, this, &m_writeCounter);
+	}
+}
@@ -0,0 +1,206 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBanManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <CString.h>
+#include <Threading/CReadWriteLock.h>
+#include <Threading/CJobSystem.h>
+
+// Amount of dead lines (expired, removed or replaced bans) the ban list file can
+// have before it is rewritten with only the bans that are left
+#define BAN_LIST_COMPACT_LINES 256
+
+// Time in ms between checks for expired bans
+#define BAN_EXPIRY_INTERVAL 1000
+
+struct BanEntry
+{
+	unsigned int  uiId;
+	bool          bSerial;
+	unsigned long ulAddress; // Host byte order and masked with the prefix
+	unsigned char ucPrefix;  // Amount of leading address bits the ban matches (32 for a single ip)
+	String        strSerial;
+	unsigned int  uiStart;   // Unix time the ban was added
+	unsigned int  uiSeconds; // 0 for a ban that doesn't expire
+};
+
+// Maps the keys of the bans to their ids, the buckets are doubled once
+// there are more keys than buckets so a lookup stays a single bucket scan
+template <typename Key>
+class CBanHashTable
+{
+private:
+	struct Item
+	{
+		Key          key;
+		unsigned int uiBanId;
+	};
+
+	std::vector<std::vector<Item> > m_buckets;
+	unsigned int                    m_uiCount;
+
+	std::vector<Item>& GetBucket(const Key& key) { return m_buckets[Hash(key) & (m_buckets.size() - 1)]; }
+
+	void               Grow()
+	{
+		std::vector<std::vector<Item> > buckets(m_buckets.size() * 2);
+		m_buckets.swap(buckets);
+
+		for(size_t i = 0; i < buckets.size(); i++)
+		{
+			for(size_t j = 0; j < buckets[i].size(); j++)
+				GetBucket(buckets[i][j].key).push_back(buckets[i][j]);
+		}
+	}
+
+public:
+	CBanHashTable() : m_buckets(64), m_uiCount(0) { }
+
+	// Returns 0 if the key has no ban
+	unsigned int Find(const Key& key) const
+	{
+		const std::vector<Item>& bucket = m_buckets[Hash(key) & (m_buckets.size() - 1)];
+
+		for(size_t i = 0; i < bucket.size(); i++)
+		{
+			if(bucket[i].key == key)
+				return bucket[i].uiBanId;
+		}
+
+		return 0;
+	}
+
+	void         Set(const Key& key, unsigned int uiBanId)
+	{
+		std::vector<Item>& bucket = GetBucket(key);
+
+		for(size_t i = 0; i < bucket.size(); i++)
+		{
+			if(bucket[i].key == key)
+			{
+				bucket[i].uiBanId = uiBanId;
+				return;
+			}
+		}
+
+		Item item;
+		item.key = key;
+		item.uiBanId = uiBanId;
+		bucket.push_back(item);
+
+		if(++m_uiCount > m_buckets.size())
+			Grow();
+	}
+
+	void         Remove(const Key& key)
+	{
+		std::vector<Item>& bucket = GetBucket(key);
+
+		for(size_t i = 0; i < bucket.size(); i++)
+		{
+			if(bucket[i].key == key)
+			{
+				bucket[i] = bucket.back();
+				bucket.pop_back();
+				m_uiCount--;
+				return;
+			}
+		}
+	}
+
+	static unsigned int Hash(unsigned long long ullKey)
+	{
+		ullKey ^= (ullKey >> 33);
+		ullKey *= 0xFF51AFD7ED558CCDULL;
+		ullKey ^= (ullKey >> 33);
+		return (unsigned int)ullKey;
+	}
+
+	static unsigned int Hash(const String& strKey)
+	{
+		// FNV-1a
+		unsigned int uiHash = 2166136261U;
+
+		for(size_t i = 0; i < strKey.GetLength(); i++)
+			uiHash = ((uiHash ^ (unsigned char)strKey.Get()[i]) * 16777619U);
+
+		return uiHash;
+	}
+};
+
+// The bans by ip, ip range (a.b.c.d/bits) and serial. Connections are checked
+// against them from the network thread with a hash lookup per prefix length in
+// use, expired bans are taken off a heap ordered by expiry and the ban list file
+// is appended to and compacted by a job.
+class CBanManager
+{
+private:
+	typedef std::pair<unsigned int, unsigned int> BanExpiry; // Expiry time, ban id
+
+	String                                  m_strFileName;
+	std::map<unsigned int, BanEntry>        m_bans;
+	unsigned int                            m_uiNextId;
+	CBanHashTable<unsigned long long>       m_addresses; // By (prefix << 32 | masked address)
+	CBanHashTable<String>                   m_serials;
+	unsigned int                            m_uiPrefixBans[33]; // Amount of address bans for each prefix length
+	std::priority_queue<BanExpiry, std::vector<BanExpiry>, std::greater<BanExpiry> > m_expiries;
+	CReadWriteLock                          m_lock;
+	unsigned long                           m_ulLastExpiryTime;
+
+	// The lines not written to the file yet
+	String                                  m_strPendingLines;
+	unsigned int                            m_uiDeadLines;
+	bool                                    m_bCompact;
+
+	// Owned by the write job while m_bWriting is set
+	String                                  m_strWriteLines;
+	bool                                    m_bWriteCompact;
+	bool                                    m_bWriteSucceeded;
+	CJobCounter                             m_writeCounter;
+	bool                                    m_bWriting;
+
+	static bool          ParseTarget(String strTarget, BanEntry& ban);
+	static String        GetTarget(const BanEntry& ban);
+	static unsigned long GetMask(unsigned char ucPrefix) { return (ucPrefix == 0 ? 0 : (0xFFFFFFFFUL << (32 - ucPrefix)) & 0xFFFFFFFFUL); }
+	static unsigned long long GetAddressKey(unsigned long ulAddress, unsigned char ucPrefix) { return ((((unsigned long long)ucPrefix) << 32) | ulAddress); }
+	unsigned int         Find(const BanEntry& ban);
+	void                 Insert(const BanEntry& ban);
+	bool                 Erase(unsigned int uiBanId);
+	static bool          IsExpired(const BanEntry& ban, unsigned int uiTime);
+	bool                 QueueWrite();
+	static void          WriteJob(void * pUserData);
+	void                 Write();
+	void                 OnWritten();
+
+public:
+	CBanManager(String strFileName);
+	~CBanManager();
+
+	// Reads the ban list file, returns false if it can't be opened
+	bool                 Load();
+
+	// The target is an ip, an ip range (a.b.c.d/bits) or a serial, a ban for a target
+	// that is already banned replaces it. 0 seconds bans until the ban is removed
+	bool                 Add(String strTarget, unsigned int uiSeconds);
+	bool                 Remove(String strTarget);
+	bool                 IsBanned(String strTarget);
+
+	// Can be called from any thread, the address is in network byte order
+	bool                 IsAddressBanned(unsigned long ulBinaryAddress);
+	bool                 IsSerialBanned(String strSerial);
+	unsigned int         GetCount() { return (unsigned int)m_bans.size(); }
+
+	// Removes the expired bans and queues the file writes
+	void                 Process();
+};
@@ -13,16 +13,31 @@
 #include "CEvents.h"
 #include "CModuleManager.h"
 #include "CPlayerManager.h"
+#include "CSpatialIndex.h"
+#include "CInterestManager.h"
+#include <CSettings.h>
+#include <SharedUtility.h>
+#include <float.h>
+#include <math.h>
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CEvents * g_pEvents;
 extern CModuleManager * g_pModuleManager;
 extern CPlayerManager * g_pPlayerManager;
+extern CJoinStreamer * g_pJoinStreamer;
+extern CSpatialIndex * g_pSpatialIndex;
+extern CInterestManager * g_pInterestManager;
 
 CBlipManager::CBlipManager()
+	: m_ulLastStreamTime(0),
+	m_ulLastAttachedTime(0),
+	m_ucAttachedUpdates(0)
 {
-	for(EntityId x = 0; x < MAX_BLIPS; x++)
-		m_bActive[x] = false;
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CBlipManager));
+
+	// Get the short range blip stream distance from the settings
+	m_fStreamDistance = CVAR_GET_FLOAT("blipstreamdistance");
 
 	for(EntityId y = 0; y < MAX_PLAYERS; y++)
 		m_bPlayerActive[y] = false;
@@ -30,14 +45,12 @@ CBlipManager::CBlipManager()
 
 CBlipManager::~CBlipManager()
 {
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CBlipManager));
+
 	for(EntityId x = 0; x < MAX_BLIPS; x++)
-	{
-		if(m_bActive[x])
+		if(m_ids.IsUsed(x))
 			Delete(x);
 
-		m_bActive[x] = false;
-	}
-
 	for(EntityId y = 0; y < MAX_PLAYERS; y++)
 	{
 		if(m_bPlayerActive[y])
@@ -49,40 +62,32 @@ CBlipManager::~CBlipManager()
 
 EntityId CBlipManager::Create(int iSprite, CVector3 vecPosition, bool bShow)
 {
-	for(EntityId x = 0; x < MAX_BLIPS; x++)
-	{
-		if(!m_bActive[x])
-		{
-			CBitStream bsSend;
-			bsSend.WriteCompressed(x);
-			bsSend.Write(iSprite);
-			bsSend.Write(vecPosition);
-			m_Blips[x].uiColor = 0xFFFFFFFF;
-			m_Blips[x].fSize = 1.0f;
-			m_Blips[x].bRouteBlip = false;
-			m_Blips[x].bShortRange = false;
-			m_Blips[x].bShow = true;
-			m_Blips[x].strName = "";
-			bsSend.Write(m_Blips[x].uiColor);
-			bsSend.Write(m_Blips[x].fSize);
-			bsSend.Write(m_Blips[x].bRouteBlip);
-			bsSend.Write(m_Blips[x].bShortRange);
-			bsSend.Write(m_Blips[x].bShow);
-			bsSend.Write(m_Blips[x].strName);
-			g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-			m_Blips[x].iSprite = iSprite;
-			m_Blips[x].vecSpawnPos = vecPosition;
-			m_bActive[x] = true;
-
-			CSquirrelArguments pArguments;
-			pArguments.push(x);
-			g_pEvents->Call("blipCreate", &pArguments);
-
-			return x;
-		}
-	}
+	EntityId x = m_ids.Allocate();
+
+	if(x == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
+
+	m_Blips[x].uiColor = 0xFFFFFFFF;
+	m_Blips[x].fSize = 1.0f;
+	m_Blips[x].bRouteBlip = false;
+	m_Blips[x].bShortRange = false;
+	m_Blips[x].bShow = true;
+	m_Blips[x].strName = "";
+	m_Blips[x].iSprite = iSprite;
+	m_Blips[x].vecSpawnPos = vecPosition;
+	m_Blips[x].attachedPlayer = INVALID_ENTITY_ID;
+	g_pSpatialIndex->Update(SPATIAL_INDEX_BLIP, x, vecPosition, 0);
+
+	// New blips are long range so everyone gets them
+	CBitStream bsSend;
+	SerializeSpawn(x, &bsSend);
+	g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+
+	CSquirrelArguments pArguments;
+	pArguments.push(x);
+	g_pEvents->Call("blipCreate", &pArguments);
 
-	return INVALID_ENTITY_ID;
+	return x;
 }
 
 void CBlipManager::Delete(EntityId blipId)
@@ -94,34 +99,89 @@ void CBlipManager::Delete(EntityId blipId)
 	pArguments.push(blipId);
 	g_pEvents->Call("blipDelete", &pArguments);
 
+	if(IsStreamed(blipId))
+	{
+		const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+		for(size_t i = 0; i < players.size(); i++)
+		{
+			if(m_streamedBlips[players[i]].erase(blipId) > 0)
+				SendDelete(blipId, players[i]);
+		}
+	}
+	else
+		SendDelete(blipId, INVALID_ENTITY_ID);
+
+	g_pSpatialIndex->Remove(SPATIAL_INDEX_BLIP, blipId);
+	m_ids.Free(blipId);
+}
+
+void CBlipManager::SerializeSpawn(EntityId blipId, CBitStream * pBitStream)
+{
+	pBitStream->WriteCompressed(blipId);
+	pBitStream->Write(m_Blips[blipId].iSprite);
+	pBitStream->Write(m_Blips[blipId].vecSpawnPos);
+	pBitStream->Write(m_Blips[blipId].uiColor);
+	pBitStream->Write(m_Blips[blipId].fSize);
+	pBitStream->Write(m_Blips[blipId].bShortRange);
+	pBitStream->Write(m_Blips[blipId].bRouteBlip);
+	pBitStream->Write(m_Blips[blipId].bShow);
+	pBitStream->Write(m_Blips[blipId].strName);
+}
+
+void CBlipManager::SendSpawn(EntityId blipId, EntityId playerId)
+{
+	CBitStream bsSend;
+	SerializeSpawn(blipId, &bsSend);
+	g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+void CBlipManager::SendDelete(EntityId blipId, EntityId playerId)
+{
 	CBitStream bsSend;
 	bsSend.WriteCompressed(blipId);
-	g_pNetworkManager->RPC(RPC_DeleteBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-	m_bActive[blipId] = false;
+	g_pNetworkManager->RPC(RPC_DeleteBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, (playerId == INVALID_ENTITY_ID));
+}
+
+void CBlipManager::SendToPlayers(EntityId blipId, RPCIdentifier rpcId, CBitStream * pBitStream, bool bCoalesce)
+{
+	if(!IsStreamed(blipId))
+	{
+		if(bCoalesce)
+			g_pNetworkManager->CoalescedRPC(rpcId, pBitStream, blipId, INVALID_ENTITY_ID, true);
+		else
+			g_pNetworkManager->RPC(rpcId, pBitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+
+		return;
+	}
+
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(m_streamedBlips[players[i]].find(blipId) == m_streamedBlips[players[i]].end())
+			continue;
+
+		if(bCoalesce)
+			g_pNetworkManager->CoalescedRPC(rpcId, pBitStream, blipId, players[i], false);
+		else
+			g_pNetworkManager->RPC(rpcId, pBitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, players[i], false);
+	}
 }
 
 void CBlipManager::SetPosition(EntityId blipId, CVector3 vecPosition)
 {
 	if(DoesExist(blipId))
 	{
-		//Update serverside position
 		m_Blips[blipId].vecSpawnPos = vecPosition;
-		//Set blip position for clients, therefore delete...
+		m_Blips[blipId].attachedPlayer = INVALID_ENTITY_ID;
+		g_pSpatialIndex->Update(SPATIAL_INDEX_BLIP, blipId, vecPosition, 0);
+
+		// Blips that are moved a lot (trackers) only send their last position of the tick
 		CBitStream bsSend;
 		bsSend.WriteCompressed(blipId);
-		g_pNetworkManager->RPC(RPC_DeleteBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-		//...and create a new one
-		CBitStream bsSend2;
-		bsSend2.WriteCompressed(blipId);
-		bsSend2.Write(m_Blips[blipId].iSprite);
-		bsSend2.Write(vecPosition);
-		bsSend2.Write(m_Blips[blipId].uiColor);
-		bsSend2.Write(m_Blips[blipId].fSize);
-		bsSend2.Write(m_Blips[blipId].bShortRange);
-		bsSend2.Write(m_Blips[blipId].bRouteBlip);
-		bsSend2.Write(m_Blips[blipId].bShow);
-		bsSend2.Write(m_Blips[blipId].strName);
-		g_pNetworkManager->RPC(RPC_NewBlip, &bsSend2, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		bsSend.Write(vecPosition);
+		SendToPlayers(blipId, RPC_ScriptingSetBlipPosition, &bsSend, true);
 	}
 }
 
@@ -142,7 +202,7 @@ void CBlipManager::SetColor(EntityId blipId, unsigned int uiColor)
 		CBitStream bsSend;
 		bsSend.Write(blipId);
 		bsSend.Write(uiColor);
-		g_pNetworkManager->RPC(RPC_ScriptingSetBlipColor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		SendToPlayers(blipId, RPC_ScriptingSetBlipColor, &bsSend, true);
 	}
 }
 
@@ -163,7 +223,7 @@ void CBlipManager::SetSize(EntityId blipId, float fSize)
 		CBitStream bsSend;
 		bsSend.Write(blipId);
 		bsSend.Write(fSize);
-		g_pNetworkManager->RPC(RPC_ScriptingSetBlipSize, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		SendToPlayers(blipId, RPC_ScriptingSetBlipSize, &bsSend, true);
 	}
 }
 
@@ -177,14 +237,46 @@ float CBlipManager::GetSize(EntityId blipId)
 
 void CBlipManager::ToggleShortRange(EntityId blipId, bool bShortRange)
 {
-	if(DoesExist(blipId))
+	if(!DoesExist(blipId) || m_Blips[blipId].bShortRange == bShortRange)
+		return;
+
+	CBitStream bsSend;
+	bsSend.Write(blipId);
+	bsSend.Write(bShortRange);
+
+	if(m_fStreamDistance <= 0.0f)
 	{
 		m_Blips[blipId].bShortRange = bShortRange;
+		g_pNetworkManager->RPC(RPC_ScriptingToggleBlipShortRange, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		return;
+	}
 
-		CBitStream bsSend;
-		bsSend.Write(blipId);
-		bsSend.Write(bShortRange);
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	if(bShortRange)
+	{
+		// Everyone has the blip until it is streamed out for the players that are too far away
 		g_pNetworkManager->RPC(RPC_ScriptingToggleBlipShortRange, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		m_Blips[blipId].bShortRange = true;
+
+		for(size_t i = 0; i < players.size(); i++)
+		{
+			if(!g_pJoinStreamer->IsStreaming(players[i]))
+				m_streamedBlips[players[i]].insert(blipId);
+		}
+	}
+	else
+	{
+		// The players that don't have the blip get all of it
+		m_Blips[blipId].bShortRange = false;
+
+		for(size_t i = 0; i < players.size(); i++)
+		{
+			if(m_streamedBlips[players[i]].erase(blipId) > 0)
+				g_pNetworkManager->RPC(RPC_ScriptingToggleBlipShortRange, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, players[i], false);
+			else
+				SendSpawn(blipId, players[i]);
+		}
 	}
 }
 
@@ -197,7 +289,7 @@ void CBlipManager::ToggleRoute(EntityId blipId, bool bRoute)
 		CBitStream bsSend;
 		bsSend.Write(blipId);
 		bsSend.Write(bRoute);
-		g_pNetworkManager->RPC(RPC_ScriptingToggleBlipRoute, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		SendToPlayers(blipId, RPC_ScriptingToggleBlipRoute, &bsSend, false);
 	}
 }
 
@@ -209,10 +301,21 @@ void CBlipManager::SetName(EntityId blipId, String strName)
 		CBitStream bsSend;
 		bsSend.Write(blipId);
 		bsSend.Write(strName);
-		g_pNetworkManager->RPC(RPC_ScriptingSetBlipName, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		SendToPlayers(blipId, RPC_ScriptingSetBlipName, &bsSend, true);
 	}
 }
 
+void CBlipManager::AttachToPlayer(EntityId blipId, EntityId playerId)
+{
+	if(!DoesExist(blipId) || (playerId != INVALID_ENTITY_ID && !g_pPlayerManager->DoesExist(playerId)))
+		return;
+
+	m_Blips[blipId].attachedPlayer = playerId;
+
+	// The next attached update has the blip
+	m_Blips[blipId].vecSentPos = CVector3(FLT_MAX, FLT_MAX, FLT_MAX);
+}
+
 String CBlipManager::GetName(EntityId blipId)
 {
 	if(DoesExist(blipId))
@@ -221,36 +324,41 @@ String CBlipManager::GetName(EntityId blipId)
 	return "";
 }
 
-void CBlipManager::HandleClientJoin(EntityId playerId)
+bool CBlipManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
 {
-	if(GetBlipCount() > 0)
-	{
-		CBitStream bsSend;
+	// Pack as many blips as fit in a single message
+	CBitStream bsSend;
+	EntityId x = pCursor->entityId;
 
-		for(EntityId x = 0; x < MAX_BLIPS; x++)
+	for(; x < MAX_BLIPS && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; x++)
+	{
+		// The player gets the streamed blips once they are in range
+		if(m_ids.IsUsed(x) && !IsStreamed(x))
 		{
-			if(m_bActive[x])
-			{
-				bsSend.WriteCompressed(x);
-				bsSend.Write(m_Blips[x].iSprite);
-				bsSend.Write(m_Blips[x].vecSpawnPos);
-				bsSend.Write(m_Blips[x].uiColor);
-				bsSend.Write(m_Blips[x].fSize);
-				bsSend.Write(m_Blips[x].bShortRange);
-				bsSend.Write(m_Blips[x].bRouteBlip);
-				bsSend.Write(m_Blips[x].bShow);
-				bsSend.Write(m_Blips[x].strName);
-				g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-				bsSend.Reset();
-			}
+			SerializeSpawn(x, &bsSend);
+			pCursor->uiEntities++;
 		}
 	}
 
+	if(pCursor->uiEntities > 0)
+		g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+
+	pCursor->uiBytes = bsSend.GetNumberOfBytesUsed();
+	pCursor->entityId = x;
+	return (x >= MAX_BLIPS);
+}
+
+void CBlipManager::HandleClientJoinPlayerBlips(EntityId playerId)
+{
 	if(g_pPlayerManager->GetPlayerCount() > 0)
 	{
 		CBitStream bsSend;
-		for(EntityId y = 0; y < MAX_PLAYERS; y++)
+		const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+		for(size_t x = 0; x < players.size(); x++)
 		{
+			EntityId y = players[x];
+
 			if(m_bPlayerActive[y])
 			{
 				bsSend.WriteCompressed(y);
@@ -266,10 +374,10 @@ void CBlipManager::HandleClientJoin(EntityId playerId)
 
 bool CBlipManager::DoesExist(EntityId blipId)
 {
-	if(blipId < 0 || blipId > MAX_BLIPS)
+	if(blipId < 0 || blipId >= MAX_BLIPS)
 		return false;
 
-	return m_bActive[blipId];
+	return m_ids.IsUsed(blipId);
 }
 
 EntityId CBlipManager::GetBlipCount()
@@ -278,7 +386,7 @@ EntityId CBlipManager::GetBlipCount()
 
 	for(EntityId x = 0; x < MAX_BLIPS; x++)
 	{
-		if(m_bActive[x])
+		if(m_ids.IsUsed(x))
 			blipCount++;
 	}
 
@@ -294,7 +402,7 @@ void CBlipManager::SwitchIcon(EntityId blipId, bool bShow, EntityId playerId)
 		bsSend.Write(blipId);
 		bsSend.Write(bShow);
 		if(playerId == INVALID_ENTITY_ID)
-			g_pNetworkManager->RPC(RPC_ScriptingSetBlipIcon, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+			SendToPlayers(blipId, RPC_ScriptingSetBlipIcon, &bsSend, true);
 		else
 			g_pNetworkManager->RPC(RPC_ScriptingSetBlipIcon, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 	}
@@ -405,4 +513,187 @@ void CBlipManager::TogglePlayerShortRangeForPlayer(EntityId playerId, EntityId t
 	bsSend.Write(bToggle);
 	bsSend.Write(m_PlayerBlips[playerId].bShow);
 	g_pNetworkManager->RPC(RPC_ScriptingChangePlayerBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, toPlayerId, false);
+}
+
+void CBlipManager::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_streamedBlips[playerId].clear();
+
+	// The blips attached to the player stay where it was last
+	for(EntityId x = 0; x < MAX_BLIPS; x++)
+	{
+		if(m_ids.IsUsed(x) && m_Blips[x].attachedPlayer == playerId)
+			m_Blips[x].attachedPlayer = INVALID_ENTITY_ID;
+	}
+}
+
+void CBlipManager::UpdatePlayer(EntityId playerId)
+{
+	CVector3 vecPosition;
+	unsigned char ucDimension;
+
+	// We only know where the player is once they have spawned
+	if(!g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, playerId, vecPosition, ucDimension))
+		return;
+
+	// Stream out the blips that are too far away (or no longer streamed)
+	std::set<EntityId> * pStreamed = &m_streamedBlips[playerId];
+	std::set<EntityId>::iterator iter = pStreamed->begin();
+	float fOutDistance = (m_fStreamDistance * BLIP_STREAMER_OUT_FACTOR);
+
+	while(iter != pStreamed->end())
+	{
+		// Deleted blips and long range blips were already handled by their setters
+		if(!DoesExist(*iter) || !IsStreamed(*iter))
+		{
+			pStreamed->erase(iter++);
+			continue;
+		}
+
+		if((m_Blips[*iter].vecSpawnPos - vecPosition).Length() > fOutDistance)
+		{
+			SendDelete(*iter, playerId);
+			pStreamed->erase(iter++);
+			continue;
+		}
+
+		iter++;
+	}
+
+	// Stream in the short range blips in range, packed into as few messages as possible
+	std::vector<EntityId> blips;
+	g_pSpatialIndex->GetInRange(SPATIAL_INDEX_BLIP, vecPosition, m_fStreamDistance, SPATIAL_INDEX_ALL_DIMENSIONS, blips);
+	CBitStream bsSend;
+
+	for(std::vector<EntityId>::iterator blipIter = blips.begin(); blipIter != blips.end(); blipIter++)
+	{
+		if(!DoesExist(*blipIter) || !IsStreamed(*blipIter) || !pStreamed->insert(*blipIter).second)
+			continue;
+
+		SerializeSpawn(*blipIter, &bsSend);
+
+		if(bsSend.GetNumberOfBytesUsed() >= JOIN_STREAM_MESSAGE_SIZE)
+		{
+			g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			bsSend.Reset();
+		}
+	}
+
+	if(bsSend.GetNumberOfBytesUsed() > 0)
+		g_pNetworkManager->RPC(RPC_NewBlip, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+void CBlipManager::ProcessAttached()
+{
+	// Move the attached blips to their players and write the ones that moved far enough
+	bool bRefresh = (++m_ucAttachedUpdates >= BLIP_ATTACHED_REFRESH_INTERVAL);
+
+	if(bRefresh)
+		m_ucAttachedUpdates = 0;
+
+	std::vector<EntityId> moved;
+
+	for(EntityId x = 0; x < MAX_BLIPS; x++)
+	{
+		if(!m_ids.IsUsed(x) || m_Blips[x].attachedPlayer == INVALID_ENTITY_ID)
+			continue;
+
+		CVector3 vecPosition;
+		unsigned char ucDimension;
+
+		if(!g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, m_Blips[x].attachedPlayer, vecPosition, ucDimension))
+			continue;
+
+		m_Blips[x].vecSpawnPos = vecPosition;
+		g_pSpatialIndex->Update(SPATIAL_INDEX_BLIP, x, vecPosition, 0);
+
+		if(bRefresh || (vecPosition - m_Blips[x].vecSentPos).Length() >= BLIP_ATTACHED_MIN_MOVE)
+		{
+			m_Blips[x].vecSentPos = vecPosition;
+			moved.push_back(x);
+		}
+	}
+
+	if(moved.empty())
+		return;
+
+	// The positions are rounded to a metre, that is plenty for the radar
+	CBitStream bsBroadcast;
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(std::vector<EntityId>::iterator iter = moved.begin(); iter != moved.end(); iter++)
+	{
+		if(IsStreamed(*iter))
+			continue;
+
+		bsBroadcast.WriteCompressed(*iter);
+		bsBroadcast.Write((short)floor(m_Blips[*iter].vecSpawnPos.fX + 0.5f));
+		bsBroadcast.Write((short)floor(m_Blips[*iter].vecSpawnPos.fY + 0.5f));
+		bsBroadcast.Write((short)floor(m_Blips[*iter].vecSpawnPos.fZ + 0.5f));
+	}
+
+	if(bsBroadcast.GetNumberOfBytesUsed() > 0)
+		g_pNetworkManager->RPC(RPC_AttachedBlipPositions, &bsBroadcast, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, INVALID_ENTITY_ID, true);
+
+	// Streamed blips only go to the players that have them
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(m_streamedBlips[players[i]].empty())
+			continue;
+
+		CBitStream bsSend;
+
+		for(std::vector<EntityId>::iterator iter = moved.begin(); iter != moved.end(); iter++)
+		{
+			if(!IsStreamed(*iter) || m_streamedBlips[players[i]].find(*iter) == m_streamedBlips[players[i]].end())
+				continue;
+
+			bsSend.WriteCompressed(*iter);
+			bsSend.Write((short)floor(m_Blips[*iter].vecSpawnPos.fX + 0.5f));
+			bsSend.Write((short)floor(m_Blips[*iter].vecSpawnPos.fY + 0.5f));
+			bsSend.Write((short)floor(m_Blips[*iter].vecSpawnPos.fZ + 0.5f));
+		}
+
+		if(bsSend.GetNumberOfBytesUsed() > 0)
+			g_pNetworkManager->RPC(RPC_AttachedBlipPositions, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, players[i], false);
+	}
+}
+
+void CBlipManager::Process()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	// Are the attached blips due for an update? (they move with the far sync of their players)
+	unsigned long ulAttachedInterval = g_pInterestManager->GetFarSyncInterval();
+
+	if(ulAttachedInterval == 0)
+		ulAttachedInterval = BLIP_STREAMER_UPDATE_INTERVAL;
+
+	if((ulTime - m_ulLastAttachedTime) >= ulAttachedInterval)
+	{
+		ProcessAttached();
+		m_ulLastAttachedTime = ulTime;
+	}
+
+	if(m_fStreamDistance <= 0.0f)
+		return;
+
+	// Is it time for an update?
+
+	if((ulTime - m_ulLastStreamTime) < BLIP_STREAMER_UPDATE_INTERVAL)
+		return;
+
+	m_ulLastStreamTime = ulTime;
+
+	// Players whose join state is still streaming get their blips once they have joined the game
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(!g_pJoinStreamer->IsStreaming(players[i]))
+			UpdatePlayer(players[i]);
+	}
 }
\ No newline at end of file
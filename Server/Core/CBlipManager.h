@@ -12,6 +12,24 @@
 
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
+#include "CJoinStreamer.h"
+#include "CEntityIdAllocator.h"
+#include <Network/RPCIdentifiers.h>
+#include <set>
+
+// Interval in ms at which the short range blips of all players are updated
+#define BLIP_STREAMER_UPDATE_INTERVAL 1000
+
+// Short range blips are only streamed out again once they are this much further
+// away than the blip stream distance
+#define BLIP_STREAMER_OUT_FACTOR 1.2f
+
+// Distance a player has to move before the position of the blips attached to it is sent again
+#define BLIP_ATTACHED_MIN_MOVE 2.0f
+
+// Amount of attached blip updates after which every attached blip is sent again even
+// if it didn't move (the updates are unreliable so the last move may never arrive)
+#define BLIP_ATTACHED_REFRESH_INTERVAL 10
 
 struct _Blip
 {
@@ -23,6 +41,8 @@ struct _Blip
 	bool			bRouteBlip;
 	bool			bShow;
 	String			strName;
+	EntityId		attachedPlayer; // The blip follows the player with the far sync
+	CVector3		vecSentPos;     // Position the last attached update had
 };
 
 struct _PlayerBlip
@@ -36,12 +56,34 @@ struct _PlayerBlip
 class CBlipManager : public CBlipManagerInterface
 {
 private:
-	bool m_bActive[MAX_BLIPS];
+	CEntityIdAllocator<MAX_BLIPS> m_ids;
 	_Blip m_Blips[MAX_BLIPS];
 
 	bool m_bPlayerActive[MAX_PLAYERS];
 	_PlayerBlip m_PlayerBlips[MAX_PLAYERS];
 
+	// Short range blips are only on the radar close to them so they are streamed to
+	// the players in range, everyone gets the long range blips
+	float m_fStreamDistance;
+	unsigned long m_ulLastStreamTime;
+	std::set<EntityId> m_streamedBlips[MAX_PLAYERS];
+
+	// Blips attached to players are moved with the far sync interval, an update only
+	// has the blips that moved and is sent unreliable
+	unsigned long m_ulLastAttachedTime;
+	unsigned char m_ucAttachedUpdates;
+
+	bool         IsStreamed(EntityId blipId) { return (m_fStreamDistance > 0.0f && m_Blips[blipId].bShortRange); }
+	void         SerializeSpawn(EntityId blipId, CBitStream * pBitStream);
+	void         SendSpawn(EntityId blipId, EntityId playerId);
+	void         SendDelete(EntityId blipId, EntityId playerId);
+
+	// Sends the rpc to the players that have the blip, coalesced rpcs are only sent
+	// once per tick with the last change
+	void         SendToPlayers(EntityId blipId, RPCIdentifier rpcId, CBitStream * pBitStream, bool bCoalesce);
+	void         UpdatePlayer(EntityId playerId);
+	void         ProcessAttached();
+
 public:
 	CBlipManager();
 	~CBlipManager();
@@ -58,7 +100,15 @@ public:
 	void		 ToggleRoute(EntityId blipId, bool bRoute);
 	void         SetName(EntityId blipId, String strName);
 	String       GetName(EntityId blipId);
-	void         HandleClientJoin(EntityId playerId);
+	int          GetSprite(EntityId blipId) { return m_Blips[blipId].iSprite; }
+	bool         IsShortRange(EntityId blipId) { return m_Blips[blipId].bShortRange; }
+	bool         IsRoute(EntityId blipId) { return m_Blips[blipId].bRouteBlip; }
+	// INVALID_ENTITY_ID (or setting the position) detaches the blip, it stays where the player was last
+	void         AttachToPlayer(EntityId blipId, EntityId playerId);
+	EntityId     GetAttachedPlayer(EntityId blipId) { return m_Blips[blipId].attachedPlayer; }
+	// Only sends the long range blips if short range blips are streamed
+	bool         HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
+	void         HandleClientJoinPlayerBlips(EntityId playerId);
 	bool         DoesExist(EntityId blipId);
 	EntityId     GetBlipCount();
 	void		 SwitchIcon(EntityId blipId, bool bShow, EntityId playerId);
@@ -75,5 +125,8 @@ public:
 	int			 GetPlayerBlipSprite(EntityId playerId) { return m_PlayerBlips[playerId].iSprite; }
 	bool		 GetPlayerBlipShow(EntityId playerId) { return m_PlayerBlips[playerId].bShow; }
 
+	void         RemovePlayer(EntityId playerId);
 
+	// Streams the short range blips to the players in range
+	void         Process();
 };
@@ -0,0 +1,128 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBroadcastGroupManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CBroadcastGroupManager.h"
+#include <algorithm>
+
+CBroadcastGroupManager::CBroadcastGroupManager()
+{
+	for(BroadcastGroupId x = 0; x < MAX_BROADCAST_GROUPS; x++)
+	{
+		// The dimension groups always exist
+		m_groups[x].bActive = (x < BROADCAST_GROUP_DIMENSIONS);
+		memset(m_groups[x].bMember, 0, sizeof(m_groups[x].bMember));
+	}
+}
+
+CBroadcastGroupManager::~CBroadcastGroupManager()
+{
+
+}
+
+BroadcastGroupId CBroadcastGroupManager::Create()
+{
+	for(BroadcastGroupId x = BROADCAST_GROUP_DIMENSIONS; x < MAX_BROADCAST_GROUPS; x++)
+	{
+		if(!m_groups[x].bActive)
+		{
+			m_groups[x].bActive = true;
+			return x;
+		}
+	}
+
+	return INVALID_BROADCAST_GROUP;
+}
+
+bool CBroadcastGroupManager::Delete(BroadcastGroupId groupId)
+{
+	// The dimension groups can't be deleted
+	if(groupId < BROADCAST_GROUP_DIMENSIONS || !DoesExist(groupId))
+		return false;
+
+	BroadcastGroup * pGroup = &m_groups[groupId];
+	pGroup->bActive = false;
+	memset(pGroup->bMember, 0, sizeof(pGroup->bMember));
+	pGroup->members.clear();
+	return true;
+}
+
+bool CBroadcastGroupManager::DoesExist(BroadcastGroupId groupId)
+{
+	if(groupId >= MAX_BROADCAST_GROUPS)
+		return false;
+
+	return m_groups[groupId].bActive;
+}
+
+bool CBroadcastGroupManager::AddPlayer(BroadcastGroupId groupId, EntityId playerId)
+{
+	if(!DoesExist(groupId) || playerId >= MAX_PLAYERS)
+		return false;
+
+	BroadcastGroup * pGroup = &m_groups[groupId];
+
+	if(pGroup->bMember[playerId])
+		return false;
+
+	pGroup->bMember[playerId] = true;
+	pGroup->members.push_back(playerId);
+	return true;
+}
+
+bool CBroadcastGroupManager::RemovePlayer(BroadcastGroupId groupId, EntityId playerId)
+{
+	if(!DoesExist(groupId) || playerId >= MAX_PLAYERS)
+		return false;
+
+	BroadcastGroup * pGroup = &m_groups[groupId];
+
+	if(!pGroup->bMember[playerId])
+		return false;
+
+	// Order doesn't matter so swap the player with the last member
+	std::vector<EntityId>::iterator iter = std::find(pGroup->members.begin(), pGroup->members.end(), playerId);
+	*iter = pGroup->members.back();
+	pGroup->members.pop_back();
+	pGroup->bMember[playerId] = false;
+	return true;
+}
+
+bool CBroadcastGroupManager::IsPlayerInGroup(BroadcastGroupId groupId, EntityId playerId)
+{
+	if(!DoesExist(groupId) || playerId >= MAX_PLAYERS)
+		return false;
+
+	return m_groups[groupId].bMember[playerId];
+}
+
+void CBroadcastGroupManager::RemovePlayerFromAll(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	for(BroadcastGroupId x = 0; x < MAX_BROADCAST_GROUPS; x++)
+	{
+		if(m_groups[x].bActive && m_groups[x].bMember[playerId])
+			RemovePlayer(x, playerId);
+	}
+}
+
+void CBroadcastGroupManager::SetPlayerDimension(EntityId playerId, unsigned char ucOldDimension, unsigned char ucNewDimension)
+{
+	RemovePlayer(GetDimensionGroup(ucOldDimension), playerId);
+	AddPlayer(GetDimensionGroup(ucNewDimension), playerId);
+}
+
+const std::vector<EntityId> * CBroadcastGroupManager::GetMembers(BroadcastGroupId groupId)
+{
+	if(!DoesExist(groupId))
+		return NULL;
+
+	return &m_groups[groupId].members;
+}
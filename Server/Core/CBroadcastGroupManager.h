@@ -0,0 +1,54 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CBroadcastGroupManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <vector>
+#include <Common.h>
+
+typedef unsigned short BroadcastGroupId;
+
+// The first groups are the dimensions, every player is always in the group
+// of the dimension they are in
+#define BROADCAST_GROUP_DIMENSIONS 256
+
+// Total amount of groups (script created groups come after the dimensions)
+#define MAX_BROADCAST_GROUPS 1024
+
+#define INVALID_BROADCAST_GROUP 0xFFFF
+
+// Membership of a single broadcast group
+struct BroadcastGroup
+{
+	bool                  bActive;
+	bool                  bMember[MAX_PLAYERS];
+	std::vector<EntityId> members;
+};
+
+class CBroadcastGroupManager
+{
+private:
+	BroadcastGroup m_groups[MAX_BROADCAST_GROUPS];
+
+public:
+	CBroadcastGroupManager();
+	~CBroadcastGroupManager();
+
+	static BroadcastGroupId       GetDimensionGroup(unsigned char ucDimension) { return (BroadcastGroupId)ucDimension; }
+	BroadcastGroupId              Create();
+	bool                          Delete(BroadcastGroupId groupId);
+	bool                          DoesExist(BroadcastGroupId groupId);
+	bool                          AddPlayer(BroadcastGroupId groupId, EntityId playerId);
+	bool                          RemovePlayer(BroadcastGroupId groupId, EntityId playerId);
+	bool                          IsPlayerInGroup(BroadcastGroupId groupId, EntityId playerId);
+	void                          RemovePlayerFromAll(EntityId playerId);
+	void                          SetPlayerDimension(EntityId playerId, unsigned char ucOldDimension, unsigned char ucNewDimension);
+	const std::vector<EntityId> * GetMembers(BroadcastGroupId groupId);
+};
@@ -0,0 +1,200 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CChatManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <algorithm>
+#include "CChatManager.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include "CPlayer.h"
+#include "CSpatialIndex.h"
+#include "CBroadcastGroupManager.h"
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager  * g_pPlayerManager;
+extern CSpatialIndex   * g_pSpatialIndex;
+extern CBroadcastGroupManager * g_pBroadcastGroupManager;
+
+CChatManager::CChatManager()
+{
+	for(ChatChannelId x = 0; x < MAX_CHAT_CHANNELS; x++)
+	{
+		m_channels[x].bActive = false;
+		m_channels[x].type = CHAT_CHANNEL_GLOBAL;
+		m_channels[x].fRadius = 0.0f;
+	}
+
+	m_channels[CHAT_CHANNEL_DEFAULT].bActive = true;
+
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		m_playerChannels[x] = CHAT_CHANNEL_DEFAULT;
+		m_iPlayerTeams[x] = CHAT_TEAM_NONE;
+	}
+}
+
+CChatManager::~CChatManager()
+{
+
+}
+
+ChatChannelId CChatManager::Create(eChatChannelType type, float fRadius)
+{
+	if(type >= CHAT_CHANNEL_TYPE_MAX)
+		return INVALID_CHAT_CHANNEL;
+
+	for(ChatChannelId x = 0; x < MAX_CHAT_CHANNELS; x++)
+	{
+		if(!m_channels[x].bActive)
+		{
+			m_channels[x].bActive = true;
+			m_channels[x].type = type;
+			m_channels[x].fRadius = fRadius;
+			return x;
+		}
+	}
+
+	return INVALID_CHAT_CHANNEL;
+}
+
+bool CChatManager::Delete(ChatChannelId channelId)
+{
+	if(channelId == CHAT_CHANNEL_DEFAULT || !DoesExist(channelId))
+		return false;
+
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		if(m_playerChannels[x] == channelId)
+			m_playerChannels[x] = CHAT_CHANNEL_DEFAULT;
+	}
+
+	m_channels[channelId].bActive = false;
+	return true;
+}
+
+bool CChatManager::DoesExist(ChatChannelId channelId)
+{
+	if(channelId >= MAX_CHAT_CHANNELS)
+		return false;
+
+	return m_channels[channelId].bActive;
+}
+
+bool CChatManager::Set(ChatChannelId channelId, eChatChannelType type, float fRadius)
+{
+	if(!DoesExist(channelId) || type >= CHAT_CHANNEL_TYPE_MAX)
+		return false;
+
+	m_channels[channelId].type = type;
+	m_channels[channelId].fRadius = fRadius;
+	return true;
+}
+
+bool CChatManager::SetPlayerChannel(EntityId playerId, ChatChannelId channelId)
+{
+	if(playerId >= MAX_PLAYERS || !DoesExist(channelId))
+		return false;
+
+	m_playerChannels[playerId] = channelId;
+	return true;
+}
+
+ChatChannelId CChatManager::GetPlayerChannel(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return INVALID_CHAT_CHANNEL;
+
+	return m_playerChannels[playerId];
+}
+
+bool CChatManager::SetPlayerTeam(EntityId playerId, int iTeam)
+{
+	if(playerId >= MAX_PLAYERS)
+		return false;
+
+	m_iPlayerTeams[playerId] = iTeam;
+	return true;
+}
+
+int CChatManager::GetPlayerTeam(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return CHAT_TEAM_NONE;
+
+	return m_iPlayerTeams[playerId];
+}
+
+void CChatManager::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_playerChannels[playerId] = CHAT_CHANNEL_DEFAULT;
+	m_iPlayerTeams[playerId] = CHAT_TEAM_NONE;
+}
+
+void CChatManager::Send(EntityId playerId, const String& strText)
+{
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer)
+		return;
+
+	ChatChannel * pChannel = &m_channels[m_playerChannels[playerId]];
+
+	// Global chat goes out in a single broadcast
+	if(pChannel->type == CHAT_CHANNEL_GLOBAL)
+	{
+		CBitStream bsSend;
+		bsSend.WriteCompressed(playerId);
+		bsSend.Write(strText);
+		g_pNetworkManager->RPC(RPC_Chat, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_CHAT);
+		return;
+	}
+
+	m_recipients.clear();
+
+	if(pChannel->type == CHAT_CHANNEL_PROXIMITY)
+	{
+		CVector3 vecPosition;
+		unsigned char ucDimension;
+
+		if(g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, playerId, vecPosition, ucDimension))
+			g_pSpatialIndex->GetInRange(SPATIAL_INDEX_PLAYER, vecPosition, pChannel->fRadius, ucDimension, m_recipients);
+	}
+	else if(pChannel->type == CHAT_CHANNEL_DIMENSION)
+	{
+		const std::vector<EntityId> * pMembers = g_pBroadcastGroupManager->GetMembers(CBroadcastGroupManager::GetDimensionGroup(pPlayer->GetDimension()));
+
+		if(pMembers)
+			m_recipients = *pMembers;
+	}
+	else if(pChannel->type == CHAT_CHANNEL_TEAM)
+	{
+		const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+		int iTeam = m_iPlayerTeams[playerId];
+
+		for(size_t i = 0; i < players.size(); i++)
+		{
+			if(m_iPlayerTeams[players[i]] == iTeam)
+				m_recipients.push_back(players[i]);
+		}
+	}
+
+	// The sender always sees their own chat (it isn't in the spatial index before it spawned)
+	if(std::find(m_recipients.begin(), m_recipients.end(), playerId) == m_recipients.end())
+		m_recipients.push_back(playerId);
+
+	// Write the rpc once, every recipient is sent the same bit stream
+	CBitStream bsSend;
+	bsSend.PadWithZeroToByteLength(RPC_HEADER_SIZE);
+	bsSend.WriteCompressed(playerId);
+	bsSend.Write(strText);
+	m_bitStreams.assign(m_recipients.size(), &bsSend);
+	g_pNetworkManager->RPCReservedBatch(RPC_Chat, &m_bitStreams[0], &m_recipients[0], (unsigned int)m_recipients.size(), PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, PACKET_CHANNEL_CHAT);
+}
@@ -0,0 +1,74 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CChatManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <vector>
+#include <CString.h>
+#include <Common.h>
+
+typedef unsigned short ChatChannelId;
+
+#define MAX_CHAT_CHANNELS 256
+
+#define INVALID_CHAT_CHANNEL 0xFFFF
+
+// Channel every player is in until a script moves them
+#define CHAT_CHANNEL_DEFAULT 0
+
+// Team of players that aren't in a team
+#define CHAT_TEAM_NONE 0
+
+enum eChatChannelType
+{
+	CHAT_CHANNEL_GLOBAL,    // Everyone
+	CHAT_CHANNEL_PROXIMITY, // Players in the dimension of the sender within the radius
+	CHAT_CHANNEL_DIMENSION, // Players in the dimension of the sender
+	CHAT_CHANNEL_TEAM,      // Players in the team of the sender
+	CHAT_CHANNEL_TYPE_MAX
+};
+
+struct ChatChannel
+{
+	bool             bActive;
+	eChatChannelType type;
+	float            fRadius; // Proximity channels only
+};
+
+// The channel each player talks in, the chat of a player is sent to the
+// players its channel selects straight from here
+class CChatManager
+{
+private:
+	ChatChannel               m_channels[MAX_CHAT_CHANNELS];
+	ChatChannelId             m_playerChannels[MAX_PLAYERS];
+	int                       m_iPlayerTeams[MAX_PLAYERS];
+	std::vector<EntityId>     m_recipients;
+	std::vector<CBitStream *> m_bitStreams; // The same bit stream for every recipient
+
+public:
+	CChatManager();
+	~CChatManager();
+
+	ChatChannelId Create(eChatChannelType type, float fRadius);
+	// Players in the channel are moved back to the default channel, which can't be deleted
+	bool          Delete(ChatChannelId channelId);
+	bool          DoesExist(ChatChannelId channelId);
+	bool          Set(ChatChannelId channelId, eChatChannelType type, float fRadius);
+	bool          SetPlayerChannel(EntityId playerId, ChatChannelId channelId);
+	ChatChannelId GetPlayerChannel(EntityId playerId);
+	bool          SetPlayerTeam(EntityId playerId, int iTeam);
+	int           GetPlayerTeam(EntityId playerId);
+	void          RemovePlayer(EntityId playerId);
+
+	// Sends the chat of the player to the players its channel selects, the rpc is
+	// written once for all of them
+	void          Send(EntityId playerId, const String& strText);
+};
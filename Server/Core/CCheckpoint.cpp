@@ -10,23 +10,32 @@
 #include "CCheckpoint.h"
 #include "CNetworkManager.h"
 #include "CPlayerManager.h"
+#include "CCheckpointManager.h"
+#include "CSpatialIndex.h"
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CPlayerManager  * g_pPlayerManager;
+extern CCheckpointManager * g_pCheckpointManager;
+extern CSpatialIndex   * g_pSpatialIndex;
 
 CCheckpoint::CCheckpoint(EntityId checkpointId, WORD wType, CVector3 vecPosition, CVector3 vecTargetPosition, float fRadius)
 {
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CCheckpoint));
 	m_checkpointId = checkpointId;
 	m_wType = wType;
 	m_vecPosition = vecPosition;
 	m_vecTargetPosition = vecTargetPosition;
 	m_fRadius = fRadius;
 	m_bShow = true;
+	m_ucDimension = 0;
+	memset(m_bShownForPlayer, 0, sizeof(m_bShownForPlayer));
+	memset(m_ucStaleFields, 0, sizeof(m_ucStaleFields));
 }
 
 CCheckpoint::~CCheckpoint()
 {
-
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CCheckpoint));
 }
 
 void CCheckpoint::AddForPlayer(EntityId playerId)
@@ -38,6 +47,7 @@ void CCheckpoint::AddForPlayer(EntityId playerId)
 	bsSend.Write(m_vecTargetPosition);
 	bsSend.Write(m_fRadius);
 	g_pNetworkManager->RPC(RPC_NewCheckpoint, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+	m_ucStaleFields[playerId] = 0;
 
 	if(m_bShow)
 		ShowForPlayer(playerId);
@@ -47,11 +57,10 @@ void CCheckpoint::AddForPlayer(EntityId playerId)
 
 void CCheckpoint::AddForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
-	{
-		if(g_pPlayerManager->DoesExist(i))
-			AddForPlayer(i);
-	}
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+		AddForPlayer(players[i]);
 }
 
 void CCheckpoint::DeleteForPlayer(EntityId playerId)
@@ -63,15 +72,20 @@ void CCheckpoint::DeleteForPlayer(EntityId playerId)
 
 void CCheckpoint::DeleteForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
-	{
-		if(g_pPlayerManager->DoesExist(i))
-			DeleteForPlayer(i);
-	}
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+		DeleteForPlayer(players[i]);
 }
 
 void CCheckpoint::ShowForPlayer(EntityId playerId)
 {
+	// The show carries the positions, the other fields are sent before it
+	m_bShownForPlayer[playerId] = true;
+	g_pCheckpointManager->RetestPlayers(m_fRadius);
+	m_ucStaleFields[playerId] &= ~(CHECKPOINT_FIELD_POSITION | CHECKPOINT_FIELD_TARGET_POSITION);
+	UpdateForPlayer(playerId);
+
 	CBitStream bsSend;
 	bsSend.Write(m_checkpointId);
 	bsSend.Write(m_vecPosition);
@@ -81,16 +95,17 @@ void CCheckpoint::ShowForPlayer(EntityId playerId)
 
 void CCheckpoint::ShowForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
-	{
-		if(g_pPlayerManager->DoesExist(i))
-			ShowForPlayer(i);
-	}
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+		ShowForPlayer(players[i]);
 	m_bShow = true;
 }
 
 void CCheckpoint::HideForPlayer(EntityId playerId)
 {
+	m_bShownForPlayer[playerId] = false;
+	g_pCheckpointManager->RetestPlayers(m_fRadius);
 	CBitStream bsSend;
 	bsSend.Write(m_checkpointId);
 	g_pNetworkManager->RPC(RPC_ScriptingHideCheckpointForPlayer, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
@@ -98,62 +113,103 @@ void CCheckpoint::HideForPlayer(EntityId playerId)
 
 void CCheckpoint::HideForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+		HideForPlayer(players[i]);
+	m_bShow = false;
+}
+
+void CCheckpoint::Update(unsigned char ucFields)
+{
+	g_pCheckpointManager->RetestPlayers(m_fRadius);
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	// Only the players that can see the checkpoint get the change now, the others
+	// get it once they can
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i))
-			HideForPlayer(i);
+		m_ucStaleFields[players[i]] |= ucFields;
+		UpdateForPlayer(players[i]);
 	}
-	m_bShow = false;
+}
+
+void CCheckpoint::UpdateForPlayer(EntityId playerId)
+{
+	unsigned char ucFields = m_ucStaleFields[playerId];
+
+	if(ucFields == 0 || !m_bShownForPlayer[playerId])
+		return;
+
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer || pPlayer->GetDimension() != m_ucDimension)
+		return;
+
+	CBitStream bsSend;
+	bsSend.WriteCompressed(m_checkpointId);
+	bsSend.Write(ucFields);
+
+	if(ucFields & CHECKPOINT_FIELD_TYPE)
+		bsSend.Write(m_wType);
+
+	if(ucFields & CHECKPOINT_FIELD_POSITION)
+		bsSend.Write(m_vecPosition);
+
+	if(ucFields & CHECKPOINT_FIELD_TARGET_POSITION)
+		bsSend.Write(m_vecTargetPosition);
+
+	if(ucFields & CHECKPOINT_FIELD_RADIUS)
+		bsSend.Write(m_fRadius);
+
+	g_pNetworkManager->RPC(RPC_UpdateCheckpoint, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+	m_ucStaleFields[playerId] = 0;
 }
 
 void CCheckpoint::SetType(WORD wType)
 {
 	// Set the type
 	m_wType = wType;
-
-	// Respawn the checkpoint
-	HideForWorld();
-	ShowForWorld();
+	Update(CHECKPOINT_FIELD_TYPE);
 }
 
 void CCheckpoint::SetPosition(CVector3 vecPosition)
 {
 	// Set the position
 	m_vecPosition = vecPosition;
-
-	// Respawn the checkpoint
-	HideForWorld();
-	ShowForWorld();
+	g_pSpatialIndex->Update(SPATIAL_INDEX_CHECKPOINT, m_checkpointId, m_vecPosition, m_ucDimension);
+	Update(CHECKPOINT_FIELD_POSITION);
 }
 
 void CCheckpoint::SetTargetPosition(CVector3 vecTargetPosition)
 {
 	// Set the target position
 	m_vecTargetPosition = vecTargetPosition;
-
-	// Respawn the checkpoint
-	HideForWorld();
-	ShowForWorld();
+	Update(CHECKPOINT_FIELD_TARGET_POSITION);
 }
 
 void CCheckpoint::SetRadius(float fRadius)
 {
 	// Set the radius
 	m_fRadius = fRadius;
-
-	// Respawn the checkpoint
-	HideForWorld();
-	ShowForWorld();
+	Update(CHECKPOINT_FIELD_RADIUS);
 }
 
-
 void CCheckpoint::SetDimension(unsigned char ucDimension)
 {
 	m_ucDimension = ucDimension;
+	g_pSpatialIndex->Update(SPATIAL_INDEX_CHECKPOINT, m_checkpointId, m_vecPosition, m_ucDimension);
+	g_pCheckpointManager->RetestPlayers(m_fRadius);
 
 	CBitStream bsSend;
 	bsSend.WriteCompressed(GetCheckpointId());
 	bsSend.Write(ucDimension);
 
 	g_pNetworkManager->RPC(RPC_ScriptingSetCheckpointDimension, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+
+	// The players in the new dimension get what they missed
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+		UpdateForPlayer(players[i]);
 }
@@ -22,6 +22,10 @@ private:
 	float    m_fRadius;
 	bool	 m_bShow;
 	unsigned char m_ucDimension;
+	bool     m_bShownForPlayer[MAX_PLAYERS];
+	unsigned char m_ucStaleFields[MAX_PLAYERS]; // Fields changed while the player couldn't see it
+
+	void     Update(unsigned char ucFields);
 
 public:
 	CCheckpoint(EntityId checkpointId, WORD wType, CVector3 vecPosition, CVector3 vecTargetPosition, float fRadius);
@@ -36,12 +40,17 @@ public:
 	void     ShowForWorld();
 	void     HideForPlayer(EntityId playerId);
 	void     HideForWorld();
+
+	// Sends the player the fields it missed if it can see the checkpoint now
+	void     UpdateForPlayer(EntityId playerId);
+	bool     IsShown() { return m_bShow; }
+	bool     IsShownForPlayer(EntityId playerId) { return m_bShownForPlayer[playerId]; }
 	void     SetType(WORD wType);
 	WORD     GetType() { return m_wType; }
 	void     SetPosition(CVector3 vecPosition);
 	void     GetPosition(CVector3& vecPosition) { vecPosition = m_vecPosition; }
 	void     SetTargetPosition(CVector3 vecTargetPosition);
-	void     GetTargetPosition(CVector3& vecTargetPosition) { vecTargetPosition = m_vecPosition; }
+	void     GetTargetPosition(CVector3& vecTargetPosition) { vecTargetPosition = m_vecTargetPosition; }
 	void     SetRadius(float fRadius);
 	float    GetRadius() { return m_fRadius; }
 	void	 SetDimension(unsigned char ucDimension);
@@ -11,57 +11,73 @@
 #include "CCheckpointManager.h"
 #include "CNetworkManager.h"
 #include "CEvents.h"
+#include "CPlayerManager.h"
+#include "CSpatialIndex.h"
+#include <algorithm>
+#include <iterator>
+#include <CMemoryTracker.h>
+
+// Rough size of the rpcs sent for a single checkpoint on join
+#define CHECKPOINT_JOIN_SIZE 48
 
 extern CNetworkManager * g_pNetworkManager;
 extern CEvents         * g_pEvents;
+extern CPlayerManager  * g_pPlayerManager;
+extern CSpatialIndex   * g_pSpatialIndex;
 
 CCheckpointManager::CCheckpointManager()
 {
-	for(EntityId i = 0; i < MAX_CHECKPOINTS; i++)
-		m_pCheckpoints[i] = NULL;
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CCheckpointManager));
+
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		m_players[x].bActive = false;
+		m_players[x].bRetest = false;
+		m_players[x].ucDimension = 0;
+	}
+
+	m_fMaxRange = 0.0f;
+	m_bRetestAll = false;
 }
 
 CCheckpointManager::~CCheckpointManager()
 {
-	for(EntityId i = 0; i < MAX_CHECKPOINTS; i++)
-	{
-		if(m_pCheckpoints[i])
-			Delete(i);
-	}
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CCheckpointManager));
+
+	for(EntityId i = m_checkpoints.GetFirst(); i != INVALID_ENTITY_ID; i = m_checkpoints.GetFirst(i + 1))
+		Delete(i);
 }
 
 EntityId CCheckpointManager::Add(WORD wType, CVector3 vecPosition, CVector3 vecTargetPosition, float fRadius)
 {
-	// Loop through all checkpoints
-	for(EntityId i = 0; i < MAX_CHECKPOINTS; i++)
-	{
-		// Does this checkpoint not exist?
-		if(!m_pCheckpoints[i])
-		{
-			// Create the checkpoint
-			CCheckpoint * pCheckpoint = new CCheckpoint(i, wType, vecPosition, vecTargetPosition, fRadius);
+	// Find a free checkpoint id
+	EntityId i = m_checkpoints.GetFree();
 
-			// Set the checkpoint
-			m_pCheckpoints[i] = pCheckpoint;
+	if(i == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
 
-			// Add it for all players
-			pCheckpoint->AddForWorld();
+	// Create the checkpoint
+	CCheckpoint * pCheckpoint = new CCheckpoint(i, wType, vecPosition, vecTargetPosition, fRadius);
 
-			// Call the 'checkpointCreate' scripting event
-			CSquirrelArguments pArguments;
-			pArguments.push(i);
-			g_pEvents->Call("checkpointCreate", &pArguments);
-			return i;
-		}
-	}
+	// Set the checkpoint
+	*m_checkpoints.Add(i) = pCheckpoint;
+	g_pSpatialIndex->Update(SPATIAL_INDEX_CHECKPOINT, i, vecPosition, 0);
+	RetestPlayers(fRadius);
 
-	return INVALID_ENTITY_ID;
+	// Add it for all players
+	pCheckpoint->AddForWorld();
+
+	// Call the 'checkpointCreate' scripting event
+	CSquirrelArguments pArguments;
+	pArguments.push(i);
+	g_pEvents->Call("checkpointCreate", &pArguments);
+	return i;
 }
 
 bool CCheckpointManager::Delete(EntityId checkpointId)
 {
 	// Does this checkpoint not exist?
-	if(!m_pCheckpoints[checkpointId])
+	if(!m_checkpoints.DoesExist(checkpointId))
 		return false;
 
 	// Call the 'checkpointDelete' scripting event
@@ -70,53 +86,236 @@ bool CCheckpointManager::Delete(EntityId checkpointId)
 	g_pEvents->Call("checkpointDelete", &pArguments);
 
 	// Delete the checkpoint for all players
-	m_pCheckpoints[checkpointId]->DeleteForWorld();
+	m_checkpoints[checkpointId]->DeleteForWorld();
+	g_pSpatialIndex->Remove(SPATIAL_INDEX_CHECKPOINT, checkpointId);
+
+	// Nobody is in it anymore (without a leave event, like zones)
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		std::vector<EntityId>& checkpoints = m_players[x].checkpoints;
+		std::vector<EntityId>::iterator iter = std::lower_bound(checkpoints.begin(), checkpoints.end(), checkpointId);
+
+		if(iter != checkpoints.end() && *iter == checkpointId)
+			checkpoints.erase(iter);
+	}
+
+	m_entered.erase(checkpointId);
+	m_left.erase(checkpointId);
 
 	// Delete the checkpoint
-	SAFE_DELETE(m_pCheckpoints[checkpointId]);
+	delete m_checkpoints[checkpointId];
+	m_checkpoints.Remove(checkpointId);
 	return true;
 }
 
-void CCheckpointManager::HandleClientJoin(EntityId playerId)
+bool CCheckpointManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
 {
-	// Loop through all checkpoints
-	for(EntityId i = 0; i < MAX_CHECKPOINTS; i++)
+	// Loop through the checkpoints until we have sent about a messages worth
+	EntityId i = m_checkpoints.GetFirst(pCursor->entityId);
+
+	for(; i != INVALID_ENTITY_ID && pCursor->uiBytes < JOIN_STREAM_MESSAGE_SIZE; i = m_checkpoints.GetFirst(i + 1))
 	{
-		// Does this checkpoint exist?
-		if(m_pCheckpoints[i])
+		// Add it for the player
+		CCheckpoint * pCheckpoint = m_checkpoints[i];
+		pCheckpoint->AddForPlayer(playerId);
+		pCursor->uiBytes += CHECKPOINT_JOIN_SIZE;
+		pCursor->uiEntities++;
+
+		// Send its dimension to the player (checkpoints are in dimension 0 by default)
+		if(pCheckpoint->GetDimension() != 0)
 		{
-			// Add it for the player
-			m_pCheckpoints[i]->AddForPlayer(playerId);
-			m_pCheckpoints[i]->SetDimension(m_pCheckpoints[i]->GetDimension());
+			CBitStream bsSend;
+			bsSend.WriteCompressed(i);
+			bsSend.Write(pCheckpoint->GetDimension());
+			g_pNetworkManager->RPC(RPC_ScriptingSetCheckpointDimension, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 		}
 	}
+
+	pCursor->entityId = i;
+	return (i >= MAX_CHECKPOINTS);
 }
 
-bool CCheckpointManager::DoesExist(EntityId checkpointId)
+void CCheckpointManager::HandlePlayerDimension(EntityId playerId)
 {
-	if(checkpointId >= MAX_CHECKPOINTS)
+	for(EntityId i = m_checkpoints.GetFirst(); i != INVALID_ENTITY_ID; i = m_checkpoints.GetFirst(i + 1))
+		m_checkpoints[i]->UpdateForPlayer(playerId);
+}
+
+void CCheckpointManager::HintPlayer(EntityId playerId)
+{
+	if(playerId < MAX_PLAYERS)
+		m_players[playerId].bRetest = true;
+}
+
+void CCheckpointManager::RetestPlayers(float fRadius)
+{
+	m_bRetestAll = true;
+
+	// The range only grows, it is just the reach of the queries
+	if((fRadius * CHECKPOINT_RADIUS_SCALE) > m_fMaxRange)
+		m_fMaxRange = (fRadius * CHECKPOINT_RADIUS_SCALE);
+}
+
+bool CCheckpointManager::IsPlayerInCheckpoint(EntityId playerId, EntityId checkpointId)
+{
+	if(playerId >= MAX_PLAYERS)
 		return false;
 
-	return (m_pCheckpoints[checkpointId] != NULL);
+	return std::binary_search(m_players[playerId].checkpoints.begin(), m_players[playerId].checkpoints.end(), checkpointId);
 }
 
-CCheckpoint * CCheckpointManager::Get(EntityId checkpointId)
+void CCheckpointManager::RemovePlayer(EntityId playerId)
 {
-	if(checkpointId >= MAX_CHECKPOINTS)
-		return NULL;
+	if(playerId >= MAX_PLAYERS)
+		return;
 
-	return m_pCheckpoints[checkpointId];
+	m_players[playerId].bActive = false;
+	m_players[playerId].bRetest = false;
+	m_players[playerId].checkpoints.clear();
 }
 
-EntityId CCheckpointManager::GetCheckpointCount()
+void CCheckpointManager::TestPlayer(EntityId playerId, const CVector3& vecPosition, unsigned char ucDimension)
+{
+	CheckpointPlayer * pPlayer = &m_players[playerId];
+	pPlayer->bActive = true;
+	pPlayer->bRetest = false;
+	pPlayer->vecPosition = vecPosition;
+	pPlayer->ucDimension = ucDimension;
+
+	// Only the checkpoints near the player that are shown to it count
+	std::vector<EntityId> nearby;
+	std::vector<EntityId> checkpoints;
+	g_pSpatialIndex->GetInRange(SPATIAL_INDEX_CHECKPOINT, vecPosition, m_fMaxRange, ucDimension, nearby);
+
+	for(std::vector<EntityId>::iterator iter = nearby.begin(); iter != nearby.end(); ++iter)
+	{
+		CCheckpoint * pCheckpoint = Get(*iter);
+
+		if(!pCheckpoint || !pCheckpoint->IsShownForPlayer(playerId))
+			continue;
+
+		CVector3 vecCheckpointPosition;
+		pCheckpoint->GetPosition(vecCheckpointPosition);
+
+		if((vecCheckpointPosition - vecPosition).Length() <= (pCheckpoint->GetRadius() * CHECKPOINT_RADIUS_SCALE))
+			checkpoints.push_back(*iter);
+	}
+
+	std::sort(checkpoints.begin(), checkpoints.end());
+
+	if(checkpoints == pPlayer->checkpoints)
+		return;
+
+	std::vector<EntityId> left;
+	std::vector<EntityId> entered;
+	std::set_difference(pPlayer->checkpoints.begin(), pPlayer->checkpoints.end(), checkpoints.begin(), checkpoints.end(), std::back_inserter(left));
+	std::set_difference(checkpoints.begin(), checkpoints.end(), pPlayer->checkpoints.begin(), pPlayer->checkpoints.end(), std::back_inserter(entered));
+	pPlayer->checkpoints.swap(checkpoints);
+
+	for(std::vector<EntityId>::iterator iter = left.begin(); iter != left.end(); ++iter)
+		m_left[*iter].push_back(playerId);
+
+	for(std::vector<EntityId>::iterator iter = entered.begin(); iter != entered.end(); ++iter)
+		m_entered[*iter].push_back(playerId);
+}
+
+void CCheckpointManager::CallEvents(std::map<EntityId, std::vector<EntityId> >& players, const char * szEvent, const char * szPlayerEvent)
 {
-	EntityId checkpointCount = 0;
+	// The handlers can delete checkpoints and kick players so work on a copy
+	// and check both still exist before each call
+	std::map<EntityId, std::vector<EntityId> > calls;
+	calls.swap(players);
+	bool bPlayerEvent = g_pEvents->IsEventRegistered(szPlayerEvent);
 
-	for(EntityId i = 0; i < MAX_CHECKPOINTS; i++)
+	for(std::map<EntityId, std::vector<EntityId> >::iterator iter = calls.begin(); iter != calls.end(); ++iter)
 	{
-		if(m_pCheckpoints[i])
-			checkpointCount++;
+		if(!DoesExist(iter->first))
+			continue;
+
+		CSquirrelArguments playerIds;
+
+		for(std::vector<EntityId>::iterator playerIter = iter->second.begin(); playerIter != iter->second.end(); ++playerIter)
+		{
+			if(g_pPlayerManager->DoesExist(*playerIter))
+				playerIds.push(*playerIter);
+		}
+
+		CSquirrelArguments pArguments;
+		pArguments.push(iter->first);
+		pArguments.push(playerIds, true);
+		g_pEvents->Call(szEvent, &pArguments);
+
+		// The old event with a call for each player is only called if a script uses it
+		if(!bPlayerEvent)
+			continue;
+
+		for(std::vector<EntityId>::iterator playerIter = iter->second.begin(); playerIter != iter->second.end() && DoesExist(iter->first); ++playerIter)
+		{
+			if(!g_pPlayerManager->DoesExist(*playerIter))
+				continue;
+
+			CSquirrelArguments playerArguments;
+			playerArguments.push(*playerIter);
+			playerArguments.push(iter->first);
+			g_pEvents->Call(szPlayerEvent, &playerArguments);
+		}
 	}
+}
+
+void CCheckpointManager::Process()
+{
+	if(m_checkpoints.GetCount() == 0)
+		return;
+
+	bool bRetestAll = m_bRetestAll;
+	m_bRetestAll = false;
+
+	// Only players that moved (or changed dimension or were hinted at) since they
+	// were last tested are tested again
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		EntityId x = players[i];
+		CVector3 vecPosition;
+		unsigned char ucDimension;
 
-	return checkpointCount;
+		if(!g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, x, vecPosition, ucDimension))
+		{
+			if(m_players[x].bActive)
+				RemovePlayer(x);
+
+			continue;
+		}
+
+		CheckpointPlayer * pPlayer = &m_players[x];
+
+		if(!bRetestAll && !pPlayer->bRetest && pPlayer->bActive && pPlayer->ucDimension == ucDimension && pPlayer->vecPosition.fX == vecPosition.fX &&
+			pPlayer->vecPosition.fY == vecPosition.fY && pPlayer->vecPosition.fZ == vecPosition.fZ)
+			continue;
+
+		TestPlayer(x, vecPosition, ucDimension);
+	}
+
+	// Leaves first so a player going from one checkpoint into the next sees them in order
+	CallEvents(m_left, "playersLeaveCheckpoint", "playerLeaveCheckpoint");
+	CallEvents(m_entered, "playersEnterCheckpoint", "playerEnterCheckpoint");
+}
+
+bool CCheckpointManager::DoesExist(EntityId checkpointId)
+{
+	return m_checkpoints.DoesExist(checkpointId);
+}
+
+CCheckpoint * CCheckpointManager::Get(EntityId checkpointId)
+{
+	if(!m_checkpoints.DoesExist(checkpointId))
+		return NULL;
+
+	return m_checkpoints[checkpointId];
+}
+
+EntityId CCheckpointManager::GetCheckpointCount()
+{
+	return (EntityId)m_checkpoints.GetCount();
 }
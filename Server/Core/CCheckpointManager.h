@@ -13,11 +13,40 @@
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
 #include "CCheckpoint.h"
+#include "CJoinStreamer.h"
+#include "CEntityPool.h"
+#include <map>
+#include <vector>
 
+// The game enters (and draws) checkpoints at this many times their radius
+#define CHECKPOINT_RADIUS_SCALE 5.0f
+
+// Checkpoints the player is in and the position they were tested at
+struct CheckpointPlayer
+{
+	bool                  bActive;
+	bool                  bRetest;     // The client reported a change we haven't seen yet
+	CVector3              vecPosition;
+	unsigned char         ucDimension;
+	std::vector<EntityId> checkpoints; // Sorted
+};
+
+// Tests the player positions of the spatial index against the checkpoints near
+// them every tick the players moved, the enters and leaves of a tick are called
+// as one event per checkpoint with all the players. What the clients report is
+// only taken as a hint to test the player again.
 class CCheckpointManager : CCheckpointManagerInterface
 {
 private:
-	CCheckpoint * m_pCheckpoints[MAX_CHECKPOINTS];
+	CEntityPool<CCheckpoint *, MAX_CHECKPOINTS> m_checkpoints;
+	CheckpointPlayer                            m_players[MAX_PLAYERS];
+	float                                       m_fMaxRange;     // Largest entry range of a checkpoint
+	bool                                        m_bRetestAll;
+	std::map<EntityId, std::vector<EntityId> >  m_entered;       // Players by checkpoint for this tick
+	std::map<EntityId, std::vector<EntityId> >  m_left;
+
+	void          TestPlayer(EntityId playerId, const CVector3& vecPosition, unsigned char ucDimension);
+	void          CallEvents(std::map<EntityId, std::vector<EntityId> >& players, const char * szEvent, const char * szPlayerEvent);
 
 public:
 	CCheckpointManager();
@@ -25,7 +54,19 @@ public:
 
 	EntityId      Add(WORD wType, CVector3 vecPosition, CVector3 vecTargetPosition, float fRadius);
 	bool          Delete(EntityId checkpointId);
-	void          HandleClientJoin(EntityId playerId);
+	bool          HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
+
+	// Sends the checkpoint changes a player missed in its old dimension
+	void          HandlePlayerDimension(EntityId playerId);
+
+	// Tests the player again next tick even if it didn't move
+	void          HintPlayer(EntityId playerId);
+
+	// Tests all players again next tick, for checkpoints that moved or were shown or hidden
+	void          RetestPlayers(float fRadius);
+	bool          IsPlayerInCheckpoint(EntityId playerId, EntityId checkpointId);
+	void          RemovePlayer(EntityId playerId);
+	void          Process();
 	bool          DoesExist(EntityId checkpointId);
 	CCheckpoint * Get(EntityId checkpointId);
 	EntityId      GetCheckpointCount();
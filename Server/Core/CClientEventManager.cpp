@@ -0,0 +1,170 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CClientEventManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CClientEventManager.h"
+#include <SharedUtility.h>
+#include <CSettings.h>
+
+extern CEvents * g_pEvents;
+
+// The limit of the events scripts didn't set one for
+static CSettingHandle g_clientEventRateSetting("clienteventrate");
+static CSettingHandle g_clientEventBurstSetting("clienteventburst");
+
+CClientEventManager::CClientEventManager()
+{
+
+}
+
+CClientEventManager::~CClientEventManager()
+{
+
+}
+
+ClientEventRule CClientEventManager::GetRule(EventId eventId)
+{
+	std::map<EventId, ClientEventRule>::iterator iter = m_rules.find(eventId);
+
+	if(iter != m_rules.end())
+		return (*iter).second;
+
+	ClientEventRule rule;
+	rule.fRate = (float)g_clientEventRateSetting.GetInteger();
+	rule.fBurst = (float)g_clientEventBurstSetting.GetInteger();
+	rule.bCoalesce = false;
+	return rule;
+}
+
+bool CClientEventManager::TakeToken(EntityId playerId, EventId eventId, const ClientEventRule& rule)
+{
+	if(rule.fRate <= 0.0f)
+		return true;
+
+	unsigned long ulTime = SharedUtility::GetTime();
+	std::map<EventId, ClientEventBucket>::iterator iter = m_buckets[playerId].find(eventId);
+
+	// A new bucket starts full
+	if(iter == m_buckets[playerId].end())
+	{
+		ClientEventBucket bucket;
+		bucket.fTokens = rule.fBurst;
+		bucket.ulLastTime = ulTime;
+		iter = m_buckets[playerId].insert(std::pair<EventId, ClientEventBucket>(eventId, bucket)).first;
+	}
+
+	ClientEventBucket& bucket = (*iter).second;
+	bucket.fTokens += (((ulTime - bucket.ulLastTime) * rule.fRate) / 1000.0f);
+	bucket.ulLastTime = ulTime;
+
+	if(bucket.fTokens > rule.fBurst)
+		bucket.fTokens = rule.fBurst;
+
+	if(bucket.fTokens < 1.0f)
+		return false;
+
+	bucket.fTokens -= 1.0f;
+	return true;
+}
+
+void CClientEventManager::Call(EventId eventId, CSquirrelArguments * pArguments)
+{
+	unsigned long long ullStartTime = SharedUtility::GetMicroseconds();
+	g_pEvents->Call(eventId, pArguments);
+
+	// Looked up after the call as the handlers can reset the stats
+	ClientEventStats& stats = m_stats[eventId];
+	stats.ullTime += (SharedUtility::GetMicroseconds() - ullStartTime);
+	stats.uiCalled++;
+}
+
+void CClientEventManager::SetLimit(EventId eventId, float fRate, float fBurst)
+{
+	ClientEventRule rule = GetRule(eventId);
+	rule.fRate = fRate;
+	rule.fBurst = (fBurst < 1.0f ? 1.0f : fBurst);
+	m_rules[eventId] = rule;
+
+	// The buckets refill to the new burst
+	for(unsigned int i = 0; i < MAX_PLAYERS; i++)
+		m_buckets[i].erase(eventId);
+}
+
+void CClientEventManager::SetCoalesced(EventId eventId, bool bCoalesce)
+{
+	ClientEventRule rule = GetRule(eventId);
+	rule.bCoalesce = bCoalesce;
+	m_rules[eventId] = rule;
+}
+
+void CClientEventManager::OnEvent(EntityId playerId, EventId eventId, CBitStream * pBitStream)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	ClientEventRule rule = GetRule(eventId);
+	ClientEventStats& stats = m_stats[eventId];
+	stats.uiReceived++;
+
+	// Don't even read the arguments of the events over the limit
+	if(!TakeToken(playerId, eventId, rule))
+	{
+		stats.uiDropped++;
+		return;
+	}
+
+	// The player id comes before the arguments of the event
+	if(rule.bCoalesce)
+	{
+		CSquirrelArguments& arguments = m_pending[PendingKey(playerId, eventId)];
+
+		if(!arguments.empty())
+		{
+			stats.uiCoalesced++;
+			arguments.reset();
+		}
+
+		arguments.push((int)playerId);
+		arguments.deserialize(pBitStream);
+		return;
+	}
+
+	CSquirrelArguments arguments;
+	arguments.push((int)playerId);
+	arguments.deserialize(pBitStream);
+	Call(eventId, &arguments);
+}
+
+void CClientEventManager::Process()
+{
+	if(m_pending.empty())
+		return;
+
+	// Take the events of this tick so the map isn't changed while it is walked
+	std::map<PendingKey, CSquirrelArguments> pending;
+	pending.swap(m_pending);
+
+	for(std::map<PendingKey, CSquirrelArguments>::iterator iter = pending.begin(); iter != pending.end(); ++iter)
+		Call((*iter).first.second, &(*iter).second);
+}
+
+void CClientEventManager::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_buckets[playerId].clear();
+
+	for(std::map<PendingKey, CSquirrelArguments>::iterator iter = m_pending.begin(); iter != m_pending.end(); )
+	{
+		if((*iter).first.first == playerId)
+			m_pending.erase(iter++);
+		else
+			++iter;
+	}
+}
@@ -0,0 +1,74 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CClientEventManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <CEvents.h>
+#include <Network/CBitStream.h>
+
+struct ClientEventRule
+{
+	float fRate;  // Events per second a player can send, 0 for no limit
+	float fBurst; // Events a player can send at once
+	bool  bCoalesce;
+};
+
+struct ClientEventBucket
+{
+	float         fTokens;
+	unsigned long ulLastTime;
+};
+
+struct ClientEventStats
+{
+	unsigned int       uiReceived;
+	unsigned int       uiCalled;
+	unsigned int       uiDropped;   // Over the limit of the event
+	unsigned int       uiCoalesced; // Replaced by a later event of the same player in the tick
+	unsigned long long ullTime;     // Microseconds spent in the handlers
+};
+
+// The script events players send to the server. Each player has a token bucket
+// for each event so a client can't call an event more often than its limit, and
+// the events declared as coalesced are only called once per tick per player with
+// the arguments the player sent last.
+class CClientEventManager
+{
+private:
+	typedef std::pair<EntityId, EventId> PendingKey;
+
+	std::map<EventId, ClientEventRule>      m_rules;
+	std::map<EventId, ClientEventBucket>    m_buckets[MAX_PLAYERS];
+	std::map<PendingKey, CSquirrelArguments> m_pending;
+	std::map<EventId, ClientEventStats>     m_stats;
+
+	ClientEventRule    GetRule(EventId eventId);
+	bool               TakeToken(EntityId playerId, EventId eventId, const ClientEventRule& rule);
+	void               Call(EventId eventId, CSquirrelArguments * pArguments);
+
+public:
+	CClientEventManager();
+	~CClientEventManager();
+
+	// A rate of 0 removes the limit of the event
+	void               SetLimit(EventId eventId, float fRate, float fBurst);
+	void               SetCoalesced(EventId eventId, bool bCoalesce);
+
+	// Handles an event the player sent, the arguments are read from the bit stream
+	void               OnEvent(EntityId playerId, EventId eventId, CBitStream * pBitStream);
+
+	// Calls the coalesced events of this tick
+	void               Process();
+	void               RemovePlayer(EntityId playerId);
+
+	const std::map<EventId, ClientEventStats>& GetStats() { return m_stats; }
+	void               ResetStats() { m_stats.clear(); }
+};
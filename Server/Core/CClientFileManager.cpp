@@ -11,36 +11,42 @@
 #include "CClientFileManager.h"
 #include "CNetworkManager.h"
 #include "CWebserver.h"
+#include "CClientFilePack.h"
 #include <map>
 #include <CLogFile.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CWebServer * g_pWebserver;
+extern CClientFilePack * g_pClientFilePack;
 
 CClientFileManager::CClientFileManager(bool bScriptManager)
 {
 	bIsScriptManager = bScriptManager;
 }
 
-bool CClientFileManager::Start(String strName)
+bool CClientFileManager::Start(String strName, bool bLazy)
 {
 	if(Exists(strName))
 		return false;
 
-	CFileChecksum fileChecksum;
+	ClientFile clientFile;
+	clientFile.bLazy = bLazy;
 	
-	if(!g_pWebserver->FileCopy(strName, bIsScriptManager, fileChecksum))
+	if(!g_pWebserver->FileCopy(strName, bIsScriptManager, clientFile.fileChecksum, clientFile.uiSize))
 	{
 		CLogFile::Printf("Failed to copy client file %s to web server.\n", strName.Get());
 		return false;
 	}
 
-	insert(std::pair<String, CFileChecksum>(strName, fileChecksum));
+	insert(std::pair<String, ClientFile>(strName, clientFile));
 	CBitStream bsSend;
 	bsSend.Write(bIsScriptManager);
 	bsSend.Write(strName);
-	bsSend.Write((char *)&fileChecksum, sizeof(CFileChecksum));
-	g_pNetworkManager->RPC(RPC_NewFile, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	bsSend.Write((char *)&clientFile.fileChecksum, sizeof(CFileChecksum));
+	bsSend.Write(clientFile.uiSize);
+	bsSend.Write(g_pClientFilePack->Contains(strName, bIsScriptManager, clientFile.fileChecksum));
+	bsSend.Write(clientFile.bLazy);
+	g_pNetworkManager->RPC(RPC_NewFile, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_FILES);
 	return true;
 }
 
@@ -53,7 +59,7 @@ bool CClientFileManager::Stop(String strName)
 			CBitStream bsSend;
 			bsSend.Write(bIsScriptManager);
 			bsSend.Write(strName);
-			g_pNetworkManager->RPC(RPC_DeleteFile, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+			g_pNetworkManager->RPC(RPC_DeleteFile, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_FILES);
 			erase(iter);
 			return true;
 		}
@@ -66,9 +72,10 @@ bool CClientFileManager::Restart(String strName)
 	if(!Exists(strName))
 		return false;
 
+	bool bLazy = find(strName)->second.bLazy;
 	Stop(strName);
 	
-	return Start(strName);
+	return Start(strName, bLazy);
 }
 
 bool CClientFileManager::Exists(String strName)
@@ -82,15 +89,18 @@ bool CClientFileManager::Exists(String strName)
 	return false;
 }
 
-void CClientFileManager::HandleClientJoin(EntityId playerId)
+bool CClientFileManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
 {
 	CBitStream bsSend;
+	iterator iter = begin();
 
-	for(iterator iter = begin(); iter != end(); ++ iter)
-	{
-		// Reset the bit stream
- 		bsSend.Reset();
+	// Skip the files we have already sent
+	for(EntityId i = 0; i < pCursor->entityId && iter != end(); i++)
+		++ iter;
 
+	// Pack as many files as fit in a single message
+	for(; iter != end() && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; ++ iter)
+	{
 		// Write if the file is a script or resource
 		bsSend.Write(bIsScriptManager);
 
@@ -98,9 +108,24 @@ void CClientFileManager::HandleClientJoin(EntityId playerId)
 		bsSend.Write((*iter).first);
 
 		// Write the file checksum
-		bsSend.Write((char *)&((*iter).second), sizeof(CFileChecksum));
+		bsSend.Write((char *)&((*iter).second.fileChecksum), sizeof(CFileChecksum));
+
+		// Write the file size (the client downloads the largest files first)
+		bsSend.Write((*iter).second.uiSize);
 
-		// Send the rpc
-		g_pNetworkManager->RPC(RPC_NewFile, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		// Write if the client can get the file from the file pack
+		bsSend.Write(g_pClientFilePack->Contains((*iter).first, bIsScriptManager, (*iter).second.fileChecksum));
+
+		// Write if the client only loads the script once it is required
+		bsSend.Write((*iter).second.bLazy);
+		pCursor->uiEntities++;
 	}
+
+	// Send the rpc
+	if(pCursor->uiEntities > 0)
+		g_pNetworkManager->RPC(RPC_NewFile, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_FILES);
+
+	pCursor->uiBytes = bsSend.GetNumberOfBytesUsed();
+	pCursor->entityId += (EntityId)pCursor->uiEntities;
+	return (iter == end());
 }
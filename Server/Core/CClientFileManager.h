@@ -10,18 +10,26 @@
 #include <map>
 #include "Main.h"
 #include <CFileChecksum.h>
+#include "CJoinStreamer.h"
 
-class CClientFileManager : public std::map<String, CFileChecksum>
+struct ClientFile
+{
+	CFileChecksum fileChecksum;
+	unsigned int  uiSize;
+	bool          bLazy; // The client only loads the script once another script requires it
+};
+
+class CClientFileManager : public std::map<String, ClientFile>
 {
 public:
 	CClientFileManager(bool bScriptManager);
 	~CClientFileManager() { };
 
-	bool Start(String strName);
+	bool Start(String strName, bool bLazy = false);
 	bool Stop(String strName);
 	bool Restart(String strName);
 	bool Exists(String strName);
-	void HandleClientJoin(EntityId playerId);
+	bool HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
 
 private:
 	bool bIsScriptManager;
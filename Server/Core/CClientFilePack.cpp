@@ -0,0 +1,125 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CClientFilePack.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CClientFilePack.h"
+#include "CClientFileManager.h"
+#include "CNetworkManager.h"
+#include <CLogFile.h>
+
+extern CNetworkManager * g_pNetworkManager;
+
+CClientFilePack::CClientFilePack()
+	: m_bBuilt(false),
+	m_uiSize(0)
+{
+
+}
+
+String CClientFilePack::GetKey(String strName, bool bIsScript)
+{
+	return String("%s/%s", (bIsScript ? "clientscripts" : "resources"), strName.Get());
+}
+
+void CClientFilePack::AddEntries(std::vector<FilePackEntry>& entries, CClientFileManager * pClientFileManager, bool bIsScript)
+{
+	for(CClientFileManager::iterator iter = pClientFileManager->begin(); iter != pClientFileManager->end(); ++ iter)
+	{
+		FilePackEntry entry;
+		entry.strName = iter->first;
+		entry.bIsScript = bIsScript;
+		entry.fileChecksum = iter->second.fileChecksum;
+		entry.uiSize = iter->second.uiSize;
+		entry.uiOffset = 0;
+		entry.uiPackedSize = 0;
+		entry.bCompressed = false;
+		// Pack the web server copy, scripts might be sent compiled
+		entry.strFilePath = SharedUtility::GetAbsolutePath("webserver/%s", GetKey(iter->first, bIsScript).Get());
+		entries.push_back(entry);
+	}
+}
+
+bool CClientFilePack::Build(CClientFileManager * pScriptFileManager, CClientFileManager * pResourceFileManager)
+{
+	m_bBuilt = false;
+	m_entries.clear();
+
+	std::vector<FilePackEntry> entries;
+	AddEntries(entries, pResourceFileManager, false);
+	AddEntries(entries, pScriptFileManager, true);
+
+	if(entries.empty())
+		return false;
+
+	// Create the web server folder if needed
+	String strWebServerFolder(SharedUtility::GetAbsolutePath("webserver"));
+
+	if(!SharedUtility::Exists(strWebServerFolder.Get()))
+		SharedUtility::CreateDirectory(strWebServerFolder.Get());
+
+	String strPackPath("%s/%s", strWebServerFolder.Get(), FILE_PACK_FILE);
+
+	// Is the pack from the last start still up to date?
+	CFilePack filePack;
+	bool bUpToDate = (filePack.Open(strPackPath) && filePack.GetEntryCount() == entries.size());
+
+	for(std::vector<FilePackEntry>::iterator iter = entries.begin(); bUpToDate && iter != entries.end(); iter++)
+	{
+		FilePackEntry * pEntry = filePack.Find(iter->strName, iter->bIsScript);
+		bUpToDate = (pEntry && pEntry->fileChecksum == iter->fileChecksum);
+	}
+
+	filePack.Close();
+
+	if(!bUpToDate && !CFilePack::Create(strPackPath, entries))
+	{
+		CLogFile::Printf("Failed to create the client file pack %s.", strPackPath.Get());
+		return false;
+	}
+
+	// Get the checksum and size of the pack for the clients
+	if(!m_fileChecksum.Calculate(strPackPath))
+		return false;
+
+	FILE * pFile = fopen(strPackPath.Get(), "rb");
+
+	if(!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	m_uiSize = (unsigned int)ftell(pFile);
+	fclose(pFile);
+
+	for(std::vector<FilePackEntry>::iterator iter = entries.begin(); iter != entries.end(); iter++)
+		m_entries[GetKey(iter->strName, iter->bIsScript)] = iter->fileChecksum;
+
+	m_bBuilt = true;
+	CLogFile::Printf("Packed %d client files (%d KB).", (int)entries.size(), (m_uiSize / 1024));
+	return true;
+}
+
+bool CClientFilePack::Contains(String strName, bool bIsScript, CFileChecksum fileChecksum)
+{
+	if(!m_bBuilt)
+		return false;
+
+	std::map<String, CFileChecksum>::iterator iter = m_entries.find(GetKey(strName, bIsScript));
+	return (iter != m_entries.end() && iter->second == fileChecksum);
+}
+
+void CClientFilePack::HandleClientJoin(EntityId playerId)
+{
+	if(!m_bBuilt)
+		return;
+
+	// Sent before the files so the client knows which of them it can get from the pack
+	CBitStream bsSend;
+	bsSend.Write((char *)&m_fileChecksum, sizeof(CFileChecksum));
+	bsSend.Write(m_uiSize);
+	g_pNetworkManager->RPC(RPC_NewFilePack, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_FILES);
+}
@@ -0,0 +1,41 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CClientFilePack.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include "Main.h"
+#include <CFilePack.h>
+
+class CClientFileManager;
+
+// The client files packed into a single file in the web server root, so joining
+// clients download a single file instead of each client file on its own
+class CClientFilePack
+{
+private:
+	bool                            m_bBuilt;
+	CFileChecksum                   m_fileChecksum;
+	unsigned int                    m_uiSize;
+	std::map<String, CFileChecksum> m_entries; // Checksums of the packed files by type and name
+
+	static String GetKey(String strName, bool bIsScript);
+	static void   AddEntries(std::vector<FilePackEntry>& entries, CClientFileManager * pClientFileManager, bool bIsScript);
+
+public:
+	CClientFilePack();
+
+	// Packs the started client files, the pack is only written again if the files changed
+	bool          Build(CClientFileManager * pScriptFileManager, CClientFileManager * pResourceFileManager);
+	bool          IsBuilt() { return m_bBuilt; }
+
+	// Is the file in the pack as it is now (files started or changed after the pack was built are downloaded on their own)?
+	bool          Contains(String strName, bool bIsScript, CFileChecksum fileChecksum);
+	void          HandleClientJoin(EntityId playerId);
+};
@@ -0,0 +1,214 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CCommandBuffer.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <algorithm>
+#include "CCommandBuffer.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include <CSettings.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager * g_pPlayerManager;
+
+CCommandBuffer::CCommandBuffer()
+{
+	m_bEnabled = CVAR_GET_BOOL("commandbatching");
+	m_ucCount = 0;
+}
+
+CCommandBuffer::~CCommandBuffer()
+{
+
+}
+
+bool CCommandBuffer::IsBufferedRPC(RPCIdentifier rpcId, ePacketReliability reliability, char cOrderingChannel)
+{
+	// The scripting rpcs are the ones between the entity rpcs and the sync rpcs
+	return (rpcId > RPC_RequestActorUpdate && rpcId < RPC_InVehicleSyncAck &&
+		reliability == RELIABILITY_RELIABLE_ORDERED && cOrderingChannel == PACKET_CHANNEL_DEFAULT);
+}
+
+void CCommandBuffer::QueueForPlayer(EntityId playerId, RPCIdentifier rpcId, CBitStream * pBitStream, EntityId subjectId)
+{
+	CommandQueue * pQueue = &m_queues[playerId];
+
+	if(pQueue->entries.empty())
+		m_pendingPlayers.push_back(playerId);
+
+	// Only the last command that sets the same property of the subject is sent
+	if(subjectId != INVALID_ENTITY_ID)
+	{
+		for(std::vector<CommandEntry>::iterator iter = pQueue->entries.begin(); iter != pQueue->entries.end(); iter++)
+		{
+			if(!iter->bReplaced && iter->rpcId == rpcId && iter->subjectId == subjectId)
+			{
+				iter->bReplaced = true;
+				break;
+			}
+		}
+	}
+
+	CommandEntry entry;
+	entry.rpcId = rpcId;
+	entry.subjectId = subjectId;
+	entry.uiOffset = pQueue->data.size();
+	entry.uiSize = (pBitStream ? pBitStream->GetNumberOfBytesUsed() : 0);
+	entry.bReplaced = false;
+
+	if(entry.uiSize > 0)
+		pQueue->data.insert(pQueue->data.end(), pBitStream->GetData(), (pBitStream->GetData() + entry.uiSize));
+
+	pQueue->entries.push_back(entry);
+}
+
+bool CCommandBuffer::Queue(RPCIdentifier rpcId, CBitStream * pBitStream, EntityId playerId, bool bBroadcast, EntityId subjectId)
+{
+	if(!m_bEnabled)
+		return false;
+
+	if(!bBroadcast)
+	{
+		if(!g_pPlayerManager->DoesExist(playerId))
+			return false;
+
+		QueueForPlayer(playerId, rpcId, pBitStream, subjectId);
+		return true;
+	}
+
+	// Broadcasts are queued for every player that joined (except the given player),
+	// the others get the current state when they join
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(players[i] != playerId)
+			QueueForPlayer(players[i], rpcId, pBitStream, subjectId);
+	}
+
+	return true;
+}
+
+void CCommandBuffer::Begin()
+{
+	// Reserve the rpc header and the entry count, both are filled in when the batch is sent
+	m_bsSend.Reset();
+	m_bsSend.PadWithZeroToByteLength(COMMAND_BATCH_HEADER_SIZE);
+	m_ucCount = 0;
+}
+
+void CCommandBuffer::Send(EntityId playerId)
+{
+	if(m_ucCount == 0)
+		return;
+
+	m_bsSend.GetData()[RPC_HEADER_SIZE] = m_ucCount;
+	g_pNetworkManager->RPCReserved(RPC_CommandBatch, &m_bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+void CCommandBuffer::SendQueue(EntityId playerId, CommandQueue * pQueue)
+{
+	// Take the commands out of the queue first, sending makes the network manager flush it again
+	CommandQueue queue;
+	queue.entries.swap(pQueue->entries);
+	queue.data.swap(pQueue->data);
+	unsigned int uiCommands = 0;
+
+	for(std::vector<CommandEntry>::iterator iter = queue.entries.begin(); iter != queue.entries.end(); iter++)
+	{
+		if(!iter->bReplaced)
+			uiCommands++;
+	}
+
+	Begin();
+
+	for(std::vector<CommandEntry>::iterator iter = queue.entries.begin(); iter != queue.entries.end(); iter++)
+	{
+		if(iter->bReplaced)
+			continue;
+
+		// A single command is sent as it is
+		if(uiCommands == 1)
+		{
+			m_bsSend.Reset();
+			m_bsSend.PadWithZeroToByteLength(RPC_HEADER_SIZE);
+
+			if(iter->uiSize > 0)
+				m_bsSend.Write((char *)&queue.data[iter->uiOffset], iter->uiSize);
+
+			g_pNetworkManager->RPCReserved(iter->rpcId, &m_bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			break;
+		}
+
+		// Would this entry make the datagram too big?
+		if(m_ucCount > 0 && (m_ucCount == 0xFF || (m_bsSend.GetNumberOfBytesUsed() + iter->uiSize + COMMAND_BATCH_ENTRY_HEADER_SIZE) > COMMAND_BATCH_MAX_SIZE))
+		{
+			Send(playerId);
+			Begin();
+		}
+
+		// Entries are byte aligned like the snapshot entries so the client can read them in place
+		m_bsSend.Write(iter->rpcId);
+		m_bsSend.WriteCompressed(iter->uiSize);
+		m_bsSend.AlignWriteToByteBoundary();
+
+		if(iter->uiSize > 0)
+			m_bsSend.Write((char *)&queue.data[iter->uiOffset], iter->uiSize);
+
+		m_ucCount++;
+	}
+
+	Send(playerId);
+
+	// Give the memory back to the queue so it isn't allocated again next tick
+	if(pQueue->entries.empty())
+	{
+		queue.entries.clear();
+		queue.data.clear();
+		pQueue->entries.swap(queue.entries);
+		pQueue->data.swap(queue.data);
+	}
+}
+
+void CCommandBuffer::Flush(EntityId playerId, bool bBroadcast)
+{
+	if(m_pendingPlayers.empty())
+		return;
+
+	if(bBroadcast)
+	{
+		FlushAll();
+		return;
+	}
+
+	if(playerId >= MAX_PLAYERS || m_queues[playerId].entries.empty())
+		return;
+
+	m_pendingPlayers.erase(std::find(m_pendingPlayers.begin(), m_pendingPlayers.end(), playerId));
+	SendQueue(playerId, &m_queues[playerId]);
+}
+
+void CCommandBuffer::FlushAll()
+{
+	std::vector<EntityId> pendingPlayers;
+	pendingPlayers.swap(m_pendingPlayers);
+
+	for(std::vector<EntityId>::iterator iter = pendingPlayers.begin(); iter != pendingPlayers.end(); iter++)
+		SendQueue(*iter, &m_queues[*iter]);
+}
+
+void CCommandBuffer::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS || m_queues[playerId].entries.empty())
+		return;
+
+	// Drop everything still queued for the player
+	m_pendingPlayers.erase(std::find(m_pendingPlayers.begin(), m_pendingPlayers.end(), playerId));
+	m_queues[playerId].entries.clear();
+	m_queues[playerId].data.clear();
+}
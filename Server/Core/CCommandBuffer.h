@@ -0,0 +1,82 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CCommandBuffer.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include "Main.h"
+#include <Common.h>
+#include <Network/CBitStream.h>
+#include <Network/RPCIdentifiers.h>
+#include <Network/CNetServerInterface.h>
+
+// Size in bytes after which a command batch is split into another datagram
+#define COMMAND_BATCH_MAX_SIZE 1200
+
+// Size of the rpc header and the entry count at the start of a command batch
+#define COMMAND_BATCH_HEADER_SIZE (RPC_HEADER_SIZE + sizeof(unsigned char))
+
+// Worst case size of the rpc id and compressed size written before each entry
+#define COMMAND_BATCH_ENTRY_HEADER_SIZE 6
+
+// A scripting rpc queued for a single player, its data is in the players queue
+struct CommandEntry
+{
+	RPCIdentifier rpcId;
+	EntityId      subjectId;         // INVALID_ENTITY_ID if the command is never coalesced
+	unsigned int  uiOffset;
+	unsigned int  uiSize;
+	bool          bReplaced;         // A later command with the same rpc and subject replaced it
+};
+
+struct CommandQueue
+{
+	std::vector<CommandEntry>  entries;
+	std::vector<unsigned char> data;
+};
+
+// Collects the reliable scripting rpcs of a tick per player and sends them
+// as one batch at the end of the tick. Any other reliable ordered rpc sends
+// the commands queued before it first so the order is kept.
+class CCommandBuffer
+{
+private:
+	bool                  m_bEnabled;
+	CommandQueue          m_queues[MAX_PLAYERS];
+	std::vector<EntityId> m_pendingPlayers;
+	CBitStream            m_bsSend;
+	unsigned char         m_ucCount;
+
+	void                  QueueForPlayer(EntityId playerId, RPCIdentifier rpcId, CBitStream * pBitStream, EntityId subjectId);
+	void                  Begin();
+	void                  Send(EntityId playerId);
+	void                  SendQueue(EntityId playerId, CommandQueue * pQueue);
+
+public:
+	CCommandBuffer();
+	~CCommandBuffer();
+
+	bool                  IsEnabled() { return m_bEnabled; }
+
+	// Returns true if the rpc is sent through the buffer (reliable ordered scripting rpcs)
+	static bool           IsBufferedRPC(RPCIdentifier rpcId, ePacketReliability reliability, char cOrderingChannel);
+
+	// Queues the rpc for the player (or all players except the player if broadcasting),
+	// of the commands with the same rpc and subject only the last one is sent. Returns
+	// false if the rpc could not be queued and has to be sent right away.
+	bool                  Queue(RPCIdentifier rpcId, CBitStream * pBitStream, EntityId playerId, bool bBroadcast, EntityId subjectId = INVALID_ENTITY_ID);
+
+	// Sends the commands queued for the player (or all players if broadcasting)
+	void                  Flush(EntityId playerId, bool bBroadcast);
+	void                  FlushAll();
+	void                  RemovePlayer(EntityId playerId);
+
+	// Called at the end of every server tick
+	void                  Process() { FlushAll(); }
+};
@@ -0,0 +1,198 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CCommandManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CCommandManager.h"
+#include "CEvents.h"
+
+CCommandManager::~CCommandManager()
+{
+	for(std::map< String, std::vector< CEventHandler* > >::iterator iter = m_handlers.begin(); iter != m_handlers.end(); ++ iter)
+	{
+		for(std::vector< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); ++ iter2)
+			delete (*iter2);
+	}
+}
+
+String CCommandManager::GetKey(String strName)
+{
+	if(strName.GetLength() > 0 && strName[0] == '/')
+		strName = strName.SubStr(1);
+
+	return strName.ToLower();
+}
+
+bool CCommandManager::Add(String strName, CEventHandler * pHandler)
+{
+	String strKey = GetKey(strName);
+
+	if(strKey.IsEmpty())
+	{
+		delete pHandler;
+		return false;
+	}
+
+	std::vector< CEventHandler* > * pHandlers = &m_handlers[strKey];
+
+	// Check if the function is registered already
+	for(std::vector< CEventHandler* >::iterator iter = pHandlers->begin(); iter != pHandlers->end(); ++ iter)
+	{
+		if(pHandler->equals(*iter))
+		{
+			delete pHandler;
+			return false;
+		}
+	}
+
+	pHandlers->push_back(pHandler);
+	return true;
+}
+
+bool CCommandManager::Remove(String strName, CEventHandler * pHandler)
+{
+	std::map< String, std::vector< CEventHandler* > >::iterator iter = m_handlers.find(GetKey(strName));
+
+	if(iter == m_handlers.end())
+		return false;
+
+	for(std::vector< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); ++ iter2)
+	{
+		if(pHandler->equals(*iter2))
+		{
+			delete (*iter2);
+			(*iter).second.erase(iter2);
+
+			if((*iter).second.empty())
+				m_handlers.erase(iter);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CCommandManager::Remove(String strName, SQVM * pVM)
+{
+	std::map< String, std::vector< CEventHandler* > >::iterator iter = m_handlers.find(GetKey(strName));
+
+	if(iter == m_handlers.end())
+		return false;
+
+	bool bRemoved = false;
+
+	for(std::vector< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); )
+	{
+		if((*iter2)->GetScript() == pVM)
+		{
+			delete (*iter2);
+			iter2 = (*iter).second.erase(iter2);
+			bRemoved = true;
+		}
+		else
+			iter2 ++;
+	}
+
+	if((*iter).second.empty())
+		m_handlers.erase(iter);
+
+	return bRemoved;
+}
+
+void CCommandManager::RemoveScript(SQVM * pVM)
+{
+	for(std::map< String, std::vector< CEventHandler* > >::iterator iter = m_handlers.begin(); iter != m_handlers.end(); )
+	{
+		for(std::vector< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); )
+		{
+			if((*iter2)->GetScript() == pVM)
+			{
+				delete (*iter2);
+				iter2 = (*iter).second.erase(iter2);
+			}
+			else
+				iter2 ++;
+		}
+
+		if((*iter).second.empty())
+			m_handlers.erase(iter++);
+		else
+			++ iter;
+	}
+}
+
+bool CCommandManager::Process(EntityId playerId, String strCommand)
+{
+	if(m_handlers.empty())
+		return false;
+
+	// Split the name from the text
+	size_t sLength = strCommand.GetLength();
+	size_t sNameEnd = 0;
+
+	while(sNameEnd < sLength && strCommand[sNameEnd] != ' ' && strCommand[sNameEnd] != '\t')
+		sNameEnd++;
+
+	std::map< String, std::vector< CEventHandler* > >::iterator iter = m_handlers.find(GetKey(strCommand.SubStr(0, sNameEnd)));
+
+	if(iter == m_handlers.end())
+		return false;
+
+	size_t sTextStart = sNameEnd;
+
+	while(sTextStart < sLength && (strCommand[sTextStart] == ' ' || strCommand[sTextStart] == '\t'))
+		sTextStart++;
+
+	String strText = strCommand.SubStr(sTextStart);
+	std::vector<String> tokens;
+	Tokenize(strText, tokens);
+
+	CSquirrelArguments * pArgs = new CSquirrelArguments();
+
+	for(std::vector<String>::iterator iter2 = tokens.begin(); iter2 != tokens.end(); ++ iter2)
+		pArgs->push(*iter2);
+
+	CSquirrelArguments pArguments;
+	pArguments.push(playerId);
+	pArguments.push(pArgs, true);
+	pArguments.push(strText);
+
+	// Copy the handlers as they can remove themselves when called
+	std::vector< CEventHandler* > handlers = (*iter).second;
+
+	for(std::vector< CEventHandler* >::iterator iter2 = handlers.begin(); iter2 != handlers.end(); ++ iter2)
+	{
+		CSquirrelArgument pReturn;
+		(*iter2)->Call(&pArguments, &pReturn);
+	}
+
+	return true;
+}
+
+void CCommandManager::Tokenize(const String& strText, std::vector<String>& tokens)
+{
+	size_t sLength = strText.GetLength();
+	size_t sStart = 0;
+
+	while(sStart < sLength)
+	{
+		if(strText[sStart] == ' ' || strText[sStart] == '\t')
+		{
+			sStart++;
+			continue;
+		}
+
+		size_t sEnd = sStart;
+
+		while(sEnd < sLength && strText[sEnd] != ' ' && strText[sEnd] != '\t')
+			sEnd++;
+
+		tokens.push_back(strText.SubStr(sStart, (sEnd - sStart)));
+		sStart = sEnd;
+	}
+}
@@ -0,0 +1,45 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CCommandManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <CString.h>
+#include <Common.h>
+
+class CEventHandler;
+struct SQVM;
+
+// Player commands mapped to the handlers added with addCommandHandler, the
+// command is split into its arguments once and only its own handlers are called
+class CCommandManager
+{
+private:
+	std::map< String, std::vector< CEventHandler* > > m_handlers; // Keyed by the lower case name without the '/'
+
+	static String GetKey(String strName);
+
+public:
+	~CCommandManager();
+
+	// Takes ownership of the handler, returns false (and deletes it) if it was added already
+	bool         Add(String strName, CEventHandler * pHandler);
+	bool         Remove(String strName, CEventHandler * pHandler);
+	// Removes all handlers the script added for this command
+	bool         Remove(String strName, SQVM * pVM);
+	void         RemoveScript(SQVM * pVM);
+
+	// Calls the handlers of the command with (playerid, args, text) where args are the
+	// arguments split on whitespace and text is all of them unsplit, returns false if
+	// the command has no handlers
+	bool         Process(EntityId playerId, String strCommand);
+
+	static void  Tokenize(const String& strText, std::vector<String>& tokens);
+};
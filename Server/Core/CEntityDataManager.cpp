@@ -0,0 +1,331 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityDataManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CEntityDataManager.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include "CEntityStreamer.h"
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager  * g_pPlayerManager;
+extern CEntityStreamer * g_pEntityStreamer;
+
+CEntityDataManager::CEntityDataManager()
+{
+
+}
+
+CEntityDataManager::~CEntityDataManager()
+{
+
+}
+
+void CEntityDataManager::MarkChanged(eEntityDataType type, EntityId entityId, const String& strKey, eEntityDataScope flushedScope)
+{
+	EntityDataChangeKey key;
+	key.type = type;
+	key.entityId = entityId;
+	key.strKey = strKey;
+
+	// Only the first change of the tick knows the scope the key was flushed with
+	m_changes.insert(std::pair<EntityDataChangeKey, eEntityDataScope>(key, flushedScope));
+}
+
+void CEntityDataManager::GetRecipients(eEntityDataType type, EntityId entityId, eEntityDataScope scope, std::vector<EntityId>& recipients)
+{
+	recipients.clear();
+
+	switch(scope)
+	{
+	case ENTITY_DATA_SCOPE_OWNER:
+		if(type == ENTITY_DATA_PLAYER && g_pPlayerManager->DoesExist(entityId))
+			recipients.push_back(entityId);
+
+		break;
+	case ENTITY_DATA_SCOPE_STREAMED:
+		// Players are never streamed out and without the entity streamer everyone has every entity
+		if(type == ENTITY_DATA_PLAYER || !g_pEntityStreamer->IsEnabled())
+			recipients = g_pPlayerManager->GetActivePlayers();
+		else
+		{
+			eEntityStreamerType streamerType = ((type == ENTITY_DATA_VEHICLE) ? ENTITY_STREAMER_VEHICLE : ENTITY_STREAMER_OBJECT);
+			const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+			for(size_t i = 0; i < players.size(); i++)
+			{
+				if(g_pEntityStreamer->IsStreamedIn(players[i], streamerType, entityId))
+					recipients.push_back(players[i]);
+			}
+		}
+
+		break;
+	case ENTITY_DATA_SCOPE_ALL:
+		recipients = g_pPlayerManager->GetActivePlayers();
+		break;
+	}
+}
+
+void CEntityDataManager::QueueForPlayers(const std::vector<EntityId>& players)
+{
+	// Every operation is byte aligned so it can be copied straight into the messages
+	m_bsOperation.AlignWriteToByteBoundary();
+
+	for(std::vector<EntityId>::const_iterator iter = players.begin(); iter != players.end(); ++ iter)
+	{
+		CBitStream * pBitStream = &m_bsPlayers[*iter];
+
+		if(pBitStream->GetNumberOfBitsUsed() == 0)
+			m_pendingPlayers.push_back(*iter);
+
+		pBitStream->WriteBits(m_bsOperation.GetData(), m_bsOperation.GetNumberOfBitsUsed(), false);
+	}
+}
+
+void CEntityDataManager::WriteSet(CBitStream * pBitStream, eEntityDataType type, EntityId entityId, const String& strKey, EntityDataValue * pValue)
+{
+	pBitStream->Write((unsigned char)ENTITY_DATA_OPERATION_SET);
+	pBitStream->Write((unsigned char)type);
+	pBitStream->WriteCompressed(entityId);
+	pBitStream->Write(strKey);
+	pValue->value.serialize(pBitStream);
+	pBitStream->AlignWriteToByteBoundary();
+}
+
+bool CEntityDataManager::Set(eEntityDataType type, EntityId entityId, const String& strKey, const CSquirrelArgument& value, eEntityDataScope scope)
+{
+	if(type >= ENTITY_DATA_TYPE_MAX || scope >= ENTITY_DATA_SCOPE_MAX || strKey.IsEmpty())
+		return false;
+
+	if(scope == ENTITY_DATA_SCOPE_OWNER && type != ENTITY_DATA_PLAYER)
+		return false;
+
+	switch(value.GetType())
+	{
+	case OT_INTEGER:
+	case OT_BOOL:
+	case OT_FLOAT:
+	case OT_STRING:
+	case OT_ARRAY:
+	case OT_TABLE:
+		break;
+	default:
+		return false;
+	}
+
+	EntityDataMap * pData = &m_data[type][entityId];
+	EntityDataMap::iterator iter = pData->find(strKey);
+	eEntityDataScope flushedScope = ENTITY_DATA_SCOPE_SERVER;
+
+	if(iter == pData->end())
+		iter = pData->insert(std::pair<String, EntityDataValue>(strKey, EntityDataValue())).first;
+	else
+		flushedScope = (*iter).second.scope;
+
+	EntityDataValue * pValue = &(*iter).second;
+	pValue->value.reset();
+	pValue->value.set(value);
+	pValue->scope = scope;
+
+	if(scope != ENTITY_DATA_SCOPE_SERVER || flushedScope != ENTITY_DATA_SCOPE_SERVER)
+		MarkChanged(type, entityId, strKey, flushedScope);
+
+	return true;
+}
+
+EntityDataValue * CEntityDataManager::Get(eEntityDataType type, EntityId entityId, const String& strKey)
+{
+	if(type >= ENTITY_DATA_TYPE_MAX)
+		return NULL;
+
+	std::map<EntityId, EntityDataMap>::iterator iter = m_data[type].find(entityId);
+
+	if(iter == m_data[type].end())
+		return NULL;
+
+	EntityDataMap::iterator iter2 = (*iter).second.find(strKey);
+
+	if(iter2 == (*iter).second.end())
+		return NULL;
+
+	return &(*iter2).second;
+}
+
+bool CEntityDataManager::Remove(eEntityDataType type, EntityId entityId, const String& strKey)
+{
+	if(type >= ENTITY_DATA_TYPE_MAX)
+		return false;
+
+	std::map<EntityId, EntityDataMap>::iterator iter = m_data[type].find(entityId);
+
+	if(iter == m_data[type].end())
+		return false;
+
+	EntityDataMap::iterator iter2 = (*iter).second.find(strKey);
+
+	if(iter2 == (*iter).second.end())
+		return false;
+
+	eEntityDataScope flushedScope = (*iter2).second.scope;
+	(*iter).second.erase(iter2);
+
+	if((*iter).second.empty())
+		m_data[type].erase(iter);
+
+	if(flushedScope != ENTITY_DATA_SCOPE_SERVER)
+		MarkChanged(type, entityId, strKey, flushedScope);
+
+	return true;
+}
+
+void CEntityDataManager::RemoveEntity(eEntityDataType type, EntityId entityId)
+{
+	if(type >= ENTITY_DATA_TYPE_MAX)
+		return;
+
+	// Drop what was queued for a player that left
+	if(type == ENTITY_DATA_PLAYER && entityId < MAX_PLAYERS)
+		m_bsPlayers[entityId].Reset();
+
+	std::map<EntityId, EntityDataMap>::iterator iter = m_data[type].find(entityId);
+
+	if(iter == m_data[type].end())
+		return;
+
+	// Forget the changes of the entity that weren't sent yet
+	EntityDataChangeKey key;
+	key.type = type;
+	key.entityId = entityId;
+	std::map<EntityDataChangeKey, eEntityDataScope>::iterator changeIter = m_changes.lower_bound(key);
+
+	while(changeIter != m_changes.end() && (*changeIter).first.type == type && (*changeIter).first.entityId == entityId)
+		m_changes.erase(changeIter++);
+
+	m_data[type].erase(iter);
+	m_clearedEntities.push_back(std::pair<eEntityDataType, EntityId>(type, entityId));
+}
+
+void CEntityDataManager::HandleStreamIn(EntityId playerId, eEntityDataType type, const std::list<EntityId>& entities)
+{
+	if(type >= ENTITY_DATA_TYPE_MAX || m_data[type].empty())
+		return;
+
+	CBitStream * pBitStream = &m_bsPlayers[playerId];
+
+	for(std::list<EntityId>::const_iterator iter = entities.begin(); iter != entities.end(); ++ iter)
+	{
+		std::map<EntityId, EntityDataMap>::iterator dataIter = m_data[type].find(*iter);
+
+		if(dataIter == m_data[type].end())
+			continue;
+
+		// The keys sent to everyone were sent already
+		for(EntityDataMap::iterator iter2 = (*dataIter).second.begin(); iter2 != (*dataIter).second.end(); ++ iter2)
+		{
+			if((*iter2).second.scope == ENTITY_DATA_SCOPE_STREAMED)
+			{
+				if(pBitStream->GetNumberOfBitsUsed() == 0)
+					m_pendingPlayers.push_back(playerId);
+
+				WriteSet(pBitStream, type, *iter, (*iter2).first, &(*iter2).second);
+			}
+		}
+	}
+}
+
+bool CEntityDataManager::HandleClientJoin(EntityId playerId, eEntityDataType type, JoinStreamCursor * pCursor)
+{
+	if(type >= ENTITY_DATA_TYPE_MAX)
+		return true;
+
+	// With the entity streamer the streamed keys of vehicles and objects are sent when they are streamed in
+	bool bStreamed = (type == ENTITY_DATA_PLAYER || !g_pEntityStreamer->IsEnabled());
+
+	// Pack the data of as many entities as fit in a single message
+	CBitStream bsSend;
+	std::map<EntityId, EntityDataMap>::iterator iter = m_data[type].lower_bound(pCursor->entityId);
+
+	for(; iter != m_data[type].end() && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; ++ iter)
+	{
+		for(EntityDataMap::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); ++ iter2)
+		{
+			eEntityDataScope scope = (*iter2).second.scope;
+
+			if(scope == ENTITY_DATA_SCOPE_ALL || (scope == ENTITY_DATA_SCOPE_STREAMED && bStreamed) || (scope == ENTITY_DATA_SCOPE_OWNER && (*iter).first == playerId))
+				WriteSet(&bsSend, type, (*iter).first, (*iter2).first, &(*iter2).second);
+		}
+	}
+
+	if(bsSend.GetNumberOfBitsUsed() > 0)
+	{
+		g_pNetworkManager->RPC(RPC_EntityData, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		pCursor->uiBytes += bsSend.GetNumberOfBytesUsed();
+	}
+
+	if(iter == m_data[type].end())
+		return true;
+
+	pCursor->entityId = (*iter).first;
+	return false;
+}
+
+void CEntityDataManager::Process()
+{
+	// Clear the deleted entities first as their ids can have been given out again this tick
+	for(std::vector< std::pair<eEntityDataType, EntityId> >::iterator iter = m_clearedEntities.begin(); iter != m_clearedEntities.end(); ++ iter)
+	{
+		m_bsOperation.Reset();
+		m_bsOperation.Write((unsigned char)ENTITY_DATA_OPERATION_CLEAR);
+		m_bsOperation.Write((unsigned char)(*iter).first);
+		m_bsOperation.WriteCompressed((*iter).second);
+		GetRecipients((*iter).first, (*iter).second, ENTITY_DATA_SCOPE_ALL, m_recipients);
+		QueueForPlayers(m_recipients);
+	}
+
+	m_clearedEntities.clear();
+
+	for(std::map<EntityDataChangeKey, eEntityDataScope>::iterator iter = m_changes.begin(); iter != m_changes.end(); ++ iter)
+	{
+		const EntityDataChangeKey& key = (*iter).first;
+		eEntityDataScope flushedScope = (*iter).second;
+		EntityDataValue * pValue = Get(key.type, key.entityId, key.strKey);
+
+		// Remove the key from the players of its old scope if it was removed or its scope changed
+		if(flushedScope != ENTITY_DATA_SCOPE_SERVER && (!pValue || pValue->scope != flushedScope))
+		{
+			m_bsOperation.Reset();
+			m_bsOperation.Write((unsigned char)ENTITY_DATA_OPERATION_REMOVE);
+			m_bsOperation.Write((unsigned char)key.type);
+			m_bsOperation.WriteCompressed(key.entityId);
+			m_bsOperation.Write(key.strKey);
+			GetRecipients(key.type, key.entityId, flushedScope, m_recipients);
+			QueueForPlayers(m_recipients);
+		}
+
+		if(pValue && pValue->scope != ENTITY_DATA_SCOPE_SERVER)
+		{
+			m_bsOperation.Reset();
+			WriteSet(&m_bsOperation, key.type, key.entityId, key.strKey, pValue);
+			GetRecipients(key.type, key.entityId, pValue->scope, m_recipients);
+			QueueForPlayers(m_recipients);
+		}
+	}
+
+	m_changes.clear();
+
+	// Send each player all of its changes in one message
+	for(std::vector<EntityId>::iterator iter = m_pendingPlayers.begin(); iter != m_pendingPlayers.end(); ++ iter)
+	{
+		if(m_bsPlayers[*iter].GetNumberOfBitsUsed() > 0 && g_pPlayerManager->DoesExist(*iter))
+			g_pNetworkManager->RPC(RPC_EntityData, &m_bsPlayers[*iter], PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, *iter, false);
+
+		m_bsPlayers[*iter].Reset();
+	}
+
+	m_pendingPlayers.clear();
+}
@@ -0,0 +1,97 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityDataManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <list>
+#include <vector>
+#include <CString.h>
+#include <Common.h>
+#include <Network/CBitStream.h>
+#include <Network/EntityData.h>
+#include <Scripting/CSquirrelArguments.h>
+#include "CJoinStreamer.h"
+
+// Players a key is sent to
+enum eEntityDataScope
+{
+	ENTITY_DATA_SCOPE_SERVER,   // Nobody
+	ENTITY_DATA_SCOPE_OWNER,    // The player the data belongs to (player data only)
+	ENTITY_DATA_SCOPE_STREAMED, // Players that have the entity streamed in
+	ENTITY_DATA_SCOPE_ALL,      // Everyone
+	ENTITY_DATA_SCOPE_MAX
+};
+
+struct EntityDataValue
+{
+	CSquirrelArgument value;
+	eEntityDataScope  scope;
+};
+
+typedef std::map<String, EntityDataValue> EntityDataMap;
+
+// A key that changed since the last flush
+struct EntityDataChangeKey
+{
+	eEntityDataType type;
+	EntityId        entityId;
+	String          strKey;
+
+	bool operator < (const EntityDataChangeKey& other) const
+	{
+		if(type != other.type)
+			return (type < other.type);
+
+		if(entityId != other.entityId)
+			return (entityId < other.entityId);
+
+		return (strKey < other.strKey);
+	}
+};
+
+// Key/value data scripts attach to players, vehicles and objects. Changed keys
+// are collected over the tick and flushed once as a single RPC_EntityData
+// message per player, joining players get the current data with the join state
+class CEntityDataManager
+{
+private:
+	std::map<EntityId, EntityDataMap>                    m_data[ENTITY_DATA_TYPE_MAX];
+	std::map<EntityDataChangeKey, eEntityDataScope>      m_changes;       // Scope the key was last flushed with
+	std::vector< std::pair<eEntityDataType, EntityId> >  m_clearedEntities;
+	CBitStream                                           m_bsPlayers[MAX_PLAYERS];
+	std::vector<EntityId>                                m_pendingPlayers;
+	std::vector<EntityId>                                m_recipients;
+	CBitStream                                           m_bsOperation;
+
+	void              MarkChanged(eEntityDataType type, EntityId entityId, const String& strKey, eEntityDataScope flushedScope);
+	void              GetRecipients(eEntityDataType type, EntityId entityId, eEntityDataScope scope, std::vector<EntityId>& recipients);
+	void              QueueForPlayers(const std::vector<EntityId>& players);
+	void              WriteSet(CBitStream * pBitStream, eEntityDataType type, EntityId entityId, const String& strKey, EntityDataValue * pValue);
+
+public:
+	CEntityDataManager();
+	~CEntityDataManager();
+
+	// Values without a network representation (functions, instances, ...) aren't accepted
+	bool              Set(eEntityDataType type, EntityId entityId, const String& strKey, const CSquirrelArgument& value, eEntityDataScope scope);
+	EntityDataValue * Get(eEntityDataType type, EntityId entityId, const String& strKey);
+	bool              Remove(eEntityDataType type, EntityId entityId, const String& strKey);
+
+	// Must be called when an entity is deleted
+	void              RemoveEntity(eEntityDataType type, EntityId entityId);
+
+	// Sends the streamed data of the entities that were streamed in for the player
+	void              HandleStreamIn(EntityId playerId, eEntityDataType type, const std::list<EntityId>& entities);
+	bool              HandleClientJoin(EntityId playerId, eEntityDataType type, JoinStreamCursor * pCursor);
+
+	// Sends the changes of this tick
+	void              Process();
+};
@@ -0,0 +1,117 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityIdAllocator.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <string.h>
+#include <deque>
+#include <Common.h>
+
+// Hands out entity ids below MaxSlots in constant time. Freed ids are queued and
+// given out again in the order they were freed, before any id that was never used,
+// so an id is reused as late as possible without spreading the ids over the whole
+// range. Every time an id is freed its generation goes up so a reference that kept
+// the id and generation can tell when the entity was replaced.
+template <unsigned int MaxSlots>
+class CEntityIdAllocator
+{
+private:
+	bool                 m_bUsed[MaxSlots];
+	unsigned char        m_ucGenerations[MaxSlots];
+	std::deque<EntityId> m_freeIds; // Can have ids that were used again with SetUsed, they are skipped
+	unsigned int         m_uiNextId; // Ids from here on were never used
+
+	CEntityIdAllocator(const CEntityIdAllocator&);
+	CEntityIdAllocator& operator = (const CEntityIdAllocator&);
+
+public:
+	CEntityIdAllocator()
+	{
+		memset(m_bUsed, 0, sizeof(m_bUsed));
+		memset(m_ucGenerations, 0, sizeof(m_ucGenerations));
+		m_uiNextId = 0;
+	}
+
+	bool          IsUsed(EntityId id) const { return (id < MaxSlots && m_bUsed[id]); }
+	unsigned char GetGeneration(EntityId id) const { return ((id < MaxSlots) ? m_ucGenerations[id] : 0); }
+
+	// Returns the id the next Allocate gives out without using it (INVALID_ENTITY_ID if all are used)
+	EntityId      GetFree()
+	{
+		while(!m_freeIds.empty())
+		{
+			EntityId id = m_freeIds.front();
+
+			if(!m_bUsed[id])
+				return id;
+
+			m_freeIds.pop_front();
+		}
+
+		while(m_uiNextId < MaxSlots && m_bUsed[m_uiNextId])
+			m_uiNextId++;
+
+		if(m_uiNextId == MaxSlots)
+			return INVALID_ENTITY_ID;
+
+		return (EntityId)m_uiNextId;
+	}
+
+	// Returns INVALID_ENTITY_ID if all ids are used
+	EntityId      Allocate()
+	{
+		EntityId id = GetFree();
+
+		if(id != INVALID_ENTITY_ID)
+			SetUsed(id);
+
+		return id;
+	}
+
+	// Uses a specific id, returns false if it is out of range or already used
+	bool          SetUsed(EntityId id)
+	{
+		if(id >= MaxSlots || m_bUsed[id])
+			return false;
+
+		m_bUsed[id] = true;
+
+		if(!m_freeIds.empty() && m_freeIds.front() == id)
+			m_freeIds.pop_front();
+
+		return true;
+	}
+
+	bool          Free(EntityId id)
+	{
+		if(!IsUsed(id))
+			return false;
+
+		m_bUsed[id] = false;
+		m_ucGenerations[id]++;
+		m_freeIds.push_back(id);
+		return true;
+	}
+
+	// Frees all ids, the reuse order starts over but the generations are kept
+	void          Clear()
+	{
+		for(unsigned int id = 0; id < MaxSlots; id++)
+		{
+			if(m_bUsed[id])
+			{
+				m_bUsed[id] = false;
+				m_ucGenerations[id]++;
+			}
+		}
+
+		m_freeIds.clear();
+		m_uiNextId = 0;
+	}
+};
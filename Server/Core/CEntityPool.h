@@ -0,0 +1,152 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityPool.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <string.h>
+#include <Common.h>
+#include "CEntityIdAllocator.h"
+
+// Amount of slots in a page of an entity pool
+#define ENTITY_POOL_PAGE_SIZE 256
+
+// Slots by entity id for up to MaxSlots ids. The slots are allocated a page at a time
+// when the first id of the page is added and the page is freed once its last id is
+// removed, so the memory used scales with the existing entities instead of MaxSlots.
+// The ids themselves are tracked by an id allocator so a free id is found in constant time.
+template <typename T, unsigned int MaxSlots>
+class CEntityPool
+{
+private:
+	struct Page
+	{
+		unsigned int uiUsed;
+		T            slots[ENTITY_POOL_PAGE_SIZE];
+	};
+
+	enum { PAGE_COUNT = ((MaxSlots + ENTITY_POOL_PAGE_SIZE - 1) / ENTITY_POOL_PAGE_SIZE) };
+
+	Page                         * m_pPages[PAGE_COUNT];
+	unsigned int                   m_uiCount;
+	CEntityIdAllocator<MaxSlots>   m_ids;
+
+	CEntityPool(const CEntityPool&);
+	CEntityPool& operator = (const CEntityPool&);
+
+public:
+	CEntityPool()
+	{
+		memset(m_pPages, 0, sizeof(m_pPages));
+		m_uiCount = 0;
+	}
+
+	~CEntityPool()
+	{
+		Clear();
+	}
+
+	unsigned int GetCount() const { return m_uiCount; }
+
+	bool         DoesExist(EntityId id) const { return m_ids.IsUsed(id); }
+
+	// Goes up every time the id is removed
+	unsigned char GetGeneration(EntityId id) const { return m_ids.GetGeneration(id); }
+
+	// Returns NULL if the id doesn't exist
+	T          * Get(EntityId id)
+	{
+		if(!DoesExist(id))
+			return NULL;
+
+		return &m_pPages[id / ENTITY_POOL_PAGE_SIZE]->slots[id % ENTITY_POOL_PAGE_SIZE];
+	}
+
+	// The id must exist
+	T          & operator [] (EntityId id)
+	{
+		return m_pPages[id / ENTITY_POOL_PAGE_SIZE]->slots[id % ENTITY_POOL_PAGE_SIZE];
+	}
+
+	// Adds the id with a default slot and returns it, NULL if the id is out of range or exists
+	T          * Add(EntityId id)
+	{
+		if(!m_ids.SetUsed(id))
+			return NULL;
+
+		Page *& pPage = m_pPages[id / ENTITY_POOL_PAGE_SIZE];
+
+		if(!pPage)
+		{
+			pPage = new Page;
+			pPage->uiUsed = 0;
+		}
+
+		unsigned int uiSlot = (id % ENTITY_POOL_PAGE_SIZE);
+		pPage->slots[uiSlot] = T();
+		pPage->uiUsed++;
+		m_uiCount++;
+		return &pPage->slots[uiSlot];
+	}
+
+	bool         Remove(EntityId id)
+	{
+		if(!m_ids.Free(id))
+			return false;
+
+		Page *& pPage = m_pPages[id / ENTITY_POOL_PAGE_SIZE];
+		m_uiCount--;
+
+		if(--pPage->uiUsed == 0)
+		{
+			delete pPage;
+			pPage = NULL;
+		}
+
+		return true;
+	}
+
+	void         Clear()
+	{
+		for(unsigned int i = 0; i < PAGE_COUNT; i++)
+		{
+			delete m_pPages[i];
+			m_pPages[i] = NULL;
+		}
+
+		m_uiCount = 0;
+		m_ids.Clear();
+	}
+
+	// Returns the first existing id from startId on (INVALID_ENTITY_ID if there is none),
+	// walk the pool with for(id = GetFirst(); id != INVALID_ENTITY_ID; id = GetFirst(id + 1))
+	EntityId     GetFirst(unsigned int startId = 0) const
+	{
+		for(unsigned int id = startId; id < MaxSlots;)
+		{
+			const Page * pPage = m_pPages[id / ENTITY_POOL_PAGE_SIZE];
+
+			if(!pPage)
+			{
+				id = (((id / ENTITY_POOL_PAGE_SIZE) + 1) * ENTITY_POOL_PAGE_SIZE);
+				continue;
+			}
+
+			if(m_ids.IsUsed((EntityId)id))
+				return (EntityId)id;
+
+			id++;
+		}
+
+		return INVALID_ENTITY_ID;
+	}
+
+	// Returns the id that should be added next (INVALID_ENTITY_ID if the pool is full), see
+	// CEntityIdAllocator for the order the ids are reused in
+	EntityId     GetFree() { return m_ids.GetFree(); }
+};
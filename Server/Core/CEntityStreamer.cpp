@@ -0,0 +1,377 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityStreamer.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <math.h>
+#include "CEntityStreamer.h"
+#include "CPlayerManager.h"
+#include "CVehicleManager.h"
+#include "CObjectManager.h"
+#include "CPickupManager.h"
+#include "CActorManager.h"
+#include "CJoinStreamer.h"
+#include "CEntityDataManager.h"
+#include <CSettings.h>
+#include <SharedUtility.h>
+
+extern CPlayerManager * g_pPlayerManager;
+extern CVehicleManager * g_pVehicleManager;
+extern CObjectManager * g_pObjectManager;
+extern CPickupManager * g_pPickupManager;
+extern CActorManager * g_pActorManager;
+extern CJoinStreamer * g_pJoinStreamer;
+extern CEntityDataManager * g_pEntityDataManager;
+
+CEntityStreamer::CEntityStreamer()
+{
+	// Get the stream distance from the settings
+	m_fDistance = CVAR_GET_FLOAT("streamdistance");
+	m_ulLastUpdateTime = 0;
+}
+
+CEntityStreamer::~CEntityStreamer()
+{
+
+}
+
+EntityStreamerSector CEntityStreamer::GetSector(const CVector3& vecPosition)
+{
+	// Sectors are the size of the stream distance so we only ever have to check
+	// the sector we are in and the 8 sectors around it
+	EntityStreamerSector sector;
+	sector.iX = (int)floor(vecPosition.fX / m_fDistance);
+	sector.iY = (int)floor(vecPosition.fY / m_fDistance);
+	return sector;
+}
+
+bool CEntityStreamer::GetEntityPosition(eEntityStreamerType type, EntityId entityId, CVector3& vecPosition, unsigned char& ucDimension)
+{
+	switch(type)
+	{
+	case ENTITY_STREAMER_VEHICLE:
+		{
+			CVehicle * pVehicle = g_pVehicleManager->GetAt(entityId);
+
+			if(!pVehicle)
+				return false;
+
+			pVehicle->GetPosition(vecPosition);
+			ucDimension = pVehicle->GetDimension();
+			return true;
+		}
+	case ENTITY_STREAMER_OBJECT:
+		{
+			if(!g_pObjectManager->DoesExist(entityId))
+				return false;
+
+			// Attached objects are wherever the entity they are attached to is
+			vecPosition = CVector3();
+
+			if(g_pObjectManager->GetAttachState(entityId))
+			{
+				EntityId attachId = (EntityId)g_pObjectManager->GetAttachId(entityId);
+
+				if(g_pObjectManager->IsVehicleAttached(entityId))
+				{
+					CVehicle * pVehicle = g_pVehicleManager->GetAt(attachId);
+
+					if(pVehicle)
+						pVehicle->GetPosition(vecPosition);
+				}
+				else
+				{
+					CPlayer * pPlayer = g_pPlayerManager->GetAt(attachId);
+
+					if(pPlayer)
+						pPlayer->GetPosition(vecPosition);
+				}
+			}
+			else
+				g_pObjectManager->GetPosition(entityId, vecPosition);
+
+			ucDimension = g_pObjectManager->GetDimension(entityId);
+			return true;
+		}
+	case ENTITY_STREAMER_PICKUP:
+		{
+			if(!g_pPickupManager->GetPosition(entityId, &vecPosition))
+				return false;
+
+			// Pickups don't have a dimension
+			ucDimension = ENTITY_STREAMER_ALL_DIMENSIONS;
+			return true;
+		}
+	case ENTITY_STREAMER_ACTOR:
+		{
+			if(!g_pActorManager->DoesExist(entityId))
+				return false;
+
+			// Actors on a path are where the server has moved them to, they don't have a dimension either
+			vecPosition = g_pActorManager->GetPosition(entityId);
+			ucDimension = ENTITY_STREAMER_ALL_DIMENSIONS;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CEntityStreamer::AddToGrid(eEntityStreamerType type, EntityId entityId)
+{
+	EntityStreamerEntry entry;
+	entry.type = type;
+	entry.entityId = entityId;
+
+	if(GetEntityPosition(type, entityId, entry.vecPosition, entry.ucDimension))
+		m_sectors[GetSector(entry.vecPosition)].push_back(entry);
+}
+
+void CEntityStreamer::BuildGrid()
+{
+	// Vehicles, attached objects and actors on paths move so the grid is rebuilt for every update
+	m_sectors.clear();
+
+	const std::vector<EntityId>& vehicles = g_pVehicleManager->GetActiveVehicles();
+
+	for(size_t i = 0; i < vehicles.size(); i++)
+		AddToGrid(ENTITY_STREAMER_VEHICLE, vehicles[i]);
+
+	const std::vector<EntityId>& objects = g_pObjectManager->GetActiveObjects();
+
+	for(size_t i = 0; i < objects.size(); i++)
+		AddToGrid(ENTITY_STREAMER_OBJECT, objects[i]);
+
+	for(EntityId x = 0; x < MAX_PICKUPS; x++)
+	{
+		if(g_pPickupManager->DoesExist(x))
+			AddToGrid(ENTITY_STREAMER_PICKUP, x);
+	}
+
+	for(EntityId x = 0; x < MAX_ACTORS; x++)
+	{
+		if(g_pActorManager->DoesExist(x))
+			AddToGrid(ENTITY_STREAMER_ACTOR, x);
+	}
+}
+
+void CEntityStreamer::StreamIn(EntityId playerId, eEntityStreamerType type, std::list<EntityId>& entityList)
+{
+	switch(type)
+	{
+	case ENTITY_STREAMER_VEHICLE:
+		g_pVehicleManager->SpawnForPlayer(playerId, entityList);
+		g_pEntityDataManager->HandleStreamIn(playerId, ENTITY_DATA_VEHICLE, entityList);
+		break;
+	case ENTITY_STREAMER_OBJECT:
+		g_pObjectManager->SpawnForPlayer(playerId, entityList);
+		g_pEntityDataManager->HandleStreamIn(playerId, ENTITY_DATA_OBJECT, entityList);
+		break;
+	case ENTITY_STREAMER_PICKUP:
+		g_pPickupManager->SpawnForPlayer(playerId, entityList);
+		break;
+	case ENTITY_STREAMER_ACTOR:
+		g_pActorManager->SpawnForPlayer(playerId, entityList);
+		break;
+	}
+}
+
+void CEntityStreamer::StreamOut(EntityId playerId, eEntityStreamerType type, EntityId entityId)
+{
+	switch(type)
+	{
+	case ENTITY_STREAMER_VEHICLE:
+		{
+			CVehicle * pVehicle = g_pVehicleManager->GetAt(entityId);
+
+			if(pVehicle)
+				pVehicle->DestroyForPlayer(playerId);
+		}
+		break;
+	case ENTITY_STREAMER_OBJECT:
+		g_pObjectManager->DeleteForPlayer(entityId, playerId);
+		break;
+	case ENTITY_STREAMER_PICKUP:
+		g_pPickupManager->DeleteForPlayer(entityId, playerId);
+		break;
+	case ENTITY_STREAMER_ACTOR:
+		g_pActorManager->DeleteForPlayer(entityId, playerId);
+		break;
+	}
+}
+
+void CEntityStreamer::UpdateRelay(EntityId playerId)
+{
+	// Relay nodes fan the game out to spectators all over the map so they get
+	// every entity of every dimension and keep it until it is deleted
+	std::list<EntityId> streamInList[ENTITY_STREAMER_TYPE_MAX];
+
+	for(std::map<EntityStreamerSector, std::vector<EntityStreamerEntry> >::iterator iter = m_sectors.begin(); iter != m_sectors.end(); iter++)
+	{
+		for(std::vector<EntityStreamerEntry>::iterator entryIter = iter->second.begin(); entryIter != iter->second.end(); entryIter++)
+		{
+			if(m_streamedEntities[playerId][entryIter->type].insert(entryIter->entityId).second)
+				streamInList[entryIter->type].push_back(entryIter->entityId);
+		}
+	}
+
+	for(int i = 0; i < ENTITY_STREAMER_TYPE_MAX; i++)
+	{
+		if(!streamInList[i].empty())
+			StreamIn(playerId, (eEntityStreamerType)i, streamInList[i]);
+	}
+}
+
+void CEntityStreamer::UpdatePlayer(EntityId playerId)
+{
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(pPlayer && pPlayer->IsRelay())
+	{
+		UpdateRelay(playerId);
+		return;
+	}
+
+	// We only know where the player is once they have spawned, until then
+	// (and while they are dead) they keep what they have
+	if(!pPlayer || !pPlayer->IsSpawned())
+		return;
+
+	CVector3 vecPosition;
+
+	if(pPlayer->IsInVehicle())
+		pPlayer->GetVehicle()->GetPosition(vecPosition);
+	else
+		pPlayer->GetPosition(vecPosition);
+
+	unsigned char ucDimension = pPlayer->GetDimension();
+	float fOutDistance = (m_fDistance * ENTITY_STREAMER_OUT_FACTOR);
+
+	// Stream out all entities that are too far away or in another dimension
+	for(int i = 0; i < ENTITY_STREAMER_TYPE_MAX; i++)
+	{
+		std::set<EntityId> * pStreamed = &m_streamedEntities[playerId][i];
+		std::set<EntityId>::iterator iter = pStreamed->begin();
+
+		while(iter != pStreamed->end())
+		{
+			CVector3 vecEntityPosition;
+			unsigned char ucEntityDimension;
+
+			// Has the entity been deleted? (its manager has already told the client)
+			if(!GetEntityPosition((eEntityStreamerType)i, *iter, vecEntityPosition, ucEntityDimension))
+			{
+				pStreamed->erase(iter++);
+				continue;
+			}
+
+			if((ucEntityDimension != ENTITY_STREAMER_ALL_DIMENSIONS && ucEntityDimension != ucDimension) ||
+				(vecEntityPosition - vecPosition).Length() > fOutDistance)
+			{
+				StreamOut(playerId, (eEntityStreamerType)i, *iter);
+				pStreamed->erase(iter++);
+				continue;
+			}
+
+			iter++;
+		}
+	}
+
+	// Stream in all entities in the sector we are in and all sectors surrounding it
+	std::list<EntityId> streamInList[ENTITY_STREAMER_TYPE_MAX];
+	EntityStreamerSector centerSector = GetSector(vecPosition);
+	EntityStreamerSector sector;
+
+	for(sector.iX = (centerSector.iX - 1); sector.iX <= (centerSector.iX + 1); sector.iX++)
+	{
+		for(sector.iY = (centerSector.iY - 1); sector.iY <= (centerSector.iY + 1); sector.iY++)
+		{
+			std::map<EntityStreamerSector, std::vector<EntityStreamerEntry> >::iterator iter = m_sectors.find(sector);
+
+			if(iter == m_sectors.end())
+				continue;
+
+			for(std::vector<EntityStreamerEntry>::iterator entryIter = iter->second.begin(); entryIter != iter->second.end(); entryIter++)
+			{
+				if(entryIter->ucDimension != ENTITY_STREAMER_ALL_DIMENSIONS && entryIter->ucDimension != ucDimension)
+					continue;
+
+				if((entryIter->vecPosition - vecPosition).Length() > m_fDistance)
+					continue;
+
+				// Only stream in entities we haven't already streamed in
+				if(m_streamedEntities[playerId][entryIter->type].insert(entryIter->entityId).second)
+					streamInList[entryIter->type].push_back(entryIter->entityId);
+			}
+		}
+	}
+
+	for(int i = 0; i < ENTITY_STREAMER_TYPE_MAX; i++)
+	{
+		if(!streamInList[i].empty())
+			StreamIn(playerId, (eEntityStreamerType)i, streamInList[i]);
+	}
+}
+
+bool CEntityStreamer::IsStreamedIn(EntityId playerId, eEntityStreamerType type, EntityId entityId)
+{
+	if(playerId >= MAX_PLAYERS || type >= ENTITY_STREAMER_TYPE_MAX)
+		return false;
+
+	std::set<EntityId> * pStreamed = &m_streamedEntities[playerId][type];
+	return (pStreamed->find(entityId) != pStreamed->end());
+}
+
+void CEntityStreamer::RemoveEntity(eEntityStreamerType type, EntityId entityId)
+{
+	if(type >= ENTITY_STREAMER_TYPE_MAX)
+		return;
+
+	// Stream the entity out for everyone that has it streamed in (RemovePlayer
+	// clears the players that left so only the active ones can have it)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(m_streamedEntities[players[i]][type].erase(entityId) > 0)
+			StreamOut(players[i], type, entityId);
+	}
+}
+
+void CEntityStreamer::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	for(int i = 0; i < ENTITY_STREAMER_TYPE_MAX; i++)
+		m_streamedEntities[playerId][i].clear();
+}
+
+void CEntityStreamer::Process()
+{
+	if(!IsEnabled())
+		return;
+
+	// Is it time for an update?
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastUpdateTime) < ENTITY_STREAMER_UPDATE_INTERVAL)
+		return;
+
+	m_ulLastUpdateTime = ulTime;
+	BuildGrid();
+
+	// Players whose join state is still streaming get their entities once
+	// they have joined the game
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		if(!g_pJoinStreamer->IsStreaming(players[i]))
+			UpdatePlayer(players[i]);
+	}
+}
@@ -0,0 +1,90 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEntityStreamer.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include <Common.h>
+
+// Interval in ms at which the streamed entities of all players are updated
+#define ENTITY_STREAMER_UPDATE_INTERVAL 500
+
+// Entities are only streamed out again once they are this much further away
+// than the stream distance so they don't flicker at the edge of it
+#define ENTITY_STREAMER_OUT_FACTOR 1.2f
+
+// Dimension of entities that are streamed in all dimensions
+#define ENTITY_STREAMER_ALL_DIMENSIONS 0xFF
+
+// Types of entity the server streams to its clients
+enum eEntityStreamerType
+{
+	ENTITY_STREAMER_VEHICLE,
+	ENTITY_STREAMER_OBJECT,
+	ENTITY_STREAMER_PICKUP,
+	ENTITY_STREAMER_ACTOR,
+	ENTITY_STREAMER_TYPE_MAX
+};
+
+// Key for a single sector of the entity grid
+struct EntityStreamerSector
+{
+	int iX;
+	int iY;
+
+	bool operator < (const EntityStreamerSector& other) const
+	{
+		if(iX != other.iX)
+			return (iX < other.iX);
+
+		return (iY < other.iY);
+	}
+};
+
+// Entry of a single entity in the entity grid
+struct EntityStreamerEntry
+{
+	eEntityStreamerType type;
+	EntityId            entityId;
+	CVector3            vecPosition;
+	unsigned char       ucDimension;
+};
+
+class CEntityStreamer
+{
+private:
+	std::map<EntityStreamerSector, std::vector<EntityStreamerEntry> > m_sectors;
+	std::set<EntityId>                                                m_streamedEntities[MAX_PLAYERS][ENTITY_STREAMER_TYPE_MAX];
+	float                                                             m_fDistance;
+	unsigned long                                                     m_ulLastUpdateTime;
+
+	EntityStreamerSector GetSector(const CVector3& vecPosition);
+	bool                 GetEntityPosition(eEntityStreamerType type, EntityId entityId, CVector3& vecPosition, unsigned char& ucDimension);
+	void                 AddToGrid(eEntityStreamerType type, EntityId entityId);
+	void                 BuildGrid();
+	void                 UpdateRelay(EntityId playerId);
+	void                 UpdatePlayer(EntityId playerId);
+	void                 StreamIn(EntityId playerId, eEntityStreamerType type, std::list<EntityId>& entityList);
+	void                 StreamOut(EntityId playerId, eEntityStreamerType type, EntityId entityId);
+
+public:
+	CEntityStreamer();
+	~CEntityStreamer();
+
+	float                GetDistance() { return m_fDistance; }
+	bool                 IsEnabled() { return (m_fDistance > 0.0f); }
+	bool                 IsStreamedIn(EntityId playerId, eEntityStreamerType type, EntityId entityId);
+	void                 RemoveEntity(eEntityStreamerType type, EntityId entityId);
+	void                 RemovePlayer(EntityId playerId);
+	void                 Process();
+};
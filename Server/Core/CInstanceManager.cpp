@@ -0,0 +1,241 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CInstanceManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <string.h>
+#include "CInstanceManager.h"
+#include "CPlayerManager.h"
+#include <CSettings.h>
+#include <CLogFile.h>
+#include <SharedUtility.h>
+#include <Threading/CJobSystem.h>
+
+extern CScriptingManager * g_pScriptingManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CEvents * g_pEvents;
+extern CJobSystem * g_pJobSystem;
+
+CEventFilter * g_pEventFilter = NULL;
+
+CInstanceManager::CInstanceManager()
+{
+
+}
+
+CInstanceManager::~CInstanceManager()
+{
+	if(g_pEventFilter == this)
+		g_pEventFilter = NULL;
+
+	for(std::list<ServerInstance *>::iterator iter = m_instances.begin(); iter != m_instances.end(); iter++)
+		delete (*iter);
+}
+
+ServerInstance * CInstanceManager::Add(const String& strName)
+{
+	if(strName.IsEmpty() || Get(strName) || m_instances.size() >= MAX_INSTANCES)
+		return NULL;
+
+	ServerInstance * pInstance = new ServerInstance;
+	pInstance->strName = strName;
+	pInstance->ucDimension = (unsigned char)(INSTANCE_FIRST_DIMENSION - m_instances.size());
+	m_instances.push_back(pInstance);
+	return pInstance;
+}
+
+void CInstanceManager::Load(int& iLoaded, int& iFailed)
+{
+	std::list<String> instances = CVAR_GET_LIST("instance");
+
+	for(std::list<String>::iterator iter = instances.begin(); iter != instances.end(); iter++)
+	{
+		size_t sSeparator = (*iter).Find(':');
+
+		if(sSeparator == String::nPos)
+		{
+			CLogFile::Printf("Warning: Instance %s has no scripts.", (*iter).Get());
+			continue;
+		}
+
+		String strName = (*iter).SubStr(0, sSeparator);
+		ServerInstance * pInstance = Add(strName);
+
+		if(!pInstance)
+		{
+			CLogFile::Printf("Warning: Failed to add instance %s.", strName.Get());
+			continue;
+		}
+
+		// The scripts are known before they run so their first events are filtered
+		std::vector<String> scriptNames;
+		std::vector<String> scriptPaths;
+		String strScripts = (*iter).SubStr(sSeparator + 1);
+		size_t sOffset = 0;
+
+		while(sOffset <= strScripts.GetLength())
+		{
+			size_t sEnd = strScripts.Find(',', sOffset);
+
+			if(sEnd == String::nPos)
+				sEnd = strScripts.GetLength();
+
+			String strScript = strScripts.SubStr(sOffset, (sEnd - sOffset));
+			sOffset = (sEnd + 1);
+
+			if(strScript.IsEmpty())
+				continue;
+
+			String strPath = SharedUtility::GetAbsolutePath("scripts/%s", strScript.Get());
+
+			// A script belongs to one instance only, the events couldn't be filtered otherwise
+			if(m_scriptInstances.find(strPath) != m_scriptInstances.end())
+			{
+				CLogFile::Printf("Warning: Script %s of instance %s is already in another instance.", strScript.Get(), strName.Get());
+				iFailed++;
+				continue;
+			}
+
+			m_scriptInstances[strPath] = pInstance;
+			pInstance->scripts.push_back(strPath);
+			scriptNames.push_back(strScript);
+			scriptPaths.push_back(strPath);
+		}
+
+		if(!g_pEventFilter)
+			g_pEventFilter = this;
+
+		std::vector<CSquirrel *> loadedScripts = g_pScriptingManager->Load(scriptNames, scriptPaths, g_pJobSystem);
+
+		for(size_t i = 0; i < loadedScripts.size(); i++)
+		{
+			if(!loadedScripts[i])
+			{
+				CLogFile::Printf("Warning: Failed to load script %s of instance %s.", scriptNames[i].Get(), strName.Get());
+				iFailed++;
+			}
+			else
+				iLoaded++;
+		}
+
+		CLogFile::Printf("Instance %s runs in dimension %d.", strName.Get(), pInstance->ucDimension);
+	}
+}
+
+ServerInstance * CInstanceManager::Get(const String& strName)
+{
+	for(std::list<ServerInstance *>::iterator iter = m_instances.begin(); iter != m_instances.end(); iter++)
+	{
+		if((*iter)->strName == strName)
+			return (*iter);
+	}
+
+	return NULL;
+}
+
+ServerInstance * CInstanceManager::GetByDimension(unsigned char ucDimension)
+{
+	if(ucDimension > INSTANCE_FIRST_DIMENSION || ucDimension <= (INSTANCE_FIRST_DIMENSION - m_instances.size()))
+		return NULL;
+
+	for(std::list<ServerInstance *>::iterator iter = m_instances.begin(); iter != m_instances.end(); iter++)
+	{
+		if((*iter)->ucDimension == ucDimension)
+			return (*iter);
+	}
+
+	return NULL;
+}
+
+ServerInstance * CInstanceManager::GetScriptInstance(SQVM * pVM)
+{
+	// Coroutines run on threads of their own
+	pVM = g_pScriptingManager->GetScriptVM(pVM);
+	std::map<SQVM *, ServerInstance *>::iterator iter = m_vmInstances.find(pVM);
+
+	if(iter != m_vmInstances.end())
+		return (*iter).second;
+
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+
+	if(!pScript)
+		return NULL;
+
+	// Hot reloaded scripts keep their path and so their instance
+	ServerInstance * pInstance = NULL;
+	std::map<String, ServerInstance *>::iterator pathIter = m_scriptInstances.find(pScript->GetPath());
+
+	if(pathIter != m_scriptInstances.end())
+		pInstance = (*pathIter).second;
+
+	m_vmInstances[pVM] = pInstance;
+	return pInstance;
+}
+
+ServerInstance * CInstanceManager::GetPlayerInstance(EntityId playerId)
+{
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer)
+		return NULL;
+
+	return GetByDimension(pPlayer->GetDimension());
+}
+
+bool CInstanceManager::SetPlayerInstance(EntityId playerId, ServerInstance * pInstance)
+{
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer)
+		return false;
+
+	ServerInstance * pOldInstance = GetByDimension(pPlayer->GetDimension());
+
+	if(pOldInstance == pInstance)
+		return true;
+
+	// The old instance gets the event while the player is still in it
+	if(pOldInstance)
+	{
+		CSquirrelArguments arguments;
+		arguments.push(playerId);
+		arguments.push(pOldInstance->strName);
+		g_pEvents->Call("playerLeaveInstance", &arguments);
+	}
+
+	pPlayer->SetDimension(pInstance ? pInstance->ucDimension : 0);
+
+	if(pInstance)
+	{
+		CSquirrelArguments arguments;
+		arguments.push(playerId);
+		arguments.push(pInstance->strName);
+		g_pEvents->Call("playerEnterInstance", &arguments);
+	}
+
+	return true;
+}
+
+void CInstanceManager::RemoveScript(SQVM * pVM)
+{
+	m_vmInstances.erase(pVM);
+}
+
+bool CInstanceManager::IsFiltered(EventId eventId, const String& strName, CSquirrelArguments * pArguments, SQVM * pVM)
+{
+	// Only the player events (their first argument is the player) are filtered
+	if(strName.GetLength() <= 6 || strncmp(strName.Get(), "player", 6) || !pArguments || pArguments->size() == 0 || pArguments->front()->GetType() != OT_INTEGER)
+		return false;
+
+	ServerInstance * pInstance = GetScriptInstance(pVM);
+
+	if(!pInstance)
+		return false;
+
+	CPlayer * pPlayer = g_pPlayerManager->GetAt((EntityId)pArguments->front()->GetInteger());
+	return (pPlayer && pPlayer->GetDimension() != pInstance->ucDimension);
+}
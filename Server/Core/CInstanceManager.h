@@ -0,0 +1,64 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CInstanceManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <list>
+#include <map>
+#include <Common.h>
+#include <CEvents.h>
+
+// Dimension of the first instance, the others get the dimensions below it
+#define INSTANCE_FIRST_DIMENSION 255
+
+// Most instances a server can have (the dimensions below them stay free for the scripts)
+#define MAX_INSTANCES 64
+
+// A world of its own in the server, its scripts only get the player events of
+// the players in its dimension
+struct ServerInstance
+{
+	String            strName;
+	unsigned char     ucDimension;
+	std::list<String> scripts;     // The paths of its scripts
+};
+
+// Runs the instances of the instance setting ("name:script.nut,script.nut"). They
+// share the network, the resources and the job system of the server, the players
+// move between them without reconnecting. The scripts that aren't in an instance
+// get all events like before.
+class CInstanceManager : public CEventFilter
+{
+private:
+	std::list<ServerInstance *>        m_instances;
+	std::map<String, ServerInstance *> m_scriptInstances; // By the path of the script
+	std::map<SQVM *, ServerInstance *> m_vmInstances;     // The looked up scripts, NULL for scripts in no instance
+
+	ServerInstance            * Add(const String& strName);
+
+public:
+	CInstanceManager();
+	~CInstanceManager();
+
+	// Loads the instances and their scripts, adds the scripts to the counts
+	void                        Load(int& iLoaded, int& iFailed);
+	ServerInstance            * Get(const String& strName);
+	ServerInstance            * GetByDimension(unsigned char ucDimension);
+	ServerInstance            * GetScriptInstance(SQVM * pVM);
+	ServerInstance            * GetPlayerInstance(EntityId playerId);
+
+	// Moves the player to the dimension of the instance (NULL for none), the scripts
+	// of the old instance get playerLeaveInstance and those of the new one playerEnterInstance
+	bool                        SetPlayerInstance(EntityId playerId, ServerInstance * pInstance);
+	void                        RemoveScript(SQVM * pVM);
+	std::list<ServerInstance *> * GetInstances() { return &m_instances; }
+
+	bool                        IsFiltered(EventId eventId, const String& strName, CSquirrelArguments * pArguments, SQVM * pVM);
+};
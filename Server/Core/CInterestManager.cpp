@@ -0,0 +1,203 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CInterestManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CInterestManager.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include "CSnapshotManager.h"
+#include "CBroadcastGroupManager.h"
+#include "CSpatialIndex.h"
+#include <CSettings.h>
+#include <SharedUtility.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CSnapshotManager * g_pSnapshotManager;
+extern CBroadcastGroupManager * g_pBroadcastGroupManager;
+extern CSpatialIndex * g_pSpatialIndex;
+
+CInterestManager::CInterestManager()
+{
+	// Reset all entries
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		m_entries[x].bActive = false;
+		m_entries[x].ucDimension = 0;
+		m_entries[x].ulLastFarSyncTime = 0;
+	}
+
+	// Get the range and far sync interval from the settings
+	m_fRange = CVAR_GET_FLOAT("syncrange");
+	m_ulFarSyncInterval = (unsigned long)CVAR_GET_INTEGER("farsyncinterval");
+}
+
+CInterestManager::~CInterestManager()
+{
+
+}
+
+void CInterestManager::SetRange(float fRange)
+{
+	if(fRange < 0.0f)
+		fRange = 0.0f;
+
+	m_fRange = fRange;
+}
+
+void CInterestManager::UpdatePlayer(EntityId playerId, const CVector3& vecPosition, unsigned char ucDimension)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	InterestEntry * pEntry = &m_entries[playerId];
+
+	if(!pEntry->bActive)
+	{
+		pEntry->bActive = true;
+		pEntry->ulLastFarSyncTime = 0;
+	}
+
+	pEntry->vecPosition = vecPosition;
+	pEntry->ucDimension = ucDimension;
+
+	// Keep the spatial index up to date, the range queries go through it
+	g_pSpatialIndex->Update(SPATIAL_INDEX_PLAYER, playerId, vecPosition, ucDimension);
+}
+
+void CInterestManager::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS || !m_entries[playerId].bActive)
+		return;
+
+	g_pSpatialIndex->Remove(SPATIAL_INDEX_PLAYER, playerId);
+	m_entries[playerId].bActive = false;
+}
+
+bool CInterestManager::IsInRange(EntityId playerId, EntityId targetId)
+{
+	if(playerId >= MAX_PLAYERS || targetId >= MAX_PLAYERS)
+		return false;
+
+	// If interest management is disabled everyone is in range
+	if(!IsEnabled())
+		return true;
+
+	InterestEntry * pEntry = &m_entries[playerId];
+	InterestEntry * pTarget = &m_entries[targetId];
+
+	if(!pEntry->bActive || !pTarget->bActive || pEntry->ucDimension != pTarget->ucDimension)
+		return false;
+
+	return ((pEntry->vecPosition - pTarget->vecPosition).Length() <= m_fRange);
+}
+
+void CInterestManager::GetPlayersInRange(EntityId playerId, InterestPlayerList& playerList)
+{
+	if(playerId >= MAX_PLAYERS || !m_entries[playerId].bActive)
+		return;
+
+	InterestEntry * pEntry = &m_entries[playerId];
+	std::vector<EntityId> players;
+	g_pSpatialIndex->GetInRange(SPATIAL_INDEX_PLAYER, pEntry->vecPosition, m_fRange, pEntry->ucDimension, players);
+
+	for(std::vector<EntityId>::iterator iter = players.begin(); iter != players.end(); iter++)
+	{
+		if((*iter) != playerId)
+			playerList.push_back(*iter);
+	}
+}
+
+void CInterestManager::GetSyncTargets(EntityId playerId, InterestPlayerList& targetList)
+{
+	// If we don't know where the player is send it to everyone
+	if(playerId >= MAX_PLAYERS || !m_entries[playerId].bActive)
+	{
+		const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+		for(size_t i = 0; i < players.size(); i++)
+		{
+			if(players[i] != playerId)
+				targetList.push_back(players[i]);
+		}
+
+		return;
+	}
+
+	// Relay nodes get the sync of everyone no matter where they are
+	const std::vector<EntityId>& relays = g_pPlayerManager->GetRelays();
+
+	for(size_t i = 0; i < relays.size(); i++)
+	{
+		if(relays[i] != playerId)
+			targetList.push_back(relays[i]);
+	}
+
+	// If interest management is disabled send it to everyone in the same dimension
+	if(!IsEnabled())
+	{
+		const std::vector<EntityId> * pMembers = g_pBroadcastGroupManager->GetMembers(CBroadcastGroupManager::GetDimensionGroup(m_entries[playerId].ucDimension));
+
+		for(std::vector<EntityId>::const_iterator iter = pMembers->begin(); iter != pMembers->end(); iter++)
+		{
+			if((*iter) != playerId && g_pPlayerManager->DoesExist(*iter) && !g_pPlayerManager->GetAt(*iter)->IsRelay())
+				targetList.push_back(*iter);
+		}
+
+		return;
+	}
+
+	// Send the sync to all players in range
+	bool bSent[MAX_PLAYERS];
+	memset(bSent, 0, sizeof(bSent));
+	bSent[playerId] = true;
+
+	for(size_t i = 0; i < relays.size(); i++)
+		bSent[relays[i]] = true;
+	InterestPlayerList playerList;
+	GetPlayersInRange(playerId, playerList);
+
+	for(InterestPlayerList::iterator iter = playerList.begin(); iter != playerList.end(); iter++)
+	{
+		if(g_pPlayerManager->DoesExist(*iter))
+		{
+			targetList.push_back(*iter);
+			bSent[*iter] = true;
+		}
+	}
+
+	// Is it time to send a far sync to the players not in range?
+	InterestEntry * pEntry = &m_entries[playerId];
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if(m_ulFarSyncInterval > 0 && (ulTime - pEntry->ulLastFarSyncTime) >= m_ulFarSyncInterval)
+	{
+		// Send the sync to all players in the same dimension that are out of range
+		const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+		for(size_t i = 0; i < players.size(); i++)
+		{
+			EntityId x = players[i];
+
+			if(!bSent[x] && (!m_entries[x].bActive || m_entries[x].ucDimension == pEntry->ucDimension))
+				targetList.push_back(x);
+		}
+
+		pEntry->ulLastFarSyncTime = ulTime;
+	}
+}
+
+void CInterestManager::SyncRPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId)
+{
+	// Queue the sync for all interested players, it is sent with the next snapshot
+	InterestPlayerList targetList;
+	GetSyncTargets(playerId, targetList);
+
+	for(InterestPlayerList::iterator iter = targetList.begin(); iter != targetList.end(); iter++)
+		g_pSnapshotManager->Queue(*iter, playerId, rpcId, pBitStream);
+}
@@ -0,0 +1,55 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CInterestManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <list>
+#include <Common.h>
+#include <CFrameArena.h>
+#include <Network/CBitStream.h>
+#include <Network/PacketPriorities.h>
+#include <Network/PacketReliabilities.h>
+#include <Network/RPCIdentifiers.h>
+
+// Players a sync goes to, the lists don't outlive the tick they are made in
+typedef std::list<EntityId, CFrameAllocator<EntityId> > InterestPlayerList;
+
+// Interest state of a single player
+struct InterestEntry
+{
+	bool           bActive;
+	CVector3       vecPosition;
+	unsigned char  ucDimension;
+	unsigned long  ulLastFarSyncTime;
+};
+
+class CInterestManager
+{
+private:
+	InterestEntry  m_entries[MAX_PLAYERS];
+	float          m_fRange;
+	unsigned long  m_ulFarSyncInterval;
+
+public:
+	CInterestManager();
+	~CInterestManager();
+
+	void           SetRange(float fRange);
+	float          GetRange() { return m_fRange; }
+	void           SetFarSyncInterval(unsigned long ulFarSyncInterval) { m_ulFarSyncInterval = ulFarSyncInterval; }
+	unsigned long  GetFarSyncInterval() { return m_ulFarSyncInterval; }
+	bool           IsEnabled() { return (m_fRange > 0.0f); }
+	void           UpdatePlayer(EntityId playerId, const CVector3& vecPosition, unsigned char ucDimension);
+	void           RemovePlayer(EntityId playerId);
+	bool           IsInRange(EntityId playerId, EntityId targetId);
+	void           GetPlayersInRange(EntityId playerId, InterestPlayerList& playerList);
+	void           GetSyncTargets(EntityId playerId, InterestPlayerList& targetList);
+	void           SyncRPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId);
+};
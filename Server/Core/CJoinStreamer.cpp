@@ -0,0 +1,290 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CJoinStreamer.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CJoinStreamer.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include "CVehicleManager.h"
+#include "CObjectManager.h"
+#include "CBlipManager.h"
+#include "CCheckpointManager.h"
+#include "CPickupManager.h"
+#include "CActorManager.h"
+#include "CClientFileManager.h"
+#include "CClientFilePack.h"
+#include "CServerRPCHandler.h"
+#include "CEvents.h"
+#include "CEntityStreamer.h"
+#include "CEntityDataManager.h"
+#include "CTransferManager.h"
+#include <CSettings.h>
+#include <CLogFile.h>
+#include <SharedUtility.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CVehicleManager * g_pVehicleManager;
+extern CObjectManager * g_pObjectManager;
+extern CBlipManager * g_pBlipManager;
+extern CCheckpointManager * g_pCheckpointManager;
+extern CPickupManager * g_pPickupManager;
+extern CActorManager * g_pActorManager;
+extern CClientFileManager * g_pClientScriptFileManager;
+extern CClientFileManager * g_pClientResourceFileManager;
+extern CClientFilePack * g_pClientFilePack;
+extern CEvents * g_pEvents;
+extern CEntityStreamer * g_pEntityStreamer;
+extern CEntityDataManager * g_pEntityDataManager;
+extern CTransferManager * g_pTransferManager;
+
+CJoinStreamer::CJoinStreamer()
+{
+	// Reset all streams
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+		m_streams[x].bActive = false;
+
+	// Get the join stream bandwidth from the settings
+	m_uiBandwidth = (unsigned int)CVAR_GET_INTEGER("joinstreambandwidth");
+	m_ulLastProcessTime = SharedUtility::GetTime();
+}
+
+CJoinStreamer::~CJoinStreamer()
+{
+
+}
+
+void CJoinStreamer::Add(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	JoinStream * pStream = &m_streams[playerId];
+	pStream->bActive = true;
+	pStream->stage = JOIN_STREAM_STAGE_VEHICLES;
+	pStream->cursor.entityId = 0;
+	pStream->cursor.uiBytes = 0;
+	pStream->cursor.uiEntities = 0;
+	pStream->uiEntitiesSent = 0;
+	pStream->ucProgress = 0;
+	pStream->iBudget = 0;
+
+	// Count everything we are about to send for the progress
+	pStream->uiEntitiesTotal = (g_pBlipManager->GetBlipCount() + g_pCheckpointManager->GetCheckpointCount() + 
+		g_pClientResourceFileManager->size() + g_pClientScriptFileManager->size());
+
+	// Vehicles, objects, pickups and actors are streamed in by the entity streamer
+	// once the player has joined if it is enabled
+	if(!g_pEntityStreamer->IsEnabled())
+	{
+		pStream->uiEntitiesTotal += (g_pVehicleManager->GetVehicleCount() + g_pObjectManager->GetObjectCount() + g_pPickupManager->GetPickupCount() +
+			g_pActorManager->GetActorCount());
+	}
+
+	SendProgress(playerId, 0);
+}
+
+void CJoinStreamer::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_streams[playerId].bActive = false;
+}
+
+bool CJoinStreamer::IsStreaming(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return false;
+
+	return m_streams[playerId].bActive;
+}
+
+unsigned char CJoinStreamer::GetProgress(JoinStream * pStream)
+{
+	if(pStream->stage == JOIN_STREAM_STAGE_COMPLETE)
+		return 100;
+
+	if(pStream->uiEntitiesTotal == 0)
+		return 0;
+
+	unsigned int uiProgress = ((pStream->uiEntitiesSent * 100) / pStream->uiEntitiesTotal);
+
+	// Don't report 100% before we are done (entities can be added while we stream)
+	if(uiProgress > 99)
+		uiProgress = 99;
+
+	return (unsigned char)uiProgress;
+}
+
+void CJoinStreamer::SendProgress(EntityId playerId, unsigned char ucProgress)
+{
+	CBitStream bsSend;
+	bsSend.Write(ucProgress);
+	g_pNetworkManager->RPC(RPC_JoinProgress, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+bool CJoinStreamer::ProcessStage(EntityId playerId, JoinStream * pStream)
+{
+	JoinStreamCursor * pCursor = &pStream->cursor;
+	pCursor->uiBytes = 0;
+	pCursor->uiEntities = 0;
+
+	switch(pStream->stage)
+	{
+	case JOIN_STREAM_STAGE_VEHICLES:
+		if(g_pEntityStreamer->IsEnabled())
+			return true;
+
+		return g_pVehicleManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_PLAYERS:
+		g_pPlayerManager->HandleClientJoin(playerId);
+		return true;
+	case JOIN_STREAM_STAGE_OBJECTS:
+		if(g_pEntityStreamer->IsEnabled())
+			return true;
+
+		return g_pObjectManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_FIRES:
+		g_pObjectManager->HandleClientJoinFire(playerId);
+		return true;
+	case JOIN_STREAM_STAGE_BLIPS:
+		return g_pBlipManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_PLAYER_BLIPS:
+		g_pBlipManager->HandleClientJoinPlayerBlips(playerId);
+		return true;
+	case JOIN_STREAM_STAGE_CHECKPOINTS:
+		return g_pCheckpointManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_PICKUPS:
+		if(g_pEntityStreamer->IsEnabled())
+			return true;
+
+		return g_pPickupManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_ACTORS:
+		if(g_pEntityStreamer->IsEnabled())
+			return true;
+
+		return g_pActorManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_PLAYER_DATA:
+		return g_pEntityDataManager->HandleClientJoin(playerId, ENTITY_DATA_PLAYER, pCursor);
+	case JOIN_STREAM_STAGE_VEHICLE_DATA:
+		return g_pEntityDataManager->HandleClientJoin(playerId, ENTITY_DATA_VEHICLE, pCursor);
+	case JOIN_STREAM_STAGE_OBJECT_DATA:
+		return g_pEntityDataManager->HandleClientJoin(playerId, ENTITY_DATA_OBJECT, pCursor);
+	case JOIN_STREAM_STAGE_JOINED_GAME:
+		CServerRPCHandler::SendJoinedGame(playerId);
+		return true;
+	case JOIN_STREAM_STAGE_FILE_PACK:
+		g_pClientFilePack->HandleClientJoin(playerId);
+		return true;
+	case JOIN_STREAM_STAGE_RESOURCE_FILES:
+		return g_pClientResourceFileManager->HandleClientJoin(playerId, pCursor);
+	case JOIN_STREAM_STAGE_SCRIPT_FILES:
+		return g_pClientScriptFileManager->HandleClientJoin(playerId, pCursor);
+	}
+
+	return true;
+}
+
+void CJoinStreamer::Process()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+	unsigned long ulElapsedTime = (ulTime - m_ulLastProcessTime);
+	m_ulLastProcessTime = ulTime;
+
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		EntityId x = players[i];
+		JoinStream * pStream = &m_streams[x];
+
+		if(!pStream->bActive)
+			continue;
+
+		// Is the clients send buffer still backed up with what we sent earlier?
+		CNetStats * pNetStats = g_pNetworkManager->GetNetServer()->GetPlayerNetStats(x);
+
+		if(pNetStats && pNetStats->dBytesInSendBuffer[PRIORITY_HIGH] > JOIN_STREAM_MAX_SEND_BUFFER)
+			continue;
+
+		// Add the bandwidth of the elapsed time to the budget
+		if(m_uiBandwidth > 0)
+		{
+			int iMaxBudget = (int)((m_uiBandwidth * JOIN_STREAM_BUDGET_BURST) / 1000);
+
+			if(iMaxBudget < JOIN_STREAM_MESSAGE_SIZE)
+				iMaxBudget = JOIN_STREAM_MESSAGE_SIZE;
+
+			pStream->iBudget += (int)((m_uiBandwidth * ulElapsedTime) / 1000);
+
+			if(pStream->iBudget > iMaxBudget)
+				pStream->iBudget = iMaxBudget;
+		}
+		else
+			pStream->iBudget = JOIN_STREAM_MAX_SEND_BUFFER;
+
+		// Send as much of the join state as fits in the budget, a message can
+		// overdraw it which is paid back over the next ticks
+		while(pStream->iBudget > 0 && pStream->stage != JOIN_STREAM_STAGE_COMPLETE)
+		{
+			bool bStageComplete = ProcessStage(x, pStream);
+			pStream->iBudget -= (int)pStream->cursor.uiBytes;
+			pStream->uiEntitiesSent += pStream->cursor.uiEntities;
+
+			if(bStageComplete)
+			{
+				pStream->stage = (eJoinStreamStage)(pStream->stage + 1);
+				pStream->cursor.entityId = 0;
+			}
+
+			// Did the script disconnect the player?
+			if(!g_pPlayerManager->DoesExist(x))
+			{
+				RemovePlayer(x);
+				break;
+			}
+		}
+
+		if(!pStream->bActive)
+			continue;
+
+		// Has the progress changed enough to tell the client?
+		unsigned char ucProgress = GetProgress(pStream);
+
+		if(ucProgress == 100 || ucProgress >= (pStream->ucProgress + JOIN_STREAM_PROGRESS_STEP))
+		{
+			pStream->ucProgress = ucProgress;
+			SendProgress(x, ucProgress);
+		}
+
+		// Are we done?
+		if(pStream->stage == JOIN_STREAM_STAGE_COMPLETE)
+		{
+			pStream->bActive = false;
+			CPlayer * pPlayer = g_pPlayerManager->GetAt(x);
+
+			// Relay nodes are no players to the scripts
+			if(pPlayer->IsRelay())
+			{
+				CLogFile::Printf("[Relay] %s (%d) is relaying the game.", pPlayer->GetName().Get(), x);
+				continue;
+			}
+
+			// Call the playerJoin event
+			CSquirrelArguments pArguments;
+			pArguments.push(x);
+			g_pEvents->Call("playerJoin", &pArguments);
+
+			// Players from another server get their state and playerTransfer after playerJoin
+			g_pTransferManager->Join(x);
+
+			CLogFile::Printf("[Join] %s (%d) has joined the game.", pPlayer->GetName().Get(), x);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CJoinStreamer.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <Common.h>
+
+// Size in bytes after which a packed join state message is sent and a new one started
+#define JOIN_STREAM_MESSAGE_SIZE 4096
+
+// Amount of ms worth of bandwidth a joining client can save up
+#define JOIN_STREAM_BUDGET_BURST 100
+
+// Bytes of reliable data waiting in a clients send buffer after which no more
+// join state is sent to them until it drains
+#define JOIN_STREAM_MAX_SEND_BUFFER (JOIN_STREAM_MESSAGE_SIZE * 8)
+
+// Minimum change in percent before a new progress update is sent to the client
+#define JOIN_STREAM_PROGRESS_STEP 5
+
+// Position of an entity manager in the join state stream, passed to its
+// HandleClientJoin so it can continue where the last message stopped
+struct JoinStreamCursor
+{
+	EntityId     entityId;   // Next entity (or file) to send
+	unsigned int uiBytes;    // Bytes sent by the last call
+	unsigned int uiEntities; // Entities sent by the last call
+};
+
+// Order in which the join state is streamed (vehicles first as players and
+// actors can be in them, the files after the joined game rpc)
+enum eJoinStreamStage
+{
+	JOIN_STREAM_STAGE_VEHICLES,
+	JOIN_STREAM_STAGE_PLAYERS,
+	JOIN_STREAM_STAGE_OBJECTS,
+	JOIN_STREAM_STAGE_FIRES,
+	JOIN_STREAM_STAGE_BLIPS,
+	JOIN_STREAM_STAGE_PLAYER_BLIPS,
+	JOIN_STREAM_STAGE_CHECKPOINTS,
+	JOIN_STREAM_STAGE_PICKUPS,
+	JOIN_STREAM_STAGE_ACTORS,
+	JOIN_STREAM_STAGE_PLAYER_DATA,
+	JOIN_STREAM_STAGE_VEHICLE_DATA,
+	JOIN_STREAM_STAGE_OBJECT_DATA,
+	JOIN_STREAM_STAGE_JOINED_GAME,
+	JOIN_STREAM_STAGE_FILE_PACK,
+	JOIN_STREAM_STAGE_RESOURCE_FILES,
+	JOIN_STREAM_STAGE_SCRIPT_FILES,
+	JOIN_STREAM_STAGE_COMPLETE
+};
+
+// Join state stream of a single player
+struct JoinStream
+{
+	bool             bActive;
+	eJoinStreamStage stage;
+	JoinStreamCursor cursor;
+	unsigned int     uiEntitiesSent;
+	unsigned int     uiEntitiesTotal;
+	unsigned char    ucProgress;
+	int              iBudget;
+};
+
+class CJoinStreamer
+{
+private:
+	JoinStream    m_streams[MAX_PLAYERS];
+	unsigned int  m_uiBandwidth;
+	unsigned long m_ulLastProcessTime;
+
+	bool          ProcessStage(EntityId playerId, JoinStream * pStream);
+	unsigned char GetProgress(JoinStream * pStream);
+	void          SendProgress(EntityId playerId, unsigned char ucProgress);
+
+public:
+	CJoinStreamer();
+	~CJoinStreamer();
+
+	void          Add(EntityId playerId);
+	void          RemovePlayer(EntityId playerId);
+	bool          IsStreaming(EntityId playerId);
+	void          SetBandwidth(unsigned int uiBandwidth) { m_uiBandwidth = uiBandwidth; }
+	unsigned int  GetBandwidth() { return m_uiBandwidth; }
+	void          Process();
+};
@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CLagCompensation.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CLagCompensation.h"
+#include <SharedUtility.h>
+
+CLagCompensation::CLagCompensation()
+{
+	memset(m_uiNext, 0, sizeof(m_uiNext));
+	memset(m_uiCount, 0, sizeof(m_uiCount));
+}
+
+CLagCompensation::~CLagCompensation()
+{
+
+}
+
+void CLagCompensation::Record(EntityId playerId, const CVector3& vecPosition)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	LagCompensationRecord& record = m_records[playerId][m_uiNext[playerId]];
+	record.ulTime = SharedUtility::GetTime();
+	record.vecPosition = vecPosition;
+	m_uiNext[playerId] = ((m_uiNext[playerId] + 1) % LAG_COMPENSATION_HISTORY);
+
+	if(m_uiCount[playerId] < LAG_COMPENSATION_HISTORY)
+		m_uiCount[playerId]++;
+}
+
+bool CLagCompensation::GetPosition(EntityId playerId, unsigned long ulTime, CVector3& vecPosition)
+{
+	if(playerId >= MAX_PLAYERS || m_uiCount[playerId] == 0)
+		return false;
+
+	// Walk back from the newest record to the first one that isn't after the time
+	unsigned int uiNewest = ((m_uiNext[playerId] + LAG_COMPENSATION_HISTORY - 1) % LAG_COMPENSATION_HISTORY);
+	const LagCompensationRecord * pAfter = NULL;
+
+	for(unsigned int i = 0; i < m_uiCount[playerId]; i++)
+	{
+		const LagCompensationRecord& record = m_records[playerId][(uiNewest + LAG_COMPENSATION_HISTORY - i) % LAG_COMPENSATION_HISTORY];
+
+		if((long)(ulTime - record.ulTime) >= 0)
+		{
+			if(!pAfter)
+			{
+				// Newer than anything we have, use the latest position
+				vecPosition = record.vecPosition;
+				return true;
+			}
+
+			float fAlpha = ((float)(ulTime - record.ulTime) / (float)(pAfter->ulTime - record.ulTime));
+			vecPosition = (record.vecPosition + ((pAfter->vecPosition - record.vecPosition) * fAlpha));
+			return true;
+		}
+
+		pAfter = &record;
+	}
+
+	// Older than anything we have, use the oldest position
+	vecPosition = pAfter->vecPosition;
+	return true;
+}
+
+void CLagCompensation::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_uiNext[playerId] = 0;
+	m_uiCount[playerId] = 0;
+}
@@ -0,0 +1,53 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CLagCompensation.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <Common.h>
+
+// Positions kept of each player, enough for a second at the highest sync rate
+#define LAG_COMPENSATION_HISTORY 64
+
+// Amount of ms a shot can be rewound at most
+#define LAG_COMPENSATION_MAX_REWIND 1000
+
+// Distance the shot target can be from the rewound position of the hit player
+#define LAG_COMPENSATION_HIT_RADIUS 2.5f
+
+// Distance the shot source can be from the rewound position of the shooter
+#define LAG_COMPENSATION_SOURCE_RADIUS 5.0f
+
+struct LagCompensationRecord
+{
+	unsigned long ulTime;
+	CVector3      vecPosition;
+};
+
+// A ring buffer of the synced positions of each player so a shot can be checked
+// against where the players were at the time the shooter saw them
+class CLagCompensation
+{
+private:
+	LagCompensationRecord m_records[MAX_PLAYERS][LAG_COMPENSATION_HISTORY];
+	unsigned int          m_uiNext[MAX_PLAYERS];
+	unsigned int          m_uiCount[MAX_PLAYERS];
+
+public:
+	CLagCompensation();
+	~CLagCompensation();
+
+	// Adds the position the player synced now
+	void                  Record(EntityId playerId, const CVector3& vecPosition);
+
+	// Gets the position of the player at a time, interpolated between the records
+	// around it. Returns false if nothing is recorded for the player.
+	bool                  GetPosition(EntityId playerId, unsigned long ulTime, CVector3& vecPosition);
+	void                  RemovePlayer(EntityId playerId);
+};
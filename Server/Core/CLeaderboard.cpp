@@ -0,0 +1,338 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CLeaderboard.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CLeaderboard.h"
+#include "CEntityDataManager.h"
+#include "CPlayerManager.h"
+#include <stdlib.h>
+
+extern CEntityDataManager * g_pEntityDataManager;
+extern CPlayerManager * g_pPlayerManager;
+
+CLeaderboard::CLeaderboard(bool bDescending)
+	: m_iLevel(1),
+	m_uiSize(0),
+	m_bDescending(bDescending),
+	m_uiNextSequence(0),
+	m_uiReplicationCount(0)
+{
+	Node::Level level;
+	level.pNext = NULL;
+	level.uiSpan = 0;
+	m_head.levels.resize(LEADERBOARD_MAX_LEVEL, level);
+}
+
+CLeaderboard::~CLeaderboard()
+{
+	RemoveReplicated();
+
+	Node * pNode = m_head.levels[0].pNext;
+
+	while(pNode)
+	{
+		Node * pNext = pNode->levels[0].pNext;
+		delete pNode;
+		pNode = pNext;
+	}
+}
+
+bool CLeaderboard::IsBefore(const LeaderboardEntry& a, const LeaderboardEntry& b)
+{
+	if(a.dScore != b.dScore)
+		return (m_bDescending ? (a.dScore > b.dScore) : (a.dScore < b.dScore));
+
+	return (a.uiSequence < b.uiSequence);
+}
+
+int CLeaderboard::GetRandomLevel()
+{
+	// Each level has a quarter of the nodes of the one below it
+	int iLevel = 1;
+
+	while((rand() & 3) == 0 && iLevel < LEADERBOARD_MAX_LEVEL)
+		iLevel++;
+
+	return iLevel;
+}
+
+unsigned int CLeaderboard::Insert(const LeaderboardEntry& entry)
+{
+	Node * pUpdate[LEADERBOARD_MAX_LEVEL];
+	unsigned int uiRank[LEADERBOARD_MAX_LEVEL];
+	Node * pNode = &m_head;
+
+	// Find the last node before the entry on each level and the rank of it
+	for(int i = (m_iLevel - 1); i >= 0; i--)
+	{
+		uiRank[i] = ((i == (m_iLevel - 1)) ? 0 : uiRank[i + 1]);
+
+		while(pNode->levels[i].pNext && IsBefore(pNode->levels[i].pNext->entry, entry))
+		{
+			uiRank[i] += pNode->levels[i].uiSpan;
+			pNode = pNode->levels[i].pNext;
+		}
+
+		pUpdate[i] = pNode;
+	}
+
+	int iLevel = GetRandomLevel();
+
+	if(iLevel > m_iLevel)
+	{
+		for(int i = m_iLevel; i < iLevel; i++)
+		{
+			uiRank[i] = 0;
+			pUpdate[i] = &m_head;
+			m_head.levels[i].uiSpan = m_uiSize;
+		}
+
+		m_iLevel = iLevel;
+	}
+
+	Node * pNewNode = new Node;
+	pNewNode->entry = entry;
+	pNewNode->levels.resize(iLevel);
+
+	for(int i = 0; i < iLevel; i++)
+	{
+		pNewNode->levels[i].pNext = pUpdate[i]->levels[i].pNext;
+		pUpdate[i]->levels[i].pNext = pNewNode;
+		pNewNode->levels[i].uiSpan = (pUpdate[i]->levels[i].uiSpan - (uiRank[0] - uiRank[i]));
+		pUpdate[i]->levels[i].uiSpan = ((uiRank[0] - uiRank[i]) + 1);
+	}
+
+	// The links above the node now skip it as well
+	for(int i = iLevel; i < m_iLevel; i++)
+		pUpdate[i]->levels[i].uiSpan++;
+
+	m_members[entry.iMember] = pNewNode;
+	m_uiSize++;
+	return (uiRank[0] + 1);
+}
+
+void CLeaderboard::Delete(Node * pNode)
+{
+	Node * pUpdate[LEADERBOARD_MAX_LEVEL];
+	Node * pCurrent = &m_head;
+
+	for(int i = (m_iLevel - 1); i >= 0; i--)
+	{
+		while(pCurrent->levels[i].pNext && pCurrent->levels[i].pNext != pNode && IsBefore(pCurrent->levels[i].pNext->entry, pNode->entry))
+			pCurrent = pCurrent->levels[i].pNext;
+
+		pUpdate[i] = pCurrent;
+	}
+
+	for(int i = 0; i < m_iLevel; i++)
+	{
+		if(pUpdate[i]->levels[i].pNext == pNode)
+		{
+			pUpdate[i]->levels[i].uiSpan += (pNode->levels[i].uiSpan - 1);
+			pUpdate[i]->levels[i].pNext = pNode->levels[i].pNext;
+		}
+		else
+			pUpdate[i]->levels[i].uiSpan--;
+	}
+
+	while(m_iLevel > 1 && !m_head.levels[m_iLevel - 1].pNext)
+	{
+		m_head.levels[m_iLevel - 1].uiSpan = 0;
+		m_iLevel--;
+	}
+
+	m_members.erase(pNode->entry.iMember);
+	m_uiSize--;
+	delete pNode;
+}
+
+unsigned int CLeaderboard::Set(SQInteger iMember, double dScore, bool bInteger)
+{
+	std::map<SQInteger, Node *>::iterator iter = m_members.find(iMember);
+
+	// A member that kept its score keeps its place
+	if(iter != m_members.end())
+	{
+		if((*iter).second->entry.dScore == dScore)
+		{
+			(*iter).second->entry.bInteger = bInteger;
+			return GetRank(iMember);
+		}
+
+		Delete((*iter).second);
+	}
+
+	LeaderboardEntry entry;
+	entry.iMember = iMember;
+	entry.dScore = dScore;
+	entry.bInteger = bInteger;
+	entry.uiSequence = m_uiNextSequence++;
+	unsigned int uiRank = Insert(entry);
+	Replicate();
+	return uiRank;
+}
+
+bool CLeaderboard::Remove(SQInteger iMember)
+{
+	std::map<SQInteger, Node *>::iterator iter = m_members.find(iMember);
+
+	if(iter == m_members.end())
+		return false;
+
+	Delete((*iter).second);
+	Replicate();
+	return true;
+}
+
+void CLeaderboard::Clear()
+{
+	Node * pNode = m_head.levels[0].pNext;
+
+	while(pNode)
+	{
+		Node * pNext = pNode->levels[0].pNext;
+		delete pNode;
+		pNode = pNext;
+	}
+
+	for(int i = 0; i < LEADERBOARD_MAX_LEVEL; i++)
+	{
+		m_head.levels[i].pNext = NULL;
+		m_head.levels[i].uiSpan = 0;
+	}
+
+	m_iLevel = 1;
+	m_uiSize = 0;
+	m_members.clear();
+	Replicate();
+}
+
+const LeaderboardEntry * CLeaderboard::Get(SQInteger iMember)
+{
+	std::map<SQInteger, Node *>::iterator iter = m_members.find(iMember);
+
+	if(iter == m_members.end())
+		return NULL;
+
+	return &(*iter).second->entry;
+}
+
+unsigned int CLeaderboard::GetRank(SQInteger iMember)
+{
+	std::map<SQInteger, Node *>::iterator iter = m_members.find(iMember);
+
+	if(iter == m_members.end())
+		return 0;
+
+	Node * pTarget = (*iter).second;
+	Node * pNode = &m_head;
+	unsigned int uiRank = 0;
+
+	for(int i = (m_iLevel - 1); i >= 0; i--)
+	{
+		while(pNode->levels[i].pNext && (pNode->levels[i].pNext == pTarget || IsBefore(pNode->levels[i].pNext->entry, pTarget->entry)))
+		{
+			uiRank += pNode->levels[i].uiSpan;
+			pNode = pNode->levels[i].pNext;
+		}
+
+		if(pNode == pTarget)
+			return uiRank;
+	}
+
+	return 0;
+}
+
+void CLeaderboard::GetRange(unsigned int uiFirstRank, unsigned int uiCount, std::vector<const LeaderboardEntry *>& entries)
+{
+	entries.clear();
+
+	if(uiFirstRank == 0 || uiFirstRank > m_uiSize || uiCount == 0)
+		return;
+
+	// Go down the levels to the node at the first rank
+	Node * pNode = &m_head;
+	unsigned int uiTraversed = 0;
+
+	for(int i = (m_iLevel - 1); i >= 0; i--)
+	{
+		while(pNode->levels[i].pNext && (uiTraversed + pNode->levels[i].uiSpan) <= uiFirstRank)
+		{
+			uiTraversed += pNode->levels[i].uiSpan;
+			pNode = pNode->levels[i].pNext;
+		}
+
+		if(uiTraversed == uiFirstRank)
+			break;
+	}
+
+	for(; pNode && entries.size() < uiCount; pNode = pNode->levels[0].pNext)
+		entries.push_back(&pNode->entry);
+}
+
+void CLeaderboard::SetReplication(const String& strKey, unsigned int uiCount)
+{
+	RemoveReplicated();
+	m_strReplicationKey = strKey;
+	m_uiReplicationCount = uiCount;
+	Replicate();
+}
+
+void CLeaderboard::Replicate()
+{
+	if(m_strReplicationKey.IsEmpty() || !g_pEntityDataManager)
+		return;
+
+	std::map<SQInteger, std::pair<unsigned int, double> > replicated;
+	unsigned int uiRank = 1;
+
+	// Only the keys of the members whose rank or score changed are set again
+	for(Node * pNode = m_head.levels[0].pNext; pNode && uiRank <= m_uiReplicationCount; pNode = pNode->levels[0].pNext, uiRank++)
+	{
+		const LeaderboardEntry& entry = pNode->entry;
+
+		if(entry.iMember < 0 || entry.iMember >= MAX_PLAYERS || !g_pPlayerManager->DoesExist((EntityId)entry.iMember))
+			continue;
+
+		std::pair<unsigned int, double> value(uiRank, entry.dScore);
+		replicated[entry.iMember] = value;
+		std::map<SQInteger, std::pair<unsigned int, double> >::iterator iter = m_replicated.find(entry.iMember);
+
+		if(iter != m_replicated.end() && (*iter).second == value)
+			continue;
+
+		CSquirrelArguments arguments;
+		arguments.push((int)uiRank);
+
+		if(entry.bInteger)
+			arguments.push((int)entry.dScore);
+		else
+			arguments.push((float)entry.dScore);
+
+		g_pEntityDataManager->Set(ENTITY_DATA_PLAYER, (EntityId)entry.iMember, m_strReplicationKey, CSquirrelArgument(arguments, true), ENTITY_DATA_SCOPE_ALL);
+	}
+
+	for(std::map<SQInteger, std::pair<unsigned int, double> >::iterator iter = m_replicated.begin(); iter != m_replicated.end(); ++iter)
+	{
+		if(replicated.find((*iter).first) == replicated.end())
+			g_pEntityDataManager->Remove(ENTITY_DATA_PLAYER, (EntityId)(*iter).first, m_strReplicationKey);
+	}
+
+	m_replicated.swap(replicated);
+}
+
+void CLeaderboard::RemoveReplicated()
+{
+	if(g_pEntityDataManager)
+	{
+		for(std::map<SQInteger, std::pair<unsigned int, double> >::iterator iter = m_replicated.begin(); iter != m_replicated.end(); ++iter)
+			g_pEntityDataManager->Remove(ENTITY_DATA_PLAYER, (EntityId)(*iter).first, m_strReplicationKey);
+	}
+
+	m_replicated.clear();
+}
@@ -0,0 +1,88 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CLeaderboard.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <vector>
+#include <CString.h>
+#include <Squirrel/squirrel.h>
+
+// Levels of the skip list, enough for 4^24 members
+#define LEADERBOARD_MAX_LEVEL 24
+
+struct LeaderboardEntry
+{
+	SQInteger    iMember;
+	double       dScore;
+	bool         bInteger;   // The score was set as an integer
+	unsigned int uiSequence; // Members with the same score rank in the order they got it
+};
+
+// Members ranked by their score with an indexable skip list, so setting a score,
+// the rank of a member and the member at a rank are all O(log n). The top of the
+// board can be replicated to the clients as entity data of the players.
+class CLeaderboard
+{
+private:
+	struct Node
+	{
+		struct Level
+		{
+			Node       * pNext;
+			unsigned int uiSpan; // Members the link skips, the next one included
+		};
+
+		LeaderboardEntry   entry;
+		std::vector<Level> levels;
+	};
+
+	Node                               m_head;
+	int                                m_iLevel;
+	unsigned int                       m_uiSize;
+	bool                               m_bDescending;
+	unsigned int                       m_uiNextSequence;
+	std::map<SQInteger, Node *>        m_members;
+
+	// Replication of the top members as a [rank, score] entity data key of the players
+	String                             m_strReplicationKey;
+	unsigned int                       m_uiReplicationCount;
+	std::map<SQInteger, std::pair<unsigned int, double> > m_replicated; // Rank and score as they were sent
+
+	bool               IsBefore(const LeaderboardEntry& a, const LeaderboardEntry& b);
+	int                GetRandomLevel();
+	unsigned int       Insert(const LeaderboardEntry& entry);
+	void               Delete(Node * pNode);
+	void               Replicate();
+	void               RemoveReplicated();
+
+public:
+	CLeaderboard(bool bDescending);
+	~CLeaderboard();
+
+	// Sets the score of a member, adding it if needed, and returns its rank (starting at 1)
+	unsigned int       Set(SQInteger iMember, double dScore, bool bInteger);
+	bool               Remove(SQInteger iMember);
+	void               Clear();
+
+	// Returns NULL if the member isn't on the board
+	const LeaderboardEntry * Get(SQInteger iMember);
+
+	// Returns the rank of a member, 0 if it isn't on the board
+	unsigned int       GetRank(SQInteger iMember);
+
+	// Gets the entries from a rank on, up to uiCount of them
+	void               GetRange(unsigned int uiFirstRank, unsigned int uiCount, std::vector<const LeaderboardEntry *>& entries);
+	unsigned int       GetSize() { return m_uiSize; }
+
+	// Keeps the ranks of the top members (player ids) in the player data key until it
+	// is set to an empty key, players that drop out of the top lose the key
+	void               SetReplication(const String& strKey, unsigned int uiCount);
+};
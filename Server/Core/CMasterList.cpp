@@ -93,5 +93,11 @@ void CMasterList::Pulse()
 					m_bSentListedMessage = false;
 			}
 		}
+		else if(!m_pHttpClient->IsBusy() && !m_bSentErrorMessage)
+		{
+			// The request failed after it was started (host not found, connect failed or timed out)
+			CLogFile::Printf("[Master List] Failed to send post request to server list (%s)!", m_pHttpClient->GetLastErrorString().Get());
+			m_bSentErrorMessage = true;
+		}
 	}
 }
@@ -0,0 +1,293 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMessageBus.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CMessageBus.h"
+#include "CEvents.h"
+#include <Network/CNetworkModule.h>
+#include <Network/PacketIdentifiers.h>
+#include <CSettings.h>
+#include <CLogFile.h>
+#include <SharedUtility.h>
+
+extern CEvents * g_pEvents;
+extern CMessageBus * g_pMessageBus;
+
+CMessageBus::CMessageBus()
+{
+	m_pNetServer = NULL;
+	m_pProcessingPeer = NULL;
+	m_ulMessagesSent = 0;
+	m_ulMessagesReceived = 0;
+}
+
+CMessageBus::~CMessageBus()
+{
+	for(std::list<MessageBusPeer>::iterator iter = m_peers.begin(); iter != m_peers.end(); iter++)
+	{
+		if((*iter).pNetClient)
+		{
+			(*iter).pNetClient->Shutdown(100);
+			CNetworkModule::DestroyNetClientInterface((*iter).pNetClient);
+		}
+	}
+
+	if(m_pNetServer)
+	{
+		m_pNetServer->Shutdown(100);
+		CNetworkModule::DestroyNetServerInterface(m_pNetServer);
+	}
+}
+
+String CMessageBus::GetEventName(const String& strChannel)
+{
+	// The handlers of a channel are the handlers of its event
+	return String("bus:%s", strChannel.Get());
+}
+
+bool CMessageBus::Startup()
+{
+	int iPort = CVAR_GET_INTEGER("busport");
+
+	if(iPort == 0)
+		return false;
+
+	m_strSecret = CVAR_GET_STRING("bussecret");
+
+	if(m_strSecret.IsEmpty())
+	{
+		CLogFile::Print("Warning: The message bus needs a bussecret, it is disabled.");
+		return false;
+	}
+
+	m_strName = CVAR_GET_STRING("busname");
+
+	if(m_strName.IsEmpty())
+		m_strName = CVAR_GET_STRING("hostname");
+
+	m_pNetServer = CNetworkModule::GetNetServerInterface();
+
+	if(!m_pNetServer || !m_pNetServer->Startup((unsigned short)iPort, MESSAGE_BUS_MAX_NODES, CVAR_GET_STRING("hostaddress")))
+	{
+		CLogFile::Printf("Warning: Failed to start the message bus on port %d.", iPort);
+
+		if(m_pNetServer)
+		{
+			CNetworkModule::DestroyNetServerInterface(m_pNetServer);
+			m_pNetServer = NULL;
+		}
+
+		return false;
+	}
+
+	m_pNetServer->SetPassword(m_strSecret);
+	m_pNetServer->SetPacketHandler(ServerPacketHandler);
+
+	// Every peer is a host:port of the bus port of another server
+	std::list<String> peers = CVAR_GET_LIST("buspeer");
+
+	for(std::list<String>::iterator iter = peers.begin(); iter != peers.end(); iter++)
+	{
+		size_t sSeparator = (*iter).Find(':');
+
+		if(sSeparator == String::nPos)
+		{
+			CLogFile::Printf("Warning: Bus peer %s has no port.", (*iter).Get());
+			continue;
+		}
+
+		MessageBusPeer peer;
+		peer.strHost = (*iter).SubStr(0, sSeparator);
+		peer.usPort = (unsigned short)(*iter).SubStr(sSeparator + 1).ToInteger();
+		peer.pNetClient = NULL;
+		peer.bConnected = false;
+		peer.bWarned = false;
+		peer.bLost = false;
+		peer.ulNextConnectTime = 0;
+		m_peers.push_back(peer);
+	}
+
+	CLogFile::Printf("Message bus %s started on port %d with %d peer(s).", m_strName.Get(), iPort, (int)m_peers.size());
+	return true;
+}
+
+void CMessageBus::ServerPacketHandler(CPacket * pPacket)
+{
+	// Other servers only publish over their link to us
+	switch(pPacket->packetId)
+	{
+	case PACKET_NEW_CONNECTION:
+		CLogFile::Printf("[Bus] %s connected.", pPacket->pPlayerSocket->GetAddress(true).Get());
+		break;
+	case PACKET_DISCONNECTED:
+	case PACKET_LOST_CONNECTION:
+		CLogFile::Printf("[Bus] %s disconnected.", pPacket->pPlayerSocket->GetAddress(true).Get());
+		break;
+	case PACKET_RPC:
+		{
+			if(pPacket->uiLength < sizeof(RPCIdentifier) || pPacket->ucData[0] != RPC_BusMessage)
+				break;
+
+			CBitStream bitStream((pPacket->ucData + sizeof(RPCIdentifier)), (pPacket->uiLength - sizeof(RPCIdentifier)), false);
+			g_pMessageBus->Deliver(&bitStream);
+		}
+		break;
+	}
+}
+
+void CMessageBus::ClientPacketHandler(CPacket * pPacket)
+{
+	// Packets are only handled from Process so they belong to the peer that is being processed
+	MessageBusPeer * pPeer = g_pMessageBus->m_pProcessingPeer;
+
+	if(!pPeer)
+		return;
+
+	switch(pPacket->packetId)
+	{
+	case PACKET_CONNECTION_SUCCEEDED:
+		CLogFile::Printf("[Bus] Connected to %s:%d.", pPeer->strHost.Get(), pPeer->usPort);
+		pPeer->bConnected = true;
+		pPeer->bWarned = false;
+		break;
+	case PACKET_CONNECTION_REJECTED:
+	case PACKET_CONNECTION_FAILED:
+	case PACKET_ALREADY_CONNECTED:
+	case PACKET_SERVER_FULL:
+	case PACKET_BANNED:
+	case PACKET_PASSWORD_INVALID:
+		g_pMessageBus->OnPeerLost(pPeer, ((pPacket->packetId == PACKET_PASSWORD_INVALID) ? "invalid bussecret" : "connection failed"));
+		break;
+	case PACKET_DISCONNECTED:
+	case PACKET_LOST_CONNECTION:
+		g_pMessageBus->OnPeerLost(pPeer, "connection lost");
+		break;
+	}
+}
+
+void CMessageBus::Connect(MessageBusPeer * pPeer)
+{
+	pPeer->pNetClient = CNetworkModule::GetNetClientInterface();
+	pPeer->bLost = false;
+
+	if(pPeer->pNetClient && pPeer->pNetClient->Startup())
+	{
+		pPeer->pNetClient->SetPacketHandler(ClientPacketHandler);
+		pPeer->pNetClient->SetHost(pPeer->strHost);
+		pPeer->pNetClient->SetPort(pPeer->usPort);
+		pPeer->pNetClient->SetPassword(m_strSecret);
+
+		if(pPeer->pNetClient->Connect() == CONNECTION_ATTEMPT_STARTED)
+			return;
+	}
+
+	OnPeerLost(pPeer, "can't connect");
+}
+
+void CMessageBus::OnPeerLost(MessageBusPeer * pPeer, const char * szReason)
+{
+	// A peer that is down is tried again and again, only tell about it once
+	if(pPeer->bConnected || !pPeer->bWarned)
+		CLogFile::Printf("[Bus] Link to %s:%d failed (%s), trying again every %d seconds.", pPeer->strHost.Get(), pPeer->usPort, szReason, (MESSAGE_BUS_RECONNECT_INTERVAL / 1000));
+
+	pPeer->bConnected = false;
+	pPeer->bWarned = true;
+
+	// The net client is destroyed in Process as we can be called from within its Process
+	pPeer->bLost = true;
+	pPeer->ulNextConnectTime = (SharedUtility::GetTime() + MESSAGE_BUS_RECONNECT_INTERVAL);
+}
+
+void CMessageBus::Deliver(CBitStream * pBitStream)
+{
+	String strOrigin;
+	String strChannel;
+	String strData;
+
+	if(!pBitStream->Read(strOrigin) || !pBitStream->Read(strChannel) || !pBitStream->Read(strData))
+		return;
+
+	m_ulMessagesReceived++;
+
+	// handler(data, channel, origin)
+	CSquirrelArguments arguments;
+	arguments.push(strData);
+	arguments.push(strChannel);
+	arguments.push(strOrigin);
+	g_pEvents->Call(GetEventName(strChannel), &arguments);
+}
+
+unsigned int CMessageBus::GetConnectedPeerCount()
+{
+	unsigned int uiCount = 0;
+
+	for(std::list<MessageBusPeer>::iterator iter = m_peers.begin(); iter != m_peers.end(); iter++)
+	{
+		if((*iter).bConnected)
+			uiCount++;
+	}
+
+	return uiCount;
+}
+
+unsigned int CMessageBus::Publish(const String& strChannel, const String& strData)
+{
+	if(!IsRunning())
+		return 0;
+
+	CBitStream bsSend;
+	bsSend.Write(m_strName);
+	bsSend.Write(strChannel);
+	bsSend.Write(strData);
+	unsigned int uiSent = 0;
+
+	for(std::list<MessageBusPeer>::iterator iter = m_peers.begin(); iter != m_peers.end(); iter++)
+	{
+		if(!(*iter).bConnected)
+			continue;
+
+		(*iter).pNetClient->RPC(RPC_BusMessage, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
+		uiSent++;
+	}
+
+	m_ulMessagesSent++;
+	return uiSent;
+}
+
+void CMessageBus::Process()
+{
+	if(!IsRunning())
+		return;
+
+	// Call the handlers of the messages of the other servers
+	m_pNetServer->Process();
+
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	for(std::list<MessageBusPeer>::iterator iter = m_peers.begin(); iter != m_peers.end(); iter++)
+	{
+		MessageBusPeer * pPeer = &(*iter);
+
+		if(pPeer->pNetClient)
+		{
+			m_pProcessingPeer = pPeer;
+			pPeer->pNetClient->Process();
+			m_pProcessingPeer = NULL;
+		}
+
+		if(pPeer->bLost && pPeer->pNetClient)
+		{
+			pPeer->pNetClient->Shutdown(0);
+			CNetworkModule::DestroyNetClientInterface(pPeer->pNetClient);
+			pPeer->pNetClient = NULL;
+		}
+
+		if(!pPeer->pNetClient && ulTime >= pPeer->ulNextConnectTime)
+			Connect(pPeer);
+	}
+}
@@ -0,0 +1,76 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMessageBus.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <list>
+#include <Common.h>
+#include <Network/CNetServerInterface.h>
+#include <Network/CNetClientInterface.h>
+
+// Maximum amount of servers that can connect to our bus port
+#define MESSAGE_BUS_MAX_NODES 64
+
+// Time in ms after which a lost or failed link to a peer is connected again
+#define MESSAGE_BUS_RECONNECT_INTERVAL 5000
+
+// Maximum size in bytes of the channel name and of the data of a message
+#define MESSAGE_BUS_MAX_CHANNEL_LENGTH 128
+#define MESSAGE_BUS_MAX_DATA_LENGTH (1024 * 1024)
+
+// Our link to another server of the bus
+struct MessageBusPeer
+{
+	String                strHost;
+	unsigned short        usPort;
+	CNetClientInterface * pNetClient;
+	bool                  bConnected;
+	bool                  bWarned; // Told about the failed link already
+	bool                  bLost;   // The net client goes at the next Process
+	unsigned long         ulNextConnectTime;
+};
+
+// Lets the servers of a community send each other messages. Every server
+// connects to the bus ports of all the others (buspeers) and publishes over
+// these links, the messages of the others arrive over the connections to our
+// own bus port. Scripts subscribe to a channel with an event handler, which
+// is called from Process on the main thread. A server never gets its own
+// messages.
+class CMessageBus
+{
+private:
+	CNetServerInterface *      m_pNetServer;
+	std::list<MessageBusPeer>  m_peers;
+	MessageBusPeer *           m_pProcessingPeer;
+	String                     m_strName;
+	String                     m_strSecret;
+	unsigned long              m_ulMessagesSent;
+	unsigned long              m_ulMessagesReceived;
+
+	static void                ServerPacketHandler(CPacket * pPacket);
+	static void                ClientPacketHandler(CPacket * pPacket);
+	void                       Connect(MessageBusPeer * pPeer);
+	void                       OnPeerLost(MessageBusPeer * pPeer, const char * szReason);
+	void                       Deliver(CBitStream * pBitStream);
+
+public:
+	CMessageBus();
+	~CMessageBus();
+
+	static String              GetEventName(const String& strChannel);
+
+	bool                       Startup();
+	bool                       IsRunning() { return (m_pNetServer != NULL); }
+	unsigned int               GetConnectedPeerCount();
+	unsigned long              GetMessagesSent() { return m_ulMessagesSent; }
+	unsigned long              GetMessagesReceived() { return m_ulMessagesReceived; }
+	unsigned int               Publish(const String& strChannel, const String& strData);
+	void                       Process();
+};
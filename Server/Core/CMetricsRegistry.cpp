@@ -0,0 +1,235 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMetricsRegistry.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CMetricsRegistry.h"
+
+CMetricsRegistry::CMetricsRegistry()
+{
+
+}
+
+CMetricsRegistry::~CMetricsRegistry()
+{
+
+}
+
+unsigned int CMetricsRegistry::GetValuesPerSeries(const MetricFamily& family)
+{
+	// Histograms keep a count per bucket (and +Inf), the sum and the count
+	if(family.type == METRIC_TYPE_HISTOGRAM)
+		return (family.bounds.size() + 3);
+
+	return 1;
+}
+
+MetricId CMetricsRegistry::Add(String strName, String strHelp, eMetricType type, String strLabel, unsigned int uiSeries, const char ** ppLabelValues)
+{
+	MetricFamily family;
+	family.strName = strName;
+	family.strHelp = strHelp;
+	family.type = type;
+	family.strLabel = strLabel;
+	family.ppLabelValues = ppLabelValues;
+	family.uiSeries = (strLabel.IsEmpty() ? 1 : uiSeries);
+	m_families.push_back(family);
+
+	// Metrics without a label are always written
+	m_families.back().used.resize(family.uiSeries, strLabel.IsEmpty());
+	return (MetricId)(m_families.size() - 1);
+}
+
+MetricId CMetricsRegistry::AddCounter(String strName, String strHelp, String strLabel, unsigned int uiSeries, const char ** ppLabelValues)
+{
+	MetricId metricId = Add(strName, strHelp, METRIC_TYPE_COUNTER, strLabel, uiSeries, ppLabelValues);
+	m_families[metricId].values.resize(m_families[metricId].uiSeries, 0.0);
+	return metricId;
+}
+
+MetricId CMetricsRegistry::AddGauge(String strName, String strHelp, String strLabel, unsigned int uiSeries, const char ** ppLabelValues)
+{
+	MetricId metricId = Add(strName, strHelp, METRIC_TYPE_GAUGE, strLabel, uiSeries, ppLabelValues);
+	m_families[metricId].values.resize(m_families[metricId].uiSeries, 0.0);
+	return metricId;
+}
+
+MetricId CMetricsRegistry::AddHistogram(String strName, String strHelp, const double * pBounds, unsigned int uiBounds, String strLabel, unsigned int uiSeries, const char ** ppLabelValues)
+{
+	MetricId metricId = Add(strName, strHelp, METRIC_TYPE_HISTOGRAM, strLabel, uiSeries, ppLabelValues);
+	MetricFamily * pFamily = &m_families[metricId];
+	pFamily->bounds.assign(pBounds, (pBounds + uiBounds));
+	pFamily->values.resize((pFamily->uiSeries * GetValuesPerSeries(*pFamily)), 0.0);
+	return metricId;
+}
+
+MetricFamily * CMetricsRegistry::Get(MetricId metricId, eMetricType type, unsigned int uiSeries)
+{
+	if(metricId >= m_families.size())
+		return NULL;
+
+	MetricFamily * pFamily = &m_families[metricId];
+
+	if(pFamily->type != type || uiSeries >= pFamily->uiSeries)
+		return NULL;
+
+	return pFamily;
+}
+
+void CMetricsRegistry::Increment(MetricId metricId, double dValue, unsigned int uiSeries)
+{
+	MetricFamily * pFamily = Get(metricId, METRIC_TYPE_COUNTER, uiSeries);
+
+	if(!pFamily)
+		return;
+
+	pFamily->values[uiSeries] += dValue;
+	pFamily->used[uiSeries] = true;
+}
+
+void CMetricsRegistry::Set(MetricId metricId, double dValue, unsigned int uiSeries)
+{
+	MetricFamily * pFamily = Get(metricId, METRIC_TYPE_GAUGE, uiSeries);
+
+	if(!pFamily)
+	{
+		// Counters can be set from totals that are kept elsewhere
+		pFamily = Get(metricId, METRIC_TYPE_COUNTER, uiSeries);
+
+		if(!pFamily)
+			return;
+	}
+
+	pFamily->values[uiSeries] = dValue;
+	pFamily->used[uiSeries] = true;
+}
+
+void CMetricsRegistry::Observe(MetricId metricId, double dValue, unsigned int uiSeries)
+{
+	MetricFamily * pFamily = Get(metricId, METRIC_TYPE_HISTOGRAM, uiSeries);
+
+	if(!pFamily)
+		return;
+
+	// Only the bucket the value falls in is counted, GetText makes them cumulative
+	unsigned int uiBuckets = (pFamily->bounds.size() + 1);
+	double * pValues = &pFamily->values[uiSeries * GetValuesPerSeries(*pFamily)];
+	unsigned int uiBucket = 0;
+
+	while(uiBucket < pFamily->bounds.size() && dValue > pFamily->bounds[uiBucket])
+		uiBucket++;
+
+	pValues[uiBucket]++;
+	pValues[uiBuckets] += dValue;
+	pValues[uiBuckets + 1]++;
+	pFamily->used[uiSeries] = true;
+}
+
+void CMetricsRegistry::Remove(MetricId metricId, unsigned int uiSeries)
+{
+	if(metricId >= m_families.size() || uiSeries >= m_families[metricId].uiSeries)
+		return;
+
+	MetricFamily * pFamily = &m_families[metricId];
+	unsigned int uiValues = GetValuesPerSeries(*pFamily);
+
+	for(unsigned int i = 0; i < uiValues; i++)
+		pFamily->values[(uiSeries * uiValues) + i] = 0.0;
+
+	pFamily->used[uiSeries] = false;
+}
+
+void CMetricsRegistry::Publish()
+{
+	m_mutex.Lock();
+	m_publishedFamilies = m_families;
+	m_mutex.Unlock();
+}
+
+void CMetricsRegistry::AppendValue(String& strText, double dValue)
+{
+	// Counts are written without a fraction
+	if(dValue == (double)(long long)dValue)
+		strText.AppendF("%lld", (long long)dValue);
+	else
+		strText.AppendF("%.6g", dValue);
+}
+
+void CMetricsRegistry::AppendSeries(String& strText, const MetricFamily& family, unsigned int uiSeries, const char * szSuffix, const char * szExtraLabels, double dValue)
+{
+	strText.Append(family.strName);
+	strText.Append(szSuffix);
+
+	if(family.strLabel.IsNotEmpty() || szExtraLabels)
+	{
+		strText.Append("{");
+
+		if(family.strLabel.IsNotEmpty())
+		{
+			if(family.ppLabelValues)
+				strText.AppendF("%s=\"%s\"", family.strLabel.Get(), family.ppLabelValues[uiSeries]);
+			else
+				strText.AppendF("%s=\"%d\"", family.strLabel.Get(), uiSeries);
+
+			if(szExtraLabels)
+				strText.Append(",");
+		}
+
+		if(szExtraLabels)
+			strText.Append(szExtraLabels);
+
+		strText.Append("}");
+	}
+
+	strText.Append(" ");
+	AppendValue(strText, dValue);
+	strText.Append("\n");
+}
+
+String CMetricsRegistry::GetText()
+{
+	String strText;
+	m_mutex.Lock();
+
+	for(std::vector<MetricFamily>::iterator iter = m_publishedFamilies.begin(); iter != m_publishedFamilies.end(); ++ iter)
+	{
+		const MetricFamily& family = (*iter);
+		const char * szType = (family.type == METRIC_TYPE_COUNTER ? "counter" : (family.type == METRIC_TYPE_GAUGE ? "gauge" : "histogram"));
+		strText.AppendF("# HELP %s %s\n# TYPE %s %s\n", family.strName.Get(), family.strHelp.Get(), family.strName.Get(), szType);
+		unsigned int uiValues = GetValuesPerSeries(family);
+
+		for(unsigned int i = 0; i < family.uiSeries; i++)
+		{
+			if(!family.used[i])
+				continue;
+
+			const double * pValues = &family.values[i * uiValues];
+
+			if(family.type != METRIC_TYPE_HISTOGRAM)
+			{
+				AppendSeries(strText, family, i, "", NULL, pValues[0]);
+				continue;
+			}
+
+			double dCount = 0.0;
+
+			for(unsigned int j = 0; j < family.bounds.size(); j++)
+			{
+				dCount += pValues[j];
+				AppendSeries(strText, family, i, "_bucket", String("le=\"%g\"", family.bounds[j]).Get(), dCount);
+			}
+
+			unsigned int uiBuckets = (family.bounds.size() + 1);
+			AppendSeries(strText, family, i, "_bucket", "le=\"+Inf\"", pValues[uiBuckets + 1]);
+			AppendSeries(strText, family, i, "_sum", NULL, pValues[uiBuckets]);
+			AppendSeries(strText, family, i, "_count", NULL, pValues[uiBuckets + 1]);
+		}
+	}
+
+	m_mutex.Unlock();
+	return strText;
+}
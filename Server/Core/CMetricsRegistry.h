@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMetricsRegistry.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include "Main.h"
+#include <CString.h>
+#include <Threading/CMutex.h>
+
+typedef unsigned int MetricId;
+
+#define INVALID_METRIC_ID 0xFFFFFFFF
+
+enum eMetricType
+{
+	METRIC_TYPE_COUNTER,
+	METRIC_TYPE_GAUGE,
+	METRIC_TYPE_HISTOGRAM
+};
+
+// A metric with its series. Series are selected by index, the label value of
+// a series is its name in ppLabelValues or else the index itself
+struct MetricFamily
+{
+	String              strName;
+	String              strHelp;
+	eMetricType         type;
+	String              strLabel;       // Empty if the metric only has a single series
+	const char       ** ppLabelValues;
+	unsigned int        uiSeries;
+	std::vector<double> bounds;         // Upper bounds of the histogram buckets (without +Inf)
+	std::vector<double> values;         // Per series the value, or for histograms the bucket counts, sum and count
+	std::vector<bool>   used;           // Per series if it is written at all
+};
+
+// Collects counters, gauges and histograms. The values are set on the main
+// thread and published from time to time, GetText only reads the published
+// values so it can be called from any thread.
+class CMetricsRegistry
+{
+private:
+	std::vector<MetricFamily> m_families;
+	std::vector<MetricFamily> m_publishedFamilies;
+	CMutex                    m_mutex;
+
+	MetricId                  Add(String strName, String strHelp, eMetricType type, String strLabel, unsigned int uiSeries, const char ** ppLabelValues);
+	MetricFamily            * Get(MetricId metricId, eMetricType type, unsigned int uiSeries);
+	static unsigned int       GetValuesPerSeries(const MetricFamily& family);
+	static void               AppendValue(String& strText, double dValue);
+	static void               AppendSeries(String& strText, const MetricFamily& family, unsigned int uiSeries, const char * szSuffix, const char * szExtraLabels, double dValue);
+
+public:
+	CMetricsRegistry();
+	~CMetricsRegistry();
+
+	// Metrics without a label have a single series
+	MetricId                  AddCounter(String strName, String strHelp, String strLabel = "", unsigned int uiSeries = 1, const char ** ppLabelValues = NULL);
+	MetricId                  AddGauge(String strName, String strHelp, String strLabel = "", unsigned int uiSeries = 1, const char ** ppLabelValues = NULL);
+	MetricId                  AddHistogram(String strName, String strHelp, const double * pBounds, unsigned int uiBounds, String strLabel = "", unsigned int uiSeries = 1, const char ** ppLabelValues = NULL);
+
+	void                      Increment(MetricId metricId, double dValue = 1.0, unsigned int uiSeries = 0);
+	void                      Set(MetricId metricId, double dValue, unsigned int uiSeries = 0);
+	void                      Observe(MetricId metricId, double dValue, unsigned int uiSeries = 0);
+
+	// Stops writing a series (e.g. of a player that left) until it is used again
+	void                      Remove(MetricId metricId, unsigned int uiSeries);
+
+	// Makes the current values visible to GetText
+	void                      Publish();
+
+	// Returns the published values in the text exposition format
+	String                    GetText();
+};
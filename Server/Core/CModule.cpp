@@ -53,9 +53,18 @@ extern Modules::CScriptModuleNatives * g_pScriptModuleNatives;
 extern Modules::CAreaModuleNatives * g_pAreaModuleNatives;
 extern Modules::CHashModuleNatives * g_pHashModuleNatives;
 extern Modules::CWorldModuleNatives * g_pWorldModuleNatives;
+extern Modules::CBulkModuleNatives * g_pBulkModuleNatives;
+extern CJobSystem * g_pJobSystem;
 
 CModule::CModule(const char * szName)
+	: m_strName(szName)
 {
+	m_uiPulseInterval = 0;
+	m_ulNextPulseTime = 0;
+	m_uiSnapshotPlayerCount = 0;
+	m_uiSnapshotVehicleCount = 0;
+	memset(&m_pulseStats, 0, sizeof(ModulePulseStats));
+	memset(&m_asyncPulseStats, 0, sizeof(ModulePulseStats));
 	String strModuleName(szName);
 	SharedUtility::RemoveIllegalCharacters(strModuleName);
 	String strModulePath(SharedUtility::GetAbsolutePath("modules/%s", strModuleName.Get()));
@@ -82,6 +91,8 @@ CModule::CModule(const char * szName)
 	m_ModuleFunctions.pfnScriptLoad = (ScriptLoad_t)m_pLibrary->GetProcedureAddress("ScriptLoad");
 	m_ModuleFunctions.pfnScriptUnload = (ScriptUnload_t)m_pLibrary->GetProcedureAddress("ScriptUnload");
 	m_ModuleFunctions.pfnPulse = (Pulse_t)m_pLibrary->GetProcedureAddress("Pulse");
+	m_ModuleFunctions.pfnGetPulseInterval = (GetPulseInterval_t)m_pLibrary->GetProcedureAddress("GetPulseInterval");
+	m_ModuleFunctions.pfnPulseAsync = (PulseAsync_t)m_pLibrary->GetProcedureAddress("PulseAsync");
 
 	if(!IsValid())
 	{
@@ -125,6 +136,7 @@ CModule::CModule(const char * szName)
 	NewInterfaceContainer[9] = (void*)g_pAreaModuleNatives;
 	NewInterfaceContainer[10] = (void*)g_pHashModuleNatives;
 	NewInterfaceContainer[11] = (void*)g_pWorldModuleNatives;
+	NewInterfaceContainer[12] = (void*)g_pBulkModuleNatives;
 
 	// Send it
 	if(m_ModuleFunctions.pfnSetupInterfaces)
@@ -138,10 +150,17 @@ CModule::CModule(const char * szName)
 
 	if(m_ModuleFunctions.pfnInitModule(szModuleName))
 		CLogFile::Printf("%s module loaded", szModuleName);
+
+	if(m_ModuleFunctions.pfnGetPulseInterval)
+		m_uiPulseInterval = m_ModuleFunctions.pfnGetPulseInterval();
 }
 
 CModule::~CModule()
 {
+	// Don't unload the module under its async pulse
+	if(!m_asyncPulseCounter.IsDone())
+		g_pJobSystem->Wait(&m_asyncPulseCounter);
+
 	if(m_pLibrary)
 	{
 		m_pLibrary->Unload();
@@ -178,8 +197,64 @@ void CModule::ScriptUnload(HSQUIRRELVM pVM)
 
 void CModule::Pulse()
 {
-	if(!m_pLibrary || !m_ModuleFunctions.pfnPulse)
+	if(!m_pLibrary)
 		return;
 
-	return m_ModuleFunctions.pfnPulse();
+	if(m_uiPulseInterval > 0)
+	{
+		unsigned long ulTime = SharedUtility::GetTime();
+
+		if(ulTime < m_ulNextPulseTime)
+			return;
+
+		m_ulNextPulseTime = (ulTime + m_uiPulseInterval);
+	}
+
+	if(m_ModuleFunctions.pfnPulse)
+	{
+		unsigned long long ullStartTime = SharedUtility::GetMicroseconds();
+		m_ModuleFunctions.pfnPulse();
+		AddPulseTime(m_pulseStats, (unsigned int)(SharedUtility::GetMicroseconds() - ullStartTime));
+	}
+
+	// The snapshot is only taken again once the last async pulse is done with it,
+	// a module slower than its pulse interval skips pulses instead of queuing them
+	if(m_ModuleFunctions.pfnPulseAsync && m_asyncPulseCounter.IsDone())
+	{
+		m_snapshotPlayers.resize(g_pPlayerManager->GetActivePlayers().size());
+		m_uiSnapshotPlayerCount = (m_snapshotPlayers.empty() ? 0 : g_pBulkModuleNatives->GetPlayers(&m_snapshotPlayers[0], (unsigned int)m_snapshotPlayers.size()));
+		m_snapshotVehicles.resize(g_pVehicleManager->GetActiveVehicles().size());
+		m_uiSnapshotVehicleCount = (m_snapshotVehicles.empty() ? 0 : g_pBulkModuleNatives->GetVehicles(&m_snapshotVehicles[0], (unsigned int)m_snapshotVehicles.size()));
+		g_pJobSystem->Add(AsyncPulseJob, this, &m_asyncPulseCounter);
+	}
+}
+
+void CModule::AsyncPulseJob(void * pUserData)
+{
+	CModule * pModule = (CModule *)pUserData;
+	unsigned long long ullStartTime = SharedUtility::GetMicroseconds();
+	pModule->m_ModuleFunctions.pfnPulseAsync((pModule->m_uiSnapshotPlayerCount > 0 ? &pModule->m_snapshotPlayers[0] : NULL), pModule->m_uiSnapshotPlayerCount,
+		(pModule->m_uiSnapshotVehicleCount > 0 ? &pModule->m_snapshotVehicles[0] : NULL), pModule->m_uiSnapshotVehicleCount);
+	pModule->AddPulseTime(pModule->m_asyncPulseStats, (unsigned int)(SharedUtility::GetMicroseconds() - ullStartTime));
+}
+
+void CModule::AddPulseTime(ModulePulseStats& pulseStats, unsigned int uiTime)
+{
+	m_statsMutex.Lock();
+	pulseStats.ulPulses++;
+	pulseStats.ullTotalTime += uiTime;
+	pulseStats.uiLastTime = uiTime;
+
+	if(uiTime > pulseStats.uiMaxTime)
+		pulseStats.uiMaxTime = uiTime;
+
+	m_statsMutex.Unlock();
+}
+
+void CModule::GetPulseStats(ModulePulseStats& pulseStats, ModulePulseStats& asyncPulseStats)
+{
+	m_statsMutex.Lock();
+	pulseStats = m_pulseStats;
+	asyncPulseStats = m_asyncPulseStats;
+	m_statsMutex.Unlock();
 }
@@ -12,7 +12,10 @@
 #include "Squirrel/squirrel.h"
 #include "CLibrary.h"
 #include "Interfaces/InterfaceCommon.h"
+#include "ModuleNatives/Interface/IModuleNatives.h"
 #include <CLogFile.h>
+#include <Threading/CJobSystem.h>
+#include <vector>
 
 static void * FunctionContainer[] =
 {
@@ -147,6 +150,10 @@ typedef bool (* InitModule_t)(char *);
 typedef void (* ScriptLoad_t)(HSQUIRRELVM);
 typedef void (* ScriptUnload_t)(HSQUIRRELVM);
 typedef void (* Pulse_t)();
+typedef unsigned int (* GetPulseInterval_t)();
+// Called on a job system thread with a copy of the world taken on the main thread,
+// it must not call any other server functions
+typedef void (* PulseAsync_t)(const Modules::ModulePlayerData * pPlayers, unsigned int uiPlayerCount, const Modules::ModuleVehicleData * pVehicles, unsigned int uiVehicleCount);
 
 struct ModuleFunctions
 {
@@ -157,6 +164,17 @@ struct ModuleFunctions
 	ScriptLoad_t pfnScriptLoad;
 	ScriptUnload_t pfnScriptUnload;
 	Pulse_t pfnPulse;
+	GetPulseInterval_t pfnGetPulseInterval; // Time in ms between pulses, every tick if not exported
+	PulseAsync_t pfnPulseAsync;
+};
+
+// Pulse times of a module in microseconds
+struct ModulePulseStats
+{
+	unsigned long      ulPulses;
+	unsigned long long ullTotalTime;
+	unsigned int       uiLastTime;
+	unsigned int       uiMaxTime;
 };
 
 class CModule : public CModuleInterface
@@ -169,8 +187,25 @@ public:
 	void ScriptLoad(HSQUIRRELVM pVM);
 	void ScriptUnload(HSQUIRRELVM pVM);
 	void Pulse();
+	String GetName() { return m_strName; }
+	bool HasAsyncPulse() { return (m_ModuleFunctions.pfnPulseAsync != NULL); }
+	void GetPulseStats(ModulePulseStats& pulseStats, ModulePulseStats& asyncPulseStats);
 
 private:
 	CLibrary * m_pLibrary;
 	ModuleFunctions m_ModuleFunctions;
+	String m_strName;
+	unsigned int m_uiPulseInterval;
+	unsigned long m_ulNextPulseTime;
+	CJobCounter m_asyncPulseCounter; // Counts the async pulse while it runs
+	std::vector<Modules::ModulePlayerData> m_snapshotPlayers;
+	std::vector<Modules::ModuleVehicleData> m_snapshotVehicles;
+	unsigned int m_uiSnapshotPlayerCount;
+	unsigned int m_uiSnapshotVehicleCount;
+	CMutex m_statsMutex; // Mutex for the pulse stats
+	ModulePulseStats m_pulseStats;
+	ModulePulseStats m_asyncPulseStats;
+
+	void AddPulseTime(ModulePulseStats& pulseStats, unsigned int uiTime);
+	static void AsyncPulseJob(void * pUserData);
 };
\ No newline at end of file
@@ -36,7 +36,9 @@ CModule * CModuleManager::LoadModule(const char * szName)
 		return NULL;
 	}
 
+	m_modulesMutex.Lock();
 	m_lstModules.push_back(pModule);
+	m_modulesMutex.Unlock();
 
 	return pModule;
 }
@@ -66,4 +68,24 @@ void CModuleManager::Pulse()
 		if(*i)
 			(*i)->Pulse();
 	}
+}
+
+void CModuleManager::GetProfiles(std::vector<ModuleProfile>& profiles)
+{
+	profiles.clear();
+	m_modulesMutex.Lock();
+
+	for(std::list<CModule *>::iterator i = m_lstModules.begin(); i != m_lstModules.end(); ++i)
+	{
+		if(*i)
+		{
+			ModuleProfile profile;
+			profile.strName = (*i)->GetName();
+			profile.bAsyncPulse = (*i)->HasAsyncPulse();
+			(*i)->GetPulseStats(profile.pulseStats, profile.asyncPulseStats);
+			profiles.push_back(profile);
+		}
+	}
+
+	m_modulesMutex.Unlock();
 }
\ No newline at end of file
@@ -10,8 +10,18 @@
 #pragma once
 
 #include <list>
+#include <vector>
 #include "CModule.h"
 #include "Interfaces/InterfaceCommon.h"
+#include <Threading/CMutex.h>
+
+struct ModuleProfile
+{
+	String           strName;
+	bool             bAsyncPulse;
+	ModulePulseStats pulseStats;
+	ModulePulseStats asyncPulseStats;
+};
 
 class CModuleManager : public CModuleManagerInterface
 {
@@ -24,6 +34,10 @@ public:
 	void ScriptUnload(HSQUIRRELVM pVM);
 	void Pulse();
 
+	// Can be called from any thread
+	void GetProfiles(std::vector<ModuleProfile>& profiles);
+
 private:
 	std::list<CModule *> m_lstModules;
+	CMutex m_modulesMutex; // Mutex for m_lstModules while it is changed or walked off the main thread
 };
\ No newline at end of file
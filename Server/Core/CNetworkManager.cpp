@@ -6,9 +6,6 @@
 // License: See LICENSE in root directory
 //
 //==============================================================================
-// TODO: Refresh ban list function
-// TODO: Convert ban list to XML?
-
 #ifdef _LINUX
 #include <stdlib.h>
 #endif
@@ -16,11 +13,29 @@
 #include <ctime>
 #include "CPlayerManager.h"
 #include "CNetworkManager.h"
+#include "CPacketRecorder.h"
+#include "CServerMetrics.h"
+#include "CCommandBuffer.h"
+#include "CBanManager.h"
 #include <Network/CNetworkModule.h>
+#include <Network/PacketIdentifiers.h>
 #include <CLogFile.h>
+#include <CSettings.h>
+#include <CTraceRecorder.h>
 
 extern CPlayerManager  * g_pPlayerManager;
 extern CNetworkManager * g_pNetworkManager;
+extern CBroadcastGroupManager * g_pBroadcastGroupManager;
+extern CPacketRecorder * g_pPacketRecorder;
+extern CServerMetrics * g_pServerMetrics;
+extern CCommandBuffer * g_pCommandBuffer;
+extern CBanManager * g_pBanManager;
+
+// Returns the size of an rpc in bytes (including the packet and rpc ids)
+static unsigned int GetRPCSize(CBitStream * pBitStream)
+{
+	return (2 + (pBitStream ? pBitStream->GetNumberOfBytesUsed() : 0));
+}
 
 CNetworkManager::CNetworkManager()
 {
@@ -66,13 +81,37 @@ CNetworkManager::~CNetworkManager()
 
 bool CNetworkManager::Startup(int iPort, int iMaxPlayers, String strPassword, String strHostAddress)
 {
+	// Receive on a separate thread if enabled (must be set before starting up)
+	m_pNetServer->SetNetworkThreadEnabled(CVAR_GET_BOOL("networkthread"));
+
 	// Start up the net server
 	if(!m_pNetServer->Startup(iPort, iMaxPlayers, strHostAddress.Get()))
 		return false;
 
+	// Simulate bad network conditions if configured
+	NetSimulatorSettings netSimulator;
+	netSimulator.uiLatency = CVAR_GET_INTEGER("netsimlatency");
+	netSimulator.uiJitter = CVAR_GET_INTEGER("netsimjitter");
+	netSimulator.fLoss = CVAR_GET_FLOAT("netsimloss");
+	netSimulator.fReorder = CVAR_GET_FLOAT("netsimreorder");
+	netSimulator.fDuplicate = CVAR_GET_FLOAT("netsimduplicate");
+	netSimulator.uiBandwidth = CVAR_GET_INTEGER("netsimbandwidth");
+
+	if(netSimulator.IsActive())
+	{
+		m_pNetServer->SetNetSimulator(netSimulator);
+		CLogFile::Printf("Network simulator enabled (Latency: %ums, Jitter: %ums, Loss: %.1f%%, Reorder: %.1f%%, Duplicate: %.1f%%, Bandwidth: %u bytes/s).", netSimulator.uiLatency, netSimulator.uiJitter, netSimulator.fLoss, netSimulator.fReorder, netSimulator.fDuplicate, netSimulator.uiBandwidth);
+	}
+
+	// Compress the large reliable rpcs if enabled
+	m_pNetServer->SetCompressionThreshold(CVAR_GET_INTEGER("compressionthreshold"));
+
 	// Set the net server password
 	m_pNetServer->SetPassword(strPassword);
 
+	// Reject banned addresses before they get a player socket
+	m_pNetServer->SetConnectionFilter(ConnectionFilter);
+
 	// Register the packets
 	m_pServerPacketHandler->Register();
 
@@ -83,12 +122,27 @@ bool CNetworkManager::Startup(int iPort, int iMaxPlayers, String strPassword, St
 
 void CNetworkManager::PacketHandler(CPacket * pPacket)
 {
-	// Get the network manager pointer
-	CNetworkManager * pNetworkManager = g_pNetworkManager;
+	// Record the packet if we are recording
+	if(g_pPacketRecorder)
+		g_pPacketRecorder->Record(pPacket);
+
+	g_pNetworkManager->HandlePacket(pPacket);
+}
+
+bool CNetworkManager::ConnectionFilter(unsigned long ulBinaryAddress)
+{
+	return !g_pBanManager->IsAddressBanned(ulBinaryAddress);
+}
+
+void CNetworkManager::HandlePacket(CPacket * pPacket)
+{
+	// Count the rpc (the rpc id is the first byte, the packet id isn't part of the data)
+	if(g_pServerMetrics && pPacket->packetId == PACKET_RPC && pPacket->uiLength >= 1)
+		g_pServerMetrics->OnRPCReceived(pPacket->ucData[0], (pPacket->uiLength + 1));
 
 	// Pass it to the packet handler, if that doesn't handle it, pass it to the rpc handler
-	if(!pNetworkManager->m_pServerPacketHandler->HandlePacket(pPacket) && 
-		!pNetworkManager->m_pServerRPCHandler->HandlePacket(pPacket))
+	if(!m_pServerPacketHandler->HandlePacket(pPacket) && 
+		!m_pServerRPCHandler->HandlePacket(pPacket))
 	{
 #ifdef IVMP_DEBUG
 		CLogFile::Printf("Warning: Unhandled packet (Id: %d, Player: %d)\n", pPacket->packetId, pPacket->pPlayerSocket->playerId);
@@ -96,76 +150,160 @@ void CNetworkManager::PacketHandler(CPacket * pPacket)
 	}
 }
 
-void CNetworkManager::Process()
+void CNetworkManager::ProcessPackets()
 {
 	// Process the net server
+	CTraceScope traceScope(TRACE_CATEGORY_NETWORK, "netserver");
 	m_pNetServer->Process();
+}
+
+bool CNetworkManager::WaitForPackets(unsigned int uiTimeOutMilliseconds)
+{
+	return m_pNetServer->WaitForPackets(uiTimeOutMilliseconds);
+}
 
+void CNetworkManager::Process()
+{
 	// Process the player manager
 	g_pPlayerManager->Pulse();
 }
 
 void CNetworkManager::RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel)
 {
+	if(g_pCommandBuffer && reliability == RELIABILITY_RELIABLE_ORDERED && cOrderingChannel == PACKET_CHANNEL_DEFAULT)
+	{
+		// Scripting rpcs are sent with the other commands of the tick
+		if(CCommandBuffer::IsBufferedRPC(rpcId, reliability, cOrderingChannel) && g_pCommandBuffer->Queue(rpcId, pBitStream, playerId, bBroadcast))
+		{
+			if(g_pServerMetrics)
+				g_pServerMetrics->OnRPCSent(rpcId, GetRPCSize(pBitStream));
+
+			return;
+		}
+
+		// Anything else can't overtake the commands queued before it
+		g_pCommandBuffer->Flush(playerId, bBroadcast);
+	}
+
 	m_pNetServer->RPC(rpcId, pBitStream, priority, reliability, playerId, bBroadcast, cOrderingChannel);
+
+	if(g_pServerMetrics)
+		g_pServerMetrics->OnRPCSent(rpcId, GetRPCSize(pBitStream));
 }
 
-String CNetworkManager::GetPlayerIp(EntityId playerId)
+void CNetworkManager::GroupRPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, BroadcastGroupId groupId, EntityId exceptPlayerId, char cOrderingChannel)
 {
-	return m_pNetServer->GetPlayerIp(playerId);
+	// Send the rpc to all members of the broadcast group (except the given player)
+	const std::vector<EntityId> * pMembers = g_pBroadcastGroupManager->GetMembers(groupId);
+
+	if(!pMembers)
+		return;
+
+	if(g_pCommandBuffer && reliability == RELIABILITY_RELIABLE_ORDERED && cOrderingChannel == PACKET_CHANNEL_DEFAULT)
+		g_pCommandBuffer->Flush(INVALID_ENTITY_ID, true);
+
+	for(std::vector<EntityId>::const_iterator iter = pMembers->begin(); iter != pMembers->end(); iter++)
+	{
+		if((*iter) != exceptPlayerId)
+		{
+			m_pNetServer->RPC(rpcId, pBitStream, priority, reliability, *iter, false, cOrderingChannel);
+
+			if(g_pServerMetrics)
+				g_pServerMetrics->OnRPCSent(rpcId, GetRPCSize(pBitStream));
+		}
+	}
 }
 
-unsigned short CNetworkManager::GetPlayerPort(EntityId playerId)
+void CNetworkManager::RPCReserved(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel)
 {
-	return m_pNetServer->GetPlayerPort(playerId);
+	if(g_pCommandBuffer && reliability == RELIABILITY_RELIABLE_ORDERED && cOrderingChannel == PACKET_CHANNEL_DEFAULT)
+		g_pCommandBuffer->Flush(playerId, bBroadcast);
+
+	m_pNetServer->RPCReserved(rpcId, pBitStream, priority, reliability, playerId, bBroadcast, cOrderingChannel);
+
+	if(g_pServerMetrics)
+		g_pServerMetrics->OnRPCSent(rpcId, GetRPCSize(pBitStream));
 }
 
-String CNetworkManager::GetPlayerSerial(EntityId playerId)
+void CNetworkManager::RPCReservedBatch(RPCIdentifier rpcId, CBitStream ** ppBitStreams, const EntityId * pPlayerIds, unsigned int uiCount, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel)
 {
-	return m_pNetServer->GetPlayerSerial(playerId);
+	if(uiCount == 0)
+		return;
+
+	if(g_pCommandBuffer && reliability == RELIABILITY_RELIABLE_ORDERED && cOrderingChannel == PACKET_CHANNEL_DEFAULT)
+	{
+		for(unsigned int i = 0; i < uiCount; i++)
+			g_pCommandBuffer->Flush(pPlayerIds[i], false);
+	}
+
+	m_pNetServer->RPCReservedBatch(rpcId, ppBitStreams, pPlayerIds, uiCount, priority, reliability, cOrderingChannel);
+
+	if(g_pServerMetrics && g_pServerMetrics->IsEnabled())
+	{
+		unsigned int uiBytes = 0;
+
+		for(unsigned int i = 0; i < uiCount; i++)
+			uiBytes += GetRPCSize(ppBitStreams[i]);
+
+		g_pServerMetrics->OnRPCSent(rpcId, uiBytes, uiCount);
+	}
 }
 
-bool CNetworkManager::AddBan(String strIp, unsigned int uiSeconds)
+void CNetworkManager::CoalescedRPC(RPCIdentifier rpcId, CBitStream * pBitStream, EntityId subjectId, EntityId playerId, bool bBroadcast)
 {
-	FILE * fBanList = fopen("bans.banlist", "a");
+	if(g_pCommandBuffer && g_pCommandBuffer->Queue(rpcId, pBitStream, playerId, bBroadcast, subjectId))
+	{
+		if(g_pServerMetrics)
+			g_pServerMetrics->OnRPCSent(rpcId, GetRPCSize(pBitStream));
 
-	if(!fBanList)
-		return false;
+		return;
+	}
 
-	int uiTimestamp = (int)time(0);
-	fprintf(fBanList, "%s:%d:%d\n", strIp.Get(), uiTimestamp, uiSeconds);
-	fclose(fBanList);
-	m_pNetServer->BanIp(strIp, uiSeconds * 1000);
-	return true;
+	RPC(rpcId, pBitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, bBroadcast);
 }
 
-bool CNetworkManager::LoadBans()
+void CNetworkManager::EventRPC(const String& strName, CSquirrelArguments * pArguments, const EntityId * pPlayerIds, unsigned int uiCount, ePacketReliability reliability)
 {
-	FILE * fBanList = fopen("bans.banlist", "r");
+	if(uiCount == 0)
+		return;
 
-	if(!fBanList)
-		return false;
+	EventNameId nameId = m_eventNames.GetId(strName);
 
-	char szBuf[256];
-	unsigned int uiTimestamp = (unsigned int)time(0);
-	while(!feof(fBanList))
+	// The definitions go on the ordered script channel so they arrive before the reliable events using them
+	for(unsigned int i = 0; i < uiCount; i++)
 	{
-		fgets(szBuf, sizeof(szBuf), fBanList);
+		CBitStream bsDefinition;
 
-		if(szBuf && szBuf[0] != '\0')
-		{
-			szBuf[strlen(szBuf) - 1] = '\0';
-			char * szIP = strtok(szBuf, ":");
-			unsigned int uiBanStart = atoi(strtok(NULL, ":"));
-			unsigned int uiBanSeconds = (atoi(strtok(NULL, "")) + uiBanStart);
+		if(m_eventNames.WriteDefinition(pPlayerIds[i], nameId, &bsDefinition))
+			RPC(RPC_ScriptingEventName, &bsDefinition, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, pPlayerIds[i], false, PACKET_CHANNEL_SCRIPT);
+	}
 
-			if(uiBanSeconds > uiTimestamp)
-				m_pNetServer->BanIp(szIP, (uiBanSeconds - uiTimestamp));
+	// Write the rpc once, every player is sent the same bit stream
+	CBitStream bsSend;
+	bsSend.PadWithZeroToByteLength(RPC_HEADER_SIZE);
+	m_eventNames.WriteEvent(nameId, strName, &bsSend);
+	pArguments->serialize(&bsSend);
 
-			szBuf[0] = '\0';
-		}
-	}
+	std::vector<CBitStream *> bitStreams(uiCount, &bsSend);
+	RPCReservedBatch(RPC_ScriptingEventCall, &bitStreams[0], pPlayerIds, uiCount, PRIORITY_HIGH, reliability, PACKET_CHANNEL_SCRIPT);
+}
 
-	fclose(fBanList);
-	return true;
+String CNetworkManager::GetPlayerIp(EntityId playerId)
+{
+	return m_pNetServer->GetPlayerIp(playerId);
+}
+
+unsigned short CNetworkManager::GetPlayerPort(EntityId playerId)
+{
+	return m_pNetServer->GetPlayerPort(playerId);
+}
+
+String CNetworkManager::GetPlayerSerial(EntityId playerId)
+{
+	return m_pNetServer->GetPlayerSerial(playerId);
+}
+
+bool CNetworkManager::AddBan(String strIp, unsigned int uiSeconds)
+{
+	return g_pBanManager->Add(strIp, uiSeconds);
 }
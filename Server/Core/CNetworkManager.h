@@ -18,6 +18,8 @@
 #include <Network/CNetServerInterface.h>
 #include "CServerPacketHandler.h"
 #include "CServerRPCHandler.h"
+#include "CBroadcastGroupManager.h"
+#include <Network/CEventNameTable.h>
 
 class CNetworkManager : public CNetworkManagerInterface
 {
@@ -25,6 +27,7 @@ private:
 	CNetServerInterface  * m_pNetServer;
 	CServerPacketHandler * m_pServerPacketHandler;
 	CServerRPCHandler    * m_pServerRPCHandler;
+	CEventNameTable        m_eventNames;
 
 public:
 	CNetworkManager();
@@ -33,12 +36,28 @@ public:
 	CNetServerInterface * GetNetServer() { return m_pNetServer; }
 	bool                  Startup(int iPort, int iMaxPlayers, String strPassword, String strHostAddress);
 	static void           PacketHandler(CPacket * pPacket);
+	static bool           ConnectionFilter(unsigned long ulBinaryAddress);
+	void                  HandlePacket(CPacket * pPacket);
+	void                  ProcessPackets();
+	bool                  WaitForPackets(unsigned int uiTimeOutMilliseconds);
 	void                  Process();
 	void                  RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+	void                  GroupRPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, BroadcastGroupId groupId, EntityId exceptPlayerId = INVALID_ENTITY_ID, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+	void                  RPCReserved(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+
+	// Sends each reserved bit stream to the player at the same index in one call to the net server
+	void                  RPCReservedBatch(RPCIdentifier rpcId, CBitStream ** ppBitStreams, const EntityId * pPlayerIds, unsigned int uiCount, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel = PACKET_CHANNEL_DEFAULT);
+
+	// Sends a reliable scripting rpc that sets a property of the subject, of the rpcs with
+	// the same id and subject queued for a player in a tick only the last one is sent
+	void                  CoalescedRPC(RPCIdentifier rpcId, CBitStream * pBitStream, EntityId subjectId, EntityId playerId, bool bBroadcast);
+	// Sends a script event to the players, the players that don't have the id of the
+	// event name yet are sent its definition first
+	void                  EventRPC(const String& strName, CSquirrelArguments * pArguments, const EntityId * pPlayerIds, unsigned int uiCount, ePacketReliability reliability = RELIABILITY_RELIABLE_ORDERED);
+	CEventNameTable     * GetEventNames() { return &m_eventNames; }
 	String                GetPlayerIp(EntityId playerId);
 	unsigned short        GetPlayerPort(EntityId playerId);
 	String                GetPlayerSerial(EntityId playerId);
 	bool                  AddBan(String strIp, unsigned int uiSeconds);
-	bool                  LoadBans();
 	bool                  bRunning;
 };
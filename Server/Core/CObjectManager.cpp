@@ -11,18 +11,25 @@
 #include "CNetworkManager.h"
 #include "CEvents.h"
 #include "CModuleManager.h"
+#include "CEntityStreamer.h"
+#include "CSpatialIndex.h"
+#include "CEntityDataManager.h"
+#include <SharedUtility.h>
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CEvents         * g_pEvents;
 extern CModuleManager  * g_pModuleManager;
+extern CEntityStreamer * g_pEntityStreamer;
+extern CSpatialIndex   * g_pSpatialIndex;
+extern CEntityDataManager * g_pEntityDataManager;
+
+// Memory of an object in the dense arrays
+#define OBJECT_SLOT_SIZE (sizeof(EntityId) + sizeof(CVector3) + sizeof(_Object))
 
 CObjectManager::CObjectManager()
 {
-	for(EntityId x = 0; x < MAX_OBJECTS; x++)
-	{
-		m_bActive[x] = false;
-		m_Objects[x].bAttached = false;
-	}
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CObjectManager));
 
 	for(EntityId y = 0; y < MAX_FIRE; y++)
 		m_bFireActive[y] = false;
@@ -30,13 +37,10 @@ CObjectManager::CObjectManager()
 
 CObjectManager::~CObjectManager()
 {
-	for(EntityId x = 0; x < MAX_OBJECTS; x++)
-	{
-		if(m_bActive[x])
-			Delete(x);
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CObjectManager));
 
-		m_bActive[x] = false;
-	}
+	while(!m_activeObjects.empty())
+		Delete(m_activeObjects.back());
 
 	for(EntityId y = 0; y < MAX_FIRE; y++)
 	{
@@ -47,110 +51,277 @@ CObjectManager::~CObjectManager()
 	}
 }
 
+void CObjectManager::AddSlot(EntityId objectId, DWORD dwModelHash, const CVector3& vecPosition, const CVector3& vecRotation)
+{
+	_Object object;
+	object.dwModelHash = dwModelHash;
+	object.vecRotation = vecRotation;
+	object.bAttached = false;
+	object.bVehicleAttached = false;
+	object.uiVehiclePlayerId = INVALID_ENTITY_ID;
+	object.ucDimension = 0;
+	object.iBone = -1;
+	*m_denseIndex.Add(objectId) = (EntityId)m_activeObjects.size();
+	m_activeObjects.push_back(objectId);
+	m_positions.push_back(vecPosition);
+	m_objects.push_back(object);
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, OBJECT_SLOT_SIZE);
+	g_pSpatialIndex->Update(SPATIAL_INDEX_OBJECT, objectId, vecPosition, 0);
+}
+
+void CObjectManager::RemoveSlot(EntityId objectId)
+{
+	// Move the last object into the slot so the arrays stay dense
+	EntityId index = m_denseIndex[objectId];
+	EntityId lastObjectId = m_activeObjects.back();
+	m_activeObjects[index] = lastObjectId;
+	m_positions[index] = m_positions.back();
+	m_objects[index] = m_objects.back();
+	m_denseIndex[lastObjectId] = index;
+	m_activeObjects.pop_back();
+	m_positions.pop_back();
+	m_objects.pop_back();
+	m_denseIndex.Remove(objectId);
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, OBJECT_SLOT_SIZE);
+}
+
 EntityId CObjectManager::Create(DWORD dwModelHash, const CVector3& vecPosition, const CVector3& vecRotation)
 {
-	for(EntityId x = 0; x < MAX_OBJECTS; x++)
+	EntityId x = m_denseIndex.GetFree();
+
+	if(x != INVALID_ENTITY_ID)
 	{
-		if(!m_bActive[x])
+		AddSlot(x, dwModelHash, vecPosition, vecRotation);
+
+		// If the server streams objects the players get it when they come in range
+		if(!g_pEntityStreamer->IsEnabled())
 		{
 			CBitStream bsSend;
-			bsSend.WriteCompressed(x);
-			bsSend.Write(dwModelHash);
-			bsSend.Write(vecPosition);
-			bsSend.Write(vecRotation);
+			SerializeSpawn(x, &bsSend);
 			g_pNetworkManager->RPC(RPC_NewObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-			m_Objects[x].dwModelHash = dwModelHash;
-			m_Objects[x].vecPosition = vecPosition;
-			m_Objects[x].vecRotation = vecRotation;
-			m_bActive[x] = true;
-			m_Objects[x].iBone = -1;
-			
-			CSquirrelArguments pArguments;
-			pArguments.push(x);
-			g_pEvents->Call("objectCreate", &pArguments);
-
-			return x;
 		}
+		
+		CSquirrelArguments pArguments;
+		pArguments.push(x);
+		g_pEvents->Call("objectCreate", &pArguments);
+
+		return x;
 	}
 	return INVALID_ENTITY_ID;
 }
 
+EntityId CObjectManager::CreateBatch(unsigned int uiCount, const DWORD * pModelHashes, const CVector3 * pPositions, const CVector3 * pRotations)
+{
+	if(uiCount == 0 || uiCount > MAX_OBJECTS)
+		return INVALID_ENTITY_ID;
+
+	// The objects get contiguous ids so scripts only need the first one
+	EntityId firstId = INVALID_ENTITY_ID;
+	unsigned int uiFree = 0;
+
+	for(EntityId x = 0; x < MAX_OBJECTS; x++)
+	{
+		if(DoesExist(x))
+		{
+			uiFree = 0;
+			continue;
+		}
+
+		if(++uiFree == uiCount)
+		{
+			firstId = (x - (uiCount - 1));
+			break;
+		}
+	}
+
+	if(firstId == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
+
+	for(unsigned int i = 0; i < uiCount; i++)
+		AddSlot((firstId + i), pModelHashes[i], pPositions[i], pRotations[i]);
+
+	// Pack the objects into as few messages as possible instead of one per object
+	if(!g_pEntityStreamer->IsEnabled())
+	{
+		CBitStream bsSend;
+
+		for(unsigned int i = 0; i < uiCount; i++)
+		{
+			if(bsSend.GetNumberOfBytesUsed() >= JOIN_STREAM_MESSAGE_SIZE)
+			{
+				g_pNetworkManager->RPC(RPC_NewObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+				bsSend.Reset();
+			}
+
+			SerializeSpawn((firstId + i), &bsSend);
+		}
+
+		g_pNetworkManager->RPC(RPC_NewObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	}
+
+	for(unsigned int i = 0; i < uiCount; i++)
+	{
+		CSquirrelArguments pArguments;
+		pArguments.push((EntityId)(firstId + i));
+		g_pEvents->Call("objectCreate", &pArguments);
+	}
+
+	return firstId;
+}
+
 void CObjectManager::Delete(EntityId objectId)
 {
-	if(!m_bActive[objectId])
+	if(!DoesExist(objectId))
 		return;
 
 	CSquirrelArguments pArguments;
 	pArguments.push(objectId);
 	g_pEvents->Call("objectDelete", &pArguments);
 
+	if(g_pEntityStreamer->IsEnabled())
+		g_pEntityStreamer->RemoveEntity(ENTITY_STREAMER_OBJECT, objectId);
+	else
+	{
+		CBitStream bsSend;
+		bsSend.WriteCompressed(objectId);
+		g_pNetworkManager->RPC(RPC_DeleteObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	}
+
+	g_pSpatialIndex->Remove(SPATIAL_INDEX_OBJECT, objectId);
+	g_pEntityDataManager->RemoveEntity(ENTITY_DATA_OBJECT, objectId);
+	m_timelines.erase(objectId);
+	RemoveSlot(objectId);
+}
+
+void CObjectManager::SerializeSpawn(EntityId objectId, CBitStream * pBitStream)
+{
+	pBitStream->WriteCompressed(objectId);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].dwModelHash);
+	pBitStream->Write(m_positions[m_denseIndex[objectId]]);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].vecRotation);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].bAttached);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].bVehicleAttached);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].uiVehiclePlayerId);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].vecAttachPosition);
+	pBitStream->Write(m_objects[m_denseIndex[objectId]].vecAttachRotation);
+
+	if(m_objects[m_denseIndex[objectId]].iBone == -1)
+		pBitStream->Write0();
+	else
+	{
+		pBitStream->Write1();
+		pBitStream->Write(m_objects[m_denseIndex[objectId]].iBone);
+	}
+
+	// Players the object spawns for later start in the middle of the movement
+	std::map<EntityId, CMoveTimeline>::iterator iter = m_timelines.find(objectId);
+
+	if(iter == m_timelines.end())
+		pBitStream->Write0();
+	else
+	{
+		pBitStream->Write1();
+		(*iter).second.Serialize(pBitStream, SharedUtility::GetTime());
+	}
+}
+
+void CObjectManager::SendDimension(EntityId objectId, EntityId playerId)
+{
+	// Objects are in dimension 0 by default
+	if(m_objects[m_denseIndex[objectId]].ucDimension == 0)
+		return;
+
+	CBitStream bsSend;
+	bsSend.WriteCompressed(objectId);
+	bsSend.Write(m_objects[m_denseIndex[objectId]].ucDimension);
+	g_pNetworkManager->RPC(RPC_ScriptingSetObjectDimension, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
+
+void CObjectManager::SendTimeline(EntityId objectId, const CMoveTimeline& timeline)
+{
 	CBitStream bsSend;
 	bsSend.WriteCompressed(objectId);
-	g_pNetworkManager->RPC(RPC_DeleteObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-	m_bActive[objectId] = false;
+	timeline.Serialize(&bsSend, SharedUtility::GetTime());
+	g_pNetworkManager->RPC(RPC_ScriptingMoveObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 }
 
-void CObjectManager::HandleClientJoin(EntityId playerId)
+bool CObjectManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
 {
-	if(GetObjectCount() > 0)
+	// Pack as many objects as fit in a single message
+	CBitStream bsSend;
+	EntityId x = m_denseIndex.GetFirst(pCursor->entityId);
+
+	for(; x != INVALID_ENTITY_ID && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; x = m_denseIndex.GetFirst(x + 1))
 	{
-		CBitStream bsSend;
+		SerializeSpawn(x, &bsSend);
+		pCursor->uiEntities++;
+	}
+
+	if(pCursor->uiEntities > 0)
+	{
+		g_pNetworkManager->RPC(RPC_NewObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+
+		// Send the dimensions of the objects in this message to the joining player only
+		for(EntityId y = m_denseIndex.GetFirst(pCursor->entityId); y < x; y = m_denseIndex.GetFirst(y + 1))
+			SendDimension(y, playerId);
+	}
+
+	pCursor->uiBytes = bsSend.GetNumberOfBytesUsed();
+	pCursor->entityId = x;
+	return (x >= MAX_OBJECTS);
+}
 
-		for(EntityId x = 0; x < MAX_OBJECTS; x++)
+void CObjectManager::SpawnForPlayer(EntityId playerId, const std::list<EntityId>& objectList)
+{
+	// Pack the objects into as few messages as possible
+	CBitStream bsSend;
+	std::list<EntityId>::const_iterator iter = objectList.begin();
+
+	while(iter != objectList.end())
+	{
+		std::list<EntityId>::const_iterator firstIter = iter;
+		bsSend.Reset();
+
+		for(; iter != objectList.end() && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; iter++)
 		{
-			if(m_bActive[x])
-			{
-				bsSend.WriteCompressed(x);
-				bsSend.Write(m_Objects[x].dwModelHash);
-				bsSend.Write(m_Objects[x].vecPosition);
-				bsSend.Write(m_Objects[x].vecRotation);
-				bsSend.Write(m_Objects[x].bAttached);
-				bsSend.Write(m_Objects[x].bVehicleAttached);
-				bsSend.Write(m_Objects[x].uiVehiclePlayerId);
-				bsSend.Write(m_Objects[x].vecAttachPosition);
-				bsSend.Write(m_Objects[x].vecAttachRotation);
-				
-				if(m_Objects[x].iBone == -1)
-					bsSend.Write0();
-				else
-				{
-					bsSend.Write1();
-					bsSend.Write(m_Objects[x].iBone);
-				}
-
-				this->SetDimension(x, this->GetDimension(x));			
-			}
+			if(DoesExist(*iter))
+				SerializeSpawn(*iter, &bsSend);
 		}
 
+		if(bsSend.GetNumberOfBytesUsed() == 0)
+			continue;
+
 		g_pNetworkManager->RPC(RPC_NewObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+
+		for(; firstIter != iter; firstIter++)
+		{
+			if(DoesExist(*firstIter))
+				SendDimension(*firstIter, playerId);
+		}
 	}
 }
 
-bool CObjectManager::DoesExist(EntityId objectId)
+void CObjectManager::DeleteForPlayer(EntityId objectId, EntityId playerId)
 {
-	if(objectId < 0 || objectId >= MAX_OBJECTS)
-		return false;
+	CBitStream bsSend;
+	bsSend.WriteCompressed(objectId);
+	g_pNetworkManager->RPC(RPC_DeleteObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
 
-	return m_bActive[objectId];
+bool CObjectManager::DoesExist(EntityId objectId)
+{
+	return m_denseIndex.DoesExist(objectId);
 }
 
 EntityId CObjectManager::GetObjectCount()
 {
-	EntityId objectCount = 0;
-
-	for(EntityId x = 0; x < MAX_OBJECTS; x++)
-	{
-		if(m_bActive[x])
-			objectCount++;
-	}
-
-	return objectCount;
+	return (EntityId)m_activeObjects.size();
 }
 
 DWORD CObjectManager::GetModel(EntityId objectId)
 {
 	if(DoesExist(objectId))
-		return m_Objects[objectId].dwModelHash;
+		return m_objects[m_denseIndex[objectId]].dwModelHash;
 
 	return 0;
 }
@@ -159,7 +330,10 @@ bool CObjectManager::SetPosition(EntityId objectId, const CVector3& vecPosition)
 {
 	if(DoesExist(objectId))
 	{
-		m_Objects[objectId].vecPosition = vecPosition;
+		// The clients stop the movement when they get the position
+		m_timelines.erase(objectId);
+		m_positions[m_denseIndex[objectId]] = vecPosition;
+		g_pSpatialIndex->Update(SPATIAL_INDEX_OBJECT, objectId, vecPosition, m_objects[m_denseIndex[objectId]].ucDimension);
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(objectId);
@@ -176,7 +350,12 @@ bool CObjectManager::GetPosition(EntityId objectId, CVector3& vecPosition)
 {
 	if(DoesExist(objectId))
 	{
-		vecPosition = m_Objects[objectId].vecPosition;
+		std::map<EntityId, CMoveTimeline>::iterator iter = m_timelines.find(objectId);
+		CVector3 vecRotation;
+
+		if(iter == m_timelines.end() || !(*iter).second.Evaluate(SharedUtility::GetTime(), vecPosition, vecRotation))
+			vecPosition = m_positions[m_denseIndex[objectId]];
+
 		return true;
 	}
 
@@ -187,7 +366,9 @@ bool CObjectManager::SetRotation(EntityId objectId, const CVector3& vecRotation)
 {
 	if(DoesExist(objectId))
 	{
-		m_Objects[objectId].vecRotation = vecRotation;
+		// The clients stop the movement when they get the rotation
+		m_timelines.erase(objectId);
+		m_objects[m_denseIndex[objectId]].vecRotation = vecRotation;
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(objectId);
@@ -204,7 +385,12 @@ bool CObjectManager::GetRotation(EntityId objectId, CVector3& vecRotation)
 {
 	if(DoesExist(objectId))
 	{
-		vecRotation = m_Objects[objectId].vecRotation;
+		std::map<EntityId, CMoveTimeline>::iterator iter = m_timelines.find(objectId);
+		CVector3 vecPosition;
+
+		if(iter == m_timelines.end() || !(*iter).second.Evaluate(SharedUtility::GetTime(), vecPosition, vecRotation))
+			vecRotation = m_objects[m_denseIndex[objectId]].vecRotation;
+
 		return true;
 	}
 
@@ -233,7 +419,7 @@ EntityId CObjectManager::CreateFire(const CVector3& vecPos, float fdensity)
 
 void CObjectManager::DeleteFire(EntityId fireId)
 {
-	if(m_bFireActive[fireId])
+	if(fireId < MAX_FIRE && m_bFireActive[fireId])
 	{
 		CBitStream bsSend;
 		bsSend.Write(fireId);
@@ -270,24 +456,24 @@ void CObjectManager::AttachToPlayer(EntityId objectId, EntityId playerId, const
 {
 	if(DoesExist(objectId))
 	{
-		m_Objects[objectId].bAttached = true;
-		m_Objects[objectId].bVehicleAttached = false;
-		m_Objects[objectId].uiVehiclePlayerId = playerId;
-		m_Objects[objectId].vecAttachPosition = vecPos;
-		m_Objects[objectId].vecAttachRotation = vecRot;
-		m_Objects[objectId].iBone = iBone;
+		m_objects[m_denseIndex[objectId]].bAttached = true;
+		m_objects[m_denseIndex[objectId]].bVehicleAttached = false;
+		m_objects[m_denseIndex[objectId]].uiVehiclePlayerId = playerId;
+		m_objects[m_denseIndex[objectId]].vecAttachPosition = vecPos;
+		m_objects[m_denseIndex[objectId]].vecAttachRotation = vecRot;
+		m_objects[m_denseIndex[objectId]].iBone = iBone;
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(objectId);
-		bsSend.Write(m_Objects[objectId].bAttached);
-		bsSend.Write(m_Objects[objectId].bVehicleAttached);
-		bsSend.Write(m_Objects[objectId].uiVehiclePlayerId);
-		bsSend.Write(m_Objects[objectId].vecAttachPosition);
-		bsSend.Write(m_Objects[objectId].vecAttachRotation);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].bAttached);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].bVehicleAttached);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].uiVehiclePlayerId);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].vecAttachPosition);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].vecAttachRotation);
 		if(iBone != -1)
 		{
 			bsSend.Write1();
-			bsSend.Write(m_Objects[objectId].iBone);
+			bsSend.Write(m_objects[m_denseIndex[objectId]].iBone);
 		}
 		else
 			bsSend.Write0();
@@ -299,19 +485,19 @@ void CObjectManager::AttachToVehicle(EntityId objectId, EntityId vehicleId,const
 {
 	if(DoesExist(objectId))
 	{
-		m_Objects[objectId].bAttached = true;
-		m_Objects[objectId].bVehicleAttached = true;
-		m_Objects[objectId].uiVehiclePlayerId = vehicleId;
-		m_Objects[objectId].vecAttachPosition = vecPos;
-		m_Objects[objectId].vecAttachRotation = vecRot;
+		m_objects[m_denseIndex[objectId]].bAttached = true;
+		m_objects[m_denseIndex[objectId]].bVehicleAttached = true;
+		m_objects[m_denseIndex[objectId]].uiVehiclePlayerId = vehicleId;
+		m_objects[m_denseIndex[objectId]].vecAttachPosition = vecPos;
+		m_objects[m_denseIndex[objectId]].vecAttachRotation = vecRot;
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(objectId);
-		bsSend.Write(m_Objects[objectId].bAttached);
-		bsSend.Write(m_Objects[objectId].bVehicleAttached);
-		bsSend.Write(m_Objects[objectId].uiVehiclePlayerId);
-		bsSend.Write(m_Objects[objectId].vecAttachPosition);
-		bsSend.Write(m_Objects[objectId].vecAttachRotation);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].bAttached);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].bVehicleAttached);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].uiVehiclePlayerId);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].vecAttachPosition);
+		bsSend.Write(m_objects[m_denseIndex[objectId]].vecAttachRotation);
 		bsSend.Write0();
 		g_pNetworkManager->RPC(RPC_ScriptingAttachObject,&bsSend,PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 	}
@@ -321,12 +507,12 @@ void CObjectManager::Detach(EntityId objectId)
 {
 	if(DoesExist(objectId))
 	{
-		m_Objects[objectId].bAttached = false;
-		m_Objects[objectId].bVehicleAttached = false;
-		m_Objects[objectId].uiVehiclePlayerId = INVALID_ENTITY_ID;
-		m_Objects[objectId].vecAttachPosition = CVector3();
-		m_Objects[objectId].vecAttachRotation = CVector3();
-		m_Objects[objectId].iBone = -1;
+		m_objects[m_denseIndex[objectId]].bAttached = false;
+		m_objects[m_denseIndex[objectId]].bVehicleAttached = false;
+		m_objects[m_denseIndex[objectId]].uiVehiclePlayerId = INVALID_ENTITY_ID;
+		m_objects[m_denseIndex[objectId]].vecAttachPosition = CVector3();
+		m_objects[m_denseIndex[objectId]].vecAttachRotation = CVector3();
+		m_objects[m_denseIndex[objectId]].iBone = -1;
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(objectId);
@@ -334,38 +520,80 @@ void CObjectManager::Detach(EntityId objectId)
 	}
 }
 
-void CObjectManager::MoveObject(EntityId objectId, const CVector3& vecMoveTarget, const CVector3& vecMoveRot, float fSpeed)
+void CObjectManager::MoveObject(EntityId objectId, const CVector3& vecMoveTarget, const CVector3& vecMoveRot, float fSpeed, eMoveEasing easing)
 {
-	if(DoesExist(objectId))
-	{
-		CBitStream bsSend;
-		bsSend.WriteCompressed(objectId);
-		bsSend.Write(vecMoveTarget);
-		bsSend.Write(fSpeed);
-		m_Objects[objectId].vecPosition = vecMoveTarget;
+	CVector3 vecPosition;
+	CVector3 vecRotation;
 
-		if((vecMoveRot - m_Objects[objectId].vecPosition).Length() != 0) {
-			bsSend.Write1();
-			bsSend.Write(vecMoveRot);
-			m_Objects[objectId].vecRotation = vecMoveRot;
-		} else {
-			bsSend.Write0();
-		}
-		g_pNetworkManager->RPC(RPC_ScriptingMoveObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	if(GetPosition(objectId, vecPosition) && GetRotation(objectId, vecRotation))
+	{
+		CMoveTimeline timeline;
+		timeline.AddKeyframe(0, vecPosition, vecRotation);
+		timeline.AddKeyframe((unsigned int)(fSpeed > 0.0f ? fSpeed : 0.0f), vecMoveTarget, vecMoveRot, easing);
+		SetTimeline(objectId, timeline);
 	}
 }
 
-void CObjectManager::RotateObject(EntityId objectId, const CVector3& vecMoveRot, float fSpeed)
+void CObjectManager::RotateObject(EntityId objectId, const CVector3& vecMoveRot, float fSpeed, eMoveEasing easing)
 {
-	if(DoesExist(objectId))
+	CVector3 vecPosition;
+	CVector3 vecRotation;
+
+	if(GetPosition(objectId, vecPosition) && GetRotation(objectId, vecRotation))
 	{
-		CBitStream bsSend;
-		bsSend.WriteCompressed(objectId);
-		bsSend.Write(vecMoveRot);
-		bsSend.Write(fSpeed);
-		m_Objects[objectId].vecRotation = vecMoveRot;
+		CMoveTimeline timeline;
+		timeline.AddKeyframe(0, vecPosition, vecRotation);
+		timeline.AddKeyframe((unsigned int)(fSpeed > 0.0f ? fSpeed : 0.0f), vecPosition, vecMoveRot, easing);
+		SetTimeline(objectId, timeline);
+	}
+}
+
+bool CObjectManager::SetTimeline(EntityId objectId, const CMoveTimeline& timeline)
+{
+	if(!DoesExist(objectId) || timeline.IsEmpty())
+		return false;
+
+	CMoveTimeline& objectTimeline = m_timelines[objectId];
+	objectTimeline = timeline;
+	objectTimeline.SetStartTime(SharedUtility::GetTime());
+	SendTimeline(objectId, objectTimeline);
+	return true;
+}
+
+void CObjectManager::StopMoving(EntityId objectId)
+{
+	std::map<EntityId, CMoveTimeline>::iterator iter = m_timelines.find(objectId);
 
-		g_pNetworkManager->RPC(RPC_ScriptingRotateObject, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	if(iter == m_timelines.end())
+		return;
+
+	// A timeline with a single keyframe places the object without moving it
+	CMoveTimeline timeline;
+	EntityId index = m_denseIndex[objectId];
+	(*iter).second.Evaluate(SharedUtility::GetTime(), m_positions[index], m_objects[index].vecRotation);
+	timeline.AddKeyframe(0, m_positions[index], m_objects[index].vecRotation);
+	timeline.SetStartTime(SharedUtility::GetTime());
+	g_pSpatialIndex->Update(SPATIAL_INDEX_OBJECT, objectId, m_positions[index], m_objects[index].ucDimension);
+	m_timelines.erase(iter);
+	SendTimeline(objectId, timeline);
+}
+
+void CObjectManager::Process()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	for(std::map<EntityId, CMoveTimeline>::iterator iter = m_timelines.begin(); iter != m_timelines.end();)
+	{
+		EntityId objectId = (*iter).first;
+		EntityId index = m_denseIndex[objectId];
+		(*iter).second.Evaluate(ulTime, m_positions[index], m_objects[index].vecRotation);
+		g_pSpatialIndex->Update(SPATIAL_INDEX_OBJECT, objectId, m_positions[index], m_objects[index].ucDimension);
+
+		// The clients stop at the last keyframe on their own
+		if((*iter).second.IsFinished(ulTime))
+			m_timelines.erase(iter++);
+		else
+			++iter;
 	}
 }
 
@@ -373,7 +601,8 @@ void CObjectManager::RotateObject(EntityId objectId, const CVector3& vecMoveRot,
 void CObjectManager::SetDimension(EntityId objectId, unsigned char ucDimension)
 {
 	if(DoesExist(objectId)) {
-		m_Objects[objectId].ucDimension = ucDimension;
+		m_objects[m_denseIndex[objectId]].ucDimension = ucDimension;
+		g_pSpatialIndex->Update(SPATIAL_INDEX_OBJECT, objectId, m_positions[m_denseIndex[objectId]], ucDimension);
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(objectId);
@@ -11,11 +11,16 @@
 
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
+#include "CJoinStreamer.h"
+#include "CEntityPool.h"
+#include <Game/CMoveTimeline.h>
+#include <list>
+#include <map>
+#include <vector>
 
 struct _Object
 {
 	DWORD			dwModelHash;
-	CVector3		vecPosition;
 	CVector3		vecRotation;
 	bool			bAttached;
 	bool			bVehicleAttached;
@@ -34,24 +39,42 @@ struct _Fire
 class CObjectManager : public CObjectManagerInterface
 {
 private:
-	bool    m_bActive[MAX_OBJECTS];
-	_Object m_Objects[MAX_OBJECTS];
-	bool    m_bFireActive[MAX_OBJECTS];
-	_Fire	m_FireObject[MAX_OBJECTS];
+	// Dense slot map of the existing objects. m_denseIndex maps an object id to its index in
+	// m_activeObjects, m_positions and m_objects, the positions are kept apart as they are
+	// read far more than the rest
+	CEntityPool<EntityId, MAX_OBJECTS>	m_denseIndex;
+	std::vector<EntityId>	m_activeObjects;
+	std::vector<CVector3>	m_positions;
+	std::vector<_Object>	m_objects;
+	std::map<EntityId, CMoveTimeline>	m_timelines; // Timelines of the moving objects
+	bool    m_bFireActive[MAX_FIRE];
+	_Fire	m_FireObject[MAX_FIRE];
+
+	void			AddSlot(EntityId objectId, DWORD dwModelHash, const CVector3& vecPosition, const CVector3& vecRotation);
+	void			RemoveSlot(EntityId objectId);
+	void			SerializeSpawn(EntityId objectId, CBitStream * pBitStream);
+	void			SendDimension(EntityId objectId, EntityId playerId);
+	void			SendTimeline(EntityId objectId, const CMoveTimeline& timeline);
 
 public:
 	CObjectManager();
 	~CObjectManager();
 
 	EntityId		Create(DWORD dwModelHash, const CVector3& vecPosition, const CVector3& vecRotation);
+	// Creates uiCount objects with contiguous ids, returns the first id or INVALID_ENTITY_ID
+	// if there is no free range large enough
+	EntityId		CreateBatch(unsigned int uiCount, const DWORD * pModelHashes, const CVector3 * pPositions, const CVector3 * pRotations);
 	void			Delete(EntityId objectId);
-	void			HandleClientJoin(EntityId playerId);
+	bool			HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
+	void			SpawnForPlayer(EntityId playerId, const std::list<EntityId>& objectList);
+	void			DeleteForPlayer(EntityId objectId, EntityId playerId);
 	bool			DoesExist(EntityId objectId);
 
 	EntityId		GetObjectCount();
-	bool			GetAttachState(EntityId objectId) { return m_Objects[objectId].bAttached; }
-	bool			IsVehicleAttached(EntityId objectId) { return m_Objects[objectId].bVehicleAttached; }
-	unsigned int	GetAttachId(EntityId objectId) { return m_Objects[objectId].uiVehiclePlayerId; }
+	const std::vector<EntityId>& GetActiveObjects() { return m_activeObjects; }
+	bool			GetAttachState(EntityId objectId) { return (DoesExist(objectId) && m_objects[m_denseIndex[objectId]].bAttached); }
+	bool			IsVehicleAttached(EntityId objectId) { return (DoesExist(objectId) && m_objects[m_denseIndex[objectId]].bVehicleAttached); }
+	unsigned int	GetAttachId(EntityId objectId) { return (DoesExist(objectId) ? m_objects[m_denseIndex[objectId]].uiVehiclePlayerId : INVALID_ENTITY_ID); }
 
 	DWORD			GetModel(EntityId objectId);
 	bool			SetPosition(EntityId objectId, const CVector3& vecPosition);
@@ -60,8 +83,17 @@ public:
 	bool			GetRotation(EntityId objectId, CVector3& vecRotation);
 	void			AttachToVehicle(EntityId objectId, EntityId vehicleId,const CVector3& vecPos, const CVector3& vecRot);
 	void			AttachToPlayer(EntityId objectId, EntityId playerId, const CVector3& vecPos, const CVector3& vecRot, int iBone = -1);
-	void			MoveObject(EntityId objectId, const CVector3& vecMoveTarget,const CVector3& vecMoveRot, float fSpeed);
-	void			RotateObject(EntityId objectId, const CVector3& vecMoveRot, float fSpeed);
+	// fSpeed is the time in ms the object takes to get to the target
+	void			MoveObject(EntityId objectId, const CVector3& vecMoveTarget, const CVector3& vecMoveRot, float fSpeed, eMoveEasing easing = MOVE_EASING_LINEAR);
+	void			RotateObject(EntityId objectId, const CVector3& vecMoveRot, float fSpeed, eMoveEasing easing = MOVE_EASING_LINEAR);
+	// Moves the object along the timeline from now on, the clients get the timeline once and
+	// move the object themselves. Returns false if the object doesn't exist or the timeline is empty
+	bool			SetTimeline(EntityId objectId, const CMoveTimeline& timeline);
+	// Stops the object where it is now
+	void			StopMoving(EntityId objectId);
+	bool			IsMoving(EntityId objectId) { return (m_timelines.find(objectId) != m_timelines.end()); }
+	// Updates the positions of the moving objects
+	void			Process();
 	void			Detach(EntityId objectId);
 
 	EntityId		CreateFire(const CVector3& vecPosition, float fdensity);
@@ -69,5 +101,5 @@ public:
 	void			HandleClientJoinFire(EntityId playerId);
 	void			CreateExplosion(const CVector3& vecPosition, float fdensity);
 	void			SetDimension(EntityId objectId, unsigned char ucDimension);
-	unsigned char	GetDimension(EntityId objectId) { if(DoesExist(objectId)) return m_Objects[objectId].ucDimension; else return 0; }
+	unsigned char	GetDimension(EntityId objectId) { if(DoesExist(objectId)) return m_objects[m_denseIndex[objectId]].ucDimension; else return 0; }
 };
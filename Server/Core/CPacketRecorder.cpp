@@ -0,0 +1,291 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPacketRecorder.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CPacketRecorder.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include <Network/PacketIdentifiers.h>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager  * g_pPlayerManager;
+
+// All values are written in the byte order of the machine that recorded them
+template <typename T>
+static void WriteValue(FILE * pFile, T value)
+{
+	fwrite(&value, sizeof(T), 1, pFile);
+}
+
+template <typename T>
+static bool ReadValue(FILE * pFile, T * pValue)
+{
+	return (fread(pValue, sizeof(T), 1, pFile) == 1);
+}
+
+CPacketRecorder::CPacketRecorder()
+{
+	m_pRecordFile = NULL;
+	m_ullLastRecordTime = 0;
+	m_ulRecordedPackets = 0;
+	m_pReplayFile = NULL;
+	m_fReplaySpeed = 1.0f;
+	m_ullReplayTime = 0;
+	m_ullReplayStartTime = 0;
+	m_ullLastProcessTime = 0;
+	m_ulReplayedPackets = 0;
+	m_ullNextPacketTime = 0;
+	m_nextPlayerId = INVALID_ENTITY_ID;
+	m_nextPacketId = INVALID_PACKET_ID;
+	memset(m_bReplayConnected, 0, sizeof(m_bReplayConnected));
+}
+
+CPacketRecorder::~CPacketRecorder()
+{
+	StopRecording();
+	StopReplay();
+}
+
+bool CPacketRecorder::StartRecording(String strPath)
+{
+	StopRecording();
+	m_pRecordFile = fopen(strPath.Get(), "wb");
+
+	if(!m_pRecordFile)
+		return false;
+
+	// Packets come in small pieces so only write them out in large ones
+	setvbuf(m_pRecordFile, NULL, _IOFBF, PACKET_RECORDER_BUFFER_SIZE);
+	WriteValue<unsigned int>(m_pRecordFile, PACKET_RECORDER_MAGIC);
+	WriteValue<unsigned int>(m_pRecordFile, PACKET_RECORDER_VERSION);
+
+	// Write the sockets again for all players that are already connected
+	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+		m_recordedSockets[i] = CPlayerSocket();
+
+	m_ullLastRecordTime = SharedUtility::GetMicroseconds();
+	m_ulRecordedPackets = 0;
+	return true;
+}
+
+void CPacketRecorder::StopRecording()
+{
+	if(!m_pRecordFile)
+		return;
+
+	fclose(m_pRecordFile);
+	m_pRecordFile = NULL;
+	CLogFile::Printf("Recorded %d packet(s).", m_ulRecordedPackets);
+}
+
+void CPacketRecorder::WriteSocket(CPlayerSocket * pPlayerSocket)
+{
+	WriteValue<unsigned char>(m_pRecordFile, PACKET_RECORD_SOCKET);
+	WriteValue<EntityId>(m_pRecordFile, pPlayerSocket->playerId);
+	WriteValue<unsigned int>(m_pRecordFile, (unsigned int)pPlayerSocket->ulBinaryAddress);
+	WriteValue<unsigned short>(m_pRecordFile, pPlayerSocket->usPort);
+	unsigned char ucSerialLength = (unsigned char)(pPlayerSocket->strSerial.GetLength() > 0xFF ? 0xFF : pPlayerSocket->strSerial.GetLength());
+	WriteValue<unsigned char>(m_pRecordFile, ucSerialLength);
+	fwrite(pPlayerSocket->strSerial.Get(), 1, ucSerialLength, m_pRecordFile);
+	m_recordedSockets[pPlayerSocket->playerId] = *pPlayerSocket;
+}
+
+void CPacketRecorder::Record(CPacket * pPacket)
+{
+	if(!m_pRecordFile)
+		return;
+
+	CPlayerSocket * pPlayerSocket = pPacket->pPlayerSocket;
+
+	if(!pPlayerSocket || pPlayerSocket->playerId >= MAX_PLAYERS)
+		return;
+
+	// Only write the socket when it changed (e.g. a new player got the id)
+	CPlayerSocket * pRecordedSocket = &m_recordedSockets[pPlayerSocket->playerId];
+
+	if(pRecordedSocket->playerId != pPlayerSocket->playerId || pRecordedSocket->ulBinaryAddress != pPlayerSocket->ulBinaryAddress ||
+		pRecordedSocket->usPort != pPlayerSocket->usPort || pRecordedSocket->strSerial != pPlayerSocket->strSerial)
+		WriteSocket(pPlayerSocket);
+
+	// Keep the time as the time since the previous packet so it fits in 4 bytes
+	unsigned long long ullTime = SharedUtility::GetMicroseconds();
+	unsigned long long ullDelta = (ullTime - m_ullLastRecordTime);
+	m_ullLastRecordTime = ullTime;
+	WriteValue<unsigned char>(m_pRecordFile, PACKET_RECORD_PACKET);
+	WriteValue<unsigned int>(m_pRecordFile, (unsigned int)(ullDelta > 0xFFFFFFFF ? 0xFFFFFFFF : ullDelta));
+	WriteValue<EntityId>(m_pRecordFile, pPlayerSocket->playerId);
+	WriteValue<PacketId>(m_pRecordFile, pPacket->packetId);
+	WriteValue<unsigned int>(m_pRecordFile, pPacket->uiLength);
+
+	if(pPacket->uiLength > 0)
+		fwrite(pPacket->ucData, 1, pPacket->uiLength, m_pRecordFile);
+
+	m_ulRecordedPackets++;
+}
+
+bool CPacketRecorder::StartReplay(String strPath, float fSpeed)
+{
+	StopReplay();
+
+	// The replayed players would share the ids of the real players
+	if(g_pPlayerManager->GetPlayerCount() > 0)
+	{
+		CLogFile::Print("Recordings can only be replayed when no players are connected.");
+		return false;
+	}
+
+	m_pReplayFile = fopen(strPath.Get(), "rb");
+
+	if(!m_pReplayFile)
+		return false;
+
+	unsigned int uiMagic = 0;
+	unsigned int uiVersion = 0;
+
+	if(!ReadValue<unsigned int>(m_pReplayFile, &uiMagic) || !ReadValue<unsigned int>(m_pReplayFile, &uiVersion) ||
+		uiMagic != PACKET_RECORDER_MAGIC || uiVersion != PACKET_RECORDER_VERSION)
+	{
+		CLogFile::Printf("%s is not a packet recording of this server version.", strPath.Get());
+		fclose(m_pReplayFile);
+		m_pReplayFile = NULL;
+		return false;
+	}
+
+	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	{
+		m_replaySockets[i] = CPlayerSocket();
+		m_replaySockets[i].playerId = i;
+		m_bReplayConnected[i] = false;
+	}
+
+	m_fReplaySpeed = (fSpeed > 0.0f ? fSpeed : 0.0f);
+	m_ullReplayTime = 0;
+	m_ullNextPacketTime = 0;
+	m_ulReplayedPackets = 0;
+	m_ullReplayStartTime = SharedUtility::GetMicroseconds();
+	m_ullLastProcessTime = m_ullReplayStartTime;
+
+	// Read the first packet so Process knows when it is due
+	if(!ReadPacket())
+		StopReplay();
+
+	return true;
+}
+
+void CPacketRecorder::StopReplay()
+{
+	if(!m_pReplayFile)
+		return;
+
+	fclose(m_pReplayFile);
+	m_pReplayFile = NULL;
+
+	// Remove the replayed players that were still connected at the end
+	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	{
+		if(m_bReplayConnected[i])
+			ReplayPacket(i, PACKET_LOST_CONNECTION, NULL, 0);
+	}
+
+	CLogFile::Printf("Replayed %d packet(s) in %.2f seconds.", m_ulReplayedPackets, ((SharedUtility::GetMicroseconds() - m_ullReplayStartTime) / 1000000.0));
+}
+
+bool CPacketRecorder::ReadPacket()
+{
+	unsigned char ucType;
+
+	while(ReadValue<unsigned char>(m_pReplayFile, &ucType))
+	{
+		if(ucType == PACKET_RECORD_SOCKET)
+		{
+			EntityId playerId;
+			unsigned int uiBinaryAddress;
+			unsigned short usPort;
+			unsigned char ucSerialLength;
+			char szSerial[256];
+
+			if(!ReadValue<EntityId>(m_pReplayFile, &playerId) || !ReadValue<unsigned int>(m_pReplayFile, &uiBinaryAddress) ||
+				!ReadValue<unsigned short>(m_pReplayFile, &usPort) || !ReadValue<unsigned char>(m_pReplayFile, &ucSerialLength) ||
+				fread(szSerial, 1, ucSerialLength, m_pReplayFile) != ucSerialLength || playerId >= MAX_PLAYERS)
+				break;
+
+			szSerial[ucSerialLength] = '\0';
+			m_replaySockets[playerId].ulBinaryAddress = uiBinaryAddress;
+			m_replaySockets[playerId].usPort = usPort;
+			m_replaySockets[playerId].strSerial.Set(szSerial);
+		}
+		else if(ucType == PACKET_RECORD_PACKET)
+		{
+			unsigned int uiDelta;
+			unsigned int uiLength;
+
+			if(!ReadValue<unsigned int>(m_pReplayFile, &uiDelta) || !ReadValue<EntityId>(m_pReplayFile, &m_nextPlayerId) ||
+				!ReadValue<PacketId>(m_pReplayFile, &m_nextPacketId) || !ReadValue<unsigned int>(m_pReplayFile, &uiLength) ||
+				m_nextPlayerId >= MAX_PLAYERS)
+				break;
+
+			m_nextPacketData.resize(uiLength);
+
+			if(uiLength > 0 && fread(&m_nextPacketData[0], 1, uiLength, m_pReplayFile) != uiLength)
+				break;
+
+			m_ullNextPacketTime += uiDelta;
+			return true;
+		}
+		else
+			break;
+	}
+
+	return false;
+}
+
+void CPacketRecorder::ReplayPacket(EntityId playerId, PacketId packetId, unsigned char * ucData, unsigned int uiLength)
+{
+	if(packetId == PACKET_NEW_CONNECTION)
+		m_bReplayConnected[playerId] = true;
+	else if(packetId == PACKET_DISCONNECTED || packetId == PACKET_LOST_CONNECTION)
+		m_bReplayConnected[playerId] = false;
+
+	CPacket packet;
+	packet.pPlayerSocket = &m_replaySockets[playerId];
+	packet.packetId = packetId;
+	packet.uiLength = uiLength;
+	packet.ucData = ucData;
+	packet.pInternalPacket = NULL;
+	g_pNetworkManager->HandlePacket(&packet);
+}
+
+void CPacketRecorder::Process()
+{
+	if(!m_pReplayFile)
+		return;
+
+	// Advance the time of the recording by the time since the last tick
+	// scaled by the replay speed (a speed of 0 replays as fast as possible)
+	unsigned long long ullTime = SharedUtility::GetMicroseconds();
+	m_ullReplayTime += (unsigned long long)((ullTime - m_ullLastProcessTime) * m_fReplaySpeed);
+	m_ullLastProcessTime = ullTime;
+
+	for(unsigned int i = 0; m_fReplaySpeed == 0.0f ? (i < PACKET_RECORDER_MAX_REPLAY_PACKETS) : (m_ullNextPacketTime <= m_ullReplayTime); i++)
+	{
+		ReplayPacket(m_nextPlayerId, m_nextPacketId, (m_nextPacketData.empty() ? NULL : &m_nextPacketData[0]), (unsigned int)m_nextPacketData.size());
+		m_ulReplayedPackets++;
+
+		// The replay can be stopped by a script during the packet
+		if(!m_pReplayFile)
+			return;
+
+		if(!ReadPacket())
+		{
+			StopReplay();
+			return;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPacketRecorder.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include "Main.h"
+#include <Network/CPacket.h>
+#include <Network/CPlayerSocket.h>
+
+// Identifies packet recordings ("IVPR") and their format version
+#define PACKET_RECORDER_MAGIC 0x52505649
+#define PACKET_RECORDER_VERSION 1
+
+// Size of the write buffer of the recording file
+#define PACKET_RECORDER_BUFFER_SIZE 65536
+
+// Maximum amount of packets replayed per tick when replaying as fast as possible
+#define PACKET_RECORDER_MAX_REPLAY_PACKETS 4096
+
+// Types of the records in a recording
+enum ePacketRecordType
+{
+	// The address, port and serial of a player socket, written before the
+	// first packet of the socket and whenever they change
+	PACKET_RECORD_SOCKET,
+
+	// A packet with the microseconds since the previous packet
+	PACKET_RECORD_PACKET
+};
+
+// Records all packets the server receives to a binary file and replays
+// recordings through the packet and rpc handlers with fake player sockets.
+// Everything the server sends to the fake players is dropped as they have no
+// connection.
+class CPacketRecorder
+{
+private:
+	// Recording
+	FILE *                     m_pRecordFile;
+	unsigned long long         m_ullLastRecordTime;
+	unsigned long              m_ulRecordedPackets;
+	CPlayerSocket              m_recordedSockets[MAX_PLAYERS];
+
+	// Replaying
+	FILE *                     m_pReplayFile;
+	float                      m_fReplaySpeed;
+	unsigned long long         m_ullReplayTime;
+	unsigned long long         m_ullReplayStartTime;
+	unsigned long long         m_ullLastProcessTime;
+	unsigned long              m_ulReplayedPackets;
+	CPlayerSocket              m_replaySockets[MAX_PLAYERS];
+	bool                       m_bReplayConnected[MAX_PLAYERS];
+	unsigned long long         m_ullNextPacketTime;
+	EntityId                   m_nextPlayerId;
+	PacketId                   m_nextPacketId;
+	std::vector<unsigned char> m_nextPacketData;
+
+	void                       WriteSocket(CPlayerSocket * pPlayerSocket);
+	bool                       ReadPacket();
+	void                       ReplayPacket(EntityId playerId, PacketId packetId, unsigned char * ucData, unsigned int uiLength);
+
+public:
+	CPacketRecorder();
+	~CPacketRecorder();
+
+	bool                       IsRecording() { return (m_pRecordFile != NULL); }
+	bool                       StartRecording(String strPath);
+	void                       StopRecording();
+	void                       Record(CPacket * pPacket);
+	bool                       IsReplaying() { return (m_pReplayFile != NULL); }
+	bool                       StartReplay(String strPath, float fSpeed);
+	void                       StopReplay();
+	void                       Process();
+};
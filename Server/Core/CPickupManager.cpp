@@ -10,125 +10,156 @@
 #include "CPickupManager.h"
 #include "CNetworkManager.h"
 #include "CEvents.h"
+#include "CEntityStreamer.h"
+#include "CSpatialIndex.h"
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CEvents * g_pEvents;
+extern CEntityStreamer * g_pEntityStreamer;
+extern CSpatialIndex * g_pSpatialIndex;
 
 CPickupManager::CPickupManager()
 {
-	for(EntityId x = 0; x < MAX_PICKUPS; x++)
-		m_bActive[x] = false;
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CPickupManager));
 }
 
 CPickupManager::~CPickupManager()
 {
-	for(EntityId x = 0; x < MAX_PICKUPS; x++)
-	{
-		if(m_bActive[x])
-			Delete(x);
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CPickupManager));
 
-		m_bActive[x] = false;
-	}
+	for(EntityId x = m_pickups.GetFirst(); x != INVALID_ENTITY_ID; x = m_pickups.GetFirst(x + 1))
+		Delete(x);
 }
 
 EntityId CPickupManager::Create(DWORD dwModelHash, unsigned char ucType, unsigned int uiValue, float fX, float fY, float fZ, float fRX, float fRY, float fRZ)
 {
-	for(EntityId x = 0; x < MAX_PICKUPS; x++)
+	EntityId x = m_pickups.GetFree();
+
+	if(x == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
+
+	CVector3 vecPos(fX, fY, fZ);
+	CVector3 vecRot(fRX, fRY, fRZ);
+	_Pickup * pPickup = m_pickups.Add(x);
+	pPickup->dwModelHash = dwModelHash;
+	pPickup->vecPos = vecPos;
+	pPickup->vecRot = vecRot;
+	pPickup->ucType = ucType;
+	pPickup->uiValue = uiValue;
+	g_pSpatialIndex->Update(SPATIAL_INDEX_PICKUP, x, vecPos, 0);
+
+	// If the server streams pickups the players get it when they come in range
+	if(!g_pEntityStreamer->IsEnabled())
 	{
-		if(!m_bActive[x])
-		{
-			CVector3 vecPos(fX, fY, fZ);
-			CVector3 vecRot(fRX, fRY, fRZ);
-			m_Pickups[x].dwModelHash = dwModelHash;
-			m_Pickups[x].vecPos = vecPos;
-			m_Pickups[x].vecRot = vecRot;
-			m_Pickups[x].ucType = ucType;
-			m_Pickups[x].uiValue = uiValue;
-			m_bActive[x] = true;
-
-			CBitStream bsSend;
-			bsSend.WriteCompressed(x);
-			bsSend.Write(dwModelHash);
-			bsSend.Write(vecPos);
-			bsSend.Write(vecRot);
-			bsSend.Write(ucType);
-			bsSend.Write(uiValue);
-			g_pNetworkManager->RPC(RPC_NewPickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-
-			CSquirrelArguments pArguments;
-			pArguments.push(x);
-			g_pEvents->Call("pickupCreate", &pArguments);
-
-			return x;
-		}
+		CBitStream bsSend;
+		SerializeSpawn(x, &bsSend);
+		g_pNetworkManager->RPC(RPC_NewPickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 	}
-	return INVALID_ENTITY_ID;
+
+	CSquirrelArguments pArguments;
+	pArguments.push(x);
+	g_pEvents->Call("pickupCreate", &pArguments);
+
+	return x;
 }
 
 void CPickupManager::Delete(EntityId pickupId)
 {
-	if(!m_bActive[pickupId])
+	if(!m_pickups.DoesExist(pickupId))
 		return;
 
 	CSquirrelArguments pArguments;
 	pArguments.push(pickupId);
 	g_pEvents->Call("pickupDelete", &pArguments);
 
+	if(g_pEntityStreamer->IsEnabled())
+		g_pEntityStreamer->RemoveEntity(ENTITY_STREAMER_PICKUP, pickupId);
+	else
+	{
+		CBitStream bsSend;
+		bsSend.WriteCompressed(pickupId);
+		g_pNetworkManager->RPC(RPC_DeletePickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	}
+
+	g_pSpatialIndex->Remove(SPATIAL_INDEX_PICKUP, pickupId);
+	m_pickups.Remove(pickupId);
+}
+
+void CPickupManager::SerializeSpawn(EntityId pickupId, CBitStream * pBitStream)
+{
+	_Pickup * pPickup = m_pickups.Get(pickupId);
+	pBitStream->WriteCompressed(pickupId);
+	pBitStream->Write(pPickup->dwModelHash);
+	pBitStream->Write(pPickup->vecPos);
+	pBitStream->Write(pPickup->vecRot);
+	pBitStream->Write(pPickup->ucType);
+	pBitStream->Write(pPickup->uiValue);
+}
+
+bool CPickupManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
+{
+	// Pack as many pickups as fit in a single message
 	CBitStream bsSend;
-	bsSend.WriteCompressed(pickupId);
-	g_pNetworkManager->RPC(RPC_DeletePickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
-	m_bActive[pickupId] = false;
+	EntityId x = m_pickups.GetFirst(pCursor->entityId);
+
+	for(; x != INVALID_ENTITY_ID && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; x = m_pickups.GetFirst(x + 1))
+	{
+		SerializeSpawn(x, &bsSend);
+		pCursor->uiEntities++;
+	}
+
+	if(pCursor->uiEntities > 0)
+		g_pNetworkManager->RPC(RPC_NewPickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+
+	pCursor->uiBytes = bsSend.GetNumberOfBytesUsed();
+	pCursor->entityId = x;
+	return (x >= MAX_PICKUPS);
 }
 
-void CPickupManager::HandleClientJoin(EntityId playerId)
+void CPickupManager::SpawnForPlayer(EntityId playerId, const std::list<EntityId>& pickupList)
 {
-	if(GetPickupCount() > 0)
+	// Pack the pickups into as few messages as possible
+	CBitStream bsSend;
+	std::list<EntityId>::const_iterator iter = pickupList.begin();
+
+	while(iter != pickupList.end())
 	{
-		CBitStream bsSend;
+		bsSend.Reset();
 
-		for(EntityId x = 0; x < MAX_PICKUPS; x++)
+		for(; iter != pickupList.end() && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; iter++)
 		{
-			if(m_bActive[x])
-			{
-				bsSend.WriteCompressed(x);
-				bsSend.Write(m_Pickups[x].dwModelHash);
-				bsSend.Write(m_Pickups[x].vecPos);
-				bsSend.Write(m_Pickups[x].vecRot);
-				bsSend.Write(m_Pickups[x].ucType);
-				bsSend.Write(m_Pickups[x].uiValue);
-			}
+			if(DoesExist(*iter))
+				SerializeSpawn(*iter, &bsSend);
 		}
 
-		g_pNetworkManager->RPC(RPC_NewPickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		if(bsSend.GetNumberOfBytesUsed() > 0)
+			g_pNetworkManager->RPC(RPC_NewPickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 	}
 }
 
-bool CPickupManager::DoesExist(EntityId pickupId)
+void CPickupManager::DeleteForPlayer(EntityId pickupId, EntityId playerId)
 {
-	if(pickupId >= MAX_PICKUPS)
-		return false;
+	CBitStream bsSend;
+	bsSend.WriteCompressed(pickupId);
+	g_pNetworkManager->RPC(RPC_DeletePickup, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+}
 
-	return m_bActive[pickupId];
+bool CPickupManager::DoesExist(EntityId pickupId)
+{
+	return m_pickups.DoesExist(pickupId);
 }
 
 EntityId CPickupManager::GetPickupCount()
 {
-	EntityId pickupCount = 0;
-
-	for(EntityId x = 0; x < MAX_PICKUPS; x++)
-	{
-		if(m_bActive[x])
-			pickupCount++;
-	}
-
-	return pickupCount;
+	return (EntityId)m_pickups.GetCount();
 }
 
 DWORD CPickupManager::GetModel(EntityId pickupId)
 {
 	if(DoesExist(pickupId))
 	{
-		return m_Pickups[pickupId].dwModelHash;
+		return m_pickups[pickupId].dwModelHash;
 	}
 	return 0;
 }
@@ -138,7 +169,7 @@ unsigned char CPickupManager::GetType(EntityId pickupId)
 {
 	if(DoesExist(pickupId))
 	{
-		return m_Pickups[pickupId].ucType;
+		return m_pickups[pickupId].ucType;
 	}
 	return 0;
 }
@@ -147,7 +178,7 @@ bool CPickupManager::SetValue(EntityId pickupId, unsigned int pValue)
 {
 	if(DoesExist(pickupId))
 	{
-		m_Pickups[pickupId].uiValue = pValue;
+		m_pickups[pickupId].uiValue = pValue;
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(pickupId);
@@ -163,7 +194,7 @@ unsigned int CPickupManager::GetValue(EntityId pickupId)
 {
 	if(DoesExist(pickupId))
 	{
-		return m_Pickups[pickupId].uiValue;
+		return m_pickups[pickupId].uiValue;
 	}
 	return 0;
 }
@@ -172,7 +203,8 @@ bool CPickupManager::SetPosition(EntityId pickupId, CVector3 vecPosition)
 {
 	if(DoesExist(pickupId))
 	{
-		m_Pickups[pickupId].vecPos = vecPosition;
+		m_pickups[pickupId].vecPos = vecPosition;
+		g_pSpatialIndex->Update(SPATIAL_INDEX_PICKUP, pickupId, vecPosition, 0);
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(pickupId);
@@ -188,7 +220,7 @@ bool CPickupManager::GetPosition(EntityId pickupId, CVector3* vecPosition)
 {
 	if(DoesExist(pickupId))
 	{
-		memcpy(vecPosition, &m_Pickups[pickupId].vecPos, sizeof(CVector3));
+		memcpy(vecPosition, &m_pickups[pickupId].vecPos, sizeof(CVector3));
 		return true;
 	}
 	return false;
@@ -198,7 +230,7 @@ bool CPickupManager::SetRotation(EntityId pickupId, CVector3 vecRotation)
 {
 	if(DoesExist(pickupId))
 	{
-		m_Pickups[pickupId].vecRot = vecRotation;
+		m_pickups[pickupId].vecRot = vecRotation;
 
 		CBitStream bsSend;
 		bsSend.WriteCompressed(pickupId);
@@ -214,7 +246,7 @@ bool CPickupManager::GetRotation(EntityId pickupId, CVector3* vecRotation)
 {
 	if(DoesExist(pickupId))
 	{
-		memcpy(vecRotation, &m_Pickups[pickupId].vecRot, sizeof(CVector3));
+		memcpy(vecRotation, &m_pickups[pickupId].vecRot, sizeof(CVector3));
 		return true;
 	}
 	return false;
@@ -11,6 +11,9 @@
 
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
+#include "CJoinStreamer.h"
+#include "CEntityPool.h"
+#include <list>
 
 struct _Pickup
 {
@@ -24,8 +27,9 @@ struct _Pickup
 class CPickupManager : public CPickupManagerInterface
 {
 private:
-	bool m_bActive[MAX_PICKUPS];
-	_Pickup m_Pickups[MAX_PICKUPS];
+	CEntityPool<_Pickup, MAX_PICKUPS> m_pickups;
+
+	void SerializeSpawn(EntityId pickupId, CBitStream * pBitStream);
 
 public:
 	CPickupManager();
@@ -33,7 +37,9 @@ public:
 
 	EntityId Create(DWORD dwModelHash, unsigned char ucType, unsigned int uiValue, float fX, float fY, float fZ, float fRX, float fRY, float fRZ);
 	void Delete(EntityId pickupId);
-	void HandleClientJoin(EntityId playerId);
+	bool HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
+	void SpawnForPlayer(EntityId playerId, const std::list<EntityId>& pickupList);
+	void DeleteForPlayer(EntityId pickupId, EntityId playerId);
 	bool DoesExist(EntityId pickupId);
 	EntityId GetPickupCount();
 
@@ -13,13 +13,33 @@
 #include "CVehicleManager.h"
 #include "CEvents.h"
 #include <CSettings.h>
+#include <SharedUtility.h>
 #include "CModuleManager.h"
+#include "CInterestManager.h"
+#include "CBroadcastGroupManager.h"
+#include "CSnapshotManager.h"
+#include "CJoinStreamer.h"
+#include "CLagCompensation.h"
+#include "CCheckpointManager.h"
+#include <Network/CSyncSerializer.h>
+#include "Scripting/CScriptingManager.h"
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CPlayerManager * g_pPlayerManager;
 extern CVehicleManager * g_pVehicleManager;
 extern CEvents * g_pEvents;
 extern CModuleManager * g_pModuleManager;
+extern CInterestManager * g_pInterestManager;
+extern CBroadcastGroupManager * g_pBroadcastGroupManager;
+extern CSnapshotManager * g_pSnapshotManager;
+extern CJoinStreamer * g_pJoinStreamer;
+extern CLagCompensation * g_pLagCompensation;
+extern CCheckpointManager * g_pCheckpointManager;
+extern CScriptingManager * g_pScriptingManager;
+
+// Read in every sync so it is only looked up once
+static CSettingHandle g_frequentEventsSetting("frequentevents");
 
 unsigned int playerColors[] = 
 {
@@ -40,6 +60,7 @@ unsigned int playerColors[] =
 
 CPlayer::CPlayer(EntityId playerId, String strName)
 {
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CPlayer));
 	m_playerId = playerId;
 	//m_pScriptingInstance = sq_createinstance()
 	m_strName = strName;
@@ -47,6 +68,8 @@ CPlayer::CPlayer(EntityId playerId, String strName)
 	m_iModelId = 1;
 	m_pVehicle = NULL;
 	m_byteVehicleSeatId = -1;
+	m_enterVehicleId = INVALID_ENTITY_ID;
+	m_byteEnterVehicleSeatId = 0;
 	memset(&m_previousControlState, 0, sizeof(CControlState));
 	memset(&m_currentControlState, 0, sizeof(CControlState));
 	m_fHeading = 0;
@@ -57,6 +80,7 @@ CPlayer::CPlayer(EntityId playerId, String strName)
 	m_iMoney = 0;
 	m_uWeapon = 0;
 	m_uAmmo = 0;
+	m_ucInputActions = 0;
 	memset(&m_aimSyncData, 0, sizeof(AimSyncData));
 	m_uiColor = playerColors[playerId];
 	memset(&m_ucClothes, 0, sizeof(m_ucClothes));
@@ -66,14 +90,25 @@ CPlayer::CPlayer(EntityId playerId, String strName)
 	m_szAnimGroup = NULL;
 	m_szAnimGroup = new char[256];
 	m_bMobilePhoneUse = false;
+	m_bGameFilesModded = false;
+	m_bRelay = false;
 	m_ucDimension = 0;
 	m_bDrop = false;
 	m_iWantedLevel = 0;
+	m_ucInVehicleSequence = 0;
+	memset(m_bInVehicleAcked, 0, sizeof(m_bInVehicleAcked));
+	memset(m_ucInVehicleAckedSequence, 0, sizeof(m_ucInVehicleAckedSequence));
+	m_usSyncInterval = TICK_RATE;
+	m_ulLastSyncRateUpdateTime = 0;
 }
 
 CPlayer::~CPlayer()
 {
-	
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CPlayer));
+
+	// The scripts keep the name under the address of the player
+	if(g_pScriptingManager)
+		g_pScriptingManager->InvalidateCachedString(this);
 }
 
 String CPlayer::GetIp()
@@ -101,11 +136,15 @@ void CPlayer::SetState(eStateType state)
 {
 	if(m_state != state)
 	{
-		CSquirrelArguments pArguments;
-		pArguments.push(m_playerId);
-		pArguments.push(m_state);
-		pArguments.push(state);
-		g_pEvents->Call("playerChangeState", &pArguments);
+		// Relay nodes are no players to the scripts
+		if(!m_bRelay)
+		{
+			CSquirrelArguments pArguments;
+			pArguments.push(m_playerId);
+			pArguments.push(m_state);
+			pArguments.push(state);
+			g_pEvents->Call("playerChangeState", &pArguments);
+		}
 
 		m_state = state;
 	}
@@ -134,19 +173,23 @@ void CPlayer::DeleteForPlayer(EntityId playerId)
 
 void CPlayer::AddForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i) && i != m_playerId)
-			AddForPlayer(i);
+		if(players[i] != m_playerId)
+			AddForPlayer(players[i]);
 	}
 }
 
 void CPlayer::DeleteForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i) && i != m_playerId)
-			DeleteForPlayer(i);
+		if(players[i] != m_playerId)
+			DeleteForPlayer(players[i]);
 	}
 }
 
@@ -198,10 +241,12 @@ void CPlayer::KillForPlayer(EntityId playerId)
 
 void CPlayer::SpawnForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i) && i != m_playerId)
-			SpawnForPlayer(i);
+		if(players[i] != m_playerId)
+			SpawnForPlayer(players[i]);
 	}
 
 	m_bSpawned = true;
@@ -210,17 +255,20 @@ void CPlayer::SpawnForWorld()
 
 void CPlayer::KillForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i) && i != m_playerId)
-			KillForPlayer(i);
+		if(players[i] != m_playerId)
+			KillForPlayer(players[i]);
 	}
 
 	m_bSpawned = false;
+	m_enterVehicleId = INVALID_ENTITY_ID;
 	SetState(STATE_TYPE_DEATH);
 }
 
-void CPlayer::StoreOnFootSync(OnFootSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData)
+void CPlayer::StoreOnFootSync(OnFootSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead)
 {
 	// If we have warped out of a vehicle update its occupant
 	if(m_pVehicle && m_pVehicle->GetOccupant(m_byteVehicleSeatId) == this)
@@ -237,6 +285,7 @@ void CPlayer::StoreOnFootSync(OnFootSyncData * syncPacket, bool bHasAimSyncData,
 
 	// Set the position
 	m_vecPosition = syncPacket->vecPos;
+	g_pLagCompensation->Record(m_playerId, m_vecPosition);
 
 	// Set the heading
 	m_fHeading = syncPacket->fHeading;
@@ -270,33 +319,32 @@ void CPlayer::StoreOnFootSync(OnFootSyncData * syncPacket, bool bHasAimSyncData,
 		UpdateWeaponSync(aimSyncData->vecAimTarget,aimSyncData->vecShotSource, aimSyncData->vecLookAt);
 	}
 
+	// Do we have a head direction?
+	if(pvecHead)
+		UpdateHeadMoveSync(*pvecHead);
+
 	// Set the state to on foot
 	SetState(STATE_TYPE_ONFOOT);
 
-	// Send the sync to all other players
+	// Update our position in the interest grid
+	g_pInterestManager->UpdatePlayer(m_playerId, m_vecPosition, m_ucDimension);
+
+	// Send the sync to all interested players, the stream is reserved for the
+	// biggest sync so it never grows while it is written
 	CBitStream bsSend;
+	bsSend.Reserve(sizeof(EntityId) + sizeof(unsigned short) + sizeof(bool) + CSyncSerializer::GetMaxSize(*syncPacket) + CSyncSerializer::GetMaxLookSize() + 2);
 	bsSend.WriteCompressed(m_playerId);
 	bsSend.WriteCompressed(GetPing());
 	bsSend.WriteCompressed(m_bHelmet);
-	bsSend.Write((char *)syncPacket, sizeof(OnFootSyncData));
+	CSyncSerializer::Serialize(&bsSend, *syncPacket, &m_outgoingAnimState);
 
-	// Do we have aim sync data?
-	if(bHasAimSyncData)
-	{
-		// Write a 1 bit to say we have aim sync
-		bsSend.Write1();
-		bsSend.Write((char *)aimSyncData, sizeof(AimSyncData));
-	}
-	else
-	{
-		// Write a 0 bit to say we don't have aim sync
-		bsSend.Write0();
-	}
+	// Write the head and aim fields that changed
+	CSyncSerializer::SerializeLook(&bsSend, pvecHead, (bHasAimSyncData ? aimSyncData : NULL), &m_outgoingLookState);
 
-	g_pNetworkManager->RPC(RPC_OnFootSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId, true);
+	g_pInterestManager->SyncRPC(RPC_OnFootSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId);
 }
 
-void CPlayer::StoreInVehicleSync(CVehicle * pVehicle, InVehicleSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData)
+void CPlayer::StoreInVehicleSync(CVehicle * pVehicle, InVehicleSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead)
 {
 	// If we have warped into a vehicle update its driver
 	if(!m_pVehicle && pVehicle->GetDriver() != this)
@@ -314,6 +362,7 @@ void CPlayer::StoreInVehicleSync(CVehicle * pVehicle, InVehicleSyncData * syncPa
 
 	// Set the position to the vehicle position
 	m_vecPosition = syncPacket->vecPos;
+	g_pLagCompensation->Record(m_playerId, m_vecPosition);
 
 	// Set the rotation to the vehicle rotation
 	// TODO: Player has full rotation vector too
@@ -338,33 +387,86 @@ void CPlayer::StoreInVehicleSync(CVehicle * pVehicle, InVehicleSyncData * syncPa
 		UpdateWeaponSync(aimSyncData->vecAimTarget,aimSyncData->vecShotSource,aimSyncData->vecLookAt);
 	}
 
+	// Do we have a head direction?
+	if(pvecHead)
+		UpdateHeadMoveSync(*pvecHead);
+
 	// Set the state to in vehicle
 	SetState(STATE_TYPE_INVEHICLE);
 
-	// Send the sync to all other players
-	CBitStream bsSend;
-	bsSend.WriteCompressed(m_playerId);
-	bsSend.WriteCompressed(pVehicle->GetVehicleId());
-	bsSend.WriteCompressed(GetPing());
-	bsSend.WriteCompressed(m_bHelmet);
-	bsSend.Write((char *)syncPacket, sizeof(InVehicleSyncData));
+	// Update our position in the interest grid
+	g_pInterestManager->UpdatePlayer(m_playerId, m_vecPosition, m_ucDimension);
 
-	// Do we have aim sync data?
-	if(bHasAimSyncData)
-	{
-		// Write a 1 bit to say we have aim sync
-		bsSend.Write1();
-		bsSend.Write((char *)aimSyncData, sizeof(AimSyncData));
-	}
-	else
+	// Store the snapshot so it can be used as a baseline once it has been acknowledged
+	m_ucInVehicleSequence++;
+	m_inVehicleSnapshots.Store(m_ucInVehicleSequence, *syncPacket);
+
+	// The head and aim are the same for every player so they are only written once
+	CBitStream bsLook;
+	CSyncSerializer::SerializeLook(&bsLook, pvecHead, (bHasAimSyncData ? aimSyncData : NULL), &m_outgoingLookState);
+
+	// Send the sync to all interested players, delta compressed against
+	// the last snapshot each of them acknowledged
+	InterestPlayerList targetList;
+	g_pInterestManager->GetSyncTargets(m_playerId, targetList);
+
+	for(InterestPlayerList::iterator iter = targetList.begin(); iter != targetList.end(); iter++)
 	{
-		// Write a 0 bit to say we don't have aim sync
-		bsSend.Write0();
+		const InVehicleSyncData * pBaseline = NULL;
+
+		// Is the acknowledged snapshot still in our history?
+		if(m_bInVehicleAcked[*iter] && (unsigned char)(m_ucInVehicleSequence - m_ucInVehicleAckedSequence[*iter]) < SYNC_SNAPSHOT_HISTORY)
+			pBaseline = m_inVehicleSnapshots.Get(m_ucInVehicleAckedSequence[*iter]);
+
+		CBitStream bsSend;
+		bsSend.WriteCompressed(m_playerId);
+		bsSend.WriteCompressed(pVehicle->GetVehicleId());
+		bsSend.WriteCompressed(GetPing());
+		bsSend.WriteCompressed(m_bHelmet);
+		bsSend.Write(m_ucInVehicleSequence);
+
+		if(pBaseline)
+		{
+			bsSend.Write1();
+			bsSend.Write(m_ucInVehicleAckedSequence[*iter]);
+		}
+		else
+			bsSend.Write0();
+
+		CSyncSerializer::SerializeDelta(&bsSend, *syncPacket, pBaseline);
+
+		bsSend.WriteBits(bsLook.GetData(), bsLook.GetNumberOfBitsUsed(), false);
+
+		g_pSnapshotManager->Queue(*iter, m_playerId, RPC_InVehicleSync, &bsSend);
 	}
-	g_pNetworkManager->RPC(RPC_InVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId, true);
 }
 
-void CPlayer::StorePassengerSync(CVehicle * pVehicle, PassengerSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData)
+void CPlayer::AckInVehicleSync(EntityId playerId, unsigned char ucSequence)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	// Ignore acks for snapshots we no longer have
+	if(!m_inVehicleSnapshots.Get(ucSequence))
+		return;
+
+	// Ignore acks older than the one we already have
+	if(m_bInVehicleAcked[playerId] && (signed char)(ucSequence - m_ucInVehicleAckedSequence[playerId]) <= 0)
+		return;
+
+	m_bInVehicleAcked[playerId] = true;
+	m_ucInVehicleAckedSequence[playerId] = ucSequence;
+}
+
+void CPlayer::ResetInVehicleBaseline(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_bInVehicleAcked[playerId] = false;
+}
+
+void CPlayer::StorePassengerSync(CVehicle * pVehicle, PassengerSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead)
 {
 	// If we have warped into a vehicle update its passenger
 	if(!m_pVehicle && pVehicle->GetPassenger(syncPacket->byteSeatId) != this)
@@ -389,6 +491,7 @@ void CPlayer::StorePassengerSync(CVehicle * pVehicle, PassengerSyncData * syncPa
 
 	// Set the position to the vehicle position
 	pVehicle->GetPosition(m_vecPosition);
+	g_pLagCompensation->Record(m_playerId, m_vecPosition);
 
 	// Set the rotation to the vehicle rotation
 	// TODO: Player has full rotation vector too
@@ -407,34 +510,31 @@ void CPlayer::StorePassengerSync(CVehicle * pVehicle, PassengerSyncData * syncPa
 		UpdateWeaponSync(aimSyncData->vecAimTarget,aimSyncData->vecShotSource,aimSyncData->vecLookAt);
 	}
 
+	// Do we have a head direction?
+	if(pvecHead)
+		UpdateHeadMoveSync(*pvecHead);
+
 	// Set the state to passenger
 	SetState(STATE_TYPE_PASSENGER);
 
-	// Send the sync to all other players
+	// Update our position in the interest grid
+	g_pInterestManager->UpdatePlayer(m_playerId, m_vecPosition, m_ucDimension);
+
+	// Send the sync to all interested players
 	CBitStream bsSend;
 	bsSend.WriteCompressed(m_playerId);
 	bsSend.WriteCompressed(pVehicle->GetVehicleId());
 	bsSend.WriteCompressed(GetPing());
 	bsSend.WriteCompressed(m_bHelmet);
-	bsSend.Write((char *)syncPacket, sizeof(PassengerSyncData));
+	CSyncSerializer::Serialize(&bsSend, *syncPacket);
 
-	// Do we have aim sync data?
-	if(bHasAimSyncData)
-	{
-		// Write a 1 bit to say we have aim sync
-		bsSend.Write1();
-		bsSend.Write((char *)aimSyncData, sizeof(AimSyncData));
-	}
-	else
-	{
-		// Write a 0 bit to say we don't have aim sync
-		bsSend.Write0();
-	}
+	// Write the head and aim fields that changed
+	CSyncSerializer::SerializeLook(&bsSend, pvecHead, (bHasAimSyncData ? aimSyncData : NULL), &m_outgoingLookState);
 
-	g_pNetworkManager->RPC(RPC_PassengerSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId, true);
+	g_pInterestManager->SyncRPC(RPC_PassengerSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId);
 }
 
-void CPlayer::StoreSmallSync(SmallSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData)
+void CPlayer::StoreSmallSync(SmallSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead)
 {
 	// Set the control state
 	SetControlState(&syncPacket->controlState);
@@ -454,30 +554,118 @@ void CPlayer::StoreSmallSync(SmallSyncData * syncPacket, bool bHasAimSyncData, A
 		UpdateWeaponSync(aimSyncData->vecAimTarget,aimSyncData->vecShotSource,aimSyncData->vecLookAt);
 	}
 
-	// Send the sync to all other players
+	// Do we have a head direction?
+	if(pvecHead)
+		UpdateHeadMoveSync(*pvecHead);
+
+	// Send the sync to all interested players
 	CBitStream bsSend;
 	bsSend.WriteCompressed(m_playerId);
-	bsSend.Write((char *)syncPacket, sizeof(SmallSyncData));
+	CSyncSerializer::Serialize(&bsSend, *syncPacket);
 
-	// Do we have aim sync data?
-	if(bHasAimSyncData)
+	// Write the head and aim fields that changed
+	CSyncSerializer::SerializeLook(&bsSend, pvecHead, (bHasAimSyncData ? aimSyncData : NULL), &m_outgoingLookState);
+
+	g_pInterestManager->SyncRPC(RPC_SmallSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId);
+}
+
+void CPlayer::StoreInputActions(unsigned char ucInputActions)
+{
+	ucInputActions &= INPUT_ACTION_ALL;
+
+	// Only changes are relayed
+	if(ucInputActions == m_ucInputActions)
+		return;
+
+	m_ucInputActions = ucInputActions;
+
+	// Send them to all interested players now instead of with the next snapshot,
+	// the control state is only changed by the syncs that follow
+	CBitStream bsSend;
+	bsSend.WriteCompressed(m_playerId);
+	bsSend.Write(ucInputActions);
+
+	InterestPlayerList targetList;
+	g_pInterestManager->GetSyncTargets(m_playerId, targetList);
+
+	for(InterestPlayerList::iterator iter = targetList.begin(); iter != targetList.end(); iter++)
+		g_pNetworkManager->RPC(RPC_InputAction, &bsSend, PRIORITY_HIGH, RELIABILITY_UNRELIABLE_SEQUENCED, *iter, false, PACKET_CHANNEL_INPUT);
+}
+
+unsigned short CPlayer::CalculateSyncInterval()
+{
+	unsigned int uiInterval = TICK_RATE;
+
+	// Are we spawned?
+	if(m_bSpawned)
 	{
-		// Write a 1 bit to say we have aim sync
-		bsSend.Write1();
-		bsSend.Write((char *)aimSyncData, sizeof(AimSyncData));
+		float fSpeed = m_vecMoveSpeed.Length();
+
+		// Are we in combat or moving fast?
+		if(m_currentControlState.IsFiring() || m_currentControlState.IsAiming() || m_currentControlState.IsInCombat() || 
+			m_currentControlState.IsDoingDriveBy() || m_currentControlState.IsFiringHelicoptor() || fSpeed >= SYNC_RATE_FAST_SPEED)
+		{
+			uiInterval = (TICK_RATE / 2);
+		}
+		else
+		{
+			// Is nobody near us?
+			InterestPlayerList playerList;
+			g_pInterestManager->GetPlayersInRange(m_playerId, playerList);
+
+			if(g_pInterestManager->IsEnabled() && playerList.empty())
+				uiInterval = (TICK_RATE * 4);
+			else if(fSpeed < SYNC_RATE_IDLE_SPEED && m_currentControlState == m_previousControlState)
+				uiInterval = (TICK_RATE * 2);
+		}
 	}
 	else
-	{
-		// Write a 0 bit to say we don't have aim sync
-		bsSend.Write0();
-	}
+		uiInterval = (TICK_RATE * 4);
+
+	// Slow everyone down as the server fills up (up to 1.5x at max players)
+	unsigned int uiMaxPlayers = (unsigned int)CVAR_GET_INTEGER("maxplayers");
+
+	if(uiMaxPlayers > 0)
+		uiInterval += ((uiInterval * g_pPlayerManager->GetPlayerCount()) / (uiMaxPlayers * 2));
 
-	g_pNetworkManager->RPC(RPC_SmallSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, m_playerId, true);
+	// Clamp it to the configured bounds
+	unsigned int uiMinInterval = (unsigned int)CVAR_GET_INTEGER("minsyncinterval");
+	unsigned int uiMaxInterval = (unsigned int)CVAR_GET_INTEGER("maxsyncinterval");
+
+	if(uiInterval > uiMaxInterval)
+		uiInterval = uiMaxInterval;
+
+	if(uiInterval < uiMinInterval)
+		uiInterval = uiMinInterval;
+
+	return (unsigned short)uiInterval;
 }
 
 void CPlayer::Process()
 {
-	
+	// Is it time to re-evaluate our sync rate?
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastSyncRateUpdateTime) < SYNC_RATE_UPDATE_INTERVAL)
+		return;
+
+	m_ulLastSyncRateUpdateTime = ulTime;
+
+	// Don't change the sync rate before the client has joined (it resets it when it does)
+	if(g_pJoinStreamer->IsStreaming(m_playerId))
+		return;
+
+	// Has our sync rate changed? (fall back to the default one if adaptive sync rate is disabled)
+	unsigned short usSyncInterval = (CVAR_GET_BOOL("adaptivesyncrate") ? CalculateSyncInterval() : TICK_RATE);
+
+	if(usSyncInterval == m_usSyncInterval)
+		return;
+
+	// Tell the client its new sync rate
+	m_usSyncInterval = usSyncInterval;
+	CBitStream bsSend;
+	bsSend.WriteCompressed(usSyncInterval);
+	g_pNetworkManager->RPC(RPC_SyncRate, &bsSend, PRIORITY_LOW, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
 }
 
 bool CPlayer::SetName(String strName)
@@ -488,7 +676,9 @@ bool CPlayer::SetName(String strName)
 	if(strName == m_strName || g_pPlayerManager->IsNameInUse(strName))
 		return false;
 	
+	g_pPlayerManager->OnNameChanged(m_playerId, m_strName, strName);
 	m_strName = strName;
+	g_pScriptingManager->InvalidateCachedString(this);
 	CBitStream bsSend;
 	bsSend.Write(m_playerId);
 	bsSend.Write(strName);
@@ -543,7 +733,7 @@ void CPlayer::SetCameraPos(const CVector3& vecPosition)
 	m_vecPosition = vecPosition;
 	CBitStream bsSend;
 	bsSend.Write(vecPosition);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerCameraPos, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerCameraPos, &bsSend, m_playerId, m_playerId, false);
 }
 
 void CPlayer::SetCameraLookAt(const CVector3& vecPosition)
@@ -551,20 +741,25 @@ void CPlayer::SetCameraLookAt(const CVector3& vecPosition)
 	m_vecPosition = vecPosition;
 	CBitStream bsSend;
 	bsSend.Write(vecPosition);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerCameraLookAt, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerCameraLookAt, &bsSend, m_playerId, m_playerId, false);
 }
 
 void CPlayer::SetPosition(const CVector3& vecPosition)
 {
 	m_vecPosition = vecPosition;
+	g_pInterestManager->UpdatePlayer(m_playerId, m_vecPosition, m_ucDimension);
 	CBitStream bsSend;
 	bsSend.Write(vecPosition);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerCoordinates, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerCoordinates, &bsSend, m_playerId, m_playerId, false);
 }
 
 void CPlayer::GetPosition(CVector3& vecPosition)
 {
-	vecPosition = m_vecPosition;
+	// Passengers only sync when their state changes, they are where their vehicle is
+	if(m_pVehicle && m_state == STATE_TYPE_PASSENGER)
+		m_pVehicle->GetPosition(vecPosition);
+	else
+		vecPosition = m_vecPosition;
 }
 
 void CPlayer::SetCurrentHeading(float fHeading)
@@ -572,7 +767,7 @@ void CPlayer::SetCurrentHeading(float fHeading)
 	m_fHeading = fHeading;
 	CBitStream bsSend;
 	bsSend.Write(fHeading);
-	g_pNetworkManager->RPC(RPC_ScriptingSetHeading, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetHeading, &bsSend, m_playerId, m_playerId, false);
 }
 
 float CPlayer::GetCurrentHeading()
@@ -585,12 +780,15 @@ void CPlayer::SetMoveSpeed(const CVector3& vecMoveSpeed)
 	m_vecMoveSpeed = vecMoveSpeed;
 	CBitStream bsSend;
 	bsSend.Write(vecMoveSpeed);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerMoveSpeed, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerMoveSpeed, &bsSend, m_playerId, m_playerId, false);
 }
 
 void CPlayer::GetMoveSpeed(CVector3& vecMoveSpeed)
 {
-	vecMoveSpeed = m_vecMoveSpeed;
+	if(m_pVehicle && m_state == STATE_TYPE_PASSENGER)
+		m_pVehicle->GetMoveSpeed(vecMoveSpeed);
+	else
+		vecMoveSpeed = m_vecMoveSpeed;
 }
 
 void CPlayer::SetDucking(bool bDuckState)
@@ -609,7 +807,7 @@ void CPlayer::SetHealth(unsigned int uHealth)
 	m_uHealth = uHealth;
 	CBitStream bsSend;
 	bsSend.Write(uHealth);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerHealth, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerHealth, &bsSend, m_playerId, m_playerId, false);
 }
 
 unsigned int CPlayer::GetHealth()
@@ -622,7 +820,7 @@ void CPlayer::SetArmour(unsigned int uArmour)
 	m_uArmour = uArmour;
 	CBitStream bsSend;
 	bsSend.Write(uArmour);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerArmour, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerArmour, &bsSend, m_playerId, m_playerId, false);
 }
 
 unsigned int CPlayer::GetArmour()
@@ -644,7 +842,7 @@ void CPlayer::SetSpawnLocation(const CVector3& vecPosition, float fHeading)
 	CBitStream bsSend;
 	bsSend.Write(vecPosition);
 	bsSend.Write(fHeading);
-	g_pNetworkManager->RPC(RPC_ScriptingSetSpawnLocation, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetSpawnLocation, &bsSend, m_playerId, m_playerId, false);
 }
 
 void CPlayer::GetSpawnLocation(CVector3& vecPosition, float * fHeading)
@@ -682,7 +880,7 @@ bool CPlayer::SetMoney(int iMoney)
 	m_iMoney = iMoney;
 	CBitStream bsSend;
 	bsSend.Write(iMoney);
-	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerMoney, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_playerId, false);
+	g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerMoney, &bsSend, m_playerId, m_playerId, false);
 	return true;
 }
 
@@ -725,12 +923,20 @@ void CPlayer::SetControlState(CControlState * controlState)
 		m_previousControlState = m_currentControlState;
 		m_currentControlState = *controlState;
 
-		if(CVAR_GET_BOOL("frequentevents"))
+		if(g_frequentEventsSetting.GetBool())
+		{
+			CSquirrelArguments pArguments;
+			pArguments.push(m_playerId);
+			g_pEvents->Call(EVENT_PLAYER_CHANGE_PAD_STATE, &pArguments);
+			g_pEvents->Call(EVENT_PLAYER_CHANGE_CONTROL_STATE, &pArguments);
+		}
+
+		if(g_pEvents->HasThrottledHandlers(EVENT_PLAYER_CHANGE_PAD_STATE) || g_pEvents->HasThrottledHandlers(EVENT_PLAYER_CHANGE_CONTROL_STATE))
 		{
 			CSquirrelArguments pArguments;
 			pArguments.push(m_playerId);
-			g_pEvents->Call("playerChangePadState", &pArguments);
-			g_pEvents->Call("playerChangeControlState", &pArguments);
+			g_pEvents->Sample(EVENT_PLAYER_CHANGE_PAD_STATE, &pArguments, m_playerId);
+			g_pEvents->Sample(EVENT_PLAYER_CHANGE_CONTROL_STATE, &pArguments, m_playerId);
 		}
 	}
 }
@@ -754,7 +960,7 @@ void CPlayer::SetColor(unsigned int color)
 		CBitStream bsSend;
 		bsSend.Write(m_playerId);
 		bsSend.Write(color);
-		g_pNetworkManager->RPC(RPC_ScriptingSetPlayerColor, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		g_pNetworkManager->CoalescedRPC(RPC_ScriptingSetPlayerColor, &bsSend, m_playerId, INVALID_ENTITY_ID, true);
 	}
 }
 
@@ -869,15 +1075,18 @@ void CPlayer::UpdateHeadMoveSync(CVector3 vecHead)
 		m_vecLastHeadMove = vecHead;
 
 		// Call the event
-		g_pEvents->Call("headMove", &pArguments);
+		g_pEvents->Call(EVENT_HEAD_MOVE, &pArguments);
 	}
 }
 
 void CPlayer::SetDimension(unsigned char ucDimension)
 {
+	g_pBroadcastGroupManager->SetPlayerDimension(m_playerId, m_ucDimension, ucDimension);
 	m_ucDimension = ucDimension;
+	g_pInterestManager->UpdatePlayer(m_playerId, m_vecPosition, m_ucDimension);
 	CBitStream bsSend;
 	bsSend.Write(this->GetPlayerId());
 	bsSend.Write(this->GetDimension());
 	g_pNetworkManager->RPC(RPC_ScriptingSetVehicleDimension, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	g_pCheckpointManager->HandlePlayerDimension(m_playerId);
 }
\ No newline at end of file
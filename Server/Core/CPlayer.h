@@ -12,6 +12,7 @@
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
 #include "CVehicle.h"
+#include <Network/CSyncSerializer.h>
 
 class CPlayer : public CPlayerInterface
 {
@@ -23,6 +24,8 @@ private:
 	int           m_iModelId;
 	CVehicle    * m_pVehicle;
 	BYTE          m_byteVehicleSeatId;
+	EntityId      m_enterVehicleId; // Vehicle of the accepted entry until it completes or is cancelled
+	BYTE          m_byteEnterVehicleSeatId;
 	CControlState     m_previousControlState;
 	CControlState     m_currentControlState;
 	CVector3      m_vecPosition;
@@ -38,6 +41,7 @@ private:
 	int           m_iMoney;
 	unsigned int  m_uWeapon;
 	unsigned int  m_uAmmo;
+	unsigned char m_ucInputActions; // The actions (see eInputAction) that were relayed last
 	AimSyncData   m_aimSyncData;
 	unsigned int  m_uiColor;
 	unsigned char m_ucClothes[11];
@@ -46,12 +50,26 @@ private:
 	char*		  m_szAnimSpec;
 	float		  m_fAnimTime;
 	bool		  m_bMobilePhoneUse;
+	bool          m_bGameFilesModded;
+	bool          m_bRelay;
 	CVector3	  m_vecLastAim;
 	CVector3	  m_vecLastShot;
 	CVector3	  m_vecLastHeadMove;
 	unsigned char m_ucDimension;
 	bool		  m_bDrop;
 	unsigned int  m_iWantedLevel;
+	CSyncAnimState m_incomingAnimState;
+	CSyncAnimState m_outgoingAnimState;
+	CSyncLookState m_incomingLookState;
+	CSyncLookState m_outgoingLookState;
+	CSyncSnapshotHistory m_inVehicleSnapshots;
+	unsigned char m_ucInVehicleSequence;
+	bool          m_bInVehicleAcked[MAX_PLAYERS];
+	unsigned char m_ucInVehicleAckedSequence[MAX_PLAYERS];
+	unsigned short m_usSyncInterval;
+	unsigned long m_ulLastSyncRateUpdateTime;
+
+	unsigned short CalculateSyncInterval();
 
 public:
 	CPlayer(EntityId playerId, String strName);
@@ -78,11 +96,21 @@ public:
 	CVehicle     * GetVehicle() { return m_pVehicle; }
 	void           SetVehicleSeatId(BYTE byteSeatId) { m_byteVehicleSeatId = byteSeatId; }
 	BYTE           GetVehicleSeatId() { return m_byteVehicleSeatId; }
-	void           StoreOnFootSync(OnFootSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData);
-	void           StoreInVehicleSync(CVehicle * pVehicle, InVehicleSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData);
-	void           StorePassengerSync(CVehicle * pVehicle, PassengerSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData);
-	void           StoreSmallSync(SmallSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData);
+	void           SetEnterVehicle(EntityId vehicleId, BYTE byteSeatId) { m_enterVehicleId = vehicleId; m_byteEnterVehicleSeatId = byteSeatId; }
+	EntityId       GetEnterVehicleId() { return m_enterVehicleId; }
+	BYTE           GetEnterVehicleSeatId() { return m_byteEnterVehicleSeatId; }
+	CSyncAnimState * GetIncomingAnimState() { return &m_incomingAnimState; }
+	CSyncLookState * GetIncomingLookState() { return &m_incomingLookState; }
+	// The head is where the player looks, NULL if the sync has none
+	void           StoreOnFootSync(OnFootSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead);
+	void           StoreInVehicleSync(CVehicle * pVehicle, InVehicleSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead);
+	void           StorePassengerSync(CVehicle * pVehicle, PassengerSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead);
+	void           StoreSmallSync(SmallSyncData * syncPacket, bool bHasAimSyncData, AimSyncData * aimSyncData, CVector3 * pvecHead);
+	void           StoreInputActions(unsigned char ucInputActions);
+	void           AckInVehicleSync(EntityId playerId, unsigned char ucSequence);
+	void           ResetInVehicleBaseline(EntityId playerId);
 	void           Process();
+	unsigned short GetSyncInterval() { return m_usSyncInterval; }
 	bool           SetName(String strName);
 	String         GetName();
 	bool           IsSpawned();
@@ -124,6 +152,11 @@ public:
 	void           SetClothes(unsigned char ucBodyPart, unsigned char ucClothes);
 	unsigned char  GetClothes(unsigned char ucBodyPart);
 	void		   UseMobilePhone(bool bUse) { m_bMobilePhoneUse = bUse; }
+	void           SetGameFilesModded(bool bModded) { m_bGameFilesModded = bModded; }
+	bool           AreGameFilesModded() { return m_bGameFilesModded; }
+	// Relay nodes aren't in the world, they get everything to fan it out to their spectators
+	void           SetRelay(bool bRelay) { m_bRelay = bRelay; }
+	bool           IsRelay() { return m_bRelay; }
 	void		   UpdateWeaponSync(CVector3 vecAim, CVector3 vecShotm, CVector3 vecLookAt);
 	void		   UpdateHeadMoveSync(CVector3 vecHead);
 
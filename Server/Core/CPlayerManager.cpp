@@ -20,6 +20,23 @@
 #include "CModuleManager.h"
 #include "CEvents.h"
 #include "CBlipManager.h"
+#include "CInterestManager.h"
+#include "CBroadcastGroupManager.h"
+#include "CSnapshotManager.h"
+#include "CCommandBuffer.h"
+#include "CJoinStreamer.h"
+#include "CEntityStreamer.h"
+#include "CZoneManager.h"
+#include "CCheckpointManager.h"
+#include "CChatManager.h"
+#include "CEntityDataManager.h"
+#include "CClientEventManager.h"
+#include "CLagCompensation.h"
+#include "CTransferManager.h"
+#include "CQuery.h"
+#include <CSettings.h>
+#include <algorithm>
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CScriptingManager * g_pScriptingManager;
@@ -27,11 +44,32 @@ extern CVehicleManager * g_pVehicleManager;
 extern CModuleManager * g_pModuleManager;
 extern CEvents * g_pEvents;
 extern CBlipManager * g_pBlipManager;
+extern CInterestManager * g_pInterestManager;
+extern CBroadcastGroupManager * g_pBroadcastGroupManager;
+extern CQuery * g_pQuery;
+extern CSnapshotManager * g_pSnapshotManager;
+extern CCommandBuffer * g_pCommandBuffer;
+extern CJoinStreamer * g_pJoinStreamer;
+extern CEntityStreamer * g_pEntityStreamer;
+extern CZoneManager * g_pZoneManager;
+extern CCheckpointManager * g_pCheckpointManager;
+extern CChatManager * g_pChatManager;
+extern CEntityDataManager * g_pEntityDataManager;
+extern CClientEventManager * g_pClientEventManager;
+extern CLagCompensation * g_pLagCompensation;
+extern CTransferManager * g_pTransferManager;
 
 CPlayerManager::CPlayerManager()
 {
-	for(EntityId x = 0; x < MAX_PLAYERS; x++)
-		m_bActive[x] = false;
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CPlayerManager));
+
+	EntityId maxPlayers = (EntityId)CVAR_GET_INTEGER("maxplayers");
+
+	if(maxPlayers > MAX_PLAYERS)
+		maxPlayers = MAX_PLAYERS;
+
+	m_bActive.resize(maxPlayers, false);
+	m_pPlayers.resize(maxPlayers, NULL);
 
 	g_pScriptingManager->RegisterConstant("STATE_TYPE_DISCONNECT", STATE_TYPE_DISCONNECT);
 	g_pScriptingManager->RegisterConstant("STATE_TYPE_CONNECT", STATE_TYPE_CONNECT);
@@ -46,33 +84,55 @@ CPlayerManager::CPlayerManager()
 
 CPlayerManager::~CPlayerManager()
 {
-	for(EntityId x = 0; x < MAX_PLAYERS; x++)
-	{
-		if(DoesExist(x))
-			Remove(x, 0);
-	}
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CPlayerManager));
+
+	while(!m_activePlayers.empty())
+		Remove(m_activePlayers.back(), 0);
 }
 
 bool CPlayerManager::DoesExist(EntityId playerId)
 {
-	if(playerId < 0 || playerId >= MAX_PLAYERS)
+	if(playerId < 0 || playerId >= m_bActive.size())
 		return false;
 
 	return m_bActive[playerId];
 }
 
-void CPlayerManager::Add(EntityId playerId, String sPlayerName)
+void CPlayerManager::Add(EntityId playerId, const String& sPlayerName, bool bRelay)
 {
+	if(playerId >= MAX_PLAYERS)
+		return;
+
 	if(DoesExist(playerId))
 		Remove(playerId, 3);
 
+	// Replayed recordings can use more ids than the server has slots
+	if(playerId >= m_pPlayers.size())
+	{
+		m_bActive.resize((playerId + 1), false);
+		m_pPlayers.resize((playerId + 1), NULL);
+	}
+
 	m_pPlayers[playerId] = new CPlayer(playerId, sPlayerName);
 
 	if(m_pPlayers[playerId])
 	{
 		m_bActive[playerId] = true;
-		m_pPlayers[playerId]->AddForWorld();
+		m_activePlayers.insert(std::lower_bound(m_activePlayers.begin(), m_activePlayers.end(), playerId), playerId);
+		m_playerNames.insert(std::make_pair(GetNameKey(sPlayerName), playerId));
+		g_pBroadcastGroupManager->AddPlayer(CBroadcastGroupManager::GetDimensionGroup(m_pPlayers[playerId]->GetDimension()), playerId);
+		m_pPlayers[playerId]->SetRelay(bRelay);
+
+		// Nobody sees a relay node
+		if(bRelay)
+			m_relays.insert(std::lower_bound(m_relays.begin(), m_relays.end(), playerId), playerId);
+		else
+			m_pPlayers[playerId]->AddForWorld();
+
 		m_pPlayers[playerId]->SetState(STATE_TYPE_CONNECT);
+
+		if(g_pQuery)
+			g_pQuery->InvalidatePlayers();
 	}
 }
 
@@ -87,16 +147,80 @@ bool CPlayerManager::Remove(EntityId playerId, BYTE byteReason)
 	if(!DoesExist(playerId))
 		return false;
 
-	CSquirrelArguments pArguments;
-	pArguments.push(playerId);
-	pArguments.push(byteReason);
-	g_pEvents->Call("playerDisconnect", &pArguments);
+	// Relay nodes are no players to the scripts
+	bool bRelay = m_pPlayers[playerId]->IsRelay();
+
+	if(bRelay)
+		m_relays.erase(std::lower_bound(m_relays.begin(), m_relays.end(), playerId));
+	else
+	{
+		CSquirrelArguments pArguments;
+		pArguments.push(playerId);
+		pArguments.push(byteReason);
+		g_pEvents->Call("playerDisconnect", &pArguments);
+	}
+
+	// The throttled handlers don't get the samples of the player any more
+	g_pEvents->RemoveSamples(playerId);
 
 	m_pPlayers[playerId]->SetState(STATE_TYPE_DISCONNECT);
-	m_pPlayers[playerId]->DeleteForWorld();
+
+	if(!bRelay)
+		m_pPlayers[playerId]->DeleteForWorld();
 
 	// Mark player as false
 	m_bActive[playerId] = false;
+	m_activePlayers.erase(std::lower_bound(m_activePlayers.begin(), m_activePlayers.end(), playerId));
+	OnNameChanged(playerId, m_pPlayers[playerId]->GetName(), "");
+
+	// Remove the player from the interest grid
+	g_pInterestManager->RemovePlayer(playerId);
+
+	// Forget which zones the player was in
+	g_pZoneManager->RemovePlayer(playerId);
+
+	// Forget which checkpoints the player was in
+	g_pCheckpointManager->RemovePlayer(playerId);
+
+	// Reset the chat channel and team of the player
+	g_pChatManager->RemovePlayer(playerId);
+
+	// Remove the data of the player
+	g_pEntityDataManager->RemoveEntity(ENTITY_DATA_PLAYER, playerId);
+
+	// Remove the player from all broadcast groups
+	g_pBroadcastGroupManager->RemovePlayerFromAll(playerId);
+
+	// Drop any sync still queued for or from the player
+	g_pSnapshotManager->RemovePlayer(playerId);
+
+	// Drop any scripting commands still queued for the player
+	g_pCommandBuffer->RemovePlayer(playerId);
+
+	// Stop streaming the world state to the player
+	g_pJoinStreamer->RemovePlayer(playerId);
+
+	// Forget which entities the player had streamed in
+	g_pEntityStreamer->RemovePlayer(playerId);
+
+	// Forget which short range blips the player had
+	g_pBlipManager->RemovePlayer(playerId);
+
+	// Forget the script event names sent to and defined by the player
+	g_pNetworkManager->GetEventNames()->RemovePeer(playerId);
+
+	// Forget the event limits and the coalesced events of the player
+	g_pClientEventManager->RemovePlayer(playerId);
+
+	// Forget the positions kept to rewind the shots of other players
+	g_pLagCompensation->RemovePlayer(playerId);
+
+	// Forget the state of a transfer the player brought but never joined with
+	g_pTransferManager->RemovePlayer(playerId);
+
+	// Other players can no longer delta compress their sync against what this player received
+	for(size_t i = 0; i < m_activePlayers.size(); i++)
+		m_pPlayers[m_activePlayers[i]]->ResetInVehicleBaseline(playerId);
 
 	String strReason = "None";
 
@@ -120,20 +244,19 @@ bool CPlayerManager::Remove(EntityId playerId, BYTE byteReason)
 
 void CPlayerManager::Pulse()
 {
-	for(EntityId x = 0; x < MAX_PLAYERS; x++)
-	{
-		if(m_bActive[x])
-			m_pPlayers[x]->Process();
-	}
+	for(size_t i = 0; i < m_activePlayers.size(); i++)
+		m_pPlayers[m_activePlayers[i]]->Process();
 }
 
 void CPlayerManager::HandleClientJoin(EntityId playerId)
 {
 	if(GetPlayerCount() > 1)
  	{
-		for(EntityId x = 0; x < MAX_PLAYERS; x++)
+		for(size_t i = 0; i < m_activePlayers.size(); i++)
 		{
-			if(m_bActive[x] && x != playerId)
+			EntityId x = m_activePlayers[i];
+
+			if(x != playerId && !m_pPlayers[x]->IsRelay())
 			{
 				m_pPlayers[x]->AddForPlayer(playerId);
 				m_pPlayers[x]->SpawnForPlayer(playerId);
@@ -155,7 +278,7 @@ void CPlayerManager::HandleClientJoin(EntityId playerId)
 	}
 }
 
-bool CPlayerManager::IsNameInUse(String sNick)
+bool CPlayerManager::IsNameInUse(const String& sNick)
 {
 	return GetPlayerFromName(sNick) != INVALID_ENTITY_ID;
 }
@@ -166,36 +289,48 @@ bool CPlayerManager::IsNameInUse(char * sNick)
 	return IsNameInUse(szNick);
 }
 
-EntityId CPlayerManager::GetPlayerFromName(String sNick)
+String CPlayerManager::GetNameKey(String strName)
 {
-	for(EntityId x = 0; x < MAX_PLAYERS; x++)
-	{
-		if(m_bActive[x])
-		{
-			if(!stricmp(m_pPlayers[x]->GetName(), sNick)) 
-				return x;
-		}
-	}
+	// Names are compared case insensitive
+	strName.ToLower();
+	return strName;
+}
 
-	return INVALID_ENTITY_ID;
+void CPlayerManager::OnNameChanged(EntityId playerId, const String& strOldName, const String& strNewName)
+{
+	std::map<String, EntityId>::iterator iter = m_playerNames.find(GetNameKey(strOldName));
+
+	// Only forget the old name if it was ours (replayed recordings can reuse names)
+	if(iter != m_playerNames.end() && iter->second == playerId)
+		m_playerNames.erase(iter);
+
+	if(strNewName.IsNotEmpty())
+		m_playerNames.insert(std::make_pair(GetNameKey(strNewName), playerId));
+
+	// Players leaving change their name to an empty one as well
+	if(g_pQuery)
+		g_pQuery->InvalidatePlayers();
+}
+
+EntityId CPlayerManager::GetPlayerFromName(const String& sNick)
+{
+	std::map<String, EntityId>::iterator iter = m_playerNames.find(GetNameKey(sNick));
+
+	if(iter == m_playerNames.end())
+		return INVALID_ENTITY_ID;
+
+	return iter->second;
 }
 
 EntityId CPlayerManager::GetPlayerFromName(char * sNick)
 {
-	return GetPlayerFromName(sNick);
+	String strNick = sNick;
+	return GetPlayerFromName(strNick);
 }
 
 EntityId CPlayerManager::GetPlayerCount()
 {
-	EntityId playerCount = 0;
-
-	for(EntityId x = 0; x < MAX_PLAYERS; x++)
-	{
-		if(m_bActive[x])
-			playerCount++;
-	}
-
-	return playerCount;
+	return (EntityId)m_activePlayers.size();
 }
 
 CPlayer * CPlayerManager::GetAt(EntityId playerId)
@@ -13,27 +13,48 @@
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
 #include "CPlayer.h"
+#include <vector>
+#include <map>
 
 class CPlayerManager : public CPlayerManagerInterface
 {
 private:
-	bool m_bActive[MAX_PLAYERS];
-	CPlayer * m_pPlayers[MAX_PLAYERS];
+	// Sized from maxplayers (MAX_PLAYERS is only the upper bound of the player ids)
+	std::vector<bool> m_bActive;
+	std::vector<CPlayer *> m_pPlayers;
+
+	// Ids of the existing players in ascending order (its size is the player count)
+	std::vector<EntityId> m_activePlayers;
+
+	// Ids of the existing relay nodes in ascending order (they are also in m_activePlayers)
+	std::vector<EntityId> m_relays;
+
+	// Ids of the existing players by their lower case name
+	std::map<String, EntityId> m_playerNames;
+
+	static String GetNameKey(String strName);
 
 public:
 	CPlayerManager();
 	~CPlayerManager();
 
 	bool DoesExist(EntityId playerId);
-	void Add(EntityId playerId, String sPlayerName);
+	void Add(EntityId playerId, const String& sPlayerName, bool bRelay = false);
 	void Add(EntityId playerId, char * sPlayerName);
 	bool Remove(EntityId playerId, BYTE byteReason);
 	void Pulse();
 	void HandleClientJoin(EntityId playerId);
-	bool IsNameInUse(String szNick);
+	bool IsNameInUse(const String& sNick);
 	bool IsNameInUse(char * sNick);
-	EntityId GetPlayerFromName(String sNick);
+	EntityId GetPlayerFromName(const String& sNick);
 	EntityId GetPlayerFromName(char * sNick);
 	EntityId GetPlayerCount();
 	CPlayer * GetAt(EntityId playerId);
+	EntityId GetMaxPlayers() { return (EntityId)m_pPlayers.size(); }
+	void OnNameChanged(EntityId playerId, const String& strOldName, const String& strNewName);
+
+	// Walk this instead of all player ids, it doesn't change while a player is processed
+	// but use a copy if a player can be added or removed during the walk
+	const std::vector<EntityId>& GetActivePlayers() { return m_activePlayers; }
+	const std::vector<EntityId>& GetRelays() { return m_relays; }
 };
\ No newline at end of file
@@ -13,12 +13,17 @@
 #include <SharedUtility.h>
 #include "CPlayerManager.h"
 #include <CLogFile.h>
+#include <algorithm>
+#include <time.h>
 #ifdef _LINUX
 #include <sys/socket.h>
+#include <sys/select.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <fcntl.h>
+#include <unistd.h>
 #define closesocket close
+#define Sleep(ms) usleep((ms) * 1000)
 #else
 typedef int socklen_t;
 #endif
@@ -27,8 +32,35 @@ typedef int socklen_t;
 extern CEvents        * g_pEvents;
 extern CPlayerManager * g_pPlayerManager;
 
+// The query type of each reply
+static const char g_cQueryTypes[QUERY_REPLY_MAX] = { 'i', 'p', 'l', 'r', 'v' };
+
+// Read in every tick so it is only looked up once
+static CSettingHandle g_frequentEventsSetting("frequentevents");
+
 CQuery::CQuery(unsigned short usPort, String strHostAddress)
 {
+	m_uiCacheInterval = CVAR_GET_INTEGER("querycacheinterval");
+	memset(m_bReplyValid, 0, sizeof(m_bReplyValid));
+	memset(m_ulReplyTime, 0, sizeof(m_ulReplyTime));
+	m_snapshots[0].bScriptQueries = false;
+	m_snapshots[1].bScriptQueries = false;
+	m_pSnapshot = &m_snapshots[0];
+	m_bStopping = false;
+	m_uiRateLimit = CVAR_GET_INTEGER("queryratelimit");
+	m_uiMaxPacketsPerSecond = CVAR_GET_INTEGER("querypacketspersecond");
+	m_uiPackets = 0;
+	m_ulPacketsTime = SharedUtility::GetTime();
+	m_ulLastBucketCleanup = m_ulPacketsTime;
+
+	// The info reply is built from these settings
+	CSettings::AddChangeHandler("hostname", OnInfoSettingChanged, this);
+	CSettings::AddChangeHandler("maxplayers", OnInfoSettingChanged, this);
+	CSettings::AddChangeHandler("password", OnInfoSettingChanged, this);
+
+	// The tokens only have to be unpredictable to hosts that don't get the challenges
+	m_uiChallengeSecret = ((unsigned int)time(NULL) ^ ((unsigned int)SharedUtility::GetTime() * 0x9E3779B9) ^ (unsigned int)(size_t)this);
+
 	// If windows startup winsock
 #ifdef WIN32
 	WSADATA wsaData;
@@ -50,7 +82,7 @@ CQuery::CQuery(unsigned short usPort, String strHostAddress)
 
 	// TODO: ERROR CHECKING
 
-	// Set the socket to non blocking
+	// Set the socket to non blocking, the query thread waits for packets with select
 #ifdef WIN32
 	unsigned long sockopt = 1;
 	ioctlsocket (m_iSocket, FIONBIO, &sockopt);
@@ -60,11 +92,32 @@ CQuery::CQuery(unsigned short usPort, String strHostAddress)
 
 	// Bind the socket to the address
 	if(bind(m_iSocket, (sockaddr *)&addr, sizeof(sockaddr_in)) == -1)
+	{
 		CLogFile::Printf("Failed to bind query port %d. Server will not respond to queries.\n", (usPort + QUERY_PORT_OFFSET));
+		return;
+	}
+
+	// Start the query thread
+	m_thread.SetUserData<CQuery *>(this);
+	m_thread.Start(QueryThread);
 }
 
 CQuery::~CQuery()
 {
+	CSettings::RemoveChangeHandler("hostname", OnInfoSettingChanged, this);
+	CSettings::RemoveChangeHandler("maxplayers", OnInfoSettingChanged, this);
+	CSettings::RemoveChangeHandler("password", OnInfoSettingChanged, this);
+
+	// Let the query thread finish the query it is handling
+	m_mutex.Lock();
+	m_bStopping = true;
+	m_mutex.Unlock();
+
+	while(m_thread.IsRunning())
+		Sleep(1);
+
+	m_thread.Stop();
+
 	if(m_iSocket != -1)
 		closesocket(m_iSocket);
 
@@ -74,208 +127,479 @@ CQuery::~CQuery()
 #endif
 }
 
-// TODO: Flood protection
-void CQuery::Process()
+bool CQuery::TakeToken(unsigned long ulAddress, unsigned long ulTime)
 {
-	// Do we have a valid socket?
-	if(m_iSocket != -1)
+	if(m_uiRateLimit == 0)
+		return true;
+
+	unsigned int uiMaxTokens = (m_uiRateLimit * QUERY_RATE_BURST_TIME);
+	std::map<unsigned long, QueryBucket>::iterator iter = m_buckets.find(ulAddress);
+
+	if(iter == m_buckets.end())
+	{
+		if(m_buckets.size() >= QUERY_MAX_BUCKETS)
+			return false;
+
+		QueryBucket bucket;
+		bucket.uiTokens = uiMaxTokens;
+		bucket.ulLastTime = ulTime;
+		iter = m_buckets.insert(std::make_pair(ulAddress, bucket)).first;
+	}
+
+	// Add the tokens for the time since the last query
+	QueryBucket * pBucket = &iter->second;
+	unsigned long ulElapsed = (ulTime - pBucket->ulLastTime);
+	pBucket->ulLastTime = ulTime;
+
+	if(ulElapsed >= QUERY_RATE_BURST_TIME)
+		pBucket->uiTokens = uiMaxTokens;
+	else
+		pBucket->uiTokens = std::min(uiMaxTokens, (unsigned int)(pBucket->uiTokens + (ulElapsed * m_uiRateLimit)));
+
+	if(pBucket->uiTokens < 1000)
+		return false;
+
+	pBucket->uiTokens -= 1000;
+	return true;
+}
+
+void CQuery::RemoveFullBuckets(unsigned long ulTime)
+{
+	if(m_uiRateLimit == 0)
+		return;
+
+	// A bucket that would be full again is the same as no bucket
+	for(std::map<unsigned long, QueryBucket>::iterator iter = m_buckets.begin(); iter != m_buckets.end(); )
+	{
+		if((ulTime - iter->second.ulLastTime) >= QUERY_RATE_BURST_TIME)
+			m_buckets.erase(iter++);
+		else
+			iter++;
+	}
+}
+
+unsigned int CQuery::GetChallengeToken(unsigned long ulAddress, unsigned long ulTime)
+{
+	// Mix the address with the secret and the current token period
+	unsigned int uiHash = ((unsigned int)ulAddress ^ m_uiChallengeSecret);
+	uiHash ^= ((unsigned int)(ulTime / QUERY_CHALLENGE_LIFETIME) * 0x9E3779B9);
+	uiHash ^= (uiHash >> 16);
+	uiHash *= 0x85EBCA6B;
+	uiHash ^= (uiHash >> 13);
+	uiHash *= 0xC2B2AE35;
+	uiHash ^= (uiHash >> 16);
+	return uiHash;
+}
+
+bool CQuery::IsChallengeTokenValid(unsigned long ulAddress, unsigned int uiToken, unsigned long ulTime)
+{
+	// The token of the last period is valid as well so a token is valid for at least a full period
+	return (uiToken == GetChallengeToken(ulAddress, ulTime) || uiToken == GetChallengeToken(ulAddress, (ulTime - QUERY_CHALLENGE_LIFETIME)));
+}
+
+void CQuery::QueryThread(CThread * pCreator)
+{
+	CQuery * pQuery = pCreator->GetUserData<CQuery *>();
+
+	while(true)
+	{
+		pQuery->m_mutex.Lock();
+		bool bStopping = pQuery->m_bStopping;
+		pQuery->m_mutex.Unlock();
+
+		if(bStopping)
+			break;
+
+		// Wait for packets (or until we have to check if we are stopping)
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(pQuery->m_iSocket, &readSet);
+		timeval tv;
+		tv.tv_sec = 0;
+		tv.tv_usec = (QUERY_THREAD_WAIT_TIME * 1000);
+
+		if(select((pQuery->m_iSocket + 1), &readSet, NULL, NULL, &tv) > 0)
+			pQuery->ReceiveQueries();
+	}
+}
+
+void CQuery::ReceiveQueries()
+{
+	// Reset the buffer
+	static char szBuffer[1024];
+
+	// Create the address
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	int iFromLen = sizeof(sockaddr_in);
+
+	// Read everything that is in the socket buffer
+	int iBytesRead = -1;
+
+	while((iBytesRead = recvfrom(m_iSocket, szBuffer, sizeof(szBuffer), NULL, (sockaddr *)&addr, (socklen_t *)&iFromLen)) != -1)
 	{
-		// Reset the buffer
-		static char szBuffer[1024];
-		memset(szBuffer, 0, sizeof(szBuffer));
+		unsigned long ulTime = SharedUtility::GetTime();
 
-		// Create the address
-		sockaddr_in addr;
-		memset(&addr, 0, sizeof(sockaddr_in));
-		int iFromLen = sizeof(sockaddr_in);
+		if((ulTime - m_ulLastBucketCleanup) >= QUERY_BUCKET_CLEANUP_INTERVAL)
+		{
+			RemoveFullBuckets(ulTime);
+			m_ulLastBucketCleanup = ulTime;
+		}
 
-		// Attempt to read data from the socket
-		int iBytesRead = -1;
+		// Are we over the packet limit? The packets that arrive until the
+		// next second wait in the socket buffer (or are dropped once it is full)
+		if((ulTime - m_ulPacketsTime) >= 1000)
+		{
+			m_uiPackets = 0;
+			m_ulPacketsTime = ulTime;
+		}
 
-		while((iBytesRead = recvfrom(m_iSocket, szBuffer, sizeof(szBuffer), NULL, (sockaddr *)&addr, (socklen_t *)&iFromLen)) != -1)
+		if(m_uiMaxPacketsPerSecond > 0 && ++m_uiPackets > m_uiMaxPacketsPerSecond)
 		{
-			// Convert the ip address to a string
-			char szIpAddress[64];
-			SharedUtility::inet_ntop(addr.sin_family, &addr.sin_addr, szIpAddress, sizeof(szIpAddress));
+			Sleep(1000 - std::min((ulTime - m_ulPacketsTime), (unsigned long)1000));
+			continue;
+		}
 
-			// Get the port
-			unsigned short usPort = ntohs(addr.sin_port);
+		// Drop the query if the address sent too many
+		if(!TakeToken(addr.sin_addr.s_addr, ulTime))
+			continue;
 
-			// Create a bit stream from the data
-			CBitStream bitStream((unsigned char *)szBuffer, iBytesRead, true);
+		HandleQuery((unsigned char *)szBuffer, iBytesRead, &addr);
+	}
+}
 
-			// Read the first 4 bytes
-			char szIdentifier[4];
+void CQuery::HandleQuery(unsigned char * pData, unsigned int uiSize, sockaddr_in * pAddress)
+{
+	// Create a bit stream from the data
+	CBitStream bitStream(pData, uiSize, false);
 
-			if(!bitStream.Read(szIdentifier, sizeof(szIdentifier)))
-				continue;
+	// Read the first 4 bytes
+	char szIdentifier[4];
 
-			// Ensure the first 4 bytes are 'IVMP'
-			if(szIdentifier[0] != 'I' || szIdentifier[1] != 'V' || szIdentifier[2] != 'M' || szIdentifier[3] != 'P')
-				continue;
+	if(!bitStream.Read(szIdentifier, sizeof(szIdentifier)))
+		return;
 
-			// Create the reply bit stream
-			CBitStream reply;
+	// Ensure the first 4 bytes are 'IVMP'
+	if(szIdentifier[0] != 'I' || szIdentifier[1] != 'V' || szIdentifier[2] != 'M' || szIdentifier[3] != 'P')
+		return;
 
-			// Are frequent events enabled?
-			if(CVAR_GET_BOOL("frequentevents"))
-			{
-				// Create the arguments
-				CSquirrelArguments pArguments;
-				pArguments.push(szIpAddress);
-				pArguments.push(usPort - QUERY_PORT_OFFSET);
-				pArguments.push(String((char *)bitStream.GetData()));
-				pArguments.push((int)bitStream.GetNumberOfBytesUsed());
-
-				// Call the 'serverQueryReceived' event
-				CSquirrelArgument result = g_pEvents->Call("serverQueryReceived", &pArguments);
-
-				// Was the query refused?
-				if((result.GetType() == OT_INTEGER && result.GetInteger() == 0) || (result.GetType() == OT_STRING && strlen(result.GetString()) == 0))
-				{
-					// A script refused the query
-					continue;
-				}
+	// Are frequent events enabled? The scripts can only be called from the game thread
+	m_mutex.Lock();
 
-				// Was a string returned?
-				if(result.GetType() == OT_STRING)
-				{
-					// Write the string to the reply
-					reply.Write(result.GetString(), strlen(result.GetString()));
-				}
-			}
+	if(m_pSnapshot->bScriptQueries)
+	{
+		if(m_scriptQueries.size() < QUERY_MAX_SCRIPT_QUERIES)
+		{
+			m_scriptQueries.push_back(QueryPacket());
+			QueryPacket * pPacket = &m_scriptQueries.back();
+			pPacket->ulAddress = pAddress->sin_addr.s_addr;
+			pPacket->usPort = pAddress->sin_port;
+			pPacket->data.assign(pData, (pData + uiSize));
+
+			// The event gets the query as a string as well
+			pPacket->data.push_back(0);
+		}
 
-			// Do we not have a reply from the script?
-			if(reply.GetNumberOfBytesUsed() == 0)
-			{
-				// Read the query type
-				char cQueryType;
+		m_mutex.Unlock();
+		return;
+	}
 
-				if(!bitStream.Read(cQueryType))
-					continue;
+	m_mutex.Unlock();
+	SendReply(&bitStream, pAddress, NULL);
+}
 
-				// Process the query
-				if(cQueryType == 'i') // Server Information
-				{
-					// Write 'IVMP' and the query type
-					reply.Write(szIdentifier, sizeof(szIdentifier));
-					reply.Write(cQueryType);
+void CQuery::SendReply(CBitStream * pQuery, sockaddr_in * pAddress, CBitStream * pReplies)
+{
+	// Read the query type
+	char cQueryType;
 
-					// Write the host name
-					reply.Write(CVAR_GET_STRING("hostname"));
+	if(!pQuery->Read(cQueryType))
+		return;
 
-					// Write the player count
-					reply.Write((int)g_pPlayerManager->GetPlayerCount());
+	// Find the reply of the query type
+	int iReply = 0;
 
-					// Write the max player limit
-					reply.Write(CVAR_GET_INTEGER("maxplayers"));
+	while(iReply < QUERY_REPLY_MAX && g_cQueryTypes[iReply] != cQueryType)
+		iReply++;
 
-					// Write if the server is passworded or not
-					reply.Write((CVAR_GET_STRING("password").IsEmpty() ? 0 : 1));
-				}
-				else if(cQueryType == 'p') // Ping
-				{
-					// Write 'IVMP' and the query type
-					reply.Write(szIdentifier, sizeof(szIdentifier));
-					reply.Write(cQueryType);
+	if(iReply == QUERY_REPLY_MAX)
+		return;
 
-					// Write a 'PONG' string
-					reply.Write("PONG");
-				}
-				else if(cQueryType == 'l') // Player List
-				{
-					// Write 'IVMP' and the query type
-					reply.Write(szIdentifier, sizeof(szIdentifier));
-					reply.Write(cQueryType);
-
-					// Write the player count
-					reply.Write(g_pPlayerManager->GetPlayerCount());
-
-					// Loop through all players
-					for(int x = (MAX_PLAYERS - 1); x >= 0; x--)
-					{
-						// Check if the current player is connected
-						if(g_pPlayerManager->DoesExist(x))
-						{	
-							CPlayer * pPlayer = g_pPlayerManager->GetAt(x);
-
-							if(pPlayer)
-							{
-								// Write the player id
-								reply.Write(x);
-
-								// Write the name
-								reply.Write(pPlayer->GetName());
-
-								// Write the player ping
-								reply.Write(pPlayer->GetPing());
-
-								// Get the players vehicle
-								CVehicle * pVehicle = pPlayer->GetVehicle();
-
-								// Is in the player in a vehicle?
-								if(pVehicle)
-									reply.Write(pVehicle->GetVehicleId());
-								else
-									reply.Write((EntityId)INVALID_ENTITY_ID);
-
-								// Write the player weapon
-								reply.Write(pPlayer->GetWeapon());
-							}
-						}
-					}
-				}
-				else if(cQueryType == 'r') // Rule List
-				{
-					// Write 'IVMP' and the query type
-					reply.Write(szIdentifier, sizeof(szIdentifier));
-					reply.Write(cQueryType);
+	// The game thread passes its replies, the query thread copies the reply
+	// out of the snapshot so the game thread can publish the next one
+	CBitStream * pReply = &pReplies[iReply];
 
-					// Write the rules count
-					reply.Write(m_rules.size());
+	if(!pReplies)
+	{
+		m_threadReply.Reset();
+		m_mutex.Lock();
+		CBitStream * pSnapshotReply = &m_pSnapshot->replies[iReply];
+		m_threadReply.Write((char *)pSnapshotReply->GetData(), pSnapshotReply->GetNumberOfBytesUsed());
+		m_mutex.Unlock();
+		pReply = &m_threadReply;
+	}
 
-					// Loop through all rules
-					for(std::list<QueryRule *>::iterator iter = m_rules.begin(); iter != m_rules.end(); iter++)
-					{
-						// Get the rule pointer
-						QueryRule * pRule = (*iter);
+	// Nothing was published yet
+	if(pReply->GetNumberOfBytesUsed() == 0)
+		return;
 
-						// Write the rule
-						reply.Write(pRule->strRule);
+	// Large replies are only sent to addresses that proved they receive
+	// what we send them, the others get a token to send the query again with
+	unsigned long ulTime = SharedUtility::GetTime();
+	unsigned int uiToken;
+	CBitStream challenge;
 
-						// Write the rule value
-						reply.Write(pRule->strValue);
-					}
-				}
-				else if(cQueryType == 'v') // Version
+	if(pReply->GetNumberOfBytesUsed() > QUERY_CHALLENGE_MIN_REPLY_SIZE &&
+		(!pQuery->Read(uiToken) || !IsChallengeTokenValid(pAddress->sin_addr.s_addr, uiToken, ulTime)))
+	{
+		challenge.Write("IVMP", 4);
+		challenge.Write('c');
+		challenge.Write(cQueryType);
+		challenge.Write(GetChallengeToken(pAddress->sin_addr.s_addr, ulTime));
+		pReply = &challenge;
+	}
+
+	// Send the reply
+	if(sendto(m_iSocket, (char *)pReply->GetData(), pReply->GetNumberOfBytesUsed(), NULL, (sockaddr *)pAddress, sizeof(sockaddr_in)) != pReply->GetNumberOfBytesUsed())
+	{
+		// Sending failed
+		// TODO: When flood protection is done, enable this
+		//LogPrintf("Warning: Failed to send query response.");
+	}
+}
+
+void CQuery::HandleScriptQuery(QueryPacket * pPacket)
+{
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(sockaddr_in));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = pPacket->ulAddress;
+	addr.sin_port = pPacket->usPort;
+
+	// Convert the ip address to a string
+	char szIpAddress[64];
+	SharedUtility::inet_ntop(addr.sin_family, &addr.sin_addr, szIpAddress, sizeof(szIpAddress));
+
+	// Get the port
+	unsigned short usPort = ntohs(addr.sin_port);
+
+	// Create a bit stream from the data, the identifier was checked by the query thread
+	CBitStream bitStream(&pPacket->data[0], (pPacket->data.size() - 1), false);
+	bitStream.IgnoreBytes(4);
+
+	// Create the arguments
+	CSquirrelArguments pArguments;
+	pArguments.push(szIpAddress);
+	pArguments.push(usPort - QUERY_PORT_OFFSET);
+	pArguments.push(String((char *)bitStream.GetData()));
+	pArguments.push((int)bitStream.GetNumberOfBytesUsed());
+
+	// Call the 'serverQueryReceived' event
+	CSquirrelArgument result = g_pEvents->Call("serverQueryReceived", &pArguments);
+
+	// Was the query refused?
+	if((result.GetType() == OT_INTEGER && result.GetInteger() == 0) || (result.GetType() == OT_STRING && strlen(result.GetString()) == 0))
+	{
+		// A script refused the query
+		return;
+	}
+
+	// Was a string returned?
+	if(result.GetType() == OT_STRING)
+	{
+		// Send the string as the reply
+		sendto(m_iSocket, result.GetString(), strlen(result.GetString()), NULL, (sockaddr *)&addr, sizeof(sockaddr_in));
+		return;
+	}
+
+	SendReply(&bitStream, &addr, m_replies);
+}
+
+bool CQuery::UpdateReplies()
+{
+	// The pings, vehicles and weapons in the player list change all the time so a
+	// reply is also built again once it is older than the cache interval
+	unsigned long ulTime = SharedUtility::GetTime();
+	bool bChanged = false;
+
+	for(int i = 0; i < QUERY_REPLY_MAX; i++)
+	{
+		if(!m_bReplyValid[i] || (ulTime - m_ulReplyTime[i]) >= m_uiCacheInterval)
+		{
+			BuildReply((eQueryReply)i, &m_replies[i]);
+			m_bReplyValid[i] = true;
+			m_ulReplyTime[i] = ulTime;
+			bChanged = true;
+		}
+	}
+
+	return bChanged;
+}
+
+void CQuery::Publish()
+{
+	// Fill the snapshot the query thread doesn't read
+	QuerySnapshot * pSnapshot = ((m_pSnapshot == &m_snapshots[0]) ? &m_snapshots[1] : &m_snapshots[0]);
+
+	for(int i = 0; i < QUERY_REPLY_MAX; i++)
+	{
+		pSnapshot->replies[i].Reset();
+		pSnapshot->replies[i].Write((char *)m_replies[i].GetData(), m_replies[i].GetNumberOfBytesUsed());
+	}
+
+	pSnapshot->bScriptQueries = g_frequentEventsSetting.GetBool();
+
+	// Swap the snapshots
+	m_mutex.Lock();
+	m_pSnapshot = pSnapshot;
+	m_mutex.Unlock();
+}
+
+void CQuery::Process()
+{
+	// Do we have a valid socket?
+	if(m_iSocket == -1)
+		return;
+
+	bool bScriptQueries = g_frequentEventsSetting.GetBool();
+
+	if(UpdateReplies() || bScriptQueries != m_pSnapshot->bScriptQueries)
+		Publish();
+
+	// Call the events of the queries that came in since the last tick
+	m_mutex.Lock();
+
+	if(m_scriptQueries.empty())
+	{
+		m_mutex.Unlock();
+		return;
+	}
+
+	std::list<QueryPacket> scriptQueries;
+	scriptQueries.swap(m_scriptQueries);
+	m_mutex.Unlock();
+
+	for(std::list<QueryPacket>::iterator iter = scriptQueries.begin(); iter != scriptQueries.end(); iter++)
+		HandleScriptQuery(&(*iter));
+}
+
+void CQuery::BuildReply(eQueryReply reply, CBitStream * pBitStream)
+{
+	// Write 'IVMP' and the query type
+	pBitStream->Reset();
+	pBitStream->Write("IVMP", 4);
+	pBitStream->Write(g_cQueryTypes[reply]);
+
+	switch(reply)
+	{
+	case QUERY_REPLY_INFO: // Server Information
+		{
+			// Write the host name
+			pBitStream->Write(CVAR_GET_STRING("hostname"));
+
+			// Write the player count
+			pBitStream->Write((int)g_pPlayerManager->GetPlayerCount());
+
+			// Write the max player limit
+			pBitStream->Write(CVAR_GET_INTEGER("maxplayers"));
+
+			// Write if the server is passworded or not
+			pBitStream->Write((CVAR_GET_STRING("password").IsEmpty() ? 0 : 1));
+		}
+		break;
+	case QUERY_REPLY_PING: // Ping
+		{
+			// Write a 'PONG' string
+			pBitStream->Write("PONG");
+		}
+		break;
+	case QUERY_REPLY_PLAYERS: // Player List
+		{
+			// Write the player count
+			pBitStream->Write(g_pPlayerManager->GetPlayerCount());
+
+			// Loop through all players
+			const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+			for(size_t i = players.size(); i > 0; i--)
+			{
+				int x = players[i - 1];
+
+				CPlayer * pPlayer = g_pPlayerManager->GetAt(x);
+
+				if(pPlayer)
 				{
-					// Write 'IVMP' and the query type
-					reply.Write(szIdentifier, sizeof(szIdentifier));
-					reply.Write(cQueryType);
+					// Write the player id
+					pBitStream->Write(x);
+
+					// Write the name
+					pBitStream->Write(pPlayer->GetName());
+
+					// Write the player ping
+					pBitStream->Write(pPlayer->GetPing());
 
-					// Get the version string
-					String strVersion(VERSION_IDENTIFIER);
+					// Get the players vehicle
+					CVehicle * pVehicle = pPlayer->GetVehicle();
 
-					// Write the version string
-					reply.Write(strVersion);
+					// Is in the player in a vehicle?
+					if(pVehicle)
+						pBitStream->Write(pVehicle->GetVehicleId());
+					else
+						pBitStream->Write((EntityId)INVALID_ENTITY_ID);
+
+					// Write the player weapon
+					pBitStream->Write(pPlayer->GetWeapon());
 				}
 			}
+		}
+		break;
+	case QUERY_REPLY_RULES: // Rule List
+		{
+			// Write the rules count
+			pBitStream->Write(m_rules.size());
 
-			// Do we have a reply to send?
-			if(reply.GetNumberOfBytesUsed() > 0)
+			// Loop through all rules
+			for(std::list<QueryRule *>::iterator iter = m_rules.begin(); iter != m_rules.end(); iter++)
 			{
-				// Send the reply
-				if(sendto(m_iSocket, (char *)reply.GetData(), reply.GetNumberOfBytesUsed(), NULL, (sockaddr *)&addr, sizeof(sockaddr_in)) != reply.GetNumberOfBytesUsed())
-				{
-					// Sending failed
-					// TODO: When flood protection is done, enable this
-					//LogPrintf("Warning: Failed to send query response.");
-				}
+				// Get the rule pointer
+				QueryRule * pRule = (*iter);
+
+				// Write the rule
+				pBitStream->Write(pRule->strRule);
+
+				// Write the rule value
+				pBitStream->Write(pRule->strValue);
 			}
 		}
+		break;
+	case QUERY_REPLY_VERSION: // Version
+		{
+			// Get the version string
+			String strVersion(VERSION_IDENTIFIER);
+
+			// Write the version string
+			pBitStream->Write(strVersion);
+		}
+		break;
 	}
 }
 
+void CQuery::InvalidatePlayers()
+{
+	m_bReplyValid[QUERY_REPLY_INFO] = false;
+	m_bReplyValid[QUERY_REPLY_PLAYERS] = false;
+}
+
+void CQuery::InvalidateInfo()
+{
+	m_bReplyValid[QUERY_REPLY_INFO] = false;
+}
+
+void CQuery::OnInfoSettingChanged(const String& strSetting, void * pUserData)
+{
+	((CQuery *)pUserData)->InvalidateInfo();
+}
+
 bool CQuery::DoesRuleExist(String strRule)
 {
 	// Loop through all rules
@@ -321,6 +645,7 @@ bool CQuery::AddRule(String strRule, String strValue)
 
 	// Add it to the rule list
 	m_rules.push_back(pRule);
+	m_bReplyValid[QUERY_REPLY_RULES] = false;
 	return true;
 }
 
@@ -333,9 +658,10 @@ bool CQuery::RemoveRule(String strRule)
 	if(!pRule)
 		return false;
 
-	// Delete the rule and remove it from the rule list
-	SAFE_DELETE(pRule);
+	// Remove the rule from the rule list and delete it
 	m_rules.remove(pRule);
+	SAFE_DELETE(pRule);
+	m_bReplyValid[QUERY_REPLY_RULES] = false;
 	return true;
 }
 
@@ -350,6 +676,7 @@ bool CQuery::SetRule(String strRule, String strValue)
 
 	// Set the rule value
 	pRule->strValue = strValue;
+	m_bReplyValid[QUERY_REPLY_RULES] = false;
 	return true;
 }
 
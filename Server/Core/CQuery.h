@@ -10,7 +10,46 @@
 #pragma once
 
 #include <CString.h>
+#include <Network/CBitStream.h>
+#include <Threading/CThread.h>
+#include <Threading/CMutex.h>
 #include <list>
+#include <map>
+#include <vector>
+
+// Replies larger than this need a challenge token so the query port can't be
+// used to send large replies to spoofed addresses
+#define QUERY_CHALLENGE_MIN_REPLY_SIZE 128
+
+// Time in ms a challenge token is valid for (at least)
+#define QUERY_CHALLENGE_LIFETIME 30000
+
+// Time in ms worth of queries an address can send at once
+#define QUERY_RATE_BURST_TIME 2000
+
+// Time in ms between two removals of the rate limiter buckets that are full again
+#define QUERY_BUCKET_CLEANUP_INTERVAL 10000
+
+// Maximum amount of addresses the rate limiter tracks, queries of other
+// addresses are dropped while it is full
+#define QUERY_MAX_BUCKETS 65536
+
+// Time in ms the query thread waits for packets before it checks if it has to stop
+#define QUERY_THREAD_WAIT_TIME 100
+
+// Maximum amount of queries waiting for the serverQueryReceived event
+#define QUERY_MAX_SCRIPT_QUERIES 256
+
+// The queries whose replies are cached
+enum eQueryReply
+{
+	QUERY_REPLY_INFO,
+	QUERY_REPLY_PING,
+	QUERY_REPLY_PLAYERS,
+	QUERY_REPLY_RULES,
+	QUERY_REPLY_VERSION,
+	QUERY_REPLY_MAX
+};
 
 struct QueryRule
 {
@@ -18,16 +57,82 @@ struct QueryRule
 	String strValue;
 };
 
+// Token bucket of an address, the tokens are in thousandths of a query
+struct QueryBucket
+{
+	unsigned int  uiTokens;
+	unsigned long ulLastTime;
+};
+
+// The replies the query thread sends, published by the game thread
+struct QuerySnapshot
+{
+	CBitStream    replies[QUERY_REPLY_MAX];
+	bool          bScriptQueries; // Queries go to the serverQueryReceived event on the game thread
+};
+
+// A query the query thread passed to the game thread, the address and port are in network order
+struct QueryPacket
+{
+	unsigned long              ulAddress;
+	unsigned short             usPort;
+	std::vector<unsigned char> data;
+};
+
+struct sockaddr_in;
+
+// Answers the queries on a thread that waits on the query socket. The game
+// thread builds the replies and publishes them each tick by swapping the
+// snapshot the query thread reads, so queries never wait for the tick and
+// the tick never waits for queries.
 class CQuery
 {
 private:
 	int                    m_iSocket;
+	unsigned int           m_uiChallengeSecret;
+
+	// Only used by the game thread
 	std::list<QueryRule *> m_rules;
+	unsigned int           m_uiCacheInterval;
+	CBitStream             m_replies[QUERY_REPLY_MAX];
+	bool                   m_bReplyValid[QUERY_REPLY_MAX];
+	unsigned long          m_ulReplyTime[QUERY_REPLY_MAX];
+	QuerySnapshot          m_snapshots[2];
+
+	// Only used by the query thread
+	CThread                m_thread;
+	unsigned int           m_uiRateLimit;
+	unsigned int           m_uiMaxPacketsPerSecond;
+	unsigned int           m_uiPackets;
+	unsigned long          m_ulPacketsTime;
+	std::map<unsigned long, QueryBucket> m_buckets;
+	unsigned long          m_ulLastBucketCleanup;
+	CBitStream             m_threadReply;
+
+	CMutex                 m_mutex; // Mutex for m_pSnapshot, m_scriptQueries and m_bStopping
+	QuerySnapshot *        m_pSnapshot;
+	std::list<QueryPacket> m_scriptQueries;
+	bool                   m_bStopping;
+
+	static void  QueryThread(CThread * pCreator);
+	static void  OnInfoSettingChanged(const String& strSetting, void * pUserData);
+	void         ReceiveQueries();
+	void         HandleQuery(unsigned char * pData, unsigned int uiSize, sockaddr_in * pAddress);
+	void         SendReply(CBitStream * pQuery, sockaddr_in * pAddress, CBitStream * pReplies);
+	void         HandleScriptQuery(QueryPacket * pPacket);
+	void         BuildReply(eQueryReply reply, CBitStream * pBitStream);
+	bool         UpdateReplies();
+	void         Publish();
+	bool         TakeToken(unsigned long ulAddress, unsigned long ulTime);
+	void         RemoveFullBuckets(unsigned long ulTime);
+	unsigned int GetChallengeToken(unsigned long ulAddress, unsigned long ulTime);
+	bool         IsChallengeTokenValid(unsigned long ulAddress, unsigned int uiToken, unsigned long ulTime);
 
 public:
 	CQuery(unsigned short usPort, String strHostAddress);
 	~CQuery();
 
+	// Publishes the replies and calls the serverQueryReceived events, called every tick
 	void        Process();
 	QueryRule * GetRule(String strRule);
 	bool        DoesRuleExist(String strRule);
@@ -35,4 +140,9 @@ public:
 	bool        RemoveRule(String strRule);
 	bool        SetRule(String strRule, String strValue);
 	String      GetRuleValue(String strRule);
+
+	// Called when the player list or the server information changed so the
+	// cached replies are built again with the next query
+	void        InvalidatePlayers();
+	void        InvalidateInfo();
 };
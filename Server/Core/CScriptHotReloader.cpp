@@ -0,0 +1,117 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptHotReloader.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CScriptHotReloader.h"
+#include <Scripting/CScriptingManager.h>
+#include <CLogFile.h>
+
+extern CScriptingManager * g_pScriptingManager;
+extern CJobSystem * g_pJobSystem;
+
+CScriptHotReloader::CScriptHotReloader()
+{
+
+}
+
+CScriptHotReloader::~CScriptHotReloader()
+{
+	// The compile jobs still use the reloads
+	for(std::list<Reload *>::iterator iter = m_reloads.begin(); iter != m_reloads.end(); ++iter)
+	{
+		g_pJobSystem->Wait(&(*iter)->counter);
+		delete (*iter);
+	}
+}
+
+void CScriptHotReloader::CompileJob(void * pUserData)
+{
+	CSquirrel::Compile(&((Reload *)pUserData)->compiledScript);
+}
+
+bool CScriptHotReloader::Start(String strName)
+{
+	CSquirrel * pScript = g_pScriptingManager->Get(strName);
+
+	if(!pScript || IsReloading(strName))
+		return false;
+
+	Reload * pReload = new Reload;
+	pReload->strName = strName;
+	pReload->compiledScript.strPath = pScript->GetPath();
+	m_reloads.push_back(pReload);
+	g_pJobSystem->Add(CompileJob, pReload, &pReload->counter);
+	return true;
+}
+
+bool CScriptHotReloader::IsReloading(String strName)
+{
+	for(std::list<Reload *>::iterator iter = m_reloads.begin(); iter != m_reloads.end(); ++iter)
+	{
+		if((*iter)->strName == strName)
+			return true;
+	}
+
+	return false;
+}
+
+void CScriptHotReloader::Finish(Reload * pReload)
+{
+	// The script was unloaded while it compiled
+	CSquirrel * pScript = g_pScriptingManager->Get(pReload->strName);
+
+	if(!pScript)
+		return;
+
+	const SquirrelCompiledScript& compiledScript = pReload->compiledScript;
+
+	if(!compiledScript.bCompiled)
+	{
+		if(compiledScript.strError.IsNotEmpty())
+			CLogFile::Printf("Failed to hot reload script %s (%s on line %d column %d).", pReload->strName.Get(), compiledScript.strError.Get(), compiledScript.iErrorLine, compiledScript.iErrorColumn);
+		else
+			CLogFile::Printf("Failed to hot reload script %s (Script does not exist/Script compilation failed).", pReload->strName.Get());
+
+		return;
+	}
+
+	CSquirrelArgument state;
+
+	if(!pScript->GetPersistentState(state))
+	{
+		CLogFile::Printf("Failed to hot reload script %s (The persistent state has values that can't be copied).", pReload->strName.Get());
+		return;
+	}
+
+	if(!g_pScriptingManager->Reload(pScript, &compiledScript, &state))
+	{
+		CLogFile::Printf("Failed to hot reload script %s (The new version failed to run, the old version keeps running).", pReload->strName.Get());
+		return;
+	}
+
+	CLogFile::Printf("Hot reloaded script %s.", pReload->strName.Get());
+}
+
+void CScriptHotReloader::Process()
+{
+	for(std::list<Reload *>::iterator iter = m_reloads.begin(); iter != m_reloads.end(); )
+	{
+		Reload * pReload = (*iter);
+
+		if(!pReload->counter.IsDone())
+		{
+			++iter;
+			continue;
+		}
+
+		// Removed first as the scripts can start new reloads while this one is finished
+		iter = m_reloads.erase(iter);
+		Finish(pReload);
+		delete pReload;
+	}
+}
@@ -0,0 +1,46 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptHotReloader.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <CString.h>
+#include <Threading/CJobSystem.h>
+#include <Scripting/CSquirrel.h>
+
+// Replaces loaded scripts with their new version without unloading anything else.
+// The new version is compiled on the job system while the old one keeps running,
+// once it compiled it is executed with the persistent state of the old version
+// (getPersistentState) and takes over its events within the same tick.
+class CScriptHotReloader
+{
+private:
+	struct Reload
+	{
+		String                 strName;
+		SquirrelCompiledScript compiledScript;
+		CJobCounter            counter;
+	};
+
+	std::list<Reload *> m_reloads;
+
+	static void CompileJob(void * pUserData);
+	void        Finish(Reload * pReload);
+
+public:
+	CScriptHotReloader();
+	~CScriptHotReloader();
+
+	// Returns false if the script isn't loaded or is already being reloaded
+	bool        Start(String strName);
+	bool        IsReloading(String strName);
+
+	// Switches to the new versions that finished compiling
+	void        Process();
+};
@@ -0,0 +1,176 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CServerMetrics.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CServerMetrics.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include "CVehicleManager.h"
+#include "CObjectManager.h"
+#include "CBlipManager.h"
+#include "CActorManager.h"
+#include "CCheckpointManager.h"
+#include "CPickupManager.h"
+#include "CTickScheduler.h"
+#include <CSettings.h>
+#include <CMemoryTracker.h>
+#include <Network/CNetworkModule.h>
+#include <SharedUtility.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CVehicleManager * g_pVehicleManager;
+extern CObjectManager * g_pObjectManager;
+extern CBlipManager * g_pBlipManager;
+extern CActorManager * g_pActorManager;
+extern CCheckpointManager * g_pCheckpointManager;
+extern CPickupManager * g_pPickupManager;
+extern CTickScheduler * g_pTickScheduler;
+
+static const char * g_szEntityNames[SERVER_METRICS_ENTITY_MAX] =
+{
+	"players",
+	"vehicles",
+	"objects",
+	"blips",
+	"actors",
+	"checkpoints",
+	"pickups"
+};
+
+// Upper bounds in seconds of the tick duration buckets
+static const double g_dTickDurationBounds[] = { 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25 };
+
+CServerMetrics::CServerMetrics()
+{
+	m_bEnabled = CVAR_GET_BOOL("metrics");
+	m_ulLastUpdateTime = 0;
+	m_rpcsReceived = m_registry.AddCounter("ivmp_rpcs_received_total", "Rpcs received from the players.", "rpc", SERVER_METRICS_MAX_RPCS);
+	m_rpcBytesReceived = m_registry.AddCounter("ivmp_rpc_bytes_received_total", "Bytes of the rpcs received from the players.", "rpc", SERVER_METRICS_MAX_RPCS);
+	m_rpcsSent = m_registry.AddCounter("ivmp_rpcs_sent_total", "Rpcs sent to the players (a broadcast counts once).", "rpc", SERVER_METRICS_MAX_RPCS);
+	m_rpcBytesSent = m_registry.AddCounter("ivmp_rpc_bytes_sent_total", "Bytes of the rpcs sent to the players (a broadcast counts once).", "rpc", SERVER_METRICS_MAX_RPCS);
+	m_playerPing = m_registry.AddGauge("ivmp_player_ping_milliseconds", "Average ping of the player.", "player", MAX_PLAYERS);
+	m_playerBytesSent = m_registry.AddCounter("ivmp_player_bytes_sent_total", "Bytes sent to the player including overhead and acks.", "player", MAX_PLAYERS);
+	m_playerBytesResent = m_registry.AddCounter("ivmp_player_bytes_resent_total", "Bytes of reliable messages that were resent to the player.", "player", MAX_PLAYERS);
+	m_playerBytesReceived = m_registry.AddCounter("ivmp_player_bytes_received_total", "Bytes received from the player including overhead and acks.", "player", MAX_PLAYERS);
+	m_playerPacketLoss = m_registry.AddGauge("ivmp_player_packet_loss_ratio", "Packet loss of the player over the last second.", "player", MAX_PLAYERS);
+	m_playerSendBufferMessages = m_registry.AddGauge("ivmp_player_send_buffer_messages", "Messages waiting to be sent to the player.", "player", MAX_PLAYERS);
+	m_playerResendBufferMessages = m_registry.AddGauge("ivmp_player_resend_buffer_messages", "Messages sent to the player waiting for an ack or to be resent.", "player", MAX_PLAYERS);
+	m_playerCongestionLimit = m_registry.AddGauge("ivmp_player_congestion_limit_bytes_per_second", "Send rate limit of the player by congestion control (0 if not limited).", "player", MAX_PLAYERS);
+	m_entities = m_registry.AddGauge("ivmp_entities", "Entities that exist on the server.", "type", SERVER_METRICS_ENTITY_MAX, g_szEntityNames);
+	m_memory = m_registry.AddGauge("ivmp_memory_bytes", "Memory counted for the subsystem.", "tag", MEMORY_TAG_MAX, CMemoryTracker::GetTagNames());
+	m_memoryPeak = m_registry.AddGauge("ivmp_memory_peak_bytes", "Most memory counted for the subsystem since the start.", "tag", MEMORY_TAG_MAX, CMemoryTracker::GetTagNames());
+	m_scriptMemory = m_registry.AddGauge("ivmp_script_memory_bytes", "Memory of the squirrel vm of the script.", "script", MEMORY_TRACKER_MAX_SCRIPTS, CMemoryTracker::GetScriptNames());
+	m_ticks = m_registry.AddCounter("ivmp_ticks_total", "Server ticks.");
+	m_tickOverruns = m_registry.AddCounter("ivmp_tick_overruns_total", "Server ticks that took longer than the tick interval.");
+	m_skippedTicks = m_registry.AddCounter("ivmp_ticks_skipped_total", "Server ticks that were skipped as the server was too far behind.");
+	m_tickDuration = m_registry.AddHistogram("ivmp_tick_duration_seconds", "Duration of the server ticks.", g_dTickDurationBounds, (sizeof(g_dTickDurationBounds) / sizeof(double)));
+}
+
+CServerMetrics::~CServerMetrics()
+{
+
+}
+
+void CServerMetrics::OnRPCReceived(RPCIdentifier rpcId, unsigned int uiBytes)
+{
+	if(!m_bEnabled)
+		return;
+
+	m_registry.Increment(m_rpcsReceived, 1.0, rpcId);
+	m_registry.Increment(m_rpcBytesReceived, uiBytes, rpcId);
+}
+
+void CServerMetrics::OnRPCSent(RPCIdentifier rpcId, unsigned int uiBytes, unsigned int uiCount)
+{
+	if(!m_bEnabled)
+		return;
+
+	m_registry.Increment(m_rpcsSent, uiCount, rpcId);
+	m_registry.Increment(m_rpcBytesSent, uiBytes, rpcId);
+}
+
+void CServerMetrics::Update()
+{
+	CNetServerInterface * pNetServer = g_pNetworkManager->GetNetServer();
+
+	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	{
+		CNetStats * pNetStats = (g_pPlayerManager->DoesExist(i) ? pNetServer->GetPlayerNetStats(i) : NULL);
+
+		if(!pNetStats)
+		{
+			m_registry.Remove(m_playerPing, i);
+			m_registry.Remove(m_playerBytesSent, i);
+			m_registry.Remove(m_playerBytesResent, i);
+			m_registry.Remove(m_playerBytesReceived, i);
+			m_registry.Remove(m_playerPacketLoss, i);
+			m_registry.Remove(m_playerSendBufferMessages, i);
+			m_registry.Remove(m_playerResendBufferMessages, i);
+			m_registry.Remove(m_playerCongestionLimit, i);
+			continue;
+		}
+
+		unsigned int uiSendBufferMessages = 0;
+
+		for(int j = 0; j < PRIORITY_COUNT; j++)
+			uiSendBufferMessages += pNetStats->uiMessageInSendBuffer[j];
+
+		m_registry.Set(m_playerPing, pNetServer->GetPlayerAveragePing(i), i);
+		m_registry.Set(m_playerBytesSent, (double)pNetStats->ulRunningTotal[ACTUAL_BYTES_SENT], i);
+		m_registry.Set(m_playerBytesResent, (double)pNetStats->ulRunningTotal[USER_MESSAGE_BYTES_RESENT], i);
+		m_registry.Set(m_playerBytesReceived, (double)pNetStats->ulRunningTotal[ACTUAL_BYTES_RECEIVED], i);
+		m_registry.Set(m_playerPacketLoss, pNetStats->fPacketlossLastSecond, i);
+		m_registry.Set(m_playerSendBufferMessages, uiSendBufferMessages, i);
+		m_registry.Set(m_playerResendBufferMessages, pNetStats->uiMessagesInResendBuffer, i);
+		m_registry.Set(m_playerCongestionLimit, (pNetStats->bIsLimitedByCongestionControl ? (double)pNetStats->ulBPSLimitByCongestionControl : 0.0), i);
+	}
+
+	m_registry.Set(m_entities, g_pPlayerManager->GetPlayerCount(), SERVER_METRICS_ENTITY_PLAYERS);
+	m_registry.Set(m_entities, g_pVehicleManager->GetVehicleCount(), SERVER_METRICS_ENTITY_VEHICLES);
+	m_registry.Set(m_entities, g_pObjectManager->GetObjectCount(), SERVER_METRICS_ENTITY_OBJECTS);
+	m_registry.Set(m_entities, g_pBlipManager->GetBlipCount(), SERVER_METRICS_ENTITY_BLIPS);
+	m_registry.Set(m_entities, g_pActorManager->GetActorCount(), SERVER_METRICS_ENTITY_ACTORS);
+	m_registry.Set(m_entities, g_pCheckpointManager->GetCheckpointCount(), SERVER_METRICS_ENTITY_CHECKPOINTS);
+	m_registry.Set(m_entities, g_pPickupManager->GetPickupCount(), SERVER_METRICS_ENTITY_PICKUPS);
+
+	for(int i = 0; i < MEMORY_TAG_MAX; i++)
+	{
+		MemoryCounter * pCounter = ((i == MEMORY_TAG_NETWORK) ? CNetworkModule::GetMemoryCounter() : CMemoryTracker::GetCounter((eMemoryTag)i));
+
+		if(!pCounter)
+			continue;
+
+		m_registry.Set(m_memory, pCounter->lCurrent, i);
+		m_registry.Set(m_memoryPeak, pCounter->lPeak, i);
+	}
+
+	for(unsigned int i = 0; i < CMemoryTracker::GetScriptSlotCount(); i++)
+		m_registry.Set(m_scriptMemory, CMemoryTracker::GetScriptCounter(i)->lCurrent, i);
+
+	const TickSchedulerStats * pTickStats = g_pTickScheduler->GetStats();
+	m_registry.Set(m_ticks, pTickStats->ulTicks);
+	m_registry.Set(m_tickOverruns, pTickStats->ulOverruns);
+	m_registry.Set(m_skippedTicks, pTickStats->ulSkippedTicks);
+}
+
+void CServerMetrics::Process()
+{
+	if(!m_bEnabled)
+		return;
+
+	m_registry.Observe(m_tickDuration, (g_pTickScheduler->GetStats()->ulLastTickTime / 1000000.0));
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastUpdateTime) >= SERVER_METRICS_UPDATE_INTERVAL)
+	{
+		Update();
+		m_registry.Publish();
+		m_ulLastUpdateTime = ulTime;
+	}
+}
@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CServerMetrics.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "CMetricsRegistry.h"
+#include <Network/RPCIdentifiers.h>
+
+// Uri of the webserver the metrics are served at
+#define SERVER_METRICS_URI "/metrics"
+
+// Time in ms between two updates of the gauges (and publishes of all metrics)
+#define SERVER_METRICS_UPDATE_INTERVAL 1000
+
+// Amount of rpc ids the rpc metrics have series for
+#define SERVER_METRICS_MAX_RPCS 256
+
+enum eServerMetricsEntity
+{
+	SERVER_METRICS_ENTITY_PLAYERS,
+	SERVER_METRICS_ENTITY_VEHICLES,
+	SERVER_METRICS_ENTITY_OBJECTS,
+	SERVER_METRICS_ENTITY_BLIPS,
+	SERVER_METRICS_ENTITY_ACTORS,
+	SERVER_METRICS_ENTITY_CHECKPOINTS,
+	SERVER_METRICS_ENTITY_PICKUPS,
+	SERVER_METRICS_ENTITY_MAX
+};
+
+// The network and gameplay metrics of the server, scraped from the webserver
+class CServerMetrics
+{
+private:
+	bool             m_bEnabled;
+	CMetricsRegistry m_registry;
+	unsigned long    m_ulLastUpdateTime;
+	MetricId         m_rpcsReceived;
+	MetricId         m_rpcBytesReceived;
+	MetricId         m_rpcsSent;
+	MetricId         m_rpcBytesSent;
+	MetricId         m_playerPing;
+	MetricId         m_playerBytesSent;
+	MetricId         m_playerBytesResent;
+	MetricId         m_playerBytesReceived;
+	MetricId         m_playerPacketLoss;
+	MetricId         m_playerSendBufferMessages;
+	MetricId         m_playerResendBufferMessages;
+	MetricId         m_playerCongestionLimit;
+	MetricId         m_entities;
+	MetricId         m_memory;
+	MetricId         m_memoryPeak;
+	MetricId         m_scriptMemory;
+	MetricId         m_ticks;
+	MetricId         m_tickOverruns;
+	MetricId         m_skippedTicks;
+	MetricId         m_tickDuration;
+
+	void             Update();
+
+public:
+	CServerMetrics();
+	~CServerMetrics();
+
+	bool             IsEnabled() { return m_bEnabled; }
+
+	// uiBytes includes the packet and rpc ids
+	void             OnRPCReceived(RPCIdentifier rpcId, unsigned int uiBytes);
+	void             OnRPCSent(RPCIdentifier rpcId, unsigned int uiBytes, unsigned int uiCount = 1);
+
+	// Called after every server tick
+	void             Process();
+
+	String           GetText() { return m_registry.GetText(); }
+};
@@ -18,6 +18,7 @@
 #include "CPickupManager.h"
 #include "CCheckpointManager.h"
 #include "CClientFileManager.h"
+#include "CJoinStreamer.h"
 #include <CSettings.h>
 #include <Game/CTime.h>
 #include <Game/CTrafficLights.h>
@@ -25,8 +26,20 @@
 #include "CEvents.h"
 #include "CNetworkManager.h"
 #include "CVehicle.h"
+#include <Network/CSyncSerializer.h>
+#include "CInterestManager.h"
+#include "CBroadcastGroupManager.h"
+#include "ModuleNatives/ModuleNatives.h"
+#include "CCommandManager.h"
+#include "CChatManager.h"
+#include "CBanManager.h"
+#include "CClientEventManager.h"
+#include "CLagCompensation.h"
+#include "CTransferManager.h"
+#include "CWebserver.h"
 
 extern CNetworkManager * g_pNetworkManager;
+extern CBanManager * g_pBanManager;
 extern CScriptingManager * g_pScriptingManager;
 extern CPlayerManager * g_pPlayerManager;
 extern CVehicleManager * g_pVehicleManager;
@@ -42,6 +55,32 @@ extern CTrafficLights * g_pTrafficLights;
 extern CModuleManager * g_pModuleManager;
 extern CEvents * g_pEvents;
 extern CVehicle * g_pVehicle;
+extern CJoinStreamer * g_pJoinStreamer;
+extern CInterestManager * g_pInterestManager;
+extern Modules::CBulkModuleNatives * g_pBulkModuleNatives;
+extern CCommandManager * g_pCommandManager;
+extern CChatManager * g_pChatManager;
+extern CClientEventManager * g_pClientEventManager;
+extern CLagCompensation * g_pLagCompensation;
+extern CTransferManager * g_pTransferManager;
+extern CWebServer * g_pWebserver;
+
+// Read in every sync so it is only looked up once
+static CSettingHandle g_frequentEventsSetting("frequentevents");
+static CSettingHandle g_headMovementSetting("headmovement");
+
+// Stores the sync of the player for the throttled handlers of the sync events,
+// they get it at their own rate when the samples are processed
+static void SampleSyncEvent(EventId eventId, EntityId playerId)
+{
+	if(!g_pEvents->HasThrottledHandlers(eventId) && !g_pEvents->HasThrottledHandlers(EVENT_PLAYER_SYNC_RECEIVED))
+		return;
+
+	CSquirrelArguments pArguments;
+	pArguments.push(playerId);
+	g_pEvents->Sample(eventId, &pArguments, playerId);
+	g_pEvents->Sample(EVENT_PLAYER_SYNC_RECEIVED, &pArguments, playerId);
+}
 
 void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
@@ -60,6 +99,20 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 	bool bGameFilesModded = false;
 	bGameFilesModded = pBitStream->ReadBit();
 
+	// Players transferred from another server bring a token it signed
+	bool bTransfer = pBitStream->ReadBit();
+	String strTransferToken;
+
+	if(bTransfer)
+		pBitStream->Read(strTransferToken);
+
+	// Relay nodes bring the relay password
+	bool bRelay = pBitStream->ReadBit();
+	String strRelayPassword;
+
+	if(bRelay)
+		pBitStream->Read(strRelayPassword);
+
 	String strIP = pSenderSocket->GetAddress(true);
 	String strSerial = pSenderSocket->GetSerial();
 
@@ -75,6 +128,45 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 		return;
 	}
 
+	// Check that they aren't banned (the address can have been banned after they connected)
+	if(g_pBanManager->IsAddressBanned(pSenderSocket->ulBinaryAddress) || g_pBanManager->IsSerialBanned(strSerial))
+	{
+		bsSend.Write(REFUSE_REASON_BANNED);
+		g_pNetworkManager->RPC(RPC_ConnectionRefused, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE, playerId, false);
+		CLogFile::Printf("[Connect] Authorization for %s (%s) failed (banned).", strIP.Get(), strName.Get());
+		return;
+	}
+
+	// The name and the game file check of a transferred player come from the server they were on
+	PlayerTransferState transferState;
+
+	if(bTransfer)
+	{
+		if(!g_pTransferManager->ReadToken(strTransferToken, strSerial, transferState))
+		{
+			bsSend.Write(REFUSE_REASON_TRANSFER_INVALID);
+			g_pNetworkManager->RPC(RPC_ConnectionRefused, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE, playerId, false);
+			CLogFile::Printf("[Connect] Authorization for %s (%s) failed (invalid transfer).", strIP.Get(), strName.Get());
+			return;
+		}
+
+		strName = transferState.strName;
+		bGameFilesModded = transferState.bGameFilesModded;
+	}
+
+	if(bRelay)
+	{
+		String strPassword = CVAR_GET_STRING("relaypassword");
+
+		if(bTransfer || strPassword.IsEmpty() || strRelayPassword != strPassword)
+		{
+			bsSend.Write(REFUSE_REASON_RELAY_INVALID);
+			g_pNetworkManager->RPC(RPC_ConnectionRefused, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE, playerId, false);
+			CLogFile::Printf("[Connect] Authorization for %s (%s) failed (invalid relay).", strIP.Get(), strName.Get());
+			return;
+		}
+	}
+
 	// Check that their name is valid
 	if(strName.IsEmpty() || strName.GetLength() > MAX_NAME_LENGTH)
 	{
@@ -92,7 +184,7 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 		CLogFile::Printf("[Connect] Authorization for %s (%s) failed (name in use).", strIP.Get(), strName.Get());
 	}
 
-	// Call the playerConnect event, and process the return value
+	// Call the playerConnect event, and process the return value (relay nodes are no players to the scripts)
 	CSquirrelArguments playerConnectArguments;
 	playerConnectArguments.push(playerId);
 	playerConnectArguments.push(strName);
@@ -100,7 +192,7 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 	playerConnectArguments.push(strSerial);
 	playerConnectArguments.push(bGameFilesModded);
 
-	if(g_pEvents->Call("playerConnect", &playerConnectArguments).GetInteger() != 1)
+	if(!bRelay && g_pEvents->Call("playerConnect", &playerConnectArguments).GetInteger() != 1)
 	{
 		bsSend.Write(REFUSE_REASON_ABORTED_BY_SCRIPT);
 		g_pNetworkManager->RPC(RPC_ConnectionRefused, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE, playerId, false);
@@ -116,37 +208,31 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 	g_pNetworkManager->RPC(RPC_ScriptingSetNametags, &bsNametags, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 
 	// Setup the player
-	g_pPlayerManager->Add(playerId, strName);
+	g_pPlayerManager->Add(playerId, strName, bRelay);
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(!pPlayer)
 		return;
 
-	// Let the vehicle manager handle the client join
-	g_pVehicleManager->HandleClientJoin(playerId);
-
-	// Let the player manager handle the client join
-	g_pPlayerManager->HandleClientJoin(playerId);
-
-	// Let the object manager handle the client join
-	g_pObjectManager->HandleClientJoin(playerId);
+	pPlayer->SetGameFilesModded(bGameFilesModded);
 
-	// Let the fire manager handle the client join
-	g_pObjectManager->HandleClientJoinFire(playerId);
+	if(bTransfer)
+		g_pTransferManager->AddPlayer(playerId, transferState);
 
-	// Let the blip manager handle the client join
-	g_pBlipManager->HandleClientJoin(playerId);
-
-	// Let the checkpoint manager handle the client join
-	g_pCheckpointManager->HandleClientJoin(playerId);
+	// Stream the world state to the player, the joined game rpc, the files and the
+	// playerJoin event follow once everything has been sent
+	g_pJoinStreamer->Add(playerId);
+}
 
-	// Let the pickup manager handle the client join
-	g_pPickupManager->HandleClientJoin(playerId);
+void CServerRPCHandler::SendJoinedGame(EntityId playerId)
+{
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
-	// Let the actor manager handle the client join
-	g_pActorManager->HandleClientJoin(playerId);
+	if(!pPlayer)
+		return;
 
 	// Construct the reply bit stream
+	CBitStream bsSend;
 	bsSend.Write(playerId);
 	bsSend.Write(CVAR_GET_STRING("hostname"));
 	bsSend.Write(CVAR_GET_BOOL("paynspray"));
@@ -154,23 +240,14 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 	bsSend.Write(pPlayer->GetColor());
 	bsSend.Write(CVAR_GET_STRING("httpserver"));
 	bsSend.Write((unsigned short)CVAR_GET_INTEGER("httpport"));
+	bsSend.Write(g_pWebserver->HasHashedFiles());
 	bsSend.Write((unsigned char)CVAR_GET_INTEGER("weather"));
 	bsSend.Write(/*CVAR_GET_BOOL("guinametags")*/false);
 	bsSend.Write(CVAR_GET_BOOL("headmovement"));
 	bsSend.Write(CVAR_GET_INTEGER("maxplayers"));
 
 	// Time
-	unsigned char ucHour = 0, ucMinute = 0;
-	g_pTime->GetTime(&ucHour, &ucMinute);
-	bsSend.Write((unsigned char)(ucHour + (24 * (1 + g_pTime->GetDayOfWeek()))));
-	bsSend.Write(ucMinute);
-	if(g_pTime->GetMinuteDuration() != CTime::DEFAULT_MINUTE_DURATION)
-	{
-		bsSend.Write1();
-		bsSend.Write(g_pTime->GetMinuteDuration());
-	}
-	else
-		bsSend.Write0();
+	g_pTime->Write(&bsSend);
 
 	// Traffic Lights
 	bsSend.Write((BYTE)g_pTrafficLights->GetSetState());
@@ -201,20 +278,6 @@ void CServerRPCHandler::PlayerConnect(CBitStream * pBitStream, CPlayerSocket * p
 
 	// Send the joined game RPC
 	g_pNetworkManager->RPC(RPC_JoinedGame, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-
-	// Inform the resource file manager of the client join
-	g_pClientResourceFileManager->HandleClientJoin(playerId);
-
-	// Inform the script file manager of the client join
-	g_pClientScriptFileManager->HandleClientJoin(playerId);
-
-	// Call the playerJoin event(AFTER he has downloaded all files)
-	CSquirrelArguments pArguments;
-	pArguments.push(playerId);
-	g_pEvents->Call("playerJoin", &pArguments);
-
-	CLogFile::Printf("[Join] %s (%d) has joined the game.", strName.Get(), playerId);
-	
 }
 
 void CServerRPCHandler::Chat(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -242,11 +305,7 @@ void CServerRPCHandler::Chat(CBitStream * pBitStream, CPlayerSocket * pSenderSoc
 		if(g_pEvents->Call("playerText", &pArguments).GetInteger() == 1)
 		{
 			CLogFile::Printf("[Chat] %s: %s", pPlayer->GetName().C_String(), strChat.Get());
-
-			CBitStream bsSend;
-			bsSend.WriteCompressed(playerId);
-			bsSend.Write(String(strChat));
-			g_pNetworkManager->RPC(RPC_Chat, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+			g_pChatManager->Send(playerId, strChat);
 		}
 	}
 }
@@ -267,6 +326,9 @@ void CServerRPCHandler::Command(CBitStream * pBitStream, CPlayerSocket * pSender
 		if(!pBitStream->Read(strCommand))
 			return;
 
+		// Commands with handlers only go to their handlers
+		if(g_pCommandManager->Process(playerId, strCommand))
+			return;
 
 		CSquirrelArguments pArguments;
 		pArguments.push(playerId);
@@ -369,30 +431,40 @@ void CServerRPCHandler::OnFootSync(CBitStream * pBitStream, CPlayerSocket * pSen
 
 	if(pPlayer)
 	{
-		if(CVAR_GET_BOOL("frequentevents"))
+		if(g_frequentEventsSetting.GetBool())
 		{
 			CSquirrelArguments pArguments;
 			pArguments.push(playerId);
 
-			if(g_pEvents->Call("playerOnFootSyncReceived", &pArguments).GetInteger() != 1 || g_pEvents->Call("playerSyncReceived", &pArguments).GetInteger() != 1)
+			if(g_pEvents->Call(EVENT_PLAYER_ONFOOT_SYNC_RECEIVED, &pArguments).GetInteger() != 1 || g_pEvents->Call(EVENT_PLAYER_SYNC_RECEIVED, &pArguments).GetInteger() != 1)
 				return;
 		}
 
+		SampleSyncEvent(EVENT_PLAYER_ONFOOT_SYNC_RECEIVED, playerId);
+
 		OnFootSyncData syncPacket;
 		AimSyncData aimSyncData;
 
-		if(!pBitStream->Read((char *)&syncPacket, sizeof(OnFootSyncData)))
+		if(!CSyncSerializer::Deserialize(pBitStream, syncPacket, pPlayer->GetIncomingAnimState()))
 			return;
 
-		bool bHasAimSyncData = pBitStream->ReadBit();
+		bool bHasAimSyncData;
+		bool bHasHead;
+		CVector3 vecHead;
 
-		if(bHasAimSyncData)
-		{
-			if(!pBitStream->Read((char *)&aimSyncData, sizeof(AimSyncData)))
-				return;
-		}
+		if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncData, pPlayer->GetIncomingLookState()))
+			return;
+
+		// Head movement can be turned off by the server
+		CVector3 * pvecHead = ((bHasHead && g_headMovementSetting.GetBool()) ? &vecHead : NULL);
+
+		if(g_pBulkModuleNatives->HasSyncFilters() && !g_pBulkModuleNatives->FilterSync(playerId, Modules::MODULE_SYNC_ONFOOT, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL)))
+			return;
 
-		pPlayer->StoreOnFootSync(&syncPacket, bHasAimSyncData, &aimSyncData);
+		pPlayer->StoreOnFootSync(&syncPacket, bHasAimSyncData, &aimSyncData, pvecHead);
+
+		if(g_pBulkModuleNatives->HasSyncHandlers())
+			g_pBulkModuleNatives->OnSync(playerId, Modules::MODULE_SYNC_ONFOOT, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL));
 	}
 }
 
@@ -407,15 +479,17 @@ void CServerRPCHandler::InVehicleSync(CBitStream * pBitStream, CPlayerSocket * p
 
 	if(pPlayer)
 	{
-		if(CVAR_GET_BOOL("frequentevents"))
+		if(g_frequentEventsSetting.GetBool())
 		{
 			CSquirrelArguments pArguments;
 			pArguments.push(playerId);
 
-			if(g_pEvents->Call("playerInVehicleSyncReceived", &pArguments).GetInteger() != 1 || g_pEvents->Call("playerSyncReceived", &pArguments).GetInteger() != 1)
+			if(g_pEvents->Call(EVENT_PLAYER_INVEHICLE_SYNC_RECEIVED, &pArguments).GetInteger() != 1 || g_pEvents->Call(EVENT_PLAYER_SYNC_RECEIVED, &pArguments).GetInteger() != 1)
 				return;
 		}
 
+		SampleSyncEvent(EVENT_PLAYER_INVEHICLE_SYNC_RECEIVED, playerId);
+
 		EntityId vehicleId;
 		InVehicleSyncData syncPacket;
 		AimSyncData aimSyncData;
@@ -425,23 +499,31 @@ void CServerRPCHandler::InVehicleSync(CBitStream * pBitStream, CPlayerSocket * p
 
 		if(g_pVehicleManager->DoesExist(vehicleId))
 		{
-			if(!pBitStream->Read((char *)&syncPacket, sizeof(InVehicleSyncData)))
+			if(!CSyncSerializer::Deserialize(pBitStream, syncPacket))
 				return;
 
-			bool bHasAimSyncData = pBitStream->ReadBit();
+			bool bHasAimSyncData;
+			bool bHasHead;
+			CVector3 vecHead;
 
-			if(bHasAimSyncData)
-			{
-				if(!pBitStream->Read((char *)&aimSyncData, sizeof(AimSyncData)))
-					return;
-			}
+			if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncData, pPlayer->GetIncomingLookState()))
+				return;
+
+			// Head movement can be turned off by the server
+			CVector3 * pvecHead = ((bHasHead && g_headMovementSetting.GetBool()) ? &vecHead : NULL);
 
 			CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
 			if(pVehicle)
 			{
-				pPlayer->StoreInVehicleSync(pVehicle, &syncPacket, bHasAimSyncData, &aimSyncData);
+				if(g_pBulkModuleNatives->HasSyncFilters() && !g_pBulkModuleNatives->FilterSync(playerId, Modules::MODULE_SYNC_INVEHICLE, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL)))
+					return;
+
+				pPlayer->StoreInVehicleSync(pVehicle, &syncPacket, bHasAimSyncData, &aimSyncData, pvecHead);
 				pVehicle->StoreInVehicleSync(&syncPacket);
+
+				if(g_pBulkModuleNatives->HasSyncHandlers())
+					g_pBulkModuleNatives->OnSync(playerId, Modules::MODULE_SYNC_INVEHICLE, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL));
 				//pVehicle->SetLastTimeOccupied(SharedUtility::GetTime());
 			}
 		}
@@ -459,15 +541,17 @@ void CServerRPCHandler::PassengerSync(CBitStream * pBitStream, CPlayerSocket * p
 
 	if(pPlayer)
 	{
-		if(CVAR_GET_BOOL("frequentevents"))
+		if(g_frequentEventsSetting.GetBool())
 		{
 			CSquirrelArguments pArguments;
 			pArguments.push(playerId);
 
-			if(g_pEvents->Call("playerPassengerSyncReceived", &pArguments).GetInteger() != 1 || g_pEvents->Call("playerSyncReceived", &pArguments).GetInteger() != 1)
+			if(g_pEvents->Call(EVENT_PLAYER_PASSENGER_SYNC_RECEIVED, &pArguments).GetInteger() != 1 || g_pEvents->Call(EVENT_PLAYER_SYNC_RECEIVED, &pArguments).GetInteger() != 1)
 				return;
 		}
 
+		SampleSyncEvent(EVENT_PLAYER_PASSENGER_SYNC_RECEIVED, playerId);
+
 		EntityId vehicleId;
 		PassengerSyncData syncPacket;
 		AimSyncData aimSyncData;
@@ -477,23 +561,31 @@ void CServerRPCHandler::PassengerSync(CBitStream * pBitStream, CPlayerSocket * p
 
 		if(g_pVehicleManager->DoesExist(vehicleId))
 		{
-			if(!pBitStream->Read((char *)&syncPacket, sizeof(PassengerSyncData)))
+			if(!CSyncSerializer::Deserialize(pBitStream, syncPacket))
 				return;
 
-			bool bHasAimSyncData = pBitStream->ReadBit();
+			bool bHasAimSyncData;
+			bool bHasHead;
+			CVector3 vecHead;
 
-			if(bHasAimSyncData)
-			{
-				if(!pBitStream->Read((char *)&aimSyncData, sizeof(AimSyncData)))
-					return;
-			}
+			if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncData, pPlayer->GetIncomingLookState()))
+				return;
+
+			// Head movement can be turned off by the server
+			CVector3 * pvecHead = ((bHasHead && g_headMovementSetting.GetBool()) ? &vecHead : NULL);
 
 			CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
 			if(pVehicle)
 			{
-				pPlayer->StorePassengerSync(pVehicle, &syncPacket, bHasAimSyncData, &aimSyncData);
+				if(g_pBulkModuleNatives->HasSyncFilters() && !g_pBulkModuleNatives->FilterSync(playerId, Modules::MODULE_SYNC_PASSENGER, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL)))
+					return;
+
+				pPlayer->StorePassengerSync(pVehicle, &syncPacket, bHasAimSyncData, &aimSyncData, pvecHead);
 				pVehicle->StorePassengerSync(&syncPacket);
+
+				if(g_pBulkModuleNatives->HasSyncHandlers())
+					g_pBulkModuleNatives->OnSync(playerId, Modules::MODULE_SYNC_PASSENGER, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL));
 			}
 		}
 	}
@@ -510,31 +602,112 @@ void CServerRPCHandler::SmallSync(CBitStream * pBitStream, CPlayerSocket * pSend
 
 	if(pPlayer)
 	{
-		if(CVAR_GET_BOOL("frequentevents"))
+		if(g_frequentEventsSetting.GetBool())
 		{
 			CSquirrelArguments pArguments;
 			pArguments.push(playerId);
 
-			if(g_pEvents->Call("playerSmallSyncReceived", &pArguments).GetInteger() != 1 || g_pEvents->Call("playerSyncReceived", &pArguments).GetInteger() != 1)
+			if(g_pEvents->Call(EVENT_PLAYER_SMALL_SYNC_RECEIVED, &pArguments).GetInteger() != 1 || g_pEvents->Call(EVENT_PLAYER_SYNC_RECEIVED, &pArguments).GetInteger() != 1)
 				return;
 		}
 
+		SampleSyncEvent(EVENT_PLAYER_SMALL_SYNC_RECEIVED, playerId);
+
 		SmallSyncData syncPacket;
 		AimSyncData aimSyncData;
 
-		if(!pBitStream->Read((char *)&syncPacket, sizeof(SmallSyncData)))
+		if(!CSyncSerializer::Deserialize(pBitStream, syncPacket))
 			return;
 
-		bool bHasAimSyncData = pBitStream->ReadBit();
+		bool bHasAimSyncData;
+		bool bHasHead;
+		CVector3 vecHead;
 
-		if(bHasAimSyncData)
-		{
-			if(!pBitStream->Read((char *)&aimSyncData, sizeof(AimSyncData)))
-				return;
-		}
+		if(!CSyncSerializer::DeserializeLook(pBitStream, bHasHead, vecHead, bHasAimSyncData, aimSyncData, pPlayer->GetIncomingLookState()))
+			return;
+
+		// Head movement can be turned off by the server
+		CVector3 * pvecHead = ((bHasHead && g_headMovementSetting.GetBool()) ? &vecHead : NULL);
+
+		if(g_pBulkModuleNatives->HasSyncFilters() && !g_pBulkModuleNatives->FilterSync(playerId, Modules::MODULE_SYNC_SMALL, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL)))
+			return;
+
+		pPlayer->StoreSmallSync(&syncPacket, bHasAimSyncData, &aimSyncData, pvecHead);
+
+		if(g_pBulkModuleNatives->HasSyncHandlers())
+			g_pBulkModuleNatives->OnSync(playerId, Modules::MODULE_SYNC_SMALL, &syncPacket, (bHasAimSyncData ? &aimSyncData : NULL));
+	}
+}
+
+void CServerRPCHandler::InputAction(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(pSenderSocket->playerId);
+
+	if(!pPlayer || !pPlayer->IsSpawned())
+		return;
+
+	unsigned char ucInputActions;
+
+	if(!pBitStream->Read(ucInputActions))
+		return;
+
+	pPlayer->StoreInputActions(ucInputActions);
+}
+
+void CServerRPCHandler::InVehicleSyncAck(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId playerId = pSenderSocket->playerId;
+
+	if(!g_pPlayerManager->DoesExist(playerId))
+		return;
+
+	unsigned char ucCount;
+
+	if(!pBitStream->ReadCompressed(ucCount))
+		return;
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		EntityId syncPlayerId;
+		unsigned char ucSequence;
+
+		if(!pBitStream->ReadCompressed(syncPlayerId) || !pBitStream->Read(ucSequence))
+			return;
+
+		CPlayer * pSyncPlayer = g_pPlayerManager->GetAt(syncPlayerId);
+
+		if(pSyncPlayer)
+			pSyncPlayer->AckInVehicleSync(playerId, ucSequence);
+	}
+}
+
+// Returns true if another player sits in the seat or has an accepted entry into it
+static bool IsVehicleSeatTaken(CVehicle * pVehicle, BYTE byteSeatId, CPlayer * pPlayer)
+{
+	CPlayer * pOccupant = pVehicle->GetOccupant(byteSeatId);
 
-		pPlayer->StoreSmallSync(&syncPacket, bHasAimSyncData, &aimSyncData);
+	if(pOccupant && pOccupant != pPlayer)
+		return true;
+
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		CPlayer * pOther = g_pPlayerManager->GetAt(players[i]);
+
+		if(pOther && pOther != pPlayer && pOther->GetEnterVehicleId() == pVehicle->GetVehicleId() && pOther->GetEnterVehicleSeatId() == byteSeatId)
+			return true;
 	}
+
+	return false;
 }
 
 void CServerRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -584,19 +757,21 @@ void CServerRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 			if(!pBitStream->Read(byteSeatId))
 				return;
 
-			// Is the vehicle fully locked?
-			if(pVehicle->GetLocked() == 1) {
-				CBitStream bitStream;
-				bitStream.Write(playerId);
-				g_pNetworkManager->RPC(RPC_ResetVehicleEnterExit, &bitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE, INVALID_ENTITY_ID, true);
-				return;
+			// The client already started the entry, it is only rolled back if the
+			// vehicle is locked, the seat is taken or the scripts don't allow it
+			bool bReply = (byteSeatId <= MAX_VEHICLE_PASSENGERS && pVehicle->GetLocked() != 1 && !IsVehicleSeatTaken(pVehicle, byteSeatId, pPlayer));
+
+			if(bReply)
+			{
+				// Get the reply
+				CSquirrelArguments arguments;
+				arguments.push(playerId);
+				arguments.push(vehicleId);
+				arguments.push(byteSeatId);
+				bReply = (g_pEvents->Call("vehicleEntryRequest", &arguments).GetInteger() == 1);
 			}
-			// Get the reply
-			CSquirrelArguments arguments;
-			arguments.push(playerId);
-			arguments.push(vehicleId);
-			arguments.push(byteSeatId);
-			if(g_pEvents->Call("vehicleEntryRequest", &arguments).GetInteger() == 1)
+
+			if(bReply)
 			{
 				// Reply to the vehicle entry request
 				CBitStream bitStream;
@@ -608,11 +783,13 @@ void CServerRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 				bitStream.Write(byteSeatId);
 				g_pNetworkManager->RPC(RPC_VehicleEnterExit, &bitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE, INVALID_ENTITY_ID, true);
 
-				// Set the player state
+				// Reserve the seat and set the player state
+				pPlayer->SetEnterVehicle(vehicleId, byteSeatId);
 				pPlayer->SetState(STATE_TYPE_ENTERVEHICLE);
 			} else {
 				CBitStream bitStream;
 				bitStream.Write(playerId);
+				bitStream.Write(vehicleId);
 				g_pNetworkManager->RPC(RPC_ResetVehicleEnterExit, &bitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE, INVALID_ENTITY_ID, true);
 			}
 		}
@@ -632,6 +809,9 @@ void CServerRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 			arguments.push(byteSeatId);
 			g_pEvents->Call("vehicleEntryCancelled", &arguments);
 
+			// Give up the seat
+			pPlayer->SetEnterVehicle(INVALID_ENTITY_ID, 0);
+
 			CBitStream bitStream;
 			bitStream.WriteCompressed(playerId);
 			bitStream.WriteBit(true);
@@ -651,6 +831,13 @@ void CServerRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 			if(!pBitStream->Read(byteSeatId))
 				return;
 
+			// Ignore an entry into a seat another player got first, the client
+			// completed it before it was rolled back
+			pPlayer->SetEnterVehicle(INVALID_ENTITY_ID, 0);
+
+			if(IsVehicleSeatTaken(pVehicle, byteSeatId, pPlayer))
+				return;
+
 			// Call the event
 			CSquirrelArguments arguments;
 			arguments.push(playerId);
@@ -737,72 +924,103 @@ void CServerRPCHandler::VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket
 	}
 }
 
-void CServerRPCHandler::HeadMovement(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+void CServerRPCHandler::EmptyVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
 	if(!pBitStream)
 		return;
 
 	EntityId playerId = pSenderSocket->playerId;
-	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
-	CVector3 vecAim;
 
-	if(!pBitStream->Read(vecAim.fX))
-		return;
+	if(g_frequentEventsSetting.GetBool())
+	{
+		CSquirrelArguments pArguments;
+		pArguments.push(playerId);
 
-	if(!pBitStream->Read(vecAim.fY))
+		if(g_pEvents->Call(EVENT_PLAYER_EMPTY_VEHICLE_SYNC_RECEIVED, &pArguments).GetInteger() != 1 || g_pEvents->Call(EVENT_PLAYER_SYNC_RECEIVED, &pArguments).GetInteger() != 1)
+			return;
+	}
+
+	SampleSyncEvent(EVENT_PLAYER_EMPTY_VEHICLE_SYNC_RECEIVED, playerId);
+
+	unsigned char ucCount;
+
+	if(!pBitStream->Read(ucCount) || ucCount > EMPTY_VEHICLE_SYNC_BATCH_SIZE)
 		return;
 
-	if(!pBitStream->Read(vecAim.fZ))
+	// Only the syncs of the vehicles the player owns are used and passed on
+	CBitStream bsSend;
+	EMPTYVEHICLESYNCPACKET syncPackets[EMPTY_VEHICLE_SYNC_BATCH_SIZE];
+	unsigned char ucStored = 0;
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		EMPTYVEHICLESYNCPACKET * pSyncPacket = &syncPackets[ucStored];
+
+		if(!pBitStream->Read((PCHAR)pSyncPacket, sizeof(EMPTYVEHICLESYNCPACKET)))
+			return;
+
+		CVehicle * pVehicle = g_pVehicleManager->GetAt(pSyncPacket->vehicleId);
+
+		if(!pVehicle || !g_pVehicleManager->DoesExist(pSyncPacket->vehicleId) || pVehicle->GetSyncOwner() != playerId || pVehicle->IsOccupied())
+			continue;
+
+		pVehicle->StoreEmptyVehicle(pSyncPacket);
+		ucStored++;
+	}
+
+	if(ucStored == 0)
 		return;
 
-	// Check if frequentevents and headmovement is enabled
-	if(CVAR_GET_BOOL("headmovement"))
+	bsSend.Write(ucStored);
+	bsSend.Write((char *)syncPackets, (ucStored * sizeof(EMPTYVEHICLESYNCPACKET)));
+
+	// Pass them on to the players around the owner (the vehicles are close to it)
+	if(g_pInterestManager->IsEnabled())
 	{
-		CBitStream bsSend;
-		bsSend.WriteCompressed(playerId);
-		bsSend.Write(vecAim.fX);
-		bsSend.Write(vecAim.fY);
-		bsSend.Write(vecAim.fZ);
+		InterestPlayerList playerList;
+		g_pInterestManager->GetPlayersInRange(playerId, playerList);
+
+		for(InterestPlayerList::iterator iter = playerList.begin(); iter != playerList.end(); iter++)
+			g_pNetworkManager->RPC(RPC_EmptyVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, *iter, false);
+	}
+	else
+	{
+		CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
-		// Update our head sync
 		if(pPlayer)
-		{
-			pPlayer->UpdateHeadMoveSync(vecAim);
-			g_pNetworkManager->RPC(RPC_HeadMovement, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, INVALID_ENTITY_ID, true);
-		}
+			g_pNetworkManager->GroupRPC(RPC_EmptyVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, CBroadcastGroupManager::GetDimensionGroup(pPlayer->GetDimension()), playerId);
 	}
 }
 
-void CServerRPCHandler::EmptyVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+void CServerRPCHandler::VehicleDamageSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
 	if(!pBitStream)
 		return;
 
 	EntityId playerId = pSenderSocket->playerId;
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
-	if(CVAR_GET_BOOL("frequentevents"))
-	{
-		CSquirrelArguments pArguments;
-		pArguments.push(playerId);
+	if(!pPlayer)
+		return;
 
-		if(g_pEvents->Call("playerEmptyVehicleSyncReceived", &pArguments).GetInteger() != 1 || g_pEvents->Call("playerSyncReceived", &pArguments).GetInteger() != 1)
-			return;
-	}
+	EntityId vehicleId;
+	VehicleDamageSyncData damage;
 
-	CBitStream bsSend;
-	EMPTYVEHICLESYNCPACKET syncPacket;
+	if(!pBitStream->ReadCompressed(vehicleId) || !CSyncSerializer::Deserialize(pBitStream, damage))
+		return;
+
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-	if(!pBitStream->Read((PCHAR)&syncPacket, sizeof(EMPTYVEHICLESYNCPACKET)))
+	if(!pVehicle || !g_pVehicleManager->DoesExist(vehicleId))
 		return;
 
-	CVehicle * pVehicle = g_pVehicleManager->GetAt(syncPacket.vehicleId);
-	if(pVehicle && g_pVehicleManager->DoesExist(syncPacket.vehicleId))
-		pVehicle->StoreEmptyVehicle(&syncPacket);
+	// Only the driver or the sync owner of an empty vehicle may damage it
+	if(pVehicle->GetDriver() != pPlayer && (pVehicle->GetSyncOwner() != playerId || pVehicle->IsOccupied()))
+		return;
 
-	//bsSend.Write((char *)&syncPacket, sizeof(EMPTYVEHICLESYNCPACKET));
-	//g_pNetworkManager->RPC(RPC_EmptyVehicleSync, &bsSend, PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED, playerId, false);
+	pVehicle->StoreDamageSync(damage, playerId);
 }
 
 void CServerRPCHandler::NameChange(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -842,10 +1060,10 @@ void CServerRPCHandler::CheckpointEntered(CBitStream * pBitStream, CPlayerSocket
 	if(!pBitStream->Read(checkpointId))
 		return;
 
-	CSquirrelArguments pArguments;
-	pArguments.push(playerId);
-	pArguments.push(checkpointId);
-	g_pEvents->Call("playerEnterCheckpoint", &pArguments);
+	// The server tests the checkpoints itself, the report only means the player
+	// should be tested again
+	if(g_pCheckpointManager->DoesExist(checkpointId))
+		g_pCheckpointManager->HintPlayer(playerId);
 }
 
 void CServerRPCHandler::CheckpointLeft(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -860,33 +1078,40 @@ void CServerRPCHandler::CheckpointLeft(CBitStream * pBitStream, CPlayerSocket *
 	if(!pBitStream->Read(checkpointId))
 		return;
 
-	CSquirrelArguments pArguments;
-	pArguments.push(playerId);
-	pArguments.push(checkpointId);
-	g_pEvents->Call("playerLeaveCheckpoint", &pArguments);
+	// Only a hint, like the enter
+	if(g_pCheckpointManager->DoesExist(checkpointId))
+		g_pCheckpointManager->HintPlayer(playerId);
 }
 
-void CServerRPCHandler::EventCall(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+void CServerRPCHandler::EventName(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
 {
 	// Ensure we have a valid bit stream
 	if(!pBitStream)
 		return;
 
-	CSquirrelArguments* pArgs = new CSquirrelArguments(pBitStream);
-	CSquirrelArgument* pEventName = pArgs->size() > 0 ? pArgs->front() : 0;
+	// The definitions of a player are forgotten when it is removed
+	if(!g_pPlayerManager->DoesExist(pSenderSocket->playerId))
+		return;
+
+	g_pNetworkManager->GetEventNames()->ReadDefinition(pSenderSocket->playerId, pBitStream);
+}
 
-	if(pEventName && pEventName->GetType() == OT_STRING)
-	{
-		String strEventName = pEventName->data.str->C_String();
-		pArgs->pop_front();
-		pArgs->push_front(new CSquirrelArgument(pSenderSocket->playerId));
+void CServerRPCHandler::EventCall(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
 
-		g_pEvents->Call(strEventName, pArgs);
+	if(!g_pPlayerManager->DoesExist(pSenderSocket->playerId))
+		return;
 
-		delete pEventName;
-	}
+	EventId eventId = g_pNetworkManager->GetEventNames()->ReadEvent(pSenderSocket->playerId, pBitStream);
+
+	if(eventId == INVALID_EVENT_ID)
+		return;
 
-	delete pArgs;
+	// Rate limited and coalesced before the event is called
+	g_pClientEventManager->OnEvent(pSenderSocket->playerId, eventId, pBitStream);
 }
 
 void CServerRPCHandler::VehicleDeath(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
@@ -918,19 +1143,20 @@ void CServerRPCHandler::VehicleDeath(CBitStream * pBitStream, CPlayerSocket * pS
 			g_pNetworkManager->RPC(RPC_ScriptingRemovePlayerFromVehicle,&bsSend,PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 		}
 		// Loop trough all players
-		for(EntityId i = 0; i < MAX_PLAYERS; i++)
+		const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+		for(size_t x = 0; x < players.size(); x++)
 		{
-			if(g_pPlayerManager->DoesExist(i))
+			EntityId i = players[x];
+
+			if(!g_pPlayerManager->GetAt(i)->IsOnFoot())
 			{
-				if(!g_pPlayerManager->GetAt(i)->IsOnFoot())
+				if(g_pPlayerManager->GetAt(i)->GetVehicle()->GetVehicleId() == pVehicle->GetVehicleId())
 				{
-					if(g_pPlayerManager->GetAt(i)->GetVehicle()->GetVehicleId() == pVehicle->GetVehicleId())
-					{
-						CBitStream bsSend;
-						bsSend.Write(i);
-						bsSend.Write0();
-						g_pNetworkManager->RPC(RPC_ScriptingRemovePlayerFromVehicle,&bsSend,PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, i, false);
-					}
+					CBitStream bsSend;
+					bsSend.Write(i);
+					bsSend.Write0();
+					g_pNetworkManager->RPC(RPC_ScriptingRemovePlayerFromVehicle,&bsSend,PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, i, false);
 				}
 			}
 
@@ -955,7 +1181,7 @@ void CServerRPCHandler::SyncActor(CBitStream * pBitStream, CPlayerSocket * pSend
 		if(!pBitStream->Read((char *)&syncPacket, sizeof(ActorSyncData)))
 			return;
 
-		if(syncPacket.bDriving)
+		if(syncPacket.bDriving && g_pActorManager->DoesExist(syncPacket.actorId))
 			g_pActorManager->UpdateDrivePos(syncPacket.actorId, syncPacket.vecPos, syncPacket.vecRot, syncPacket.bDriving);
 	}
 }
@@ -970,18 +1196,98 @@ void CServerRPCHandler::RequestActorUpdate(CBitStream * pBitStream, CPlayerSocke
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	EntityId actorId;
-	pBitStream->Read(actorId);
 
-	if(pPlayer)
+	if(!pBitStream->Read(actorId) || !g_pActorManager->DoesExist(actorId))
+		return;
+
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(g_pActorManager->GetVehicle(actorId));
+
+	if(pPlayer && pVehicle)
 	{
 		CBitStream bsSend;
 		bsSend.Write(actorId);
 		CVector3 vecPos; 
-		g_pVehicleManager->GetAt(g_pActorManager->GetVehicle(actorId))->GetPosition(vecPos);
+		pVehicle->GetPosition(vecPos);
 		bsSend.Write(vecPos);
 		g_pNetworkManager->RPC(RPC_ScriptingActorDriveToCoords, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 	}
 }
+void CServerRPCHandler::PlayerShot(CBitStream * pBitStream, CPlayerSocket * pSenderSocket)
+{
+	// Ensure we have a valid bit stream
+	if(!pBitStream)
+		return;
+
+	EntityId playerId = pSenderSocket->playerId;
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer || !pPlayer->IsSpawned())
+		return;
+
+	unsigned int uiShotTime;
+	unsigned int uiWeapon;
+	CVector3 vecShotSource;
+	CVector3 vecShotTarget;
+	EntityId hitPlayerId;
+
+	if(!pBitStream->Read(uiShotTime) || !pBitStream->ReadCompressed(uiWeapon) || !pBitStream->ReadPosition(vecShotSource) ||
+		!pBitStream->ReadPosition(vecShotTarget) || !pBitStream->ReadCompressed(hitPlayerId))
+		return;
+
+	// The shot time is the server time the shooter saw the others at, it can't be
+	// rewound further than the limit (0 is sent before the client knows the server time)
+	unsigned long ulTime = SharedUtility::GetTime();
+	long lRewind = (long)(ulTime - uiShotTime);
+
+	if(uiShotTime == 0)
+		lRewind = pPlayer->GetPing();
+
+	if(lRewind < 0)
+		lRewind = 0;
+	else if(lRewind > LAG_COMPENSATION_MAX_REWIND)
+		lRewind = LAG_COMPENSATION_MAX_REWIND;
+
+	unsigned long ulShotTime = (ulTime - lRewind);
+
+	// The shot has to come from where the shooter was with the weapon it holds
+	CVector3 vecShooterPosition;
+
+	if(!g_pLagCompensation->GetPosition(playerId, ulShotTime, vecShooterPosition))
+		pPlayer->GetPosition(vecShooterPosition);
+
+	if(uiWeapon != pPlayer->GetWeapon() || (vecShotSource - vecShooterPosition).Length() > LAG_COMPENSATION_SOURCE_RADIUS)
+	{
+		CLogFile::PrintDebugf("Refused a shot of player %d (Weapon %d).", playerId, uiWeapon);
+		return;
+	}
+
+	// The hit only counts if the target was close to the player the shooter saw
+	if(hitPlayerId != INVALID_ENTITY_ID)
+	{
+		CPlayer * pHitPlayer = g_pPlayerManager->GetAt(hitPlayerId);
+		CVector3 vecHitPosition;
+
+		if(hitPlayerId == playerId || !pHitPlayer || !pHitPlayer->IsSpawned() || pHitPlayer->GetDimension() != pPlayer->GetDimension() ||
+			!g_pLagCompensation->GetPosition(hitPlayerId, ulShotTime, vecHitPosition) || (vecShotTarget - vecHitPosition).Length() > LAG_COMPENSATION_HIT_RADIUS)
+		{
+			CLogFile::PrintDebugf("Refused a hit of player %d on player %d.", playerId, hitPlayerId);
+			hitPlayerId = INVALID_ENTITY_ID;
+		}
+	}
+
+	CSquirrelArguments pArguments;
+	pArguments.push(playerId);
+	pArguments.push((int)uiWeapon);
+	pArguments.push(vecShotSource.fX);
+	pArguments.push(vecShotSource.fY);
+	pArguments.push(vecShotSource.fZ);
+	pArguments.push(vecShotTarget.fX);
+	pArguments.push(vecShotTarget.fY);
+	pArguments.push(vecShotTarget.fZ);
+	pArguments.push(hitPlayerId);
+	g_pEvents->Call("playerShot", &pArguments);
+}
+
 void CServerRPCHandler::Register()
 {
 	AddFunction(RPC_PlayerConnect, PlayerConnect);
@@ -993,16 +1299,20 @@ void CServerRPCHandler::Register()
 	AddFunction(RPC_InVehicleSync, InVehicleSync);
 	AddFunction(RPC_PassengerSync, PassengerSync);
 	AddFunction(RPC_SmallSync, SmallSync);
+	AddFunction(RPC_InputAction, InputAction);
+	AddFunction(RPC_InVehicleSyncAck, InVehicleSyncAck);
 	AddFunction(RPC_VehicleEnterExit, VehicleEnterExit);
-	AddFunction(RPC_HeadMovement, HeadMovement);
 	AddFunction(RPC_EmptyVehicleSync, EmptyVehicleSync);
+	AddFunction(RPC_VehicleDamageSync, VehicleDamageSync);
 	AddFunction(RPC_NameChange, NameChange);
 	AddFunction(RPC_CheckpointEntered, CheckpointEntered);
 	AddFunction(RPC_CheckpointLeft, CheckpointLeft);
+	AddFunction(RPC_ScriptingEventName, EventName);
 	AddFunction(RPC_ScriptingEventCall, EventCall);
 	AddFunction(RPC_ScriptingVehicleDeath, VehicleDeath);
 	AddFunction(RPC_SyncActor, SyncActor);
 	AddFunction(RPC_RequestActorUpdate, RequestActorUpdate);
+	AddFunction(RPC_PlayerShot, PlayerShot);
 }
 
 void CServerRPCHandler::Unregister()
@@ -1016,14 +1326,18 @@ void CServerRPCHandler::Unregister()
 	RemoveFunction(RPC_InVehicleSync);
 	RemoveFunction(RPC_PassengerSync);
 	RemoveFunction(RPC_SmallSync);
+	RemoveFunction(RPC_InputAction);
+	RemoveFunction(RPC_InVehicleSyncAck);
 	RemoveFunction(RPC_VehicleEnterExit);
-	RemoveFunction(RPC_HeadMovement);
 	RemoveFunction(RPC_EmptyVehicleSync);
+	RemoveFunction(RPC_VehicleDamageSync);
 	RemoveFunction(RPC_NameChange);
 	RemoveFunction(RPC_CheckpointEntered);
 	RemoveFunction(RPC_CheckpointLeft);
+	RemoveFunction(RPC_ScriptingEventName);
 	RemoveFunction(RPC_ScriptingEventCall);
 	RemoveFunction(RPC_ScriptingVehicleDeath);
 	RemoveFunction(RPC_SyncActor);
 	RemoveFunction(RPC_RequestActorUpdate);
+	RemoveFunction(RPC_PlayerShot);
 }
@@ -23,18 +23,24 @@ private:
 	static void InVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void PassengerSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void SmallSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void InputAction(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void InVehicleSyncAck(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void VehicleEnterExit(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
-	static void HeadMovement(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void EmptyVehicleSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void VehicleDamageSync(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void NameChange(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void CheckpointEntered(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void CheckpointLeft(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void EventName(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void EventCall(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void VehicleDeath(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void SyncActor(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 	static void RequestActorUpdate(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
+	static void PlayerShot(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 
 public:
+	static void SendJoinedGame(EntityId playerId);
+
 	void        Register();
 	void        Unregister();
 };
@@ -0,0 +1,325 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSnapshotManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <limits.h>
+#include "CSnapshotManager.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include "CInterestManager.h"
+#include <CSettings.h>
+#include <SharedUtility.h>
+#include <Threading/CJobSystem.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CInterestManager * g_pInterestManager;
+extern CJobSystem * g_pJobSystem;
+
+CSnapshotManager::CSnapshotManager()
+{
+	// Reset all entries
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		m_bPending[x] = false;
+		m_iBudget[x] = 0;
+		m_datagrams[x].uiCount = 0;
+
+		for(EntityId y = 0; y < MAX_PLAYERS; y++)
+		{
+			m_entries[x][y].bPending = false;
+			m_entries[x][y].rpcId = 0;
+			m_entries[x][y].pBitStream = NULL;
+			m_entries[x][y].ulSyncTime = 0;
+			m_entries[x][y].ulLastSendTime = 0;
+		}
+	}
+
+	// Get the per client sync bandwidth from the settings
+	m_uiBandwidth = (unsigned int)CVAR_GET_INTEGER("syncbandwidth");
+	m_ulLastProcessTime = SharedUtility::GetTime();
+}
+
+CSnapshotManager::~CSnapshotManager()
+{
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		for(EntityId y = 0; y < MAX_PLAYERS; y++)
+			SAFE_DELETE(m_entries[x][y].pBitStream);
+
+		for(size_t i = 0; i < m_datagrams[x].datagrams.size(); i++)
+			SAFE_DELETE(m_datagrams[x].datagrams[i]);
+	}
+}
+
+void CSnapshotManager::Queue(EntityId playerId, EntityId syncPlayerId, RPCIdentifier rpcId, CBitStream * pBitStream)
+{
+	if(playerId >= MAX_PLAYERS || syncPlayerId >= MAX_PLAYERS)
+		return;
+
+	SnapshotEntry * pEntry = &m_entries[playerId][syncPlayerId];
+
+	// The bit streams are kept around and reused for every tick
+	if(!pEntry->pBitStream)
+		pEntry->pBitStream = new CBitStream();
+	else
+		pEntry->pBitStream->Reset();
+
+	// Only the latest sync of each player is sent so this replaces any sync
+	// queued earlier (including any that didn't fit in the budget yet)
+	pEntry->pBitStream->Write((char *)pBitStream->GetData(), pBitStream->GetNumberOfBytesUsed());
+	pEntry->rpcId = rpcId;
+	pEntry->ulSyncTime = SharedUtility::GetTime();
+	pEntry->bPending = true;
+	m_bPending[playerId] = true;
+}
+
+void CSnapshotManager::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	// Drop everything queued for and from this player (the players that left
+	// earlier were already dropped so only the active ones can have entries)
+	m_bPending[playerId] = false;
+	m_iBudget[playerId] = 0;
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		m_entries[playerId][players[i]].bPending = false;
+		m_entries[players[i]][playerId].bPending = false;
+	}
+}
+
+CBitStream * CSnapshotManager::Begin(EntityId playerId, unsigned long ulTime)
+{
+	SnapshotDatagrams * pDatagrams = &m_datagrams[playerId];
+
+	if(pDatagrams->uiCount == pDatagrams->datagrams.size())
+		pDatagrams->datagrams.push_back(new CBitStream());
+
+	CBitStream * pBitStream = pDatagrams->datagrams[pDatagrams->uiCount++];
+
+	// Reserve the rpc header and the entry count, the count is filled in once the datagram is full
+	pBitStream->Reset();
+	pBitStream->PadWithZeroToByteLength(RPC_HEADER_SIZE + sizeof(unsigned char));
+
+	// The client buffers the entries by the server time they are from
+	pBitStream->Write((unsigned int)ulTime);
+	return pBitStream;
+}
+
+bool CSnapshotManager::UpdateBudget(EntityId playerId, unsigned long ulElapsedTime)
+{
+	// Relay nodes carry the snapshots of all their spectators so only congestion control limits them
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+	unsigned int uiBandwidth = ((pPlayer && pPlayer->IsRelay()) ? 0 : m_uiBandwidth);
+	CNetStats * pNetStats = g_pNetworkManager->GetNetServer()->GetPlayerNetStats(playerId);
+
+	if(pNetStats)
+	{
+		// Is the send buffer already backed up? Hold everything back until
+		// it drains instead of making the latency worse
+		if(pNetStats->dBytesInSendBuffer[PRIORITY_LOW] > SNAPSHOT_MAX_SEND_BUFFER)
+			return false;
+
+		// Are we limited by congestion control? Leave some of the limit
+		// for the reliable traffic
+		if(pNetStats->bIsLimitedByCongestionControl)
+		{
+			unsigned int uiLimit = (unsigned int)((pNetStats->ulBPSLimitByCongestionControl * 3) / 4);
+
+			if(uiBandwidth == 0 || uiLimit < uiBandwidth)
+				uiBandwidth = uiLimit;
+		}
+	}
+
+	// Is there no budget?
+	if(uiBandwidth == 0)
+	{
+		m_iBudget[playerId] = INT_MAX;
+		return true;
+	}
+
+	// Add the bandwidth of the elapsed time to the budget, a client can only
+	// save up a limited burst (which always fits a full datagram)
+	int iMaxBudget = (int)((uiBandwidth * SNAPSHOT_BUDGET_BURST) / 1000);
+
+	if(iMaxBudget < SNAPSHOT_MAX_SIZE)
+		iMaxBudget = SNAPSHOT_MAX_SIZE;
+
+	if(m_iBudget[playerId] > iMaxBudget)
+		m_iBudget[playerId] = iMaxBudget;
+
+	m_iBudget[playerId] += (int)((uiBandwidth * ulElapsedTime) / 1000);
+
+	if(m_iBudget[playerId] > iMaxBudget)
+		m_iBudget[playerId] = iMaxBudget;
+
+	return (m_iBudget[playerId] > 0);
+}
+
+float CSnapshotManager::GetPriority(EntityId playerId, EntityId syncPlayerId, unsigned long ulTime)
+{
+	// Priority grows with the time since the last update so starved entries
+	// eventually win over everything else
+	float fPriority = (float)((ulTime - m_entries[playerId][syncPlayerId].ulLastSendTime) + 1);
+
+	// Players near the recipient are more relevant than players far away
+	float fRange = g_pInterestManager->GetRange();
+
+	if(fRange > 0.0f)
+	{
+		CVector3 vecPosition;
+		CVector3 vecSyncPosition;
+		g_pPlayerManager->GetAt(playerId)->GetPosition(vecPosition);
+		g_pPlayerManager->GetAt(syncPlayerId)->GetPosition(vecSyncPosition);
+		float fCloseness = (1.0f - ((vecPosition - vecSyncPosition).Length() / fRange));
+
+		if(fCloseness > 0.0f)
+			fPriority *= (1.0f + ((SNAPSHOT_NEAR_PRIORITY - 1.0f) * fCloseness));
+	}
+
+	return fPriority;
+}
+
+void CSnapshotManager::Pack(EntityId x, unsigned long ulTime)
+{
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	// Sort the pending entries by their priority
+	EntityId entries[MAX_PLAYERS];
+	float fPriorities[MAX_PLAYERS];
+	EntityId entryCount = 0;
+
+	for(size_t k = 0; k < players.size(); k++)
+	{
+		EntityId y = players[k];
+
+		if(!m_entries[x][y].bPending)
+			continue;
+
+		float fPriority = GetPriority(x, y, ulTime);
+		EntityId i = entryCount;
+
+		for(; i > 0 && fPriorities[i - 1] < fPriority; i--)
+		{
+			entries[i] = entries[i - 1];
+			fPriorities[i] = fPriorities[i - 1];
+		}
+
+		entries[i] = y;
+		fPriorities[i] = fPriority;
+		entryCount++;
+	}
+
+	// Pack as many pending syncs as fit in the budget into as few datagrams as possible,
+	// anything that doesn't fit stays queued and gains priority until it is sent
+	m_bPending[x] = false;
+	m_datagrams[x].uiCount = 0;
+	CBitStream * pBitStream = Begin(x, ulTime);
+	unsigned char ucCount = 0;
+
+	for(EntityId i = 0; i < entryCount; i++)
+	{
+		SnapshotEntry * pEntry = &m_entries[x][entries[i]];
+		unsigned int uiSize = pEntry->pBitStream->GetNumberOfBytesUsed();
+
+		// Does this entry not fit in the budget? Stop here so the budget
+		// is saved up for it instead of spent on lower priority entries
+		if((int)(uiSize + SNAPSHOT_ENTRY_HEADER_SIZE) > m_iBudget[x])
+		{
+			m_bPending[x] = true;
+			break;
+		}
+
+		// Would this entry make the datagram too big?
+		if(ucCount > 0 && (pBitStream->GetNumberOfBytesUsed() + uiSize) > SNAPSHOT_MAX_SIZE)
+		{
+			pBitStream->GetData()[RPC_HEADER_SIZE] = ucCount;
+			pBitStream = Begin(x, ulTime);
+			ucCount = 0;
+		}
+
+		// Entries are byte aligned (the header before them is whole bytes)
+		// so the client can read them in place
+		unsigned int uiStartSize = pBitStream->GetNumberOfBytesUsed();
+		pBitStream->Write(pEntry->rpcId);
+		pBitStream->WriteCompressed(uiSize);
+
+		// Time in ms the sync waited on the server (it may have been held back by the budget)
+		unsigned long ulAge = (ulTime - pEntry->ulSyncTime);
+		pBitStream->WriteCompressed((unsigned short)((ulAge > 0xFFFF) ? 0xFFFF : ulAge));
+		pBitStream->AlignWriteToByteBoundary();
+		pBitStream->Write((char *)pEntry->pBitStream->GetData(), uiSize);
+		ucCount++;
+		m_iBudget[x] -= (int)(pBitStream->GetNumberOfBytesUsed() - uiStartSize);
+		pEntry->bPending = false;
+		pEntry->ulLastSendTime = ulTime;
+	}
+
+	// Don't send the last datagram if nothing fit in it
+	if(ucCount > 0)
+		pBitStream->GetData()[RPC_HEADER_SIZE] = ucCount;
+	else
+		m_datagrams[x].uiCount--;
+}
+
+void CSnapshotManager::PackJob(unsigned int uiBegin, unsigned int uiEnd, void * pUserData)
+{
+	CSnapshotManager * pSnapshotManager = (CSnapshotManager *)pUserData;
+
+	for(unsigned int i = uiBegin; i < uiEnd; i++)
+		pSnapshotManager->Pack(pSnapshotManager->m_recipients[i], pSnapshotManager->m_ulLastProcessTime);
+}
+
+void CSnapshotManager::Process()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+	unsigned long ulElapsedTime = (ulTime - m_ulLastProcessTime);
+	m_ulLastProcessTime = ulTime;
+
+	// Find the clients that have something pending and budget left (the network
+	// stats are read here as they can't be read from the job threads)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+	m_recipients.clear();
+
+	for(size_t j = 0; j < players.size(); j++)
+	{
+		EntityId x = players[j];
+
+		if(m_bPending[x] && UpdateBudget(x, ulElapsedTime))
+			m_recipients.push_back(x);
+	}
+
+	// Packing only changes the state of the recipient itself (and reads the player
+	// positions) so the recipients are packed on all the job threads at once
+	if(g_pJobSystem && m_recipients.size() >= SNAPSHOT_PARALLEL_RECIPIENTS)
+		g_pJobSystem->ParallelFor(0, (unsigned int)m_recipients.size(), SNAPSHOT_PARALLEL_GRAIN, PackJob, this);
+	else
+		PackJob(0, (unsigned int)m_recipients.size(), this);
+
+	// Hand all the datagrams to the network at once instead of one call per datagram
+	m_sendDatagrams.clear();
+	m_sendPlayers.clear();
+
+	for(size_t j = 0; j < m_recipients.size(); j++)
+	{
+		EntityId x = m_recipients[j];
+
+		for(unsigned int i = 0; i < m_datagrams[x].uiCount; i++)
+		{
+			m_sendDatagrams.push_back(m_datagrams[x].datagrams[i]);
+			m_sendPlayers.push_back(x);
+		}
+	}
+
+	if(!m_sendDatagrams.empty())
+		g_pNetworkManager->RPCReservedBatch(RPC_SyncSnapshot, &m_sendDatagrams[0], &m_sendPlayers[0], (unsigned int)m_sendDatagrams.size(), PRIORITY_LOW, RELIABILITY_UNRELIABLE_SEQUENCED);
+}
@@ -0,0 +1,90 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSnapshotManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <vector>
+#include <Common.h>
+#include <Network/CBitStream.h>
+#include <Network/RPCIdentifiers.h>
+#include <Network/CNetServerInterface.h>
+
+// Size in bytes after which a snapshot is split into another datagram
+#define SNAPSHOT_MAX_SIZE 1200
+
+// Size of the rpc header, the entry count and the server time at the start of a snapshot
+#define SNAPSHOT_HEADER_SIZE (RPC_HEADER_SIZE + sizeof(unsigned char) + sizeof(unsigned int))
+
+// Worst case size of the rpc id, compressed size and compressed age written before each entry
+#define SNAPSHOT_ENTRY_HEADER_SIZE 9
+
+// Amount of ms worth of bandwidth a client can save up for a burst
+#define SNAPSHOT_BUDGET_BURST 250
+
+// Bytes of low priority data waiting in a clients send buffer after which
+// no more snapshots are queued for them until it drains
+#define SNAPSHOT_MAX_SEND_BUFFER (SNAPSHOT_MAX_SIZE * 4)
+
+// Priority multiplier of a player right next to the recipient (it falls off
+// to 1 at the edge of the sync range)
+#define SNAPSHOT_NEAR_PRIORITY 4.0f
+
+// Amount of recipients from which their snapshots are packed on all the job threads
+#define SNAPSHOT_PARALLEL_RECIPIENTS 8
+
+// Amount of recipients packed by a single job
+#define SNAPSHOT_PARALLEL_GRAIN 4
+
+// Latest sync of a single player queued for a single recipient
+struct SnapshotEntry
+{
+	bool          bPending;
+	RPCIdentifier rpcId;
+	CBitStream  * pBitStream;
+	unsigned long ulSyncTime;     // Server time the sync was received at
+	unsigned long ulLastSendTime;
+};
+
+// Datagrams packed for a single recipient in this tick
+struct SnapshotDatagrams
+{
+	std::vector<CBitStream *> datagrams; // Kept around and reused for every tick
+	unsigned int              uiCount;
+};
+
+class CSnapshotManager
+{
+private:
+	SnapshotEntry             m_entries[MAX_PLAYERS][MAX_PLAYERS];
+	bool                      m_bPending[MAX_PLAYERS];
+	int                       m_iBudget[MAX_PLAYERS];
+	SnapshotDatagrams         m_datagrams[MAX_PLAYERS];
+	std::vector<EntityId>     m_recipients; // Recipients that get snapshots in this tick
+	std::vector<CBitStream *> m_sendDatagrams; // Datagrams of this tick passed to the network in one batch
+	std::vector<EntityId>     m_sendPlayers; // Recipient of each datagram in m_sendDatagrams
+	unsigned int              m_uiBandwidth;
+	unsigned long             m_ulLastProcessTime;
+
+	CBitStream *  Begin(EntityId playerId, unsigned long ulTime);
+	bool          UpdateBudget(EntityId playerId, unsigned long ulElapsedTime);
+	float         GetPriority(EntityId playerId, EntityId syncPlayerId, unsigned long ulTime);
+	void          Pack(EntityId playerId, unsigned long ulTime);
+	static void   PackJob(unsigned int uiBegin, unsigned int uiEnd, void * pUserData);
+
+public:
+	CSnapshotManager();
+	~CSnapshotManager();
+
+	void          Queue(EntityId playerId, EntityId syncPlayerId, RPCIdentifier rpcId, CBitStream * pBitStream);
+	void          RemovePlayer(EntityId playerId);
+	void          SetBandwidth(unsigned int uiBandwidth) { m_uiBandwidth = uiBandwidth; }
+	unsigned int  GetBandwidth() { return m_uiBandwidth; }
+	void          Process();
+};
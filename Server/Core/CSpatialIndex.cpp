@@ -0,0 +1,218 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSpatialIndex.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <math.h>
+#include <algorithm>
+#include "CSpatialIndex.h"
+#include <CSettings.h>
+
+CSpatialIndex::CSpatialIndex()
+{
+	// Cells are the size of the sync range so the interest manager only ever
+	// has to check the cell a player is in and the 8 cells around it
+	m_fCellSize = CVAR_GET_FLOAT("syncrange");
+
+	if(m_fCellSize <= 0.0f)
+		m_fCellSize = SPATIAL_INDEX_CELL_SIZE;
+}
+
+CSpatialIndex::~CSpatialIndex()
+{
+
+}
+
+SpatialIndexCell CSpatialIndex::GetCell(float fX, float fY)
+{
+	SpatialIndexCell cell;
+	cell.iX = (int)floor(fX / m_fCellSize);
+	cell.iY = (int)floor(fY / m_fCellSize);
+	return cell;
+}
+
+void CSpatialIndex::AddToCell(eSpatialIndexType type, EntityId entityId, const SpatialIndexCell& cell)
+{
+	SpatialIndexEntry * pEntry = &m_entries[type][entityId];
+	SpatialIndexCellEntities * pCellEntities = &m_cells[type][cell];
+	pEntry->pCellEntities = pCellEntities;
+	pEntry->uiCellIndex = (unsigned int)pCellEntities->entities.size();
+	pCellEntities->entities.push_back(entityId);
+	pCellEntities->positions.Add(pEntry->vecPosition);
+}
+
+void CSpatialIndex::RemoveFromCell(eSpatialIndexType type, EntityId entityId)
+{
+	SpatialIndexEntry * pEntry = &m_entries[type][entityId];
+	SpatialIndexCellEntities * pCellEntities = pEntry->pCellEntities;
+
+	// The order within a cell doesn't matter so swap the entity with the last one
+	EntityId lastEntityId = pCellEntities->entities.back();
+	pCellEntities->entities[pEntry->uiCellIndex] = lastEntityId;
+	pCellEntities->entities.pop_back();
+	pCellEntities->positions.Remove(pEntry->uiCellIndex);
+	m_entries[type][lastEntityId].uiCellIndex = pEntry->uiCellIndex;
+	pEntry->pCellEntities = NULL;
+
+	// Don't keep empty cells around
+	if(pCellEntities->entities.empty())
+		m_cells[type].erase(pEntry->cell);
+}
+
+void CSpatialIndex::Update(eSpatialIndexType type, EntityId entityId, const CVector3& vecPosition, unsigned char ucDimension)
+{
+	if(type >= SPATIAL_INDEX_TYPE_MAX || entityId == INVALID_ENTITY_ID)
+		return;
+
+	std::vector<SpatialIndexEntry>& entries = m_entries[type];
+
+	if(entityId >= entries.size())
+	{
+		SpatialIndexEntry entry;
+		entry.bActive = false;
+		entries.resize((entityId + 1), entry);
+	}
+
+	SpatialIndexEntry * pEntry = &entries[entityId];
+	SpatialIndexCell cell = GetCell(vecPosition.fX, vecPosition.fY);
+	pEntry->vecPosition = vecPosition;
+	pEntry->ucDimension = ucDimension;
+
+	if(!pEntry->bActive)
+	{
+		pEntry->bActive = true;
+		AddToCell(type, entityId, cell);
+	}
+	else if(pEntry->cell < cell || cell < pEntry->cell)
+	{
+		// Move the entity to its new cell
+		RemoveFromCell(type, entityId);
+		AddToCell(type, entityId, cell);
+	}
+	else
+		pEntry->pCellEntities->positions.Set(pEntry->uiCellIndex, vecPosition);
+
+	pEntry->cell = cell;
+}
+
+void CSpatialIndex::Remove(eSpatialIndexType type, EntityId entityId)
+{
+	if(!Contains(type, entityId))
+		return;
+
+	RemoveFromCell(type, entityId);
+	m_entries[type][entityId].bActive = false;
+}
+
+bool CSpatialIndex::Contains(eSpatialIndexType type, EntityId entityId)
+{
+	if(type >= SPATIAL_INDEX_TYPE_MAX || entityId >= m_entries[type].size())
+		return false;
+
+	return m_entries[type][entityId].bActive;
+}
+
+bool CSpatialIndex::GetPosition(eSpatialIndexType type, EntityId entityId, CVector3& vecPosition, unsigned char& ucDimension)
+{
+	if(!Contains(type, entityId))
+		return false;
+
+	vecPosition = m_entries[type][entityId].vecPosition;
+	ucDimension = m_entries[type][entityId].ucDimension;
+	return true;
+}
+
+void CSpatialIndex::Query(eSpatialIndexType type, const CVector3& vecMin, const CVector3& vecMax, const CVector3 * pCenter, float fRadius, unsigned char ucDimension, std::vector<EntityId>& entities)
+{
+	if(type >= SPATIAL_INDEX_TYPE_MAX)
+		return;
+
+	std::map<SpatialIndexCell, SpatialIndexCellEntities >& cells = m_cells[type];
+	SpatialIndexCell minCell = GetCell(vecMin.fX, vecMin.fY);
+	SpatialIndexCell maxCell = GetCell(vecMax.fX, vecMax.fY);
+
+	// If the area covers more cells than are used go through the used cells
+	// instead of looking up every cell of the area
+	double dAreaCells = ((double)(maxCell.iX - minCell.iX + 1) * (double)(maxCell.iY - minCell.iY + 1));
+	bool bScanUsedCells = (dAreaCells > (double)cells.size());
+	std::map<SpatialIndexCell, SpatialIndexCellEntities >::iterator iter = cells.begin();
+	SpatialIndexCell cell = minCell;
+
+	while(true)
+	{
+		SpatialIndexCellEntities * pCellEntities = NULL;
+
+		if(bScanUsedCells)
+		{
+			if(iter == cells.end())
+				break;
+
+			if(iter->first.iX >= minCell.iX && iter->first.iX <= maxCell.iX && iter->first.iY >= minCell.iY && iter->first.iY <= maxCell.iY)
+				pCellEntities = &iter->second;
+
+			++iter;
+		}
+		else
+		{
+			if(cell.iX > maxCell.iX)
+				break;
+
+			iter = cells.find(cell);
+
+			if(iter != cells.end())
+				pCellEntities = &iter->second;
+
+			if(cell.iY < maxCell.iY)
+				cell.iY++;
+			else
+			{
+				cell.iY = minCell.iY;
+				cell.iX++;
+			}
+		}
+
+		if(!pCellEntities)
+			continue;
+
+		// Range check the whole cell at once, then filter the matches by dimension
+		if(m_cellMatches.size() < pCellEntities->entities.size())
+			m_cellMatches.resize(pCellEntities->entities.size());
+
+		unsigned int uiMatches;
+
+		if(pCenter)
+			uiMatches = pCellEntities->positions.FindInSphere(*pCenter, fRadius, &m_cellMatches[0]);
+		else
+			uiMatches = pCellEntities->positions.FindInBox(vecMin, vecMax, &m_cellMatches[0]);
+
+		for(unsigned int i = 0; i < uiMatches; i++)
+		{
+			EntityId entityId = pCellEntities->entities[m_cellMatches[i]];
+
+			if(ucDimension != SPATIAL_INDEX_ALL_DIMENSIONS && m_entries[type][entityId].ucDimension != ucDimension)
+				continue;
+
+			entities.push_back(entityId);
+		}
+	}
+}
+
+void CSpatialIndex::GetInRange(eSpatialIndexType type, const CVector3& vecPosition, float fRadius, unsigned char ucDimension, std::vector<EntityId>& entities)
+{
+	if(fRadius < 0.0f)
+		return;
+
+	Query(type, (vecPosition - fRadius), (vecPosition + fRadius), &vecPosition, fRadius, ucDimension, entities);
+}
+
+void CSpatialIndex::GetInBox(eSpatialIndexType type, const CVector3& vecMin, const CVector3& vecMax, unsigned char ucDimension, std::vector<EntityId>& entities)
+{
+	// Allow the corners to be given in any order
+	CVector3 vecBoxMin(std::min(vecMin.fX, vecMax.fX), std::min(vecMin.fY, vecMax.fY), std::min(vecMin.fZ, vecMax.fZ));
+	CVector3 vecBoxMax(std::max(vecMin.fX, vecMax.fX), std::max(vecMin.fY, vecMax.fY), std::max(vecMin.fZ, vecMax.fZ));
+	Query(type, vecBoxMin, vecBoxMax, NULL, 0.0f, ucDimension, entities);
+}
@@ -0,0 +1,98 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSpatialIndex.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <vector>
+#include <Common.h>
+#include <Math/CPositionBatch.h>
+
+// Size of the grid cells if no sync range is set
+#define SPATIAL_INDEX_CELL_SIZE 100.0f
+
+// Dimension to query the entities of all dimensions with
+#define SPATIAL_INDEX_ALL_DIMENSIONS 0xFF
+
+// Types of entity the spatial index keeps the positions of
+enum eSpatialIndexType
+{
+	SPATIAL_INDEX_PLAYER,
+	SPATIAL_INDEX_VEHICLE,
+	SPATIAL_INDEX_OBJECT,
+	SPATIAL_INDEX_PICKUP,
+	SPATIAL_INDEX_CHECKPOINT,
+	SPATIAL_INDEX_BLIP,
+	SPATIAL_INDEX_TYPE_MAX
+};
+
+// Key for a single cell of the spatial grid
+struct SpatialIndexCell
+{
+	int iX;
+	int iY;
+
+	bool operator < (const SpatialIndexCell& other) const
+	{
+		if(iX != other.iX)
+			return (iX < other.iX);
+
+		return (iY < other.iY);
+	}
+};
+
+// Entities of a single cell, the positions are kept next to each other so the
+// cell can be range checked in one go
+struct SpatialIndexCellEntities
+{
+	std::vector<EntityId> entities;
+	CPositionBatch        positions; // Position of the entity at the same index
+};
+
+// Entry of a single entity in the spatial grid
+struct SpatialIndexEntry
+{
+	bool                       bActive;
+	CVector3                   vecPosition;
+	unsigned char              ucDimension;
+	SpatialIndexCell           cell;
+	SpatialIndexCellEntities * pCellEntities; // Entities of the cell (map nodes don't move)
+	unsigned int               uiCellIndex; // Index in pCellEntities
+};
+
+// Uniform grid of the positions of all entities, it is kept up to date by the
+// entities themselves whenever they move so queries never scan all entities
+class CSpatialIndex
+{
+private:
+	float                                                   m_fCellSize;
+	std::map<SpatialIndexCell, SpatialIndexCellEntities >   m_cells[SPATIAL_INDEX_TYPE_MAX];
+	std::vector<SpatialIndexEntry>                          m_entries[SPATIAL_INDEX_TYPE_MAX];
+	std::vector<unsigned int>                               m_cellMatches; // Indices of the matches in the cell that is queried
+
+	SpatialIndexCell GetCell(float fX, float fY);
+	void             AddToCell(eSpatialIndexType type, EntityId entityId, const SpatialIndexCell& cell);
+	void             RemoveFromCell(eSpatialIndexType type, EntityId entityId);
+	void             Query(eSpatialIndexType type, const CVector3& vecMin, const CVector3& vecMax, const CVector3 * pCenter, float fRadius, unsigned char ucDimension, std::vector<EntityId>& entities);
+
+public:
+	CSpatialIndex();
+	~CSpatialIndex();
+
+	float            GetCellSize() { return m_fCellSize; }
+	void             Update(eSpatialIndexType type, EntityId entityId, const CVector3& vecPosition, unsigned char ucDimension);
+	void             Remove(eSpatialIndexType type, EntityId entityId);
+	bool             Contains(eSpatialIndexType type, EntityId entityId);
+	bool             GetPosition(eSpatialIndexType type, EntityId entityId, CVector3& vecPosition, unsigned char& ucDimension);
+
+	// Adds all entities of the type within the radius (or inside the box) to the list
+	void             GetInRange(eSpatialIndexType type, const CVector3& vecPosition, float fRadius, unsigned char ucDimension, std::vector<EntityId>& entities);
+	void             GetInBox(eSpatialIndexType type, const CVector3& vecMin, const CVector3& vecMax, unsigned char ucDimension, std::vector<EntityId>& entities);
+};
@@ -0,0 +1,266 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTickProfiler.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <algorithm>
+#include "CTickProfiler.h"
+#include "CTickScheduler.h"
+#include "CModuleManager.h"
+#include <Scripting/CScriptingManager.h>
+#include <CSettings.h>
+#include <SharedUtility.h>
+#include <CTraceRecorder.h>
+
+extern CTickScheduler * g_pTickScheduler;
+extern CModuleManager * g_pModuleManager;
+extern CScriptingManager * g_pScriptingManager;
+
+static const char * g_szTickStageNames[TICK_STAGE_MAX] =
+{
+	"packets",
+	"scriptcoroutines",
+	"packetrecorder",
+	"network",
+	"clientevents",
+	"snapshots",
+	"joinstreamer",
+	"entitystreamer",
+	"zones",
+	"vehicles",
+	"objects",
+	"actors",
+	"query",
+	"masterlist",
+	"scriptwatchdog",
+	"sqliteworker",
+	"fileworker",
+	"worldsnapshot",
+	"bans",
+	"world",
+	"httprequests",
+	"webrequests",
+	"messagebus",
+	"scriptreloads",
+	"scripttimers",
+	"modules",
+	"serverpulse",
+	"console",
+	"entitydata",
+	"commands",
+	"scriptgc"
+};
+
+CTickProfiler::CTickProfiler()
+{
+	m_bEnabled = CVAR_GET_BOOL("tickprofiler");
+	m_ullTickStartTime = 0;
+	m_ullStageStartTime = 0;
+	m_currentStage = TICK_STAGE_NONE;
+	memset(m_uiStageTimes, 0, sizeof(m_uiStageTimes));
+	m_uiNextSample = 0;
+	m_uiSampleCount = 0;
+}
+
+CTickProfiler::~CTickProfiler()
+{
+
+}
+
+const char * CTickProfiler::GetStageName(eTickStage stage)
+{
+	if(stage >= TICK_STAGE_MAX)
+		return "none";
+
+	return g_szTickStageNames[stage];
+}
+
+void CTickProfiler::BeginTick()
+{
+	StopStage();
+
+	// The stages are also timed for the trace recorder while the profiler is disabled
+	if(!m_bEnabled && !CTraceRecorder::IsEnabled())
+	{
+		m_ullTickStartTime = 0;
+		return;
+	}
+
+	m_ullTickStartTime = SharedUtility::GetMicroseconds();
+}
+
+void CTickProfiler::EndTick()
+{
+	StopStage();
+
+	if(m_ullTickStartTime == 0)
+		return;
+
+	unsigned long long ullTime = SharedUtility::GetMicroseconds();
+
+	if(CTraceRecorder::IsEnabled())
+		CTraceRecorder::Record(TRACE_CATEGORY_TICK, "tick", -1, m_ullTickStartTime, ullTime);
+
+	if(!m_bEnabled)
+		return;
+
+	unsigned int uiTickTime = (unsigned int)(ullTime - m_ullTickStartTime);
+
+	// Store the times of this tick over the oldest ones
+	m_mutex.Lock();
+	m_uiTickSamples[m_uiNextSample] = uiTickTime;
+
+	for(int i = 0; i < TICK_STAGE_MAX; i++)
+		m_uiStageSamples[i][m_uiNextSample] = m_uiStageTimes[i];
+
+	m_uiNextSample = ((m_uiNextSample + 1) % TICK_PROFILER_SAMPLES);
+
+	if(m_uiSampleCount < TICK_PROFILER_SAMPLES)
+		m_uiSampleCount++;
+
+	m_mutex.Unlock();
+	memset(m_uiStageTimes, 0, sizeof(m_uiStageTimes));
+}
+
+void CTickProfiler::EndStage(unsigned long long ullTime)
+{
+	if(m_bEnabled)
+		m_uiStageTimes[m_currentStage] += (unsigned int)(ullTime - m_ullStageStartTime);
+
+	if(CTraceRecorder::IsEnabled())
+		CTraceRecorder::Record(TRACE_CATEGORY_STAGE, g_szTickStageNames[m_currentStage], -1, m_ullStageStartTime, ullTime);
+}
+
+void CTickProfiler::StartStage(eTickStage stage)
+{
+	if(!m_bEnabled && !CTraceRecorder::IsEnabled())
+	{
+		m_currentStage = TICK_STAGE_NONE;
+		return;
+	}
+
+	unsigned long long ullTime = SharedUtility::GetMicroseconds();
+
+	if(m_currentStage != TICK_STAGE_NONE)
+		EndStage(ullTime);
+
+	m_currentStage = stage;
+	m_ullStageStartTime = ullTime;
+}
+
+void CTickProfiler::StopStage()
+{
+	if(m_currentStage == TICK_STAGE_NONE)
+		return;
+
+	if(m_bEnabled || CTraceRecorder::IsEnabled())
+		EndStage(SharedUtility::GetMicroseconds());
+
+	m_currentStage = TICK_STAGE_NONE;
+}
+
+void CTickProfiler::GetSampleStats(unsigned int * pSamples, unsigned int uiSampleCount, TickStageStats * pStats)
+{
+	memset(pStats, 0, sizeof(TickStageStats));
+
+	if(uiSampleCount == 0)
+		return;
+
+	unsigned long long ullTotal = 0;
+
+	for(unsigned int i = 0; i < uiSampleCount; i++)
+	{
+		ullTotal += pSamples[i];
+		pStats->uiMax = std::max(pStats->uiMax, pSamples[i]);
+	}
+
+	pStats->uiAverage = (unsigned int)(ullTotal / uiSampleCount);
+
+	// The samples are a copy so they can be reordered
+	unsigned int uiP50 = (uiSampleCount / 2);
+	std::nth_element(pSamples, pSamples + uiP50, pSamples + uiSampleCount);
+	pStats->uiP50 = pSamples[uiP50];
+	unsigned int uiP99 = std::min(((uiSampleCount * 99) / 100), (uiSampleCount - 1));
+	std::nth_element(pSamples, pSamples + uiP99, pSamples + uiSampleCount);
+	pStats->uiP99 = pSamples[uiP99];
+}
+
+unsigned int CTickProfiler::GetStats(TickStageStats * pTickStats, TickStageStats * pStageStats)
+{
+	// Copy the samples so the tick isn't held up while we sort them
+	unsigned int uiSamples[TICK_PROFILER_SAMPLES];
+	m_mutex.Lock();
+	unsigned int uiSampleCount = m_uiSampleCount;
+	memcpy(uiSamples, m_uiTickSamples, (uiSampleCount * sizeof(unsigned int)));
+	m_mutex.Unlock();
+	GetSampleStats(uiSamples, uiSampleCount, pTickStats);
+
+	for(int i = 0; i < TICK_STAGE_MAX; i++)
+	{
+		m_mutex.Lock();
+		memcpy(uiSamples, m_uiStageSamples[i], (uiSampleCount * sizeof(unsigned int)));
+		m_mutex.Unlock();
+		GetSampleStats(uiSamples, uiSampleCount, &pStageStats[i]);
+	}
+
+	return uiSampleCount;
+}
+
+String CTickProfiler::GetJSON()
+{
+	TickStageStats tickStats;
+	TickStageStats stageStats[TICK_STAGE_MAX];
+	unsigned int uiSampleCount = GetStats(&tickStats, stageStats);
+	const TickSchedulerStats * pSchedulerStats = g_pTickScheduler->GetStats();
+
+	// All times are in microseconds
+	String strJSON("{\"tickrate\": %d, \"ticks\": %lu, \"overruns\": %lu, \"skippedticks\": %lu, \"samples\": %d, ",
+		pSchedulerStats->uiTickRate, pSchedulerStats->ulTicks, pSchedulerStats->ulOverruns, pSchedulerStats->ulSkippedTicks, uiSampleCount);
+	strJSON.AppendF("\"tick\": {\"avg\": %d, \"p50\": %d, \"p99\": %d, \"max\": %d}, \"stages\": {", tickStats.uiAverage, tickStats.uiP50, tickStats.uiP99, tickStats.uiMax);
+
+	for(int i = 0; i < TICK_STAGE_MAX; i++)
+	{
+		strJSON.AppendF("%s\"%s\": {\"avg\": %d, \"p50\": %d, \"p99\": %d, \"max\": %d}", (i > 0 ? ", " : ""), g_szTickStageNames[i],
+			stageStats[i].uiAverage, stageStats[i].uiP50, stageStats[i].uiP99, stageStats[i].uiMax);
+	}
+
+	// Modules are timed even with the profiler disabled, their times are since they were loaded
+	std::vector<ModuleProfile> moduleProfiles;
+	g_pModuleManager->GetProfiles(moduleProfiles);
+	strJSON.Append("}, \"modules\": {");
+
+	for(unsigned int i = 0; i < moduleProfiles.size(); i++)
+	{
+		const ModuleProfile& profile = moduleProfiles[i];
+		strJSON.AppendF("%s\"%s\": {\"pulses\": %lu, \"avg\": %d, \"last\": %d, \"max\": %d", (i > 0 ? ", " : ""), profile.strName.Get(), profile.pulseStats.ulPulses,
+			(profile.pulseStats.ulPulses > 0 ? (unsigned int)(profile.pulseStats.ullTotalTime / profile.pulseStats.ulPulses) : 0), profile.pulseStats.uiLastTime, profile.pulseStats.uiMaxTime);
+
+		if(profile.bAsyncPulse)
+		{
+			strJSON.AppendF(", \"async\": {\"pulses\": %lu, \"avg\": %d, \"last\": %d, \"max\": %d}", profile.asyncPulseStats.ulPulses,
+				(profile.asyncPulseStats.ulPulses > 0 ? (unsigned int)(profile.asyncPulseStats.ullTotalTime / profile.asyncPulseStats.ulPulses) : 0),
+				profile.asyncPulseStats.uiLastTime, profile.asyncPulseStats.uiMaxTime);
+		}
+
+		strJSON.Append("}");
+	}
+
+	// The cycle collections of the scripts since they were loaded
+	std::list<CSquirrel *> * pScripts = g_pScriptingManager->GetScriptList();
+	strJSON.Append("}, \"scriptgc\": {");
+
+	for(std::list<CSquirrel *>::iterator iter = pScripts->begin(); iter != pScripts->end(); ++iter)
+	{
+		const SquirrelGCStats& stats = (*iter)->GetGCStats();
+		strJSON.AppendF("%s\"%s\": {\"collections\": %d, \"freed\": %d, \"lastfreed\": %d, \"avg\": %d, \"last\": %d, \"max\": %d}", (iter != pScripts->begin() ? ", " : ""),
+			(*iter)->GetName().Get(), stats.uiCollections, stats.uiFreed, stats.uiLastFreed, (stats.uiCollections > 0 ? (unsigned int)(stats.ullTotalTime / stats.uiCollections) : 0),
+			stats.uiLastTime, stats.uiMaxTime);
+	}
+
+	strJSON.Append("}}");
+	return strJSON;
+}
@@ -0,0 +1,106 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTickProfiler.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <CString.h>
+#include <Threading/CMutex.h>
+
+// Amount of ticks the rolling statistics are taken over
+#define TICK_PROFILER_SAMPLES 1024
+
+// Uri of the webserver the statistics are served at
+#define TICK_PROFILER_URI "/tickprofiler"
+
+// The stages of the server tick, packets are handled between the ticks so
+// their time is the total since the last tick
+enum eTickStage
+{
+	TICK_STAGE_PACKETS,
+	TICK_STAGE_SCRIPT_COROUTINES,
+	TICK_STAGE_PACKET_RECORDER,
+	TICK_STAGE_NETWORK,
+	TICK_STAGE_CLIENT_EVENTS,
+	TICK_STAGE_SNAPSHOTS,
+	TICK_STAGE_JOIN_STREAMER,
+	TICK_STAGE_ENTITY_STREAMER,
+	TICK_STAGE_ZONES,
+	TICK_STAGE_VEHICLES,
+	TICK_STAGE_OBJECTS,
+	TICK_STAGE_ACTORS,
+	TICK_STAGE_QUERY,
+	TICK_STAGE_MASTER_LIST,
+	TICK_STAGE_SCRIPT_WATCHDOG,
+	TICK_STAGE_SQLITE_WORKER,
+	TICK_STAGE_FILE_WORKER,
+	TICK_STAGE_WORLD_SNAPSHOT,
+	TICK_STAGE_BANS,
+	TICK_STAGE_WORLD,
+	TICK_STAGE_HTTP_REQUESTS,
+	TICK_STAGE_WEB_REQUESTS,
+	TICK_STAGE_MESSAGE_BUS,
+	TICK_STAGE_SCRIPT_RELOADS,
+	TICK_STAGE_SCRIPT_TIMERS,
+	TICK_STAGE_MODULES,
+	TICK_STAGE_SERVER_PULSE,
+	TICK_STAGE_CONSOLE,
+	TICK_STAGE_ENTITY_DATA,
+	TICK_STAGE_COMMANDS,
+	TICK_STAGE_SCRIPT_GC, // In the idle time after the tick, counted in the next tick
+	TICK_STAGE_MAX,
+	TICK_STAGE_NONE = TICK_STAGE_MAX
+};
+
+// Rolling statistics of a stage (or the whole tick), all times are in microseconds
+struct TickStageStats
+{
+	unsigned int uiAverage;
+	unsigned int uiP50;
+	unsigned int uiP99;
+	unsigned int uiMax;
+};
+
+class CTickProfiler
+{
+private:
+	bool               m_bEnabled;
+	unsigned long long m_ullTickStartTime;
+	unsigned long long m_ullStageStartTime;
+	eTickStage         m_currentStage;
+	unsigned int       m_uiStageTimes[TICK_STAGE_MAX];
+	CMutex             m_mutex;
+	unsigned int       m_uiTickSamples[TICK_PROFILER_SAMPLES];
+	unsigned int       m_uiStageSamples[TICK_STAGE_MAX][TICK_PROFILER_SAMPLES];
+	unsigned int       m_uiNextSample;
+	unsigned int       m_uiSampleCount;
+
+	static void        GetSampleStats(unsigned int * pSamples, unsigned int uiSampleCount, TickStageStats * pStats);
+	void               EndStage(unsigned long long ullTime);
+
+public:
+	CTickProfiler();
+	~CTickProfiler();
+
+	static const char * GetStageName(eTickStage stage);
+
+	bool               IsEnabled() { return m_bEnabled; }
+	void               BeginTick();
+	void               EndTick();
+
+	// Starts timing a stage, the stage that was timed (if any) is stopped
+	void               StartStage(eTickStage stage);
+	void               StopStage();
+
+	// Gets the statistics of the whole tick and of every stage (pStageStats
+	// must have TICK_STAGE_MAX entries), returns the amount of ticks they are over
+	unsigned int       GetStats(TickStageStats * pTickStats, TickStageStats * pStageStats);
+
+	String             GetJSON();
+};
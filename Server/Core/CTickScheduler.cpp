@@ -0,0 +1,171 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTickScheduler.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#ifdef WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#else
+#include <sched.h>
+#endif
+
+#include "CTickScheduler.h"
+#include "CNetworkManager.h"
+#include <CSettings.h>
+#include <SharedUtility.h>
+
+extern CNetworkManager * g_pNetworkManager;
+
+CTickScheduler::CTickScheduler()
+{
+#ifdef WIN32
+	// Make Sleep as accurate as the system allows
+	timeBeginPeriod(1);
+#endif
+
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_ullTickStartTime = 0;
+	m_bIdle = false;
+
+	// Get the tick rates from the settings
+	SetTickRate((unsigned int)CVAR_GET_INTEGER("servertickrate"));
+	SetIdleTickRate((unsigned int)CVAR_GET_INTEGER("idletickrate"));
+}
+
+CTickScheduler::~CTickScheduler()
+{
+#ifdef WIN32
+	timeEndPeriod(1);
+#endif
+}
+
+void CTickScheduler::SetTickRate(unsigned int uiTickRate)
+{
+	if(uiTickRate == 0)
+		uiTickRate = 1;
+
+	m_uiTickRate = uiTickRate;
+	m_stats.uiTickRate = uiTickRate;
+	m_ullTickInterval = (1000000 / uiTickRate);
+	m_ullNextTickTime = SharedUtility::GetMicroseconds();
+}
+
+void CTickScheduler::SetIdleTickRate(unsigned int uiIdleTickRate)
+{
+	// Idle ticks can't be faster than the normal ones
+	if(uiIdleTickRate > m_uiTickRate)
+		uiIdleTickRate = m_uiTickRate;
+
+	m_uiIdleTickRate = uiIdleTickRate;
+	m_ullIdleTickInterval = (uiIdleTickRate > 0 ? (1000000 / uiIdleTickRate) : m_ullTickInterval);
+
+	if(uiIdleTickRate == 0)
+		SetIdle(false);
+}
+
+bool CTickScheduler::SetIdle(bool bIdle)
+{
+	if(m_uiIdleTickRate == 0)
+		bIdle = false;
+
+	if(bIdle == m_bIdle)
+		return false;
+
+	m_bIdle = bIdle;
+	m_stats.bIdle = bIdle;
+
+	// Run the next tick at once instead of when the next idle tick would be due
+	if(!bIdle)
+		m_ullNextTickTime = SharedUtility::GetMicroseconds();
+
+	return true;
+}
+
+bool CTickScheduler::IsTickDue()
+{
+	return (SharedUtility::GetMicroseconds() >= m_ullNextTickTime);
+}
+
+void CTickScheduler::BeginTick()
+{
+	m_ullTickStartTime = SharedUtility::GetMicroseconds();
+
+	// Schedule the next tick from when this one was due (not when it started) so
+	// the rate stays fixed, if we are too far behind skip the missed ticks
+	unsigned long long ullTickInterval = GetTickInterval();
+	m_ullNextTickTime += ullTickInterval;
+
+	if(m_ullTickStartTime > m_ullNextTickTime + (ullTickInterval * TICK_SCHEDULER_MAX_CATCH_UP))
+	{
+		unsigned long long ullMissedTicks = ((m_ullTickStartTime - m_ullNextTickTime) / ullTickInterval);
+		m_stats.ulSkippedTicks += (unsigned long)ullMissedTicks;
+		m_ullNextTickTime += (ullMissedTicks * ullTickInterval);
+	}
+}
+
+void CTickScheduler::EndTick()
+{
+	unsigned long long ullTickTime = (SharedUtility::GetMicroseconds() - m_ullTickStartTime);
+	m_stats.ulTicks++;
+	m_stats.ullTotalTickTime += ullTickTime;
+	m_stats.ulLastTickTime = (unsigned long)ullTickTime;
+
+	if(ullTickTime > m_stats.ulMaxTickTime)
+		m_stats.ulMaxTickTime = (unsigned long)ullTickTime;
+
+	// Did the tick take longer than we have for it?
+	if(ullTickTime > GetTickInterval())
+		m_stats.ulOverruns++;
+}
+
+void CTickScheduler::Wait()
+{
+	unsigned long long ullTime = SharedUtility::GetMicroseconds();
+
+	while(ullTime < m_ullNextTickTime)
+	{
+		unsigned long long ullTimeLeft = (m_ullNextTickTime - ullTime);
+
+		if(ullTimeLeft > TICK_SCHEDULER_SPIN_TIME)
+		{
+			// Sleep until shortly before the tick is due, but wake up as soon
+			// as packets arrive so they are handled without delay
+			if(g_pNetworkManager->WaitForPackets((unsigned int)((ullTimeLeft - TICK_SCHEDULER_SPIN_TIME) / 1000)))
+				return;
+		}
+		else
+		{
+			// Give up the rest of our time slice until the tick is due
+#ifdef WIN32
+			Sleep(0);
+#else
+			sched_yield();
+#endif
+		}
+
+		ullTime = SharedUtility::GetMicroseconds();
+	}
+}
+
+unsigned int CTickScheduler::GetTimeUntilNextTick()
+{
+	unsigned long long ullTime = SharedUtility::GetMicroseconds();
+
+	if(ullTime >= m_ullNextTickTime)
+		return 0;
+
+	return (unsigned int)(m_ullNextTickTime - ullTime);
+}
+
+unsigned long CTickScheduler::GetAverageTickTime()
+{
+	if(m_stats.ulTicks == 0)
+		return 0;
+
+	return (unsigned long)(m_stats.ullTotalTickTime / m_stats.ulTicks);
+}
@@ -0,0 +1,70 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTickScheduler.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+
+// Time in microseconds before a tick is due at which we stop sleeping and
+// only yield so the tick starts on time
+#define TICK_SCHEDULER_SPIN_TIME 1000
+
+// If we are this many ticks behind the missed ticks are skipped instead of
+// being caught up on
+#define TICK_SCHEDULER_MAX_CATCH_UP 5
+
+// Statistics of the server tick schedule, all times are in microseconds
+struct TickSchedulerStats
+{
+	unsigned int       uiTickRate;
+	bool               bIdle;
+	unsigned long      ulTicks;
+	unsigned long      ulOverruns;
+	unsigned long      ulSkippedTicks;
+	unsigned long long ullTotalTickTime;
+	unsigned long      ulMaxTickTime;
+	unsigned long      ulLastTickTime;
+};
+
+class CTickScheduler
+{
+private:
+	unsigned int       m_uiTickRate;
+	unsigned int       m_uiIdleTickRate; // 0 if the server is never idle
+	bool               m_bIdle;
+	unsigned long long m_ullTickInterval;
+	unsigned long long m_ullIdleTickInterval;
+	unsigned long long m_ullNextTickTime;
+	unsigned long long m_ullTickStartTime;
+	TickSchedulerStats m_stats;
+
+public:
+	CTickScheduler();
+	~CTickScheduler();
+
+	unsigned int               GetTickRate() { return m_uiTickRate; }
+	void                       SetTickRate(unsigned int uiTickRate);
+
+	// While idle (no players are connected) the ticks run at the idle tick rate,
+	// the wait for the next tick still returns as soon as packets arrive.
+	// Returns true if the idle state changed.
+	void                       SetIdleTickRate(unsigned int uiIdleTickRate);
+	bool                       SetIdle(bool bIdle);
+	bool                       IsIdle() { return m_bIdle; }
+	unsigned long long         GetTickInterval() { return (m_bIdle ? m_ullIdleTickInterval : m_ullTickInterval); }
+	bool                       IsTickDue();
+	void                       BeginTick();
+	void                       EndTick();
+	void                       Wait();
+
+	// Returns the microseconds until the next tick is due, 0 if it is due
+	unsigned int               GetTimeUntilNextTick();
+	const TickSchedulerStats * GetStats() { return &m_stats; }
+	unsigned long              GetAverageTickTime();
+};
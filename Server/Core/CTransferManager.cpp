@@ -0,0 +1,230 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTransferManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <time.h>
+#include <stdlib.h>
+#include "CTransferManager.h"
+#include "CNetworkManager.h"
+#include "CPlayerManager.h"
+#include <CSettings.h>
+#include <CLogFile.h>
+#include <CEvents.h>
+#include <SharedUtility.h>
+#include <Network/CBitStream.h>
+
+extern CNetworkManager * g_pNetworkManager;
+extern CPlayerManager * g_pPlayerManager;
+extern CEvents * g_pEvents;
+
+// Length of the signature at the end of a token
+#define TRANSFER_SIGNATURE_LENGTH 64
+
+static const char g_szHexDigits[] = "0123456789abcdef";
+
+static String ToHex(const unsigned char * pData, unsigned int uiLength)
+{
+	String strHex;
+
+	for(unsigned int i = 0; i < uiLength; i++)
+	{
+		strHex += (unsigned char)g_szHexDigits[pData[i] >> 4];
+		strHex += (unsigned char)g_szHexDigits[pData[i] & 0xF];
+	}
+
+	return strHex;
+}
+
+static int FromHexDigit(char c)
+{
+	if(c >= '0' && c <= '9')
+		return (c - '0');
+
+	if(c >= 'a' && c <= 'f')
+		return (c - 'a' + 10);
+
+	return -1;
+}
+
+CTransferManager::CTransferManager()
+{
+
+}
+
+CTransferManager::~CTransferManager()
+{
+
+}
+
+String CTransferManager::Sign(const String& strSecret, const String& strPayload)
+{
+	// The secret goes into both hashes so the signature can't be extended like a plain hash
+	String strInner = strSecret;
+	strInner += strPayload;
+	String strOuter = strSecret;
+	strOuter += SharedUtility::HashSHA256(strInner);
+	return SharedUtility::HashSHA256(strOuter);
+}
+
+bool CTransferManager::Transfer(EntityId playerId, const String& strHost, unsigned short usPort, const String& strPassword, const String& strData)
+{
+	String strSecret = CVAR_GET_STRING("transfersecret");
+
+	if(strSecret.IsEmpty() || strHost.IsEmpty() || strData.GetLength() > TRANSFER_MAX_DATA_LENGTH)
+		return false;
+
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer)
+		return false;
+
+	CVector3 vecPosition;
+	pPlayer->GetPosition(vecPosition);
+
+	CBitStream bsPayload;
+	bsPayload.Write((unsigned char)TRANSFER_TOKEN_VERSION);
+	bsPayload.Write((unsigned int)time(NULL));
+	bsPayload.Write((unsigned int)rand()); // Tokens of the same second differ
+	bsPayload.Write(pPlayer->GetName());
+	bsPayload.Write(pPlayer->GetSerial());
+	bsPayload.WriteBit(pPlayer->AreGameFilesModded());
+	bsPayload.Write(pPlayer->GetModel());
+	bsPayload.Write(vecPosition);
+	bsPayload.Write(pPlayer->GetCurrentHeading());
+	bsPayload.Write(pPlayer->GetMoney());
+	bsPayload.Write(CVAR_GET_STRING("hostname"));
+	bsPayload.Write(strData);
+
+	String strToken = ToHex(bsPayload.GetData(), bsPayload.GetNumberOfBytesUsed());
+	strToken += Sign(strSecret, strToken);
+
+	CBitStream bsSend;
+	bsSend.Write(strHost);
+	bsSend.Write(usPort);
+	bsSend.Write(strPassword);
+	bsSend.Write(strToken);
+	g_pNetworkManager->RPC(RPC_PlayerTransfer, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+	CLogFile::Printf("[Transfer] %s is transferred to %s:%d.", pPlayer->GetName().Get(), strHost.Get(), usPort);
+	return true;
+}
+
+bool CTransferManager::ReadToken(const String& strToken, const String& strSerial, PlayerTransferState& state)
+{
+	String strSecret = CVAR_GET_STRING("transfersecret");
+	size_t sLength = strToken.GetLength();
+
+	if(strSecret.IsEmpty() || sLength <= TRANSFER_SIGNATURE_LENGTH || ((sLength - TRANSFER_SIGNATURE_LENGTH) % 2) != 0)
+		return false;
+
+	String strPayload = strToken.SubStr(0, (sLength - TRANSFER_SIGNATURE_LENGTH));
+	String strSignature = strToken.SubStr(sLength - TRANSFER_SIGNATURE_LENGTH);
+	String strExpected = Sign(strSecret, strPayload);
+
+	// Compare all of the signature so the time doesn't tell how much of it was right
+	unsigned char ucDifference = 0;
+
+	for(size_t i = 0; i < TRANSFER_SIGNATURE_LENGTH; i++)
+		ucDifference |= (strSignature.Get()[i] ^ strExpected.Get()[i]);
+
+	if(ucDifference != 0)
+		return false;
+
+	unsigned int uiSize = (unsigned int)(strPayload.GetLength() / 2);
+	unsigned char * pData = new unsigned char[uiSize];
+
+	for(unsigned int i = 0; i < uiSize; i++)
+	{
+		int iHigh = FromHexDigit(strPayload.Get()[i * 2]);
+		int iLow = FromHexDigit(strPayload.Get()[i * 2 + 1]);
+
+		if(iHigh < 0 || iLow < 0)
+		{
+			delete [] pData;
+			return false;
+		}
+
+		pData[i] = (unsigned char)((iHigh << 4) | iLow);
+	}
+
+	CBitStream bsPayload(pData, uiSize, true);
+	delete [] pData;
+
+	unsigned char ucVersion;
+	unsigned int uiIssueTime;
+	unsigned int uiNonce;
+
+	if(!bsPayload.Read(ucVersion) || ucVersion != TRANSFER_TOKEN_VERSION || !bsPayload.Read(uiIssueTime) || !bsPayload.Read(uiNonce) ||
+		!bsPayload.Read(state.strName) || !bsPayload.Read(state.strSerial))
+		return false;
+
+	state.bGameFilesModded = bsPayload.ReadBit();
+
+	if(!bsPayload.Read(state.iModel) || !bsPayload.Read(state.vecPosition) || !bsPayload.Read(state.fHeading) || !bsPayload.Read(state.iMoney) ||
+		!bsPayload.Read(state.strOrigin) || !bsPayload.Read(state.strData))
+		return false;
+
+	// The token only works for a short while and only for the client it was given to
+	unsigned int uiTime = (unsigned int)time(NULL);
+	unsigned int uiExpiryTime = (uiIssueTime + CVAR_GET_INTEGER("transfertimeout"));
+
+	if(uiIssueTime > (uiTime + TRANSFER_CLOCK_TOLERANCE) || uiTime > uiExpiryTime || state.strSerial != strSerial)
+		return false;
+
+	// Forget the tokens that expired, they are refused by their time now
+	for(std::map<String, unsigned int>::iterator iter = m_usedTokens.begin(); iter != m_usedTokens.end(); )
+	{
+		if(uiTime > (*iter).second)
+			m_usedTokens.erase(iter++);
+		else
+			iter++;
+	}
+
+	if(m_usedTokens.find(strSignature) != m_usedTokens.end())
+		return false;
+
+	m_usedTokens[strSignature] = uiExpiryTime;
+	return true;
+}
+
+void CTransferManager::AddPlayer(EntityId playerId, const PlayerTransferState& state)
+{
+	m_players[playerId] = state;
+}
+
+void CTransferManager::Join(EntityId playerId)
+{
+	std::map<EntityId, PlayerTransferState>::iterator iter = m_players.find(playerId);
+
+	if(iter == m_players.end())
+		return;
+
+	PlayerTransferState state = (*iter).second;
+	m_players.erase(iter);
+	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
+
+	if(!pPlayer)
+		return;
+
+	// The player spawns where they left the other server, the scripts can change
+	// this in playerTransfer
+	pPlayer->SetModel(state.iModel);
+	pPlayer->SetMoney(state.iMoney);
+	pPlayer->SetSpawnLocation(state.vecPosition, state.fHeading);
+
+	CSquirrelArguments arguments;
+	arguments.push(playerId);
+	arguments.push(state.strOrigin);
+	arguments.push(state.strData);
+	g_pEvents->Call("playerTransfer", &arguments);
+	CLogFile::Printf("[Transfer] %s was transferred from %s.", state.strName.Get(), state.strOrigin.Get());
+}
+
+void CTransferManager::RemovePlayer(EntityId playerId)
+{
+	m_players.erase(playerId);
+}
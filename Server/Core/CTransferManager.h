@@ -0,0 +1,66 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTransferManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <Common.h>
+
+// Version of the transfer token, tokens of other versions are refused
+#define TRANSFER_TOKEN_VERSION 1
+
+// Time in seconds a token may be issued in the future, for clocks that are a bit off
+#define TRANSFER_CLOCK_TOLERANCE 5
+
+// Longest script data a transfer can bring along
+#define TRANSFER_MAX_DATA_LENGTH 4096
+
+// What a player brings from the server they were transferred from
+struct PlayerTransferState
+{
+	String       strName;
+	String       strSerial;
+	bool         bGameFilesModded;
+	int          iModel;
+	CVector3     vecPosition;
+	float        fHeading;
+	int          iMoney;
+	String       strOrigin; // Hostname of the server the player came from
+	String       strData;   // Given by the scripts of that server
+};
+
+// Moves players between the servers of one community without a reconnect from the
+// menu. The origin server signs the state of the player with the transfersecret
+// setting all its servers share and sends the client to the target server with it.
+// The target server takes the name and the game file check from the token and
+// gives the state to its scripts once the player joined.
+class CTransferManager
+{
+private:
+	std::map<String, unsigned int>               m_usedTokens; // Signatures of the accepted tokens until they expire
+	std::map<EntityId, PlayerTransferState>      m_players;    // Transferred players that haven't joined yet
+
+	static String Sign(const String& strSecret, const String& strPayload);
+
+public:
+	CTransferManager();
+	~CTransferManager();
+
+	// Sends the player to the server, they disconnect from this one once they got it
+	bool          Transfer(EntityId playerId, const String& strHost, unsigned short usPort, const String& strPassword, const String& strData);
+
+	// Checks the token a connecting player brought, every token only works once
+	bool          ReadToken(const String& strToken, const String& strSerial, PlayerTransferState& state);
+	void          AddPlayer(EntityId playerId, const PlayerTransferState& state);
+
+	// Gives the state to the player and calls playerTransfer once they joined
+	void          Join(EntityId playerId);
+	void          RemovePlayer(EntityId playerId);
+};
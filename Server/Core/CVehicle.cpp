@@ -11,15 +11,25 @@
 #include "CNetworkManager.h"
 #include "CPlayerManager.h"
 #include <CLogFile.h>
+#include <SharedUtility.h>
 #include "CEvents.h"
+#include "CEntityStreamer.h"
+#include "CSpatialIndex.h"
+#include "CVehicleManager.h"
+#include <Network/CSyncSerializer.h>
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CPlayerManager * g_pPlayerManager;
 extern CEvents * g_pEvents;
+extern CEntityStreamer * g_pEntityStreamer;
+extern CSpatialIndex * g_pSpatialIndex;
+extern CVehicleManager * g_pVehicleManager;
 
 
-CVehicle::CVehicle(EntityId vehicleId, int iModelId, CVector3 vecSpawnPosition, CVector3 vecSpawnRotation, BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4)
+CVehicle::CVehicle(EntityId vehicleId, int iModelId, CVector3 vecSpawnPosition, CVector3 vecSpawnRotation, BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4, bool bSpawnForWorld)
 {
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CVehicle));
 	m_vehicleId = vehicleId;
 	m_iModelId = iModelId;
 	m_vecSpawnPosition = vecSpawnPosition;
@@ -28,26 +38,68 @@ CVehicle::CVehicle(EntityId vehicleId, int iModelId, CVector3 vecSpawnPosition,
 	m_byteSpawnColors[1] = byteColor2;
 	m_byteSpawnColors[2] = byteColor3;
 	m_byteSpawnColors[3] = byteColor4;
-	m_iRespawnDelay = -1;
 	m_bActorVehicle = false;
 	m_ucDimension = 0;
 	Reset();
-	SpawnForWorld();
+
+	// Batches are spawned by the vehicle manager in packed messages
+	if(bSpawnForWorld)
+		SpawnForWorld();
 }
 
 CVehicle::~CVehicle()
 {
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CVehicle));
 	DestroyForWorld();
+	g_pSpatialIndex->Remove(SPATIAL_INDEX_VEHICLE, m_vehicleId);
+}
+
+void CVehicle::SetLastTimeOccupied(unsigned long lastTimeOccupied)
+{
+	g_pVehicleManager->SetLastTimeOccupied(m_vehicleId, lastTimeOccupied);
+}
+
+unsigned long CVehicle::GetLastTimeOccupied()
+{
+	return g_pVehicleManager->GetLastTimeOccupied(m_vehicleId);
+}
+
+void CVehicle::SetRespawnDelay(int iRespawnDelay)
+{
+	g_pVehicleManager->SetRespawnDelay(m_vehicleId, iRespawnDelay);
+}
+
+int CVehicle::GetRespawnDelay()
+{
+	return g_pVehicleManager->GetRespawnDelay(m_vehicleId);
+}
+
+void CVehicle::SetDeathTime(unsigned long time)
+{
+	g_pVehicleManager->SetDeathTime(m_vehicleId, time);
+}
+
+unsigned long CVehicle::GetDeathTime()
+{
+	return g_pVehicleManager->GetDeathTime(m_vehicleId);
+}
+
+void CVehicle::UpdateSpatialIndex()
+{
+	g_pSpatialIndex->Update(SPATIAL_INDEX_VEHICLE, m_vehicleId, m_vecPosition, m_ucDimension);
 }
 
 void CVehicle::Reset()
 {
 	m_pDriver = NULL;
+	m_syncOwnerId = INVALID_ENTITY_ID;
 	memset(m_pPassengers, 0, sizeof(m_pPassengers));
 	m_uiHealth = 1000;
 	m_fPetrolTankHealth = 1000.0f;
 	m_vecPosition = m_vecSpawnPosition;
 	m_vecRotation = m_vecSpawnRotation;
+	CDeadReckoning::Reset(&m_syncState);
+	UpdateSpatialIndex();
 	memset(&m_vecTurnSpeed, 0, sizeof(CVector3));
 	memset(&m_vecMoveSpeed, 0, sizeof(CVector3));
 	memcpy(m_byteColors, m_byteSpawnColors, sizeof(m_byteColors));
@@ -66,91 +118,83 @@ void CVehicle::Reset()
 	m_fDoor[3] = 0.0f;
 	m_fDoor[4] = 0.0f;
 	m_fDoor[5] = 0.0f;
-	m_bWindow[0] = false;
-	m_bWindow[1] = false;
-	m_bWindow[2] = false;
-	m_bWindow[3] = false;
 	m_bTaxiLight = true;
-	m_bTyre[0] = false;
-	m_bTyre[1] = false;
-	m_bTyre[2] = false;
-	m_bTyre[3] = false;
-	m_bTyre[4] = false;
-	m_bTyre[5] = false;
+	memset(&m_damage, 0, sizeof(VehicleDamageSyncData));
 	m_bGpsState = false;
 }
 
-void CVehicle::SpawnForPlayer(EntityId playerId)
+void CVehicle::SerializeSpawn(CBitStream * pBitStream)
 {
-	CBitStream bsSend;
-	bsSend.WriteCompressed(m_vehicleId);
-	bsSend.Write(m_iModelId);
-	bsSend.Write(m_uiHealth);
-	bsSend.Write(m_fPetrolTankHealth);
-	bsSend.Write(m_vecPosition);
+	pBitStream->WriteCompressed(m_vehicleId);
+	pBitStream->Write(m_iModelId);
+	pBitStream->Write(m_uiHealth);
+	pBitStream->Write(m_fPetrolTankHealth);
+	pBitStream->Write(m_vecPosition);
 
 	if(!m_vecRotation.IsEmpty())
 	{
-		bsSend.Write1();
-		bsSend.Write(m_vecRotation);
+		pBitStream->Write1();
+		pBitStream->Write(m_vecRotation);
 	}
 	else
-		bsSend.Write0();
+		pBitStream->Write0();
 
 	if(!m_vecTurnSpeed.IsEmpty())
 	{
-		bsSend.Write1();
-		bsSend.Write(m_vecTurnSpeed);
+		pBitStream->Write1();
+		pBitStream->Write(m_vecTurnSpeed);
 	}
 	else
-		bsSend.Write0();
+		pBitStream->Write0();
 
 	if(!m_vecMoveSpeed.IsEmpty())
 	{
-		bsSend.Write1();
-		bsSend.Write(m_vecMoveSpeed);
+		pBitStream->Write1();
+		pBitStream->Write(m_vecMoveSpeed);
 	}
 	else
-		bsSend.Write0();
+		pBitStream->Write0();
 
-	bsSend.Write(m_iRespawnDelay);
+	pBitStream->Write(GetRespawnDelay());
 
-	bsSend.Write((char *)m_byteColors, sizeof(m_byteColors));
+	pBitStream->Write((char *)m_byteColors, sizeof(m_byteColors));
 
-	bsSend.Write(m_fDirtLevel);
+	pBitStream->Write(m_fDirtLevel);
 
 	for(int i = 0; i < 4; ++ i)
-		bsSend.WriteBit(m_bIndicatorState[i]);
+		pBitStream->WriteBit(m_bIndicatorState[i]);
 
 	for(int i = 0; i < 9; ++ i)
-		bsSend.WriteBit(m_bComponents[i]);
-
-	bsSend.Write(m_iHornDuration);
-	bsSend.Write(m_bSirenState);
-	bsSend.Write(m_iLocked);
-	bsSend.WriteBit(m_bEngineStatus);
-	bsSend.Write(m_bLights);
-	bsSend.Write(m_fDoor[0]);
-	bsSend.Write(m_fDoor[1]);
-	bsSend.Write(m_fDoor[2]);
-	bsSend.Write(m_fDoor[3]);
-	bsSend.Write(m_fDoor[4]);
-	bsSend.Write(m_fDoor[5]);
-	bsSend.Write(m_bWindow[0]);
-	bsSend.Write(m_bWindow[1]);
-	bsSend.Write(m_bWindow[2]);
-	bsSend.Write(m_bWindow[3]);
-	bsSend.Write(m_bTaxiLight);
-	bsSend.Write(m_bGpsState);
+		pBitStream->WriteBit(m_bComponents[i]);
+
+	pBitStream->Write(m_iHornDuration);
+	pBitStream->Write(m_bSirenState);
+	pBitStream->Write(m_iLocked);
+	pBitStream->WriteBit(m_bEngineStatus);
+	pBitStream->Write(m_bLights);
+	pBitStream->Write(m_fDoor[0]);
+	pBitStream->Write(m_fDoor[1]);
+	pBitStream->Write(m_fDoor[2]);
+	pBitStream->Write(m_fDoor[3]);
+	pBitStream->Write(m_fDoor[4]);
+	pBitStream->Write(m_fDoor[5]);
+	CSyncSerializer::Serialize(pBitStream, m_damage);
+	pBitStream->Write(m_bTaxiLight);
+	pBitStream->Write(m_bGpsState);
 
 	if(m_ucVariation != 0)
 	{
-		bsSend.Write1();
-		bsSend.Write(m_ucVariation);
+		pBitStream->Write1();
+		pBitStream->Write(m_ucVariation);
 	}
 	else
-		bsSend.Write0();
+		pBitStream->Write0();
+}
 
+void CVehicle::SpawnForPlayer(EntityId playerId)
+{
+	CBitStream bsSend;
+	SerializeSpawn(&bsSend);
 	g_pNetworkManager->RPC(RPC_NewVehicle, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 
 	// Mark vehicle as actor vehicle
@@ -172,19 +216,29 @@ void CVehicle::DestroyForPlayer(EntityId playerId)
 
 void CVehicle::SpawnForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	// If the server streams vehicles only players that have us streamed in
+	// get us, everyone else gets us when we come in range
+	bool bStreamed = g_pEntityStreamer->IsEnabled();
+
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i))
-			SpawnForPlayer(i);
+		if(!bStreamed || g_pEntityStreamer->IsStreamedIn(players[i], ENTITY_STREAMER_VEHICLE, m_vehicleId))
+			SpawnForPlayer(players[i]);
 	}
 }
 
 void CVehicle::DestroyForWorld()
 {
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	bool bStreamed = g_pEntityStreamer->IsEnabled();
+
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
 	{
-		if(g_pPlayerManager->DoesExist(i))
-			DestroyForPlayer(i);
+		if(!bStreamed || g_pEntityStreamer->IsStreamedIn(players[i], ENTITY_STREAMER_VEHICLE, m_vehicleId))
+			DestroyForPlayer(players[i]);
 	}
 }
 
@@ -208,12 +262,23 @@ bool CVehicle::IsOccupied()
 	return false;
 }
 
+void CVehicle::SetDriver(CPlayer * pDriver)
+{
+	// The driver is set again with every sync packet
+	if(m_pDriver == pDriver)
+		return;
+
+	m_pDriver = pDriver;
+	g_pVehicleManager->OnOccupantsChanged(m_vehicleId);
+}
+
 void CVehicle::SetPassenger(BYTE byteSeatId, CPlayer * pPassenger)
 {
-	if(byteSeatId < MAX_VEHICLE_PASSENGERS)
+	if(byteSeatId >= MAX_VEHICLE_PASSENGERS || m_pPassengers[byteSeatId] == pPassenger)
 		return;
 
 	m_pPassengers[byteSeatId] = pPassenger;
+	g_pVehicleManager->OnOccupantsChanged(m_vehicleId);
 }
 
 CPlayer * CVehicle::GetPassenger(BYTE byteSeatId)
@@ -242,6 +307,7 @@ CPlayer * CVehicle::GetOccupant(BYTE byteSeatId)
 
 void CVehicle::Respawn()
 {
+	g_pVehicleManager->WakeUp(m_vehicleId);
 	DestroyForWorld();
 	Reset();
 	SpawnForWorld();
@@ -251,6 +317,8 @@ void CVehicle::StoreInVehicleSync(InVehicleSyncData * syncPacket)
 {
 	m_vecPosition = syncPacket->vecPos;
 	m_vecRotation = syncPacket->vecRotation;
+	CDeadReckoning::SetState(&m_syncState, SharedUtility::GetTime(), syncPacket->vecPos, syncPacket->vecRotation, syncPacket->vecMoveSpeed, syncPacket->vecTurnSpeed);
+	UpdateSpatialIndex();
 	if(m_uiHealth != syncPacket->uiHealth || m_fPetrolTankHealth != syncPacket->fPetrolHealth)
 	{
 		CSquirrelArguments pArguments;
@@ -271,23 +339,7 @@ void CVehicle::StoreInVehicleSync(InVehicleSyncData * syncPacket)
 	m_bSirenState = syncPacket->bSirenState;
 	m_bEngineStatus = syncPacket->bEngineStatus;
 	m_bLights = syncPacket->bLights;
-	m_fDoor[0] = syncPacket->fDoor[0];
-	m_fDoor[1] = syncPacket->fDoor[1];
-	m_fDoor[2] = syncPacket->fDoor[2];
-	m_fDoor[3] = syncPacket->fDoor[3];
-	m_fDoor[4] = syncPacket->fDoor[4];
-	m_fDoor[5] = syncPacket->fDoor[5];
-	m_bWindow[0] = syncPacket->bWindow[0];
-	m_bWindow[1] = syncPacket->bWindow[1];
-	m_bWindow[2] = syncPacket->bWindow[2];
-	m_bWindow[3] = syncPacket->bWindow[3];
 	m_bTaxiLight = syncPacket->bTaxiLights;
-	m_bTyre[0] = syncPacket->bTyre[0];
-	m_bTyre[1] = syncPacket->bTyre[1];
-	m_bTyre[2] = syncPacket->bTyre[2];
-	m_bTyre[3] = syncPacket->bTyre[3];
-	m_bTyre[4] = syncPacket->bTyre[4];
-	m_bTyre[5] = syncPacket->bTyre[5];
 	m_bGpsState = syncPacket->bGpsState;
 }
 
@@ -326,7 +378,10 @@ unsigned int CVehicle::GetHealth()
 
 void CVehicle::SetPosition(const CVector3& vecPosition)
 {
+	g_pVehicleManager->WakeUp(m_vehicleId);
 	m_vecPosition = vecPosition;
+	CDeadReckoning::Reset(&m_syncState);
+	UpdateSpatialIndex();
 
 	CBitStream bsSend;
 	bsSend.Write(m_vehicleId);
@@ -337,15 +392,22 @@ void CVehicle::SetPosition(const CVector3& vecPosition)
 void CVehicle::SetPositionSave(CVector3 vecPosition)
 {
 	m_vecPosition = vecPosition;
+	CDeadReckoning::Reset(&m_syncState);
+	UpdateSpatialIndex();
 }
 
 void CVehicle::GetPosition(CVector3& vecPosition)
 {
-	vecPosition = m_vecPosition;
+	// Carry on along the movement of the last driver sync like the clients do
+	CVector3 vecRotation;
+
+	if(!m_pDriver || !CDeadReckoning::Extrapolate(&m_syncState, SharedUtility::GetTime(), vecPosition, vecRotation))
+		vecPosition = m_vecPosition;
 }
 
 void CVehicle::SetRotation(const CVector3& vecRotation)
 {
+	g_pVehicleManager->WakeUp(m_vehicleId);
 	m_vecRotation = vecRotation;
 
 	CBitStream bsSend;
@@ -381,6 +443,7 @@ float CVehicle::GetDirtLevel()
 
 void CVehicle::SetTurnSpeed(const CVector3& vecTurnSpeed)
 {
+	g_pVehicleManager->WakeUp(m_vehicleId);
 	m_vecTurnSpeed = vecTurnSpeed;
 
 	CBitStream bsSend;
@@ -396,6 +459,7 @@ void CVehicle::GetTurnSpeed(CVector3& vecTurnSpeed)
 
 void CVehicle::SetMoveSpeed(const CVector3& vecMoveSpeed)
 {
+	g_pVehicleManager->WakeUp(m_vehicleId);
 	m_vecMoveSpeed = vecMoveSpeed;
 
 	CBitStream bsSend;
@@ -680,6 +744,8 @@ bool CVehicle::GetTaxiLights()
 
 void CVehicle::RepairWheels()
 {
+	m_damage.ucTyres = 0;
+
 	CBitStream bsSend;
 	bsSend.Write(m_vehicleId);
 	g_pNetworkManager->RPC(RPC_ScriptingRepairCarTyres, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
@@ -687,13 +753,49 @@ void CVehicle::RepairWheels()
 
 void CVehicle::RepairWindows()
 {
+	m_damage.ucWindows = 0;
+
 	CBitStream bsSend;
 	bsSend.Write(m_vehicleId);
 	g_pNetworkManager->RPC(RPC_ScriptingRepairCarWindows, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 }
 
+void CVehicle::SetSyncOwner(EntityId playerId)
+{
+	if(m_syncOwnerId == playerId)
+		return;
+
+	CBitStream bsSend;
+
+	if(m_syncOwnerId != INVALID_ENTITY_ID && g_pPlayerManager->DoesExist(m_syncOwnerId))
+	{
+		bsSend.WriteCompressed(m_vehicleId);
+		bsSend.Write0();
+		g_pNetworkManager->RPC(RPC_VehicleSyncOwner, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, m_syncOwnerId, false);
+	}
+
+	m_syncOwnerId = playerId;
+
+	if(playerId != INVALID_ENTITY_ID)
+	{
+		bsSend.Reset();
+		bsSend.WriteCompressed(m_vehicleId);
+		bsSend.Write1();
+		g_pNetworkManager->RPC(RPC_VehicleSyncOwner, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+	}
+}
+
 void CVehicle::StoreEmptyVehicle(EMPTYVEHICLESYNCPACKET * syncPacket)
 {
+	// The sync owner moved the vehicle
+	g_pVehicleManager->WakeUp(m_vehicleId);
+	m_vecPosition = syncPacket->vecPosition;
+	m_vecRotation = syncPacket->vecRotation;
+	m_vecTurnSpeed = syncPacket->vecTurnSpeed;
+	m_vecMoveSpeed = syncPacket->vecMoveSpeed;
+	CDeadReckoning::Reset(&m_syncState);
+	UpdateSpatialIndex();
+
 	// Check stuff
 	if(syncPacket->bLights != GetLights())
 		SetLights(syncPacket->bLights);
@@ -732,47 +834,62 @@ void CVehicle::StoreEmptyVehicle(EMPTYVEHICLESYNCPACKET * syncPacket)
 		if((vecMoveSpeed-syncPacket->vecMoveSpeed).Length() > 5.0f || (vecMoveSpeed-syncPacket->vecMoveSpeed).Length() < -5.0f)
 			SetMoveSpeed(syncPacket->vecMoveSpeed);
 	}*/
+}
 
-	/*for(unsigned int ui = 0; ui <= 3; ui++)
-	{
-		if(syncPacket->bWindow[ui] != m_bWindow[ui])
-			SetWindowState(ui, syncPacket->bWindow[ui]);
-	}
+void CVehicle::StoreDamageSync(const VehicleDamageSyncData& damage, EntityId playerId)
+{
+	if(!memcmp(&m_damage, &damage, sizeof(VehicleDamageSyncData)))
+		return;
 
-	for(unsigned int ui = 0; ui <= 5; ui++)
-	{
-		if(syncPacket->bTyre[ui] != m_bTyre[ui])
-			SetTyreState(ui, syncPacket->bTyre[ui]);
-	}*/
+	memcpy(&m_damage, &damage, sizeof(VehicleDamageSyncData));
+
+	// The damage is only sent when it changed so it is sent reliably
+	CBitStream bsSend;
+	bsSend.WriteCompressed(m_vehicleId);
+	CSyncSerializer::Serialize(&bsSend, m_damage);
+	g_pNetworkManager->RPC(RPC_VehicleDamageSync, &bsSend, PRIORITY_MEDIUM, RELIABILITY_RELIABLE_ORDERED, playerId, true);
+}
+
+void CVehicle::GetDeformation(unsigned int uiPoint, CVector3& vecDeformation)
+{
+	vecDeformation.fX = (m_damage.cDeformation[uiPoint][0] * VEHICLE_DAMAGE_DEFORMATION_STEP);
+	vecDeformation.fY = (m_damage.cDeformation[uiPoint][1] * VEHICLE_DAMAGE_DEFORMATION_STEP);
+	vecDeformation.fZ = (m_damage.cDeformation[uiPoint][2] * VEHICLE_DAMAGE_DEFORMATION_STEP);
 }
 
 bool CVehicle::GetWindowState(unsigned int uiWindow)
 {
-	return m_bWindow[uiWindow];
+	return ((m_damage.ucWindows & (1 << uiWindow)) != 0);
 }
 
 void CVehicle::SetWindowState(unsigned int uiWindow, bool bState)
 {
-	m_bWindow[uiWindow] = bState;
+	if(bState)
+		m_damage.ucWindows |= (1 << uiWindow);
+	else
+		m_damage.ucWindows &= ~(1 << uiWindow);
 
 	CBitStream bsSend;
 	bsSend.Write(m_vehicleId);
-	bsSend.Write(m_bWindow[uiWindow]);
+	bsSend.Write(bState);
 	g_pNetworkManager->RPC(RPC_ScriptingSetVehicleWindowState, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 }
 
 bool CVehicle::GetTyreState(unsigned int uiTyre)
 {
-	return m_bTyre[uiTyre];
+	return ((m_damage.ucTyres & (1 << uiTyre)) != 0);
 }
 
 void CVehicle::SetTyreState(unsigned int uiTyre, bool bState)
 {
-	m_bTyre[uiTyre] = bState;
+	if(bState)
+		m_damage.ucTyres |= (1 << uiTyre);
+	else
+		m_damage.ucTyres &= ~(1 << uiTyre);
 
 	CBitStream bsSend;
 	bsSend.Write(m_vehicleId);
-	bsSend.Write(m_bTyre[uiTyre]);
+	bsSend.Write(bState);
 	g_pNetworkManager->RPC(RPC_ScriptingSetVehicleTryeState, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
 }
 
@@ -826,6 +943,8 @@ void CVehicle::MarkVehicle(bool bToggle)
 
 void CVehicle::RepairVehicle()
 {
+	memset(&m_damage, 0, sizeof(VehicleDamageSyncData));
+
 	CBitStream bsSend;
 	bsSend.Write(m_vehicleId);
 	g_pNetworkManager->RPC(RPC_ScriptingFixVehicle, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
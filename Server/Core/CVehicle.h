@@ -11,6 +11,7 @@
 
 #include "Main.h"
 #include "Interfaces/InterfaceCommon.h"
+#include <Game/CDeadReckoning.h>
 
 class CPlayer;
 
@@ -41,29 +42,33 @@ private:
 	bool		  m_bEngineStatus;
 	bool		  m_bLights;
 	float		  m_fDoor[6];
-	bool		  m_bWindow[4];
 	bool		  m_bTaxiLight;
-	bool		  m_bTyre[6];
+	VehicleDamageSyncData m_damage; // Windows, tyres, doors and deformation from the damage sync
 	bool		  m_bGpsState;
 	bool		  m_bActorVehicle;
 	unsigned char m_ucDimension;
-	int			  m_iRespawnDelay;
-	unsigned long m_lastTimeOccupied;
-	unsigned long m_ulDeathTime;
+	DeadReckoningState m_syncState; // The driver only syncs once the extrapolation is too far off
+	EntityId      m_syncOwnerId;    // The player that syncs the vehicle while nobody is in it
+
+	void          UpdateSpatialIndex();
 
 public:
-	CVehicle(EntityId vehicleId, int iModelId, CVector3 vecSpawnPosition, CVector3 vecSpawnRotation, BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4);
+	CVehicle(EntityId vehicleId, int iModelId, CVector3 vecSpawnPosition, CVector3 vecSpawnRotation, BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4, bool bSpawnForWorld = true);
 	~CVehicle();
 
 	EntityId      GetVehicleId() { return m_vehicleId; }
 	void          Reset();
+	void          SerializeSpawn(CBitStream * pBitStream);
 	void          SpawnForPlayer(EntityId playerId);
+	bool          IsActorVehicle() { return m_bActorVehicle; }
 	void          DestroyForPlayer(EntityId playerId);
 	void          SpawnForWorld();
 	void          DestroyForWorld();
 	bool          IsOccupied();
-	void          SetDriver(CPlayer * pDriver) { m_pDriver = pDriver; }
+	void          SetDriver(CPlayer * pDriver);
 	CPlayer     * GetDriver() { return m_pDriver; }
+	EntityId      GetSyncOwner() { return m_syncOwnerId; }
+	void          SetSyncOwner(EntityId playerId);
 	void          SetPassenger(BYTE byteSeatId, CPlayer * pPassenger);
 	CPlayer     * GetPassenger(BYTE byteSeatId);
 	void          SetOccupant(BYTE byteSeatId, CPlayer * pOccupant);
@@ -72,6 +77,9 @@ public:
 	void          StoreInVehicleSync(InVehicleSyncData * syncPacket);
 	void          StorePassengerSync(PassengerSyncData * syncPacket);
 	void		  StoreEmptyVehicle(EMPTYVEHICLESYNCPACKET * syncPacket);
+	// Stores the damage synced by a player and passes it on to the others
+	void		  StoreDamageSync(const VehicleDamageSyncData& damage, EntityId playerId);
+	void		  GetDeformation(unsigned int uiPoint, CVector3& vecDeformation);
 	void          SetPassengerId(BYTE byteSeatId, EntityId passengerId);
 	void          SetModel(int iModelId);
 	int           GetModel();
@@ -93,6 +101,9 @@ public:
 	void          GetMoveSpeed(CVector3& vecMoveSpeed);
 	void          SetColors(BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4);
 	void          GetColors(BYTE& byteColor1, BYTE& byteColor2, BYTE& byteColor3, BYTE& byteColor4);
+	void          GetSpawnPosition(CVector3& vecSpawnPosition) { vecSpawnPosition = m_vecSpawnPosition; }
+	void          GetSpawnRotation(CVector3& vecSpawnRotation) { vecSpawnRotation = m_vecSpawnRotation; }
+	BYTE          GetSpawnColor(unsigned char ucSlot) { return m_byteSpawnColors[ucSlot]; }
 	void          SoundHorn(unsigned int iDuration);
 	void          SetSirenState(bool bSirenState);
 	bool          GetSirenState();
@@ -123,12 +134,14 @@ public:
 	void		  SetAlarm(int iDuration);
 	void		  MarkVehicle(bool bToggle);
 	void		  RepairVehicle();
-	void		  SetDimension(unsigned char ucDimension) { m_ucDimension = ucDimension; }
+	void		  SetDimension(unsigned char ucDimension) { m_ucDimension = ucDimension; UpdateSpatialIndex(); }
 	unsigned char GetDimension() { return m_ucDimension; }
-	void		  SetLastTimeOccupied(unsigned long lastTimeOccupied) { m_lastTimeOccupied = lastTimeOccupied; }
-	unsigned long GetLastTimeOccupied() { return m_lastTimeOccupied; }
-	void		  SetRespawnDelay(int iRespawnDelay) { m_iRespawnDelay = iRespawnDelay; }
-	int			  GetRespawnDelay() { return m_iRespawnDelay; }
-	void		  SetDeathTime(unsigned long time) { m_ulDeathTime = time; }
-	unsigned long GetDeathTime() { return m_ulDeathTime; }
+
+	// The timers are kept by the vehicle manager
+	void		  SetLastTimeOccupied(unsigned long lastTimeOccupied);
+	unsigned long GetLastTimeOccupied();
+	void		  SetRespawnDelay(int iRespawnDelay);
+	int			  GetRespawnDelay();
+	void		  SetDeathTime(unsigned long time);
+	unsigned long GetDeathTime();
 };
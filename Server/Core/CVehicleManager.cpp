@@ -14,84 +14,342 @@
 #include "CModuleManager.h"
 #include "CEvents.h"
 #include "SharedUtility.h"
+#include "CEntityStreamer.h"
+#include "CSpatialIndex.h"
+#include "CEntityDataManager.h"
+#include <CMemoryTracker.h>
 
 extern CNetworkManager * g_pNetworkManager;
 extern CScriptingManager * g_pScriptingManager;
 extern CModuleManager * g_pModuleManager;
 extern CEvents * g_pEvents;
+extern CEntityStreamer * g_pEntityStreamer;
+extern CSpatialIndex * g_pSpatialIndex;
+extern CEntityDataManager * g_pEntityDataManager;
 
 CVehicleManager::CVehicleManager()
 {
-	for(EntityId x = 0; x < MAX_VEHICLES; x++)
-		m_bActive[x] = false;
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CVehicleManager));
+
+	m_ulLastSyncOwnerUpdateTime = 0;
+	m_uiSyncOwnerUpdates = 0;
 }
 
 CVehicleManager::~CVehicleManager()
 {
-	for(EntityId x = 0; x < MAX_VEHICLES; x++)
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CVehicleManager));
+
+	while(!m_activeVehicles.empty())
+		Remove(m_activeVehicles.back());
+}
+
+void CVehicleManager::AddSlot(EntityId vehicleId, int iRespawnDelay)
+{
+	*m_denseIndex.Add(vehicleId) = (EntityId)m_activeVehicles.size();
+	m_activeVehicles.push_back(vehicleId);
+	m_vehicles.push_back(NULL);
+	m_respawnDelays.push_back(iRespawnDelay);
+	m_respawnTimes.push_back(0);
+	m_lastTimesOccupied.push_back(0);
+	m_deathTimes.push_back(0);
+	m_wakeTimes.push_back(SharedUtility::GetTime());
+
+	// New vehicles are unoccupied
+	ScheduleRespawn(vehicleId, SharedUtility::GetTime());
+}
+
+void CVehicleManager::RemoveSlot(EntityId vehicleId)
+{
+	// Move the last vehicle into the slot so the arrays stay dense
+	EntityId index = m_denseIndex[vehicleId];
+	EntityId lastVehicleId = m_activeVehicles.back();
+	m_activeVehicles[index] = lastVehicleId;
+	m_vehicles[index] = m_vehicles.back();
+	m_respawnDelays[index] = m_respawnDelays.back();
+	m_respawnTimes[index] = m_respawnTimes.back();
+	m_lastTimesOccupied[index] = m_lastTimesOccupied.back();
+	m_deathTimes[index] = m_deathTimes.back();
+	m_wakeTimes[index] = m_wakeTimes.back();
+	m_denseIndex[lastVehicleId] = index;
+	m_activeVehicles.pop_back();
+	m_vehicles.pop_back();
+	m_respawnDelays.pop_back();
+	m_respawnTimes.pop_back();
+	m_lastTimesOccupied.pop_back();
+	m_deathTimes.pop_back();
+	m_wakeTimes.pop_back();
+	m_denseIndex.Remove(vehicleId);
+}
+
+void CVehicleManager::AddTimer(unsigned long ulTime, EntityId vehicleId, eVehicleTimerType type)
+{
+	VehicleTimer timer;
+	timer.ulTime = ulTime;
+	timer.vehicleId = vehicleId;
+	timer.type = type;
+	m_timers.push(timer);
+}
+
+void CVehicleManager::ScheduleRespawn(EntityId vehicleId, unsigned long ulTime)
+{
+	EntityId index = m_denseIndex[vehicleId];
+
+	if(m_respawnDelays[index] < 0)
+	{
+		m_respawnTimes[index] = 0;
+		return;
+	}
+
+	m_lastTimesOccupied[index] = ulTime;
+	m_respawnTimes[index] = (ulTime + m_respawnDelays[index]);
+	AddTimer(m_respawnTimes[index], vehicleId, VEHICLE_TIMER_RESPAWN);
+}
+
+void CVehicleManager::OnOccupantsChanged(EntityId vehicleId)
+{
+	if(!DoesExist(vehicleId))
+		return;
+
+	EntityId index = m_denseIndex[vehicleId];
+	CVehicle * pVehicle = m_vehicles[index];
+
+	if(!pVehicle)
+		return;
+
+	m_wakeTimes[index] = SharedUtility::GetTime();
+
+	// Occupied vehicles don't respawn, the delay starts when the last occupant leaves
+	if(pVehicle->IsOccupied())
 	{
-		if(m_bActive[x])
-			Remove(x);
+		m_lastTimesOccupied[index] = SharedUtility::GetTime();
+		m_respawnTimes[index] = 0;
+
+		// The occupants sync the vehicle now
+		pVehicle->SetSyncOwner(INVALID_ENTITY_ID);
 	}
+	else
+		ScheduleRespawn(vehicleId, SharedUtility::GetTime());
+}
+
+void CVehicleManager::WakeUp(EntityId vehicleId)
+{
+	if(DoesExist(vehicleId))
+		m_wakeTimes[m_denseIndex[vehicleId]] = SharedUtility::GetTime();
+}
+
+bool CVehicleManager::IsAsleep(EntityId index, unsigned long ulTime)
+{
+	CVehicle * pVehicle = m_vehicles[index];
+	return (pVehicle && !pVehicle->IsOccupied() && (ulTime - m_wakeTimes[index]) >= VEHICLE_SLEEP_TIME);
+}
+
+bool CVehicleManager::IsAsleep(EntityId vehicleId)
+{
+	if(!DoesExist(vehicleId))
+		return false;
+
+	return IsAsleep(m_denseIndex[vehicleId], SharedUtility::GetFrameTime());
 }
 
 EntityId CVehicleManager::Add(int iModelId, CVector3 vecSpawnPosition, CVector3 vecSpawnRotation, BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4, int respawn_delay)
 {
+	EntityId x = m_denseIndex.GetFree();
+
+	if(x == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
+
+	// The slot has to exist before the vehicle spawns as the spawn includes the respawn delay
+	AddSlot(x, respawn_delay);
+	CVehicle * pVehicle = new CVehicle(x, iModelId, vecSpawnPosition, vecSpawnRotation, byteColor1, byteColor2, byteColor3, byteColor4);
+	m_vehicles[m_denseIndex[x]] = pVehicle;
+	CSquirrelArguments pArguments;
+	pArguments.push(x);
+	g_pEvents->Call("vehicleCreate", &pArguments);
+	return x;
+}
+
+EntityId CVehicleManager::AddBatch(unsigned int uiCount, const int * pModelIds, const CVector3 * pSpawnPositions, const CVector3 * pSpawnRotations, const BYTE * pColors)
+{
+	if(uiCount == 0 || uiCount > MAX_VEHICLES)
+		return INVALID_ENTITY_ID;
+
+	// The vehicles get contiguous ids so scripts only need the first one
+	EntityId firstId = INVALID_ENTITY_ID;
+	unsigned int uiFree = 0;
+
 	for(EntityId x = 0; x < MAX_VEHICLES; x++)
 	{
-		if(!m_bActive[x])
+		if(DoesExist(x))
 		{
-			m_pVehicles[x] = new CVehicle(x, iModelId, vecSpawnPosition, vecSpawnRotation, byteColor1, byteColor2, byteColor3, byteColor4);
+			uiFree = 0;
+			continue;
+		}
 
-			if(m_pVehicles[x])
-			{
-				m_bActive[x] = true;
-				m_pVehicles[x]->SetRespawnDelay(respawn_delay);
-				CSquirrelArguments pArguments;
-				pArguments.push(x);
-				g_pEvents->Call("vehicleCreate", &pArguments);
+		if(++uiFree == uiCount)
+		{
+			firstId = (x - (uiCount - 1));
+			break;
+		}
+	}
+
+	if(firstId == INVALID_ENTITY_ID)
+		return INVALID_ENTITY_ID;
 
-				return x;
+	for(unsigned int i = 0; i < uiCount; i++)
+	{
+		EntityId vehicleId = (firstId + i);
+		const BYTE * pVehicleColors = &pColors[i * 4];
+		AddSlot(vehicleId, -1);
+		CVehicle * pVehicle = new CVehicle(vehicleId, pModelIds[i], pSpawnPositions[i], pSpawnRotations[i], pVehicleColors[0], pVehicleColors[1], pVehicleColors[2], pVehicleColors[3], false);
+		m_vehicles[m_denseIndex[vehicleId]] = pVehicle;
+	}
+
+	// Pack the vehicles into as few messages as possible instead of one per vehicle and player
+	// (new vehicles aren't actor vehicles and are in dimension 0)
+	if(!g_pEntityStreamer->IsEnabled())
+	{
+		CBitStream bsSend;
+
+		for(unsigned int i = 0; i < uiCount; i++)
+		{
+			if(bsSend.GetNumberOfBytesUsed() >= JOIN_STREAM_MESSAGE_SIZE)
+			{
+				g_pNetworkManager->RPC(RPC_NewVehicle, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+				bsSend.Reset();
 			}
 
-			return INVALID_ENTITY_ID;
+			m_vehicles[m_denseIndex[firstId + i]]->SerializeSpawn(&bsSend);
 		}
+
+		g_pNetworkManager->RPC(RPC_NewVehicle, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	}
+
+	for(unsigned int i = 0; i < uiCount; i++)
+	{
+		CSquirrelArguments pArguments;
+		pArguments.push((EntityId)(firstId + i));
+		g_pEvents->Call("vehicleCreate", &pArguments);
 	}
 
-	return INVALID_ENTITY_ID;
+	return firstId;
 }
 
-void CVehicleManager::Process()
+bool CVehicleManager::CanSyncVehicle(EntityId playerId, CVehicle * pVehicle, const CVector3& vecPosition, float fDistance)
 {
-	for(EntityId x = 0; x < MAX_VEHICLES; x++)
+	// Only spawned players are in the spatial index
+	CVector3 vecPlayerPosition;
+	unsigned char ucDimension;
+
+	if(!g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, playerId, vecPlayerPosition, ucDimension))
+		return false;
+
+	if(ucDimension != pVehicle->GetDimension() || (vecPlayerPosition - vecPosition).LengthSquared() > (fDistance * fDistance))
+		return false;
+
+	// The player needs to have the vehicle to sync it
+	return (!g_pEntityStreamer->IsEnabled() || g_pEntityStreamer->IsStreamedIn(playerId, ENTITY_STREAMER_VEHICLE, pVehicle->GetVehicleId()));
+}
+
+void CVehicleManager::UpdateSyncOwners()
+{
+	std::vector<EntityId> players;
+	unsigned long ulTime = SharedUtility::GetFrameTime();
+
+	// Asleep vehicles don't move so their owner rarely needs to change
+	bool bUpdateAsleep = ((m_uiSyncOwnerUpdates++ % VEHICLE_SLEEP_OWNER_UPDATES) == 0);
+
+	for(EntityId index = 0; index < (EntityId)m_vehicles.size(); index++)
 	{
-		if(m_bActive[x])
+		CVehicle * pVehicle = m_vehicles[index];
+
+		if(!pVehicle || pVehicle->IsOccupied())
+			continue;
+
+		if(!bUpdateAsleep && IsAsleep(index, ulTime))
+			continue;
+
+		CVector3 vecPosition;
+		pVehicle->GetPosition(vecPosition);
+
+		// Keep the owner while it stays around so the vehicle doesn't change owners all the time
+		EntityId ownerId = pVehicle->GetSyncOwner();
+
+		if(ownerId != INVALID_ENTITY_ID && CanSyncVehicle(ownerId, pVehicle, vecPosition, VEHICLE_SYNC_OWNER_KEEP_DISTANCE))
+			continue;
+
+		// The closest player becomes the new owner
+		players.clear();
+		g_pSpatialIndex->GetInRange(SPATIAL_INDEX_PLAYER, vecPosition, VEHICLE_SYNC_OWNER_DISTANCE, pVehicle->GetDimension(), players);
+		EntityId closestPlayerId = INVALID_ENTITY_ID;
+		float fClosestDistance = 0.0f;
+
+		for(std::vector<EntityId>::iterator playerIter = players.begin(); playerIter != players.end(); playerIter++)
 		{
-			if(m_pVehicles[x]->GetRespawnDelay() > -1) {
-				if(m_pVehicles[x]->IsOccupied()) {
-					m_pVehicles[x]->SetLastTimeOccupied(SharedUtility::GetTime());
-					continue;
-				}
-				if(m_pVehicles[x]->GetLastTimeOccupied() == 0) {
-					m_pVehicles[x]->SetLastTimeOccupied(SharedUtility::GetTime());
-					continue;
-				}
-
-				//CLogFile::Printf("Checkrespawn ( %i + %i < %i )", m_pVehicles[x]->GetLastTimeOccupied(), m_pVehicles[x]->GetRespawnDelay(), SharedUtility::GetTime());
-				if((m_pVehicles[x]->GetLastTimeOccupied() + m_pVehicles[x]->GetRespawnDelay()) < SharedUtility::GetTime()) {
-					m_pVehicles[x]->Respawn();
-					BYTE colors[4];
-					m_pVehicles[x]->GetColors(colors[0], colors[1], colors[2], colors[3]);
-					m_pVehicles[x]->SetColors(colors[0], colors[1], colors[2], colors[3]);
-					m_pVehicles[x]->SetLastTimeOccupied(SharedUtility::GetTime());
-				}
-			}
-			if(m_pVehicles[x]->GetDeathTime() != 0 && m_pVehicles[x]->GetDeathTime() + 3000 <= SharedUtility::GetTime())
+			CVector3 vecPlayerPosition;
+			unsigned char ucDimension;
+
+			if(!g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, *playerIter, vecPlayerPosition, ucDimension))
+				continue;
+
+			float fDistance = (vecPlayerPosition - vecPosition).LengthSquared();
+
+			if((closestPlayerId == INVALID_ENTITY_ID || fDistance < fClosestDistance) && CanSyncVehicle(*playerIter, pVehicle, vecPosition, VEHICLE_SYNC_OWNER_DISTANCE))
 			{
-				m_pVehicles[x]->SetDeathTime(0);
-				m_pVehicles[x]->Respawn();
+				closestPlayerId = *playerIter;
+				fClosestDistance = fDistance;
 			}
 		}
+
+		pVehicle->SetSyncOwner(closestPlayerId);
+	}
+}
+
+void CVehicleManager::Process()
+{
+	unsigned long ulTime = SharedUtility::GetFrameTime();
+
+	if((ulTime - m_ulLastSyncOwnerUpdateTime) >= VEHICLE_SYNC_OWNER_INTERVAL)
+	{
+		UpdateSyncOwners();
+		m_ulLastSyncOwnerUpdateTime = ulTime;
+	}
+
+	if(m_timers.empty())
+		return;
+
+	// Timers are due once their time has passed, so a respawn delay of 0 waits for the next tick
+	while(!m_timers.empty() && m_timers.top().ulTime < ulTime)
+	{
+		VehicleTimer timer = m_timers.top();
+		m_timers.pop();
+
+		if(!DoesExist(timer.vehicleId))
+			continue;
+
+		EntityId index = m_denseIndex[timer.vehicleId];
+		CVehicle * pVehicle = m_vehicles[index];
+
+		if(timer.type == VEHICLE_TIMER_RESPAWN)
+		{
+			if(m_respawnTimes[index] != timer.ulTime)
+				continue;
+
+			pVehicle->Respawn();
+			BYTE colors[4];
+			pVehicle->GetColors(colors[0], colors[1], colors[2], colors[3]);
+			pVehicle->SetColors(colors[0], colors[1], colors[2], colors[3]);
+
+			// Unused vehicles keep respawning after every delay
+			ScheduleRespawn(timer.vehicleId, ulTime);
+		}
+		else
+		{
+			if(m_deathTimes[index] == 0 || (m_deathTimes[index] + VEHICLE_DEATH_RESPAWN_DELAY) != timer.ulTime)
+				continue;
+
+			m_deathTimes[index] = 0;
+			pVehicle->Respawn();
+		}
 	}
 }
 void CVehicleManager::Remove(EntityId vehicleId)
@@ -103,42 +361,106 @@ void CVehicleManager::Remove(EntityId vehicleId)
 	pArguments.push(vehicleId);
 	g_pEvents->Call("vehicleDelete", &pArguments);
 
-	delete m_pVehicles[vehicleId];
-	m_pVehicles[vehicleId] = NULL;
-	m_bActive[vehicleId] = false;
+	// Stream the vehicle out for everyone that has it
+	g_pEntityStreamer->RemoveEntity(ENTITY_STREAMER_VEHICLE, vehicleId);
+	g_pEntityDataManager->RemoveEntity(ENTITY_DATA_VEHICLE, vehicleId);
+
+	delete m_vehicles[m_denseIndex[vehicleId]];
+	RemoveSlot(vehicleId);
 }
 
-void CVehicleManager::HandleClientJoin(EntityId playerId)
+bool CVehicleManager::HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor)
 {
-	if(GetVehicleCount() > 0)
+	// Pack as many vehicles as fit in a single message
+	CBitStream bsSend;
+	EntityId x = m_denseIndex.GetFirst(pCursor->entityId);
+
+	for(; x != INVALID_ENTITY_ID && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; x = m_denseIndex.GetFirst(x + 1))
+	{
+		m_vehicles[m_denseIndex[x]]->SerializeSpawn(&bsSend);
+		pCursor->uiEntities++;
+	}
+
+	if(pCursor->uiEntities > 0)
 	{
-		for(EntityId x = 0; x < MAX_VEHICLES; x++)
+		g_pNetworkManager->RPC(RPC_NewVehicle, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+
+		// Mark the actor vehicles in this message (vehicles aren't actor vehicles by default)
+		for(EntityId y = m_denseIndex.GetFirst(pCursor->entityId); y < x; y = m_denseIndex.GetFirst(y + 1))
 		{
-			if(m_bActive[x])
-				m_pVehicles[x]->SpawnForPlayer(playerId);
+			if(m_vehicles[m_denseIndex[y]]->IsActorVehicle())
+			{
+				CBitStream bsActorVehicle;
+				bsActorVehicle.Write(y);
+				bsActorVehicle.Write(true);
+				g_pNetworkManager->RPC(RPC_ScriptingMarkVehicleAsActorVehicle, &bsActorVehicle, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			}
 		}
 	}
-}
 
-bool CVehicleManager::DoesExist(EntityId vehicleId)
-{
-	if(vehicleId < 0 || vehicleId >= MAX_VEHICLES)
-		return false;
-	
-	return m_bActive[vehicleId];
+	pCursor->uiBytes = bsSend.GetNumberOfBytesUsed();
+	pCursor->entityId = x;
+	return (x >= MAX_VEHICLES);
 }
 
-int CVehicleManager::GetVehicleCount()
+void CVehicleManager::SpawnForPlayer(EntityId playerId, const std::list<EntityId>& vehicleList)
 {
-	int iCount = 0;
+	// Pack the vehicles into as few messages as possible
+	CBitStream bsSend;
+	std::list<EntityId>::const_iterator iter = vehicleList.begin();
 
-	for(EntityId x = 0; x < MAX_VEHICLES; x++)
+	while(iter != vehicleList.end())
 	{
-		if(DoesExist(x))
-			iCount++;
+		std::list<EntityId>::const_iterator firstIter = iter;
+		bsSend.Reset();
+
+		for(; iter != vehicleList.end() && bsSend.GetNumberOfBytesUsed() < JOIN_STREAM_MESSAGE_SIZE; iter++)
+		{
+			if(DoesExist(*iter))
+				m_vehicles[m_denseIndex[*iter]]->SerializeSpawn(&bsSend);
+		}
+
+		if(bsSend.GetNumberOfBytesUsed() == 0)
+			continue;
+
+		g_pNetworkManager->RPC(RPC_NewVehicle, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+
+		// Mark the actor vehicles and send the dimensions of the vehicles in this message
+		// (vehicles aren't actor vehicles and are in dimension 0 by default)
+		for(; firstIter != iter; firstIter++)
+		{
+			if(!DoesExist(*firstIter))
+				continue;
+
+			CVehicle * pVehicle = m_vehicles[m_denseIndex[*firstIter]];
+
+			if(pVehicle->IsActorVehicle())
+			{
+				CBitStream bsActorVehicle;
+				bsActorVehicle.Write(*firstIter);
+				bsActorVehicle.Write(true);
+				g_pNetworkManager->RPC(RPC_ScriptingMarkVehicleAsActorVehicle, &bsActorVehicle, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			}
+
+			if(pVehicle->GetDimension() != 0)
+			{
+				CBitStream bsDimension;
+				bsDimension.Write(*firstIter);
+				bsDimension.Write((int)pVehicle->GetDimension());
+				g_pNetworkManager->RPC(RPC_ScriptingSetVehicleDimension, &bsDimension, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			}
+		}
 	}
+}
+
+bool CVehicleManager::DoesExist(EntityId vehicleId)
+{
+	return m_denseIndex.DoesExist(vehicleId);
+}
 
-	return iCount;
+int CVehicleManager::GetVehicleCount()
+{
+	return (int)m_activeVehicles.size();
 }
 
 CVehicle * CVehicleManager::GetAt(EntityId vehicleId)
@@ -146,5 +468,68 @@ CVehicle * CVehicleManager::GetAt(EntityId vehicleId)
 	if(!DoesExist(vehicleId))
 		return NULL;
 
-	return m_pVehicles[vehicleId];
+	return m_vehicles[m_denseIndex[vehicleId]];
+}
+
+void CVehicleManager::SetRespawnDelay(EntityId vehicleId, int iRespawnDelay)
+{
+	if(!DoesExist(vehicleId))
+		return;
+
+	EntityId index = m_denseIndex[vehicleId];
+	m_respawnDelays[index] = iRespawnDelay;
+
+	if(m_vehicles[index] && m_vehicles[index]->IsOccupied())
+		return;
+
+	ScheduleRespawn(vehicleId, SharedUtility::GetTime());
+}
+
+int CVehicleManager::GetRespawnDelay(EntityId vehicleId)
+{
+	if(!DoesExist(vehicleId))
+		return -1;
+
+	return m_respawnDelays[m_denseIndex[vehicleId]];
+}
+
+void CVehicleManager::SetLastTimeOccupied(EntityId vehicleId, unsigned long ulTime)
+{
+	if(!DoesExist(vehicleId))
+		return;
+
+	// The respawn delay of an unoccupied vehicle starts again from this time
+	EntityId index = m_denseIndex[vehicleId];
+
+	if(m_vehicles[index] && !m_vehicles[index]->IsOccupied())
+		ScheduleRespawn(vehicleId, ulTime);
+	else
+		m_lastTimesOccupied[index] = ulTime;
+}
+
+unsigned long CVehicleManager::GetLastTimeOccupied(EntityId vehicleId)
+{
+	if(!DoesExist(vehicleId))
+		return 0;
+
+	return m_lastTimesOccupied[m_denseIndex[vehicleId]];
+}
+
+void CVehicleManager::SetDeathTime(EntityId vehicleId, unsigned long ulTime)
+{
+	if(!DoesExist(vehicleId))
+		return;
+
+	m_deathTimes[m_denseIndex[vehicleId]] = ulTime;
+
+	if(ulTime != 0)
+		AddTimer((ulTime + VEHICLE_DEATH_RESPAWN_DELAY), vehicleId, VEHICLE_TIMER_DEATH);
+}
+
+unsigned long CVehicleManager::GetDeathTime(EntityId vehicleId)
+{
+	if(!DoesExist(vehicleId))
+		return 0;
+
+	return m_deathTimes[m_denseIndex[vehicleId]];
 }
\ No newline at end of file
@@ -12,22 +12,103 @@
 #include "./Main.h"
 #include "Interfaces/InterfaceCommon.h"
 #include "CVehicle.h"
+#include "CJoinStreamer.h"
+#include "CEntityPool.h"
+#include <list>
+#include <vector>
+#include <queue>
+
+// Time in ms after which a destroyed vehicle respawns
+#define VEHICLE_DEATH_RESPAWN_DELAY 3000
+
+// Time in ms between two updates of the sync owners of the empty vehicles
+#define VEHICLE_SYNC_OWNER_INTERVAL 1000
+
+// Distance within which a player can become the sync owner of an empty vehicle, the
+// owner keeps the vehicle until it is VEHICLE_SYNC_OWNER_KEEP_DISTANCE away
+#define VEHICLE_SYNC_OWNER_DISTANCE 100.0f
+#define VEHICLE_SYNC_OWNER_KEEP_DISTANCE 150.0f
+
+// Time in ms an empty vehicle has to stay where it is before it falls asleep
+#define VEHICLE_SLEEP_TIME 3000
+
+// Asleep vehicles only get their sync owner updated every this many sync owner updates
+#define VEHICLE_SLEEP_OWNER_UPDATES 5
+
+enum eVehicleTimerType
+{
+	VEHICLE_TIMER_RESPAWN,
+	VEHICLE_TIMER_DEATH
+};
+
+struct VehicleTimer
+{
+	unsigned long     ulTime;
+	EntityId          vehicleId;
+	eVehicleTimerType type;
+
+	// Ordered so the priority queue has the earliest timer on top
+	bool operator < (const VehicleTimer& timer) const { return (ulTime > timer.ulTime); }
+};
 
 class CVehicleManager : public CVehicleManagerInterface
 {
 private:
-	bool m_bActive[MAX_VEHICLES];
-	CVehicle * m_pVehicles[MAX_VEHICLES];
+	// Dense slot map of the existing vehicles. m_denseIndex maps a vehicle id to its index
+	// in m_activeVehicles, m_vehicles and the timer arrays, the timers are kept here instead
+	// of in the vehicles
+	CEntityPool<EntityId, MAX_VEHICLES> m_denseIndex;
+	std::vector<EntityId> m_activeVehicles;
+	std::vector<CVehicle *> m_vehicles; // NULL while the vehicle is created
+	std::vector<int> m_respawnDelays;
+	std::vector<unsigned long> m_respawnTimes; // 0 if no respawn is scheduled
+	std::vector<unsigned long> m_lastTimesOccupied;
+	std::vector<unsigned long> m_deathTimes;
+	std::vector<unsigned long> m_wakeTimes; // Last time the vehicle moved, was occupied or changed by a script
+
+	// Pending respawns, timers that no longer match m_respawnTimes or m_deathTimes
+	// (e.g. as the vehicle got occupied) are dropped when they come up
+	std::priority_queue<VehicleTimer> m_timers;
+	unsigned long m_ulLastSyncOwnerUpdateTime;
+	unsigned int m_uiSyncOwnerUpdates;
+
+	void AddSlot(EntityId vehicleId, int iRespawnDelay);
+	void RemoveSlot(EntityId vehicleId);
+	void AddTimer(unsigned long ulTime, EntityId vehicleId, eVehicleTimerType type);
+	void ScheduleRespawn(EntityId vehicleId, unsigned long ulTime);
+	bool CanSyncVehicle(EntityId playerId, CVehicle * pVehicle, const CVector3& vecPosition, float fDistance);
+	bool IsAsleep(EntityId index, unsigned long ulTime);
+	void UpdateSyncOwners();
 
 public:
 	CVehicleManager();
 	~CVehicleManager();
 
 	EntityId Add(int iModelId, CVector3 vecSpawnPosition, CVector3 vecSpawnRotation, BYTE byteColor1, BYTE byteColor2, BYTE byteColor3, BYTE byteColor4, int respawn_delay = -1);
+	// Adds uiCount vehicles with contiguous ids, pColors holds 4 colors per vehicle. Returns the
+	// first id or INVALID_ENTITY_ID if there is no free range large enough
+	EntityId AddBatch(unsigned int uiCount, const int * pModelIds, const CVector3 * pSpawnPositions, const CVector3 * pSpawnRotations, const BYTE * pColors);
 	void Remove(EntityId vehicleId);
-	void HandleClientJoin(EntityId playerId);
+	bool HandleClientJoin(EntityId playerId, JoinStreamCursor * pCursor);
+	void SpawnForPlayer(EntityId playerId, const std::list<EntityId>& vehicleList);
 	bool DoesExist(EntityId vehicleId);
 	int GetVehicleCount();
 	void Process();
 	CVehicle * GetAt(EntityId vehicleId);
+	const std::vector<EntityId>& GetActiveVehicles() { return m_activeVehicles; }
+
+	// Called by the vehicles when a seat changes
+	void OnOccupantsChanged(EntityId vehicleId);
+
+	// Called by the vehicles when they move or a script changes them, empty vehicles
+	// that don't fall asleep after VEHICLE_SLEEP_TIME
+	void WakeUp(EntityId vehicleId);
+	bool IsAsleep(EntityId vehicleId);
+
+	void SetRespawnDelay(EntityId vehicleId, int iRespawnDelay);
+	int GetRespawnDelay(EntityId vehicleId);
+	void SetLastTimeOccupied(EntityId vehicleId, unsigned long ulTime);
+	unsigned long GetLastTimeOccupied(EntityId vehicleId);
+	void SetDeathTime(EntityId vehicleId, unsigned long ulTime);
+	unsigned long GetDeathTime(EntityId vehicleId);
 };
\ No newline at end of file
@@ -14,48 +14,457 @@
 #include <iostream>
 #include <CSettings.h>
 #include "CEvents.h"
+#include "CTickProfiler.h"
+#include "CServerMetrics.h"
+#include "CAdminApi.h"
 #include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <zlib-1.2.5/zlib.h>
 #ifdef _LINUX
+#include <utime.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #else
 #include <winsock2.h>
+#include <sys/utime.h>
 #endif
 #include <CLogFile.h>
+#include <Scripting/CScriptBytecodeCache.h>
+#include <CMemoryTracker.h>
 
 extern CEvents * g_pEvents;
-CMutex           g_webMutex;
+extern CTickProfiler * g_pTickProfiler;
+extern CServerMetrics * g_pServerMetrics;
+extern CAdminApi * g_pAdminApi;
+
+// Memory of a queued request and of a cached response (without the containers)
+static size_t GetRequestSize(WebRequest * pRequest)
+{
+	return (sizeof(WebRequest) + pRequest->strBody.GetLength() + pRequest->strResponse.GetLength());
+}
+
+static size_t GetCachedResponseSize(const String& strKey, const WebCachedResponse& response)
+{
+	return (sizeof(WebCachedResponse) + strKey.GetLength() + response.strContentType.GetLength() + response.strResponse.GetLength());
+}
+
+// Writes a json response to the web client
+static void SendJSON(mg_connection * conn, String strJSON)
+{
+	mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\nCache-Control: no-cache\r\n\r\n", strJSON.GetLength());
+	mg_write(conn, strJSON.Get(), strJSON.GetLength());
+}
+
+// Writes a response in the text exposition format of the metrics to the web client
+static void SendMetrics(mg_connection * conn, String strText)
+{
+	mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nCache-Control: no-cache\r\n\r\n", strText.GetLength());
+	mg_write(conn, strText.Get(), strText.GetLength());
+}
+
+bool CWebServer::SendCompressedFile(mg_connection * conn, const mg_request_info * request_info)
+{
+	// Only client files have compressed copies and ranges are always of the uncompressed file
+	const char * szAcceptEncoding = mg_get_header(conn, "Accept-Encoding");
+
+	if(!szAcceptEncoding || !strstr(szAcceptEncoding, "gzip") || mg_get_header(conn, "Range") ||
+		(strncmp(request_info->uri, "/clientscripts/", 15) && strncmp(request_info->uri, "/resources/", 11)) ||
+		strstr(request_info->uri, ".."))
+		return false;
+
+	// Is the compressed copy smaller than the file?
+	String strFilePath(SharedUtility::GetAbsolutePath("webserver%s", request_info->uri));
+	String strCompressedFilePath("%s%s", strFilePath.Get(), WEBSERVER_COMPRESSED_EXTENSION);
+	struct stat fileStat;
+	struct stat compressedFileStat;
+
+	if(stat(strFilePath.Get(), &fileStat) != 0 || stat(strCompressedFilePath.Get(), &compressedFileStat) != 0 ||
+		compressedFileStat.st_size >= fileStat.st_size)
+		return false;
+
+	FILE * fFile = fopen(strCompressedFilePath.Get(), "rb");
+
+	if(!fFile)
+		return false;
+
+	mg_printf(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/octet-stream\r\nContent-Encoding: gzip\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", (int)compressedFileStat.st_size);
+
+	if(strcmp(request_info->request_method, "HEAD"))
+	{
+		char szBuffer[8192];
+		size_t sBytesRead = 0;
+
+		while((sBytesRead = fread(szBuffer, 1, sizeof(szBuffer), fFile)) > 0)
+		{
+			if(mg_write(conn, szBuffer, sBytesRead) <= 0)
+				break;
+		}
+	}
+
+	fclose(fFile);
+	return true;
+}
+
+bool CWebServer::IsStaticFile(const mg_request_info * request_info)
+{
+	// Mongoose serves the files of the webserver folder
+	if(strstr(request_info->uri, ".."))
+		return false;
+
+	struct stat fileStat;
+	return (stat(SharedUtility::GetAbsolutePath("webserver%s", request_info->uri).Get(), &fileStat) == 0 && (fileStat.st_mode & S_IFREG));
+}
+
+void CWebServer::SendResponse(mg_connection * conn, int iStatusCode, const String& strContentType, const String& strResponse, bool bHead)
+{
+	mg_printf(conn, "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %d\r\nCache-Control: no-cache\r\n\r\n", iStatusCode,
+		((iStatusCode >= 200 && iStatusCode < 300) ? "OK" : "Error"), strContentType.Get(), strResponse.GetLength());
+
+	if(!bHead)
+		mg_write(conn, strResponse.Get(), strResponse.GetLength());
+}
+
+bool CWebServer::SendCachedResponse(mg_connection * conn, const String& strCacheKey, bool bHead)
+{
+	m_cacheMutex.Lock();
+	std::map<String, WebCachedResponse>::iterator iter = m_cachedResponses.find(strCacheKey);
+
+	if(iter == m_cachedResponses.end() || SharedUtility::GetTime() >= iter->second.ulExpireTime)
+	{
+		m_cacheMutex.Unlock();
+		return false;
+	}
+
+	// Don't write to the client while other threads wait for the cache
+	WebCachedResponse response = iter->second;
+	m_cacheMutex.Unlock();
+	SendResponse(conn, response.iStatusCode, response.strContentType, response.strResponse, bHead);
+	return true;
+}
+
+void CWebServer::HandleScriptRequest(mg_connection * conn, const mg_request_info * request_info, bool bAdmin)
+{
+	bool bHead = !strcmp(request_info->request_method, "HEAD");
+	bool bGet = (bHead || !strcmp(request_info->request_method, "GET"));
+	String strQuery(request_info->query_string ? request_info->query_string : "");
+
+	if(!bAdmin && bGet && SendCachedResponse(conn, GetCacheKey(request_info->uri, strQuery), bHead))
+		return;
+
+	WebRequest * pRequest = new WebRequest;
+	pRequest->strUri = request_info->uri;
+	pRequest->strQuery = strQuery;
+	pRequest->strMethod = request_info->request_method;
+	pRequest->bAdmin = bAdmin;
+
+	// inet_ntoa isn't thread safe
+	unsigned long ulIp = (unsigned long)request_info->remote_ip;
+	pRequest->strIpAddress.Format("%lu.%lu.%lu.%lu", ((ulIp >> 24) & 0xFF), ((ulIp >> 16) & 0xFF), ((ulIp >> 8) & 0xFF), (ulIp & 0xFF));
+	pRequest->bAnswered = false;
+	pRequest->iStatusCode = 0;
+
+	// Read the body of the request
+	const char * szContentLength = mg_get_header(conn, "Content-Length");
+	int iContentLength = (szContentLength ? atoi(szContentLength) : 0);
+
+	if(iContentLength > WEBSERVER_MAX_BODY_SIZE)
+	{
+		SendResponse(conn, 413, "text/plain", "Request Entity Too Large", bHead);
+		delete pRequest;
+		return;
+	}
+
+	if(iContentLength > 0)
+	{
+		char * szBody = new char[iContentLength];
+		int iRead = 0;
+		int iBytes = 0;
+
+		while(iRead < iContentLength && (iBytes = mg_read(conn, (szBody + iRead), (iContentLength - iRead))) > 0)
+			iRead += iBytes;
+
+		pRequest->strBody.Set(szBody, iRead);
+		delete [] szBody;
+	}
+
+	// Queue the request for the main thread
+	m_requestMutex.Lock();
+
+	if(m_bStopping || m_queuedRequests.size() >= WEBSERVER_MAX_QUEUED_REQUESTS)
+	{
+		m_requestMutex.Unlock();
+		SendResponse(conn, 503, "text/plain", "Service Unavailable", bHead);
+		delete pRequest;
+		return;
+	}
+
+	pRequest->uiId = m_uiNextRequestId++;
+	m_queuedRequests.push_back(pRequest);
+	CMemoryTracker::Allocated(MEMORY_TAG_WEBSERVER, GetRequestSize(pRequest));
+	m_requestMutex.Unlock();
+
+	// Wait for the answer of the scripts
+	unsigned long ulTimeOutTime = (SharedUtility::GetTime() + WEBSERVER_REQUEST_TIMEOUT);
+	bool bAnswered = false;
+
+	while(true)
+	{
+		m_requestMutex.Lock();
+		bAnswered = pRequest->bAnswered;
+
+		// Nobody answers the request anymore once it is gone from the lists
+		if(!bAnswered && SharedUtility::GetTime() >= ulTimeOutTime)
+		{
+			m_queuedRequests.remove(pRequest);
+			m_pendingRequests.erase(pRequest->uiId);
+			m_requestMutex.Unlock();
+			break;
+		}
+
+		m_requestMutex.Unlock();
+
+		if(bAnswered)
+			break;
+
+		pRequest->answeredEvent.Wait(WEBSERVER_REQUEST_TIMEOUT);
+	}
+
+	if(bAnswered)
+		SendResponse(conn, pRequest->iStatusCode, pRequest->strContentType, pRequest->strResponse, bHead);
+	else
+		SendResponse(conn, 504, "text/plain", "Gateway Timeout", bHead);
+
+	CMemoryTracker::Freed(MEMORY_TAG_WEBSERVER, GetRequestSize(pRequest));
+	delete pRequest;
+}
+
+void CWebServer::Answer(WebRequest * pRequest, int iStatusCode, const String& strContentType, const String& strResponse)
+{
+	// The request mutex must be locked
+	pRequest->iStatusCode = iStatusCode;
+	pRequest->strContentType = strContentType;
+	pRequest->strResponse = strResponse;
+	CMemoryTracker::Allocated(MEMORY_TAG_WEBSERVER, strResponse.GetLength());
+	pRequest->bAnswered = true;
+	pRequest->answeredEvent.Signal();
+}
+
+bool CWebServer::Respond(unsigned int uiRequestId, int iStatusCode, const String& strContentType, const String& strResponse, unsigned int uiTTL)
+{
+	m_requestMutex.Lock();
+	std::map<unsigned int, WebRequest *>::iterator iter = m_pendingRequests.find(uiRequestId);
+
+	if(iter == m_pendingRequests.end())
+	{
+		m_requestMutex.Unlock();
+		return false;
+	}
+
+	WebRequest * pRequest = iter->second;
+	m_pendingRequests.erase(iter);
+	bool bCache = (uiTTL > 0 && (pRequest->strMethod == "GET" || pRequest->strMethod == "HEAD"));
+	String strCacheKey;
+
+	if(bCache)
+		strCacheKey = GetCacheKey(pRequest->strUri, pRequest->strQuery);
+
+	Answer(pRequest, iStatusCode, strContentType, strResponse);
+	m_requestMutex.Unlock();
+
+	if(bCache)
+	{
+		m_cacheMutex.Lock();
+
+		std::map<String, WebCachedResponse>::iterator cacheIter = m_cachedResponses.find(strCacheKey);
+
+		if(m_cachedResponses.size() < WEBSERVER_MAX_CACHED_RESPONSES || cacheIter != m_cachedResponses.end())
+		{
+			if(cacheIter != m_cachedResponses.end())
+				CMemoryTracker::Freed(MEMORY_TAG_WEBSERVER, GetCachedResponseSize(strCacheKey, cacheIter->second));
+
+			WebCachedResponse& response = m_cachedResponses[strCacheKey];
+			response.iStatusCode = iStatusCode;
+			response.strContentType = strContentType;
+			response.strResponse = strResponse;
+			response.ulExpireTime = (SharedUtility::GetTime() + (uiTTL * 1000));
+			CMemoryTracker::Allocated(MEMORY_TAG_WEBSERVER, GetCachedResponseSize(strCacheKey, response));
+		}
+
+		m_cacheMutex.Unlock();
+	}
+
+	return true;
+}
+
+void CWebServer::PruneCache()
+{
+	m_cacheMutex.Lock();
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	for(std::map<String, WebCachedResponse>::iterator iter = m_cachedResponses.begin(); iter != m_cachedResponses.end(); )
+	{
+		if(ulTime >= iter->second.ulExpireTime)
+		{
+			CMemoryTracker::Freed(MEMORY_TAG_WEBSERVER, GetCachedResponseSize(iter->first, iter->second));
+			m_cachedResponses.erase(iter++);
+		}
+		else
+			iter++;
+	}
+
+	m_cacheMutex.Unlock();
+}
+
+void CWebServer::Process()
+{
+	if(!m_pMongooseContext)
+		return;
+
+	// Take all queued requests at once so the mongoose threads can queue more while the scripts run
+	m_requestMutex.Lock();
+	std::list<unsigned int> requestIds;
+
+	for(std::list<WebRequest *>::iterator iter = m_queuedRequests.begin(); iter != m_queuedRequests.end(); iter++)
+	{
+		m_pendingRequests[(*iter)->uiId] = *iter;
+		requestIds.push_back((*iter)->uiId);
+	}
+
+	m_queuedRequests.clear();
+	m_requestMutex.Unlock();
+
+	for(std::list<unsigned int>::iterator iter = requestIds.begin(); iter != requestIds.end(); iter++)
+	{
+		// The request is only valid while it is pending, it can time out while the scripts run
+		unsigned int uiRequestId = *iter;
+		m_requestMutex.Lock();
+		std::map<unsigned int, WebRequest *>::iterator pendingIter = m_pendingRequests.find(uiRequestId);
+
+		if(pendingIter == m_pendingRequests.end())
+		{
+			m_requestMutex.Unlock();
+			continue;
+		}
+
+		WebRequest * pRequest = pendingIter->second;
+
+		if(pRequest->bAdmin)
+		{
+			String strUri(pRequest->strUri);
+			String strMethod(pRequest->strMethod);
+			String strQuery(pRequest->strQuery);
+			String strBody(pRequest->strBody);
+			m_requestMutex.Unlock();
+			String strJSON;
+			int iStatusCode = g_pAdminApi->Handle(strUri, strMethod, strQuery, strBody, strJSON);
+			Respond(uiRequestId, iStatusCode, "application/json", strJSON, 0);
+			continue;
+		}
+
+		CSquirrelArguments arguments;
+		arguments.push((int)uiRequestId);
+		arguments.push(pRequest->strUri);
+		arguments.push(pRequest->strIpAddress);
+		arguments.push(pRequest->strMethod);
+		arguments.push(pRequest->strQuery);
+		arguments.push(pRequest->strBody);
+		m_requestMutex.Unlock();
+
+		// Scripts answer with a string, or return true and call sendWebResponse now or later
+		CSquirrelArgument result = g_pEvents->Call("webRequest", &arguments);
+
+		if(result.GetType() == OT_STRING)
+			Respond(uiRequestId, 200, "text/html", result.GetString(), 0);
+		else if(result.GetType() != OT_BOOL || !result.GetBool())
+			Respond(uiRequestId, 404, "text/plain", "Not Found", 0);
+	}
+
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - m_ulLastCachePruneTime) >= WEBSERVER_REQUEST_TIMEOUT)
+	{
+		PruneCache();
+		m_ulLastCachePruneTime = ulTime;
+	}
+}
+
+bool CWebServer::CompressFile(String strSource, String strDestination)
+{
+	FILE * fSource = fopen(strSource.Get(), "rb");
+
+	if(!fSource)
+		return false;
+
+	gzFile gzDestination = gzopen(strDestination.Get(), "wb9");
+
+	if(!gzDestination)
+	{
+		fclose(fSource);
+		return false;
+	}
+
+	char szBuffer[8192];
+	size_t sBytesRead = 0;
+	bool bCompressed = true;
+
+	while(bCompressed && (sBytesRead = fread(szBuffer, 1, sizeof(szBuffer), fSource)) > 0)
+		bCompressed = (gzwrite(gzDestination, szBuffer, (unsigned int)sBytesRead) == (int)sBytesRead);
+
+	fclose(fSource);
+	bCompressed = (gzclose(gzDestination) == Z_OK && bCompressed);
+
+	// Don't leave broken compressed files around
+	if(!bCompressed)
+		remove(strDestination.Get());
+
+	return bCompressed;
+}
 
 void * CWebServer::MongooseEventHandler(mg_event event, mg_connection * conn)
 {
 	if(event == MG_NEW_REQUEST)
 	{
-		// Lock the web mutex
-		g_webMutex.Lock();
 		const mg_request_info* request_info = mg_get_request_info(conn);
-		// Get the ip address
-		in_addr sa;
-		memset(&sa, 0, sizeof(in_addr));
-		sa.s_addr = htonl(request_info->remote_ip);
-		char * szIpAddress = inet_ntoa(sa);
-
-		// Call the scripting event
-		/*CSquirrelArguments args;
-		args.push(request_info->uri);
-		args.push(szIpAddress);
-		args.push(request_info->request_method);
-		g_pEvents->Call("webRequest", &args);*/
-
-		// Output the string to the web client
-		/*const char * out = "yes";
-		mg_printf(conn, out);*/
-
-		// Unlock the web mutex
-		g_webMutex.Unlock();
+
+		// Is it a request for the tick profiler statistics?
+		if(g_pTickProfiler && g_pTickProfiler->IsEnabled() && !strcmp(request_info->uri, TICK_PROFILER_URI))
+		{
+			SendJSON(conn, g_pTickProfiler->GetJSON());
+			return (void *)"yes";
+		}
+
+		if(g_pServerMetrics && g_pServerMetrics->IsEnabled() && !strcmp(request_info->uri, SERVER_METRICS_URI))
+		{
+			SendMetrics(conn, g_pServerMetrics->GetText());
+			return (void *)"yes";
+		}
+
+		// Send the compressed copy of client files if the client accepts it
+		if(SendCompressedFile(conn, request_info))
+			return (void *)"yes";
+
+		// Admin api requests are handled in the tick like the script requests
+		if(g_pAdminApi && g_pAdminApi->IsEnabled() && CAdminApi::IsAdminUri(request_info->uri))
+		{
+			if(g_pAdminApi->IsAuthorized(mg_get_header(conn, "Authorization")))
+				((CWebServer *)mg_get_user_data(conn))->HandleScriptRequest(conn, request_info, true);
+			else
+				SendResponse(conn, 401, "application/json", "{\"error\": \"unauthorized\"}", !strcmp(request_info->request_method, "HEAD"));
+
+			return (void *)"yes";
+		}
+
+		// Let mongoose serve the files
+		if(IsStaticFile(request_info))
+			return NULL;
+
+		// Everything else is for the scripts
+		((CWebServer *)mg_get_user_data(conn))->HandleScriptRequest(conn, request_info, false);
 
 		// Handled
-		//return (void *)"yes";
+		return (void *)"yes";
 	}
 
 	// Not handled
@@ -63,9 +472,14 @@ void * CWebServer::MongooseEventHandler(mg_event event, mg_connection * conn)
 }
 
 CWebServer::CWebServer(unsigned short usHTTPPort) 
+	: m_checksumCache(SharedUtility::GetAbsolutePath(CHECKSUM_CACHE_FILE))
 {
 	// Reset the mongoose context pointer
 	m_pMongooseContext = NULL;
+	m_uiNextRequestId = 0;
+	m_bStopping = false;
+	m_ulLastCachePruneTime = SharedUtility::GetTime();
+	m_bHashedFiles = (CVAR_GET_STRING("httpserver").IsNotEmpty() && CVAR_GET_BOOL("hashedfiles"));
 
 	// Do we not have an external Webserver configured?
 	if(CVAR_GET_STRING("httpserver").IsEmpty())
@@ -86,7 +500,7 @@ CWebServer::CWebServer(unsigned short usHTTPPort)
 		options[6] = NULL;
 
 		// Start the mongoose context
-		m_pMongooseContext = mg_start(MongooseEventHandler, 0, (const char **)options);
+		m_pMongooseContext = mg_start(MongooseEventHandler, this, (const char **)options);
 
 		// Free the options
 		for(int i = 0; i < 6; i++)
@@ -103,16 +517,35 @@ CWebServer::~CWebServer()
 	// Stop the mongoose context
 	if(m_pMongooseContext)
 	{
+		// Don't let the mongoose threads wait for requests that are never answered
+		m_requestMutex.Lock();
+		m_bStopping = true;
+
+		for(std::list<WebRequest *>::iterator iter = m_queuedRequests.begin(); iter != m_queuedRequests.end(); iter++)
+			Answer(*iter, 503, "text/plain", "Service Unavailable");
+
+		for(std::map<unsigned int, WebRequest *>::iterator iter = m_pendingRequests.begin(); iter != m_pendingRequests.end(); iter++)
+			Answer(iter->second, 503, "text/plain", "Service Unavailable");
+
+		m_queuedRequests.clear();
+		m_pendingRequests.clear();
+		m_requestMutex.Unlock();
+
 		mg_stop(m_pMongooseContext);
 		m_pMongooseContext = NULL;
 	}
+
+	for(std::map<String, WebCachedResponse>::iterator iter = m_cachedResponses.begin(); iter != m_cachedResponses.end(); iter++)
+		CMemoryTracker::Freed(MEMORY_TAG_WEBSERVER, GetCachedResponseSize(iter->first, iter->second));
 }
 
-bool CWebServer::FileCopy(String strClientFile, bool bIsScript, CFileChecksum &fileChecksum)
+bool CWebServer::FileCopy(String strClientFile, bool bIsScript, CFileChecksum &fileChecksum, unsigned int &uiSize)
 {
 	String strType = bIsScript ? "clientscripts" : "resources";
 	String strClientFilePath(SharedUtility::GetAbsolutePath("%s/%s", strType.Get(), strClientFile.Get()));
 
+	bool bBytecode = false;
+
 	// Do we not have an external Webserver configured?
 	if(CVAR_GET_STRING("httpserver").IsEmpty())
 	{
@@ -129,9 +562,105 @@ bool CWebServer::FileCopy(String strClientFile, bool bIsScript, CFileChecksum &f
 		if(!SharedUtility::Exists(strWebServerTypeFolder.Get()))
 			SharedUtility::CreateDirectory(strWebServerTypeFolder.Get());
 
-		if(!SharedUtility::CopyFile(strClientFilePath.Get(), strClientWebServerFilePath.Get()))
-			return false;
+		String strCompressedFilePath("%s%s", strClientWebServerFilePath.Get(), WEBSERVER_COMPRESSED_EXTENSION);
+		struct stat fileStat;
+		struct stat copyFileStat;
+		struct stat compressedFileStat;
+		bool bHasFileStat = (stat(strClientFilePath.Get(), &fileStat) == 0);
+		bool bCopyIsBytecode = CScriptBytecodeCache::IsBytecode(strClientWebServerFilePath);
+		bBytecode = (bIsScript && CVAR_GET_BOOL("clientscriptbytecode"));
+
+		// Send scripts compiled so the clients don't have to compile them, the compiled
+		// copy gets the modification time of the source so it is only compiled again
+		// once the source changed
+		if(bBytecode && (!bCopyIsBytecode || !bHasFileStat || stat(strClientWebServerFilePath.Get(), &copyFileStat) != 0 || copyFileStat.st_mtime != fileStat.st_mtime))
+		{
+			if(CScriptBytecodeCache::Compile(strClientFilePath, strClientWebServerFilePath))
+			{
+				if(bHasFileStat)
+				{
+					utimbuf times;
+					times.actime = fileStat.st_atime;
+					times.modtime = fileStat.st_mtime;
+					utime(strClientWebServerFilePath.Get(), &times);
+				}
+
+				// The compressed file was made from the old copy
+				remove(strCompressedFilePath.Get());
+			}
+			else
+			{
+				CLogFile::Printf("Failed to compile client script %s, sending its source instead.", strClientFile.Get());
+				bBytecode = false;
+			}
+		}
+
+		if(!bBytecode)
+		{
+			if(!SharedUtility::CopyFile(strClientFilePath.Get(), strClientWebServerFilePath.Get()))
+				return false;
+
+			// The compressed file was made from the compiled copy
+			if(bCopyIsBytecode)
+				remove(strCompressedFilePath.Get());
+		}
+
+		// Compress the file again if it changed since it was last compressed, the
+		// compressed file gets the modification time of the file it was made from
+		if(bHasFileStat && (stat(strCompressedFilePath.Get(), &compressedFileStat) != 0 || compressedFileStat.st_mtime != fileStat.st_mtime))
+		{
+			if(CompressFile(strClientWebServerFilePath, strCompressedFilePath))
+			{
+				utimbuf times;
+				times.actime = fileStat.st_atime;
+				times.modtime = fileStat.st_mtime;
+				utime(strCompressedFilePath.Get(), &times);
+			}
+			else
+				remove(strCompressedFilePath.Get());
+		}
+
+		// The clients get the compiled copy
+		if(bBytecode)
+			return m_checksumCache.GetChecksum(strClientWebServerFilePath, fileChecksum, &uiSize);
+	}
+
+	if(!m_checksumCache.GetChecksum(strClientFilePath, fileChecksum, &uiSize))
+		return false;
+
+	if(m_bHashedFiles && !PublishHashedFile(strClientFilePath, strClientFile, fileChecksum, uiSize))
+	{
+		CLogFile::Printf("Failed to publish client file %s to the hashed files folder.", strClientFile.Get());
+		return false;
+	}
+
+	return true;
+}
+
+bool CWebServer::PublishHashedFile(String strFilePath, String strName, CFileChecksum fileChecksum, unsigned int uiSize)
+{
+	String strFolder(SharedUtility::GetAbsolutePath("%s", CVAR_GET_STRING("hashedfilesfolder").Get()));
+
+	if(!SharedUtility::Exists(strFolder.Get()))
+		SharedUtility::CreateDirectory(strFolder.Get());
+
+	// A hashed file never changes, one that is there already has the same content
+	String strHashedFilePath("%s/%s", strFolder.Get(), fileChecksum.GetHashedName(uiSize, strName).Get());
+
+	if(SharedUtility::Exists(strHashedFilePath.Get()))
+		return true;
+
+	// Copy to a temporary file first so an upload never gets half a file
+	String strPartPath("%s.part", strHashedFilePath.Get());
+
+	if(!SharedUtility::CopyFile(strFilePath.Get(), strPartPath.Get()))
+		return false;
+
+	if(rename(strPartPath.Get(), strHashedFilePath.Get()) != 0)
+	{
+		remove(strPartPath.Get());
+		return false;
 	}
 
-	return fileChecksum.Calculate(strClientFilePath.Get());
+	return true;
 }
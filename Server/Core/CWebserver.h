@@ -13,17 +13,102 @@
 #include "SharedUtility.h"
 #include <mongoose/mongoose.h>
 #include <CFileChecksum.h>
+#include <CChecksumCache.h>
+#include <Threading/CMutex.h>
+#include <Threading/CThreadEvent.h>
+#include <list>
+#include <map>
 
+// Extension of the gzip compressed copies of the client files
+#define WEBSERVER_COMPRESSED_EXTENSION ".gz"
+
+// Time in ms a script has to answer a web request
+#define WEBSERVER_REQUEST_TIMEOUT 10000
+
+// Maximum amount of web requests that can wait for the scripts
+#define WEBSERVER_MAX_QUEUED_REQUESTS 256
+
+// Maximum size in bytes of the body of a request to the scripts
+#define WEBSERVER_MAX_BODY_SIZE 65536
+
+// Maximum amount of cached script responses
+#define WEBSERVER_MAX_CACHED_RESPONSES 1024
+
+// A web request that is answered by the scripts
+struct WebRequest
+{
+	unsigned int           uiId;
+	String                 strUri;
+	String                 strQuery;
+	String                 strMethod;
+	String                 strIpAddress;
+	String                 strBody;
+	bool                   bAdmin; // For the admin api and not for the scripts
+
+	// Set once the request is answered
+	bool                   bAnswered;
+	int                    iStatusCode;
+	String                 strContentType;
+	String                 strResponse;
+	CThreadEvent           answeredEvent;
+};
+
+// A script response that is sent again for the same uri until it expires
+struct WebCachedResponse
+{
+	int                    iStatusCode;
+	String                 strContentType;
+	String                 strResponse;
+	unsigned long          ulExpireTime;
+};
+
+// Serves the client files and the requests of the scripts. The mongoose
+// threads queue the requests for the scripts and wait for their answer, the
+// main thread calls the webRequest event for the queued requests each tick.
+// Static files never wait for the main thread.
 class CWebServer
 {
 private:
-	mg_context * m_pMongooseContext;
+	mg_context   * m_pMongooseContext;
+	CChecksumCache m_checksumCache;
+	bool           m_bHashedFiles;
+	CMutex         m_requestMutex;
+	unsigned int   m_uiNextRequestId;
+	bool           m_bStopping;
+	std::list<WebRequest *> m_queuedRequests;
+	std::map<unsigned int, WebRequest *> m_pendingRequests;
+	CMutex         m_cacheMutex;
+	std::map<String, WebCachedResponse> m_cachedResponses;
+	unsigned long  m_ulLastCachePruneTime;
 
 	static void * MongooseEventHandler(mg_event event, mg_connection * conn);
+	static bool   SendCompressedFile(mg_connection * conn, const mg_request_info * request_info);
+	static bool   IsStaticFile(const mg_request_info * request_info);
+	static bool   CompressFile(String strSource, String strDestination);
+	static bool   PublishHashedFile(String strFilePath, String strName, CFileChecksum fileChecksum, unsigned int uiSize);
+	static void   SendResponse(mg_connection * conn, int iStatusCode, const String& strContentType, const String& strResponse, bool bHead);
+	static String GetCacheKey(const String& strUri, const String& strQuery) { return String("%s?%s", strUri.Get(), strQuery.Get()); }
+	bool          SendCachedResponse(mg_connection * conn, const String& strCacheKey, bool bHead);
+	void          HandleScriptRequest(mg_connection * conn, const mg_request_info * request_info, bool bAdmin);
+	void          Answer(WebRequest * pRequest, int iStatusCode, const String& strContentType, const String& strResponse);
+	void          PruneCache();
 
 public:
 	CWebServer(unsigned short usHTTPPort);
 	~CWebServer();
 
-	bool FileCopy(String strClientFile, bool bIsScript, CFileChecksum &fileChecksum);
+	bool FileCopy(String strClientFile, bool bIsScript, CFileChecksum &fileChecksum, unsigned int &uiSize);
+
+	// Clients download the client files from the external webserver by their content
+	bool HasHashedFiles() { return m_bHashedFiles; }
+
+	// Writes the checksums of the client files if any changed
+	void SaveChecksumCache() { m_checksumCache.Save(); }
+
+	// Answers a request of the webRequest event, GET responses with a ttl (in
+	// seconds) are sent again for the same uri until the ttl is over
+	bool Respond(unsigned int uiRequestId, int iStatusCode, const String& strContentType, const String& strResponse, unsigned int uiTTL);
+
+	// Calls the webRequest event for the queued requests
+	void Process();
 };
@@ -0,0 +1,593 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CWorldSnapshotManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CWorldSnapshotManager.h"
+#include "CVehicleManager.h"
+#include "CObjectManager.h"
+#include "CPickupManager.h"
+#include "CBlipManager.h"
+#include "CCheckpointManager.h"
+#include "CEvents.h"
+#include <SharedUtility.h>
+#include <CLogFile.h>
+#include <stdio.h>
+
+extern CVehicleManager    * g_pVehicleManager;
+extern CObjectManager     * g_pObjectManager;
+extern CPickupManager     * g_pPickupManager;
+extern CBlipManager       * g_pBlipManager;
+extern CCheckpointManager * g_pCheckpointManager;
+extern CEvents            * g_pEvents;
+extern CJobSystem         * g_pJobSystem;
+
+#define WORLD_SNAPSHOT_KEY(type, id) ((((unsigned int)(type)) << 16) | (id))
+
+CWorldSnapshotManager::CWorldSnapshotManager()
+{
+	m_uiIncrements = 0;
+	m_bIncremental = false;
+	m_bSucceeded = false;
+	m_uiRecordsWritten = 0;
+	m_bWriting = false;
+}
+
+CWorldSnapshotManager::~CWorldSnapshotManager()
+{
+	// Let the snapshot that is being written finish
+	if(m_bWriting)
+		g_pJobSystem->Wait(&m_writeCounter);
+}
+
+static void AddRecord(WorldSnapshotRecords& records, eWorldSnapshotEntity type, EntityId entityId, CBitStream * pBitStream)
+{
+	std::vector<unsigned char>& data = records[WORLD_SNAPSHOT_KEY(type, entityId)];
+	data.assign(pBitStream->GetData(), (pBitStream->GetData() + pBitStream->GetNumberOfBytesUsed()));
+	pBitStream->Reset();
+}
+
+void CWorldSnapshotManager::Capture(WorldSnapshotRecords& records)
+{
+	CBitStream bitStream;
+
+	// Vehicles
+	const std::vector<EntityId>& vehicles = g_pVehicleManager->GetActiveVehicles();
+
+	for(std::vector<EntityId>::const_iterator iter = vehicles.begin(); iter != vehicles.end(); ++iter)
+	{
+		CVehicle * pVehicle = g_pVehicleManager->GetAt(*iter);
+
+		// The vehicles of actors belong to them
+		if(!pVehicle || pVehicle->IsActorVehicle())
+			continue;
+
+		CVector3 vecPosition;
+		CVector3 vecRotation;
+		BYTE byteColors[4];
+		bitStream.Write(pVehicle->GetModel());
+		pVehicle->GetSpawnPosition(vecPosition);
+		pVehicle->GetSpawnRotation(vecRotation);
+		bitStream.Write(vecPosition);
+		bitStream.Write(vecRotation);
+
+		for(unsigned char i = 0; i < 4; i++)
+			bitStream.Write(pVehicle->GetSpawnColor(i));
+
+		bitStream.Write(g_pVehicleManager->GetRespawnDelay(*iter));
+		pVehicle->GetPosition(vecPosition);
+		pVehicle->GetRotation(vecRotation);
+		pVehicle->GetColors(byteColors[0], byteColors[1], byteColors[2], byteColors[3]);
+		bitStream.Write(vecPosition);
+		bitStream.Write(vecRotation);
+		bitStream.Write((char *)byteColors, sizeof(byteColors));
+		bitStream.Write(pVehicle->GetHealth());
+		bitStream.Write(pVehicle->GetPetrolTankHealth());
+		bitStream.Write(pVehicle->GetDirtLevel());
+		bitStream.Write(pVehicle->GetLocked());
+		bitStream.Write(pVehicle->GetSirenState());
+		bitStream.Write(pVehicle->GetEngineStatus());
+		bitStream.Write(pVehicle->GetLights());
+		bitStream.Write(pVehicle->GetTaxiLights());
+		bitStream.Write(pVehicle->GetVehicleGPSState());
+		bitStream.Write(pVehicle->GetVariation());
+
+		for(unsigned char i = 0; i < 9; i++)
+			bitStream.Write(pVehicle->GetComponentState(i));
+
+		for(unsigned int i = 0; i < 4; i++)
+			bitStream.Write(pVehicle->GetWindowState(i));
+
+		for(unsigned int i = 0; i < 6; i++)
+			bitStream.Write(pVehicle->GetTyreState(i));
+
+		bitStream.Write(pVehicle->GetDimension());
+		AddRecord(records, WORLD_SNAPSHOT_VEHICLE, *iter, &bitStream);
+	}
+
+	// Objects
+	const std::vector<EntityId>& objects = g_pObjectManager->GetActiveObjects();
+
+	for(std::vector<EntityId>::const_iterator iter = objects.begin(); iter != objects.end(); ++iter)
+	{
+		CVector3 vecPosition;
+		CVector3 vecRotation;
+		g_pObjectManager->GetPosition(*iter, vecPosition);
+		g_pObjectManager->GetRotation(*iter, vecRotation);
+		bitStream.Write(g_pObjectManager->GetModel(*iter));
+		bitStream.Write(vecPosition);
+		bitStream.Write(vecRotation);
+		bitStream.Write(g_pObjectManager->GetDimension(*iter));
+		AddRecord(records, WORLD_SNAPSHOT_OBJECT, *iter, &bitStream);
+	}
+
+	// Pickups
+	unsigned int uiPickups = g_pPickupManager->GetPickupCount();
+
+	for(EntityId x = 0; x < MAX_PICKUPS && uiPickups > 0; x++)
+	{
+		if(!g_pPickupManager->DoesExist(x))
+			continue;
+
+		CVector3 vecPosition;
+		CVector3 vecRotation;
+		g_pPickupManager->GetPosition(x, &vecPosition);
+		g_pPickupManager->GetRotation(x, &vecRotation);
+		bitStream.Write(g_pPickupManager->GetModel(x));
+		bitStream.Write(g_pPickupManager->GetType(x));
+		bitStream.Write(g_pPickupManager->GetValue(x));
+		bitStream.Write(vecPosition);
+		bitStream.Write(vecRotation);
+		AddRecord(records, WORLD_SNAPSHOT_PICKUP, x, &bitStream);
+		uiPickups--;
+	}
+
+	// Blips
+	for(EntityId x = 0; x < MAX_BLIPS; x++)
+	{
+		if(!g_pBlipManager->DoesExist(x))
+			continue;
+
+		bitStream.Write(g_pBlipManager->GetSprite(x));
+		bitStream.Write(g_pBlipManager->GetPosition(x));
+		bitStream.Write(g_pBlipManager->GetColor(x));
+		bitStream.Write(g_pBlipManager->GetSize(x));
+		bitStream.Write(g_pBlipManager->IsShortRange(x));
+		bitStream.Write(g_pBlipManager->IsRoute(x));
+		bitStream.Write(g_pBlipManager->GetName(x));
+		AddRecord(records, WORLD_SNAPSHOT_BLIP, x, &bitStream);
+	}
+
+	// Checkpoints
+	unsigned int uiCheckpoints = g_pCheckpointManager->GetCheckpointCount();
+
+	for(EntityId x = 0; x < MAX_CHECKPOINTS && uiCheckpoints > 0; x++)
+	{
+		CCheckpoint * pCheckpoint = g_pCheckpointManager->Get(x);
+
+		if(!pCheckpoint)
+			continue;
+
+		CVector3 vecPosition;
+		CVector3 vecTargetPosition;
+		pCheckpoint->GetPosition(vecPosition);
+		pCheckpoint->GetTargetPosition(vecTargetPosition);
+		bitStream.Write(pCheckpoint->GetType());
+		bitStream.Write(vecPosition);
+		bitStream.Write(vecTargetPosition);
+		bitStream.Write(pCheckpoint->GetRadius());
+		bitStream.Write(pCheckpoint->IsShown());
+		bitStream.Write(pCheckpoint->GetDimension());
+		AddRecord(records, WORLD_SNAPSHOT_CHECKPOINT, x, &bitStream);
+		uiCheckpoints--;
+	}
+}
+
+bool CWorldSnapshotManager::Save(String strFileName, bool bIncremental)
+{
+	if(m_bWriting)
+		return false;
+
+	m_strFileName = strFileName;
+	SharedUtility::RemoveIllegalCharacters(strFileName);
+	m_strPath = SharedUtility::GetAbsolutePath("files/%s", strFileName.Get());
+	m_bIncremental = bIncremental;
+	m_capture.clear();
+	Capture(m_capture);
+
+	// The write job owns the records until Process sees it is done
+	m_bWriting = true;
+	g_pJobSystem->Add(WriteJob, this, &m_writeCounter);
+	return true;
+}
+
+void CWorldSnapshotManager::WriteRecord(CBitStream * pBitStream, unsigned int uiKey, const std::vector<unsigned char> * pData)
+{
+	pBitStream->Write(uiKey);
+
+	if(!pData)
+	{
+		pBitStream->Write((unsigned char)WORLD_SNAPSHOT_RECORD_REMOVE);
+		return;
+	}
+
+	pBitStream->Write((unsigned char)WORLD_SNAPSHOT_RECORD_SET);
+	pBitStream->Write((unsigned int)pData->size());
+
+	if(!pData->empty())
+		pBitStream->Write((const char *)&(*pData)[0], (unsigned int)pData->size());
+}
+
+void CWorldSnapshotManager::WriteJob(void * pUserData)
+{
+	((CWorldSnapshotManager *)pUserData)->Write();
+}
+
+void CWorldSnapshotManager::Write()
+{
+	// Append to the file if we wrote it last and it hasn't got too many increments
+	bool bFull = (!m_bIncremental || m_strWrittenPath != m_strPath || m_uiIncrements >= WORLD_SNAPSHOT_MAX_INCREMENTS);
+	CBitStream bitStream;
+	unsigned int uiRecords = 0;
+
+	if(bFull)
+	{
+		bitStream.Write((unsigned int)WORLD_SNAPSHOT_MAGIC);
+		bitStream.Write((unsigned char)WORLD_SNAPSHOT_VERSION);
+	}
+
+	bitStream.Write((unsigned char)(bFull ? WORLD_SNAPSHOT_CHUNK_FULL : WORLD_SNAPSHOT_CHUNK_INCREMENT));
+
+	// The record count is filled in once it is known
+	unsigned int uiCountOffset = bitStream.GetNumberOfBytesUsed();
+	bitStream.Write(uiRecords);
+
+	for(WorldSnapshotRecords::const_iterator iter = m_capture.begin(); iter != m_capture.end(); ++iter)
+	{
+		if(!bFull)
+		{
+			WorldSnapshotRecords::const_iterator written = m_written.find((*iter).first);
+
+			if(written != m_written.end() && (*written).second == (*iter).second)
+				continue;
+		}
+
+		WriteRecord(&bitStream, (*iter).first, &(*iter).second);
+		uiRecords++;
+	}
+
+	if(!bFull)
+	{
+		for(WorldSnapshotRecords::const_iterator iter = m_written.begin(); iter != m_written.end(); ++iter)
+		{
+			if(m_capture.find((*iter).first) == m_capture.end())
+			{
+				WriteRecord(&bitStream, (*iter).first, NULL);
+				uiRecords++;
+			}
+		}
+	}
+
+	memcpy((bitStream.GetData() + uiCountOffset), &uiRecords, sizeof(uiRecords));
+
+	// Full snapshots are written next to the file and moved over it so a failed
+	// write never destroys the last snapshot, a torn increment is ignored on load
+	String strWritePath(m_strPath);
+
+	if(bFull)
+		strWritePath.Append(".tmp");
+
+	FILE * pFile = fopen(strWritePath.Get(), (bFull ? "wb" : "ab"));
+	m_bSucceeded = false;
+
+	if(pFile)
+	{
+		m_bSucceeded = (fwrite(bitStream.GetData(), 1, bitStream.GetNumberOfBytesUsed(), pFile) == bitStream.GetNumberOfBytesUsed());
+		m_bSucceeded = ((fclose(pFile) == 0) && m_bSucceeded);
+
+		if(bFull && m_bSucceeded)
+		{
+			remove(m_strPath.Get());
+			m_bSucceeded = (rename(strWritePath.Get(), m_strPath.Get()) == 0);
+		}
+	}
+
+	if(m_bSucceeded)
+	{
+		m_written.swap(m_capture);
+		m_strWrittenPath = m_strPath;
+		m_uiIncrements = (bFull ? 0 : (m_uiIncrements + 1));
+		m_uiRecordsWritten = uiRecords;
+	}
+	else
+	{
+		// We don't know what the file holds now so the next snapshot is a full one
+		m_written.clear();
+		m_strWrittenPath.Clear();
+		m_uiRecordsWritten = 0;
+	}
+
+	m_capture.clear();
+}
+
+void CWorldSnapshotManager::Process()
+{
+	if(!m_bWriting || !m_writeCounter.IsDone())
+		return;
+
+	m_bWriting = false;
+
+	if(!m_bSucceeded)
+		CLogFile::Printf("Failed to write the world snapshot %s", m_strPath.Get());
+
+	CSquirrelArguments arguments;
+	arguments.push(m_strFileName);
+	arguments.push(m_bSucceeded);
+	arguments.push((int)m_uiRecordsWritten);
+	g_pEvents->Call("worldSnapshotSave", &arguments);
+}
+
+int CWorldSnapshotManager::Load(String strFileName)
+{
+	SharedUtility::RemoveIllegalCharacters(strFileName);
+	String strPath(SharedUtility::GetAbsolutePath("files/%s", strFileName.Get()));
+	FILE * pFile = fopen(strPath.Get(), "rb");
+
+	if(!pFile)
+		return -1;
+
+	fseek(pFile, 0, SEEK_END);
+	long lSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	if(lSize <= 0)
+	{
+		fclose(pFile);
+		return -1;
+	}
+
+	std::vector<unsigned char> buffer((size_t)lSize);
+	bool bRead = (fread(&buffer[0], 1, buffer.size(), pFile) == buffer.size());
+	fclose(pFile);
+
+	if(!bRead)
+		return -1;
+
+	CBitStream bitStream(&buffer[0], (unsigned int)buffer.size(), false);
+	unsigned int uiMagic;
+	unsigned char ucVersion;
+
+	if(!bitStream.Read(uiMagic) || uiMagic != WORLD_SNAPSHOT_MAGIC || !bitStream.Read(ucVersion) || ucVersion != WORLD_SNAPSHOT_VERSION)
+	{
+		CLogFile::Printf("%s is not a world snapshot", strPath.Get());
+		return -1;
+	}
+
+	// Apply the chunks in order, a chunk is only applied if it is complete
+	WorldSnapshotRecords records;
+	unsigned char ucChunk;
+
+	while(bitStream.Read(ucChunk))
+	{
+		WorldSnapshotRecords set;
+		std::vector<unsigned int> removed;
+		unsigned int uiRecords;
+		bool bComplete = bitStream.Read(uiRecords);
+
+		for(unsigned int i = 0; bComplete && i < uiRecords; i++)
+		{
+			unsigned int uiKey;
+			unsigned char ucRecord;
+			unsigned int uiSize;
+
+			if(!bitStream.Read(uiKey) || !bitStream.Read(ucRecord))
+				bComplete = false;
+			else if(ucRecord == WORLD_SNAPSHOT_RECORD_REMOVE)
+				removed.push_back(uiKey);
+			else if(!bitStream.Read(uiSize) || BYTES_TO_BITS(uiSize) > bitStream.GetNumberOfUnreadBits())
+				bComplete = false;
+			else
+			{
+				std::vector<unsigned char>& data = set[uiKey];
+				data.resize(uiSize);
+
+				if(uiSize > 0)
+					bitStream.Read((char *)&data[0], uiSize);
+			}
+		}
+
+		if(!bComplete)
+			break;
+
+		if(ucChunk == WORLD_SNAPSHOT_CHUNK_FULL)
+			records.clear();
+
+		for(std::vector<unsigned int>::iterator iter = removed.begin(); iter != removed.end(); ++iter)
+			records.erase(*iter);
+
+		for(WorldSnapshotRecords::iterator iter = set.begin(); iter != set.end(); ++iter)
+			records[(*iter).first].swap((*iter).second);
+	}
+
+	// The entities get new ids so the next snapshot can't be an increment
+	m_strWrittenPath.Clear();
+	int iCreated = 0;
+
+	for(WorldSnapshotRecords::iterator iter = records.begin(); iter != records.end(); ++iter)
+	{
+		eWorldSnapshotEntity type = (eWorldSnapshotEntity)((*iter).first >> 16);
+
+		if((*iter).second.empty() || type >= WORLD_SNAPSHOT_ENTITY_MAX)
+			continue;
+
+		CBitStream recordStream(&(*iter).second[0], (unsigned int)(*iter).second.size(), false);
+
+		if(Restore(type, &recordStream))
+			iCreated++;
+	}
+
+	return iCreated;
+}
+
+bool CWorldSnapshotManager::Restore(eWorldSnapshotEntity type, CBitStream * pBitStream)
+{
+	CVector3 vecPosition;
+	CVector3 vecRotation;
+	unsigned char ucDimension;
+
+	switch(type)
+	{
+	case WORLD_SNAPSHOT_VEHICLE:
+		{
+			int iModelId;
+			BYTE byteColors[4];
+			int iRespawnDelay;
+
+			if(!pBitStream->Read(iModelId) || !pBitStream->Read(vecPosition) || !pBitStream->Read(vecRotation) ||
+				!pBitStream->Read((char *)byteColors, sizeof(byteColors)) || !pBitStream->Read(iRespawnDelay))
+				return false;
+
+			EntityId vehicleId = g_pVehicleManager->Add(iModelId, vecPosition, vecRotation, byteColors[0], byteColors[1], byteColors[2], byteColors[3], iRespawnDelay);
+			CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
+
+			if(!pVehicle)
+				return false;
+
+			unsigned int uiHealth;
+			float fPetrolTankHealth;
+			float fDirtLevel;
+			unsigned int uiLocked;
+			bool bSirenState;
+			bool bEngineStatus;
+			bool bLights;
+			bool bTaxiLights;
+			bool bGpsState;
+			unsigned char ucVariation;
+			bool bStates[19];
+
+			// The vehicle exists even if the rest of its state is missing
+			if(!pBitStream->Read(vecPosition) || !pBitStream->Read(vecRotation) || !pBitStream->Read((char *)byteColors, sizeof(byteColors)) ||
+				!pBitStream->Read(uiHealth) || !pBitStream->Read(fPetrolTankHealth) || !pBitStream->Read(fDirtLevel) ||
+				!pBitStream->Read(uiLocked) || !pBitStream->Read(bSirenState) || !pBitStream->Read(bEngineStatus) ||
+				!pBitStream->Read(bLights) || !pBitStream->Read(bTaxiLights) || !pBitStream->Read(bGpsState) ||
+				!pBitStream->Read(ucVariation))
+				return true;
+
+			for(unsigned int i = 0; i < 19; i++)
+			{
+				if(!pBitStream->Read(bStates[i]))
+					return true;
+			}
+
+			if(!pBitStream->Read(ucDimension))
+				return true;
+
+			pVehicle->SetPosition(vecPosition);
+			pVehicle->SetRotation(vecRotation);
+			pVehicle->SetColors(byteColors[0], byteColors[1], byteColors[2], byteColors[3]);
+			pVehicle->SetHealth(uiHealth);
+			pVehicle->SetPetrolTankHealth(fPetrolTankHealth);
+			pVehicle->SetDirtLevel(fDirtLevel);
+			pVehicle->SetLocked(uiLocked);
+			pVehicle->SetSirenState(bSirenState);
+			pVehicle->SetEngineStatus(bEngineStatus);
+			pVehicle->SetLights(bLights);
+			pVehicle->TurnTaxiLights(bTaxiLights);
+			pVehicle->SetVehicleGPSState(bGpsState);
+			pVehicle->SetVariation(ucVariation);
+
+			for(unsigned char i = 0; i < 9; i++)
+				pVehicle->SetComponentState(i, bStates[i]);
+
+			for(unsigned int i = 0; i < 4; i++)
+				pVehicle->SetWindowState(i, bStates[9 + i]);
+
+			for(unsigned int i = 0; i < 6; i++)
+				pVehicle->SetTyreState(i, bStates[13 + i]);
+
+			pVehicle->SetDimension(ucDimension);
+			return true;
+		}
+	case WORLD_SNAPSHOT_OBJECT:
+		{
+			DWORD dwModelHash;
+
+			if(!pBitStream->Read(dwModelHash) || !pBitStream->Read(vecPosition) || !pBitStream->Read(vecRotation) || !pBitStream->Read(ucDimension))
+				return false;
+
+			EntityId objectId = g_pObjectManager->Create(dwModelHash, vecPosition, vecRotation);
+
+			if(objectId == INVALID_ENTITY_ID)
+				return false;
+
+			g_pObjectManager->SetDimension(objectId, ucDimension);
+			return true;
+		}
+	case WORLD_SNAPSHOT_PICKUP:
+		{
+			DWORD dwModelHash;
+			unsigned char ucType;
+			unsigned int uiValue;
+
+			if(!pBitStream->Read(dwModelHash) || !pBitStream->Read(ucType) || !pBitStream->Read(uiValue) ||
+				!pBitStream->Read(vecPosition) || !pBitStream->Read(vecRotation))
+				return false;
+
+			return (g_pPickupManager->Create(dwModelHash, ucType, uiValue, vecPosition.fX, vecPosition.fY, vecPosition.fZ,
+				vecRotation.fX, vecRotation.fY, vecRotation.fZ) != INVALID_ENTITY_ID);
+		}
+	case WORLD_SNAPSHOT_BLIP:
+		{
+			int iSprite;
+			unsigned int uiColor;
+			float fSize;
+			bool bShortRange;
+			bool bRoute;
+			String strName;
+
+			if(!pBitStream->Read(iSprite) || !pBitStream->Read(vecPosition) || !pBitStream->Read(uiColor) || !pBitStream->Read(fSize) ||
+				!pBitStream->Read(bShortRange) || !pBitStream->Read(bRoute) || !pBitStream->Read(strName))
+				return false;
+
+			EntityId blipId = g_pBlipManager->Create(iSprite, vecPosition, true);
+
+			if(blipId == INVALID_ENTITY_ID)
+				return false;
+
+			g_pBlipManager->SetColor(blipId, uiColor);
+			g_pBlipManager->SetSize(blipId, fSize);
+			g_pBlipManager->ToggleShortRange(blipId, bShortRange);
+			g_pBlipManager->ToggleRoute(blipId, bRoute);
+			g_pBlipManager->SetName(blipId, strName);
+			return true;
+		}
+	case WORLD_SNAPSHOT_CHECKPOINT:
+		{
+			WORD wType;
+			CVector3 vecTargetPosition;
+			float fRadius;
+			bool bShown;
+
+			if(!pBitStream->Read(wType) || !pBitStream->Read(vecPosition) || !pBitStream->Read(vecTargetPosition) ||
+				!pBitStream->Read(fRadius) || !pBitStream->Read(bShown) || !pBitStream->Read(ucDimension))
+				return false;
+
+			CCheckpoint * pCheckpoint = g_pCheckpointManager->Get(g_pCheckpointManager->Add(wType, vecPosition, vecTargetPosition, fRadius));
+
+			if(!pCheckpoint)
+				return false;
+
+			if(!bShown)
+				pCheckpoint->HideForWorld();
+
+			pCheckpoint->SetDimension(ucDimension);
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,96 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CWorldSnapshotManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <vector>
+#include <CString.h>
+#include <Network/CBitStream.h>
+#include <Threading/CJobSystem.h>
+
+// "IVWS"
+#define WORLD_SNAPSHOT_MAGIC 0x53575649
+
+#define WORLD_SNAPSHOT_VERSION 1
+
+// Amount of incremental snapshots appended to a file before the next one is a full snapshot again
+#define WORLD_SNAPSHOT_MAX_INCREMENTS 32
+
+enum eWorldSnapshotEntity
+{
+	WORLD_SNAPSHOT_VEHICLE,
+	WORLD_SNAPSHOT_OBJECT,
+	WORLD_SNAPSHOT_PICKUP,
+	WORLD_SNAPSHOT_BLIP,
+	WORLD_SNAPSHOT_CHECKPOINT,
+	WORLD_SNAPSHOT_ENTITY_MAX
+};
+
+enum eWorldSnapshotChunk
+{
+	WORLD_SNAPSHOT_CHUNK_FULL,     // Replaces everything before it
+	WORLD_SNAPSHOT_CHUNK_INCREMENT // Only the entities that changed since the chunk before it
+};
+
+enum eWorldSnapshotRecord
+{
+	WORLD_SNAPSHOT_RECORD_SET,
+	WORLD_SNAPSHOT_RECORD_REMOVE
+};
+
+// The state of every entity by (type << 16 | id)
+typedef std::map<unsigned int, std::vector<unsigned char> > WorldSnapshotRecords;
+
+// Saves the vehicles, objects, pickups, blips and checkpoints to a file and
+// restores them from it. The entities are captured on the main thread into
+// compact records which are compared against the last written state and
+// written by a job, so the tick only pays for the capture. A file holds a full
+// snapshot followed by incremental snapshots with only the changed entities.
+class CWorldSnapshotManager
+{
+private:
+	// Owned by the write job while m_bWriting is set
+	WorldSnapshotRecords m_capture;
+	WorldSnapshotRecords m_written; // The state the file at m_strWrittenPath is at
+	String               m_strWrittenPath;
+	unsigned int         m_uiIncrements; // Amount of increments after the full snapshot in the file
+	String               m_strPath;
+	String               m_strFileName;
+	bool                 m_bIncremental;
+	bool                 m_bSucceeded;
+	unsigned int         m_uiRecordsWritten;
+
+	CJobCounter          m_writeCounter;
+	bool                 m_bWriting;
+
+	void                 Capture(WorldSnapshotRecords& records);
+	static void          WriteRecord(CBitStream * pBitStream, unsigned int uiKey, const std::vector<unsigned char> * pData);
+	static void          WriteJob(void * pUserData);
+	void                 Write();
+	bool                 Restore(eWorldSnapshotEntity type, CBitStream * pBitStream);
+
+public:
+	CWorldSnapshotManager();
+	~CWorldSnapshotManager();
+
+	// Captures the world and queues writing it to the file, an incremental snapshot
+	// is appended if the file was the last one written. Returns false if a snapshot
+	// is still being written
+	bool                 Save(String strFileName, bool bIncremental);
+	bool                 IsSaving() { return m_bWriting; }
+
+	// Creates the entities of the file (they get new ids), returns the amount
+	// of entities created or -1 if the file can't be read
+	int                  Load(String strFileName);
+
+	// Calls the worldSnapshotSave event once a snapshot is written
+	void                 Process();
+};
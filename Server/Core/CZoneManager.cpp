@@ -0,0 +1,357 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CZoneManager.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <math.h>
+#include <algorithm>
+#include <iterator>
+#include "CZoneManager.h"
+#include "CEvents.h"
+#include "CPlayerManager.h"
+#include <Math/CMath.h>
+#include <CMemoryTracker.h>
+
+extern CSpatialIndex * g_pSpatialIndex;
+extern CEvents * g_pEvents;
+extern CPlayerManager * g_pPlayerManager;
+
+CZoneManager::CZoneManager()
+{
+	CMemoryTracker::Allocated(MEMORY_TAG_ENTITIES, sizeof(CZoneManager));
+
+	for(EntityId x = 0; x < MAX_PLAYERS; x++)
+	{
+		m_players[x].bActive = false;
+		m_players[x].ucDimension = 0;
+	}
+
+	m_uiZoneCount = 0;
+	m_bTestAllPlayers = false;
+}
+
+CZoneManager::~CZoneManager()
+{
+	CMemoryTracker::Freed(MEMORY_TAG_ENTITIES, sizeof(CZoneManager));
+}
+
+SpatialIndexCell CZoneManager::GetCell(float fX, float fY)
+{
+	SpatialIndexCell cell;
+	cell.iX = (int)floor(fX / ZONE_MANAGER_CELL_SIZE);
+	cell.iY = (int)floor(fY / ZONE_MANAGER_CELL_SIZE);
+	return cell;
+}
+
+EntityId CZoneManager::Add(Zone& zone)
+{
+	EntityId zoneId = INVALID_ENTITY_ID;
+
+	for(EntityId x = 0; x < m_zones.size(); x++)
+	{
+		if(!m_zones[x].bActive)
+		{
+			zoneId = x;
+			break;
+		}
+	}
+
+	if(zoneId == INVALID_ENTITY_ID)
+	{
+		if(m_zones.size() >= MAX_ZONES)
+			return INVALID_ENTITY_ID;
+
+		zoneId = (EntityId)m_zones.size();
+		m_zones.push_back(Zone());
+	}
+
+	zone.bActive = true;
+	zone.ucDimension = ZONE_ALL_DIMENSIONS;
+
+	// Put the zone in every cell its bounds overlap
+	SpatialIndexCell minCell = GetCell(zone.vecMin.fX, zone.vecMin.fY);
+	SpatialIndexCell maxCell = GetCell(zone.vecMax.fX, zone.vecMax.fY);
+	zone.bLarge = (((double)(maxCell.iX - minCell.iX + 1) * (double)(maxCell.iY - minCell.iY + 1)) > ZONE_MANAGER_MAX_CELLS);
+
+	if(zone.bLarge)
+		m_largeZones.push_back(zoneId);
+	else
+	{
+		SpatialIndexCell cell;
+
+		for(cell.iX = minCell.iX; cell.iX <= maxCell.iX; cell.iX++)
+		{
+			for(cell.iY = minCell.iY; cell.iY <= maxCell.iY; cell.iY++)
+				m_cells[cell].push_back(zoneId);
+		}
+	}
+
+	m_zones[zoneId] = zone;
+	m_uiZoneCount++;
+
+	// Test all players against the new zone
+	m_bTestAllPlayers = true;
+
+	return zoneId;
+}
+
+EntityId CZoneManager::CreateCircle(float fX, float fY, float fRadius)
+{
+	Zone zone;
+	zone.type = ZONE_TYPE_CIRCLE;
+	zone.vecCenter = CVector3(fX, fY, 0.0f);
+	zone.fRadius = fabs(fRadius);
+	zone.vecMin = CVector3((fX - zone.fRadius), (fY - zone.fRadius), 0.0f);
+	zone.vecMax = CVector3((fX + zone.fRadius), (fY + zone.fRadius), 0.0f);
+	return Add(zone);
+}
+
+EntityId CZoneManager::CreateBox(const CVector3& vecMin, const CVector3& vecMax)
+{
+	Zone zone;
+	zone.type = ZONE_TYPE_BOX;
+	zone.fRadius = 0.0f;
+	zone.vecMin = CVector3(std::min(vecMin.fX, vecMax.fX), std::min(vecMin.fY, vecMax.fY), std::min(vecMin.fZ, vecMax.fZ));
+	zone.vecMax = CVector3(std::max(vecMin.fX, vecMax.fX), std::max(vecMin.fY, vecMax.fY), std::max(vecMin.fZ, vecMax.fZ));
+	return Add(zone);
+}
+
+EntityId CZoneManager::CreatePolygon(const std::vector<float>& polygonX, const std::vector<float>& polygonY)
+{
+	if(polygonX.size() < 3 || polygonX.size() != polygonY.size())
+		return INVALID_ENTITY_ID;
+
+	Zone zone;
+	zone.type = ZONE_TYPE_POLYGON;
+	zone.fRadius = 0.0f;
+	zone.polygonX = polygonX;
+	zone.polygonY = polygonY;
+	zone.vecMin = CVector3(*std::min_element(polygonX.begin(), polygonX.end()), *std::min_element(polygonY.begin(), polygonY.end()), 0.0f);
+	zone.vecMax = CVector3(*std::max_element(polygonX.begin(), polygonX.end()), *std::max_element(polygonY.begin(), polygonY.end()), 0.0f);
+	return Add(zone);
+}
+
+void CZoneManager::Delete(EntityId zoneId)
+{
+	if(!DoesExist(zoneId))
+		return;
+
+	Zone * pZone = &m_zones[zoneId];
+
+	if(pZone->bLarge)
+		m_largeZones.erase(std::find(m_largeZones.begin(), m_largeZones.end(), zoneId));
+	else
+	{
+		SpatialIndexCell minCell = GetCell(pZone->vecMin.fX, pZone->vecMin.fY);
+		SpatialIndexCell maxCell = GetCell(pZone->vecMax.fX, pZone->vecMax.fY);
+		SpatialIndexCell cell;
+
+		for(cell.iX = minCell.iX; cell.iX <= maxCell.iX; cell.iX++)
+		{
+			for(cell.iY = minCell.iY; cell.iY <= maxCell.iY; cell.iY++)
+			{
+				std::map<SpatialIndexCell, std::vector<EntityId> >::iterator iter = m_cells.find(cell);
+
+				if(iter == m_cells.end())
+					continue;
+
+				iter->second.erase(std::remove(iter->second.begin(), iter->second.end(), zoneId), iter->second.end());
+
+				// Don't keep empty cells around
+				if(iter->second.empty())
+					m_cells.erase(iter);
+			}
+		}
+	}
+
+	// Players in the zone don't get a leave event as the zone is gone (the
+	// players that left already forgot their zones)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		std::vector<EntityId>& zones = m_players[players[i]].zones;
+		std::vector<EntityId>::iterator iter = std::lower_bound(zones.begin(), zones.end(), zoneId);
+
+		if(iter != zones.end() && (*iter) == zoneId)
+			zones.erase(iter);
+	}
+
+	pZone->bActive = false;
+	pZone->polygonX.clear();
+	pZone->polygonY.clear();
+	m_uiZoneCount--;
+}
+
+bool CZoneManager::DoesExist(EntityId zoneId)
+{
+	return (zoneId < m_zones.size() && m_zones[zoneId].bActive);
+}
+
+void CZoneManager::SetDimension(EntityId zoneId, unsigned char ucDimension)
+{
+	if(!DoesExist(zoneId))
+		return;
+
+	m_zones[zoneId].ucDimension = ucDimension;
+
+	// Test all players against the zone again
+	m_bTestAllPlayers = true;
+}
+
+unsigned char CZoneManager::GetDimension(EntityId zoneId)
+{
+	if(!DoesExist(zoneId))
+		return 0;
+
+	return m_zones[zoneId].ucDimension;
+}
+
+bool CZoneManager::IsPointInZone(const Zone& zone, const CVector3& vecPosition, unsigned char ucDimension)
+{
+	if(zone.ucDimension != ZONE_ALL_DIMENSIONS && zone.ucDimension != ucDimension)
+		return false;
+
+	if(vecPosition.fX < zone.vecMin.fX || vecPosition.fX > zone.vecMax.fX || vecPosition.fY < zone.vecMin.fY || vecPosition.fY > zone.vecMax.fY)
+		return false;
+
+	switch(zone.type)
+	{
+	case ZONE_TYPE_CIRCLE:
+		return Math::IsPointInCircle(zone.vecCenter.fX, zone.vecCenter.fY, zone.fRadius, vecPosition.fX, vecPosition.fY);
+	case ZONE_TYPE_BOX:
+		return (vecPosition.fZ >= zone.vecMin.fZ && vecPosition.fZ <= zone.vecMax.fZ);
+	case ZONE_TYPE_POLYGON:
+		return Math::IsPointInPolygon((int)zone.polygonX.size(), (float *)&zone.polygonX[0], (float *)&zone.polygonY[0], vecPosition.fX, vecPosition.fY);
+	}
+
+	return false;
+}
+
+bool CZoneManager::IsPlayerInZone(EntityId playerId, EntityId zoneId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return false;
+
+	return std::binary_search(m_players[playerId].zones.begin(), m_players[playerId].zones.end(), zoneId);
+}
+
+const std::vector<EntityId> * CZoneManager::GetPlayerZones(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return NULL;
+
+	return &m_players[playerId].zones;
+}
+
+void CZoneManager::RemovePlayer(EntityId playerId)
+{
+	if(playerId >= MAX_PLAYERS)
+		return;
+
+	m_players[playerId].bActive = false;
+	m_players[playerId].zones.clear();
+}
+
+void CZoneManager::UpdatePlayer(EntityId playerId, const CVector3& vecPosition, unsigned char ucDimension)
+{
+	ZonePlayer * pPlayer = &m_players[playerId];
+	pPlayer->bActive = true;
+	pPlayer->vecPosition = vecPosition;
+	pPlayer->ucDimension = ucDimension;
+
+	// Test the zones of the cell the player is in and the large zones
+	std::vector<EntityId> zones;
+	std::map<SpatialIndexCell, std::vector<EntityId> >::iterator iter = m_cells.find(GetCell(vecPosition.fX, vecPosition.fY));
+
+	if(iter != m_cells.end())
+	{
+		for(std::vector<EntityId>::iterator zoneIter = iter->second.begin(); zoneIter != iter->second.end(); ++zoneIter)
+		{
+			if(IsPointInZone(m_zones[*zoneIter], vecPosition, ucDimension))
+				zones.push_back(*zoneIter);
+		}
+	}
+
+	for(std::vector<EntityId>::iterator zoneIter = m_largeZones.begin(); zoneIter != m_largeZones.end(); ++zoneIter)
+	{
+		if(IsPointInZone(m_zones[*zoneIter], vecPosition, ucDimension))
+			zones.push_back(*zoneIter);
+	}
+
+	std::sort(zones.begin(), zones.end());
+
+	if(zones == pPlayer->zones)
+		return;
+
+	std::vector<EntityId> leftZones;
+	std::vector<EntityId> enteredZones;
+	std::set_difference(pPlayer->zones.begin(), pPlayer->zones.end(), zones.begin(), zones.end(), std::back_inserter(leftZones));
+	std::set_difference(zones.begin(), zones.end(), pPlayer->zones.begin(), pPlayer->zones.end(), std::back_inserter(enteredZones));
+
+	// Store the zones first so the handlers see them, the handlers can delete
+	// zones and kick players so check both still exist before each call
+	pPlayer->zones = zones;
+
+	for(std::vector<EntityId>::iterator zoneIter = leftZones.begin(); zoneIter != leftZones.end() && pPlayer->bActive; ++zoneIter)
+	{
+		if(!DoesExist(*zoneIter))
+			continue;
+
+		CSquirrelArguments pArguments;
+		pArguments.push(playerId);
+		pArguments.push(*zoneIter);
+		g_pEvents->Call(EVENT_PLAYER_LEAVE_ZONE, &pArguments);
+	}
+
+	for(std::vector<EntityId>::iterator zoneIter = enteredZones.begin(); zoneIter != enteredZones.end() && pPlayer->bActive; ++zoneIter)
+	{
+		if(!IsPlayerInZone(playerId, *zoneIter))
+			continue;
+
+		CSquirrelArguments pArguments;
+		pArguments.push(playerId);
+		pArguments.push(*zoneIter);
+		g_pEvents->Call(EVENT_PLAYER_ENTER_ZONE, &pArguments);
+	}
+}
+
+void CZoneManager::Process()
+{
+	// Players are tested as soon as the first zone is created
+	if(m_uiZoneCount == 0)
+		return;
+
+	bool bTestAllPlayers = m_bTestAllPlayers;
+	m_bTestAllPlayers = false;
+
+	// Only players that moved (or changed dimension) since they were last tested are tested again
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t i = 0; i < players.size(); i++)
+	{
+		EntityId x = players[i];
+		CVector3 vecPosition;
+		unsigned char ucDimension;
+
+		if(!g_pSpatialIndex->GetPosition(SPATIAL_INDEX_PLAYER, x, vecPosition, ucDimension))
+		{
+			if(m_players[x].bActive)
+				RemovePlayer(x);
+
+			continue;
+		}
+
+		ZonePlayer * pPlayer = &m_players[x];
+
+		if(!bTestAllPlayers && pPlayer->bActive && pPlayer->ucDimension == ucDimension && pPlayer->vecPosition.fX == vecPosition.fX &&
+			pPlayer->vecPosition.fY == vecPosition.fY && pPlayer->vecPosition.fZ == vecPosition.fZ)
+			continue;
+
+		UpdatePlayer(x, vecPosition, ucDimension);
+	}
+}
@@ -0,0 +1,93 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CZoneManager.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Main.h"
+#include <map>
+#include <vector>
+#include <Common.h>
+#include "CSpatialIndex.h"
+
+#define MAX_ZONES 0xFFFE
+
+// Size of the cells of the zone grid
+#define ZONE_MANAGER_CELL_SIZE 100.0f
+
+// Zones covering more cells than this are not put in the grid but tested
+// against every player instead
+#define ZONE_MANAGER_MAX_CELLS 256
+
+// Dimension of zones that are in all dimensions
+#define ZONE_ALL_DIMENSIONS 0xFF
+
+enum eZoneType
+{
+	ZONE_TYPE_CIRCLE,
+	ZONE_TYPE_BOX,
+	ZONE_TYPE_POLYGON
+};
+
+struct Zone
+{
+	bool               bActive;
+	eZoneType          type;
+	unsigned char      ucDimension;
+	CVector3           vecMin;         // Bounds of the zone (z is ignored for circles and polygons)
+	CVector3           vecMax;
+	CVector3           vecCenter;      // Circles only
+	float              fRadius;
+	std::vector<float> polygonX;       // Polygons only
+	std::vector<float> polygonY;
+	bool               bLarge;         // If the zone is not in the grid
+};
+
+// Zones the player is in and the position they were tested at
+struct ZonePlayer
+{
+	bool                  bActive;
+	CVector3              vecPosition;
+	unsigned char         ucDimension;
+	std::vector<EntityId> zones;       // Sorted
+};
+
+// Tests the player positions of the spatial index against all zones every
+// tick the players moved and calls playerEnterZone and playerLeaveZone
+class CZoneManager
+{
+private:
+	std::vector<Zone>                                       m_zones;
+	std::map<SpatialIndexCell, std::vector<EntityId> >      m_cells;
+	std::vector<EntityId>                                   m_largeZones;
+	ZonePlayer                                              m_players[MAX_PLAYERS];
+	unsigned int                                            m_uiZoneCount;
+	bool                                                    m_bTestAllPlayers;
+
+	SpatialIndexCell GetCell(float fX, float fY);
+	EntityId         Add(Zone& zone);
+	bool             IsPointInZone(const Zone& zone, const CVector3& vecPosition, unsigned char ucDimension);
+	void             UpdatePlayer(EntityId playerId, const CVector3& vecPosition, unsigned char ucDimension);
+
+public:
+	CZoneManager();
+	~CZoneManager();
+
+	EntityId         CreateCircle(float fX, float fY, float fRadius);
+	EntityId         CreateBox(const CVector3& vecMin, const CVector3& vecMax);
+	EntityId         CreatePolygon(const std::vector<float>& polygonX, const std::vector<float>& polygonY);
+	void             Delete(EntityId zoneId);
+	bool             DoesExist(EntityId zoneId);
+	unsigned int     GetZoneCount() { return m_uiZoneCount; }
+	void             SetDimension(EntityId zoneId, unsigned char ucDimension);
+	unsigned char    GetDimension(EntityId zoneId);
+	bool             IsPlayerInZone(EntityId playerId, EntityId zoneId);
+	const std::vector<EntityId> * GetPlayerZones(EntityId playerId);
+	void             RemovePlayer(EntityId playerId);
+	void             Process();
+};
@@ -14,6 +14,7 @@
 #include "Main.h"
 #include <stdarg.h>
 #include <queue>
+#include <algorithm>
 #include "CNetworkManager.h"
 #include "CPlayerManager.h"
 #include "CVehicleManager.h"
@@ -24,13 +25,26 @@
 #include "CPickupManager.h"
 #include "Scripting/CScriptingManager.h"
 #include "CClientFileManager.h"
+#include "CClientFilePack.h"
 #include "Natives.h"
 #include "CModuleManager.h"
 #include "Scripting/CScriptTimerManager.h"
+#include "CScriptHotReloader.h"
+#include "Scripting/CScriptBytecodeCache.h"
+#include "Scripting/CScriptProfiler.h"
+#include "Scripting/CScriptWatchdog.h"
+#include "Scripting/CScriptAllocator.h"
+#include "CSQLiteWorker.h"
+#include "CSQLiteCache.h"
+#include "CHttpRequestPool.h"
+#include "CFileWorker.h"
 #include "CMasterList.h"
 #include "tinyxml/tinyxml.h"
 #include "tinyxml/ticpp.h"
 #include "SharedUtility.h"
+#include <CFrameArena.h>
+#include <CTraceRecorder.h>
+#include <CMemoryTracker.h>
 #include "CWebserver.h"
 #include <CSettings.h>
 #include <Game/CTime.h>
@@ -39,9 +53,33 @@
 #include <Network/CNetworkModule.h>
 #include <Threading/CMutex.h>
 #include <Threading/CThread.h>
+#include <Threading/CJobSystem.h>
 #include "CQuery.h"
+#include "CInterestManager.h"
+#include "CSpatialIndex.h"
+#include "CZoneManager.h"
+#include "CInstanceManager.h"
+#include "CTransferManager.h"
+#include "CMessageBus.h"
+#include "CAdminApi.h"
+#include "CChatManager.h"
+#include "CClientEventManager.h"
+#include "CLagCompensation.h"
+#include "CEntityDataManager.h"
+#include "CWorldSnapshotManager.h"
+#include "CBanManager.h"
+#include "CBroadcastGroupManager.h"
+#include "CSnapshotManager.h"
+#include "CCommandBuffer.h"
+#include "CJoinStreamer.h"
+#include "CEntityStreamer.h"
+#include "CTickScheduler.h"
+#include "CPacketRecorder.h"
+#include "CTickProfiler.h"
+#include "CServerMetrics.h"
 #include <CExceptionHandler.h>
 #include "ModuleNatives/ModuleNatives.h"
+#include "CCommandManager.h"
 
 #define HEIPHEN_GEN(string, stringname) \
 	{ \
@@ -62,6 +100,7 @@ CCheckpointManager * g_pCheckpointManager = NULL;
 CScriptingManager  * g_pScriptingManager = NULL;
 CClientFileManager * g_pClientScriptFileManager = NULL;
 CClientFileManager * g_pClientResourceFileManager = NULL;
+CClientFilePack    * g_pClientFilePack = NULL;
 CModuleManager     * g_pModuleManager = NULL;
 CMasterList        * g_pMasterList = NULL;
 CWebServer         * g_pWebserver = NULL;
@@ -72,9 +111,39 @@ unsigned long        g_ulStartTick = 0;
 CMutex               consoleInputQueueMutex;
 std::queue<String>   consoleInputQueue;
 CQuery             * g_pQuery = NULL;
+CInterestManager   * g_pInterestManager = NULL;
+CSpatialIndex      * g_pSpatialIndex = NULL;
+CZoneManager       * g_pZoneManager = NULL;
+CInstanceManager   * g_pInstanceManager = NULL;
+CTransferManager   * g_pTransferManager = NULL;
+CMessageBus        * g_pMessageBus = NULL;
+CAdminApi          * g_pAdminApi = NULL;
+CChatManager       * g_pChatManager = NULL;
+CClientEventManager * g_pClientEventManager = NULL;
+CLagCompensation   * g_pLagCompensation = NULL;
+CEntityDataManager * g_pEntityDataManager = NULL;
+CWorldSnapshotManager * g_pWorldSnapshotManager = NULL;
+CBanManager * g_pBanManager = NULL;
+CBroadcastGroupManager * g_pBroadcastGroupManager = NULL;
+CSnapshotManager   * g_pSnapshotManager = NULL;
+CCommandBuffer     * g_pCommandBuffer = NULL;
+CJoinStreamer      * g_pJoinStreamer = NULL;
+CEntityStreamer    * g_pEntityStreamer = NULL;
+CTickScheduler     * g_pTickScheduler = NULL;
+CPacketRecorder    * g_pPacketRecorder = NULL;
+CTickProfiler      * g_pTickProfiler = NULL;
+CCommandManager    * g_pCommandManager = NULL;
+CServerMetrics     * g_pServerMetrics = NULL;
+CJobSystem         * g_pJobSystem = NULL;
+CScriptHotReloader * g_pScriptHotReloader = NULL;
 
 extern CScriptTimerManager * g_pScriptTimerManager;
 
+// Read in every tick so it is only looked up once
+static CSettingHandle g_frequentEventsSetting("frequentevents");
+static CSettingHandle g_scriptGCBudgetSetting("scriptgcbudget");
+static CSettingHandle g_idleTimersSetting("idletimers");
+
 Modules::CActorModuleNatives * g_pActorModuleNatives;
 Modules::CBlipModuleNatives * g_pBlipModuleNatives;
 Modules::CCheckpointModuleNatives * g_pCheckpointModuleNatives;
@@ -87,6 +156,7 @@ Modules::CScriptModuleNatives * g_pScriptModuleNatives;
 Modules::CAreaModuleNatives * g_pAreaModuleNatives;
 Modules::CHashModuleNatives * g_pHashModuleNatives;
 Modules::CWorldModuleNatives * g_pWorldModuleNatives;
+Modules::CBulkModuleNatives * g_pBulkModuleNatives;
 
 void SendConsoleInput(String strInput)
 {
@@ -111,7 +181,7 @@ void SendConsoleInput(String strInput)
 				CBitStream bsSend;
 				bsSend.Write((DWORD)0xFFFFFFAA);
 				bsSend.Write(strParameters);
-				g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+				g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_CHAT);
 				CLogFile::Print(strParameters);
 			}
 		}
@@ -237,6 +307,18 @@ void SendConsoleInput(String strInput)
 					CLogFile::Printf("Failed to reload script %s (Script is not loaded).", strParameters.Get());
 			}
 		}
+		else if(strCommand == "hotreloadscript")
+		{
+			if(strParameters.IsNotEmpty())
+			{
+				if(!g_pScriptingManager->Get(strParameters))
+					CLogFile::Printf("Failed to hot reload script %s (Script is not loaded).", strParameters.Get());
+				else if(!g_pScriptHotReloader->Start(strParameters))
+					CLogFile::Printf("Failed to hot reload script %s (Script is already being reloaded).", strParameters.Get());
+				else
+					CLogFile::Printf("Hot reloading script %s.", strParameters.Get());
+			}
+		}
 		else if(strCommand == "reloadclientscript")
 		{
 			if(strParameters.IsNotEmpty())
@@ -278,18 +360,192 @@ void SendConsoleInput(String strInput)
 
 			for(CClientFileManager::iterator iter = g_pClientScriptFileManager->begin(); iter != g_pClientScriptFileManager->end(); ++ iter)
 			{
-				CLogFile::Printf("Client Script: %s (Checksum: 0x%p)", (*iter).first.Get(), (*iter).second.GetChecksum());
+				CLogFile::Printf("Client Script: %s (Checksum: 0x%p)", (*iter).first.Get(), (*iter).second.fileChecksum.GetChecksum());
 				iClientScriptsLoaded++;
 			}
 
 			for(CClientFileManager::iterator iter = g_pClientResourceFileManager->begin(); iter != g_pClientResourceFileManager->end(); ++ iter)
 			{
-				CLogFile::Printf("Resource: %s (Checksum: 0x%p)", (*iter).first.Get(), (*iter).second.GetChecksum());
+				CLogFile::Printf("Resource: %s (Checksum: 0x%p)", (*iter).first.Get(), (*iter).second.fileChecksum.GetChecksum());
 				iClientScriptsLoaded++;
 			}
 
 			CLogFile::Printf("%d script(s) and %d client script(s) loaded.", iScriptsLoaded, iClientScriptsLoaded);
 		}
+		else if(strCommand == "scriptprofile")
+		{
+			// Get the action and the dump file (if any)
+			size_t sPathSplit = strParameters.Find(' ', 0);
+			String strAction = strParameters.SubStr(0, sPathSplit++);
+			String strPath = strParameters.SubStr(sPathSplit, (strParameters.GetLength() - sPathSplit));
+
+			if(strAction == "start")
+			{
+				g_pScriptProfiler->Start();
+				CLogFile::Print("Script profiler started.");
+			}
+			else if(strAction == "stop")
+			{
+				g_pScriptProfiler->Stop();
+				CLogFile::Print("Script profiler stopped.");
+			}
+			else if(strAction == "reset")
+			{
+				g_pScriptProfiler->Reset();
+				CLogFile::Print("Script profiler reset.");
+			}
+			else if(strAction == "dump")
+			{
+				if(strPath.IsEmpty())
+					strPath = "scriptprofile.txt";
+
+				if(g_pScriptProfiler->Dump(SharedUtility::GetAbsolutePath(strPath.Get())))
+					CLogFile::Printf("Script profile written to %s.", strPath.Get());
+				else
+					CLogFile::Printf("Failed to write script profile to %s.", strPath.Get());
+			}
+			else if(strAction.IsEmpty() || strAction == "print")
+				g_pScriptProfiler->Print();
+			else
+				CLogFile::Print("Usage: scriptprofile [start|stop|reset|print|dump [file]]");
+		}
+		else if(strCommand == "trace")
+		{
+			// Get the action and the dump file (if any)
+			size_t sPathSplit = strParameters.Find(' ', 0);
+			String strAction = strParameters.SubStr(0, sPathSplit++);
+			String strPath = strParameters.SubStr(sPathSplit, (strParameters.GetLength() - sPathSplit));
+
+			if(strAction == "start")
+			{
+				// Every start records a new trace
+				CTraceRecorder::SetEnabled(false);
+				CTraceRecorder::Reset();
+				CTraceRecorder::SetEnabled(true);
+				CLogFile::Print("Trace recorder started.");
+			}
+			else if(strAction == "stop")
+			{
+				CTraceRecorder::SetEnabled(false);
+				CLogFile::Printf("Trace recorder stopped with %d event(s).", CTraceRecorder::GetEventCount());
+			}
+			else if(strAction == "dump")
+			{
+				if(strPath.IsEmpty())
+					strPath = "trace.json";
+
+				// The trace is written from this thread, what the others record meanwhile is kept out
+				bool bEnabled = CTraceRecorder::IsEnabled();
+				CTraceRecorder::SetEnabled(false);
+
+				if(CTraceRecorder::Dump(SharedUtility::GetAbsolutePath(strPath.Get())))
+					CLogFile::Printf("Trace written to %s.", strPath.Get());
+				else
+					CLogFile::Printf("Failed to write trace to %s.", strPath.Get());
+
+				CTraceRecorder::SetEnabled(bEnabled);
+			}
+			else
+				CLogFile::Print("Usage: trace [start|stop|dump [file]]");
+		}
+		else if(strCommand == "memory")
+			CMemoryTracker::Print(CNetworkModule::GetMemoryCounter());
+		else if(strCommand == "record")
+		{
+			// Get the action and the recording file (if any)
+			size_t sPathSplit = strParameters.Find(' ', 0);
+			String strAction = strParameters.SubStr(0, sPathSplit++);
+			String strPath = strParameters.SubStr(sPathSplit, (strParameters.GetLength() - sPathSplit));
+
+			if(strAction == "start")
+			{
+				if(strPath.IsEmpty())
+					strPath = "packets.rec";
+
+				if(g_pPacketRecorder->StartRecording(SharedUtility::GetAbsolutePath(strPath.Get())))
+					CLogFile::Printf("Recording packets to %s.", strPath.Get());
+				else
+					CLogFile::Printf("Failed to open %s for recording.", strPath.Get());
+			}
+			else if(strAction == "stop")
+				g_pPacketRecorder->StopRecording();
+			else
+				CLogFile::Print("Usage: record [start [file]|stop]");
+		}
+		else if(strCommand == "replay")
+		{
+			// Get the action, the recording file and the speed (if any)
+			size_t sPathSplit = strParameters.Find(' ', 0);
+			String strAction = strParameters.SubStr(0, sPathSplit++);
+			String strPath = strParameters.SubStr(sPathSplit, (strParameters.GetLength() - sPathSplit));
+			size_t sSpeedSplit = strPath.Find(' ', 0);
+			String strFile = strPath.SubStr(0, sSpeedSplit++);
+			String strSpeed = strPath.SubStr(sSpeedSplit, (strPath.GetLength() - sSpeedSplit));
+
+			if(strAction == "start" && strFile.IsNotEmpty())
+			{
+				// A speed of 0 replays as fast as possible
+				float fSpeed = (strSpeed.IsNotEmpty() ? (float)atof(strSpeed.Get()) : 1.0f);
+
+				if(g_pPacketRecorder->StartReplay(SharedUtility::GetAbsolutePath(strFile.Get()), fSpeed))
+					CLogFile::Printf("Replaying %s at %.2fx speed.", strFile.Get(), fSpeed);
+				else
+					CLogFile::Printf("Failed to replay %s.", strFile.Get());
+			}
+			else if(strAction == "stop")
+				g_pPacketRecorder->StopReplay();
+			else
+				CLogFile::Print("Usage: replay [start <file> [speed]|stop]");
+		}
+		else if(strCommand == "netsim")
+		{
+			CNetServerInterface * pNetServer = g_pNetworkManager->GetNetServer();
+			NetSimulatorSettings settings;
+
+			if(strParameters == "off")
+			{
+				pNetServer->SetNetSimulator(settings);
+				CLogFile::Print("Network simulator disabled.");
+			}
+			else if(strParameters.IsNotEmpty())
+			{
+				sscanf(strParameters.Get(), "%u %u %f %f %f %u", &settings.uiLatency, &settings.uiJitter, &settings.fLoss, &settings.fReorder, &settings.fDuplicate, &settings.uiBandwidth);
+				pNetServer->SetNetSimulator(settings);
+				CLogFile::Printf("Network simulator set (Latency: %ums, Jitter: %ums, Loss: %.1f%%, Reorder: %.1f%%, Duplicate: %.1f%%, Bandwidth: %u bytes/s).", settings.uiLatency, settings.uiJitter, settings.fLoss, settings.fReorder, settings.fDuplicate, settings.uiBandwidth);
+			}
+			else
+			{
+				NetSimulatorStats stats;
+				pNetServer->GetNetSimulatorStats(&stats);
+				CLogFile::Printf("Network simulator: %lu datagrams (%lu bytes), %lu lost, %lu overflowed, %lu reordered, %lu duplicated, %u queued.", stats.ulDatagrams, stats.ulBytes, stats.ulLost, stats.ulOverflowed, stats.ulReordered, stats.ulDuplicated, stats.uiQueued);
+				CLogFile::Print("Usage: netsim [off|<latency> [jitter] [loss] [reorder] [duplicate] [bandwidth]]");
+			}
+		}
+		else if(strCommand == "publishfiles")
+		{
+			if(!g_pWebserver->HasHashedFiles())
+				CLogFile::Print("The client files are only published with hashedfiles and an httpserver.");
+			else
+			{
+				// Publish the client files again, for example to a hashed files folder that was emptied after an upload
+				unsigned int uiPublished = 0;
+				CClientFileManager * pManagers[] = { g_pClientScriptFileManager, g_pClientResourceFileManager };
+
+				for(int i = 0; i < 2; i++)
+				{
+					for(CClientFileManager::iterator iter = pManagers[i]->begin(); iter != pManagers[i]->end(); iter++)
+					{
+						CFileChecksum fileChecksum;
+						unsigned int uiSize;
+
+						if(g_pWebserver->FileCopy(iter->first, (i == 0), fileChecksum, uiSize))
+							uiPublished++;
+					}
+				}
+
+				CLogFile::Printf("Published %d client file(s) to %s.", uiPublished, CVAR_GET_STRING("hashedfilesfolder").Get());
+			}
+		}
 		else if(strCommand == "uptime")
 		{
 			CLogFile::Printf("Server has been online for %s.", SharedUtility::GetTimePassedFromTime(g_ulStartTick).Get());
@@ -316,9 +572,13 @@ void InputThread(CThread * pCreator)
 	// Loop until server shutdown
 	while(pCreator->GetUserData<bool>())
 	{
-		// Wait for input from the console
-		// TODO: Make non-blocking
-		fgets(szInputBuffer, sizeof(szInputBuffer), stdin);
+		// Wait for input from the console (fgets blocks until there is some)
+		if(!fgets(szInputBuffer, sizeof(szInputBuffer), stdin))
+		{
+			// There is no console input (anymore), don't spin on it
+			Sleep(100);
+			continue;
+		}
 
 		// Do we have anything in the input?
 		if(szInputBuffer[0] != '\n')
@@ -353,9 +613,6 @@ void InputThread(CThread * pCreator)
 				strInputString.Clear();
 			}
 		}
-
-		// Wait
-		Sleep(10);
 	}
 }
 
@@ -392,6 +649,12 @@ int main(int argc, char ** argv)
 	// Parse the command line
 	CSettings::ParseCommandLine(argc, argv);
 
+	// Set up the log file rotation and writer thread
+	CLogFile::SetMaxFileSize((unsigned int)CVAR_GET_INTEGER("logmaxsize") * 1024 * 1024);
+
+	if(CVAR_GET_BOOL("logasync"))
+		CLogFile::StartWriter(CVAR_GET_INTEGER("logflushinterval"));
+
 	char heiphens[128];
 
 	HEIPHEN_GEN(" " VERSION_IDENTIFIER " " OS_STRING " Server", heiphens);
@@ -441,9 +704,17 @@ int main(int argc, char ** argv)
 	//----------------------------------------------------------
 
 	g_pEvents = new CEvents();
+	g_pCommandManager = new CCommandManager();
 	g_pScriptingManager = new CScriptingManager();
+	g_pScriptingManager->SetGCInterval(CVAR_GET_INTEGER("scriptgcinterval"));
+
+	// Cache compiled scripts so unchanged scripts don't have to be compiled again
+	if(CVAR_GET_BOOL("scriptcache"))
+		CScriptBytecodeCache::SetDirectory(SharedUtility::GetAbsolutePath("scripts/cache"));
+
 	g_pClientScriptFileManager = new CClientFileManager(true);
 	g_pClientResourceFileManager = new CClientFileManager(false);
+	g_pClientFilePack = new CClientFilePack();
 
 	// Initialize the network module, if it fails, exit
 	if(!CNetworkModule::Init())
@@ -453,6 +724,11 @@ int main(int argc, char ** argv)
 		return 1;
 	}
 
+	// The job system writes the ban list and the network thread checks the bans so both are there before it
+	g_pJobSystem = new CJobSystem(CVAR_GET_INTEGER("jobthreads"));
+	g_pBanManager = new CBanManager("bans.banlist");
+	g_pBanManager->Load();
+
 	g_pNetworkManager = new CNetworkManager();
 
 	// Startup the network manager, if it fails exit
@@ -463,6 +739,22 @@ int main(int argc, char ** argv)
 		return 1;
 	}
 
+	g_pSpatialIndex = new CSpatialIndex();
+	g_pZoneManager = new CZoneManager();
+	g_pInstanceManager = new CInstanceManager();
+	g_pTransferManager = new CTransferManager();
+	g_pMessageBus = new CMessageBus();
+	g_pMessageBus->Startup();
+	g_pChatManager = new CChatManager();
+	g_pClientEventManager = new CClientEventManager();
+	g_pLagCompensation = new CLagCompensation();
+	g_pEntityDataManager = new CEntityDataManager();
+	g_pInterestManager = new CInterestManager();
+	g_pBroadcastGroupManager = new CBroadcastGroupManager();
+	g_pSnapshotManager = new CSnapshotManager();
+	g_pCommandBuffer = new CCommandBuffer();
+	g_pJoinStreamer = new CJoinStreamer();
+	g_pEntityStreamer = new CEntityStreamer();
 	g_pPlayerManager = new CPlayerManager();
 	g_pVehicleManager = new CVehicleManager();
 	g_pObjectManager = new CObjectManager();
@@ -472,9 +764,26 @@ int main(int argc, char ** argv)
 	g_pCheckpointManager = new CCheckpointManager();
 	g_pModuleManager = new CModuleManager();
 	g_pScriptTimerManager = new CScriptTimerManager();
+	g_pScriptHotReloader = new CScriptHotReloader();
+	g_pScriptProfiler = new CScriptProfiler();
+
+	// Only create the script watchdog if it has a budget to enforce
+	if(CVAR_GET_INTEGER("scriptcallbudget") > 0 || CVAR_GET_INTEGER("scripttickbudget") > 0)
+		g_pScriptWatchdog = new CScriptWatchdog(CVAR_GET_INTEGER("scriptcallbudget"), CVAR_GET_INTEGER("scripttickbudget"), CVAR_GET_BOOL("scriptdeferevents"));
+
+	CScriptAllocator::SetMemoryLimit((size_t)CVAR_GET_INTEGER("scriptmemorylimit") * 1024);
+	g_pSQLiteWorker = new CSQLiteWorker();
+	g_pWorldSnapshotManager = new CWorldSnapshotManager();
+	g_pHttpRequestPool = new CHttpRequestPool(CVAR_GET_INTEGER("httprequests"), CVAR_GET_INTEGER("httprequestsperhost"));
+	g_pFileWorker = new CFileWorker(g_pJobSystem);
+	g_pAdminApi = new CAdminApi();
 	g_pWebserver = new CWebServer(CVAR_GET_INTEGER("httpport"));
 	g_pTime = new CTime();
 	g_pTrafficLights = new CTrafficLights();
+	g_pTickScheduler = new CTickScheduler();
+	g_pPacketRecorder = new CPacketRecorder();
+	g_pTickProfiler = new CTickProfiler();
+	g_pServerMetrics = new CServerMetrics();
 
 	g_pPickupModuleNatives = new Modules::CPickupModuleNatives;
 	g_pActorModuleNatives = new Modules::CActorModuleNatives;
@@ -488,6 +797,7 @@ int main(int argc, char ** argv)
 	g_pAreaModuleNatives = new Modules::CAreaModuleNatives;
 	g_pHashModuleNatives = new Modules::CHashModuleNatives;
 	g_pWorldModuleNatives = new Modules::CWorldModuleNatives;
+	g_pBulkModuleNatives = new Modules::CBulkModuleNatives;
 
 	std::list<String> modules = CVAR_GET_LIST("module");
 	if(modules.size() > 0)
@@ -545,8 +855,37 @@ int main(int argc, char ** argv)
 	// Register the area natives
 	CAreaNatives::Register(g_pScriptingManager);
 
+	// Register the spatial natives
+	CSpatialNatives::Register(g_pScriptingManager);
+
+	// Register the zone natives
+	CZoneNatives::Register(g_pScriptingManager);
+
+	// Register the instance natives
+	CInstanceNatives::Register(g_pScriptingManager);
+	CMessageBusNatives::Register(g_pScriptingManager);
+
+	// Register the chat natives
+	CChatNatives::Register(g_pScriptingManager);
+
+	// Register the entity data natives
+	CEntityDataNatives::Register(g_pScriptingManager);
+
+	// Register the world snapshot natives
+	CWorldSnapshotNatives::Register(g_pScriptingManager);
+
+	// Register the leaderboard natives
+	RegisterLeaderboardNatives(g_pScriptingManager);
+
+	// Register the client event natives
+	CClientEventNatives::Register(g_pScriptingManager);
+
 	// Register the hash natives
 	CHashNatives::Register(g_pScriptingManager);
+	CSerializationNatives::Register(g_pScriptingManager);
+
+	// Register the shared data natives
+	CSharedDataNatives::Register(g_pScriptingManager);
 
 	// Register the event natives
 	CEventNatives::Register(g_pScriptingManager);
@@ -554,15 +893,27 @@ int main(int argc, char ** argv)
 	// Register the script natives
 	RegisterScriptNatives(g_pScriptingManager);
 
+	// Register the command natives
+	CCommandNatives::Register(g_pScriptingManager);
+
 	// Register the SQLite natives
 	RegisterSQLiteNatives(g_pScriptingManager);
 
+	// Register the http natives
+	CHttpNatives::Register(g_pScriptingManager);
+
+	// Register the file natives
+	CFileNatives::Register(g_pScriptingManager);
+
 	// Register the XML natives
 	RegisterXMLNatives(g_pScriptingManager);
 
 	// Register the timer natives
 	RegisterTimerNatives(g_pScriptingManager);
 
+	// Register the coroutine natives
+	CCoroutineNatives::Register(g_pScriptingManager);
+
 	// Register the default constants
 	g_pScriptingManager->RegisterDefaultConstants();
 
@@ -579,20 +930,30 @@ int main(int argc, char ** argv)
 	int iResourcesLoaded = 0;
 	int iFailedResources = 0;
 
+	// The scripts are compiled on the job system and executed here in the order they are listed
 	std::list<String> scripts = CVAR_GET_LIST("script");
+	std::vector<String> scriptNames(scripts.begin(), scripts.end());
+	std::vector<String> scriptPaths;
+
 	for(std::list<String>::iterator iter = scripts.begin(); iter != scripts.end(); iter++)
-	{
-		String strPath(SharedUtility::GetAbsolutePath("scripts/%s", (*iter).Get()));
+		scriptPaths.push_back(SharedUtility::GetAbsolutePath("scripts/%s", (*iter).Get()));
+
+	std::vector<CSquirrel *> loadedScripts = g_pScriptingManager->Load(scriptNames, scriptPaths, g_pJobSystem);
 
-		if(!g_pScriptingManager->Load(*iter, strPath))
+	for(size_t i = 0; i < loadedScripts.size(); i++)
+	{
+		if(!loadedScripts[i])
 		{
-			CLogFile::Printf("Warning: Failed to load script %s.", (*iter).Get());
+			CLogFile::Printf("Warning: Failed to load script %s.", scriptNames[i].Get());
 			iFailedResources++;
 		}
 		else
 			iResourcesLoaded++;
 	}
 
+	// The scripts of the instances only get the player events of their own players
+	g_pInstanceManager->Load(iResourcesLoaded, iFailedResources);
+
 	std::list<String> clientscripts = CVAR_GET_LIST("clientscript");
 	for(std::list<String>::iterator iter = clientscripts.begin(); iter != clientscripts.end(); iter++)
 	{
@@ -605,6 +966,19 @@ int main(int argc, char ** argv)
 			iResourcesLoaded++;
 	}
 
+	// Lazy client scripts are only loaded by the clients once another client script requires them
+	std::list<String> lazyclientscripts = CVAR_GET_LIST("lazyclientscript");
+	for(std::list<String>::iterator iter = lazyclientscripts.begin(); iter != lazyclientscripts.end(); iter++)
+	{
+		if(!g_pClientScriptFileManager->Start(*iter, true))
+		{
+			CLogFile::Printf("Warning: Failed to load client script %s.", (*iter).Get());
+			iFailedResources++;
+		}
+		else
+			iResourcesLoaded++;
+	}
+
 	std::list<String> clientresources = CVAR_GET_LIST("clientresource");
 	for(std::list<String>::iterator iter = clientresources.begin(); iter != clientresources.end(); iter++)
 	{	
@@ -617,6 +991,14 @@ int main(int argc, char ** argv)
 			iResourcesLoaded++;
 	}
 
+	// Pack the client files so joining clients download a single file (the
+	// files have to be uploaded one by one if an external web server is used)
+	if(CVAR_GET_BOOL("clientfilepack") && CVAR_GET_STRING("httpserver").IsEmpty())
+		g_pClientFilePack->Build(g_pClientScriptFileManager, g_pClientResourceFileManager);
+
+	// Keep the checksums of the client files for the next start
+	g_pWebserver->SaveChecksumCache();
+
 	#ifdef WIN32
 		SetConsoleTextAttribute((HANDLE)GetStdHandle(STD_OUTPUT_HANDLE), FOREGROUND_RED | FOREGROUND_INTENSITY);
 		CLogFile::Printf("Successfully loaded %d resources (%d failed).", iResourcesLoaded, iFailedResources);
@@ -685,53 +1067,227 @@ int main(int argc, char ** argv)
 
 	while(g_pNetworkManager->bRunning)
 	{
-		g_pNetworkManager->Process();
+		// Read the clock once for everything processed this time around
+		SharedUtility::UpdateFrameTime();
 
+		// Handle all received packets as soon as they arrive
+		g_pTickProfiler->StartStage(TICK_STAGE_PACKETS);
+		g_pNetworkManager->ProcessPackets();
+		g_pTickProfiler->StopStage();
 
-		g_pVehicleManager->Process();
+		// Tick at the idle rate while the server is empty, a connecting player
+		// switches it back to the full rate from the next tick on
+		if(g_pTickScheduler->SetIdle(g_pPlayerManager->GetPlayerCount() == 0))
+		{
+			if(g_pTickScheduler->IsIdle())
+			{
+				if(!g_idleTimersSetting.GetBool())
+					g_pScriptTimerManager->Pause();
+			}
+			else if(g_pScriptTimerManager->IsPaused())
+				g_pScriptTimerManager->Resume();
+		}
 
+		// Process everything else at the fixed tick rate
+		if(g_pTickScheduler->IsTickDue())
+		{
+			g_pTickScheduler->BeginTick();
+			g_pTickProfiler->BeginTick();
 
-		if(g_pQuery)
-			g_pQuery->Process();
+			// Resume the script coroutines whose wait ended in the last tick first
+			g_pTickProfiler->StartStage(TICK_STAGE_SCRIPT_COROUTINES);
+			g_pScriptingManager->ProcessCoroutines();
 
-		if(g_pMasterList)
-			g_pMasterList->Pulse();
+			// Handle the replayed packets that are due
+			g_pTickProfiler->StartStage(TICK_STAGE_PACKET_RECORDER);
+			g_pPacketRecorder->Process();
 
-		g_pScriptTimerManager->Pulse();
-		g_pModuleManager->Pulse();
+			// Process the player manager
+			g_pTickProfiler->StartStage(TICK_STAGE_NETWORK);
+			g_pNetworkManager->Process();
 
-		if(CVAR_GET_BOOL("frequentevents"))
-			g_pEvents->Call("serverPulse");
+			// Call the coalesced events the players sent since the last tick
+			g_pTickProfiler->StartStage(TICK_STAGE_CLIENT_EVENTS);
+			g_pClientEventManager->Process();
 
-		// Try and lock the console input queue mutex
-		if(consoleInputQueueMutex.TryLock(0))
-		{
-			// Process the console input queue
-			while(!consoleInputQueue.empty())
+			// Send everything that was synced this tick
+			g_pTickProfiler->StartStage(TICK_STAGE_SNAPSHOTS);
+			g_pSnapshotManager->Process();
+
+			// Stream the world state to joining players
+			g_pTickProfiler->StartStage(TICK_STAGE_JOIN_STREAMER);
+			g_pJoinStreamer->Process();
+
+			// Stream vehicles, objects and pickups in and out for all players
+			g_pTickProfiler->StartStage(TICK_STAGE_ENTITY_STREAMER);
+			g_pEntityStreamer->Process();
+
+			// Stream the short range blips in and out for all players
+			g_pBlipManager->Process();
+
+			// Test the players that moved against the zones and checkpoints
+			g_pTickProfiler->StartStage(TICK_STAGE_ZONES);
+			g_pZoneManager->Process();
+			g_pCheckpointManager->Process();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_VEHICLES);
+			g_pVehicleManager->Process();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_OBJECTS);
+			g_pObjectManager->Process();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_ACTORS);
+			g_pActorManager->Process();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_QUERY);
+
+			if(g_pQuery)
+				g_pQuery->Process();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_MASTER_LIST);
+
+			if(g_pMasterList)
+				g_pMasterList->Pulse();
+
+			// Start the script budgets for this tick and call the deferred events
+			g_pTickProfiler->StartStage(TICK_STAGE_SCRIPT_WATCHDOG);
+
+			if(g_pScriptWatchdog)
+				g_pScriptWatchdog->Process();
+
+			// Call the callbacks of the database queries that finished
+			g_pTickProfiler->StartStage(TICK_STAGE_SQLITE_WORKER);
+			g_pSQLiteWorker->Process();
+
+			// Hand the changed records of the database caches to their writers
+			CSQLiteCache::ProcessAll();
+
+			// Save the settings that were changed a while ago
+			CSettings::Process();
+
+			// Call the callbacks of the file reads, writes and hashes that finished
+			g_pTickProfiler->StartStage(TICK_STAGE_FILE_WORKER);
+			g_pFileWorker->Process();
+
+			// Call the events of the world snapshots that were written
+			g_pTickProfiler->StartStage(TICK_STAGE_WORLD_SNAPSHOT);
+			g_pWorldSnapshotManager->Process();
+
+			// Remove the expired bans and write the ban list
+			g_pTickProfiler->StartStage(TICK_STAGE_BANS);
+			g_pBanManager->Process();
+
+			// Send the clock and the traffic lights if they were changed
+			g_pTickProfiler->StartStage(TICK_STAGE_WORLD);
+			g_pTime->Process();
+			g_pTrafficLights->Process();
+
+			// Call the callbacks of the http requests that finished and run the others
+			g_pTickProfiler->StartStage(TICK_STAGE_HTTP_REQUESTS);
+			g_pHttpRequestPool->Process();
+
+			// Let the scripts answer the requests to the webserver
+			g_pTickProfiler->StartStage(TICK_STAGE_WEB_REQUESTS);
+			g_pWebserver->Process();
+
+			// Call the handlers of the messages the other servers published
+			g_pTickProfiler->StartStage(TICK_STAGE_MESSAGE_BUS);
+			g_pMessageBus->Process();
+
+			// Switch to the new versions of the hot reloaded scripts that compiled
+			g_pTickProfiler->StartStage(TICK_STAGE_SCRIPT_RELOADS);
+			g_pScriptHotReloader->Process();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_SCRIPT_TIMERS);
+			g_pScriptTimerManager->Pulse();
+			g_pTickProfiler->StartStage(TICK_STAGE_MODULES);
+			g_pModuleManager->Pulse();
+			g_pTickProfiler->StartStage(TICK_STAGE_SERVER_PULSE);
+
+			if(g_frequentEventsSetting.GetBool())
+				g_pEvents->Call(EVENT_SERVER_PULSE);
+
+			// Call the throttled handlers whose interval has passed
+			if(g_pEvents->HasThrottledHandlers(EVENT_SERVER_PULSE))
 			{
-				SendConsoleInput(consoleInputQueue.back().GetData());
-				consoleInputQueue.pop();
+				CSquirrelArguments pArguments;
+				g_pEvents->Sample(EVENT_SERVER_PULSE, &pArguments);
 			}
 
-			// Unlock the console input queue mutex
-			consoleInputQueueMutex.Unlock();
+			g_pEvents->ProcessSamples();
+
+			g_pTickProfiler->StartStage(TICK_STAGE_CONSOLE);
+
+			// Try and lock the console input queue mutex
+			if(consoleInputQueueMutex.TryLock(0))
+			{
+				// Process the console input queue
+				while(!consoleInputQueue.empty())
+				{
+					SendConsoleInput(consoleInputQueue.front().GetData());
+					consoleInputQueue.pop();
+				}
+
+				// Unlock the console input queue mutex
+				consoleInputQueueMutex.Unlock();
+			}
+
+			// Send the entity data that changed this tick
+			g_pTickProfiler->StartStage(TICK_STAGE_ENTITY_DATA);
+			g_pEntityDataManager->Process();
+
+			// Send the scripting commands of this tick
+			g_pTickProfiler->StartStage(TICK_STAGE_COMMANDS);
+			g_pCommandBuffer->Process();
+
+			g_pTickProfiler->EndTick();
+			g_pTickScheduler->EndTick();
+			g_pServerMetrics->Process();
+
+			// Collect the script cycles in the time left before the next tick
+			g_pTickProfiler->StartStage(TICK_STAGE_SCRIPT_GC);
+			g_pScriptingManager->CollectGarbage(std::min((unsigned int)g_scriptGCBudgetSetting.GetInteger(), g_pTickScheduler->GetTimeUntilNextTick()));
+			g_pTickProfiler->StopStage();
 		}
 
-		Sleep(5);
+		// Drop the memory this iteration used for its temporaries
+		CFrameArena::Reset();
+
+		// Wait for the next tick or until packets arrive
+		g_pTickScheduler->Wait();
 	}
 
 	// Stop the input thread
 	inputThread.SetUserData<bool>(true);
 	inputThread.Stop(false, true);
 
+	// Release the command handlers while their scripts still exist
+	SAFE_DELETE(g_pCommandManager);
+
+	// Wait for the reloads that are still compiling and drop them
+	SAFE_DELETE(g_pScriptHotReloader);
+
 	// Unload all loaded scripts
 	g_pScriptingManager->UnloadAll();
 
 	CLogFile::Print(" ===== IV:MP Server shutting down. ===== ");
 
+	// Stop the webserver first as its requests use the other objects
+	SAFE_DELETE(g_pWebserver);
+	SAFE_DELETE(g_pAdminApi);
+	SAFE_DELETE(g_pServerMetrics);
+	SAFE_DELETE(g_pTickProfiler);
+	SAFE_DELETE(g_pPacketRecorder);
+	SAFE_DELETE(g_pTickScheduler);
 	SAFE_DELETE(g_pMasterList);
 	SAFE_DELETE(g_pQuery);
 	SAFE_DELETE(g_pScriptTimerManager);
+	SAFE_DELETE(g_pScriptProfiler);
+	SAFE_DELETE(g_pScriptWatchdog);
+	SAFE_DELETE(g_pSQLiteWorker);
+	SAFE_DELETE(g_pWorldSnapshotManager);
+	SAFE_DELETE(g_pHttpRequestPool);
+	SAFE_DELETE(g_pFileWorker);
 	SAFE_DELETE(g_pModuleManager);
 	SAFE_DELETE(g_pCheckpointManager);
 	SAFE_DELETE(g_pPickupManager);
@@ -740,12 +1296,29 @@ int main(int argc, char ** argv)
 	SAFE_DELETE(g_pActorManager);
 	SAFE_DELETE(g_pVehicleManager);
 	SAFE_DELETE(g_pPlayerManager);
+	SAFE_DELETE(g_pEntityStreamer);
+	SAFE_DELETE(g_pJoinStreamer);
+	SAFE_DELETE(g_pCommandBuffer);
+	SAFE_DELETE(g_pSnapshotManager);
+	SAFE_DELETE(g_pBroadcastGroupManager);
+	SAFE_DELETE(g_pInterestManager);
+	SAFE_DELETE(g_pEntityDataManager);
+	SAFE_DELETE(g_pLagCompensation);
+	SAFE_DELETE(g_pClientEventManager);
+	SAFE_DELETE(g_pChatManager);
+	SAFE_DELETE(g_pMessageBus);
+	SAFE_DELETE(g_pTransferManager);
+	SAFE_DELETE(g_pInstanceManager);
+	SAFE_DELETE(g_pZoneManager);
+	SAFE_DELETE(g_pSpatialIndex);
 	SAFE_DELETE(g_pNetworkManager);
 	CNetworkModule::Shutdown();
+	SAFE_DELETE(g_pBanManager);
+	SAFE_DELETE(g_pJobSystem);
 	SAFE_DELETE(g_pClientResourceFileManager);
 	SAFE_DELETE(g_pClientScriptFileManager);
+	SAFE_DELETE(g_pClientFilePack);
 	SAFE_DELETE(g_pScriptingManager);
-	SAFE_DELETE(g_pWebserver);
 	SAFE_DELETE(g_pTime);
 	SAFE_DELETE(g_pTrafficLights);
 	SAFE_DELETE(g_pEvents);
@@ -0,0 +1,169 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: BulkNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "ModuleNatives.h"
+#include "../CPlayerManager.h"
+#include "../CVehicleManager.h"
+
+extern CPlayerManager * g_pPlayerManager;
+extern CVehicleManager * g_pVehicleManager;
+
+// Bulk functions
+namespace Modules
+{
+	unsigned int CBulkModuleNatives::GetApiVersion()
+	{
+		return MODULE_API_VERSION;
+	}
+
+	unsigned int CBulkModuleNatives::GetPlayers(ModulePlayerData * pPlayers, unsigned int uiMaxPlayers)
+	{
+		if(!pPlayers)
+			return 0;
+
+		const std::vector<EntityId>& activePlayers = g_pPlayerManager->GetActivePlayers();
+		unsigned int uiCount = 0;
+
+		for(std::vector<EntityId>::const_iterator iter = activePlayers.begin(); iter != activePlayers.end() && uiCount < uiMaxPlayers; ++iter)
+		{
+			CPlayer * pPlayer = g_pPlayerManager->GetAt(*iter);
+
+			if(!pPlayer)
+				continue;
+
+			ModulePlayerData * pData = &pPlayers[uiCount++];
+			pData->playerId = *iter;
+			pData->iState = (int)pPlayer->GetState();
+			pPlayer->GetPosition(pData->vecPosition);
+			pPlayer->GetMoveSpeed(pData->vecMoveSpeed);
+			pData->fHeading = pPlayer->GetCurrentHeading();
+			pData->uiHealth = pPlayer->GetHealth();
+			pData->uiArmour = pPlayer->GetArmour();
+			pData->uiWeapon = pPlayer->GetWeapon();
+			pData->uiAmmo = pPlayer->GetAmmo();
+			CVehicle * pVehicle = pPlayer->GetVehicle();
+			pData->vehicleId = (pVehicle ? pVehicle->GetVehicleId() : INVALID_ENTITY_ID);
+			pData->ucSeatId = pPlayer->GetVehicleSeatId();
+			pData->usPing = pPlayer->GetPing();
+		}
+
+		return uiCount;
+	}
+
+	unsigned int CBulkModuleNatives::GetVehicles(ModuleVehicleData * pVehicles, unsigned int uiMaxVehicles)
+	{
+		if(!pVehicles)
+			return 0;
+
+		const std::vector<EntityId>& activeVehicles = g_pVehicleManager->GetActiveVehicles();
+		unsigned int uiCount = 0;
+
+		for(std::vector<EntityId>::const_iterator iter = activeVehicles.begin(); iter != activeVehicles.end() && uiCount < uiMaxVehicles; ++iter)
+		{
+			CVehicle * pVehicle = g_pVehicleManager->GetAt(*iter);
+
+			if(!pVehicle)
+				continue;
+
+			ModuleVehicleData * pData = &pVehicles[uiCount++];
+			pData->vehicleId = *iter;
+			pData->iModelId = pVehicle->GetModel();
+			pVehicle->GetPosition(pData->vecPosition);
+			pVehicle->GetRotation(pData->vecRotation);
+			pVehicle->GetMoveSpeed(pData->vecMoveSpeed);
+			pData->uiHealth = pVehicle->GetHealth();
+			CPlayer * pDriver = pVehicle->GetDriver();
+			pData->driverId = (pDriver ? pDriver->GetPlayerId() : INVALID_ENTITY_ID);
+		}
+
+		return uiCount;
+	}
+
+	bool CBulkModuleNatives::AddSyncHandler(ModuleSyncHandler_t pfnHandler, void * pUserData)
+	{
+		if(!pfnHandler)
+			return false;
+
+		for(std::vector<SyncHandler>::iterator iter = m_syncHandlers.begin(); iter != m_syncHandlers.end(); ++iter)
+		{
+			if((*iter).pfnHandler == pfnHandler && (*iter).pUserData == pUserData)
+				return false;
+		}
+
+		SyncHandler syncHandler;
+		syncHandler.pfnHandler = pfnHandler;
+		syncHandler.pUserData = pUserData;
+		m_syncHandlers.push_back(syncHandler);
+		return true;
+	}
+
+	bool CBulkModuleNatives::RemoveSyncHandler(ModuleSyncHandler_t pfnHandler, void * pUserData)
+	{
+		for(std::vector<SyncHandler>::iterator iter = m_syncHandlers.begin(); iter != m_syncHandlers.end(); ++iter)
+		{
+			if((*iter).pfnHandler == pfnHandler && (*iter).pUserData == pUserData)
+			{
+				m_syncHandlers.erase(iter);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool CBulkModuleNatives::AddSyncFilter(ModuleSyncFilter_t pfnFilter, void * pUserData)
+	{
+		if(!pfnFilter)
+			return false;
+
+		for(std::vector<SyncFilter>::iterator iter = m_syncFilters.begin(); iter != m_syncFilters.end(); ++iter)
+		{
+			if((*iter).pfnFilter == pfnFilter && (*iter).pUserData == pUserData)
+				return false;
+		}
+
+		SyncFilter syncFilter;
+		syncFilter.pfnFilter = pfnFilter;
+		syncFilter.pUserData = pUserData;
+		m_syncFilters.push_back(syncFilter);
+		return true;
+	}
+
+	bool CBulkModuleNatives::RemoveSyncFilter(ModuleSyncFilter_t pfnFilter, void * pUserData)
+	{
+		for(std::vector<SyncFilter>::iterator iter = m_syncFilters.begin(); iter != m_syncFilters.end(); ++iter)
+		{
+			if((*iter).pfnFilter == pfnFilter && (*iter).pUserData == pUserData)
+			{
+				m_syncFilters.erase(iter);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void CBulkModuleNatives::OnSync(EntityId playerId, eModuleSyncType syncType, const void * pSyncData, const AimSyncData * pAimSyncData)
+	{
+		// Walk by index so a handler can add or remove handlers during the call
+		for(unsigned int i = 0; i < m_syncHandlers.size(); i++)
+			m_syncHandlers[i].pfnHandler(playerId, syncType, pSyncData, pAimSyncData, m_syncHandlers[i].pUserData);
+	}
+
+	bool CBulkModuleNatives::FilterSync(EntityId playerId, eModuleSyncType syncType, void * pSyncData, AimSyncData * pAimSyncData)
+	{
+		for(unsigned int i = 0; i < m_syncFilters.size(); i++)
+		{
+			if(!m_syncFilters[i].pfnFilter(playerId, syncType, pSyncData, pAimSyncData, m_syncFilters[i].pUserData))
+				return false;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: BulkNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "ModuleNatives.h"
+#include <vector>
+
+namespace Modules
+{
+	class CBulkModuleNatives : public ICBulkModuleNatives
+	{
+	private:
+		struct SyncHandler
+		{
+			ModuleSyncHandler_t pfnHandler;
+			void              * pUserData;
+		};
+
+		struct SyncFilter
+		{
+			ModuleSyncFilter_t pfnFilter;
+			void             * pUserData;
+		};
+
+		std::vector<SyncHandler> m_syncHandlers;
+		std::vector<SyncFilter>  m_syncFilters;
+
+	public:
+		unsigned int GetApiVersion();
+		unsigned int GetPlayers(ModulePlayerData * pPlayers, unsigned int uiMaxPlayers);
+		unsigned int GetVehicles(ModuleVehicleData * pVehicles, unsigned int uiMaxVehicles);
+		bool AddSyncHandler(ModuleSyncHandler_t pfnHandler, void * pUserData);
+		bool RemoveSyncHandler(ModuleSyncHandler_t pfnHandler, void * pUserData);
+		bool AddSyncFilter(ModuleSyncFilter_t pfnFilter, void * pUserData);
+		bool RemoveSyncFilter(ModuleSyncFilter_t pfnFilter, void * pUserData);
+
+		// Checked first so the sync handlers and filters cost nothing without a module using them
+		bool HasSyncHandlers() { return !m_syncHandlers.empty(); }
+		bool HasSyncFilters() { return !m_syncFilters.empty(); }
+		void OnSync(EntityId playerId, eModuleSyncType syncType, const void * pSyncData, const AimSyncData * pAimSyncData);
+
+		// Returns false if a filter dropped the packet
+		bool FilterSync(EntityId playerId, eModuleSyncType syncType, void * pSyncData, AimSyncData * pAimSyncData);
+	};
+}
@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: BulkNatives.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "IModuleNatives.h"
+
+namespace Modules
+{
+	// The state of a player as written by GetPlayers
+	struct ModulePlayerData
+	{
+		EntityId       playerId;
+		int            iState;
+		CVector3       vecPosition;
+		CVector3       vecMoveSpeed;
+		float          fHeading;
+		unsigned int   uiHealth;
+		unsigned int   uiArmour;
+		unsigned int   uiWeapon;
+		unsigned int   uiAmmo;
+		EntityId       vehicleId; // INVALID_ENTITY_ID if the player is on foot
+		unsigned char  ucSeatId;
+		unsigned short usPing;
+	};
+
+	// The state of a vehicle as written by GetVehicles
+	struct ModuleVehicleData
+	{
+		EntityId     vehicleId;
+		int          iModelId;
+		CVector3     vecPosition;
+		CVector3     vecRotation;
+		CVector3     vecMoveSpeed;
+		unsigned int uiHealth;
+		EntityId     driverId; // INVALID_ENTITY_ID if the vehicle has no driver
+	};
+
+	enum eModuleSyncType
+	{
+		MODULE_SYNC_ONFOOT,    // pSyncData is an OnFootSyncData
+		MODULE_SYNC_INVEHICLE, // pSyncData is an InVehicleSyncData
+		MODULE_SYNC_PASSENGER, // pSyncData is a PassengerSyncData
+		MODULE_SYNC_SMALL      // pSyncData is a SmallSyncData
+	};
+
+	// Called with each sync packet once it is applied to the player, the data (and
+	// pAimSyncData, NULL if the packet has none) is only valid during the call
+	typedef void (* ModuleSyncHandler_t)(EntityId playerId, eModuleSyncType syncType, const void * pSyncData, const AimSyncData * pAimSyncData, void * pUserData);
+
+	// Called with each sync packet once it is decoded but before it is applied to the player,
+	// the filter can change the data and returns false to drop the packet (the filters after
+	// it and the sync handlers aren't called for a dropped packet)
+	typedef bool (* ModuleSyncFilter_t)(EntityId playerId, eModuleSyncType syncType, void * pSyncData, AimSyncData * pAimSyncData, void * pUserData);
+
+	class ICBulkModuleNatives
+	{
+	public:
+		// MODULE_API_VERSION of the server, servers older than version 2 don't have this interface
+		virtual unsigned int GetApiVersion() = 0;
+
+		// Write the state of up to uiMaxPlayers players (in ascending id order) into pPlayers
+		// and return the amount of players written
+		virtual unsigned int GetPlayers(ModulePlayerData * pPlayers, unsigned int uiMaxPlayers) = 0;
+		virtual unsigned int GetVehicles(ModuleVehicleData * pVehicles, unsigned int uiMaxVehicles) = 0;
+
+		virtual bool AddSyncHandler(ModuleSyncHandler_t pfnHandler, void * pUserData) = 0;
+		virtual bool RemoveSyncHandler(ModuleSyncHandler_t pfnHandler, void * pUserData) = 0;
+
+		// Version 3, the filters are called in the order they were added
+		virtual bool AddSyncFilter(ModuleSyncFilter_t pfnFilter, void * pUserData) = 0;
+		virtual bool RemoveSyncFilter(ModuleSyncFilter_t pfnFilter, void * pUserData) = 0;
+	};
+}
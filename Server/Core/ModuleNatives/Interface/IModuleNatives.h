@@ -17,6 +17,11 @@
 #include <Game/CControlState.h>
 #include <list>
 
+// Version of the module interfaces, increased when an interface is added
+// 2: Bulk functions (NewInterfaceContainer[12])
+// 3: Sync filters in the bulk functions
+#define MODULE_API_VERSION 3
+
 // Natives
 
 // Server and Timer functions
@@ -53,4 +58,7 @@
 #include "IHashNatives.h"
 
 // World functions
-#include "IWorldNatives.h"
\ No newline at end of file
+#include "IWorldNatives.h"
+
+// Bulk functions
+#include "IBulkNatives.h"
\ No newline at end of file
@@ -29,5 +29,6 @@ namespace Modules
 		virtual void DeleteFire(EntityId fireId) = 0;
 		virtual bool AttachPed(EntityId objectId, EntityId playerId, CVector3 vecPos, CVector3 vecRot) = 0;
 		virtual bool AttachVehicle(EntityId objectId, EntityId vehicleId, CVector3 vecPos, CVector3 vecRot) = 0;
+		virtual EntityId CreateBatch(unsigned int uiCount, const int * pModelHashes, const CVector3 * pPositions, const CVector3 * pRotations) = 0;
 	};
 }
\ No newline at end of file
@@ -58,5 +58,6 @@ namespace Modules
 		virtual bool GetTaxiLights(EntityId vehicleId) = 0;
 		virtual bool RepairWheels(EntityId vehicleId) = 0;
 		virtual bool RepairWindows(EntityId vehicleId) = 0;
+		virtual EntityId CreateBatch(unsigned int uiCount, const int * pModelIds, const CVector3 * pPositions, const CVector3 * pRotations, const int * pColors) = 0;
 	};
 }
\ No newline at end of file
@@ -55,4 +55,7 @@
 #include "HashNatives.h"
 
 // World functions
-#include "WorldNatives.h"
\ No newline at end of file
+#include "WorldNatives.h"
+
+// Bulk functions
+#include "BulkNatives.h"
\ No newline at end of file
@@ -136,4 +136,14 @@ namespace Modules
 		}
 		return false;
 	}
+
+	// createObjects([[modelhash, x, y, z, rx, ry, rz], ...])
+	EntityId CObjectModuleNatives::CreateBatch(unsigned int uiCount, const int * pModelHashes, const CVector3 * pPositions, const CVector3 * pRotations)
+	{
+		if(uiCount == 0)
+			return INVALID_ENTITY_ID;
+
+		std::vector<DWORD> modelHashes(pModelHashes, (pModelHashes + uiCount));
+		return g_pObjectManager->CreateBatch(uiCount, &modelHashes[0], pPositions, pRotations);
+	}
 }
\ No newline at end of file
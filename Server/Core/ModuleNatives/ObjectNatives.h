@@ -30,5 +30,6 @@ namespace Modules
 		void DeleteFire(EntityId fireId);
 		bool AttachPed(EntityId objectId, EntityId playerId, CVector3 vecPos, CVector3 vecRot);
 		bool AttachVehicle(EntityId objectId, EntityId vehicleId, CVector3 vecPos, CVector3 vecRot);
+		EntityId CreateBatch(unsigned int uiCount, const int * pModelHashes, const CVector3 * pPositions, const CVector3 * pRotations);
 	};
 }
\ No newline at end of file
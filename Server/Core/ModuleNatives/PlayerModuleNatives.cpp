@@ -202,10 +202,7 @@ namespace Modules
 		if(g_pPlayerManager->DoesExist(playerId) && (iHour >= 0 && iHour < 24) && (iMinute >= 0 && iMinute < 60))
 		{
 			CBitStream bsSend;
-			bsSend.Write((unsigned char)iHour);
-			bsSend.Write((unsigned char)iMinute);
-			if(g_pTime->GetMinuteDuration() != CTime::DEFAULT_MINUTE_DURATION)
-				bsSend.Write(g_pTime->GetMinuteDuration());
+			CTime::WriteTime(&bsSend, g_pTime->GetDayOfWeek(), (unsigned char)iHour, (unsigned char)iMinute, g_pTime->GetMinuteDuration(), 0);
 
 			g_pNetworkManager->RPC(RPC_ScriptingSetPlayerTime, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 			return true;
@@ -253,7 +250,7 @@ namespace Modules
 			bsSend.Write(String(szMessage));
 			bool bAllowFormatting = (sqbAllowFormatting != 0);
 			bsSend.Write(bAllowFormatting);
-			g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_CHAT);
 			return true;
 		}
 
@@ -270,7 +267,7 @@ namespace Modules
 			bsSend.Write(String(szMessage));
 			bool bAllowFormatting = (sqbAllowFormatting != 0);
 			bsSend.Write(bAllowFormatting);
-			g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+			g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_CHAT);
 			return true;
 		}
 
@@ -630,7 +627,7 @@ namespace Modules
 			bsSend.Write(fPosY);
 			bsSend.Write(String(szText));
 			bsSend.Write(iTime);
-			g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 
@@ -645,7 +642,7 @@ namespace Modules
 		bsSend.Write(fPosY);
 		bsSend.Write(String(szText));
 		bsSend.Write(iTime);
-		g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_GUI);
 		return true;
 	}
 
@@ -657,7 +654,7 @@ namespace Modules
 			CBitStream bsSend;
 			bsSend.Write(String(szText));
 			bsSend.Write(iTime);
-			g_pNetworkManager->RPC(RPC_ScriptingDisplayInfoText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingDisplayInfoText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 
@@ -670,7 +667,7 @@ namespace Modules
 		CBitStream bsSend;
 		bsSend.Write(String(szText));
 		bsSend.Write(iTime);
-		g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_GUI);
 		return true;
 	}
 
@@ -834,7 +831,7 @@ namespace Modules
 		{
 			CBitStream bsSend;
 			bsSend.Write(sqbToggle != 0);
-			g_pNetworkManager->RPC(RPC_ScriptingToggleHUD, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingToggleHUD, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 
@@ -849,7 +846,7 @@ namespace Modules
 			CBitStream bsSend;
 			bool bToggle = (sqbToggle != 0);
 			bsSend.Write(bToggle);
-			g_pNetworkManager->RPC(RPC_ScriptingToggleRadar, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingToggleRadar, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 
@@ -879,7 +876,7 @@ namespace Modules
 			CBitStream bsSend;
 			bool bToggle = (sqbToggle != 0);
 			bsSend.Write(bToggle);
-			g_pNetworkManager->RPC(RPC_ScriptingToggleAreaNames, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingToggleAreaNames, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 
@@ -931,9 +928,10 @@ namespace Modules
 	// triggerClientEvent(playerid, eventname, ...)
 	bool CPlayerModuleNatives::TriggerEvent(EntityId playerid, const char * szEventName, const char * szFormat, ...)
 	{
-		CBitStream bsSend;
-		CSquirrelArguments* arguments = new CSquirrelArguments();
-		arguments->push(String(szEventName));
+		if(!g_pPlayerManager->DoesExist(playerid))
+			return false;
+
+		CSquirrelArguments arguments;
 
 		int argcount = 0;
 		const char* p = szFormat;
@@ -947,24 +945,24 @@ namespace Modules
 				{
 					case 'b':
 					{
-						arguments->push(va_arg(ap, int) != 0);
+						arguments.push(va_arg(ap, int) != 0);
 					}
 					break;
 					case 'i':
 					{
-						arguments->push((int)va_arg(ap, int));
+						arguments.push((int)va_arg(ap, int));
 						break;
 					}
 					case 'f':
 					{
-						arguments->push((float)va_arg(ap, double));
+						arguments.push((float)va_arg(ap, double));
 						break;
 					}
 					break;
 					case 's':
 					{
 						char* sz = va_arg(ap, char*);
-						arguments->push(String(sz));
+						arguments.push(String(sz));
 						break;
 					}
 				}
@@ -974,8 +972,7 @@ namespace Modules
 			va_end(ap);
 		}
 		
-		arguments->serialize(&bsSend);
-		g_pNetworkManager->RPC(RPC_ScriptingEventCall, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerid, false, PACKET_CHANNEL_SCRIPT);
+		g_pNetworkManager->EventRPC(szEventName, &arguments, &playerid, 1);
 		return true;
 	}
 	
@@ -1189,7 +1186,7 @@ namespace Modules
 		{
 			CBitStream bsSend;
 			bsSend.Write(String(szAudio));
-			g_pNetworkManager->RPC(RPC_ScriptingPlayGameAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingPlayGameAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 		return false;
@@ -1201,7 +1198,7 @@ namespace Modules
 		{
 			CBitStream bsSend;
 			bsSend.Write(iMission);
-			g_pNetworkManager->RPC(RPC_ScriptingPlayMissionCompleteAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingPlayMissionCompleteAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 		return false;
@@ -1213,7 +1210,7 @@ namespace Modules
 		{
 			CBitStream bsSend;
 			bsSend.Write(String(szAudio));
-			g_pNetworkManager->RPC(RPC_ScriptingPlayPoliceReport, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingPlayPoliceReport, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 		return false;
@@ -1225,7 +1222,7 @@ namespace Modules
 		{
 			CBitStream bsSend;
 			bsSend.Write(iDuration);
-			g_pNetworkManager->RPC(RPC_ScriptingFadeScreenIn, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingFadeScreenIn, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 		return false;
@@ -1237,7 +1234,7 @@ namespace Modules
 		{
 			CBitStream bsSend;
 			bsSend.Write(iDuration);
-			g_pNetworkManager->RPC(RPC_ScriptingFadeScreenOut, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+			g_pNetworkManager->RPC(RPC_ScriptingFadeScreenOut, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 			return true;
 		}
 		return false;
@@ -13,6 +13,7 @@
 #include "Scripting/CScriptingManager.h"
 #include "../CVehicleManager.h"
 #include "../CPlayer.h"
+#include <Game/CVehicleModels.h>
 
 extern CVehicleManager * g_pVehicleManager;
 extern CNetworkManager * g_pNetworkManager;
@@ -25,7 +26,7 @@ namespace Modules
 	// TODO: Rotation and colors optional
 	int CVehicleModuleNatives::Create(int iModelId, CVector3 vecPosition, CVector3 vecRotation, int color1, int color2, int color3, int color4)
 	{
-		if(iModelId < 0 || iModelId == 41 || iModelId == 96 || iModelId == 107 || iModelId == 111 || iModelId > 123)
+		if(!CVehicleModels::IsValidModel(iModelId))
 		{
 			#ifdef IVMP_DEBUG
 				CLogFile::Printf("Invalid vehicle model (%d)", iModelId);
@@ -659,4 +660,35 @@ namespace Modules
 
 		return false;
 	}
+
+	// createVehicles([[model, x, y, z, rx, ry, rz, color1, color2, color3, color4], ...])
+	// pColors holds 4 colors per vehicle or is NULL
+	EntityId CVehicleModuleNatives::CreateBatch(unsigned int uiCount, const int * pModelIds, const CVector3 * pPositions, const CVector3 * pRotations, const int * pColors)
+	{
+		if(uiCount == 0 || uiCount > MAX_VEHICLES)
+			return INVALID_ENTITY_ID;
+
+		std::vector<BYTE> colors((uiCount * 4), 0);
+
+		for(unsigned int i = 0; i < uiCount; i++)
+		{
+			int iModelId = pModelIds[i];
+
+			if(!CVehicleModels::IsValidModel(iModelId))
+			{
+				#ifdef IVMP_DEBUG
+					CLogFile::Printf("Invalid vehicle model (%d)", iModelId);
+				#endif
+				return INVALID_ENTITY_ID;
+			}
+
+			if(pColors)
+			{
+				for(unsigned int j = 0; j < 4; j++)
+					colors[(i * 4) + j] = (BYTE)pColors[(i * 4) + j];
+			}
+		}
+
+		return g_pVehicleManager->AddBatch(uiCount, pModelIds, pPositions, pRotations, &colors[0]);
+	}
 }
\ No newline at end of file
@@ -59,5 +59,6 @@ namespace Modules
 		bool GetTaxiLights(EntityId vehicleId);
 		bool RepairWheels(EntityId vehicleId);
 		bool RepairWindows(EntityId vehicleId);
+		EntityId CreateBatch(unsigned int uiCount, const int * pModelIds, const CVector3 * pPositions, const CVector3 * pRotations, const int * pColors);
 	};
 }
\ No newline at end of file
@@ -43,5 +43,35 @@
 // Pickup functions
 #include "Natives/PickupNatives.h"
 
+// Spatial functions
+#include "Natives/SpatialNatives.h"
+
+// Zone functions
+#include "Natives/ZoneNatives.h"
+
+// Instance functions
+#include "Natives/InstanceNatives.h"
+
+// Message bus functions
+#include "Natives/MessageBusNatives.h"
+
+// Chat functions
+#include "Natives/ChatNatives.h"
+
+// Entity data functions
+#include "Natives/EntityDataNatives.h"
+
+// World snapshot functions
+#include "Natives/WorldSnapshotNatives.h"
+
+// Leaderboard functions
+#include "Natives/LeaderboardNatives.h"
+
+// Client event functions
+#include "Natives/ClientEventNatives.h"
+
 // Script functions
 #include "Natives/ScriptNatives.h"
+
+// Command functions
+#include "Natives/CommandNatives.h"
@@ -48,6 +48,9 @@ void CActorNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("driveActorToCoordinates", DriveToCoordinates, 4,"ifff");
 	pScriptingManager->RegisterFunction("forceAnimationAtActor", ForceAnim, 3, "iss");
 	pScriptingManager->RegisterFunction("sayActorSpeech", SaySpeech, 3, "iss");
+	pScriptingManager->RegisterFunction("setActorPath", SetPath, -1, NULL);
+	pScriptingManager->RegisterFunction("stopActorPath", StopPath, 1, "i");
+	pScriptingManager->RegisterFunction("isActorOnPath", IsOnPath, 1, "i");
 }
 
 // createActor(modelhash, x, y, z, r)
@@ -490,3 +493,85 @@ SQInteger CActorNatives::SaySpeech(SQVM * pVM)
 	sq_pushbool(pVM, false);
 	return 1;
 }
+
+// setActorPath(actorid, [[x, y, z], ...], speed, [loop])
+// The server walks the actor along the waypoints at the speed (in units per second)
+// and the clients follow the same path, so no player has to control the actor
+SQInteger CActorNatives::SetPath(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("setActorPath", 3, 4);
+	CHECK_TYPE("setActorPath", 1, 2, OT_INTEGER);
+	CHECK_TYPE("setActorPath", 2, 3, OT_ARRAY);
+
+	EntityId actorId;
+	sq_getentity(pVM, 2, &actorId);
+	SQInteger iCount = sq_getsize(pVM, 3);
+	float fSpeed;
+
+	if(!g_pActorManager->DoesExist(actorId) || iCount <= 0 || iCount > MOVE_TIMELINE_MAX_KEYFRAMES ||
+		SQ_FAILED(sq_getfloat(pVM, 4, &fSpeed)) || fSpeed <= 0.0f)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	CMoveTimeline path;
+
+	if(sq_gettop(pVM) >= 5)
+	{
+		CHECK_TYPE("setActorPath", 4, 5, OT_BOOL);
+		SQBool bLoop = false;
+		sq_getbool(pVM, 5, &bLoop);
+		path.SetLoop(bLoop != 0);
+	}
+
+	// The time of each waypoint is how long the actor takes to walk to it
+	CVector3 vecLastPosition;
+	float fTime = 0.0f;
+
+	for(SQInteger i = 0; i < iCount; i++)
+	{
+		if(SQ_FAILED(sq_pusharrayelement(pVM, 3, i)))
+		{
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		CVector3 vecPosition;
+		bool bValid = (sq_gettype(pVM, -1) == OT_ARRAY && SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 0, &vecPosition)));
+		sq_pop(pVM, 1);
+
+		if(bValid && i > 0)
+			fTime += (((vecPosition - vecLastPosition).Length() / fSpeed) * 1000.0f);
+
+		if(!bValid || !path.AddKeyframe((unsigned int)fTime, vecPosition, CVector3()))
+		{
+			CLogFile::Printf("Invalid waypoint %d for function setActorPath.", i);
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		vecLastPosition = vecPosition;
+	}
+
+	sq_pushbool(pVM, g_pActorManager->SetPath(actorId, path));
+	return 1;
+}
+
+// stopActorPath(actorid)
+SQInteger CActorNatives::StopPath(SQVM * pVM)
+{
+	EntityId actorId;
+	sq_getentity(pVM, -1, &actorId);
+	sq_pushbool(pVM, g_pActorManager->StopPath(actorId));
+	return 1;
+}
+
+// isActorOnPath(actorid)
+SQInteger CActorNatives::IsOnPath(SQVM * pVM)
+{
+	EntityId actorId;
+	sq_getentity(pVM, -1, &actorId);
+	sq_pushbool(pVM, g_pActorManager->HasPath(actorId));
+	return 1;
+}
@@ -40,6 +40,9 @@ private:
 	static SQInteger DriveToCoordinates(SQVM * pVM);
 	static SQInteger ForceAnim(SQVM * pVM);
 	static SQInteger SaySpeech(SQVM * pVM);
+	static SQInteger SetPath(SQVM * pVM);
+	static SQInteger StopPath(SQVM * pVM);
+	static SQInteger IsOnPath(SQVM * pVM);
 
 public:
 	static void      Register(CScriptingManager * pScriptingManager);
@@ -42,6 +42,9 @@ void CBlipNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("getBlipName", GetName, -1, "is");
 	pScriptingManager->RegisterFunction("switchBlipIcon", SwitchIcon, 2, "ib");
 	pScriptingManager->RegisterFunction("switchBlipIconForPlayer", SwitchIconPlayer, 3, "iib");
+	pScriptingManager->RegisterFunction("attachBlipToPlayer", AttachToPlayer, 2, "ii");
+	pScriptingManager->RegisterFunction("detachBlip", Detach, 1, "i");
+	pScriptingManager->RegisterFunction("getBlipAttachedPlayer", GetAttachedPlayer, 1, "i");
 
 	pScriptingManager->RegisterFunction("createPlayerBlip", CreatePlayerBlip, 2, "ii");
 	pScriptingManager->RegisterFunction("deletePlayerBlip", DeletePlayerBlip, 1, "i");
@@ -429,6 +432,59 @@ SQInteger CBlipNatives::SwitchIconPlayer(SQVM * pVM)
 	return 1;
 }
 
+// attachBlipToPlayer(blipid, playerid)
+SQInteger CBlipNatives::AttachToPlayer(SQVM * pVM)
+{
+	EntityId blipId;
+	sq_getentity(pVM, -2, &blipId);
+
+	EntityId playerId;
+	sq_getentity(pVM, -1, &playerId);
+
+	if(g_pBlipManager->DoesExist(blipId) && g_pPlayerManager->DoesExist(playerId))
+	{
+		g_pBlipManager->AttachToPlayer(blipId, playerId);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// detachBlip(blipid)
+SQInteger CBlipNatives::Detach(SQVM * pVM)
+{
+	EntityId blipId;
+	sq_getentity(pVM, -1, &blipId);
+
+	if(g_pBlipManager->DoesExist(blipId))
+	{
+		g_pBlipManager->AttachToPlayer(blipId, INVALID_ENTITY_ID);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// getBlipAttachedPlayer(blipid)
+SQInteger CBlipNatives::GetAttachedPlayer(SQVM * pVM)
+{
+	EntityId blipId;
+	sq_getentity(pVM, -1, &blipId);
+
+	if(g_pBlipManager->DoesExist(blipId))
+	{
+		sq_pushentity(pVM, g_pBlipManager->GetAttachedPlayer(blipId));
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
 SQInteger CBlipNatives::CreatePlayerBlip(SQVM * pVM)
 {
 	EntityId playerId;
@@ -30,6 +30,9 @@ private:
 	static SQInteger GetName(SQVM * pVM);
 	static SQInteger SwitchIcon(SQVM * pVM);
 	static SQInteger SwitchIconPlayer(SQVM * pVM);
+	static SQInteger AttachToPlayer(SQVM * pVM);
+	static SQInteger Detach(SQVM * pVM);
+	static SQInteger GetAttachedPlayer(SQVM * pVM);
 	static SQInteger CreatePlayerBlip(SQVM * pVM);
 	static SQInteger DeletePlayerBlip(SQVM * pVM);
 	static SQInteger TogglePlayerShortRange(SQVM * pVM);
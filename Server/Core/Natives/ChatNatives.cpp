@@ -0,0 +1,140 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ChatNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "../CChatManager.h"
+
+extern CChatManager * g_pChatManager;
+
+// Chat functions
+
+void CChatNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterConstant("CHAT_CHANNEL_DEFAULT", CHAT_CHANNEL_DEFAULT);
+	pScriptingManager->RegisterConstant("CHAT_CHANNEL_GLOBAL", CHAT_CHANNEL_GLOBAL);
+	pScriptingManager->RegisterConstant("CHAT_CHANNEL_PROXIMITY", CHAT_CHANNEL_PROXIMITY);
+	pScriptingManager->RegisterConstant("CHAT_CHANNEL_DIMENSION", CHAT_CHANNEL_DIMENSION);
+	pScriptingManager->RegisterConstant("CHAT_CHANNEL_TEAM", CHAT_CHANNEL_TEAM);
+	pScriptingManager->RegisterFunction("createChatChannel", Create, -1, NULL);
+	pScriptingManager->RegisterFunction("deleteChatChannel", Delete, 1, "i");
+	pScriptingManager->RegisterFunction("setChatChannel", Set, -1, NULL);
+	pScriptingManager->RegisterFunction("setPlayerChatChannel", SetPlayerChannel, 2, "ii");
+	pScriptingManager->RegisterFunction("getPlayerChatChannel", GetPlayerChannel, 1, "i");
+	pScriptingManager->RegisterFunction("setPlayerChatTeam", SetPlayerTeam, 2, "ii");
+	pScriptingManager->RegisterFunction("getPlayerChatTeam", GetPlayerTeam, 1, "i");
+}
+
+// createChatChannel(type, [radius])
+SQInteger CChatNatives::Create(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("createChatChannel", 1, 2);
+	CHECK_TYPE("createChatChannel", 1, 2, OT_INTEGER);
+
+	SQInteger iType;
+	float fRadius = 0.0f;
+	sq_getinteger(pVM, 2, &iType);
+
+	if(sq_gettop(pVM) >= 3)
+	{
+		CHECK_TYPE("createChatChannel", 2, 3, OT_FLOAT);
+		sq_getfloat(pVM, 3, &fRadius);
+	}
+
+	ChatChannelId channelId = g_pChatManager->Create((eChatChannelType)iType, fRadius);
+
+	if(channelId == INVALID_CHAT_CHANNEL)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, channelId);
+	return 1;
+}
+
+// deleteChatChannel(channelid)
+SQInteger CChatNatives::Delete(SQVM * pVM)
+{
+	SQInteger iChannelId;
+	sq_getinteger(pVM, -1, &iChannelId);
+	sq_pushbool(pVM, g_pChatManager->Delete((ChatChannelId)iChannelId));
+	return 1;
+}
+
+// setChatChannel(channelid, type, [radius])
+SQInteger CChatNatives::Set(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("setChatChannel", 2, 3);
+	CHECK_TYPE("setChatChannel", 1, 2, OT_INTEGER);
+	CHECK_TYPE("setChatChannel", 2, 3, OT_INTEGER);
+
+	SQInteger iChannelId;
+	SQInteger iType;
+	float fRadius = 0.0f;
+	sq_getinteger(pVM, 2, &iChannelId);
+	sq_getinteger(pVM, 3, &iType);
+
+	if(sq_gettop(pVM) >= 4)
+	{
+		CHECK_TYPE("setChatChannel", 3, 4, OT_FLOAT);
+		sq_getfloat(pVM, 4, &fRadius);
+	}
+
+	sq_pushbool(pVM, g_pChatManager->Set((ChatChannelId)iChannelId, (eChatChannelType)iType, fRadius));
+	return 1;
+}
+
+// setPlayerChatChannel(playerid, channelid)
+SQInteger CChatNatives::SetPlayerChannel(SQVM * pVM)
+{
+	EntityId playerId;
+	SQInteger iChannelId;
+	sq_getentity(pVM, -2, &playerId);
+	sq_getinteger(pVM, -1, &iChannelId);
+	sq_pushbool(pVM, g_pChatManager->SetPlayerChannel(playerId, (ChatChannelId)iChannelId));
+	return 1;
+}
+
+// getPlayerChatChannel(playerid)
+SQInteger CChatNatives::GetPlayerChannel(SQVM * pVM)
+{
+	EntityId playerId;
+	sq_getentity(pVM, -1, &playerId);
+	ChatChannelId channelId = g_pChatManager->GetPlayerChannel(playerId);
+
+	if(channelId == INVALID_CHAT_CHANNEL)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, channelId);
+	return 1;
+}
+
+// setPlayerChatTeam(playerid, team)
+SQInteger CChatNatives::SetPlayerTeam(SQVM * pVM)
+{
+	EntityId playerId;
+	SQInteger iTeam;
+	sq_getentity(pVM, -2, &playerId);
+	sq_getinteger(pVM, -1, &iTeam);
+	sq_pushbool(pVM, g_pChatManager->SetPlayerTeam(playerId, (int)iTeam));
+	return 1;
+}
+
+// getPlayerChatTeam(playerid)
+SQInteger CChatNatives::GetPlayerTeam(SQVM * pVM)
+{
+	EntityId playerId;
+	sq_getentity(pVM, -1, &playerId);
+	sq_pushinteger(pVM, g_pChatManager->GetPlayerTeam(playerId));
+	return 1;
+}
@@ -0,0 +1,27 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ChatNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CChatNatives
+{
+private:
+	static SQInteger Create(SQVM * pVM);
+	static SQInteger Delete(SQVM * pVM);
+	static SQInteger Set(SQVM * pVM);
+	static SQInteger SetPlayerChannel(SQVM * pVM);
+	static SQInteger GetPlayerChannel(SQVM * pVM);
+	static SQInteger SetPlayerTeam(SQVM * pVM);
+	static SQInteger GetPlayerTeam(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
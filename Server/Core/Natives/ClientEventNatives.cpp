@@ -0,0 +1,132 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ClientEventNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "ClientEventNatives.h"
+#include "../CClientEventManager.h"
+#include <algorithm>
+#include <vector>
+
+extern CClientEventManager * g_pClientEventManager;
+extern CEvents * g_pEvents;
+
+// Client event functions
+
+void CClientEventNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("setClientEventLimit", SetLimit, -1, NULL);
+	pScriptingManager->RegisterFunction("setClientEventCoalesced", SetCoalesced, 2, "sb");
+	pScriptingManager->RegisterFunction("getClientEventStats", GetStats, 0, NULL);
+	pScriptingManager->RegisterFunction("resetClientEventStats", ResetStats, 0, NULL);
+}
+
+// setClientEventLimit(eventname, persecond, [burst = persecond * 2])
+// A limit of 0 events per second lets the players send the event as often as they want
+SQInteger CClientEventNatives::SetLimit(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("setClientEventLimit", 2, 3);
+	CHECK_TYPE("setClientEventLimit", 1, 2, OT_STRING);
+	CHECK_TYPE("setClientEventLimit", 2, 3, OT_FLOAT);
+
+	const char * szEventName;
+	float fRate;
+	sq_getstring(pVM, 2, &szEventName);
+	sq_getfloat(pVM, 3, &fRate);
+	float fBurst = (fRate * 2.0f);
+
+	if(sq_gettop(pVM) >= 4)
+	{
+		CHECK_TYPE("setClientEventLimit", 3, 4, OT_FLOAT);
+		sq_getfloat(pVM, 4, &fBurst);
+	}
+
+	if(fRate < 0.0f)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	g_pClientEventManager->SetLimit(g_pEvents->GetEventId(szEventName), fRate, fBurst);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// setClientEventCoalesced(eventname, toggle)
+// A coalesced event is called once per tick for each player with the arguments it sent last
+SQInteger CClientEventNatives::SetCoalesced(SQVM * pVM)
+{
+	const char * szEventName;
+	SQBool bCoalesce;
+	sq_getstring(pVM, 2, &szEventName);
+	sq_getbool(pVM, 3, &bCoalesce);
+	g_pClientEventManager->SetCoalesced(g_pEvents->GetEventId(szEventName), (bCoalesce != 0));
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+static bool SortByTime(const std::pair<unsigned long long, EventId>& a, const std::pair<unsigned long long, EventId>& b)
+{
+	return (a.first > b.first);
+}
+
+// getClientEventStats()
+// Returns an array with a table for each event the players sent, the most expensive event first
+SQInteger CClientEventNatives::GetStats(SQVM * pVM)
+{
+	const std::map<EventId, ClientEventStats>& stats = g_pClientEventManager->GetStats();
+	std::vector<std::pair<unsigned long long, EventId> > events;
+
+	for(std::map<EventId, ClientEventStats>::const_iterator iter = stats.begin(); iter != stats.end(); ++iter)
+		events.push_back(std::pair<unsigned long long, EventId>((*iter).second.ullTime, (*iter).first));
+
+	std::sort(events.begin(), events.end(), SortByTime);
+	sq_newarray(pVM, 0);
+
+	for(size_t i = 0; i < events.size(); i++)
+	{
+		const ClientEventStats& eventStats = stats.find(events[i].second)->second;
+		sq_newtable(pVM);
+
+		sq_pushstring(pVM, "name", -1);
+		sq_pushstring(pVM, g_pEvents->GetEventName(events[i].second).Get(), -1);
+		sq_createslot(pVM, -3);
+
+		sq_pushstring(pVM, "received", -1);
+		sq_pushinteger(pVM, eventStats.uiReceived);
+		sq_createslot(pVM, -3);
+
+		sq_pushstring(pVM, "called", -1);
+		sq_pushinteger(pVM, eventStats.uiCalled);
+		sq_createslot(pVM, -3);
+
+		sq_pushstring(pVM, "dropped", -1);
+		sq_pushinteger(pVM, eventStats.uiDropped);
+		sq_createslot(pVM, -3);
+
+		sq_pushstring(pVM, "coalesced", -1);
+		sq_pushinteger(pVM, eventStats.uiCoalesced);
+		sq_createslot(pVM, -3);
+
+		// Milliseconds spent in the handlers
+		sq_pushstring(pVM, "time", -1);
+		sq_pushfloat(pVM, (float)(eventStats.ullTime / 1000.0));
+		sq_createslot(pVM, -3);
+
+		sq_arrayappend(pVM, -2);
+	}
+
+	return 1;
+}
+
+// resetClientEventStats()
+SQInteger CClientEventNatives::ResetStats(SQVM * pVM)
+{
+	g_pClientEventManager->ResetStats();
+	sq_pushbool(pVM, true);
+	return 1;
+}
@@ -0,0 +1,24 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ClientEventNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CClientEventNatives
+{
+private:
+	static SQInteger SetLimit(SQVM * pVM);
+	static SQInteger SetCoalesced(SQVM * pVM);
+	static SQInteger GetStats(SQVM * pVM);
+	static SQInteger ResetStats(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
@@ -0,0 +1,59 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CommandNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include "Scripting/CScriptingManager.h"
+#include "CEvents.h"
+#include "../CCommandManager.h"
+
+extern CCommandManager * g_pCommandManager;
+
+// Command functions
+
+void CCommandNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("addCommandHandler", Add, 2, "sc");
+	pScriptingManager->RegisterFunction("removeCommandHandler", Remove, -1, NULL);
+}
+
+// addCommandHandler(name, function(playerid, args, text))
+SQInteger CCommandNatives::Add(SQVM * pVM)
+{
+	const char * szName;
+	SQObjectPtr pFunction;
+	sq_getstring(pVM, 2, &szName);
+	pFunction = stack_get(pVM, 3);
+
+	sq_pushbool(pVM, g_pCommandManager->Add(szName, new CSquirrelEventHandler(pVM, pFunction)));
+	return 1;
+}
+
+// removeCommandHandler(name, [function])
+SQInteger CCommandNatives::Remove(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("removeCommandHandler", 1, 2);
+	CHECK_TYPE("removeCommandHandler", 1, 2, OT_STRING);
+
+	const char * szName;
+	sq_getstring(pVM, 2, &szName);
+
+	// Without a function all handlers of the script for the command are removed
+	if(sq_gettop(pVM) < 3)
+	{
+		sq_pushbool(pVM, g_pCommandManager->Remove(szName, pVM));
+		return 1;
+	}
+
+	CHECK_TYPE("removeCommandHandler", 2, 3, OT_CLOSURE);
+	CSquirrelEventHandler handler(pVM, stack_get(pVM, 3));
+	sq_pushbool(pVM, g_pCommandManager->Remove(szName, &handler));
+	return 1;
+}
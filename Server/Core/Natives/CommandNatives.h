@@ -0,0 +1,22 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CommandNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CCommandNatives
+{
+private:
+	static SQInteger Add(SQVM * pVM);
+	static SQInteger Remove(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
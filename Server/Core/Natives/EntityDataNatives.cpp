@@ -0,0 +1,183 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: EntityDataNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "../CEntityDataManager.h"
+#include "../CPlayerManager.h"
+#include "../CVehicleManager.h"
+#include "../CObjectManager.h"
+
+extern CEntityDataManager * g_pEntityDataManager;
+extern CPlayerManager     * g_pPlayerManager;
+extern CVehicleManager    * g_pVehicleManager;
+extern CObjectManager     * g_pObjectManager;
+
+// Entity data functions
+
+void CEntityDataNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterConstant("ENTITY_DATA_SCOPE_SERVER", ENTITY_DATA_SCOPE_SERVER);
+	pScriptingManager->RegisterConstant("ENTITY_DATA_SCOPE_OWNER", ENTITY_DATA_SCOPE_OWNER);
+	pScriptingManager->RegisterConstant("ENTITY_DATA_SCOPE_STREAMED", ENTITY_DATA_SCOPE_STREAMED);
+	pScriptingManager->RegisterConstant("ENTITY_DATA_SCOPE_ALL", ENTITY_DATA_SCOPE_ALL);
+	pScriptingManager->RegisterFunction("setPlayerData", SetPlayerData, -1, NULL);
+	pScriptingManager->RegisterFunction("getPlayerData", GetPlayerData, 2, "is");
+	pScriptingManager->RegisterFunction("removePlayerData", RemovePlayerData, 2, "is");
+	pScriptingManager->RegisterFunction("setVehicleData", SetVehicleData, -1, NULL);
+	pScriptingManager->RegisterFunction("getVehicleData", GetVehicleData, 2, "is");
+	pScriptingManager->RegisterFunction("removeVehicleData", RemoveVehicleData, 2, "is");
+	pScriptingManager->RegisterFunction("setObjectData", SetObjectData, -1, NULL);
+	pScriptingManager->RegisterFunction("getObjectData", GetObjectData, 2, "is");
+	pScriptingManager->RegisterFunction("removeObjectData", RemoveObjectData, 2, "is");
+}
+
+bool CEntityDataNatives::DoesEntityExist(eEntityDataType type, EntityId entityId)
+{
+	switch(type)
+	{
+	case ENTITY_DATA_PLAYER:
+		return g_pPlayerManager->DoesExist(entityId);
+	case ENTITY_DATA_VEHICLE:
+		return g_pVehicleManager->DoesExist(entityId);
+	case ENTITY_DATA_OBJECT:
+		return g_pObjectManager->DoesExist(entityId);
+	}
+
+	return false;
+}
+
+// Sets the data of the entity, the parameter count and types were checked by the caller
+SQInteger CEntityDataNatives::Set(SQVM * pVM, eEntityDataType type)
+{
+	EntityId entityId;
+	const char * szKey;
+	SQInteger iScope = ENTITY_DATA_SCOPE_SERVER;
+	sq_getentity(pVM, 2, &entityId);
+	sq_getstring(pVM, 3, &szKey);
+
+	if(sq_gettop(pVM) >= 5)
+		sq_getinteger(pVM, 5, &iScope);
+
+	CSquirrelArgument value;
+
+	if(!DoesEntityExist(type, entityId) || !value.pushFromStack(pVM, 4))
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, g_pEntityDataManager->Set(type, entityId, szKey, value, (eEntityDataScope)iScope));
+	return 1;
+}
+
+// Pushes the data of the entity or null if it has none with the key
+SQInteger CEntityDataNatives::Get(SQVM * pVM, eEntityDataType type)
+{
+	EntityId entityId;
+	const char * szKey;
+	sq_getentity(pVM, -2, &entityId);
+	sq_getstring(pVM, -1, &szKey);
+
+	EntityDataValue * pValue = g_pEntityDataManager->Get(type, entityId, szKey);
+
+	if(!pValue)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	pValue->value.push(pVM);
+	return 1;
+}
+
+SQInteger CEntityDataNatives::Remove(SQVM * pVM, eEntityDataType type)
+{
+	EntityId entityId;
+	const char * szKey;
+	sq_getentity(pVM, -2, &entityId);
+	sq_getstring(pVM, -1, &szKey);
+	sq_pushbool(pVM, g_pEntityDataManager->Remove(type, entityId, szKey));
+	return 1;
+}
+
+// setPlayerData(playerid, key, value, [scope])
+SQInteger CEntityDataNatives::SetPlayerData(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("setPlayerData", 3, 4);
+	CHECK_TYPE("setPlayerData", 1, 2, OT_INTEGER);
+	CHECK_TYPE("setPlayerData", 2, 3, OT_STRING);
+
+	if(sq_gettop(pVM) >= 5)
+		CHECK_TYPE("setPlayerData", 4, 5, OT_INTEGER);
+
+	return Set(pVM, ENTITY_DATA_PLAYER);
+}
+
+// getPlayerData(playerid, key)
+SQInteger CEntityDataNatives::GetPlayerData(SQVM * pVM)
+{
+	return Get(pVM, ENTITY_DATA_PLAYER);
+}
+
+// removePlayerData(playerid, key)
+SQInteger CEntityDataNatives::RemovePlayerData(SQVM * pVM)
+{
+	return Remove(pVM, ENTITY_DATA_PLAYER);
+}
+
+// setVehicleData(vehicleid, key, value, [scope])
+SQInteger CEntityDataNatives::SetVehicleData(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("setVehicleData", 3, 4);
+	CHECK_TYPE("setVehicleData", 1, 2, OT_INTEGER);
+	CHECK_TYPE("setVehicleData", 2, 3, OT_STRING);
+
+	if(sq_gettop(pVM) >= 5)
+		CHECK_TYPE("setVehicleData", 4, 5, OT_INTEGER);
+
+	return Set(pVM, ENTITY_DATA_VEHICLE);
+}
+
+// getVehicleData(vehicleid, key)
+SQInteger CEntityDataNatives::GetVehicleData(SQVM * pVM)
+{
+	return Get(pVM, ENTITY_DATA_VEHICLE);
+}
+
+// removeVehicleData(vehicleid, key)
+SQInteger CEntityDataNatives::RemoveVehicleData(SQVM * pVM)
+{
+	return Remove(pVM, ENTITY_DATA_VEHICLE);
+}
+
+// setObjectData(objectid, key, value, [scope])
+SQInteger CEntityDataNatives::SetObjectData(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("setObjectData", 3, 4);
+	CHECK_TYPE("setObjectData", 1, 2, OT_INTEGER);
+	CHECK_TYPE("setObjectData", 2, 3, OT_STRING);
+
+	if(sq_gettop(pVM) >= 5)
+		CHECK_TYPE("setObjectData", 4, 5, OT_INTEGER);
+
+	return Set(pVM, ENTITY_DATA_OBJECT);
+}
+
+// getObjectData(objectid, key)
+SQInteger CEntityDataNatives::GetObjectData(SQVM * pVM)
+{
+	return Get(pVM, ENTITY_DATA_OBJECT);
+}
+
+// removeObjectData(objectid, key)
+SQInteger CEntityDataNatives::RemoveObjectData(SQVM * pVM)
+{
+	return Remove(pVM, ENTITY_DATA_OBJECT);
+}
@@ -0,0 +1,34 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: EntityDataNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+#include <Network/EntityData.h>
+
+class CEntityDataNatives
+{
+private:
+	static bool      DoesEntityExist(eEntityDataType type, EntityId entityId);
+	static SQInteger Set(SQVM * pVM, eEntityDataType type);
+	static SQInteger Get(SQVM * pVM, eEntityDataType type);
+	static SQInteger Remove(SQVM * pVM, eEntityDataType type);
+	static SQInteger SetPlayerData(SQVM * pVM);
+	static SQInteger GetPlayerData(SQVM * pVM);
+	static SQInteger RemovePlayerData(SQVM * pVM);
+	static SQInteger SetVehicleData(SQVM * pVM);
+	static SQInteger GetVehicleData(SQVM * pVM);
+	static SQInteger RemoveVehicleData(SQVM * pVM);
+	static SQInteger SetObjectData(SQVM * pVM);
+	static SQInteger GetObjectData(SQVM * pVM);
+	static SQInteger RemoveObjectData(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
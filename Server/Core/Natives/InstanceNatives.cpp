@@ -0,0 +1,113 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: InstanceNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "../CInstanceManager.h"
+
+extern CInstanceManager * g_pInstanceManager;
+
+// Instance functions
+
+void CInstanceNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("getInstances", GetInstances, 0, NULL);
+	pScriptingManager->RegisterFunction("getInstanceDimension", GetDimension, 1, "s");
+	pScriptingManager->RegisterFunction("getScriptInstance", GetScriptInstance, 0, NULL);
+	pScriptingManager->RegisterFunction("setPlayerInstance", SetPlayerInstance, 2, "is");
+	pScriptingManager->RegisterFunction("getPlayerInstance", GetPlayerInstance, 1, "i");
+}
+
+// getInstances()
+SQInteger CInstanceNatives::GetInstances(SQVM * pVM)
+{
+	std::list<ServerInstance *> * pInstances = g_pInstanceManager->GetInstances();
+	sq_newarray(pVM, 0);
+
+	for(std::list<ServerInstance *>::iterator iter = pInstances->begin(); iter != pInstances->end(); iter++)
+	{
+		sq_pushstring(pVM, (*iter)->strName.Get(), -1);
+		sq_arrayappend(pVM, -2);
+	}
+
+	return 1;
+}
+
+// getInstanceDimension(name)
+SQInteger CInstanceNatives::GetDimension(SQVM * pVM)
+{
+	const char * szName;
+	sq_getstring(pVM, -1, &szName);
+	ServerInstance * pInstance = g_pInstanceManager->Get(szName);
+
+	if(pInstance)
+	{
+		sq_pushinteger(pVM, pInstance->ucDimension);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// getScriptInstance()
+SQInteger CInstanceNatives::GetScriptInstance(SQVM * pVM)
+{
+	ServerInstance * pInstance = g_pInstanceManager->GetScriptInstance(pVM);
+
+	if(pInstance)
+	{
+		sq_pushstring(pVM, pInstance->strName.Get(), -1);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// setPlayerInstance(playerid, name) ("" for no instance)
+SQInteger CInstanceNatives::SetPlayerInstance(SQVM * pVM)
+{
+	EntityId playerId;
+	const char * szName;
+	sq_getentity(pVM, -2, &playerId);
+	sq_getstring(pVM, -1, &szName);
+	ServerInstance * pInstance = NULL;
+
+	if(szName[0] != '\0')
+	{
+		pInstance = g_pInstanceManager->Get(szName);
+
+		if(!pInstance)
+		{
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+	}
+
+	sq_pushbool(pVM, g_pInstanceManager->SetPlayerInstance(playerId, pInstance));
+	return 1;
+}
+
+// getPlayerInstance(playerid)
+SQInteger CInstanceNatives::GetPlayerInstance(SQVM * pVM)
+{
+	EntityId playerId;
+	sq_getentity(pVM, -1, &playerId);
+	ServerInstance * pInstance = g_pInstanceManager->GetPlayerInstance(playerId);
+
+	if(pInstance)
+	{
+		sq_pushstring(pVM, pInstance->strName.Get(), -1);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
@@ -0,0 +1,25 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: InstanceNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CInstanceNatives
+{
+private:
+	static SQInteger GetInstances(SQVM * pVM);
+	static SQInteger GetDimension(SQVM * pVM);
+	static SQInteger GetScriptInstance(SQVM * pVM);
+	static SQInteger SetPlayerInstance(SQVM * pVM);
+	static SQInteger GetPlayerInstance(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
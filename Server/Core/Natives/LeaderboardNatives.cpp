@@ -0,0 +1,323 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: LeaderboardNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "../CLeaderboard.h"
+
+// Leaderboard functions
+_BEGIN_CLASS(leaderboard)
+_MEMBER_FUNCTION(leaderboard, constructor, -1, NULL)
+_MEMBER_FUNCTION(leaderboard, set, 2, "in")
+_MEMBER_FUNCTION(leaderboard, add, 2, "in")
+_MEMBER_FUNCTION(leaderboard, remove, 1, "i")
+_MEMBER_FUNCTION(leaderboard, clear, 0, NULL)
+_MEMBER_FUNCTION(leaderboard, getScore, 1, "i")
+_MEMBER_FUNCTION(leaderboard, getRank, 1, "i")
+_MEMBER_FUNCTION(leaderboard, getRange, -1, NULL)
+_MEMBER_FUNCTION(leaderboard, getTop, -1, NULL)
+_MEMBER_FUNCTION(leaderboard, getSize, 0, NULL)
+_MEMBER_FUNCTION(leaderboard, replicate, 2, "si")
+_END_CLASS(leaderboard)
+
+void RegisterLeaderboardNatives(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterClass(&_CLASS_DECL(leaderboard));
+}
+
+static void sq_pushscore(SQVM * pVM, const LeaderboardEntry * pEntry)
+{
+	if(pEntry->bInteger)
+		sq_pushinteger(pVM, (SQInteger)pEntry->dScore);
+	else
+		sq_pushfloat(pVM, (SQFloat)pEntry->dScore);
+}
+
+static double sq_getscore(SQVM * pVM, SQInteger idx, bool * pbInteger)
+{
+	if(sq_gettype(pVM, idx) == OT_INTEGER)
+	{
+		SQInteger iScore;
+		sq_getinteger(pVM, idx, &iScore);
+		*pbInteger = true;
+		return (double)iScore;
+	}
+
+	SQFloat fScore;
+	sq_getfloat(pVM, idx, &fScore);
+	*pbInteger = false;
+	return (double)fScore;
+}
+
+// Pushes the member and score pairs from a rank on as a flat array, the array at
+// iResultIndex (if there is one) is filled instead of a new one
+static SQInteger sq_pushleaderboardrange(SQVM * pVM, CLeaderboard * pLeaderboard, SQInteger iFirstRank, SQInteger iCount, int iResultIndex)
+{
+	std::vector<const LeaderboardEntry *> entries;
+
+	if(iFirstRank > 0 && iCount > 0)
+		pLeaderboard->GetRange((unsigned int)iFirstRank, (unsigned int)iCount, entries);
+
+	if(iResultIndex <= sq_gettop(pVM))
+	{
+		if(sq_gettype(pVM, iResultIndex) != OT_ARRAY)
+			return sq_throwerror(pVM, "the result must be an array");
+
+		sq_push(pVM, iResultIndex);
+	}
+	else
+		sq_newarray(pVM, 0);
+
+	sq_arrayresize(pVM, -1, (SQInteger)(entries.size() * 2));
+
+	for(unsigned int i = 0; i < entries.size(); i++)
+	{
+		sq_pushinteger(pVM, (i * 2));
+		sq_pushinteger(pVM, entries[i]->iMember);
+		sq_set(pVM, -3);
+		sq_pushinteger(pVM, ((i * 2) + 1));
+		sq_pushscore(pVM, entries[i]);
+		sq_set(pVM, -3);
+	}
+
+	return 1;
+}
+
+// The members are integers (usually player ids) ranked by their score:
+//
+// local kills = leaderboard();
+// kills.replicate("killsrank", 10);
+// kills.add(killerid, 1);
+// local top = kills.getTop(10); // [member, score, member, score, ...]
+
+_MEMBER_FUNCTION_RELEASE_HOOK(leaderboard)
+{
+	CLeaderboard * pLeaderboard = (CLeaderboard *)pInst;
+	delete pLeaderboard;
+	return 1;
+}
+
+// leaderboard([descending = true])
+// A descending board ranks the highest score first (kills), an ascending one the lowest (lap times)
+_MEMBER_FUNCTION_IMPL(leaderboard, constructor)
+{
+	CHECK_PARAMS_MIN_MAX("leaderboard", 0, 1);
+
+	SQBool bDescending = true;
+
+	if(sq_gettop(pVM) >= 2)
+	{
+		CHECK_TYPE("leaderboard", 1, 2, OT_BOOL);
+		sq_getbool(pVM, 2, &bDescending);
+	}
+
+	CLeaderboard * pLeaderboard = new CLeaderboard(bDescending != 0);
+
+	if(SQ_FAILED(sq_setinstance(pVM, pLeaderboard)))
+	{
+		CLogFile::Print("Failed to create the leaderboard.");
+		SAFE_DELETE(pLeaderboard);
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	_SET_RELEASE_HOOK(leaderboard);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// set(member, score)
+// Returns the new rank of the member, starting at 1
+_MEMBER_FUNCTION_IMPL(leaderboard, set)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+
+	if(!pLeaderboard)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger iMember;
+	bool bInteger;
+	sq_getinteger(pVM, 2, &iMember);
+	double dScore = sq_getscore(pVM, 3, &bInteger);
+	sq_pushinteger(pVM, pLeaderboard->Set(iMember, dScore, bInteger));
+	return 1;
+}
+
+// add(member, amount)
+// Adds to the score of the member (0 if it isn't on the board) and returns the new score
+_MEMBER_FUNCTION_IMPL(leaderboard, add)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+
+	if(!pLeaderboard)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger iMember;
+	bool bInteger;
+	sq_getinteger(pVM, 2, &iMember);
+	double dAmount = sq_getscore(pVM, 3, &bInteger);
+	const LeaderboardEntry * pEntry = pLeaderboard->Get(iMember);
+
+	if(pEntry)
+	{
+		dAmount += pEntry->dScore;
+		bInteger = (bInteger && pEntry->bInteger);
+	}
+
+	pLeaderboard->Set(iMember, dAmount, bInteger);
+	sq_pushscore(pVM, pLeaderboard->Get(iMember));
+	return 1;
+}
+
+// remove(member)
+_MEMBER_FUNCTION_IMPL(leaderboard, remove)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+
+	if(!pLeaderboard)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger iMember;
+	sq_getinteger(pVM, 2, &iMember);
+	sq_pushbool(pVM, pLeaderboard->Remove(iMember));
+	return 1;
+}
+
+// clear()
+_MEMBER_FUNCTION_IMPL(leaderboard, clear)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+
+	if(!pLeaderboard)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pLeaderboard->Clear();
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// getScore(member)
+// Returns null if the member isn't on the board
+_MEMBER_FUNCTION_IMPL(leaderboard, getScore)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+	SQInteger iMember;
+	sq_getinteger(pVM, 2, &iMember);
+	const LeaderboardEntry * pEntry = (pLeaderboard ? pLeaderboard->Get(iMember) : NULL);
+
+	if(!pEntry)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	sq_pushscore(pVM, pEntry);
+	return 1;
+}
+
+// getRank(member)
+// Returns the rank starting at 1, null if the member isn't on the board
+_MEMBER_FUNCTION_IMPL(leaderboard, getRank)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+	SQInteger iMember;
+	sq_getinteger(pVM, 2, &iMember);
+	unsigned int uiRank = (pLeaderboard ? pLeaderboard->GetRank(iMember) : 0);
+
+	if(uiRank == 0)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, uiRank);
+	return 1;
+}
+
+// getRange(firstrank, count, [result])
+_MEMBER_FUNCTION_IMPL(leaderboard, getRange)
+{
+	CHECK_PARAMS_MIN_MAX("getRange", 2, 3);
+	CHECK_TYPE("getRange", 1, 2, OT_INTEGER);
+	CHECK_TYPE("getRange", 2, 3, OT_INTEGER);
+
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+
+	if(!pLeaderboard)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger iFirstRank, iCount;
+	sq_getinteger(pVM, 2, &iFirstRank);
+	sq_getinteger(pVM, 3, &iCount);
+	return sq_pushleaderboardrange(pVM, pLeaderboard, iFirstRank, iCount, 4);
+}
+
+// getTop(count, [result])
+_MEMBER_FUNCTION_IMPL(leaderboard, getTop)
+{
+	CHECK_PARAMS_MIN_MAX("getTop", 1, 2);
+	CHECK_TYPE("getTop", 1, 2, OT_INTEGER);
+
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+
+	if(!pLeaderboard)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger iCount;
+	sq_getinteger(pVM, 2, &iCount);
+	return sq_pushleaderboardrange(pVM, pLeaderboard, 1, iCount, 3);
+}
+
+// getSize()
+_MEMBER_FUNCTION_IMPL(leaderboard, getSize)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+	sq_pushinteger(pVM, (pLeaderboard ? pLeaderboard->GetSize() : 0));
+	return 1;
+}
+
+// replicate(key, count)
+// Sets the player data key (scope all) of the members in the top count to [rank, score] so
+// clients can show the top of the board, an empty key stops it and removes the keys again
+_MEMBER_FUNCTION_IMPL(leaderboard, replicate)
+{
+	CLeaderboard * pLeaderboard = sq_getinstance<CLeaderboard *>(pVM);
+	const char * szKey;
+	SQInteger iCount;
+	sq_getstring(pVM, 2, &szKey);
+	sq_getinteger(pVM, 3, &iCount);
+
+	if(!pLeaderboard || iCount < 0)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pLeaderboard->SetReplication(szKey, (unsigned int)iCount);
+	sq_pushbool(pVM, true);
+	return 1;
+}
@@ -0,0 +1,26 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: LeaderboardNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+void RegisterLeaderboardNatives(CScriptingManager * pScriptingManager);
+
+_MEMBER_FUNCTION_IMPL(leaderboard, constructor);
+_MEMBER_FUNCTION_IMPL(leaderboard, set);
+_MEMBER_FUNCTION_IMPL(leaderboard, add);
+_MEMBER_FUNCTION_IMPL(leaderboard, remove);
+_MEMBER_FUNCTION_IMPL(leaderboard, clear);
+_MEMBER_FUNCTION_IMPL(leaderboard, getScore);
+_MEMBER_FUNCTION_IMPL(leaderboard, getRank);
+_MEMBER_FUNCTION_IMPL(leaderboard, getRange);
+_MEMBER_FUNCTION_IMPL(leaderboard, getTop);
+_MEMBER_FUNCTION_IMPL(leaderboard, getSize);
+_MEMBER_FUNCTION_IMPL(leaderboard, replicate);
@@ -0,0 +1,70 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: MessageBusNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include "Scripting/CScriptingManager.h"
+#include "CEvents.h"
+#include "../CMessageBus.h"
+
+extern CMessageBus * g_pMessageBus;
+extern CEvents * g_pEvents;
+
+// Message bus functions
+
+void CMessageBusNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("publish", Publish, 2, "ss");
+	pScriptingManager->RegisterFunction("subscribe", Subscribe, 2, "sc");
+	pScriptingManager->RegisterFunction("unsubscribe", Unsubscribe, 2, "sc");
+}
+
+// publish(channel, data)
+SQInteger CMessageBusNatives::Publish(SQVM * pVM)
+{
+	const char * szChannel;
+	const char * szData;
+	sq_getstring(pVM, 2, &szChannel);
+	sq_getstring(pVM, 3, &szData);
+	SQInteger iChannelLength = sq_getsize(pVM, 2);
+	SQInteger iDataLength = sq_getsize(pVM, 3);
+
+	if(iChannelLength == 0 || iChannelLength > MESSAGE_BUS_MAX_CHANNEL_LENGTH || iDataLength > MESSAGE_BUS_MAX_DATA_LENGTH)
+		return sq_throwerror(pVM, "invalid channel or data too long");
+
+	// The data can be binary
+	String strData;
+	strData.Set(szData, (unsigned int)iDataLength);
+	sq_pushinteger(pVM, g_pMessageBus->Publish(szChannel, strData));
+	return 1;
+}
+
+// subscribe(channel, function)
+SQInteger CMessageBusNatives::Subscribe(SQVM * pVM)
+{
+	const char * szChannel;
+	sq_getstring(pVM, 2, &szChannel);
+	SQObjectPtr pFunction = stack_get(pVM, 3);
+
+	sq_pushbool(pVM, g_pEvents->Add(CMessageBus::GetEventName(szChannel), new CSquirrelEventHandler(pVM, pFunction)));
+	return 1;
+}
+
+// unsubscribe(channel, function)
+SQInteger CMessageBusNatives::Unsubscribe(SQVM * pVM)
+{
+	const char * szChannel;
+	sq_getstring(pVM, 2, &szChannel);
+	SQObjectPtr pFunction = stack_get(pVM, 3);
+	CSquirrelEventHandler handler(pVM, pFunction);
+
+	sq_pushbool(pVM, g_pEvents->Remove(CMessageBus::GetEventName(szChannel), &handler));
+	return 1;
+}
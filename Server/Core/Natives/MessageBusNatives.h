@@ -0,0 +1,23 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: MessageBusNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CMessageBusNatives
+{
+private:
+	static SQInteger Publish(SQVM * pVM);
+	static SQInteger Subscribe(SQVM * pVM);
+	static SQInteger Unsubscribe(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
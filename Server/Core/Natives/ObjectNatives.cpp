@@ -20,6 +20,7 @@ extern CNetworkManager * g_pNetworkManager;
 void CObjectNatives::Register(CScriptingManager * pScriptingManager)
 {
 	pScriptingManager->RegisterFunction("createObject", Create, 7, "iffffff");
+	pScriptingManager->RegisterFunction("createObjects", CreateBatch, 1, "a");
 	pScriptingManager->RegisterFunction("deleteObject", Delete, 1, "i");
 	pScriptingManager->RegisterFunction("getObjectModel", GetModel, 1, "i");
 	pScriptingManager->RegisterFunction("setObjectCoordinates", SetCoordinates, 4, "ifff");
@@ -36,9 +37,17 @@ void CObjectNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("attachObjectToVehicle", AttachVehicle, 8, "iiffffff");
 	pScriptingManager->RegisterFunction("detachObject", DetachObject, 1, "i");
 	pScriptingManager->RegisterFunction("moveObject", MoveObject, -1, NULL);
-	pScriptingManager->RegisterFunction("rotateObject", RotateObject, 5, "iffff");
+	pScriptingManager->RegisterFunction("rotateObject", RotateObject, -1, NULL);
+	pScriptingManager->RegisterFunction("moveObjectPath", MoveObjectPath, -1, NULL);
+	pScriptingManager->RegisterFunction("stopObject", StopObject, 1, "i");
+	pScriptingManager->RegisterFunction("isObjectMoving", IsMoving, 1, "i");
 	pScriptingManager->RegisterFunction("setObjectDimension", SetDimension, 2, "ii");
 	pScriptingManager->RegisterFunction("getObjectDimension", GetDimension, 1, "i");
+
+	pScriptingManager->RegisterConstant("MOVE_EASING_LINEAR", MOVE_EASING_LINEAR);
+	pScriptingManager->RegisterConstant("MOVE_EASING_IN", MOVE_EASING_IN);
+	pScriptingManager->RegisterConstant("MOVE_EASING_OUT", MOVE_EASING_OUT);
+	pScriptingManager->RegisterConstant("MOVE_EASING_IN_OUT", MOVE_EASING_IN_OUT);
 }
 
 // createObject(modelhash, x, y, z, rx, ry, rz)
@@ -54,6 +63,57 @@ SQInteger CObjectNatives::Create(SQVM * pVM)
 	return 1;
 }
 
+// createObjects([[modelhash, x, y, z, rx, ry, rz], ...])
+// The objects get contiguous ids, returns the id of the first one
+SQInteger CObjectNatives::CreateBatch(SQVM * pVM)
+{
+	SQInteger iCount = sq_getsize(pVM, 2);
+
+	if(iCount <= 0 || iCount > MAX_OBJECTS)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	std::vector<DWORD> modelHashes(iCount);
+	std::vector<CVector3> positions(iCount);
+	std::vector<CVector3> rotations(iCount);
+
+	for(SQInteger i = 0; i < iCount; i++)
+	{
+		if(SQ_FAILED(sq_pusharrayelement(pVM, 2, i)))
+		{
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		SQInteger modelhash;
+		bool bValid = (sq_gettype(pVM, -1) == OT_ARRAY && SQ_SUCCEEDED(sq_getarrayinteger(pVM, -1, 0, &modelhash)) &&
+			SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 1, &positions[i])) && SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 4, &rotations[i])));
+		sq_pop(pVM, 1);
+
+		if(!bValid)
+		{
+			CLogFile::Printf("Invalid object %d for function createObjects.", i);
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		modelHashes[i] = (DWORD)modelhash;
+	}
+
+	EntityId objectId = g_pObjectManager->CreateBatch(iCount, &modelHashes[0], &positions[0], &rotations[0]);
+
+	if(objectId == INVALID_ENTITY_ID)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushentity(pVM, objectId);
+	return 1;
+}
+
 // deleteObject(objectid)
 SQInteger CObjectNatives::Delete(SQVM * pVM)
 {
@@ -300,13 +360,16 @@ SQInteger CObjectNatives::DetachObject(SQVM *pVM)
 	return 1;
 }
 
+// moveObject(objectid, x, y, z, time, [rx, ry, rz, [easing]])
+// The time is in ms
 SQInteger CObjectNatives::MoveObject(SQVM * pVM)
 {
 	EntityId objectId;
 	CVector3 vecMoveTarget;
 	CVector3 vecMoveRot;
 	float fSpeed;
-	if(sq_gettop(pVM) >= 5) {
+	SQInteger iEasing = MOVE_EASING_LINEAR;
+	if(sq_gettop(pVM) >= 6) {
 		sq_getentity(pVM, 2, &objectId);
 		sq_getfloat(pVM, 3, &vecMoveTarget.fX);
 		sq_getfloat(pVM, 4, &vecMoveTarget.fY);
@@ -317,16 +380,19 @@ SQInteger CObjectNatives::MoveObject(SQVM * pVM)
 			g_pObjectManager->GetRotation(objectId, vecMoveRot);
 		}
 
-		if(sq_gettop(pVM) > 5)
+		if(sq_gettop(pVM) >= 9)
 		{
 			sq_getfloat(pVM, 7, &vecMoveRot.fX);
 			sq_getfloat(pVM, 8, &vecMoveRot.fY);
 			sq_getfloat(pVM, 9, &vecMoveRot.fZ);
 		}
 
-		if(g_pObjectManager->DoesExist(objectId))
+		if(sq_gettop(pVM) >= 10)
+			sq_getinteger(pVM, 10, &iEasing);
+
+		if(g_pObjectManager->DoesExist(objectId) && iEasing >= 0 && iEasing < MOVE_EASING_MAX)
 		{
-			g_pObjectManager->MoveObject(objectId, vecMoveTarget, vecMoveRot, fSpeed);
+			g_pObjectManager->MoveObject(objectId, vecMoveTarget, vecMoveRot, fSpeed, (eMoveEasing)iEasing);
 			sq_pushbool(pVM, true);
 			return 1;
 		}
@@ -335,26 +401,128 @@ SQInteger CObjectNatives::MoveObject(SQVM * pVM)
 	return 1;
 }
 
+// rotateObject(objectid, rx, ry, rz, time, [easing])
 SQInteger CObjectNatives::RotateObject(SQVM * pVM)
 {
+	CHECK_PARAMS_MIN_MAX("rotateObject", 5, 6);
+	CHECK_TYPE("rotateObject", 1, 2, OT_INTEGER);
+	CHECK_TYPE("rotateObject", 2, 3, OT_FLOAT);
+	CHECK_TYPE("rotateObject", 3, 4, OT_FLOAT);
+	CHECK_TYPE("rotateObject", 4, 5, OT_FLOAT);
+	CHECK_TYPE("rotateObject", 5, 6, OT_FLOAT);
+
 	EntityId objectId;
 	CVector3 vecMoveRot;
 	float fSpeed;
-	sq_getentity(pVM, -5, &objectId);
-	sq_getfloat(pVM, -4, &vecMoveRot.fX);
-	sq_getfloat(pVM, -3, &vecMoveRot.fY);
-	sq_getfloat(pVM, -2, &vecMoveRot.fZ);
-	sq_getfloat(pVM, -1, &fSpeed);
-	if(g_pObjectManager->DoesExist(objectId))
+	SQInteger iEasing = MOVE_EASING_LINEAR;
+	sq_getentity(pVM, 2, &objectId);
+	sq_getvector3(pVM, 3, &vecMoveRot);
+	sq_getfloat(pVM, 6, &fSpeed);
+
+	if(sq_gettop(pVM) >= 7)
+	{
+		CHECK_TYPE("rotateObject", 6, 7, OT_INTEGER);
+		sq_getinteger(pVM, 7, &iEasing);
+	}
+
+	if(g_pObjectManager->DoesExist(objectId) && iEasing >= 0 && iEasing < MOVE_EASING_MAX)
+	{
+		g_pObjectManager->RotateObject(objectId, vecMoveRot, fSpeed, (eMoveEasing)iEasing);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// moveObjectPath(objectid, [[time, x, y, z, rx, ry, rz, [easing]], ...], [loop])
+// The times are in ms since the start of the path and must not go down, the
+// clients get the path once and move the object along it themselves
+SQInteger CObjectNatives::MoveObjectPath(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("moveObjectPath", 2, 3);
+	CHECK_TYPE("moveObjectPath", 1, 2, OT_INTEGER);
+	CHECK_TYPE("moveObjectPath", 2, 3, OT_ARRAY);
+
+	EntityId objectId;
+	sq_getentity(pVM, 2, &objectId);
+	SQInteger iCount = sq_getsize(pVM, 3);
+
+	if(!g_pObjectManager->DoesExist(objectId) || iCount <= 0 || iCount > MOVE_TIMELINE_MAX_KEYFRAMES)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	CMoveTimeline timeline;
+
+	if(sq_gettop(pVM) >= 4)
 	{
-		g_pObjectManager->RotateObject(objectId, vecMoveRot, fSpeed);
+		CHECK_TYPE("moveObjectPath", 3, 4, OT_BOOL);
+		SQBool bLoop = false;
+		sq_getbool(pVM, 4, &bLoop);
+		timeline.SetLoop(bLoop != 0);
+	}
+
+	for(SQInteger i = 0; i < iCount; i++)
+	{
+		if(SQ_FAILED(sq_pusharrayelement(pVM, 3, i)))
+		{
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		SQInteger iTime;
+		SQInteger iEasing = MOVE_EASING_LINEAR;
+		CVector3 vecPosition;
+		CVector3 vecRotation;
+		bool bValid = (sq_gettype(pVM, -1) == OT_ARRAY && SQ_SUCCEEDED(sq_getarrayinteger(pVM, -1, 0, &iTime)) &&
+			SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 1, &vecPosition)) && SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 4, &vecRotation)));
+
+		if(bValid && sq_getsize(pVM, -1) > 7)
+			bValid = SQ_SUCCEEDED(sq_getarrayinteger(pVM, -1, 7, &iEasing));
+
+		sq_pop(pVM, 1);
+
+		if(!bValid || iTime < 0 || iEasing < 0 || iEasing >= MOVE_EASING_MAX ||
+			!timeline.AddKeyframe((unsigned int)iTime, vecPosition, vecRotation, (eMoveEasing)iEasing))
+		{
+			CLogFile::Printf("Invalid keyframe %d for function moveObjectPath.", i);
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+	}
+
+	sq_pushbool(pVM, g_pObjectManager->SetTimeline(objectId, timeline));
+	return 1;
+}
+
+// stopObject(objectid)
+SQInteger CObjectNatives::StopObject(SQVM * pVM)
+{
+	EntityId objectId;
+	sq_getentity(pVM, -1, &objectId);
+
+	if(g_pObjectManager->IsMoving(objectId))
+	{
+		g_pObjectManager->StopMoving(objectId);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
+
 	sq_pushbool(pVM, false);
 	return 1;
 }
 
+// isObjectMoving(objectid)
+SQInteger CObjectNatives::IsMoving(SQVM * pVM)
+{
+	EntityId objectId;
+	sq_getentity(pVM, -1, &objectId);
+	sq_pushbool(pVM, g_pObjectManager->IsMoving(objectId));
+	return 1;
+}
+
 
 SQInteger CObjectNatives::SetDimension(SQVM * pVM)
 {
@@ -16,6 +16,7 @@ class CObjectNatives
 {
 private:
 	static SQInteger Create(SQVM * pVM);
+	static SQInteger CreateBatch(SQVM * pVM);
 	static SQInteger Delete(SQVM * pVM);
 	static SQInteger GetModel(SQVM * pVM);
 	static SQInteger GetCoordinates(SQVM * pVM);
@@ -31,6 +32,9 @@ private:
 	static SQInteger DetachObject(SQVM * pVM);
 	static SQInteger MoveObject(SQVM * pVM);
 	static SQInteger RotateObject(SQVM * pVM);
+	static SQInteger MoveObjectPath(SQVM * pVM);
+	static SQInteger StopObject(SQVM * pVM);
+	static SQInteger IsMoving(SQVM * pVM);
 	static SQInteger SetDimension(SQVM * pVM);
 	static SQInteger GetDimension(SQVM * pVM);
 
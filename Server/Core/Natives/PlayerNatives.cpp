@@ -12,38 +12,48 @@
 #include "../Natives.h"
 #include "Scripting/CScriptingManager.h"
 #include "Squirrel/sqstring.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include <Squirrel/sqarray.h>
 #include "../CVehicleManager.h"
 #include "../CPlayerManager.h"
 #include "../CNetworkManager.h"
 #include <Game/CTime.h>
 #include "CEvents.h"
+#include "../CBroadcastGroupManager.h"
+#include "../CSpatialIndex.h"
+#include "../CTransferManager.h"
 
 extern CPlayerManager * g_pPlayerManager;
 extern CVehicleManager * g_pVehicleManager;
 extern CNetworkManager * g_pNetworkManager;
 extern CTime * g_pTime;
 extern CEvents * g_pEvents;
+extern CTransferManager * g_pTransferManager;
+extern CBroadcastGroupManager * g_pBroadcastGroupManager;
+extern CSpatialIndex * g_pSpatialIndex;
+extern CScriptingManager * g_pScriptingManager;
 
 // Player functions
 
 void CPlayerNatives::Register(CScriptingManager * pScriptingManager)
 {
-	pScriptingManager->RegisterFunction("isPlayerConnected", IsConnected, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "isPlayerConnected", IsConnected);
 
 	pScriptingManager->RegisterFunction("getPlayerName", GetName, 1, "i");
 	pScriptingManager->RegisterFunction("setPlayerName", SetName, 2, "is");
 
-	pScriptingManager->RegisterFunction("setPlayerHealth", SetHealth, 2, "ii");
-	pScriptingManager->RegisterFunction("getPlayerHealth", GetHealth, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setPlayerHealth", SetHealth);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerHealth", GetHealth);
 
-	pScriptingManager->RegisterFunction("setPlayerArmour", SetArmour, 2, "ii");
-	pScriptingManager->RegisterFunction("getPlayerArmour", GetArmour, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setPlayerArmour", SetArmour);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerArmour", GetArmour);
 
-	pScriptingManager->RegisterFunction("setPlayerCoordinates", SetCoordinates, 4, "ifff");
-	pScriptingManager->RegisterFunction("getPlayerCoordinates", GetCoordinates, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setPlayerCoordinates", SetCoordinates);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerCoordinates", GetCoordinates);
 
-	pScriptingManager->RegisterFunction("setPlayerPosition", SetCoordinates, 4, "ifff");
-	pScriptingManager->RegisterFunction("getPlayerPosition", GetCoordinates, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setPlayerPosition", SetCoordinates);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerPosition", GetCoordinates);
 
 	// World stuffs
 	pScriptingManager->RegisterFunction("setPlayerTime", SetTime, 3, "iii");
@@ -52,26 +62,27 @@ void CPlayerNatives::Register(CScriptingManager * pScriptingManager)
 
 	pScriptingManager->RegisterFunction("sendPlayerMessage", SendMessage, -1, NULL);
 	pScriptingManager->RegisterFunction("sendMessageToAll", SendMessageToAll, -1, NULL);
-	pScriptingManager->RegisterFunction("isPlayerInAnyVehicle", IsInAnyVehicle, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "isPlayerInAnyVehicle", IsInAnyVehicle);
 	pScriptingManager->RegisterFunction("isPlayerInVehicle", IsInVehicle, 2, "ii");
-	pScriptingManager->RegisterFunction("getPlayerVehicleId", GetVehicleId, 1, "i");
-	pScriptingManager->RegisterFunction("getPlayerSeatId", GetSeatId, 1, "i");
-	pScriptingManager->RegisterFunction("isPlayerOnFoot", IsOnFoot, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerVehicleId", GetVehicleId);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerSeatId", GetSeatId);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "isPlayerOnFoot", IsOnFoot);
 	pScriptingManager->RegisterFunction("togglePlayerPayAndSpray", TogglePayAndSpray, 2, "ib");
 	pScriptingManager->RegisterFunction("togglePlayerAutoAim", ToggleAutoAim, 2, "ib");
 	//pScriptingManager->RegisterFunction("setPlayerDrunk", SetPlayerDrunk, 2, "ii");
 	pScriptingManager->RegisterFunction("givePlayerWeapon", GiveWeapon, 3, "iii");
 	pScriptingManager->RegisterFunction("removePlayerWeapons", RemoveWeapons, 1, "i");
 	pScriptingManager->RegisterFunction("setPlayerSpawnLocation", SetSpawnLocation, 5, "iffff");
-	pScriptingManager->RegisterFunction("setPlayerModel", SetModel, 2, "ii");
-	pScriptingManager->RegisterFunction("getPlayerModel", GetModel, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setPlayerModel", SetModel);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerModel", GetModel);
 	pScriptingManager->RegisterFunction("togglePlayerControls", ToggleControls, 2, "ib");
 	pScriptingManager->RegisterFunction("isPlayerSpawned", IsSpawned, 1, "i");
-	pScriptingManager->RegisterFunction("setPlayerHeading", SetHeading, 2, "if");
-	pScriptingManager->RegisterFunction("getPlayerHeading", GetHeading, 1, "1");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setPlayerHeading", SetHeading);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getPlayerHeading", GetHeading);
 	pScriptingManager->RegisterFunction("togglePlayerPhysics", TogglePhysics, 2, "ib");
 	pScriptingManager->RegisterFunction("kickPlayer", Kick, 2, "ib");
 	pScriptingManager->RegisterFunction("banPlayer", Ban, 2, "ii");
+	pScriptingManager->RegisterFunction("transferPlayer", Transfer, -1, NULL);
 	pScriptingManager->RegisterFunction("getPlayerIp", GetIp, 1, "i");
 	pScriptingManager->RegisterFunction("givePlayerMoney", GiveMoney, 2, "ii");
 	pScriptingManager->RegisterFunction("setPlayerMoney", SetMoney, 2, "ii");
@@ -109,6 +120,7 @@ void CPlayerNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("setPlayerColor", SetColor, 2, "ii");
 	pScriptingManager->RegisterFunction("getPlayerColor", GetColor, 1, "i");
 	pScriptingManager->RegisterFunction("getPlayerPing", GetPing, 1, "i");
+	pScriptingManager->RegisterFunction("getPlayerNetStats", GetNetStats, 1, "i");
 	pScriptingManager->RegisterFunction("givePlayerHelmet", GiveHelmet, 1, "i");
 	pScriptingManager->RegisterFunction("removePlayerHelmet", RemoveHelmet, 1, "i");
 	pScriptingManager->RegisterFunction("togglePlayerHelmet", ToggleHelmet, 2, "ib");
@@ -144,15 +156,43 @@ void CPlayerNatives::Register(CScriptingManager * pScriptingManager)
 	
 	pScriptingManager->RegisterFunction("setPlayerDimension", SetDimension, 2, "ii");
 	pScriptingManager->RegisterFunction("getPlayerDimension", GetDimension, 1, "i");
+
+	pScriptingManager->RegisterFunction("createBroadcastGroup", CreateBroadcastGroup, 0, NULL);
+	pScriptingManager->RegisterFunction("deleteBroadcastGroup", DeleteBroadcastGroup, 1, "i");
+	pScriptingManager->RegisterFunction("addPlayerToBroadcastGroup", AddToBroadcastGroup, 2, "ii");
+	pScriptingManager->RegisterFunction("removePlayerFromBroadcastGroup", RemoveFromBroadcastGroup, 2, "ii");
+	pScriptingManager->RegisterFunction("isPlayerInBroadcastGroup", IsInBroadcastGroup, 2, "ii");
+	pScriptingManager->RegisterFunction("getDimensionBroadcastGroup", GetDimensionBroadcastGroup, 1, "i");
+	pScriptingManager->RegisterFunction("sendMessageToBroadcastGroup", SendMessageToBroadcastGroup, -1, NULL);
+	pScriptingManager->RegisterFunction("triggerClientEventForBroadcastGroup", TriggerEventForBroadcastGroup, -1, NULL);
+	pScriptingManager->RegisterFunction("triggerClientEventForPlayers", TriggerEventForPlayers, -1, NULL);
+	pScriptingManager->RegisterFunction("triggerClientEventInRange", TriggerEventInRange, -1, NULL);
+
+	pScriptingManager->RegisterFunction("getPlayersData", GetPlayersData, -1, NULL);
+	pScriptingManager->RegisterFunction("getPlayerDataStride", GetPlayerDataStride, 1, "i");
+	pScriptingManager->RegisterConstant("PLAYER_DATA_NAME", PLAYER_DATA_NAME);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_PING", PLAYER_DATA_PING);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_HEALTH", PLAYER_DATA_HEALTH);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_ARMOUR", PLAYER_DATA_ARMOUR);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_COORDINATES", PLAYER_DATA_COORDINATES);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_VELOCITY", PLAYER_DATA_VELOCITY);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_HEADING", PLAYER_DATA_HEADING);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_MODEL", PLAYER_DATA_MODEL);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_MONEY", PLAYER_DATA_MONEY);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_WANTED_LEVEL", PLAYER_DATA_WANTED_LEVEL);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_WEAPON", PLAYER_DATA_WEAPON);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_VEHICLE", PLAYER_DATA_VEHICLE);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_STATE", PLAYER_DATA_STATE);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_DIMENSION", PLAYER_DATA_DIMENSION);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_COLOR", PLAYER_DATA_COLOR);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_SPAWNED", PLAYER_DATA_SPAWNED);
+	pScriptingManager->RegisterConstant("PLAYER_DATA_ALL", PLAYER_DATA_ALL);
 }
 
 // isPlayerConnected(playerid)
-SQInteger CPlayerNatives::IsConnected(SQVM * pVM)
+bool CPlayerNatives::IsConnected(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-	sq_pushbool(pVM, g_pPlayerManager->DoesExist(playerId));
-	return 1;
+	return g_pPlayerManager->DoesExist(playerId);
 }
 
 // getPlayerName(playerid)
@@ -165,7 +205,10 @@ SQInteger CPlayerNatives::GetName(SQVM * pVM)
 
 	if(pPlayer)
 	{
-		sq_pushstring(pVM, pPlayer->GetName(), -1);
+		// The name is kept by the script until it changes
+		if(!g_pScriptingManager->PushCachedString(pVM, pPlayer))
+			g_pScriptingManager->PushCachedString(pVM, pPlayer, pPlayer->GetName());
+
 		return 1;
 	}
 
@@ -285,126 +328,82 @@ SQInteger CPlayerNatives::SetWantedLevel(SQVM * pVM)
 }
 
 // setPlayerHealth(playerid, health)
-SQInteger CPlayerNatives::SetHealth(SQVM * pVM)
+bool CPlayerNatives::SetHealth(EntityId playerId, int iHealth)
 {
-	EntityId playerId;
-	SQInteger iHealth;
-	sq_getentity(pVM, -2, &playerId);
-	sq_getinteger(pVM, -1, &iHealth);
-
 	if(g_pPlayerManager->DoesExist(playerId))
 	{
 		CBitStream bsSend;
 		bsSend.Write(iHealth);
 		g_pNetworkManager->RPC(RPC_ScriptingSetPlayerHealth, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-		sq_pushbool(pVM, true);
-		return 1;
+		return true;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return false;
 }
 
 // getPlayerHealth(playerid)
-SQInteger CPlayerNatives::GetHealth(SQVM * pVM)
+NativeResult<int> CPlayerNatives::GetHealth(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer)
-	{
-		sq_pushinteger(pVM, (pPlayer->GetHealth() - 100));
-		return 1;
-	}
+		return (pPlayer->GetHealth() - 100);
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<int>();
 }
 
 // setPlayerArmour(playerid)
-SQInteger CPlayerNatives::SetArmour(SQVM * pVM)
+bool CPlayerNatives::SetArmour(EntityId playerId, int iArmour)
 {
-	EntityId playerId;
-	SQInteger iArmour;
-	sq_getentity(pVM, -2, &playerId);
-	sq_getinteger(pVM, -1, &iArmour);
-
 	if(g_pPlayerManager->DoesExist(playerId))
 	{
 		CBitStream bsSend;
 		bsSend.Write(iArmour);
 		g_pNetworkManager->RPC(RPC_ScriptingSetPlayerArmour, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-		sq_pushbool(pVM, true);
-		return 1;
+		return true;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return false;
 }
 
 // getPlayerArmour(playerid)
-SQInteger CPlayerNatives::GetArmour(SQVM * pVM)
+NativeResult<int> CPlayerNatives::GetArmour(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer)
-	{
-		sq_pushinteger(pVM, pPlayer->GetArmour());
-		return 1;
-	}
+		return (int)pPlayer->GetArmour();
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<int>();
 }
 
 // setPlayerCoordinates(playerid, x, y, z)
-SQInteger CPlayerNatives::SetCoordinates(SQVM * pVM)
+bool CPlayerNatives::SetCoordinates(EntityId playerId, CVector3 vecPos)
 {
-	EntityId playerId;
-	CVector3 vecPos;
-	sq_getentity(pVM, -4, &playerId);
-	sq_getvector3(pVM, -3, &vecPos);
-
 	if(g_pPlayerManager->DoesExist(playerId))
 	{
 		CBitStream bsSend;
 		bsSend.Write(vecPos);
 		g_pNetworkManager->RPC(RPC_ScriptingSetPlayerCoordinates, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-		sq_pushbool(pVM, true);
-		return 1;
+		return true;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return false;
 }
 
 // getPlayerCoordinates(playerid)
-SQInteger CPlayerNatives::GetCoordinates(SQVM * pVM)
+NativeResult<CVector3> CPlayerNatives::GetCoordinates(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer)
 	{
 		CVector3 vecPosition;
 		pPlayer->GetPosition(vecPosition);
-		CSquirrelArguments args;
-		args.push(vecPosition.fX);
-		args.push(vecPosition.fY);
-		args.push(vecPosition.fZ);
-		sq_pusharg(pVM, CSquirrelArgument(args, true));
-		return 1;
+		return vecPosition;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<CVector3>();
 }
 
 // setPlayerTime(playerid, hour, minute)
@@ -420,10 +419,7 @@ SQInteger CPlayerNatives::SetTime(SQVM * pVM)
 	if(g_pPlayerManager->DoesExist(playerId) && (iHour >= 0 && iHour < 24) && (iMinute >= 0 && iMinute < 60))
 	{
 		CBitStream bsSend;
-		bsSend.Write((unsigned char)iHour);
-		bsSend.Write((unsigned char)iMinute);
-		if(g_pTime->GetMinuteDuration() != CTime::DEFAULT_MINUTE_DURATION)
-			bsSend.Write(g_pTime->GetMinuteDuration());
+		CTime::WriteTime(&bsSend, g_pTime->GetDayOfWeek(), (unsigned char)iHour, (unsigned char)iMinute, g_pTime->GetMinuteDuration(), 0);
 
 		g_pNetworkManager->RPC(RPC_ScriptingSetPlayerTime, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
 		sq_pushbool(pVM, true);
@@ -526,7 +522,7 @@ SQInteger CPlayerNatives::SendMessage(SQVM * pVM)
 		bsSend.Write(String(szMessage));
 		bool bAllowFormatting = (sqbAllowFormatting != 0);
 		bsSend.Write(bAllowFormatting);
-		g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_CHAT);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -578,7 +574,7 @@ SQInteger CPlayerNatives::SendMessageToAll(SQVM * pVM)
 		bsSend.Write(String(szMessage));
 		bool bAllowFormatting = (sqbAllowFormatting != 0);
 		bsSend.Write(bAllowFormatting);
-		g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+		g_pNetworkManager->RPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_CHAT);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -588,21 +584,10 @@ SQInteger CPlayerNatives::SendMessageToAll(SQVM * pVM)
 }
 
 // isPlayerInAnyVehicle(playerid)
-SQInteger CPlayerNatives::IsInAnyVehicle(SQVM * pVM)
+bool CPlayerNatives::IsInAnyVehicle(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
-
-	if(pPlayer)
-	{
-		sq_pushbool(pVM, pPlayer->IsInVehicle());
-		return 1;
-	}
-
-	sq_pushbool(pVM, false);
-	return 1;
+	return (pPlayer && pPlayer->IsInVehicle());
 }
 
 // isPlayerInVehicle(playerid, vehicleid)
@@ -629,60 +614,32 @@ SQInteger CPlayerNatives::IsInVehicle(SQVM * pVM)
 }
 
 // getPlayerVehicleId(playerid)
-SQInteger CPlayerNatives::GetVehicleId(SQVM * pVM)
+NativeResult<int> CPlayerNatives::GetVehicleId(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
-	if(pPlayer)
-	{
-		if(pPlayer->IsInVehicle())
-		{
-			sq_pushinteger(pVM, pPlayer->GetVehicle()->GetVehicleId());
-			return 1;
-		}
-	}
+	if(pPlayer && pPlayer->IsInVehicle())
+		return (int)pPlayer->GetVehicle()->GetVehicleId();
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<int>();
 }
 
 // getPlayerSeatId(playerid)
-SQInteger CPlayerNatives::GetSeatId(SQVM * pVM)
+NativeResult<int> CPlayerNatives::GetSeatId(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer && pPlayer->IsInVehicle())
-	{
-		sq_pushinteger(pVM, pPlayer->GetVehicleSeatId());
-		return 1;
-	}
+		return (int)pPlayer->GetVehicleSeatId();
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<int>();
 }
 
 // isPlayerOnFoot(playerid)
-SQInteger CPlayerNatives::IsOnFoot(SQVM * pVM)
+bool CPlayerNatives::IsOnFoot(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
-
-	if(pPlayer)
-	{
-		sq_pushbool(pVM, pPlayer->IsOnFoot());
-		return 1;
-	}
-
-	sq_pushbool(pVM, false);
-	return 1;
+	return (pPlayer && pPlayer->IsOnFoot());
 }
 
 // togglePlayerPayAndSpray(playerid, toggle)
@@ -767,41 +724,25 @@ SQInteger CPlayerNatives::SetSpawnLocation(SQVM * pVM)
 }
 
 // setPlayerModel(playerid, model)
-SQInteger CPlayerNatives::SetModel(SQVM * pVM)
+bool CPlayerNatives::SetModel(EntityId playerId, int iModelId)
 {
-	EntityId playerId;
-	SQInteger iModelId;
-	sq_getentity(pVM, -2, &playerId);
-	sq_getinteger(pVM, -1, &iModelId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer)
-	{
-		sq_pushbool(pVM, pPlayer->SetModel(iModelId));
-		return 1;
-	}
+		return pPlayer->SetModel(iModelId);
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return false;
 }
 
 // getPlayerModel(playerid)
-SQInteger CPlayerNatives::GetModel(SQVM * pVM)
+NativeResult<int> CPlayerNatives::GetModel(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer)
-	{
-		sq_pushinteger(pVM, pPlayer->GetModel());
-		return 1;
-	}
+		return pPlayer->GetModel();
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<int>();
 }
 
 // togglePlayerControls(playerid, toggle)
@@ -845,42 +786,28 @@ SQInteger CPlayerNatives::IsSpawned(SQVM * pVM)
 }
 
 // setPlayerHeading(playerid, heading)
-SQInteger CPlayerNatives::SetHeading(SQVM * pVM)
+bool CPlayerNatives::SetHeading(EntityId playerId, float fHeading)
 {
-	EntityId playerId;
-	float fHeading;
-	sq_getentity(pVM, -2, &playerId);
-	sq_getfloat(pVM, -1, &fHeading);
-
 	if(g_pPlayerManager->DoesExist(playerId))
 	{
 		CBitStream bsSend;
 		bsSend.Write(fHeading);
 		g_pNetworkManager->RPC(RPC_ScriptingSetHeading, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
-		sq_pushbool(pVM, true);
-		return 1;
+		return true;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return false;
 }
 
 // getPlayerHeading(playerid)
-SQInteger CPlayerNatives::GetHeading(SQVM * pVM)
+NativeResult<float> CPlayerNatives::GetHeading(EntityId playerId)
 {
-	EntityId playerId;
-	sq_getentity(pVM, -1, &playerId);
-
 	CPlayer * pPlayer = g_pPlayerManager->GetAt(playerId);
 
 	if(pPlayer)
-	{
-		sq_pushfloat(pVM, pPlayer->GetCurrentHeading());
-		return 1;
-	}
+		return pPlayer->GetCurrentHeading();
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<float>();
 }
 
 // togglePlayerPhysics(playerid, toggle)
@@ -926,6 +853,46 @@ SQInteger CPlayerNatives::Kick(SQVM * pVM)
 	return 1;
 }
 
+// transferPlayer(playerid, host, port, [password, data])
+SQInteger CPlayerNatives::Transfer(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("transferPlayer", 3, 5);
+	CHECK_TYPE("transferPlayer", 1, 2, OT_INTEGER);
+	CHECK_TYPE("transferPlayer", 2, 3, OT_STRING);
+	CHECK_TYPE("transferPlayer", 3, 4, OT_INTEGER);
+
+	SQInteger iTop = sq_gettop(pVM);
+	EntityId playerId;
+	const char * szHost;
+	SQInteger iPort;
+	const char * szPassword = "";
+	const char * szData = "";
+	sq_getentity(pVM, 2, &playerId);
+	sq_getstring(pVM, 3, &szHost);
+	sq_getinteger(pVM, 4, &iPort);
+
+	if(iTop >= 5)
+	{
+		CHECK_TYPE("transferPlayer", 4, 5, OT_STRING);
+		sq_getstring(pVM, 5, &szPassword);
+	}
+
+	if(iTop >= 6)
+	{
+		CHECK_TYPE("transferPlayer", 5, 6, OT_STRING);
+		sq_getstring(pVM, 6, &szData);
+	}
+
+	if(iPort <= 0 || iPort > 65535)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, g_pTransferManager->Transfer(playerId, szHost, (unsigned short)iPort, szPassword, szData));
+	return 1;
+}
+
 // banPlayer(playerid, milliseconds)
 SQInteger CPlayerNatives::Ban(SQVM * pVM)
 {
@@ -1115,7 +1082,7 @@ SQInteger CPlayerNatives::DisplayText(SQVM * pVM)
 		bsSend.Write(fPos[1]);
 		bsSend.Write(String(szText));
 		bsSend.Write((int)iTime);
-		g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -1139,7 +1106,7 @@ SQInteger CPlayerNatives::DisplayTextForAll(SQVM * pVM)
 	bsSend.Write(fPos[1]);
 	bsSend.Write(String(szText));
 	bsSend.Write((int)iTime);
-	g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_GUI);
 	sq_pushbool(pVM, true);
 	return 1;
 }
@@ -1159,7 +1126,7 @@ SQInteger CPlayerNatives::DisplayInfoText(SQVM * pVM)
 		CBitStream bsSend;
 		bsSend.Write(String(szText));
 		bsSend.Write((int)iTime);
-		g_pNetworkManager->RPC(RPC_ScriptingDisplayInfoText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingDisplayInfoText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -1178,7 +1145,7 @@ SQInteger CPlayerNatives::DisplayInfoTextForAll(SQVM * pVM)
 	CBitStream bsSend;
 	bsSend.Write(String(szText));
 	bsSend.Write((int)iTime);
-	g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	g_pNetworkManager->RPC(RPC_ScriptingDisplayText, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true, PACKET_CHANNEL_GUI);
 	sq_pushbool(pVM, true);
 	return 1;
 }
@@ -1440,7 +1407,7 @@ SQInteger CPlayerNatives::ToggleHUD(SQVM * pVM)
 	{
 		CBitStream bsSend;
 		bsSend.Write(sqbToggle != 0);
-		g_pNetworkManager->RPC(RPC_ScriptingToggleHUD, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingToggleHUD, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -1462,7 +1429,7 @@ SQInteger CPlayerNatives::ToggleRadar(SQVM * pVM)
 		CBitStream bsSend;
 		bool bToggle = (sqbToggle != 0);
 		bsSend.Write(bToggle);
-		g_pNetworkManager->RPC(RPC_ScriptingToggleRadar, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingToggleRadar, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -1506,7 +1473,7 @@ SQInteger CPlayerNatives::ToggleAreaNames(SQVM * pVM)
 		CBitStream bsSend;
 		bool bToggle = (sqbToggle != 0);
 		bsSend.Write(bToggle);
-		g_pNetworkManager->RPC(RPC_ScriptingToggleAreaNames, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingToggleAreaNames, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -1780,13 +1747,19 @@ SQInteger CPlayerNatives::TriggerEvent(SQVM * pVM)
 	CHECK_TYPE("triggerClientEvent", 1, 2, OT_INTEGER);
 	CHECK_TYPE("triggerClientEvent", 2, 3, OT_STRING);
 
-	SQInteger playerId;
-	sq_getinteger(pVM, 2, &playerId);
-	CSquirrelArguments arguments(pVM, 3);
+	EntityId playerId;
+	sq_getentity(pVM, 2, &playerId);
+
+	if(!g_pPlayerManager->DoesExist(playerId))
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
 
-	CBitStream bsSend;
-	arguments.serialize(&bsSend);
-	g_pNetworkManager->RPC(RPC_ScriptingEventCall, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_SCRIPT);
+	const char * szEventName;
+	sq_getstring(pVM, 3, &szEventName);
+	CSquirrelArguments arguments(pVM, 4);
+	g_pNetworkManager->EventRPC(szEventName, &arguments, &playerId, 1);
 	sq_pushbool(pVM, true);
 	return 1;
 }
@@ -1846,6 +1819,64 @@ SQInteger CPlayerNatives::GetPing(SQVM* pVM)
 	return 1;
 }
 
+// Adds an integer slot to the table at the top of the stack
+static void PushNetStat(SQVM * pVM, const char * szName, NetStat_t ulValue)
+{
+	sq_pushstring(pVM, szName, -1);
+	sq_pushinteger(pVM, (SQInteger)ulValue);
+	sq_createslot(pVM, -3);
+}
+
+// getPlayerNetStats(playerid), the rates are in bytes per second over the last second
+SQInteger CPlayerNatives::GetNetStats(SQVM * pVM)
+{
+	EntityId playerId;
+	sq_getentity(pVM, 2, &playerId);
+
+	CNetStats * pNetStats = (g_pPlayerManager->DoesExist(playerId) ? g_pNetworkManager->GetNetServer()->GetPlayerNetStats(playerId) : NULL);
+
+	if(!pNetStats)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	unsigned int uiSendBufferMessages = 0;
+	double dSendBufferBytes = 0;
+
+	for(int i = 0; i < PRIORITY_COUNT; i++)
+	{
+		uiSendBufferMessages += pNetStats->uiMessageInSendBuffer[i];
+		dSendBufferBytes += pNetStats->dBytesInSendBuffer[i];
+	}
+
+	sq_newtable(pVM);
+	PushNetStat(pVM, "ping", g_pNetworkManager->GetNetServer()->GetPlayerAveragePing(playerId));
+	PushNetStat(pVM, "bytesout", pNetStats->ulValueOverLastSecond[ACTUAL_BYTES_SENT]);
+	PushNetStat(pVM, "bytesin", pNetStats->ulValueOverLastSecond[ACTUAL_BYTES_RECEIVED]);
+	PushNetStat(pVM, "bytesresent", pNetStats->ulValueOverLastSecond[USER_MESSAGE_BYTES_RESENT]);
+	PushNetStat(pVM, "totalbytesout", pNetStats->ulRunningTotal[ACTUAL_BYTES_SENT]);
+	PushNetStat(pVM, "totalbytesin", pNetStats->ulRunningTotal[ACTUAL_BYTES_RECEIVED]);
+	PushNetStat(pVM, "totalbytesresent", pNetStats->ulRunningTotal[USER_MESSAGE_BYTES_RESENT]);
+	PushNetStat(pVM, "sendbuffermessages", uiSendBufferMessages);
+	PushNetStat(pVM, "sendbufferbytes", (NetStat_t)dSendBufferBytes);
+	PushNetStat(pVM, "resendbuffermessages", pNetStats->uiMessagesInResendBuffer);
+	PushNetStat(pVM, "resendbufferbytes", pNetStats->ulBytesInResendBuffer);
+
+	// 0 if the send rate isn't limited
+	PushNetStat(pVM, "congestionlimit", (pNetStats->bIsLimitedByCongestionControl ? pNetStats->ulBPSLimitByCongestionControl : 0));
+	PushNetStat(pVM, "bandwidthlimit", (pNetStats->bIsLimitedByOutgoingBandwidthLimit ? pNetStats->ulBPSLimitByOutgoingBandwidthLimit : 0));
+
+	sq_pushstring(pVM, "packetloss", -1);
+	sq_pushfloat(pVM, pNetStats->fPacketlossLastSecond);
+	sq_createslot(pVM, -3);
+
+	sq_pushstring(pVM, "packetlosstotal", -1);
+	sq_pushfloat(pVM, pNetStats->fPacketlossTotal);
+	sq_createslot(pVM, -3);
+	return 1;
+}
+
 SQInteger CPlayerNatives::SetClothes(SQVM * pVM)
 {
 	SQInteger iPlayerId, iBodyPart, iClothes;
@@ -2123,7 +2154,7 @@ SQInteger CPlayerNatives::triggerAudioEvent(SQVM * pVM)
 	{
 		CBitStream bsSend;
 		bsSend.Write(String(szAudio));
-		g_pNetworkManager->RPC(RPC_ScriptingPlayGameAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingPlayGameAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -2143,7 +2174,7 @@ SQInteger CPlayerNatives::triggerMissionCompleteAudio(SQVM * pVM)
 	{
 		CBitStream bsSend;
 		bsSend.Write((int)szMission);
-		g_pNetworkManager->RPC(RPC_ScriptingPlayMissionCompleteAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingPlayMissionCompleteAudio, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -2163,7 +2194,7 @@ SQInteger CPlayerNatives::triggerPoliceReport(SQVM * pVM)
 	{
 		CBitStream bsSend;
 		bsSend.Write(String(szAudio));
-		g_pNetworkManager->RPC(RPC_ScriptingPlayPoliceReport, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingPlayPoliceReport, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -2183,7 +2214,7 @@ SQInteger CPlayerNatives::fadeScreenIn(SQVM * pVM)
 	{
 		CBitStream bsSend;
 		bsSend.Write((int)iDuration);
-		g_pNetworkManager->RPC(RPC_ScriptingFadeScreenIn, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingFadeScreenIn, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -2203,7 +2234,7 @@ SQInteger CPlayerNatives::fadeScreenOut(SQVM * pVM)
 	{
 		CBitStream bsSend;
 		bsSend.Write((int)iDuration);
-		g_pNetworkManager->RPC(RPC_ScriptingFadeScreenOut, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingFadeScreenOut, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -2311,7 +2342,7 @@ SQInteger CPlayerNatives::DisplayHudNotification(SQVM * pVM)
 		CBitStream bsSend;
 		bsSend.Write((int)iMode);
 		bsSend.Write(String(szMessage));
-		g_pNetworkManager->RPC(RPC_ScriptingDisplayHudNotification, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false);
+		g_pNetworkManager->RPC(RPC_ScriptingDisplayHudNotification, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, playerId, false, PACKET_CHANNEL_GUI);
 		sq_pushbool(pVM, true);
 		return 1;
 	}
@@ -2587,4 +2618,396 @@ SQInteger CPlayerNatives::GetDimension(SQVM * pVM)
 
 	sq_pushinteger(pVM, -1);
 	return 1;
-}
\ No newline at end of file
+}
+
+// createBroadcastGroup()
+SQInteger CPlayerNatives::CreateBroadcastGroup(SQVM * pVM)
+{
+	BroadcastGroupId groupId = g_pBroadcastGroupManager->Create();
+
+	if(groupId != INVALID_BROADCAST_GROUP)
+	{
+		sq_pushinteger(pVM, groupId);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, -1);
+	return 1;
+}
+
+// deleteBroadcastGroup(groupid)
+SQInteger CPlayerNatives::DeleteBroadcastGroup(SQVM * pVM)
+{
+	SQInteger iGroupId;
+	sq_getinteger(pVM, -1, &iGroupId);
+	sq_pushbool(pVM, g_pBroadcastGroupManager->Delete((BroadcastGroupId)iGroupId));
+	return 1;
+}
+
+// addPlayerToBroadcastGroup(groupid, playerid)
+SQInteger CPlayerNatives::AddToBroadcastGroup(SQVM * pVM)
+{
+	SQInteger iGroupId;
+	EntityId playerId;
+	sq_getinteger(pVM, -2, &iGroupId);
+	sq_getentity(pVM, -1, &playerId);
+
+	// Players are only ever in the group of the dimension they are in
+	if(g_pPlayerManager->DoesExist(playerId) && iGroupId >= BROADCAST_GROUP_DIMENSIONS)
+	{
+		sq_pushbool(pVM, g_pBroadcastGroupManager->AddPlayer((BroadcastGroupId)iGroupId, playerId));
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// removePlayerFromBroadcastGroup(groupid, playerid)
+SQInteger CPlayerNatives::RemoveFromBroadcastGroup(SQVM * pVM)
+{
+	SQInteger iGroupId;
+	EntityId playerId;
+	sq_getinteger(pVM, -2, &iGroupId);
+	sq_getentity(pVM, -1, &playerId);
+
+	if(iGroupId >= BROADCAST_GROUP_DIMENSIONS)
+	{
+		sq_pushbool(pVM, g_pBroadcastGroupManager->RemovePlayer((BroadcastGroupId)iGroupId, playerId));
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// isPlayerInBroadcastGroup(groupid, playerid)
+SQInteger CPlayerNatives::IsInBroadcastGroup(SQVM * pVM)
+{
+	SQInteger iGroupId;
+	EntityId playerId;
+	sq_getinteger(pVM, -2, &iGroupId);
+	sq_getentity(pVM, -1, &playerId);
+	sq_pushbool(pVM, g_pBroadcastGroupManager->IsPlayerInGroup((BroadcastGroupId)iGroupId, playerId));
+	return 1;
+}
+
+// getDimensionBroadcastGroup(dimension)
+SQInteger CPlayerNatives::GetDimensionBroadcastGroup(SQVM * pVM)
+{
+	SQInteger iDimension;
+	sq_getinteger(pVM, -1, &iDimension);
+
+	if(iDimension >= 0 && iDimension < BROADCAST_GROUP_DIMENSIONS)
+	{
+		sq_pushinteger(pVM, CBroadcastGroupManager::GetDimensionGroup((unsigned char)iDimension));
+		return 1;
+	}
+
+	sq_pushinteger(pVM, -1);
+	return 1;
+}
+
+// sendMessageToBroadcastGroup(groupid, message, color = 0xFFFFFFAA, allowformatting = false)
+SQInteger CPlayerNatives::SendMessageToBroadcastGroup(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("sendMessageToBroadcastGroup", 2, 4);
+	CHECK_TYPE("sendMessageToBroadcastGroup", 1, 2, OT_INTEGER);
+	CHECK_TYPE("sendMessageToBroadcastGroup", 2, 3, OT_STRING);
+
+	SQInteger iGroupId;
+	const char * szMessage = NULL;
+	SQInteger iColor = 0xFFFFFFAA;
+	SQBool sqbAllowFormatting = false;
+	sq_getinteger(pVM, 2, &iGroupId);
+	sq_getstring(pVM, 3, &szMessage);
+	SQInteger vtop = (sq_gettop(pVM) - 1);
+
+	if(vtop > 2)
+	{
+		CHECK_TYPE("sendMessageToBroadcastGroup", 3, 4, OT_INTEGER);
+		sq_getinteger(pVM, 4, &iColor);
+	}
+
+	if(vtop > 3)
+	{
+		CHECK_TYPE("sendMessageToBroadcastGroup", 4, 5, OT_BOOL);
+		sq_getbool(pVM, 5, &sqbAllowFormatting);
+	}
+
+	if(g_pBroadcastGroupManager->DoesExist((BroadcastGroupId)iGroupId))
+	{
+		CBitStream bsSend;
+		bsSend.Write((DWORD)iColor);
+		bsSend.Write(String(szMessage));
+		bool bAllowFormatting = (sqbAllowFormatting != 0);
+		bsSend.Write(bAllowFormatting);
+		g_pNetworkManager->GroupRPC(RPC_Message, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, (BroadcastGroupId)iGroupId, INVALID_ENTITY_ID, PACKET_CHANNEL_CHAT);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// triggerClientEventForBroadcastGroup(groupid, [reliable = true,] eventname, ...)
+SQInteger CPlayerNatives::TriggerEventForBroadcastGroup(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("triggerClientEventForBroadcastGroup", 2);
+	CHECK_TYPE("triggerClientEventForBroadcastGroup", 1, 2, OT_INTEGER);
+
+	SQInteger iGroupId;
+	sq_getinteger(pVM, 2, &iGroupId);
+	const std::vector<EntityId> * pMembers = g_pBroadcastGroupManager->GetMembers((BroadcastGroupId)iGroupId);
+
+	if(!pMembers)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	return MulticastEvent(pVM, 3, *pMembers);
+}
+
+// triggerClientEventForPlayers(playerids, [reliable = true,] eventname, ...)
+SQInteger CPlayerNatives::TriggerEventForPlayers(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("triggerClientEventForPlayers", 2);
+	CHECK_TYPE("triggerClientEventForPlayers", 1, 2, OT_ARRAY);
+
+	std::vector<EntityId> players;
+	sq_pushnull(pVM);
+
+	while(SQ_SUCCEEDED(sq_next(pVM, 2)))
+	{
+		EntityId playerId;
+
+		if(sq_gettype(pVM, -1) == OT_INTEGER && SQ_SUCCEEDED(sq_getentity(pVM, -1, &playerId)))
+			players.push_back(playerId);
+
+		sq_pop(pVM, 2);
+	}
+
+	sq_pop(pVM, 1);
+	return MulticastEvent(pVM, 3, players);
+}
+
+// triggerClientEventInRange(x, y, z, range, [reliable = true,] eventname, ...)
+SQInteger CPlayerNatives::TriggerEventInRange(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("triggerClientEventInRange", 5);
+	CHECK_TYPE("triggerClientEventInRange", 1, 2, OT_FLOAT);
+	CHECK_TYPE("triggerClientEventInRange", 2, 3, OT_FLOAT);
+	CHECK_TYPE("triggerClientEventInRange", 3, 4, OT_FLOAT);
+	CHECK_TYPE("triggerClientEventInRange", 4, 5, OT_FLOAT);
+
+	CVector3 vecPosition;
+	float fRange;
+	sq_getfloat(pVM, 2, &vecPosition.fX);
+	sq_getfloat(pVM, 3, &vecPosition.fY);
+	sq_getfloat(pVM, 4, &vecPosition.fZ);
+	sq_getfloat(pVM, 5, &fRange);
+
+	std::vector<EntityId> players;
+	g_pSpatialIndex->GetInRange(SPATIAL_INDEX_PLAYER, vecPosition, fRange, SPATIAL_INDEX_ALL_DIMENSIONS, players);
+	return MulticastEvent(pVM, 6, players);
+}
+
+SQInteger CPlayerNatives::MulticastEvent(SQVM * pVM, SQInteger iArgument, const std::vector<EntityId>& players)
+{
+	// Cosmetic events can be sent unreliable so they never hold up the other events
+	SQBool bReliable = true;
+
+	if(sq_gettype(pVM, iArgument) == OT_BOOL)
+		sq_getbool(pVM, iArgument++, &bReliable);
+
+	if(sq_gettype(pVM, iArgument) != OT_STRING)
+	{
+		CLogFile::Printf("Invalid event name for a client event (Expected a string as parameter %d).", (iArgument - 1));
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * szEventName;
+	sq_getstring(pVM, iArgument, &szEventName);
+	CSquirrelArguments arguments(pVM, (iArgument + 1));
+	std::vector<EntityId> recipients;
+	recipients.reserve(players.size());
+
+	for(std::vector<EntityId>::const_iterator iter = players.begin(); iter != players.end(); ++iter)
+	{
+		if(g_pPlayerManager->DoesExist(*iter))
+			recipients.push_back(*iter);
+	}
+
+	if(!recipients.empty())
+		g_pNetworkManager->EventRPC(szEventName, &arguments, &recipients[0], (unsigned int)recipients.size(), (bReliable ? RELIABILITY_RELIABLE_ORDERED : RELIABILITY_UNRELIABLE));
+
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+int CPlayerNatives::GetDataStride(SQInteger iAttributes)
+{
+	int iStride = 1;
+
+	for(int i = 0; i < 16; i++)
+	{
+		if(iAttributes & (1 << i))
+			iStride++;
+	}
+
+	// The vectors have three values and the weapon and vehicle two
+	if(iAttributes & PLAYER_DATA_COORDINATES)
+		iStride += 2;
+
+	if(iAttributes & PLAYER_DATA_VELOCITY)
+		iStride += 2;
+
+	if(iAttributes & PLAYER_DATA_WEAPON)
+		iStride++;
+
+	if(iAttributes & PLAYER_DATA_VEHICLE)
+		iStride++;
+
+	return iStride;
+}
+
+// getPlayersData(attributes, [players = null, result])
+// Returns a flat array with the id of each player followed by the attributes (PLAYER_DATA_*
+// flags) in the order of the flags, getPlayerDataStride gives the amount of values per player.
+// players is an array of player ids (null for all players), the ones that don't exist are
+// left out. The result array is filled in place so it can be kept and reused every time.
+SQInteger CPlayerNatives::GetPlayersData(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("getPlayersData", 1, 3);
+	CHECK_TYPE("getPlayersData", 1, 2, OT_INTEGER);
+
+	SQInteger iAttributes;
+	sq_getinteger(pVM, 2, &iAttributes);
+	int iTop = sq_gettop(pVM);
+	std::vector<EntityId> players;
+	bool bSubset = (iTop >= 3 && sq_gettype(pVM, 3) != OT_NULL);
+
+	if(bSubset)
+	{
+		CHECK_TYPE("getPlayersData", 2, 3, OT_ARRAY);
+		sq_pushnull(pVM);
+
+		while(SQ_SUCCEEDED(sq_next(pVM, 3)))
+		{
+			EntityId playerId;
+
+			if(sq_gettype(pVM, -1) == OT_INTEGER && SQ_SUCCEEDED(sq_getentity(pVM, -1, &playerId)) && g_pPlayerManager->DoesExist(playerId))
+				players.push_back(playerId);
+
+			sq_pop(pVM, 2);
+		}
+
+		sq_pop(pVM, 1);
+	}
+
+	if(iTop >= 4)
+	{
+		CHECK_TYPE("getPlayersData", 3, 4, OT_ARRAY);
+		sq_push(pVM, 4);
+	}
+	else
+		sq_newarray(pVM, 0);
+
+	const std::vector<EntityId>& playerIds = (bSubset ? players : g_pPlayerManager->GetActivePlayers());
+	int iStride = GetDataStride(iAttributes);
+
+	// The values are set straight in the array instead of being pushed one by one
+	sq_arrayresize(pVM, -1, (SQInteger)(playerIds.size() * iStride));
+	SQArray * pArray = _array(stack_get(pVM, -1));
+	SQInteger iIndex = 0;
+
+	for(std::vector<EntityId>::const_iterator iter = playerIds.begin(); iter != playerIds.end(); ++iter)
+	{
+		CPlayer * pPlayer = g_pPlayerManager->GetAt(*iter);
+		pArray->Set(iIndex++, SQObjectPtr((SQInteger)(*iter)));
+
+		if(iAttributes & PLAYER_DATA_NAME)
+		{
+			String strName = pPlayer->GetName();
+			pArray->Set(iIndex++, SQObjectPtr(SQString::Create(_ss(pVM), strName.Get(), strName.GetLength())));
+		}
+
+		if(iAttributes & PLAYER_DATA_PING)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetPing()));
+
+		if(iAttributes & PLAYER_DATA_HEALTH)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetHealth() - 100));
+
+		if(iAttributes & PLAYER_DATA_ARMOUR)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetArmour()));
+
+		if(iAttributes & PLAYER_DATA_COORDINATES)
+		{
+			CVector3 vecPosition;
+			pPlayer->GetPosition(vecPosition);
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)vecPosition.fX));
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)vecPosition.fY));
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)vecPosition.fZ));
+		}
+
+		if(iAttributes & PLAYER_DATA_VELOCITY)
+		{
+			CVector3 vecMoveSpeed;
+			pPlayer->GetMoveSpeed(vecMoveSpeed);
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)vecMoveSpeed.fX));
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)vecMoveSpeed.fY));
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)vecMoveSpeed.fZ));
+		}
+
+		if(iAttributes & PLAYER_DATA_HEADING)
+			pArray->Set(iIndex++, SQObjectPtr((SQFloat)pPlayer->GetCurrentHeading()));
+
+		if(iAttributes & PLAYER_DATA_MODEL)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetModel()));
+
+		if(iAttributes & PLAYER_DATA_MONEY)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetMoney()));
+
+		if(iAttributes & PLAYER_DATA_WANTED_LEVEL)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetWantedLevel()));
+
+		if(iAttributes & PLAYER_DATA_WEAPON)
+		{
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetWeapon()));
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetAmmo()));
+		}
+
+		if(iAttributes & PLAYER_DATA_VEHICLE)
+		{
+			bool bInVehicle = pPlayer->IsInVehicle();
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)(bInVehicle ? pPlayer->GetVehicle()->GetVehicleId() : -1)));
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)(bInVehicle ? pPlayer->GetVehicleSeatId() : -1)));
+		}
+
+		if(iAttributes & PLAYER_DATA_STATE)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetState()));
+
+		if(iAttributes & PLAYER_DATA_DIMENSION)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetDimension()));
+
+		if(iAttributes & PLAYER_DATA_COLOR)
+			pArray->Set(iIndex++, SQObjectPtr((SQInteger)pPlayer->GetColor()));
+
+		if(iAttributes & PLAYER_DATA_SPAWNED)
+			pArray->Set(iIndex++, SQObjectPtr(pPlayer->IsSpawned()));
+	}
+
+	return 1;
+}
+
+// getPlayerDataStride(attributes)
+SQInteger CPlayerNatives::GetPlayerDataStride(SQVM * pVM)
+{
+	SQInteger iAttributes;
+	sq_getinteger(pVM, 2, &iAttributes);
+	sq_pushinteger(pVM, GetDataStride(iAttributes));
+	return 1;
+}
@@ -11,44 +11,69 @@
 #pragma once
 
 #include "../Natives.h"
+#include <vector>
+
+// Attributes getPlayersData can get, the values of each player follow its id in
+// the order of the flags
+enum ePlayerDataAttribute
+{
+	PLAYER_DATA_NAME         = (1 << 0),
+	PLAYER_DATA_PING         = (1 << 1),
+	PLAYER_DATA_HEALTH       = (1 << 2),
+	PLAYER_DATA_ARMOUR       = (1 << 3),
+	PLAYER_DATA_COORDINATES  = (1 << 4),  // x, y, z
+	PLAYER_DATA_VELOCITY     = (1 << 5),  // x, y, z
+	PLAYER_DATA_HEADING      = (1 << 6),
+	PLAYER_DATA_MODEL        = (1 << 7),
+	PLAYER_DATA_MONEY        = (1 << 8),
+	PLAYER_DATA_WANTED_LEVEL = (1 << 9),
+	PLAYER_DATA_WEAPON       = (1 << 10), // Weapon, ammo
+	PLAYER_DATA_VEHICLE      = (1 << 11), // Vehicle id, seat id (both -1 on foot)
+	PLAYER_DATA_STATE        = (1 << 12),
+	PLAYER_DATA_DIMENSION    = (1 << 13),
+	PLAYER_DATA_COLOR        = (1 << 14),
+	PLAYER_DATA_SPAWNED      = (1 << 15),
+	PLAYER_DATA_ALL          = ((1 << 16) - 1)
+};
 
 class CPlayerNatives
 {
 private:
-	static SQInteger IsConnected(SQVM * pVM);
+	static bool IsConnected(EntityId playerId);
 	static SQInteger GetName(SQVM * pVM);
 	static SQInteger SetName(SQVM * pVM);
-	static SQInteger SetHealth(SQVM * pVM);
-	static SQInteger GetHealth(SQVM * pVM);
-	static SQInteger SetArmour(SQVM * pVM);
-	static SQInteger GetArmour(SQVM * pVM);
-	static SQInteger SetCoordinates(SQVM * pVM);
-	static SQInteger GetCoordinates(SQVM * pVM);
+	static bool SetHealth(EntityId playerId, int iHealth);
+	static NativeResult<int> GetHealth(EntityId playerId);
+	static bool SetArmour(EntityId playerId, int iArmour);
+	static NativeResult<int> GetArmour(EntityId playerId);
+	static bool SetCoordinates(EntityId playerId, CVector3 vecPos);
+	static NativeResult<CVector3> GetCoordinates(EntityId playerId);
 	static SQInteger SetTime(SQVM * pVM);
 	static SQInteger SetWeather(SQVM * pVM);
 	static SQInteger SetGravity(SQVM * pVM);
 	static SQInteger SendMessage(SQVM * pVM);
 	static SQInteger SendMessageToAll(SQVM * pVM);
-	static SQInteger IsInAnyVehicle(SQVM * pVM);
+	static bool IsInAnyVehicle(EntityId playerId);
 	static SQInteger IsInVehicle(SQVM * pVM);
-	static SQInteger GetVehicleId(SQVM * pVM);
-	static SQInteger GetSeatId(SQVM * pVM);
-	static SQInteger IsOnFoot(SQVM * pVM);
+	static NativeResult<int> GetVehicleId(EntityId playerId);
+	static NativeResult<int> GetSeatId(EntityId playerId);
+	static bool IsOnFoot(EntityId playerId);
 	static SQInteger TogglePayAndSpray(SQVM * pVM);
 	static SQInteger ToggleAutoAim(SQVM * pVM);
 	//static SQInteger SetPlayerDrunk(SQVM * pVM);
 	static SQInteger GiveWeapon(SQVM * pVM);
 	static SQInteger RemoveWeapons(SQVM * pVM);
 	static SQInteger SetSpawnLocation(SQVM * pVM);
-	static SQInteger SetModel(SQVM * pVM);
-	static SQInteger GetModel(SQVM * pVM);
+	static bool SetModel(EntityId playerId, int iModelId);
+	static NativeResult<int> GetModel(EntityId playerId);
 	static SQInteger ToggleControls(SQVM * pVM);
 	static SQInteger IsSpawned(SQVM * pVM);
-	static SQInteger SetHeading(SQVM * pVM);
-	static SQInteger GetHeading(SQVM * pVM);
+	static bool SetHeading(EntityId playerId, float fHeading);
+	static NativeResult<float> GetHeading(EntityId playerId);
 	static SQInteger TogglePhysics(SQVM * pVM);
 	static SQInteger Kick(SQVM * pVM);
 	static SQInteger Ban(SQVM * pVM);
+	static SQInteger Transfer(SQVM * pVM);
 	static SQInteger GetIp(SQVM * pVM);
 	static SQInteger GiveMoney(SQVM * pVM);
 	static SQInteger SetMoney(SQVM * pVM);
@@ -85,6 +110,7 @@ private:
 	static SQInteger GetColor(SQVM * pVM);
 	static SQInteger SetColor(SQVM * pVM);
 	static SQInteger GetPing(SQVM * pVM);
+	static SQInteger GetNetStats(SQVM * pVM);
 	static SQInteger SetClothes(SQVM * pVM);
 	static SQInteger GetClothes(SQVM * pVM);
 	static SQInteger ResetClothes(SQVM * pVM);
@@ -119,6 +145,26 @@ private:
 	static SQInteger SetDimension(SQVM * pVM);
 	static SQInteger GetDimension(SQVM * pVM);
 
+	static SQInteger CreateBroadcastGroup(SQVM * pVM);
+	static SQInteger DeleteBroadcastGroup(SQVM * pVM);
+	static SQInteger AddToBroadcastGroup(SQVM * pVM);
+	static SQInteger RemoveFromBroadcastGroup(SQVM * pVM);
+	static SQInteger IsInBroadcastGroup(SQVM * pVM);
+	static SQInteger GetDimensionBroadcastGroup(SQVM * pVM);
+	static SQInteger SendMessageToBroadcastGroup(SQVM * pVM);
+	static SQInteger TriggerEventForBroadcastGroup(SQVM * pVM);
+	static SQInteger TriggerEventForPlayers(SQVM * pVM);
+	static SQInteger TriggerEventInRange(SQVM * pVM);
+
+	static SQInteger GetPlayersData(SQVM * pVM);
+	static SQInteger GetPlayerDataStride(SQVM * pVM);
+
+	// Returns the amount of values a player has in getPlayersData, its id included
+	static int       GetDataStride(SQInteger iAttributes);
+
+	// Sends the event at the argument index ([reliable,] eventname, ...) to the players with the arguments serialized once
+	static SQInteger MulticastEvent(SQVM * pVM, SQInteger iArgument, const std::vector<EntityId>& players);
+
 public:
 	static void      Register(CScriptingManager * pScriptingManager);
 };
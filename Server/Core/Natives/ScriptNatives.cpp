@@ -8,13 +8,17 @@
 //==============================================================================
 
 #include "../Natives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
 #include "../CClientFileManager.h"
 #include "Scripting/CScriptTimerManager.h"
+#include "../CScriptHotReloader.h"
 
 extern CScriptingManager * g_pScriptingManager;
 extern CClientFileManager * g_pClientScriptFileManager;
 extern CClientFileManager * g_pClientResourceFileManager;
 extern CScriptTimerManager * g_pScriptTimerManager;
+extern CScriptHotReloader * g_pScriptHotReloader;
 
 // Script functions
 
@@ -26,6 +30,11 @@ void RegisterScriptNatives(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("loadScript", sq_server_loadscript, 1, "s");
 	pScriptingManager->RegisterFunction("unloadScript", sq_server_unloadscript, 1, "s");
 	pScriptingManager->RegisterFunction("reloadScript", sq_server_reloadscript, 1, "s");
+	pScriptingManager->RegisterFunction("hotReloadScript", sq_server_hotreloadscript, 1, "s");
+	pScriptingManager->RegisterFunction("getPersistentState", sq_server_getpersistentstate, 1, "t");
+	pScriptingManager->RegisterFunction("collectGarbage", sq_server_collectgarbage, 0, NULL);
+	pScriptingManager->RegisterFunction("setGarbageCollectionInterval", sq_server_setgarbagecollectioninterval, 1, "i");
+	pScriptingManager->RegisterFunction("getGarbageCollectionStats", sq_server_getgarbagecollectionstats, 0, NULL);
 	pScriptingManager->RegisterFunction("loadClientScript", sq_server_loadclientscript, 1, "s");
 	pScriptingManager->RegisterFunction("unloadClientScript", sq_server_unloadclientscript, 1, "s");
 	pScriptingManager->RegisterFunction("reloadClientScript", sq_server_reloadclientscript, 1, "s");
@@ -143,6 +152,110 @@ SQInteger sq_server_reloadscript(SQVM * pVM)
 	return 1;
 }
 
+// hotReloadScript(script)
+// The new version is compiled in the background and replaces the old one in a later tick,
+// so a script can also hot reload itself
+SQInteger sq_server_hotreloadscript(SQVM * pVM)
+{
+	const char* szScript;
+	sq_getstring(pVM, 2, &szScript);
+	sq_pushbool(pVM, g_pScriptHotReloader->Start(szScript));
+	return 1;
+}
+
+// getPersistentState(table)
+// Declares the table as the state of the script that hot reloads copy to the new version,
+// returns the copied state while the new version runs and the table otherwise
+SQInteger sq_server_getpersistentstate(SQVM * pVM)
+{
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+
+	if(!pScript)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	CSquirrelArgument * pMigratedState = pScript->GetMigratedState();
+
+	if(pMigratedState && pMigratedState->GetType() == OT_TABLE)
+	{
+		pMigratedState->push(pVM);
+		pScript->SetMigratedState(NULL);
+	}
+	else
+		sq_push(pVM, 2);
+
+	pScript->SetPersistentState(stack_get(pVM, -1));
+	return 1;
+}
+
+// collectGarbage()
+// Collects the cycles of the script now, returns the amount of objects freed
+SQInteger sq_server_collectgarbage(SQVM * pVM)
+{
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+	sq_pushinteger(pVM, (pScript ? pScript->CollectGarbage() : 0));
+	return 1;
+}
+
+// setGarbageCollectionInterval(milliseconds)
+// 0 stops the collections between the ticks, the script then only collects with collectGarbage
+SQInteger sq_server_setgarbagecollectioninterval(SQVM * pVM)
+{
+	SQInteger iInterval;
+	sq_getinteger(pVM, 2, &iInterval);
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+
+	if(!pScript || iInterval < 0)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pScript->SetGCInterval((unsigned int)iInterval);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// getGarbageCollectionStats()
+// Times are in microseconds
+SQInteger sq_server_getgarbagecollectionstats(SQVM * pVM)
+{
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+
+	if(!pScript)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	const SquirrelGCStats& stats = pScript->GetGCStats();
+	sq_newtable(pVM);
+	sq_pushstring(pVM, "interval", -1);
+	sq_pushinteger(pVM, pScript->GetGCInterval());
+	sq_createslot(pVM, -3);
+	sq_pushstring(pVM, "collections", -1);
+	sq_pushinteger(pVM, stats.uiCollections);
+	sq_createslot(pVM, -3);
+	sq_pushstring(pVM, "freed", -1);
+	sq_pushinteger(pVM, stats.uiFreed);
+	sq_createslot(pVM, -3);
+	sq_pushstring(pVM, "lastFreed", -1);
+	sq_pushinteger(pVM, stats.uiLastFreed);
+	sq_createslot(pVM, -3);
+	sq_pushstring(pVM, "averageTime", -1);
+	sq_pushinteger(pVM, (stats.uiCollections > 0 ? (SQInteger)(stats.ullTotalTime / stats.uiCollections) : 0));
+	sq_createslot(pVM, -3);
+	sq_pushstring(pVM, "lastTime", -1);
+	sq_pushinteger(pVM, stats.uiLastTime);
+	sq_createslot(pVM, -3);
+	sq_pushstring(pVM, "maxTime", -1);
+	sq_pushinteger(pVM, stats.uiMaxTime);
+	sq_createslot(pVM, -3);
+	return 1;
+}
+
 // loadClientScript(script)
 SQInteger sq_server_loadclientscript(SQVM * pVM)
 {
@@ -20,6 +20,11 @@ SQUIRREL_FUNCTION(server_getscriptname);
 SQUIRREL_FUNCTION(server_loadscript);
 SQUIRREL_FUNCTION(server_unloadscript);
 SQUIRREL_FUNCTION(server_reloadscript);
+SQUIRREL_FUNCTION(server_hotreloadscript);
+SQUIRREL_FUNCTION(server_getpersistentstate);
+SQUIRREL_FUNCTION(server_collectgarbage);
+SQUIRREL_FUNCTION(server_setgarbagecollectioninterval);
+SQUIRREL_FUNCTION(server_getgarbagecollectionstats);
 SQUIRREL_FUNCTION(server_loadclientscript);
 SQUIRREL_FUNCTION(server_unloadclientscript);
 SQUIRREL_FUNCTION(server_reloadclientscript);
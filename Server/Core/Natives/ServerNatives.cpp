@@ -18,12 +18,18 @@
 #include "tinyxml/ticpp.h"
 #include <CSettings.h>
 #include "../CQuery.h"
+#include "../CTickScheduler.h"
+#include "../CBanManager.h"
+#include "../CWebserver.h"
 #include <SharedUtility.h>
 
 extern CPlayerManager    * g_pPlayerManager;
 extern CNetworkManager   * g_pNetworkManager;
 extern CQuery            * g_pQuery;
 extern CScriptingManager * g_pScriptingManager;
+extern CTickScheduler    * g_pTickScheduler;
+extern CBanManager       * g_pBanManager;
+extern CWebServer        * g_pWebserver;
 
 void SendConsoleInput(String strInput);
 
@@ -44,6 +50,7 @@ void CServerNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("getPlayers", GetPlayers, 0, NULL);
 	pScriptingManager->RegisterFunction("getPlayerSlots", GetPlayerSlots, 0, NULL);
 	pScriptingManager->RegisterFunction("getTickCount", GetTickCount, 0, NULL);
+	pScriptingManager->RegisterFunction("getServerTickStats", GetServerTickStats, 0, NULL);
 	pScriptingManager->RegisterFunction("setHostname", SetHostName, 1, "s");
 	pScriptingManager->RegisterFunction("getHostname", GetHostName, 0, NULL);
 	pScriptingManager->RegisterFunction("togglePayAndSpray", TogglePayAndSpray, 1, "b");
@@ -57,6 +64,10 @@ void CServerNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("forceWind",ForceWind,1,"f");
 	pScriptingManager->RegisterFunction("setWeather", SetWeather, 1, "i");
 	pScriptingManager->RegisterFunction("getWeather", GetWeather, 0, NULL);
+	pScriptingManager->RegisterFunction("addBan", AddBan, 2, "si");
+	pScriptingManager->RegisterFunction("removeBan", RemoveBan, 1, "s");
+	pScriptingManager->RegisterFunction("isBanned", IsBanned, 1, "s");
+	pScriptingManager->RegisterFunction("sendWebResponse", SendWebResponse, -1, NULL);
 }
 
 // log(string)
@@ -140,6 +151,7 @@ SQInteger CServerNatives::SetPassword(SQVM * pVM)
 	sq_getstring(pVM, -1, &pass);
 	g_pNetworkManager->GetNetServer()->SetPassword(pass);
 	CVAR_SET_STRING("password",String(pass));
+
 	sq_pushbool(pVM, true);
 	return 1;
 }
@@ -166,19 +178,20 @@ SQInteger CServerNatives::GetPlayers(SQVM * pVM)
 
 	sq_newtable(pVM);
 
-	for(EntityId i = 0; i < MAX_PLAYERS; i++)
+	const std::vector<EntityId>& players = g_pPlayerManager->GetActivePlayers();
+
+	for(size_t x = 0; x < players.size(); x++)
 	{
-		if(g_pPlayerManager->DoesExist(i))
-		{
-			CPlayer * pPlayer = g_pPlayerManager->GetAt(i);
+		EntityId i = players[x];
 
-			if(pPlayer)
-			{
-				sq_pushinteger(pVM, i);
-				sq_pushstring(pVM, pPlayer->GetName(), -1);
-				sq_createslot(pVM, -3);
-				++iCount;
-			}
+		CPlayer * pPlayer = g_pPlayerManager->GetAt(i);
+
+		if(pPlayer)
+		{
+			sq_pushinteger(pVM, i);
+			sq_pushstring(pVM, pPlayer->GetName(), -1);
+			sq_createslot(pVM, -3);
+			++iCount;
 		}
 	}
 
@@ -199,12 +212,50 @@ SQInteger CServerNatives::GetTickCount(SQVM * pVM)
 	return 1;
 }
 
+// getServerTickStats()
+SQInteger CServerNatives::GetServerTickStats(SQVM * pVM)
+{
+	const TickSchedulerStats * pStats = g_pTickScheduler->GetStats();
+	sq_newtable(pVM);
+
+	sq_pushstring(pVM, "rate", -1);
+	sq_pushinteger(pVM, pStats->uiTickRate);
+	sq_createslot(pVM, -3);
+
+	sq_pushstring(pVM, "ticks", -1);
+	sq_pushinteger(pVM, pStats->ulTicks);
+	sq_createslot(pVM, -3);
+
+	sq_pushstring(pVM, "overruns", -1);
+	sq_pushinteger(pVM, pStats->ulOverruns);
+	sq_createslot(pVM, -3);
+
+	sq_pushstring(pVM, "skipped", -1);
+	sq_pushinteger(pVM, pStats->ulSkippedTicks);
+	sq_createslot(pVM, -3);
+
+	// Times are in microseconds
+	sq_pushstring(pVM, "averagetime", -1);
+	sq_pushinteger(pVM, g_pTickScheduler->GetAverageTickTime());
+	sq_createslot(pVM, -3);
+
+	sq_pushstring(pVM, "maxtime", -1);
+	sq_pushinteger(pVM, pStats->ulMaxTickTime);
+	sq_createslot(pVM, -3);
+
+	sq_pushstring(pVM, "idle", -1);
+	sq_pushbool(pVM, pStats->bIdle);
+	sq_createslot(pVM, -3);
+	return 1;
+}
+
 // setHostname(hostname)
 SQInteger CServerNatives::SetHostName(SQVM * pVM)
 {
 	const char * szHostname;
 	sq_getstring(pVM, -1, &szHostname);
 	CVAR_SET_STRING("hostname", String(szHostname));
+
 	sq_pushbool(pVM, true);
 	return 1;
 }
@@ -306,70 +357,75 @@ SQInteger CServerNatives::GetWeaponName(SQVM * pVM)
 	SQInteger iWeaponId;
 	sq_getinteger(pVM, -1, &iWeaponId);
 
+	// The names are string literals so they are kept by the scripts under their address
+	const char * szName = NULL;
+
 	switch(iWeaponId)
 	{
 	case 0:
-		sq_pushstring(pVM, "Fists", -1);
+		szName = "Fists";
 		break;
 	case 1:
-		sq_pushstring(pVM, "Baseball Bat", -1);
+		szName = "Baseball Bat";
 		break;
 	case 2:
-		sq_pushstring(pVM, "Pool Cue", -1);
+		szName = "Pool Cue";
 		break;
 	case 3:
-		sq_pushstring(pVM, "Knife", -1);
+		szName = "Knife";
 		break;
 	case 4:
-		sq_pushstring(pVM, "Grenade", -1);
+		szName = "Grenade";
 		break;
 	case 5:
-		sq_pushstring(pVM, "Molotov Cocktail", -1);
+		szName = "Molotov Cocktail";
 		break;
 	case 7:
-		sq_pushstring(pVM, "Pistol", -1);
+		szName = "Pistol";
 		break;
 	case 9:
-		sq_pushstring(pVM, "Desert Eagle", -1);
+		szName = "Desert Eagle";
 		break;
 	case 10:
-		sq_pushstring(pVM, "Shotgun", -1);
+		szName = "Shotgun";
 		break;
 	case 11:
-		sq_pushstring(pVM, "Baretta", -1);
+		szName = "Baretta";
 		break;
 	case 12:
-		sq_pushstring(pVM, "Micro UZI", -1);
+		szName = "Micro UZI";
 		break;
 	case 13:
-		sq_pushstring(pVM, "MP5", -1);
+		szName = "MP5";
 		break;
 	case 14:
-		sq_pushstring(pVM, "AK-47", -1);
+		szName = "AK-47";
 		break;
 	case 15:
-		sq_pushstring(pVM, "M4", -1);
+		szName = "M4";
 		break;
 	case 16:
-		sq_pushstring(pVM, "Sniper Rifle", -1);
+		szName = "Sniper Rifle";
 		break;
 	case 17:
-		sq_pushstring(pVM, "M40-A1", -1);
+		szName = "M40-A1";
 		break;
 	case 18:
-		sq_pushstring(pVM, "Rocket Launcher", -1);
+		szName = "Rocket Launcher";
 		break;
 	case 19:
-		sq_pushstring(pVM, "Flame Thrower", -1);
+		szName = "Flame Thrower";
 		break;
 	case 20:
-		sq_pushstring(pVM, "Minigun", -1);
-		break;
-	default:
-		sq_pushbool(pVM, false);
+		szName = "Minigun";
 		break;
 	}
-	
+
+	if(szName)
+		g_pScriptingManager->PushCachedString(pVM, szName, szName);
+	else
+		sq_pushbool(pVM, false);
+
 	return 1;
 }
 
@@ -403,7 +459,7 @@ SQInteger CServerNatives::GetVehicleName(SQVM * pVM)
 		return 1;
 	}
 
-	sq_pushstring(pVM, szVehicleNames[iModelId], -1);
+	g_pScriptingManager->PushCachedString(pVM, szVehicleNames[iModelId], szVehicleNames[iModelId]);
 	return 1;
 }
 
@@ -472,3 +528,85 @@ SQInteger CServerNatives::ForceWind(SQVM * pVM)
 	sq_pushbool(pVM, false);
 	return 1;
 }
+
+// addBan(ip/ip range (a.b.c.d/bits)/serial, seconds (0 = until removed))
+SQInteger CServerNatives::AddBan(SQVM * pVM)
+{
+	const char * szTarget;
+	SQInteger iSeconds;
+	sq_getstring(pVM, -2, &szTarget);
+	sq_getinteger(pVM, -1, &iSeconds);
+
+	if(iSeconds < 0)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, g_pBanManager->Add(szTarget, (unsigned int)iSeconds));
+	return 1;
+}
+
+// removeBan(ip/ip range/serial)
+SQInteger CServerNatives::RemoveBan(SQVM * pVM)
+{
+	const char * szTarget;
+	sq_getstring(pVM, -1, &szTarget);
+	sq_pushbool(pVM, g_pBanManager->Remove(szTarget));
+	return 1;
+}
+
+// isBanned(ip/ip range/serial)
+SQInteger CServerNatives::IsBanned(SQVM * pVM)
+{
+	const char * szTarget;
+	sq_getstring(pVM, -1, &szTarget);
+	sq_pushbool(pVM, g_pBanManager->IsBanned(szTarget));
+	return 1;
+}
+
+// sendWebResponse(requestid, response [, status = 200, contenttype = "text/html", ttl = 0])
+SQInteger CServerNatives::SendWebResponse(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("sendWebResponse", 2, 5);
+	CHECK_TYPE("sendWebResponse", 1, 2, OT_INTEGER);
+	CHECK_TYPE("sendWebResponse", 2, 3, OT_STRING);
+
+	SQInteger iRequestId;
+	const char * szResponse;
+	SQInteger iStatusCode = 200;
+	const char * szContentType = "text/html";
+	SQInteger iTTL = 0;
+	sq_getinteger(pVM, 2, &iRequestId);
+	sq_getstring(pVM, 3, &szResponse);
+
+	if(sq_gettop(pVM) >= 4)
+	{
+		CHECK_TYPE("sendWebResponse", 3, 4, OT_INTEGER);
+		sq_getinteger(pVM, 4, &iStatusCode);
+	}
+
+	if(sq_gettop(pVM) >= 5)
+	{
+		CHECK_TYPE("sendWebResponse", 4, 5, OT_STRING);
+		sq_getstring(pVM, 5, &szContentType);
+	}
+
+	if(sq_gettop(pVM) >= 6)
+	{
+		CHECK_TYPE("sendWebResponse", 5, 6, OT_INTEGER);
+		sq_getinteger(pVM, 6, &iTTL);
+	}
+
+	if(!g_pWebserver || iStatusCode < 100 || iStatusCode > 599 || iTTL < 0)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// The response can be binary
+	String strResponse;
+	strResponse.Set(szResponse, (unsigned int)sq_getsize(pVM, 3));
+	sq_pushbool(pVM, g_pWebserver->Respond((unsigned int)iRequestId, (int)iStatusCode, szContentType, strResponse, (unsigned int)iTTL));
+	return 1;
+}
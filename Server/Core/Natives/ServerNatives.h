@@ -28,6 +28,7 @@ private:
 	static SQInteger GetPlayers(SQVM * pVM);
 	static SQInteger GetPlayerSlots(SQVM * pVM);
 	static SQInteger GetTickCount(SQVM * pVM);
+	static SQInteger GetServerTickStats(SQVM * pVM);
 	static SQInteger SetHostName(SQVM * pVM);
 	static SQInteger GetHostName(SQVM * pVM);
 	static SQInteger TogglePayAndSpray(SQVM * pVM);
@@ -41,6 +42,10 @@ private:
 	static SQInteger SetWeather(SQVM * pVM);
 	static SQInteger GetWeather(SQVM * pVM);
 	static SQInteger ForceWind(SQVM * pvM);
+	static SQInteger AddBan(SQVM * pVM);
+	static SQInteger RemoveBan(SQVM * pVM);
+	static SQInteger IsBanned(SQVM * pVM);
+	static SQInteger SendWebResponse(SQVM * pVM);
 
 public:
 	static void      Register(CScriptingManager * pScriptingManager);
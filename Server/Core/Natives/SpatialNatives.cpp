@@ -0,0 +1,124 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SpatialNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "../CSpatialIndex.h"
+
+extern CSpatialIndex * g_pSpatialIndex;
+
+// Spatial functions
+
+void CSpatialNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("getPlayersInRange", GetPlayersInRange, 4, "ffff");
+	pScriptingManager->RegisterFunction("getPlayersInBox", GetPlayersInBox, 6, "ffffff");
+	pScriptingManager->RegisterFunction("getVehiclesInRange", GetVehiclesInRange, 4, "ffff");
+	pScriptingManager->RegisterFunction("getVehiclesInBox", GetVehiclesInBox, 6, "ffffff");
+	pScriptingManager->RegisterFunction("getObjectsInRange", GetObjectsInRange, 4, "ffff");
+	pScriptingManager->RegisterFunction("getObjectsInBox", GetObjectsInBox, 6, "ffffff");
+	pScriptingManager->RegisterFunction("getPickupsInRange", GetPickupsInRange, 4, "ffff");
+	pScriptingManager->RegisterFunction("getPickupsInBox", GetPickupsInBox, 6, "ffffff");
+}
+
+// Pushes an array of the ids of all entities of the type within the radius
+SQInteger CSpatialNatives::GetInRange(SQVM * pVM, eSpatialIndexType type)
+{
+	CVector3 vecPosition;
+	float fRadius;
+	sq_getfloat(pVM, -4, &vecPosition.fX);
+	sq_getfloat(pVM, -3, &vecPosition.fY);
+	sq_getfloat(pVM, -2, &vecPosition.fZ);
+	sq_getfloat(pVM, -1, &fRadius);
+
+	std::vector<EntityId> entities;
+	g_pSpatialIndex->GetInRange(type, vecPosition, fRadius, SPATIAL_INDEX_ALL_DIMENSIONS, entities);
+	sq_newarray(pVM, 0);
+
+	for(std::vector<EntityId>::iterator iter = entities.begin(); iter != entities.end(); ++iter)
+	{
+		sq_pushinteger(pVM, *iter);
+		sq_arrayappend(pVM, -2);
+	}
+
+	return 1;
+}
+
+// Pushes an array of the ids of all entities of the type inside the box
+SQInteger CSpatialNatives::GetInBox(SQVM * pVM, eSpatialIndexType type)
+{
+	CVector3 vecMin;
+	CVector3 vecMax;
+	sq_getfloat(pVM, -6, &vecMin.fX);
+	sq_getfloat(pVM, -5, &vecMin.fY);
+	sq_getfloat(pVM, -4, &vecMin.fZ);
+	sq_getfloat(pVM, -3, &vecMax.fX);
+	sq_getfloat(pVM, -2, &vecMax.fY);
+	sq_getfloat(pVM, -1, &vecMax.fZ);
+
+	std::vector<EntityId> entities;
+	g_pSpatialIndex->GetInBox(type, vecMin, vecMax, SPATIAL_INDEX_ALL_DIMENSIONS, entities);
+	sq_newarray(pVM, 0);
+
+	for(std::vector<EntityId>::iterator iter = entities.begin(); iter != entities.end(); ++iter)
+	{
+		sq_pushinteger(pVM, *iter);
+		sq_arrayappend(pVM, -2);
+	}
+
+	return 1;
+}
+
+// getPlayersInRange(x, y, z, radius)
+SQInteger CSpatialNatives::GetPlayersInRange(SQVM * pVM)
+{
+	return GetInRange(pVM, SPATIAL_INDEX_PLAYER);
+}
+
+// getPlayersInBox(minx, miny, minz, maxx, maxy, maxz)
+SQInteger CSpatialNatives::GetPlayersInBox(SQVM * pVM)
+{
+	return GetInBox(pVM, SPATIAL_INDEX_PLAYER);
+}
+
+// getVehiclesInRange(x, y, z, radius)
+SQInteger CSpatialNatives::GetVehiclesInRange(SQVM * pVM)
+{
+	return GetInRange(pVM, SPATIAL_INDEX_VEHICLE);
+}
+
+// getVehiclesInBox(minx, miny, minz, maxx, maxy, maxz)
+SQInteger CSpatialNatives::GetVehiclesInBox(SQVM * pVM)
+{
+	return GetInBox(pVM, SPATIAL_INDEX_VEHICLE);
+}
+
+// getObjectsInRange(x, y, z, radius)
+SQInteger CSpatialNatives::GetObjectsInRange(SQVM * pVM)
+{
+	return GetInRange(pVM, SPATIAL_INDEX_OBJECT);
+}
+
+// getObjectsInBox(minx, miny, minz, maxx, maxy, maxz)
+SQInteger CSpatialNatives::GetObjectsInBox(SQVM * pVM)
+{
+	return GetInBox(pVM, SPATIAL_INDEX_OBJECT);
+}
+
+// getPickupsInRange(x, y, z, radius)
+SQInteger CSpatialNatives::GetPickupsInRange(SQVM * pVM)
+{
+	return GetInRange(pVM, SPATIAL_INDEX_PICKUP);
+}
+
+// getPickupsInBox(minx, miny, minz, maxx, maxy, maxz)
+SQInteger CSpatialNatives::GetPickupsInBox(SQVM * pVM)
+{
+	return GetInBox(pVM, SPATIAL_INDEX_PICKUP);
+}
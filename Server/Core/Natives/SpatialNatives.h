@@ -0,0 +1,31 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SpatialNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+#include "../CSpatialIndex.h"
+
+class CSpatialNatives
+{
+private:
+	static SQInteger GetInRange(SQVM * pVM, eSpatialIndexType type);
+	static SQInteger GetInBox(SQVM * pVM, eSpatialIndexType type);
+	static SQInteger GetPlayersInRange(SQVM * pVM);
+	static SQInteger GetPlayersInBox(SQVM * pVM);
+	static SQInteger GetVehiclesInRange(SQVM * pVM);
+	static SQInteger GetVehiclesInBox(SQVM * pVM);
+	static SQInteger GetObjectsInRange(SQVM * pVM);
+	static SQInteger GetObjectsInBox(SQVM * pVM);
+	static SQInteger GetPickupsInRange(SQVM * pVM);
+	static SQInteger GetPickupsInBox(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
@@ -13,6 +13,7 @@
 #include "Scripting/CScriptingManager.h"
 #include "../CVehicleManager.h"
 #include "../CPlayer.h"
+#include <Game/CVehicleModels.h>
 
 extern CVehicleManager * g_pVehicleManager;
 extern CNetworkManager * g_pNetworkManager;
@@ -22,32 +23,34 @@ extern CNetworkManager * g_pNetworkManager;
 void CVehicleNatives::Register(CScriptingManager * pScriptingManager)
 {
 	pScriptingManager->RegisterFunction("createVehicle", Create, -1, NULL);
+	pScriptingManager->RegisterFunction("createVehicles", CreateBatch, 1, "a");
 	pScriptingManager->RegisterFunction("deleteVehicle", Delete, 1, "i");
-	pScriptingManager->RegisterFunction("setVehicleCoordinates", SetCoordinates, 4, "ifff");
-	pScriptingManager->RegisterFunction("getVehicleCoordinates", GetCoordinates, 1, "i");
-	pScriptingManager->RegisterFunction("setVehiclePosition", SetCoordinates, 4, "ifff");
-	pScriptingManager->RegisterFunction("getVehiclePosition", GetCoordinates, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setVehicleCoordinates", SetCoordinates);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehicleCoordinates", GetCoordinates);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setVehiclePosition", SetCoordinates);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehiclePosition", GetCoordinates);
 	pScriptingManager->RegisterFunction("setVehicleRotation", SetRotation, 4, "ifff");
 	pScriptingManager->RegisterFunction("setVehicleSirenState", SetSirenState, 2, "ib");
 	pScriptingManager->RegisterFunction("getVehicleSirenState", GetSirenState, 1, "i");
 	pScriptingManager->RegisterFunction("setVehicleDirtLevel", SetDirtLevel, 2, "if");
 	pScriptingManager->RegisterFunction("getVehicleDirtLevel", GetDirtLevel, 1, "i");
 	pScriptingManager->RegisterFunction("soundVehicleHorn", SoundHorn, 2, "ii");
-	pScriptingManager->RegisterFunction("getVehicleRotation", GetRotation, 1, "i");
-	pScriptingManager->RegisterFunction("isVehicleValid", IsValid, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehicleRotation", GetRotation);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "isVehicleValid", IsValid);
 	pScriptingManager->RegisterFunction("setVehicleColor", SetColor, -1, NULL);
 	pScriptingManager->RegisterFunction("getVehicleColor", GetColor, 1, "i");
-	pScriptingManager->RegisterFunction("getVehicleModel", GetModel, 1, "i");
-	pScriptingManager->RegisterFunction("setVehicleHealth", SetHealth, 2, "ii");
-	pScriptingManager->RegisterFunction("getVehicleHealth", GetHealth, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehicleModel", GetModel);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "setVehicleHealth", SetHealth);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehicleHealth", GetHealth);
 	pScriptingManager->RegisterFunction("setVehicleEngineHealth", SetEngineHealth, 2, "ii");
 	pScriptingManager->RegisterFunction("getVehicleEngineHealth", GetEngineHealth, 1, "i");
 	pScriptingManager->RegisterFunction("setVehicleVelocity", SetVelocity, 4, "ifff");
-	pScriptingManager->RegisterFunction("getVehicleVelocity", GetVelocity, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehicleVelocity", GetVelocity);
+	REGISTER_TYPED_NATIVE(pScriptingManager, "getVehicleDeformation", GetDeformation);
 	pScriptingManager->RegisterFunction("setVehicleAngularVelocity", SetAngularVelocity, 4, "ifff");
 	pScriptingManager->RegisterFunction("getVehicleAngularVelocity", GetAngularVelocity, 1, "i");
 	pScriptingManager->RegisterFunction("respawnVehicle", Respawn, 1, "i");
-	pScriptingManager->RegisterFunction("isVehicleOccupied", IsOccupied, 1, "i");
+	REGISTER_TYPED_NATIVE(pScriptingManager, "isVehicleOccupied", IsOccupied);
 	pScriptingManager->RegisterFunction("getVehicleOccupants", GetOccupants, 1, "i");
 	pScriptingManager->RegisterFunction("setVehicleLocked", SetLocked, 2, "ii");
 	pScriptingManager->RegisterFunction("getVehicleLocked", GetLocked, 1, "i");
@@ -88,7 +91,7 @@ SQInteger CVehicleNatives::Create(SQVM * pVM)
 	SQInteger color1, color2, color3 = 0, color4 = 0;
 	sq_getinteger(pVM, 2, &iModelId);
 
-	if(iModelId < 0 || iModelId == 41 || iModelId == 96 || iModelId == 107 || iModelId == 111 || iModelId > 123)
+	if(!CVehicleModels::IsValidModel(iModelId))
 	{
 		#ifdef IVMP_DEBUG
 			CLogFile::Printf("Invalid vehicle model (%d)", iModelId);
@@ -121,6 +124,70 @@ SQInteger CVehicleNatives::Create(SQVM * pVM)
 	return 1;
 }
 
+// createVehicles([[model, x, y, z, rx, ry, rz, color1, color2, color3, color4], ...])
+// The colors are optional, the vehicles get contiguous ids, returns the id of the first one
+SQInteger CVehicleNatives::CreateBatch(SQVM * pVM)
+{
+	SQInteger iCount = sq_getsize(pVM, 2);
+
+	if(iCount <= 0 || iCount > MAX_VEHICLES)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	std::vector<int> modelIds(iCount);
+	std::vector<CVector3> positions(iCount);
+	std::vector<CVector3> rotations(iCount);
+	std::vector<BYTE> colors((iCount * 4), 0);
+
+	for(SQInteger i = 0; i < iCount; i++)
+	{
+		if(SQ_FAILED(sq_pusharrayelement(pVM, 2, i)))
+		{
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		SQInteger iModelId = -1;
+		bool bValid = (sq_gettype(pVM, -1) == OT_ARRAY && SQ_SUCCEEDED(sq_getarrayinteger(pVM, -1, 0, &iModelId)) &&
+			SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 1, &positions[i])) && SQ_SUCCEEDED(sq_getarrayvector3(pVM, -1, 4, &rotations[i])));
+
+		if(bValid)
+		{
+			for(SQInteger j = 0; j < 4; j++)
+			{
+				SQInteger iColor;
+
+				if(SQ_SUCCEEDED(sq_getarrayinteger(pVM, -1, (7 + j), &iColor)))
+					colors[(i * 4) + j] = (BYTE)iColor;
+			}
+		}
+
+		sq_pop(pVM, 1);
+
+		if(!bValid || !CVehicleModels::IsValidModel(iModelId))
+		{
+			CLogFile::Printf("Invalid vehicle %d for function createVehicles.", i);
+			sq_pushbool(pVM, false);
+			return 1;
+		}
+
+		modelIds[i] = (int)iModelId;
+	}
+
+	EntityId vehicleId = g_pVehicleManager->AddBatch(iCount, &modelIds[0], &positions[0], &rotations[0], &colors[0]);
+
+	if(vehicleId == INVALID_ENTITY_ID)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushentity(pVM, vehicleId);
+	return 1;
+}
+
 // deleteVehicle(vehicleid)
 SQInteger CVehicleNatives::Delete(SQVM * pVM)
 {
@@ -137,55 +204,32 @@ SQInteger CVehicleNatives::Delete(SQVM * pVM)
 }
 
 // setVehicleCoordinates(vehicleid, x, y, z)
-SQInteger CVehicleNatives::SetCoordinates(SQVM * pVM)
+bool CVehicleNatives::SetCoordinates(EntityId vehicleId, CVector3 vecPosition)
 {
-	SQInteger vehicleid;
-	float x, y, z;
-	sq_getinteger(pVM, -4, &vehicleid);
-	sq_getfloat(pVM, -3, &x);
-	sq_getfloat(pVM, -2, &y);
-	sq_getfloat(pVM, -1, &z);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-	if(g_pVehicleManager->DoesExist(vehicleid))
+	if(pVehicle)
 	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleid);
-		
-		if(pVehicle)
-		{
-			pVehicle->SetPosition(CVector3(x, y, z));
-			sq_pushbool(pVM, true);
-			return 1;
-		}
+		pVehicle->SetPosition(vecPosition);
+		return true;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return false;
 }
 
 // getVehicleCoordinates(vehicleid)
-SQInteger CVehicleNatives::GetCoordinates(SQVM * pVM)
+NativeResult<CVector3> CVehicleNatives::GetCoordinates(EntityId vehicleId)
 {
-	SQInteger vehicleid;
-	sq_getinteger(pVM, -1, &vehicleid);
-	if(g_pVehicleManager->DoesExist(vehicleid))
-	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleid);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-		if(pVehicle)
-		{
-			CVector3 vecPosition;
-			pVehicle->GetPosition(vecPosition);
-			CSquirrelArguments args;
-			args.push(vecPosition.fX);
-			args.push(vecPosition.fY);
-			args.push(vecPosition.fZ);
-			sq_pusharg(pVM, CSquirrelArgument(args, true));
-			return 1;
-		}
+	if(pVehicle)
+	{
+		CVector3 vecPosition;
+		pVehicle->GetPosition(vecPosition);
+		return vecPosition;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<CVector3>();
 }
 
 // setVehicleRotation(vehicleid, rotation)
@@ -321,39 +365,24 @@ SQInteger CVehicleNatives::SoundHorn(SQVM * pVM)
 }
 
 // getVehicleRotation(vehicleid)
-SQInteger CVehicleNatives::GetRotation(SQVM * pVM)
+NativeResult<CVector3> CVehicleNatives::GetRotation(EntityId vehicleId)
 {
-	EntityId vehicleId;
-	sq_getentity(pVM, -1, &vehicleId);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-	if(g_pVehicleManager->DoesExist(vehicleId))
+	if(pVehicle)
 	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
-
-		if(pVehicle)
-		{
-			CVector3 vecRotation;
-			pVehicle->GetRotation(vecRotation);
-			CSquirrelArguments args;
-			args.push(vecRotation.fX);
-			args.push(vecRotation.fY);
-			args.push(vecRotation.fZ);
-			sq_pusharg(pVM, CSquirrelArgument(args, true));
-			return 1;
-		}
+		CVector3 vecRotation;
+		pVehicle->GetRotation(vecRotation);
+		return vecRotation;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<CVector3>();
 }
 
 // isVehicleValid(vehicleid)
-SQInteger CVehicleNatives::IsValid(SQVM * pVM)
+bool CVehicleNatives::IsValid(EntityId vehicleId)
 {
-	SQInteger vehicleid;
-	sq_getinteger(pVM, -1, &vehicleid);
-	sq_pushbool(pVM, g_pVehicleManager->DoesExist(vehicleid));
-	return 1;
+	return g_pVehicleManager->DoesExist(vehicleId);
 }
 
 // setVehicleColor(vehicleid, color1, color2, color3, color4)
@@ -410,63 +439,39 @@ SQInteger CVehicleNatives::GetColor(SQVM * pVM)
 }
 
 // getVehicleModel(vehicleid)
-SQInteger CVehicleNatives::GetModel(SQVM * pVM)
+NativeResult<int> CVehicleNatives::GetModel(EntityId vehicleId)
 {
-	SQInteger vehicleid;
-	sq_getinteger(pVM, -1, &vehicleid);
-	if(g_pVehicleManager->DoesExist(vehicleid))
-	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleid);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-		if(pVehicle)
-		{
-			sq_pushinteger(pVM, pVehicle->GetModel());
-			return 1;
-		}
-	}
-	sq_pushbool(pVM, false);
-	return 1;
+	if(pVehicle)
+		return pVehicle->GetModel();
+
+	return NativeResult<int>();
 }
 
 // setVehicleHealth(vehicleid, health)
-SQInteger CVehicleNatives::SetHealth(SQVM * pVM)
+bool CVehicleNatives::SetHealth(EntityId vehicleId, int iHealth)
 {
-	SQInteger vehicleid;
-	SQInteger health;
-	sq_getinteger(pVM, -2, &vehicleid);
-	sq_getinteger(pVM, -1, &health);
-	if(g_pVehicleManager->DoesExist(vehicleid))
-	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleid);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-		if(pVehicle)
-		{
-			pVehicle->SetHealth(health);
-			sq_pushbool(pVM, true);
-			return 1;
-		}
+	if(pVehicle)
+	{
+		pVehicle->SetHealth(iHealth);
+		return true;
 	}
-	sq_pushbool(pVM, false);
-	return 1;
+
+	return false;
 }
 
 // getVehicleHealth(vehicleid)
-SQInteger CVehicleNatives::GetHealth(SQVM * pVM)
+NativeResult<int> CVehicleNatives::GetHealth(EntityId vehicleId)
 {
-	SQInteger vehicleid;
-	sq_getinteger(pVM, -1, &vehicleid);
-	if(g_pVehicleManager->DoesExist(vehicleid))
-	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleid);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-		if(pVehicle)
-		{
-			sq_pushinteger(pVM, pVehicle->GetHealth());
-			return 1;
-		}
-	}
-	sq_pushbool(pVM, false);
-	return 1;
+	if(pVehicle)
+		return (int)pVehicle->GetHealth();
+
+	return NativeResult<int>();
 }
 
 // setVehicleEngineHealth(vehicleid, enginehealth)
@@ -537,30 +542,33 @@ SQInteger CVehicleNatives::SetVelocity(SQVM * pVM)
 }
 
 // getVehicleVelocity(vehicleid)
-SQInteger CVehicleNatives::GetVelocity(SQVM * pVM)
+NativeResult<CVector3> CVehicleNatives::GetVelocity(EntityId vehicleId)
 {
-	SQInteger vehicleid;
-	sq_getinteger(pVM, -1, &vehicleid);
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
 
-	if(g_pVehicleManager->DoesExist(vehicleid))
+	if(pVehicle)
 	{
-		CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleid);
+		CVector3 vecMoveSpeed;
+		pVehicle->GetMoveSpeed(vecMoveSpeed);
+		return vecMoveSpeed;
+	}
 
-		if(pVehicle)
-		{
-			CVector3 vecMoveSpeed;
-			pVehicle->GetMoveSpeed(vecMoveSpeed);
-			CSquirrelArguments args;
-			args.push(vecMoveSpeed.fX);
-			args.push(vecMoveSpeed.fY);
-			args.push(vecMoveSpeed.fZ);
-			sq_pusharg(pVM, CSquirrelArgument(args, true));
-			return 1;
-		}
+	return NativeResult<CVector3>();
+}
+
+// getVehicleDeformation(vehicleid, point)
+NativeResult<CVector3> CVehicleNatives::GetDeformation(EntityId vehicleId, int iPoint)
+{
+	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
+
+	if(pVehicle && iPoint >= 0 && iPoint < VEHICLE_DAMAGE_POINTS)
+	{
+		CVector3 vecDeformation;
+		pVehicle->GetDeformation((unsigned int)iPoint, vecDeformation);
+		return vecDeformation;
 	}
 
-	sq_pushbool(pVM, false);
-	return 1;
+	return NativeResult<CVector3>();
 }
 
 // setVehicleAngularVelocity(vehicleid, x, y, z)
@@ -637,21 +645,10 @@ SQInteger CVehicleNatives::Respawn(SQVM * pVM)
 }
 
 // isVehicleOccupied(vehicleid)
-SQInteger CVehicleNatives::IsOccupied(SQVM * pVM)
+bool CVehicleNatives::IsOccupied(EntityId vehicleId)
 {
-	EntityId vehicleId;
-	sq_getentity(pVM, -1, &vehicleId);
-
 	CVehicle * pVehicle = g_pVehicleManager->GetAt(vehicleId);
-
-	if(pVehicle)
-	{
-		sq_pushbool(pVM, pVehicle->IsOccupied());
-		return 1;
-	}
-
-	sq_pushbool(pVM, false);
-	return 1;
+	return (pVehicle && pVehicle->IsOccupied());
 }
 
 // getVehicleOccupants(vehicleid)
@@ -16,25 +16,27 @@ class CVehicleNatives
 {
 private:
 	static SQInteger Create(SQVM * pVM);
+	static SQInteger CreateBatch(SQVM * pVM);
 	static SQInteger Delete(SQVM * pVM);
-	static SQInteger SetCoordinates(SQVM * pVM);
-	static SQInteger GetCoordinates(SQVM * pVM);
+	static bool SetCoordinates(EntityId vehicleId, CVector3 vecPosition);
+	static NativeResult<CVector3> GetCoordinates(EntityId vehicleId);
 	static SQInteger SetRotation(SQVM * pVM);
-	static SQInteger GetRotation(SQVM * pVM);
-	static SQInteger IsValid(SQVM * pVM);
+	static NativeResult<CVector3> GetRotation(EntityId vehicleId);
+	static bool IsValid(EntityId vehicleId);
 	static SQInteger SetColor(SQVM * pVM);
 	static SQInteger GetColor(SQVM * pVM);
-	static SQInteger GetModel(SQVM * pVM);
-	static SQInteger SetHealth(SQVM * pVM);
-	static SQInteger GetHealth(SQVM * pVM);
+	static NativeResult<int> GetModel(EntityId vehicleId);
+	static bool SetHealth(EntityId vehicleId, int iHealth);
+	static NativeResult<int> GetHealth(EntityId vehicleId);
 	static SQInteger SetEngineHealth(SQVM * pVM);
 	static SQInteger GetEngineHealth(SQVM * pVM);
 	static SQInteger SetVelocity(SQVM * pVM);
-	static SQInteger GetVelocity(SQVM * pVM);
+	static NativeResult<CVector3> GetVelocity(EntityId vehicleId);
+	static NativeResult<CVector3> GetDeformation(EntityId vehicleId, int iPoint);
 	static SQInteger SetAngularVelocity(SQVM * pVM);
 	static SQInteger GetAngularVelocity(SQVM * pVM);
 	static SQInteger Respawn(SQVM * pVM);
-	static SQInteger IsOccupied(SQVM * pVM);
+	static bool IsOccupied(EntityId vehicleId);
 	static SQInteger GetOccupants(SQVM * pVM);
 	static SQInteger SetDirtLevel(SQVM * pVM);
 	static SQInteger GetDirtLevel(SQVM * pVM);
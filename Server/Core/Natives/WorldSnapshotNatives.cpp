@@ -0,0 +1,68 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: WorldSnapshotNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "WorldSnapshotNatives.h"
+#include "../CWorldSnapshotManager.h"
+
+extern CWorldSnapshotManager * g_pWorldSnapshotManager;
+
+// World snapshot functions
+
+void CWorldSnapshotNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("saveWorldSnapshot", Save, -1, NULL);
+	pScriptingManager->RegisterFunction("loadWorldSnapshot", Load, 1, "s");
+	pScriptingManager->RegisterFunction("isWorldSnapshotSaving", IsSaving, 0, NULL);
+}
+
+// saveWorldSnapshot(filename, [incremental = false])
+// The snapshot is written in the background, worldSnapshotSave is called once it is done
+SQInteger CWorldSnapshotNatives::Save(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("saveWorldSnapshot", 1, 2);
+	CHECK_TYPE("saveWorldSnapshot", 1, 2, OT_STRING);
+
+	const char * szFileName;
+	SQBool bIncremental = false;
+	sq_getstring(pVM, 2, &szFileName);
+
+	if(sq_gettop(pVM) >= 3)
+	{
+		CHECK_TYPE("saveWorldSnapshot", 2, 3, OT_BOOL);
+		sq_getbool(pVM, 3, &bIncremental);
+	}
+
+	sq_pushbool(pVM, g_pWorldSnapshotManager->Save(szFileName, (bIncremental != 0)));
+	return 1;
+}
+
+// loadWorldSnapshot(filename)
+// Returns the amount of entities created or false if the file can't be read
+SQInteger CWorldSnapshotNatives::Load(SQVM * pVM)
+{
+	const char * szFileName;
+	sq_getstring(pVM, -1, &szFileName);
+	int iCreated = g_pWorldSnapshotManager->Load(szFileName);
+
+	if(iCreated < 0)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, iCreated);
+	return 1;
+}
+
+// isWorldSnapshotSaving()
+SQInteger CWorldSnapshotNatives::IsSaving(SQVM * pVM)
+{
+	sq_pushbool(pVM, g_pWorldSnapshotManager->IsSaving());
+	return 1;
+}
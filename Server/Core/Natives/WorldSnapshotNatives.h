@@ -0,0 +1,23 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: WorldSnapshotNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CWorldSnapshotNatives
+{
+private:
+	static SQInteger Save(SQVM * pVM);
+	static SQInteger Load(SQVM * pVM);
+	static SQInteger IsSaving(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
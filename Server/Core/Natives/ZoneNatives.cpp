@@ -0,0 +1,180 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ZoneNatives.cpp
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "../Natives.h"
+#include "Scripting/CScriptingManager.h"
+#include "../CZoneManager.h"
+
+extern CZoneManager * g_pZoneManager;
+
+// Zone functions
+
+void CZoneNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("createCircleZone", CreateCircle, 3, "fff");
+	pScriptingManager->RegisterFunction("createBoxZone", CreateBox, 6, "ffffff");
+	pScriptingManager->RegisterFunction("createPolygonZone", CreatePolygon, -1, NULL);
+	pScriptingManager->RegisterFunction("deleteZone", Delete, 1, "i");
+	pScriptingManager->RegisterFunction("isZoneValid", IsValid, 1, "i");
+	pScriptingManager->RegisterFunction("setZoneDimension", SetDimension, 2, "ii");
+	pScriptingManager->RegisterFunction("getZoneDimension", GetDimension, 1, "i");
+	pScriptingManager->RegisterFunction("isPlayerInZone", IsPlayerInZone, 2, "ii");
+	pScriptingManager->RegisterFunction("getPlayerZones", GetPlayerZones, 1, "i");
+}
+
+// createCircleZone(x, y, radius)
+SQInteger CZoneNatives::CreateCircle(SQVM * pVM)
+{
+	float fX, fY, fRadius;
+	sq_getfloat(pVM, -3, &fX);
+	sq_getfloat(pVM, -2, &fY);
+	sq_getfloat(pVM, -1, &fRadius);
+	sq_pushentity(pVM, g_pZoneManager->CreateCircle(fX, fY, fRadius));
+	return 1;
+}
+
+// createBoxZone(minx, miny, minz, maxx, maxy, maxz)
+SQInteger CZoneNatives::CreateBox(SQVM * pVM)
+{
+	CVector3 vecMin;
+	CVector3 vecMax;
+	sq_getvector3(pVM, -6, &vecMin);
+	sq_getvector3(pVM, -3, &vecMax);
+	sq_pushentity(pVM, g_pZoneManager->CreateBox(vecMin, vecMax));
+	return 1;
+}
+
+// createPolygonZone(x1, y1, x2, y2, x3, y3, ...)
+SQInteger CZoneNatives::CreatePolygon(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("createPolygonZone", 6);
+
+	SQInteger iTop = sq_gettop(pVM);
+
+	if(((iTop - 1) % 2) != 0)
+	{
+		CLogFile::Printf("Invalid parameter count for function createPolygonZone (Expected pairs of coordinates).");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	std::vector<float> polygonX;
+	std::vector<float> polygonY;
+
+	for(SQInteger i = 2; i < iTop; i += 2)
+	{
+		CHECK_TYPE("createPolygonZone", (i - 1), i, OT_FLOAT);
+		CHECK_TYPE("createPolygonZone", i, (i + 1), OT_FLOAT);
+
+		float fX, fY;
+		sq_getfloat(pVM, i, &fX);
+		sq_getfloat(pVM, (i + 1), &fY);
+		polygonX.push_back(fX);
+		polygonY.push_back(fY);
+	}
+
+	sq_pushentity(pVM, g_pZoneManager->CreatePolygon(polygonX, polygonY));
+	return 1;
+}
+
+// deleteZone(zoneid)
+SQInteger CZoneNatives::Delete(SQVM * pVM)
+{
+	EntityId zoneId;
+	sq_getentity(pVM, -1, &zoneId);
+
+	if(g_pZoneManager->DoesExist(zoneId))
+	{
+		g_pZoneManager->Delete(zoneId);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// isZoneValid(zoneid)
+SQInteger CZoneNatives::IsValid(SQVM * pVM)
+{
+	EntityId zoneId;
+	sq_getentity(pVM, -1, &zoneId);
+	sq_pushbool(pVM, g_pZoneManager->DoesExist(zoneId));
+	return 1;
+}
+
+// setZoneDimension(zoneid, dimension)
+SQInteger CZoneNatives::SetDimension(SQVM * pVM)
+{
+	EntityId zoneId;
+	SQInteger iDimension;
+	sq_getentity(pVM, -2, &zoneId);
+	sq_getinteger(pVM, -1, &iDimension);
+
+	if(g_pZoneManager->DoesExist(zoneId))
+	{
+		g_pZoneManager->SetDimension(zoneId, (unsigned char)iDimension);
+		sq_pushbool(pVM, true);
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// getZoneDimension(zoneid)
+SQInteger CZoneNatives::GetDimension(SQVM * pVM)
+{
+	EntityId zoneId;
+	sq_getentity(pVM, -1, &zoneId);
+
+	if(g_pZoneManager->DoesExist(zoneId))
+	{
+		sq_pushinteger(pVM, g_pZoneManager->GetDimension(zoneId));
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
+
+// isPlayerInZone(playerid, zoneid)
+SQInteger CZoneNatives::IsPlayerInZone(SQVM * pVM)
+{
+	EntityId playerId;
+	EntityId zoneId;
+	sq_getentity(pVM, -2, &playerId);
+	sq_getentity(pVM, -1, &zoneId);
+	sq_pushbool(pVM, g_pZoneManager->IsPlayerInZone(playerId, zoneId));
+	return 1;
+}
+
+// getPlayerZones(playerid)
+SQInteger CZoneNatives::GetPlayerZones(SQVM * pVM)
+{
+	EntityId playerId;
+	sq_getentity(pVM, -1, &playerId);
+	const std::vector<EntityId> * pZones = g_pZoneManager->GetPlayerZones(playerId);
+
+	if(pZones)
+	{
+		sq_newarray(pVM, 0);
+
+		for(std::vector<EntityId>::const_iterator iter = pZones->begin(); iter != pZones->end(); ++iter)
+		{
+			sq_pushinteger(pVM, *iter);
+			sq_arrayappend(pVM, -2);
+		}
+
+		return 1;
+	}
+
+	sq_pushbool(pVM, false);
+	return 1;
+}
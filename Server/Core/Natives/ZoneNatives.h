@@ -0,0 +1,29 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: ZoneNatives.h
+// Project: Server.Core
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Natives.h"
+
+class CZoneNatives
+{
+private:
+	static SQInteger CreateCircle(SQVM * pVM);
+	static SQInteger CreateBox(SQVM * pVM);
+	static SQInteger CreatePolygon(SQVM * pVM);
+	static SQInteger Delete(SQVM * pVM);
+	static SQInteger IsValid(SQVM * pVM);
+	static SQInteger SetDimension(SQVM * pVM);
+	static SQInteger GetDimension(SQVM * pVM);
+	static SQInteger IsPlayerInZone(SQVM * pVM);
+	static SQInteger GetPlayerZones(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
@@ -0,0 +1,404 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CRelay.cpp
+// Project: Server.Relay
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <algorithm>
+#include "CRelay.h"
+#include <Network/CNetworkModule.h>
+#include <Network/PacketIdentifiers.h>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+CRelay * g_pRelay = NULL;
+
+CRelay::CRelay(const RelaySettings& settings)
+{
+	m_settings = settings;
+	m_pNetClient = NULL;
+	m_pNetServer = NULL;
+	m_state = RELAY_STATE_CONNECTING;
+	m_uiLogSize = 0;
+	m_bLogFull = false;
+	m_ulLastReportTime = SharedUtility::GetTime();
+	m_ulRpcsForwarded = 0;
+	m_ulBytesForwarded = 0;
+}
+
+CRelay::~CRelay()
+{
+	if(m_pNetServer)
+	{
+		m_pNetServer->Shutdown(100);
+		CNetworkModule::DestroyNetServerInterface(m_pNetServer);
+	}
+
+	if(m_pNetClient)
+	{
+		m_pNetClient->Shutdown(100);
+		CNetworkModule::DestroyNetClientInterface(m_pNetClient);
+	}
+
+	for(std::vector<RelayLogEntry>::iterator iter = m_log.begin(); iter != m_log.end(); iter++)
+		delete (*iter).pBitStream;
+}
+
+bool CRelay::Connect()
+{
+	m_pNetClient = CNetworkModule::GetNetClientInterface();
+
+	if(!m_pNetClient || !m_pNetClient->Startup())
+	{
+		OnFailed("failed to start up the net client");
+		return false;
+	}
+
+	m_pNetClient->SetPacketHandler(UpstreamPacketHandler);
+	m_pNetClient->SetHost(m_settings.strHost);
+	m_pNetClient->SetPort(m_settings.usPort);
+	m_pNetClient->SetPassword(m_settings.strPassword);
+
+	if(m_pNetClient->Connect() != CONNECTION_ATTEMPT_STARTED)
+	{
+		OnFailed("failed to start the connection attempt");
+		return false;
+	}
+
+	return true;
+}
+
+bool CRelay::IsSyncRPC(RPCIdentifier rpcId)
+{
+	// The rpcs the server sends unreliable, a newer one replaces them so
+	// they are neither resent nor logged
+	switch(rpcId)
+	{
+	case RPC_OnFootSync:
+	case RPC_InVehicleSync:
+	case RPC_PassengerSync:
+	case RPC_SmallSync:
+	case RPC_InputAction:
+	case RPC_EmptyVehicleSync:
+	case RPC_SyncSnapshot:
+	case RPC_ActorPathCorrection:
+	case RPC_AttachedBlipPositions:
+		return true;
+	}
+
+	return false;
+}
+
+void CRelay::UpstreamPacketHandler(CPacket * pPacket)
+{
+	switch(pPacket->packetId)
+	{
+	case PACKET_CONNECTION_SUCCEEDED:
+		g_pRelay->OnConnected();
+		break;
+	case PACKET_CONNECTION_REJECTED:
+		g_pRelay->OnFailed("connection rejected");
+		break;
+	case PACKET_CONNECTION_FAILED:
+		g_pRelay->OnFailed("connection timed out");
+		break;
+	case PACKET_ALREADY_CONNECTED:
+		g_pRelay->OnFailed("already connected");
+		break;
+	case PACKET_SERVER_FULL:
+		g_pRelay->OnFailed("server full");
+		break;
+	case PACKET_DISCONNECTED:
+		g_pRelay->OnFailed("disconnected");
+		break;
+	case PACKET_LOST_CONNECTION:
+		g_pRelay->OnFailed("lost connection");
+		break;
+	case PACKET_BANNED:
+		g_pRelay->OnFailed("banned");
+		break;
+	case PACKET_PASSWORD_INVALID:
+		g_pRelay->OnFailed("invalid password");
+		break;
+	case PACKET_RPC:
+		{
+			// The rpc id is the first byte, the rest is the payload
+			if(pPacket->uiLength < sizeof(RPCIdentifier))
+				break;
+
+			CBitStream bitStream((pPacket->ucData + sizeof(RPCIdentifier)), (pPacket->uiLength - sizeof(RPCIdentifier)), false);
+			g_pRelay->HandleServerRPC(pPacket->ucData[0], &bitStream);
+		}
+		break;
+	}
+}
+
+void CRelay::DownstreamPacketHandler(CPacket * pPacket)
+{
+	// Spectators only get to join, everything else they send is dropped
+	switch(pPacket->packetId)
+	{
+	case PACKET_DISCONNECTED:
+	case PACKET_LOST_CONNECTION:
+		g_pRelay->RemoveSpectator(pPacket->pPlayerSocket->playerId);
+		break;
+	case PACKET_RPC:
+		{
+			if(pPacket->uiLength < sizeof(RPCIdentifier) || pPacket->ucData[0] != RPC_PlayerConnect)
+				break;
+
+			CBitStream bitStream((pPacket->ucData + sizeof(RPCIdentifier)), (pPacket->uiLength - sizeof(RPCIdentifier)), false);
+			g_pRelay->AddSpectator(pPacket->pPlayerSocket->playerId, &bitStream);
+		}
+		break;
+	}
+}
+
+void CRelay::OnConnected()
+{
+	// Send the same connect rpc as the client with the relay password
+	CBitStream bsSend;
+	bsSend.Write(NETWORK_VERSION);
+	bsSend.Write(m_settings.strName);
+	bsSend.WriteBit(false);
+	bsSend.WriteBit(false); // No transfer
+	bsSend.WriteBit(true);
+	bsSend.Write(m_settings.strRelayPassword);
+	m_pNetClient->RPC(RPC_PlayerConnect, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
+	m_state = RELAY_STATE_JOINING;
+	CLogFile::Printf("Connected to %s:%d, getting the world state.", m_settings.strHost.Get(), m_settings.usPort);
+}
+
+void CRelay::OnJoined()
+{
+	// Only take spectators once there is a whole world state to give them
+	m_pNetServer = CNetworkModule::GetNetServerInterface();
+
+	if(!m_pNetServer || !m_pNetServer->Startup(m_settings.usListenPort, m_settings.uiMaxSpectators, m_settings.strListenAddress))
+	{
+		OnFailed("failed to start up the net server");
+		return;
+	}
+
+	m_pNetServer->SetPassword(m_settings.strListenPassword);
+	m_pNetServer->SetPacketHandler(DownstreamPacketHandler);
+	m_state = RELAY_STATE_RELAYING;
+	CLogFile::Printf("Joined the server, taking up to %d spectator(s) on port %d.", m_settings.uiMaxSpectators, m_settings.usListenPort);
+}
+
+void CRelay::OnFailed(const char * szReason)
+{
+	// Only the first reason is interesting (a refused connection is also disconnected)
+	if(m_state == RELAY_STATE_FAILED)
+		return;
+
+	CLogFile::Printf("Relay %s failed: %s.", m_settings.strName.Get(), szReason);
+	m_state = RELAY_STATE_FAILED;
+}
+
+bool CRelay::RewriteJoinedGame(CBitStream * pBitStream, CBitStream * pOut)
+{
+	EntityId playerId;
+	String strHostName;
+	bool bPayAndSpray;
+	bool bAutoAim;
+	unsigned int uiColor;
+	String strHttpServer;
+	unsigned short usHttpPort;
+
+	if(!pBitStream->Read(playerId) || !pBitStream->Read(strHostName) || !pBitStream->Read(bPayAndSpray) ||
+		!pBitStream->Read(bAutoAim) || !pBitStream->Read(uiColor) || !pBitStream->Read(strHttpServer) ||
+		!pBitStream->Read(usHttpPort))
+		return false;
+
+	// An empty http server is the server the client is connected to, the
+	// files of the spectators come from the server and not from us
+	if(strHttpServer.IsEmpty())
+		strHttpServer = m_settings.strHost;
+
+	pOut->Write(playerId);
+	pOut->Write(strHostName);
+	pOut->Write(bPayAndSpray);
+	pOut->Write(bAutoAim);
+	pOut->Write(uiColor);
+	pOut->Write(strHttpServer);
+	pOut->Write(usHttpPort);
+
+	// The rest of the world state is passed on as it is
+	unsigned int uiBits = pBitStream->GetNumberOfUnreadBits();
+
+	if(uiBits > 0)
+	{
+		unsigned char * pData = new unsigned char[BITS_TO_BYTES(uiBits)];
+		pBitStream->ReadBits(pData, uiBits);
+		pOut->WriteBits(pData, uiBits);
+		delete [] pData;
+	}
+
+	return true;
+}
+
+void CRelay::HandleServerRPC(RPCIdentifier rpcId, CBitStream * pBitStream)
+{
+	if(rpcId == RPC_ConnectionRefused)
+	{
+		int iReason = -1;
+		pBitStream->Read(iReason);
+		OnFailed(String("connection refused (reason %d)", iReason).Get());
+		return;
+	}
+
+	// Transferring the relay node would take all the spectators along
+	if(rpcId == RPC_PlayerTransfer)
+		return;
+
+	// Copy the payload behind a reserved rpc header so it is passed on without another copy
+	CBitStream * pForward = new CBitStream();
+	pForward->Reserve(RPC_HEADER_SIZE + pBitStream->GetNumberOfBytesUsed());
+	pForward->PadWithZeroToByteLength(RPC_HEADER_SIZE);
+
+	if(rpcId == RPC_JoinedGame)
+	{
+		if(!RewriteJoinedGame(pBitStream, pForward))
+		{
+			delete pForward;
+			OnFailed("invalid joined game rpc");
+			return;
+		}
+	}
+	else
+		pForward->Write((char *)pBitStream->GetData(), pBitStream->GetNumberOfBytesUsed());
+
+	if(IsSyncRPC(rpcId))
+	{
+		Forward(rpcId, pForward, ((rpcId == RPC_InputAction) ? PRIORITY_HIGH : PRIORITY_LOW), RELIABILITY_UNRELIABLE_SEQUENCED);
+		delete pForward;
+		return;
+	}
+
+	Forward(rpcId, pForward, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED);
+
+	// Keep it for the spectators that join later, once the log is full the
+	// spectators that are there keep getting everything but no more can join
+	unsigned int uiSize = pForward->GetNumberOfBytesUsed();
+
+	if(!m_bLogFull && (m_uiLogSize + uiSize) > m_settings.uiMaxLogSize)
+	{
+		CLogFile::Printf("The log of the world state is full (%d bytes), no more spectators can join.", m_uiLogSize);
+		m_bLogFull = true;
+	}
+
+	if(m_bLogFull)
+	{
+		delete pForward;
+	}
+	else
+	{
+		RelayLogEntry entry;
+		entry.rpcId = rpcId;
+		entry.pBitStream = pForward;
+		m_log.push_back(entry);
+		m_uiLogSize += uiSize;
+	}
+
+	if(rpcId == RPC_JoinedGame && m_state == RELAY_STATE_JOINING)
+		OnJoined();
+}
+
+void CRelay::Forward(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability)
+{
+	if(m_spectators.empty())
+		return;
+
+	// Every spectator gets the same bit stream, the batch fills in the same header for each
+	m_sendStreams.assign(m_spectators.size(), pBitStream);
+	m_pNetServer->RPCReservedBatch(rpcId, &m_sendStreams[0], &m_spectators[0], (unsigned int)m_spectators.size(), priority, reliability);
+	m_ulRpcsForwarded += m_spectators.size();
+	m_ulBytesForwarded += (pBitStream->GetNumberOfBytesUsed() * m_spectators.size());
+}
+
+void CRelay::AddSpectator(EntityId spectatorId, CBitStream * pBitStream)
+{
+	if(std::find(m_spectators.begin(), m_spectators.end(), spectatorId) != m_spectators.end())
+		return;
+
+	int iVersion = 0;
+	String strName;
+	pBitStream->Read(iVersion);
+	pBitStream->Read(strName);
+	CPlayerSocket * pSocket = m_pNetServer->GetPlayerSocket(spectatorId);
+
+	if(!pSocket)
+		return;
+
+	String strAddress = pSocket->GetAddress(true);
+	CBitStream bsSend;
+
+	if(iVersion != NETWORK_VERSION)
+	{
+		bsSend.Write(REFUSE_REASON_INVALID_VERSION);
+		m_pNetServer->RPC(RPC_ConnectionRefused, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE, spectatorId, false);
+		CLogFile::Printf("Spectator %s (%s) refused (invalid version %x).", strAddress.Get(), strName.Get(), iVersion);
+		return;
+	}
+
+	if(m_bLogFull)
+	{
+		bsSend.Write(REFUSE_REASON_RELAY_UNAVAILABLE);
+		m_pNetServer->RPC(RPC_ConnectionRefused, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE, spectatorId, false);
+		CLogFile::Printf("Spectator %s (%s) refused (the log is full).", strAddress.Get(), strName.Get());
+		return;
+	}
+
+	// Replay the world state the way the server sent it to us, everything
+	// forwarded from now on is ordered after it
+	for(std::vector<RelayLogEntry>::iterator iter = m_log.begin(); iter != m_log.end(); iter++)
+		m_pNetServer->RPCReserved((*iter).rpcId, (*iter).pBitStream, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, spectatorId, false);
+
+	m_spectators.push_back(spectatorId);
+	CLogFile::Printf("Spectator %s (%s) joined (%d spectator(s)).", strAddress.Get(), strName.Get(), (int)m_spectators.size());
+}
+
+void CRelay::RemoveSpectator(EntityId spectatorId)
+{
+	std::vector<EntityId>::iterator iter = std::find(m_spectators.begin(), m_spectators.end(), spectatorId);
+
+	if(iter == m_spectators.end())
+		return;
+
+	m_spectators.erase(iter);
+	CLogFile::Printf("Spectator %d left (%d spectator(s)).", spectatorId, (int)m_spectators.size());
+}
+
+void CRelay::Report(unsigned long ulTime)
+{
+	unsigned long ulElapsedTime = (ulTime - m_ulLastReportTime);
+
+	if(ulElapsedTime == 0)
+		return;
+
+	CLogFile::Printf("[Report] %d spectator(s), %lu rpc(s)/s, %lu kb/s forwarded, ping %dms, log %d kb%s",
+		(int)m_spectators.size(), ((m_ulRpcsForwarded * 1000) / ulElapsedTime), ((m_ulBytesForwarded * 1000) / ulElapsedTime / 1024),
+		m_pNetClient->GetAveragePing(), (m_uiLogSize / 1024), (m_bLogFull ? " (full)" : ""));
+	m_ulLastReportTime = ulTime;
+	m_ulRpcsForwarded = 0;
+	m_ulBytesForwarded = 0;
+}
+
+void CRelay::Process()
+{
+	// Handle what the server sent us first so the spectators get it in this tick
+	if(m_pNetClient)
+		m_pNetClient->Process();
+
+	if(m_pNetServer)
+		m_pNetServer->Process();
+
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if(m_state == RELAY_STATE_RELAYING && m_settings.uiReportInterval > 0 && (ulTime - m_ulLastReportTime) >= m_settings.uiReportInterval)
+		Report(ulTime);
+}
@@ -0,0 +1,97 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CRelay.h
+// Project: Server.Relay
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include "Main.h"
+#include <Common.h>
+#include <Network/CNetClientInterface.h>
+#include <Network/CNetServerInterface.h>
+
+// Settings of a relay node, all times are in ms
+struct RelaySettings
+{
+	String                strHost;
+	unsigned short        usPort;
+	String                strPassword;       // Password of the server
+	String                strRelayPassword;  // Relay password of the server
+	String                strName;           // Name of the relay node on the server
+	String                strListenAddress;  // Address the spectators connect to (all if empty)
+	unsigned short        usListenPort;
+	String                strListenPassword; // Password of the spectators
+	unsigned int          uiMaxSpectators;
+	unsigned int          uiMaxLogSize;      // Bytes of reliable rpcs kept for the spectators that join later
+	unsigned int          uiReportInterval;
+};
+
+// A reliable rpc of the server kept to replay it to the spectators that join later
+struct RelayLogEntry
+{
+	RPCIdentifier         rpcId;
+	CBitStream *          pBitStream; // Starts with the reserved rpc header
+};
+
+enum eRelayState
+{
+	// Waiting for the server to accept the connection
+	RELAY_STATE_CONNECTING,
+
+	// Getting the world state from the server
+	RELAY_STATE_JOINING,
+
+	// Joined and taking spectators
+	RELAY_STATE_RELAYING,
+
+	// Refused, disconnected or lost the connection
+	RELAY_STATE_FAILED
+};
+
+// Joins the server as a relay node, which gets the whole game from the server
+// once, and fans it out to many spectators. The spectators are ordinary
+// clients. Everything they send is dropped.
+class CRelay
+{
+private:
+	RelaySettings              m_settings;
+	CNetClientInterface *      m_pNetClient;
+	CNetServerInterface *      m_pNetServer;
+	eRelayState                m_state;
+	std::vector<RelayLogEntry> m_log;
+	unsigned int               m_uiLogSize;
+	bool                       m_bLogFull;
+	std::vector<EntityId>      m_spectators;  // Spectators that got the log
+	std::vector<CBitStream *>  m_sendStreams; // The forwarded rpc once for each spectator
+	unsigned long              m_ulLastReportTime;
+	unsigned long              m_ulRpcsForwarded;
+	unsigned long              m_ulBytesForwarded;
+
+	static void                UpstreamPacketHandler(CPacket * pPacket);
+	static void                DownstreamPacketHandler(CPacket * pPacket);
+	static bool                IsSyncRPC(RPCIdentifier rpcId);
+	void                       OnConnected();
+	void                       OnJoined();
+	void                       OnFailed(const char * szReason);
+	void                       HandleServerRPC(RPCIdentifier rpcId, CBitStream * pBitStream);
+	bool                       RewriteJoinedGame(CBitStream * pBitStream, CBitStream * pOut);
+	void                       Forward(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability);
+	void                       AddSpectator(EntityId spectatorId, CBitStream * pBitStream);
+	void                       RemoveSpectator(EntityId spectatorId);
+	void                       Report(unsigned long ulTime);
+
+public:
+	CRelay(const RelaySettings& settings);
+	~CRelay();
+
+	bool                       Connect();
+	bool                       IsFinished() { return (m_state == RELAY_STATE_FAILED); }
+	void                       Process();
+};
+
+extern CRelay * g_pRelay;
@@ -0,0 +1,140 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: Main.cpp
+// Project: Server.Relay
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "Main.h"
+#include "CRelay.h"
+#include <Network/CNetworkModule.h>
+#include <SharedUtility.h>
+#include <CLogFile.h>
+
+// Time in ms the main loop sleeps between two relay updates
+#define RELAY_PROCESS_INTERVAL 2
+
+extern CRelay * g_pRelay;
+
+bool g_bRunning = true;
+
+void SignalHandler(int iSignal)
+{
+	g_bRunning = false;
+}
+
+void PrintUsage()
+{
+	CLogFile::Print("Usage: ivmp-relay [options]");
+	CLogFile::Print("  -host <address>            Server address (default 127.0.0.1)");
+	CLogFile::Print("  -port <port>               Server port (default 9999)");
+	CLogFile::Print("  -password <password>       Server password");
+	CLogFile::Print("  -relaypassword <password>  Relay password of the server (relaypassword in its settings)");
+	CLogFile::Print("  -name <name>               Name of the relay on the server (default Relay)");
+	CLogFile::Print("  -listenaddress <address>   Address the spectators connect to (default all)");
+	CLogFile::Print("  -listenport <port>         Port the spectators connect to (default 9999)");
+	CLogFile::Print("  -listenpassword <password> Password of the spectators");
+	CLogFile::Print("  -spectators <count>        Maximum amount of spectators (default 500)");
+	CLogFile::Print("  -maxlog <kb>               World state kept for the spectators that join later (default 16384)");
+	CLogFile::Print("  -report <ms>               Time between two reports, 0 disables them (default 10000)");
+}
+
+int main(int argc, char ** argv)
+{
+	// Open the log file
+	CLogFile::Open("ivmp-relay.log", true);
+
+	RelaySettings settings;
+	settings.strHost = "127.0.0.1";
+	settings.usPort = 9999;
+	settings.strName = "Relay";
+	settings.usListenPort = 9999;
+	settings.uiMaxSpectators = 500;
+	settings.uiMaxLogSize = (16384 * 1024);
+	settings.uiReportInterval = 10000;
+
+	// Parse the command line
+	for(int i = 1; i < argc; i++)
+	{
+		String strOption = argv[i];
+
+		if(strOption == "-help" || strOption == "-h" || (i + 1) >= argc)
+		{
+			PrintUsage();
+			return 0;
+		}
+
+		String strValue = argv[++i];
+
+		if(strOption == "-host")
+			settings.strHost = strValue;
+		else if(strOption == "-port")
+			settings.usPort = (unsigned short)strValue.ToInteger();
+		else if(strOption == "-password")
+			settings.strPassword = strValue;
+		else if(strOption == "-relaypassword")
+			settings.strRelayPassword = strValue;
+		else if(strOption == "-name")
+			settings.strName = strValue;
+		else if(strOption == "-listenaddress")
+			settings.strListenAddress = strValue;
+		else if(strOption == "-listenport")
+			settings.usListenPort = (unsigned short)strValue.ToInteger();
+		else if(strOption == "-listenpassword")
+			settings.strListenPassword = strValue;
+		else if(strOption == "-spectators")
+			settings.uiMaxSpectators = (unsigned int)strValue.ToInteger();
+		else if(strOption == "-maxlog")
+			settings.uiMaxLogSize = ((unsigned int)strValue.ToInteger() * 1024);
+		else if(strOption == "-report")
+			settings.uiReportInterval = (unsigned int)strValue.ToInteger();
+		else
+		{
+			CLogFile::Printf("Unknown option %s.", strOption.Get());
+			PrintUsage();
+			return 0;
+		}
+	}
+
+	if(settings.strRelayPassword.IsEmpty())
+	{
+		CLogFile::Print("The relay password of the server is required (-relaypassword).");
+		return 1;
+	}
+
+	if(settings.strName.IsEmpty() || settings.strName.GetLength() > MAX_NAME_LENGTH)
+	{
+		CLogFile::Printf("The relay name can be at most %d characters long.", MAX_NAME_LENGTH);
+		return 1;
+	}
+
+	// Load the network module
+	if(!CNetworkModule::Init())
+	{
+		CLogFile::Print("Failed to load the network module.");
+		return 1;
+	}
+
+	signal(SIGINT, SignalHandler);
+	signal(SIGTERM, SignalHandler);
+	CLogFile::Printf("Relaying %s:%d.", settings.strHost.Get(), settings.usPort);
+	g_pRelay = new CRelay(settings);
+	g_pRelay->Connect();
+
+	while(g_bRunning && !g_pRelay->IsFinished())
+	{
+		g_pRelay->Process();
+		Sleep(RELAY_PROCESS_INTERVAL);
+	}
+
+	CLogFile::Print("Stopping the relay.");
+	SAFE_DELETE(g_pRelay);
+	CNetworkModule::Shutdown();
+	CLogFile::Close();
+	return 0;
+}
@@ -0,0 +1,195 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CChecksumCache.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CChecksumCache.h"
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+CChecksumCache::CChecksumCache(String strPath)
+	: m_strPath(strPath),
+	m_bChanged(false)
+{
+	Load();
+}
+
+CChecksumCache::~CChecksumCache()
+{
+	Save();
+}
+
+bool CChecksumCache::GetFileInfo(String strFilePath, ChecksumCacheEntry &entry)
+{
+	struct stat St;
+
+	if(stat(strFilePath.Get(), &St) != 0)
+		return false;
+
+	entry.uiSize = (unsigned int)St.st_size;
+	entry.uiModifiedTime = (unsigned int)St.st_mtime;
+#ifdef WIN32
+	// stat doesn't give us a file index on windows
+	entry.uiVolume = 0;
+	entry.ullFileIndex = 0;
+	HANDLE hFile = CreateFile(strFilePath.Get(), FILE_READ_ATTRIBUTES, (FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE), NULL, OPEN_EXISTING, 0, NULL);
+
+	if(hFile != INVALID_HANDLE_VALUE)
+	{
+		BY_HANDLE_FILE_INFORMATION fileInformation;
+
+		if(GetFileInformationByHandle(hFile, &fileInformation))
+		{
+			entry.uiVolume = fileInformation.dwVolumeSerialNumber;
+			entry.ullFileIndex = (((unsigned long long)fileInformation.nFileIndexHigh << 32) | fileInformation.nFileIndexLow);
+		}
+
+		CloseHandle(hFile);
+	}
+#else
+	entry.uiVolume = (unsigned int)St.st_dev;
+	entry.ullFileIndex = (unsigned long long)St.st_ino;
+#endif
+	return true;
+}
+
+void CChecksumCache::Load()
+{
+	FILE * pFile = fopen(m_strPath.Get(), "rb");
+
+	if(!pFile)
+		return;
+
+	// Is the cache file from this version?
+	ChecksumCacheHeader header;
+
+	if(fread(&header, sizeof(header), 1, pFile) != 1 || header.uiMagic != CHECKSUM_CACHE_MAGIC || 
+		header.uiVersion != CHECKSUM_CACHE_VERSION)
+	{
+		fclose(pFile);
+		return;
+	}
+
+	// Read the entries, a broken entry ends the cache
+	for(unsigned int i = 0; i < header.uiEntries; i++)
+	{
+		unsigned int uiLength;
+
+		if(fread(&uiLength, sizeof(uiLength), 1, pFile) != 1 || uiLength == 0 || uiLength > 4096)
+			break;
+
+		char * szFilePath = new char[uiLength + 1];
+		ChecksumCacheEntry entry;
+		bool bRead = (fread(szFilePath, 1, uiLength, pFile) == uiLength && fread(&entry, sizeof(entry), 1, pFile) == 1);
+		szFilePath[uiLength] = '\0';
+
+		if(bRead)
+			m_entries[szFilePath] = entry;
+
+		delete [] szFilePath;
+
+		if(!bRead)
+			break;
+	}
+
+	fclose(pFile);
+}
+
+bool CChecksumCache::GetCachedChecksum(String strFilePath, const ChecksumCacheEntry &fileInfo, CFileChecksum &fileChecksum)
+{
+	// Did the file not change since it was last checksummed?
+	std::map<String, ChecksumCacheEntry>::iterator iter = m_entries.find(strFilePath);
+
+	if(iter != m_entries.end() && iter->second.uiSize == fileInfo.uiSize && iter->second.uiModifiedTime == fileInfo.uiModifiedTime && 
+		iter->second.uiVolume == fileInfo.uiVolume && iter->second.ullFileIndex == fileInfo.ullFileIndex)
+	{
+		fileChecksum = iter->second.fileChecksum;
+		return true;
+	}
+
+	return false;
+}
+
+void CChecksumCache::SetChecksum(String strFilePath, const ChecksumCacheEntry &entry)
+{
+	m_entries[strFilePath] = entry;
+	m_bChanged = true;
+}
+
+bool CChecksumCache::GetChecksum(String strFilePath, CFileChecksum &fileChecksum, unsigned int * puiSize)
+{
+	ChecksumCacheEntry entry;
+
+	if(!GetFileInfo(strFilePath, entry))
+	{
+		Remove(strFilePath);
+		return false;
+	}
+
+	if(puiSize)
+		*puiSize = entry.uiSize;
+
+	if(GetCachedChecksum(strFilePath, entry, fileChecksum))
+		return true;
+
+	if(!fileChecksum.Calculate(strFilePath))
+	{
+		Remove(strFilePath);
+		return false;
+	}
+
+	entry.fileChecksum = fileChecksum;
+	SetChecksum(strFilePath, entry);
+	return true;
+}
+
+void CChecksumCache::Remove(String strFilePath)
+{
+	std::map<String, ChecksumCacheEntry>::iterator iter = m_entries.find(strFilePath);
+
+	if(iter != m_entries.end())
+	{
+		m_entries.erase(iter);
+		m_bChanged = true;
+	}
+}
+
+void CChecksumCache::Save()
+{
+	if(!m_bChanged)
+		return;
+
+	FILE * pFile = fopen(m_strPath.Get(), "wb");
+
+	if(!pFile)
+		return;
+
+	ChecksumCacheHeader header;
+	header.uiMagic = CHECKSUM_CACHE_MAGIC;
+	header.uiVersion = CHECKSUM_CACHE_VERSION;
+	header.uiEntries = m_entries.size();
+	bool bSaved = (fwrite(&header, sizeof(header), 1, pFile) == 1);
+
+	for(std::map<String, ChecksumCacheEntry>::iterator iter = m_entries.begin(); bSaved && iter != m_entries.end(); iter++)
+	{
+		unsigned int uiLength = iter->first.GetLength();
+		bSaved = (fwrite(&uiLength, sizeof(uiLength), 1, pFile) == 1 && fwrite(iter->first.Get(), 1, uiLength, pFile) == uiLength &&
+			fwrite(&iter->second, sizeof(iter->second), 1, pFile) == 1);
+	}
+
+	fclose(pFile);
+
+	// Don't leave broken cache files around
+	if(!bSaved)
+		remove(m_strPath.Get());
+	else
+		m_bChanged = false;
+}
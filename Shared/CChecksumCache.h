@@ -0,0 +1,78 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CChecksumCache.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include "CString.h"
+#include "CFileChecksum.h"
+
+// Identifies a checksum cache file ('IVCS')
+#define CHECKSUM_CACHE_MAGIC 0x53435649
+
+// Name of the checksum cache file
+#define CHECKSUM_CACHE_FILE "checksums.dat"
+
+// Increase this whenever the cache file layout (or the checksum) changes
+#define CHECKSUM_CACHE_VERSION 2
+
+// Header at the start of the checksum cache file, followed by the entries
+struct ChecksumCacheHeader
+{
+	unsigned int uiMagic;
+	unsigned int uiVersion;
+	unsigned int uiEntries;
+};
+
+// A file checksum and the size, modification time and identity (volume and file
+// index) of the file it was calculated from
+struct ChecksumCacheEntry
+{
+	unsigned int       uiSize;
+	unsigned int       uiModifiedTime;
+	unsigned int       uiVolume;
+	unsigned long long ullFileIndex;
+	CFileChecksum      fileChecksum;
+};
+
+// Keeps the checksums of files on disk so files that didn't change since they
+// were last checksummed (same size, modification time and identity) aren't read
+// again. A cache is only used by one thread at a time.
+class CChecksumCache
+{
+private:
+	String                               m_strPath;
+	std::map<String, ChecksumCacheEntry> m_entries;
+	bool                                 m_bChanged;
+
+	void        Load();
+
+public:
+	CChecksumCache(String strPath);
+	~CChecksumCache();
+
+	// Gets the size, modification time and identity of the file into the entry
+	static bool GetFileInfo(String strFilePath, ChecksumCacheEntry &entry);
+
+	// Gets the checksum of the file from the cache if the file info is the same as
+	// when it was checksummed, the file info comes from GetFileInfo
+	bool        GetCachedChecksum(String strFilePath, const ChecksumCacheEntry &fileInfo, CFileChecksum &fileChecksum);
+
+	// Stores the checksum of the file with the file info it was calculated for
+	void        SetChecksum(String strFilePath, const ChecksumCacheEntry &entry);
+
+	// Gets the checksum (and size) of the file from the cache or calculates it if the file changed
+	bool        GetChecksum(String strFilePath, CFileChecksum &fileChecksum, unsigned int * puiSize = NULL);
+
+	// Forgets the checksum of the file, use this when the file is replaced
+	void        Remove(String strFilePath);
+
+	// Writes the cache file if any checksum changed
+	void        Save();
+};
@@ -7,12 +7,18 @@
 //
 //==============================================================================
 
+#pragma once
+
 #include <map>
-#include <list>
+#include <vector>
 
 #include <Scripting/CSquirrelArguments.h>
 #include <Scripting/CSquirrel.h>
 #include <Scripting/CScriptingManager.h>
+#include <Scripting/CScriptProfiler.h>
+#include <Scripting/CScriptWatchdog.h>
+#include <CTraceRecorder.h>
+#include <SharedUtility.h>
 // FIXUPDATE
 // jenksta: this is kinda hacky :/
 #ifdef _SERVER
@@ -44,7 +50,8 @@ class CSquirrelEventHandler : public CEventHandler
 public:
 	CSquirrelEventHandler(SQVM * pVM, SQObjectPtr pFunction)
 	{
-		m_pVM = pVM;
+		// Handlers added by a coroutine belong to its script
+		m_pVM = g_pScriptingManager->GetScriptVM(pVM);
 		m_pFunction = pFunction;
 	}
 
@@ -88,110 +95,438 @@ public:
 	}
 };
 #endif
-class CEvents : public std::map< String, std::list< CEventHandler* > >
+typedef unsigned int EventId;
+
 #ifdef _SERVER
-	, public CEventsInterface
+// Decides which scripts get an event that isn't for a specific script
+class CEventFilter
+{
+public:
+	virtual bool IsFiltered(EventId eventId, const String& strName, CSquirrelArguments * pArguments, SQVM * pVM) = 0;
+};
+
+extern CEventFilter * g_pEventFilter;
 #endif
+
+#define INVALID_EVENT_ID 0xFFFFFFFF
+
+// Key of the samples of events that aren't for a player
+#define EVENT_SAMPLE_KEY_NONE 0xFFFFFFFF
+
+// Events which are called often enough to skip the name lookup, their ids
+// are registered in this order when CEvents is created
+enum eBuiltinEvent
+{
+	EVENT_SERVER_PULSE,
+	EVENT_FRAME_RENDER,
+	EVENT_PLAYER_SYNC_RECEIVED,
+	EVENT_PLAYER_ONFOOT_SYNC_RECEIVED,
+	EVENT_PLAYER_INVEHICLE_SYNC_RECEIVED,
+	EVENT_PLAYER_PASSENGER_SYNC_RECEIVED,
+	EVENT_PLAYER_SMALL_SYNC_RECEIVED,
+	EVENT_PLAYER_EMPTY_VEHICLE_SYNC_RECEIVED,
+	EVENT_PLAYER_CHANGE_PAD_STATE,
+	EVENT_PLAYER_CHANGE_CONTROL_STATE,
+	EVENT_HEAD_MOVE,
+	EVENT_PLAYER_ENTER_ZONE,
+	EVENT_PLAYER_LEAVE_ZONE,
+	EVENT_BUILTIN_MAX
+};
+
+static const char * g_szBuiltinEventNames[EVENT_BUILTIN_MAX] =
+{
+	"serverPulse",
+	"frameRender",
+	"playerSyncReceived",
+	"playerOnFootSyncReceived",
+	"playerInVehicleSyncReceived",
+	"playerPassengerSyncReceived",
+	"playerSmallSyncReceived",
+	"playerEmptyVehicleSyncReceived",
+	"playerChangePadState",
+	"playerChangeControlState",
+	"headMove",
+	"playerEnterZone",
+	"playerLeaveZone"
+};
+
+#ifdef _SERVER
+// The latest sample of an event for a throttled handler
+struct EventSample
+{
+	unsigned int       uiLastCallTime;
+	bool               bPending;
+	CSquirrelArguments arguments;
+
+	EventSample() { uiLastCallTime = 0; bPending = false; }
+};
+
+// A script handler of a frequent event which is called at most once per
+// interval (and key), the samples in between are coalesced so it only gets
+// the latest one
+class CThrottledEventHandler
 {
 public:
-	~CEvents()
+	EventId                                 eventId;
+	CSquirrelEventHandler                   handler;
+	unsigned int                            uiInterval;
+	bool                                    bRemoved;
+	std::map< unsigned int, EventSample >   samples;
+
+	CThrottledEventHandler(EventId id, const CSquirrelEventHandler& eventHandler, unsigned int uiCallInterval)
+		: handler(eventHandler)
 	{
-		clear();
+		eventId = id;
+		uiInterval = uiCallInterval;
+		bRemoved = false;
 	}
+};
+#endif
 
-	bool Add(String strName, CEventHandler* pEventHandler)
+// Event names are interned into ids when they are first used, the handlers
+// of each event are kept in a vector indexed by its id
+class CEvents
+#ifdef _SERVER
+	: public CEventsInterface
+#endif
+{
+private:
+	std::map< String, EventId >                   m_eventIds;
+	std::vector< String >                        m_eventNames;
+	std::vector< std::vector< CEventHandler* > > m_handlers;
+#ifdef _SERVER
+	std::vector< CThrottledEventHandler* >       m_throttledHandlers;
+	bool                                         m_bProcessingSamples;
+
+	// Deletes the throttled handlers that were removed (they can't be deleted
+	// while their samples are delivered)
+	void DeleteRemovedThrottledHandlers()
 	{
-		// Any events with that name?
-		CEvents::iterator iter = find(strName);
-		if(iter != end())
+		for(std::vector< CThrottledEventHandler* >::iterator iter = m_throttledHandlers.begin(); iter != m_throttledHandlers.end(); )
 		{
-			// Event exists, check if the function is registered already
-			for(std::list< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); ++ iter2)
+			if((*iter)->bRemoved)
 			{
-				if(pEventHandler->equals(*iter2))
-					return false;
+				delete *iter;
+				iter = m_throttledHandlers.erase(iter);
 			}
+			else
+				iter ++;
 		}
-		else
-		{
-			// new - create the event
-			std::pair< std::map< String, std::list< CEventHandler* > >::iterator, bool > ret;
-			ret = insert(std::pair< String, std::list< CEventHandler* > >( strName, std::list< CEventHandler* >( ) ) );
+	}
+
+	void RemoveThrottledHandler(unsigned int uiIndex)
+	{
+		m_throttledHandlers[uiIndex]->bRemoved = true;
+
+		if(!m_bProcessingSamples)
+			DeleteRemovedThrottledHandlers();
+	}
+#endif
+
+public:
+	CEvents()
+	{
+#ifdef _SERVER
+		m_bProcessingSamples = false;
+#endif
 
-			iter = ret.first;
+		for(int i = 0; i < EVENT_BUILTIN_MAX; i++)
+			GetEventId(g_szBuiltinEventNames[i]);
+	}
+
+	~CEvents()
+	{
+		clear();
+	}
+
+	// Returns the id of the event with this name, registering it if needed
+	EventId GetEventId(const String& strName)
+	{
+		std::map< String, EventId >::iterator iter = m_eventIds.find(strName);
+
+		if(iter != m_eventIds.end())
+			return (*iter).second;
+
+		EventId eventId = (EventId)m_handlers.size();
+		m_eventIds.insert(std::pair< String, EventId >(strName, eventId));
+		m_eventNames.push_back(strName);
+		m_handlers.push_back(std::vector< CEventHandler* >());
+		return eventId;
+	}
+
+	// Returns the id of the event with this name or INVALID_EVENT_ID if it was never used
+	EventId FindEventId(const String& strName)
+	{
+		std::map< String, EventId >::iterator iter = m_eventIds.find(strName);
+
+		if(iter != m_eventIds.end())
+			return (*iter).second;
+
+		return INVALID_EVENT_ID;
+	}
+
+	String GetEventName(EventId eventId)
+	{
+		if(eventId >= m_eventNames.size())
+			return String();
+
+		return m_eventNames[eventId];
+	}
+
+	// Removes all handlers, the event ids stay valid
+	void clear()
+	{
+		for(std::vector< std::vector< CEventHandler* > >::iterator iter = m_handlers.begin(); iter != m_handlers.end(); ++ iter)
+			(*iter).clear();
+
+#ifdef _SERVER
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+			m_throttledHandlers[i]->bRemoved = true;
+
+		if(!m_bProcessingSamples)
+			DeleteRemovedThrottledHandlers();
+#endif
+	}
+
+	bool Add(const String& strName, CEventHandler* pEventHandler)
+	{
+		return Add(GetEventId(strName), pEventHandler);
+	}
+
+	bool Add(EventId eventId, CEventHandler* pEventHandler)
+	{
+		if(eventId >= m_handlers.size())
+			return false;
+
+		std::vector< CEventHandler* > * pHandlers = &m_handlers[eventId];
+
+		// Check if the function is registered already
+		for(std::vector< CEventHandler* >::iterator iter = pHandlers->begin(); iter != pHandlers->end(); ++ iter)
+		{
+			if(pEventHandler->equals(*iter))
+				return false;
 		}
 
 		// insert the handler
-		(*iter).second.push_back(pEventHandler);
+		pHandlers->push_back(pEventHandler);
 		return true;
 	}
 
-	bool Remove(String strName, CEventHandler* pEventHandler)
+	bool Remove(const String& strName, CEventHandler* pEventHandler)
 	{
-		// Any events with that name?
-		CEvents::iterator iter = find(strName);
-		if(iter != end())
-		{
-			// Check if it exists, if so remove it
-			bool bRemoved = false;
-			for(std::list< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); )
-			{
-				if(pEventHandler->equals(*iter2))
-				{
-					(*iter).second.erase(iter2++);
-					bRemoved = true;
-					break;
-				}
-				else
-					iter2 ++;
-			}
+		EventId eventId = FindEventId(strName);
+
+		// no such event - can't remove handlers
+		if(eventId == INVALID_EVENT_ID)
+			return false;
 
-			if(bRemoved)
+		return Remove(eventId, pEventHandler);
+	}
+
+	bool Remove(EventId eventId, CEventHandler* pEventHandler)
+	{
+		if(eventId >= m_handlers.size())
+			return false;
+
+		std::vector< CEventHandler* > * pHandlers = &m_handlers[eventId];
+
+		// Check if it exists, if so remove it
+		for(std::vector< CEventHandler* >::iterator iter = pHandlers->begin(); iter != pHandlers->end(); ++ iter)
+		{
+			if(pEventHandler->equals(*iter))
 			{
-				// remove the event list if it is empty
-				if((*iter).second.size() == 0)
-				{
-					erase(iter);
-				}
+				pHandlers->erase(iter);
+				return true;
 			}
-
-			return bRemoved;
 		}
 
-		// no such event - can't remove handlers
 		return false;
 	}
 
 	bool RemoveScript(SQVM * pVM)
 	{
-		for(CEvents::iterator iter = begin(); iter != end(); )
+		for(std::vector< std::vector< CEventHandler* > >::iterator iter = m_handlers.begin(); iter != m_handlers.end(); ++ iter)
 		{
-			for(std::list< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); )
+			for(std::vector< CEventHandler* >::iterator iter2 = (*iter).begin(); iter2 != (*iter).end(); )
 			{
 				if((*iter2)->GetScript() == pVM)
-					(*iter).second.erase(iter2++);
+					iter2 = (*iter).erase(iter2);
 				else
 					iter2 ++;
 			}
+		}
 
-			// remove events with no handlers
-			if((*iter).second.size() == 0)
-				erase(iter++);
-			else
-				iter++;
+#ifdef _SERVER
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+		{
+			if(m_throttledHandlers[i]->handler.GetScript() == pVM)
+				m_throttledHandlers[i]->bRemoved = true;
 		}
 
+		if(!m_bProcessingSamples)
+			DeleteRemovedThrottledHandlers();
+#endif
+
 		return true;
 	}
 
-	bool IsEventRegistered(String eventName)
+	bool IsEventRegistered(const String& eventName)
 	{		
 		// TODO: Add checking for special script also
-		CEvents::iterator iter = find(eventName);
-		return iter != end();
+		return IsEventRegistered(FindEventId(eventName));
+	}
+
+	bool IsEventRegistered(EventId eventId)
+	{
+		return (eventId < m_handlers.size() && !m_handlers[eventId].empty());
 	}
 
 #ifdef _SERVER
+	// Events the server samples for throttled handlers, the others are only
+	// called at the full rate
+	static bool IsSampledEvent(EventId eventId)
+	{
+		return (eventId == EVENT_SERVER_PULSE || (eventId >= EVENT_PLAYER_SYNC_RECEIVED && eventId <= EVENT_PLAYER_CHANGE_CONTROL_STATE));
+	}
+
+	// Adds a handler which gets the event at most once every interval (in ms),
+	// per player for player events. It is called whether frequent events are
+	// enabled or not, its return value is ignored.
+	bool AddThrottled(const String& strName, const CSquirrelEventHandler& eventHandler, unsigned int uiInterval)
+	{
+		EventId eventId = FindEventId(strName);
+
+		if(!IsSampledEvent(eventId))
+			return false;
+
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+		{
+			CThrottledEventHandler * pHandler = m_throttledHandlers[i];
+
+			// Adding it again only changes the interval
+			if(!pHandler->bRemoved && pHandler->eventId == eventId && eventHandler.equals(&pHandler->handler))
+			{
+				pHandler->uiInterval = uiInterval;
+				return true;
+			}
+		}
+
+		m_throttledHandlers.push_back(new CThrottledEventHandler(eventId, eventHandler, uiInterval));
+		return true;
+	}
+
+	bool RemoveThrottled(const String& strName, const CSquirrelEventHandler& eventHandler)
+	{
+		EventId eventId = FindEventId(strName);
+
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+		{
+			CThrottledEventHandler * pHandler = m_throttledHandlers[i];
+
+			if(!pHandler->bRemoved && pHandler->eventId == eventId && eventHandler.equals(&pHandler->handler))
+			{
+				RemoveThrottledHandler(i);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool HasThrottledHandlers(EventId eventId)
+	{
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+		{
+			if(m_throttledHandlers[i]->eventId == eventId && !m_throttledHandlers[i]->bRemoved)
+				return true;
+		}
+
+		return false;
+	}
+
+	// Stores the arguments as the latest sample of the event for its throttled
+	// handlers, they get it the next time ProcessSamples finds them due
+	void Sample(EventId eventId, CSquirrelArguments* pArguments, unsigned int uiKey = EVENT_SAMPLE_KEY_NONE)
+	{
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+		{
+			CThrottledEventHandler * pHandler = m_throttledHandlers[i];
+
+			if(pHandler->eventId != eventId || pHandler->bRemoved)
+				continue;
+
+			EventSample * pSample = &pHandler->samples[uiKey];
+			pSample->bPending = true;
+			pSample->arguments = *pArguments;
+		}
+	}
+
+	// Drops the samples of a key (a player that left)
+	void RemoveSamples(unsigned int uiKey)
+	{
+		for(unsigned int i = 0; i < m_throttledHandlers.size(); i++)
+		{
+			std::map< unsigned int, EventSample > * pSamples = &m_throttledHandlers[i]->samples;
+
+			// The samples are iterated while they are delivered, they are only dropped then
+			if(m_bProcessingSamples)
+			{
+				std::map< unsigned int, EventSample >::iterator iter = pSamples->find(uiKey);
+
+				if(iter != pSamples->end())
+					(*iter).second.bPending = false;
+			}
+			else
+				pSamples->erase(uiKey);
+		}
+	}
+
+	// Calls the throttled handlers with their latest samples once their
+	// interval has passed, called once per tick
+	void ProcessSamples()
+	{
+		if(m_throttledHandlers.empty())
+			return;
+
+		unsigned int uiNow = SharedUtility::GetFrameTime();
+		m_bProcessingSamples = true;
+
+		// Handlers added by the calls are processed from the next time on
+		unsigned int uiHandlers = m_throttledHandlers.size();
+
+		for(unsigned int i = 0; i < uiHandlers; i++)
+		{
+			CThrottledEventHandler * pHandler = m_throttledHandlers[i];
+
+			for(std::map< unsigned int, EventSample >::iterator iter = pHandler->samples.begin(); iter != pHandler->samples.end() && !pHandler->bRemoved; ++ iter)
+			{
+				EventSample * pSample = &(*iter).second;
+
+				if(!pSample->bPending || (uiNow - pSample->uiLastCallTime) < pHandler->uiInterval)
+					continue;
+
+				pSample->bPending = false;
+				pSample->uiLastCallTime = uiNow;
+
+				// Scripts of other instances don't get the events of the player
+				if(g_pEventFilter && g_pEventFilter->IsFiltered(pHandler->eventId, m_eventNames[pHandler->eventId], &pSample->arguments, pHandler->handler.GetScript()))
+					continue;
+
+				// The handler can add samples, so the map can change during the call
+				CSquirrelArguments arguments(pSample->arguments);
+				CSquirrelArgument pReturn(1);
+				unsigned int uiProfilerDepth = (g_pScriptProfiler ? g_pScriptProfiler->EnterFrame(SCRIPT_PROFILER_EVENT, m_eventNames[pHandler->eventId]) : SCRIPT_PROFILER_NO_FRAME);
+				pHandler->handler.Call(&arguments, &pReturn);
+
+				if(g_pScriptProfiler)
+					g_pScriptProfiler->LeaveFrame(uiProfilerDepth);
+			}
+		}
+
+		m_bProcessingSamples = false;
+		DeleteRemovedThrottledHandlers();
+	}
+
 	bool AddModuleEvent(const char* szName, EventHandler_t pfnHandler, void* pChunk = 0)
 	{
 		return Add(szName, new CModuleEventHandler(pfnHandler, pChunk));
@@ -209,37 +544,83 @@ public:
 
 #endif
 
-	CSquirrelArgument Call(String strName, CSquirrel* pScript = NULL)
+	CSquirrelArgument Call(const String& strName, CSquirrel* pScript = NULL)
+	{
+		return Call(FindEventId(strName), pScript);
+	}
+
+	CSquirrelArgument Call(const String& strName, CSquirrelArguments* pArguments, CSquirrel* pScript = NULL)
+	{
+		return Call(FindEventId(strName), pArguments, pScript);
+	}
+
+	void Call(const String& strName, CSquirrelArguments* pArguments, CSquirrelArgument* pReturn, CSquirrel* pScript = NULL)
+	{
+		Call(FindEventId(strName), pArguments, pReturn, pScript);
+	}
+
+	CSquirrelArgument Call(EventId eventId, CSquirrel* pScript = NULL)
 	{
 		CSquirrelArgument pReturn(1);
-		Call(strName, &CSquirrelArguments(), &pReturn, pScript);
+
+		if(IsEventRegistered(eventId))
+		{
+			CSquirrelArguments arguments;
+			Call(eventId, &arguments, &pReturn, pScript);
+		}
+
 		return pReturn;
 	}
 
-	CSquirrelArgument Call(String strName, CSquirrelArguments* pArguments, CSquirrel* pScript = NULL)
+	CSquirrelArgument Call(EventId eventId, CSquirrelArguments* pArguments, CSquirrel* pScript = NULL)
 	{
 		CSquirrelArgument pReturn(1);
-		Call(strName, pArguments, &pReturn, pScript);
+		Call(eventId, pArguments, &pReturn, pScript);
 		return pReturn;
 	}
 
-	void Call(String strName, CSquirrelArguments* pArguments, CSquirrelArgument* pReturn, CSquirrel* pScript = NULL)
+	void Call(EventId eventId, CSquirrelArguments* pArguments, CSquirrelArgument* pReturn, CSquirrel* pScript = NULL)
 	{
+		// Any handlers for this event?
+		if(!IsEventRegistered(eventId))
+			return;
+
 		SQVM* pVM = pScript ? pScript->GetVM() : 0;
 
-		// Any events with that name?
-		CEvents::iterator iter = find(strName);
-		if(iter != end())
+		// The handlers can add events (which moves the names), the trace gets a copy
+		String strTraceName;
+
+		if(CTraceRecorder::IsEnabled())
+			strTraceName = m_eventNames[eventId];
+
+		CTraceScope traceScope(TRACE_CATEGORY_EVENT, strTraceName.Get());
+
+		// Sync events can be deferred to the next tick for scripts over their tick budget
+		bool bDeferrable = (g_pScriptWatchdog && eventId >= EVENT_PLAYER_SYNC_RECEIVED && eventId <= EVENT_HEAD_MOVE);
+		unsigned int uiProfilerDepth = (g_pScriptProfiler ? g_pScriptProfiler->EnterFrame(SCRIPT_PROFILER_EVENT, m_eventNames[eventId]) : SCRIPT_PROFILER_NO_FRAME);
+
+		// loop through all handlers (by index as handlers can add and remove events)
+		for(unsigned int i = 0; i < m_handlers[eventId].size(); i++)
 		{
-			// loop through all handlers
-			for(std::list< CEventHandler* >::iterator iter2 = (*iter).second.begin(); iter2 != (*iter).second.end(); ++ iter2)
+			CEventHandler * pHandler = m_handlers[eventId][i];
+
+			// not for a specific script; or that script is the one we want
+			if(!pVM || pVM == pHandler->GetScript())
 			{
-				// not for a specific script; or that script is the one we want
-				if(!pVM || pVM == (*iter2)->GetScript())
-				{
-					(*iter2)->Call(pArguments, pReturn);
-				}
+#ifdef _SERVER
+				// Scripts of other instances don't get the events of the player
+				if(!pVM && g_pEventFilter && pHandler->GetScript() && g_pEventFilter->IsFiltered(eventId, m_eventNames[eventId], pArguments, pHandler->GetScript()))
+					continue;
+#endif
+
+				if(bDeferrable && g_pScriptWatchdog->Defer(pHandler->GetScript(), pHandler->GetFunction(), pArguments))
+					continue;
+
+				pHandler->Call(pArguments, pReturn);
 			}
 		}
+
+		if(g_pScriptProfiler)
+			g_pScriptProfiler->LeaveFrame(uiProfilerDepth);
 	}
 };
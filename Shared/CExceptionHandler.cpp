@@ -241,6 +241,9 @@ void CExceptionHandler::WriteExceptionReport()
 
 	// Print a message in the log file
 	CLogFile::Printf("IV:MP has crashed. Please see %s for more information.", strLogPath.Get());
+
+	// Make sure the messages waiting for the log writer make it to the file
+	CLogFile::Flush();
 }
 
 #ifdef WIN32
@@ -255,6 +258,7 @@ void CExceptionHandler::ExceptionHandler(int iSignal)
 #endif
 	// Exit the current process
 #ifndef WIN32
+	CLogFile::Flush();
 	exit(0);
 #else
 	SharedUtility::_TerminateProcess("GTAIV.exe");
@@ -13,6 +13,13 @@
 #include <CString.h>
 #include <SharedUtility.h>
 #include <stdio.h>
+#include <string.h>
+
+// Size in bytes of the blocks files are read in
+#define CHECKSUM_READ_BUFFER_SIZE 65536
+
+// Uri of the folder of the client files that are named by their content
+#define HASHED_FILES_URI "/files"
 
 #define ADD_TEMPLATE(in, size) \
 	/* Add to the checksum */ \
@@ -86,6 +93,26 @@ static const unsigned int uiCrc32Table[256] =
 	0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
+// Tables to add 8 bytes at once (slicing by 8), uiTables[0] is the table above and
+// uiTables[i][n] is the checksum of byte n followed by i zero bytes
+struct Crc32SliceTables
+{
+	unsigned int uiTables[8][256];
+
+	Crc32SliceTables()
+	{
+		memcpy(uiTables[0], uiCrc32Table, sizeof(uiCrc32Table));
+
+		for(int i = 1; i < 8; i++)
+		{
+			for(int n = 0; n < 256; n++)
+				uiTables[i][n] = ((uiTables[i - 1][n] >> 8) ^ uiCrc32Table[uiTables[i - 1][n] & 0xFF]);
+		}
+	}
+};
+
+static const Crc32SliceTables crc32SliceTables;
+
 class CChecksum
 {
 private:
@@ -117,8 +144,28 @@ public:
 
 	void Add(unsigned char * ucData, unsigned int uiLength)
 	{
+		// Add 8 bytes at a time (the words are read as little endian, like on all platforms we run on)
+		const unsigned int (* uiTables)[256] = crc32SliceTables.uiTables;
+		unsigned int uiChecksum = m_uiChecksum;
+
+		while(uiLength >= 8)
+		{
+			unsigned int uiLow, uiHigh;
+			memcpy(&uiLow, ucData, sizeof(unsigned int));
+			memcpy(&uiHigh, (ucData + 4), sizeof(unsigned int));
+			uiLow ^= uiChecksum;
+			uiChecksum = (uiTables[7][uiLow & 0xFF] ^ uiTables[6][(uiLow >> 8) & 0xFF] ^
+				uiTables[5][(uiLow >> 16) & 0xFF] ^ uiTables[4][uiLow >> 24] ^
+				uiTables[3][uiHigh & 0xFF] ^ uiTables[2][(uiHigh >> 8) & 0xFF] ^
+				uiTables[1][(uiHigh >> 16) & 0xFF] ^ uiTables[0][uiHigh >> 24]);
+			ucData += 8;
+			uiLength -= 8;
+		}
+
 		for(unsigned int i = 0; i < uiLength; i++)
-			m_uiChecksum = ((m_uiChecksum >> 8) ^ uiCrc32Table[(m_uiChecksum ^ ucData[i]) & 0xFF]);
+			uiChecksum = ((uiChecksum >> 8) ^ uiCrc32Table[(uiChecksum ^ ucData[i]) & 0xFF]);
+
+		m_uiChecksum = uiChecksum;
 	}
 
 	void Add(const bool &bData) { ADD_TEMPLATE(bData, sizeof(bool)); }
@@ -158,18 +205,33 @@ public:
 		if(!fFile)
 			return false;
 
-		// Read file data in 512 byte blocks
+		// Read file data in large blocks
 		unsigned int uiBytesRead = 0;
-		unsigned char ucData[512];
+		unsigned char * ucData = new unsigned char[CHECKSUM_READ_BUFFER_SIZE];
 
-		while((uiBytesRead = fread(ucData, 1, sizeof(ucData), fFile)) > 0)
+		while((uiBytesRead = fread(ucData, 1, CHECKSUM_READ_BUFFER_SIZE, fFile)) > 0)
 		{
 			// Add the read data to the checksum
 			Add(ucData, uiBytesRead);
 		}
 
+		delete [] ucData;
+
 		// Close the file
 		fclose(fFile);
 		return true;
 	}
+
+	// Name of the file in the folder of the hashed client files, it only changes
+	// when the content does (the extension is kept for the content type)
+	String GetHashedName(unsigned int uiSize, const String& strName)
+	{
+		String strExtension;
+		size_t sDot = strName.ReverseFind('.');
+
+		if(sDot != String::nPos && strName.Find('/', sDot) == String::nPos)
+			strExtension = strName.SubStr(sDot);
+
+		return String("%08x%08x%s", GetChecksum(), uiSize, strExtension.Get());
+	}
 };
@@ -0,0 +1,232 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFilePack.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CFilePack.h"
+#include <zlib-1.2.5/zlib.h>
+
+CFilePack::CFilePack()
+	: m_pFile(NULL)
+{
+
+}
+
+CFilePack::~CFilePack()
+{
+	Close();
+}
+
+String CFilePack::GetKey(String strName, bool bIsScript)
+{
+	return String("%c%s", (bIsScript ? 's' : 'r'), strName.Get());
+}
+
+bool CFilePack::WriteIndex(FILE * pFile, std::vector<FilePackEntry>& entries)
+{
+	FilePackHeader header;
+	header.uiMagic = FILE_PACK_MAGIC;
+	header.uiVersion = FILE_PACK_VERSION;
+	header.uiEntries = entries.size();
+
+	if(fwrite(&header, sizeof(header), 1, pFile) != 1)
+		return false;
+
+	for(std::vector<FilePackEntry>::iterator iter = entries.begin(); iter != entries.end(); iter++)
+	{
+		unsigned int uiLength = iter->strName.GetLength();
+		unsigned char ucFlags = ((iter->bIsScript ? 1 : 0) | (iter->bCompressed ? 2 : 0));
+
+		if(fwrite(&uiLength, sizeof(uiLength), 1, pFile) != 1 || fwrite(iter->strName.Get(), 1, uiLength, pFile) != uiLength ||
+			fwrite(&ucFlags, sizeof(ucFlags), 1, pFile) != 1 || fwrite(&iter->fileChecksum, sizeof(CFileChecksum), 1, pFile) != 1 ||
+			fwrite(&iter->uiSize, sizeof(iter->uiSize), 1, pFile) != 1 || fwrite(&iter->uiOffset, sizeof(iter->uiOffset), 1, pFile) != 1 ||
+			fwrite(&iter->uiPackedSize, sizeof(iter->uiPackedSize), 1, pFile) != 1)
+			return false;
+	}
+
+	return true;
+}
+
+bool CFilePack::Create(String strPath, std::vector<FilePackEntry>& entries)
+{
+	FILE * pFile = fopen(strPath.Get(), "wb");
+
+	if(!pFile)
+		return false;
+
+	// Write the index first to make room for it, it is written again once the offsets and sizes are known
+	bool bCreated = WriteIndex(pFile, entries);
+
+	for(std::vector<FilePackEntry>::iterator iter = entries.begin(); bCreated && iter != entries.end(); iter++)
+	{
+		FILE * pSourceFile = fopen(iter->strFilePath.Get(), "rb");
+
+		if(!pSourceFile)
+		{
+			bCreated = false;
+			break;
+		}
+
+		fseek(pSourceFile, 0, SEEK_END);
+		unsigned int uiSize = (unsigned int)ftell(pSourceFile);
+		fseek(pSourceFile, 0, SEEK_SET);
+
+		unsigned char * pData = new unsigned char[uiSize + 1];
+		bCreated = (fread(pData, 1, uiSize, pSourceFile) == uiSize);
+		fclose(pSourceFile);
+
+		// Only keep the compressed file if it is smaller (most images and sounds are compressed already)
+		uLongf packedSize = compressBound(uiSize);
+		unsigned char * pPackedData = new unsigned char[packedSize];
+
+		if(bCreated)
+		{
+			iter->uiSize = uiSize;
+			iter->uiOffset = (unsigned int)ftell(pFile);
+			iter->bCompressed = (compress2(pPackedData, &packedSize, pData, uiSize, Z_BEST_COMPRESSION) == Z_OK && packedSize < uiSize);
+
+			if(iter->bCompressed)
+			{
+				iter->uiPackedSize = (unsigned int)packedSize;
+				bCreated = (fwrite(pPackedData, 1, packedSize, pFile) == packedSize);
+			}
+			else
+			{
+				iter->uiPackedSize = uiSize;
+				bCreated = (fwrite(pData, 1, uiSize, pFile) == uiSize);
+			}
+		}
+
+		delete [] pPackedData;
+		delete [] pData;
+	}
+
+	if(bCreated)
+	{
+		fseek(pFile, 0, SEEK_SET);
+		bCreated = WriteIndex(pFile, entries);
+	}
+
+	fclose(pFile);
+
+	// Don't leave broken packs around
+	if(!bCreated)
+		remove(strPath.Get());
+
+	return bCreated;
+}
+
+bool CFilePack::Open(String strPath)
+{
+	Close();
+	m_pFile = fopen(strPath.Get(), "rb");
+
+	if(!m_pFile)
+		return false;
+
+	// Is the pack from this version?
+	FilePackHeader header;
+
+	if(fread(&header, sizeof(header), 1, m_pFile) != 1 || header.uiMagic != FILE_PACK_MAGIC || header.uiVersion != FILE_PACK_VERSION)
+	{
+		Close();
+		return false;
+	}
+
+	// Read the index, a broken index makes the whole pack unusable
+	for(unsigned int i = 0; i < header.uiEntries; i++)
+	{
+		unsigned int uiLength;
+
+		if(fread(&uiLength, sizeof(uiLength), 1, m_pFile) != 1 || uiLength == 0 || uiLength > 4096)
+		{
+			Close();
+			return false;
+		}
+
+		char * szName = new char[uiLength + 1];
+		FilePackEntry entry;
+		unsigned char ucFlags;
+		bool bRead = (fread(szName, 1, uiLength, m_pFile) == uiLength && fread(&ucFlags, sizeof(ucFlags), 1, m_pFile) == 1 &&
+			fread(&entry.fileChecksum, sizeof(CFileChecksum), 1, m_pFile) == 1 && fread(&entry.uiSize, sizeof(entry.uiSize), 1, m_pFile) == 1 &&
+			fread(&entry.uiOffset, sizeof(entry.uiOffset), 1, m_pFile) == 1 && fread(&entry.uiPackedSize, sizeof(entry.uiPackedSize), 1, m_pFile) == 1);
+		szName[uiLength] = '\0';
+		entry.strName = szName;
+		entry.bIsScript = ((ucFlags & 1) != 0);
+		entry.bCompressed = ((ucFlags & 2) != 0);
+		delete [] szName;
+
+		if(!bRead)
+		{
+			Close();
+			return false;
+		}
+
+		m_index[GetKey(entry.strName, entry.bIsScript)] = m_entries.size();
+		m_entries.push_back(entry);
+	}
+
+	return true;
+}
+
+void CFilePack::Close()
+{
+	if(m_pFile)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+	}
+
+	m_entries.clear();
+	m_index.clear();
+}
+
+FilePackEntry * CFilePack::Find(String strName, bool bIsScript)
+{
+	std::map<String, unsigned int>::iterator iter = m_index.find(GetKey(strName, bIsScript));
+
+	if(iter == m_index.end())
+		return NULL;
+
+	return &m_entries[iter->second];
+}
+
+bool CFilePack::Extract(FilePackEntry * pEntry, String strPath)
+{
+	if(!m_pFile || fseek(m_pFile, pEntry->uiOffset, SEEK_SET) != 0)
+		return false;
+
+	unsigned char * pPackedData = new unsigned char[pEntry->uiPackedSize + 1];
+	bool bExtracted = (fread(pPackedData, 1, pEntry->uiPackedSize, m_pFile) == pEntry->uiPackedSize);
+	unsigned char * pData = pPackedData;
+
+	if(bExtracted && pEntry->bCompressed)
+	{
+		uLongf size = pEntry->uiSize;
+		pData = new unsigned char[pEntry->uiSize + 1];
+		bExtracted = (uncompress(pData, &size, pPackedData, pEntry->uiPackedSize) == Z_OK && size == pEntry->uiSize);
+	}
+
+	if(bExtracted)
+	{
+		FILE * pFile = fopen(strPath.Get(), "wb");
+		bExtracted = (pFile && fwrite(pData, 1, pEntry->uiSize, pFile) == pEntry->uiSize);
+
+		if(pFile)
+			fclose(pFile);
+
+		// Don't leave broken files around
+		if(!bExtracted)
+			remove(strPath.Get());
+	}
+
+	if(pData != pPackedData)
+		delete [] pData;
+
+	delete [] pPackedData;
+	return bExtracted;
+}
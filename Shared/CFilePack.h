@@ -0,0 +1,76 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFilePack.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+#include "CString.h"
+#include "CFileChecksum.h"
+
+// Identifies a file pack ('IVPK')
+#define FILE_PACK_MAGIC 0x4B505649
+
+// Increase this whenever the pack layout changes
+#define FILE_PACK_VERSION 1
+
+// Name of the pack of the client files (in the web server root and the client files folder)
+#define FILE_PACK_FILE "clientfiles.pack"
+
+// Header at the start of a file pack, followed by the index and then the file data
+struct FilePackHeader
+{
+	unsigned int uiMagic;
+	unsigned int uiVersion;
+	unsigned int uiEntries;
+};
+
+// A file in a pack
+struct FilePackEntry
+{
+	String        strName;
+	bool          bIsScript;
+	CFileChecksum fileChecksum; // Of the uncompressed file
+	unsigned int  uiSize;
+	unsigned int  uiOffset;     // From the start of the pack
+	unsigned int  uiPackedSize;
+	bool          bCompressed;
+	String        strFilePath;  // File the entry is made from (only used to create a pack)
+};
+
+// A single file of many client files with an index of them at the start, each
+// file is compressed on its own so they can be extracted one at a time
+class CFilePack
+{
+private:
+	FILE                         * m_pFile;
+	std::vector<FilePackEntry>     m_entries;
+	std::map<String, unsigned int> m_index; // Entries by type and name
+
+	static String  GetKey(String strName, bool bIsScript);
+	static bool    WriteIndex(FILE * pFile, std::vector<FilePackEntry>& entries);
+
+public:
+	CFilePack();
+	~CFilePack();
+
+	// Writes a pack of the files of the entries (their name, type, checksum and file path must be set)
+	static bool    Create(String strPath, std::vector<FilePackEntry>& entries);
+
+	bool           Open(String strPath);
+	void           Close();
+	bool           IsOpen() { return (m_pFile != NULL); }
+	unsigned int   GetEntryCount() { return m_entries.size(); }
+	FilePackEntry * GetEntry(unsigned int uiIndex) { return &m_entries[uiIndex]; }
+	FilePackEntry * Find(String strName, bool bIsScript);
+
+	// Writes the uncompressed file of the entry to the path
+	bool           Extract(FilePackEntry * pEntry, String strPath);
+};
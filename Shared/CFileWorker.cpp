@@ -0,0 +1,263 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFileWorker.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "Scripting/CScriptingManager.h"
+#include "CFileWorker.h"
+#include <stdio.h>
+#include <md5/md5.h>
+#include "SharedUtility.h"
+
+extern CScriptingManager * g_pScriptingManager;
+
+CFileWorker * g_pFileWorker = NULL;
+
+CFileWorker::CFileWorker(CJobSystem * pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+CFileWorker::~CFileWorker()
+{
+	// Let the jobs finish so no writes are lost, the callbacks are never called
+	RemoveScript(NULL);
+}
+
+bool CFileWorker::LoadFile(const String& strPath, String& strData, String& strError)
+{
+	FILE * pFile = fopen(strPath.Get(), "rb");
+
+	if(!pFile)
+	{
+		strError.Set("can't open the file");
+		return false;
+	}
+
+	fseek(pFile, 0, SEEK_END);
+	long lSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	if(lSize < 0)
+	{
+		fclose(pFile);
+		strError.Set("can't get the size of the file");
+		return false;
+	}
+
+	if(lSize > 0)
+	{
+		char * szData = new char[lSize];
+		bool bRead = (fread(szData, 1, lSize, pFile) == (size_t)lSize);
+
+		if(bRead)
+			strData.Set(szData, (unsigned int)lSize);
+
+		delete [] szData;
+
+		if(!bRead)
+		{
+			fclose(pFile);
+			strError.Set("can't read the file");
+			return false;
+		}
+	}
+
+	fclose(pFile);
+	return true;
+}
+
+void CFileWorker::RequestJob(void * pUserData)
+{
+	FileRequest * pRequest = (FileRequest *)pUserData;
+
+	switch(pRequest->type)
+	{
+	case FILE_REQUEST_READ:
+		pRequest->bSucceeded = LoadFile(pRequest->strPath, pRequest->strData, pRequest->strError);
+		break;
+	case FILE_REQUEST_WRITE:
+	case FILE_REQUEST_APPEND:
+		{
+			FILE * pFile = fopen(pRequest->strPath.Get(), ((pRequest->type == FILE_REQUEST_APPEND) ? "ab" : "wb"));
+
+			if(!pFile)
+			{
+				pRequest->strError.Set("can't open the file");
+				break;
+			}
+
+			size_t sLength = pRequest->strData.GetLength();
+			pRequest->bSucceeded = (fwrite(pRequest->strData.Get(), 1, sLength, pFile) == sLength);
+
+			if(fclose(pFile) != 0)
+				pRequest->bSucceeded = false;
+
+			if(!pRequest->bSucceeded)
+				pRequest->strError.Set("can't write the file");
+
+			pRequest->strData.Clear();
+		}
+		break;
+	case FILE_REQUEST_HASH_MD5:
+		{
+			// The file is hashed in blocks without reading all of it
+			MD5 md5bytes;
+			CMD5Hasher hasher;
+
+			if(!hasher.Calculate(pRequest->strPath.Get(), md5bytes))
+			{
+				pRequest->strError.Set("can't read the file");
+				break;
+			}
+
+			char szHash[33];
+			hasher.ConvertToHex(md5bytes, szHash);
+			pRequest->strData.Set(szHash, 32);
+			pRequest->bSucceeded = true;
+		}
+		break;
+	case FILE_REQUEST_HASH_SHA256:
+		{
+			String strData;
+
+			if(!LoadFile(pRequest->strPath, strData, pRequest->strError))
+				break;
+
+			pRequest->strData = SharedUtility::HashSHA256(strData);
+			pRequest->bSucceeded = true;
+		}
+		break;
+	}
+}
+
+bool CFileWorker::Add(FileRequest * pRequest)
+{
+	if(m_requests.size() >= FILE_WORKER_MAX_REQUESTS)
+		return false;
+
+	pRequest->bSucceeded = false;
+	m_requests.push_back(pRequest);
+
+	// Run after the last request of the file so a read gets what was written before
+	CJobCounter * pDependency = NULL;
+	std::map<String, FileRequest *>::iterator iter = m_lastRequests.find(pRequest->strPath);
+
+	if(iter != m_lastRequests.end())
+	{
+		pDependency = &(*iter).second->counter;
+		(*iter).second = pRequest;
+	}
+	else
+		m_lastRequests.insert(std::pair<String, FileRequest *>(pRequest->strPath, pRequest));
+
+	m_pJobSystem->Add(RequestJob, pRequest, &pRequest->counter, pDependency);
+	return true;
+}
+
+void CFileWorker::DeleteRequest(FileRequest * pRequest)
+{
+	// Wait for the job before the request (and its counter) is gone
+	m_pJobSystem->Wait(&pRequest->counter);
+
+	std::map<String, FileRequest *>::iterator iter = m_lastRequests.find(pRequest->strPath);
+
+	if(iter != m_lastRequests.end() && (*iter).second == pRequest)
+		m_lastRequests.erase(iter);
+
+	delete pRequest;
+}
+
+void CFileWorker::RemoveRequests(std::list<FileRequest *> * pRequests, SQVM * pVM)
+{
+	for(std::list<FileRequest *>::iterator iter = pRequests->begin(); iter != pRequests->end(); )
+	{
+		if(!pVM || (*iter)->pVM == pVM)
+		{
+			DeleteRequest(*iter);
+			iter = pRequests->erase(iter);
+		}
+		else
+			iter++;
+	}
+}
+
+void CFileWorker::RemoveScript(SQVM * pVM)
+{
+	// The requests of the script still run so no writes are lost, only their
+	// callbacks are dropped. The requests hold references to objects of the
+	// script so they must go before the script does.
+	RemoveRequests(&m_requests, pVM);
+	RemoveRequests(&m_processingRequests, pVM);
+}
+
+void CFileWorker::Process()
+{
+	// The requests are kept in a member so RemoveScript can remove them while
+	// we call their callbacks
+	for(std::list<FileRequest *>::iterator iter = m_requests.begin(); iter != m_requests.end(); )
+	{
+		std::list<FileRequest *>::iterator next = iter;
+		next++;
+
+		if((*iter)->counter.IsDone())
+			m_processingRequests.splice(m_processingRequests.end(), m_requests, iter);
+
+		iter = next;
+	}
+
+	while(!m_processingRequests.empty())
+	{
+		FileRequest * pRequest = m_processingRequests.front();
+		m_processingRequests.pop_front();
+		m_pJobSystem->Wait(&pRequest->counter);
+		CSquirrel * pScript = g_pScriptingManager->Get(pRequest->pVM);
+		bool bWrite = (pRequest->type == FILE_REQUEST_WRITE || pRequest->type == FILE_REQUEST_APPEND);
+
+		if(pRequest->uiCoroutine != 0)
+		{
+			// The coroutine gets the data, true or the hash or the error is thrown in it
+			if(!pRequest->bSucceeded)
+				g_pScriptingManager->FailCoroutine(pRequest->uiCoroutine, pRequest->strError);
+			else if(bWrite)
+				g_pScriptingManager->ResumeCoroutine(pRequest->uiCoroutine, CSquirrelArgument(true));
+			else
+				g_pScriptingManager->ResumeCoroutine(pRequest->uiCoroutine, CSquirrelArgument(pRequest->strData));
+		}
+		else if(pScript && pRequest->pFunction._type != OT_NULL)
+		{
+			// Call the callback with the data, true or the hash (or false and
+			// the error) followed by the extra arguments
+			CSquirrelArguments arguments;
+
+			if(!pRequest->bSucceeded)
+			{
+				arguments.push(false);
+				arguments.push(pRequest->strError);
+			}
+			else
+			{
+				if(bWrite)
+					arguments.push(true);
+				else
+					arguments.push(pRequest->strData);
+
+				arguments.push();
+			}
+
+			for(unsigned int i = 0; i < pRequest->arguments.size(); i++)
+			{
+				arguments.push();
+				arguments.back()->set(*pRequest->arguments.get(i));
+			}
+
+			pScript->Call(pRequest->pFunction, &arguments);
+		}
+
+		DeleteRequest(pRequest);
+	}
+}
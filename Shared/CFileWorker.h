@@ -0,0 +1,73 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFileWorker.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <map>
+#include "Threading/CJobSystem.h"
+#include "Scripting/CSquirrel.h"
+
+// Maximum amount of file requests that can be waiting or running
+#define FILE_WORKER_MAX_REQUESTS 1024
+
+enum eFileRequestType
+{
+	FILE_REQUEST_READ,
+	FILE_REQUEST_WRITE,
+	FILE_REQUEST_APPEND,
+	FILE_REQUEST_HASH_MD5,
+	FILE_REQUEST_HASH_SHA256
+};
+
+// A file read, write or hash of a script that runs on the job system
+struct FileRequest
+{
+	// Only used by the job while the request is waiting or running
+	eFileRequestType     type;
+	String               strPath;
+	String               strData; // What is written, what was read or the hash
+	bool                 bSucceeded;
+	String               strError;
+	CJobCounter          counter; // Done once the job of the request finished
+
+	// Only used by the main thread
+	SQVM *               pVM;
+	SQObjectPtr          pFunction;
+	CSquirrelArguments   arguments;
+	unsigned int         uiCoroutine; // Resumed with the result instead of calling pFunction if not 0
+};
+
+// Runs the file requests of the scripts on the job system and calls their
+// callbacks on the main thread when Process is called. The requests of a
+// file run in the order they were made, the requests of different files run
+// at the same time.
+class CFileWorker
+{
+private:
+	CJobSystem *                     m_pJobSystem;
+	std::list<FileRequest *>         m_requests;
+	std::list<FileRequest *>         m_processingRequests;
+	std::map<String, FileRequest *>  m_lastRequests; // The last request of each file that is still there
+
+	static void  RequestJob(void * pUserData);
+	static bool  LoadFile(const String& strPath, String& strData, String& strError);
+	void         DeleteRequest(FileRequest * pRequest);
+	void         RemoveRequests(std::list<FileRequest *> * pRequests, SQVM * pVM);
+
+public:
+	CFileWorker(CJobSystem * pJobSystem);
+	~CFileWorker();
+
+	bool         Add(FileRequest * pRequest);
+	void         RemoveScript(SQVM * pVM);
+	void         Process();
+};
+
+extern CFileWorker * g_pFileWorker;
@@ -0,0 +1,72 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFrameArena.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CFrameArena.h"
+#include <stdlib.h>
+
+// Alignment of every allocation, enough for any of the types put in the arena
+#define FRAME_ARENA_ALIGNMENT 16
+
+std::vector<CFrameArena::Block> CFrameArena::m_blocks;
+size_t                          CFrameArena::m_sCurrentBlock = 0;
+
+void * CFrameArena::Allocate(size_t sSize)
+{
+	sSize = ((sSize + (FRAME_ARENA_ALIGNMENT - 1)) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1));
+
+	// Use the rest of the current block or the next block that has room
+	for(; m_sCurrentBlock < m_blocks.size(); m_sCurrentBlock++)
+	{
+		Block& block = m_blocks[m_sCurrentBlock];
+
+		if((block.sSize - block.sUsed) >= sSize)
+		{
+			void * pMemory = (block.pData + block.sUsed);
+			block.sUsed += sSize;
+			return pMemory;
+		}
+	}
+
+	Block block;
+	block.sSize = ((sSize > FRAME_ARENA_BLOCK_SIZE) ? sSize : FRAME_ARENA_BLOCK_SIZE);
+	block.pData = (unsigned char *)malloc(block.sSize);
+
+	if(!block.pData)
+		throw std::bad_alloc();
+
+	block.sUsed = sSize;
+	m_blocks.push_back(block);
+	m_sCurrentBlock = (m_blocks.size() - 1);
+	return block.pData;
+}
+
+void CFrameArena::Reset()
+{
+	// Keep the first blocks for the next tick, a spike doesn't keep its memory
+	while(m_blocks.size() > FRAME_ARENA_MAX_BLOCKS)
+	{
+		free(m_blocks.back().pData);
+		m_blocks.pop_back();
+	}
+
+	for(std::vector<Block>::iterator iter = m_blocks.begin(); iter != m_blocks.end(); iter++)
+		(*iter).sUsed = 0;
+
+	m_sCurrentBlock = 0;
+}
+
+size_t CFrameArena::GetAllocatedSize()
+{
+	size_t sSize = 0;
+
+	for(std::vector<Block>::iterator iter = m_blocks.begin(); iter != m_blocks.end(); iter++)
+		sSize += (*iter).sSize;
+
+	return sSize;
+}
@@ -0,0 +1,81 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CFrameArena.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <new>
+#include <vector>
+
+// Size of each arena block, bigger allocations get a block of their own
+#define FRAME_ARENA_BLOCK_SIZE 65536
+
+// Blocks kept over a reset, the ones a busy tick needed beyond these are freed
+#define FRAME_ARENA_MAX_BLOCKS 16
+
+// Memory that lives until the end of the current tick (frame). Allocating only
+// bumps a pointer and nothing is freed one by one, the whole arena is reset once
+// the tick is done. Only the main thread uses it.
+class CFrameArena
+{
+private:
+	struct Block
+	{
+		unsigned char * pData;
+		size_t          sSize;
+		size_t          sUsed;
+	};
+
+	static std::vector<Block> m_blocks;
+	static size_t             m_sCurrentBlock;
+
+public:
+	static void * Allocate(size_t sSize);
+
+	// Everything allocated since the last reset is gone after this
+	static void   Reset();
+	static size_t GetAllocatedSize();
+};
+
+// A standard library allocator using the frame arena, for containers that don't
+// outlive the tick they are made in
+template <typename T>
+class CFrameAllocator
+{
+public:
+	typedef T              value_type;
+	typedef T            * pointer;
+	typedef const T      * const_pointer;
+	typedef T            & reference;
+	typedef const T      & const_reference;
+	typedef size_t         size_type;
+	typedef ptrdiff_t      difference_type;
+
+	template <typename U>
+	struct rebind { typedef CFrameAllocator<U> other; };
+
+	CFrameAllocator() { }
+
+	template <typename U>
+	CFrameAllocator(const CFrameAllocator<U>&) { }
+
+	pointer       address(reference value) const { return &value; }
+	const_pointer address(const_reference value) const { return &value; }
+	pointer       allocate(size_type sCount, const void * = 0) { return (pointer)CFrameArena::Allocate(sCount * sizeof(T)); }
+	void          deallocate(pointer, size_type) { }
+	size_type     max_size() const { return ((size_type)-1 / sizeof(T)); }
+	void          construct(pointer p, const T& value) { new((void *)p) T(value); }
+	void          destroy(pointer p) { p->~T(); }
+};
+
+template <typename T, typename U>
+bool operator==(const CFrameAllocator<T>&, const CFrameAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const CFrameAllocator<T>&, const CFrameAllocator<U>&) { return false; }
@@ -0,0 +1,291 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CHttpRequestPool.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "Scripting/CScriptingManager.h"
+#include "CHttpRequestPool.h"
+
+extern CScriptingManager * g_pScriptingManager;
+
+CHttpRequestPool * g_pHttpRequestPool = NULL;
+
+CHttpRequestPool::CHttpRequestPool(unsigned int uiMaxClients, unsigned int uiMaxClientsPerHost)
+{
+	m_uiMaxClients = uiMaxClients;
+	m_uiMaxClientsPerHost = uiMaxClientsPerHost;
+	m_uiClients = 0;
+}
+
+CHttpRequestPool::~CHttpRequestPool()
+{
+	// The callbacks of the requests that are not done are never called
+	RemoveScript(NULL);
+
+	for(std::list<CHttpClient *>::iterator iter = m_idleClients.begin(); iter != m_idleClients.end(); iter++)
+		delete *iter;
+}
+
+bool CHttpRequestPool::ParseUrl(String strUrl, String& strHost, unsigned short& usPort, String& strPath)
+{
+	// Only plain http is supported, the scheme is optional
+	if(strUrl.Find("://") != String::nPos)
+	{
+		if(strUrl.SubStr(0, 7).ToLower() != "http://")
+			return false;
+
+		strUrl.Erase(0, 7);
+	}
+
+	size_t sPathStart = strUrl.Find('/');
+
+	if(sPathStart == String::nPos)
+	{
+		strHost = strUrl;
+		strPath = "/";
+	}
+	else
+	{
+		strHost = strUrl.SubStr(0, sPathStart);
+		strPath = strUrl.SubStr(sPathStart, (strUrl.GetLength() - sPathStart));
+	}
+
+	usPort = 80;
+	size_t sPortStart = strHost.Find(':');
+
+	if(sPortStart != String::nPos)
+	{
+		int iPort = strHost.SubStr((sPortStart + 1), (strHost.GetLength() - (sPortStart + 1))).ToInteger();
+
+		if(iPort <= 0 || iPort > 65535)
+			return false;
+
+		usPort = (unsigned short)iPort;
+		strHost.Erase(sPortStart, (strHost.GetLength() - sPortStart));
+	}
+
+	return strHost.IsNotEmpty();
+}
+
+CHttpClient * CHttpRequestPool::GetClient(String strHost)
+{
+	// A client that talked to the host before already knows its address
+	for(std::list<CHttpClient *>::iterator iter = m_idleClients.begin(); iter != m_idleClients.end(); iter++)
+	{
+		if((*iter)->GetHost() == strHost)
+		{
+			CHttpClient * pHttpClient = *iter;
+			m_idleClients.erase(iter);
+			return pHttpClient;
+		}
+	}
+
+	if(m_uiClients < m_uiMaxClients)
+	{
+		m_uiClients++;
+		CHttpClient * pHttpClient = new CHttpClient();
+		pHttpClient->SetRequestTimeout(HTTP_REQUEST_POOL_TIMEOUT);
+		return pHttpClient;
+	}
+
+	// Take the client that has been idle the longest
+	CHttpClient * pHttpClient = m_idleClients.back();
+	m_idleClients.pop_back();
+	return pHttpClient;
+}
+
+void CHttpRequestPool::ReleaseClient(HttpRequest * pRequest)
+{
+	pRequest->pHttpClient->Reset();
+	m_idleClients.push_front(pRequest->pHttpClient);
+	pRequest->pHttpClient = NULL;
+
+	std::map<String, unsigned int>::iterator iter = m_hostRequests.find(pRequest->strHost);
+
+	if(iter != m_hostRequests.end() && --iter->second == 0)
+		m_hostRequests.erase(iter);
+}
+
+bool CHttpRequestPool::StartRequest(HttpRequest * pRequest)
+{
+	pRequest->pHttpClient = GetClient(pRequest->strHost);
+	m_hostRequests[pRequest->strHost]++;
+	CHttpClient * pHttpClient = pRequest->pHttpClient;
+	pHttpClient->SetHost(pRequest->strHost);
+	pHttpClient->SetPort(pRequest->usPort);
+
+	if(pRequest->bPost)
+		return pHttpClient->Post(true, pRequest->strPath, pRequest->strBody, pRequest->strContentType);
+
+	return pHttpClient->Get(pRequest->strPath);
+}
+
+void CHttpRequestPool::StartRequests()
+{
+	for(std::list<HttpRequest *>::iterator iter = m_queuedRequests.begin(); iter != m_queuedRequests.end() && m_runningRequests.size() < m_uiMaxClients; )
+	{
+		HttpRequest * pRequest = *iter;
+
+		// Keep the request queued while its host has enough requests running
+		std::map<String, unsigned int>::iterator hostIter = m_hostRequests.find(pRequest->strHost);
+
+		if(hostIter != m_hostRequests.end() && hostIter->second >= m_uiMaxClientsPerHost)
+		{
+			iter++;
+			continue;
+		}
+
+		iter = m_queuedRequests.erase(iter);
+
+		if(StartRequest(pRequest))
+			m_runningRequests.push_back(pRequest);
+		else
+		{
+			pRequest->strError = pRequest->pHttpClient->GetLastErrorString();
+			ReleaseClient(pRequest);
+			m_completedRequests.push_back(pRequest);
+		}
+	}
+}
+
+bool CHttpRequestPool::Add(HttpRequest * pRequest)
+{
+	if(m_queuedRequests.size() >= HTTP_REQUEST_POOL_MAX_QUEUED)
+		return false;
+
+	pRequest->pHttpClient = NULL;
+	pRequest->bSucceeded = false;
+	pRequest->iStatusCode = 0;
+	m_queuedRequests.push_back(pRequest);
+
+	// Start it right away if a client is free, the callback is still only called in a later pulse
+	StartRequests();
+	return true;
+}
+
+void CHttpRequestPool::RemoveRequests(std::list<HttpRequest *> * pRequests, SQVM * pVM)
+{
+	for(std::list<HttpRequest *>::iterator iter = pRequests->begin(); iter != pRequests->end(); )
+	{
+		if(!pVM || (*iter)->pVM == pVM)
+		{
+			delete *iter;
+			iter = pRequests->erase(iter);
+		}
+		else
+			iter++;
+	}
+}
+
+void CHttpRequestPool::RemoveScript(SQVM * pVM)
+{
+	// The requests hold references to objects of the script so they must go
+	// before the script does, the running ones give their client back first
+	for(std::list<HttpRequest *>::iterator iter = m_runningRequests.begin(); iter != m_runningRequests.end(); iter++)
+	{
+		if(!pVM || (*iter)->pVM == pVM)
+			ReleaseClient(*iter);
+	}
+
+	RemoveRequests(&m_runningRequests, pVM);
+	RemoveRequests(&m_queuedRequests, pVM);
+	RemoveRequests(&m_completedRequests, pVM);
+	RemoveRequests(&m_processingRequests, pVM);
+}
+
+void CHttpRequestPool::CallCallbacks()
+{
+	// The requests are kept in a member so RemoveScript can remove them while
+	// we call their callbacks
+	m_processingRequests.splice(m_processingRequests.end(), m_completedRequests);
+
+	while(!m_processingRequests.empty())
+	{
+		HttpRequest * pRequest = m_processingRequests.front();
+		m_processingRequests.pop_front();
+		CSquirrel * pScript = g_pScriptingManager->Get(pRequest->pVM);
+
+		if(pRequest->uiCoroutine != 0)
+		{
+			// The coroutine gets a table with the status code and the response
+			// or the error is thrown in it
+			if(pRequest->bSucceeded)
+			{
+				CSquirrelArguments * pResponse = new CSquirrelArguments();
+				pResponse->push("status");
+				pResponse->push(pRequest->iStatusCode);
+				pResponse->push("body");
+				pResponse->push(pRequest->strData);
+				g_pScriptingManager->ResumeCoroutine(pRequest->uiCoroutine, CSquirrelArgument(pResponse, false));
+			}
+			else
+				g_pScriptingManager->FailCoroutine(pRequest->uiCoroutine, pRequest->strError);
+		}
+		else if(pScript)
+		{
+			// Call the callback with the status code and the response (or false
+			// and the error) followed by the arguments given to httpRequest
+			CSquirrelArguments arguments;
+
+			if(pRequest->bSucceeded)
+			{
+				arguments.push(pRequest->iStatusCode);
+				arguments.push(pRequest->strData);
+			}
+			else
+			{
+				arguments.push(false);
+				arguments.push(pRequest->strError);
+			}
+
+			for(unsigned int i = 0; i < pRequest->arguments.size(); i++)
+			{
+				arguments.push();
+				arguments.back()->set(*pRequest->arguments.get(i));
+			}
+
+			pScript->Call(pRequest->pFunction, &arguments);
+		}
+
+		delete pRequest;
+	}
+}
+
+void CHttpRequestPool::Process()
+{
+	// Call the callbacks of the requests that were done in the last pulse
+	// first so no responses are handled in the same pulse they arrived in
+	CallCallbacks();
+
+	for(std::list<HttpRequest *>::iterator iter = m_runningRequests.begin(); iter != m_runningRequests.end(); )
+	{
+		HttpRequest * pRequest = *iter;
+		CHttpClient * pHttpClient = pRequest->pHttpClient;
+		pHttpClient->Process();
+
+		if(pHttpClient->IsBusy())
+		{
+			iter++;
+			continue;
+		}
+
+		if(pHttpClient->GotData())
+		{
+			pRequest->bSucceeded = true;
+			pRequest->iStatusCode = pHttpClient->GetStatusCode();
+			pRequest->strData = *pHttpClient->GetData();
+		}
+		else
+			pRequest->strError = pHttpClient->GetLastErrorString();
+
+		ReleaseClient(pRequest);
+		iter = m_runningRequests.erase(iter);
+		m_completedRequests.push_back(pRequest);
+	}
+
+	StartRequests();
+}
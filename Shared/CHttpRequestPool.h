@@ -0,0 +1,83 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CHttpRequestPool.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <map>
+#include "Network/CHttpClient.h"
+#include "Scripting/CSquirrel.h"
+
+// Maximum amount of requests that can be waiting for a http client
+#define HTTP_REQUEST_POOL_MAX_QUEUED 1024
+
+// Time in ms a script request may take
+#define HTTP_REQUEST_POOL_TIMEOUT 30000
+
+// A http request made by a script
+struct HttpRequest
+{
+	// Only used while the request is queued or running
+	String               strHost;
+	unsigned short       usPort;
+	String               strPath;
+	bool                 bPost;
+	String               strBody;
+	String               strContentType;
+	CHttpClient *        pHttpClient;
+
+	// Set when the request is done
+	bool                 bSucceeded;
+	int                  iStatusCode;
+	String               strData;
+	String               strError;
+
+	SQVM *               pVM;
+	SQObjectPtr          pFunction;
+	CSquirrelArguments   arguments;
+	unsigned int         uiCoroutine; // Resumed with the response instead of calling pFunction if not 0
+};
+
+// Runs the http requests of the scripts on a pool of non blocking http
+// clients and calls their callbacks in the server pulse after they are done.
+// The clients are reused so a host is only resolved again when a connect to
+// it fails.
+class CHttpRequestPool
+{
+private:
+	unsigned int                   m_uiMaxClients;
+	unsigned int                   m_uiMaxClientsPerHost;
+	unsigned int                   m_uiClients;
+	std::list<CHttpClient *>       m_idleClients;
+	std::map<String, unsigned int> m_hostRequests;
+	std::list<HttpRequest *>       m_queuedRequests;
+	std::list<HttpRequest *>       m_runningRequests;
+	std::list<HttpRequest *>       m_completedRequests;
+	std::list<HttpRequest *>       m_processingRequests;
+
+	CHttpClient * GetClient(String strHost);
+	void          ReleaseClient(HttpRequest * pRequest);
+	bool          StartRequest(HttpRequest * pRequest);
+	void          StartRequests();
+	void          CallCallbacks();
+	static void   RemoveRequests(std::list<HttpRequest *> * pRequests, SQVM * pVM);
+
+public:
+	CHttpRequestPool(unsigned int uiMaxClients, unsigned int uiMaxClientsPerHost);
+	~CHttpRequestPool();
+
+	// Splits a http url into its host, port and path, false if it isn't a http url
+	static bool   ParseUrl(String strUrl, String& strHost, unsigned short& usPort, String& strPath);
+
+	bool          Add(HttpRequest * pRequest);
+	void          RemoveScript(SQVM * pVM);
+	void          Process();
+};
+
+extern CHttpRequestPool * g_pHttpRequestPool;
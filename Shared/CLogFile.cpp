@@ -9,9 +9,15 @@
 
 #include "CLogFile.h"
 #include "SharedUtility.h"
+#include <string.h>
+#include "Threading/CThread.h"
+#include "Threading/CAtomic.h"
+#include "CMemoryTracker.h"
 
 #ifdef _LINUX
 #include <stdarg.h>
+#include <unistd.h>
+#define Sleep(ms) usleep((ms) * 1000)
 #endif
 
 FILE *            CLogFile::m_fLogFile = NULL;
@@ -19,30 +25,240 @@ bool              CLogFile::m_bUseCallback = false;
 LogFileCallback_t CLogFile::m_pfnCallback = NULL;
 bool              CLogFile::m_bUseTimeStamp = true;
 CMutex            CLogFile::m_mutex;
+String            CLogFile::m_strLogFile;
+long              CLogFile::m_lFileSize = 0;
+unsigned int      CLogFile::m_uiMaxFileSize = 0;
+LogRecord *       CLogFile::m_pRecords = NULL;
+volatile bool     CLogFile::m_bUseWriter = false;
+volatile long     CLogFile::m_lWritePosition = 0;
+volatile long     CLogFile::m_lReadPosition = 0;
+CThread *         CLogFile::m_pWriterThread = NULL;
+CThreadEvent      CLogFile::m_writerEvent;
+unsigned int      CLogFile::m_uiFlushInterval = 0;
+
+// Positions wrap around so they are only added and compared as unsigned
+static long AdvancePosition(long lPosition, unsigned long ulAmount = 1)
+{
+	return (long)((unsigned long)lPosition + ulAmount);
+}
+
+static long GetPositionDifference(long lPosition, long lOtherPosition)
+{
+	return (long)((unsigned long)lPosition - (unsigned long)lOtherPosition);
+}
+
+// localtime isn't thread safe and the log writer formats its own time stamps
+static void GetLocalTimeString(time_t time, const char * szFormat, char * szBuffer, size_t bufferSize)
+{
+	struct tm timeInfo;
+#ifdef WIN32
+	localtime_s(&timeInfo, &time);
+#else
+	localtime_r(&time, &timeInfo);
+#endif
+	strftime(szBuffer, bufferSize, szFormat, &timeInfo);
+}
 
 void CLogFile::Open(String strLogFile, bool bAppend)
 {
+	// Write the messages that are still waiting to the old file
+	Flush();
+
 	// Lock the mutex
-	m_mutex.TryLock(1);
+	m_mutex.Lock();
 
 	// Open the log file
-	m_fLogFile = fopen(SharedUtility::GetAbsolutePath(strLogFile).Get(), bAppend ? "a" : "w");
+	m_strLogFile = SharedUtility::GetAbsolutePath(strLogFile);
+	m_fLogFile = fopen(m_strLogFile.Get(), bAppend ? "a" : "w");
+	m_lFileSize = 0;
 
 	// Did the log file open successfully?
 	if(m_fLogFile)
 	{
-		// Log the log file started message
-		//PrintToFile("Log file started");
+		// Appended files count towards the maximum file size
+		fseek(m_fLogFile, 0, SEEK_END);
+		m_lFileSize = ftell(m_fLogFile);
 	}
 
 	// Unlock the mutex
 	m_mutex.Unlock();
 }
 
+void CLogFile::WriteToFile(time_t time, const char * szString)
+{
+	// Is the log file open?
+	if(!m_fLogFile)
+		return;
+
+	// Log the message
+	int iWritten;
+
+	if(m_bUseTimeStamp)
+	{
+		char szTime[16];
+		GetLocalTimeString(time, "%H:%M:%S", szTime, sizeof(szTime));
+		iWritten = fprintf(m_fLogFile, "[%s] %s\n", szTime, szString);
+	}
+	else
+		iWritten = fprintf(m_fLogFile, "%s\n", szString);
+
+	if(iWritten > 0)
+		m_lFileSize += iWritten;
+
+	// Is the log file too big?
+	if(m_uiMaxFileSize > 0 && m_lFileSize >= (long)m_uiMaxFileSize)
+		RotateLogFile();
+}
+
+void CLogFile::RotateLogFile()
+{
+	// Keep the old file with the time it was rotated at and start a new one
+	char szTime[32];
+	GetLocalTimeString(time(NULL), "%Y%m%d-%H%M%S", szTime, sizeof(szTime));
+	String strRotatedLogFile("%s.%s", m_strLogFile.Get(), szTime);
+
+	// Don't replace a file that was rotated in the same second
+	for(int i = 1; SharedUtility::Exists(strRotatedLogFile.Get()); i++)
+		strRotatedLogFile.Format("%s.%s-%d", m_strLogFile.Get(), szTime, i);
+
+	fclose(m_fLogFile);
+	rename(m_strLogFile.Get(), strRotatedLogFile.Get());
+	m_fLogFile = fopen(m_strLogFile.Get(), "w");
+	m_lFileSize = 0;
+}
+
+void CLogFile::PushRecord(const char * szString, bool bConsole)
+{
+	LogRecord * pRecord = NULL;
+	long lPosition = m_lWritePosition;
+
+	// Claim the next free record
+	while(true)
+	{
+		pRecord = &m_pRecords[lPosition & (LOG_WRITER_RECORDS - 1)];
+		long lSequence = pRecord->lSequence;
+		CAtomic::Barrier();
+		long lDifference = GetPositionDifference(lSequence, lPosition);
+
+		if(lDifference == 0)
+		{
+			// The record is free, try to take it before another thread does
+			if(CAtomic::CompareExchange(&m_lWritePosition, AdvancePosition(lPosition), lPosition) == lPosition)
+				break;
+		}
+		else if(lDifference < 0)
+		{
+			// The buffer is full, wait for the writer thread to catch up
+			// rather than losing messages
+			Sleep(1);
+		}
+
+		lPosition = m_lWritePosition;
+	}
+
+	pRecord->time = time(NULL);
+	pRecord->bConsole = bConsole;
+	strncpy(pRecord->szText, szString, (sizeof(pRecord->szText) - 1));
+	pRecord->szText[sizeof(pRecord->szText) - 1] = '\0';
+
+	// Hand the record to the writer thread
+	CAtomic::Barrier();
+	pRecord->lSequence = AdvancePosition(lPosition);
+	m_writerEvent.Signal();
+}
+
+LogRecord * CLogFile::GetNextRecord()
+{
+	// Only called from the writer thread
+	LogRecord * pRecord = &m_pRecords[m_lReadPosition & (LOG_WRITER_RECORDS - 1)];
+
+	if(pRecord->lSequence != AdvancePosition(m_lReadPosition))
+		return NULL;
+
+	CAtomic::Barrier();
+	return pRecord;
+}
+
+void CLogFile::FreeRecord(LogRecord * pRecord)
+{
+	// The record can be used again once the write position went around the
+	// buffer once
+	CAtomic::Barrier();
+	pRecord->lSequence = AdvancePosition(m_lReadPosition, LOG_WRITER_RECORDS);
+	m_lReadPosition = AdvancePosition(m_lReadPosition);
+}
+
+void CLogFile::WriterThread(CThread * pCreator)
+{
+	unsigned long ulLastFlushTime = SharedUtility::GetTime();
+	bool bNeedsFlush = false;
+
+	while(true)
+	{
+		bool bRunning = pCreator->GetUserData<bool>();
+		unsigned long ulTime = SharedUtility::GetTime();
+		bool bFlush = (bNeedsFlush && (!bRunning || (ulTime - ulLastFlushTime) >= m_uiFlushInterval));
+		LogRecord * pRecord = GetNextRecord();
+
+		if(pRecord || bFlush)
+		{
+			// Write everything that is waiting in one go
+			m_mutex.Lock();
+
+			for(; pRecord; pRecord = GetNextRecord())
+			{
+				if(pRecord->bConsole)
+					printf("%s\n", pRecord->szText);
+
+				WriteToFile(pRecord->time, pRecord->szText);
+				FreeRecord(pRecord);
+				bNeedsFlush = true;
+			}
+
+			if(bFlush)
+			{
+				fflush(stdout);
+
+				if(m_fLogFile)
+					fflush(m_fLogFile);
+
+				bNeedsFlush = false;
+				ulLastFlushTime = ulTime;
+			}
+
+			m_mutex.Unlock();
+			continue;
+		}
+
+		// Stop once everything has been written and flushed
+		if(!bRunning && !bNeedsFlush)
+			break;
+
+		// Sleep until there is something to write or the next flush is due
+		unsigned int uiWaitTime = LOG_WRITER_IDLE_WAIT;
+
+		if(bNeedsFlush)
+			uiWaitTime = (m_uiFlushInterval - (ulTime - ulLastFlushTime));
+
+		m_writerEvent.Wait(uiWaitTime);
+	}
+}
+
 void CLogFile::Print(const char * szString)
 {
+	// If we have a callback and it is enabled call it
+	if(m_bUseCallback && m_pfnCallback)
+		m_pfnCallback(szString);
+
+	// Leave the writing to the writer thread if it is running
+	if(m_bUseWriter)
+	{
+		PushRecord(szString, true);
+		return;
+	}
+
 	// Lock the mutex
-	m_mutex.TryLock(1);
+	m_mutex.Lock();
 
 	// Print the message
 	printf("%s\n", szString);
@@ -51,7 +267,11 @@ void CLogFile::Print(const char * szString)
 	fflush(stdout);
 
 	// Print the message to the log file
-	PrintToFile(szString);
+	WriteToFile(time(NULL), szString);
+
+	// Flush the log file buffer
+	if(m_fLogFile)
+		fflush(m_fLogFile);
 
 	// Unlock the mutex
 	m_mutex.Unlock();
@@ -59,9 +279,6 @@ void CLogFile::Print(const char * szString)
 
 void CLogFile::Printf(const char * szFormat, ...)
 {
-	// Lock the mutex
-	m_mutex.TryLock(1);
-
 	// Collect the arguments
 	va_list vaArgs;
 	char szBuffer[2048];
@@ -71,17 +288,11 @@ void CLogFile::Printf(const char * szFormat, ...)
 
 	// Print the message
 	Print(szBuffer);
-
-	// Unlock the mutex
-	m_mutex.Unlock();
 }
 
 void CLogFile::PrintDebugf(const char * szFormat, ...)
 {
 #ifdef _DEBUG
-	// Lock the mutex
-	m_mutex.TryLock(1);
-
 	// Collect the arguments
 	va_list vaArgs;
 	char szBuffer[2048];
@@ -91,33 +302,31 @@ void CLogFile::PrintDebugf(const char * szFormat, ...)
 
 	// Print the message
 	Print(szBuffer);
-
-	// Unlock the mutex
-	m_mutex.Unlock();
 #endif
 }
 
 void CLogFile::PrintToFile(const char * szString)
 {
-	// Lock the mutex
-	m_mutex.TryLock(1);
-
 	// If we have a callback and it is enabled call it
 	if(m_bUseCallback && m_pfnCallback)
 		m_pfnCallback(szString);
 
-	// Is the log file open?
-	if(m_fLogFile)
+	// Leave the writing to the writer thread if it is running
+	if(m_bUseWriter)
 	{
-		// Log the message
-		if(m_bUseTimeStamp)
-			fprintf(m_fLogFile, "[%s] %s\n", SharedUtility::GetTimeString(), szString);
-		else
-			fprintf(m_fLogFile, "%s\n", szString);
+		PushRecord(szString, false);
+		return;
+	}
+
+	// Lock the mutex
+	m_mutex.Lock();
+
+	// Log the message
+	WriteToFile(time(NULL), szString);
 
-		// Flush the log file buffer
+	// Flush the log file buffer
+	if(m_fLogFile)
 		fflush(m_fLogFile);
-	}
 
 	// Unlock the mutex
 	m_mutex.Unlock();
@@ -125,9 +334,6 @@ void CLogFile::PrintToFile(const char * szString)
 
 void CLogFile::PrintfToFile(const char * szFormat, ...)
 {
-	// Lock the mutex
-	m_mutex.TryLock(1);
-
 	// Collect the arguments
 	va_list vaArgs;
 	char szBuffer[2048];
@@ -137,15 +343,15 @@ void CLogFile::PrintfToFile(const char * szFormat, ...)
 
 	// Print the message to the log file
 	PrintToFile(szBuffer);
-
-	// Unlock the mutex
-	m_mutex.Unlock();
 }
 
 void CLogFile::Close()
 {
+	// Write all messages that are still waiting
+	StopWriter();
+
 	// Lock the mutex
-	m_mutex.TryLock(1);
+	m_mutex.Lock();
 
 	// Is the log file open?
 	if(m_fLogFile)
@@ -161,3 +367,76 @@ void CLogFile::Close()
 	// Unlock the mutex
 	m_mutex.Unlock();
 }
+
+void CLogFile::SetMaxFileSize(unsigned int uiMaxFileSize)
+{
+	m_mutex.Lock();
+	m_uiMaxFileSize = uiMaxFileSize;
+	m_mutex.Unlock();
+}
+
+void CLogFile::StartWriter(unsigned int uiFlushInterval)
+{
+	if(m_bUseWriter)
+		return;
+
+	// Every record starts free for the position it will be written at
+	m_pRecords = new LogRecord[LOG_WRITER_RECORDS];
+	CMemoryTracker::Allocated(MEMORY_TAG_LOG, (sizeof(LogRecord) * LOG_WRITER_RECORDS));
+
+	for(long i = 0; i < LOG_WRITER_RECORDS; i++)
+		m_pRecords[i].lSequence = i;
+
+	m_lWritePosition = 0;
+	m_lReadPosition = 0;
+	m_uiFlushInterval = uiFlushInterval;
+	m_pWriterThread = new CThread();
+	m_pWriterThread->SetUserData<bool>(true);
+	m_pWriterThread->Start(WriterThread);
+	m_bUseWriter = true;
+}
+
+void CLogFile::StopWriter()
+{
+	if(!m_bUseWriter)
+		return;
+
+	// Messages are written directly again from now on, the writer thread
+	// writes the waiting ones before it exits
+	m_bUseWriter = false;
+	m_pWriterThread->SetUserData<bool>(false);
+	m_writerEvent.Signal();
+
+	while(m_pWriterThread->IsRunning())
+		Sleep(1);
+
+	m_pWriterThread->Stop();
+	delete m_pWriterThread;
+	m_pWriterThread = NULL;
+	delete [] m_pRecords;
+	m_pRecords = NULL;
+	CMemoryTracker::Freed(MEMORY_TAG_LOG, (sizeof(LogRecord) * LOG_WRITER_RECORDS));
+}
+
+void CLogFile::Flush()
+{
+	if(!m_bUseWriter)
+		return;
+
+	// Wait for the writer thread to take all records (but not forever in
+	// case it is the thread that crashed)
+	unsigned long ulStartTime = SharedUtility::GetTime();
+
+	while(GetPositionDifference(m_lWritePosition, m_lReadPosition) > 0 && (SharedUtility::GetTime() - ulStartTime) < LOG_WRITER_FLUSH_TIMEOUT)
+		Sleep(1);
+
+	if(!m_mutex.TryLock(LOG_WRITER_FLUSH_TIMEOUT))
+		return;
+
+	fflush(stdout);
+
+	if(m_fLogFile)
+		fflush(m_fLogFile);
+
+	m_mutex.Unlock();
+}
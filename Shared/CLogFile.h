@@ -10,11 +10,37 @@
 #pragma once
 
 #include <stdio.h>
+#include <time.h>
 #include "CString.h"
 #include "Threading/CMutex.h"
+#include "Threading/CThreadEvent.h"
+
+// Amount of records in the ring buffer of the log writer (must be a power of two)
+#define LOG_WRITER_RECORDS 1024
+
+// Maximum length of a single record (longer messages are truncated)
+#define LOG_RECORD_SIZE 2048
+
+// Maximum time in ms Flush waits for the log writer
+#define LOG_WRITER_FLUSH_TIMEOUT 1000
+
+// Maximum time in ms the log writer sleeps while there is nothing to write
+#define LOG_WRITER_IDLE_WAIT 1000
 
 typedef void (* LogFileCallback_t)(const char * szBuffer);
 
+// A message waiting for the log writer thread, the sequence tells the
+// writer (and the other threads) if the record is free or written
+struct LogRecord
+{
+	volatile long lSequence;
+	time_t        time;
+	bool          bConsole;
+	char          szText[LOG_RECORD_SIZE];
+};
+
+class CThread;
+
 class CLogFile
 {
 private:
@@ -23,6 +49,23 @@ private:
 	static LogFileCallback_t m_pfnCallback;
 	static bool              m_bUseTimeStamp;
 	static CMutex            m_mutex;
+	static String            m_strLogFile;
+	static long              m_lFileSize;
+	static unsigned int      m_uiMaxFileSize;
+	static LogRecord *       m_pRecords;
+	static volatile bool     m_bUseWriter;
+	static volatile long     m_lWritePosition;
+	static volatile long     m_lReadPosition;
+	static CThread *         m_pWriterThread;
+	static CThreadEvent      m_writerEvent; // Signaled when a record is waiting for the writer thread
+	static unsigned int      m_uiFlushInterval;
+
+	static void              WriteToFile(time_t time, const char * szString);
+	static void              RotateLogFile();
+	static void              PushRecord(const char * szString, bool bConsole);
+	static LogRecord *       GetNextRecord();
+	static void              FreeRecord(LogRecord * pRecord);
+	static void              WriterThread(CThread * pCreator);
 
 public: 
 	static void              SetUseCallback(bool bUseCallback) { m_mutex.Lock(); m_bUseCallback = bUseCallback; m_mutex.Unlock(); }
@@ -38,4 +81,14 @@ public:
 	static void              PrintToFile(const char * szString);
 	static void              PrintfToFile(const char * szFormat, ...);
 	static void              Close();
+
+	// Files bigger than uiMaxFileSize bytes are renamed and a new file is
+	// started, 0 never rotates the file
+	static void              SetMaxFileSize(unsigned int uiMaxFileSize);
+
+	// Messages are written by a writer thread once it is started, the
+	// console and the file are flushed every uiFlushInterval ms
+	static void              StartWriter(unsigned int uiFlushInterval);
+	static void              StopWriter();
+	static void              Flush();
 };
@@ -0,0 +1,106 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMemoryTracker.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <string.h>
+#include "CMemoryTracker.h"
+#include "CLogFile.h"
+
+static const char * g_szMemoryTagNames[MEMORY_TAG_MAX] =
+{
+	"scripts",
+	"entities",
+	"bitstreams",
+	"network",
+	"log",
+	"webserver"
+};
+
+// Slots are never reused so memory that is freed late is taken off the right script
+static MemoryCounter g_scriptCounters[MEMORY_TRACKER_MAX_SCRIPTS];
+static char          g_szScriptNames[MEMORY_TRACKER_MAX_SCRIPTS][MEMORY_TRACKER_SCRIPT_NAME_LENGTH] = { "unattributed" };
+static const char *  g_pScriptNames[MEMORY_TRACKER_MAX_SCRIPTS];
+static unsigned int  g_uiScriptSlots = 1;
+
+const char * CMemoryTracker::GetTagName(eMemoryTag tag)
+{
+	if(tag >= MEMORY_TAG_MAX)
+		return "unknown";
+
+	return g_szMemoryTagNames[tag];
+}
+
+const char ** CMemoryTracker::GetTagNames()
+{
+	return g_szMemoryTagNames;
+}
+
+unsigned int CMemoryTracker::GetScriptSlot(const char * szName)
+{
+	// Only the main thread loads scripts
+	for(unsigned int i = 1; i < g_uiScriptSlots; i++)
+	{
+		if(!strncmp(g_szScriptNames[i], szName, (MEMORY_TRACKER_SCRIPT_NAME_LENGTH - 1)))
+			return i;
+	}
+
+	if(g_uiScriptSlots == MEMORY_TRACKER_MAX_SCRIPTS)
+		return 0;
+
+	strncpy(g_szScriptNames[g_uiScriptSlots], szName, (MEMORY_TRACKER_SCRIPT_NAME_LENGTH - 1));
+	return g_uiScriptSlots++;
+}
+
+unsigned int CMemoryTracker::GetScriptSlotCount()
+{
+	return g_uiScriptSlots;
+}
+
+const char ** CMemoryTracker::GetScriptNames()
+{
+	// The names of the slots are never changed once they are given out
+	for(unsigned int i = 0; i < MEMORY_TRACKER_MAX_SCRIPTS; i++)
+		g_pScriptNames[i] = g_szScriptNames[i];
+
+	return g_pScriptNames;
+}
+
+MemoryCounter * CMemoryTracker::GetScriptCounter(unsigned int uiSlot)
+{
+	if(uiSlot >= MEMORY_TRACKER_MAX_SCRIPTS)
+		return NULL;
+
+	return &g_scriptCounters[uiSlot];
+}
+
+void CMemoryTracker::Print(MemoryCounter * pNetworkCounter)
+{
+	CLogFile::Print("Memory (current/peak in kb):");
+
+	for(int i = 0; i < MEMORY_TAG_MAX; i++)
+	{
+		MemoryCounter * pCounter = GetCounter((eMemoryTag)i);
+
+		// The network module counts for itself
+		if(i == MEMORY_TAG_NETWORK)
+		{
+			if(!pNetworkCounter)
+				continue;
+
+			pCounter = pNetworkCounter;
+		}
+
+		CLogFile::Printf("  %-12s %8ld / %ld", g_szMemoryTagNames[i], (pCounter->lCurrent / 1024), (pCounter->lPeak / 1024));
+	}
+
+	for(unsigned int i = 0; i < g_uiScriptSlots; i++)
+	{
+		if(g_scriptCounters[i].lPeak > 0)
+			CLogFile::Printf("  script %-24s %8ld / %ld", g_szScriptNames[i], (g_scriptCounters[i].lCurrent / 1024), (g_scriptCounters[i].lPeak / 1024));
+	}
+}
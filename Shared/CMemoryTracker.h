@@ -0,0 +1,84 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMemoryTracker.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include <Threading/CAtomic.h>
+
+// Amount of scripts whose memory is counted on its own, the memory of the
+// others (and of the vms that aren't a script) is counted as unattributed
+#define MEMORY_TRACKER_MAX_SCRIPTS 128
+
+// Longer script names are cut off
+#define MEMORY_TRACKER_SCRIPT_NAME_LENGTH 64
+
+// What the memory is used by
+enum eMemoryTag
+{
+	MEMORY_TAG_SCRIPTS,    // All squirrel vms
+	MEMORY_TAG_ENTITIES,   // The entity managers and their entities
+	MEMORY_TAG_BITSTREAMS, // Bit stream buffers that don't fit on the stack
+	MEMORY_TAG_NETWORK,    // RakNet, counted in the network module
+	MEMORY_TAG_LOG,        // The records of the log writer
+	MEMORY_TAG_WEBSERVER,  // Script requests and cached responses of the webserver
+	MEMORY_TAG_MAX
+};
+
+// Bytes in use now and at most since the start
+struct MemoryCounter
+{
+	volatile long lCurrent;
+	volatile long lPeak;
+};
+
+// Counts the memory of the subsystems that are known to grow. It only counts
+// what they tell it about, so the total is less than what the process uses.
+// The counters can be changed from any thread.
+class CMemoryTracker
+{
+public:
+	static MemoryCounter * GetCounter(eMemoryTag tag)
+	{
+		// Zero initialized before anything runs, each module has its own
+		static MemoryCounter counters[MEMORY_TAG_MAX];
+		return &counters[tag];
+	}
+
+	static void            Add(MemoryCounter * pCounter, long lBytes)
+	{
+		long lCurrent = CAtomic::Add(&pCounter->lCurrent, lBytes);
+		long lPeak = pCounter->lPeak;
+
+		while(lCurrent > lPeak)
+		{
+			long lOldPeak = CAtomic::CompareExchange(&pCounter->lPeak, lCurrent, lPeak);
+
+			if(lOldPeak == lPeak)
+				break;
+
+			lPeak = lOldPeak;
+		}
+	}
+
+	static void            Allocated(eMemoryTag tag, size_t sSize) { Add(GetCounter(tag), (long)sSize); }
+	static void            Freed(eMemoryTag tag, size_t sSize) { CAtomic::Add(&GetCounter(tag)->lCurrent, -(long)sSize); }
+	static const char    * GetTagName(eMemoryTag tag);
+	static const char   ** GetTagNames();
+
+	// Returns the counter slot of the script, scripts that are loaded again
+	// keep their slot. Slot 0 is the unattributed memory.
+	static unsigned int    GetScriptSlot(const char * szName);
+	static unsigned int    GetScriptSlotCount();
+	static const char   ** GetScriptNames();
+	static MemoryCounter * GetScriptCounter(unsigned int uiSlot);
+
+	// Prints the counters of the tags and the scripts to the log
+	static void            Print(MemoryCounter * pNetworkCounter = NULL);
+};
@@ -9,10 +9,12 @@
 //==============================================================================
 
 #include "CSQLite.h"
+#include "Scripting/CSquirrelArguments.h"
 
 CSQLite::CSQLite()
 {
 	m_pDB = NULL;
+	m_uiReferences = 1;
 }
 
 CSQLite::~CSQLite()
@@ -21,6 +23,12 @@ CSQLite::~CSQLite()
 		close();
 }
 
+void CSQLite::release()
+{
+	if(--m_uiReferences == 0)
+		delete this;
+}
+
 bool CSQLite::open(String strFileName)
 {
 	if(m_pDB)
@@ -29,21 +37,282 @@ bool CSQLite::open(String strFileName)
 	return (sqlite3_open(strFileName.Get(), &m_pDB) == SQLITE_OK);
 }
 
+void CSQLite::clearStatements()
+{
+	m_statementMutex.Lock();
+
+	for(std::list<SQLiteCachedStatement>::iterator iter = m_statements.begin(); iter != m_statements.end(); iter++)
+		sqlite3_finalize((*iter).pStatement);
+
+	m_statements.clear();
+	m_statementMutex.Unlock();
+}
+
 bool CSQLite::close()
 {
 	if(!m_pDB)
 		return false;
 
-	return (sqlite3_close(m_pDB) == SQLITE_OK);
+	// Fails if any statements are still in use
+	clearStatements();
+
+	if(sqlite3_close(m_pDB) != SQLITE_OK)
+		return false;
+
+	m_pDB = NULL;
+	return true;
+}
+
+bool CSQLite::prepare(const char * szQuery, sqlite3_stmt ** ppStatement, const char ** pszTail, String * pstrError)
+{
+	*ppStatement = NULL;
+
+	if(!m_pDB || !szQuery)
+	{
+		if(pstrError)
+			pstrError->Set("database is not open");
+
+		return false;
+	}
+
+	// Is the statement in the cache?
+	m_statementMutex.Lock();
+
+	for(std::list<SQLiteCachedStatement>::iterator iter = m_statements.begin(); iter != m_statements.end(); iter++)
+	{
+		if((*iter).strQuery == szQuery)
+		{
+			*ppStatement = (*iter).pStatement;
+			m_statements.erase(iter);
+			break;
+		}
+	}
+
+	m_statementMutex.Unlock();
+
+	if(*ppStatement)
+	{
+		// Cached statements are always the whole query
+		if(pszTail)
+			*pszTail = (szQuery + strlen(szQuery));
+
+		return true;
+	}
+
+	if(sqlite3_prepare_v2(m_pDB, szQuery, -1, ppStatement, pszTail) != SQLITE_OK)
+	{
+		if(pstrError)
+			pstrError->Set(sqlite3_errmsg(m_pDB));
+
+		*ppStatement = NULL;
+		return false;
+	}
+
+	return true;
 }
 
-bool CSQLite::query(const char * szQuery)
+void CSQLite::finish(sqlite3_stmt * pStatement)
 {
-	if(szQuery)
+	if(!pStatement)
+		return;
+
+	sqlite3_reset(pStatement);
+	sqlite3_clear_bindings(pStatement);
+
+	// The statement is cached with the text it was prepared from (without
+	// any statements that came after it)
+	SQLiteCachedStatement statement;
+	statement.strQuery.Set(sqlite3_sql(pStatement));
+	statement.pStatement = pStatement;
+
+	m_statementMutex.Lock();
+	m_statements.push_front(statement);
+
+	if(m_statements.size() > SQLITE_STATEMENT_CACHE_SIZE)
+	{
+		sqlite3_finalize(m_statements.back().pStatement);
+		m_statements.pop_back();
+	}
+
+	m_statementMutex.Unlock();
+}
+
+bool CSQLite::bind(sqlite3_stmt * pStatement, int iIndex, CSquirrelArgument * pValue, String * pstrError)
+{
+	int iResult;
+
+	switch(pValue->GetType())
 	{
-		//char *zErrMsg;
-		//int rc = sqlite3_exec(m_pDB, szQuery, this->sqlitecallback, 0, &zErrMsg);
+	case OT_NULL:
+		iResult = sqlite3_bind_null(pStatement, iIndex);
+		break;
+	case OT_INTEGER:
+		iResult = sqlite3_bind_int(pStatement, iIndex, pValue->GetInteger());
+		break;
+	case OT_BOOL:
+		iResult = sqlite3_bind_int(pStatement, iIndex, pValue->GetBool() ? 1 : 0);
+		break;
+	case OT_FLOAT:
+		iResult = sqlite3_bind_double(pStatement, iIndex, pValue->GetFloat());
+		break;
+	case OT_STRING:
+		iResult = sqlite3_bind_text(pStatement, iIndex, pValue->GetString(), -1, SQLITE_TRANSIENT);
+		break;
+	default:
+		if(pstrError)
+			pstrError->Format("parameter %d has an unsupported type", iIndex);
+
 		return false;
 	}
-	return false;
+
+	if(iResult != SQLITE_OK)
+	{
+		if(pstrError)
+			pstrError->Set(sqlite3_errmsg(sqlite3_db_handle(pStatement)));
+
+		return false;
+	}
+
+	return true;
+}
+
+bool CSQLite::bind(sqlite3_stmt * pStatement, CSquirrelArguments * pParameters, String * pstrError)
+{
+	if(!pParameters || pParameters->empty())
+		return true;
+
+	// A single table binds its values to the parameters named by its keys
+	// (e.g. { ":name" = "jenksta" }), anything else is bound by position
+	CSquirrelArguments * pNamedParameters = NULL;
+
+	if(pParameters->size() == 1)
+		pNamedParameters = pParameters->front()->GetTable();
+
+	if(!pNamedParameters)
+	{
+		for(unsigned int i = 0; i < pParameters->size(); i++)
+		{
+			if(!bind(pStatement, (int)(i + 1), pParameters->get(i), pstrError))
+				return false;
+		}
+
+		return true;
+	}
+
+	for(unsigned int i = 0; i < pNamedParameters->size(); i += 2)
+	{
+		const char * szName = pNamedParameters->get(i)->GetString();
+		int iIndex = (szName ? sqlite3_bind_parameter_index(pStatement, szName) : 0);
+
+		if(iIndex == 0)
+		{
+			if(pstrError)
+				pstrError->Format("unknown parameter %s", szName ? szName : "(not a string)");
+
+			return false;
+		}
+
+		if(!bind(pStatement, iIndex, pNamedParameters->get(i + 1), pstrError))
+			return false;
+	}
+
+	return true;
+}
+
+void CSQLite::getRow(sqlite3_stmt * pStatement, CSquirrelArguments * pRow)
+{
+	int iColumns = sqlite3_column_count(pStatement);
+
+	for(int i = 0; i < iColumns; i++)
+	{
+		pRow->push(sqlite3_column_name(pStatement, i));
+
+		switch(sqlite3_column_type(pStatement, i))
+		{
+		case SQLITE_INTEGER:
+			pRow->push(sqlite3_column_int(pStatement, i));
+			break;
+		case SQLITE_FLOAT:
+			pRow->push((float)sqlite3_column_double(pStatement, i));
+			break;
+		case SQLITE_NULL:
+			pRow->push();
+			break;
+		default:
+			// Text and blobs are both returned as strings
+			pRow->push((const char *)sqlite3_column_text(pStatement, i));
+			break;
+		}
+	}
+}
+
+bool CSQLite::query(const char * szQuery, CSquirrelArguments * pParameters, CSquirrelArguments * pRows, String * pstrError)
+{
+	// This is also called from the sqlite worker thread so the rows must only
+	// be built as arguments here and pushed to the vm later
+	const char * szTail = szQuery;
+	bool bBound = false;
+
+	if(!m_pDB || !szQuery)
+	{
+		if(pstrError)
+			pstrError->Set("database is not open");
+
+		return false;
+	}
+
+	// Run every statement of the query, the rows of the last one are returned
+	while(*szTail)
+	{
+		sqlite3_stmt * pStatement = NULL;
+
+		if(!prepare(szTail, &pStatement, &szTail, pstrError))
+			return false;
+
+		// Whitespace or a comment
+		if(!pStatement)
+			continue;
+
+		// The parameters are bound to the first statement
+		if(!bBound)
+		{
+			bBound = true;
+
+			if(!bind(pStatement, pParameters, pstrError))
+			{
+				finish(pStatement);
+				return false;
+			}
+		}
+
+		if(pRows)
+			pRows->reset();
+
+		int iRow = 0;
+		int iResult;
+
+		while((iResult = sqlite3_step(pStatement)) == SQLITE_ROW)
+		{
+			if(!pRows)
+				continue;
+
+			CSquirrelArguments * pRow = new CSquirrelArguments();
+			getRow(pStatement, pRow);
+			pRows->push(++iRow);
+			pRows->push(pRow, false);
+		}
+
+		if(iResult != SQLITE_DONE)
+		{
+			if(pstrError)
+				pstrError->Set(sqlite3_errmsg(m_pDB));
+
+			finish(pStatement);
+			return false;
+		}
+
+		finish(pStatement);
+	}
+
+	return true;
 }
@@ -9,21 +9,56 @@
 //
 //==============================================================================
 
+#pragma once
+
+#include <list>
 #include "sqlite/sqlite3.h"
 #include <CString.h>
+#include <Threading/CMutex.h>
+
+// Maximum amount of prepared statements kept by each database
+#define SQLITE_STATEMENT_CACHE_SIZE 32
+
+class CSquirrelArgument;
+class CSquirrelArguments;
 
+// A prepared statement that isn't in use
+struct SQLiteCachedStatement
+{
+	String         strQuery;
+	sqlite3_stmt * pStatement;
+};
+
+// Prepared statements are taken out of the cache while they are used and put
+// back by finish so the same statement is never used twice at once. The
+// cache is used from the sqlite worker thread as well.
 class CSQLite
 {
 private:
-	sqlite3 * m_pDB;
+	sqlite3 *                         m_pDB;
+	unsigned int                      m_uiReferences;
+	CMutex                            m_statementMutex; // Mutex for m_statements
+	std::list<SQLiteCachedStatement>  m_statements; // Most recently used first
+
+	void      clearStatements();
 
 public:
 	CSQLite();
 	~CSQLite();
 
+	// The database is deleted when the last reference is released
+	void      addref() { m_uiReferences++; }
+	void      release();
+
 	sqlite3 * getDatabase() { return m_pDB; }
 	bool      isopen() { return (m_pDB != NULL); }
 	bool      open(String strFileName);
 	bool      close();
-	bool      query(const char * szQuery);
+	bool      prepare(const char * szQuery, sqlite3_stmt ** ppStatement, const char ** pszTail = NULL, String * pstrError = NULL);
+	void      finish(sqlite3_stmt * pStatement);
+	bool      query(const char * szQuery, CSquirrelArguments * pParameters, CSquirrelArguments * pRows, String * pstrError = NULL);
+
+	static bool bind(sqlite3_stmt * pStatement, int iIndex, CSquirrelArgument * pValue, String * pstrError = NULL);
+	static bool bind(sqlite3_stmt * pStatement, CSquirrelArguments * pParameters, String * pstrError = NULL);
+	static void getRow(sqlite3_stmt * pStatement, CSquirrelArguments * pRow);
 };
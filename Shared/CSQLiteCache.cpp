@@ -0,0 +1,347 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSQLiteCache.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CSQLiteCache.h"
+#include "Scripting/CSquirrelArguments.h"
+#include "Network/CBitStream.h"
+#include "SharedUtility.h"
+
+#ifdef _LINUX
+#include <unistd.h>
+#define Sleep(ms) usleep((ms) * 1000)
+#endif
+
+std::list<CSQLiteCache *> CSQLiteCache::m_caches;
+
+CSQLiteCache::CSQLiteCache()
+	: m_pSQLite(NULL),
+	m_ulFlushInterval(0),
+	m_ulLastFlushTime(0),
+	m_bStopping(false),
+	m_bWriting(false)
+{
+	m_caches.push_back(this);
+}
+
+CSQLiteCache::~CSQLiteCache()
+{
+	Close();
+
+	for(std::map<String, CSquirrelArgument *>::iterator iter = m_records.begin(); iter != m_records.end(); ++iter)
+		delete (*iter).second;
+
+	m_caches.remove(this);
+}
+
+bool CSQLiteCache::Open(const String& strFileName, const String& strTable, unsigned long ulFlushInterval, String& strError)
+{
+	if(m_pSQLite)
+	{
+		strError.Set("cache is already open");
+		return false;
+	}
+
+	// The table name is put into the queries as it is
+	if(strTable.IsEmpty())
+	{
+		strError.Set("table name is empty");
+		return false;
+	}
+
+	for(size_t i = 0; i < strTable.GetLength(); i++)
+	{
+		char c = strTable[i];
+
+		if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'))
+		{
+			strError.Set("table names can only have letters, digits and underscores");
+			return false;
+		}
+	}
+
+	m_pSQLite = new CSQLite();
+
+	if(!m_pSQLite->open(strFileName))
+	{
+		strError.Set("can't open the database");
+		m_pSQLite->release();
+		m_pSQLite = NULL;
+		return false;
+	}
+
+	m_strTable = strTable;
+
+	// Commits only append to the write ahead log and readers never wait for the writer
+	sqlite3_busy_timeout(m_pSQLite->getDatabase(), 5000);
+	sqlite3_exec(m_pSQLite->getDatabase(), "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL; PRAGMA temp_store=MEMORY; PRAGMA cache_size=-8192;", NULL, NULL, NULL);
+
+	if(!Load(strError))
+	{
+		m_pSQLite->close();
+		m_pSQLite->release();
+		m_pSQLite = NULL;
+		return false;
+	}
+
+	m_ulFlushInterval = ulFlushInterval;
+	m_ulLastFlushTime = SharedUtility::GetTime();
+	m_bStopping = false;
+	m_thread.SetUserData<CSQLiteCache *>(this);
+	m_thread.Start(WriterThread);
+	return true;
+}
+
+bool CSQLiteCache::Load(String& strError)
+{
+	sqlite3 * pDB = m_pSQLite->getDatabase();
+	String strCreate("CREATE TABLE IF NOT EXISTS %s (key TEXT PRIMARY KEY, value BLOB)", m_strTable.Get());
+
+	if(sqlite3_exec(pDB, strCreate.Get(), NULL, NULL, NULL) != SQLITE_OK)
+	{
+		strError.Set(sqlite3_errmsg(pDB));
+		return false;
+	}
+
+	String strSelect("SELECT key, value FROM %s", m_strTable.Get());
+	sqlite3_stmt * pStatement;
+
+	if(!m_pSQLite->prepare(strSelect.Get(), &pStatement, NULL, &strError))
+		return false;
+
+	while(sqlite3_step(pStatement) == SQLITE_ROW)
+	{
+		String strKey;
+		strKey.Set((const char *)sqlite3_column_text(pStatement, 0));
+		CSquirrelArgument * pValue = new CSquirrelArgument();
+		int iSize = sqlite3_column_bytes(pStatement, 1);
+
+		if(iSize > 0)
+		{
+			CBitStream bitStream((unsigned char *)sqlite3_column_blob(pStatement, 1), (unsigned int)iSize, false);
+			pValue->deserialize(&bitStream);
+		}
+
+		std::map<String, CSquirrelArgument *>::iterator iter = m_records.find(strKey);
+
+		if(iter != m_records.end())
+		{
+			delete (*iter).second;
+			(*iter).second = pValue;
+		}
+		else
+			m_records.insert(std::pair<String, CSquirrelArgument *>(strKey, pValue));
+	}
+
+	m_pSQLite->finish(pStatement);
+	return true;
+}
+
+CSquirrelArgument * CSQLiteCache::Get(const String& strKey)
+{
+	std::map<String, CSquirrelArgument *>::iterator iter = m_records.find(strKey);
+
+	if(iter == m_records.end())
+		return NULL;
+
+	return (*iter).second;
+}
+
+void CSQLiteCache::Set(const String& strKey, const CSquirrelArgument& value)
+{
+	std::map<String, CSquirrelArgument *>::iterator iter = m_records.find(strKey);
+
+	if(iter != m_records.end())
+		(*iter).second->set(value);
+	else
+		m_records.insert(std::pair<String, CSquirrelArgument *>(strKey, new CSquirrelArgument(value)));
+
+	m_dirtyKeys[strKey] = false;
+}
+
+bool CSQLiteCache::Remove(const String& strKey)
+{
+	std::map<String, CSquirrelArgument *>::iterator iter = m_records.find(strKey);
+
+	if(iter == m_records.end())
+		return false;
+
+	delete (*iter).second;
+	m_records.erase(iter);
+	m_dirtyKeys[strKey] = true;
+	return true;
+}
+
+void CSQLiteCache::Flush()
+{
+	m_ulLastFlushTime = SharedUtility::GetTime();
+
+	if(!m_pSQLite || m_dirtyKeys.empty())
+		return;
+
+	// The values are serialized here, the writer thread only gets bytes
+	std::vector<SQLiteCacheWrite> * pBatch = new std::vector<SQLiteCacheWrite>(m_dirtyKeys.size());
+	size_t sIndex = 0;
+
+	for(std::map<String, bool>::iterator iter = m_dirtyKeys.begin(); iter != m_dirtyKeys.end(); ++iter, sIndex++)
+	{
+		SQLiteCacheWrite& write = (*pBatch)[sIndex];
+		write.strKey = (*iter).first;
+		write.bRemove = (*iter).second;
+
+		if(!write.bRemove)
+		{
+			CBitStream bitStream;
+			m_records[write.strKey]->serialize(&bitStream);
+			write.value.assign(bitStream.GetData(), (bitStream.GetData() + bitStream.GetNumberOfBytesUsed()));
+		}
+	}
+
+	m_dirtyKeys.clear();
+
+	m_mutex.Lock();
+	m_batches.push_back(pBatch);
+	m_mutex.Unlock();
+}
+
+void CSQLiteCache::Close()
+{
+	if(!m_pSQLite)
+		return;
+
+	Flush();
+
+	// Let the writer thread finish all batches so no writes are lost
+	m_mutex.Lock();
+	m_bStopping = true;
+	m_mutex.Unlock();
+
+	while(m_thread.IsRunning())
+		Sleep(1);
+
+	m_thread.Stop();
+	m_pSQLite->close();
+	m_pSQLite->release();
+	m_pSQLite = NULL;
+}
+
+bool CSQLiteCache::GetWriteError(String& strError)
+{
+	m_mutex.Lock();
+	bool bFailed = !m_strError.IsEmpty();
+	strError = m_strError;
+	m_strError.Clear();
+	m_mutex.Unlock();
+	return !bFailed;
+}
+
+void CSQLiteCache::WriterThread(CThread * pCreator)
+{
+	CSQLiteCache * pCache = pCreator->GetUserData<CSQLiteCache *>();
+
+	while(true)
+	{
+		pCache->m_mutex.Lock();
+
+		if(pCache->m_batches.empty())
+		{
+			bool bStopping = pCache->m_bStopping;
+			pCache->m_mutex.Unlock();
+
+			if(bStopping)
+				break;
+
+			Sleep(1);
+			continue;
+		}
+
+		std::vector<SQLiteCacheWrite> * pBatch = pCache->m_batches.front();
+		pCache->m_batches.pop_front();
+		pCache->m_bWriting = true;
+		pCache->m_mutex.Unlock();
+
+		String strError;
+		bool bWritten = pCache->Write(pBatch, strError);
+		delete pBatch;
+
+		pCache->m_mutex.Lock();
+		pCache->m_bWriting = false;
+
+		if(!bWritten)
+			pCache->m_strError = strError;
+
+		pCache->m_mutex.Unlock();
+	}
+}
+
+bool CSQLiteCache::Write(std::vector<SQLiteCacheWrite> * pBatch, String& strError)
+{
+	sqlite3 * pDB = m_pSQLite->getDatabase();
+
+	if(sqlite3_exec(pDB, "BEGIN", NULL, NULL, NULL) != SQLITE_OK)
+	{
+		strError.Set(sqlite3_errmsg(pDB));
+		return false;
+	}
+
+	String strInsert("INSERT OR REPLACE INTO %s (key, value) VALUES (?, ?)", m_strTable.Get());
+	String strDelete("DELETE FROM %s WHERE key = ?", m_strTable.Get());
+	bool bWritten = true;
+
+	for(std::vector<SQLiteCacheWrite>::iterator iter = pBatch->begin(); bWritten && iter != pBatch->end(); ++iter)
+	{
+		sqlite3_stmt * pStatement;
+
+		if(!m_pSQLite->prepare((*iter).bRemove ? strDelete.Get() : strInsert.Get(), &pStatement, NULL, &strError))
+		{
+			bWritten = false;
+			break;
+		}
+
+		sqlite3_bind_text(pStatement, 1, (*iter).strKey.Get(), -1, SQLITE_STATIC);
+
+		if(!(*iter).bRemove)
+			sqlite3_bind_blob(pStatement, 2, ((*iter).value.empty() ? NULL : &(*iter).value[0]), (int)(*iter).value.size(), SQLITE_STATIC);
+
+		if(sqlite3_step(pStatement) != SQLITE_DONE)
+		{
+			strError.Set(sqlite3_errmsg(pDB));
+			bWritten = false;
+		}
+
+		m_pSQLite->finish(pStatement);
+	}
+
+	if(!bWritten)
+	{
+		sqlite3_exec(pDB, "ROLLBACK", NULL, NULL, NULL);
+		return false;
+	}
+
+	if(sqlite3_exec(pDB, "COMMIT", NULL, NULL, NULL) != SQLITE_OK)
+	{
+		strError.Set(sqlite3_errmsg(pDB));
+		sqlite3_exec(pDB, "ROLLBACK", NULL, NULL, NULL);
+		return false;
+	}
+
+	return true;
+}
+
+void CSQLiteCache::ProcessAll()
+{
+	unsigned long ulTime = SharedUtility::GetFrameTime();
+
+	for(std::list<CSQLiteCache *>::iterator iter = m_caches.begin(); iter != m_caches.end(); ++iter)
+	{
+		CSQLiteCache * pCache = (*iter);
+
+		if(pCache->m_ulFlushInterval > 0 && !pCache->m_dirtyKeys.empty() && (ulTime - pCache->m_ulLastFlushTime) >= pCache->m_ulFlushInterval)
+			pCache->Flush();
+	}
+}
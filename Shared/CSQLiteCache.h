@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSQLiteCache.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <vector>
+#include "CSQLite.h"
+#include "Threading/CThread.h"
+#include "Threading/CMutex.h"
+
+class CSquirrelArgument;
+
+// A change of a record that is waiting to be written
+struct SQLiteCacheWrite
+{
+	String                     strKey;
+	bool                       bRemove;
+	std::vector<unsigned char> value; // The serialized value
+};
+
+// The records of a database table kept in memory. Reads never touch the database,
+// changed records are written by a thread of the cache in a single transaction
+// each flush interval (and when the cache is closed) so the disk is never
+// waited on by the main thread.
+class CSQLiteCache
+{
+private:
+	CSQLite                                       * m_pSQLite;
+	String                                          m_strTable;
+	std::map<String, CSquirrelArgument *>           m_records;
+	std::map<String, bool>                          m_dirtyKeys; // Changed since the last flush, true if removed
+	unsigned long                                   m_ulFlushInterval;
+	unsigned long                                   m_ulLastFlushTime;
+
+	CThread                                         m_thread;
+	CMutex                                          m_mutex; // Mutex for the members up to m_strError
+	bool                                            m_bStopping;
+	std::list<std::vector<SQLiteCacheWrite> *>      m_batches;
+	bool                                            m_bWriting;
+	String                                          m_strError; // Of the last batch that failed
+
+	static std::list<CSQLiteCache *>                m_caches;
+
+	static void        WriterThread(CThread * pCreator);
+	bool               Write(std::vector<SQLiteCacheWrite> * pBatch, String& strError);
+	bool               Load(String& strError);
+
+public:
+	CSQLiteCache();
+	~CSQLiteCache();
+
+	// Opens the database (in WAL mode) and reads the table, it is created if needed
+	bool               Open(const String& strFileName, const String& strTable, unsigned long ulFlushInterval, String& strError);
+
+	// Returns NULL if there is no record of the key
+	CSquirrelArgument * Get(const String& strKey);
+	void               Set(const String& strKey, const CSquirrelArgument& value);
+	bool               Remove(const String& strKey);
+	const std::map<String, CSquirrelArgument *>& GetRecords() { return m_records; }
+
+	// Hands the changed records to the writer thread
+	void               Flush();
+
+	// Flushes and waits until everything is written
+	void               Close();
+
+	// Returns false (and the error) if a write failed since the last call
+	bool               GetWriteError(String& strError);
+
+	// Flushes the caches whose flush interval has passed
+	static void        ProcessAll();
+};
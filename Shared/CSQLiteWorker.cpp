@@ -0,0 +1,245 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSQLiteWorker.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "Scripting/CScriptingManager.h"
+#include "CSQLiteWorker.h"
+
+#ifdef _LINUX
+#include <unistd.h>
+#define Sleep(ms) usleep((ms) * 1000)
+#endif
+
+extern CScriptingManager * g_pScriptingManager;
+
+CSQLiteWorker * g_pSQLiteWorker = NULL;
+
+CSQLiteWorker::CSQLiteWorker()
+{
+	m_bStopping = false;
+	m_pRunningQuery = NULL;
+	m_thread.SetUserData<CSQLiteWorker *>(this);
+	m_thread.Start(WorkerThread);
+}
+
+CSQLiteWorker::~CSQLiteWorker()
+{
+	// Let the worker thread finish all queries so no writes are lost
+	WaitForQueries(NULL, NULL);
+
+	m_mutex.Lock();
+	m_bStopping = true;
+	m_mutex.Unlock();
+
+	while(m_thread.IsRunning())
+		Sleep(1);
+
+	m_thread.Stop();
+
+	// The callbacks of the completed queries are never called
+	for(std::list<SQLiteQuery *>::iterator iter = m_completedQueries.begin(); iter != m_completedQueries.end(); iter++)
+		DeleteQuery(*iter);
+
+	for(std::list<SQLiteQuery *>::iterator iter = m_processingQueries.begin(); iter != m_processingQueries.end(); iter++)
+		DeleteQuery(*iter);
+}
+
+void CSQLiteWorker::WorkerThread(CThread * pCreator)
+{
+	CSQLiteWorker * pWorker = pCreator->GetUserData<CSQLiteWorker *>();
+
+	while(true)
+	{
+		pWorker->m_mutex.Lock();
+
+		if(pWorker->m_bStopping)
+		{
+			pWorker->m_mutex.Unlock();
+			break;
+		}
+
+		if(pWorker->m_queries.empty())
+		{
+			pWorker->m_mutex.Unlock();
+			Sleep(1);
+			continue;
+		}
+
+		SQLiteQuery * pQuery = pWorker->m_queries.front();
+		pWorker->m_queries.pop_front();
+		pWorker->m_pRunningQuery = pQuery;
+		pWorker->m_mutex.Unlock();
+
+		// Run the query without holding the mutex so the main thread can
+		// keep adding queries
+		pQuery->pRows = new CSquirrelArguments();
+		pQuery->bSucceeded = pQuery->pSQLite->query(pQuery->strQuery.Get(), &pQuery->parameters, pQuery->pRows, &pQuery->strError);
+
+		pWorker->m_mutex.Lock();
+		pWorker->m_pRunningQuery = NULL;
+		pWorker->m_completedQueries.push_back(pQuery);
+		pWorker->m_mutex.Unlock();
+	}
+}
+
+bool CSQLiteWorker::IsQueryOf(SQLiteQuery * pQuery, SQVM * pVM, CSQLite * pSQLite)
+{
+	if(pVM && pQuery->pVM != pVM)
+		return false;
+
+	if(pSQLite && pQuery->pSQLite != pSQLite)
+		return false;
+
+	return true;
+}
+
+void CSQLiteWorker::DeleteQuery(SQLiteQuery * pQuery)
+{
+	if(pQuery->pRows)
+		delete pQuery->pRows;
+
+	delete pQuery;
+}
+
+void CSQLiteWorker::WaitForQueries(SQVM * pVM, CSQLite * pSQLite)
+{
+	while(true)
+	{
+		bool bWaiting = false;
+		m_mutex.Lock();
+
+		if(m_pRunningQuery && IsQueryOf(m_pRunningQuery, pVM, pSQLite))
+			bWaiting = true;
+
+		for(std::list<SQLiteQuery *>::iterator iter = m_queries.begin(); !bWaiting && iter != m_queries.end(); iter++)
+		{
+			if(IsQueryOf(*iter, pVM, pSQLite))
+				bWaiting = true;
+		}
+
+		m_mutex.Unlock();
+
+		if(!bWaiting)
+			break;
+
+		Sleep(1);
+	}
+}
+
+bool CSQLiteWorker::Add(SQLiteQuery * pQuery)
+{
+	m_mutex.Lock();
+
+	if(m_queries.size() >= SQLITE_WORKER_MAX_QUERIES)
+	{
+		m_mutex.Unlock();
+		return false;
+	}
+
+	pQuery->bSucceeded = false;
+	pQuery->pRows = NULL;
+	m_queries.push_back(pQuery);
+	m_mutex.Unlock();
+	return true;
+}
+
+void CSQLiteWorker::WaitForDatabase(CSQLite * pSQLite)
+{
+	WaitForQueries(NULL, pSQLite);
+}
+
+void CSQLiteWorker::RemoveQueries(std::list<SQLiteQuery *> * pQueries, SQVM * pVM)
+{
+	for(std::list<SQLiteQuery *>::iterator iter = pQueries->begin(); iter != pQueries->end(); )
+	{
+		if((*iter)->pVM == pVM)
+		{
+			DeleteQuery(*iter);
+			iter = pQueries->erase(iter);
+		}
+		else
+			iter++;
+	}
+}
+
+void CSQLiteWorker::RemoveScript(SQVM * pVM)
+{
+	// The queries of the script still run so no writes are lost, only their
+	// callbacks are dropped. The queries hold references to objects of the
+	// script so they must go before the script does.
+	WaitForQueries(pVM, NULL);
+
+	m_mutex.Lock();
+	RemoveQueries(&m_completedQueries, pVM);
+	m_mutex.Unlock();
+	RemoveQueries(&m_processingQueries, pVM);
+}
+
+void CSQLiteWorker::Process()
+{
+	m_mutex.Lock();
+
+	if(m_completedQueries.empty())
+	{
+		m_mutex.Unlock();
+		return;
+	}
+
+	// The queries are kept in a member so RemoveScript can remove them while
+	// we call their callbacks
+	m_processingQueries.splice(m_processingQueries.end(), m_completedQueries);
+	m_mutex.Unlock();
+
+	while(!m_processingQueries.empty())
+	{
+		SQLiteQuery * pQuery = m_processingQueries.front();
+		m_processingQueries.pop_front();
+		CSquirrel * pScript = g_pScriptingManager->Get(pQuery->pVM);
+
+		if(pQuery->uiCoroutine != 0)
+		{
+			// The coroutine gets the rows or the error is thrown in it
+			if(pQuery->bSucceeded)
+			{
+				CSquirrelArgument rows(pQuery->pRows, false);
+				pQuery->pRows = NULL;
+				g_pScriptingManager->ResumeCoroutine(pQuery->uiCoroutine, rows);
+			}
+			else
+				g_pScriptingManager->FailCoroutine(pQuery->uiCoroutine, pQuery->strError);
+		}
+		else if(pScript)
+		{
+			// Call the callback with the rows (or false and the error) followed
+			// by the arguments given to queryAsync
+			CSquirrelArguments arguments;
+
+			if(pQuery->bSucceeded)
+			{
+				arguments.push(pQuery->pRows, false);
+				pQuery->pRows = NULL;
+				arguments.push();
+			}
+			else
+			{
+				arguments.push(false);
+				arguments.push(pQuery->strError);
+			}
+
+			for(unsigned int i = 0; i < pQuery->arguments.size(); i++)
+			{
+				arguments.push();
+				arguments.back()->set(*pQuery->arguments.get(i));
+			}
+
+			pScript->Call(pQuery->pFunction, &arguments);
+		}
+
+		DeleteQuery(pQuery);
+	}
+}
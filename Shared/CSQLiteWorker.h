@@ -0,0 +1,71 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSQLiteWorker.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <list>
+#include "CSQLite.h"
+#include "Threading/CThread.h"
+#include "Threading/CMutex.h"
+#include "Scripting/CSquirrel.h"
+
+// Maximum amount of queries that can be waiting for the worker thread
+#define SQLITE_WORKER_MAX_QUERIES 4096
+
+// A query that is run on the worker thread
+struct SQLiteQuery
+{
+	// Only used by the worker thread while the query is queued or running
+	CSQLite *            pSQLite;
+	String               strQuery;
+	CSquirrelArguments   parameters;
+	bool                 bSucceeded;
+	String               strError;
+	CSquirrelArguments * pRows;
+
+	// Only used by the main thread
+	SQVM *               pVM;
+	SQObjectPtr          pDatabase;
+	SQObjectPtr          pFunction;
+	CSquirrelArguments   arguments;
+	unsigned int         uiCoroutine; // Resumed with the rows instead of calling pFunction if not 0
+};
+
+// Runs database queries on a worker thread and calls their callbacks on the
+// main thread when Process is called. All queries go through a single queue
+// so the queries of a database (and its transactions) run in the order they
+// were made.
+class CSQLiteWorker
+{
+private:
+	CThread                    m_thread;
+	CMutex                     m_mutex; // Mutex for the members up to m_completedQueries
+	bool                       m_bStopping;
+	std::list<SQLiteQuery *>   m_queries;
+	SQLiteQuery *              m_pRunningQuery;
+	std::list<SQLiteQuery *>   m_completedQueries;
+	std::list<SQLiteQuery *>   m_processingQueries; // Only used by the main thread
+
+	static void  WorkerThread(CThread * pCreator);
+	static bool  IsQueryOf(SQLiteQuery * pQuery, SQVM * pVM, CSQLite * pSQLite);
+	static void  DeleteQuery(SQLiteQuery * pQuery);
+	void         WaitForQueries(SQVM * pVM, CSQLite * pSQLite);
+	void         RemoveQueries(std::list<SQLiteQuery *> * pQueries, SQVM * pVM);
+
+public:
+	CSQLiteWorker();
+	~CSQLiteWorker();
+
+	bool         Add(SQLiteQuery * pQuery);
+	void         WaitForDatabase(CSQLite * pSQLite);
+	void         RemoveScript(SQVM * pVM);
+	void         Process();
+};
+
+extern CSQLiteWorker * g_pSQLiteWorker;
@@ -12,10 +12,23 @@
 #include "SharedUtility.h"
 #include "CLogFile.h"
 
+#ifdef _LINUX
+#include <unistd.h>
+#define Sleep(ms) usleep((ms) * 1000)
+#endif
+
 std::map<String, SettingsValue *> CSettings::m_values;
 bool                              CSettings::m_bOpen = false;
 bool                              CSettings::m_bSave = false;
 TiXmlDocument                     CSettings::m_XMLDocument;
+String                            CSettings::m_strPath;
+unsigned int                      CSettings::m_uiGeneration = 1;
+bool                              CSettings::m_bDirty = false;
+unsigned long                     CSettings::m_ulDirtyTime = 0;
+CThread                           CSettings::m_saveThread;
+CMutex                            CSettings::m_saveMutex;
+String                            CSettings::m_strSaveData;
+bool                              CSettings::m_bSavePending = false;
 
 void CSettings::LoadDefaults()
 {
@@ -25,15 +38,68 @@ void CSettings::LoadDefaults()
 	AddInteger("port", 9999, 1024, 65535);
 	AddInteger("httpport", 9998, 80, 65535);
 	AddString("httpserver", "");
-	AddInteger("maxplayers", MAX_PLAYERS, 1, MAX_PLAYERS);
+	AddBool("hashedfiles", false);
+	AddString("hashedfilesfolder", "hashedfiles");
+	AddBool("clientscriptbytecode", true);
+	AddBool("clientfilepack", true);
+	AddInteger("maxplayers", 48, 1, MAX_PLAYERS);
 	AddInteger("maxvehicles", MAX_VEHICLES, 0, MAX_VEHICLES);
 	AddString("password", "");
 	AddBool("query", true);
+	AddInteger("querycacheinterval", 1000, 0, 60000);
+	AddInteger("queryratelimit", 10, 0, 10000);
+	AddInteger("querypacketspersecond", 4096, 0, 1000000);
 	AddBool("listed", false);
 	AddBool("guinametags",false);
 	AddBool("headmovement",true);
+	AddFloat("syncrange", 300.0f, 0.0f, 10000.0f);
+	AddInteger("farsyncinterval", 1000, 0, 60000);
+	AddBool("adaptivesyncrate", true);
+	AddInteger("minsyncinterval", (TICK_RATE / 2), 10, 1000);
+	AddInteger("maxsyncinterval", (TICK_RATE * 4), 10, 5000);
+	AddInteger("syncbandwidth", 32768, 0, 1048576);
+	AddBool("commandbatching", true);
+	AddInteger("joinstreambandwidth", 262144, 0, 16777216);
+	AddInteger("netsimlatency", 0, 0, 10000);
+	AddInteger("netsimjitter", 0, 0, 10000);
+	AddFloat("netsimloss", 0.0f, 0.0f, 100.0f);
+	AddFloat("netsimreorder", 0.0f, 0.0f, 100.0f);
+	AddFloat("netsimduplicate", 0.0f, 0.0f, 100.0f);
+	AddInteger("netsimbandwidth", 0, 0, 100000000);
+	AddInteger("compressionthreshold", 0, 0, 1048576);
+	AddFloat("streamdistance", 300.0f, 0.0f, 10000.0f);
+	AddFloat("blipstreamdistance", 500.0f, 0.0f, 10000.0f);
+	AddBool("networkthread", true);
+	AddInteger("servertickrate", 200, 10, 1000);
+	AddInteger("idletickrate", 10, 0, 1000);
+	AddBool("idletimers", true);
+	AddInteger("jobthreads", -1, -1, 64);
+	AddBool("tickprofiler", true);
+	AddBool("metrics", true);
+	AddBool("scriptcache", true);
+	AddInteger("scriptcallbudget", 0, 0, 60000);
+	AddInteger("scripttickbudget", 0, 0, 1000);
+	AddBool("scriptdeferevents", false);
+	AddInteger("scriptmemorylimit", 0, 0, 1048576);
+	AddInteger("scriptgcinterval", 10000, 0, 3600000);
+	AddInteger("scriptgcbudget", 2000, 0, 1000000);
+	AddInteger("clienteventrate", 100, 0, 100000);
+	AddInteger("clienteventburst", 200, 1, 100000);
+	AddInteger("httprequests", 16, 1, 256);
+	AddInteger("httprequestsperhost", 4, 1, 256);
+	AddBool("logasync", false);
+	AddInteger("logflushinterval", 1000, 0, 60000);
+	AddInteger("logmaxsize", 0, 0, 2047);
+	AddInteger("dbcacheflushinterval", 5000, 0, 3600000);
 	AddString("hostname", VERSION_IDENTIFIER_2 " Server");
 	AddString("hostaddress", "");
+	AddString("transfersecret", "");
+	AddInteger("transfertimeout", 30, 5, 3600);
+	AddString("relaypassword", "");
+	AddString("admintoken", "");
+	AddInteger("busport", 0, 0, 65535);
+	AddString("bussecret", "");
+	AddString("busname", "");
 	AddBool("frequentevents", false);
 	AddBool("kickoldplayers", true);
 	AddBool("paynspray", true);
@@ -43,10 +109,13 @@ void CSettings::LoadDefaults()
 	AddBool("silent", false);
 	AddBool("timestamp", true);
 	AddList("script");
+	AddList("instance");
 	AddList("clientscript");
+	AddList("lazyclientscript");
 	AddList("clientresource");
 	AddList("module");
 	AddList("config");
+	AddList("buspeer");
 #else
 	AddString("ip", "127.0.0.1");
 	AddInteger("port", 9999, 1024, 65535);
@@ -62,21 +131,26 @@ void CSettings::LoadDefaults()
 	AddInteger("chatbgr", 0, 0, 255);
 	AddInteger("chatbgg", 0, 0, 255);
 	AddInteger("chatbgb", 0, 0, 255);
+	AddString("fontglyphranges", "0x20-0x24F,0x400-0x4FF");
+	AddBool("networkthread", true);
+	AddInteger("networkprocesstime", 4, 0, 1000);
+	AddString("screenshotformat", "png");
+	AddInteger("screenshotquality", 90, 1, 100);
+	AddInteger("modelbudget", 64, 0, 1000);
 #endif
 }
 
-SettingsValue * CSettings::GetSetting(String strSetting)
+SettingsValue * CSettings::GetSetting(const String& strSetting)
 {
-	for(std::map<String, SettingsValue *>::iterator iter = m_values.begin(); iter != m_values.end(); iter++)
-	{
-		if(iter->first == strSetting)
-			return iter->second;
-	}
+	std::map<String, SettingsValue *>::iterator iter = m_values.find(strSetting);
+
+	if(iter != m_values.end())
+		return iter->second;
 
 	return NULL;
 }
 
-bool CSettings::Open(String strPath, bool bCreate, bool bSave)
+bool CSettings::Open(const String& strPath, bool bCreate, bool bSave)
 {
 	// Flag we are not allowed to save the file by default
 	m_bSave = false;
@@ -128,6 +202,7 @@ bool CSettings::Open(String strPath, bool bCreate, bool bSave)
 		{
 			// Flag ourselves as open
 			m_bOpen = true;
+			m_strPath = strPath;
 
 			// Loop through all XML nodes
 			for(TiXmlNode * pNode = m_XMLDocument.RootElement()->FirstChildElement(); pNode; pNode = pNode->NextSibling())
@@ -150,7 +225,7 @@ bool CSettings::Open(String strPath, bool bCreate, bool bSave)
 			// Flag if we are allowed to save the file
 			m_bSave = bSave;
 
-			// Save the XML file
+			// Save the XML file once with everything that was loaded
 			Save();
 		}
 		else
@@ -172,7 +247,29 @@ bool CSettings::Close()
 {
 	// Are we flagged as open?
 	if(m_bOpen)
+	{
+		// Save the changes that are still waiting and wait until the file is written
+		if(m_bDirty)
+			Save();
+
+		while(true)
+		{
+			m_saveMutex.Lock();
+			bool bSavePending = m_bSavePending;
+			m_saveMutex.Unlock();
+
+			if(!bSavePending && !m_saveThread.IsRunning())
+				break;
+
+			if(!m_saveThread.IsRunning())
+				StartSaveThread();
+
+			Sleep(1);
+		}
+
+		m_saveThread.Stop();
 		return true;
+	}
 
 	return false;	
 }
@@ -187,6 +284,8 @@ bool CSettings::Save()
 	if(!m_bSave)
 		return false;
 
+	m_bDirty = false;
+
 	// Loop through all values
 	for(std::map<String, SettingsValue *>::iterator iter = m_values.begin(); iter != m_values.end(); iter++)
 	{
@@ -274,11 +373,98 @@ bool CSettings::Save()
 		}
 	}
 
-	// Save the XML document
-	return m_XMLDocument.SaveFile();
+	// Print the XML document here, the save thread only gets the text
+	TiXmlPrinter printer;
+	m_XMLDocument.Accept(&printer);
+
+	m_saveMutex.Lock();
+	m_strSaveData.Set(printer.CStr());
+	m_bSavePending = true;
+	m_saveMutex.Unlock();
+
+	StartSaveThread();
+	return true;
 }
 
-bool CSettings::AddBool(String strSetting, bool bDefaultValue)
+void CSettings::Process()
+{
+	if(m_bDirty && (SharedUtility::GetTime() - m_ulDirtyTime) >= SETTINGS_SAVE_DELAY)
+		Save();
+
+	// The save thread may have been about to exit when the last save was handed to it
+	if(!m_saveThread.IsRunning())
+	{
+		m_saveMutex.Lock();
+		bool bSavePending = m_bSavePending;
+		m_saveMutex.Unlock();
+
+		if(bSavePending)
+			StartSaveThread();
+	}
+}
+
+void CSettings::SetDirty()
+{
+	// Are we not flagged as allowed to save the file?
+	if(!m_bOpen || !m_bSave)
+		return;
+
+	if(!m_bDirty)
+	{
+		m_bDirty = true;
+		m_ulDirtyTime = SharedUtility::GetTime();
+	}
+}
+
+void CSettings::StartSaveThread()
+{
+	if(!m_saveThread.IsRunning())
+		m_saveThread.Start(SaveThread);
+}
+
+void CSettings::SaveThread(CThread * pCreator)
+{
+	while(true)
+	{
+		m_saveMutex.Lock();
+
+		if(!m_bSavePending)
+		{
+			m_saveMutex.Unlock();
+			break;
+		}
+
+		String strData = m_strSaveData;
+		String strPath = m_strPath;
+		m_bSavePending = false;
+		m_saveMutex.Unlock();
+
+		// Write a temporary file and move it over the settings file so the settings
+		// file is never left half written
+		String strTempPath("%s.tmp", strPath.Get());
+		FILE * fFile = fopen(strTempPath.Get(), "wb");
+
+		if(!fFile)
+			continue;
+
+		bool bWritten = (fwrite(strData.Get(), 1, strData.GetLength(), fFile) == strData.GetLength());
+		bWritten = ((fclose(fFile) == 0) && bWritten);
+
+		if(!bWritten)
+		{
+			remove(strTempPath.Get());
+			continue;
+		}
+
+#ifdef WIN32
+		MoveFileEx(strTempPath.Get(), strPath.Get(), (MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH));
+#else
+		rename(strTempPath.Get(), strPath.Get());
+#endif
+	}
+}
+
+bool CSettings::AddBool(const String& strSetting, bool bDefaultValue)
 {
 	if(Exists(strSetting))
 		return false;
@@ -288,13 +474,14 @@ bool CSettings::AddBool(String strSetting, bool bDefaultValue)
 	SET_BIT(setting->cFlags, SETTINGS_FLAG_BOOL);
 	setting->bValue = bDefaultValue;
 	m_values[strSetting] = setting;
+	m_uiGeneration++;
 	
-	// Save the XML file
-	Save();
+	// Save the XML file later
+	SetDirty();
 	return true;
 }
 
-bool CSettings::AddInteger(String strSetting, int iDefaultValue, int iMinimumValue, int iMaximumValue)
+bool CSettings::AddInteger(const String& strSetting, int iDefaultValue, int iMinimumValue, int iMaximumValue)
 {
 	if(Exists(strSetting))
 		return false;
@@ -306,13 +493,14 @@ bool CSettings::AddInteger(String strSetting, int iDefaultValue, int iMinimumVal
 	setting->iMinimumValue = iMinimumValue;
 	setting->iMaximimValue = iMaximumValue;
 	m_values[strSetting] = setting;
+	m_uiGeneration++;
 
-	// Save the XML file
-	Save();
+	// Save the XML file later
+	SetDirty();
 	return true;
 }
 
-bool CSettings::AddFloat(String strSetting, float fDefaultValue, float fMinimumValue, float fMaximumValue)
+bool CSettings::AddFloat(const String& strSetting, float fDefaultValue, float fMinimumValue, float fMaximumValue)
 {
 	if(Exists(strSetting))
 		return false;
@@ -324,13 +512,14 @@ bool CSettings::AddFloat(String strSetting, float fDefaultValue, float fMinimumV
 	setting->fMinimumValue = fMinimumValue;
 	setting->fMaximimValue = fMaximumValue;
 	m_values[strSetting] = setting;
+	m_uiGeneration++;
 
-	// Save the XML file
-	Save();
+	// Save the XML file later
+	SetDirty();
 	return true;
 }
 
-bool CSettings::AddString(String strSetting, String strDefaultValue)
+bool CSettings::AddString(const String& strSetting, const String& strDefaultValue)
 {
 	if(Exists(strSetting))
 		return false;
@@ -340,13 +529,14 @@ bool CSettings::AddString(String strSetting, String strDefaultValue)
 	SET_BIT(setting->cFlags, SETTINGS_FLAG_STRING);
 	setting->strValue = strDefaultValue;
 	m_values[strSetting] = setting;
+	m_uiGeneration++;
 
-	// Save the XML file
-	Save();
+	// Save the XML file later
+	SetDirty();
 	return true;
 }
 
-bool CSettings::AddList(String strSetting)
+bool CSettings::AddList(const String& strSetting)
 {
 	if(Exists(strSetting))
 		return false;
@@ -355,90 +545,102 @@ bool CSettings::AddList(String strSetting)
 	setting->cFlags = 0;
 	SET_BIT(setting->cFlags, SETTINGS_FLAG_LIST);
 	m_values[strSetting] = setting;
+	m_uiGeneration++;
 	return true;
 }
 
-bool CSettings::SetBool(String strSetting, bool bValue)
+bool CSettings::SetBool(const String& strSetting, bool bValue)
 {
-	if(IsBool(strSetting))
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsBool())
 	{
-		GetSetting(strSetting)->bValue = bValue;
+		setting->bValue = bValue;
 
-		// Save the XML file
-		Save();
+		// Save the XML file later
+		SetDirty();
+		OnChanged(strSetting, setting);
 		return true;
 	}
 
 	return false;
 }
 
-bool CSettings::SetInteger(String strSetting, int iValue)
+bool CSettings::SetInteger(const String& strSetting, int iValue)
 {
-	if(IsInteger(strSetting))
-	{
-		SettingsValue * setting = GetSetting(strSetting);
+	SettingsValue * setting = GetSetting(strSetting);
 
+	if(setting && setting->IsInteger())
+	{
 		if(iValue < setting->iMinimumValue || iValue > setting->iMaximimValue)
 			return false;
 
 		setting->iValue = iValue;
 
-		// Save the XML file
-		Save();
+		// Save the XML file later
+		SetDirty();
+		OnChanged(strSetting, setting);
 		return true;
 	}
 
 	return false;
 }
 
-bool CSettings::SetFloat(String strSetting, float fValue)
+bool CSettings::SetFloat(const String& strSetting, float fValue)
 {
-	if(IsFloat(strSetting))
-	{
-		SettingsValue * setting = GetSetting(strSetting);
+	SettingsValue * setting = GetSetting(strSetting);
 
+	if(setting && setting->IsFloat())
+	{
 		if(fValue < setting->fMinimumValue || fValue > setting->fMaximimValue)
 			return false;
 
 		setting->fValue = fValue;
 
-		// Save the XML file
-		Save();
+		// Save the XML file later
+		SetDirty();
+		OnChanged(strSetting, setting);
 		return true;
 	}
 
 	return false;
 }
 
-bool CSettings::SetString(String strSetting, String strValue)
+bool CSettings::SetString(const String& strSetting, const String& strValue)
 {
-	if(IsString(strSetting))
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsString())
 	{
-		GetSetting(strSetting)->strValue = strValue;
+		setting->strValue = strValue;
 
-		// Save the XML file
-		Save();
+		// Save the XML file later
+		SetDirty();
+		OnChanged(strSetting, setting);
 		return true;
 	}
 
 	return false;
 }
 
-bool CSettings::AddToList(String strSetting, String strValue)
+bool CSettings::AddToList(const String& strSetting, const String& strValue)
 {
-	if(IsList(strSetting))
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsList())
 	{
-		GetSetting(strSetting)->listValue.push_back(strValue);
+		setting->listValue.push_back(strValue);
 
-		// Save the XML file
-		Save();
+		// Save the XML file later
+		SetDirty();
+		OnChanged(strSetting, setting);
 		return true;
 	}
 
 	return false;
 }
 
-bool CSettings::SetEx(String strSetting, String strValue)
+bool CSettings::SetEx(const String& strSetting, const String& strValue)
 {
 	if(IsBool(strSetting))
 		SetBool(strSetting, strValue.ToBoolean());
@@ -456,47 +658,57 @@ bool CSettings::SetEx(String strSetting, String strValue)
 	return true;
 }
 
-bool CSettings::GetBool(String strSetting)
+bool CSettings::GetBool(const String& strSetting)
 {
-	if(IsBool(strSetting))
-		return GetSetting(strSetting)->bValue;
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsBool())
+		return setting->bValue;
 
 	return false;
 }
 
-int CSettings::GetInteger(String strSetting)
+int CSettings::GetInteger(const String& strSetting)
 {
-	if(IsInteger(strSetting))
-		return GetSetting(strSetting)->iValue;
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsInteger())
+		return setting->iValue;
 
 	return 0;
 }
 
-float CSettings::GetFloat(String strSetting)
+float CSettings::GetFloat(const String& strSetting)
 {
-	if(IsFloat(strSetting))
-		return GetSetting(strSetting)->fValue;
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsFloat())
+		return setting->fValue;
 
 	return 0.0f;
 }
 
-String CSettings::GetString(String strSetting)
+String CSettings::GetString(const String& strSetting)
 {
-	if(IsString(strSetting))
-		return GetSetting(strSetting)->strValue;
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsString())
+		return setting->strValue;
 
 	return "";
 }
 
-std::list<String> CSettings::GetList(String strSetting)
+std::list<String> CSettings::GetList(const String& strSetting)
 {
-	if(IsList(strSetting))
-		return GetSetting(strSetting)->listValue;
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(setting && setting->IsList())
+		return setting->listValue;
 
 	return std::list<String>();
 }
 
-String CSettings::GetEx(String strSetting)
+String CSettings::GetEx(const String& strSetting)
 {
 	String strValue;
 
@@ -519,12 +731,12 @@ String CSettings::GetEx(String strSetting)
 	return strValue;
 }
 
-bool CSettings::Exists(String strSetting)
+bool CSettings::Exists(const String& strSetting)
 {
 	return (GetSetting(strSetting) != NULL);
 }
 
-bool CSettings::IsBool(String strSetting)
+bool CSettings::IsBool(const String& strSetting)
 {
 	SettingsValue * setting = GetSetting(strSetting);
 
@@ -535,7 +747,7 @@ bool CSettings::IsBool(String strSetting)
 
 }
 
-bool CSettings::IsInteger(String strSetting)
+bool CSettings::IsInteger(const String& strSetting)
 {
 	SettingsValue * setting = GetSetting(strSetting);
 
@@ -545,7 +757,7 @@ bool CSettings::IsInteger(String strSetting)
 	return false;
 }
 
-bool CSettings::IsFloat(String strSetting)
+bool CSettings::IsFloat(const String& strSetting)
 {
 	SettingsValue * setting = GetSetting(strSetting);
 
@@ -555,7 +767,7 @@ bool CSettings::IsFloat(String strSetting)
 	return false;
 }
 
-bool CSettings::IsString(String strSetting)
+bool CSettings::IsString(const String& strSetting)
 {
 	SettingsValue * setting = GetSetting(strSetting);
 
@@ -565,7 +777,7 @@ bool CSettings::IsString(String strSetting)
 	return false;
 }
 
-bool CSettings::IsList(String strSetting)
+bool CSettings::IsList(const String& strSetting)
 {
 	SettingsValue * setting = GetSetting(strSetting);
 
@@ -575,24 +787,62 @@ bool CSettings::IsList(String strSetting)
 	return false;
 }
 
-bool CSettings::Remove(String strSetting)
+bool CSettings::Remove(const String& strSetting)
 {
-	if(!Exists(strSetting))
+	std::map<String, SettingsValue *>::iterator iter = m_values.find(strSetting);
+
+	if(iter == m_values.end())
 		return false;
 
-	for(std::map<String, SettingsValue *>::iterator iter = m_values.begin(); iter != m_values.end(); iter++)
+	delete iter->second;
+	m_values.erase(iter);
+	m_uiGeneration++;
+
+	// Save the XML file later
+	SetDirty();
+	return true;
+}
+
+void CSettings::OnChanged(const String& strSetting, SettingsValue * setting)
+{
+	// Copy the handlers as a handler can add or remove handlers
+	std::vector<SettingsChangeHandler> changeHandlers = setting->changeHandlers;
+
+	for(std::vector<SettingsChangeHandler>::iterator iter = changeHandlers.begin(); iter != changeHandlers.end(); iter++)
+		(*iter).pfnHandler(strSetting, (*iter).pUserData);
+}
+
+bool CSettings::AddChangeHandler(const String& strSetting, SettingsChangeHandler_t pfnHandler, void * pUserData)
+{
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(!setting)
+		return false;
+
+	SettingsChangeHandler changeHandler;
+	changeHandler.pfnHandler = pfnHandler;
+	changeHandler.pUserData = pUserData;
+	setting->changeHandlers.push_back(changeHandler);
+	return true;
+}
+
+bool CSettings::RemoveChangeHandler(const String& strSetting, SettingsChangeHandler_t pfnHandler, void * pUserData)
+{
+	SettingsValue * setting = GetSetting(strSetting);
+
+	if(!setting)
+		return false;
+
+	for(std::vector<SettingsChangeHandler>::iterator iter = setting->changeHandlers.begin(); iter != setting->changeHandlers.end(); iter++)
 	{
-		if(iter->first == strSetting)
+		if((*iter).pfnHandler == pfnHandler && (*iter).pUserData == pUserData)
 		{
-			delete iter->second;
-			m_values.erase(iter);
-			break;
+			setting->changeHandlers.erase(iter);
+			return true;
 		}
 	}
 
-	// Save the XML file
-	Save();
-	return true;
+	return false;
 }
 
 void CSettings::ParseCommandLine(int argc, char ** argv)
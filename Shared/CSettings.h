@@ -12,8 +12,10 @@
 
 #include <map>
 #include <list>
+#include <vector>
 #include "Common.h"
 #include "CString.h"
+#include "Threading/CThread.h"
 #include <tinyxml/tinyxml.h>
 #include <tinyxml/ticpp.h>
 
@@ -33,6 +35,10 @@
 #define CVAR_GET_LIST CSettings::GetList
 #define CVAR_GET_EX CSettings::GetEx
 
+// Time in ms changed settings wait before they are saved so changes that come
+// together are written with a single save
+#define SETTINGS_SAVE_DELAY 1000
+
 enum eSettingsFlags
 {
 	SETTINGS_FLAG_BOOL = 1,
@@ -42,6 +48,15 @@ enum eSettingsFlags
 	SETTINGS_FLAG_LIST = 16
 };
 
+// Called after the value of a setting was set
+typedef void (* SettingsChangeHandler_t)(const String& strSetting, void * pUserData);
+
+struct SettingsChangeHandler
+{
+	SettingsChangeHandler_t pfnHandler;
+	void                  * pUserData;
+};
+
 struct SettingsValue
 {
 	// TODO: For this we could just do the following
@@ -51,16 +66,17 @@ struct SettingsValue
 	std::list<String> minimumValue;
 	std::list<String> maximumValue;
 	*/
-	char              cFlags;
-	bool              bValue;
-	int               iValue;
-	float             fValue;
-	String            strValue;
-	std::list<String> listValue;
-	int               iMinimumValue;
-	float             fMinimumValue;
-	int               iMaximimValue;
-	float             fMaximimValue;
+	char                               cFlags;
+	bool                               bValue;
+	int                                iValue;
+	float                              fValue;
+	String                             strValue;
+	std::list<String>                  listValue;
+	int                                iMinimumValue;
+	float                              fMinimumValue;
+	int                                iMaximimValue;
+	float                              fMaximimValue;
+	std::vector<SettingsChangeHandler> changeHandlers;
 
 	bool IsBool() { return IS_BIT_SET(cFlags, SETTINGS_FLAG_BOOL); }
 	bool IsInteger() { return IS_BIT_SET(cFlags, SETTINGS_FLAG_INTEGER); }
@@ -76,48 +92,121 @@ private:
 	static bool                              m_bOpen;
 	static bool                              m_bSave;
 	static TiXmlDocument                     m_XMLDocument;
+	static String                            m_strPath;
+	static unsigned int                      m_uiGeneration; // Changes whenever a setting is added or removed
+	static bool                              m_bDirty; // Changed since the last save
+	static unsigned long                     m_ulDirtyTime; // When the first unsaved change was made
+
+	// The file is written by a thread so the disk is never waited on
+	static CThread                           m_saveThread;
+	static CMutex                            m_saveMutex; // Mutex for the members up to m_bSavePending
+	static String                            m_strSaveData; // The printed document waiting to be written
+	static bool                              m_bSavePending;
 
 	static void                                LoadDefaults();
-	static SettingsValue                     * GetSetting(String strSetting);
+	static SettingsValue                     * GetSetting(const String& strSetting);
+	static void                                OnChanged(const String& strSetting, SettingsValue * setting);
+	static void                                SetDirty();
+	static void                                StartSaveThread();
+	static void                                SaveThread(CThread * pCreator);
+
+	friend class CSettingHandle;
 
 public:
 	CSettings();
 	~CSettings();
 
 	static std::map<String, SettingsValue *> * GetValues() { return &m_values; }
-	static bool                                Open(String strPath, bool bCreate = true, bool bSave = true);
+	static bool                                Open(const String& strPath, bool bCreate = true, bool bSave = true);
 	static bool                                Close();
-	static bool                                Save();
 
-	static bool                                AddBool(String strSetting, bool bDefaultValue);
-	static bool                                AddInteger(String strSetting, int iDefaultValue, int iMinimumValue, int iMaximumValue);
-	static bool                                AddFloat(String strSetting, float fDefaultValue, float fMinimumValue, float fMaximumValue);
-	static bool                                AddString(String strSetting, String strDefaultValue);
-	static bool                                AddList(String strSetting);
-
-	static bool                                SetBool(String strSetting, bool bValue);
-	static bool                                SetInteger(String strSetting, int iValue);
-	static bool                                SetFloat(String strSetting, float fValue);
-	static bool                                SetString(String strSetting, String strValue);
-	static bool                                AddToList(String strSetting, String strValue);
-	static bool                                SetEx(String strSetting, String strValue);
-
-	static bool                                GetBool(String strSetting);
-	static int                                 GetInteger(String strSetting);
-	static float                               GetFloat(String strSetting);
-	static String                              GetString(String strSetting);
-	static std::list<String>                   GetList(String strSetting);
-	static String                              GetEx(String strSetting);
-
-	static bool                                Exists(String strSetting);
-	static bool                                IsBool(String strSetting);
-	static bool                                IsInteger(String strSetting);
-	static bool                                IsFloat(String strSetting);
-	static bool                                IsString(String strSetting);
-	static bool                                IsList(String strSetting);
-
-	static bool                                Remove(String strSetting);
+	// Hands the settings to the save thread right away, changes are otherwise saved
+	// SETTINGS_SAVE_DELAY after they were made (or when the settings are closed)
+	static bool                                Save();
+	static void                                Process();
+
+	static bool                                AddBool(const String& strSetting, bool bDefaultValue);
+	static bool                                AddInteger(const String& strSetting, int iDefaultValue, int iMinimumValue, int iMaximumValue);
+	static bool                                AddFloat(const String& strSetting, float fDefaultValue, float fMinimumValue, float fMaximumValue);
+	static bool                                AddString(const String& strSetting, const String& strDefaultValue);
+	static bool                                AddList(const String& strSetting);
+
+	static bool                                SetBool(const String& strSetting, bool bValue);
+	static bool                                SetInteger(const String& strSetting, int iValue);
+	static bool                                SetFloat(const String& strSetting, float fValue);
+	static bool                                SetString(const String& strSetting, const String& strValue);
+	static bool                                AddToList(const String& strSetting, const String& strValue);
+	static bool                                SetEx(const String& strSetting, const String& strValue);
+
+	static bool                                GetBool(const String& strSetting);
+	static int                                 GetInteger(const String& strSetting);
+	static float                               GetFloat(const String& strSetting);
+	static String                              GetString(const String& strSetting);
+	static std::list<String>                   GetList(const String& strSetting);
+	static String                              GetEx(const String& strSetting);
+
+	static bool                                Exists(const String& strSetting);
+	static bool                                IsBool(const String& strSetting);
+	static bool                                IsInteger(const String& strSetting);
+	static bool                                IsFloat(const String& strSetting);
+	static bool                                IsString(const String& strSetting);
+	static bool                                IsList(const String& strSetting);
+
+	static bool                                Remove(const String& strSetting);
+
+	// The handlers are called whenever the setting is set (even to the value it has)
+	static bool                                AddChangeHandler(const String& strSetting, SettingsChangeHandler_t pfnHandler, void * pUserData = NULL);
+	static bool                                RemoveChangeHandler(const String& strSetting, SettingsChangeHandler_t pfnHandler, void * pUserData = NULL);
 
 	static void                                ParseCommandLine(int argc, char ** argv);
 	static void                                ParseCommandLine(char * szCommandLine);
 };
+
+// A setting that is only looked up again after settings were added or removed,
+// for the settings read in every tick or sync (then it is a static or global).
+// The values are aligned words so reading them while they are set never tears.
+class CSettingHandle
+{
+private:
+	const char    * m_szSetting;
+	SettingsValue * m_pValue;
+	unsigned int    m_uiGeneration;
+
+	SettingsValue * Get()
+	{
+		if(m_uiGeneration != CSettings::m_uiGeneration)
+		{
+			m_pValue = CSettings::GetSetting(m_szSetting);
+			m_uiGeneration = CSettings::m_uiGeneration;
+		}
+
+		return m_pValue;
+	}
+
+public:
+	CSettingHandle(const char * szSetting) : m_szSetting(szSetting), m_pValue(NULL), m_uiGeneration(0) { }
+
+	bool   GetBool()
+	{
+		SettingsValue * setting = Get();
+		return (setting && setting->IsBool() && setting->bValue);
+	}
+
+	int    GetInteger()
+	{
+		SettingsValue * setting = Get();
+		return ((setting && setting->IsInteger()) ? setting->iValue : 0);
+	}
+
+	float  GetFloat()
+	{
+		SettingsValue * setting = Get();
+		return ((setting && setting->IsFloat()) ? setting->fValue : 0.0f);
+	}
+
+	String GetString()
+	{
+		SettingsValue * setting = Get();
+		return ((setting && setting->IsString()) ? setting->strValue : String());
+	}
+};
@@ -34,7 +34,11 @@ String::String(const char * szFormat, ...)
 {
 	Init();
 
-	if(szFormat)
+	// Strings without format specifiers (most of those constructed from a
+	// literal to pass to a function) don't need to be formatted
+	if(szFormat && !strchr(szFormat, '%'))
+		Set(szFormat);
+	else if(szFormat)
 	{
 		char szString[BUFFER_SIZE];
 		va_list vaArgs;
@@ -61,7 +65,7 @@ String& String::operator = (const char * szString)
 	return *this;
 }
 
-String& String::operator = (const String strString)
+String& String::operator = (const String& strString)
 {
 	Set(strString.Get());
 	return *this;
@@ -82,7 +86,7 @@ String& String::operator += (const char * szString)
 	return *this;
 }
 
-String& String::operator += (const String strString)
+String& String::operator += (const String& strString)
 {
 	Append(strString.Get());
 	return *this;
@@ -101,7 +105,7 @@ String String::operator + (const char * szString) const
 	return strNewString;
 }
 
-String String::operator + (const String strString) const
+String String::operator + (const String& strString) const
 {
 	String strNewString(*this);
 	strNewString.Append(strString.Get());
@@ -125,7 +129,7 @@ bool String::operator == (const char * szString) const
 	return (Compare(szString) == 0);
 }
 
-bool String::operator == (const String strString) const
+bool String::operator == (const String& strString) const
 {
 	return (Compare(strString.Get()) == 0);
 }
@@ -135,7 +139,7 @@ bool String::operator != (const char * szString) const
 	return (Compare(szString) != 0);
 }
 
-bool String::operator != (const String strString) const
+bool String::operator != (const String& strString) const
 {
 	return (Compare(strString.Get()) != 0);
 }
@@ -145,7 +149,7 @@ bool String::operator > (const char * szString) const
 	return (Compare(szString) > 0);
 }
 
-bool String::operator > (const String strString) const
+bool String::operator > (const String& strString) const
 {
 	return (Compare(strString.Get()) > 0);
 }
@@ -155,7 +159,7 @@ bool String::operator >= (const char * szString) const
 	return (Compare(szString) >= 0);
 }
 
-bool String::operator >= (const String strString) const
+bool String::operator >= (const String& strString) const
 {
 	return (Compare(strString.Get()) >= 0);
 }
@@ -165,7 +169,7 @@ bool String::operator < (const char * szString) const
 	return (Compare(szString) < 0);
 }
 
-bool String::operator < (const String strString) const
+bool String::operator < (const String& strString) const
 {
 	return (Compare(strString.Get()) < 0);
 }
@@ -175,7 +179,7 @@ bool String::operator <= (const char * szString) const
 	return (Compare(szString) <= 0);
 }
 
-bool String::operator <= (const String strString) const
+bool String::operator <= (const String& strString) const
 {
 	return (Compare(strString.Get()) <= 0);
 }
@@ -228,7 +232,7 @@ void String::Set(const char * szString, unsigned int uiLength)
 	}
 }
 
-void String::Set(const String strString)
+void String::Set(const String& strString)
 {
 	// Set the string
 	m_strString.assign(strString.Get());
@@ -237,7 +241,7 @@ void String::Set(const String strString)
 	LimitTruncate();
 }
 
-void String::Set(const String strString, unsigned int uiLength)
+void String::Set(const String& strString, unsigned int uiLength)
 {
 	// Ensure the length is valid
 	if(uiLength > strString.GetLength())
@@ -338,7 +342,7 @@ int String::Compare(const char * szString) const
 	return strcmp(Get(), szString);
 }
 
-int String::Compare(const String strString) const
+int String::Compare(const String& strString) const
 {
 	return strcmp(Get(), strString.Get());
 }
@@ -348,7 +352,7 @@ int String::ICompare(const char * szString) const
 	return stricmp(Get(), szString);
 }
 
-int String::ICompare(const String strString) const
+int String::ICompare(const String& strString) const
 {
 	return stricmp(Get(), strString.Get());
 }
@@ -419,7 +423,7 @@ void String::Replace(size_t sOffset, const char * szString)
 	//m_strString.replace(sOffset, szString);
 }
 
-void String::Replace(size_t sOffset, String strString)
+void String::Replace(size_t sOffset, const String& strString)
 {
 	// TODO:
 	//m_strString.replace(sOffset, strString.Get());
@@ -457,7 +461,7 @@ void String::Append(const char * szString, unsigned int uiLength)
 	}
 }
 
-void String::Append(const String strString)
+void String::Append(const String& strString)
 {
 	// Copy the string to the end of our string
 	m_strString.append(strString.Get());
@@ -466,7 +470,7 @@ void String::Append(const String strString)
 	LimitTruncate();
 }
 
-void String::Append(const String strString, unsigned int uiLength)
+void String::Append(const String& strString, unsigned int uiLength)
 {
 	// Ensure the length is valid
 	if(uiLength > strString.GetLength())
@@ -530,7 +534,7 @@ size_t String::Find(const unsigned char ucChar, size_t sPos) const
 	return m_strString.find(ucChar, sPos);
 }
 
-size_t String::Find(const String strString, size_t sPos) const
+size_t String::Find(const String& strString, size_t sPos) const
 {
 	return m_strString.find(strString.Get(), sPos);
 }
@@ -545,7 +549,7 @@ bool String::Contains(const unsigned char ucChar, size_t sPos) const
 	return (Find(ucChar, sPos) != nPos);
 }
 
-bool String::Contains(const String strString, size_t sPos) const
+bool String::Contains(const String& strString, size_t sPos) const
 {
 	return (Find(strString.Get(), sPos) != nPos);
 }
@@ -560,12 +564,12 @@ size_t String::ReverseFind(const unsigned char ucChar, size_t sPos) const
 	return m_strString.rfind(ucChar, sPos);
 }
 
-size_t String::ReverseFind(const String strString, size_t sPos) const
+size_t String::ReverseFind(const String& strString, size_t sPos) const
 {
 	return m_strString.rfind(strString.Get(), sPos);
 }
 
-size_t String::Substitute(const char * szString, const String strSubstitute)
+size_t String::Substitute(const char * szString, const String& strSubstitute)
 {
 	// Reset the find position and the instance count
 	unsigned int uiFind = String::nPos;
@@ -588,7 +592,7 @@ size_t String::Substitute(const char * szString, const String strSubstitute)
 	return uiInstanceCount;
 }
 
-size_t String::Substitute(const unsigned char ucChar, const String strSubstitute)
+size_t String::Substitute(const unsigned char ucChar, const String& strSubstitute)
 {
 	// Construct the string to substitute
 	char szString[2];
@@ -598,7 +602,7 @@ size_t String::Substitute(const unsigned char ucChar, const String strSubstitute
 	return Substitute(szString, strSubstitute);
 }
 
-size_t String::Substitute(const String strString, const String strSubstitute)
+size_t String::Substitute(const String& strString, const String& strSubstitute)
 {
 	return Substitute(strString.C_String(), strSubstitute);
 }
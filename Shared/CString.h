@@ -32,17 +32,17 @@ public:
 
 	// Assignment operator
 	String& operator = (const char * szString);
-	String& operator = (const String strString);
+	String& operator = (const String& strString);
 	String& operator = (const unsigned char ucChar);
 
 	// Addition assignment operator
 	String& operator += (const char * szString);
-	String& operator += (const String strString);
+	String& operator += (const String& strString);
 	String& operator += (const unsigned char ucChar);
 
 	// Addition operator
 	String operator + (const char * szString) const;
-	String operator + (const String strString) const;
+	String operator + (const String& strString) const;
 	String operator + (const unsigned char ucChar) const;
 
 	// Array access operator
@@ -50,27 +50,27 @@ public:
 
 	// Comparison operator
 	bool operator == (const char * szString) const;
-	bool operator == (const String strString) const;
+	bool operator == (const String& strString) const;
 
 	// Not comparison operator
 	bool operator != (const char * szString) const;
-	bool operator != (const String strString) const;
+	bool operator != (const String& strString) const;
 
 	// More than operator
 	bool operator > (const char * szString) const;
-	bool operator > (const String strString) const;
+	bool operator > (const String& strString) const;
 
 	// More than or equal to operator
 	bool operator >= (const char * szString) const;
-	bool operator >= (const String strString) const;
+	bool operator >= (const String& strString) const;
 
 	// Less than operator
 	bool operator < (const char * szString) const;
-	bool operator < (const String strString) const;
+	bool operator < (const String& strString) const;
 
 	// Less than or equal to operator
 	bool operator <= (const char * szString) const;
-	bool operator <= (const String strString) const;
+	bool operator <= (const String& strString) const;
 
 	// Return the non editable string
 	const char *  Get() const;
@@ -79,8 +79,8 @@ public:
 	// Set the string
 	void          Set(const char * szString);
 	void          Set(const char * szString, unsigned int uiLength);
-	void          Set(const String strString);
-	void          Set(const String strString, unsigned int uiLength);
+	void          Set(const String& strString);
+	void          Set(const String& strString, unsigned int uiLength);
 
 	// Format the string
 	void          Format(const char * szFormat, ...);
@@ -125,13 +125,13 @@ public:
 
 	// Compare the string with sz/strString (case sensitive)
 	int           Compare(const char * szString) const;
-	int           Compare(const String strString) const;
+	int           Compare(const String& strString) const;
 	int           StrCmp(const char * szString) const { return Compare(szString); }
 	int           StrCmp(const String &strString) const { return Compare(strString); }
 
 	// Compare the string with sz/strString (case insensitive)
 	int           ICompare(const char * szString) const;
-	int           ICompare(const String strString) const;
+	int           ICompare(const String& strString) const;
 	int           StrICmp(const char * szString) const { return ICompare(szString); }
 	int           StrICmp(const String &strString) const { return ICompare(strString); }
 
@@ -165,13 +165,13 @@ public:
 
 	// Replace the string at sOffset with sz/strString
 	void          Replace(size_t sOffset, const char * szString);
-	void          Replace(size_t sOffset, String strString);
+	void          Replace(size_t sOffset, const String& strString);
 
 	// Append sz/strString to the string
 	void          Append(const char * szString);
 	void          Append(const char * szString, unsigned int uiLength);
-	void          Append(const String strString);
-	void          Append(const String strString, unsigned int uiLength);
+	void          Append(const String& strString);
+	void          Append(const String& strString, unsigned int uiLength);
 
 	// Append szFormat and variable arguments to the string
 	void          AppendF(const char * szFormat, ...);
@@ -186,25 +186,25 @@ public:
 	// if found return its index, if not return nPos
 	size_t        Find(const char * szString, size_t sPos = 0) const;
 	size_t        Find(const unsigned char ucChar, size_t sPos = 0) const;
-	size_t        Find(const String strString, size_t sPos = 0) const;
+	size_t        Find(const String& strString, size_t sPos = 0) const;
 
 	// Return true if the string contains sz/strString after sPos, 
 	// false if not
 	bool          Contains(const char * szString, size_t sPos = 0) const;
 	bool          Contains(const unsigned char ucChar, size_t sPos = 0) const;
-	bool          Contains(const String strString, size_t sPos = 0) const;
+	bool          Contains(const String& strString, size_t sPos = 0) const;
 
 	// Starting at the end, attempt to find sz/strString 
 	// in the string after sPos, if found return its index, if 
 	// not return nPos
 	size_t        ReverseFind(const char * szString, size_t sPos = nPos) const;
 	size_t        ReverseFind(const unsigned char ucChar, size_t sPos = nPos) const;
-	size_t        ReverseFind(const String strString, size_t sPos = nPos) const;
+	size_t        ReverseFind(const String& strString, size_t sPos = nPos) const;
 
 	// Replace all instances of strString with strSubstitute
-	size_t        Substitute(const char * szString, const String strSubstitute);
-	size_t        Substitute(const unsigned char ucChar, const String strSubstitute);
-	size_t        Substitute(const String strString, const String strSubstitute);
+	size_t        Substitute(const char * szString, const String& strSubstitute);
+	size_t        Substitute(const unsigned char ucChar, const String& strSubstitute);
+	size_t        Substitute(const String& strString, const String& strSubstitute);
 
 	// Return true if the string consists only of numbers, false if not
 	bool          IsNumeric() const;
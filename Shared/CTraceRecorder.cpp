@@ -0,0 +1,238 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTraceRecorder.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CTraceRecorder.h"
+#include "SharedUtility.h"
+#include "Threading/CAtomic.h"
+
+#ifdef _LINUX
+#include <pthread.h>
+#endif
+
+// The events of a single thread, only that thread writes to it
+struct TraceBuffer
+{
+	TraceEvent            events[TRACE_RECORDER_BUFFER_EVENTS];
+	volatile unsigned int uiWritten; // Events recorded since the last reset, the buffer wraps around
+};
+
+static const char * g_szTraceCategoryNames[TRACE_CATEGORY_MAX] =
+{
+	"tick",
+	"stage",
+	"network",
+	"rpc",
+	"event",
+	"timer",
+	"frame"
+};
+
+volatile bool CTraceRecorder::m_bEnabled = false;
+
+// Buffers are never freed so they can still be dumped after their thread is gone
+static TraceBuffer * g_pTraceBuffers[TRACE_RECORDER_MAX_THREADS];
+static volatile long g_lTraceBufferCount = 0;
+
+#ifdef WIN32
+static volatile long g_lTraceBufferSlot = (long)TLS_OUT_OF_INDEXES;
+#else
+static pthread_once_t g_traceBufferOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t  g_traceBufferKey;
+static bool           g_bTraceBufferKeyCreated = false;
+
+static void CreateTraceBufferKey()
+{
+	g_bTraceBufferKeyCreated = (pthread_key_create(&g_traceBufferKey, NULL) == 0);
+}
+#endif
+
+// Returns the buffer of the calling thread, NULL if it can't get one (its events are dropped then)
+static TraceBuffer * GetTraceBuffer()
+{
+	TraceBuffer * pBuffer = NULL;
+#ifdef WIN32
+	DWORD dwSlot = (DWORD)CAtomic::Get(&g_lTraceBufferSlot);
+
+	if(dwSlot == TLS_OUT_OF_INDEXES)
+	{
+		DWORD dwNewSlot = TlsAlloc();
+
+		if(dwNewSlot == TLS_OUT_OF_INDEXES)
+			return NULL;
+
+		// Another thread can allocate the slot at the same time, only one of them is kept
+		dwSlot = (DWORD)CAtomic::CompareExchange(&g_lTraceBufferSlot, (long)dwNewSlot, (long)TLS_OUT_OF_INDEXES);
+
+		if(dwSlot == TLS_OUT_OF_INDEXES)
+			dwSlot = dwNewSlot;
+		else
+			TlsFree(dwNewSlot);
+	}
+
+	pBuffer = (TraceBuffer *)TlsGetValue(dwSlot);
+#else
+	pthread_once(&g_traceBufferOnce, CreateTraceBufferKey);
+
+	if(!g_bTraceBufferKeyCreated)
+		return NULL;
+
+	pBuffer = (TraceBuffer *)pthread_getspecific(g_traceBufferKey);
+#endif
+
+	if(pBuffer)
+		return pBuffer;
+
+	if(CAtomic::Get(&g_lTraceBufferCount) >= TRACE_RECORDER_MAX_THREADS)
+		return NULL;
+
+	long lIndex = (CAtomic::Increment(&g_lTraceBufferCount) - 1);
+
+	if(lIndex >= TRACE_RECORDER_MAX_THREADS)
+		return NULL;
+
+	pBuffer = (TraceBuffer *)calloc(1, sizeof(TraceBuffer));
+
+	if(!pBuffer)
+		return NULL;
+
+	// The buffer is complete before the dump can see it
+	CAtomic::Barrier();
+	g_pTraceBuffers[lIndex] = pBuffer;
+#ifdef WIN32
+	TlsSetValue(dwSlot, pBuffer);
+#else
+	pthread_setspecific(g_traceBufferKey, pBuffer);
+#endif
+	return pBuffer;
+}
+
+void CTraceRecorder::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+}
+
+void CTraceRecorder::Reset()
+{
+	for(int i = 0; i < TRACE_RECORDER_MAX_THREADS; i++)
+	{
+		if(g_pTraceBuffers[i])
+			g_pTraceBuffers[i]->uiWritten = 0;
+	}
+}
+
+void CTraceRecorder::Record(eTraceCategory category, const char * szName, int iId, unsigned long long ullStartTime, unsigned long long ullEndTime)
+{
+	TraceBuffer * pBuffer = GetTraceBuffer();
+
+	if(!pBuffer)
+		return;
+
+	unsigned int uiWritten = pBuffer->uiWritten;
+	TraceEvent * pEvent = &pBuffer->events[uiWritten % TRACE_RECORDER_BUFFER_EVENTS];
+	pEvent->ullStartTime = ullStartTime;
+	pEvent->uiDuration = (unsigned int)(ullEndTime - ullStartTime);
+	pEvent->iId = iId;
+	pEvent->ucCategory = (unsigned char)category;
+	strncpy(pEvent->szName, (szName ? szName : "unknown"), (TRACE_EVENT_NAME_LENGTH - 1));
+	pEvent->szName[TRACE_EVENT_NAME_LENGTH - 1] = '\0';
+
+	// Count the event once it is written
+	CAtomic::Barrier();
+	pBuffer->uiWritten = (uiWritten + 1);
+}
+
+unsigned int CTraceRecorder::GetEventCount()
+{
+	unsigned int uiCount = 0;
+
+	for(int i = 0; i < TRACE_RECORDER_MAX_THREADS; i++)
+	{
+		if(!g_pTraceBuffers[i])
+			continue;
+
+		unsigned int uiWritten = g_pTraceBuffers[i]->uiWritten;
+		uiCount += ((uiWritten < TRACE_RECORDER_BUFFER_EVENTS) ? uiWritten : TRACE_RECORDER_BUFFER_EVENTS);
+	}
+
+	return uiCount;
+}
+
+bool CTraceRecorder::Dump(String strPath)
+{
+	FILE * pFile = fopen(strPath.Get(), "w");
+
+	if(!pFile)
+		return false;
+
+	// Complete events ("X") with the times in microseconds and a thread for each buffer
+	fprintf(pFile, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	bool bFirst = true;
+
+	for(int i = 0; i < TRACE_RECORDER_MAX_THREADS; i++)
+	{
+		TraceBuffer * pBuffer = g_pTraceBuffers[i];
+
+		if(!pBuffer)
+			continue;
+
+		unsigned int uiWritten = pBuffer->uiWritten;
+		unsigned int uiCount = ((uiWritten < TRACE_RECORDER_BUFFER_EVENTS) ? uiWritten : TRACE_RECORDER_BUFFER_EVENTS);
+
+		for(unsigned int j = (uiWritten - uiCount); j != uiWritten; j++)
+		{
+			TraceEvent * pEvent = &pBuffer->events[j % TRACE_RECORDER_BUFFER_EVENTS];
+
+			// Names come from scripts, keep them valid json
+			char szName[(TRACE_EVENT_NAME_LENGTH * 2) + 16];
+			unsigned int uiLength = 0;
+
+			for(const char * szChar = pEvent->szName; *szChar && uiLength < (TRACE_EVENT_NAME_LENGTH * 2); szChar++)
+			{
+				if(*szChar == '"' || *szChar == '\\')
+					szName[uiLength++] = '\\';
+				else if((unsigned char)*szChar < 0x20)
+					continue;
+
+				szName[uiLength++] = *szChar;
+			}
+
+			szName[uiLength] = '\0';
+
+			if(pEvent->iId != -1)
+				sprintf(szName + uiLength, " %d", pEvent->iId);
+
+			fprintf(pFile, "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %llu, \"dur\": %u, \"pid\": 1, \"tid\": %d}", (bFirst ? "" : ","),
+				szName, g_szTraceCategoryNames[(pEvent->ucCategory < TRACE_CATEGORY_MAX) ? pEvent->ucCategory : 0], pEvent->ullStartTime, pEvent->uiDuration, i);
+			bFirst = false;
+		}
+	}
+
+	fprintf(pFile, "\n]}\n");
+	fclose(pFile);
+	return true;
+}
+
+CTraceScope::CTraceScope(eTraceCategory category, const char * szName, int iId)
+	: m_category(category),
+	m_szName(szName),
+	m_iId(iId),
+	m_ullStartTime(0)
+{
+	if(CTraceRecorder::IsEnabled())
+		m_ullStartTime = SharedUtility::GetMicroseconds();
+}
+
+CTraceScope::~CTraceScope()
+{
+	if(m_ullStartTime != 0)
+		CTraceRecorder::Record(m_category, m_szName, m_iId, m_ullStartTime, SharedUtility::GetMicroseconds());
+}
@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CTraceRecorder.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <CString.h>
+
+// Maximum amount of threads that can record events
+#define TRACE_RECORDER_MAX_THREADS 32
+
+// Amount of events kept for each thread, older ones are overwritten
+#define TRACE_RECORDER_BUFFER_EVENTS 65536
+
+// Longer event names are cut off
+#define TRACE_EVENT_NAME_LENGTH 40
+
+enum eTraceCategory
+{
+	TRACE_CATEGORY_TICK,
+	TRACE_CATEGORY_STAGE,
+	TRACE_CATEGORY_NETWORK,
+	TRACE_CATEGORY_RPC,
+	TRACE_CATEGORY_EVENT,
+	TRACE_CATEGORY_TIMER,
+	TRACE_CATEGORY_FRAME,
+	TRACE_CATEGORY_MAX
+};
+
+// A finished scope, times are in microseconds
+struct TraceEvent
+{
+	unsigned long long ullStartTime;
+	unsigned int       uiDuration;
+	int                iId; // Shown after the name unless it is -1
+	unsigned char      ucCategory;
+	char               szName[TRACE_EVENT_NAME_LENGTH];
+};
+
+// Records scopes into a ring buffer of the thread they run on while it is
+// enabled and writes them as a chrome trace (chrome://tracing, perfetto) to
+// see what a slow tick or frame spent its time on. Nothing but a flag check
+// is done while it is disabled.
+class CTraceRecorder
+{
+private:
+	static volatile bool m_bEnabled;
+
+public:
+	static bool          IsEnabled() { return m_bEnabled; }
+	static void          SetEnabled(bool bEnabled);
+
+	// Drops the recorded events, only call it while no events are recorded
+	static void          Reset();
+	static void          Record(eTraceCategory category, const char * szName, int iId, unsigned long long ullStartTime, unsigned long long ullEndTime);
+	static unsigned int  GetEventCount();
+
+	// Events that are recorded while dumping can come out garbled, stop first
+	static bool          Dump(String strPath);
+};
+
+// Records the code from the construction to the destruction of the scope,
+// szName has to stay valid until then
+class CTraceScope
+{
+private:
+	eTraceCategory       m_category;
+	const char         * m_szName;
+	int                  m_iId;
+	unsigned long long   m_ullStartTime;
+
+public:
+	CTraceScope(eTraceCategory category, const char * szName, int iId = -1);
+	~CTraceScope();
+};
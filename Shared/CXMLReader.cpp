@@ -0,0 +1,243 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CXMLReader.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CXMLReader.h"
+
+CXMLReader::CXMLReader()
+	: m_parser(NULL),
+	m_pFile(NULL),
+	m_bEnd(true),
+	m_iErrorRow(0),
+	m_iErrorColumn(0),
+	m_uiDepth(0)
+{
+	m_node.type = XML_NODE_NONE;
+	m_node.uiDepth = 0;
+}
+
+CXMLReader::~CXMLReader()
+{
+	Close();
+}
+
+bool CXMLReader::Open(const String& strFileName)
+{
+	Close();
+	m_strError.Clear();
+	m_iErrorRow = 0;
+	m_iErrorColumn = 0;
+
+	if(!(m_pFile = fopen(strFileName.Get(), "rb")))
+	{
+		SetError("Failed to open the file");
+		return false;
+	}
+
+	m_parser = XML_ParserCreate(NULL);
+	XML_SetUserData(m_parser, this);
+	XML_SetElementHandler(m_parser, OnStartElement, OnEndElement);
+	XML_SetCharacterDataHandler(m_parser, OnCharacterData);
+	m_bEnd = false;
+	return true;
+}
+
+void CXMLReader::Close()
+{
+	if(m_parser)
+	{
+		XML_ParserFree(m_parser);
+		m_parser = NULL;
+	}
+
+	if(m_pFile)
+	{
+		fclose(m_pFile);
+		m_pFile = NULL;
+	}
+
+	m_bEnd = true;
+	m_uiDepth = 0;
+	m_strText.Clear();
+	m_elements.clear();
+	m_nodes.clear();
+	m_node.type = XML_NODE_NONE;
+	m_node.uiDepth = 0;
+	m_node.strName.Clear();
+	m_node.strText.Clear();
+	m_node.attributes.clear();
+}
+
+void XMLCALL CXMLReader::OnStartElement(void * pUserData, const XML_Char * szName, const XML_Char ** szAttributes)
+{
+	CXMLReader * pReader = (CXMLReader *)pUserData;
+	pReader->AddText();
+	pReader->m_nodes.push_back(XMLReaderNode());
+	XMLReaderNode& node = pReader->m_nodes.back();
+	node.type = XML_NODE_ELEMENT;
+	node.uiDepth = pReader->m_uiDepth++;
+	node.strName.Set(szName);
+
+	// The attributes are name and value pairs, terminated by NULL
+	for(int i = 0; szAttributes[i]; i += 2)
+	{
+		node.attributes.push_back(std::pair<String, String>());
+		node.attributes.back().first.Set(szAttributes[i]);
+		node.attributes.back().second.Set(szAttributes[i + 1]);
+	}
+
+	pReader->m_elements.push_back(node.strName);
+}
+
+void XMLCALL CXMLReader::OnEndElement(void * pUserData, const XML_Char * szName)
+{
+	CXMLReader * pReader = (CXMLReader *)pUserData;
+	pReader->AddText();
+	pReader->m_nodes.push_back(XMLReaderNode());
+	XMLReaderNode& node = pReader->m_nodes.back();
+	node.type = XML_NODE_END_ELEMENT;
+	node.uiDepth = --pReader->m_uiDepth;
+	node.strName.Set(szName);
+	pReader->m_elements.pop_back();
+}
+
+void XMLCALL CXMLReader::OnCharacterData(void * pUserData, const XML_Char * szData, int iLength)
+{
+	CXMLReader * pReader = (CXMLReader *)pUserData;
+
+	// Text outside of the root element isn't a node
+	if(!pReader->m_elements.empty())
+		pReader->m_strText.Append(szData, (unsigned int)iLength);
+}
+
+void CXMLReader::AddText()
+{
+	if(m_strText.IsEmpty())
+		return;
+
+	// Skip the whitespace between the tags
+	bool bWhitespace = true;
+
+	for(unsigned int i = 0; i < m_strText.GetLength() && bWhitespace; i++)
+	{
+		char c = m_strText.GetChar(i);
+		bWhitespace = (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+	}
+
+	if(!bWhitespace)
+	{
+		m_nodes.push_back(XMLReaderNode());
+		XMLReaderNode& node = m_nodes.back();
+		node.type = XML_NODE_TEXT;
+		node.uiDepth = m_uiDepth;
+		node.strName = m_elements.back();
+		node.strText = m_strText;
+	}
+
+	m_strText.Clear();
+}
+
+bool CXMLReader::ParseBlock()
+{
+	if(m_bEnd)
+		return false;
+
+	void * pBuffer = XML_GetBuffer(m_parser, XML_READER_BUFFER_SIZE);
+
+	if(!pBuffer)
+	{
+		SetError("Out of memory");
+		return false;
+	}
+
+	size_t sRead = fread(pBuffer, 1, XML_READER_BUFFER_SIZE, m_pFile);
+	m_bEnd = (sRead < XML_READER_BUFFER_SIZE);
+
+	if(XML_ParseBuffer(m_parser, (int)sRead, m_bEnd) == XML_STATUS_ERROR)
+	{
+		SetError(XML_ErrorString(XML_GetErrorCode(m_parser)));
+		return false;
+	}
+
+	return true;
+}
+
+void CXMLReader::SetError(const char * szError)
+{
+	m_strError.Set(szError);
+
+	if(m_parser)
+	{
+		m_iErrorRow = (int)XML_GetCurrentLineNumber(m_parser);
+		m_iErrorColumn = (int)XML_GetCurrentColumnNumber(m_parser);
+	}
+
+	m_bEnd = true;
+}
+
+bool CXMLReader::Read()
+{
+	// A block can end without a complete node so parse until there is one
+	while(m_nodes.empty())
+	{
+		if(!ParseBlock())
+		{
+			m_node.type = XML_NODE_NONE;
+			m_node.uiDepth = 0;
+			m_node.strName.Clear();
+			m_node.strText.Clear();
+			m_node.attributes.clear();
+			return false;
+		}
+	}
+
+	m_node = m_nodes.front();
+	m_nodes.pop_front();
+	return true;
+}
+
+bool CXMLReader::Skip()
+{
+	if(m_node.type != XML_NODE_ELEMENT)
+		return Read();
+
+	unsigned int uiDepth = m_node.uiDepth;
+
+	while(Read())
+	{
+		if(m_node.type == XML_NODE_END_ELEMENT && m_node.uiDepth == uiDepth)
+			return Read();
+	}
+
+	return false;
+}
+
+const char * CXMLReader::GetAttribute(const char * szName)
+{
+	for(std::vector<std::pair<String, String> >::iterator iter = m_node.attributes.begin(); iter != m_node.attributes.end(); ++iter)
+	{
+		if((*iter).first == szName)
+			return (*iter).second.Get();
+	}
+
+	return NULL;
+}
+
+const char * CXMLReader::GetLastError(int * iRow, int * iColumn)
+{
+	if(m_strError.IsEmpty())
+		return NULL;
+
+	if(iRow)
+		*iRow = m_iErrorRow;
+
+	if(iColumn)
+		*iColumn = m_iErrorColumn;
+
+	return m_strError.Get();
+}
@@ -0,0 +1,93 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CXMLReader.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+#include "CString.h"
+
+#define XML_STATIC
+#include <expat-2.0.1/expat.h>
+
+// Bytes of the file given to the parser at once
+#define XML_READER_BUFFER_SIZE 16384
+
+enum eXMLNodeType
+{
+	XML_NODE_NONE,
+	XML_NODE_ELEMENT,     // Start tag, with the attributes
+	XML_NODE_END_ELEMENT, // End tag, also read for empty elements
+	XML_NODE_TEXT         // Text between the tags that isn't only whitespace
+};
+
+struct XMLReaderNode
+{
+	eXMLNodeType                             type;
+	unsigned int                             uiDepth;
+	String                                   strName; // Of the element for text nodes
+	String                                   strText;
+	std::vector<std::pair<String, String> >  attributes;
+};
+
+// Reads an xml file one node at a time with expat. The file is parsed in blocks
+// of XML_READER_BUFFER_SIZE and only the nodes of the current block are kept, so
+// files of any size are read in a single pass with the same memory.
+class CXMLReader
+{
+private:
+	XML_Parser                m_parser;
+	FILE                    * m_pFile;
+	bool                      m_bEnd;
+	String                    m_strError;
+	int                       m_iErrorRow;
+	int                       m_iErrorColumn;
+	unsigned int              m_uiDepth;
+	String                    m_strText;    // Text of the open element since the last tag
+	std::vector<String>       m_elements;   // Names of the open elements
+	std::deque<XMLReaderNode> m_nodes;      // Parsed but not read yet
+	XMLReaderNode             m_node;
+
+	static void XMLCALL       OnStartElement(void * pUserData, const XML_Char * szName, const XML_Char ** szAttributes);
+	static void XMLCALL       OnEndElement(void * pUserData, const XML_Char * szName);
+	static void XMLCALL       OnCharacterData(void * pUserData, const XML_Char * szData, int iLength);
+
+	void                      AddText();
+	bool                      ParseBlock();
+	void                      SetError(const char * szError);
+
+public:
+	CXMLReader();
+	~CXMLReader();
+
+	bool                      Open(const String& strFileName);
+	void                      Close();
+	bool                      IsOpen() { return (m_pFile != NULL); }
+
+	// Moves to the next node, returns false at the end of the file or on an error
+	bool                      Read();
+
+	// Skips the children of the current element, the next node read is the node after its end tag
+	bool                      Skip();
+
+	eXMLNodeType              GetNodeType() { return m_node.type; }
+	unsigned int              GetDepth() { return m_node.uiDepth; }
+	const String&             GetName() { return m_node.strName; }
+	const String&             GetText() { return m_node.strText; }
+	unsigned int              GetAttributeCount() { return m_node.attributes.size(); }
+	const String&             GetAttributeName(unsigned int uiIndex) { return m_node.attributes[uiIndex].first; }
+	const String&             GetAttributeValue(unsigned int uiIndex) { return m_node.attributes[uiIndex].second; }
+
+	// Returns NULL if the current element doesn't have the attribute
+	const char              * GetAttribute(const char * szName);
+
+	// Returns NULL if there was no error
+	const char              * GetLastError(int * iRow, int * iColumn);
+};
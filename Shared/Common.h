@@ -43,25 +43,34 @@
 #endif
 
 // Network module version
-#define NETWORK_MODULE_VERSION 0x08
+#define NETWORK_MODULE_VERSION 0x0B
 
 // Network version - increment this when packet layouts change!
-#define NETWORK_VERSION 0x8A
+#define NETWORK_VERSION 0x9E
 
 // Tick Rate
 #define TICK_RATE 100
 
+// Interval in ms at which the server re-evaluates each clients pure sync rate
+#define SYNC_RATE_UPDATE_INTERVAL 500
+
+// Move speed above which players are synced at the fast rate
+#define SYNC_RATE_FAST_SPEED 15.0f
+
+// Move speed below which players are considered idle
+#define SYNC_RATE_IDLE_SPEED 0.1f
+
 // Defines used for the max amount of entities we (IV:MP, not GTA) can handle
 // jenksta: although they may be streamed, shouldn't they at least have some sensible limit?
 // NOTE: (if client-side entitys are introduced, those should not use ids from the same range as server ids)
-#define MAX_PLAYERS 48/*128*/ // Player Info Array Size: 64 // Ped Pool Size: 64
+#define MAX_PLAYERS 128 // Upper bound of the player ids. Player Info Array Size: 32 (clients only create that many players at once) // Ped Pool Size: 64
 #define MAX_VEHICLES 0xFFFE // Streamed. See note on Pickups. Vehicle Pool Size: 140
 #define MAX_OBJECTS 0xFFFE // Streamed. See note on Pickups. Object Pool Size: 1300
 #define MAX_CHECKPOINTS 0xFFFE // Streamed. Checkpoint Pool Size: See CStreamer.h
 #define MAX_BLIPS 1300 // Blip Pool Size: 1500
 #define MAX_PICKUPS 0xFFFE // Streamed. Pickup Pool Size: TODO: 1500?
 #define MAX_FIRE 32
-#define MAX_ACTORS 12/*252*/ 
+#define MAX_ACTORS 1000 // Streamed. The server moves actors on paths so no client has to control them. Ped Pool Size: 64
 
 // TODO: RC2: Players: 128, Actors, 252
 
@@ -225,12 +234,9 @@ struct InVehicleSyncData
 	bool hHazardLights : 1;				   // hazardlights status
 	float fPetrolHealth;				   // vehicle petrol tank health
 	float fDirtLevel;					   // vehicle dirt
-	float fDoor[6];						   // vehicle doors(open angle)
 	bool bLights;						   // vehicle lights
 	bool bTaxiLights : 1;				   // vehicle taxilight
 	bool bSirenState : 1;				   // vehicle siren state
-	bool bWindow[4];					   // vehicle window
-	bool bTyre[6];						   // vehicle tyres
 	bool bGpsState : 1;				       // gps state
 	float fQuaternion[4];					// vehicle quaternion
 	unsigned int uPlayerHealthArmour : 32; // player health and armour (first 16bit Health last 16bit Armour)
@@ -261,6 +267,9 @@ struct ActorSyncData
 	bool		bDriving;	// driving(yes/no)
 };
 
+// Most empty vehicle syncs sent in a single packet
+#define EMPTY_VEHICLE_SYNC_BATCH_SIZE 10
+
 struct EMPTYVEHICLESYNCPACKET
 {
 	EntityId vehicleId;			// vehicleId
@@ -271,13 +280,27 @@ struct EMPTYVEHICLESYNCPACKET
 	unsigned int uiHealth;		// vehicle health
 	float fPetrolHealth;		// vehicle petrol health
 	float fDirtLevel;			// vehicle dirt
-	float fDoor[6];				// vehicle door(open angle)
 	bool bLights;				// vehicle lights
 	bool bTaxiLights : 1;		// vehicle taxilight
 	bool bSirenState : 1;		// vehicle siren state
-	bool bWindow[4];			// vehicle window
 	bool bEngineStatus : 1;		// vehicle engine
-	bool bTyre[6];				// vehicle tyre
+};
+
+// Points on the hull of a vehicle its deformation is sampled at (front, rear, left, right and roof)
+#define VEHICLE_DAMAGE_POINTS 5
+
+// Deformation in m per step of VehicleDamageSyncData::cDeformation
+#define VEHICLE_DAMAGE_DEFORMATION_STEP 0.01f
+
+// The damage of a vehicle, it is sent apart from the vehicle sync and only when it changed.
+// It is kept quantized so it can be compared with memcmp.
+struct VehicleDamageSyncData
+{
+	unsigned char ucWindows;                            // bit per broken window
+	unsigned char ucTyres;                              // bit per burst tyre
+	unsigned char ucDamagedDoors;                       // bit per damaged door
+	unsigned char ucDoors[6];                           // door open ratios (0 - 255)
+	signed char cDeformation[VEHICLE_DAMAGE_POINTS][3]; // deformation at the hull points (in deformation steps)
 };
 
 struct AimSyncData
@@ -288,6 +311,18 @@ struct AimSyncData
 	CVector3 vecLookAt;			// look at position
 };
 
+// Distance from the shot target within which a shot hits a player
+#define SHOT_HIT_RADIUS 1.5f
+
+// Fields of a checkpoint that RPC_UpdateCheckpoint can carry
+enum eCheckpointField
+{
+	CHECKPOINT_FIELD_TYPE            = 1,
+	CHECKPOINT_FIELD_POSITION        = 2,
+	CHECKPOINT_FIELD_TARGET_POSITION = 4,
+	CHECKPOINT_FIELD_RADIUS          = 8
+};
+
 // Refuse Reasons
 enum eRefuseReason
 {
@@ -295,7 +330,11 @@ enum eRefuseReason
 	REFUSE_REASON_NAME_IN_USE,
 	REFUSE_REASON_NAME_INVALID,
 	REFUSE_REASON_ABORTED_BY_SCRIPT,
-	REFUSE_REASON_FILES_MODIFIED
+	REFUSE_REASON_FILES_MODIFIED,
+	REFUSE_REASON_BANNED,
+	REFUSE_REASON_TRANSFER_INVALID,
+	REFUSE_REASON_RELAY_INVALID,
+	REFUSE_REASON_RELAY_UNAVAILABLE
 };
 
 // State types
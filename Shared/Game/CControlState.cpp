@@ -37,6 +37,37 @@ bool CControlState::operator!= (const CControlState& o) const
 	return (memcmp(this, &o, sizeof(CControlState)) != 0);
 }
 
+unsigned char CControlState::GetInputActions() const
+{
+	unsigned char ucInputActions = 0;
+
+	if(keys.bEnterExitVehicle)
+		ucInputActions |= INPUT_ACTION_ENTER_EXIT_VEHICLE;
+
+	if(keys.bJump)
+		ucInputActions |= INPUT_ACTION_JUMP;
+
+	if(keys.bAttack)
+		ucInputActions |= INPUT_ACTION_ATTACK;
+
+	if(keys.bHorn)
+		ucInputActions |= INPUT_ACTION_HORN;
+
+	if(keys.bHeliPrimaryFire)
+		ucInputActions |= INPUT_ACTION_HELI_PRIMARY_FIRE;
+
+	return ucInputActions;
+}
+
+void CControlState::SetInputActions(unsigned char ucInputActions)
+{
+	keys.bEnterExitVehicle = ((ucInputActions & INPUT_ACTION_ENTER_EXIT_VEHICLE) != 0);
+	keys.bJump = ((ucInputActions & INPUT_ACTION_JUMP) != 0);
+	keys.bAttack = ((ucInputActions & INPUT_ACTION_ATTACK) != 0);
+	keys.bHorn = ((ucInputActions & INPUT_ACTION_HORN) != 0);
+	keys.bHeliPrimaryFire = ((ucInputActions & INPUT_ACTION_HELI_PRIMARY_FIRE) != 0);
+}
+
 void CControlState::Serialize(CBitStream * pBitStream) const
 {
 	pBitStream->Write((char *)ucOnFootMove, sizeof(ucOnFootMove));
@@ -11,6 +11,18 @@
 
 class CBitStream;
 
+// The discrete actions of the binary keys, they are sent on their own as soon
+// as they change (see RPC_InputAction) instead of waiting for the next sync
+enum eInputAction
+{
+	INPUT_ACTION_ENTER_EXIT_VEHICLE = 0x01,
+	INPUT_ACTION_JUMP               = 0x02,
+	INPUT_ACTION_ATTACK             = 0x04,
+	INPUT_ACTION_HORN               = 0x08,
+	INPUT_ACTION_HELI_PRIMARY_FIRE  = 0x10,
+	INPUT_ACTION_ALL                = 0x1F
+};
+
 class CControlState
 {
 public:
@@ -67,6 +79,8 @@ public:
 	bool IsJumping() const { return (keys.bJump); }
 	bool IsUsingHandbrake() { return (keys.bHandbrake || keys.bHandbrake2); }
 	bool IsUsingEnterExitVehicle() { return (keys.bEnterExitVehicle); }
+	unsigned char GetInputActions() const;
+	void SetInputActions(unsigned char ucInputActions);
 	void Serialize(CBitStream * pBitStream) const;
 	bool Deserialize(CBitStream * pBitStream);
 };
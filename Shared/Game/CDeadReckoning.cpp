@@ -0,0 +1,61 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CDeadReckoning.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CDeadReckoning.h"
+
+void CDeadReckoning::SetState(DeadReckoningState * pState, unsigned long ulTime, const CVector3& vecPosition, const CVector3& vecRotation, const CVector3& vecMoveSpeed, const CVector3& vecTurnSpeed)
+{
+	// 0 means there is no state
+	pState->ulTime = (ulTime != 0 ? ulTime : 1);
+	pState->vecPosition = vecPosition;
+	pState->vecRotation = vecRotation;
+	pState->vecMoveSpeed = vecMoveSpeed;
+	pState->vecTurnSpeed = vecTurnSpeed;
+}
+
+bool CDeadReckoning::Extrapolate(const DeadReckoningState * pState, unsigned long ulTime, CVector3& vecPosition, CVector3& vecRotation)
+{
+	if(pState->ulTime == 0)
+		return false;
+
+	long lTime = (long)(ulTime - pState->ulTime);
+
+	if(lTime < 0)
+		lTime = 0;
+	else if(lTime > DEAD_RECKONING_MAX_TIME)
+		lTime = DEAD_RECKONING_MAX_TIME;
+
+	// Amount of game frames since the state
+	float fFrames = (((float)lTime / 1000.0f) * DEAD_RECKONING_SPEED_RATE);
+	vecPosition = (pState->vecPosition + (pState->vecMoveSpeed * fFrames));
+
+	// The turn speed is in radians, the rotation in degrees
+	vecRotation = (pState->vecRotation + (pState->vecTurnSpeed * (fFrames * DEGS_PER_RAD)));
+	vecRotation.fX = Math::WrapAround(vecRotation.fX, 360.0f);
+	vecRotation.fY = Math::WrapAround(vecRotation.fY, 360.0f);
+	vecRotation.fZ = Math::WrapAround(vecRotation.fZ, 360.0f);
+	return true;
+}
+
+bool CDeadReckoning::IsUpdateNeeded(const DeadReckoningState * pState, unsigned long ulTime, const CVector3& vecPosition, const CVector3& vecRotation)
+{
+	if(pState->ulTime == 0 || (ulTime - pState->ulTime) >= DEAD_RECKONING_HEARTBEAT)
+		return true;
+
+	CVector3 vecExtrapolatedPosition;
+	CVector3 vecExtrapolatedRotation;
+	Extrapolate(pState, ulTime, vecExtrapolatedPosition, vecExtrapolatedRotation);
+
+	if((vecPosition - vecExtrapolatedPosition).LengthSquared() > (DEAD_RECKONING_POSITION_ERROR * DEAD_RECKONING_POSITION_ERROR))
+		return true;
+
+	CVector3 vecRotationError = Math::GetOffsetDegrees(vecExtrapolatedRotation, vecRotation);
+	return (fabs(vecRotationError.fX) > DEAD_RECKONING_ROTATION_ERROR || fabs(vecRotationError.fY) > DEAD_RECKONING_ROTATION_ERROR ||
+		fabs(vecRotationError.fZ) > DEAD_RECKONING_ROTATION_ERROR);
+}
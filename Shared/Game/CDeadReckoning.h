@@ -0,0 +1,53 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CDeadReckoning.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <Math/CMath.h>
+
+// The move and turn speeds of the game are per frame at this frame rate
+#define DEAD_RECKONING_SPEED_RATE 50.0f
+
+// Distance the extrapolated position may be off the real one before a new sync is sent
+#define DEAD_RECKONING_POSITION_ERROR 0.5f
+
+// Degrees the extrapolated rotation may be off the real one before a new sync is sent
+#define DEAD_RECKONING_ROTATION_ERROR 5.0f
+
+// Time in ms after which a sync is sent even if the extrapolation is still right
+#define DEAD_RECKONING_HEARTBEAT 1000
+
+// Time in ms a state is extrapolated for at most
+#define DEAD_RECKONING_MAX_TIME 1500
+
+// The last synced movement of a vehicle
+struct DeadReckoningState
+{
+	unsigned long ulTime; // 0 if there is no state
+	CVector3      vecPosition;
+	CVector3      vecRotation;
+	CVector3      vecMoveSpeed;
+	CVector3      vecTurnSpeed;
+};
+
+// Extrapolates the movement of vehicles, the syncing client and everyone who
+// receives the sync extrapolate the same way so syncs are only needed once the
+// extrapolation is too far off
+class CDeadReckoning
+{
+public:
+	static void Reset(DeadReckoningState * pState) { pState->ulTime = 0; }
+	static void SetState(DeadReckoningState * pState, unsigned long ulTime, const CVector3& vecPosition, const CVector3& vecRotation, const CVector3& vecMoveSpeed, const CVector3& vecTurnSpeed);
+
+	// Returns false if there is no state to extrapolate from
+	static bool Extrapolate(const DeadReckoningState * pState, unsigned long ulTime, CVector3& vecPosition, CVector3& vecRotation);
+
+	// Returns true if the extrapolated state is too far off the real one or the heartbeat is due
+	static bool IsUpdateNeeded(const DeadReckoningState * pState, unsigned long ulTime, const CVector3& vecPosition, const CVector3& vecRotation);
+};
@@ -0,0 +1,143 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMoveTimeline.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CMoveTimeline.h"
+
+float CMoveTimeline::Ease(float fAlpha, unsigned char ucEasing)
+{
+	switch(ucEasing)
+	{
+	case MOVE_EASING_IN:
+		return (fAlpha * fAlpha);
+	case MOVE_EASING_OUT:
+		return (fAlpha * (2.0f - fAlpha));
+	case MOVE_EASING_IN_OUT:
+		return (fAlpha * fAlpha * (3.0f - (2.0f * fAlpha)));
+	}
+
+	return fAlpha;
+}
+
+bool CMoveTimeline::AddKeyframe(unsigned int uiTime, const CVector3& vecPosition, const CVector3& vecRotation, eMoveEasing easing)
+{
+	if(m_keyframes.size() >= MOVE_TIMELINE_MAX_KEYFRAMES || (!m_keyframes.empty() && uiTime < m_keyframes.back().uiTime))
+		return false;
+
+	MoveKeyframe keyframe;
+	keyframe.uiTime = uiTime;
+	keyframe.vecPosition = vecPosition;
+	keyframe.vecRotation = vecRotation;
+	keyframe.ucEasing = (unsigned char)(easing < MOVE_EASING_MAX ? easing : MOVE_EASING_LINEAR);
+	m_keyframes.push_back(keyframe);
+	return true;
+}
+
+bool CMoveTimeline::IsFinished(unsigned long ulTime) const
+{
+	if(m_keyframes.empty())
+		return true;
+
+	if(m_bLoop && GetDuration() > 0)
+		return false;
+
+	long lTime = (long)(ulTime - m_ulStartTime);
+	return (lTime >= (long)GetDuration());
+}
+
+bool CMoveTimeline::Evaluate(unsigned long ulTime, CVector3& vecPosition, CVector3& vecRotation) const
+{
+	if(m_keyframes.empty())
+		return false;
+
+	long lTime = (long)(ulTime - m_ulStartTime);
+	unsigned int uiDuration = GetDuration();
+
+	if(lTime < 0)
+		lTime = 0;
+
+	unsigned int uiTime = (unsigned int)lTime;
+
+	if(uiTime >= uiDuration)
+	{
+		if(!m_bLoop || uiDuration == 0)
+		{
+			vecPosition = m_keyframes.back().vecPosition;
+			vecRotation = m_keyframes.back().vecRotation;
+			return true;
+		}
+
+		uiTime %= uiDuration;
+	}
+
+	// Find the keyframe we are moving to
+	unsigned int i = 0;
+
+	while(i < m_keyframes.size() && m_keyframes[i].uiTime <= uiTime)
+		i++;
+
+	if(i == 0)
+	{
+		vecPosition = m_keyframes[0].vecPosition;
+		vecRotation = m_keyframes[0].vecRotation;
+		return true;
+	}
+
+	const MoveKeyframe& from = m_keyframes[i - 1];
+	const MoveKeyframe& to = m_keyframes[i];
+	float fAlpha = Ease(((float)(uiTime - from.uiTime) / (float)(to.uiTime - from.uiTime)), to.ucEasing);
+	vecPosition = Math::Lerp(from.vecPosition, fAlpha, to.vecPosition);
+	vecRotation = Math::Lerp(from.vecRotation, fAlpha, to.vecRotation);
+	return true;
+}
+
+void CMoveTimeline::Serialize(CBitStream * pBitStream, unsigned long ulTime) const
+{
+	long lElapsed = (long)(ulTime - m_ulStartTime);
+	pBitStream->WriteCompressed((unsigned int)(lElapsed > 0 ? lElapsed : 0));
+	pBitStream->Write(m_bLoop);
+	pBitStream->WriteCompressed((unsigned char)m_keyframes.size());
+
+	for(std::vector<MoveKeyframe>::const_iterator iter = m_keyframes.begin(); iter != m_keyframes.end(); ++iter)
+	{
+		pBitStream->WriteCompressed((*iter).uiTime);
+		pBitStream->Write((*iter).vecPosition);
+		pBitStream->Write((*iter).vecRotation);
+		pBitStream->Write((*iter).ucEasing);
+	}
+}
+
+bool CMoveTimeline::Deserialize(CBitStream * pBitStream, unsigned long ulTime)
+{
+	unsigned int uiElapsed;
+	unsigned char ucCount;
+	m_keyframes.clear();
+
+	if(!pBitStream->ReadCompressed(uiElapsed) || !pBitStream->Read(m_bLoop) || !pBitStream->ReadCompressed(ucCount) ||
+		ucCount > MOVE_TIMELINE_MAX_KEYFRAMES)
+		return false;
+
+	m_ulStartTime = (ulTime - uiElapsed);
+
+	for(unsigned char i = 0; i < ucCount; i++)
+	{
+		unsigned int uiTime;
+		CVector3 vecPosition;
+		CVector3 vecRotation;
+		unsigned char ucEasing;
+
+		if(!pBitStream->ReadCompressed(uiTime) || !pBitStream->Read(vecPosition) || !pBitStream->Read(vecRotation) ||
+			!pBitStream->Read(ucEasing) || !AddKeyframe(uiTime, vecPosition, vecRotation, (eMoveEasing)ucEasing))
+		{
+			m_keyframes.clear();
+			return false;
+		}
+	}
+
+	return true;
+}
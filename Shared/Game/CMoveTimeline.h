@@ -0,0 +1,75 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CMoveTimeline.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include <Math/CMath.h>
+#include <Network/CBitStream.h>
+
+// Amount of keyframes a timeline can have at most
+#define MOVE_TIMELINE_MAX_KEYFRAMES 64
+
+// How a timeline moves from one keyframe to the next
+enum eMoveEasing
+{
+	MOVE_EASING_LINEAR,
+	MOVE_EASING_IN,     // Starts slow
+	MOVE_EASING_OUT,    // Ends slow
+	MOVE_EASING_IN_OUT, // Starts and ends slow
+	MOVE_EASING_MAX
+};
+
+struct MoveKeyframe
+{
+	unsigned int  uiTime; // Time in ms since the start of the timeline
+	CVector3      vecPosition;
+	CVector3      vecRotation;
+	unsigned char ucEasing; // Easing used to move from the previous keyframe to this one
+};
+
+// A path of keyframes an entity moves along from a start time on. The server and the
+// clients evaluate the same timeline so a movement only has to be sent once.
+class CMoveTimeline
+{
+private:
+	std::vector<MoveKeyframe> m_keyframes;
+	unsigned long             m_ulStartTime;
+	bool                      m_bLoop;
+
+	static float Ease(float fAlpha, unsigned char ucEasing);
+
+public:
+	CMoveTimeline() : m_ulStartTime(0), m_bLoop(false) {}
+
+	void          Clear() { m_keyframes.clear(); }
+	bool          IsEmpty() const { return m_keyframes.empty(); }
+	unsigned int  GetKeyframeCount() const { return (unsigned int)m_keyframes.size(); }
+
+	// Keyframes must be added in order of their time, returns false if the
+	// keyframe is before the last one or the timeline is full
+	bool          AddKeyframe(unsigned int uiTime, const CVector3& vecPosition, const CVector3& vecRotation, eMoveEasing easing = MOVE_EASING_LINEAR);
+
+	void          SetStartTime(unsigned long ulStartTime) { m_ulStartTime = ulStartTime; }
+	unsigned long GetStartTime() const { return m_ulStartTime; }
+	void          SetLoop(bool bLoop) { m_bLoop = bLoop; }
+	bool          IsLooped() const { return m_bLoop; }
+	unsigned int  GetDuration() const { return (m_keyframes.empty() ? 0 : m_keyframes.back().uiTime); }
+
+	// Returns true once a timeline that doesn't loop has reached its last keyframe
+	bool          IsFinished(unsigned long ulTime) const;
+
+	// Gets the position and rotation at the time, returns false if the timeline is empty
+	bool          Evaluate(unsigned long ulTime, CVector3& vecPosition, CVector3& vecRotation) const;
+
+	// The start time is sent as the time that passed since it so the
+	// timeline is at the same point on the time line of the receiver
+	void          Serialize(CBitStream * pBitStream, unsigned long ulTime) const;
+	bool          Deserialize(CBitStream * pBitStream, unsigned long ulTime);
+};
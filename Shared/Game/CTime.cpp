@@ -23,6 +23,9 @@ CTime::CTime()
 	m_ucMinute(0),
 	m_ucDayOfWeek(0),
 	m_uiMinuteDuration(DEFAULT_MINUTE_DURATION)
+#ifdef _SERVER
+	, m_bSyncPending(false)
+#endif
 {
 }
 
@@ -30,19 +33,31 @@ CTime::~CTime()
 {
 }
 
-void CTime::SetTime(const unsigned char ucHour, const unsigned char ucMinute)
+void CTime::Set(unsigned char ucDayOfWeek, unsigned char ucHour, unsigned char ucMinute, unsigned int uiMinuteDuration, unsigned int uiMinuteElapsed)
 {
-	if(ucHour >= 24)
-		SetDayOfWeek(((ucHour) / 24) - 1);
-	m_ulTimeSet = SharedUtility::GetTime();
-	m_ucHour = ucHour;
-	m_ucMinute = ucMinute;
+	m_ulTimeSet = (SharedUtility::GetTime() - uiMinuteElapsed);
+	m_ucDayOfWeek = (ucDayOfWeek % 7);
+	m_ucHour = (ucHour % 24);
+	m_ucMinute = (ucMinute % 60);
+	m_uiMinuteDuration = uiMinuteDuration;
 
 #ifdef _SERVER
-	SyncTime();
+	m_bSyncPending = true;
 #endif
 }
 
+void CTime::SetTime(const unsigned char ucHour, const unsigned char ucMinute)
+{
+	// Scripts that drive a day cycle set the time the clock is at, that keeps it running as it is
+	unsigned char ucCurrentHour = 0, ucCurrentMinute = 0;
+	GetTime(&ucCurrentHour, &ucCurrentMinute);
+
+	if(ucHour == ucCurrentHour && ucMinute == ucCurrentMinute)
+		return;
+
+	Set(GetDayOfWeek(), ucHour, ucMinute, m_uiMinuteDuration, 0);
+}
+
 void CTime::GetTime(unsigned char *ucHour, unsigned char *ucMinute)
 {
 	if(m_uiMinuteDuration == 0)
@@ -63,14 +78,14 @@ void CTime::GetTime(unsigned char *ucHour, unsigned char *ucMinute)
 
 void CTime::SetMinuteDuration(const unsigned int uiMinuteDuration)
 {
-	// Make sure we're calculating future times from ours
+	if(uiMinuteDuration == 0 || uiMinuteDuration == m_uiMinuteDuration)
+		return;
+
+	// Make sure we're calculating future times from ours, keeping how far into the minute we are
 	unsigned char ucHour = 0, ucMinute = 0;
 	GetTime(&ucHour, &ucMinute);
-	if(uiMinuteDuration > 0)
-	{
-		m_uiMinuteDuration = uiMinuteDuration;
-	}
-	SetTime(ucHour, ucMinute);
+	unsigned int uiMinuteElapsed = (unsigned int)(((double)GetMinuteElapsed() / m_uiMinuteDuration) * uiMinuteDuration);
+	Set(GetDayOfWeek(), ucHour, ucMinute, uiMinuteDuration, uiMinuteElapsed);
 }
 
 unsigned int CTime::GetMinuteDuration()
@@ -80,14 +95,14 @@ unsigned int CTime::GetMinuteDuration()
 
 void CTime::SetDayOfWeek(const unsigned char ucDayOfWeek)
 {
+	if(ucDayOfWeek == GetDayOfWeek())
+		return;
+
 	// Make sure we're calculating future times from our current ones, if we were to only set the day of week here
 	// it would be desynced for that it is calculated from a time in the past
 	unsigned char ucHour = 0, ucMinute = 0;
 	GetTime(&ucHour, &ucMinute);
-
-	m_ucDayOfWeek = ucDayOfWeek;
-
-	SetTime(ucHour, ucMinute);
+	Set(ucDayOfWeek, ucHour, ucMinute, m_uiMinuteDuration, GetMinuteElapsed());
 }
 
 unsigned char CTime::GetDayOfWeek()
@@ -104,15 +119,56 @@ unsigned char CTime::GetDayOfWeek()
 	}
 }
 
+unsigned int CTime::GetMinuteElapsed()
+{
+	if(m_uiMinuteDuration == 0)
+		return 0;
+
+	return ((SharedUtility::GetTime() - m_ulTimeSet) % m_uiMinuteDuration);
+}
+
+void CTime::WriteTime(CBitStream * pBitStream, unsigned char ucDayOfWeek, unsigned char ucHour, unsigned char ucMinute, unsigned int uiMinuteDuration, unsigned int uiMinuteElapsed)
+{
+	pBitStream->Write(ucDayOfWeek);
+	pBitStream->Write(ucHour);
+	pBitStream->Write(ucMinute);
+	pBitStream->WriteCompressed(uiMinuteDuration);
+	pBitStream->WriteCompressed(uiMinuteElapsed);
+}
+
+void CTime::Write(CBitStream * pBitStream)
+{
+	unsigned char ucHour = 0, ucMinute = 0;
+	GetTime(&ucHour, &ucMinute);
+	WriteTime(pBitStream, GetDayOfWeek(), ucHour, ucMinute, m_uiMinuteDuration, GetMinuteElapsed());
+}
+
+bool CTime::Read(CBitStream * pBitStream)
+{
+	unsigned char ucDayOfWeek, ucHour, ucMinute;
+	unsigned int uiMinuteDuration, uiMinuteElapsed;
+
+	if(!pBitStream->Read(ucDayOfWeek) || !pBitStream->Read(ucHour) || !pBitStream->Read(ucMinute) ||
+		!pBitStream->ReadCompressed(uiMinuteDuration) || !pBitStream->ReadCompressed(uiMinuteElapsed))
+		return false;
+
+	Set(ucDayOfWeek, ucHour, ucMinute, uiMinuteDuration, uiMinuteElapsed);
+	return true;
+}
+
 #ifdef _SERVER
+void CTime::Process()
+{
+	// Changes made in the same tick are sent at once
+	if(m_bSyncPending)
+		SyncTime();
+}
+
 void CTime::SyncTime()
 {
 	CBitStream bsSend;
-	bsSend.Write((unsigned char)(m_ucHour + (24 * (m_ucDayOfWeek + 1))));
-	bsSend.Write(m_ucMinute);
-	if(m_uiMinuteDuration != DEFAULT_MINUTE_DURATION)
-		bsSend.Write(m_uiMinuteDuration);
-
+	Write(&bsSend);
 	g_pNetworkManager->RPC(RPC_ScriptingSetPlayerTime, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	m_bSyncPending = false;
 }
 #endif
@@ -11,8 +11,10 @@
 // jenksta: this is kinda hacky :/
 #include "../Server/Core/Main.h"
 #include "../Server/Core/Interfaces/InterfaceCommon.h"
+#include "../Network/CBitStream.h"
 
-
+// The clock runs from the time it was set at with the minute duration, so every side
+// computes the same time from it and it is only sent when it is changed
 class CTime/* : public CTimeInterface*/
 {
 public:
@@ -24,10 +26,17 @@ private:
 	unsigned char m_ucMinute;
 	unsigned char m_ucDayOfWeek;
 	unsigned int m_uiMinuteDuration;
+#ifdef _SERVER
+	bool m_bSyncPending;
+#endif
+
+	void Set(unsigned char ucDayOfWeek, unsigned char ucHour, unsigned char ucMinute, unsigned int uiMinuteDuration, unsigned int uiMinuteElapsed);
+
 public:
 	CTime();
 	~CTime();
 
+	// Setting the time the clock is at already doesn't change it
 	void SetTime(const unsigned char ucHour, const unsigned char ucMinute);
 	void GetTime(unsigned char * ucHour, unsigned char * ucMinute);
 
@@ -37,7 +46,17 @@ public:
 	void SetDayOfWeek(const unsigned char ucDayOfWeek);
 	unsigned char GetDayOfWeek();
 
+	// Time in ms since the current minute started
+	unsigned int GetMinuteElapsed();
+
+	// The clock as it is sent (the day of week, hour, minute, minute duration and the time into the minute)
+	static void WriteTime(CBitStream * pBitStream, unsigned char ucDayOfWeek, unsigned char ucHour, unsigned char ucMinute, unsigned int uiMinuteDuration, unsigned int uiMinuteElapsed);
+	void Write(CBitStream * pBitStream);
+	bool Read(CBitStream * pBitStream);
+
 #ifdef _SERVER
+	// Sends the clock to everyone if it was changed since the last call
+	void Process();
 	void SyncTime();
 #endif
 };
@@ -24,6 +24,9 @@ CTrafficLights::CTrafficLights()
 	m_uiGreenDuration(DEFAULT_GREEN_DURATION),
 	m_uiYellowDuration(DEFAULT_YELLOW_DURATION),
 	m_uiRedDuration(DEFAULT_RED_DURATION)
+#ifdef _SERVER
+	, m_bSyncPending(false)
+#endif
 {
 }
 
@@ -50,7 +53,7 @@ bool CTrafficLights::SetState(eTrafficLightState state)
 		m_ulTimeSet = SharedUtility::GetTime();
 
 #ifdef _SERVER
-		SyncState();
+		m_bSyncPending = true;
 #endif
 		return true;
 	}
@@ -128,7 +131,7 @@ void CTrafficLights::SetLocked(bool bLocked)
 	m_bIsLocked = bLocked;
 
 #ifdef _SERVER
-	SyncState();
+	m_bSyncPending = true;
 #endif
 }
 
@@ -250,10 +253,20 @@ unsigned int CTrafficLights::GetRedDuration()
 }
 
 #ifdef _SERVER
+void CTrafficLights::Process()
+{
+	// The state and all durations set in the same tick are sent at once
+	if(m_bSyncPending)
+		SyncState();
+}
+
 void CTrafficLights::SyncState()
 {
 	CBitStream bsSend;
 	bsSend.Write((BYTE)m_eStateSet);
+
+	// The clients run the cycle from the same point
+	bsSend.Write(GetTimeThisCylce());
 	if(m_eStateSet != TRAFFIC_LIGHT_STATE_DISABLED_DISABLED)
 	{
 		if(m_bIsLocked)
@@ -275,6 +288,7 @@ void CTrafficLights::SyncState()
 	}
 
 	g_pNetworkManager->RPC(RPC_ScriptingSetTrafficLightState, &bsSend, PRIORITY_HIGH, RELIABILITY_RELIABLE_ORDERED, INVALID_ENTITY_ID, true);
+	m_bSyncPending = false;
 }
 #else
 CTrafficLights::eGTATrafficLightState CTrafficLights::GetTrafficLightState()
@@ -24,6 +24,9 @@ private:
 	unsigned int m_uiYellowDuration;
 	unsigned int m_uiRedDuration;
 	unsigned int m_uiTotalDuration;
+#ifdef _SERVER
+	bool m_bSyncPending;
+#endif
 
 public:
 	CTrafficLights();
@@ -53,6 +56,8 @@ public:
 	bool IsLocked();
 
 #ifdef _SERVER
+	// Sends the state to everyone if it was changed since the last call
+	void Process();
 	void SyncState();
 #else
 	eGTATrafficLightState GetTrafficLightState();
@@ -0,0 +1,311 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CVehicleModels.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <algorithm>
+#include "CVehicleModels.h"
+
+struct VehicleModelHash
+{
+	unsigned int uiModelHash;
+	int          iModelId;
+};
+
+// The model hash of each model id
+static const unsigned int g_uiVehicleModelHashes[VEHICLE_MODEL_COUNT] =
+{
+	0x4B5C5320, // 0 ADMIRAL
+	0x5D0AAC8F, // 1 AIRTUG
+	0x45D56ADA, // 2 AMBULANCE
+	0xC1E908D2, // 3 BANSHEE
+	0x7A61B330, // 4 BENSON
+	0x32B91AE8, // 5 BIFF
+	0xEB70965F, // 6 BLISTA
+	0x4020325C, // 7 BOBCAT
+	0x898ECCEA, // 8 BOXVILLE
+	0xD756460C, // 9 BUCCANEER
+	0xAFBB2CA4, // 10 BURRITO
+	0xC9E8FF76, // 11 BURRITO2
+	0xD577C962, // 12 BUS
+	0x705A3E41, // 13 CABBY
+	0x779F23AA, // 14 CAVALCADE
+	0xFBFD5B62, // 15 CHAVOS
+	0x86FE0B60, // 16 COGNOSCENTI
+	0x3F637729, // 17 COMET
+	0x067BC037, // 18 COQUETTE
+	0x09B56631, // 19 DF8
+	0xBC993509, // 20 DILETTANTE
+	0x2B26F456, // 21 DUKES
+	0x8A765902, // 22 E109
+	0xD7278283, // 23 EMPEROR
+	0x8FC3AADC, // 24 EMPEROR2
+	0xEF7ED55D, // 25 ESPERANTO
+	0x81A9CDDF, // 26 FACTION
+	0x432EA949, // 27 FBI
+	0xBE9075F1, // 28 FELTZER
+	0x3A196CEA, // 29 FEROCI
+	0x3D285C4A, // 30 FEROCI2
+	0x73920F8E, // 31 FIRETRUK
+	0x50B0215A, // 32 FLATBED
+	0x255FC509, // 33 FORTUNE
+	0x58E49664, // 34 FORKLIFT
+	0x7836CE2F, // 35 FUTO
+	0x28420460, // 36 FXT
+	0x34B7390F, // 37 HABANERO
+	0xEB9F21D3, // 38 HAKUMAI
+	0x1D06D681, // 39 HUNTLEY
+	0x18F25AC7, // 40 INFERNUS
+	0xB3206692, // 41 INGOT
+	0x34DD8AA1, // 42 INTRUDER
+	0x4BA4E8DC, // 43 LANDSTALKER
+	0xFDCAF758, // 44 LOKUS
+	0x81634188, // 45 MANANA
+	0x4DC293EA, // 46 MARBELLA
+	0xB4D8797E, // 47 MERIT
+	0xED7EADA4, // 48 MINIVAN
+	0x1F52A43F, // 49 MOONBEAM
+	0x22C16A2F, // 50 MRTASTY
+	0x35ED670B, // 51 MULE
+	0x08DE2A8B, // 52 NOOSE
+	0x71EF6313, // 53 NSTOCKADE
+	0x506434F6, // 54 ORACLE
+	0x21EEE87D, // 55 PACKER
+	0xCFCFEB3B, // 56 PATRIOT
+	0x84282613, // 57 PERENNIAL
+	0xA1363020, // 58 PERENNIAL2
+	0x6D19CCBC, // 59 PEYOTE
+	0x809AA4CB, // 60 PHANTOM
+	0x07D10BDC, // 61 PINNACLE
+	0x5208A519, // 62 PMP600
+	0x79FBB0C5, // 63 POLICE
+	0x9F05F101, // 64 POLICE2
+	0xEB221FC2, // 65 POLPATRIOT
+	0xF8DE29A8, // 66 PONY
+	0x8FB66F9B, // 67 PREMIER
+	0x8B0D2BA6, // 68 PRES
+	0xBB6B404F, // 69 PRIMO
+	0x8EB78F5A, // 70 PSTOCKADE
+	0x52DB01E0, // 71 RANCHER
+	0x04F48FC4, // 72 REBLA
+	0xCD935EF9, // 73 RIPLEY
+	0x2560B2FC, // 74 ROMERO
+	0x8CD0264C, // 75 ROM
+	0xF26CEFF9, // 76 RUINER
+	0xE53C7459, // 77 SABRE
+	0x4B5D021E, // 78 SABRE2
+	0x9B909C94, // 79 SABREGT
+	0xECC96C3F, // 80 SCHAFTER
+	0x50732C82, // 81 SENTINEL
+	0x50249008, // 82 SOLAIR
+	0xCFB3870C, // 83 SPEEDO
+	0x72A4C31E, // 84 STALION
+	0x63FFE6EC, // 85 STEED
+	0x6827CF72, // 86 STOCKADE
+	0x66B4FC45, // 87 STRATUM
+	0x8B13F083, // 88 STRETCH
+	0x39DA2754, // 89 SULTAN
+	0xEE6024BC, // 90 SULTANRS
+	0x6C9962A9, // 91 SUPERGT
+	0xC703DB5F, // 92 TAXI
+	0x480DAF95, // 93 TAXI2
+	0x72435A19, // 94 TRASH
+	0x8EF34547, // 95 TURISMO
+	0x5B73F5B7, // 96 URANUS
+	0xCEC6B9B7, // 97 VIGERO
+	0x973141FC, // 98 VIGERO2
+	0xDD3BD501, // 99 VINCENT
+	0xE2504942, // 100 VIRGO
+	0x779B4F2D, // 101 VOODOO
+	0x69F06B57, // 102 WASHINGTON
+	0x737DAEC2, // 103 WILLARD
+	0xBE6FF06A, // 104 YANKEE
+	0x92E56A2C, // 105 BOBBER
+	0x9229E4EB, // 106 FAGGIO
+	0x22DC8E7F, // 107 HELLFURY
+	0x47B9138A, // 108 NRG900
+	0xC9CEAF06, // 109 PCJ
+	0x2EF89E46, // 110 SANCHEZ
+	0xDE05FB87, // 111 ZOMBIEB
+	0x31F0B376, // 112 ANNIHILATOR
+	0x9D0450CA, // 113 MAVERICK
+	0x1517D4D9, // 114 POLMAV
+	0x78D70477, // 115 TOURMAV
+	0x3D961290, // 116 DINGHY
+	0x33581161, // 117 JETMAX
+	0xC1CE1183, // 118 MARQUIS
+	0xE2E7D4AB, // 119 PREDATOR
+	0x68E27CB6, // 120 REEFER
+	0x17DF5EC2, // 121 SQUALO
+	0x3F724E66, // 122 TUGA
+	0x1149422F, // 123 TROPIC
+	0xC6C3242D, // 124 CABLECAR
+	0x2FBC4D30, // 125 SUBWAY_LO
+	0x8B887FDB, // 126 SUBWAY_HI
+};
+
+// The model ids sorted by their model hash
+static const VehicleModelHash g_vehicleModelIds[VEHICLE_MODEL_COUNT] =
+{
+	{ 0x04F48FC4, 72 },
+	{ 0x067BC037, 18 },
+	{ 0x07D10BDC, 61 },
+	{ 0x08DE2A8B, 52 },
+	{ 0x09B56631, 19 },
+	{ 0x1149422F, 123 },
+	{ 0x1517D4D9, 114 },
+	{ 0x17DF5EC2, 121 },
+	{ 0x18F25AC7, 40 },
+	{ 0x1D06D681, 39 },
+	{ 0x1F52A43F, 49 },
+	{ 0x21EEE87D, 55 },
+	{ 0x22C16A2F, 50 },
+	{ 0x22DC8E7F, 107 },
+	{ 0x255FC509, 33 },
+	{ 0x2560B2FC, 74 },
+	{ 0x28420460, 36 },
+	{ 0x2B26F456, 21 },
+	{ 0x2EF89E46, 110 },
+	{ 0x2FBC4D30, 125 },
+	{ 0x31F0B376, 112 },
+	{ 0x32B91AE8, 5 },
+	{ 0x33581161, 117 },
+	{ 0x34B7390F, 37 },
+	{ 0x34DD8AA1, 42 },
+	{ 0x35ED670B, 51 },
+	{ 0x39DA2754, 89 },
+	{ 0x3A196CEA, 29 },
+	{ 0x3D285C4A, 30 },
+	{ 0x3D961290, 116 },
+	{ 0x3F637729, 17 },
+	{ 0x3F724E66, 122 },
+	{ 0x4020325C, 7 },
+	{ 0x432EA949, 27 },
+	{ 0x45D56ADA, 2 },
+	{ 0x47B9138A, 108 },
+	{ 0x480DAF95, 93 },
+	{ 0x4B5C5320, 0 },
+	{ 0x4B5D021E, 78 },
+	{ 0x4BA4E8DC, 43 },
+	{ 0x4DC293EA, 46 },
+	{ 0x50249008, 82 },
+	{ 0x506434F6, 54 },
+	{ 0x50732C82, 81 },
+	{ 0x50B0215A, 32 },
+	{ 0x5208A519, 62 },
+	{ 0x52DB01E0, 71 },
+	{ 0x58E49664, 34 },
+	{ 0x5B73F5B7, 96 },
+	{ 0x5D0AAC8F, 1 },
+	{ 0x63FFE6EC, 85 },
+	{ 0x66B4FC45, 87 },
+	{ 0x6827CF72, 86 },
+	{ 0x68E27CB6, 120 },
+	{ 0x69F06B57, 102 },
+	{ 0x6C9962A9, 91 },
+	{ 0x6D19CCBC, 59 },
+	{ 0x705A3E41, 13 },
+	{ 0x71EF6313, 53 },
+	{ 0x72435A19, 94 },
+	{ 0x72A4C31E, 84 },
+	{ 0x737DAEC2, 103 },
+	{ 0x73920F8E, 31 },
+	{ 0x779B4F2D, 101 },
+	{ 0x779F23AA, 14 },
+	{ 0x7836CE2F, 35 },
+	{ 0x78D70477, 115 },
+	{ 0x79FBB0C5, 63 },
+	{ 0x7A61B330, 4 },
+	{ 0x809AA4CB, 60 },
+	{ 0x81634188, 45 },
+	{ 0x81A9CDDF, 26 },
+	{ 0x84282613, 57 },
+	{ 0x86FE0B60, 16 },
+	{ 0x898ECCEA, 8 },
+	{ 0x8A765902, 22 },
+	{ 0x8B0D2BA6, 68 },
+	{ 0x8B13F083, 88 },
+	{ 0x8B887FDB, 126 },
+	{ 0x8CD0264C, 75 },
+	{ 0x8EB78F5A, 70 },
+	{ 0x8EF34547, 95 },
+	{ 0x8FB66F9B, 67 },
+	{ 0x8FC3AADC, 24 },
+	{ 0x9229E4EB, 106 },
+	{ 0x92E56A2C, 105 },
+	{ 0x973141FC, 98 },
+	{ 0x9B909C94, 79 },
+	{ 0x9D0450CA, 113 },
+	{ 0x9F05F101, 64 },
+	{ 0xA1363020, 58 },
+	{ 0xAFBB2CA4, 10 },
+	{ 0xB3206692, 41 },
+	{ 0xB4D8797E, 47 },
+	{ 0xBB6B404F, 69 },
+	{ 0xBC993509, 20 },
+	{ 0xBE6FF06A, 104 },
+	{ 0xBE9075F1, 28 },
+	{ 0xC1CE1183, 118 },
+	{ 0xC1E908D2, 3 },
+	{ 0xC6C3242D, 124 },
+	{ 0xC703DB5F, 92 },
+	{ 0xC9CEAF06, 109 },
+	{ 0xC9E8FF76, 11 },
+	{ 0xCD935EF9, 73 },
+	{ 0xCEC6B9B7, 97 },
+	{ 0xCFB3870C, 83 },
+	{ 0xCFCFEB3B, 56 },
+	{ 0xD577C962, 12 },
+	{ 0xD7278283, 23 },
+	{ 0xD756460C, 9 },
+	{ 0xDD3BD501, 99 },
+	{ 0xDE05FB87, 111 },
+	{ 0xE2504942, 100 },
+	{ 0xE2E7D4AB, 119 },
+	{ 0xE53C7459, 77 },
+	{ 0xEB221FC2, 65 },
+	{ 0xEB70965F, 6 },
+	{ 0xEB9F21D3, 38 },
+	{ 0xECC96C3F, 80 },
+	{ 0xED7EADA4, 48 },
+	{ 0xEE6024BC, 90 },
+	{ 0xEF7ED55D, 25 },
+	{ 0xF26CEFF9, 76 },
+	{ 0xF8DE29A8, 66 },
+	{ 0xFBFD5B62, 15 },
+	{ 0xFDCAF758, 44 },
+};
+
+inline bool CompareVehicleModelHash(const VehicleModelHash& modelHash, unsigned int uiModelHash)
+{
+	return (modelHash.uiModelHash < uiModelHash);
+}
+
+unsigned int CVehicleModels::GetModelHash(int iModelId)
+{
+	if(iModelId < 0 || iModelId >= VEHICLE_MODEL_COUNT)
+		return 0;
+
+	return g_uiVehicleModelHashes[iModelId];
+}
+
+int CVehicleModels::GetModelId(unsigned int uiModelHash)
+{
+	const VehicleModelHash * pEnd = (g_vehicleModelIds + VEHICLE_MODEL_COUNT);
+	const VehicleModelHash * pModelHash = std::lower_bound(g_vehicleModelIds, pEnd, uiModelHash, CompareVehicleModelHash);
+
+	if(pModelHash == pEnd || pModelHash->uiModelHash != uiModelHash)
+		return -1;
+
+	return pModelHash->iModelId;
+}
+
+bool CVehicleModels::IsValidModel(int iModelId)
+{
+	// The trains and a few others can't be created
+	return (iModelId >= 0 && iModelId <= 123 && iModelId != 41 && iModelId != 96 && iModelId != 107 && iModelId != 111);
+}
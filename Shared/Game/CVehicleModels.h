@@ -0,0 +1,27 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CVehicleModels.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+// Amount of vehicle model ids
+#define VEHICLE_MODEL_COUNT 127
+
+// Converts between the vehicle model ids of the scripts and the model hashes of the game
+class CVehicleModels
+{
+public:
+	// Returns 0 if the model id is invalid
+	static unsigned int GetModelHash(int iModelId);
+
+	// Returns -1 if the model hash isn't a vehicle model
+	static int          GetModelId(unsigned int uiModelHash);
+
+	// Returns true if a vehicle can be created with the model id
+	static bool         IsValidModel(int iModelId);
+};
@@ -0,0 +1,210 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CPositionBatch.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include "CMath.h"
+
+// Use sse for the batch queries if the compiler targets it (every x64 target and
+// x86 with /arch:SSE or above), otherwise the queries are done one by one
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1) || defined(__SSE__)
+#define POSITION_BATCH_SSE
+#include <xmmintrin.h>
+#endif
+
+// Positions stored as separate x, y and z arrays so range checks against a
+// lot of them can be done 4 at a time
+class CPositionBatch
+{
+private:
+	std::vector<float> m_fX;
+	std::vector<float> m_fY;
+	std::vector<float> m_fZ;
+
+public:
+	unsigned int GetSize() const { return (unsigned int)m_fX.size(); }
+
+	void         Clear()
+	{
+		m_fX.clear();
+		m_fY.clear();
+		m_fZ.clear();
+	}
+
+	void         Reserve(unsigned int uiSize)
+	{
+		m_fX.reserve(uiSize);
+		m_fY.reserve(uiSize);
+		m_fZ.reserve(uiSize);
+	}
+
+	void         Add(const CVector3& vecPosition)
+	{
+		m_fX.push_back(vecPosition.fX);
+		m_fY.push_back(vecPosition.fY);
+		m_fZ.push_back(vecPosition.fZ);
+	}
+
+	void         Set(unsigned int uiIndex, const CVector3& vecPosition)
+	{
+		m_fX[uiIndex] = vecPosition.fX;
+		m_fY[uiIndex] = vecPosition.fY;
+		m_fZ[uiIndex] = vecPosition.fZ;
+	}
+
+	void         Get(unsigned int uiIndex, CVector3& vecPosition) const
+	{
+		vecPosition.fX = m_fX[uiIndex];
+		vecPosition.fY = m_fY[uiIndex];
+		vecPosition.fZ = m_fZ[uiIndex];
+	}
+
+	// Removes the position by moving the last one into its place
+	void         Remove(unsigned int uiIndex)
+	{
+		m_fX[uiIndex] = m_fX.back();
+		m_fY[uiIndex] = m_fY.back();
+		m_fZ[uiIndex] = m_fZ.back();
+		m_fX.pop_back();
+		m_fY.pop_back();
+		m_fZ.pop_back();
+	}
+
+	// Writes the squared distance of every position to vecPoint into pfDistances
+	void         GetDistancesSquared(const CVector3& vecPoint, float * pfDistances) const
+	{
+		unsigned int uiSize = GetSize();
+		unsigned int i = 0;
+
+		if(uiSize == 0)
+			return;
+
+		const float * pfX = &m_fX[0];
+		const float * pfY = &m_fY[0];
+		const float * pfZ = &m_fZ[0];
+#ifdef POSITION_BATCH_SSE
+		__m128 x = _mm_set1_ps(vecPoint.fX);
+		__m128 y = _mm_set1_ps(vecPoint.fY);
+		__m128 z = _mm_set1_ps(vecPoint.fZ);
+
+		for(; (i + 4) <= uiSize; i += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(pfX + i), x);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(pfY + i), y);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(pfZ + i), z);
+			_mm_storeu_ps((pfDistances + i), _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		}
+#endif
+		for(; i < uiSize; i++)
+		{
+			float fX = (pfX[i] - vecPoint.fX);
+			float fY = (pfY[i] - vecPoint.fY);
+			float fZ = (pfZ[i] - vecPoint.fZ);
+			pfDistances[i] = ((fX * fX) + (fY * fY) + (fZ * fZ));
+		}
+	}
+
+	// Writes the indices of the positions within fRadius of vecCenter into puiIndices
+	// (which must have space for GetSize indices) and returns the amount of them
+	unsigned int FindInSphere(const CVector3& vecCenter, float fRadius, unsigned int * puiIndices) const
+	{
+		unsigned int uiSize = GetSize();
+		unsigned int uiFound = 0;
+		unsigned int i = 0;
+
+		if(uiSize == 0)
+			return 0;
+
+		const float * pfX = &m_fX[0];
+		const float * pfY = &m_fY[0];
+		const float * pfZ = &m_fZ[0];
+		float fRadiusSquared = (fRadius * fRadius);
+#ifdef POSITION_BATCH_SSE
+		__m128 x = _mm_set1_ps(vecCenter.fX);
+		__m128 y = _mm_set1_ps(vecCenter.fY);
+		__m128 z = _mm_set1_ps(vecCenter.fZ);
+		__m128 radiusSquared = _mm_set1_ps(fRadiusSquared);
+
+		for(; (i + 4) <= uiSize; i += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(pfX + i), x);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(pfY + i), y);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(pfZ + i), z);
+			__m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			int iMask = _mm_movemask_ps(_mm_cmple_ps(distanceSquared, radiusSquared));
+
+			for(unsigned int j = 0; iMask != 0; j++, iMask >>= 1)
+			{
+				if(iMask & 1)
+					puiIndices[uiFound++] = (i + j);
+			}
+		}
+#endif
+		for(; i < uiSize; i++)
+		{
+			float fX = (pfX[i] - vecCenter.fX);
+			float fY = (pfY[i] - vecCenter.fY);
+			float fZ = (pfZ[i] - vecCenter.fZ);
+
+			if(((fX * fX) + (fY * fY) + (fZ * fZ)) <= fRadiusSquared)
+				puiIndices[uiFound++] = i;
+		}
+
+		return uiFound;
+	}
+
+	// Same as FindInSphere for the positions inside the box (vecMin must be the lower corner)
+	unsigned int FindInBox(const CVector3& vecMin, const CVector3& vecMax, unsigned int * puiIndices) const
+	{
+		unsigned int uiSize = GetSize();
+		unsigned int uiFound = 0;
+		unsigned int i = 0;
+
+		if(uiSize == 0)
+			return 0;
+
+		const float * pfX = &m_fX[0];
+		const float * pfY = &m_fY[0];
+		const float * pfZ = &m_fZ[0];
+#ifdef POSITION_BATCH_SSE
+		__m128 minX = _mm_set1_ps(vecMin.fX);
+		__m128 minY = _mm_set1_ps(vecMin.fY);
+		__m128 minZ = _mm_set1_ps(vecMin.fZ);
+		__m128 maxX = _mm_set1_ps(vecMax.fX);
+		__m128 maxY = _mm_set1_ps(vecMax.fY);
+		__m128 maxZ = _mm_set1_ps(vecMax.fZ);
+
+		for(; (i + 4) <= uiSize; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(pfX + i);
+			__m128 y = _mm_loadu_ps(pfY + i);
+			__m128 z = _mm_loadu_ps(pfZ + i);
+			__m128 inside = _mm_and_ps(_mm_cmpge_ps(x, minX), _mm_cmple_ps(x, maxX));
+			inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(y, minY), _mm_cmple_ps(y, maxY)));
+			inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpge_ps(z, minZ), _mm_cmple_ps(z, maxZ)));
+			int iMask = _mm_movemask_ps(inside);
+
+			for(unsigned int j = 0; iMask != 0; j++, iMask >>= 1)
+			{
+				if(iMask & 1)
+					puiIndices[uiFound++] = (i + j);
+			}
+		}
+#endif
+		for(; i < uiSize; i++)
+		{
+			if(pfX[i] >= vecMin.fX && pfX[i] <= vecMax.fX && pfY[i] >= vecMin.fY && pfY[i] <= vecMax.fY &&
+				pfZ[i] >= vecMin.fZ && pfZ[i] <= vecMax.fZ)
+				puiIndices[uiFound++] = i;
+		}
+
+		return uiFound;
+	}
+};
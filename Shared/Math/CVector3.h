@@ -37,6 +37,11 @@ public:
 		return sqrt((fX * fX) + (fY * fY) + (fZ * fZ));
 	}
 
+	float LengthSquared() const
+	{
+		return ((fX * fX) + (fY * fY) + (fZ * fZ));
+	}
+
 	CVector3 operator+ (const CVector3& vecRight) const
 	{
 		return CVector3(fX + vecRight.fX, fY + vecRight.fY, fZ + vecRight.fZ);
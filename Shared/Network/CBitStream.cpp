@@ -10,6 +10,160 @@
 
 #include "CBitStream.h"
 #include <assert.h>
+#include "../Threading/CAtomic.h"
+#include "../CMemoryTracker.h"
+
+#ifdef _LINUX
+#include <pthread.h>
+#endif
+
+// Freed buffers of a single thread
+struct BufferPool
+{
+	unsigned char * pFree[BUFFER_POOL_CLASSES][BUFFER_POOL_MAX_FREE];
+	unsigned int    uiFree[BUFFER_POOL_CLASSES];
+};
+
+#ifdef WIN32
+// The slot is allocated on first use rather than declaring the pool __declspec(thread) as
+// that doesn't work in dynamically loaded modules on XP. There is no thread exit callback
+// for it so the pool of a thread that exits stays allocated (at most a few megabytes).
+static volatile long g_lBufferPoolSlot = (long)TLS_OUT_OF_INDEXES;
+#else
+static pthread_once_t g_bufferPoolOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t  g_bufferPoolKey;
+static bool           g_bBufferPoolKeyCreated = false;
+
+static void DestroyBufferPool(void * pPool)
+{
+	BufferPool * pBufferPool = (BufferPool *)pPool;
+
+	for(unsigned int i = 0; i < BUFFER_POOL_CLASSES; i++)
+	{
+		for(unsigned int j = 0; j < pBufferPool->uiFree[i]; j++)
+		{
+			CMemoryTracker::Freed(MEMORY_TAG_BITSTREAMS, ((BUFFER_STACK_ALLOCATION_SIZE << 1) << i));
+			free(pBufferPool->pFree[i][j]);
+		}
+	}
+
+	free(pBufferPool);
+}
+
+static void CreateBufferPoolKey()
+{
+	g_bBufferPoolKeyCreated = (pthread_key_create(&g_bufferPoolKey, DestroyBufferPool) == 0);
+}
+#endif
+
+// Returns the pool of the calling thread, NULL if there is none (the buffers are not pooled then)
+static BufferPool * GetBufferPool()
+{
+	BufferPool * pPool = NULL;
+#ifdef WIN32
+	DWORD dwSlot = (DWORD)CAtomic::Get(&g_lBufferPoolSlot);
+
+	if(dwSlot == TLS_OUT_OF_INDEXES)
+	{
+		DWORD dwNewSlot = TlsAlloc();
+
+		if(dwNewSlot == TLS_OUT_OF_INDEXES)
+			return NULL;
+
+		// Another thread can allocate the slot at the same time, only one of them is kept
+		dwSlot = (DWORD)CAtomic::CompareExchange(&g_lBufferPoolSlot, (long)dwNewSlot, (long)TLS_OUT_OF_INDEXES);
+
+		if(dwSlot == TLS_OUT_OF_INDEXES)
+			dwSlot = dwNewSlot;
+		else
+			TlsFree(dwNewSlot);
+	}
+
+	pPool = (BufferPool *)TlsGetValue(dwSlot);
+
+	if(!pPool)
+	{
+		pPool = (BufferPool *)calloc(1, sizeof(BufferPool));
+
+		if(pPool)
+			TlsSetValue(dwSlot, pPool);
+	}
+#else
+	pthread_once(&g_bufferPoolOnce, CreateBufferPoolKey);
+
+	if(!g_bBufferPoolKeyCreated)
+		return NULL;
+
+	pPool = (BufferPool *)pthread_getspecific(g_bufferPoolKey);
+
+	if(!pPool)
+	{
+		pPool = (BufferPool *)calloc(1, sizeof(BufferPool));
+
+		if(pPool)
+			pthread_setspecific(g_bufferPoolKey, pPool);
+	}
+#endif
+	return pPool;
+}
+
+unsigned char * CBitStream::AllocateBuffer(unsigned int& uiSizeInBytes)
+{
+	// Find the smallest class the buffer fits in
+	unsigned int uiClass = 0;
+	unsigned int uiClassSize = (BUFFER_STACK_ALLOCATION_SIZE << 1);
+
+	while(uiClass < BUFFER_POOL_CLASSES && uiClassSize < uiSizeInBytes)
+	{
+		uiClass++;
+		uiClassSize <<= 1;
+	}
+
+	// Buffers bigger than the biggest class are not pooled
+	if(uiClass == BUFFER_POOL_CLASSES)
+	{
+		CMemoryTracker::Allocated(MEMORY_TAG_BITSTREAMS, uiSizeInBytes);
+		return (unsigned char *)malloc(uiSizeInBytes);
+	}
+
+	uiSizeInBytes = uiClassSize;
+	BufferPool * pPool = GetBufferPool();
+
+	if(pPool && pPool->uiFree[uiClass] > 0)
+		return pPool->pFree[uiClass][--pPool->uiFree[uiClass]];
+
+	// Pooled buffers stay counted until they are freed
+	CMemoryTracker::Allocated(MEMORY_TAG_BITSTREAMS, uiClassSize);
+	return (unsigned char *)malloc(uiClassSize);
+}
+
+void CBitStream::FreeBuffer(unsigned char * pBuffer, unsigned int uiSizeInBytes)
+{
+	if(!pBuffer)
+		return;
+
+	// Only buffers of exactly the size of a class came from the pool
+	unsigned int uiClassSize = (BUFFER_STACK_ALLOCATION_SIZE << 1);
+
+	for(unsigned int i = 0; i < BUFFER_POOL_CLASSES; i++, uiClassSize <<= 1)
+	{
+		if(uiClassSize == uiSizeInBytes)
+		{
+			BufferPool * pPool = GetBufferPool();
+
+			if(pPool && pPool->uiFree[i] < BUFFER_POOL_MAX_FREE)
+			{
+				pPool->pFree[i][pPool->uiFree[i]++] = pBuffer;
+				return;
+			}
+
+			break;
+		}
+	}
+
+	CMemoryTracker::Freed(MEMORY_TAG_BITSTREAMS, uiSizeInBytes);
+	free(pBuffer);
+}
 
 CBitStream::CBitStream()
 	: m_pData(m_stackData),
@@ -33,8 +187,9 @@ CBitStream::CBitStream(const unsigned int uiSizeInBytes)
 	}
 	else
 	{
-		m_pData = (unsigned char *)malloc(uiSizeInBytes);
-		m_uiBufferSizeInBits = (uiSizeInBytes << 3);
+		unsigned int uiAllocatedSize = uiSizeInBytes;
+		m_pData = AllocateBuffer(uiAllocatedSize);
+		m_uiBufferSizeInBits = (uiAllocatedSize << 3);
 	}
 }
 
@@ -44,32 +199,35 @@ CBitStream::CBitStream(unsigned char * pBuffer, unsigned int uiSizeInBytes, bool
 {
 	if(bCopyData)
 	{
-		if(uiSizeInBytes > 0)
+		if(uiSizeInBytes <= BUFFER_STACK_ALLOCATION_SIZE)
 		{
-			if(uiSizeInBytes < BUFFER_STACK_ALLOCATION_SIZE)
-			{
-				m_pData = (unsigned char *)m_stackData;
-				m_uiBufferSizeInBits = (BUFFER_STACK_ALLOCATION_SIZE << 3);
-			}
-			else
-				m_pData = (unsigned char *)malloc(uiSizeInBytes);
-
-			memcpy(m_pData, pBuffer, uiSizeInBytes);
+			m_pData = (unsigned char *)m_stackData;
+			m_uiBufferSizeInBits = (BUFFER_STACK_ALLOCATION_SIZE << 3);
 		}
 		else
-			m_pData = NULL;
+		{
+			unsigned int uiAllocatedSize = uiSizeInBytes;
+			m_pData = AllocateBuffer(uiAllocatedSize);
+			m_uiBufferSizeInBits = (uiAllocatedSize << 3);
+		}
+
+		if(uiSizeInBytes > 0)
+			memcpy(m_pData, pBuffer, uiSizeInBytes);
 	}
 	else
+	{
 		m_pData = (unsigned char *)pBuffer;
+		m_uiBufferSizeInBits = (uiSizeInBytes << 3);
+	}
 
 	m_uiWriteOffsetInBits = (uiSizeInBytes << 3);
-	m_uiBufferSizeInBits = (uiSizeInBytes << 3);
 }
 
 CBitStream::~CBitStream()
 {
-	if(m_bCopyData && (m_uiBufferSizeInBits > (BUFFER_STACK_ALLOCATION_SIZE << 3)))
-		free(m_pData);
+	// Heap buffers are always exactly m_uiBufferSizeInBits so they can be pooled
+	if(m_bCopyData && m_pData != (unsigned char *)m_stackData)
+		FreeBuffer(m_pData, BITS_TO_BYTES(m_uiBufferSizeInBits));
 }
 
 void CBitStream::Reset(void)
@@ -78,6 +236,18 @@ void CBitStream::Reset(void)
 	m_uiReadOffsetInBits = 0;
 }
 
+void CBitStream::Reallocate(unsigned int uiSizeInBytes)
+{
+	unsigned char * pData = AllocateBuffer(uiSizeInBytes);
+	memcpy(pData, m_pData, BITS_TO_BYTES(m_uiBufferSizeInBits));
+
+	if(m_pData != (unsigned char *)m_stackData)
+		FreeBuffer(m_pData, BITS_TO_BYTES(m_uiBufferSizeInBits));
+
+	m_pData = pData;
+	m_uiBufferSizeInBits = (uiSizeInBytes << 3);
+}
+
 void CBitStream::AddBitsAndReallocate(unsigned int uiSizeInBits)
 {
 	unsigned int uiNewNumberOfBitsAllocated = uiSizeInBits + m_uiWriteOffsetInBits;
@@ -95,22 +265,23 @@ void CBitStream::AddBitsAndReallocate(unsigned int uiSizeInBits)
 
 		unsigned int uiAmountToAllocate = BITS_TO_BYTES(uiNewNumberOfBitsAllocated);
 
-		if(m_pData == (unsigned char *)m_stackData)
-		{
-			if (uiAmountToAllocate > BUFFER_STACK_ALLOCATION_SIZE)
-			{
-				m_pData = (unsigned char *)malloc(uiAmountToAllocate);
-
-				// need to copy the stack data over to our new memory area too
-				memcpy(m_pData, (void *)m_stackData, BITS_TO_BYTES(m_uiBufferSizeInBits)); 
-			}
-		}
+		// The stack buffer is used until it is full
+		if(m_pData == (unsigned char *)m_stackData && uiAmountToAllocate <= BUFFER_STACK_ALLOCATION_SIZE)
+			m_uiBufferSizeInBits = (BUFFER_STACK_ALLOCATION_SIZE << 3);
 		else
-			m_pData = (unsigned char *)realloc(m_pData, uiAmountToAllocate);
+			Reallocate(uiAmountToAllocate);
 	}
+}
 
-	if(uiNewNumberOfBitsAllocated > m_uiBufferSizeInBits)
-		m_uiBufferSizeInBits = uiNewNumberOfBitsAllocated;
+void CBitStream::Reserve(unsigned int uiSizeInBytes)
+{
+	if(!m_bCopyData || (uiSizeInBytes << 3) <= m_uiBufferSizeInBits)
+		return;
+
+	if(m_pData == (unsigned char *)m_stackData && uiSizeInBytes <= BUFFER_STACK_ALLOCATION_SIZE)
+		m_uiBufferSizeInBits = (BUFFER_STACK_ALLOCATION_SIZE << 3);
+	else
+		Reallocate(uiSizeInBytes);
 }
 
 void CBitStream::ResetReadPointer(void)
@@ -169,6 +340,190 @@ bool CBitStream::Read(CControlState &out)
 	return out.Deserialize(this);
 }
 
+void CBitStream::WriteQuantized(float fIn, float fMin, float fMax, unsigned int uiBits)
+{
+	unsigned int uiMax = ((uiBits >= 32) ? 0xFFFFFFFF : ((1U << uiBits) - 1));
+
+	// Normalize the value to 0 - 1 (this also catches NaN)
+	double dNormalized = ((fIn - fMin) / (fMax - fMin));
+
+	if(!(dNormalized >= 0.0))
+		dNormalized = 0.0;
+	else if(dNormalized > 1.0)
+		dNormalized = 1.0;
+
+	unsigned int uiValue = (unsigned int)((dNormalized * uiMax) + 0.5);
+	WriteBits((unsigned char *)&uiValue, uiBits, true);
+}
+
+void CBitStream::WriteQuantized(const CVector3 &vecIn, float fMin, float fMax, unsigned int uiBits)
+{
+	WriteQuantized(vecIn.fX, fMin, fMax, uiBits);
+	WriteQuantized(vecIn.fY, fMin, fMax, uiBits);
+	WriteQuantized(vecIn.fZ, fMin, fMax, uiBits);
+}
+
+void CBitStream::WriteAngle(float fIn)
+{
+	// Wrap the angle to 0 - 360
+	fIn = fmod(fIn, 360.0f);
+
+	if(fIn < 0.0f)
+		fIn += 360.0f;
+
+	// Quantize to 0 - 65535 steps of the full circle so 360 wraps to 0
+	unsigned int uiValue = ((unsigned int)((fIn / 360.0f) * (1 << ANGLE_BITS) + 0.5f) & ((1 << ANGLE_BITS) - 1));
+	WriteBits((unsigned char *)&uiValue, ANGLE_BITS, true);
+}
+
+void CBitStream::WriteNormVector(const CVector3 &vecIn)
+{
+	WriteQuantized(vecIn, -1.0f, 1.0f, NORM_VECTOR_BITS);
+}
+
+void CBitStream::WriteMagnitudeVector(const CVector3 &vecIn)
+{
+	float fMagnitude = vecIn.Length();
+	Write(fMagnitude);
+
+	if(fMagnitude > 0.00001f)
+		WriteNormVector(vecIn / fMagnitude);
+}
+
+void CBitStream::WritePosition(const CVector3 &vecIn)
+{
+	// Is the position within the world bounds?
+	if(vecIn.fX >= WORLD_BOUNDS_MIN_XY && vecIn.fX <= WORLD_BOUNDS_MAX_XY &&
+		vecIn.fY >= WORLD_BOUNDS_MIN_XY && vecIn.fY <= WORLD_BOUNDS_MAX_XY &&
+		vecIn.fZ >= WORLD_BOUNDS_MIN_Z && vecIn.fZ <= WORLD_BOUNDS_MAX_Z)
+	{
+		Write1();
+		WriteQuantized(vecIn.fX, WORLD_BOUNDS_MIN_XY, WORLD_BOUNDS_MAX_XY, POSITION_BITS_XY);
+		WriteQuantized(vecIn.fY, WORLD_BOUNDS_MIN_XY, WORLD_BOUNDS_MAX_XY, POSITION_BITS_XY);
+		WriteQuantized(vecIn.fZ, WORLD_BOUNDS_MIN_Z, WORLD_BOUNDS_MAX_Z, POSITION_BITS_Z);
+	}
+	else
+	{
+		Write0();
+		Write(vecIn);
+	}
+}
+
+void CBitStream::WriteQuaternion(const float * fQuaternion, unsigned int uiBits)
+{
+	// Find the largest component
+	unsigned char ucLargest = 0;
+
+	for(unsigned char i = 1; i < 4; i++)
+	{
+		if(fabs(fQuaternion[i]) > fabs(fQuaternion[ucLargest]))
+			ucLargest = i;
+	}
+
+	// q and -q are the same rotation so flip it to make the largest component positive,
+	// that way it can be rebuilt from the other three without a sign
+	float fSign = ((fQuaternion[ucLargest] < 0.0f) ? -1.0f : 1.0f);
+	WriteBits(&ucLargest, 2, true);
+
+	// The other three components are within -1/sqrt(2) and 1/sqrt(2)
+	for(unsigned char i = 0; i < 4; i++)
+	{
+		if(i != ucLargest)
+			WriteQuantized((fQuaternion[i] * fSign), -0.707107f, 0.707107f, uiBits);
+	}
+}
+
+bool CBitStream::ReadQuantized(float &fOut, float fMin, float fMax, unsigned int uiBits)
+{
+	unsigned int uiMax = ((uiBits >= 32) ? 0xFFFFFFFF : ((1U << uiBits) - 1));
+	unsigned int uiValue = 0;
+
+	if(!ReadBits((unsigned char *)&uiValue, uiBits, true))
+		return false;
+
+	fOut = (float)(fMin + (((double)uiValue / uiMax) * (fMax - fMin)));
+	return true;
+}
+
+bool CBitStream::ReadQuantized(CVector3 &vecOut, float fMin, float fMax, unsigned int uiBits)
+{
+	return (ReadQuantized(vecOut.fX, fMin, fMax, uiBits) &&
+		ReadQuantized(vecOut.fY, fMin, fMax, uiBits) &&
+		ReadQuantized(vecOut.fZ, fMin, fMax, uiBits));
+}
+
+bool CBitStream::ReadAngle(float &fOut)
+{
+	unsigned int uiValue = 0;
+
+	if(!ReadBits((unsigned char *)&uiValue, ANGLE_BITS, true))
+		return false;
+
+	fOut = (((float)uiValue / (1 << ANGLE_BITS)) * 360.0f);
+	return true;
+}
+
+bool CBitStream::ReadNormVector(CVector3 &vecOut)
+{
+	return ReadQuantized(vecOut, -1.0f, 1.0f, NORM_VECTOR_BITS);
+}
+
+bool CBitStream::ReadMagnitudeVector(CVector3 &vecOut)
+{
+	float fMagnitude;
+
+	if(!Read(fMagnitude))
+		return false;
+
+	if(fMagnitude > 0.00001f)
+	{
+		if(!ReadNormVector(vecOut))
+			return false;
+
+		vecOut = (vecOut * fMagnitude);
+	}
+	else
+		vecOut = CVector3();
+
+	return true;
+}
+
+bool CBitStream::ReadPosition(CVector3 &vecOut)
+{
+	// Is the position quantized?
+	if(!ReadBit())
+		return Read(vecOut);
+
+	return (ReadQuantized(vecOut.fX, WORLD_BOUNDS_MIN_XY, WORLD_BOUNDS_MAX_XY, POSITION_BITS_XY) &&
+		ReadQuantized(vecOut.fY, WORLD_BOUNDS_MIN_XY, WORLD_BOUNDS_MAX_XY, POSITION_BITS_XY) &&
+		ReadQuantized(vecOut.fZ, WORLD_BOUNDS_MIN_Z, WORLD_BOUNDS_MAX_Z, POSITION_BITS_Z));
+}
+
+bool CBitStream::ReadQuaternion(float * fQuaternion, unsigned int uiBits)
+{
+	unsigned char ucLargest = 0;
+
+	if(!ReadBits(&ucLargest, 2, true))
+		return false;
+
+	float fSum = 0.0f;
+
+	for(unsigned char i = 0; i < 4; i++)
+	{
+		if(i != ucLargest)
+		{
+			if(!ReadQuantized(fQuaternion[i], -0.707107f, 0.707107f, uiBits))
+				return false;
+
+			fSum += (fQuaternion[i] * fQuaternion[i]);
+		}
+	}
+
+	// Rebuild the largest component from the other three
+	fQuaternion[ucLargest] = ((fSum < 1.0f) ? sqrt(1.0f - fSum) : 0.0f);
+	return true;
+}
+
 void CBitStream::Write(const char * pIn, const unsigned int uiSizeInBytes)
 {
 	// Is the size we need to write 0?
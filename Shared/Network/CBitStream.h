@@ -36,8 +36,29 @@
 // Arbitrary size, just picking something likely to be larger than most packets
 #define BUFFER_STACK_ALLOCATION_SIZE 256
 
+// Bigger buffers come from a per thread pool of BUFFER_POOL_CLASSES size classes
+// (BUFFER_STACK_ALLOCATION_SIZE * 2 up to BUFFER_STACK_ALLOCATION_SIZE * 2 ^ BUFFER_POOL_CLASSES),
+// each thread keeps up to BUFFER_POOL_MAX_FREE freed buffers of each class
+#define BUFFER_POOL_CLASSES 8
+#define BUFFER_POOL_MAX_FREE 8
+
 #define MUL_OF_8(x) (((x) & 7) == 0)
 
+// World bounds used for quantized positions (positions outside of them are written raw)
+#define WORLD_BOUNDS_MIN_XY -8192.0f
+#define WORLD_BOUNDS_MAX_XY 8192.0f
+#define WORLD_BOUNDS_MIN_Z  -1024.0f
+#define WORLD_BOUNDS_MAX_Z  3072.0f
+
+// Precision of quantized positions (24 bits over 16384 units is ~1mm, 20 bits over 4096 units is ~4mm)
+#define POSITION_BITS_XY    24
+#define POSITION_BITS_Z     20
+
+// Precision of quantized angles, normalized vectors and quaternion components
+#define ANGLE_BITS          16
+#define NORM_VECTOR_BITS    16
+#define QUATERNION_BITS     15
+
 #define READ_TEMPLATE(size, out) \
 	/* Read from the buffer */ \
 	return ReadBits((unsigned char *)&out, (size * 8));
@@ -72,6 +93,13 @@ private:
 	// BitStreams that use less than BUFFER_STACK_ALLOCATION_SIZE use the stack, rather than the heap to store data.  It switches over if BUFFER_STACK_ALLOCATION_SIZE is exceeded
 	unsigned char   m_stackData[BUFFER_STACK_ALLOCATION_SIZE];
 
+	// Moves the data to a buffer of at least uiSizeInBytes
+	void                     Reallocate(unsigned int uiSizeInBytes);
+
+	// Gets a buffer of at least uiSizeInBytes from the pool of this thread (uiSizeInBytes is set to its real size)
+	static unsigned char   * AllocateBuffer(unsigned int& uiSizeInBytes);
+	static void              FreeBuffer(unsigned char * pBuffer, unsigned int uiSizeInBytes);
+
 public:
 	CBitStream();
 	CBitStream(const unsigned int uiSizeInBytes);
@@ -84,6 +112,9 @@ public:
 	// Reallocates (if necessary) in preparation of writing uiSizeInBits
 	void                     AddBitsAndReallocate(unsigned int uiSizeInBits);
 
+	// Makes sure uiSizeInBytes in total can be written without growing the buffer again
+	void                     Reserve(unsigned int uiSizeInBytes);
+
 	// Reset the BitStream read pointer for reuse.
 	void                     ResetReadPointer(void);
 
@@ -148,6 +179,48 @@ public:
 	bool                     ReadCompressed(float &fOut) { READ_COMPRESSED_TEMPLATE(sizeof(float), fOut); }
 	bool                     ReadCompressed(double &dOut) { READ_COMPRESSED_TEMPLATE(sizeof(double), dOut); }
 
+	// Write a float quantized to uiBits bits in the range fMin to fMax (values outside the range are clamped).
+	void                     WriteQuantized(float fIn, float fMin, float fMax, unsigned int uiBits);
+
+	// Write a vector quantized to uiBits bits per axis in the range fMin to fMax.
+	void                     WriteQuantized(const CVector3 &vecIn, float fMin, float fMax, unsigned int uiBits);
+
+	// Write an angle in degrees wrapped to 0 - 360 with ANGLE_BITS bits.
+	void                     WriteAngle(float fIn);
+
+	// Write a normalized vector (each axis -1 to 1) with NORM_VECTOR_BITS bits per axis.
+	void                     WriteNormVector(const CVector3 &vecIn);
+
+	// Write a vector as its magnitude and its normalized direction.
+	void                     WriteMagnitudeVector(const CVector3 &vecIn);
+
+	// Write a world position as fixed point relative to the world bounds.
+	void                     WritePosition(const CVector3 &vecIn);
+
+	// Write a quaternion (x, y, z, w) with smallest three compression.
+	void                     WriteQuaternion(const float * fQuaternion, unsigned int uiBits = QUATERNION_BITS);
+
+	// Read a float quantized to uiBits bits in the range fMin to fMax.
+	bool                     ReadQuantized(float &fOut, float fMin, float fMax, unsigned int uiBits);
+
+	// Read a vector quantized to uiBits bits per axis in the range fMin to fMax.
+	bool                     ReadQuantized(CVector3 &vecOut, float fMin, float fMax, unsigned int uiBits);
+
+	// Read an angle in degrees written with WriteAngle.
+	bool                     ReadAngle(float &fOut);
+
+	// Read a normalized vector written with WriteNormVector.
+	bool                     ReadNormVector(CVector3 &vecOut);
+
+	// Read a vector written with WriteMagnitudeVector.
+	bool                     ReadMagnitudeVector(CVector3 &vecOut);
+
+	// Read a world position written with WritePosition.
+	bool                     ReadPosition(CVector3 &vecOut);
+
+	// Read a quaternion written with WriteQuaternion.
+	bool                     ReadQuaternion(float * fQuaternion, unsigned int uiBits = QUATERNION_BITS);
+
 	// Write an array or casted stream or raw data to the BitStream.
 	void                     Write(const char * inputByteArray, const unsigned int numberOfBytes);
 
@@ -189,6 +262,9 @@ public:
 	// Returns the number of bytes used in the BitStream.
 	unsigned int             GetNumberOfBytesUsed() const { return BITS_TO_BYTES(m_uiWriteOffsetInBits); }
 
+	// Returns the current read offset (In bits)
+	unsigned int             GetReadOffset() const { return m_uiReadOffsetInBits; }
+
 	// Returns the number of unread bits left in the BitStream.
 	unsigned int             GetNumberOfUnreadBits() const { return (m_uiWriteOffsetInBits - m_uiReadOffsetInBits); }
 
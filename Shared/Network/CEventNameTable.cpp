@@ -0,0 +1,138 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEventNameTable.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CEventNameTable.h"
+
+extern CEvents * g_pEvents;
+
+CEventNameTable::CEventNameTable()
+{
+	Reset();
+}
+
+EventNameId CEventNameTable::GetId(const String& strName)
+{
+	std::map<String, EventNameId>::iterator iter = m_ids.find(strName);
+
+	if(iter != m_ids.end())
+		return (*iter).second;
+
+	if(m_names.size() >= MAX_EVENT_NAME_IDS)
+		return INLINE_EVENT_NAME_ID;
+
+	EventNameId nameId = (EventNameId)m_names.size();
+	m_ids.insert(std::pair<String, EventNameId>(strName, nameId));
+	m_names.push_back(strName);
+	return nameId;
+}
+
+bool CEventNameTable::WriteDefinition(EntityId peerId, EventNameId nameId, CBitStream * pBitStream)
+{
+	if(nameId == INLINE_EVENT_NAME_ID || nameId >= m_names.size())
+		return false;
+
+	if(peerId >= m_sent.size())
+		m_sent.resize(peerId + 1);
+
+	std::vector<bool>& sent = m_sent[peerId];
+
+	if(nameId < sent.size() && sent[nameId])
+		return false;
+
+	if(nameId >= sent.size())
+		sent.resize(nameId + 1, false);
+
+	sent[nameId] = true;
+	pBitStream->WriteCompressed(nameId);
+	pBitStream->Write(m_names[nameId]);
+	return true;
+}
+
+bool CEventNameTable::ReadDefinition(EntityId peerId, CBitStream * pBitStream)
+{
+	EventNameId nameId;
+	String strName;
+
+	if(!pBitStream->ReadCompressed(nameId) || !pBitStream->Read(strName) || nameId == INLINE_EVENT_NAME_ID)
+		return false;
+
+	if(peerId >= m_definitions.size())
+		m_definitions.resize(peerId + 1);
+
+	std::vector<Definition>& definitions = m_definitions[peerId];
+
+	if(nameId >= definitions.size())
+	{
+		Definition definition;
+		definition.eventId = INVALID_EVENT_ID;
+		definitions.resize(nameId + 1, definition);
+	}
+
+	// Names aren't interned here so a peer can't grow the event table
+	definitions[nameId].strName = strName;
+	definitions[nameId].eventId = g_pEvents->FindEventId(strName);
+	return true;
+}
+
+void CEventNameTable::WriteEvent(EventNameId nameId, const String& strName, CBitStream * pBitStream)
+{
+	pBitStream->WriteCompressed(nameId);
+
+	if(nameId == INLINE_EVENT_NAME_ID)
+		pBitStream->Write(strName);
+}
+
+EventId CEventNameTable::ReadEvent(EntityId peerId, CBitStream * pBitStream)
+{
+	EventNameId nameId;
+
+	if(!pBitStream->ReadCompressed(nameId))
+		return INVALID_EVENT_ID;
+
+	if(nameId == INLINE_EVENT_NAME_ID)
+	{
+		String strName;
+
+		if(!pBitStream->Read(strName))
+			return INVALID_EVENT_ID;
+
+		return g_pEvents->FindEventId(strName);
+	}
+
+	if(peerId >= m_definitions.size() || nameId >= m_definitions[peerId].size())
+		return INVALID_EVENT_ID;
+
+	Definition& definition = m_definitions[peerId][nameId];
+
+	// The event ids stay valid once an event is used, until then look it up again
+	if(definition.eventId == INVALID_EVENT_ID && definition.strName.IsNotEmpty())
+		definition.eventId = g_pEvents->FindEventId(definition.strName);
+
+	return definition.eventId;
+}
+
+void CEventNameTable::RemovePeer(EntityId peerId)
+{
+	if(peerId < m_sent.size())
+		m_sent[peerId].clear();
+
+	if(peerId < m_definitions.size())
+		m_definitions[peerId].clear();
+}
+
+void CEventNameTable::Reset()
+{
+	m_ids.clear();
+	m_names.clear();
+	m_sent.clear();
+	m_definitions.clear();
+
+	// Id 0 is INLINE_EVENT_NAME_ID
+	m_names.push_back(String());
+}
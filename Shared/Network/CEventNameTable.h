@@ -0,0 +1,65 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CEventNameTable.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <vector>
+#include <Common.h>
+#include <CString.h>
+#include <CEvents.h>
+#include "CBitStream.h"
+
+typedef unsigned short EventNameId;
+
+// Written in place of an id when the name follows it (once all ids are taken)
+#define INLINE_EVENT_NAME_ID 0
+
+#define MAX_EVENT_NAME_IDS 0xFFFF
+
+// Names of the script events sent with RPC_ScriptingEventCall. Each side gives
+// the names it sends an id and sends the definition of an id to a peer once per
+// session (RPC_ScriptingEventName) on the ordered script channel, the events after
+// it only carry the compressed id. The names a peer defined are resolved to their
+// event id so a received event is called without looking its name up.
+class CEventNameTable
+{
+private:
+	struct Definition
+	{
+		String  strName;
+		EventId eventId; // INVALID_EVENT_ID until the event is used on this side
+	};
+
+	std::map<String, EventNameId>         m_ids;
+	std::vector<String>                   m_names;       // By id
+	std::vector<std::vector<bool> >       m_sent;        // By peer then id, whether the peer has the definition
+	std::vector<std::vector<Definition> > m_definitions; // By peer then id
+
+public:
+	CEventNameTable();
+
+	// Returns the id of the name, INLINE_EVENT_NAME_ID once all ids are taken
+	EventNameId GetId(const String& strName);
+
+	// Writes the definition of the id if the peer doesn't have it yet, returns false if it does
+	bool        WriteDefinition(EntityId peerId, EventNameId nameId, CBitStream * pBitStream);
+	bool        ReadDefinition(EntityId peerId, CBitStream * pBitStream);
+
+	// Writes the header of an event, the arguments follow it
+	void        WriteEvent(EventNameId nameId, const String& strName, CBitStream * pBitStream);
+
+	// Returns the event of the header the peer sent, INVALID_EVENT_ID for an id it
+	// never defined or an event that has no handlers on this side
+	EventId     ReadEvent(EntityId peerId, CBitStream * pBitStream);
+
+	// Forgets the definitions sent to and received from the peer
+	void        RemovePeer(EntityId peerId);
+	void        Reset();
+};
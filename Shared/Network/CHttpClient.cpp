@@ -13,14 +13,22 @@
 #ifndef WIN32
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
 #define closesocket close
+#define Sleep(ms) usleep((ms) * 1000)
 #include <string.h>
 #else
 #include <winsock2.h>
 #include <winsock.h>
+#include <ws2tcpip.h>
 #endif
 #include <SharedUtility.h>
+#include <zlib-1.2.5/zlib.h>
 #include "CLogFile.h"
 // OS Independent Defines
 #define MAX_BUFFER 8192
@@ -28,18 +36,40 @@
 #define DEFAULT_USER_AGENT "IV: Multiplayer/1.0"
 #define DEFAULT_REFERER "http://iv-multiplayer.com"
 
+// Returns true if the last socket call failed only because it would have blocked
+static bool WouldBlock()
+{
+#ifdef WIN32
+	return (WSAGetLastError() == WSAEWOULDBLOCK);
+#else
+	return (errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS);
+#endif
+}
+
 CHttpClient::CHttpClient()
 	: m_iSocket(INVALID_SOCKET),
 	m_bConnected(false),
 	m_usPort(DEFAULT_PORT),
 	m_status(HTTP_STATUS_NONE),
+	m_iStatusCode(0),
 	m_lastError(HTTP_ERROR_NONE),
 	m_strUserAgent(DEFAULT_USER_AGENT),
 	m_strReferer(DEFAULT_REFERER),
 	m_uiRequestTimeout(30000),
+	m_uiConnectTimeout(10000),
 	m_uiRequestStart(0),
+	m_uiRequestSent(0),
+	m_bHasResponse(false),
+	m_bAcceptCompression(false),
+	m_pInflateStream(NULL),
+	m_bInflateDone(false),
 	m_pfnReceiveHandler(NULL),
-	m_pReceiveHandlerUserData(NULL)
+	m_pReceiveHandlerUserData(NULL),
+	m_bResolveDone(false),
+	m_bResolveSucceeded(false),
+	m_ulResolveAddress(0),
+	m_bResolving(false),
+	m_ulResolvedAddress(0)
 
 {
 	// If windows startup winsock
@@ -61,15 +91,128 @@ CHttpClient::CHttpClient()
 CHttpClient::~CHttpClient()
 {
 	// If we are connected to a host disconnect
-	if(m_bConnected)
+	if(m_bConnected || m_iSocket != INVALID_SOCKET)
 		Disconnect();
 
+	// The resolve thread uses our members so let it finish first
+	WaitForResolve();
+	EndInflate();
+
 	// If windows cleanup winsock
 #ifdef WIN32
 	WSACleanup();
 #endif
 }
 
+void CHttpClient::ResolveThread(CThread * pCreator)
+{
+	CHttpClient * pHttpClient = pCreator->GetUserData<CHttpClient *>();
+
+	// Resolve the host, this can take as long as the name servers need
+	addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo * pResult = NULL;
+	bool bSucceeded = (getaddrinfo(pHttpClient->m_strResolveHost.Get(), NULL, &hints, &pResult) == 0 && pResult);
+	unsigned long ulAddress = 0;
+
+	if(bSucceeded)
+	{
+		ulAddress = ((sockaddr_in *)pResult->ai_addr)->sin_addr.s_addr;
+		freeaddrinfo(pResult);
+	}
+
+	pHttpClient->m_resolveMutex.Lock();
+	pHttpClient->m_bResolveSucceeded = bSucceeded;
+	pHttpClient->m_ulResolveAddress = ulAddress;
+	pHttpClient->m_bResolveDone = true;
+	pHttpClient->m_resolveMutex.Unlock();
+}
+
+bool CHttpClient::CollectResolve()
+{
+	if(!m_bResolving)
+		return true;
+
+	m_resolveMutex.Lock();
+	bool bDone = m_bResolveDone;
+	bool bSucceeded = m_bResolveSucceeded;
+	unsigned long ulAddress = m_ulResolveAddress;
+	m_resolveMutex.Unlock();
+
+	if(!bDone)
+		return false;
+
+	// Remember the address so the next requests to the host don't resolve it again
+	m_bResolving = false;
+	m_strResolvedHost = (bSucceeded ? m_strResolveHost : "");
+	m_ulResolvedAddress = ulAddress;
+
+	// The thread is done with our members, wait for it to exit
+	m_resolveThread.Stop();
+	return true;
+}
+
+void CHttpClient::WaitForResolve()
+{
+	while(!CollectResolve())
+		Sleep(1);
+}
+
+bool CHttpClient::StartRequest(String strRequest, bool bHasResponse)
+{
+	// Drop any request still in progress
+	Reset();
+
+	// Reset the header and data
+	m_headerMap.clear();
+	m_iStatusCode = 0;
+	m_strData.Clear();
+
+	m_strRequest = strRequest;
+	m_uiRequestSent = 0;
+	m_bHasResponse = bHasResponse;
+	m_lastError = HTTP_ERROR_NONE;
+	m_status = HTTP_STATUS_RESOLVING;
+
+	// Set the request start
+	m_uiRequestStart = SharedUtility::GetTime();
+
+	// A resolve of another host can't be cancelled so wait for it, a resolve of
+	// this host that is still running (after a timeout) is used for this request
+	if(m_bResolving && m_strResolveHost != m_strHost)
+		WaitForResolve();
+
+	// Start resolving the host if we don't know its address
+	if(!m_bResolving && m_strResolvedHost != m_strHost)
+	{
+		m_strResolveHost = m_strHost;
+		m_bResolveDone = false;
+		m_bResolving = true;
+		m_resolveThread.SetUserData<CHttpClient *>(this);
+		m_resolveThread.Start(ResolveThread, false);
+	}
+
+	return ProcessResolve();
+}
+
+bool CHttpClient::ProcessResolve()
+{
+	// Is the host still being resolved?
+	if(!CollectResolve())
+		return true;
+
+	if(m_strResolvedHost != m_strHost)
+	{
+		// Failed to get the host, set the last error
+		Fail(HTTP_ERROR_INVALID_HOST);
+		return false;
+	}
+
+	return Connect();
+}
+
 bool CHttpClient::Connect()
 {
 	// Prepare the socket
@@ -78,17 +221,21 @@ bool CHttpClient::Connect()
 	if(m_iSocket == INVALID_SOCKET)
 	{
 		// Failed to prepare the socket, set the last error
-		m_lastError = HTTP_ERROR_SOCKET_PREPARE_FAILED;
+		Fail(HTTP_ERROR_SOCKET_PREPARE_FAILED);
 		return false;
 	}
 
-	// Get the host
-	hostent * heHost = gethostbyname(m_strHost.Get());
+	// Set the socket to non blocking
+#ifdef WIN32
+	u_long sockopt = 1;
 
-	if(heHost == NULL)
+	if(ioctlsocket(m_iSocket, FIONBIO, &sockopt) != 0)
+#else
+	if(fcntl(m_iSocket, F_SETFL, (fcntl(m_iSocket, F_GETFL, 0) | O_NONBLOCK)) < 0)
+#endif
 	{
-		// Failed to get the host, set the last error
-		m_lastError = HTTP_ERROR_INVALID_HOST;
+		// Failed to ioctl the socket, set the last error
+		Fail(HTTP_ERROR_IOCTL_FAILED);
 		return false;
 	}
 
@@ -96,33 +243,62 @@ bool CHttpClient::Connect()
 	sockaddr_in sinAddress;
 	sinAddress.sin_family = AF_INET;
 	sinAddress.sin_port = htons(m_usPort);
-	sinAddress.sin_addr = *((in_addr *)heHost->h_addr);
+	sinAddress.sin_addr.s_addr = m_ulResolvedAddress;
 	memset(&sinAddress.sin_zero, 0, (sizeof(char) * 8));
 
-	// Set the socket to non blocking
-	/*u_long sockopt = 1;
+	// Start connecting, Process checks when the connection is made
+	m_status = HTTP_STATUS_CONNECTING;
 
-	if(ioctlsocket(m_iSocket, FIONBIO, &sockopt) != 0)
-	{
-		// Failed to ioctl the socket, set the last error
-		m_lastError = HTTP_ERROR_IOCTL_FAILED;
-		return false;
-	}*/
-
-	// Try to connect
 	if(connect(m_iSocket, (sockaddr *)&sinAddress, sizeof(sockaddr)) < 0)
 	{
-		// Disconnect
-		Disconnect();
+		if(WouldBlock())
+			return true;
 
 		// Connection failed, set the last error
-		m_lastError = HTTP_ERROR_CONNECTION_FAILED;
+		Fail(HTTP_ERROR_CONNECTION_FAILED);
 		return false;
 	}
 
+	// Connected right away (usually only to local hosts)
+	m_bConnected = true;
+	m_status = HTTP_STATUS_SEND_DATA;
+	return Write();
+}
+
+void CHttpClient::ProcessConnect()
+{
+	// Check if the connect finished without waiting
+	fd_set writeSet;
+	fd_set exceptSet;
+	FD_ZERO(&writeSet);
+	FD_ZERO(&exceptSet);
+	FD_SET(m_iSocket, &writeSet);
+	FD_SET(m_iSocket, &exceptSet);
+	timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+
+	if(select((m_iSocket + 1), NULL, &writeSet, &exceptSet, &tv) <= 0)
+		return;
+
+	int iError = 0;
+#ifdef WIN32
+	int iErrorSize = sizeof(iError);
+#else
+	socklen_t iErrorSize = sizeof(iError);
+#endif
+
+	if(FD_ISSET(m_iSocket, &exceptSet) || getsockopt(m_iSocket, SOL_SOCKET, SO_ERROR, (char *)&iError, &iErrorSize) != 0 || iError != 0)
+	{
+		// Connection failed, set the last error
+		Fail(HTTP_ERROR_CONNECTION_FAILED);
+		return;
+	}
+
 	// Set the connected flag to true
 	m_bConnected = true;
-	return true;
+	m_status = HTTP_STATUS_SEND_DATA;
+	Write();
 }
 
 void CHttpClient::Disconnect()
@@ -141,14 +317,62 @@ void CHttpClient::Disconnect()
 	m_bConnected = false;
 }
 
-bool CHttpClient::Write(const char * szData, int iLen)
+void CHttpClient::Fail(eHttpError error)
 {
-	// Try to send
-	if(send(m_iSocket, szData, iLen, 0) < 0)
+	// Set the status to invalid
+	m_status = HTTP_STATUS_INVALID;
+
+	// Set the last error
+	m_lastError = error;
+
+	// Reset the request start
+	m_uiRequestStart = 0;
+
+	// The address may have changed, resolve it again with the next request
+	if(error == HTTP_ERROR_CONNECTION_FAILED || error == HTTP_ERROR_CONNECT_TIMEOUT)
+		m_strResolvedHost.Clear();
+
+	// Disconnect from the host
+	Disconnect();
+}
+
+bool CHttpClient::Write()
+{
+	// Send as much of the request as the socket takes
+	while(m_uiRequestSent < m_strRequest.GetLength())
 	{
-		// Send failed
-		m_lastError = HTTP_ERROR_SEND_FAILED;
-		return false;
+		int iBytesSent = send(m_iSocket, (m_strRequest.C_String() + m_uiRequestSent), (m_strRequest.GetLength() - m_uiRequestSent), 0);
+
+		if(iBytesSent < 0)
+		{
+			// Try again with the next process
+			if(WouldBlock())
+				return true;
+
+			// Send failed
+			Fail(HTTP_ERROR_SEND_FAILED);
+			return false;
+		}
+
+		m_uiRequestSent += iBytesSent;
+	}
+
+	// Do we have a response
+	if(m_bHasResponse)
+	{
+		// Set the status to get data
+		m_status = HTTP_STATUS_GET_DATA;
+	}
+	else
+	{
+		// Set the status to none
+		m_status = HTTP_STATUS_NONE;
+
+		// Reset the request start
+		m_uiRequestStart = 0;
+
+		// Disconnect from the host
+		Disconnect();
 	}
 
 	// Send success
@@ -157,35 +381,14 @@ bool CHttpClient::Write(const char * szData, int iLen)
 
 int CHttpClient::Read(char * szBuffer, int iLen)
 {
-	// HACK: Method for non blocking recv calls only
-	// Set the socket to non blocking
-#ifdef _LINUX
-	int flags = fcntl(m_iSocket, F_GETFL, 0);
-	UNSET_BIT(flags, O_NONBLOCK);
-	fcntl(m_iSocket, F_SETFL, flags);
-#else
-	u_long sockopt = 1;
-	ioctlsocket(m_iSocket, FIONBIO, &sockopt);
-#endif
-
-	// Try to receive
-	int iBytesRead = recv(m_iSocket, szBuffer, iLen, 0);
-
-	// Set the socket to blocking
-#ifdef _LINUX
-	SET_BIT(flags, O_NONBLOCK);
-	fcntl(m_iSocket, F_SETFL, flags);
-#else
-	sockopt = 0;
-	ioctlsocket(m_iSocket, FIONBIO, &sockopt);
-#endif
-	return iBytesRead;
+	// The socket is non blocking so this returns right away
+	return recv(m_iSocket, szBuffer, iLen, 0);
 }
 
 void CHttpClient::Reset()
 {
 	// Are we connected?
-	if(IsConnected())
+	if(m_iSocket != INVALID_SOCKET)
 	{
 		// Disconnect
 		Disconnect();
@@ -193,64 +396,52 @@ void CHttpClient::Reset()
 
 	// Set the status to none
 	m_status = HTTP_STATUS_NONE;
+
+	// Reset the request start
+	m_uiRequestStart = 0;
+	EndInflate();
 }
 
-bool CHttpClient::Get(String strPath)
+bool CHttpClient::Get(String strPath, unsigned int uiRangeStart)
 {
-	// Connect to the host
-	if(!Connect())
-	{
-		// Connect failed
-		return false;
-	}
+	// Prepare the range and encoding headers
+	String strRange;
 
-	// Reset the header and data
-	m_headerMap.clear();
-	m_strData.Clear();
+	if(uiRangeStart > 0)
+		strRange.Format("Range: bytes=%u-\r\n", uiRangeStart);
+
+	if(m_bAcceptCompression)
+		strRange.Append("Accept-Encoding: gzip\r\n");
 
 	// Prepare the GET command
 	String strGet("GET %s HTTP/1.0\r\n" \
 				  "Host: %s\r\n" \
 				  "User-Agent: %s\r\n" \
 				  "Referer: %s\r\n" \
+				  "%s" \
 				  "Connection: close\r\n" \
 				  "\r\n", 
 				  strPath.Get(), m_strHost.Get(), 
-				  m_strUserAgent.Get(), m_strReferer.Get());
+				  m_strUserAgent.Get(), m_strReferer.Get(),
+				  strRange.Get());
 
 	// Send the GET command
-	if(!Write(strGet.C_String(), strGet.GetLength()))
+	if(!StartRequest(strGet, true))
 	{
 		CLogFile::Printf("HTTP REQUEST FAILED!");
-		// Send failed
+		// Request failed
 		return false;
 	}
 
-	// Set the status to get data
-	m_status = HTTP_STATUS_GET_DATA;
-
-	// Set the request start
-	m_uiRequestStart = SharedUtility::GetTime();
 	return true;
 }
 
 bool CHttpClient::Post(bool bHasResponse, String strPath, String strData, String strContentType)
 {
-	// Connect to the host
-	if(!Connect())
-	{
-		// Connect failed
-		return false;
-	}
-
-	// Reset the header and data
-	m_headerMap.clear();
-	m_strData.Clear();
-
 	// Prepare the POST command
 	String strGet("POST %s HTTP/1.0\r\n" \
 				  "Host: %s\r\n" \
-				  "User-Agent: %s\r\n\r\n" \
+				  "User-Agent: %s\r\n" \
 				  "Referer: %s\r\n" \
 				  "Content-Type: %s\r\n" \
 				  "Content-Length: %d\r\n" \
@@ -262,29 +453,7 @@ bool CHttpClient::Post(bool bHasResponse, String strPath, String strData, String
 				  strData.Get());
 
 	// Send the POST command
-	if(!Write(strGet.C_String(), strGet.GetLength()))
-	{
-		// Send failed
-		return false;
-	}
-
-	// Do we have a response
-	if(bHasResponse)
-	{
-		// Set the status to get data
-		m_status = HTTP_STATUS_GET_DATA;
-
-		// Set the request start
-		m_uiRequestStart = SharedUtility::GetTime();
-	}
-	else
-	{
-		// Disconnect from the host
-		Disconnect();
-	}
-
-	return true;
-	
+	return StartRequest(strGet, bHasResponse);
 }
 #define ARRAY_SIZE(array) (sizeof(array) / sizeof(array[0]))
 
@@ -438,20 +607,115 @@ static int parse_http_response(char *buf, int len, struct mg_request_info *ri) {
   return result > 0 && !strncmp(ri->request_method, "HTTP/", 5) ? result : -1;
 }
 
+bool CHttpClient::StartInflate()
+{
+	EndInflate();
+	m_pInflateStream = new z_stream;
+	memset(m_pInflateStream, 0, sizeof(z_stream));
+	m_bInflateDone = false;
+
+	// 16 + MAX_WBITS makes zlib expect a gzip header
+	if(inflateInit2(m_pInflateStream, (16 + MAX_WBITS)) != Z_OK)
+	{
+		SAFE_DELETE(m_pInflateStream);
+		return false;
+	}
+
+	return true;
+}
+
+void CHttpClient::EndInflate()
+{
+	if(m_pInflateStream)
+	{
+		inflateEnd(m_pInflateStream);
+		SAFE_DELETE(m_pInflateStream);
+	}
+}
+
+bool CHttpClient::HandleData(char * szData, unsigned int uiDataSize)
+{
+	// Is the data not compressed?
+	if(!m_pInflateStream)
+	{
+		// Call the receive handler if we have one
+		bool bAppendData = true;
+
+		if(m_pfnReceiveHandler)
+			bAppendData = m_pfnReceiveHandler(szData, uiDataSize, m_pReceiveHandlerUserData);
+
+		// Append the buffer to the data if needed
+		if(bAppendData)
+			m_strData.Append(szData, uiDataSize);
+
+		return true;
+	}
+
+	// Ignore anything after the end of the compressed data
+	if(m_bInflateDone)
+		return true;
+
+	// Decompress the data in blocks and pass each block on like uncompressed data
+	char szInflated[MAX_BUFFER];
+	m_pInflateStream->next_in = (Bytef *)szData;
+	m_pInflateStream->avail_in = uiDataSize;
+
+	do
+	{
+		m_pInflateStream->next_out = (Bytef *)szInflated;
+		m_pInflateStream->avail_out = sizeof(szInflated);
+		int iResult = inflate(m_pInflateStream, Z_NO_FLUSH);
+
+		if(iResult != Z_OK && iResult != Z_STREAM_END && iResult != Z_BUF_ERROR)
+			return false;
+
+		unsigned int uiInflated = (sizeof(szInflated) - m_pInflateStream->avail_out);
+
+		if(uiInflated > 0)
+		{
+			bool bAppendData = true;
+
+			if(m_pfnReceiveHandler)
+				bAppendData = m_pfnReceiveHandler(szInflated, uiInflated, m_pReceiveHandlerUserData);
+
+			if(bAppendData)
+				m_strData.Append(szInflated, uiInflated);
+		}
+
+		if(iResult == Z_STREAM_END)
+		{
+			m_bInflateDone = true;
+			break;
+		}
+
+		// Does zlib need more input?
+		if(iResult == Z_BUF_ERROR)
+			break;
+	}
+	while(m_pInflateStream->avail_in > 0 || m_pInflateStream->avail_out == 0);
+
+	return true;
+}
+
 bool CHttpClient::ParseHeaders(String& strBuffer, int& iBufferSize)
 {
 	// Find the header size, testing code, but should work
 	mg_request_info info;
+	memset(&info, 0, sizeof(info));
 	
 	char* buf = new char[iBufferSize];
 	memcpy(buf, strBuffer.C_String(), iBufferSize);
 	parse_http_response(buf, strBuffer.GetLength(), &info);
+
+	// The status line is parsed like a request line, the status code is in the uri
+	m_iStatusCode = (info.uri != NULL ? atoi(info.uri) : 0);
 	
 	String buf_header;
 	int iHeaderSize = 0;
 	for(int i = 0; i < info.num_headers; ++i)
 	{
 		buf_header.AppendF("%s: %s\r\n", info.http_headers[i].name, info.http_headers[i].value);
+		m_headerMap[info.http_headers[i].name] = info.http_headers[i].value;
 	}
 
 	iHeaderSize = buf_header.GetLength();
@@ -459,6 +723,7 @@ bool CHttpClient::ParseHeaders(String& strBuffer, int& iBufferSize)
 	iBufferSize -= iHeaderSize;
 	strBuffer.Erase(0, iHeaderSize);
 	m_headerMap["HeaderSize"] = iHeaderSize;
+	delete [] buf;
 
 
 	// ADAMIX/JENKSTA: commented out this code because doesn't work properly. Are we really need to parse headers?
@@ -565,20 +830,24 @@ bool CHttpClient::ParseHeaders(String& strBuffer, int& iBufferSize)
 void CHttpClient::Process()
 {
 	// Do we have a request start and has the request timed out?
-	if(m_uiRequestStart > 0 && (SharedUtility::GetTime() - m_uiRequestStart) >= m_uiRequestTimeout)
+	if(m_uiRequestStart > 0)
 	{
-		// Set the status to none
-		m_status = HTTP_STATUS_NONE;
-
-		// Request timed out, set the last error
-		m_lastError = HTTP_ERROR_REQUEST_TIMEOUT;
+		unsigned int uiRequestTime = (SharedUtility::GetTime() - m_uiRequestStart);
 
-		// Reset the request start
-		m_uiRequestStart = 0;
+		if(uiRequestTime >= m_uiRequestTimeout)
+		{
+			// Request timed out, set the last error
+			Fail(HTTP_ERROR_REQUEST_TIMEOUT);
+			return;
+		}
 
-		// Disconnect from the host
-		Disconnect();
-		return;
+		// Has resolving the host and connecting to it timed out?
+		if((m_status == HTTP_STATUS_RESOLVING || m_status == HTTP_STATUS_CONNECTING) && uiRequestTime >= m_uiConnectTimeout)
+		{
+			// Connect timed out, set the last error
+			Fail(HTTP_ERROR_CONNECT_TIMEOUT);
+			return;
+		}
 	}
 
 	// Are we not in idle status?
@@ -586,6 +855,15 @@ void CHttpClient::Process()
 	{
 		switch(m_status)
 		{
+		case HTTP_STATUS_RESOLVING:
+			ProcessResolve();
+			break;
+		case HTTP_STATUS_CONNECTING:
+			ProcessConnect();
+			break;
+		case HTTP_STATUS_SEND_DATA:
+			Write();
+			break;
 		case HTTP_STATUS_GET_DATA:
 			{
 				// Prepare a buffer
@@ -612,40 +890,42 @@ void CHttpClient::Process()
 						// Parse the headers
 						if(!ParseHeaders(strBuffer, iBytesRecieved))
 						{
-							// We don't have a header, set the status
-							m_status = HTTP_STATUS_INVALID;
-
-							// Set the last error
-							m_lastError = HTTP_ERROR_NO_HEADER;
-
-							// Reset the request start
-							m_uiRequestStart = 0;
-
-							// Disconnect from the host
-							Disconnect();
+							// We don't have a header, set the last error
+							Fail(HTTP_ERROR_NO_HEADER);
 							return;
 						}
 
 						iSkipBytes -= iBytesRecieved;
 
+						// Is the response compressed?
+						if(m_headerMap["Content-Encoding"] == "gzip" && !StartInflate())
+						{
+							Fail(HTTP_ERROR_DECOMPRESS_FAILED);
+							return;
+						}
+
 						// Do we not have any data?
 						if(iBytesRecieved == 0)
 							return;
 					}
 
-					// Call the receive handler if we have one
-					bool bAppendData = true;
-
-					if(m_pfnReceiveHandler) {
-						bAppendData = m_pfnReceiveHandler(szBuffer + iSkipBytes, iBytesRecieved, m_pReceiveHandlerUserData);
+					if(!HandleData(szBuffer + iSkipBytes, iBytesRecieved))
+					{
+						Fail(HTTP_ERROR_DECOMPRESS_FAILED);
+						return;
 					}
-
-					// Append the buffer to the data if needed
-					if(bAppendData)
-						m_strData.Append(szBuffer + iSkipBytes, iBytesRecieved);
 				}
 				else if(iBytesRecieved == 0)
 				{
+					// Did the compressed data end early?
+					if(m_pInflateStream && !m_bInflateDone)
+					{
+						Fail(HTTP_ERROR_DECOMPRESS_FAILED);
+						return;
+					}
+
+					EndInflate();
+
 					// We got data, set the status
 					m_status = HTTP_STATUS_GOT_DATA;
 
@@ -655,6 +935,11 @@ void CHttpClient::Process()
 					// Disconnect from the host
 					Disconnect();
 				}
+				else if(!WouldBlock())
+				{
+					// The connection was lost, set the last error
+					Fail(HTTP_ERROR_CONNECTION_FAILED);
+				}
 			}
 
 			break;
@@ -689,6 +974,12 @@ String CHttpClient::GetLastErrorString()
 	case HTTP_ERROR_NO_HEADER:
 		strError.Set("No header");
 		break;
+	case HTTP_ERROR_CONNECT_TIMEOUT:
+		strError.Set("Connection timed out");
+		break;
+	case HTTP_ERROR_DECOMPRESS_FAILED:
+		strError.Set("Decompression failed");
+		break;
 	}
 
 	return strError;
@@ -11,6 +11,11 @@
 
 #include <CString.h>
 #include <map>
+#ifndef WIN32
+#include <pthread.h>
+#endif
+#include <Threading/CThread.h>
+#include <Threading/CMutex.h>
 
 // OS Independent Defines
 #define DEFAULT_CONTENT_TYPE "text/plain"
@@ -26,6 +31,9 @@ enum eHttpStatus
 {
 	HTTP_STATUS_NONE,
 	HTTP_STATUS_INVALID,
+	HTTP_STATUS_RESOLVING,
+	HTTP_STATUS_CONNECTING,
+	HTTP_STATUS_SEND_DATA,
 	HTTP_STATUS_GET_DATA,
 	HTTP_STATUS_GOT_DATA
 };
@@ -40,11 +48,17 @@ enum eHttpError
 	HTTP_ERROR_CONNECTION_FAILED,
 	HTTP_ERROR_SEND_FAILED,
 	HTTP_ERROR_REQUEST_TIMEOUT,
-	HTTP_ERROR_NO_HEADER
+	HTTP_ERROR_NO_HEADER,
+	HTTP_ERROR_CONNECT_TIMEOUT,
+	HTTP_ERROR_DECOMPRESS_FAILED
 };
 
+struct z_stream_s;
+
 typedef bool (* ReceieveHandler_t)(const char * szData, unsigned int uiDataSize, void * pUserData);
 
+// Http client that never blocks the calling thread, the host is resolved on a
+// thread and the connect, request and response are driven by Process
 class CHttpClient
 {
 private:
@@ -54,19 +68,46 @@ private:
 	unsigned short           m_usPort;
 	eHttpStatus              m_status;
 	std::map<String, String> m_headerMap;
+	int                      m_iStatusCode;
 	String                   m_strData;
 	eHttpError               m_lastError;
 	String                   m_strUserAgent;
 	String                   m_strReferer;
 	unsigned int             m_uiRequestTimeout;
+	unsigned int             m_uiConnectTimeout;
 	unsigned int             m_uiRequestStart;
+	String                   m_strRequest;
+	unsigned int             m_uiRequestSent;
+	bool                     m_bHasResponse;
+	bool                     m_bAcceptCompression;
+	z_stream_s             * m_pInflateStream; // Only set while a gzip response is received
+	bool                     m_bInflateDone;
 	ReceieveHandler_t        m_pfnReceiveHandler;
 	void                   * m_pReceiveHandlerUserData;
+	CThread                  m_resolveThread;
+	CMutex                   m_resolveMutex; // Mutex for m_bResolveDone, m_bResolveSucceeded and m_ulResolveAddress
+	bool                     m_bResolveDone;
+	bool                     m_bResolveSucceeded;
+	unsigned long            m_ulResolveAddress;
+	bool                     m_bResolving; // Only used by the main thread
+	String                   m_strResolveHost; // Only read by the resolve thread while resolving
+	String                   m_strResolvedHost;
+	unsigned long            m_ulResolvedAddress;
 
+	static void            ResolveThread(CThread * pCreator);
+	bool                   CollectResolve();
+	void                   WaitForResolve();
+	bool                   StartRequest(String strRequest, bool bHasResponse);
+	bool                   ProcessResolve();
 	bool                   Connect();
+	void                   ProcessConnect();
 	void                   Disconnect();
-	bool                   Write(const char * szData, int iLen);
+	void                   Fail(eHttpError error);
+	bool                   Write();
 	int                    Read(char * szBuffer, int iLen);
+	bool                   StartInflate();
+	void                   EndInflate();
+	bool                   HandleData(char * szData, unsigned int uiDataSize);
 	bool                   ParseHeaders(String& strBuffer, int& iBufferSize);
 
 public:
@@ -77,8 +118,9 @@ public:
 	virtual bool           IsInvalid() { return (m_status == HTTP_STATUS_INVALID); }
 	virtual bool           GettingData() { return (m_status == HTTP_STATUS_GET_DATA); }
 	virtual bool           GotData() { return (m_status == HTTP_STATUS_GOT_DATA); }
-	virtual bool           IsBusy() { return (m_status == HTTP_STATUS_GET_DATA); }
+	virtual bool           IsBusy() { return (m_status >= HTTP_STATUS_RESOLVING && m_status <= HTTP_STATUS_GET_DATA); }
 	virtual String         GetHeader(String strName) { return m_headerMap[strName]; }
+	virtual int            GetStatusCode() { return m_iStatusCode; }
 	virtual String       * GetData() { return &m_strData; }
 	virtual eHttpError     GetLastError() { return m_lastError; }
 	virtual void           SetUserAgent(String strUserAgent) { m_strUserAgent = strUserAgent; }
@@ -87,12 +129,23 @@ public:
 	virtual String         GetReferer() { return m_strReferer; }
 	virtual void           SetRequestTimeout(unsigned int uiRequestTimeout) { m_uiRequestTimeout = uiRequestTimeout; }
 	virtual unsigned int   GetRequestTimeout() { return m_uiRequestTimeout; }
+	virtual void           SetConnectTimeout(unsigned int uiConnectTimeout) { m_uiConnectTimeout = uiConnectTimeout; }
+	virtual unsigned int   GetConnectTimeout() { return m_uiConnectTimeout; }
+
+	// Asks for gzip compressed responses, the data is decompressed before it reaches the receive handler
+	virtual void           SetAcceptCompression(bool bAcceptCompression) { m_bAcceptCompression = bAcceptCompression; }
+	virtual bool           GetAcceptCompression() { return m_bAcceptCompression; }
 	virtual void           SetHost(String strHost) { m_strHost = strHost; }
 	virtual String         GetHost() { return m_strHost; }
 	virtual void           SetPort(unsigned short usPort) { m_usPort = usPort; }
 	virtual unsigned short GetPort() { return m_usPort; }
 	virtual void           Reset();
-	virtual bool           Get(String strPath);
+
+	// Start a request, false is only returned if it failed right away. Any
+	// later failure leaves the client invalid with the error set. A get with a
+	// range start only asks for the data from that offset on, the server
+	// replies with status code 206 if it sends just that part.
+	virtual bool           Get(String strPath, unsigned int uiRangeStart = 0);
 	virtual bool           Post(bool bHasResponse, String strPath, String strData = "", String strContentType = DEFAULT_CONTENT_TYPE);
 	virtual void           Process();
 	virtual String         GetLastErrorString();
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "CNetStats.h"
+#include "NetSimulator.h"
 #include "CPacket.h"
 #include "CBitStream.h"
 #include "PacketPriorities.h"
@@ -55,4 +56,10 @@ public:
 	virtual CNetStats              * GetNetStats() = 0;
 	virtual int                      GetLastPing() = 0;
 	virtual int                      GetAveragePing() = 0;
+	virtual void                     SetNetworkThreadEnabled(bool bEnabled) = 0;
+	// Time in ms Process spends on packets at most (0 for no limit), the rest is handled in the next Process
+	virtual void                     SetProcessTimeLimit(unsigned int uiMilliseconds) = 0;
+	// Simulates bad network conditions on the datagrams the client sends
+	virtual void                     SetNetSimulator(const NetSimulatorSettings& settings) = 0;
+	virtual void                     GetNetSimulatorStats(NetSimulatorStats * pStats) = 0;
 };
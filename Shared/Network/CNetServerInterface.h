@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include "CNetStats.h"
+#include "NetSimulator.h"
 #include "CPacket.h"
 #include "CBitStream.h"
 #include "PacketPriorities.h"
@@ -18,6 +20,14 @@
 
 typedef void (* PacketHandler_t)(CPacket * pPacket);
 
+// Called for each new connection with its address in network byte order (on the network
+// thread if it is enabled), the connection is rejected if it returns false
+typedef bool (* ConnectionFilter_t)(unsigned long ulBinaryAddress);
+
+// Amount of bytes a bit stream passed to RPCReserved must reserve at its start for the rpc header
+// (e.g. with PadWithZeroToByteLength(RPC_HEADER_SIZE) before writing the payload)
+#define RPC_HEADER_SIZE (sizeof(PacketId) + sizeof(RPCIdentifier))
+
 class CNetServerInterface
 {
 public:
@@ -28,12 +38,17 @@ public:
 	virtual void            Process() = 0;
 	virtual void            SetPassword(String strPassword) = 0;
 	virtual const char    * GetPassword() = 0;
+	// Reliable rpcs of at least this many bytes are compressed if that makes them smaller (0 to disable)
+	virtual void            SetCompressionThreshold(unsigned int uiBytes) = 0;
 	virtual unsigned int    Send(CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT) = 0;
 	virtual unsigned int    RPC(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT) = 0;
+	virtual unsigned int    RPCReserved(RPCIdentifier rpcId, CBitStream * pBitStream, ePacketPriority priority, ePacketReliability reliability, EntityId playerId, bool bBroadcast, char cOrderingChannel = PACKET_CHANNEL_DEFAULT) = 0;
+	virtual unsigned int    RPCReservedBatch(RPCIdentifier rpcId, CBitStream ** ppBitStreams, const EntityId * pPlayerIds, unsigned int uiCount, ePacketPriority priority, ePacketReliability reliability, char cOrderingChannel = PACKET_CHANNEL_DEFAULT) = 0;
 	virtual const char    * GetPlayerIp(EntityId playerId) = 0;
 	virtual unsigned short  GetPlayerPort(EntityId playerId) = 0;
 	virtual void            SetPacketHandler(PacketHandler_t pfnPacketHandler) = 0;
 	virtual PacketHandler_t GetPacketHandler() = 0;
+	virtual void            SetConnectionFilter(ConnectionFilter_t pfnConnectionFilter) = 0;
 	virtual const char    * GetPlayerSerial(EntityId playerId) = 0;
 	virtual void            KickPlayer(EntityId playerId, bool bSendDisconnectionNotification = true, ePacketPriority disconnectionPacketPriority = PRIORITY_LOW) = 0;
 	virtual CPlayerSocket * GetPlayerSocket(EntityId playerId) = 0;
@@ -42,4 +57,10 @@ public:
 	virtual void            UnbanIp(String strIpAddress) = 0;
 	virtual int             GetPlayerLastPing(EntityId playerId) = 0;
 	virtual int             GetPlayerAveragePing(EntityId playerId) = 0;
+	virtual CNetStats     * GetPlayerNetStats(EntityId playerId) = 0;
+	virtual void            SetNetworkThreadEnabled(bool bEnabled) = 0;
+	virtual bool            WaitForPackets(unsigned int uiTimeOutMilliseconds) = 0;
+	// Simulates bad network conditions on the datagrams the server sends
+	virtual void            SetNetSimulator(const NetSimulatorSettings& settings) = 0;
+	virtual void            GetNetSimulatorStats(NetSimulatorStats * pStats) = 0;
 };
@@ -18,6 +18,7 @@ GetNetServerInterface_t     CNetworkModule::m_pfnGetNetServerInterface;
 DestroyNetServerInterface_t CNetworkModule::m_pfnDestroyNetServerInterface;
 GetNetClientInterface_t     CNetworkModule::m_pfnGetNetClientInterface;
 DestroyNetClientInterface_t CNetworkModule::m_pfnDestroyNetClientInterface;
+GetMemoryCounter_t          CNetworkModule::m_pfnGetMemoryCounter;
 
 CNetworkModule::CNetworkModule()
 {
@@ -53,6 +54,7 @@ bool CNetworkModule::Init()
 	m_pfnDestroyNetServerInterface = (DestroyNetServerInterface_t)m_pLibrary->GetProcedureAddress("DestroyNetServerInterface");
 	m_pfnGetNetClientInterface = (GetNetClientInterface_t)m_pLibrary->GetProcedureAddress("GetNetClientInterface");
 	m_pfnDestroyNetClientInterface = (DestroyNetClientInterface_t)m_pLibrary->GetProcedureAddress("DestroyNetClientInterface");
+	m_pfnGetMemoryCounter = (GetMemoryCounter_t)m_pLibrary->GetProcedureAddress("GetMemoryCounter");
 
 	// Verify the pointers to the net module functions
 
@@ -76,6 +78,7 @@ void CNetworkModule::Shutdown()
 
 	// Delete the library instance
 	SAFE_DELETE(m_pLibrary);
+	m_pfnGetMemoryCounter = NULL;
 }
 
 bool CNetworkModule::VerifyVersion(unsigned char ucVersion)
@@ -120,3 +123,12 @@ void CNetworkModule::DestroyNetClientInterface(CNetClientInterface * pNetClient)
 	// Call the DestroyNetClientInterface function
 	m_pfnDestroyNetClientInterface(pNetClient);
 }
+
+MemoryCounter * CNetworkModule::GetMemoryCounter()
+{
+	// Older modules don't count their memory
+	if(!m_pfnGetMemoryCounter)
+		return NULL;
+
+	return m_pfnGetMemoryCounter();
+}
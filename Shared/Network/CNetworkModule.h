@@ -12,12 +12,14 @@
 #include "CNetServerInterface.h"
 #include "CNetClientInterface.h"
 #include <CLibrary.h>
+#include <CMemoryTracker.h>
 
 typedef bool                     (* VerifyVersion_t)(unsigned char ucVersion);
 typedef CNetServerInterface *    (* GetNetServerInterface_t)();
 typedef void                     (* DestroyNetServerInterface_t)(CNetServerInterface * pNetServer);
 typedef CNetClientInterface *    (* GetNetClientInterface_t)();
 typedef void                     (* DestroyNetClientInterface_t)(CNetClientInterface * pNetClient);
+typedef MemoryCounter *          (* GetMemoryCounter_t)();
 
 class CNetworkModule
 {
@@ -27,6 +29,7 @@ private:
 	static DestroyNetServerInterface_t m_pfnDestroyNetServerInterface;
 	static GetNetClientInterface_t     m_pfnGetNetClientInterface;
 	static DestroyNetClientInterface_t m_pfnDestroyNetClientInterface;
+	static GetMemoryCounter_t          m_pfnGetMemoryCounter;
 
 public:
 	CNetworkModule();
@@ -39,4 +42,7 @@ public:
 	static void                     DestroyNetServerInterface(CNetServerInterface * pNetServer);
 	static CNetClientInterface *    GetNetClientInterface();
 	static void                     DestroyNetClientInterface(CNetClientInterface * pNetClient);
+
+	// The memory counter of RakNet, NULL if the module doesn't count it
+	static MemoryCounter *          GetMemoryCounter();
 };
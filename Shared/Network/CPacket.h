@@ -29,6 +29,9 @@ public:
 	// The length of the packet in bytes
 	unsigned int uiLength;
 
-	// The data of the packet
+	// The data of the packet (points into pInternalPacket)
 	unsigned char * ucData;
+
+	// The network layer packet this packet wraps, it is freed along with this packet
+	void * pInternalPacket;
 };
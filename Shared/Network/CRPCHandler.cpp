@@ -9,71 +9,72 @@
 
 #include "CRPCHandler.h"
 #include "PacketIdentifiers.h"
+#include "../SharedUtility.h"
+#include "../CTraceRecorder.h"
 
 CRPCHandler::CRPCHandler()
 {
-
+	// Reset the dispatch table
+	memset(m_rpcFunctions, 0, sizeof(m_rpcFunctions));
+	m_bProfiling = false;
+	m_pfnProfileHook = NULL;
 }
 
 CRPCHandler::~CRPCHandler()
 {
-	std::list<RPCFunction *>::iterator iter;
-
-	for(iter = m_rpcFunctionList.begin(); iter != m_rpcFunctionList.end(); iter++)
+	for(int i = 0; i < MAX_RPC_IDENTIFIERS; i++)
 	{
-		delete (*iter);
+		if(m_rpcFunctions[i])
+			delete m_rpcFunctions[i];
 	}
 }
 
 void CRPCHandler::AddFunction(RPCIdentifier rpcId, RPCFunction_t rpcFunction)
 {
 	// Make sure it isn't already added
-	RPCFunction * pFunction = GetFunctionFromIdentifier(rpcId);
-
-	if(pFunction)
+	if(m_rpcFunctions[rpcId])
 	{
 		// Function already added
 		return;
 	}
 
 	// Create the rpc function
-	pFunction = new RPCFunction;
+	RPCFunction * pFunction = new RPCFunction;
 	pFunction->rpcId = rpcId;
 	pFunction->rpcFunction = rpcFunction;
+	pFunction->uiCalls = 0;
+	pFunction->ulTotalTime = 0;
 	
-	// Add it to the rpc function list
-	m_rpcFunctionList.push_back(pFunction);
+	// Add it to the dispatch table
+	m_rpcFunctions[rpcId] = pFunction;
 }
 
 void CRPCHandler::RemoveFunction(RPCIdentifier rpcId)
 {
 	// Get the function
-	RPCFunction * pFunction = GetFunctionFromIdentifier(rpcId);
+	RPCFunction * pFunction = m_rpcFunctions[rpcId];
 
 	// Is the function not added?
 	if(!pFunction)
 		return;
 
-	// Remove it from the rpc function list
-	m_rpcFunctionList.remove(pFunction);
+	// Remove it from the dispatch table
+	m_rpcFunctions[rpcId] = NULL;
 
 	// Delete it
 	delete pFunction;
 }
 
-RPCFunction * CRPCHandler::GetFunctionFromIdentifier(RPCIdentifier rpcId)
+void CRPCHandler::ResetProfileStats()
 {
-	// Iterate through all rpc functions
-	std::list<RPCFunction *>::iterator iter;
-	for(iter = m_rpcFunctionList.begin(); iter != m_rpcFunctionList.end(); iter++)
+	for(int i = 0; i < MAX_RPC_IDENTIFIERS; i++)
 	{
-		// Is this the function we're after?
-		if((*iter)->rpcId == rpcId)
-			return (*iter);
+		if(m_rpcFunctions[i])
+		{
+			m_rpcFunctions[i]->uiCalls = 0;
+			m_rpcFunctions[i]->ulTotalTime = 0;
+		}
 	}
-
-	// Function not found
-	return NULL;
 }
 
 bool CRPCHandler::HandlePacket(CPacket * pPacket)
@@ -88,13 +89,34 @@ bool CRPCHandler::HandlePacket(CPacket * pPacket)
 		// Read the rpc id
 		if(bitStream.Read(rpcId))
 		{
-			RPCFunction * pFunction = GetFunctionFromIdentifier(rpcId);
+			RPCFunction * pFunction = m_rpcFunctions[rpcId];
 
 			// Does the function exist?
 			if(pFunction)
 			{
-				// Call the function
-				pFunction->rpcFunction(&bitStream, pPacket->pPlayerSocket);
+				CTraceScope traceScope(TRACE_CATEGORY_RPC, "rpc", (int)rpcId);
+
+				// Are we profiling?
+				if(m_bProfiling)
+				{
+					unsigned long ulStartTime = SharedUtility::GetTime();
+
+					// Call the function
+					pFunction->rpcFunction(&bitStream, pPacket->pPlayerSocket);
+
+					unsigned long ulTime = (SharedUtility::GetTime() - ulStartTime);
+					pFunction->uiCalls++;
+					pFunction->ulTotalTime += ulTime;
+
+					if(m_pfnProfileHook)
+						m_pfnProfileHook(rpcId, ulTime);
+				}
+				else
+				{
+					// Call the function
+					pFunction->rpcFunction(&bitStream, pPacket->pPlayerSocket);
+				}
+
 				return true;
 			}
 		}
@@ -9,25 +9,34 @@
 
 #pragma once
 
-#include <list>
 #include "CBitStream.h"
 #include "CPlayerSocket.h"
 #include "RPCIdentifiers.h"
 #include "CPacket.h"
 
+// Amount of possible rpc identifiers
+#define MAX_RPC_IDENTIFIERS 256
+
 typedef void (* RPCFunction_t)(CBitStream * pBitStream, CPlayerSocket * pSenderSocket);
 
+// Called after every rpc function call while profiling is enabled
+typedef void (* RPCProfileHook_t)(RPCIdentifier rpcId, unsigned long ulTime);
+
 // Structure used for rpc functions
 struct RPCFunction
 {
 	RPCIdentifier rpcId;
 	RPCFunction_t rpcFunction;
+	unsigned int  uiCalls;
+	unsigned long ulTotalTime;
 };
 
 class CRPCHandler
 {
 private:
-	std::list<RPCFunction *> m_rpcFunctionList;
+	RPCFunction    * m_rpcFunctions[MAX_RPC_IDENTIFIERS];
+	bool             m_bProfiling;
+	RPCProfileHook_t m_pfnProfileHook;
 
 public:
 	CRPCHandler();
@@ -35,6 +44,10 @@ public:
 
 	void          AddFunction(RPCIdentifier rpcId, RPCFunction_t rpcFunction);
 	void          RemoveFunction(RPCIdentifier rpcId);
-	RPCFunction * GetFunctionFromIdentifier(RPCIdentifier rpcId);
+	RPCFunction * GetFunctionFromIdentifier(RPCIdentifier rpcId) { return m_rpcFunctions[rpcId]; }
 	bool          HandlePacket(CPacket * pPacket);
+	void          SetProfilingEnabled(bool bProfiling) { m_bProfiling = bProfiling; }
+	bool          IsProfilingEnabled() { return m_bProfiling; }
+	void          SetProfileHook(RPCProfileHook_t pfnProfileHook) { m_pfnProfileHook = pfnProfileHook; }
+	void          ResetProfileStats();
 };
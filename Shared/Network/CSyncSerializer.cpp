@@ -0,0 +1,662 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSyncSerializer.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CSyncSerializer.h"
+
+void CSyncSerializer::WriteVector(CBitStream * pBitStream, const CVector3& vecIn)
+{
+	// Most speed vectors are empty so only write them if they are not
+	if(!vecIn.IsEmpty())
+	{
+		pBitStream->Write1();
+		pBitStream->WriteMagnitudeVector(vecIn);
+	}
+	else
+		pBitStream->Write0();
+}
+
+bool CSyncSerializer::ReadVector(CBitStream * pBitStream, CVector3& vecOut)
+{
+	if(pBitStream->ReadBit())
+		return pBitStream->ReadMagnitudeVector(vecOut);
+
+	vecOut = CVector3();
+	return true;
+}
+
+void CSyncSerializer::WriteRotation(CBitStream * pBitStream, const CVector3& vecIn)
+{
+	pBitStream->WriteAngle(vecIn.fX);
+	pBitStream->WriteAngle(vecIn.fY);
+	pBitStream->WriteAngle(vecIn.fZ);
+}
+
+bool CSyncSerializer::ReadRotation(CBitStream * pBitStream, CVector3& vecOut)
+{
+	return (pBitStream->ReadAngle(vecOut.fX) && pBitStream->ReadAngle(vecOut.fY) && pBitStream->ReadAngle(vecOut.fZ));
+}
+
+void CSyncSerializer::WriteHealthArmour(CBitStream * pBitStream, unsigned int uHealthArmour)
+{
+	pBitStream->WriteCompressed((unsigned short)(uHealthArmour >> 16));
+	pBitStream->WriteCompressed((unsigned short)(uHealthArmour & 0xFFFF));
+}
+
+bool CSyncSerializer::ReadHealthArmour(CBitStream * pBitStream, unsigned int& uHealthArmour)
+{
+	unsigned short usHealth;
+	unsigned short usArmour;
+
+	if(!pBitStream->ReadCompressed(usHealth) || !pBitStream->ReadCompressed(usArmour))
+		return false;
+
+	uHealthArmour = ((usHealth << 16) | usArmour);
+	return true;
+}
+
+void CSyncSerializer::WriteWeaponInfo(CBitStream * pBitStream, unsigned int uWeaponInfo)
+{
+	// First 12 bits weapon, last 20 bits ammo
+	pBitStream->WriteCompressed((unsigned short)(uWeaponInfo >> 20));
+	pBitStream->WriteCompressed((unsigned int)(uWeaponInfo & 0xFFFFF));
+}
+
+bool CSyncSerializer::ReadWeaponInfo(CBitStream * pBitStream, unsigned int& uWeaponInfo)
+{
+	unsigned short usWeapon;
+	unsigned int uAmmo;
+
+	if(!pBitStream->ReadCompressed(usWeapon) || !pBitStream->ReadCompressed(uAmmo))
+		return false;
+
+	uWeaponInfo = ((usWeapon << 20) | (uAmmo & 0xFFFFF));
+	return true;
+}
+
+static unsigned int GetNameLength(const char * szName, unsigned int uiSize)
+{
+	const char * szEnd = (const char *)memchr(szName, 0, uiSize);
+	return (szEnd ? (unsigned int)(szEnd - szName) : uiSize);
+}
+
+unsigned int CSyncSerializer::GetMaxSize(const OnFootSyncData& syncPacket)
+{
+	// None of the fields are written bigger than they are in memory, the anim names are
+	// written as strings of their length instead and the flags take up to 2 more bytes
+	unsigned int uiSize = (sizeof(OnFootSyncData) - sizeof(syncPacket.szAnimGroup) - sizeof(syncPacket.szAnimSpecific) + 2);
+
+	if(syncPacket.bAnim)
+	{
+		uiSize += (2 * sizeof(size_t));
+		uiSize += GetNameLength(syncPacket.szAnimGroup, sizeof(syncPacket.szAnimGroup));
+		uiSize += GetNameLength(syncPacket.szAnimSpecific, sizeof(syncPacket.szAnimSpecific));
+	}
+
+	return uiSize;
+}
+
+void CSyncSerializer::Serialize(CBitStream * pBitStream, const OnFootSyncData& syncPacket, CSyncAnimState * pAnimState)
+{
+	pBitStream->Write(syncPacket.controlState);
+	pBitStream->WritePosition(syncPacket.vecPos);
+	pBitStream->Write(syncPacket.fHeading);
+	WriteVector(pBitStream, syncPacket.vecMoveSpeed);
+	WriteVector(pBitStream, syncPacket.vecTurnSpeed);
+	pBitStream->WriteBit(syncPacket.bDuckState);
+	WriteHealthArmour(pBitStream, syncPacket.uHealthArmour);
+	WriteWeaponInfo(pBitStream, syncPacket.uWeaponInfo);
+
+	// Do we have an anim and somewhere to intern it?
+	if(syncPacket.bAnim && pAnimState)
+	{
+		pBitStream->Write1();
+
+		// Has the anim changed?
+		bool bDefinition = false;
+
+		if(!pAnimState->bDefined || pAnimState->strGroup != syncPacket.szAnimGroup || pAnimState->strSpecific != syncPacket.szAnimSpecific)
+		{
+			pAnimState->strGroup = syncPacket.szAnimGroup;
+			pAnimState->strSpecific = syncPacket.szAnimSpecific;
+			pAnimState->ucAnimId++;
+			pAnimState->bDefined = true;
+			bDefinition = true;
+		}
+		else if(pAnimState->ucPacketsSinceDefinition >= SYNC_ANIM_DEFINITION_INTERVAL)
+			bDefinition = true;
+
+		pBitStream->Write(pAnimState->ucAnimId);
+		pBitStream->WriteBit(bDefinition);
+
+		if(bDefinition)
+		{
+			pBitStream->Write(pAnimState->strGroup);
+			pBitStream->Write(pAnimState->strSpecific);
+			pAnimState->ucPacketsSinceDefinition = 0;
+		}
+		else
+			pAnimState->ucPacketsSinceDefinition++;
+
+		pBitStream->Write(syncPacket.fAnimTime);
+	}
+	else
+		pBitStream->Write0();
+}
+
+bool CSyncSerializer::Deserialize(CBitStream * pBitStream, OnFootSyncData& syncPacket, CSyncAnimState * pAnimState)
+{
+	if(!pBitStream->Read(syncPacket.controlState))
+		return false;
+
+	if(!pBitStream->ReadPosition(syncPacket.vecPos))
+		return false;
+
+	if(!pBitStream->Read(syncPacket.fHeading))
+		return false;
+
+	if(!ReadVector(pBitStream, syncPacket.vecMoveSpeed) || !ReadVector(pBitStream, syncPacket.vecTurnSpeed))
+		return false;
+
+	syncPacket.bDuckState = pBitStream->ReadBit();
+
+	// Health and armour is a bit field so it has to be read into a temporary
+	unsigned int uHealthArmour;
+
+	if(!ReadHealthArmour(pBitStream, uHealthArmour))
+		return false;
+
+	syncPacket.uHealthArmour = uHealthArmour;
+
+	if(!ReadWeaponInfo(pBitStream, syncPacket.uWeaponInfo))
+		return false;
+
+	syncPacket.bAnim = false;
+	syncPacket.szAnimGroup[0] = '\0';
+	syncPacket.szAnimSpecific[0] = '\0';
+	syncPacket.fAnimTime = 0.0f;
+
+	// Do we have an anim?
+	if(pBitStream->ReadBit())
+	{
+		unsigned char ucAnimId;
+
+		if(!pBitStream->Read(ucAnimId))
+			return false;
+
+		// Do we have the anim names?
+		if(pBitStream->ReadBit())
+		{
+			String strGroup;
+			String strSpecific;
+
+			if(!pBitStream->Read(strGroup) || !pBitStream->Read(strSpecific))
+				return false;
+
+			if(pAnimState)
+			{
+				pAnimState->strGroup = strGroup;
+				pAnimState->strSpecific = strSpecific;
+				pAnimState->ucAnimId = ucAnimId;
+				pAnimState->bDefined = true;
+			}
+		}
+
+		if(!pBitStream->Read(syncPacket.fAnimTime))
+			return false;
+
+		// Only use the anim if we know its names (a definition may have been lost)
+		if(pAnimState && pAnimState->bDefined && pAnimState->ucAnimId == ucAnimId)
+		{
+			syncPacket.bAnim = true;
+			strncpy(syncPacket.szAnimGroup, pAnimState->strGroup.Get(), sizeof(syncPacket.szAnimGroup) - 1);
+			syncPacket.szAnimGroup[sizeof(syncPacket.szAnimGroup) - 1] = '\0';
+			strncpy(syncPacket.szAnimSpecific, pAnimState->strSpecific.Get(), sizeof(syncPacket.szAnimSpecific) - 1);
+			syncPacket.szAnimSpecific[sizeof(syncPacket.szAnimSpecific) - 1] = '\0';
+		}
+	}
+
+	return true;
+}
+
+void CSyncSerializer::Serialize(CBitStream * pBitStream, const InVehicleSyncData& syncPacket)
+{
+	pBitStream->Write(syncPacket.controlState);
+	pBitStream->WritePosition(syncPacket.vecPos);
+	WriteRotation(pBitStream, syncPacket.vecRotation);
+	pBitStream->WriteCompressed(syncPacket.uiHealth);
+	pBitStream->Write((char *)syncPacket.byteColors, sizeof(syncPacket.byteColors));
+	WriteVector(pBitStream, syncPacket.vecTurnSpeed);
+	WriteVector(pBitStream, syncPacket.vecMoveSpeed);
+	pBitStream->WriteBit(syncPacket.bEngineStatus);
+	pBitStream->WriteBit(syncPacket.hHazardLights);
+	pBitStream->WriteBit(syncPacket.bLights);
+	pBitStream->WriteBit(syncPacket.bTaxiLights);
+	pBitStream->WriteBit(syncPacket.bSirenState);
+	pBitStream->WriteBit(syncPacket.bGpsState);
+	pBitStream->Write(syncPacket.fPetrolHealth);
+	pBitStream->Write(syncPacket.fDirtLevel);
+	pBitStream->WriteQuaternion(syncPacket.fQuaternion);
+	WriteHealthArmour(pBitStream, syncPacket.uPlayerHealthArmour);
+	WriteWeaponInfo(pBitStream, syncPacket.uPlayerWeaponInfo);
+}
+
+bool CSyncSerializer::Deserialize(CBitStream * pBitStream, InVehicleSyncData& syncPacket)
+{
+	if(!pBitStream->Read(syncPacket.controlState))
+		return false;
+
+	if(!pBitStream->ReadPosition(syncPacket.vecPos) || !ReadRotation(pBitStream, syncPacket.vecRotation))
+		return false;
+
+	if(!pBitStream->ReadCompressed(syncPacket.uiHealth))
+		return false;
+
+	if(!pBitStream->Read((char *)syncPacket.byteColors, sizeof(syncPacket.byteColors)))
+		return false;
+
+	if(!ReadVector(pBitStream, syncPacket.vecTurnSpeed) || !ReadVector(pBitStream, syncPacket.vecMoveSpeed))
+		return false;
+
+	syncPacket.bEngineStatus = pBitStream->ReadBit();
+	syncPacket.hHazardLights = pBitStream->ReadBit();
+	syncPacket.bLights = pBitStream->ReadBit();
+	syncPacket.bTaxiLights = pBitStream->ReadBit();
+	syncPacket.bSirenState = pBitStream->ReadBit();
+	syncPacket.bGpsState = pBitStream->ReadBit();
+
+	if(!pBitStream->Read(syncPacket.fPetrolHealth) || !pBitStream->Read(syncPacket.fDirtLevel))
+		return false;
+
+	if(!pBitStream->ReadQuaternion(syncPacket.fQuaternion))
+		return false;
+
+	unsigned int uHealthArmour;
+
+	if(!ReadHealthArmour(pBitStream, uHealthArmour))
+		return false;
+
+	syncPacket.uPlayerHealthArmour = uHealthArmour;
+
+	return ReadWeaponInfo(pBitStream, syncPacket.uPlayerWeaponInfo);
+}
+
+void CSyncSerializer::Serialize(CBitStream * pBitStream, const PassengerSyncData& syncPacket)
+{
+	pBitStream->Write(syncPacket.controlState);
+	pBitStream->Write(syncPacket.byteSeatId);
+	WriteHealthArmour(pBitStream, syncPacket.uPlayerHealthArmour);
+	WriteWeaponInfo(pBitStream, syncPacket.uPlayerWeaponInfo);
+}
+
+bool CSyncSerializer::Deserialize(CBitStream * pBitStream, PassengerSyncData& syncPacket)
+{
+	if(!pBitStream->Read(syncPacket.controlState))
+		return false;
+
+	if(!pBitStream->Read(syncPacket.byteSeatId))
+		return false;
+
+	unsigned int uHealthArmour;
+
+	if(!ReadHealthArmour(pBitStream, uHealthArmour))
+		return false;
+
+	syncPacket.uPlayerHealthArmour = uHealthArmour;
+
+	return ReadWeaponInfo(pBitStream, syncPacket.uPlayerWeaponInfo);
+}
+
+void CSyncSerializer::Serialize(CBitStream * pBitStream, const SmallSyncData& syncPacket)
+{
+	pBitStream->Write(syncPacket.controlState);
+	pBitStream->WriteBit(syncPacket.bDuckState);
+	WriteWeaponInfo(pBitStream, syncPacket.uWeaponInfo);
+}
+
+bool CSyncSerializer::Deserialize(CBitStream * pBitStream, SmallSyncData& syncPacket)
+{
+	if(!pBitStream->Read(syncPacket.controlState))
+		return false;
+
+	syncPacket.bDuckState = pBitStream->ReadBit();
+	return ReadWeaponInfo(pBitStream, syncPacket.uWeaponInfo);
+}
+
+void CSyncSerializer::Serialize(CBitStream * pBitStream, const VehicleDamageSyncData& damage)
+{
+	pBitStream->WriteBits(&damage.ucWindows, 4);
+	pBitStream->WriteBits(&damage.ucTyres, 6);
+	pBitStream->WriteBits(&damage.ucDamagedDoors, 6);
+
+	// Most doors are closed so only write their ratio if they are not
+	for(int i = 0; i < 6; i++)
+	{
+		if(damage.ucDoors[i] != 0)
+		{
+			pBitStream->Write1();
+			pBitStream->Write(damage.ucDoors[i]);
+		}
+		else
+			pBitStream->Write0();
+	}
+
+	for(int i = 0; i < VEHICLE_DAMAGE_POINTS; i++)
+	{
+		if(damage.cDeformation[i][0] != 0 || damage.cDeformation[i][1] != 0 || damage.cDeformation[i][2] != 0)
+		{
+			pBitStream->Write1();
+			pBitStream->Write((const char *)damage.cDeformation[i], 3);
+		}
+		else
+			pBitStream->Write0();
+	}
+}
+
+bool CSyncSerializer::Deserialize(CBitStream * pBitStream, VehicleDamageSyncData& damage)
+{
+	memset(&damage, 0, sizeof(VehicleDamageSyncData));
+
+	if(!pBitStream->ReadBits(&damage.ucWindows, 4) || !pBitStream->ReadBits(&damage.ucTyres, 6) || !pBitStream->ReadBits(&damage.ucDamagedDoors, 6))
+		return false;
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(pBitStream->ReadBit() && !pBitStream->Read(damage.ucDoors[i]))
+			return false;
+	}
+
+	for(int i = 0; i < VEHICLE_DAMAGE_POINTS; i++)
+	{
+		if(pBitStream->ReadBit() && !pBitStream->Read((char *)damage.cDeformation[i], 3))
+			return false;
+	}
+
+	return true;
+}
+
+unsigned int CSyncSerializer::GetMaxLookSize()
+{
+	// The flags and every field unquantized
+	return (1 + (LOOK_SYNC_FIELD_BITS * (sizeof(CVector3) + 1)));
+}
+
+void CSyncSerializer::SerializeLook(CBitStream * pBitStream, const CVector3 * pvecHead, const AimSyncData * pAimSyncData, CSyncLookState * pLookState)
+{
+	pBitStream->WriteBit(pvecHead != NULL);
+	pBitStream->WriteBit(pAimSyncData != NULL);
+
+	if(!pvecHead && !pAimSyncData)
+		return;
+
+	const CVector3 * pFields[LOOK_SYNC_FIELD_BITS] = { pvecHead, NULL, NULL, NULL, NULL };
+
+	if(pAimSyncData)
+	{
+		pFields[1] = &pAimSyncData->vecAimTarget;
+		pFields[2] = &pAimSyncData->vecShotSource;
+		pFields[3] = &pAimSyncData->vecShotTarget;
+		pFields[4] = &pAimSyncData->vecLookAt;
+	}
+
+	// Without a look state every field is written
+	bool bRefresh = (!pLookState || pLookState->ucPacketsSinceRefresh >= SYNC_LOOK_REFRESH_INTERVAL);
+	unsigned char ucChanged = 0;
+
+	for(int i = 0; i < LOOK_SYNC_FIELD_BITS; i++)
+	{
+		if(pFields[i] && (bRefresh || !(pLookState->ucFields & (1 << i)) || (*pFields[i] - pLookState->vecFields[i]).Length() > SYNC_LOOK_MIN_CHANGE))
+			ucChanged |= (1 << i);
+	}
+
+	pBitStream->WriteBits(&ucChanged, LOOK_SYNC_FIELD_BITS);
+
+	for(int i = 0; i < LOOK_SYNC_FIELD_BITS; i++)
+	{
+		if(!(ucChanged & (1 << i)))
+			continue;
+
+		pBitStream->WritePosition(*pFields[i]);
+
+		if(pLookState)
+		{
+			pLookState->vecFields[i] = *pFields[i];
+			pLookState->ucFields |= (1 << i);
+		}
+	}
+
+	if(pLookState)
+		pLookState->ucPacketsSinceRefresh = (bRefresh ? 0 : (pLookState->ucPacketsSinceRefresh + 1));
+}
+
+bool CSyncSerializer::DeserializeLook(CBitStream * pBitStream, bool& bHasHead, CVector3& vecHead, bool& bHasAim, AimSyncData& aimSyncData, CSyncLookState * pLookState)
+{
+	bHasHead = pBitStream->ReadBit();
+	bHasAim = pBitStream->ReadBit();
+
+	if(!bHasHead && !bHasAim)
+		return true;
+
+	CVector3 * pFields[LOOK_SYNC_FIELD_BITS] = { &vecHead, &aimSyncData.vecAimTarget, &aimSyncData.vecShotSource, &aimSyncData.vecShotTarget, &aimSyncData.vecLookAt };
+	unsigned char ucPresent = ((bHasHead ? LOOK_SYNC_HEAD : 0) | (bHasAim ? LOOK_SYNC_AIM : 0));
+	unsigned char ucChanged = 0;
+	unsigned char ucKnown = 0;
+
+	if(!pBitStream->ReadBits(&ucChanged, LOOK_SYNC_FIELD_BITS))
+		return false;
+
+	for(int i = 0; i < LOOK_SYNC_FIELD_BITS; i++)
+	{
+		if(!(ucPresent & (1 << i)))
+			continue;
+
+		if(ucChanged & (1 << i))
+		{
+			if(!pBitStream->ReadPosition(*pFields[i]))
+				return false;
+
+			ucKnown |= (1 << i);
+
+			if(pLookState)
+			{
+				pLookState->vecFields[i] = *pFields[i];
+				pLookState->ucFields |= (1 << i);
+			}
+		}
+		else if(pLookState && (pLookState->ucFields & (1 << i)))
+		{
+			*pFields[i] = pLookState->vecFields[i];
+			ucKnown |= (1 << i);
+		}
+	}
+
+	// A field we never got a value of is unknown until the next refresh
+	bHasHead = ((ucKnown & LOOK_SYNC_HEAD) != 0);
+	bHasAim = (bHasAim && (ucKnown & LOOK_SYNC_AIM) == LOOK_SYNC_AIM);
+	return true;
+}
+
+unsigned short CSyncSerializer::GetChangedFields(const InVehicleSyncData& syncPacket, const InVehicleSyncData& baseline)
+{
+	unsigned short usFields = 0;
+
+	if(memcmp(&syncPacket.vecPos, &baseline.vecPos, sizeof(CVector3)))
+		usFields |= INVEHICLE_SYNC_POSITION;
+
+	if(memcmp(&syncPacket.vecRotation, &baseline.vecRotation, sizeof(CVector3)))
+		usFields |= INVEHICLE_SYNC_ROTATION;
+
+	if(syncPacket.uiHealth != baseline.uiHealth)
+		usFields |= INVEHICLE_SYNC_HEALTH;
+
+	if(memcmp(syncPacket.byteColors, baseline.byteColors, sizeof(syncPacket.byteColors)))
+		usFields |= INVEHICLE_SYNC_COLORS;
+
+	if(memcmp(&syncPacket.vecTurnSpeed, &baseline.vecTurnSpeed, sizeof(CVector3)))
+		usFields |= INVEHICLE_SYNC_TURN_SPEED;
+
+	if(memcmp(&syncPacket.vecMoveSpeed, &baseline.vecMoveSpeed, sizeof(CVector3)))
+		usFields |= INVEHICLE_SYNC_MOVE_SPEED;
+
+	if(syncPacket.bEngineStatus != baseline.bEngineStatus || syncPacket.hHazardLights != baseline.hHazardLights ||
+		syncPacket.bLights != baseline.bLights || syncPacket.bTaxiLights != baseline.bTaxiLights ||
+		syncPacket.bSirenState != baseline.bSirenState || syncPacket.bGpsState != baseline.bGpsState)
+		usFields |= INVEHICLE_SYNC_STATES;
+
+	if(syncPacket.fPetrolHealth != baseline.fPetrolHealth)
+		usFields |= INVEHICLE_SYNC_PETROL_HEALTH;
+
+	if(syncPacket.fDirtLevel != baseline.fDirtLevel)
+		usFields |= INVEHICLE_SYNC_DIRT_LEVEL;
+
+	if(memcmp(syncPacket.fQuaternion, baseline.fQuaternion, sizeof(syncPacket.fQuaternion)))
+		usFields |= INVEHICLE_SYNC_QUATERNION;
+
+	if(syncPacket.uPlayerHealthArmour != baseline.uPlayerHealthArmour)
+		usFields |= INVEHICLE_SYNC_PLAYER_HEALTH;
+
+	if(syncPacket.uPlayerWeaponInfo != baseline.uPlayerWeaponInfo)
+		usFields |= INVEHICLE_SYNC_PLAYER_WEAPON;
+
+	return usFields;
+}
+
+void CSyncSerializer::SerializeDelta(CBitStream * pBitStream, const InVehicleSyncData& syncPacket, const InVehicleSyncData * pBaseline)
+{
+	// Without a baseline every field has changed
+	unsigned short usFields = INVEHICLE_SYNC_ALL;
+
+	if(pBaseline)
+		usFields = GetChangedFields(syncPacket, *pBaseline);
+
+	pBitStream->WriteBits((unsigned char *)&usFields, INVEHICLE_SYNC_FIELD_BITS);
+
+	// The control state is always written as it is what drives the remote vehicle
+	pBitStream->Write(syncPacket.controlState);
+
+	if(usFields & INVEHICLE_SYNC_POSITION)
+		pBitStream->WritePosition(syncPacket.vecPos);
+
+	if(usFields & INVEHICLE_SYNC_ROTATION)
+		WriteRotation(pBitStream, syncPacket.vecRotation);
+
+	if(usFields & INVEHICLE_SYNC_HEALTH)
+		pBitStream->WriteCompressed(syncPacket.uiHealth);
+
+	if(usFields & INVEHICLE_SYNC_COLORS)
+		pBitStream->Write((char *)syncPacket.byteColors, sizeof(syncPacket.byteColors));
+
+	if(usFields & INVEHICLE_SYNC_TURN_SPEED)
+		WriteVector(pBitStream, syncPacket.vecTurnSpeed);
+
+	if(usFields & INVEHICLE_SYNC_MOVE_SPEED)
+		WriteVector(pBitStream, syncPacket.vecMoveSpeed);
+
+	if(usFields & INVEHICLE_SYNC_STATES)
+	{
+		pBitStream->WriteBit(syncPacket.bEngineStatus);
+		pBitStream->WriteBit(syncPacket.hHazardLights);
+		pBitStream->WriteBit(syncPacket.bLights);
+		pBitStream->WriteBit(syncPacket.bTaxiLights);
+		pBitStream->WriteBit(syncPacket.bSirenState);
+		pBitStream->WriteBit(syncPacket.bGpsState);
+	}
+
+	if(usFields & INVEHICLE_SYNC_PETROL_HEALTH)
+		pBitStream->Write(syncPacket.fPetrolHealth);
+
+	if(usFields & INVEHICLE_SYNC_DIRT_LEVEL)
+		pBitStream->Write(syncPacket.fDirtLevel);
+
+	if(usFields & INVEHICLE_SYNC_QUATERNION)
+		pBitStream->WriteQuaternion(syncPacket.fQuaternion);
+
+	if(usFields & INVEHICLE_SYNC_PLAYER_HEALTH)
+		WriteHealthArmour(pBitStream, syncPacket.uPlayerHealthArmour);
+
+	if(usFields & INVEHICLE_SYNC_PLAYER_WEAPON)
+		WriteWeaponInfo(pBitStream, syncPacket.uPlayerWeaponInfo);
+}
+
+bool CSyncSerializer::DeserializeDelta(CBitStream * pBitStream, InVehicleSyncData& syncPacket, const InVehicleSyncData * pBaseline)
+{
+	// Start from the baseline, the fields that changed are read over it
+	if(pBaseline)
+		memcpy(&syncPacket, pBaseline, sizeof(InVehicleSyncData));
+	else
+		memset(&syncPacket, 0, sizeof(InVehicleSyncData));
+
+	unsigned short usFields = 0;
+
+	if(!pBitStream->ReadBits((unsigned char *)&usFields, INVEHICLE_SYNC_FIELD_BITS))
+		return false;
+
+	// Without a baseline every field must be present
+	if(!pBaseline && usFields != INVEHICLE_SYNC_ALL)
+		return false;
+
+	if(!pBitStream->Read(syncPacket.controlState))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_POSITION) && !pBitStream->ReadPosition(syncPacket.vecPos))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_ROTATION) && !ReadRotation(pBitStream, syncPacket.vecRotation))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_HEALTH) && !pBitStream->ReadCompressed(syncPacket.uiHealth))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_COLORS) && !pBitStream->Read((char *)syncPacket.byteColors, sizeof(syncPacket.byteColors)))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_TURN_SPEED) && !ReadVector(pBitStream, syncPacket.vecTurnSpeed))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_MOVE_SPEED) && !ReadVector(pBitStream, syncPacket.vecMoveSpeed))
+		return false;
+
+	if(usFields & INVEHICLE_SYNC_STATES)
+	{
+		syncPacket.bEngineStatus = pBitStream->ReadBit();
+		syncPacket.hHazardLights = pBitStream->ReadBit();
+		syncPacket.bLights = pBitStream->ReadBit();
+		syncPacket.bTaxiLights = pBitStream->ReadBit();
+		syncPacket.bSirenState = pBitStream->ReadBit();
+		syncPacket.bGpsState = pBitStream->ReadBit();
+	}
+
+	if((usFields & INVEHICLE_SYNC_PETROL_HEALTH) && !pBitStream->Read(syncPacket.fPetrolHealth))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_DIRT_LEVEL) && !pBitStream->Read(syncPacket.fDirtLevel))
+		return false;
+
+	if((usFields & INVEHICLE_SYNC_QUATERNION) && !pBitStream->ReadQuaternion(syncPacket.fQuaternion))
+		return false;
+
+	unsigned int uValue;
+
+	if(usFields & INVEHICLE_SYNC_PLAYER_HEALTH)
+	{
+		if(!ReadHealthArmour(pBitStream, uValue))
+			return false;
+
+		syncPacket.uPlayerHealthArmour = uValue;
+	}
+
+	if(usFields & INVEHICLE_SYNC_PLAYER_WEAPON)
+	{
+		if(!ReadWeaponInfo(pBitStream, uValue))
+			return false;
+
+		syncPacket.uPlayerWeaponInfo = uValue;
+	}
+
+	return true;
+}
@@ -0,0 +1,194 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSyncSerializer.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "../Common.h"
+#include "CBitStream.h"
+
+// Sync serializer version - increment this (and NETWORK_VERSION) when the compact layout changes!
+#define SYNC_SERIALIZER_VERSION 4
+
+// Amount of sync packets after which the current anim names are sent again
+// (sync is unreliable so the first definition may never arrive)
+#define SYNC_ANIM_DEFINITION_INTERVAL 10
+
+// Interned anim state for a single sync stream. The anim names are only
+// written when they change (or every SYNC_ANIM_DEFINITION_INTERVAL packets),
+// every other packet just references them by id.
+class CSyncAnimState
+{
+public:
+	String        strGroup;
+	String        strSpecific;
+	unsigned char ucAnimId;
+	bool          bDefined;
+	unsigned char ucPacketsSinceDefinition;
+
+	CSyncAnimState()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		strGroup.Clear();
+		strSpecific.Clear();
+		ucAnimId = 0;
+		bDefined = false;
+		ucPacketsSinceDefinition = 0;
+	}
+};
+
+// Amount of sync packets after which every look field is written again even if
+// it didn't change (a lost packet may have had the last change)
+#define SYNC_LOOK_REFRESH_INTERVAL 10
+
+// Distance a look position has to move before it is written again
+#define SYNC_LOOK_MIN_CHANGE 0.05f
+
+// Look fields of a sync, the head is where the player looks and the others are the aim sync
+enum eLookSyncField
+{
+	LOOK_SYNC_HEAD        = (1 << 0),
+	LOOK_SYNC_AIM_TARGET  = (1 << 1),
+	LOOK_SYNC_SHOT_SOURCE = (1 << 2),
+	LOOK_SYNC_SHOT_TARGET = (1 << 3),
+	LOOK_SYNC_AIM_LOOK_AT = (1 << 4),
+	LOOK_SYNC_FIELD_BITS  = 5,
+	LOOK_SYNC_AIM         = (LOOK_SYNC_AIM_TARGET | LOOK_SYNC_SHOT_SOURCE | LOOK_SYNC_SHOT_TARGET | LOOK_SYNC_AIM_LOOK_AT)
+};
+
+// Last look fields of a single sync stream. A field is only written when it moved
+// (or every SYNC_LOOK_REFRESH_INTERVAL packets), otherwise the reader uses the
+// value it has.
+class CSyncLookState
+{
+public:
+	CVector3      vecFields[LOOK_SYNC_FIELD_BITS];
+	unsigned char ucFields; // Fields that have a value
+	unsigned char ucPacketsSinceRefresh;
+
+	CSyncLookState()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		ucFields = 0;
+		ucPacketsSinceRefresh = 0;
+	}
+};
+
+// Amount of in vehicle snapshots kept as delta baselines (the sequence is a
+// byte so this must be a power of 2 less than 256)
+#define SYNC_SNAPSHOT_HISTORY 32
+
+// Interval in ms at which received in vehicle snapshots are acknowledged
+#define SYNC_ACK_INTERVAL 100
+
+// Changed field bits of a delta compressed in vehicle sync
+enum eInVehicleSyncField
+{
+	INVEHICLE_SYNC_POSITION       = (1 << 0),
+	INVEHICLE_SYNC_ROTATION       = (1 << 1),
+	INVEHICLE_SYNC_HEALTH         = (1 << 2),
+	INVEHICLE_SYNC_COLORS         = (1 << 3),
+	INVEHICLE_SYNC_TURN_SPEED     = (1 << 4),
+	INVEHICLE_SYNC_MOVE_SPEED     = (1 << 5),
+	INVEHICLE_SYNC_STATES         = (1 << 6),
+	INVEHICLE_SYNC_PETROL_HEALTH  = (1 << 7),
+	INVEHICLE_SYNC_DIRT_LEVEL     = (1 << 8),
+	INVEHICLE_SYNC_QUATERNION     = (1 << 9),
+	INVEHICLE_SYNC_PLAYER_HEALTH  = (1 << 10),
+	INVEHICLE_SYNC_PLAYER_WEAPON  = (1 << 11),
+	INVEHICLE_SYNC_FIELD_BITS     = 12,
+	INVEHICLE_SYNC_ALL            = ((1 << INVEHICLE_SYNC_FIELD_BITS) - 1),
+
+	// The fields that are extrapolated between syncs
+	INVEHICLE_SYNC_MOVEMENT       = (INVEHICLE_SYNC_POSITION | INVEHICLE_SYNC_ROTATION | INVEHICLE_SYNC_TURN_SPEED | INVEHICLE_SYNC_MOVE_SPEED | INVEHICLE_SYNC_QUATERNION)
+};
+
+// Ring of the last SYNC_SNAPSHOT_HISTORY in vehicle snapshots of a single
+// sync stream indexed by their sequence
+class CSyncSnapshotHistory
+{
+private:
+	InVehicleSyncData m_snapshots[SYNC_SNAPSHOT_HISTORY];
+	unsigned char     m_ucSequences[SYNC_SNAPSHOT_HISTORY];
+	bool              m_bValid[SYNC_SNAPSHOT_HISTORY];
+
+public:
+	CSyncSnapshotHistory()
+	{
+		Reset();
+	}
+
+	void Reset()
+	{
+		memset(m_bValid, 0, sizeof(m_bValid));
+	}
+
+	void Store(unsigned char ucSequence, const InVehicleSyncData& syncPacket)
+	{
+		unsigned char ucIndex = (ucSequence % SYNC_SNAPSHOT_HISTORY);
+		memcpy(&m_snapshots[ucIndex], &syncPacket, sizeof(InVehicleSyncData));
+		m_ucSequences[ucIndex] = ucSequence;
+		m_bValid[ucIndex] = true;
+	}
+
+	const InVehicleSyncData * Get(unsigned char ucSequence)
+	{
+		unsigned char ucIndex = (ucSequence % SYNC_SNAPSHOT_HISTORY);
+
+		if(!m_bValid[ucIndex] || m_ucSequences[ucIndex] != ucSequence)
+			return NULL;
+
+		return &m_snapshots[ucIndex];
+	}
+};
+
+class CSyncSerializer
+{
+private:
+	static void WriteVector(CBitStream * pBitStream, const CVector3& vecIn);
+	static bool ReadVector(CBitStream * pBitStream, CVector3& vecOut);
+	static void WriteRotation(CBitStream * pBitStream, const CVector3& vecIn);
+	static bool ReadRotation(CBitStream * pBitStream, CVector3& vecOut);
+	static void WriteHealthArmour(CBitStream * pBitStream, unsigned int uHealthArmour);
+	static bool ReadHealthArmour(CBitStream * pBitStream, unsigned int& uHealthArmour);
+	static void WriteWeaponInfo(CBitStream * pBitStream, unsigned int uWeaponInfo);
+	static bool ReadWeaponInfo(CBitStream * pBitStream, unsigned int& uWeaponInfo);
+
+public:
+	// Returns the eInVehicleSyncField bits of the fields that differ from the baseline
+	static unsigned short GetChangedFields(const InVehicleSyncData& syncPacket, const InVehicleSyncData& baseline);
+	// Returns the most bytes Serialize can write for the sync (so the stream can be reserved up front)
+	static unsigned int GetMaxSize(const OnFootSyncData& syncPacket);
+	static void Serialize(CBitStream * pBitStream, const OnFootSyncData& syncPacket, CSyncAnimState * pAnimState);
+	static bool Deserialize(CBitStream * pBitStream, OnFootSyncData& syncPacket, CSyncAnimState * pAnimState);
+	static void Serialize(CBitStream * pBitStream, const InVehicleSyncData& syncPacket);
+	static bool Deserialize(CBitStream * pBitStream, InVehicleSyncData& syncPacket);
+	static void SerializeDelta(CBitStream * pBitStream, const InVehicleSyncData& syncPacket, const InVehicleSyncData * pBaseline);
+	static bool DeserializeDelta(CBitStream * pBitStream, InVehicleSyncData& syncPacket, const InVehicleSyncData * pBaseline);
+	static void Serialize(CBitStream * pBitStream, const PassengerSyncData& syncPacket);
+	static bool Deserialize(CBitStream * pBitStream, PassengerSyncData& syncPacket);
+	static void Serialize(CBitStream * pBitStream, const SmallSyncData& syncPacket);
+	static bool Deserialize(CBitStream * pBitStream, SmallSyncData& syncPacket);
+	// Only the doors that are open and the hull points that are deformed are written
+	static void Serialize(CBitStream * pBitStream, const VehicleDamageSyncData& damage);
+	static bool Deserialize(CBitStream * pBitStream, VehicleDamageSyncData& damage);
+	// Returns the most bytes SerializeLook can write
+	static unsigned int GetMaxLookSize();
+	// Writes the head and aim of a player (either can be NULL), only the fields that
+	// changed since the last packet of the look state are written
+	static void SerializeLook(CBitStream * pBitStream, const CVector3 * pvecHead, const AimSyncData * pAimSyncData, CSyncLookState * pLookState);
+	static bool DeserializeLook(CBitStream * pBitStream, bool& bHasHead, CVector3& vecHead, bool& bHasAim, AimSyncData& aimSyncData, CSyncLookState * pLookState);
+};
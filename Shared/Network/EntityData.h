@@ -0,0 +1,30 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: EntityData.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+// Entities that can have data attached
+enum eEntityDataType
+{
+	ENTITY_DATA_PLAYER,
+	ENTITY_DATA_VEHICLE,
+	ENTITY_DATA_OBJECT,
+	ENTITY_DATA_TYPE_MAX
+};
+
+// Operations in an RPC_EntityData message, each one starts with the operation,
+// the entity type and the compressed entity id:
+// SET is followed by the key and the value, REMOVE by the key and CLEAR removes
+// all data of the entity
+enum eEntityDataOperation
+{
+	ENTITY_DATA_OPERATION_SET,
+	ENTITY_DATA_OPERATION_REMOVE,
+	ENTITY_DATA_OPERATION_CLEAR
+};
@@ -0,0 +1,59 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: NetSimulator.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+// Conditions the network simulator applies to the datagrams a peer sends, the
+// other direction is simulated by the peer on the other end
+struct NetSimulatorSettings
+{
+	unsigned int uiLatency;   // Time in ms every datagram is delayed
+	unsigned int uiJitter;    // Time in ms of random extra delay (the order is kept)
+	float        fLoss;       // Chance in percent a datagram is dropped
+	float        fReorder;    // Chance in percent a datagram is held back so later ones overtake it
+	float        fDuplicate;  // Chance in percent a datagram is sent twice
+	unsigned int uiBandwidth; // Bytes per second the link can send (0 for no limit)
+
+	NetSimulatorSettings()
+		: uiLatency(0),
+		uiJitter(0),
+		fLoss(0.0f),
+		fReorder(0.0f),
+		fDuplicate(0.0f),
+		uiBandwidth(0)
+	{
+	}
+
+	bool IsActive() const
+	{
+		return (uiLatency > 0 || uiJitter > 0 || fLoss > 0.0f || fReorder > 0.0f || fDuplicate > 0.0f || uiBandwidth > 0);
+	}
+};
+
+struct NetSimulatorStats
+{
+	unsigned long ulDatagrams;  // Datagrams given to the simulator
+	unsigned long ulBytes;      // Bytes of those datagrams
+	unsigned long ulLost;       // Dropped by the loss chance
+	unsigned long ulOverflowed; // Dropped because the bandwidth limited link was full
+	unsigned long ulReordered;
+	unsigned long ulDuplicated;
+	unsigned int  uiQueued;     // Datagrams waiting to be sent right now
+
+	NetSimulatorStats()
+		: ulDatagrams(0),
+		ulBytes(0),
+		ulLost(0),
+		ulOverflowed(0),
+		ulReordered(0),
+		ulDuplicated(0),
+		uiQueued(0)
+	{
+	}
+};
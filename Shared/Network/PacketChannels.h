@@ -9,9 +9,12 @@
 
 #pragma once
 
+// Reliable ordered packets are only ordered against the packets of the same
+// channel, so a packet lost on one channel doesn't hold up the others
 enum ePacketChannels
 {
-	// Default packet channel
+	// Default packet channel, used for the world state (entities and the scripting
+	// calls that change them as they have to arrive after the entity was created)
 	PACKET_CHANNEL_DEFAULT,
 
 	// Packet channel used for input
@@ -20,6 +23,15 @@ enum ePacketChannels
 	// Packet channel used for script
 	PACKET_CHANNEL_SCRIPT,
 
+	// Packet channel used for chat messages and commands
+	PACKET_CHANNEL_CHAT,
+
+	// Packet channel used for the client file list
+	PACKET_CHANNEL_FILES,
+
+	// Packet channel used for text, hud and screen effects that don't refer to entities
+	PACKET_CHANNEL_GUI,
+
 	// Number of packet channels
 	PACKET_CHANNEL_COUNT
 };
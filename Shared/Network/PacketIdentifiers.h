@@ -46,6 +46,10 @@ enum ePacketIdentfiers
 	// Remote procedure call
 	PACKET_RPC,
 
+	// Remote procedure call with the rpc identifier and data compressed, it is
+	// handed to the packet handler as PACKET_RPC once decompressed
+	PACKET_RPC_COMPRESSED,
+
 	// Number of packet identifiers
 	PACKET_COUNT
 };
@@ -47,7 +47,6 @@ enum eRPCIdentfiers
 	RPC_CheckpointLeft,
 	RPC_Death,
 	RPC_VehicleEnterExit,
-	RPC_HeadMovement,
 	RPC_CheckpointEntered,
 	RPC_NameChange,
 	RPC_NewFile,
@@ -188,7 +187,25 @@ enum eRPCIdentfiers
 	RPC_ResetVehicleEnterExit,
 	RPC_ScriptingTogglePlayerLabelForPlayer,
 	RPC_ScriptingMoveObject,
-	RPC_ScriptingRotateObject,
 	RPC_ScriptingSetObjectDimension,
 	RPC_ScriptingSetCheckpointDimension,
+	RPC_InVehicleSyncAck,
+	RPC_SyncSnapshot,
+	RPC_SyncRate,
+	RPC_JoinProgress,
+	RPC_CommandBatch,
+	RPC_VehicleSyncOwner,
+	RPC_NewFilePack,
+	RPC_EntityData,
+	RPC_ScriptingEventName,
+	RPC_PlayerShot,
+	RPC_UpdateCheckpoint,
+	RPC_ScriptingSetActorPath,
+	RPC_ActorPathCorrection,
+	RPC_ScriptingSetBlipPosition,
+	RPC_AttachedBlipPositions,
+	RPC_VehicleDamageSync,
+	RPC_PlayerTransfer,
+	RPC_BusMessage,
+	RPC_InputAction,
 };
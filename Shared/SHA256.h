@@ -108,7 +108,11 @@ using namespace std;
    ======== */
  
 typedef unsigned char          byte;
+#ifdef WIN32
 typedef unsigned __int32       word;
+#else
+typedef uint32_t               word;
+#endif
 typedef unsigned long long int longword;
    
    
@@ -0,0 +1,307 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptAllocator.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+#include "CScriptAllocator.h"
+
+#ifdef _LINUX
+#include <pthread.h>
+#endif
+
+// Every block starts with this, the size keeps the alignment of malloc
+#define SCRIPT_ALLOCATION_HEADER_SIZE 16
+
+struct ScriptAllocationHeader
+{
+	size_t       sSize;
+	unsigned int uiSlot;
+};
+
+typedef char ScriptAllocationHeaderFits[(sizeof(ScriptAllocationHeader) <= SCRIPT_ALLOCATION_HEADER_SIZE) ? 1 : -1];
+
+// A free block of a pool, stored in the block itself
+struct ScriptFreeBlock
+{
+	ScriptFreeBlock * pNext;
+};
+
+// The pools and the current script of a single thread, only that thread
+// uses them. Blocks go back to the pool of the thread that frees them.
+struct ScriptAllocatorCache
+{
+	ScriptFreeBlock * pFreeBlocks[SCRIPT_ALLOCATOR_SIZE_CLASSES];
+	unsigned int      uiCurrentScript;
+	long              lUncountedBytes; // Change of the memory of the current script that isn't counted yet
+};
+
+size_t        CScriptAllocator::m_sMemoryLimit = 0;
+volatile long CScriptAllocator::m_lScriptsOverLimit = 0;
+
+static volatile long g_lScriptOverLimit[MEMORY_TRACKER_MAX_SCRIPTS];
+
+#ifdef WIN32
+static volatile long g_lAllocatorCacheSlot = (long)TLS_OUT_OF_INDEXES;
+#else
+static pthread_once_t g_allocatorCacheOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t  g_allocatorCacheKey;
+static bool           g_bAllocatorCacheKeyCreated = false;
+
+static void CreateAllocatorCacheKey()
+{
+	g_bAllocatorCacheKeyCreated = (pthread_key_create(&g_allocatorCacheKey, NULL) == 0);
+}
+#endif
+
+// Returns the pools of the calling thread, NULL if it can't get them (it uses the heap then)
+static ScriptAllocatorCache * GetAllocatorCache()
+{
+	ScriptAllocatorCache * pCache = NULL;
+#ifdef WIN32
+	DWORD dwSlot = (DWORD)CAtomic::Get(&g_lAllocatorCacheSlot);
+
+	if(dwSlot == TLS_OUT_OF_INDEXES)
+	{
+		DWORD dwNewSlot = TlsAlloc();
+
+		if(dwNewSlot == TLS_OUT_OF_INDEXES)
+			return NULL;
+
+		// Another thread can allocate the slot at the same time, only one of them is kept
+		dwSlot = (DWORD)CAtomic::CompareExchange(&g_lAllocatorCacheSlot, (long)dwNewSlot, (long)TLS_OUT_OF_INDEXES);
+
+		if(dwSlot == TLS_OUT_OF_INDEXES)
+			dwSlot = dwNewSlot;
+		else
+			TlsFree(dwNewSlot);
+	}
+
+	pCache = (ScriptAllocatorCache *)TlsGetValue(dwSlot);
+#else
+	pthread_once(&g_allocatorCacheOnce, CreateAllocatorCacheKey);
+
+	if(!g_bAllocatorCacheKeyCreated)
+		return NULL;
+
+	pCache = (ScriptAllocatorCache *)pthread_getspecific(g_allocatorCacheKey);
+#endif
+
+	if(pCache)
+		return pCache;
+
+	// The pools are kept for the lifetime of the process as their blocks
+	// can still be in use by the vms
+	pCache = (ScriptAllocatorCache *)calloc(1, sizeof(ScriptAllocatorCache));
+
+	if(!pCache)
+		return NULL;
+
+#ifdef WIN32
+	TlsSetValue(dwSlot, pCache);
+#else
+	pthread_setspecific(g_allocatorCacheKey, pCache);
+#endif
+	return pCache;
+}
+
+static unsigned int GetSizeClass(size_t sSize)
+{
+	if(sSize == 0)
+		return 0;
+
+	return (unsigned int)((sSize - 1) / SCRIPT_ALLOCATOR_SIZE_CLASS_STEP);
+}
+
+static size_t GetBlockSize(unsigned int uiSizeClass)
+{
+	return (SCRIPT_ALLOCATION_HEADER_SIZE + ((uiSizeClass + 1) * SCRIPT_ALLOCATOR_SIZE_CLASS_STEP));
+}
+
+static ScriptAllocationHeader * AllocateBlock(ScriptAllocatorCache * pCache, size_t sSize)
+{
+	if(sSize > SCRIPT_ALLOCATOR_MAX_POOLED_SIZE)
+		return (ScriptAllocationHeader *)malloc(SCRIPT_ALLOCATION_HEADER_SIZE + sSize);
+
+	unsigned int uiSizeClass = GetSizeClass(sSize);
+
+	// Without pools the block has to be as large as the pooled one so it can be freed to a pool later
+	if(!pCache)
+		return (ScriptAllocationHeader *)malloc(GetBlockSize(uiSizeClass));
+
+	if(!pCache->pFreeBlocks[uiSizeClass])
+	{
+		// Split a new chunk into blocks of this class
+		size_t sBlockSize = GetBlockSize(uiSizeClass);
+		unsigned char * pChunk = (unsigned char *)malloc(SCRIPT_ALLOCATOR_CHUNK_SIZE);
+
+		if(!pChunk)
+			return NULL;
+
+		for(size_t sOffset = 0; (sOffset + sBlockSize) <= SCRIPT_ALLOCATOR_CHUNK_SIZE; sOffset += sBlockSize)
+		{
+			ScriptFreeBlock * pBlock = (ScriptFreeBlock *)(pChunk + sOffset);
+			pBlock->pNext = pCache->pFreeBlocks[uiSizeClass];
+			pCache->pFreeBlocks[uiSizeClass] = pBlock;
+		}
+	}
+
+	ScriptFreeBlock * pBlock = pCache->pFreeBlocks[uiSizeClass];
+	pCache->pFreeBlocks[uiSizeClass] = pBlock->pNext;
+	return (ScriptAllocationHeader *)pBlock;
+}
+
+static void FreeBlock(ScriptAllocatorCache * pCache, ScriptAllocationHeader * pHeader)
+{
+	if(pHeader->sSize > SCRIPT_ALLOCATOR_MAX_POOLED_SIZE)
+	{
+		free(pHeader);
+		return;
+	}
+
+	// Blocks of pools are never given back to the heap as they are part of a chunk
+	if(!pCache)
+		return;
+
+	unsigned int uiSizeClass = GetSizeClass(pHeader->sSize);
+	ScriptFreeBlock * pBlock = (ScriptFreeBlock *)pHeader;
+	pBlock->pNext = pCache->pFreeBlocks[uiSizeClass];
+	pCache->pFreeBlocks[uiSizeClass] = pBlock;
+}
+
+void CScriptAllocator::CountScriptMemory(unsigned int uiSlot, long lChange)
+{
+	CMemoryTracker::Add(CMemoryTracker::GetCounter(MEMORY_TAG_SCRIPTS), lChange);
+	MemoryCounter * pCounter = CMemoryTracker::GetScriptCounter(uiSlot);
+	CMemoryTracker::Add(pCounter, lChange);
+
+	// Keep track of whether the script is over its limit
+	long lOverLimit = ((m_sMemoryLimit > 0 && uiSlot != 0 && pCounter->lCurrent > (long)m_sMemoryLimit) ? 1 : 0);
+
+	if(g_lScriptOverLimit[uiSlot] == lOverLimit)
+		return;
+
+	// Only the thread that changes the flag changes the count
+	if(CAtomic::CompareExchange(&g_lScriptOverLimit[uiSlot], lOverLimit, !lOverLimit) == !lOverLimit)
+		CAtomic::Add(&m_lScriptsOverLimit, (lOverLimit ? 1 : -1));
+}
+
+void CScriptAllocator::CountScriptMemory(ScriptAllocatorCache * pCache, unsigned int uiSlot, long lChange)
+{
+	// Changes of the current script are collected so the counters aren't
+	// changed (which is atomic) for every block
+	if(pCache && uiSlot == pCache->uiCurrentScript)
+	{
+		pCache->lUncountedBytes += lChange;
+
+		if(pCache->lUncountedBytes < SCRIPT_ALLOCATOR_COUNT_BATCH && pCache->lUncountedBytes > -SCRIPT_ALLOCATOR_COUNT_BATCH)
+			return;
+
+		lChange = pCache->lUncountedBytes;
+		pCache->lUncountedBytes = 0;
+	}
+
+	CountScriptMemory(uiSlot, lChange);
+}
+
+bool CScriptAllocator::IsCurrentScriptOverLimit()
+{
+	return (g_lScriptOverLimit[GetCurrentScript()] != 0);
+}
+
+void * CScriptAllocator::Allocate(size_t sSize)
+{
+	ScriptAllocatorCache * pCache = GetAllocatorCache();
+	ScriptAllocationHeader * pHeader = AllocateBlock(pCache, sSize);
+
+	if(!pHeader)
+		return NULL;
+
+	pHeader->sSize = sSize;
+	pHeader->uiSlot = (pCache ? pCache->uiCurrentScript : 0);
+	CountScriptMemory(pCache, pHeader->uiSlot, (long)sSize);
+	return ((unsigned char *)pHeader + SCRIPT_ALLOCATION_HEADER_SIZE);
+}
+
+void * CScriptAllocator::Reallocate(void * pMemory, size_t sSize)
+{
+	if(!pMemory)
+		return Allocate(sSize);
+
+	ScriptAllocationHeader * pHeader = (ScriptAllocationHeader *)((unsigned char *)pMemory - SCRIPT_ALLOCATION_HEADER_SIZE);
+	size_t sOldSize = pHeader->sSize;
+	unsigned int uiSlot = pHeader->uiSlot;
+	ScriptAllocatorCache * pCache = GetAllocatorCache();
+	bool bPooled = (sOldSize <= SCRIPT_ALLOCATOR_MAX_POOLED_SIZE);
+
+	// The memory stays counted for the script that allocated it first
+	if(bPooled != (sSize <= SCRIPT_ALLOCATOR_MAX_POOLED_SIZE) || (bPooled && GetSizeClass(sOldSize) != GetSizeClass(sSize)))
+	{
+		// Move it to a block of the new size
+		ScriptAllocationHeader * pNewHeader = AllocateBlock(pCache, sSize);
+
+		if(!pNewHeader)
+			return NULL;
+
+		memcpy(((unsigned char *)pNewHeader + SCRIPT_ALLOCATION_HEADER_SIZE), pMemory, ((sSize < sOldSize) ? sSize : sOldSize));
+		FreeBlock(pCache, pHeader);
+		pHeader = pNewHeader;
+		pHeader->uiSlot = uiSlot;
+	}
+	else if(!bPooled)
+	{
+		pHeader = (ScriptAllocationHeader *)realloc(pHeader, (SCRIPT_ALLOCATION_HEADER_SIZE + sSize));
+
+		if(!pHeader)
+			return NULL;
+	}
+
+	pHeader->sSize = sSize;
+	CountScriptMemory(pCache, uiSlot, ((long)sSize - (long)sOldSize));
+	return ((unsigned char *)pHeader + SCRIPT_ALLOCATION_HEADER_SIZE);
+}
+
+void CScriptAllocator::Free(void * pMemory)
+{
+	if(!pMemory)
+		return;
+
+	ScriptAllocationHeader * pHeader = (ScriptAllocationHeader *)((unsigned char *)pMemory - SCRIPT_ALLOCATION_HEADER_SIZE);
+	ScriptAllocatorCache * pCache = GetAllocatorCache();
+	CountScriptMemory(pCache, pHeader->uiSlot, -(long)pHeader->sSize);
+	FreeBlock(pCache, pHeader);
+}
+
+unsigned int CScriptAllocator::SetCurrentScript(unsigned int uiSlot)
+{
+	ScriptAllocatorCache * pCache = GetAllocatorCache();
+
+	if(!pCache)
+		return 0;
+
+	unsigned int uiPreviousSlot = pCache->uiCurrentScript;
+
+	if(uiSlot == uiPreviousSlot)
+		return uiPreviousSlot;
+
+	// What wasn't counted yet belongs to the previous script
+	if(pCache->lUncountedBytes != 0)
+	{
+		CountScriptMemory(uiPreviousSlot, pCache->lUncountedBytes);
+		pCache->lUncountedBytes = 0;
+	}
+
+	pCache->uiCurrentScript = uiSlot;
+	return uiPreviousSlot;
+}
+
+unsigned int CScriptAllocator::GetCurrentScript()
+{
+	ScriptAllocatorCache * pCache = GetAllocatorCache();
+	return (pCache ? pCache->uiCurrentScript : 0);
+}
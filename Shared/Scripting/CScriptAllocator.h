@@ -0,0 +1,78 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptAllocator.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stddef.h>
+#include "../CMemoryTracker.h"
+
+// Allocations up to this size come from the size class pools
+#define SCRIPT_ALLOCATOR_MAX_POOLED_SIZE 256
+
+// Difference in bytes between two size classes
+#define SCRIPT_ALLOCATOR_SIZE_CLASS_STEP 16
+
+#define SCRIPT_ALLOCATOR_SIZE_CLASSES (SCRIPT_ALLOCATOR_MAX_POOLED_SIZE / SCRIPT_ALLOCATOR_SIZE_CLASS_STEP)
+
+// Size of the chunks the pools are filled from
+#define SCRIPT_ALLOCATOR_CHUNK_SIZE 16384
+
+// Bytes the memory of the current script of a thread can change by before
+// it is counted, the counters and the limit lag behind by at most this
+#define SCRIPT_ALLOCATOR_COUNT_BATCH 16384
+
+struct ScriptAllocatorCache;
+
+// The allocator of squirrel. Small blocks (tables, closures, strings) come
+// from free lists of the calling thread so they don't need the heap, larger
+// ones go to the heap. Every block is counted for the script that runs on
+// the calling thread (see CScriptMemoryScope).
+class CScriptAllocator
+{
+private:
+	static size_t        m_sMemoryLimit;
+	static volatile long m_lScriptsOverLimit;
+
+	static void          CountScriptMemory(unsigned int uiSlot, long lChange);
+	static void          CountScriptMemory(ScriptAllocatorCache * pCache, unsigned int uiSlot, long lChange);
+	static bool          IsCurrentScriptOverLimit();
+
+public:
+	static void        * Allocate(size_t sSize);
+	static void        * Reallocate(void * pMemory, size_t sSize);
+	static void          Free(void * pMemory);
+
+	// Memory in bytes each script may use (0 for no limit), the unattributed
+	// memory has no limit
+	static void          SetMemoryLimit(size_t sMemoryLimit) { m_sMemoryLimit = sMemoryLimit; }
+	static size_t        GetMemoryLimit() { return m_sMemoryLimit; }
+
+	// Squirrel can't handle a failed allocation so allocations over the limit
+	// still succeed, the vm raises an error at the next allocating instruction
+	// or loop instead while the script is over its limit
+	static bool          IsOverLimit() { return (m_lScriptsOverLimit > 0 && IsCurrentScriptOverLimit()); }
+
+	// The memory tracker slot (see CMemoryTracker::GetScriptSlot) the blocks
+	// allocated on the calling thread are counted for, returns the slot that
+	// was current before
+	static unsigned int  SetCurrentScript(unsigned int uiSlot);
+	static unsigned int  GetCurrentScript();
+};
+
+// Counts what squirrel allocates on this thread from the construction to the
+// destruction of the scope for the script
+class CScriptMemoryScope
+{
+private:
+	unsigned int m_uiPreviousSlot;
+
+public:
+	CScriptMemoryScope(unsigned int uiSlot) { m_uiPreviousSlot = CScriptAllocator::SetCurrentScript(uiSlot); }
+	~CScriptMemoryScope() { CScriptAllocator::SetCurrentScript(m_uiPreviousSlot); }
+};
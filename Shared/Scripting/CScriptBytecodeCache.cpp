@@ -0,0 +1,164 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptBytecodeCache.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CScriptBytecodeCache.h"
+#include "../CFileChecksum.h"
+#include "../SharedUtility.h"
+#include <Squirrel/sqstdio.h>
+#include <stdio.h>
+
+String CScriptBytecodeCache::m_strDirectory;
+
+static SQInteger ReadFunction(SQUserPointer pFile, SQUserPointer pBuffer, SQInteger iSize)
+{
+	SQInteger iRead = (SQInteger)fread(pBuffer, 1, (size_t)iSize, (FILE *)pFile);
+	return (iRead != 0 ? iRead : -1);
+}
+
+static SQInteger WriteFunction(SQUserPointer pFile, SQUserPointer pBuffer, SQInteger iSize)
+{
+	return (SQInteger)fwrite(pBuffer, 1, (size_t)iSize, (FILE *)pFile);
+}
+
+void CScriptBytecodeCache::SetDirectory(String strDirectory)
+{
+	m_strDirectory = strDirectory;
+
+	// An empty directory disables the cache
+	if(!m_strDirectory.IsEmpty() && !SharedUtility::Exists(m_strDirectory.Get()))
+		SharedUtility::CreateDirectory(m_strDirectory.Get());
+}
+
+String CScriptBytecodeCache::GetCachePath(String strSourcePath)
+{
+	// The cache file is named after the source path so scripts with the same
+	// name in different folders don't share a cache file
+	CChecksum pathChecksum;
+	pathChecksum.Add((unsigned char *)strSourcePath.Get(), strSourcePath.GetLength());
+	return String("%s/%08x.cnut", m_strDirectory.Get(), pathChecksum.GetChecksum());
+}
+
+bool CScriptBytecodeCache::GetSourceInfo(String strSourcePath, unsigned int& uiChecksum, unsigned int& uiSize)
+{
+	CFileChecksum fileChecksum;
+
+	if(!fileChecksum.Calculate(strSourcePath))
+		return false;
+
+	FILE * pFile = fopen(strSourcePath.Get(), "rb");
+
+	if(!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	uiSize = (unsigned int)ftell(pFile);
+	fclose(pFile);
+	uiChecksum = fileChecksum.GetChecksum();
+	return true;
+}
+
+bool CScriptBytecodeCache::Load(SQVM * pVM, String strSourcePath, unsigned int uiChecksum, unsigned int uiSize)
+{
+	if(!IsEnabled())
+		return false;
+
+	FILE * pFile = fopen(GetCachePath(strSourcePath).Get(), "rb");
+
+	if(!pFile)
+		return false;
+
+	// Is the cache file for this version of the source?
+	ScriptBytecodeCacheHeader header;
+
+	if(fread(&header, sizeof(header), 1, pFile) != 1 || header.uiMagic != SCRIPT_BYTECODE_CACHE_MAGIC || 
+		header.uiVersion != SCRIPT_BYTECODE_CACHE_VERSION || header.uiSourceChecksum != uiChecksum || 
+		header.uiSourceSize != uiSize)
+	{
+		fclose(pFile);
+		return false;
+	}
+
+	// Read the closure onto the stack (this fails if the cache was written by
+	// a build with different squirrel types)
+	bool bLoaded = SQ_SUCCEEDED(sq_readclosure(pVM, ReadFunction, pFile));
+	fclose(pFile);
+	return bLoaded;
+}
+
+bool CScriptBytecodeCache::Save(SQVM * pVM, String strSourcePath, unsigned int uiChecksum, unsigned int uiSize)
+{
+	if(!IsEnabled())
+		return false;
+
+	// The source info must be taken before the source was compiled, if the
+	// source changes in between the cache is just never used
+	ScriptBytecodeCacheHeader header;
+	header.uiMagic = SCRIPT_BYTECODE_CACHE_MAGIC;
+	header.uiVersion = SCRIPT_BYTECODE_CACHE_VERSION;
+	header.uiSourceChecksum = uiChecksum;
+	header.uiSourceSize = uiSize;
+
+	String strCachePath = GetCachePath(strSourcePath);
+	FILE * pFile = fopen(strCachePath.Get(), "wb");
+
+	if(!pFile)
+		return false;
+
+	// Write the closure on the top of the stack
+	bool bSaved = (fwrite(&header, sizeof(header), 1, pFile) == 1 && SQ_SUCCEEDED(sq_writeclosure(pVM, WriteFunction, pFile)));
+	fclose(pFile);
+
+	// Don't leave broken cache files around
+	if(!bSaved)
+		remove(strCachePath.Get());
+
+	return bSaved;
+}
+
+bool CScriptBytecodeCache::Compile(String strSourcePath, String strBytecodePath)
+{
+	// The closure doesn't reference anything of the vm so a vm of its own is enough to compile it
+	SQVM * pVM = sq_open(1024);
+
+	if(!pVM)
+		return false;
+
+	if(SQ_FAILED(sqstd_loadfile(pVM, strSourcePath.Get(), SQFalse)))
+	{
+		sq_close(pVM);
+		return false;
+	}
+
+	FILE * pFile = fopen(strBytecodePath.Get(), "wb");
+	bool bCompiled = (pFile && SQ_SUCCEEDED(sq_writeclosure(pVM, WriteFunction, pFile)));
+
+	if(pFile)
+		fclose(pFile);
+
+	sq_close(pVM);
+
+	// Don't leave broken bytecode files around
+	if(!bCompiled)
+		remove(strBytecodePath.Get());
+
+	return bCompiled;
+}
+
+bool CScriptBytecodeCache::IsBytecode(String strPath)
+{
+	FILE * pFile = fopen(strPath.Get(), "rb");
+
+	if(!pFile)
+		return false;
+
+	unsigned short usTag = 0;
+	bool bIsBytecode = (fread(&usTag, sizeof(usTag), 1, pFile) == 1 && usTag == SQ_BYTECODE_STREAM_TAG);
+	fclose(pFile);
+	return bIsBytecode;
+}
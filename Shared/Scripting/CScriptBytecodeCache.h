@@ -0,0 +1,48 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptBytecodeCache.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <Squirrel/squirrel.h>
+#include "../CString.h"
+
+// Identifies a bytecode cache file ('IVBC')
+#define SCRIPT_BYTECODE_CACHE_MAGIC 0x43425649
+
+// Increase this whenever the cache file layout (or the squirrel version) changes
+#define SCRIPT_BYTECODE_CACHE_VERSION 1
+
+// Header at the start of every bytecode cache file, followed by the closure
+struct ScriptBytecodeCacheHeader
+{
+	unsigned int uiMagic;
+	unsigned int uiVersion;
+	unsigned int uiSourceChecksum;
+	unsigned int uiSourceSize;
+};
+
+class CScriptBytecodeCache
+{
+private:
+	static String m_strDirectory;
+
+	static String GetCachePath(String strSourcePath);
+
+public:
+	static void   SetDirectory(String strDirectory);
+	static bool   IsEnabled() { return !m_strDirectory.IsEmpty(); }
+	static bool   GetSourceInfo(String strSourcePath, unsigned int& uiChecksum, unsigned int& uiSize);
+	static bool   Load(SQVM * pVM, String strSourcePath, unsigned int uiChecksum, unsigned int uiSize);
+	static bool   Save(SQVM * pVM, String strSourcePath, unsigned int uiChecksum, unsigned int uiSize);
+
+	// Compiles the source into a file of just the closure (no cache header), squirrel
+	// loads such a file like the source as long as it was built with the same types
+	static bool   Compile(String strSourcePath, String strBytecodePath);
+	static bool   IsBytecode(String strPath);
+};
@@ -0,0 +1,246 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptProfiler.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CScriptingManager.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include <Squirrel/sqfuncproto.h>
+#include <Squirrel/sqclosure.h>
+#include <Squirrel/sqstring.h>
+#include "CScriptProfiler.h"
+#include "../SharedUtility.h"
+#include "../CLogFile.h"
+#include <algorithm>
+#include <stdio.h>
+
+extern CScriptingManager * g_pScriptingManager;
+
+CScriptProfiler * g_pScriptProfiler = NULL;
+
+static const char * g_szScriptProfilerFrameTypeNames[SCRIPT_PROFILER_FRAME_TYPE_MAX] =
+{
+	"Scripts",
+	"Events",
+	"Timers",
+	"Functions"
+};
+
+typedef std::pair<String, ScriptProfilerEntry> ScriptProfilerSortEntry;
+
+static bool SortByExclusiveTime(const ScriptProfilerSortEntry& a, const ScriptProfilerSortEntry& b)
+{
+	return (a.second.ullExclusiveTime > b.second.ullExclusiveTime);
+}
+
+CScriptProfiler::CScriptProfiler()
+{
+	m_bRunning = false;
+	m_ullStartTime = 0;
+	m_ullRunTime = 0;
+}
+
+CScriptProfiler::~CScriptProfiler()
+{
+	Stop();
+}
+
+void CScriptProfiler::OnDebugHook(SQVM * pVM, SQInteger iType, const SQChar * szSource, SQInteger iLine, const SQChar * szFunction)
+{
+	// Lines (and loop iterations) are only interesting to the script watchdog
+	if(!m_bRunning || (iType != 'c' && iType != 'r'))
+		return;
+
+	// Exceptions unwind the squirrel call stack without telling us so functions
+	// that were called deeper than (or tail called at) this depth are done
+	SQInteger iCallDepth = pVM->_callsstacksize;
+	PopFunctions(pVM, iCallDepth);
+
+	if(iType == 'c')
+	{
+		// The line is the first line of the function when it is called
+		if(EnterFrame(SCRIPT_PROFILER_FUNCTION, String("%s (%s:%d)", szFunction ? szFunction : "anonymous", szSource ? szSource : "unknown", (int)iLine)) != SCRIPT_PROFILER_NO_FRAME)
+		{
+			m_frames.back().pVM = pVM;
+			m_frames.back().iCallDepth = iCallDepth;
+		}
+	}
+}
+
+String CScriptProfiler::GetFunctionName(SQObjectPtr pFunction)
+{
+	if(type(pFunction) == OT_NATIVECLOSURE)
+		return "native";
+
+	if(type(pFunction) != OT_CLOSURE)
+		return "unknown";
+
+	SQFunctionProto * pProto = _closure(pFunction)->_function;
+	const char * szFunction = (type(pProto->_name) == OT_STRING ? _stringval(pProto->_name) : "anonymous");
+	const char * szSource = (type(pProto->_sourcename) == OT_STRING ? _stringval(pProto->_sourcename) : "unknown");
+	int iLine = (pProto->_nlineinfos > 0 ? (int)pProto->_lineinfos[0]._line : 0);
+	return String("%s (%s:%d)", szFunction, szSource, iLine);
+}
+
+void CScriptProfiler::UpdateDebugHooks()
+{
+	if(!g_pScriptingManager)
+		return;
+
+	std::list<CSquirrel *> * pScripts = g_pScriptingManager->GetScriptList();
+
+	for(std::list<CSquirrel *>::iterator iter = pScripts->begin(); iter != pScripts->end(); iter++)
+		(*iter)->UpdateDebugHook();
+}
+
+void CScriptProfiler::Start()
+{
+	if(m_bRunning)
+		return;
+
+	m_frames.clear();
+	m_ullStartTime = SharedUtility::GetMicroseconds();
+	m_bRunning = true;
+	UpdateDebugHooks();
+}
+
+void CScriptProfiler::Stop()
+{
+	if(!m_bRunning)
+		return;
+
+	// Frames that are still open aren't recorded
+	m_bRunning = false;
+	UpdateDebugHooks();
+	m_frames.clear();
+	m_ullRunTime += (SharedUtility::GetMicroseconds() - m_ullStartTime);
+}
+
+void CScriptProfiler::Reset()
+{
+	for(int i = 0; i < SCRIPT_PROFILER_FRAME_TYPE_MAX; i++)
+		m_entries[i].clear();
+
+	m_stacks.clear();
+	m_frames.clear();
+	m_ullRunTime = 0;
+	m_ullStartTime = SharedUtility::GetMicroseconds();
+}
+
+unsigned int CScriptProfiler::EnterFrame(eScriptProfilerFrameType type, const String& strName)
+{
+	if(!m_bRunning)
+		return SCRIPT_PROFILER_NO_FRAME;
+
+	unsigned int uiDepth = (unsigned int)m_frames.size();
+	ScriptProfilerFrame frame;
+	frame.type = type;
+
+	// Get the entry for this frame
+	std::map<String, ScriptProfilerEntry>::iterator iter = m_entries[type].find(strName);
+
+	if(iter == m_entries[type].end())
+	{
+		ScriptProfilerEntry entry;
+		memset(&entry, 0, sizeof(entry));
+		iter = m_entries[type].insert(std::pair<String, ScriptProfilerEntry>(strName, entry)).first;
+	}
+
+	frame.pEntry = &(*iter).second;
+	frame.pEntry->uiCalls++;
+
+	// The stack is in the folded format flame graph tools read
+	if(m_frames.empty())
+		frame.strStack = strName;
+	else
+		frame.strStack = (m_frames.back().strStack + ";" + strName);
+
+	frame.ullChildTime = 0;
+	frame.pVM = NULL;
+	frame.iCallDepth = 0;
+	m_frames.push_back(frame);
+
+	// Take the start time last so the above isn't counted
+	m_frames.back().ullStartTime = SharedUtility::GetMicroseconds();
+	return uiDepth;
+}
+
+void CScriptProfiler::PopFrame()
+{
+	ScriptProfilerFrame * pFrame = &m_frames.back();
+	unsigned long long ullTime = (SharedUtility::GetMicroseconds() - pFrame->ullStartTime);
+	unsigned long long ullExclusiveTime = (ullTime > pFrame->ullChildTime ? (ullTime - pFrame->ullChildTime) : 0);
+	pFrame->pEntry->ullInclusiveTime += ullTime;
+	pFrame->pEntry->ullExclusiveTime += ullExclusiveTime;
+	m_stacks[pFrame->strStack] += ullExclusiveTime;
+	m_frames.pop_back();
+
+	if(!m_frames.empty())
+		m_frames.back().ullChildTime += ullTime;
+}
+
+void CScriptProfiler::PopFunctions(SQVM * pVM, SQInteger iCallDepth)
+{
+	// Frames of anything other than functions are left by the code that entered them
+	while(!m_frames.empty() && m_frames.back().type == SCRIPT_PROFILER_FUNCTION && m_frames.back().pVM == pVM && m_frames.back().iCallDepth >= iCallDepth)
+		PopFrame();
+}
+
+void CScriptProfiler::LeaveFrame(unsigned int uiDepth)
+{
+	if(uiDepth == SCRIPT_PROFILER_NO_FRAME || !m_bRunning)
+		return;
+
+	// Also pop any functions above the frame that never returned (because
+	// of a script error)
+	while(m_frames.size() > uiDepth)
+		PopFrame();
+}
+
+void CScriptProfiler::Print()
+{
+	unsigned long long ullRunTime = m_ullRunTime;
+
+	if(m_bRunning)
+		ullRunTime += (SharedUtility::GetMicroseconds() - m_ullStartTime);
+
+	CLogFile::Printf("Script profile (%s, %.2f seconds):", m_bRunning ? "running" : "stopped", (ullRunTime / 1000000.0));
+
+	for(int i = 0; i < SCRIPT_PROFILER_FRAME_TYPE_MAX; i++)
+	{
+		if(m_entries[i].empty())
+			continue;
+
+		// Sort the entries by the time spent in them
+		std::vector<ScriptProfilerSortEntry> entries(m_entries[i].begin(), m_entries[i].end());
+		std::sort(entries.begin(), entries.end(), SortByExclusiveTime);
+		CLogFile::Printf("%s (%d):", g_szScriptProfilerFrameTypeNames[i], entries.size());
+
+		for(size_t j = 0; j < entries.size() && j < SCRIPT_PROFILER_PRINT_ENTRIES; j++)
+		{
+			ScriptProfilerEntry * pEntry = &entries[j].second;
+			CLogFile::Printf("  %s: %d call(s), %.3f ms inclusive, %.3f ms exclusive, %.3f ms average", entries[j].first.Get(), pEntry->uiCalls,
+				(pEntry->ullInclusiveTime / 1000.0), (pEntry->ullExclusiveTime / 1000.0), ((pEntry->ullInclusiveTime / 1000.0) / pEntry->uiCalls));
+		}
+	}
+}
+
+bool CScriptProfiler::Dump(String strPath)
+{
+	FILE * pFile = fopen(strPath.Get(), "w");
+
+	if(!pFile)
+		return false;
+
+	// One line per stack with the exclusive time in microseconds
+	for(std::map<String, unsigned long long>::iterator iter = m_stacks.begin(); iter != m_stacks.end(); iter++)
+		fprintf(pFile, "%s %llu\n", (*iter).first.Get(), (*iter).second);
+
+	fclose(pFile);
+	return true;
+}
@@ -0,0 +1,89 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptProfiler.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <stdlib.h>
+#include <map>
+#include <vector>
+#include <Squirrel/squirrel.h>
+#include <Squirrel/sqobject.h>
+#include "../CString.h"
+
+// Returned by EnterFrame when the profiler isn't running
+#define SCRIPT_PROFILER_NO_FRAME 0xFFFFFFFF
+
+// Amount of entries of each type shown by Print
+#define SCRIPT_PROFILER_PRINT_ENTRIES 15
+
+// Types of frame the profiler records, each type has its own statistics
+enum eScriptProfilerFrameType
+{
+	SCRIPT_PROFILER_SCRIPT,
+	SCRIPT_PROFILER_EVENT,
+	SCRIPT_PROFILER_TIMER,
+	SCRIPT_PROFILER_FUNCTION,
+	SCRIPT_PROFILER_FRAME_TYPE_MAX
+};
+
+// Statistics of a single script, event, timer or function
+struct ScriptProfilerEntry
+{
+	unsigned int       uiCalls;
+	unsigned long long ullInclusiveTime;
+	unsigned long long ullExclusiveTime;
+};
+
+// Frame on the profiler call stack
+struct ScriptProfilerFrame
+{
+	eScriptProfilerFrameType type;
+	ScriptProfilerEntry *    pEntry;
+	String                   strStack;
+	unsigned long long       ullStartTime;
+	unsigned long long       ullChildTime;
+	SQVM *                   pVM;
+	SQInteger                iCallDepth;
+};
+
+// Records call counts and inclusive/exclusive time (in microseconds) of
+// scripts, events, timers and script functions. Functions are recorded with
+// the squirrel debug hook which is only set while the profiler is running
+// (or the script watchdog needs it).
+class CScriptProfiler
+{
+private:
+	bool                                    m_bRunning;
+	unsigned long long                      m_ullStartTime;
+	unsigned long long                      m_ullRunTime;
+	std::map<String, ScriptProfilerEntry>   m_entries[SCRIPT_PROFILER_FRAME_TYPE_MAX];
+	std::map<String, unsigned long long>    m_stacks;
+	std::vector<ScriptProfilerFrame>        m_frames;
+
+	void         PopFrame();
+	void         PopFunctions(SQVM * pVM, SQInteger iCallDepth);
+	void         UpdateDebugHooks();
+
+public:
+	CScriptProfiler();
+	~CScriptProfiler();
+
+	static String GetFunctionName(SQObjectPtr pFunction);
+	bool          IsRunning() { return m_bRunning; }
+	void          Start();
+	void          Stop();
+	void          Reset();
+	void          OnDebugHook(SQVM * pVM, SQInteger iType, const SQChar * szSource, SQInteger iLine, const SQChar * szFunction);
+	unsigned int  EnterFrame(eScriptProfilerFrameType type, const String& strName);
+	void          LeaveFrame(unsigned int uiDepth);
+	void          Print();
+	bool          Dump(String strPath);
+};
+
+extern CScriptProfiler * g_pScriptProfiler;
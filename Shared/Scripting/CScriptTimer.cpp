@@ -8,7 +8,9 @@
 //==============================================================================
 
 #include "CScriptTimer.h"
+#include "CScriptProfiler.h"
 #include "../SharedUtility.h"
+#include "../CTraceRecorder.h"
 
 CScriptTimer::CScriptTimer(CSquirrel* pSquirrel, SQObjectPtr pFunction, int uiInterval, int iRepeations, CSquirrelArguments* pArguments)
 {
@@ -28,7 +30,7 @@ CScriptTimer::~CScriptTimer()
 		delete m_pArguments;
 }
 
-bool CScriptTimer::Pulse()
+bool CScriptTimer::Pulse(unsigned int uiNow)
 {
 	if(m_bIsDead)
 		return false;
@@ -37,14 +39,28 @@ bool CScriptTimer::Pulse()
 	// 'traditional behavior' means only one iteration at most
 	unsigned int iCount = m_bTraditional ? 1 : 10;
 
-	// save the current time
-	unsigned int uiNow = SharedUtility::GetTime();
-
 	// call the timer function as long as we should by time & iterations
-	while(uiNow >= m_uiLastTick + m_uiInterval && iCount -- > 0)
+	// (compared as a difference so it still works when the tick count wraps)
+	while((int)(uiNow - (m_uiLastTick + m_uiInterval)) >= 0 && iCount -- > 0)
 	{
 		// call the function
-		m_pSquirrel->Call(m_pFunction, m_pArguments);
+		unsigned int uiProfilerDepth = SCRIPT_PROFILER_NO_FRAME;
+
+		if(g_pScriptProfiler && g_pScriptProfiler->IsRunning())
+			uiProfilerDepth = g_pScriptProfiler->EnterFrame(SCRIPT_PROFILER_TIMER, CScriptProfiler::GetFunctionName(m_pFunction));
+
+		{
+			String strTraceName;
+
+			if(CTraceRecorder::IsEnabled())
+				strTraceName = CScriptProfiler::GetFunctionName(m_pFunction);
+
+			CTraceScope traceScope(TRACE_CATEGORY_TIMER, strTraceName.Get());
+			m_pSquirrel->Call(m_pFunction, m_pArguments);
+		}
+
+		if(g_pScriptProfiler)
+			g_pScriptProfiler->LeaveFrame(uiProfilerDepth);
 
 		// update the last tick count. 'traditional behaviour' implies the timer to go off after some time, yet forces at least m_uiInterval to
 		// elapse inbetween two calls. By default, it is assumed that the timer should be happening in regular intervals, so it might be a few
@@ -60,6 +76,21 @@ bool CScriptTimer::Pulse()
 	return true;
 }
 
+unsigned int CScriptTimer::GetNextTick()
+{
+	return m_uiLastTick + m_uiInterval;
+}
+
+unsigned int CScriptTimer::GetLastTick()
+{
+	return m_uiLastTick;
+}
+
+void CScriptTimer::Delay(unsigned int uiTime)
+{
+	m_uiLastTick += uiTime;
+}
+
 CSquirrel* CScriptTimer::GetScript()
 {
 	return m_pSquirrel;
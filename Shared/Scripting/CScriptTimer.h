@@ -28,7 +28,12 @@ public:
 	CScriptTimer(CSquirrel* pSquirrel, SQObjectPtr pFunction, int uiInterval, int iRepeations, CSquirrelArguments* pArguments);
 	~CScriptTimer();
 
-	bool Pulse();
+	bool Pulse(unsigned int uiNow);
+	unsigned int GetNextTick();
+	unsigned int GetLastTick();
+
+	// Moves the next run back by the time (in ms)
+	void Delay(unsigned int uiTime);
 	CSquirrel* GetScript();
 	void Kill();
 	bool IsDead();
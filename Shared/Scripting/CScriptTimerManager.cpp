@@ -10,43 +10,312 @@
 //==============================================================================
 
 #include "CScriptTimerManager.h"
+#include "../SharedUtility.h"
 
 CScriptTimerManager * g_pScriptTimerManager = NULL;
 
+CScriptTimerManager::CScriptTimerManager()
+{
+	for(int i = 0; i < SCRIPT_TIMER_WHEEL_ROOT_SIZE; i++)
+		m_uiRootWheel[i] = INVALID_SCRIPT_TIMER_SLOT;
+
+	for(int i = 0; i < SCRIPT_TIMER_WHEEL_LEVELS; i++)
+	{
+		for(int j = 0; j < SCRIPT_TIMER_WHEEL_LEVEL_SIZE; j++)
+			m_uiLevelWheels[i][j] = INVALID_SCRIPT_TIMER_SLOT;
+	}
+
+	m_uiExpired = INVALID_SCRIPT_TIMER_SLOT;
+	m_uiCurrentTick = SharedUtility::GetTime();
+	m_uiRunningSlot = INVALID_SCRIPT_TIMER_SLOT;
+	m_uiCount = 0;
+	m_bPaused = false;
+	m_uiPauseTime = 0;
+}
+
+CScriptTimerManager::~CScriptTimerManager()
+{
+	for(unsigned int i = 0; i < m_slots.size(); i++)
+	{
+		if(m_slots[i].pTimer)
+			delete m_slots[i].pTimer;
+	}
+}
+
+void CScriptTimerManager::Link(unsigned int * puiList, unsigned int uiSlot)
+{
+	ScriptTimerSlot * pSlot = &m_slots[uiSlot];
+	pSlot->puiList = puiList;
+	pSlot->uiPrevious = INVALID_SCRIPT_TIMER_SLOT;
+	pSlot->uiNext = *puiList;
+
+	if(*puiList != INVALID_SCRIPT_TIMER_SLOT)
+		m_slots[*puiList].uiPrevious = uiSlot;
+
+	*puiList = uiSlot;
+}
+
+void CScriptTimerManager::Unlink(unsigned int uiSlot)
+{
+	ScriptTimerSlot * pSlot = &m_slots[uiSlot];
+
+	if(!pSlot->puiList)
+		return;
+
+	if(pSlot->uiPrevious != INVALID_SCRIPT_TIMER_SLOT)
+		m_slots[pSlot->uiPrevious].uiNext = pSlot->uiNext;
+	else
+		*pSlot->puiList = pSlot->uiNext;
+
+	if(pSlot->uiNext != INVALID_SCRIPT_TIMER_SLOT)
+		m_slots[pSlot->uiNext].uiPrevious = pSlot->uiPrevious;
+
+	pSlot->puiList = NULL;
+}
+
+void CScriptTimerManager::Schedule(unsigned int uiSlot, unsigned int uiExpireTick)
+{
+	// Timers that should have run already run on the next tick
+	if((int)(uiExpireTick - m_uiCurrentTick) < 0)
+		uiExpireTick = m_uiCurrentTick;
+
+	unsigned int uiDelta = (uiExpireTick - m_uiCurrentTick);
+
+	if(uiDelta >= SCRIPT_TIMER_WHEEL_MAX_DELTA)
+	{
+		uiDelta = (SCRIPT_TIMER_WHEEL_MAX_DELTA - 1);
+		uiExpireTick = (m_uiCurrentTick + uiDelta);
+	}
+
+	m_slots[uiSlot].uiExpireTick = uiExpireTick;
+
+	if(uiDelta < SCRIPT_TIMER_WHEEL_ROOT_SIZE)
+	{
+		Link(&m_uiRootWheel[uiExpireTick & SCRIPT_TIMER_WHEEL_ROOT_MASK], uiSlot);
+		return;
+	}
+
+	// Find the finest wheel that covers the expiry
+	int iLevel = 0;
+	int iShift = SCRIPT_TIMER_WHEEL_ROOT_BITS;
+
+	while(iLevel < (SCRIPT_TIMER_WHEEL_LEVELS - 1) && uiDelta >= (1u << (iShift + SCRIPT_TIMER_WHEEL_LEVEL_BITS)))
+	{
+		iLevel++;
+		iShift += SCRIPT_TIMER_WHEEL_LEVEL_BITS;
+	}
+
+	Link(&m_uiLevelWheels[iLevel][(uiExpireTick >> iShift) & SCRIPT_TIMER_WHEEL_LEVEL_MASK], uiSlot);
+}
+
+void CScriptTimerManager::Cascade(int iLevel)
+{
+	// Move all timers of the current slot of this wheel down to the finer wheels
+	int iShift = (SCRIPT_TIMER_WHEEL_ROOT_BITS + (iLevel * SCRIPT_TIMER_WHEEL_LEVEL_BITS));
+	unsigned int * puiList = &m_uiLevelWheels[iLevel][(m_uiCurrentTick >> iShift) & SCRIPT_TIMER_WHEEL_LEVEL_MASK];
+
+	while(*puiList != INVALID_SCRIPT_TIMER_SLOT)
+	{
+		unsigned int uiSlot = *puiList;
+		Unlink(uiSlot);
+		Schedule(uiSlot, m_slots[uiSlot].uiExpireTick);
+	}
+}
+
+void CScriptTimerManager::Destroy(unsigned int uiSlot)
+{
+	ScriptTimerSlot * pSlot = &m_slots[uiSlot];
+	Unlink(uiSlot);
+	delete pSlot->pTimer;
+	pSlot->pTimer = NULL;
+
+	// Invalidate all handles to this slot (generation 0 is never used so no
+	// handle can be INVALID_SCRIPT_TIMER_HANDLE)
+	if(++pSlot->usGeneration == 0)
+		pSlot->usGeneration = 1;
+
+	m_freeSlots.push_back(uiSlot);
+	m_uiCount--;
+}
+
+ScriptTimerHandle CScriptTimerManager::Add(CScriptTimer * pTimer)
+{
+	unsigned int uiSlot;
+
+	if(!m_freeSlots.empty())
+	{
+		uiSlot = m_freeSlots.back();
+		m_freeSlots.pop_back();
+	}
+	else
+	{
+		if(m_slots.size() >= MAX_SCRIPT_TIMERS)
+			return INVALID_SCRIPT_TIMER_HANDLE;
+
+		ScriptTimerSlot slot;
+		slot.usGeneration = 1;
+		uiSlot = m_slots.size();
+		m_slots.push_back(slot);
+	}
+
+	ScriptTimerSlot * pSlot = &m_slots[uiSlot];
+	pSlot->pTimer = pTimer;
+	pSlot->puiList = NULL;
+	Schedule(uiSlot, pTimer->GetNextTick());
+	m_uiCount++;
+	return (((ScriptTimerHandle)pSlot->usGeneration << 16) | uiSlot);
+}
+
+CScriptTimer * CScriptTimerManager::Get(ScriptTimerHandle handle)
+{
+	unsigned int uiSlot = (handle & 0xFFFF);
+
+	if(uiSlot >= m_slots.size() || m_slots[uiSlot].usGeneration != (handle >> 16))
+		return NULL;
+
+	return m_slots[uiSlot].pTimer;
+}
+
+bool CScriptTimerManager::Kill(ScriptTimerHandle handle)
+{
+	CScriptTimer * pTimer = Get(handle);
+
+	if(!pTimer || pTimer->IsDead())
+		return false;
+
+	pTimer->Kill();
+
+	// A timer that kills itself is deleted once its function has returned
+	unsigned int uiSlot = (handle & 0xFFFF);
+
+	if(uiSlot != m_uiRunningSlot)
+		Destroy(uiSlot);
+
+	return true;
+}
+
 void CScriptTimerManager::Pulse()
 {
-	for(iterator iter = begin(); iter != end(); )
+	if(m_bPaused)
+		return;
+
+	unsigned int uiNow = SharedUtility::GetFrameTime();
+
+	// Process every tick since the last pulse, each tick only touches the
+	// timers that expire on it
+	while((int)(uiNow - m_uiCurrentTick) >= 0)
 	{
-		if(!(*iter)->Pulse())
+		unsigned int uiIndex = (m_uiCurrentTick & SCRIPT_TIMER_WHEEL_ROOT_MASK);
+
+		// Has the root wheel wrapped? if so refill it from the coarser wheels
+		if(uiIndex == 0)
+		{
+			for(int i = 0; i < SCRIPT_TIMER_WHEEL_LEVELS; i++)
+			{
+				Cascade(i);
+
+				if(((m_uiCurrentTick >> (SCRIPT_TIMER_WHEEL_ROOT_BITS + (i * SCRIPT_TIMER_WHEEL_LEVEL_BITS))) & SCRIPT_TIMER_WHEEL_LEVEL_MASK) != 0)
+					break;
+			}
+		}
+
+		// Move the expired timers out of the wheel first so timers which are
+		// rescheduled into the same slot don't run again on this tick
+		while(m_uiRootWheel[uiIndex] != INVALID_SCRIPT_TIMER_SLOT)
+		{
+			unsigned int uiSlot = m_uiRootWheel[uiIndex];
+			Unlink(uiSlot);
+			Link(&m_uiExpired, uiSlot);
+		}
+
+		m_uiCurrentTick++;
+
+		while(m_uiExpired != INVALID_SCRIPT_TIMER_SLOT)
 		{
-			delete *iter;
-			iter = erase(iter);
+			unsigned int uiSlot = m_uiExpired;
+			Unlink(uiSlot);
+
+			m_uiRunningSlot = uiSlot;
+			CScriptTimer * pTimer = m_slots[uiSlot].pTimer;
+			bool bActive = pTimer->Pulse(uiNow);
+			m_uiRunningSlot = INVALID_SCRIPT_TIMER_SLOT;
+
+			if(!bActive || pTimer->IsDead())
+			{
+				Destroy(uiSlot);
+				continue;
+			}
+
+			// Timers which are still behind run again on the next pulse
+			unsigned int uiNextTick = pTimer->GetNextTick();
+
+			if((int)(uiNextTick - uiNow) <= 0)
+				uiNextTick = (uiNow + 1);
+
+			Schedule(uiSlot, uiNextTick);
 		}
-		else
-			++ iter;
 	}
 }
 
-void CScriptTimerManager::HandleScriptUnload(CSquirrel * pScript)
+void CScriptTimerManager::Pause()
+{
+	if(m_bPaused)
+		return;
+
+	m_bPaused = true;
+	m_uiPauseTime = SharedUtility::GetFrameTime();
+}
+
+void CScriptTimerManager::Resume()
 {
-	for(iterator iter = begin(); iter != end(); )
+	if(!m_bPaused)
+		return;
+
+	m_bPaused = false;
+	unsigned int uiNow = SharedUtility::GetFrameTime();
+
+	// Take all timers out of the wheel as their slots belong to the old tick
+	for(unsigned int i = 0; i < m_slots.size(); i++)
 	{
-		if((*iter)->GetScript() == pScript)
-		{
-			delete *iter;
-			iter = erase(iter);
-		}
-		else
-			++ iter;
+		if(m_slots[i].pTimer)
+			Unlink(i);
+	}
+
+	m_uiCurrentTick = uiNow;
+
+	for(unsigned int i = 0; i < m_slots.size(); i++)
+	{
+		CScriptTimer * pTimer = m_slots[i].pTimer;
+
+		if(!pTimer)
+			continue;
+
+		// Timers that were started while paused are only delayed by the time since then
+		unsigned int uiPausedSince = m_uiPauseTime;
+
+		if((int)(pTimer->GetLastTick() - uiPausedSince) > 0)
+			uiPausedSince = pTimer->GetLastTick();
+
+		if((int)(uiNow - uiPausedSince) > 0)
+			pTimer->Delay(uiNow - uiPausedSince);
+
+		Schedule(i, pTimer->GetNextTick());
 	}
 }
 
-// this basically means the CScriptTimer* pointer is valid as well
-bool CScriptTimerManager::contains(CScriptTimer* pTimer)
+void CScriptTimerManager::HandleScriptUnload(CSquirrel * pScript)
 {
-	for(iterator iter = begin(); iter != end(); ++ iter)
-		if((*iter) == pTimer)
-			return true;
+	for(unsigned int i = 0; i < m_slots.size(); i++)
+	{
+		CScriptTimer * pTimer = m_slots[i].pTimer;
 
-	return false;
+		if(pTimer && pTimer->GetScript() == pScript)
+		{
+			// The running timer is deleted once its function has returned
+			if(i == m_uiRunningSlot)
+				pTimer->Kill();
+			else
+				Destroy(i);
+		}
+	}
 }
@@ -14,12 +14,74 @@
 
 #include "CScriptingManager.h"
 #include "CScriptTimer.h"
-#include <list>
+#include <vector>
 
-class CScriptTimerManager : public std::list<CScriptTimer *>
+// The timer wheel has a root wheel with one slot per ms and 3 coarser wheels
+// above it, timers with an expiry further away than the last wheel covers
+// (~18 hours) are put into its last slot and rescheduled from there
+#define SCRIPT_TIMER_WHEEL_ROOT_BITS 8
+#define SCRIPT_TIMER_WHEEL_LEVEL_BITS 6
+#define SCRIPT_TIMER_WHEEL_LEVELS 3
+#define SCRIPT_TIMER_WHEEL_ROOT_SIZE (1 << SCRIPT_TIMER_WHEEL_ROOT_BITS)
+#define SCRIPT_TIMER_WHEEL_LEVEL_SIZE (1 << SCRIPT_TIMER_WHEEL_LEVEL_BITS)
+#define SCRIPT_TIMER_WHEEL_ROOT_MASK (SCRIPT_TIMER_WHEEL_ROOT_SIZE - 1)
+#define SCRIPT_TIMER_WHEEL_LEVEL_MASK (SCRIPT_TIMER_WHEEL_LEVEL_SIZE - 1)
+#define SCRIPT_TIMER_WHEEL_MAX_DELTA (1 << (SCRIPT_TIMER_WHEEL_ROOT_BITS + (SCRIPT_TIMER_WHEEL_LEVEL_BITS * SCRIPT_TIMER_WHEEL_LEVELS)))
+
+// Handles are the slot index in the low 16 bits and the generation of the
+// slot in the high 16 bits so handles of deleted timers are never valid
+typedef unsigned int ScriptTimerHandle;
+
+#define INVALID_SCRIPT_TIMER_HANDLE 0
+#define MAX_SCRIPT_TIMERS 0xFFFF
+#define INVALID_SCRIPT_TIMER_SLOT 0xFFFFFFFF
+
+// A single timer slot, slots are linked into the wheel slot (or expired list)
+// they are waiting in
+struct ScriptTimerSlot
+{
+	CScriptTimer * pTimer;
+	unsigned short usGeneration;
+	unsigned int   uiExpireTick;
+	unsigned int * puiList;
+	unsigned int   uiPrevious;
+	unsigned int   uiNext;
+};
+
+class CScriptTimerManager
 {
+private:
+	std::vector<ScriptTimerSlot> m_slots;
+	std::vector<unsigned int>    m_freeSlots;
+	unsigned int                 m_uiRootWheel[SCRIPT_TIMER_WHEEL_ROOT_SIZE];
+	unsigned int                 m_uiLevelWheels[SCRIPT_TIMER_WHEEL_LEVELS][SCRIPT_TIMER_WHEEL_LEVEL_SIZE];
+	unsigned int                 m_uiExpired;
+	unsigned int                 m_uiCurrentTick;
+	unsigned int                 m_uiRunningSlot;
+	unsigned int                 m_uiCount;
+	bool                         m_bPaused;
+	unsigned int                 m_uiPauseTime;
+
+	void                         Link(unsigned int * puiList, unsigned int uiSlot);
+	void                         Unlink(unsigned int uiSlot);
+	void                         Schedule(unsigned int uiSlot, unsigned int uiExpireTick);
+	void                         Cascade(int iLevel);
+	void                         Destroy(unsigned int uiSlot);
+
 public:
-	void Pulse();
-	void HandleScriptUnload(CSquirrel * pScript);
-	bool contains(CScriptTimer* pTimer);
+	CScriptTimerManager();
+	~CScriptTimerManager();
+
+	ScriptTimerHandle            Add(CScriptTimer * pTimer);
+	CScriptTimer               * Get(ScriptTimerHandle handle);
+	bool                         Kill(ScriptTimerHandle handle);
+	unsigned int                 GetCount() { return m_uiCount; }
+	void                         Pulse();
+
+	// No timer runs while the timers are paused, once they are resumed they
+	// run as if the time in between never passed
+	bool                         IsPaused() { return m_bPaused; }
+	void                         Pause();
+	void                         Resume();
+	void                         HandleScriptUnload(CSquirrel * pScript);
 };
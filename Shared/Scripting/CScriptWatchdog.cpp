@@ -0,0 +1,242 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptWatchdog.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CScriptingManager.h"
+#include "CScriptWatchdog.h"
+#include "../SharedUtility.h"
+#include "../CLogFile.h"
+
+extern CScriptingManager * g_pScriptingManager;
+
+CScriptWatchdog * g_pScriptWatchdog = NULL;
+
+CScriptWatchdog::CScriptWatchdog(unsigned int uiCallBudget, unsigned int uiTickBudget, bool bDeferEvents)
+{
+	// The budgets are given in ms but all times are kept in microseconds
+	m_ullCallBudget = ((unsigned long long)uiCallBudget * 1000);
+	m_ullTickBudget = ((unsigned long long)uiTickBudget * 1000);
+	m_bDeferEvents = (bDeferEvents && uiTickBudget > 0);
+	m_uiHookEvents = 0;
+}
+
+CScriptWatchdog::~CScriptWatchdog()
+{
+
+}
+
+ScriptWatchdogUsage * CScriptWatchdog::GetUsage(SQVM * pVM)
+{
+	std::map<SQVM *, ScriptWatchdogUsage>::iterator iter = m_usage.find(pVM);
+
+	if(iter == m_usage.end())
+	{
+		ScriptWatchdogUsage usage;
+		memset(&usage, 0, sizeof(usage));
+		iter = m_usage.insert(std::pair<SQVM *, ScriptWatchdogUsage>(pVM, usage)).first;
+	}
+
+	return &(*iter).second;
+}
+
+String CScriptWatchdog::GetScriptName(SQVM * pVM)
+{
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+
+	if(!pScript)
+		return "unknown";
+
+	return pScript->GetName();
+}
+
+void CScriptWatchdog::OnDebugHook(SQVM * pVM, SQInteger iType)
+{
+	// Only check the time every few events as getting it isn't free
+	if(++m_uiHookEvents < SCRIPT_WATCHDOG_CHECK_INTERVAL)
+		return;
+
+	m_uiHookEvents = 0;
+
+	if(m_calls.empty() || !m_calls.back().pUsage)
+		return;
+
+	ScriptWatchdogCall * pCall = &m_calls.back();
+	unsigned long long ullTime = (SharedUtility::GetMicroseconds() - pCall->ullStartTime);
+
+	if(ullTime <= m_ullCallBudget)
+		return;
+
+	// The script keeps getting interrupted until the call returns in case
+	// it catches the error
+	pCall->pUsage->uiInterruptions++;
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	if((ulTime - pCall->pUsage->ulLastWarningTime) >= SCRIPT_WATCHDOG_WARNING_INTERVAL)
+	{
+		CLogFile::Printf("Script %s has been running for %.2f ms (budget %.2f ms), interrupting it.", GetScriptName(pCall->pVM).Get(),
+			(ullTime / 1000.0), (m_ullCallBudget / 1000.0));
+		pCall->pUsage->ulLastWarningTime = ulTime;
+	}
+
+	sq_interrupt(pVM);
+}
+
+void CScriptWatchdog::EnterCall(SQVM * pVM)
+{
+	ScriptWatchdogCall call;
+	call.pVM = pVM;
+	call.pUsage = GetUsage(pVM);
+	call.ullChildTime = 0;
+	call.ullStartTime = SharedUtility::GetMicroseconds();
+	m_calls.push_back(call);
+}
+
+void CScriptWatchdog::LeaveCall()
+{
+	if(m_calls.empty())
+		return;
+
+	ScriptWatchdogCall call = m_calls.back();
+	m_calls.pop_back();
+	unsigned long long ullTime = (SharedUtility::GetMicroseconds() - call.ullStartTime);
+
+	// Calls into other scripts count for those scripts
+	if(!m_calls.empty())
+		m_calls.back().ullChildTime += ullTime;
+
+	// Was the script unloaded during the call?
+	if(!call.pUsage)
+		return;
+
+	call.pUsage->ullTickTime += (ullTime > call.ullChildTime ? (ullTime - call.ullChildTime) : 0);
+
+	// Calls that went over budget without being interrupted (e.g. in a native)
+	// are only logged
+	if(m_ullCallBudget > 0 && ullTime > m_ullCallBudget)
+	{
+		unsigned long ulTime = SharedUtility::GetTime();
+
+		if((ulTime - call.pUsage->ulLastWarningTime) >= SCRIPT_WATCHDOG_WARNING_INTERVAL)
+		{
+			CLogFile::Printf("Script %s took %.2f ms for a single call (budget %.2f ms).", GetScriptName(call.pVM).Get(), (ullTime / 1000.0),
+				(m_ullCallBudget / 1000.0));
+			call.pUsage->ulLastWarningTime = ulTime;
+		}
+	}
+}
+
+bool CScriptWatchdog::Defer(SQVM * pVM, SQObjectPtr pFunction, CSquirrelArguments * pArguments)
+{
+	if(!m_bDeferEvents || !pVM)
+		return false;
+
+	ScriptWatchdogUsage * pUsage = GetUsage(pVM);
+
+	// Is the script within its budget for this tick?
+	if(pUsage->ullTickTime <= m_ullTickBudget)
+		return false;
+
+	// If too many events are waiting drop the event as they are only sync
+	// events and a newer one will come
+	pUsage->uiDeferredEvents++;
+
+	if(m_deferredEvents.size() >= SCRIPT_WATCHDOG_MAX_DEFERRED_EVENTS)
+		return true;
+
+	ScriptWatchdogDeferredEvent deferredEvent;
+	deferredEvent.pVM = pVM;
+	deferredEvent.pFunction = pFunction;
+	m_deferredEvents.push_back(deferredEvent);
+
+	if(pArguments)
+		m_deferredEvents.back().arguments = *pArguments;
+
+	return true;
+}
+
+void CScriptWatchdog::RemoveEvents(std::list<ScriptWatchdogDeferredEvent> * pEvents, SQVM * pVM)
+{
+	for(std::list<ScriptWatchdogDeferredEvent>::iterator iter = pEvents->begin(); iter != pEvents->end(); )
+	{
+		if((*iter).pVM == pVM)
+			iter = pEvents->erase(iter);
+		else
+			iter++;
+	}
+}
+
+void CScriptWatchdog::RemoveScript(SQVM * pVM)
+{
+	// The deferred events hold references to objects of the script so they
+	// must go before the script does
+	RemoveEvents(&m_deferredEvents, pVM);
+	RemoveEvents(&m_processingEvents, pVM);
+
+	for(std::vector<ScriptWatchdogCall>::iterator iter = m_calls.begin(); iter != m_calls.end(); iter++)
+	{
+		if((*iter).pVM == pVM)
+			(*iter).pUsage = NULL;
+	}
+
+	m_usage.erase(pVM);
+}
+
+void CScriptWatchdog::Process()
+{
+	unsigned long ulTime = SharedUtility::GetTime();
+
+	// Log all scripts that went over their budget during the last tick and
+	// start the new tick
+	for(std::map<SQVM *, ScriptWatchdogUsage>::iterator iter = m_usage.begin(); iter != m_usage.end(); iter++)
+	{
+		ScriptWatchdogUsage * pUsage = &(*iter).second;
+
+		if(m_ullTickBudget > 0 && pUsage->ullTickTime > m_ullTickBudget)
+		{
+			pUsage->uiOverBudgetTicks++;
+
+			if((ulTime - pUsage->ulLastWarningTime) >= SCRIPT_WATCHDOG_WARNING_INTERVAL)
+			{
+				CLogFile::Printf("Script %s took %.2f ms in a single tick (budget %.2f ms, %d tick(s) over budget, %d event(s) deferred).",
+					GetScriptName((*iter).first).Get(), (pUsage->ullTickTime / 1000.0), (m_ullTickBudget / 1000.0), pUsage->uiOverBudgetTicks,
+					pUsage->uiDeferredEvents);
+				pUsage->ulLastWarningTime = ulTime;
+				pUsage->uiOverBudgetTicks = 0;
+				pUsage->uiDeferredEvents = 0;
+			}
+		}
+
+		pUsage->ullTickTime = 0;
+	}
+
+	if(m_deferredEvents.empty())
+		return;
+
+	// Call the events that were deferred during the last tick, scripts that
+	// go over their budget again keep the rest for the next tick (the events
+	// are kept in a member so RemoveScript can remove them while we call them)
+	m_processingEvents.swap(m_deferredEvents);
+
+	while(!m_processingEvents.empty())
+	{
+		ScriptWatchdogDeferredEvent deferredEvent = m_processingEvents.front();
+		m_processingEvents.pop_front();
+		CSquirrel * pScript = g_pScriptingManager->Get(deferredEvent.pVM);
+
+		if(!pScript)
+			continue;
+
+		if(GetUsage(deferredEvent.pVM)->ullTickTime > m_ullTickBudget)
+		{
+			m_deferredEvents.push_back(deferredEvent);
+			continue;
+		}
+
+		pScript->Call(deferredEvent.pFunction, &deferredEvent.arguments);
+	}
+}
@@ -0,0 +1,87 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CScriptWatchdog.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <vector>
+#include "CSquirrel.h"
+
+// Amount of debug hook events between two checks of the call budget
+#define SCRIPT_WATCHDOG_CHECK_INTERVAL 256
+
+// Maximum amount of events that can be waiting for the next tick
+#define SCRIPT_WATCHDOG_MAX_DEFERRED_EVENTS 4096
+
+// Minimum time in ms between two over budget warnings of the same script
+#define SCRIPT_WATCHDOG_WARNING_INTERVAL 5000
+
+// Time used by a single script
+struct ScriptWatchdogUsage
+{
+	unsigned long long ullTickTime;
+	unsigned int       uiOverBudgetTicks;
+	unsigned int       uiDeferredEvents;
+	unsigned int       uiInterruptions;
+	unsigned long      ulLastWarningTime;
+};
+
+// A script call that is currently running
+struct ScriptWatchdogCall
+{
+	SQVM *               pVM;
+	ScriptWatchdogUsage * pUsage;
+	unsigned long long   ullStartTime;
+	unsigned long long   ullChildTime;
+};
+
+// An event that was deferred to the next tick
+struct ScriptWatchdogDeferredEvent
+{
+	SQVM *             pVM;
+	SQObjectPtr        pFunction;
+	CSquirrelArguments arguments;
+};
+
+// Limits the time scripts can take per call and per tick. Calls that go
+// over the call budget are interrupted from the debug hook, which is also
+// called for every loop iteration so endless loops can be stopped.
+// Scripts that go over the tick budget can have their sync events deferred
+// to the next tick.
+class CScriptWatchdog
+{
+private:
+	unsigned long long                          m_ullCallBudget;
+	unsigned long long                          m_ullTickBudget;
+	bool                                        m_bDeferEvents;
+	unsigned int                                m_uiHookEvents;
+	std::map<SQVM *, ScriptWatchdogUsage>       m_usage;
+	std::vector<ScriptWatchdogCall>             m_calls;
+	std::list<ScriptWatchdogDeferredEvent>      m_deferredEvents;
+	std::list<ScriptWatchdogDeferredEvent>      m_processingEvents;
+
+	ScriptWatchdogUsage * GetUsage(SQVM * pVM);
+	String                GetScriptName(SQVM * pVM);
+	void                  RemoveEvents(std::list<ScriptWatchdogDeferredEvent> * pEvents, SQVM * pVM);
+
+public:
+	CScriptWatchdog(unsigned int uiCallBudget, unsigned int uiTickBudget, bool bDeferEvents);
+	~CScriptWatchdog();
+
+	bool                  IsInterruptEnabled() { return (m_ullCallBudget > 0); }
+	void                  OnDebugHook(SQVM * pVM, SQInteger iType);
+	void                  EnterCall(SQVM * pVM);
+	void                  LeaveCall();
+	bool                  Defer(SQVM * pVM, SQObjectPtr pFunction, CSquirrelArguments * pArguments);
+	void                  RemoveScript(SQVM * pVM);
+	void                  Process();
+};
+
+extern CScriptWatchdog * g_pScriptWatchdog;
@@ -14,16 +14,38 @@
 #include "CScriptingManager.h"
 #include "../CEvents.h"
 #include "../CLogFile.h"
+#include "../Threading/CJobSystem.h"
+#include "CScriptTimerManager.h"
+#include "CScriptProfiler.h"
+#include "CScriptWatchdog.h"
+#include "CSharedData.h"
+#include "CScriptAllocator.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include <Squirrel/sqtable.h>
+#include <Squirrel/sqstring.h>
+#include <Squirrel/sqfuncproto.h>
+#include <Squirrel/sqclosure.h>
+#include <Squirrel/sqclass.h>
 #include <Common.h>
+#include <SharedUtility.h>
+#include <algorithm>
+#include <map>
 
 // FIXUPDATE
 // jenksta: HACKY!!!
 #ifdef _SERVER
 #include "../../Server/Core/CModuleManager.h"
 extern CModuleManager * g_pModuleManager;
+#include "../../Server/Core/CCommandManager.h"
+extern CCommandManager * g_pCommandManager;
+#include "../../Server/Core/CInstanceManager.h"
+extern CInstanceManager * g_pInstanceManager;
 #endif
 
 extern CEvents* g_pEvents;
+extern CScriptTimerManager * g_pScriptTimerManager;
+extern CScriptingManager * g_pScriptingManager;
 
 #if 0
 #include <SharedUtility.h>
@@ -665,7 +687,15 @@ CSquirrelArgument TestNative(CNewSquirrel * pSquirrel, CSquirrelArguments * pArg
 }
 #endif
 
-CSquirrel * CScriptingManager::Load(String strName, String strPath)
+CScriptingManager::CScriptingManager()
+	: m_uiGCInterval(SQUIRREL_GC_INTERVAL),
+	m_uiNextGCScript(0),
+	m_uiNextCoroutineId(1)
+{
+
+}
+
+CSquirrel * CScriptingManager::Create(String strName, String strPath)
 {
 #if 0
 	if(bFirstLoad)
@@ -696,16 +726,17 @@ CSquirrel * CScriptingManager::Load(String strName, String strPath)
 		return NULL;
 	}
 
+	pScript->SetGCInterval(m_uiGCInterval);
 	m_scripts.push_back(pScript);
+	m_vmScripts[pScript->GetVM()] = pScript;
 
-	if(m_funcs.size() > 0)
-	{
-		std::list<ScriptingFunction *>::iterator iter;
+	// A new version of a script keeps the old one in the name lookup until it replaces it
+	if(m_namedScripts.find(strName) == m_namedScripts.end())
+		m_namedScripts[strName] = pScript;
 
-		for(iter = m_funcs.begin(); iter != m_funcs.end(); iter++)
-			pScript->RegisterFunction((*iter)->strName, (*iter)->pfnFunction, (*iter)->iParameterCount, 
-			(*iter)->strTemplate);
-	}
+	// The natives, classes and constants are only created in the vm once the
+	// script uses them, so creating it doesn't take longer with every native
+	sq_setrootmissfunc(pScript->GetVM(), BindGlobal);
 
 #if 0
 	pScript->RegisterClass(&_CLASS_DECL(testClass));
@@ -750,31 +781,68 @@ CSquirrel * CScriptingManager::Load(String strName, String strPath)
 	}
 #endif
 
-	if(m_classes.size() > 0)
-	{
-		std::list<SquirrelClassDecl *>::iterator iter;
-
-		for(iter = m_classes.begin(); iter != m_classes.end(); iter++)
-			pScript->RegisterClass(*iter);
-	}
+#ifdef _SERVER
+	if(g_pModuleManager)
+		g_pModuleManager->ScriptLoad(pScript->GetVM());
+#endif
 
-	if(m_constants.size() > 0)
-	{
-		std::list<ScriptingConstant *>::iterator iter;
+	return pScript;
+}
 
-		for(iter = m_constants.begin(); iter != m_constants.end(); iter++)
-			pScript->RegisterConstant((*iter)->strName, (*iter)->value);
-	}
+void CScriptingManager::Remove(CSquirrel * pScript)
+{
+	g_pEvents->RemoveScript(pScript->GetVM());
 
 #ifdef _SERVER
 	if(g_pModuleManager)
-		g_pModuleManager->ScriptLoad(pScript->GetVM());
+		g_pModuleManager->ScriptUnload(pScript->GetVM());
+
+	if(g_pCommandManager)
+		g_pCommandManager->RemoveScript(pScript->GetVM());
+
+	if(g_pInstanceManager)
+		g_pInstanceManager->RemoveScript(pScript->GetVM());
 #endif
 
-	if(!pScript->Execute())
+	// The threads of the coroutines have to be released before their vm is closed
+	DeleteCoroutines(pScript);
+
+	// Release hooks can still look the script up while it unloads
+	SQVM * pVM = pScript->GetVM();
+	pScript->Unload();
+	m_scripts.remove(pScript);
+	m_vmScripts.erase(pVM);
+
+	// Another script with the same name takes its place in the name lookup
+	std::map<String, CSquirrel *>::iterator nameIter = m_namedScripts.find(pScript->GetName());
+
+	if(nameIter != m_namedScripts.end() && (*nameIter).second == pScript)
 	{
-		delete pScript;
-		m_scripts.remove(pScript);
+		m_namedScripts.erase(nameIter);
+
+		for(std::list<CSquirrel *>::iterator iter = m_scripts.begin(); iter != m_scripts.end(); iter++)
+		{
+			if((*iter)->GetName() == pScript->GetName())
+			{
+				m_namedScripts[(*iter)->GetName()] = (*iter);
+				break;
+			}
+		}
+	}
+
+	delete pScript;
+}
+
+CSquirrel * CScriptingManager::Load(String strName, String strPath, const SquirrelCompiledScript * pCompiledScript)
+{
+	CSquirrel * pScript = Create(strName, strPath);
+
+	if(!pScript)
+		return NULL;
+
+	if(!pScript->Execute(pCompiledScript))
+	{
+		Remove(pScript);
 		return NULL;
 	}
 
@@ -786,24 +854,62 @@ CSquirrel * CScriptingManager::Load(String strName, String strPath)
 	return pScript;
 }
 
-bool CScriptingManager::Unload(String strName)
+static void CompileScriptJob(void * pUserData)
 {
-	CSquirrel * pScript = NULL;
+	CSquirrel::Compile((SquirrelCompiledScript *)pUserData);
+}
 
-	if(m_scripts.size() > 0)
+std::vector<CSquirrel *> CScriptingManager::Load(const std::vector<String>& names, const std::vector<String>& paths, CJobSystem * pJobSystem)
+{
+	std::vector<CSquirrel *> scripts(names.size(), (CSquirrel *)NULL);
+
+	if(!pJobSystem)
 	{
-		std::list<CSquirrel *>::iterator iter;
+		for(size_t i = 0; i < names.size(); i++)
+			scripts[i] = Load(names[i], paths[i]);
 
-		for(iter = m_scripts.begin(); iter != m_scripts.end(); iter++)
+		return scripts;
+	}
+
+	// A script that is loaded more than once is only compiled once
+	std::vector<SquirrelCompiledScript> compiledScripts;
+	std::vector<size_t> compiledIndices(names.size());
+	std::map<String, size_t> pathIndices;
+
+	for(size_t i = 0; i < paths.size(); i++)
+	{
+		std::map<String, size_t>::iterator iter = pathIndices.find(paths[i]);
+
+		if(iter == pathIndices.end())
 		{
-			if((*iter)->GetName() == strName)
-			{
-				pScript = (*iter);
-				break;
-			}
+			iter = pathIndices.insert(std::pair<String, size_t>(paths[i], compiledScripts.size())).first;
+			compiledScripts.push_back(SquirrelCompiledScript());
+			compiledScripts.back().strPath = paths[i];
 		}
+
+		compiledIndices[i] = (*iter).second;
 	}
 
+	// Each script has its own counter so the first ones can run while the others compile
+	CJobCounter * pCounters = new CJobCounter[compiledScripts.size()];
+
+	for(size_t i = 0; i < compiledScripts.size(); i++)
+		pJobSystem->Add(CompileScriptJob, &compiledScripts[i], &pCounters[i]);
+
+	for(size_t i = 0; i < names.size(); i++)
+	{
+		pJobSystem->Wait(&pCounters[compiledIndices[i]]);
+		scripts[i] = Load(names[i], paths[i], &compiledScripts[compiledIndices[i]]);
+	}
+
+	delete [] pCounters;
+	return scripts;
+}
+
+bool CScriptingManager::Unload(String strName)
+{
+	CSquirrel * pScript = Get(strName);
+
 	if(pScript)
 	{
 		g_pEvents->Call("scriptExit", pScript);
@@ -811,24 +917,58 @@ bool CScriptingManager::Unload(String strName)
 		CSquirrelArguments pArguments;
 		pArguments.push(strName);
 		g_pEvents->Call("scriptUnload", &pArguments);
-		g_pEvents->RemoveScript(pScript->GetVM());
-		
-#ifdef _SERVER
-		if(g_pModuleManager)
-			g_pModuleManager->ScriptUnload(pScript->GetVM());
-#endif
-
-		pScript->Unload();
-		m_scripts.remove(pScript);
-		delete pScript;
+		Remove(pScript);
 		return true;
 	}
 
 	return false;
 }
 
+CSquirrel * CScriptingManager::Reload(CSquirrel * pScript, const SquirrelCompiledScript * pCompiledScript, CSquirrelArgument * pMigratedState)
+{
+	std::list<CSquirrel *>::iterator iter = std::find(m_scripts.begin(), m_scripts.end(), pScript);
+
+	if(iter == m_scripts.end())
+		return NULL;
+
+	// The new version is executed while the old one still handles the events,
+	// if it fails the old one keeps running as if nothing happened
+	CSquirrel * pNewScript = Create(pScript->GetName(), pScript->GetPath());
+
+	if(!pNewScript)
+		return NULL;
+
+	pNewScript->SetMigratedState(pMigratedState);
+	bool bExecuted = pNewScript->Execute(pCompiledScript);
+	pNewScript->SetMigratedState(NULL);
+
+	if(!bExecuted)
+	{
+		Remove(pNewScript);
+		return NULL;
+	}
+
+	// Take the place of the old version so the events are called in the same order
+	m_scripts.remove(pNewScript);
+	m_scripts.insert(iter, pNewScript);
+	m_namedScripts[pNewScript->GetName()] = pNewScript;
+
+	// The old version is gone before anything else can call its events or timers
+	g_pEvents->Call("scriptExit", pScript);
+
+	if(g_pScriptTimerManager)
+		g_pScriptTimerManager->HandleScriptUnload(pScript);
+
+	Remove(pScript);
+	g_pEvents->Call("scriptInit", pNewScript);
+	return pNewScript;
+}
+
 void CScriptingManager::UnloadAll()
 {
+	while(!m_coroutines.empty())
+		DeleteCoroutine((*m_coroutines.begin()).second);
+
 	if(m_scripts.size() > 0)
 	{
 		std::list<CSquirrel*>::iterator iter;
@@ -837,6 +977,52 @@ void CScriptingManager::UnloadAll()
 			(*iter)->Unload();
 	}
 	m_scripts.clear();
+	m_vmScripts.clear();
+	m_namedScripts.clear();
+
+	// The shared data belongs to the scripts that set it
+	CSharedData::RemoveAll();
+}
+
+void CScriptingManager::CollectGarbage(unsigned int uiBudget)
+{
+	if(m_scripts.empty() || uiBudget == 0)
+		return;
+
+	unsigned long long ullStartTime = SharedUtility::GetMicroseconds();
+	unsigned long ulTime = SharedUtility::GetTime();
+	unsigned int uiScriptCount = m_scripts.size();
+
+	if(m_uiNextGCScript >= uiScriptCount)
+		m_uiNextGCScript = 0;
+
+	std::list<CSquirrel *>::iterator iter = m_scripts.begin();
+	std::advance(iter, m_uiNextGCScript);
+
+	for(unsigned int i = 0; i < uiScriptCount; i++)
+	{
+		unsigned int uiElapsed = (unsigned int)(SharedUtility::GetMicroseconds() - ullStartTime);
+
+		if(uiElapsed >= uiBudget)
+			break;
+
+		CSquirrel * pScript = (*iter);
+		m_uiNextGCScript = ((m_uiNextGCScript + 1) % uiScriptCount);
+
+		if(++iter == m_scripts.end())
+			iter = m_scripts.begin();
+
+		unsigned int uiInterval = pScript->GetGCInterval();
+		unsigned long ulSinceCollection = (ulTime - pScript->GetLastGCTime());
+
+		if(uiInterval == 0 || ulSinceCollection < uiInterval)
+			continue;
+
+		if(pScript->GetGCStats().uiLastTime > (uiBudget - uiElapsed) && ulSinceCollection < (uiInterval * 2))
+			continue;
+
+		pScript->CollectGarbage();
+	}
 }
 
 void CScriptingManager::RegisterFunction(String strFunctionName, SQFUNCTION pfnFunction, int iParameterCount, String strFunctionTemplate)
@@ -847,6 +1033,7 @@ void CScriptingManager::RegisterFunction(String strFunctionName, SQFUNCTION pfnF
 	pFunction->iParameterCount = iParameterCount;
 	pFunction->strTemplate = strFunctionTemplate;
 	m_funcs.push_back(pFunction);
+	AddGlobal(strFunctionName, pFunction, NULL, NULL);
 
 	if(m_scripts.size() > 0)
 	{
@@ -860,6 +1047,7 @@ void CScriptingManager::RegisterFunction(String strFunctionName, SQFUNCTION pfnF
 void CScriptingManager::RegisterClass(SquirrelClassDecl * pClassDeclaration)
 {
 	m_classes.push_back(pClassDeclaration);
+	AddGlobal(pClassDeclaration->name, NULL, pClassDeclaration, NULL);
 
 	if(m_scripts.size() > 0)
 	{
@@ -876,6 +1064,7 @@ void CScriptingManager::RegisterConstant(String strConstantName, CSquirrelArgume
 	pConstant->strName = strConstantName;
 	pConstant->value = value;
 	m_constants.push_back(pConstant);
+	AddGlobal(strConstantName, NULL, NULL, pConstant);
 
 	if(m_scripts.size() > 0)
 	{
@@ -886,6 +1075,122 @@ void CScriptingManager::RegisterConstant(String strConstantName, CSquirrelArgume
 	}
 }
 
+void CScriptingManager::AddGlobal(const String& strName, ScriptingFunction * pFunction, SquirrelClassDecl * pClass, ScriptingConstant * pConstant)
+{
+	// A later registration of a name replaces the earlier one like it does in the vms
+	ScriptingGlobal global;
+	global.pFunction = pFunction;
+	global.pClass = pClass;
+	global.pConstant = pConstant;
+	m_globals[strName] = global;
+}
+
+// The globals are created without the stack of the vm as the lookup that misses
+// them can have its key and result on it
+
+static SQNativeClosure * CreateNative(SQSharedState * pSharedState, SQFUNCTION pfnFunction, int iParameterCount, const char * szTemplate)
+{
+	SQNativeClosure * pClosure = SQNativeClosure::Create(pSharedState, pfnFunction);
+	pClosure->_nparamscheck = 0;
+
+	// The same checks CSquirrel::RegisterFunction sets
+	if(iParameterCount != -1)
+	{
+		pClosure->_nparamscheck = (iParameterCount + 1);
+
+		if(szTemplate && szTemplate[0])
+		{
+			String strTypeMask(".%s", szTemplate);
+			CompileTypemask(pClosure->_typecheck, strTypeMask.Get());
+		}
+	}
+
+	return pClosure;
+}
+
+static bool CreateClass(SQVM * pVM, SquirrelClassDecl * pClassDecl, SQObjectPtr& pClass)
+{
+	SQSharedState * pSharedState = _ss(pVM);
+	SQClass * pBaseClass = NULL;
+
+	if(pClassDecl->base)
+	{
+		// The base class is created first if the script didn't use it yet
+		SQTable * pRootTable = _table(pVM->_roottable);
+		SQObjectPtr baseName(SQString::Create(pSharedState, pClassDecl->base));
+		SQObjectPtr pBase;
+
+		if(!pRootTable->Get(baseName, pBase) && CScriptingManager::BindGlobal(pVM, pClassDecl->base))
+			pRootTable->Get(baseName, pBase);
+
+		if(type(pBase) != OT_CLASS)
+			return false;
+
+		pBaseClass = _class(pBase);
+	}
+
+	SQClass * pNewClass = SQClass::Create(pSharedState, pBaseClass);
+	pClass = SQObjectPtr(pNewClass);
+	const ScriptClassMemberDecl * pMembers = pClassDecl->members;
+
+	for(int x = 0; pMembers[x].szFunctionName; x++)
+	{
+		SQObjectPtr memberName(SQString::Create(pSharedState, pMembers[x].szFunctionName));
+		SQObjectPtr member(CreateNative(pSharedState, pMembers[x].sqFunc, pMembers[x].iParameterCount, pMembers[x].szFunctionTemplate));
+		pNewClass->NewSlot(pSharedState, memberName, member, false);
+	}
+
+	return true;
+}
+
+SQBool CScriptingManager::BindGlobal(SQVM * pVM, const SQChar * szName)
+{
+	std::map<String, ScriptingGlobal>::iterator iter = g_pScriptingManager->m_globals.find(szName);
+
+	if(iter == g_pScriptingManager->m_globals.end())
+		return SQFalse;
+
+	SQSharedState * pSharedState = _ss(pVM);
+	ScriptingGlobal& global = (*iter).second;
+	SQObjectPtr value;
+
+	if(global.pFunction)
+		value = SQObjectPtr(CreateNative(pSharedState, global.pFunction->pfnFunction, global.pFunction->iParameterCount, global.pFunction->strTemplate.Get()));
+	else if(global.pClass)
+	{
+		if(!CreateClass(pVM, global.pClass, value))
+			return SQFalse;
+	}
+	else
+	{
+		// Only plain values can be created without the stack
+		const CSquirrelArgument& constant = global.pConstant->value;
+
+		switch(constant.GetType())
+		{
+		case OT_NULL:
+			break;
+		case OT_INTEGER:
+			value = SQObjectPtr((SQInteger)constant.GetInteger());
+			break;
+		case OT_FLOAT:
+			value = SQObjectPtr((SQFloat)constant.GetFloat());
+			break;
+		case OT_BOOL:
+			value = SQObjectPtr(constant.GetBool());
+			break;
+		case OT_STRING:
+			value = SQObjectPtr(SQString::Create(pSharedState, constant.GetString()));
+			break;
+		default:
+			return SQFalse;
+		}
+	}
+
+	_table(pVM->_roottable)->NewSlot(SQObjectPtr(SQString::Create(pSharedState, szName)), value);
+	return SQTrue;
+}
+
 void CScriptingManager::RegisterDefaultConstants()
 {
 	RegisterConstant("MAX_PLAYERS", MAX_PLAYERS);
@@ -908,31 +1213,246 @@ void CScriptingManager::RegisterDefaultConstants()
 
 CSquirrel * CScriptingManager::Get(String strName)
 {
-	if(m_scripts.size() > 0)
-	{
-		std::list<CSquirrel *>::iterator iter;
+	std::map<String, CSquirrel *>::iterator iter = m_namedScripts.find(strName);
 
-		for(iter = m_scripts.begin(); iter != m_scripts.end(); iter++)
-		{
-			if((*iter)->GetName() == strName)
-				return (*iter);
-		}
-	}
+	if(iter != m_namedScripts.end())
+		return (*iter).second;
 
 	return NULL;
 }
 
 CSquirrel * CScriptingManager::Get(SQVM * pVM)
 {
-	if(m_scripts.size() > 0)
+	std::map<SQVM *, CSquirrel *>::iterator iter = m_vmScripts.find(pVM);
+
+	if(iter != m_vmScripts.end())
+		return (*iter).second;
+
+	return NULL;
+}
+
+bool CScriptingManager::PushCachedString(SQVM * pVM, const void * pKey, const char * szString)
+{
+	CSquirrel * pScript = Get(GetScriptVM(pVM));
+
+	if(pScript)
+		return pScript->PushCachedString(pVM, pKey, szString);
+
+	if(!szString)
+		return false;
+
+	sq_pushstring(pVM, szString, -1);
+	return true;
+}
+
+void CScriptingManager::InvalidateCachedString(const void * pKey)
+{
+	for(std::list<CSquirrel *>::iterator iter = m_scripts.begin(); iter != m_scripts.end(); iter++)
+		(*iter)->RemoveCachedString(pKey);
+}
+
+SQVM * CScriptingManager::GetScriptVM(SQVM * pVM)
+{
+	std::map<SQVM *, ScriptCoroutine *>::iterator iter = m_vmCoroutines.find(pVM);
+
+	if(iter != m_vmCoroutines.end())
+		return (*iter).second->pScript->GetVM();
+
+	return pVM;
+}
+
+bool CScriptingManager::StartCoroutine(CSquirrel * pScript, SQObjectPtr pFunction, CSquirrelArguments * pArguments)
+{
+	if(m_coroutines.size() >= SCRIPT_MAX_COROUTINES)
 	{
-		std::list<CSquirrel *>::iterator iter;
+		CLogFile::Printf("Failed to start a coroutine of script %s (Too many coroutines are running).", pScript->GetName().Get());
+		return false;
+	}
 
-		for(iter = m_scripts.begin(); iter != m_scripts.end(); iter++)
-		{
-			if((*iter)->GetVM() == pVM)
-				return (*iter);
-		}
+	// The thread shares the root table of the script
+	SQVM * pScriptVM = pScript->GetVM();
+	SQVM * pVM = sq_newthread(pScriptVM, SCRIPT_COROUTINE_STACK_SIZE);
+
+	if(!pVM)
+		return false;
+
+	ScriptCoroutine * pCoroutine = new ScriptCoroutine();
+	pCoroutine->uiId = m_uiNextCoroutineId++;
+
+	if(m_uiNextCoroutineId == 0)
+		m_uiNextCoroutineId = 1;
+
+	pCoroutine->pScript = pScript;
+	pCoroutine->pVM = pVM;
+	pCoroutine->pThread = stack_get(pScriptVM, -1);
+	pCoroutine->ulWakeTime = 0;
+	pCoroutine->bResume = false;
+	pCoroutine->bFailed = false;
+	sq_pop(pScriptVM, 1);
+
+	// The natives called by the coroutine find the script by the thread
+	m_coroutines[pCoroutine->uiId] = pCoroutine;
+	m_vmCoroutines[pVM] = pCoroutine;
+	m_vmScripts[pVM] = pScript;
+
+	int iParams = 1;
+	sq_pushobject(pVM, pFunction);
+	sq_pushroottable(pVM);
+
+	if(pArguments)
+	{
+		pArguments->push_to_vm(pVM);
+		iParams += pArguments->size();
+	}
+
+	RunCoroutine(pCoroutine, true, iParams);
+	return true;
+}
+
+void CScriptingManager::RunCoroutine(ScriptCoroutine * pCoroutine, bool bStart, int iParams)
+{
+	// The thread is kept alive in case the coroutine unloads its script
+	SQObjectPtr pThread = pCoroutine->pThread;
+	SQVM * pVM = pCoroutine->pVM;
+	CSquirrel * pScript = pCoroutine->pScript;
+	unsigned int uiId = pCoroutine->uiId;
+	CScriptMemoryScope memoryScope(pScript->GetMemorySlot());
+
+	// The time is counted for the script like the time of its calls
+	unsigned int uiProfilerDepth = (g_pScriptProfiler ? g_pScriptProfiler->EnterFrame(SCRIPT_PROFILER_SCRIPT, pScript->GetName()) : SCRIPT_PROFILER_NO_FRAME);
+
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->EnterCall(pScript->GetVM());
+
+	if(bStart)
+		sq_call(pVM, iParams, SQFalse, SQTrue);
+	else if(pCoroutine->bFailed)
+	{
+		sq_throwerror(pVM, pCoroutine->result.GetString() ? pCoroutine->result.GetString() : "");
+		pCoroutine->result.SetNull();
+		sq_wakeupvm(pVM, SQFalse, SQFalse, SQTrue, SQTrue);
+	}
+	else
+	{
+		pCoroutine->result.push(pVM);
+		pCoroutine->result.SetNull();
+		sq_wakeupvm(pVM, SQTrue, SQFalse, SQTrue, SQFalse);
+	}
+
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->LeaveCall();
+
+	if(g_pScriptProfiler)
+		g_pScriptProfiler->LeaveFrame(uiProfilerDepth);
+
+	// It is gone if it unloaded its script, otherwise it is done unless it was suspended
+	std::map<unsigned int, ScriptCoroutine *>::iterator iter = m_coroutines.find(uiId);
+
+	if(iter != m_coroutines.end() && sq_getvmstate(pVM) != SQ_VMSTATE_SUSPENDED)
+		DeleteCoroutine((*iter).second);
+}
+
+void CScriptingManager::DeleteCoroutine(ScriptCoroutine * pCoroutine)
+{
+	m_coroutines.erase(pCoroutine->uiId);
+	m_vmCoroutines.erase(pCoroutine->pVM);
+	m_vmScripts.erase(pCoroutine->pVM);
+	delete pCoroutine;
+}
+
+void CScriptingManager::DeleteCoroutines(CSquirrel * pScript)
+{
+	for(std::map<unsigned int, ScriptCoroutine *>::iterator iter = m_coroutines.begin(); iter != m_coroutines.end(); )
+	{
+		ScriptCoroutine * pCoroutine = (*iter).second;
+		iter++;
+
+		if(pCoroutine->pScript == pScript)
+			DeleteCoroutine(pCoroutine);
+	}
+}
+
+unsigned int CScriptingManager::GetCoroutine(SQVM * pVM)
+{
+	std::map<SQVM *, ScriptCoroutine *>::iterator iter = m_vmCoroutines.find(pVM);
+
+	// The thread can only be suspended by a native the script called directly
+	if(iter == m_vmCoroutines.end() || pVM->_suspended || pVM->_nnativecalls != 2)
+		return 0;
+
+	return (*iter).second->uiId;
+}
+
+SQInteger CScriptingManager::SuspendCoroutine(SQVM * pVM, unsigned long ulWakeTime)
+{
+	std::map<SQVM *, ScriptCoroutine *>::iterator iter = m_vmCoroutines.find(pVM);
+
+	if(iter == m_vmCoroutines.end())
+		return sq_throwerror(pVM, "only coroutines can wait (see async)");
+
+	(*iter).second->ulWakeTime = ulWakeTime;
+	return sq_suspendvm(pVM);
+}
+
+void CScriptingManager::ResumeCoroutine(unsigned int uiId, const CSquirrelArgument& result)
+{
+	std::map<unsigned int, ScriptCoroutine *>::iterator iter = m_coroutines.find(uiId);
+
+	if(iter == m_coroutines.end())
+		return;
+
+	ScriptCoroutine * pCoroutine = (*iter).second;
+	pCoroutine->result.set(result);
+	pCoroutine->bResume = true;
+	pCoroutine->bFailed = false;
+}
+
+void CScriptingManager::FailCoroutine(unsigned int uiId, const String& strError)
+{
+	std::map<unsigned int, ScriptCoroutine *>::iterator iter = m_coroutines.find(uiId);
+
+	if(iter == m_coroutines.end())
+		return;
+
+	ScriptCoroutine * pCoroutine = (*iter).second;
+	pCoroutine->result.SetString(strError.Get());
+	pCoroutine->bResume = true;
+	pCoroutine->bFailed = true;
+}
+
+void CScriptingManager::ProcessCoroutines()
+{
+	if(m_coroutines.empty())
+		return;
+
+	// Only the coroutines that were done waiting before this call are resumed,
+	// the ones that are done while we resume these wait for the next tick
+	unsigned long ulTime = SharedUtility::GetFrameTime();
+	std::vector<unsigned int> resumed;
+
+	for(std::map<unsigned int, ScriptCoroutine *>::iterator iter = m_coroutines.begin(); iter != m_coroutines.end(); iter++)
+	{
+		ScriptCoroutine * pCoroutine = (*iter).second;
+
+		if(pCoroutine->bResume || (pCoroutine->ulWakeTime != 0 && ulTime >= pCoroutine->ulWakeTime))
+			resumed.push_back(pCoroutine->uiId);
+	}
+
+	for(std::vector<unsigned int>::iterator iter = resumed.begin(); iter != resumed.end(); iter++)
+	{
+		// A coroutine resumed before can unload the script of the others
+		std::map<unsigned int, ScriptCoroutine *>::iterator coroutineIter = m_coroutines.find(*iter);
+
+		if(coroutineIter == m_coroutines.end())
+			continue;
+
+		ScriptCoroutine * pCoroutine = (*coroutineIter).second;
+
+		if(sq_getvmstate(pCoroutine->pVM) != SQ_VMSTATE_SUSPENDED)
+			continue;
+
+		pCoroutine->ulWakeTime = 0;
+		pCoroutine->bResume = false;
+		RunCoroutine(pCoroutine, false, 0);
 	}
-	return NULL;
 }
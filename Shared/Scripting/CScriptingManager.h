@@ -11,6 +11,8 @@
 #pragma once
 
 #include <list>
+#include <map>
+#include <vector>
 #include <string>
 
 #ifdef WIN32
@@ -20,6 +22,12 @@
 
 #include "CSquirrel.h"
 
+// Maximum amount of coroutines that can be started and not finished yet
+#define SCRIPT_MAX_COROUTINES 4096
+
+// Stack size the squirrel thread of a coroutine starts with (it grows as needed)
+#define SCRIPT_COROUTINE_STACK_SIZE 1024
+
 template <typename T>
 static SQRESULT sq_setinstance(SQVM * pVM, T pInstance, int iIndex = 1)
 {
@@ -75,6 +83,8 @@ static T sq_getinstance(SQVM * pVM, int iIndex = 1)
 #define _CLASS_DECL(classname) \
 	__##classname##_decl
 
+class CJobSystem;
+
 struct ScriptingFunction
 {
 	String     strName;
@@ -89,17 +99,77 @@ struct ScriptingConstant
 	CSquirrelArgument value;
 };
 
+// A native function, class or constant by its name, only one of them is set.
+// It is created in the root table of a script once the script first uses it.
+struct ScriptingGlobal
+{
+	ScriptingFunction * pFunction;
+	SquirrelClassDecl * pClass;
+	ScriptingConstant * pConstant;
+};
+
+// A script function that runs on a squirrel thread of its own. The natives that
+// wait for something suspend it and it is resumed at the start of a later tick
+// once the wait is over, so the script reads like it waited without the server
+// ever waiting for it.
+struct ScriptCoroutine
+{
+	unsigned int       uiId;
+	CSquirrel        * pScript;
+	SQVM             * pVM;        // The thread it runs on
+	SQObjectPtr        pThread;    // Keeps the thread alive while it is suspended
+	unsigned long      ulWakeTime; // When it is resumed if it sleeps, 0 if it doesn't
+	bool               bResume;    // The native it waits for is done
+	bool               bFailed;    // The result is the error that is thrown in the coroutine
+	CSquirrelArgument  result;     // Returned by the native it waits for
+};
+
 class CScriptingManager
 {
 private:
 	std::list<CSquirrel *>         m_scripts;
+	std::map<SQVM *, CSquirrel *>  m_vmScripts;    // The event handlers check their vm on every call
+	std::map<String, CSquirrel *>  m_namedScripts; // The first loaded script of each name
 	std::list<ScriptingFunction *> m_funcs;
 	std::list<SquirrelClassDecl *> m_classes;
 	std::list<ScriptingConstant *> m_constants;
+	std::map<String, ScriptingGlobal> m_globals; // The natives, classes and constants the scripts create on their first use
+	unsigned int                   m_uiGCInterval;
+	unsigned int                   m_uiNextGCScript;
+	std::map<unsigned int, ScriptCoroutine *> m_coroutines;
+	std::map<SQVM *, ScriptCoroutine *>       m_vmCoroutines;
+	unsigned int                   m_uiNextCoroutineId;
+
+	// Creates the vm of a script with all natives, it isn't executed yet
+	CSquirrel              * Create(String strName, String strPath);
+
+	void                     AddGlobal(const String& strName, ScriptingFunction * pFunction, SquirrelClassDecl * pClass, ScriptingConstant * pConstant);
+	void                     Remove(CSquirrel * pScript);
+
+	// Runs the coroutine until it suspends or finishes, it is deleted once it finished
+	void                     RunCoroutine(ScriptCoroutine * pCoroutine, bool bStart, int iParams);
+	void                     DeleteCoroutine(ScriptCoroutine * pCoroutine);
+	void                     DeleteCoroutines(CSquirrel * pScript);
 
 public:
-	CSquirrel              * Load(String strName, String strPath);
+	CScriptingManager();
+
+	// Called by a vm for a name its root table doesn't have, creates the native,
+	// class or constant of the name in it. Returns false if there is none.
+	static SQBool            BindGlobal(SQVM * pVM, const SQChar * szName);
+
+	CSquirrel              * Load(String strName, String strPath, const SquirrelCompiledScript * pCompiledScript = NULL);
+
+	// Loads the scripts in the given order, their sources are compiled on the job
+	// system first while only the execution is done here. Returns the scripts in
+	// the order of the names, NULL for the scripts that failed to load.
+	std::vector<CSquirrel *> Load(const std::vector<String>& names, const std::vector<String>& paths, CJobSystem * pJobSystem);
 	bool                     Unload(String strName);
+
+	// Replaces a loaded script with the compiled new version of it, the new version
+	// gets pMigratedState from getPersistentState. Returns the new version or NULL
+	// if it failed to execute, the old version is only unloaded if it didn't.
+	CSquirrel              * Reload(CSquirrel * pScript, const SquirrelCompiledScript * pCompiledScript, CSquirrelArgument * pMigratedState);
 	void                     UnloadAll();
 	void                     RegisterFunction(String strFunctionName, SQFUNCTION pfnFunction, int iParameterCount, String strFunctionTemplate);
 	void                     RegisterClass(SquirrelClassDecl * pClassDeclaration);
@@ -107,6 +177,46 @@ public:
 	void                     RegisterDefaultConstants();
 	CSquirrel              * Get(String strName);
 	CSquirrel              * Get(SQVM * pVM);
+
+	// Returns the vm of the script the vm belongs to (coroutines run on threads of
+	// their own), what is kept for a script later has to be kept by this vm
+	SQVM                   * GetScriptVM(SQVM * pVM);
 	std::list<CSquirrel *> * GetScriptList() { return &m_scripts; }
+
+	// Pushes the string the script of the vm keeps for pKey, see
+	// CSquirrel::PushCachedString. Strings that change (like the name of a player)
+	// are dropped from all scripts with InvalidateCachedString when they do.
+	bool                     PushCachedString(SQVM * pVM, const void * pKey, const char * szString = NULL);
+	void                     InvalidateCachedString(const void * pKey);
 	unsigned int             GetScriptCount() { return m_scripts.size(); }
+
+	// The cycle collection interval new scripts start with
+	void                     SetGCInterval(unsigned int uiInterval) { m_uiGCInterval = uiInterval; }
+
+	// Collects the cycles of the scripts whose interval passed until the budget
+	// (in microseconds) is used up, starting after the script collected last.
+	// A collection can't be split so a script whose last collection took longer
+	// than the time left waits, unless it is a whole interval overdue.
+	void                     CollectGarbage(unsigned int uiBudget);
+
+	// Calls the function as a coroutine, it runs until it waits for the first time.
+	// Returns false if it couldn't be started.
+	bool                     StartCoroutine(CSquirrel * pScript, SQObjectPtr pFunction, CSquirrelArguments * pArguments);
+
+	// Returns the id of the coroutine running on the vm if a native called by it
+	// can suspend it right now (it can't from natives called by natives), 0 if not
+	unsigned int             GetCoroutine(SQVM * pVM);
+
+	// Returned by a native to suspend the coroutine running on the vm until it is
+	// resumed, or until ulWakeTime if that isn't 0
+	SQInteger                SuspendCoroutine(SQVM * pVM, unsigned long ulWakeTime = 0);
+
+	// The native the coroutine waits for returns the result (or throws the error)
+	// at the start of the next tick. Does nothing if the coroutine is gone.
+	void                     ResumeCoroutine(unsigned int uiId, const CSquirrelArgument& result);
+	void                     FailCoroutine(unsigned int uiId, const String& strError);
+
+	// Resumes the coroutines whose wait is over, called at the start of the tick
+	void                     ProcessCoroutines();
+	unsigned int             GetCoroutineCount() { return m_coroutines.size(); }
 };
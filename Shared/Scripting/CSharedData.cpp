@@ -0,0 +1,362 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSharedData.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CSharedData.h"
+
+// Stack slots each nesting level of a value uses while it is frozen or copied
+#define SHARED_DATA_STACK_PER_DEPTH 4
+
+std::map<String, CSharedValue *> CSharedData::m_values;
+
+CSharedValue::CSharedValue(SQObjectType type)
+	: m_type(type),
+	m_iValue(0),
+	m_fValue(0.0f),
+	m_uiReferences(1)
+{
+
+}
+
+CSharedValue::~CSharedValue()
+{
+	for(std::vector<CSharedValue *>::iterator iter = m_array.begin(); iter != m_array.end(); ++iter)
+		delete (*iter);
+
+	for(std::map<SQInteger, CSharedValue *>::iterator iter = m_integerKeys.begin(); iter != m_integerKeys.end(); ++iter)
+		delete (*iter).second;
+
+	for(std::map<std::string, CSharedValue *>::iterator iter = m_stringKeys.begin(); iter != m_stringKeys.end(); ++iter)
+		delete (*iter).second;
+}
+
+CSharedValue * CSharedValue::Freeze(SQVM * pVM, SQInteger idx, int iDepth, String& strError)
+{
+	// sq_next pushes onto the stack so the index has to stay the same
+	if(idx < 0)
+		idx = (sq_gettop(pVM) + idx + 1);
+
+	SQObjectType type = sq_gettype(pVM, idx);
+
+	switch(type)
+	{
+	case OT_NULL:
+		return new CSharedValue(OT_NULL);
+	case OT_BOOL:
+		{
+			SQBool bValue;
+			sq_getbool(pVM, idx, &bValue);
+			CSharedValue * pValue = new CSharedValue(OT_BOOL);
+			pValue->m_iValue = (bValue ? 1 : 0);
+			return pValue;
+		}
+	case OT_INTEGER:
+		{
+			CSharedValue * pValue = new CSharedValue(OT_INTEGER);
+			sq_getinteger(pVM, idx, &pValue->m_iValue);
+			return pValue;
+		}
+	case OT_FLOAT:
+		{
+			CSharedValue * pValue = new CSharedValue(OT_FLOAT);
+			sq_getfloat(pVM, idx, &pValue->m_fValue);
+			return pValue;
+		}
+	case OT_STRING:
+		{
+			const SQChar * szValue;
+			sq_getstring(pVM, idx, &szValue);
+			CSharedValue * pValue = new CSharedValue(OT_STRING);
+			pValue->m_strValue.assign(szValue, sq_getsize(pVM, idx));
+			return pValue;
+		}
+	case OT_ARRAY:
+	case OT_TABLE:
+		{
+			if(iDepth >= SHARED_DATA_MAX_DEPTH)
+			{
+				strError.Set("value is nested too deep");
+				return NULL;
+			}
+
+			CSharedValue * pValue = new CSharedValue(type);
+			sq_pushnull(pVM);
+
+			while(SQ_SUCCEEDED(sq_next(pVM, idx)))
+			{
+				CSharedValue * pChild = Freeze(pVM, -1, (iDepth + 1), strError);
+
+				if(!pChild)
+				{
+					sq_pop(pVM, 3);
+					delete pValue;
+					return NULL;
+				}
+
+				// Arrays are walked in order
+				if(type == OT_ARRAY)
+					pValue->m_array.push_back(pChild);
+				else if(sq_gettype(pVM, -2) == OT_INTEGER)
+				{
+					SQInteger iKey;
+					sq_getinteger(pVM, -2, &iKey);
+					pValue->m_integerKeys[iKey] = pChild;
+				}
+				else if(sq_gettype(pVM, -2) == OT_STRING)
+				{
+					const SQChar * szKey;
+					sq_getstring(pVM, -2, &szKey);
+					pValue->m_stringKeys[std::string(szKey, sq_getsize(pVM, -2))] = pChild;
+				}
+				else
+				{
+					strError.Set("table keys must be strings or integers");
+					sq_pop(pVM, 3);
+					delete pChild;
+					delete pValue;
+					return NULL;
+				}
+
+				sq_pop(pVM, 2);
+			}
+
+			sq_pop(pVM, 1);
+			return pValue;
+		}
+	default:
+		break;
+	}
+
+	strError.Set("only null, bools, numbers, strings, arrays and tables can be shared");
+	return NULL;
+}
+
+CSharedValue * CSharedValue::Create(SQVM * pVM, SQInteger idx, String& strError)
+{
+	sq_reservestack(pVM, (SHARED_DATA_MAX_DEPTH * SHARED_DATA_STACK_PER_DEPTH));
+	return Freeze(pVM, idx, 0, strError);
+}
+
+void CSharedValue::Release()
+{
+	if(--m_uiReferences == 0)
+		delete this;
+}
+
+unsigned int CSharedValue::GetSize()
+{
+	if(m_type == OT_ARRAY)
+		return m_array.size();
+
+	if(m_type == OT_TABLE)
+		return (m_integerKeys.size() + m_stringKeys.size());
+
+	if(m_type == OT_STRING)
+		return m_strValue.size();
+
+	return 0;
+}
+
+void CSharedValue::Push(SQVM * pVM)
+{
+	switch(m_type)
+	{
+	case OT_BOOL:
+		sq_pushbool(pVM, (m_iValue != 0));
+		break;
+	case OT_INTEGER:
+		sq_pushinteger(pVM, m_iValue);
+		break;
+	case OT_FLOAT:
+		sq_pushfloat(pVM, m_fValue);
+		break;
+	case OT_STRING:
+		sq_pushstring(pVM, m_strValue.data(), (SQInteger)m_strValue.size());
+		break;
+	default:
+		sq_pushnull(pVM);
+		break;
+	}
+}
+
+void CSharedValue::PushCopy(SQVM * pVM)
+{
+	if(m_type == OT_ARRAY)
+	{
+		sq_reservestack(pVM, SHARED_DATA_STACK_PER_DEPTH);
+		sq_newarray(pVM, 0);
+
+		for(std::vector<CSharedValue *>::iterator iter = m_array.begin(); iter != m_array.end(); ++iter)
+		{
+			(*iter)->PushCopy(pVM);
+			sq_arrayappend(pVM, -2);
+		}
+	}
+	else if(m_type == OT_TABLE)
+	{
+		sq_reservestack(pVM, SHARED_DATA_STACK_PER_DEPTH);
+		sq_newtable(pVM);
+
+		for(std::map<SQInteger, CSharedValue *>::iterator iter = m_integerKeys.begin(); iter != m_integerKeys.end(); ++iter)
+		{
+			sq_pushinteger(pVM, (*iter).first);
+			(*iter).second->PushCopy(pVM);
+			sq_createslot(pVM, -3);
+		}
+
+		for(std::map<std::string, CSharedValue *>::iterator iter = m_stringKeys.begin(); iter != m_stringKeys.end(); ++iter)
+		{
+			sq_pushstring(pVM, (*iter).first.data(), (SQInteger)(*iter).first.size());
+			(*iter).second->PushCopy(pVM);
+			sq_createslot(pVM, -3);
+		}
+	}
+	else
+		Push(pVM);
+}
+
+CSharedValue * CSharedValue::Get(SQVM * pVM, SQInteger idx)
+{
+	SQObjectType keyType = sq_gettype(pVM, idx);
+
+	if(keyType == OT_INTEGER)
+	{
+		SQInteger iKey;
+		sq_getinteger(pVM, idx, &iKey);
+
+		if(m_type == OT_ARRAY)
+		{
+			if(iKey >= 0 && iKey < (SQInteger)m_array.size())
+				return m_array[iKey];
+		}
+		else if(m_type == OT_TABLE)
+		{
+			std::map<SQInteger, CSharedValue *>::iterator iter = m_integerKeys.find(iKey);
+
+			if(iter != m_integerKeys.end())
+				return (*iter).second;
+		}
+	}
+	else if(keyType == OT_STRING && m_type == OT_TABLE)
+	{
+		const SQChar * szKey;
+		sq_getstring(pVM, idx, &szKey);
+		std::map<std::string, CSharedValue *>::iterator iter = m_stringKeys.find(std::string(szKey, sq_getsize(pVM, idx)));
+
+		if(iter != m_stringKeys.end())
+			return (*iter).second;
+	}
+
+	return NULL;
+}
+
+bool CSharedValue::PushNextKey(SQVM * pVM, SQInteger idx)
+{
+	SQObjectType keyType = sq_gettype(pVM, idx);
+
+	if(m_type == OT_ARRAY)
+	{
+		SQInteger iKey = 0;
+
+		if(keyType == OT_INTEGER)
+		{
+			sq_getinteger(pVM, idx, &iKey);
+			iKey++;
+		}
+		else if(keyType != OT_NULL)
+			return false;
+
+		if(iKey < 0 || iKey >= (SQInteger)m_array.size())
+			return false;
+
+		sq_pushinteger(pVM, iKey);
+		return true;
+	}
+
+	if(m_type != OT_TABLE)
+		return false;
+
+	std::map<std::string, CSharedValue *>::iterator stringIter = m_stringKeys.end();
+
+	if(keyType == OT_NULL || keyType == OT_INTEGER)
+	{
+		std::map<SQInteger, CSharedValue *>::iterator iter = m_integerKeys.begin();
+
+		if(keyType == OT_INTEGER)
+		{
+			SQInteger iKey;
+			sq_getinteger(pVM, idx, &iKey);
+			iter = m_integerKeys.upper_bound(iKey);
+		}
+
+		if(iter != m_integerKeys.end())
+		{
+			sq_pushinteger(pVM, (*iter).first);
+			return true;
+		}
+
+		// The string keys follow the integer keys
+		stringIter = m_stringKeys.begin();
+	}
+	else if(keyType == OT_STRING)
+	{
+		const SQChar * szKey;
+		sq_getstring(pVM, idx, &szKey);
+		stringIter = m_stringKeys.upper_bound(std::string(szKey, sq_getsize(pVM, idx)));
+	}
+
+	if(stringIter == m_stringKeys.end())
+		return false;
+
+	sq_pushstring(pVM, (*stringIter).first.data(), (SQInteger)(*stringIter).first.size());
+	return true;
+}
+
+void CSharedData::Set(const String& strName, CSharedValue * pValue)
+{
+	std::map<String, CSharedValue *>::iterator iter = m_values.find(strName);
+
+	if(iter != m_values.end())
+	{
+		(*iter).second->Release();
+		(*iter).second = pValue;
+		return;
+	}
+
+	m_values.insert(std::pair<String, CSharedValue *>(strName, pValue));
+}
+
+CSharedValue * CSharedData::Get(const String& strName)
+{
+	std::map<String, CSharedValue *>::iterator iter = m_values.find(strName);
+
+	if(iter != m_values.end())
+		return (*iter).second;
+
+	return NULL;
+}
+
+bool CSharedData::Remove(const String& strName)
+{
+	std::map<String, CSharedValue *>::iterator iter = m_values.find(strName);
+
+	if(iter == m_values.end())
+		return false;
+
+	(*iter).second->Release();
+	m_values.erase(iter);
+	return true;
+}
+
+void CSharedData::RemoveAll()
+{
+	for(std::map<String, CSharedValue *>::iterator iter = m_values.begin(); iter != m_values.end(); ++iter)
+		(*iter).second->Release();
+
+	m_values.clear();
+}
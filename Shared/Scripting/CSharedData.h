@@ -0,0 +1,82 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CSharedData.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <Squirrel/squirrel.h>
+#include <CString.h>
+
+// Nesting depth of the tables and arrays a value can be frozen from
+#define SHARED_DATA_MAX_DEPTH 64
+
+// A frozen copy of a squirrel value that no vm owns. Only the root of a tree is
+// reference counted, it owns every node below it and the nodes never change once
+// the tree is frozen, so any script can read them in place.
+class CSharedValue
+{
+private:
+	SQObjectType                                m_type;
+	SQInteger                                   m_iValue;
+	SQFloat                                     m_fValue;
+	std::string                                 m_strValue;
+	std::vector<CSharedValue *>                 m_array;
+	std::map<SQInteger, CSharedValue *>         m_integerKeys; // Walked before the string keys
+	std::map<std::string, CSharedValue *>       m_stringKeys;
+	unsigned int                                m_uiReferences;
+
+	CSharedValue(SQObjectType type);
+	~CSharedValue();
+
+	static CSharedValue * Freeze(SQVM * pVM, SQInteger idx, int iDepth, String& strError);
+
+public:
+	// Copies the value at the index, returns NULL with the reason in strError if it
+	// has a value that can't be shared (functions, instances, ...) or is nested too deep
+	static CSharedValue * Create(SQVM * pVM, SQInteger idx, String& strError);
+
+	void                  AddRef() { m_uiReferences++; }
+	void                  Release();
+
+	SQObjectType          GetType() { return m_type; }
+	bool                  IsContainer() { return (m_type == OT_TABLE || m_type == OT_ARRAY); }
+	unsigned int          GetSize();
+
+	// Pushes the value of a scalar, containers are pushed by the caller
+	void                  Push(SQVM * pVM);
+
+	// Pushes a copy of the value made of regular tables and arrays
+	void                  PushCopy(SQVM * pVM);
+
+	// Returns the value of the key at the index, NULL if the container doesn't have it
+	CSharedValue        * Get(SQVM * pVM, SQInteger idx);
+
+	// Pushes the key after the key at the index (null for the first key), returns
+	// false after the last key
+	bool                  PushNextKey(SQVM * pVM, SQInteger idx);
+};
+
+// The shared values by name. Values are only set and read on the main thread.
+class CSharedData
+{
+private:
+	static std::map<String, CSharedValue *> m_values;
+
+public:
+	// Replaces the value of the name, the scripts that read the old value keep it
+	// until they let go of it
+	static void           Set(const String& strName, CSharedValue * pValue);
+
+	// Returns the value of the name without adding a reference, NULL if it isn't set
+	static CSharedValue * Get(const String& strName);
+	static bool           Remove(const String& strName);
+	static void           RemoveAll();
+};
@@ -23,10 +23,26 @@
 #include "../CEvents.h"
 #include "../CLogFile.h"
 #include "CSquirrel.h"
+#include "CScriptBytecodeCache.h"
+#include "CScriptProfiler.h"
+#include "CScriptWatchdog.h"
+#include "../CSQLiteWorker.h"
+#include "../CHttpRequestPool.h"
+#include "../CFileWorker.h"
+#include "CScriptAllocator.h"
 
 extern CScriptingManager * g_pScriptingManager;
 extern CEvents * g_pEvents;
 
+void CSquirrel::DebugHook(SQVM * pVM, SQInteger iType, const SQChar * szSource, SQInteger iLine, const SQChar * szFunction)
+{
+	if(g_pScriptProfiler)
+		g_pScriptProfiler->OnDebugHook(pVM, iType, szSource, iLine, szFunction);
+
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->OnDebugHook(pVM, iType);
+}
+
 void CSquirrel::PrintFunction(SQVM * pVM, const char * szFormat, ...)
 {
 	va_list args;
@@ -120,6 +136,92 @@ void CSquirrel::CompilerErrorFunction(SQVM * pVM, const char * szError, const ch
 	}
 }
 
+CSquirrel::CSquirrel()
+	: m_pVM(NULL),
+	m_pMigratedState(NULL),
+	m_uiGCInterval(SQUIRREL_GC_INTERVAL),
+	m_ulLastGCTime(0),
+	m_uiMemorySlot(0)
+{
+	memset(&m_gcStats, 0, sizeof(m_gcStats));
+}
+
+void CSquirrel::CompileErrorFunction(SQVM * pVM, const char * szError, const char * szSource, int iLine, int iColumn)
+{
+	// Kept for the script vm, the events can only be called on the main thread
+	SquirrelCompiledScript * pCompiledScript = (SquirrelCompiledScript *)sq_getforeignptr(pVM);
+	pCompiledScript->strError.Set(szError);
+	pCompiledScript->strErrorSource.Set(szSource);
+	pCompiledScript->iErrorLine = iLine;
+	pCompiledScript->iErrorColumn = iColumn;
+}
+
+struct BytecodeReader
+{
+	const std::vector<unsigned char> * pBytecode;
+	size_t                             sOffset;
+};
+
+SQInteger CSquirrel::WriteBytecode(SQUserPointer pUserData, SQUserPointer pBuffer, SQInteger iSize)
+{
+	std::vector<unsigned char> * pBytecode = (std::vector<unsigned char> *)pUserData;
+	pBytecode->insert(pBytecode->end(), (unsigned char *)pBuffer, ((unsigned char *)pBuffer + iSize));
+	return iSize;
+}
+
+SQInteger CSquirrel::ReadBytecode(SQUserPointer pUserData, SQUserPointer pBuffer, SQInteger iSize)
+{
+	BytecodeReader * pReader = (BytecodeReader *)pUserData;
+	size_t sSize = (pReader->pBytecode->size() - pReader->sOffset);
+
+	if((size_t)iSize < sSize)
+		sSize = (size_t)iSize;
+
+	if(sSize == 0)
+		return -1;
+
+	memcpy(pBuffer, &(*pReader->pBytecode)[pReader->sOffset], sSize);
+	pReader->sOffset += sSize;
+	return (SQInteger)sSize;
+}
+
+void CSquirrel::Compile(SquirrelCompiledScript * pCompiledScript)
+{
+	pCompiledScript->bCompiled = false;
+	pCompiledScript->bytecode.clear();
+	pCompiledScript->strError.Clear();
+	pCompiledScript->strErrorSource.Clear();
+	pCompiledScript->iErrorLine = 0;
+	pCompiledScript->iErrorColumn = 0;
+
+	SQVM * pVM = sq_open(1024);
+
+	if(!pVM)
+		return;
+
+	sq_setforeignptr(pVM, pCompiledScript);
+	sq_setcompilererrorhandler(pVM, CompileErrorFunction);
+
+	// Use the bytecode cache like Execute does
+	unsigned int uiChecksum = 0;
+	unsigned int uiSize = 0;
+	bool bCacheable = (CScriptBytecodeCache::IsEnabled() && CScriptBytecodeCache::GetSourceInfo(pCompiledScript->strPath, uiChecksum, uiSize));
+	bool bLoaded = (bCacheable && CScriptBytecodeCache::Load(pVM, pCompiledScript->strPath, uiChecksum, uiSize));
+
+	if(!bLoaded && SQ_SUCCEEDED(sqstd_loadfile(pVM, pCompiledScript->strPath.Get(), SQTrue)))
+	{
+		bLoaded = true;
+
+		if(bCacheable)
+			CScriptBytecodeCache::Save(pVM, pCompiledScript->strPath, uiChecksum, uiSize);
+	}
+
+	if(bLoaded)
+		pCompiledScript->bCompiled = SQ_SUCCEEDED(sq_writeclosure(pVM, WriteBytecode, &pCompiledScript->bytecode));
+
+	sq_close(pVM);
+}
+
 bool CSquirrel::Load(String strName, String strPath)
 {
 	// Check if the script exists
@@ -132,8 +234,13 @@ bool CSquirrel::Load(String strName, String strPath)
 	// Set the script path
 	m_strPath = strPath;
 
+	// Count the memory of the vm for the script
+	m_uiMemorySlot = CMemoryTracker::GetScriptSlot(m_strName.Get());
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+
 	// Create a squirrel VM with an initial stack size of 1024 bytes (stack will resize as needed)
 	m_pVM = sq_open(1024);
+	m_ulLastGCTime = SharedUtility::GetTime();
 
 	// Register the default error handlers
 	sqstd_seterrorhandlers(m_pVM);
@@ -144,6 +251,9 @@ bool CSquirrel::Load(String strName, String strPath)
 	// Set the compiler error function
 	sq_setcompilererrorhandler(m_pVM, CompilerErrorFunction);
 
+	// Set the debug hook if the profiler or watchdog need it
+	UpdateDebugHook();
+
 	// Push the root table onto the stack
 	sq_pushroottable(m_pVM);
 
@@ -163,23 +273,94 @@ bool CSquirrel::Load(String strName, String strPath)
 	return true;
 }
 
-bool CSquirrel::Execute()
+bool CSquirrel::Execute(const SquirrelCompiledScript * pCompiledScript)
 {
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+
 	// Add the script name constant
 	RegisterConstant("SCRIPT_NAME", m_strName);
 
 	// Add the script path constant
 	RegisterConstant("SCRIPT_PATH", m_strPath);
 
-	// Load and compile the script
-	if(SQ_FAILED(sqstd_dofile(m_pVM, m_strPath.Get(), SQFalse, SQTrue)))
-		return false;
+	if(pCompiledScript)
+	{
+		// Report the compiler error now that the script has a vm
+		if(!pCompiledScript->bCompiled)
+		{
+			if(pCompiledScript->strError.IsNotEmpty())
+				CompilerErrorFunction(m_pVM, pCompiledScript->strError.Get(), pCompiledScript->strErrorSource.Get(), pCompiledScript->iErrorLine, pCompiledScript->iErrorColumn);
 
-	return true;
+			return false;
+		}
+
+		BytecodeReader reader;
+		reader.pBytecode = &pCompiledScript->bytecode;
+		reader.sOffset = 0;
+
+		if(SQ_FAILED(sq_readclosure(m_pVM, ReadBytecode, &reader)))
+			return false;
+	}
+	else
+	{
+		// Load the script from the bytecode cache if the source hasn't changed,
+		// otherwise compile it and update the cache
+		unsigned int uiChecksum = 0;
+		unsigned int uiSize = 0;
+		bool bCacheable = (CScriptBytecodeCache::IsEnabled() && CScriptBytecodeCache::GetSourceInfo(m_strPath, uiChecksum, uiSize));
+
+		if(!bCacheable || !CScriptBytecodeCache::Load(m_pVM, m_strPath, uiChecksum, uiSize))
+		{
+			if(SQ_FAILED(sqstd_loadfile(m_pVM, m_strPath.Get(), SQTrue)))
+				return false;
+
+			if(bCacheable)
+				CScriptBytecodeCache::Save(m_pVM, m_strPath, uiChecksum, uiSize);
+		}
+	}
+
+	// Run the script with the root table as 'this'
+	unsigned int uiProfilerDepth = (g_pScriptProfiler ? g_pScriptProfiler->EnterFrame(SCRIPT_PROFILER_SCRIPT, m_strName) : SCRIPT_PROFILER_NO_FRAME);
+
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->EnterCall(m_pVM);
+
+	sq_push(m_pVM, -2);
+	bool bSucceeded = SQ_SUCCEEDED(sq_call(m_pVM, 1, SQFalse, SQTrue));
+
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->LeaveCall();
+
+	if(g_pScriptProfiler)
+		g_pScriptProfiler->LeaveFrame(uiProfilerDepth);
+
+	// Pop the closure
+	sq_pop(m_pVM, 1);
+	return bSucceeded;
 }
 
 void CSquirrel::Unload()
 {
+	// Remove anything the watchdog holds for the script
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->RemoveScript(m_pVM);
+
+	// Finish the database queries of the script and drop their callbacks
+	if(g_pSQLiteWorker)
+		g_pSQLiteWorker->RemoveScript(m_pVM);
+
+	// Drop the http requests of the script and their callbacks
+	if(g_pHttpRequestPool)
+		g_pHttpRequestPool->RemoveScript(m_pVM);
+
+	// Finish the file requests of the script and drop their callbacks
+	if(g_pFileWorker)
+		g_pFileWorker->RemoveScript(m_pVM);
+
+	// Release the persistent state and the cached strings before the vm that owns them
+	m_persistentState.Null();
+	m_cachedStrings.clear();
+
 	// Pop the root table from the stack
 	sq_pop(m_pVM, 1);
 
@@ -188,8 +369,84 @@ void CSquirrel::Unload()
 	m_pVM = NULL;
 }
 
+bool CSquirrel::PushCachedString(SQVM * pVM, const void * pKey, const char * szString)
+{
+	std::map<const void *, SQObjectPtr>::iterator iter = m_cachedStrings.find(pKey);
+
+	if(iter != m_cachedStrings.end())
+	{
+		sq_pushobject(pVM, (*iter).second);
+		return true;
+	}
+
+	if(!szString)
+		return false;
+
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+	sq_pushstring(pVM, szString, -1);
+	HSQOBJECT string;
+	sq_getstackobj(pVM, -1, &string);
+	m_cachedStrings.insert(std::pair<const void *, SQObjectPtr>(pKey, SQObjectPtr(string)));
+	return true;
+}
+
+unsigned int CSquirrel::CollectGarbage()
+{
+	if(!m_pVM)
+		return 0;
+
+	unsigned long long ullStartTime = SharedUtility::GetMicroseconds();
+	SQInteger iFreed = sq_collectgarbage(m_pVM);
+	unsigned int uiTime = (unsigned int)(SharedUtility::GetMicroseconds() - ullStartTime);
+	m_ulLastGCTime = SharedUtility::GetTime();
+
+	// Squirrel returns -1 if it was built without the cycle collector
+	unsigned int uiFreed = (iFreed > 0 ? (unsigned int)iFreed : 0);
+	m_gcStats.uiCollections++;
+	m_gcStats.uiFreed += uiFreed;
+	m_gcStats.uiLastFreed = uiFreed;
+	m_gcStats.ullTotalTime += uiTime;
+	m_gcStats.uiLastTime = uiTime;
+
+	if(uiTime > m_gcStats.uiMaxTime)
+		m_gcStats.uiMaxTime = uiTime;
+
+	return uiFreed;
+}
+
+bool CSquirrel::GetPersistentState(CSquirrelArgument& state)
+{
+	state.SetNull();
+
+	if(sq_isnull(m_persistentState))
+		return true;
+
+	sq_pushobject(m_pVM, m_persistentState);
+	CSquirrelArgument localState;
+	bool bCopied = localState.pushFromStack(m_pVM, -1);
+	sq_pop(m_pVM, 1);
+
+	if(!bCopied)
+		return false;
+
+	// Serialized so nothing of this vm is left in the copy
+	CBitStream bitStream;
+	localState.serialize(&bitStream);
+	state.deserialize(&bitStream);
+	return true;
+}
+
+void CSquirrel::UpdateDebugHook()
+{
+	// The debug hook slows scripts down so it is only set while it is needed
+	bool bNeeded = ((g_pScriptProfiler && g_pScriptProfiler->IsRunning()) || (g_pScriptWatchdog && g_pScriptWatchdog->IsInterruptEnabled()));
+	sq_setnativedebughook(m_pVM, bNeeded ? DebugHook : NULL);
+}
+
 void CSquirrel::RegisterFunction(String strFunctionName, SQFUNCTION pfnFunction, int iParameterCount, String strFunctionTemplate)
 {
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+
 	// Push the function name onto the stack
 	sq_pushstring(m_pVM, strFunctionName.Get(), -1);
 
@@ -213,6 +470,8 @@ void CSquirrel::RegisterFunction(String strFunctionName, SQFUNCTION pfnFunction,
 
 bool CSquirrel::RegisterClass(SquirrelClassDecl * pClassDecl)
 {
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+
 	// Get the stack top
 	int oldtop = sq_gettop(m_pVM);
 
@@ -256,6 +515,8 @@ bool CSquirrel::RegisterClass(SquirrelClassDecl * pClassDecl)
 
 void CSquirrel::RegisterConstant(String strConstantName, CSquirrelArgument value)
 {
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+
 	// Push the constant name onto the stack
 	sq_pushstring(m_pVM, strConstantName.Get(), -1);
 
@@ -268,6 +529,8 @@ void CSquirrel::RegisterConstant(String strConstantName, CSquirrelArgument value
 
 void CSquirrel::Call(SQObjectPtr pFunction, CSquirrelArguments * pArguments, CSquirrelArgument * pReturn)
 {
+	CScriptMemoryScope memoryScope(m_uiMemorySlot);
+
 	// Get the stack top
 	int iTop = sq_gettop(m_pVM);
 
@@ -281,6 +544,11 @@ void CSquirrel::Call(SQObjectPtr pFunction, CSquirrelArguments * pArguments, CSq
 	}
 
 	// Call the function
+	unsigned int uiProfilerDepth = (g_pScriptProfiler ? g_pScriptProfiler->EnterFrame(SCRIPT_PROFILER_SCRIPT, m_strName) : SCRIPT_PROFILER_NO_FRAME);
+
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->EnterCall(m_pVM);
+
 	SQObjectPtr res;
 
 	if(m_pVM->Call(pFunction, iParams, m_pVM->_top-iParams, res, true))
@@ -290,6 +558,12 @@ void CSquirrel::Call(SQObjectPtr pFunction, CSquirrelArguments * pArguments, CSq
 			pReturn->set(res);
 	}
 
+	if(g_pScriptWatchdog)
+		g_pScriptWatchdog->LeaveCall();
+
+	if(g_pScriptProfiler)
+		g_pScriptProfiler->LeaveFrame(uiProfilerDepth);
+
 	// Restore the stack top
 	sq_settop(m_pVM, iTop);
 }
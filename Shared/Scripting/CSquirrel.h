@@ -12,10 +12,15 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <vector>
+#include <map>
 #include <Squirrel/squirrel.h>
 #include <Squirrel/sqobject.h>
 #include "CSquirrelArguments.h"
 
+// Milliseconds between the cycle collections of a script unless it sets its own
+#define SQUIRREL_GC_INTERVAL 10000
+
 #if defined(WIN32) && defined(RegisterClass)
 #undef RegisterClass
 #endif
@@ -41,25 +46,98 @@ struct SquirrelArguments
 	SQObjectPtr * pArguments;
 };
 
+// A script compiled ahead of its Execute by a vm of its own, which can be done on
+// any thread. The closure is kept as bytecode and read into the script vm later.
+struct SquirrelCompiledScript
+{
+	String                     strPath;
+	bool                       bCompiled;
+	std::vector<unsigned char> bytecode;
+
+	// The compiler error, reported once the script is executed
+	String                     strError;
+	String                     strErrorSource;
+	int                        iErrorLine;
+	int                        iErrorColumn;
+};
+
+// Collections of the cycles of a script, all times are in microseconds
+struct SquirrelGCStats
+{
+	unsigned int       uiCollections;
+	unsigned int       uiFreed;     // Objects that were only kept alive by cycles
+	unsigned int       uiLastFreed;
+	unsigned long long ullTotalTime;
+	unsigned int       uiLastTime;
+	unsigned int       uiMaxTime;
+};
+
 class CSquirrel
 {
 private:
-	SQVM * m_pVM;
-	String m_strName;
-	String m_strPath;
+	SQVM              * m_pVM;
+	String              m_strName;
+	String              m_strPath;
+	SQObjectPtr         m_persistentState; // Declared with getPersistentState, kept by hot reloads
+	CSquirrelArgument * m_pMigratedState;  // State of the old version while a hot reload executes this one
+	unsigned int        m_uiGCInterval;    // Milliseconds between the cycle collections, 0 for none
+	unsigned long       m_ulLastGCTime;
+	SquirrelGCStats     m_gcStats;
+	std::map<const void *, SQObjectPtr> m_cachedStrings; // Strings of the natives by what they belong to
+	unsigned int        m_uiMemorySlot;    // What the vm allocates is counted for this slot of the memory tracker
 
 	static void PrintFunction(SQVM * pVM, const char * szFormat, ...);
 	static void ErrorFunction(SQVM * pVM, const char * szFormat, ...);
 	static void CompilerErrorFunction(SQVM * pVM, const char * szError, const char * szSource, int iLine, int iColumn);
+	static void DebugHook(SQVM * pVM, SQInteger iType, const SQChar * szSource, SQInteger iLine, const SQChar * szFunction);
+	static void CompileErrorFunction(SQVM * pVM, const char * szError, const char * szSource, int iLine, int iColumn);
+	static SQInteger WriteBytecode(SQUserPointer pUserData, SQUserPointer pBuffer, SQInteger iSize);
+	static SQInteger ReadBytecode(SQUserPointer pUserData, SQUserPointer pBuffer, SQInteger iSize);
 
 public:
+	CSquirrel();
+
 	SQVM *      GetVM() { return m_pVM; }
 	String      GetName() { return m_strName; }
+	String      GetPath() { return m_strPath; }
 	bool        Load(String strName, String strPath);
-	bool        Execute();
+	bool        Execute(const SquirrelCompiledScript * pCompiledScript = NULL);
+
+	// Compiles the source of pCompiledScript->strPath, doesn't touch anything but
+	// the bytecode cache so it can run on a worker thread
+	static void Compile(SquirrelCompiledScript * pCompiledScript);
 	void        Unload();
+	void        UpdateDebugHook();
 	void        RegisterFunction(String strFunctionName, SQFUNCTION pfnFunction, int iParameterCount, String strFunctionTemplate);
 	bool        RegisterClass(SquirrelClassDecl * pClassDecl);
 	void        RegisterConstant(String strConstantName, CSquirrelArgument value);
 	void        Call(SQObjectPtr pFunction, CSquirrelArguments * pArguments = NULL, CSquirrelArgument * pReturn = NULL);
+
+	void        SetPersistentState(SQObjectPtr pState) { m_persistentState = pState; }
+
+	// Copies the declared persistent state without the values that can't be copied
+	// to another vm (functions become null), the state is null if none was declared.
+	// Returns false if the state has values that can't be copied at all (instances).
+	bool        GetPersistentState(CSquirrelArgument& state);
+
+	void        SetMigratedState(CSquirrelArgument * pState) { m_pMigratedState = pState; }
+	CSquirrelArgument * GetMigratedState() { return m_pMigratedState; }
+
+	// Reference counting frees everything but cycles, which are only freed when
+	// the cycles of the vm are collected. The scripting manager collects the vms
+	// whose interval passed in the idle time between the ticks.
+	void        SetGCInterval(unsigned int uiInterval) { m_uiGCInterval = uiInterval; }
+	unsigned int GetGCInterval() { return m_uiGCInterval; }
+	unsigned long GetLastGCTime() { return m_ulLastGCTime; }
+
+	// Returns the amount of objects that were freed
+	unsigned int CollectGarbage();
+	const SquirrelGCStats& GetGCStats() { return m_gcStats; }
+	unsigned int GetMemorySlot() { return m_uiMemorySlot; }
+
+	// Pushes the string kept for pKey to the vm (this vm or a coroutine of it) so it
+	// isn't hashed and interned again. If szString is given it is kept first if
+	// there is none. Returns false if nothing was pushed.
+	bool        PushCachedString(SQVM * pVM, const void * pKey, const char * szString = NULL);
+	void        RemoveCachedString(const void * pKey) { m_cachedStrings.erase(pKey); }
 };
@@ -91,9 +91,9 @@ bool CSquirrelArgument::push(SQVM* pVM)
 			{
 				sq_newarray(pVM, 0);
 
-				for(CSquirrelArguments::iterator iter = data.pArray->begin(); iter != data.pArray->end(); iter++)
+				for(unsigned int i = 0; i < data.pArray->size(); i++)
 				{
-					(*iter)->push(pVM);
+					data.pArray->get(i)->push(pVM);
 					sq_arrayappend(pVM, -2);
 				}
 				break;
@@ -103,11 +103,10 @@ bool CSquirrelArgument::push(SQVM* pVM)
 				assert(data.pArray->size() % 2 == 0);
 				sq_newtable(pVM);
 
-				for(CSquirrelArguments::iterator iter = data.pArray->begin(); iter != data.pArray->end(); iter++)
+				for(unsigned int i = 0; i < data.pArray->size(); i += 2)
 				{
-					(*iter)->push(pVM);
-					++iter;
-					(*iter)->push(pVM);
+					data.pArray->get(i)->push(pVM);
+					data.pArray->get(i + 1)->push(pVM);
 					sq_createslot(pVM, -3);
 				}
 				break;
@@ -463,23 +462,41 @@ void CSquirrelArgument::set(const CSquirrelArgument& p)
 	}
 }
 
+void CSquirrelArgument::swap(CSquirrelArgument& p)
+{
+	// Swap the values without copying what they point to
+	SQObjectType tempType = type;
+	type = p.type;
+	p.type = tempType;
+
+	char tempData[sizeof(data)];
+	memcpy(tempData, &data, sizeof(data));
+	memcpy(&data, &p.data, sizeof(data));
+	memcpy(&p.data, tempData, sizeof(data));
+}
+
 //==============================================================================
 
 CSquirrelArguments::CSquirrelArguments(SQVM * pVM, int idx)
 {
+	m_uiSize = 0;
+
 	for(int i = idx; i <= sq_gettop(pVM); i++)
 		pushFromStack(pVM, i);
 }
 
 CSquirrelArguments::CSquirrelArguments(CBitStream * pBitStream)
 {
+	m_uiSize = 0;
 	deserialize(pBitStream);
 }
 
 CSquirrelArguments::CSquirrelArguments(const CSquirrelArguments& p)
 {
-	for(CSquirrelArguments::const_iterator iter = p.begin(); iter != p.end(); ++ iter)
-		push_back(new CSquirrelArgument(**iter));
+	m_uiSize = 0;
+
+	for(unsigned int i = 0; i < p.size(); i++)
+		next()->set(*p.get(i));
 }
 
 CSquirrelArguments::~CSquirrelArguments()
@@ -487,74 +504,142 @@ CSquirrelArguments::~CSquirrelArguments()
 	reset();
 }
 
-void CSquirrelArguments::reset()
+CSquirrelArguments& CSquirrelArguments::operator = (const CSquirrelArguments& p)
 {
-	for(iterator iter = begin(); iter != end(); iter++)
-		delete *iter;
+	if(this != &p)
+	{
+		reset();
+
+		for(unsigned int i = 0; i < p.size(); i++)
+			next()->set(*p.get(i));
+	}
 
-	clear();
+	return *this;
+}
+
+CSquirrelArgument * CSquirrelArguments::next()
+{
+	// Use the inline arguments first and only allocate once they are used up
+	CSquirrelArgument * pArgument;
+
+	if(m_uiSize < SQUIRREL_ARGUMENTS_INLINE_SIZE)
+		pArgument = &m_inlineArguments[m_uiSize];
+	else
+	{
+		pArgument = new CSquirrelArgument();
+		m_spillArguments.push_back(pArgument);
+	}
+
+	m_uiSize++;
+	return pArgument;
+}
+
+CSquirrelArgument * CSquirrelArguments::get(unsigned int i) const
+{
+	if(i >= m_uiSize)
+		return NULL;
+
+	if(i < SQUIRREL_ARGUMENTS_INLINE_SIZE)
+		return const_cast<CSquirrelArgument *>(&m_inlineArguments[i]);
+
+	return m_spillArguments[i - SQUIRREL_ARGUMENTS_INLINE_SIZE];
+}
+
+void CSquirrelArguments::pop_front()
+{
+	if(m_uiSize == 0)
+		return;
+
+	// Move all arguments down by one, the first one ends up last
+	for(unsigned int i = 1; i < m_uiSize; i++)
+		get(i - 1)->swap(*get(i));
+
+	pop_back();
+}
+
+void CSquirrelArguments::pop_back()
+{
+	if(m_uiSize == 0)
+		return;
+
+	m_uiSize--;
+
+	if(m_uiSize < SQUIRREL_ARGUMENTS_INLINE_SIZE)
+		m_inlineArguments[m_uiSize].reset();
+	else
+	{
+		delete m_spillArguments.back();
+		m_spillArguments.pop_back();
+	}
+}
+
+void CSquirrelArguments::reset()
+{
+	while(m_uiSize > 0)
+		pop_back();
 }
 
 void CSquirrelArguments::push_to_vm(SQVM* pVM)
 {
-	for(iterator iter = begin(); iter != end(); ++ iter)
-		(*iter)->push(pVM);
+	for(unsigned int i = 0; i < m_uiSize; i++)
+		get(i)->push(pVM);
 }
 
 void CSquirrelArguments::push()
 {
-	push_back(new CSquirrelArgument());
+	next();
 }
 
 void CSquirrelArguments::pushObject(SQObject o)
 {
-	push_back(new CSquirrelArgument(o));
+	CSquirrelArgument argument(o);
+	next()->swap(argument);
 }
 
 void CSquirrelArguments::push(int i)
 {
-	push_back(new CSquirrelArgument(i));
+	next()->SetInteger(i);
 }
 
 void CSquirrelArguments::push(bool b)
 {
-	push_back(new CSquirrelArgument(b));
+	next()->SetBool(b);
 }
 
 void CSquirrelArguments::push(float f)
 {
-	push_back(new CSquirrelArgument(f));
+	next()->SetFloat(f);
 }
 
 void CSquirrelArguments::push(const char* c)
 {
-	push_back(new CSquirrelArgument(new String(c)));
+	next()->SetString(c);
 }
 
 void CSquirrelArguments::push(String str)
 {
-	push_back(new CSquirrelArgument(new String(str)));
+	next()->SetString(str);
 }
 
 void CSquirrelArguments::push(CSquirrelArguments array, bool isArray)
 {
-	push_back(new CSquirrelArgument(array, isArray));
+	push(new CSquirrelArguments(array), isArray);
 }
 
 void CSquirrelArguments::push(CSquirrelArguments* pArray, bool isArray)
 {
-	push_back(new CSquirrelArgument(pArray, isArray));
+	if(isArray)
+		next()->SetArray(pArray);
+	else
+		next()->SetTable(pArray);
 }
 
 bool CSquirrelArguments::pushFromStack(SQVM* pVM, int idx)
 {
-	CSquirrelArgument * arg = new CSquirrelArgument();
-	bool bValid = arg->pushFromStack(pVM, idx);
+	bool bValid = next()->pushFromStack(pVM, idx);
 
-	if(bValid)
-		push_back(arg);
-	else
-		delete arg;
+	if(!bValid)
+		pop_back();
 
 	return bValid;
 }
@@ -562,17 +647,13 @@ bool CSquirrelArguments::pushFromStack(SQVM* pVM, int idx)
 CSquirrelArgument CSquirrelArguments::pop()
 {
 	// Do we have an argument to pop?
-	if(size() > 0)
+	if(m_uiSize > 0)
 	{
-		// Get an argument from the front
-		CSquirrelArgument * pArgument = front();
-		pop_front();
+		// Create a new instance of the argument from the front
+		CSquirrelArgument argument(*front());
 
-		// Create a new instance of the argument
-		CSquirrelArgument argument(*pArgument);
-
-		// Delete the argument
-		delete pArgument;
+		// Remove the argument
+		pop_front();
 
 		// Return the new argument instance
 		return argument;
@@ -604,8 +685,8 @@ void CSquirrelArguments::serialize(CBitStream * pBitStream)
 
 	// --
 
-	for(iterator iter = begin(); iter != end(); ++ iter)
-		(*iter)->serialize(pBitStream);
+	for(unsigned int i = 0; i < m_uiSize; i++)
+		get(i)->serialize(pBitStream);
 }
 
 void CSquirrelArguments::deserialize(CBitStream * pBitStream)
@@ -627,24 +708,5 @@ void CSquirrelArguments::deserialize(CBitStream * pBitStream)
 		pBitStream->Read(size);
 
 	for(size_t i = 0; i < size; ++i)
-		push_back(new CSquirrelArgument(pBitStream));
-}
-
-#ifdef _SERVER
-SquirrelArgumentInterface* CSquirrelArguments::Get(unsigned int i) const
-{
-	if(i >= size())
-		return 0;
-
-	unsigned int j = 0;
-	for(const_iterator iter = begin(); iter != end(); ++ iter)
-	{
-		if(j == i)
-			return *iter;
-		
-		++ j;
-	}
-
-	return 0;
+		next()->deserialize(pBitStream);
 }
-#endif
@@ -11,6 +11,7 @@
 
 #include <Squirrel/squirrel.h>
 #include <list>
+#include <vector>
 // FIXUPDATE
 // jenksta: this is very hacky :/
 #ifdef _SERVER
@@ -82,11 +83,13 @@ public:
 	void                 deserialize(CBitStream * pBitStream);
 
 	void                 set(const CSquirrelArgument& p);
+	void                 swap(CSquirrelArgument& p);
 	void                 SetNull()                 { reset(); type = OT_NULL; }
 	void                 SetInteger(int i)         { reset(); type = OT_INTEGER; data.i = i; }
 	void                 SetBool   (bool b)        { reset(); type = OT_BOOL; data.b = b; }
 	void                 SetFloat  (float f)       { reset(); type = OT_FLOAT; data.f = f; }
-	void                 SetString (const char* s) { reset(); type = OT_STRING; data.str = new String(s); }
+	void                 SetString (const char* s) { reset(); type = OT_STRING; data.str = new String(); data.str->Set(s); }
+	void                 SetString (const String& str) { reset(); type = OT_STRING; data.str = new String(str); } // Keeps binary data
 	void                 SetArray(CSquirrelArguments * pArray) { reset(); type = OT_ARRAY; data.pArray = pArray; }
 	void                 SetTable(CSquirrelArguments * pTable) { reset(); type = OT_TABLE; data.pArray = pTable; }
 	void                 SetInstance(SQInstance * pInstance) { reset(); type = OT_INSTANCE; data.pInstance = pInstance; }
@@ -100,20 +103,41 @@ public:
 	SQInstance         * GetInstance() const { return type == OT_INSTANCE ? data.pInstance : NULL; }
 };
 
-class CSquirrelArguments : public std::list<CSquirrelArgument*>
+// Amount of arguments stored inside CSquirrelArguments itself, only
+// arguments after these are allocated
+#define SQUIRREL_ARGUMENTS_INLINE_SIZE 8
+
+class CSquirrelArguments
 #ifdef _SERVER
-	, public SquirrelArgumentsInterface
+	: public SquirrelArgumentsInterface
 #endif
 {
+private:
+	CSquirrelArgument                m_inlineArguments[SQUIRREL_ARGUMENTS_INLINE_SIZE];
+	std::vector<CSquirrelArgument *> m_spillArguments;
+	unsigned int                     m_uiSize;
+
+	CSquirrelArgument * next();
+
 public:
-	CSquirrelArguments(){}
+	CSquirrelArguments() { m_uiSize = 0; }
 	CSquirrelArguments(SQVM * pVM, int idx);
 	CSquirrelArguments(CBitStream * pBitStream);
 	CSquirrelArguments(const CSquirrelArguments& p);
 	~CSquirrelArguments();
 
+	CSquirrelArguments& operator = (const CSquirrelArguments& p);
+
 	void reset();
 
+	unsigned int        size() const { return m_uiSize; }
+	bool                empty() const { return (m_uiSize == 0); }
+	CSquirrelArgument * get(unsigned int i) const;
+	CSquirrelArgument * front() const { return get(0); }
+	CSquirrelArgument * back() const { return (m_uiSize > 0 ? get(m_uiSize - 1) : NULL); }
+	void                pop_front();
+	void                pop_back();
+
 	void push_to_vm(SQVM* pVM);
 
 	void push();
@@ -133,7 +157,7 @@ public:
 	void deserialize(CBitStream * pBitStream);
 
 #ifdef _SERVER
-	SquirrelArgumentInterface* Get(unsigned int i) const;
+	SquirrelArgumentInterface* Get(unsigned int i) const { return get(i); }
 	unsigned int GetSize() const { return size(); }
 
 	SquirrelArgumentInterface* Add() { push(); return back(); }
@@ -0,0 +1,80 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CoroutineNatives.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CoroutineNatives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include "../CScriptingManager.h"
+#include "../../SharedUtility.h"
+
+extern CScriptingManager * g_pScriptingManager;
+
+// Coroutine functions
+
+void CCoroutineNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("async", Async, -1, NULL);
+	pScriptingManager->RegisterFunction("sleep", Delay, 1, "i");
+}
+
+// async(function, ...)
+// Calls the function with the arguments as a coroutine. It runs until it waits for
+// the first time (with sleep or the functions that wait when they get no callback,
+// like db.queryAsync and httpRequest) and goes on at the start of a later pulse
+// once the wait is over.
+SQInteger CCoroutineNatives::Async(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("async", 1);
+
+	if(sq_gettype(pVM, 2) != OT_NATIVECLOSURE)
+		CHECK_TYPE("async", 1, 2, OT_CLOSURE);
+
+	CSquirrel * pScript = g_pScriptingManager->Get(pVM);
+
+	if(!pScript)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	CSquirrelArguments arguments;
+
+	for(SQInteger i = 3; i <= sq_gettop(pVM); i++)
+		arguments.pushFromStack(pVM, (int)i);
+
+	sq_pushbool(pVM, g_pScriptingManager->StartCoroutine(pScript, stack_get(pVM, 2), &arguments));
+	return 1;
+}
+
+// sleep(milliseconds)
+// Lets the coroutine that calls it wait for at least the given time
+SQInteger CCoroutineNatives::Delay(SQVM * pVM)
+{
+	unsigned int uiCoroutine = g_pScriptingManager->GetCoroutine(pVM);
+
+	if(uiCoroutine == 0)
+	{
+		CLogFile::Print("Function sleep can only be called by a coroutine (See async).");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger iTime;
+	sq_getinteger(pVM, 2, &iTime);
+
+	// The coroutine goes on in the next pulse if it doesn't wait for any time
+	if(iTime <= 0)
+	{
+		g_pScriptingManager->ResumeCoroutine(uiCoroutine, CSquirrelArgument());
+		return g_pScriptingManager->SuspendCoroutine(pVM);
+	}
+
+	unsigned long ulWakeTime = (SharedUtility::GetFrameTime() + (unsigned long)iTime);
+	return g_pScriptingManager->SuspendCoroutine(pVM, (ulWakeTime != 0) ? ulWakeTime : 1);
+}
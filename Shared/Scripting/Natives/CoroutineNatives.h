@@ -0,0 +1,22 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CoroutineNatives.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Natives.h"
+
+class CCoroutineNatives
+{
+private:
+	static SQInteger Async(SQVM * pVM);
+	static SQInteger Delay(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
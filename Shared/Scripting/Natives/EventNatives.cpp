@@ -23,6 +23,9 @@ void CEventNatives::Register(CScriptingManager * pScriptingManager)
 	pScriptingManager->RegisterFunction("addEvent", Add, -1, NULL);
 	pScriptingManager->RegisterFunction("callEvent", Call, -1, NULL);
 	pScriptingManager->RegisterFunction("removeEvent", Remove, 2, "sc");
+#ifdef _SERVER
+	pScriptingManager->RegisterFunction("addThrottledEvent", AddThrottled, 3, "scn");
+#endif
 }
 
 // addEvent(eventname, function, ...)
@@ -37,6 +40,30 @@ SQInteger CEventNatives::Add(SQVM * pVM)
 	return 1;
 }
 
+#ifdef _SERVER
+// addThrottledEvent(eventname, function, maxfrequency)
+SQInteger CEventNatives::AddThrottled(SQVM * pVM)
+{
+	const char * szEventName;
+	SQObjectPtr pFunction;
+	SQFloat fMaxFrequency;
+	sq_getstring(pVM, 2, &szEventName);
+	pFunction = stack_get(pVM, 3);
+	sq_getfloat(pVM, 4, &fMaxFrequency);
+
+	// The frequency is in calls per second
+	if(fMaxFrequency <= 0.0f)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	unsigned int uiInterval = (unsigned int)(1000.0f / fMaxFrequency);
+	sq_pushbool(pVM, g_pEvents->AddThrottled(szEventName, CSquirrelEventHandler(pVM, pFunction), uiInterval));
+	return 1;
+}
+#endif
+
 // TODO: 'Call for this script only' argument
 // callEvent(eventname, defaultretval, ...)
 SQInteger CEventNatives::Call(SQVM * pVM)
@@ -62,8 +89,7 @@ SQInteger CEventNatives::Call(SQVM * pVM)
 		return 1;
 	}
 
-	CSquirrelArgument pReturn(*pArguments.front());
-	pArguments.pop_front();
+	CSquirrelArgument pReturn = pArguments.pop();
 
 	// Call the event
 	g_pEvents->Call(szEventName, &pArguments, &pReturn);
@@ -79,6 +105,12 @@ SQInteger CEventNatives::Remove(SQVM * pVM)
 	sq_getstring(pVM, -2, &szEventName);
 	pFunction = stack_get(pVM, -1);
 
-	sq_pushbool(pVM, g_pEvents->Remove(szEventName, &CSquirrelEventHandler(pVM, pFunction)));
+	bool bRemoved = g_pEvents->Remove(szEventName, &CSquirrelEventHandler(pVM, pFunction));
+#ifdef _SERVER
+	// It can be a throttled handler as well
+	if(!bRemoved)
+		bRemoved = g_pEvents->RemoveThrottled(szEventName, CSquirrelEventHandler(pVM, pFunction));
+#endif
+	sq_pushbool(pVM, bRemoved);
 	return 1;
 }
@@ -18,6 +18,9 @@ private:
 	static SQInteger Add(SQVM * pVM);
 	static SQInteger Call(SQVM * pVM);
 	static SQInteger Remove(SQVM * pVM);
+#ifdef _SERVER
+	static SQInteger AddThrottled(SQVM * pVM);
+#endif
 
 public:
 	static void      Register(CScriptingManager * pScriptingManager);
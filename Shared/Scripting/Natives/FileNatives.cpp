@@ -0,0 +1,162 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: FileNatives.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "FileNatives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include "../CScriptingManager.h"
+#include "../../CFileWorker.h"
+#include <SharedUtility.h>
+
+extern CScriptingManager * g_pScriptingManager;
+
+// File functions, the files are in the files folder like with md5File
+
+void CFileNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("readFile", Read, -1, NULL);
+	pScriptingManager->RegisterFunction("writeFile", Write, -1, NULL);
+	pScriptingManager->RegisterFunction("hashFile", Hash, -1, NULL);
+}
+
+// Hands the request to the file worker, the callback (or the coroutine) is at
+// iCallback and the extra arguments after it
+SQInteger CFileNatives::Add(SQVM * pVM, FileRequest * pRequest, int iFile, int iCallback)
+{
+	if(!g_pFileWorker)
+	{
+		delete pRequest;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * szFileName;
+	sq_getstring(pVM, iFile, &szFileName);
+	String strFileName(szFileName);
+	SharedUtility::RemoveIllegalCharacters(strFileName);
+	pRequest->strPath = SharedUtility::GetAbsolutePath("files/%s", strFileName.Get());
+	pRequest->pVM = g_pScriptingManager->GetScriptVM(pVM);
+	pRequest->uiCoroutine = ((sq_gettop(pVM) < iCallback) ? g_pScriptingManager->GetCoroutine(pVM) : 0);
+
+	if(pRequest->uiCoroutine == 0 && sq_gettop(pVM) >= iCallback)
+	{
+		pRequest->pFunction = stack_get(pVM, iCallback);
+
+		for(SQInteger i = (iCallback + 1); i <= sq_gettop(pVM); i++)
+			pRequest->arguments.pushFromStack(pVM, (int)i);
+	}
+
+	unsigned int uiCoroutine = pRequest->uiCoroutine;
+
+	if(!g_pFileWorker->Add(pRequest))
+	{
+		CLogFile::Print("Failed to add the file request (Too many requests are waiting).");
+		delete pRequest;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	if(uiCoroutine != 0)
+		return g_pScriptingManager->SuspendCoroutine(pVM);
+
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// readFile(name, callback, ...)
+// The callback is called in a later server pulse with the content of the file
+// (or false and the error message) followed by the extra arguments. A coroutine
+// can leave out the callback, it then waits for the content (the error is thrown).
+SQInteger CFileNatives::Read(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("readFile", 1);
+	CHECK_TYPE("readFile", 1, 2, OT_STRING);
+
+	if(sq_gettop(pVM) >= 3 || g_pScriptingManager->GetCoroutine(pVM) == 0)
+	{
+		if(sq_gettype(pVM, 3) != OT_NATIVECLOSURE)
+			CHECK_TYPE("readFile", 2, 3, OT_CLOSURE);
+	}
+
+	FileRequest * pRequest = new FileRequest();
+	pRequest->type = FILE_REQUEST_READ;
+	return Add(pVM, pRequest, 2, 3);
+}
+
+// writeFile(name, data, [append,] [callback, ...])
+// The callback is called in a later server pulse with true (or false and the
+// error message) followed by the extra arguments. A coroutine that leaves out
+// the callback waits for the write (the error is thrown).
+SQInteger CFileNatives::Write(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("writeFile", 2);
+	CHECK_TYPE("writeFile", 1, 2, OT_STRING);
+	CHECK_TYPE("writeFile", 2, 3, OT_STRING);
+
+	// Append is optional
+	bool bAppend = false;
+	int iCallback = 4;
+
+	if(sq_gettype(pVM, 4) == OT_BOOL)
+	{
+		SQBool b;
+		sq_getbool(pVM, 4, &b);
+		bAppend = (b != 0);
+		iCallback = 5;
+	}
+
+	if(sq_gettop(pVM) >= iCallback && sq_gettype(pVM, iCallback) != OT_NATIVECLOSURE)
+		CHECK_TYPE("writeFile", (iCallback - 1), iCallback, OT_CLOSURE);
+
+	const char * szData;
+	sq_getstring(pVM, 3, &szData);
+	FileRequest * pRequest = new FileRequest();
+	pRequest->type = (bAppend ? FILE_REQUEST_APPEND : FILE_REQUEST_WRITE);
+	pRequest->strData.Set(szData, (unsigned int)sq_getsize(pVM, 3));
+	return Add(pVM, pRequest, 2, iCallback);
+}
+
+// hashFile(name, algorithm, callback, ...)
+// The algorithm is md5 or sha256. The callback is called in a later server
+// pulse with the hash as hex (or false and the error message) followed by the
+// extra arguments. A coroutine can leave out the callback, it then waits for
+// the hash (the error is thrown).
+SQInteger CFileNatives::Hash(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("hashFile", 2);
+	CHECK_TYPE("hashFile", 1, 2, OT_STRING);
+	CHECK_TYPE("hashFile", 2, 3, OT_STRING);
+
+	if(sq_gettop(pVM) >= 4 || g_pScriptingManager->GetCoroutine(pVM) == 0)
+	{
+		if(sq_gettype(pVM, 4) != OT_NATIVECLOSURE)
+			CHECK_TYPE("hashFile", 3, 4, OT_CLOSURE);
+	}
+
+	const char * szAlgorithm;
+	sq_getstring(pVM, 3, &szAlgorithm);
+	String strAlgorithm(szAlgorithm);
+	strAlgorithm.ToLower();
+	eFileRequestType type;
+
+	if(strAlgorithm == "md5")
+		type = FILE_REQUEST_HASH_MD5;
+	else if(strAlgorithm == "sha256")
+		type = FILE_REQUEST_HASH_SHA256;
+	else
+	{
+		CLogFile::Printf("Invalid algorithm %s for function hashFile (Expected md5 or sha256).", szAlgorithm);
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	FileRequest * pRequest = new FileRequest();
+	pRequest->type = type;
+	return Add(pVM, pRequest, 2, 4);
+}
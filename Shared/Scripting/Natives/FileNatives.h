@@ -0,0 +1,26 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: FileNatives.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Natives.h"
+
+struct FileRequest;
+
+class CFileNatives
+{
+private:
+	static SQInteger Add(SQVM * pVM, FileRequest * pRequest, int iFile, int iCallback);
+	static SQInteger Read(SQVM * pVM);
+	static SQInteger Write(SQVM * pVM);
+	static SQInteger Hash(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
@@ -0,0 +1,116 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: HttpNatives.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "HttpNatives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
+#include "../CScriptingManager.h"
+#include "../../CHttpRequestPool.h"
+
+extern CScriptingManager * g_pScriptingManager;
+
+// Http functions
+
+void CHttpNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("httpRequest", Request, -1, NULL);
+}
+
+// httpRequest(url, method, body, [contentType,] callback, ...)
+// The callback is called in a later server pulse with the status code and the
+// response (or false and the error message) followed by the extra arguments.
+// A coroutine can leave out the callback, it then waits for the response and
+// gets a table with status and body (the error is thrown).
+SQInteger CHttpNatives::Request(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN("httpRequest", 3);
+	CHECK_TYPE("httpRequest", 1, 2, OT_STRING);
+	CHECK_TYPE("httpRequest", 2, 3, OT_STRING);
+
+	// The content type is optional
+	int iCallback = (sq_gettype(pVM, 5) == OT_STRING ? 6 : 5);
+	unsigned int uiCoroutine = ((sq_gettop(pVM) < iCallback) ? g_pScriptingManager->GetCoroutine(pVM) : 0);
+
+	if(uiCoroutine == 0 && sq_gettype(pVM, iCallback) != OT_NATIVECLOSURE)
+		CHECK_TYPE("httpRequest", (iCallback - 1), iCallback, OT_CLOSURE);
+
+	if(!g_pHttpRequestPool)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * url;
+	const char * method;
+	sq_getstring(pVM, 2, &url);
+	sq_getstring(pVM, 3, &method);
+	String strMethod(method);
+	strMethod.ToUpper();
+
+	if(strMethod != "GET" && strMethod != "POST")
+	{
+		CLogFile::Printf("Invalid method %s for function httpRequest (Expected GET or POST).", method);
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	HttpRequest * pRequest = new HttpRequest();
+
+	if(!CHttpRequestPool::ParseUrl(url, pRequest->strHost, pRequest->usPort, pRequest->strPath))
+	{
+		CLogFile::Printf("Invalid url %s for function httpRequest (Only http urls are supported).", url);
+		delete pRequest;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pRequest->bPost = (strMethod == "POST");
+
+	// The body is only sent with post requests and can be null
+	if(sq_gettype(pVM, 4) == OT_STRING)
+	{
+		const char * body;
+		sq_getstring(pVM, 4, &body);
+		pRequest->strBody.Set(body);
+	}
+
+	if(iCallback == 6)
+	{
+		const char * contentType;
+		sq_getstring(pVM, 5, &contentType);
+		pRequest->strContentType.Set(contentType);
+	}
+	else
+		pRequest->strContentType.Set(DEFAULT_CONTENT_TYPE);
+
+	pRequest->pVM = g_pScriptingManager->GetScriptVM(pVM);
+	pRequest->uiCoroutine = uiCoroutine;
+
+	if(uiCoroutine == 0)
+	{
+		pRequest->pFunction = stack_get(pVM, iCallback);
+
+		for(SQInteger i = (iCallback + 1); i <= sq_gettop(pVM); i++)
+			pRequest->arguments.pushFromStack(pVM, (int)i);
+	}
+
+	if(!g_pHttpRequestPool->Add(pRequest))
+	{
+		CLogFile::Print("Failed to add the http request (Too many requests are waiting).");
+		delete pRequest;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	if(uiCoroutine != 0)
+		return g_pScriptingManager->SuspendCoroutine(pVM);
+
+	sq_pushbool(pVM, true);
+	return 1;
+}
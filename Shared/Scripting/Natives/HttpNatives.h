@@ -0,0 +1,21 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: HttpNatives.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Natives.h"
+
+class CHttpNatives
+{
+private:
+	static SQInteger Request(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
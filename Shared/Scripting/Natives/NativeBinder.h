@@ -0,0 +1,246 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: NativeBinder.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <Squirrel/squirrel.h>
+#include <Math/CMath.h>
+#include <CString.h>
+#include "../../Common.h"
+
+// The result of a typed native that can fail, the native returns false to the
+// script if it isn't valid
+template <typename T>
+struct NativeResult
+{
+	bool bValid;
+	T    value;
+
+	NativeResult() : bValid(false), value() { }
+	NativeResult(const T& _value) : bValid(true), value(_value) { }
+};
+
+// How a type is read from and pushed to a vm. The type mask of a native is made
+// from the masks of its arguments and checked by squirrel before the native is
+// called, so the values are read without checking them again.
+template <typename T>
+struct NativeType;
+
+template <>
+struct NativeType<int>
+{
+	enum { COUNT = 1 };
+	static const char * GetMask() { return "i"; }
+	static int  Get(SQVM * pVM, SQInteger iIndex) { SQInteger i; sq_getinteger(pVM, iIndex, &i); return (int)i; }
+	static void Push(SQVM * pVM, int iValue) { sq_pushinteger(pVM, iValue); }
+};
+
+template <>
+struct NativeType<EntityId>
+{
+	enum { COUNT = 1 };
+	static const char * GetMask() { return "i"; }
+	static EntityId Get(SQVM * pVM, SQInteger iIndex) { SQInteger i; sq_getinteger(pVM, iIndex, &i); return (EntityId)i; }
+	static void Push(SQVM * pVM, EntityId entityId) { sq_pushinteger(pVM, (SQInteger)entityId); }
+};
+
+template <>
+struct NativeType<float>
+{
+	enum { COUNT = 1 };
+	static const char * GetMask() { return "f"; }
+	static float Get(SQVM * pVM, SQInteger iIndex) { SQFloat f; sq_getfloat(pVM, iIndex, &f); return (float)f; }
+	static void Push(SQVM * pVM, float fValue) { sq_pushfloat(pVM, fValue); }
+};
+
+template <>
+struct NativeType<bool>
+{
+	enum { COUNT = 1 };
+	static const char * GetMask() { return "b"; }
+	static bool Get(SQVM * pVM, SQInteger iIndex) { SQBool b; sq_getbool(pVM, iIndex, &b); return (b != 0); }
+	static void Push(SQVM * pVM, bool bValue) { sq_pushbool(pVM, bValue); }
+};
+
+template <>
+struct NativeType<const char *>
+{
+	enum { COUNT = 1 };
+	static const char * GetMask() { return "s"; }
+	static const char * Get(SQVM * pVM, SQInteger iIndex) { const SQChar * sz; sq_getstring(pVM, iIndex, &sz); return sz; }
+	static void Push(SQVM * pVM, const char * szValue) { sq_pushstring(pVM, szValue, -1); }
+};
+
+template <>
+struct NativeType<String>
+{
+	enum { COUNT = 1 };
+	static const char * GetMask() { return "s"; }
+	static String Get(SQVM * pVM, SQInteger iIndex)
+	{
+		const SQChar * sz;
+		sq_getstring(pVM, iIndex, &sz);
+
+		// Not the format constructor, the string can have format specifiers
+		String strValue;
+		strValue.Set(sz);
+		return strValue;
+	}
+
+	static void Push(SQVM * pVM, const String& strValue) { sq_pushstring(pVM, strValue.Get(), -1); }
+};
+
+// Vectors are three float arguments and are returned as [x, y, z]
+template <>
+struct NativeType<CVector3>
+{
+	enum { COUNT = 3 };
+	static const char * GetMask() { return "fff"; }
+
+	static CVector3 Get(SQVM * pVM, SQInteger iIndex)
+	{
+		CVector3 vecValue;
+		vecValue.fX = NativeType<float>::Get(pVM, iIndex);
+		vecValue.fY = NativeType<float>::Get(pVM, (iIndex + 1));
+		vecValue.fZ = NativeType<float>::Get(pVM, (iIndex + 2));
+		return vecValue;
+	}
+
+	static void Push(SQVM * pVM, const CVector3& vecValue)
+	{
+		sq_newarray(pVM, 0);
+		sq_pushfloat(pVM, vecValue.fX);
+		sq_arrayappend(pVM, -2);
+		sq_pushfloat(pVM, vecValue.fY);
+		sq_arrayappend(pVM, -2);
+		sq_pushfloat(pVM, vecValue.fZ);
+		sq_arrayappend(pVM, -2);
+	}
+};
+
+template <typename T>
+struct NativeType<NativeResult<T> >
+{
+	static void Push(SQVM * pVM, const NativeResult<T>& result)
+	{
+		if(result.bValid)
+			NativeType<T>::Push(pVM, result.value);
+		else
+			sq_pushbool(pVM, false);
+	}
+};
+
+// A native bound from a plain function. Each arity has its own binder and
+// GetNativeBinder picks the one that matches the function.
+template <typename R>
+struct NativeBinder0
+{
+	template <R (* pfnFunction)()>
+	static SQInteger Call(SQVM * pVM)
+	{
+		NativeType<R>::Push(pVM, pfnFunction());
+		return 1;
+	}
+
+	template <R (* pfnFunction)()>
+	SQFUNCTION GetFunction() { return &Call<pfnFunction>; }
+	int        GetParameterCount() { return 0; }
+	String     GetTypeMask() { return String(); }
+};
+
+template <typename R, typename A1>
+struct NativeBinder1
+{
+	template <R (* pfnFunction)(A1)>
+	static SQInteger Call(SQVM * pVM)
+	{
+		A1 a1 = NativeType<A1>::Get(pVM, 2);
+		NativeType<R>::Push(pVM, pfnFunction(a1));
+		return 1;
+	}
+
+	template <R (* pfnFunction)(A1)>
+	SQFUNCTION GetFunction() { return &Call<pfnFunction>; }
+	int        GetParameterCount() { return NativeType<A1>::COUNT; }
+	String     GetTypeMask() { String strMask; strMask.Set(NativeType<A1>::GetMask()); return strMask; }
+};
+
+template <typename R, typename A1, typename A2>
+struct NativeBinder2
+{
+	template <R (* pfnFunction)(A1, A2)>
+	static SQInteger Call(SQVM * pVM)
+	{
+		SQInteger iIndex = 2;
+		A1 a1 = NativeType<A1>::Get(pVM, iIndex);
+		iIndex += NativeType<A1>::COUNT;
+		A2 a2 = NativeType<A2>::Get(pVM, iIndex);
+		NativeType<R>::Push(pVM, pfnFunction(a1, a2));
+		return 1;
+	}
+
+	template <R (* pfnFunction)(A1, A2)>
+	SQFUNCTION GetFunction() { return &Call<pfnFunction>; }
+	int        GetParameterCount() { return (NativeType<A1>::COUNT + NativeType<A2>::COUNT); }
+
+	String GetTypeMask()
+	{
+		String strMask;
+		strMask.Set(NativeType<A1>::GetMask());
+		strMask.Append(NativeType<A2>::GetMask());
+		return strMask;
+	}
+};
+
+template <typename R, typename A1, typename A2, typename A3>
+struct NativeBinder3
+{
+	template <R (* pfnFunction)(A1, A2, A3)>
+	static SQInteger Call(SQVM * pVM)
+	{
+		SQInteger iIndex = 2;
+		A1 a1 = NativeType<A1>::Get(pVM, iIndex);
+		iIndex += NativeType<A1>::COUNT;
+		A2 a2 = NativeType<A2>::Get(pVM, iIndex);
+		iIndex += NativeType<A2>::COUNT;
+		A3 a3 = NativeType<A3>::Get(pVM, iIndex);
+		NativeType<R>::Push(pVM, pfnFunction(a1, a2, a3));
+		return 1;
+	}
+
+	template <R (* pfnFunction)(A1, A2, A3)>
+	SQFUNCTION GetFunction() { return &Call<pfnFunction>; }
+	int        GetParameterCount() { return (NativeType<A1>::COUNT + NativeType<A2>::COUNT + NativeType<A3>::COUNT); }
+
+	String GetTypeMask()
+	{
+		String strMask;
+		strMask.Set(NativeType<A1>::GetMask());
+		strMask.Append(NativeType<A2>::GetMask());
+		strMask.Append(NativeType<A3>::GetMask());
+		return strMask;
+	}
+};
+
+template <typename R>
+NativeBinder0<R> GetNativeBinder(R (*)()) { return NativeBinder0<R>(); }
+
+template <typename R, typename A1>
+NativeBinder1<R, A1> GetNativeBinder(R (*)(A1)) { return NativeBinder1<R, A1>(); }
+
+template <typename R, typename A1, typename A2>
+NativeBinder2<R, A1, A2> GetNativeBinder(R (*)(A1, A2)) { return NativeBinder2<R, A1, A2>(); }
+
+template <typename R, typename A1, typename A2, typename A3>
+NativeBinder3<R, A1, A2, A3> GetNativeBinder(R (*)(A1, A2, A3)) { return NativeBinder3<R, A1, A2, A3>(); }
+
+// Registers a typed native, its parameter count and type mask come from the function
+#define REGISTER_TYPED_NATIVE(pScriptingManager, szName, pfnFunction) \
+	(pScriptingManager)->RegisterFunction(szName, GetNativeBinder(pfnFunction).GetFunction<pfnFunction>(), \
+		GetNativeBinder(pfnFunction).GetParameterCount(), GetNativeBinder(pfnFunction).GetTypeMask())
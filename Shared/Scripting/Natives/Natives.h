@@ -15,6 +15,7 @@
 #include <Squirrel/sqstdio.h>
 #include "../../CLogFile.h"
 #include "../../Common.h"
+#include "NativeBinder.h"
 
 #define SQUIRREL_FUNCTION(name) SQInteger sq_##name(SQVM * pVM)
 
@@ -92,6 +93,47 @@ static SQRESULT sq_getvector3(SQVM * pVM, SQInteger iIndex, CVector3 * pVector)
 	return SQ_OK;
 }
 
+// Pushes the element iElement of the array at iIndex, nothing is pushed on failure
+static SQRESULT sq_pusharrayelement(SQVM * pVM, SQInteger iIndex, SQInteger iElement)
+{
+	if(iIndex < 0)
+		iIndex = (sq_gettop(pVM) + iIndex + 1);
+
+	sq_pushinteger(pVM, iElement);
+	return sq_get(pVM, iIndex);
+}
+
+static SQRESULT sq_getarrayinteger(SQVM * pVM, SQInteger iIndex, SQInteger iElement, SQInteger * pInteger)
+{
+	if(SQ_FAILED(sq_pusharrayelement(pVM, iIndex, iElement)))
+		return SQ_ERROR;
+
+	SQRESULT res = sq_getinteger(pVM, -1, pInteger);
+	sq_pop(pVM, 1);
+	return res;
+}
+
+static SQRESULT sq_getarrayfloat(SQVM * pVM, SQInteger iIndex, SQInteger iElement, float * pFloat)
+{
+	if(SQ_FAILED(sq_pusharrayelement(pVM, iIndex, iElement)))
+		return SQ_ERROR;
+
+	SQRESULT res = sq_getfloat(pVM, -1, (SQFloat *)pFloat);
+	sq_pop(pVM, 1);
+	return res;
+}
+
+// Reads the elements iElement..iElement+2 of the array at iIndex
+static SQRESULT sq_getarrayvector3(SQVM * pVM, SQInteger iIndex, SQInteger iElement, CVector3 * pVector)
+{
+	if(SQ_FAILED(sq_getarrayfloat(pVM, iIndex, iElement, &pVector->fX)) ||
+		SQ_FAILED(sq_getarrayfloat(pVM, iIndex, (iElement + 1), &pVector->fY)) ||
+		SQ_FAILED(sq_getarrayfloat(pVM, iIndex, (iElement + 2), &pVector->fZ)))
+		return SQ_ERROR;
+
+	return SQ_OK;
+}
+
 static void sq_pusharg(SQVM * pVM, CSquirrelArgument arg)
 {
 	arg.push(pVM);
@@ -110,4 +152,9 @@ static void sq_getarg(SQVM * pVM, SQInteger iIndex, CSquirrelArgument * arg)
 #include "SQLiteNatives.h"
 #include "TimerNatives.h"
 #include "HashNatives.h"
+#include "SerializationNatives.h"
+#include "SharedDataNatives.h"
+#include "HttpNatives.h"
+#include "FileNatives.h"
 #include "WorldNatives.h"
+#include "CoroutineNatives.h"
@@ -10,28 +10,80 @@
 // TODO: Move to server
 
 #include "Natives.h"
+#include <Squirrel/sqstate.h>
+#include <Squirrel/sqvm.h>
 #include "../CScriptingManager.h"
 #include "../../CSQLite.h"
+#include "../../CSQLiteWorker.h"
+#include "../../CSQLiteCache.h"
+#include "../../CSettings.h"
 #include "sqlite/sqlite3.h"
 #include <SharedUtility.h>
 
+extern CScriptingManager * g_pScriptingManager;
+
+// Instance of a dbStatement, the statement is owned by the statement cache
+// of the database again once it is closed
+struct SQLiteStatement
+{
+	CSQLite *      pSQLite;
+	sqlite3_stmt * pStatement;
+	bool           bRow;
+};
+
 // SQLite Database
 _BEGIN_CLASS(db)
 _MEMBER_FUNCTION(db, constructor, 1, "s")
-_MEMBER_FUNCTION(db, query, 1, "s")
+_MEMBER_FUNCTION(db, query, -1, NULL)
+_MEMBER_FUNCTION(db, queryAsync, -1, NULL)
+_MEMBER_FUNCTION(db, prepare, 1, "s")
 _MEMBER_FUNCTION(db, close, 0, NULL)
 _END_CLASS(db)
 
+// SQLite Prepared Statement
+_BEGIN_CLASS(dbStatement)
+_MEMBER_FUNCTION(dbStatement, constructor, 2, "xs")
+_MEMBER_FUNCTION(dbStatement, bind, 2, "i|s.")
+_MEMBER_FUNCTION(dbStatement, step, 0, NULL)
+_MEMBER_FUNCTION(dbStatement, getRow, 0, NULL)
+_MEMBER_FUNCTION(dbStatement, fetch, 1, "i")
+_MEMBER_FUNCTION(dbStatement, column, 1, "i|s")
+_MEMBER_FUNCTION(dbStatement, columnCount, 0, NULL)
+_MEMBER_FUNCTION(dbStatement, columnName, 1, "i")
+_MEMBER_FUNCTION(dbStatement, reset, 0, NULL)
+_MEMBER_FUNCTION(dbStatement, close, 0, NULL)
+_END_CLASS(dbStatement)
+
+// SQLite Database Cache
+_BEGIN_CLASS(dbCache)
+_MEMBER_FUNCTION(dbCache, constructor, -1, NULL)
+_MEMBER_FUNCTION(dbCache, get, 1, "s")
+_MEMBER_FUNCTION(dbCache, set, 2, "s.")
+_MEMBER_FUNCTION(dbCache, remove, 1, "s")
+_MEMBER_FUNCTION(dbCache, has, 1, "s")
+_MEMBER_FUNCTION(dbCache, keys, 0, NULL)
+_MEMBER_FUNCTION(dbCache, flush, 0, NULL)
+_MEMBER_FUNCTION(dbCache, close, 0, NULL)
+_MEMBER_FUNCTION(dbCache, getError, 0, NULL)
+_END_CLASS(dbCache)
+
 void RegisterSQLiteNatives(CScriptingManager * pScriptingManager)
 {
 	pScriptingManager->RegisterClass(&_CLASS_DECL(db));
+	pScriptingManager->RegisterClass(&_CLASS_DECL(dbStatement));
+	pScriptingManager->RegisterClass(&_CLASS_DECL(dbCache));
 }
 
 _MEMBER_FUNCTION_RELEASE_HOOK(db)
 {
 	CSQLite * pSQLite = (CSQLite *)pInst;
+
+	if(g_pSQLiteWorker)
+		g_pSQLiteWorker->WaitForDatabase(pSQLite);
+
+	// The database stays open until its statements are released as well
 	pSQLite->close();
-	delete pSQLite;
+	pSQLite->release();
 	return 1;
 }
 
@@ -65,94 +117,148 @@ _MEMBER_FUNCTION_IMPL(db, constructor)
 	return 1;
 }
 
-// TODO: Fix this function
+// db.query(query, ...)
+// The extra arguments (or a table of named arguments) are bound to the
+// parameters of the query
 _MEMBER_FUNCTION_IMPL(db, query)
 {
-	char * query;
-	sq_getstring(pVM, -1, (const char **)&query);
-	if(query)
+	CHECK_PARAMS_MIN("db.query", 1);
+	CHECK_TYPE("db.query", 1, 2, OT_STRING);
+
+	const char * query;
+	sq_getstring(pVM, 2, &query);
+
+	CSQLite * pSQLite = sq_getinstance<CSQLite *>(pVM);
+
+	if(!pSQLite)
 	{
-		CSQLite * pSQLite = sq_getinstance<CSQLite *>(pVM);
+		CLogFile::Print("Failed to get the database instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
 
-		if(!pSQLite)
-		{
-			CLogFile::Print("Failed to get the database instance.");
-			sq_pushbool(pVM, false);
-			return 1;
-		}
+	// Run after the asynchronous queries of the database so their order
+	// (and any transaction they started) is kept
+	if(g_pSQLiteWorker)
+		g_pSQLiteWorker->WaitForDatabase(pSQLite);
+
+	// TODO: let the user get the error message using a seperate function
+	CSquirrelArguments parameters(pVM, 3);
+	CSquirrelArgument rows(new CSquirrelArguments(), false);
+
+	if(!pSQLite->query(query, &parameters, rows.GetTable()))
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	rows.push(pVM);
+	return 1;
+}
 
-		sqlite3 * database = pSQLite->getDatabase();
-		sqlite3_stmt * stmt;
+// db.queryAsync(query, [parameters,] callback, ...)
+// The callback is called in a later server pulse with the rows (or false and
+// the error message) followed by the extra arguments. A coroutine can leave out
+// the callback, it then waits for the query and gets the rows (the error is thrown).
+_MEMBER_FUNCTION_IMPL(db, queryAsync)
+{
+	CHECK_PARAMS_MIN("db.queryAsync", 1);
+	CHECK_TYPE("db.queryAsync", 1, 2, OT_STRING);
+
+	// The parameters are optional
+	int iCallback = ((sq_gettype(pVM, 3) == OT_ARRAY || sq_gettype(pVM, 3) == OT_TABLE) ? 4 : 3);
+	unsigned int uiCoroutine = ((sq_gettop(pVM) < iCallback) ? g_pScriptingManager->GetCoroutine(pVM) : 0);
+
+	if(uiCoroutine == 0 && sq_gettype(pVM, iCallback) != OT_NATIVECLOSURE)
+		CHECK_TYPE("db.queryAsync", (iCallback - 1), iCallback, OT_CLOSURE);
 
-		if(sqlite3_prepare(database, query, strlen(query) + 1, &stmt, 0) != SQLITE_OK)
+	CSQLite * pSQLite = sq_getinstance<CSQLite *>(pVM);
+
+	if(!pSQLite || !g_pSQLiteWorker)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * query;
+	sq_getstring(pVM, 2, &query);
+
+	SQLiteQuery * pQuery = new SQLiteQuery();
+	pQuery->pSQLite = pSQLite;
+	pQuery->strQuery.Set(query);
+	pQuery->pVM = g_pScriptingManager->GetScriptVM(pVM);
+	pQuery->uiCoroutine = uiCoroutine;
+
+	// An array is bound by position and a table by name
+	if(iCallback == 4)
+	{
+		if(sq_gettype(pVM, 3) == OT_TABLE)
+			pQuery->parameters.pushFromStack(pVM, 3);
+		else
 		{
-			//const char * errmsg = sqlite3_errmsg(database); // TODO: let the user get the error message using a seperate function
-			sq_pushbool(pVM, false);
-			//sq_pushstring(vm, errmsg, sizeof(errmsg));
-			return 1;
+			CSquirrelArgument parameters;
+			parameters.pushFromStack(pVM, 3);
+			pQuery->parameters = *parameters.GetArray();
 		}
+	}
+
+	// Keep the database instance alive until the callback has been called
+	pQuery->pDatabase = stack_get(pVM, 1);
 
-		sq_newtable(pVM);
+	if(uiCoroutine == 0)
+	{
+		pQuery->pFunction = stack_get(pVM, iCallback);
 
-		SQInteger rowCount = 0;
-		//sqlite3_step(stmt);
+		for(SQInteger i = (iCallback + 1); i <= sq_gettop(pVM); i++)
+			pQuery->arguments.pushFromStack(pVM, (int)i);
+	}
 
-		while(sqlite3_step(stmt) == SQLITE_ROW)
-		{
-			rowCount++;
-			SQInteger colCount = sqlite3_column_count(stmt);
+	if(!g_pSQLiteWorker->Add(pQuery))
+	{
+		CLogFile::Print("Failed to add the database query (Too many queries are waiting).");
+		delete pQuery;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
 
-			sq_pushinteger(pVM, rowCount);
-			sq_newtable(pVM);
+	if(uiCoroutine != 0)
+		return g_pScriptingManager->SuspendCoroutine(pVM);
 
-			for(SQInteger i = 0; i < colCount; i++)
-			{
-				SQInteger columnType = sqlite3_column_type(stmt, i);
-				const char * columnName = sqlite3_column_name(stmt, i);
-
-				sq_pushstring(pVM, columnName, strlen(columnName));
-
-				SQInteger type = sqlite3_column_type(stmt, i);
-
-				switch(type)
-				{
-				case SQLITE_NULL:
-					break;
-				case SQLITE_INTEGER:
-					sq_pushinteger(pVM, sqlite3_column_int(stmt, i));
-					break;
-				case SQLITE_FLOAT:
-					sq_pushfloat(pVM, (float)sqlite3_column_double(stmt, i));
-					break;
-				case SQLITE_BLOB:
-					/*SQInteger length = sqlite3_column_bytes(stmt, i);
-					if(length > 0) {
-					new unsigned char val[length];
-					memcpy(val, (const void *)sqlite3_column_blob(stmt, i), length);
-					sq_pushstring(vm, val, sizeof(val));
-					}*/
-					break;
-				default:
-					/*SQInteger length = sqlite3_column_bytes(stmt, i) + 1;
-					new unsigned char val[length];
-					memcpy(val, sqlite3_column_text(stmt, i), length);
-
-					sq_pushstring(vm, val, sizeof(val));*/
-					break;
-
-				}
-
-				sq_createslot(pVM, -3);
-			}
+	sq_pushbool(pVM, true);
+	return 1;
+}
 
-			sq_createslot(pVM, -3);
-		}
+// db.prepare(query)
+// Same as dbStatement(db, query)
+_MEMBER_FUNCTION_IMPL(db, prepare)
+{
+	sq_pushroottable(pVM);
+	sq_pushstring(pVM, "dbStatement", -1);
 
-		sqlite3_finalize(stmt);
+	if(SQ_FAILED(sq_get(pVM, -2)))
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// Call the class with the database and the query to create the instance
+	sq_pushroottable(pVM);
+	sq_push(pVM, 1);
+	sq_push(pVM, 2);
+
+	if(SQ_FAILED(sq_call(pVM, 3, SQTrue, SQTrue)))
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// The constructor leaves the instance empty if the query is invalid
+	if(!sq_getinstance<SQLiteStatement *>(pVM, -1))
+	{
+		sq_pushbool(pVM, false);
 		return 1;
 	}
 
-	sq_pushbool(pVM, false);
 	return 1;
 }
 
@@ -167,6 +273,568 @@ _MEMBER_FUNCTION_IMPL(db, close)
 		return 1;
 	}
 
+	if(g_pSQLiteWorker)
+		g_pSQLiteWorker->WaitForDatabase(pSQLite);
+
 	sq_pushbool(pVM, pSQLite->close());
 	return 1;
 }
+
+_MEMBER_FUNCTION_RELEASE_HOOK(dbStatement)
+{
+	SQLiteStatement * pStatement = (SQLiteStatement *)pInst;
+
+	if(pStatement->pStatement)
+	{
+		pStatement->pSQLite->finish(pStatement->pStatement);
+		pStatement->pSQLite->release();
+	}
+
+	delete pStatement;
+	return 1;
+}
+
+// Get the statement of a dbStatement instance, returns NULL if the statement
+// has been closed
+static SQLiteStatement * sq_getstatement(SQVM * pVM)
+{
+	SQLiteStatement * pStatement = sq_getinstance<SQLiteStatement *>(pVM);
+
+	if(!pStatement || !pStatement->pStatement)
+		return NULL;
+
+	return pStatement;
+}
+
+// Push a column of the current row straight to the vm
+static void sq_pushcolumn(SQVM * pVM, sqlite3_stmt * pStatement, int iColumn)
+{
+	switch(sqlite3_column_type(pStatement, iColumn))
+	{
+	case SQLITE_INTEGER:
+		sq_pushinteger(pVM, sqlite3_column_int(pStatement, iColumn));
+		break;
+	case SQLITE_FLOAT:
+		sq_pushfloat(pVM, (float)sqlite3_column_double(pStatement, iColumn));
+		break;
+	case SQLITE_NULL:
+		sq_pushnull(pVM);
+		break;
+	default:
+		{
+			// Text and blobs are both returned as strings
+			const char * szText = (const char *)sqlite3_column_text(pStatement, iColumn);
+			sq_pushstring(pVM, szText, sqlite3_column_bytes(pStatement, iColumn));
+		}
+		break;
+	}
+}
+
+// Push the current row as a table of column name to value
+static void sq_pushrow(SQVM * pVM, sqlite3_stmt * pStatement)
+{
+	int iColumns = sqlite3_column_count(pStatement);
+	sq_newtable(pVM);
+
+	for(int i = 0; i < iColumns; i++)
+	{
+		sq_pushstring(pVM, sqlite3_column_name(pStatement, i), -1);
+		sq_pushcolumn(pVM, pStatement, i);
+		sq_createslot(pVM, -3);
+	}
+}
+
+_MEMBER_FUNCTION_IMPL(dbStatement, constructor)
+{
+	CSQLite * pSQLite = sq_getinstance<CSQLite *>(pVM, 2);
+	const char * query;
+	sq_getstring(pVM, 3, &query);
+
+	if(!pSQLite)
+	{
+		CLogFile::Print("Failed to get the database instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// Only the first statement of the query is used
+	sqlite3_stmt * pPreparedStatement = NULL;
+
+	if(!pSQLite->prepare(query, &pPreparedStatement) || !pPreparedStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQLiteStatement * pStatement = new SQLiteStatement;
+	pStatement->pSQLite = pSQLite;
+	pStatement->pStatement = pPreparedStatement;
+	pStatement->bRow = false;
+
+	if(SQ_FAILED(sq_setinstance(pVM, pStatement)))
+	{
+		CLogFile::Print("Failed to set the statement instance.");
+		pSQLite->finish(pPreparedStatement);
+		delete pStatement;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// The statement keeps the database open
+	pSQLite->addref();
+	_SET_RELEASE_HOOK(dbStatement);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// dbStatement.bind(index or name, value)
+_MEMBER_FUNCTION_IMPL(dbStatement, bind)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger index = 0;
+
+	if(sq_gettype(pVM, 2) == OT_STRING)
+	{
+		const char * name;
+		sq_getstring(pVM, 2, &name);
+		index = sqlite3_bind_parameter_index(pStatement->pStatement, name);
+	}
+	else
+		sq_getinteger(pVM, 2, &index);
+
+	CSquirrelArgument value;
+	value.pushFromStack(pVM, 3);
+	sq_pushbool(pVM, (index > 0 && CSQLite::bind(pStatement->pStatement, (int)index, &value)));
+	return 1;
+}
+
+// dbStatement.step()
+// Returns true if there is a row and false if there are no more rows (or an
+// error happened)
+_MEMBER_FUNCTION_IMPL(dbStatement, step)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	if(g_pSQLiteWorker)
+		g_pSQLiteWorker->WaitForDatabase(pStatement->pSQLite);
+
+	pStatement->bRow = (sqlite3_step(pStatement->pStatement) == SQLITE_ROW);
+	sq_pushbool(pVM, pStatement->bRow);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(dbStatement, getRow)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement || !pStatement->bRow)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushrow(pVM, pStatement->pStatement);
+	return 1;
+}
+
+// dbStatement.fetch(amount)
+// Steps up to amount rows and returns them as an array of rows, the array is
+// empty once there are no more rows
+_MEMBER_FUNCTION_IMPL(dbStatement, fetch)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	SQInteger amount;
+	sq_getinteger(pVM, 2, &amount);
+
+	if(g_pSQLiteWorker)
+		g_pSQLiteWorker->WaitForDatabase(pStatement->pSQLite);
+
+	sq_newarray(pVM, 0);
+
+	for(SQInteger i = 0; i < amount; i++)
+	{
+		pStatement->bRow = (sqlite3_step(pStatement->pStatement) == SQLITE_ROW);
+
+		if(!pStatement->bRow)
+			break;
+
+		sq_pushrow(pVM, pStatement->pStatement);
+		sq_arrayappend(pVM, -2);
+	}
+
+	return 1;
+}
+
+// dbStatement.column(index or name)
+// Returns a column of the current row without building the whole row
+_MEMBER_FUNCTION_IMPL(dbStatement, column)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement || !pStatement->bRow)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	int iColumns = sqlite3_column_count(pStatement->pStatement);
+	SQInteger index = -1;
+
+	if(sq_gettype(pVM, 2) == OT_STRING)
+	{
+		const char * name;
+		sq_getstring(pVM, 2, &name);
+
+		for(int i = 0; i < iColumns; i++)
+		{
+			if(!strcmp(sqlite3_column_name(pStatement->pStatement, i), name))
+			{
+				index = i;
+				break;
+			}
+		}
+	}
+	else
+		sq_getinteger(pVM, 2, &index);
+
+	if(index < 0 || index >= iColumns)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushcolumn(pVM, pStatement->pStatement, (int)index);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(dbStatement, columnCount)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, sqlite3_column_count(pStatement->pStatement));
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(dbStatement, columnName)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+	SQInteger index;
+	sq_getinteger(pVM, 2, &index);
+
+	if(!pStatement || index < 0 || index >= sqlite3_column_count(pStatement->pStatement))
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushstring(pVM, sqlite3_column_name(pStatement->pStatement, (int)index), -1);
+	return 1;
+}
+
+// dbStatement.reset()
+// Resets the statement so it can be stepped again, the bound values are
+// cleared as well
+_MEMBER_FUNCTION_IMPL(dbStatement, reset)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sqlite3_reset(pStatement->pStatement);
+	sqlite3_clear_bindings(pStatement->pStatement);
+	pStatement->bRow = false;
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// dbStatement.close()
+// Gives the statement back to the statement cache of the database
+_MEMBER_FUNCTION_IMPL(dbStatement, close)
+{
+	SQLiteStatement * pStatement = sq_getstatement(pVM);
+
+	if(!pStatement)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pStatement->pSQLite->finish(pStatement->pStatement);
+	pStatement->pSQLite->release();
+	pStatement->pStatement = NULL;
+	pStatement->bRow = false;
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// Database cache
+
+_MEMBER_FUNCTION_RELEASE_HOOK(dbCache)
+{
+	CSQLiteCache * pCache = (CSQLiteCache *)pInst;
+
+	// Write everything that is still waiting before the cache is gone
+	pCache->Close();
+	delete pCache;
+	return 1;
+}
+
+// dbCache(filename, table[, flushInterval])
+// Keeps the records of the table in memory, the changes are written by a
+// thread of the cache each flush interval (in ms)
+_MEMBER_FUNCTION_IMPL(dbCache, constructor)
+{
+	CHECK_PARAMS_MIN_MAX("dbCache", 2, 3);
+	CHECK_TYPE("dbCache", 1, 2, OT_STRING);
+	CHECK_TYPE("dbCache", 2, 3, OT_STRING);
+
+#ifdef _SERVER
+	SQInteger iFlushInterval = CVAR_GET_INTEGER("dbcacheflushinterval");
+#else
+	SQInteger iFlushInterval = 5000;
+#endif
+
+	if(sq_gettop(pVM) >= 4)
+	{
+		CHECK_TYPE("dbCache", 3, 4, OT_INTEGER);
+		sq_getinteger(pVM, 4, &iFlushInterval);
+
+		if(iFlushInterval < 0)
+			iFlushInterval = 0;
+	}
+
+	const char * filename;
+	const char * table;
+	sq_getstring(pVM, 2, &filename);
+	sq_getstring(pVM, 3, &table);
+
+	String strFileName;
+	strFileName.Set(filename);
+	SharedUtility::RemoveIllegalCharacters(strFileName);
+	String strPath(SharedUtility::GetAbsolutePath("files/%s", strFileName.Get()));
+	String strTable;
+	strTable.Set(table);
+
+	CSQLiteCache * pCache = new CSQLiteCache();
+	String strError;
+
+	if(!pCache->Open(strPath, strTable, (unsigned long)iFlushInterval, strError))
+	{
+		CLogFile::Printf("Failed to open the database cache (%s).", strError.Get());
+		delete pCache;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	if(SQ_FAILED(sq_setinstance(pVM, pCache)))
+	{
+		CLogFile::Print("Failed to set the database cache instance.");
+		delete pCache;
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	_SET_RELEASE_HOOK(dbCache);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// dbCache.get(key)
+// Returns the value of the record or null if there is none
+_MEMBER_FUNCTION_IMPL(dbCache, get)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * key;
+	sq_getstring(pVM, 2, &key);
+	String strKey;
+	strKey.Set(key);
+	CSquirrelArgument * pValue = pCache->Get(strKey);
+
+	if(!pValue)
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	pValue->push(pVM);
+	return 1;
+}
+
+// dbCache.set(key, value)
+_MEMBER_FUNCTION_IMPL(dbCache, set)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * key;
+	sq_getstring(pVM, 2, &key);
+	String strKey;
+	strKey.Set(key);
+	CSquirrelArgument value;
+	value.pushFromStack(pVM, 3);
+	pCache->Set(strKey, value);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// dbCache.remove(key)
+_MEMBER_FUNCTION_IMPL(dbCache, remove)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * key;
+	sq_getstring(pVM, 2, &key);
+	String strKey;
+	strKey.Set(key);
+	sq_pushbool(pVM, pCache->Remove(strKey));
+	return 1;
+}
+
+// dbCache.has(key)
+_MEMBER_FUNCTION_IMPL(dbCache, has)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * key;
+	sq_getstring(pVM, 2, &key);
+	String strKey;
+	strKey.Set(key);
+	sq_pushbool(pVM, (pCache->Get(strKey) != NULL));
+	return 1;
+}
+
+// dbCache.keys()
+// Returns an array of the keys of all records
+_MEMBER_FUNCTION_IMPL(dbCache, keys)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const std::map<String, CSquirrelArgument *>& records = pCache->GetRecords();
+	sq_newarray(pVM, 0);
+
+	for(std::map<String, CSquirrelArgument *>::const_iterator iter = records.begin(); iter != records.end(); ++iter)
+	{
+		sq_pushstring(pVM, (*iter).first.Get(), (*iter).first.GetLength());
+		sq_arrayappend(pVM, -2);
+	}
+
+	return 1;
+}
+
+// dbCache.flush()
+// Hands the changed records to the writer now instead of at the next interval
+_MEMBER_FUNCTION_IMPL(dbCache, flush)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pCache->Flush();
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// dbCache.close()
+// Writes the changed records and waits until they are on disk
+_MEMBER_FUNCTION_IMPL(dbCache, close)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pCache->Close();
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// dbCache.getError()
+// Returns the error of the last write that failed since the last call or null
+_MEMBER_FUNCTION_IMPL(dbCache, getError)
+{
+	CSQLiteCache * pCache = sq_getinstance<CSQLiteCache *>(pVM);
+
+	if(!pCache)
+	{
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	String strError;
+
+	if(pCache->GetWriteError(strError))
+	{
+		sq_pushnull(pVM);
+		return 1;
+	}
+
+	sq_pushstring(pVM, strError.Get(), strError.GetLength());
+	return 1;
+}
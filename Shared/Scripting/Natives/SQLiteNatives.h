@@ -18,5 +18,26 @@
 
 	_MEMBER_FUNCTION_IMPL(db, constructor);
 	_MEMBER_FUNCTION_IMPL(db, query);
+	_MEMBER_FUNCTION_IMPL(db, queryAsync);
+	_MEMBER_FUNCTION_IMPL(db, prepare);
 	_MEMBER_FUNCTION_IMPL(db, close);
+	_MEMBER_FUNCTION_IMPL(dbStatement, constructor);
+	_MEMBER_FUNCTION_IMPL(dbStatement, bind);
+	_MEMBER_FUNCTION_IMPL(dbStatement, step);
+	_MEMBER_FUNCTION_IMPL(dbStatement, getRow);
+	_MEMBER_FUNCTION_IMPL(dbStatement, fetch);
+	_MEMBER_FUNCTION_IMPL(dbStatement, column);
+	_MEMBER_FUNCTION_IMPL(dbStatement, columnCount);
+	_MEMBER_FUNCTION_IMPL(dbStatement, columnName);
+	_MEMBER_FUNCTION_IMPL(dbStatement, reset);
+	_MEMBER_FUNCTION_IMPL(dbStatement, close);
+	_MEMBER_FUNCTION_IMPL(dbCache, constructor);
+	_MEMBER_FUNCTION_IMPL(dbCache, get);
+	_MEMBER_FUNCTION_IMPL(dbCache, set);
+	_MEMBER_FUNCTION_IMPL(dbCache, remove);
+	_MEMBER_FUNCTION_IMPL(dbCache, has);
+	_MEMBER_FUNCTION_IMPL(dbCache, keys);
+	_MEMBER_FUNCTION_IMPL(dbCache, flush);
+	_MEMBER_FUNCTION_IMPL(dbCache, close);
+	_MEMBER_FUNCTION_IMPL(dbCache, getError);
 //};
@@ -0,0 +1,854 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SerializationNatives.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "SerializationNatives.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Stack slots each nesting level of a value uses while it is written or read
+#define SERIALIZATION_STACK_PER_DEPTH 4
+
+// Serialization functions
+
+void CSerializationNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterFunction("toJSON", toJSON, 1, ".");
+	pScriptingManager->RegisterFunction("fromJSON", fromJSON, 1, "s");
+	pScriptingManager->RegisterFunction("pack", pack, 1, ".");
+	pScriptingManager->RegisterFunction("unpack", unpack, 1, "s");
+}
+
+static void WriteJSONString(std::string& strOut, const char * szString, SQInteger iLength)
+{
+	strOut += '"';
+
+	for(SQInteger i = 0; i < iLength; i++)
+	{
+		unsigned char c = (unsigned char)szString[i];
+
+		switch(c)
+		{
+		case '"': strOut += "\\\""; break;
+		case '\\': strOut += "\\\\"; break;
+		case '\b': strOut += "\\b"; break;
+		case '\f': strOut += "\\f"; break;
+		case '\n': strOut += "\\n"; break;
+		case '\r': strOut += "\\r"; break;
+		case '\t': strOut += "\\t"; break;
+		default:
+			if(c < 0x20)
+			{
+				char szEscape[8];
+				sprintf(szEscape, "\\u%04x", c);
+				strOut += szEscape;
+			}
+			else
+				strOut += (char)c;
+		}
+	}
+
+	strOut += '"';
+}
+
+static bool IsFinite(SQFloat fValue)
+{
+	// NaN fails the first test and infinity the second
+	return (fValue == fValue && (fValue - fValue) == 0);
+}
+
+static void WriteJSONNumber(std::string& strOut, SQFloat fValue)
+{
+	if(!IsFinite(fValue))
+	{
+		strOut += "null";
+		return;
+	}
+
+	char szNumber[32];
+	sprintf(szNumber, (sizeof(SQFloat) == sizeof(float)) ? "%.9g" : "%.17g", (double)fValue);
+	strOut += szNumber;
+
+	// Keep it a float when it is read back
+	if(!strpbrk(szNumber, ".eE"))
+		strOut += ".0";
+}
+
+// Writes the value at the top of the stack
+bool CSerializationNatives::WriteJSON(SQVM * pVM, std::string& strOut, int iDepth)
+{
+	switch(sq_gettype(pVM, -1))
+	{
+	case OT_BOOL:
+		{
+			SQBool b;
+			sq_getbool(pVM, -1, &b);
+			strOut += (b ? "true" : "false");
+		}
+		break;
+	case OT_INTEGER:
+		{
+			SQInteger i;
+			sq_getinteger(pVM, -1, &i);
+			char szNumber[24];
+			sprintf(szNumber, "%lld", (long long)i);
+			strOut += szNumber;
+		}
+		break;
+	case OT_FLOAT:
+		{
+			SQFloat f;
+			sq_getfloat(pVM, -1, &f);
+			WriteJSONNumber(strOut, f);
+		}
+		break;
+	case OT_STRING:
+		{
+			const char * szString;
+			sq_getstring(pVM, -1, &szString);
+			WriteJSONString(strOut, szString, sq_getsize(pVM, -1));
+		}
+		break;
+	case OT_ARRAY:
+	case OT_TABLE:
+		{
+			if(iDepth >= SERIALIZATION_MAX_DEPTH)
+				return false;
+
+			bool bArray = (sq_gettype(pVM, -1) == OT_ARRAY);
+			bool bFirst = true;
+			strOut += (bArray ? '[' : '{');
+			sq_pushnull(pVM);
+
+			while(SQ_SUCCEEDED(sq_next(pVM, -2)))
+			{
+				if(!bArray)
+				{
+					// JSON only has string keys, keys that can't be one are left out
+					SQObjectType keyType = sq_gettype(pVM, -2);
+
+					if(keyType != OT_STRING && keyType != OT_INTEGER && keyType != OT_FLOAT && keyType != OT_BOOL)
+					{
+						sq_pop(pVM, 2);
+						continue;
+					}
+				}
+
+				if(!bFirst)
+					strOut += ',';
+
+				bFirst = false;
+
+				if(!bArray)
+				{
+					if(sq_gettype(pVM, -2) == OT_STRING)
+					{
+						const char * szKey;
+						sq_getstring(pVM, -2, &szKey);
+						WriteJSONString(strOut, szKey, sq_getsize(pVM, -2));
+					}
+					else
+					{
+						std::string strKey;
+						sq_push(pVM, -2);
+						WriteJSON(pVM, strKey, iDepth + 1);
+						sq_pop(pVM, 1);
+						WriteJSONString(strOut, strKey.c_str(), (SQInteger)strKey.size());
+					}
+
+					strOut += ':';
+				}
+
+				if(!WriteJSON(pVM, strOut, iDepth + 1))
+				{
+					sq_pop(pVM, 3);
+					return false;
+				}
+
+				sq_pop(pVM, 2);
+			}
+
+			sq_pop(pVM, 1);
+			strOut += (bArray ? ']' : '}');
+		}
+		break;
+	default:
+		// Null and the types JSON has nothing for
+		strOut += "null";
+		break;
+	}
+
+	return true;
+}
+
+static void SkipJSONWhitespace(const char *& szIn, const char * szEnd)
+{
+	while(szIn < szEnd && (*szIn == ' ' || *szIn == '\t' || *szIn == '\n' || *szIn == '\r'))
+		szIn++;
+}
+
+static bool ReadJSONHex(const char *& szIn, const char * szEnd, unsigned int& uiValue)
+{
+	if((szEnd - szIn) < 4)
+		return false;
+
+	uiValue = 0;
+
+	for(int i = 0; i < 4; i++)
+	{
+		char c = *szIn++;
+		uiValue <<= 4;
+
+		if(c >= '0' && c <= '9')
+			uiValue |= (c - '0');
+		else if(c >= 'a' && c <= 'f')
+			uiValue |= (c - 'a' + 10);
+		else if(c >= 'A' && c <= 'F')
+			uiValue |= (c - 'A' + 10);
+		else
+			return false;
+	}
+
+	return true;
+}
+
+static void WriteUTF8(std::string& strOut, unsigned int uiCodePoint)
+{
+	if(uiCodePoint < 0x80)
+		strOut += (char)uiCodePoint;
+	else if(uiCodePoint < 0x800)
+	{
+		strOut += (char)(0xC0 | (uiCodePoint >> 6));
+		strOut += (char)(0x80 | (uiCodePoint & 0x3F));
+	}
+	else if(uiCodePoint < 0x10000)
+	{
+		strOut += (char)(0xE0 | (uiCodePoint >> 12));
+		strOut += (char)(0x80 | ((uiCodePoint >> 6) & 0x3F));
+		strOut += (char)(0x80 | (uiCodePoint & 0x3F));
+	}
+	else
+	{
+		strOut += (char)(0xF0 | (uiCodePoint >> 18));
+		strOut += (char)(0x80 | ((uiCodePoint >> 12) & 0x3F));
+		strOut += (char)(0x80 | ((uiCodePoint >> 6) & 0x3F));
+		strOut += (char)(0x80 | (uiCodePoint & 0x3F));
+	}
+}
+
+// Reads the string after the opening quote
+static bool ReadJSONString(const char *& szIn, const char * szEnd, std::string& strOut)
+{
+	while(szIn < szEnd)
+	{
+		unsigned char c = (unsigned char)*szIn++;
+
+		if(c == '"')
+			return true;
+
+		if(c < 0x20)
+			return false;
+
+		if(c != '\\')
+		{
+			strOut += (char)c;
+			continue;
+		}
+
+		if(szIn == szEnd)
+			return false;
+
+		switch(*szIn++)
+		{
+		case '"': strOut += '"'; break;
+		case '\\': strOut += '\\'; break;
+		case '/': strOut += '/'; break;
+		case 'b': strOut += '\b'; break;
+		case 'f': strOut += '\f'; break;
+		case 'n': strOut += '\n'; break;
+		case 'r': strOut += '\r'; break;
+		case 't': strOut += '\t'; break;
+		case 'u':
+			{
+				unsigned int uiCodePoint;
+
+				if(!ReadJSONHex(szIn, szEnd, uiCodePoint))
+					return false;
+
+				// Characters outside the basic plane come as a surrogate pair
+				if(uiCodePoint >= 0xD800 && uiCodePoint <= 0xDBFF)
+				{
+					unsigned int uiLow;
+
+					if((szEnd - szIn) < 2 || szIn[0] != '\\' || szIn[1] != 'u')
+						return false;
+
+					szIn += 2;
+
+					if(!ReadJSONHex(szIn, szEnd, uiLow) || uiLow < 0xDC00 || uiLow > 0xDFFF)
+						return false;
+
+					uiCodePoint = (0x10000 + ((uiCodePoint - 0xD800) << 10) + (uiLow - 0xDC00));
+				}
+				else if(uiCodePoint >= 0xDC00 && uiCodePoint <= 0xDFFF)
+					return false;
+
+				WriteUTF8(strOut, uiCodePoint);
+			}
+			break;
+		default:
+			return false;
+		}
+	}
+
+	return false;
+}
+
+static bool ReadJSONLiteral(const char *& szIn, const char * szEnd, const char * szLiteral)
+{
+	size_t sLength = strlen(szLiteral);
+
+	if((size_t)(szEnd - szIn) < sLength || memcmp(szIn, szLiteral, sLength))
+		return false;
+
+	szIn += sLength;
+	return true;
+}
+
+static bool ReadJSONNumber(SQVM * pVM, const char *& szIn, const char * szEnd)
+{
+	const char * szStart = szIn;
+	bool bNegative = false;
+	bool bFloat = false;
+	bool bOverflow = false;
+	unsigned long long ullValue = 0;
+
+	if(szIn < szEnd && *szIn == '-')
+	{
+		bNegative = true;
+		szIn++;
+	}
+
+	if(szIn == szEnd || *szIn < '0' || *szIn > '9')
+		return false;
+
+	while(szIn < szEnd && *szIn >= '0' && *szIn <= '9')
+	{
+		if(ullValue > (0x7FFFFFFFFFFFFFFFULL / 10))
+			bOverflow = true;
+
+		ullValue = (ullValue * 10 + (*szIn++ - '0'));
+	}
+
+	if(szIn < szEnd && *szIn == '.')
+	{
+		bFloat = true;
+		szIn++;
+
+		if(szIn == szEnd || *szIn < '0' || *szIn > '9')
+			return false;
+
+		while(szIn < szEnd && *szIn >= '0' && *szIn <= '9')
+			szIn++;
+	}
+
+	if(szIn < szEnd && (*szIn == 'e' || *szIn == 'E'))
+	{
+		bFloat = true;
+		szIn++;
+
+		if(szIn < szEnd && (*szIn == '+' || *szIn == '-'))
+			szIn++;
+
+		if(szIn == szEnd || *szIn < '0' || *szIn > '9')
+			return false;
+
+		while(szIn < szEnd && *szIn >= '0' && *szIn <= '9')
+			szIn++;
+	}
+
+	if(!bFloat && !bOverflow)
+	{
+		long long llValue = (bNegative ? -(long long)ullValue : (long long)ullValue);
+
+		// Integers that don't fit a squirrel integer become floats
+		if((long long)(SQInteger)llValue == llValue)
+		{
+			sq_pushinteger(pVM, (SQInteger)llValue);
+			return true;
+		}
+	}
+
+	// The input is a squirrel string so there is always a terminator after it
+	sq_pushfloat(pVM, (SQFloat)strtod(szStart, NULL));
+	return true;
+}
+
+// Reads a value and pushes it onto the stack
+bool CSerializationNatives::ReadJSON(SQVM * pVM, const char *& szIn, const char * szEnd, int iDepth)
+{
+	SkipJSONWhitespace(szIn, szEnd);
+
+	if(szIn == szEnd)
+		return false;
+
+	switch(*szIn)
+	{
+	case '{':
+		{
+			if(iDepth >= SERIALIZATION_MAX_DEPTH)
+				return false;
+
+			szIn++;
+			sq_newtable(pVM);
+			SkipJSONWhitespace(szIn, szEnd);
+
+			if(szIn < szEnd && *szIn == '}')
+			{
+				szIn++;
+				return true;
+			}
+
+			while(true)
+			{
+				std::string strKey;
+				SkipJSONWhitespace(szIn, szEnd);
+
+				if(szIn == szEnd || *szIn++ != '"' || !ReadJSONString(szIn, szEnd, strKey))
+					return false;
+
+				SkipJSONWhitespace(szIn, szEnd);
+
+				if(szIn == szEnd || *szIn++ != ':')
+					return false;
+
+				sq_pushstring(pVM, strKey.data(), (SQInteger)strKey.size());
+
+				if(!ReadJSON(pVM, szIn, szEnd, iDepth + 1))
+					return false;
+
+				sq_newslot(pVM, -3, SQFalse);
+				SkipJSONWhitespace(szIn, szEnd);
+
+				if(szIn == szEnd)
+					return false;
+
+				if(*szIn == '}')
+				{
+					szIn++;
+					return true;
+				}
+
+				if(*szIn++ != ',')
+					return false;
+			}
+		}
+	case '[':
+		{
+			if(iDepth >= SERIALIZATION_MAX_DEPTH)
+				return false;
+
+			szIn++;
+			sq_newarray(pVM, 0);
+			SkipJSONWhitespace(szIn, szEnd);
+
+			if(szIn < szEnd && *szIn == ']')
+			{
+				szIn++;
+				return true;
+			}
+
+			while(true)
+			{
+				if(!ReadJSON(pVM, szIn, szEnd, iDepth + 1))
+					return false;
+
+				sq_arrayappend(pVM, -2);
+				SkipJSONWhitespace(szIn, szEnd);
+
+				if(szIn == szEnd)
+					return false;
+
+				if(*szIn == ']')
+				{
+					szIn++;
+					return true;
+				}
+
+				if(*szIn++ != ',')
+					return false;
+			}
+		}
+	case '"':
+		{
+			std::string strValue;
+			szIn++;
+
+			if(!ReadJSONString(szIn, szEnd, strValue))
+				return false;
+
+			sq_pushstring(pVM, strValue.data(), (SQInteger)strValue.size());
+		}
+		return true;
+	case 't':
+		if(!ReadJSONLiteral(szIn, szEnd, "true"))
+			return false;
+
+		sq_pushbool(pVM, true);
+		return true;
+	case 'f':
+		if(!ReadJSONLiteral(szIn, szEnd, "false"))
+			return false;
+
+		sq_pushbool(pVM, false);
+		return true;
+	case 'n':
+		if(!ReadJSONLiteral(szIn, szEnd, "null"))
+			return false;
+
+		sq_pushnull(pVM);
+		return true;
+	}
+
+	return ReadJSONNumber(pVM, szIn, szEnd);
+}
+
+void CSerializationNatives::WriteVarInt(std::string& strOut, unsigned long long ullValue)
+{
+	while(ullValue >= 0x80)
+	{
+		strOut += (char)((ullValue & 0x7F) | 0x80);
+		ullValue >>= 7;
+	}
+
+	strOut += (char)ullValue;
+}
+
+bool CSerializationNatives::ReadVarInt(const unsigned char *& pIn, const unsigned char * pEnd, unsigned long long& ullValue)
+{
+	ullValue = 0;
+
+	for(int iShift = 0; iShift < 64; iShift += 7)
+	{
+		if(pIn == pEnd)
+			return false;
+
+		unsigned char ucByte = *pIn++;
+		ullValue |= ((unsigned long long)(ucByte & 0x7F) << iShift);
+
+		if(!(ucByte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+// Writes the value at the top of the stack
+bool CSerializationNatives::WritePacked(SQVM * pVM, std::string& strOut, int iDepth)
+{
+	switch(sq_gettype(pVM, -1))
+	{
+	case OT_BOOL:
+		{
+			SQBool b;
+			sq_getbool(pVM, -1, &b);
+			strOut += (char)(b ? SERIALIZATION_TAG_TRUE : SERIALIZATION_TAG_FALSE);
+		}
+		break;
+	case OT_INTEGER:
+		{
+			SQInteger i;
+			sq_getinteger(pVM, -1, &i);
+			long long llValue = (long long)i;
+
+			// Zigzag so small negative numbers stay short
+			strOut += (char)SERIALIZATION_TAG_INTEGER;
+			WriteVarInt(strOut, (((unsigned long long)llValue << 1) ^ (unsigned long long)(llValue >> 63)));
+		}
+		break;
+	case OT_FLOAT:
+		{
+			SQFloat f;
+			sq_getfloat(pVM, -1, &f);
+			unsigned long long ullBits = 0;
+			int iBytes;
+
+			if(sizeof(SQFloat) == sizeof(float))
+			{
+				float fValue = (float)f;
+				unsigned int uiBits;
+				memcpy(&uiBits, &fValue, sizeof(uiBits));
+				ullBits = uiBits;
+				iBytes = 4;
+				strOut += (char)SERIALIZATION_TAG_FLOAT;
+			}
+			else
+			{
+				double dValue = (double)f;
+				memcpy(&ullBits, &dValue, sizeof(ullBits));
+				iBytes = 8;
+				strOut += (char)SERIALIZATION_TAG_DOUBLE;
+			}
+
+			for(int i = 0; i < iBytes; i++)
+				strOut += (char)((ullBits >> (i * 8)) & 0xFF);
+		}
+		break;
+	case OT_STRING:
+		{
+			const char * szString;
+			sq_getstring(pVM, -1, &szString);
+			SQInteger iLength = sq_getsize(pVM, -1);
+			strOut += (char)SERIALIZATION_TAG_STRING;
+			WriteVarInt(strOut, (unsigned long long)iLength);
+			strOut.append(szString, (size_t)iLength);
+		}
+		break;
+	case OT_ARRAY:
+	case OT_TABLE:
+		{
+			if(iDepth >= SERIALIZATION_MAX_DEPTH)
+				return false;
+
+			bool bArray = (sq_gettype(pVM, -1) == OT_ARRAY);
+			strOut += (char)(bArray ? SERIALIZATION_TAG_ARRAY : SERIALIZATION_TAG_TABLE);
+			WriteVarInt(strOut, (unsigned long long)sq_getsize(pVM, -1));
+			sq_pushnull(pVM);
+
+			while(SQ_SUCCEEDED(sq_next(pVM, -2)))
+			{
+				if(!bArray)
+				{
+					sq_push(pVM, -2);
+
+					if(!WritePacked(pVM, strOut, iDepth + 1))
+					{
+						sq_pop(pVM, 4);
+						return false;
+					}
+
+					sq_pop(pVM, 1);
+				}
+
+				if(!WritePacked(pVM, strOut, iDepth + 1))
+				{
+					sq_pop(pVM, 3);
+					return false;
+				}
+
+				sq_pop(pVM, 2);
+			}
+
+			sq_pop(pVM, 1);
+		}
+		break;
+	default:
+		// Null and the types that can't be packed
+		strOut += (char)SERIALIZATION_TAG_NULL;
+		break;
+	}
+
+	return true;
+}
+
+// Reads a value and pushes it onto the stack
+bool CSerializationNatives::ReadPacked(SQVM * pVM, const unsigned char *& pIn, const unsigned char * pEnd, int iDepth)
+{
+	if(pIn == pEnd)
+		return false;
+
+	unsigned long long ullValue;
+
+	switch(*pIn++)
+	{
+	case SERIALIZATION_TAG_NULL:
+		sq_pushnull(pVM);
+		return true;
+	case SERIALIZATION_TAG_FALSE:
+		sq_pushbool(pVM, false);
+		return true;
+	case SERIALIZATION_TAG_TRUE:
+		sq_pushbool(pVM, true);
+		return true;
+	case SERIALIZATION_TAG_INTEGER:
+		if(!ReadVarInt(pIn, pEnd, ullValue))
+			return false;
+
+		sq_pushinteger(pVM, (SQInteger)((long long)(ullValue >> 1) ^ -(long long)(ullValue & 1)));
+		return true;
+	case SERIALIZATION_TAG_FLOAT:
+	case SERIALIZATION_TAG_DOUBLE:
+		{
+			bool bDouble = (*(pIn - 1) == SERIALIZATION_TAG_DOUBLE);
+			int iBytes = (bDouble ? 8 : 4);
+
+			if((pEnd - pIn) < iBytes)
+				return false;
+
+			unsigned long long ullBits = 0;
+
+			for(int i = 0; i < iBytes; i++)
+				ullBits |= ((unsigned long long)*pIn++ << (i * 8));
+
+			if(bDouble)
+			{
+				double dValue;
+				memcpy(&dValue, &ullBits, sizeof(dValue));
+				sq_pushfloat(pVM, (SQFloat)dValue);
+			}
+			else
+			{
+				unsigned int uiBits = (unsigned int)ullBits;
+				float fValue;
+				memcpy(&fValue, &uiBits, sizeof(fValue));
+				sq_pushfloat(pVM, (SQFloat)fValue);
+			}
+		}
+		return true;
+	case SERIALIZATION_TAG_STRING:
+		if(!ReadVarInt(pIn, pEnd, ullValue) || ullValue > (unsigned long long)(pEnd - pIn))
+			return false;
+
+		sq_pushstring(pVM, (const char *)pIn, (SQInteger)ullValue);
+		pIn += ullValue;
+		return true;
+	case SERIALIZATION_TAG_ARRAY:
+		// Every value is at least a byte so a count past the end of the data is invalid
+		if(iDepth >= SERIALIZATION_MAX_DEPTH || !ReadVarInt(pIn, pEnd, ullValue) || ullValue > (unsigned long long)(pEnd - pIn))
+			return false;
+
+		sq_newarray(pVM, 0);
+
+		for(unsigned long long i = 0; i < ullValue; i++)
+		{
+			if(!ReadPacked(pVM, pIn, pEnd, iDepth + 1))
+				return false;
+
+			sq_arrayappend(pVM, -2);
+		}
+
+		return true;
+	case SERIALIZATION_TAG_TABLE:
+		if(iDepth >= SERIALIZATION_MAX_DEPTH || !ReadVarInt(pIn, pEnd, ullValue) || ullValue > (unsigned long long)(pEnd - pIn) / 2)
+			return false;
+
+		sq_newtable(pVM);
+
+		for(unsigned long long i = 0; i < ullValue; i++)
+		{
+			if(!ReadPacked(pVM, pIn, pEnd, iDepth + 1) || !ReadPacked(pVM, pIn, pEnd, iDepth + 1))
+				return false;
+
+			// Fails for a null key
+			if(SQ_FAILED(sq_newslot(pVM, -3, SQFalse)))
+				return false;
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
+bool CSerializationNatives::Deserialize(SQVM * pVM, const char * szData, size_t sSize, bool bPacked)
+{
+	int iTop = sq_gettop(pVM);
+	sq_reservestack(pVM, (SERIALIZATION_MAX_DEPTH * SERIALIZATION_STACK_PER_DEPTH));
+
+	if(bPacked)
+	{
+		const unsigned char * pIn = (const unsigned char *)szData;
+		const unsigned char * pEnd = (pIn + sSize);
+
+		if(ReadPacked(pVM, pIn, pEnd, 0) && pIn == pEnd)
+			return true;
+	}
+	else
+	{
+		const char * szIn = szData;
+		const char * szEnd = (szData + sSize);
+
+		if(ReadJSON(pVM, szIn, szEnd, 0))
+		{
+			SkipJSONWhitespace(szIn, szEnd);
+
+			if(szIn == szEnd)
+				return true;
+		}
+	}
+
+	sq_settop(pVM, iTop);
+	return false;
+}
+
+// toJSON(value)
+SQInteger CSerializationNatives::toJSON(SQVM * pVM)
+{
+	std::string strOut;
+	sq_reservestack(pVM, (SERIALIZATION_MAX_DEPTH * SERIALIZATION_STACK_PER_DEPTH));
+	sq_push(pVM, 2);
+
+	if(!WriteJSON(pVM, strOut, 0))
+		return sq_throwerror(pVM, "value is nested too deep");
+
+	sq_pop(pVM, 1);
+	sq_pushstring(pVM, strOut.data(), (SQInteger)strOut.size());
+	return 1;
+}
+
+// fromJSON(string)
+SQInteger CSerializationNatives::fromJSON(SQVM * pVM)
+{
+	const char * szJSON;
+	sq_getstring(pVM, 2, &szJSON);
+	const char * szIn = szJSON;
+	const char * szEnd = (szJSON + sq_getsize(pVM, 2));
+	sq_reservestack(pVM, (SERIALIZATION_MAX_DEPTH * SERIALIZATION_STACK_PER_DEPTH));
+
+	if(ReadJSON(pVM, szIn, szEnd, 0))
+	{
+		SkipJSONWhitespace(szIn, szEnd);
+
+		if(szIn == szEnd)
+			return 1;
+	}
+
+	String strError("invalid JSON at offset %d", (int)(szIn - szJSON));
+	return sq_throwerror(pVM, strError.Get());
+}
+
+// pack(value)
+SQInteger CSerializationNatives::pack(SQVM * pVM)
+{
+	std::string strOut;
+	sq_reservestack(pVM, (SERIALIZATION_MAX_DEPTH * SERIALIZATION_STACK_PER_DEPTH));
+	sq_push(pVM, 2);
+
+	if(!WritePacked(pVM, strOut, 0))
+		return sq_throwerror(pVM, "value is nested too deep");
+
+	sq_pop(pVM, 1);
+	sq_pushstring(pVM, strOut.data(), (SQInteger)strOut.size());
+	return 1;
+}
+
+// unpack(string)
+SQInteger CSerializationNatives::unpack(SQVM * pVM)
+{
+	const char * szData;
+	sq_getstring(pVM, 2, &szData);
+	const unsigned char * pIn = (const unsigned char *)szData;
+	const unsigned char * pEnd = (pIn + sq_getsize(pVM, 2));
+	sq_reservestack(pVM, (SERIALIZATION_MAX_DEPTH * SERIALIZATION_STACK_PER_DEPTH));
+
+	if(!ReadPacked(pVM, pIn, pEnd, 0) || pIn != pEnd)
+		return sq_throwerror(pVM, "invalid packed data");
+
+	return 1;
+}
@@ -0,0 +1,55 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SerializationNatives.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Natives.h"
+#include <string>
+
+// Nesting depth of arrays and tables the serialization natives read and write
+#define SERIALIZATION_MAX_DEPTH 64
+
+// Tags of the values in the pack format
+enum eSerializationTag
+{
+	SERIALIZATION_TAG_NULL,
+	SERIALIZATION_TAG_FALSE,
+	SERIALIZATION_TAG_TRUE,
+	SERIALIZATION_TAG_INTEGER, // Zigzag varint
+	SERIALIZATION_TAG_FLOAT,   // 4 bytes, little endian
+	SERIALIZATION_TAG_DOUBLE,  // 8 bytes, little endian
+	SERIALIZATION_TAG_STRING,  // Varint length, bytes
+	SERIALIZATION_TAG_ARRAY,   // Varint count, values
+	SERIALIZATION_TAG_TABLE    // Varint count, key and value pairs
+};
+
+// JSON and a compact binary format for squirrel values. Both are written straight
+// from the stack into a buffer and read straight back onto the stack, so nothing
+// is built in between. Packed strings can be passed as a single event argument.
+class CSerializationNatives
+{
+private:
+	static bool      WriteJSON(SQVM * pVM, std::string& strOut, int iDepth);
+	static bool      ReadJSON(SQVM * pVM, const char *& szIn, const char * szEnd, int iDepth);
+	static void      WriteVarInt(std::string& strOut, unsigned long long ullValue);
+	static bool      ReadVarInt(const unsigned char *& pIn, const unsigned char * pEnd, unsigned long long& ullValue);
+	static bool      WritePacked(SQVM * pVM, std::string& strOut, int iDepth);
+	static bool      ReadPacked(SQVM * pVM, const unsigned char *& pIn, const unsigned char * pEnd, int iDepth);
+
+	static SQInteger toJSON(SQVM * pVM);
+	static SQInteger fromJSON(SQVM * pVM);
+	static SQInteger pack(SQVM * pVM);
+	static SQInteger unpack(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+
+	// Pushes the value of a JSON document or packed data, returns false if it isn't valid
+	static bool      Deserialize(SQVM * pVM, const char * szData, size_t sSize, bool bPacked);
+};
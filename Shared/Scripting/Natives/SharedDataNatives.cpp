@@ -0,0 +1,299 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SharedDataNatives.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "SharedDataNatives.h"
+#include "SerializationNatives.h"
+#include "../CSharedData.h"
+#include <SharedUtility.h>
+#include <stdio.h>
+
+// What a sharedData instance points at, the root keeps the whole tree alive
+struct SharedDataInstance
+{
+	CSharedValue * pRoot;
+	CSharedValue * pValue;
+};
+
+// Tags the sharedData class so the natives only take instances it made
+static int g_iSharedDataTypeTag = 0;
+
+// Shared data
+_BEGIN_CLASS(sharedData)
+_MEMBER_FUNCTION(sharedData, _get, 1, NULL)
+_MEMBER_FUNCTION(sharedData, _set, 2, NULL)
+_MEMBER_FUNCTION(sharedData, _newslot, 2, NULL)
+_MEMBER_FUNCTION(sharedData, _delslot, 1, NULL)
+_MEMBER_FUNCTION(sharedData, _nexti, 1, NULL)
+_END_CLASS(sharedData)
+
+void CSharedDataNatives::Register(CScriptingManager * pScriptingManager)
+{
+	pScriptingManager->RegisterClass(&_CLASS_DECL(sharedData));
+	pScriptingManager->RegisterFunction("setSharedData", setSharedData, 2, "st|a");
+	pScriptingManager->RegisterFunction("loadSharedData", loadSharedData, -1, NULL);
+	pScriptingManager->RegisterFunction("getSharedData", getSharedData, 1, "s");
+	pScriptingManager->RegisterFunction("removeSharedData", removeSharedData, 1, "s");
+	pScriptingManager->RegisterFunction("getSharedDataSize", getSharedDataSize, 1, "x");
+	pScriptingManager->RegisterFunction("copySharedData", copySharedData, 1, "x");
+}
+
+_MEMBER_FUNCTION_RELEASE_HOOK(sharedData)
+{
+	SharedDataInstance * pInstance = (SharedDataInstance *)pInst;
+	pInstance->pRoot->Release();
+	delete pInstance;
+	return 1;
+}
+
+// Pushes a scalar as itself and a table or array as a sharedData instance
+static bool PushSharedValue(SQVM * pVM, CSharedValue * pRoot, CSharedValue * pValue)
+{
+	if(!pValue->IsContainer())
+	{
+		pValue->Push(pVM);
+		return true;
+	}
+
+	int iTop = sq_gettop(pVM);
+	sq_pushroottable(pVM);
+	sq_pushstring(pVM, "sharedData", -1);
+
+	if(SQ_FAILED(sq_rawget(pVM, -2)) || sq_gettype(pVM, -1) != OT_CLASS)
+	{
+		sq_settop(pVM, iTop);
+		return false;
+	}
+
+	sq_settypetag(pVM, -1, &g_iSharedDataTypeTag);
+
+	if(SQ_FAILED(sq_createinstance(pVM, -1)))
+	{
+		sq_settop(pVM, iTop);
+		return false;
+	}
+
+	SharedDataInstance * pInstance = new SharedDataInstance;
+	pInstance->pRoot = pRoot;
+	pInstance->pValue = pValue;
+	pRoot->AddRef();
+	sq_setinstanceup(pVM, -1, pInstance);
+	sq_setreleasehook(pVM, -1, __sharedData_releasehook);
+
+	// Leave only the instance
+	sq_remove(pVM, -2);
+	sq_remove(pVM, -2);
+	return true;
+}
+
+static SharedDataInstance * GetSharedDataInstance(SQVM * pVM, int iIndex)
+{
+	SQUserPointer pInstance = NULL;
+
+	if(SQ_FAILED(sq_getinstanceup(pVM, iIndex, &pInstance, &g_iSharedDataTypeTag)))
+		return NULL;
+
+	return (SharedDataInstance *)pInstance;
+}
+
+static bool ReadFileContents(const String& strPath, std::string& strData)
+{
+	FILE * pFile = fopen(strPath.Get(), "rb");
+
+	if(!pFile)
+		return false;
+
+	fseek(pFile, 0, SEEK_END);
+	long lSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+	bool bRead = (lSize >= 0);
+
+	if(bRead && lSize > 0)
+	{
+		strData.resize(lSize);
+		bRead = (fread(&strData[0], 1, lSize, pFile) == (size_t)lSize);
+	}
+
+	fclose(pFile);
+	return bRead;
+}
+
+// setSharedData(name, value)
+// Freezes a copy of the table or array, every script can then read it with getSharedData
+SQInteger CSharedDataNatives::setSharedData(SQVM * pVM)
+{
+	const char * szName;
+	sq_getstring(pVM, 2, &szName);
+	String strError;
+	CSharedValue * pValue = CSharedValue::Create(pVM, 3, strError);
+
+	if(!pValue)
+		return sq_throwerror(pVM, strError.Get());
+
+	CSharedData::Set(szName, pValue);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// loadSharedData(name, filename, [packed = false])
+// Reads a JSON document (or data written by pack) straight into the shared data
+SQInteger CSharedDataNatives::loadSharedData(SQVM * pVM)
+{
+	CHECK_PARAMS_MIN_MAX("loadSharedData", 2, 3);
+	CHECK_TYPE("loadSharedData", 1, 2, OT_STRING);
+	CHECK_TYPE("loadSharedData", 2, 3, OT_STRING);
+
+	const char * szName;
+	const char * szFileName;
+	SQBool bPacked = false;
+	sq_getstring(pVM, 2, &szName);
+	sq_getstring(pVM, 3, &szFileName);
+
+	if(sq_gettop(pVM) >= 4)
+	{
+		CHECK_TYPE("loadSharedData", 3, 4, OT_BOOL);
+		sq_getbool(pVM, 4, &bPacked);
+	}
+
+	String strFileName(szFileName);
+	SharedUtility::RemoveIllegalCharacters(strFileName);
+	std::string strData;
+
+	if(!ReadFileContents(SharedUtility::GetAbsolutePath("files/%s", strFileName.Get()), strData))
+	{
+		CLogFile::Printf("loadSharedData: Failed to read %s.", strFileName.Get());
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	// The value only stays on this stack until it is frozen
+	if(!CSerializationNatives::Deserialize(pVM, strData.data(), strData.size(), (bPacked != 0)))
+	{
+		CLogFile::Printf("loadSharedData: %s is not valid %s.", strFileName.Get(), (bPacked ? "packed data" : "JSON"));
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	String strError;
+	CSharedValue * pValue = NULL;
+
+	if(sq_gettype(pVM, -1) == OT_TABLE || sq_gettype(pVM, -1) == OT_ARRAY)
+		pValue = CSharedValue::Create(pVM, -1, strError);
+	else
+		strError.Set("only tables and arrays can be shared");
+
+	sq_pop(pVM, 1);
+
+	if(!pValue)
+	{
+		CLogFile::Printf("loadSharedData: Failed to share %s (%s).", strFileName.Get(), strError.Get());
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	CSharedData::Set(szName, pValue);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+// getSharedData(name)
+// Returns a read only sharedData instance, or null if nothing has the name
+SQInteger CSharedDataNatives::getSharedData(SQVM * pVM)
+{
+	const char * szName;
+	sq_getstring(pVM, 2, &szName);
+	CSharedValue * pValue = CSharedData::Get(szName);
+
+	if(!pValue || !PushSharedValue(pVM, pValue, pValue))
+		sq_pushnull(pVM);
+
+	return 1;
+}
+
+// removeSharedData(name)
+// The scripts that still have the data can keep reading it
+SQInteger CSharedDataNatives::removeSharedData(SQVM * pVM)
+{
+	const char * szName;
+	sq_getstring(pVM, 2, &szName);
+	sq_pushbool(pVM, CSharedData::Remove(szName));
+	return 1;
+}
+
+// getSharedDataSize(data)
+SQInteger CSharedDataNatives::getSharedDataSize(SQVM * pVM)
+{
+	SharedDataInstance * pInstance = GetSharedDataInstance(pVM, 2);
+
+	if(!pInstance)
+		return sq_throwerror(pVM, "not a sharedData instance");
+
+	sq_pushinteger(pVM, pInstance->pValue->GetSize());
+	return 1;
+}
+
+// copySharedData(data)
+// Returns a regular table or array with the same values the script can change
+SQInteger CSharedDataNatives::copySharedData(SQVM * pVM)
+{
+	SharedDataInstance * pInstance = GetSharedDataInstance(pVM, 2);
+
+	if(!pInstance)
+		return sq_throwerror(pVM, "not a sharedData instance");
+
+	pInstance->pValue->PushCopy(pVM);
+	return 1;
+}
+
+// The instances are only indexed and walked, they can't be changed:
+//
+// local weapons = getSharedData("weapons");
+// local damage = weapons.pistol.damage;
+// foreach(name, weapon in weapons)
+//     log(name + " " + weapon.damage);
+
+_MEMBER_FUNCTION_IMPL(sharedData, _get)
+{
+	SharedDataInstance * pInstance = sq_getinstance<SharedDataInstance *>(pVM);
+	CSharedValue * pValue = (pInstance ? pInstance->pValue->Get(pVM, 2) : NULL);
+
+	// A clean failure lets the vm raise its usual error for a missing index
+	if(!pValue || !PushSharedValue(pVM, pInstance->pRoot, pValue))
+	{
+		sq_reseterror(pVM);
+		return SQ_ERROR;
+	}
+
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(sharedData, _set)
+{
+	return sq_throwerror(pVM, "shared data is read only");
+}
+
+_MEMBER_FUNCTION_IMPL(sharedData, _newslot)
+{
+	return sq_throwerror(pVM, "shared data is read only");
+}
+
+_MEMBER_FUNCTION_IMPL(sharedData, _delslot)
+{
+	return sq_throwerror(pVM, "shared data is read only");
+}
+
+_MEMBER_FUNCTION_IMPL(sharedData, _nexti)
+{
+	SharedDataInstance * pInstance = sq_getinstance<SharedDataInstance *>(pVM);
+
+	// Null ends the foreach
+	if(!pInstance || !pInstance->pValue->PushNextKey(pVM, 2))
+		sq_pushnull(pVM);
+
+	return 1;
+}
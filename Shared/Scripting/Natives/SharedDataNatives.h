@@ -0,0 +1,35 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: SharedDataNatives.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include "Natives.h"
+
+// Read only tables and arrays every script can read without a copy of its own.
+// The data lives outside of the vms, a script gets a sharedData instance that
+// looks the keys up in it when it is indexed or walked with foreach.
+class CSharedDataNatives
+{
+private:
+	static SQInteger setSharedData(SQVM * pVM);
+	static SQInteger loadSharedData(SQVM * pVM);
+	static SQInteger getSharedData(SQVM * pVM);
+	static SQInteger removeSharedData(SQVM * pVM);
+	static SQInteger getSharedDataSize(SQVM * pVM);
+	static SQInteger copySharedData(SQVM * pVM);
+
+public:
+	static void      Register(CScriptingManager * pScriptingManager);
+};
+
+_MEMBER_FUNCTION_IMPL(sharedData, _get);
+_MEMBER_FUNCTION_IMPL(sharedData, _set);
+_MEMBER_FUNCTION_IMPL(sharedData, _newslot);
+_MEMBER_FUNCTION_IMPL(sharedData, _delslot);
+_MEMBER_FUNCTION_IMPL(sharedData, _nexti);
@@ -21,6 +21,13 @@
 extern CScriptTimerManager * g_pScriptTimerManager;
 extern CScriptingManager * g_pScriptingManager;
 
+// Timer instances hold the handle of their timer instead of a pointer so
+// instances of deleted timers can be detected without searching all timers
+static ScriptTimerHandle sq_gettimerhandle(SQVM * pVM)
+{
+	return (ScriptTimerHandle)(size_t)sq_getinstance<SQUserPointer>(pVM);
+}
+
 // Timer functions
 _BEGIN_CLASS(timer)
 _MEMBER_FUNCTION(timer, constructor, -1, NULL)
@@ -36,11 +43,7 @@ void RegisterTimerNatives(CScriptingManager * pScriptingManager)
 
 _MEMBER_FUNCTION_RELEASE_HOOK(timer)
 {
-	CScriptTimer * pTimer = (CScriptTimer *)pInst;
-
-	if(pTimer != NULL && g_pScriptTimerManager->contains(pTimer))
-		pTimer->Kill();
-
+	g_pScriptTimerManager->Kill((ScriptTimerHandle)(size_t)pInst);
 	return 1;
 }
 
@@ -71,32 +74,41 @@ _MEMBER_FUNCTION_IMPL(timer, constructor)
 	CSquirrelArguments * pArguments = new CSquirrelArguments(pVM, 5);
 
 	CScriptTimer * pTimer = new CScriptTimer(g_pScriptingManager->Get(pVM), pFunction, interval, repeations, pArguments);
+	ScriptTimerHandle handle = g_pScriptTimerManager->Add(pTimer);
 
-	if(SQ_FAILED(sq_setinstance(pVM, pTimer)))
+	// The timer owns the arguments so deleting it deletes them as well
+	if(handle == INVALID_SCRIPT_TIMER_HANDLE)
 	{
 		delete pTimer;
-		delete pArguments;
 		sq_pushbool(pVM, false);
 		return 1;
 	}
 
-	g_pScriptTimerManager->push_back(pTimer);
+	if(SQ_FAILED(sq_setinstance(pVM, (SQUserPointer)(size_t)handle)))
+	{
+		g_pScriptTimerManager->Kill(handle);
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
 	sq_pushbool(pVM, true);
 	return 1;
 }
 
 _MEMBER_FUNCTION_IMPL(timer, isActive)
 {
-	CScriptTimer * pTimer = sq_getinstance<CScriptTimer *>(pVM);
+	ScriptTimerHandle handle = sq_gettimerhandle(pVM);
 
-	if(!pTimer)
+	if(handle == INVALID_SCRIPT_TIMER_HANDLE)
 	{
 		CLogFile::Print("Failed to get the timer instance.");
 		sq_pushbool(pVM, false);
 		return 1;
 	}
 
-	if(g_pScriptTimerManager->contains(pTimer))
+	CScriptTimer * pTimer = g_pScriptTimerManager->Get(handle);
+
+	if(pTimer)
 	{
 		if(pTimer->IsDead())
 		{
@@ -115,18 +127,17 @@ _MEMBER_FUNCTION_IMPL(timer, isActive)
 
 _MEMBER_FUNCTION_IMPL(timer, kill)
 {
-	CScriptTimer * pTimer = sq_getinstance<CScriptTimer *>(pVM);
+	ScriptTimerHandle handle = sq_gettimerhandle(pVM);
 
-	if(!pTimer)
+	if(handle == INVALID_SCRIPT_TIMER_HANDLE)
 	{
 		CLogFile::Print("Failed to get the timer instance.");
 		sq_pushbool(pVM, false);
 		return 1;
 	}
 
-	if(g_pScriptTimerManager->contains(pTimer) && !pTimer->IsDead())
+	if(g_pScriptTimerManager->Kill(handle))
 	{
-		pTimer->Kill();
 		sq_pushbool(pVM, true);
 		sq_setinstance(pVM, NULL);
 		return 1;
@@ -138,16 +149,18 @@ _MEMBER_FUNCTION_IMPL(timer, kill)
 
 _MEMBER_FUNCTION_IMPL(timer, setTraditionalBehavior)
 {
-	CScriptTimer * pTimer = sq_getinstance<CScriptTimer *>(pVM);
+	ScriptTimerHandle handle = sq_gettimerhandle(pVM);
 
-	if(!pTimer)
+	if(handle == INVALID_SCRIPT_TIMER_HANDLE)
 	{
 		CLogFile::Print("Failed to get the timer instance.");
 		sq_pushbool(pVM, false);
 		return 1;
 	}
 
-	if(pTimer != 0 && g_pScriptTimerManager->contains(pTimer) && !pTimer->IsDead())
+	CScriptTimer * pTimer = g_pScriptTimerManager->Get(handle);
+
+	if(pTimer && !pTimer->IsDead())
 	{
 		bool b;
 		sq_getbool(pVM, 2, (SQBool*)&b);
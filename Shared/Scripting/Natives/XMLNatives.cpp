@@ -9,6 +9,7 @@
 
 #include "Natives.h"
 #include "../../CXML.h"
+#include "../../CXMLReader.h"
 #include "../CScriptingManager.h"
 #include <SharedUtility.h>
 
@@ -36,9 +37,30 @@ _MEMBER_FUNCTION(xml, lastError, 0, NULL)
 _MEMBER_FUNCTION(xml, isComment, 0, NULL)
 _END_CLASS(xml)
 
+// XML reader
+_BEGIN_CLASS(xmlReader)
+_MEMBER_FUNCTION(xmlReader, constructor, 1, "s")
+_MEMBER_FUNCTION(xmlReader, read, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, skip, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, close, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, nodeType, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, nodeDepth, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, nodeName, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, nodeText, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, nodeAttribute, 1, "s")
+_MEMBER_FUNCTION(xmlReader, nodeAttributes, 0, NULL)
+_MEMBER_FUNCTION(xmlReader, lastError, 0, NULL)
+_END_CLASS(xmlReader)
+
 void RegisterXMLNatives(CScriptingManager * pScriptingManager)
 {
 	pScriptingManager->RegisterClass(&_CLASS_DECL(xml));
+	pScriptingManager->RegisterClass(&_CLASS_DECL(xmlReader));
+
+	pScriptingManager->RegisterConstant("XML_NODE_NONE", XML_NODE_NONE);
+	pScriptingManager->RegisterConstant("XML_NODE_ELEMENT", XML_NODE_ELEMENT);
+	pScriptingManager->RegisterConstant("XML_NODE_END_ELEMENT", XML_NODE_END_ELEMENT);
+	pScriptingManager->RegisterConstant("XML_NODE_TEXT", XML_NODE_TEXT);
 }
 
 _MEMBER_FUNCTION_RELEASE_HOOK(xml)
@@ -418,3 +440,217 @@ _MEMBER_FUNCTION_IMPL(xml, isComment)
 	sq_pushbool(pVM, pXML->isComment());
 	return 1;
 }
+
+// The xml reader goes through a file one node at a time without loading it:
+//
+// local reader = xmlReader("map.xml");
+// while(reader.read())
+// {
+//     if(reader.nodeType() == XML_NODE_ELEMENT && reader.nodeName() == "object")
+//         createObject(reader.nodeAttribute("model").tointeger(), ...);
+// }
+
+_MEMBER_FUNCTION_RELEASE_HOOK(xmlReader)
+{
+	CXMLReader * pReader = (CXMLReader *)pInst;
+	delete pReader;
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, constructor)
+{
+	const char * filename;
+	sq_getstring(pVM, -1, &filename);
+
+	CXMLReader * pReader = new CXMLReader();
+	String strFileName(filename);
+	SharedUtility::RemoveIllegalCharacters(strFileName);
+
+	// A reader that failed to open reads no nodes and has the error in lastError
+	pReader->Open(SharedUtility::GetAbsolutePath("files/%s", strFileName.Get()));
+
+	if(SQ_FAILED(sq_setinstance(pVM, pReader)))
+	{
+		CLogFile::Print("Failed to create the xml reader.");
+		SAFE_DELETE(pReader);
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	_SET_RELEASE_HOOK(xmlReader);
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, read)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, pReader->Read());
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, skip)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushbool(pVM, pReader->Skip());
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, close)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	pReader->Close();
+	sq_pushbool(pVM, true);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeType)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, pReader->GetNodeType());
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeDepth)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushinteger(pVM, pReader->GetDepth());
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeName)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushstring(pVM, pReader->GetName().Get(), pReader->GetName().GetLength());
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeText)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_pushstring(pVM, pReader->GetText().Get(), pReader->GetText().GetLength());
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeAttribute)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	const char * attributeName;
+	sq_getstring(pVM, -1, &attributeName);
+	const char * attribute = pReader->GetAttribute(attributeName);
+	if(attribute != NULL)
+		sq_pushstring(pVM, attribute, strlen(attribute));
+	else
+		sq_pushbool(pVM, false);
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeAttributes)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	sq_newtable(pVM);
+
+	for(unsigned int i = 0; i < pReader->GetAttributeCount(); i++)
+	{
+		sq_pushstring(pVM, pReader->GetAttributeName(i).Get(), pReader->GetAttributeName(i).GetLength());
+		sq_pushstring(pVM, pReader->GetAttributeValue(i).Get(), pReader->GetAttributeValue(i).GetLength());
+		sq_createslot(pVM, -3);
+	}
+
+	return 1;
+}
+
+_MEMBER_FUNCTION_IMPL(xmlReader, lastError)
+{
+	CXMLReader * pReader = sq_getinstance<CXMLReader *>(pVM);
+
+	if(!pReader)
+	{
+		CLogFile::Print("Failed to get the XML reader instance.");
+		sq_pushbool(pVM, false);
+		return 1;
+	}
+
+	int iRow = 0;
+	int iColumn = 0;
+	const char * error = pReader->GetLastError(&iRow, &iColumn);
+	if(error == 0) sq_pushbool(pVM, false);
+	else
+	{
+		String strError("%s (line %d, column %d)", error, iRow, iColumn);
+		sq_pushstring(pVM, strError.Get(), strError.GetLength());
+	}
+	return 1;
+}
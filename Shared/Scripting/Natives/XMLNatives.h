@@ -34,3 +34,15 @@ _MEMBER_FUNCTION_IMPL(xml, nodeNew);
 _MEMBER_FUNCTION_IMPL(xml, lastError);
 _MEMBER_FUNCTION_IMPL(xml, commentNew);
 _MEMBER_FUNCTION_IMPL(xml, isComment);
+
+_MEMBER_FUNCTION_IMPL(xmlReader, constructor);
+_MEMBER_FUNCTION_IMPL(xmlReader, read);
+_MEMBER_FUNCTION_IMPL(xmlReader, skip);
+_MEMBER_FUNCTION_IMPL(xmlReader, close);
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeType);
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeDepth);
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeName);
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeText);
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeAttribute);
+_MEMBER_FUNCTION_IMPL(xmlReader, nodeAttributes);
+_MEMBER_FUNCTION_IMPL(xmlReader, lastError);
@@ -30,6 +30,7 @@
 #include <errno.h>
 #include "SharedUtility.h"
 #include <stdio.h>
+#include "SHA256.h"
 
 #ifndef WIN32
 #define MAX_PATH PATH_MAX
@@ -418,16 +419,59 @@ namespace SharedUtility
 	}
 
 	unsigned long GetTime()
+	{
+		// The same clock as GetMicroseconds, timeGetTime is only as precise as the timer period
+		return (unsigned long)(GetMicroseconds() / 1000);
+	}
+
+	unsigned long long GetMicroseconds()
 	{
 #ifdef WIN32
-		return timeGetTime();
+		static LARGE_INTEGER frequency = {0};
+
+		if(frequency.QuadPart == 0)
+			QueryPerformanceFrequency(&frequency);
+
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (unsigned long long)((counter.QuadPart / frequency.QuadPart) * 1000000 + ((counter.QuadPart % frequency.QuadPart) * 1000000) / frequency.QuadPart);
 #else
-		timeval ts;
-		gettimeofday(&ts,0);
-		return (DWORD)(ts.tv_sec * 1000 + (ts.tv_usec / 1000));
+		// Unlike gettimeofday this doesn't jump when the system time is set
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ((unsigned long long)ts.tv_sec * 1000000 + (ts.tv_nsec / 1000));
 #endif
 	}
 
+	static unsigned long long g_ullFrameMicroseconds = 0;
+	static bool g_bFrameTimeSet = false;
+
+	void UpdateFrameTime()
+	{
+		g_ullFrameMicroseconds = GetMicroseconds();
+		g_bFrameTimeSet = true;
+	}
+
+	unsigned long GetFrameTime()
+	{
+		return (unsigned long)(GetFrameMicroseconds() / 1000);
+	}
+
+	unsigned long long GetFrameMicroseconds()
+	{
+		// Before the first tick there is no frame time yet
+		if(!g_bFrameTimeSet)
+			UpdateFrameTime();
+
+		return g_ullFrameMicroseconds;
+	}
+
+	void SetFrameMicroseconds(unsigned long long ullFrameMicroseconds)
+	{
+		g_ullFrameMicroseconds = ullFrameMicroseconds;
+		g_bFrameTimeSet = true;
+	}
+
 	bool Exists(const char * szPath)
 	{
 		struct stat St;
@@ -532,6 +576,13 @@ namespace SharedUtility
 		return uiValue;
 	}
 
+	String HashSHA256(const String& strData)
+	{
+		// The SHA-256 implementation is only included here as it defines its functions in the header
+		SHA256 sha256;
+		return String(sha256.hash((char *)strData.Get(), strData.GetLength()).c_str());
+	}
+
 	const char * inet_ntop(int af, const void * src, char * dst, int cnt)
 	{
 		if(af == AF_INET || af == PF_INET)
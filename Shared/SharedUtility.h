@@ -91,10 +91,23 @@ const char * GetTimeAndDateString2();
 // 'HR:MN:SC'
 const char * GetTimeString();
 
-// TODO: TimeInit and TimeShutdown from Networked: IV
-// 
+// Returns a monotonic time in milliseconds
 unsigned long GetTime();
 
+// Returns a monotonic high resolution time in microseconds
+unsigned long long GetMicroseconds();
+
+// Reads the clock for the current tick (frame), code that runs many times a tick
+// uses the frame time instead of reading the clock each time. Only the thread that
+// updates the frame time reads it.
+void UpdateFrameTime();
+unsigned long GetFrameTime();
+unsigned long long GetFrameMicroseconds();
+
+// Sets the frame time instead of reading the clock, the benchmarks use it to run
+// ticks without waiting for them. The next UpdateFrameTime reads the clock again.
+void SetFrameMicroseconds(unsigned long long ullFrameMicroseconds);
+
 // Check if a path exists
 bool Exists(const char * szPath);
 
@@ -108,6 +121,9 @@ int CreateDirectory(const char * szPath);
 // All of the IV hash functions merged into one
 unsigned int IVHash(std::string strString, unsigned int uiInitialHash = 0, bool bEnsureLowercase = true);
 
+// Returns the SHA-256 hash of the data in lowercase hex
+String HashSHA256(const String& strData);
+
 // Replacement for inet_ntop
 const char * inet_ntop(int af, const void * src, char * dst, int cnt);
 
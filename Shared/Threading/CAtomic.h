@@ -0,0 +1,103 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CAtomic.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+// Atomic operations on values shared between threads, each of them is also a full memory barrier
+class CAtomic
+{
+public:
+	// Returns the new value
+	static long Increment(volatile long * plValue)
+	{
+#ifdef WIN32
+		return InterlockedIncrement(plValue);
+#else
+		return __sync_add_and_fetch(plValue, 1);
+#endif
+	}
+
+	// Returns the new value
+	static long Decrement(volatile long * plValue)
+	{
+#ifdef WIN32
+		return InterlockedDecrement(plValue);
+#else
+		return __sync_sub_and_fetch(plValue, 1);
+#endif
+	}
+
+	// Returns the new value
+	static long Add(volatile long * plValue, long lAdd)
+	{
+#ifdef WIN32
+		return (InterlockedExchangeAdd(plValue, lAdd) + lAdd);
+#else
+		return __sync_add_and_fetch(plValue, lAdd);
+#endif
+	}
+
+	// Returns the old value
+	static long Exchange(volatile long * plValue, long lExchange)
+	{
+#ifdef WIN32
+		return InterlockedExchange(plValue, lExchange);
+#else
+		// __sync_lock_test_and_set is only an acquire barrier
+		__sync_synchronize();
+		return __sync_lock_test_and_set(plValue, lExchange);
+#endif
+	}
+
+	// Sets the value to lExchange if it is lComparand, returns the old value
+	static long CompareExchange(volatile long * plValue, long lExchange, long lComparand)
+	{
+#ifdef WIN32
+		return InterlockedCompareExchange(plValue, lExchange, lComparand);
+#else
+		return __sync_val_compare_and_swap(plValue, lComparand, lExchange);
+#endif
+	}
+
+	static long Get(volatile long * plValue)
+	{
+		Barrier();
+		long lValue = *plValue;
+		Barrier();
+		return lValue;
+	}
+
+	static void Set(volatile long * plValue, long lValue)
+	{
+		Exchange(plValue, lValue);
+	}
+
+	static void Barrier()
+	{
+#ifdef WIN32
+		MemoryBarrier();
+#else
+		__sync_synchronize();
+#endif
+	}
+
+	// Tells the cpu we are spinning on a value another thread changes
+	static void Pause()
+	{
+#ifdef WIN32
+		YieldProcessor();
+#elif defined(__i386__) || defined(__x86_64__)
+		__asm__ __volatile__("pause");
+#endif
+	}
+};
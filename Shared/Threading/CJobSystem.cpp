@@ -0,0 +1,288 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CJobSystem.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CJobSystem.h"
+#include "CAtomic.h"
+
+#ifdef _LINUX
+#include <unistd.h>
+#define Sleep(ms) usleep((ms) * 1000)
+#endif
+
+// A range of a parallel for
+struct ParallelForRange
+{
+	ParallelForFunction_t pfnFunction;
+	void                * pUserData;
+	unsigned int          uiBegin;
+	unsigned int          uiEnd;
+};
+
+static void ParallelForJob(void * pUserData)
+{
+	ParallelForRange * pRange = (ParallelForRange *)pUserData;
+	pRange->pfnFunction(pRange->uiBegin, pRange->uiEnd, pRange->pUserData);
+}
+
+bool CJobCounter::IsDone()
+{
+	return (CAtomic::Get(&m_lJobs) == 0);
+}
+
+CJobSystem::CJobSystem(int iThreads)
+{
+	unsigned int uiThreads = (unsigned int)iThreads;
+
+	if(iThreads < 0)
+		uiThreads = (GetProcessorCount() - 1);
+
+	if(uiThreads > JOB_SYSTEM_MAX_THREADS)
+		uiThreads = JOB_SYSTEM_MAX_THREADS;
+
+	m_uiWorkerCount = uiThreads;
+	m_pWorkers = NULL;
+	m_lNextWorker = 0;
+	m_lRunning = 1;
+
+	if(m_uiWorkerCount > 0)
+	{
+		m_pWorkers = new Worker[m_uiWorkerCount];
+
+		for(unsigned int i = 0; i < m_uiWorkerCount; i++)
+		{
+			m_pWorkers[i].pJobSystem = this;
+			m_pWorkers[i].uiIndex = i;
+			m_pWorkers[i].thread.SetUserData<Worker *>(&m_pWorkers[i]);
+			m_pWorkers[i].thread.Start(WorkerThread);
+		}
+	}
+}
+
+CJobSystem::~CJobSystem()
+{
+	if(m_pWorkers)
+	{
+		// Let the workers finish their jobs and exit
+		CAtomic::Set(&m_lRunning, 0);
+
+		for(unsigned int i = 0; i < m_uiWorkerCount; i++)
+			m_pWorkers[i].event.Signal();
+
+		for(unsigned int i = 0; i < m_uiWorkerCount; i++)
+		{
+			while(m_pWorkers[i].thread.IsRunning())
+				Sleep(1);
+
+			m_pWorkers[i].thread.Stop();
+		}
+
+		delete [] m_pWorkers;
+		m_pWorkers = NULL;
+	}
+}
+
+unsigned int CJobSystem::GetProcessorCount()
+{
+#ifdef WIN32
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return (unsigned int)systemInfo.dwNumberOfProcessors;
+#else
+	long lProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+	return ((lProcessors > 0) ? (unsigned int)lProcessors : 1);
+#endif
+}
+
+void CJobSystem::Queue(const Job& job)
+{
+	// Without workers the jobs run right away
+	if(m_uiWorkerCount == 0)
+	{
+		RunJob(job);
+		return;
+	}
+
+	// Spread the jobs over the workers, the idle workers steal the jobs of the busy ones
+	Worker * pWorker = &m_pWorkers[(unsigned long)CAtomic::Increment(&m_lNextWorker) % m_uiWorkerCount];
+	pWorker->mutex.Lock();
+	pWorker->jobs.push_back(job);
+	pWorker->mutex.Unlock();
+	pWorker->event.Signal();
+}
+
+bool CJobSystem::GetJob(unsigned int uiWorker, Job& job)
+{
+	if(m_uiWorkerCount == 0)
+		return false;
+
+	// Take the newest job of our own queue (its data is most likely still in
+	// the cache) or else the oldest job of another queue
+	for(unsigned int i = 0; i < m_uiWorkerCount; i++)
+	{
+		Worker * pWorker = &m_pWorkers[(uiWorker + i) % m_uiWorkerCount];
+		pWorker->mutex.Lock();
+
+		if(!pWorker->jobs.empty())
+		{
+			if(i == 0)
+			{
+				job = pWorker->jobs.back();
+				pWorker->jobs.pop_back();
+			}
+			else
+			{
+				job = pWorker->jobs.front();
+				pWorker->jobs.pop_front();
+			}
+
+			pWorker->mutex.Unlock();
+			return true;
+		}
+
+		pWorker->mutex.Unlock();
+	}
+
+	return false;
+}
+
+void CJobSystem::RunJob(const Job& job)
+{
+	job.pfnFunction(job.pUserData);
+
+	CJobCounter * pCounter = job.pCounter;
+
+	if(!pCounter)
+		return;
+
+	// The counter only changes with its mutex locked so a wait for it can make
+	// sure we are done with the counter before it is destroyed
+	std::vector<Job> waitingJobs;
+	pCounter->m_mutex.Lock();
+
+	if(CAtomic::Decrement(&pCounter->m_lJobs) == 0)
+		waitingJobs.swap(pCounter->m_waitingJobs);
+
+	pCounter->m_mutex.Unlock();
+
+	// Start the jobs that waited for the counter
+
+	for(size_t i = 0; i < waitingJobs.size(); i++)
+		Queue(waitingJobs[i]);
+}
+
+void CJobSystem::WorkerThread(CThread * pCreator)
+{
+	Worker * pWorker = pCreator->GetUserData<Worker *>();
+	CJobSystem * pJobSystem = pWorker->pJobSystem;
+	Job job;
+
+	while(true)
+	{
+		if(pJobSystem->GetJob(pWorker->uiIndex, job))
+		{
+			pJobSystem->RunJob(job);
+			continue;
+		}
+
+		if(CAtomic::Get(&pJobSystem->m_lRunning) == 0)
+			break;
+
+		pWorker->event.Wait(JOB_SYSTEM_IDLE_WAIT);
+	}
+}
+
+void CJobSystem::Add(JobFunction_t pfnFunction, void * pUserData, CJobCounter * pCounter, CJobCounter * pDependency)
+{
+	Job job;
+	job.pfnFunction = pfnFunction;
+	job.pUserData = pUserData;
+	job.pCounter = pCounter;
+
+	if(pCounter)
+		CAtomic::Increment(&pCounter->m_lJobs);
+
+	if(pDependency)
+	{
+		// The counter is only done once the last job of it took the waiting
+		// jobs so checking it with the mutex locked is enough
+		pDependency->m_mutex.Lock();
+
+		if(!pDependency->IsDone())
+		{
+			pDependency->m_waitingJobs.push_back(job);
+			pDependency->m_mutex.Unlock();
+			return;
+		}
+
+		pDependency->m_mutex.Unlock();
+	}
+
+	Queue(job);
+}
+
+void CJobSystem::Wait(CJobCounter * pCounter)
+{
+	Job job;
+
+	for(unsigned int i = 0; !pCounter->IsDone(); i++)
+	{
+		// Help with the jobs instead of just waiting
+		if(GetJob(i, job))
+		{
+			RunJob(job);
+			continue;
+		}
+
+		// The last jobs are running on the workers
+		if(i < MUTEX_SPIN_COUNT)
+			CAtomic::Pause();
+		else
+			Sleep(0);
+	}
+
+	// Wait for the thread that finished the last job to let go of the counter
+	pCounter->m_mutex.Lock();
+	pCounter->m_mutex.Unlock();
+}
+
+void CJobSystem::ParallelFor(unsigned int uiBegin, unsigned int uiEnd, unsigned int uiGrainSize, ParallelForFunction_t pfnFunction, void * pUserData)
+{
+	if(uiEnd <= uiBegin)
+		return;
+
+	if(uiGrainSize == 0)
+		uiGrainSize = 1;
+
+	// Is it not worth splitting?
+	if(m_uiWorkerCount == 0 || (uiEnd - uiBegin) <= uiGrainSize)
+	{
+		pfnFunction(uiBegin, uiEnd, pUserData);
+		return;
+	}
+
+	std::vector<ParallelForRange> ranges;
+	ranges.reserve(((uiEnd - uiBegin) + (uiGrainSize - 1)) / uiGrainSize);
+
+	for(unsigned int i = uiBegin; i < uiEnd; i += uiGrainSize)
+	{
+		ParallelForRange range;
+		range.pfnFunction = pfnFunction;
+		range.pUserData = pUserData;
+		range.uiBegin = i;
+		range.uiEnd = (((uiEnd - i) > uiGrainSize) ? (i + uiGrainSize) : uiEnd);
+		ranges.push_back(range);
+	}
+
+	CJobCounter counter;
+
+	for(size_t i = 0; i < ranges.size(); i++)
+		Add(ParallelForJob, &ranges[i], &counter);
+
+	Wait(&counter);
+}
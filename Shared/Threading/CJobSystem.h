@@ -0,0 +1,97 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CJobSystem.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "CMutex.h"
+#include "CThread.h"
+#include "CThreadEvent.h"
+
+// Maximum time in ms an idle worker sleeps before it looks for jobs to steal again
+#define JOB_SYSTEM_IDLE_WAIT 100
+
+// Maximum amount of worker threads
+#define JOB_SYSTEM_MAX_THREADS 64
+
+typedef void (* JobFunction_t)(void * pUserData);
+typedef void (* ParallelForFunction_t)(unsigned int uiBegin, unsigned int uiEnd, void * pUserData);
+
+class CJobCounter;
+
+struct Job
+{
+	JobFunction_t pfnFunction;
+	void        * pUserData;
+	CJobCounter * pCounter; // Counts the job until it is finished, can be NULL
+};
+
+// Handle of a group of jobs, it is done once all jobs added with it finished.
+// Jobs can be added to run only once another counter is done.
+class CJobCounter
+{
+	friend class CJobSystem;
+
+private:
+	volatile long    m_lJobs;
+	CMutex           m_mutex; // Mutex for m_waitingJobs
+	std::vector<Job> m_waitingJobs; // Jobs that wait for this counter to be done
+
+public:
+	CJobCounter() { m_lJobs = 0; }
+
+	bool IsDone();
+};
+
+// Runs jobs on a worker thread per core, every worker has its own queue and
+// takes jobs from the queues of the other workers once its own is empty
+class CJobSystem
+{
+private:
+	struct Worker
+	{
+		CJobSystem     * pJobSystem;
+		unsigned int     uiIndex;
+		CMutex           mutex; // Mutex for jobs
+		std::deque<Job>  jobs;
+		CThreadEvent     event; // Signaled when a job is added to this worker
+		CThread          thread;
+	};
+
+	Worker      * m_pWorkers;
+	unsigned int  m_uiWorkerCount;
+	volatile long m_lNextWorker;
+	volatile long m_lRunning;
+
+	void          Queue(const Job& job);
+	bool          GetJob(unsigned int uiWorker, Job& job);
+	void          RunJob(const Job& job);
+	static void   WorkerThread(CThread * pCreator);
+
+public:
+	// -1 starts a worker for every core but the one of the calling thread, 0
+	// runs every job on the thread that adds or waits for it
+	CJobSystem(int iThreads = -1);
+	~CJobSystem();
+
+	static unsigned int GetProcessorCount();
+	unsigned int  GetThreadCount() { return m_uiWorkerCount; }
+
+	// Runs the job once pDependency is done (if there is one), pCounter counts
+	// the job until it is finished (if there is one)
+	void          Add(JobFunction_t pfnFunction, void * pUserData, CJobCounter * pCounter = NULL, CJobCounter * pDependency = NULL);
+
+	// Runs jobs until the counter is done
+	void          Wait(CJobCounter * pCounter);
+
+	// Calls the function for ranges of at most uiGrainSize of [uiBegin, uiEnd)
+	// on all the threads and returns once all of them are done
+	void          ParallelFor(unsigned int uiBegin, unsigned int uiEnd, unsigned int uiGrainSize, ParallelForFunction_t pfnFunction, void * pUserData);
+};
@@ -8,19 +8,32 @@
 //==============================================================================
 
 #include "CMutex.h"
+#include "CAtomic.h"
 #include <SharedUtility.h>
 
+#ifdef _LINUX
+#include <time.h>
+#include <errno.h>
+#endif
+
 CMutex::CMutex()
 {
 	// Create the mutex
 #ifdef WIN32
 #ifdef USE_CRITICAL_SECTION
-	InitializeCriticalSection(&m_criticalSection);
+	InitializeCriticalSectionAndSpinCount(&m_criticalSection, MUTEX_SPIN_COUNT);
 #else
 	m_hMutex = CreateMutex(NULL, FALSE, NULL);
 #endif
 #else
-	pthread_mutex_init(&m_mutex, NULL);
+	pthread_mutexattr_t attributes;
+	pthread_mutexattr_init(&attributes);
+#ifdef PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP
+	// Spin a while before sleeping on the futex
+	pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_ADAPTIVE_NP);
+#endif
+	pthread_mutex_init(&m_mutex, &attributes);
+	pthread_mutexattr_destroy(&attributes);
 #endif
 
 	// Set the lock count to its default value
@@ -58,39 +71,62 @@ void CMutex::Lock()
 	m_iLockCount++;
 }
 
-bool CMutex::TryLock(unsigned int uiTimeOutMilliseconds)
+bool CMutex::TryLockOnce()
 {
-	// Attempt to lock the mutex
-	bool bLocked = false;
-#if defined(WIN32) && !defined(USE_CRITICAL_SECTION)
-	bLocked = (WaitForSingleObject(m_hMutex, uiTimeOutMilliseconds) == 0);
-#else
-	if(uiTimeOutMilliseconds == 0)
-	{
 #ifdef WIN32
-		bLocked = (TryEnterCriticalSection(&m_criticalSection) != 0);
+#ifdef USE_CRITICAL_SECTION
+	return (TryEnterCriticalSection(&m_criticalSection) != 0);
 #else
-		bLocked = pthread_mutex_trylock(&m_mutex);
+	return (WaitForSingleObject(m_hMutex, 0) == WAIT_OBJECT_0);
 #endif
-	}
-	else
+#else
+	return (pthread_mutex_trylock(&m_mutex) == 0);
+#endif
+}
+
+bool CMutex::TryLock(unsigned int uiTimeOutMilliseconds)
+{
+	// Attempt to lock the mutex
+	bool bLocked = TryLockOnce();
+
+	if(!bLocked && uiTimeOutMilliseconds > 0)
 	{
-		unsigned long ulEndTime = (SharedUtility::GetTime() + uiTimeOutMilliseconds);
+#if defined(WIN32) && !defined(USE_CRITICAL_SECTION)
+		bLocked = (WaitForSingleObject(m_hMutex, uiTimeOutMilliseconds) == WAIT_OBJECT_0);
+#elif defined(WIN32)
+		// Critical sections can't be waited for with a time out, spin for a
+		// moment and then sleep between the attempts instead of burning the cpu
+		unsigned long ulStartTime = SharedUtility::GetTime();
 
-		while(SharedUtility::GetTime() < ulEndTime)
+		for(unsigned int i = 0; !bLocked && (SharedUtility::GetTime() - ulStartTime) < uiTimeOutMilliseconds; i++)
 		{
-#ifdef WIN32
-			if(TryEnterCriticalSection(&m_criticalSection))
+			if(i < MUTEX_SPIN_COUNT)
+				CAtomic::Pause();
+			else
+				Sleep(1);
+
+			bLocked = TryLockOnce();
+		}
 #else
-			if(pthread_mutex_trylock(&m_mutex))
-#endif
-			{
-				bLocked = true;
-				break;
-			}
+		// Sleep on the mutex until it is unlocked or the time out is reached
+		timespec endTime;
+		clock_gettime(CLOCK_REALTIME, &endTime);
+		endTime.tv_sec += (uiTimeOutMilliseconds / 1000);
+		endTime.tv_nsec += ((uiTimeOutMilliseconds % 1000) * 1000000);
+
+		if(endTime.tv_nsec >= 1000000000)
+		{
+			endTime.tv_sec++;
+			endTime.tv_nsec -= 1000000000;
 		}
-	}
+
+		int iResult;
+
+		while((iResult = pthread_mutex_timedlock(&m_mutex, &endTime)) == EINTR);
+
+		bLocked = (iResult == 0);
 #endif
+	}
 
 	// Did the mutex lock successfully?
 	if(bLocked)
@@ -11,11 +11,17 @@
 
 #ifdef WIN32
 #include <windows.h>
+#else
+#include <pthread.h>
 #endif
 #include <CString.h>
 
 #define USE_CRITICAL_SECTION
 
+// Amount of times a lock spins before the thread goes to sleep, most locks are
+// only held for a moment so spinning saves the trip to the kernel
+#define MUTEX_SPIN_COUNT 4000
+
 class CMutex
 {
 private:
@@ -31,11 +37,15 @@ private:
 #endif
 	int m_iLockCount;
 
+	bool TryLockOnce();
+
 public:
 	CMutex();
 	~CMutex();
 
 	void Lock();
+
+	// Waits up to uiTimeOutMilliseconds for the mutex, returns true if it was locked
 	bool TryLock(unsigned int uiTimeOutMilliseconds);
 	void Unlock();
 };
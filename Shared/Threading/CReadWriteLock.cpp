@@ -0,0 +1,86 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CReadWriteLock.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CReadWriteLock.h"
+#include "CAtomic.h"
+#include "CMutex.h"
+
+CReadWriteLock::CReadWriteLock()
+{
+#ifdef WIN32
+	InitializeCriticalSectionAndSpinCount(&m_writerCriticalSection, MUTEX_SPIN_COUNT);
+	m_lReaders = 0;
+#else
+	pthread_rwlockattr_t attributes;
+	pthread_rwlockattr_init(&attributes);
+#ifdef __GLIBC__
+	// Waiting writers go before new readers
+	pthread_rwlockattr_setkind_np(&attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+	pthread_rwlock_init(&m_lock, &attributes);
+	pthread_rwlockattr_destroy(&attributes);
+#endif
+}
+
+CReadWriteLock::~CReadWriteLock()
+{
+#ifdef WIN32
+	DeleteCriticalSection(&m_writerCriticalSection);
+#else
+	pthread_rwlock_destroy(&m_lock);
+#endif
+}
+
+void CReadWriteLock::LockRead()
+{
+#ifdef WIN32
+	// Only wait for a writer that holds or waits for the lock
+	EnterCriticalSection(&m_writerCriticalSection);
+	CAtomic::Increment(&m_lReaders);
+	LeaveCriticalSection(&m_writerCriticalSection);
+#else
+	pthread_rwlock_rdlock(&m_lock);
+#endif
+}
+
+void CReadWriteLock::UnlockRead()
+{
+#ifdef WIN32
+	CAtomic::Decrement(&m_lReaders);
+#else
+	pthread_rwlock_unlock(&m_lock);
+#endif
+}
+
+void CReadWriteLock::LockWrite()
+{
+#ifdef WIN32
+	EnterCriticalSection(&m_writerCriticalSection);
+
+	// Wait for the readers that are inside to leave
+	for(unsigned int i = 0; CAtomic::Get(&m_lReaders) > 0; i++)
+	{
+		if(i < MUTEX_SPIN_COUNT)
+			CAtomic::Pause();
+		else
+			Sleep(0);
+	}
+#else
+	pthread_rwlock_wrlock(&m_lock);
+#endif
+}
+
+void CReadWriteLock::UnlockWrite()
+{
+#ifdef WIN32
+	LeaveCriticalSection(&m_writerCriticalSection);
+#else
+	pthread_rwlock_unlock(&m_lock);
+#endif
+}
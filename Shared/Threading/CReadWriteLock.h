@@ -0,0 +1,40 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CReadWriteLock.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Any amount of readers or a single writer can hold the lock at once, a
+// waiting writer keeps new readers out so it isn't starved
+class CReadWriteLock
+{
+private:
+#ifdef WIN32
+	// Slim reader/writer locks aren't there before vista so the writers take a
+	// critical section and wait for the readers that are inside to leave
+	CRITICAL_SECTION m_writerCriticalSection;
+	volatile long    m_lReaders;
+#else
+	pthread_rwlock_t m_lock;
+#endif
+
+public:
+	CReadWriteLock();
+	~CReadWriteLock();
+
+	void LockRead();
+	void UnlockRead();
+	void LockWrite();
+	void UnlockWrite();
+};
@@ -0,0 +1,99 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CThreadEvent.cpp
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#include "CThreadEvent.h"
+#include "CAtomic.h"
+
+#ifdef _LINUX
+#include <time.h>
+#endif
+
+CThreadEvent::CThreadEvent()
+{
+	m_lSignaled = 0;
+	m_lWaiters = 0;
+#ifdef WIN32
+	// Auto reset so a signal wakes a single wait
+	m_hEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_condition, NULL);
+#endif
+}
+
+CThreadEvent::~CThreadEvent()
+{
+#ifdef WIN32
+	CloseHandle(m_hEvent);
+#else
+	pthread_cond_destroy(&m_condition);
+	pthread_mutex_destroy(&m_mutex);
+#endif
+}
+
+void CThreadEvent::Signal()
+{
+	// Is the event signaled already (the wait will see that signal)?
+	if(CAtomic::Exchange(&m_lSignaled, 1) != 0)
+		return;
+
+	// The waiter counts itself before it checks for a signal so either it sees
+	// our signal or we see it waiting
+	if(CAtomic::Get(&m_lWaiters) == 0)
+		return;
+
+#ifdef WIN32
+	SetEvent(m_hEvent);
+#else
+	pthread_mutex_lock(&m_mutex);
+	pthread_cond_signal(&m_condition);
+	pthread_mutex_unlock(&m_mutex);
+#endif
+}
+
+bool CThreadEvent::Wait(unsigned int uiTimeOutMilliseconds)
+{
+	CAtomic::Increment(&m_lWaiters);
+
+	if(CAtomic::Exchange(&m_lSignaled, 0) != 0)
+	{
+		CAtomic::Decrement(&m_lWaiters);
+		return true;
+	}
+
+#ifdef WIN32
+	// The event can still be set by a signal we took without waiting, the wake
+	// up is early then
+	WaitForSingleObject(m_hEvent, uiTimeOutMilliseconds);
+#else
+	timespec endTime;
+	clock_gettime(CLOCK_REALTIME, &endTime);
+	endTime.tv_sec += (uiTimeOutMilliseconds / 1000);
+	endTime.tv_nsec += ((uiTimeOutMilliseconds % 1000) * 1000000);
+
+	if(endTime.tv_nsec >= 1000000000)
+	{
+		endTime.tv_sec++;
+		endTime.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&m_mutex);
+
+	while(CAtomic::Get(&m_lSignaled) == 0)
+	{
+		if(pthread_cond_timedwait(&m_condition, &m_mutex, &endTime) != 0)
+			break;
+	}
+
+	pthread_mutex_unlock(&m_mutex);
+#endif
+
+	CAtomic::Decrement(&m_lWaiters);
+	return (CAtomic::Exchange(&m_lSignaled, 0) != 0);
+}
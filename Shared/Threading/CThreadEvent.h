@@ -0,0 +1,42 @@
+//============== IV: Multiplayer - http://code.iv-multiplayer.com ==============
+//
+// File: CThreadEvent.h
+// Project: Shared
+// Author(s): jenksta
+// License: See LICENSE in root directory
+//
+//==============================================================================
+
+#pragma once
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+// Wakes a thread that waits for work, signals sent while no thread waits wake
+// the next wait. Signaling is only a system call if a thread is asleep so it
+// can be done for every bit of work that is handed over.
+class CThreadEvent
+{
+private:
+	volatile long   m_lSignaled;
+	volatile long   m_lWaiters;
+#ifdef WIN32
+	HANDLE          m_hEvent;
+#else
+	pthread_mutex_t m_mutex;
+	pthread_cond_t  m_condition;
+#endif
+
+public:
+	CThreadEvent();
+	~CThreadEvent();
+
+	void Signal();
+
+	// Waits up to uiTimeOutMilliseconds for a signal, returns true if there was
+	// one (the caller still has to check for its work, the wake up can be early)
+	bool Wait(unsigned int uiTimeOutMilliseconds);
+};
@@ -108,6 +108,11 @@ void sq_setnativedebughook(HSQUIRRELVM v,SQDEBUGHOOK hook)
 	v->_debughook = hook?true:false;
 }
 
+void sq_interrupt(HSQUIRRELVM v)
+{
+	v->_interrupted = true;
+}
+
 void sq_setdebughook(HSQUIRRELVM v)
 {
 	SQObject o = stack_get(v,-1);
@@ -1439,6 +1444,11 @@ SQPRINTFUNCTION sq_geterrorfunc(HSQUIRRELVM v)
 	return _ss(v)->_errorfunc;
 }
 
+void sq_setrootmissfunc(HSQUIRRELVM v, SQROOTMISSFUNCTION rootmissfunc)
+{
+	_ss(v)->_rootmissfunc = rootmissfunc;
+}
+
 void *sq_malloc(SQUnsignedInteger size)
 {
 	return SQ_MALLOC(size);
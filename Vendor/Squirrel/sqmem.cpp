@@ -2,8 +2,24 @@
 	see copyright notice in squirrel.h
 */
 #include "sqpcheader.h"
+// The pooled and counted allocator of the server and the client, modules
+// built against the sdk keep the plain allocator
+#if defined(_SERVER) || defined(CLIENT_EXPORTS)
+#include <Scripting/CScriptAllocator.h>
+
+void *sq_vm_malloc(SQUnsignedInteger size){	return CScriptAllocator::Allocate(size); }
+
+void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ return CScriptAllocator::Reallocate(p, size); }
+
+void sq_vm_free(void *p, SQUnsignedInteger size){	CScriptAllocator::Free(p); }
+
+bool sq_vm_overlimit(){ return CScriptAllocator::IsOverLimit(); }
+#else
 void *sq_vm_malloc(SQUnsignedInteger size){	return malloc(size); }
 
 void *sq_vm_realloc(void *p, SQUnsignedInteger oldsize, SQUnsignedInteger size){ return realloc(p, size); }
 
 void sq_vm_free(void *p, SQUnsignedInteger size){	free(p); }
+
+bool sq_vm_overlimit(){ return false; }
+#endif
@@ -107,6 +107,7 @@ public:
 	SQCOMPILERERROR _compilererrorhandler;
 	SQPRINTFUNCTION _printfunc;
 	SQPRINTFUNCTION _errorfunc;
+	SQROOTMISSFUNCTION _rootmissfunc;
 	bool _debuginfo;
 	bool _notifyallexceptions;
 private:
@@ -145,4 +146,6 @@ bool CompileTypemask(SQIntVec &res,const SQChar *typemask);
 void *sq_vm_malloc(SQUnsignedInteger size);
 void *sq_vm_realloc(void *p,SQUnsignedInteger oldsize,SQUnsignedInteger size);
 void sq_vm_free(void *p,SQUnsignedInteger size);
+//true while the script running on this thread is over its memory limit
+bool sq_vm_overlimit();
 #endif //_SQSTATE_H_
@@ -118,6 +118,7 @@ SQVM::SQVM(SQSharedState *ss)
 	_debughook = false;
 	_debughook_native = NULL;
 	_debughook_closure.Null();
+	_interrupted = false;
 	_openouters = NULL;
 	ci = NULL;
 	INIT_CHAIN();ADD_TO_CHAIN(&_ss(this)->_gc_chain,this);
@@ -560,6 +561,12 @@ bool SQVM::FOREACH_OP(SQObjectPtr &o1,SQObjectPtr &o2,SQObjectPtr
 
 #define SQ_THROW() { goto exception_trap; }
 
+//the debug hook asked for the execution to be stopped (see sq_interrupt)
+#define _CHECK_INTERRUPT() { if(_interrupted) { _interrupted = false; Raise_Error(_SC("script execution interrupted")); SQ_THROW(); } }
+
+//allocations can't fail so scripts over their memory limit are stopped where they allocate (see sq_vm_overlimit)
+#define _CHECK_MEMORY_LIMIT() { if(sq_vm_overlimit()) { Raise_Error(_SC("script memory limit exceeded")); SQ_THROW(); } }
+
 bool SQVM::CLOSURE_OP(SQObjectPtr &target, SQFunctionProto *func)
 {
 	SQInteger nouters;
@@ -687,7 +694,12 @@ exception_restore:
 			//scprintf("\n[%d] %s %d %d %d %d\n",ci->_ip-ci->_iv->_vals,g_InstrDesc[_i_.op].name,arg0,arg1,arg2,arg3);
 			switch(_i_.op)
 			{
-			case _OP_LINE: if (_debughook) CallDebugHook(_SC('l'),arg1); continue;
+			case _OP_LINE:
+				if (_debughook) {
+					CallDebugHook(_SC('l'),arg1);
+					_CHECK_INTERRUPT();
+				}
+				continue;
 			case _OP_LOAD: TARGET = ci->_literals[arg1]; continue;
 			case _OP_LOADINT: 
 #ifndef _SQ64
@@ -836,7 +848,17 @@ exception_restore:
 			case _OP_LOADROOT:	TARGET = _roottable; continue;
 			case _OP_LOADBOOL: TARGET = arg1?true:false; continue;
 			case _OP_DMOVE: STK(arg0) = STK(arg1); STK(arg2) = STK(arg3); continue;
-			case _OP_JMP: ci->_ip += (sarg1); continue;
+			case _OP_JMP:
+				ci->_ip += (sarg1);
+				//loops jump back, let the debug hook see them so it can interrupt endless loops
+				if (sarg1 < 0) {
+					if (_debughook) {
+						CallDebugHook(_SC('l'));
+						_CHECK_INTERRUPT();
+					}
+					_CHECK_MEMORY_LIMIT();
+				}
+				continue;
 			//case _OP_JNZ: if(!IsFalse(STK(arg0))) ci->_ip+=(sarg1); continue;
 			case _OP_JCMP: 
 				_GUARD(CMP_OP((CmpOP)arg3,STK(arg2),STK(arg0),temp_reg));
@@ -859,6 +881,7 @@ exception_restore:
 				}
 			continue;
 			case _OP_NEWOBJ: 
+				_CHECK_MEMORY_LIMIT();
 				switch(arg3) {
 					case NOT_TABLE: TARGET = SQTable::Create(_ss(this), arg1); continue;
 					case NOT_ARRAY: TARGET = SQArray::Create(_ss(this), 0); _array(TARGET)->Reserve(arg1); continue;
@@ -952,6 +975,7 @@ exception_restore:
 				Raise_Error(_SC("attempt to perform a bitwise op on a %s"), GetTypeName(STK(arg1)));
 				SQ_THROW();
 			case _OP_CLOSURE: {
+				_CHECK_MEMORY_LIMIT();
 				SQClosure *c = ci->_closure._unVal.pClosure;
 				SQFunctionProto *fp = c->_function;
 				if(!CLOSURE_OP(TARGET,fp->_functions[arg1]._unVal.pFunctionProto)) { SQ_THROW(); }
@@ -1181,6 +1205,7 @@ bool SQVM::Get(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest,
 	switch(type(self)){
 	case OT_TABLE:
 		if(_table(self)->Get(key,dest))return true;
+		if(_table(self) == _table(_roottable) && RootMiss(key) && _table(self)->Get(key,dest)) return true;
 		break;
 	case OT_ARRAY:
 		if(sq_isnumeric(key)) { if(_array(self)->Get(tointeger(key),dest)) { return true; } Raise_IdxError(key); return false; }
@@ -1218,12 +1243,21 @@ bool SQVM::Get(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest,
 //#ifdef ROOT_FALLBACK
 	if(selfidx == 0) {
 		if(_table(_roottable)->Get(key,dest)) return true;
+		if(RootMiss(key) && _table(_roottable)->Get(key,dest)) return true;
 	}
 //#endif
 	Raise_IdxError(key);
 	return false;
 }
 
+//gives the host a chance to create a missing slot of the root table (see sq_setrootmissfunc),
+//the function must not touch the stack as the key and the destination can be on it
+bool SQVM::RootMiss(const SQObjectPtr &key)
+{
+	if(!_ss(this)->_rootmissfunc || type(key) != OT_STRING) return false;
+	return _ss(this)->_rootmissfunc(this,_stringval(key)) ? true : false;
+}
+
 bool SQVM::InvokeDefaultDelegate(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest)
 {
 	SQTable *ddel = NULL;
@@ -1288,6 +1322,7 @@ bool SQVM::Set(const SQObjectPtr &self,const SQObjectPtr &key,const SQObjectPtr
 	switch(type(self)){
 	case OT_TABLE:
 		if(_table(self)->Set(key,val)) return true;
+		if(_table(self) == _table(_roottable) && RootMiss(key) && _table(self)->Set(key,val)) return true;
 		break;
 	case OT_INSTANCE:
 		if(_instance(self)->Set(key,val)) return true;
@@ -1312,6 +1347,8 @@ bool SQVM::Set(const SQObjectPtr &self,const SQObjectPtr &key,const SQObjectPtr
 	if(selfidx == 0) {
 		if(_table(_roottable)->Set(key,val))
 			return true;
+		if(RootMiss(key) && _table(_roottable)->Set(key,val))
+			return true;
 	}
 	Raise_IdxError(key);
 	return false;
@@ -67,6 +67,7 @@ public:
 	void CallErrorHandler(SQObjectPtr &e);
 	bool Get(const SQObjectPtr &self, const SQObjectPtr &key, SQObjectPtr &dest, bool raw, SQInteger selfidx);
 	SQInteger FallBackGet(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest);
+	bool RootMiss(const SQObjectPtr &key);
 	bool InvokeDefaultDelegate(const SQObjectPtr &self,const SQObjectPtr &key,SQObjectPtr &dest);
 	bool Set(const SQObjectPtr &self, const SQObjectPtr &key, const SQObjectPtr &val, SQInteger selfidx);
 	SQInteger FallBackSet(const SQObjectPtr &self,const SQObjectPtr &key,const SQObjectPtr &val);
@@ -151,6 +152,7 @@ public:
 	bool _debughook;
 	SQDEBUGHOOK _debughook_native;
 	SQObjectPtr _debughook_closure;
+	bool _interrupted;
 
 	SQObjectPtr temp_reg;
 	